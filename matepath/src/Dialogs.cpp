@@ -419,6 +419,194 @@ void GotoDlg(HWND hwnd) noexcept {
 	ThemedDialogBox(g_hInstance, MAKEINTRESOURCE(IDD_GOTO), hwnd, GotoDlgProc);
 }
 
+//=============================================================================
+//
+//  FindFileDlgProc()
+//
+//
+extern WCHAR tchFindFileExclude[DL_FILTER_BUFSIZE];
+static WCHAR tchFindFileName[DL_FILTER_BUFSIZE];
+
+struct FindFileDlgData {
+	FileSearch *search;
+	bool bIncludeHidden;
+	DWORD dwStartTick;
+};
+
+// show results found so far and throughput
+static void FindFileDlg_Update(HWND hwnd, const FindFileDlgData *data) noexcept {
+	int iCount;
+	LONG64 scanCount;
+	const bool running = FileSearch_GetStatus(data->search, &iCount, &scanCount);
+	HWND hwndLV = GetDlgItem(hwnd, IDC_FINDFILE_RESULT);
+	if (ListView_GetItemCount(hwndLV) != iCount) {
+		ListView_SetItemCountEx(hwndLV, iCount, LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	}
+
+	const DWORD elapsed = max<DWORD>(GetTickCount() - data->dwStartTick, 1);
+	WCHAR tchFound[32];
+	WCHAR tchScanned[32];
+	WCHAR tchRate[32];
+	FormatNumber(tchFound, iCount);
+	FormatNumber(tchScanned, static_cast<UINT>(min<LONG64>(scanCount, UINT_MAX)));
+	FormatNumber(tchRate, static_cast<UINT>(min<LONG64>(scanCount*1000/elapsed, UINT_MAX)));
+	WCHAR tchFormat[128];
+	WCHAR tchStatus[256];
+	FormatString(tchStatus, tchFormat, IDS_FINDFILE_STATUS, tchFound, tchScanned, tchRate);
+	SetDlgItemText(hwnd, IDC_FINDFILE_STATUS, tchStatus);
+
+	if (!running) {
+		KillTimer(hwnd, ID_FINDFILETIMER);
+		GetString(IDS_FINDFILE_FIND, tchFormat, COUNTOF(tchFormat));
+		SetDlgItemText(hwnd, IDOK, tchFormat);
+	}
+}
+
+static void FindFileDlg_Start(HWND hwnd, FindFileDlgData *data) noexcept {
+	if (data->search) {
+		FileSearch_Free(data->search);
+		data->search = nullptr;
+	}
+
+	GetDlgItemText(hwnd, IDC_FINDFILE_NAME, tchFindFileName, COUNTOF(tchFindFileName));
+	GetDlgItemText(hwnd, IDC_FINDFILE_EXCLUDE, tchFindFileExclude, COUNTOF(tchFindFileExclude));
+	ListView_SetItemCountEx(GetDlgItem(hwnd, IDC_FINDFILE_RESULT), 0, 0);
+
+	data->search = FileSearch_Start(szCurDir, tchFindFileName, tchFindFileExclude, data->bIncludeHidden);
+	if (data->search == nullptr) {
+		MessageBeep(MB_OK);
+		return;
+	}
+
+	data->dwStartTick = GetTickCount();
+	SetTimer(hwnd, ID_FINDFILETIMER, FINDFILETIMER_DELAY, nullptr);
+	WCHAR tch[64];
+	GetString(IDS_FINDFILE_STOP, tch, COUNTOF(tch));
+	SetDlgItemText(hwnd, IDOK, tch);
+}
+
+static INT_PTR CALLBACK FindFileDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam) noexcept {
+	static const DWORD controlDefinition[] = {
+		DeferCtlMove(IDC_RESIZEGRIP),
+		DeferCtlMoveX(IDOK),
+		DeferCtlMove(IDCANCEL),
+		DeferCtlSizeX(IDC_FINDFILE_NAME),
+		DeferCtlSizeX(IDC_FINDFILE_EXCLUDE),
+		DeferCtlSize(IDC_FINDFILE_RESULT) | RESIZE_AUTOSIZE_USEHEADER,
+		DeferCtlMoveYSizeX(IDC_FINDFILE_STATUS) | RESIZE_INVALIDATE_RECT,
+	};
+
+	switch (umsg) {
+	case WM_INITDIALOG: {
+		SetWindowLongPtr(hwnd, DWLP_USER, lParam);
+		ResizeDlg_Init(hwnd, &positionRecord.cxFindFileDlg, &positionRecord.cyFindFileDlg, controlDefinition, COUNTOF(controlDefinition));
+
+		HWND hwndCtl = GetDlgItem(hwnd, IDC_FINDFILE_NAME);
+		Edit_LimitText(hwndCtl, COUNTOF(tchFindFileName) - 1);
+		Edit_SetText(hwndCtl, tchFindFileName);
+		hwndCtl = GetDlgItem(hwnd, IDC_FINDFILE_EXCLUDE);
+		Edit_LimitText(hwndCtl, COUNTOF(tchFindFileExclude) - 1);
+		Edit_SetText(hwndCtl, tchFindFileExclude);
+
+		HWND hwndLV = GetDlgItem(hwnd, IDC_FINDFILE_RESULT);
+		InitWindowCommon(hwndLV);
+		ListView_SetExtendedListViewStyle(hwndLV, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER | LVS_EX_LABELTIP);
+		const LVCOLUMN lvc = { LVCF_FMT | LVCF_TEXT, LVCFMT_LEFT, 0, nullptr, -1, 0, 0, 0
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+			, 0, 0, 0
+#endif
+		};
+		ListView_InsertColumn(hwndLV, 0, &lvc);
+		ListView_SetColumnWidth(hwndLV, 0, LVSCW_AUTOSIZE_USEHEADER);
+
+		CenterDlgInParent(hwnd);
+	}
+	return TRUE;
+
+	case WM_DESTROY: {
+		FindFileDlgData *data = AsPointer<FindFileDlgData *>(GetWindowLongPtr(hwnd, DWLP_USER));
+		KillTimer(hwnd, ID_FINDFILETIMER);
+		if (data->search) {
+			FileSearch_Free(data->search);
+			data->search = nullptr;
+		}
+	}
+	return FALSE;
+
+	case WM_TIMER:
+		if (wParam == ID_FINDFILETIMER) {
+			const FindFileDlgData *data = AsPointer<FindFileDlgData *>(GetWindowLongPtr(hwnd, DWLP_USER));
+			FindFileDlg_Update(hwnd, data);
+		}
+		return TRUE;
+
+	case WM_NOTIFY: {
+		LPNMHDR pnmh = AsPointer<LPNMHDR>(lParam);
+		if (pnmh->idFrom == IDC_FINDFILE_RESULT) {
+			FindFileDlgData *data = AsPointer<FindFileDlgData *>(GetWindowLongPtr(hwnd, DWLP_USER));
+			switch (pnmh->code) {
+			case LVN_GETDISPINFO: {
+				NMLVDISPINFO *pdi = AsPointer<NMLVDISPINFO *>(lParam);
+				if (pdi->item.mask & LVIF_TEXT) {
+					// path relative to current directory
+					if (data->search == nullptr || !FileSearch_GetResult(data->search, pdi->item.iItem, pdi->item.pszText, pdi->item.cchTextMax, false)) {
+						pdi->item.pszText[0] = L'\0';
+					}
+				}
+			}
+			break;
+
+			case NM_DBLCLK: {
+				HWND hwndLV = GetDlgItem(hwnd, IDC_FINDFILE_RESULT);
+				const int iItem = ListView_GetNextItem(hwndLV, -1, LVNI_ALL | LVNI_SELECTED);
+				WCHAR szPath[MAX_PATH];
+				if (data->search && FileSearch_GetResult(data->search, iItem, szPath, COUNTOF(szPath), true)) {
+					EndDialog(hwnd, IDOK);
+					DisplayPath(szPath, IDS_ERR_CMDLINE);
+				}
+			}
+			break;
+			}
+		}
+	}
+	return TRUE;
+
+	case WM_COMMAND:
+		switch (LOWORD(wParam)) {
+		case IDOK: {
+			FindFileDlgData *data = AsPointer<FindFileDlgData *>(GetWindowLongPtr(hwnd, DWLP_USER));
+			int iCount;
+			LONG64 scanCount;
+			if (data->search && FileSearch_GetStatus(data->search, &iCount, &scanCount)) {
+				FileSearch_Cancel(data->search);
+				FindFileDlg_Update(hwnd, data);
+			} else {
+				FindFileDlg_Start(hwnd, data);
+			}
+		}
+		break;
+
+		case IDCANCEL:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+		}
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+//=============================================================================
+//
+//  FindFileDlg()
+//
+//  Search names recursively under current directory
+//
+void FindFileDlg(HWND hwnd, bool bIncludeHidden) noexcept {
+	FindFileDlgData data = { nullptr, bIncludeHidden, 0 };
+	ThemedDialogBoxParam(g_hInstance, MAKEINTRESOURCE(IDD_FINDFILE), hwnd, FindFileDlgProc, AsInteger<LPARAM>(&data));
+}
+
 void OpenHelpLink(HWND hwnd, int cmd) noexcept {
 	LPCWSTR link = nullptr;
 	switch (cmd) {
@@ -1839,9 +2027,9 @@ INT_PTR CALLBACK OpenWithDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lPa
 				DirList_GetDispInfo(hwndLV, lParam);
 				break;
 
-			case LVN_DELETEITEM:
-				DirList_DeleteItem(hwndLV, lParam);
-				break;
+			case LVN_ODFINDITEM:
+				SetWindowLongPtr(hwnd, DWLP_MSGRESULT, DirList_FindItem(hwndLV, lParam));
+				return TRUE;
 
 			case LVN_ITEMCHANGED: {
 				const NM_LISTVIEW *pnmlv = AsPointer<NM_LISTVIEW *>(lParam);
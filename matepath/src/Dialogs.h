@@ -38,6 +38,7 @@ bool GetDirectory2(HWND hwndParent, int iTitle, LPWSTR pszFolder, REFKNOWNFOLDER
 
 void RunDlg(HWND hwnd) noexcept;
 void GotoDlg(HWND hwnd) noexcept;
+void FindFileDlg(HWND hwnd, bool bIncludeHidden) noexcept;
 
 void OpenHelpLink(HWND hwnd, int cmd) noexcept;
 INT_PTR CALLBACK AboutDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam) noexcept;
@@ -30,6 +30,33 @@
 
 //==== DirList ================================================================
 
+//==== DirListEntry Structure =================================================
+// item of the owner data listview, keys for sorting are cached at enumeration
+struct DirListEntry {
+	PITEMID_CHILD pidl;			// Item Id
+	LPCWSTR pszName;			// File name, stored in DirListNames block
+	ULONGLONG size;				// File size
+	FILETIME ftLastWriteTime;	// Last modified time
+	DWORD dwAttributes;			// File attributes
+	UINT cchExtension;			// Offset to file extension in pszName
+	int iImage;					// Icon resolved by icon thread, -1 for default icon
+	UINT state;					// Link and Share Overlay
+};
+
+// file names of one batch, names follow the header
+struct DirListNames {
+	DirListNames *next;
+};
+
+//==== Directory Watcher ======================================================
+#define DL_WATCH_BUFFER_SIZE	(64*1024)
+#define DL_WATCH_MAX_CHANGES	4096
+
+// name of created, deleted, renamed or modified item
+struct DirListChange {
+	WCHAR szName[MAX_PATH];
+};
+
 //==== DLDATA Structure =======================================================
 struct DLDATA {
 	BackgroundWorker worker;	// where HWND is ListView Control
@@ -43,6 +70,45 @@ struct DLDATA {
 	HANDLE hExitThread;			// Flag is set when Icon Thread should terminate
 	HANDLE hTerminatedThread;	// Flag is set when Icon Thread has terminated
 	HANDLE hIconThread;
+	DirListEntry *entries;		// Items in display order
+	int entryCount;
+	int entryCapacity;
+	DirListNames *names;		// Blocks referenced by entries
+	DWORD grfFlags;				// Flags and filter passed to DirList_Fill()
+	DirListFilter filter;
+	int iSortFlags;				// Order passed to DirList_Sort()
+	bool fSortRev;
+	BackgroundWorker watcher;	// where HWND receives uMsgNotify
+	UINT uMsgNotify;			// Posted when changes are queued
+	HANDLE hWatchDir;			// Directory watched by DirList_WatchThread()
+	SRWLOCK watchLock;
+	bool bChangePending;		// uMsgNotify is posted
+	bool bChangeOverflow;		// Changes are lost, refill is required
+	int changeCount;
+	int changeCapacity;
+	DirListChange *changes;		// Changed names in current directory
+};
+
+//==== Enumeration Batch ======================================================
+#define DL_ENUM_BATCH_SIZE	256
+
+struct DirListBatch {
+	DirListBatch *next;
+	DirListNames *names;
+	UINT count;
+	DirListEntry entry[DL_ENUM_BATCH_SIZE];
+};
+
+// shared between DirList_Fill() and DirList_EnumThread()
+struct DirListEnumContext {
+	const BackgroundWorker *worker;
+	LPSHELLFOLDER lpsf;
+	LPENUMIDLIST lpe;
+	const DirListFilter *filter;
+	HANDLE eventBatch;			// set when a batch is added
+	SRWLOCK lock;
+	DirListBatch *head;
+	DirListBatch *tail;
 };
 
 //==== Property Name ==========================================================
@@ -52,6 +118,193 @@ static inline LPCITEMIDLIST IL_Next(LPCITEMIDLIST pidl) noexcept {
 	return reinterpret_cast<LPCITEMIDLIST>(reinterpret_cast<const char *>(pidl) + pidl->mkid.cb);
 }
 
+static inline LPWSTR DirList_NameBuffer(DirListNames *names) noexcept {
+	return reinterpret_cast<LPWSTR>(names + 1);
+}
+
+static inline const DirListEntry *DirList_GetEntry(const DLDATA *lpdl, int iItem) noexcept {
+	return (iItem >= 0 && iItem < lpdl->entryCount) ? &lpdl->entries[iItem] : nullptr;
+}
+
+static void DirList_FreeEntries(DLDATA *lpdl) noexcept {
+	for (int i = 0; i < lpdl->entryCount; i++) {
+		CoTaskMemFree(lpdl->entries[i].pidl);
+	}
+	if (lpdl->entries) {
+		NP2HeapFree(lpdl->entries);
+	}
+	DirListNames *names = lpdl->names;
+	while (names) {
+		DirListNames * const next = names->next;
+		NP2HeapFree(names);
+		names = next;
+	}
+	lpdl->entries = nullptr;
+	lpdl->entryCount = 0;
+	lpdl->entryCapacity = 0;
+	lpdl->names = nullptr;
+}
+
+//=============================================================================
+//
+//  DirList_WatchThread()
+//
+//  Thread to queue changed names of current directory
+//
+static void DirList_QueueChanges(DLDATA *lpdl, const BYTE *buffer, DWORD cbReturned) noexcept {
+	AcquireSRWLockExclusive(&lpdl->watchLock);
+	if (cbReturned == 0) {
+		// buffer overflow or error, changes are lost
+		lpdl->bChangeOverflow = true;
+	}
+	while (cbReturned != 0 && !lpdl->bChangeOverflow) {
+		const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(buffer);
+		const UINT cchName = info->FileNameLength / sizeof(WCHAR);
+		if (lpdl->changeCount == lpdl->changeCapacity) {
+			DirListChange *changes = nullptr;
+			const int capacity = max(lpdl->changeCapacity * 2, 64);
+			if (capacity <= DL_WATCH_MAX_CHANGES) {
+				if (lpdl->changes) {
+					changes = static_cast<DirListChange *>(NP2HeapReAlloc(lpdl->changes, capacity * sizeof(DirListChange)));
+				} else {
+					changes = static_cast<DirListChange *>(NP2HeapAlloc(capacity * sizeof(DirListChange)));
+				}
+			}
+			if (changes) {
+				lpdl->changes = changes;
+				lpdl->changeCapacity = capacity;
+			}
+		}
+		// refill is faster than applying too many changes
+		if (cchName == 0 || cchName >= MAX_PATH || lpdl->changeCount == lpdl->changeCapacity) {
+			lpdl->bChangeOverflow = true;
+			break;
+		}
+
+		LPWSTR pszName = lpdl->changes[lpdl->changeCount++].szName;
+		memcpy(pszName, info->FileName, cchName * sizeof(WCHAR));
+		pszName[cchName] = L'\0';
+		if (info->NextEntryOffset == 0) {
+			break;
+		}
+		buffer += info->NextEntryOffset;
+	}
+
+	const bool bPost = !lpdl->bChangePending;
+	lpdl->bChangePending = true;
+	ReleaseSRWLockExclusive(&lpdl->watchLock);
+	if (bPost) {
+		PostMessage(lpdl->watcher.hwnd, lpdl->uMsgNotify, 0, 0);
+	}
+}
+
+static DWORD WINAPI DirList_WatchThread(LPVOID lpParam) noexcept {
+	DLDATA * const lpdl = static_cast<DLDATA *>(lpParam);
+	const BackgroundWorker &watcher = lpdl->watcher;
+	HANDLE hDir = lpdl->hWatchDir;
+
+	OVERLAPPED ov;
+	memset(&ov, 0, sizeof(OVERLAPPED));
+	ov.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+	BYTE *buffer = static_cast<BYTE *>(NP2HeapAlloc(DL_WATCH_BUFFER_SIZE));
+	if (ov.hEvent && buffer) {
+		const HANDLE handles[2] = { ov.hEvent, watcher.eventCancel };
+		while (watcher.Continue()) {
+			ResetEvent(ov.hEvent);
+			if (!ReadDirectoryChangesW(hDir, buffer, DL_WATCH_BUFFER_SIZE, FALSE,
+				FILE_NOTIFY_CHANGE_FILE_NAME  | \
+				FILE_NOTIFY_CHANGE_DIR_NAME   | \
+				FILE_NOTIFY_CHANGE_ATTRIBUTES | \
+				FILE_NOTIFY_CHANGE_SIZE | \
+				FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &ov, nullptr)) {
+				DirList_QueueChanges(lpdl, buffer, 0);
+				break;
+			}
+
+			DWORD cbReturned = 0;
+			if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0) {
+				CancelIoEx(hDir, &ov);
+				GetOverlappedResult(hDir, &ov, &cbReturned, TRUE);
+				break;
+			}
+			// directory is deleted or not accessible when failed
+			const bool bSuccess = GetOverlappedResult(hDir, &ov, &cbReturned, FALSE);
+			DirList_QueueChanges(lpdl, buffer, bSuccess ? cbReturned : 0);
+			if (!bSuccess) {
+				break;
+			}
+		}
+	}
+
+	if (ov.hEvent) {
+		CloseHandle(ov.hEvent);
+	}
+	if (buffer) {
+		NP2HeapFree(buffer);
+	}
+	return 0;
+}
+
+// Stop watching and discard queued changes
+static void DirList_StopWatching(DLDATA *lpdl) noexcept {
+	lpdl->watcher.Cancel();
+	if (lpdl->hWatchDir) {
+		CloseHandle(lpdl->hWatchDir);
+		lpdl->hWatchDir = nullptr;
+	}
+	if (lpdl->changes) {
+		NP2HeapFree(lpdl->changes);
+		lpdl->changes = nullptr;
+	}
+	lpdl->changeCount = 0;
+	lpdl->changeCapacity = 0;
+	lpdl->bChangePending = false;
+	lpdl->bChangeOverflow = false;
+}
+
+static void DirList_StartWatching(DLDATA *lpdl, LPCITEMIDLIST pidl) noexcept {
+	WCHAR szDir[MAX_PATH];
+	if (lpdl->uMsgNotify == 0 || !SHGetPathFromIDList(reinterpret_cast<PCIDLIST_ABSOLUTE>(pidl), szDir)) {
+		return;
+	}
+
+	HANDLE hDir = CreateFile(szDir, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (hDir == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	lpdl->hWatchDir = hDir;
+	lpdl->watcher.workerThread = CreateThread(nullptr, 0, DirList_WatchThread, lpdl, 0, nullptr);
+	if (lpdl->watcher.workerThread == nullptr) {
+		CloseHandle(hDir);
+		lpdl->hWatchDir = nullptr;
+	}
+}
+
+//=============================================================================
+//
+//  DirList_WatchChanges()
+//
+//  Post uMsgNotify to hwndNotify when current directory is changed,
+//  DirList_ApplyChanges() should be called to update the listview
+//
+void DirList_WatchChanges(HWND hwnd, HWND hwndNotify, UINT uMsgNotify) noexcept {
+	DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+
+	DirList_StopWatching(lpdl);
+	lpdl->watcher.hwnd = hwndNotify;
+	lpdl->uMsgNotify = uMsgNotify;
+	if (lpdl->pidl) {
+		DirList_StartWatching(lpdl, lpdl->pidl);
+	}
+}
+
+bool DirList_IsWatching(HWND hwnd) noexcept {
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	return lpdl->hWatchDir != nullptr;
+}
+
 //=============================================================================
 //
 //  DirList_Init()
@@ -65,6 +318,8 @@ void DirList_Init(HWND hwnd) noexcept {
 
 	// Setup dl
 	lpdl->worker.Init(hwnd);
+	lpdl->watcher.Init(nullptr);
+	InitializeSRWLock(&lpdl->watchLock);
 	lpdl->cbidl = 0;
 	lpdl->pidl = nullptr;
 	lpdl->lpsf = nullptr;
@@ -78,6 +333,9 @@ void DirList_Init(HWND hwnd) noexcept {
 	hil = AsPointer<HIMAGELIST>(SHGetFileInfo(L"C:\\", 0, &shfi, sizeof(SHFILEINFO), SHGFI_LARGEICON | SHGFI_SYSICONINDEX));
 	ListView_SetImageList(hwnd, hil, LVSIL_NORMAL);
 
+	// Overlay and fade state are provided by DirList_GetDispInfo()
+	ListView_SetCallbackMask(hwnd, LVIS_OVERLAYMASK | LVIS_CUT);
+
 	// Initialize default icons - done in DirList_Fill()
 	//SHGetFileInfo(L"Icon", FILE_ATTRIBUTE_DIRECTORY, &shfi, sizeof(SHFILEINFO), SHGFI_USEFILEATTRIBUTES | SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
 	//lpdl->iDefIconFolder = shfi.iIcon;
@@ -99,6 +357,10 @@ void DirList_Destroy(HWND hwnd) {
 	DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
 
 	lpdl->worker.Destroy();
+	DirList_StopWatching(lpdl);
+	lpdl->watcher.Destroy();
+
+	DirList_FreeEntries(lpdl);
 
 	if (lpdl->pidl) {
 		CoTaskMemFree(lpdl->pidl);
@@ -126,6 +388,158 @@ void DirList_StartIconThread(HWND hwnd) noexcept {
 	lpdl->worker.workerThread = CreateThread(nullptr, 0, DirList_IconThread, lpdl, 0, nullptr);
 }
 
+// Get find data of item, name is kept when find data is not available
+static void DirList_GetFindData(LPSHELLFOLDER lpsf, PCUITEMID_CHILD pidl, WIN32_FIND_DATA &fd) noexcept {
+	if (S_OK != SHGetDataFromIDList(lpsf, pidl, SHGDFIL_FINDDATA, &fd, sizeof(WIN32_FIND_DATA))) {
+		memset(&fd, 0, sizeof(WIN32_FIND_DATA));
+		IL_GetDisplayName(lpsf, pidl, SHGDN_INFOLDER | SHGDN_FORPARSING, fd.cFileName, MAX_PATH);
+	}
+}
+
+// Cache sort keys, pszName is a copy of fd.cFileName
+static void DirList_InitEntry(DirListEntry &entry, PITEMID_CHILD pidl, LPCWSTR pszName, UINT cchName, const WIN32_FIND_DATA &fd) noexcept {
+	entry.pidl = pidl;
+	entry.pszName = pszName;
+	entry.size = (static_cast<ULONGLONG>(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow;
+	entry.ftLastWriteTime = fd.ftLastWriteTime;
+	entry.dwAttributes = fd.dwFileAttributes;
+	entry.cchExtension = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? cchName : static_cast<UINT>(PathFindExtension(pszName) - pszName);
+	entry.iImage = -1;
+	entry.state = 0;
+}
+
+//=============================================================================
+//
+//  DirList_EnumThread()
+//
+//  Thread to enumerate directory items in batches
+//
+static DWORD WINAPI DirList_EnumThread(LPVOID lpParam) noexcept {
+	DirListEnumContext * const context = static_cast<DirListEnumContext *>(lpParam);
+	const BackgroundWorker &worker = *context->worker;
+	LPSHELLFOLDER lpsf = context->lpsf;
+
+	// names of current batch, copied into block of exact size
+	LPWSTR nameBuffer = static_cast<LPWSTR>(NP2HeapAlloc(DL_ENUM_BATCH_SIZE * MAX_PATH * sizeof(WCHAR)));
+	if (nameBuffer == nullptr) {
+		return 0;
+	}
+
+	PITEMID_CHILD pidls[DL_ENUM_BATCH_SIZE];
+	while (worker.Continue()) {
+		ULONG fetched = 0;
+		const HRESULT hr = context->lpe->Next(DL_ENUM_BATCH_SIZE, pidls, &fetched);
+		if (FAILED(hr) || fetched == 0) {
+			break;
+		}
+
+		DirListBatch *batch = static_cast<DirListBatch *>(NP2HeapAlloc(sizeof(DirListBatch)));
+		UINT cchNames = 0;
+		for (ULONG i = 0; i < fetched; i++) {
+			PITEMID_CHILD pidlEntry = pidls[i];
+			// Check if it's part of the Filesystem
+			DWORD dwAttributes = SFGAO_FILESYSTEM;
+			lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&pidlEntry), &dwAttributes);
+			bool bAdd = false;
+			if (batch && (dwAttributes & SFGAO_FILESYSTEM)) {
+				WIN32_FIND_DATA fd;
+				DirList_GetFindData(lpsf, pidlEntry, fd);
+				// Check if item matches specified filter
+				if (context->filter->Match(fd)) {
+					bAdd = true;
+					const UINT cchName = lstrlen(fd.cFileName);
+					LPWSTR pszName = nameBuffer + cchNames;
+					memcpy(pszName, fd.cFileName, (cchName + 1) * sizeof(WCHAR));
+					cchNames += cchName + 1;
+					DirList_InitEntry(batch->entry[batch->count++], pidlEntry, pszName, cchName, fd);
+				}
+			}
+			if (!bAdd) {
+				CoTaskMemFree(pidlEntry);
+			}
+		}
+
+		if (batch) {
+			if (batch->count != 0) {
+				batch->names = static_cast<DirListNames *>(NP2HeapAlloc(sizeof(DirListNames) + cchNames * sizeof(WCHAR)));
+			}
+			if (batch->names == nullptr) {
+				for (UINT i = 0; i < batch->count; i++) {
+					CoTaskMemFree(batch->entry[i].pidl);
+				}
+				NP2HeapFree(batch);
+			} else {
+				LPWSTR names = DirList_NameBuffer(batch->names);
+				memcpy(names, nameBuffer, cchNames * sizeof(WCHAR));
+				for (UINT i = 0; i < batch->count; i++) {
+					batch->entry[i].pszName = names + (batch->entry[i].pszName - nameBuffer);
+				}
+
+				AcquireSRWLockExclusive(&context->lock);
+				if (context->tail) {
+					context->tail->next = batch;
+				} else {
+					context->head = batch;
+				}
+				context->tail = batch;
+				ReleaseSRWLockExclusive(&context->lock);
+				SetEvent(context->eventBatch);
+			}
+		}
+		if (hr != S_OK) {
+			break;
+		}
+	}
+
+	NP2HeapFree(nameBuffer);
+	return 0;
+}
+
+// Append batches found so far to entries of the listview
+static void DirList_AppendBatches(HWND hwnd, DirListEnumContext &context, DLDATA *lpdl) noexcept {
+	AcquireSRWLockExclusive(&context.lock);
+	DirListBatch *batch = context.head;
+	context.head = nullptr;
+	context.tail = nullptr;
+	ReleaseSRWLockExclusive(&context.lock);
+
+	const int iItemCount = lpdl->entryCount;
+	while (batch) {
+		const int count = lpdl->entryCount + batch->count;
+		if (count > lpdl->entryCapacity) {
+			const int capacity = max(max(lpdl->entryCapacity * 2, count), 1024);
+			DirListEntry *entries;
+			if (lpdl->entries) {
+				entries = static_cast<DirListEntry *>(NP2HeapReAlloc(lpdl->entries, capacity * sizeof(DirListEntry)));
+			} else {
+				entries = static_cast<DirListEntry *>(NP2HeapAlloc(capacity * sizeof(DirListEntry)));
+			}
+			if (entries) {
+				lpdl->entries = entries;
+				lpdl->entryCapacity = capacity;
+			}
+		}
+		if (count <= lpdl->entryCapacity) {
+			memcpy(lpdl->entries + lpdl->entryCount, batch->entry, batch->count * sizeof(DirListEntry));
+			lpdl->entryCount = count;
+			batch->names->next = lpdl->names;
+			lpdl->names = batch->names;
+		} else {
+			for (UINT i = 0; i < batch->count; i++) {
+				CoTaskMemFree(batch->entry[i].pidl);
+			}
+			NP2HeapFree(batch->names);
+		}
+		DirListBatch * const next = batch->next;
+		NP2HeapFree(batch);
+		batch = next;
+	}
+
+	if (lpdl->entryCount != iItemCount) {
+		ListView_SetItemCountEx(hwnd, lpdl->entryCount, LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	}
+}
+
 //=============================================================================
 //
 //  DirList_Fill()
@@ -145,6 +559,7 @@ int DirList_Fill(HWND hwnd, LPCWSTR lpszDir, DWORD grfFlags, LPCWSTR lpszFileSpe
 
 	// First of all terminate running icon thread
 	lpdl->worker.Cancel();
+	DirList_StopWatching(lpdl);
 
 	// A Directory is strongly required
 	if (StrIsEmpty(lpszDir)) {
@@ -156,61 +571,115 @@ int DirList_Fill(HWND hwnd, LPCWSTR lpszDir, DWORD grfFlags, LPCWSTR lpszFileSpe
 	// Init ListView
 	SendMessage(hwnd, WM_SETREDRAW, 0, 0);
 	ListView_DeleteAllItems(hwnd);
+	DirList_FreeEntries(lpdl);
+
+	if (lpdl->pidl) {
+		CoTaskMemFree(lpdl->pidl);
+	}
+
+	if (lpdl->lpsf) {
+		lpdl->lpsf->Release();
+	}
 
-	// Init Filter
-	DirListFilter dlf;
-	dlf.Create(lpszFileSpec, bExcludeFilter);
+	// Set lpdl, visible rows are resolved while enumerating
+	lpdl->cbidl = 0;
+	lpdl->pidl = nullptr;
+	lpdl->lpsf = nullptr;
+	lpdl->bNoFadeHidden = bNoFadeHidden;
+	lpdl->grfFlags = grfFlags;
 
-	// Init lvi
-	LV_ITEM lvi;
-	lvi.mask = LVIF_TEXT | LVIF_IMAGE | LVIF_PARAM;
-	lvi.iItem = 0;
-	lvi.iSubItem = 0;
-	lvi.pszText = LPSTR_TEXTCALLBACK;
-	lvi.cchTextMax = MAX_PATH;
-	lvi.iImage = I_IMAGECALLBACK;
+	// Init Filter, kept to match added items
+	lpdl->filter.Create(lpszFileSpec, bExcludeFilter);
 
 	WCHAR wszDir[MAX_PATH];
 	lstrcpy(wszDir, lpszDir);
 
 	// Get Desktop Folder
 	LPSHELLFOLDER lpsfDesktop = nullptr;
-	PIDLIST_RELATIVE pidl = nullptr;
-	LPSHELLFOLDER lpsf = nullptr;
+	bool quit = false;
+	WPARAM exitCode = 0;
 	if (S_OK == SHGetDesktopFolder(&lpsfDesktop)) {
 		// Convert wszDir into a pidl
 		ULONG chParsed = 0;
 		ULONG dwAttributes = 0;
+		PIDLIST_RELATIVE pidl = nullptr;
 		if (S_OK == lpsfDesktop->ParseDisplayName(hwnd, nullptr, wszDir, &chParsed, &pidl, &dwAttributes)) {
+			lpdl->cbidl = IL_GetSize(pidl);
+			lpdl->pidl = pidl;
 			// Bind pidl to IShellFolder
+			LPSHELLFOLDER lpsf = nullptr;
 			if (S_OK == lpsfDesktop->BindToObject(pidl, nullptr, IID_IShellFolder, AsPPVArgs(&lpsf))) {
+				lpdl->lpsf = lpsf;
+				// Changes made while enumerating are queued
+				DirList_StartWatching(lpdl, pidl);
 				// Create an Enumeration object for lpsf
 				LPENUMIDLIST lpe = nullptr;
 				if (S_OK == lpsf->EnumObjects(hwnd, grfFlags, &lpe)) {
-					// Enumerate the contents of lpsf
-					PITEMID_CHILD pidlEntry = nullptr;
-					while (S_OK == lpe->Next(1, &pidlEntry, nullptr)) {
-						// Add found item to the List
-						// Check if it's part of the Filesystem
-						dwAttributes = SFGAO_FILESYSTEM | SFGAO_FOLDER;
-						lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&pidlEntry), &dwAttributes);
-
-						if (dwAttributes & SFGAO_FILESYSTEM) {
-							// Check if item matches specified filter
-							if (dlf.Match(lpsf, pidlEntry)) {
-								LV_ITEMDATA *lplvid = static_cast<LV_ITEMDATA *>(CoTaskMemAlloc(sizeof(LV_ITEMDATA)));
-								lplvid->pidl = pidlEntry;
-								lplvid->lpsf = lpsf;
-								lpsf->AddRef();
-								lvi.lParam = AsInteger<LPARAM>(lplvid);
-								// Setup default Icon - Folder or File
-								lvi.iImage = (dwAttributes & SFGAO_FOLDER) ? lpdl->iDefIconFolder : lpdl->iDefIconFile;
-								ListView_InsertItem(hwnd, &lvi);
-								lvi.iItem++;
+					// Enumerate the contents of lpsf in background, found items are added
+					// while waiting, Esc stops enumerating remaining items.
+					DirListEnumContext context;
+					memset(&context, 0, sizeof(context));
+					context.worker = &lpdl->worker;
+					context.lpsf = lpsf;
+					context.lpe = lpe;
+					context.filter = &lpdl->filter;
+					context.eventBatch = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+					InitializeSRWLock(&context.lock);
+
+					HANDLE hThread = context.eventBatch ? CreateThread(nullptr, 0, DirList_EnumThread, &context, 0, nullptr) : nullptr;
+					if (hThread == nullptr) {
+						DirList_EnumThread(&context);
+						DirList_AppendBatches(hwnd, context, lpdl);
+					} else {
+						lpdl->worker.workerThread = hThread;
+						const HANDLE handles[2] = { hThread, context.eventBatch };
+						bool shown = false;
+						while (true) {
+							const DWORD wait = MsgWaitForMultipleObjects(2, handles, FALSE, INFINITE, QS_ALLINPUT);
+							if (wait == WAIT_OBJECT_0 + 2) {
+								MSG msg;
+								while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+									const UINT message = msg.message;
+									if (message == WM_QUIT) {
+										quit = true;
+										exitCode = msg.wParam;
+									} else if (message >= WM_KEYFIRST && message <= WM_KEYLAST) {
+										if (message == WM_KEYDOWN && msg.wParam == VK_ESCAPE) {
+											SetEvent(lpdl->worker.eventCancel);
+										}
+									} else if (!((message >= WM_MOUSEFIRST && message <= WM_MOUSELAST)
+										|| (message >= WM_NCMOUSEMOVE && message <= WM_NCXBUTTONDBLCLK)
+										|| message == WM_TIMER || message == WM_COMMAND)) {
+										TranslateMessage(&msg);
+										DispatchMessage(&msg);
+									}
+								}
+								continue;
 							}
+
+							DirList_AppendBatches(hwnd, context, lpdl);
+							if (wait != WAIT_OBJECT_0 + 1) {
+								break;
+							}
+							// show first screenful while remaining items are enumerated
+							if (!shown && lpdl->entryCount >= ListView_GetCountPerPage(hwnd)) {
+								shown = true;
+								SendMessage(hwnd, WM_SETREDRAW, 1, 0);
+								UpdateWindow(hwnd);
+								SendMessage(hwnd, WM_SETREDRAW, 0, 0);
+							}
+						}
+
+						hThread = InterlockedExchangePointer(&lpdl->worker.workerThread, nullptr);
+						if (hThread) {
+							CloseHandle(hThread);
 						}
-					} // IEnumIDList::Next()
+						ResetEvent(lpdl->worker.eventCancel);
+					}
 
+					if (context.eventBatch) {
+						CloseHandle(context.eventBatch);
+					}
 					lpe->Release();
 
 				} // IShellFolder::EnumObjects()
@@ -222,20 +691,6 @@ int DirList_Fill(HWND hwnd, LPCWSTR lpszDir, DWORD grfFlags, LPCWSTR lpszFileSpe
 		lpsfDesktop->Release();
 	} // SHGetDesktopFolder()
 
-	if (lpdl->pidl) {
-		CoTaskMemFree(lpdl->pidl);
-	}
-
-	if (lpdl->lpsf) {
-		lpdl->lpsf->Release();
-	}
-
-	// Set lpdl
-	lpdl->cbidl = IL_GetSize(pidl);
-	lpdl->pidl = pidl;
-	lpdl->lpsf = lpsf;
-	lpdl->bNoFadeHidden = bNoFadeHidden;
-
 	// Set column width to fit window
 	ListView_SetColumnWidth(hwnd, 0, LVSCW_AUTOSIZE_USEHEADER);
 
@@ -245,89 +700,141 @@ int DirList_Fill(HWND hwnd, LPCWSTR lpszDir, DWORD grfFlags, LPCWSTR lpszFileSpe
 	// Redraw Listview
 	SendMessage(hwnd, WM_SETREDRAW, 1, 0);
 
+	if (quit) {
+		PostQuitMessage(static_cast<int>(exitCode));
+	}
+
 	// Return number of items in the control
 	return ListView_GetItemCount(hwnd);
 }
 
-//=============================================================================
-//
-//  DirList_IconThread()
-//
-//  Thread to extract file icons in the background
-//
-DWORD WINAPI DirList_IconThread(LPVOID lpParam) {
-	DLDATA * const lpdl = static_cast<DLDATA *>(lpParam);
-	const BackgroundWorker &worker = lpdl->worker;
-
-	// Exit immediately if DirList_Fill() hasn't been called
-	if (!lpdl->lpsf) {
-		return 0;
+//==== Icon Worker ============================================================
+#define DL_ICON_WORKER_COUNT	4
+
+// resolve icons on thread pool, rows are claimed starting from top visible row.
+struct DirListIconWorker {
+	DLDATA *lpdl;
+	int iMaxItem;
+	int iTopItem;
+	int iVisibleCount;
+	LONG nextItem;
+	bool bFileSystem;
+	WCHAR szDir[MAX_PATH];
+
+	void ResolveIcon(int iItem, IShellIcon *lpshi) noexcept;
+	void DoWork() noexcept;
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		DirListIconWorker *worker = static_cast<DirListIconWorker *>(context);
+		worker->DoWork();
 	}
+};
 
-	HWND hwnd = worker.hwnd;
-	const int iMaxItem = ListView_GetItemCount(hwnd);
+void DirListIconWorker::ResolveIcon(int iItem, IShellIcon *lpshi) noexcept {
+	DirListEntry &entry = lpdl->entries[iItem];
+	int iImage = -1;
+	if (bFileSystem && !(entry.dwAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		WCHAR szPath[MAX_PATH];
+		if (PathCombine(szPath, szDir, entry.pszName)) {
+			iImage = IconCache_GetFileIcon(szPath, entry.dwAttributes, &entry.ftLastWriteTime);
+		}
+	}
+	if (iImage < 0 && (!lpshi || S_OK != lpshi->GetIconOf(entry.pidl, GIL_FORSHELL, &iImage))) {
+		SHFILEINFO shfi;
+		LPITEMIDLIST pidl = IL_Create(lpdl->pidl, lpdl->cbidl, entry.pidl, 0);
+		SHGetFileInfo(reinterpret_cast<LPCWSTR>(pidl), 0, &shfi, sizeof(SHFILEINFO), SHGFI_PIDL | SHGFI_SYSICONINDEX | SHGFI_SMALLICON);
+		CoTaskMemFree(pidl);
+		iImage = shfi.iIcon;
+	}
 
-	// Get IShellIcon
-	IShellIcon *lpshi;
-	lpdl->lpsf->QueryInterface(IID_IShellIcon, AsPPVArgs(&lpshi));
+	UINT state = 0;
+	DWORD dwAttributes = SFGAO_LINK | SFGAO_SHARE;
+	// Link and Share Overlay
+	lpdl->lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&entry.pidl), &dwAttributes);
 
-	int iItem = 0;
-	while (iItem < iMaxItem && worker.Continue()) {
-		LV_ITEM lvi;
-		lvi.iItem = iItem;
-		lvi.mask = LVIF_PARAM;
-		if (ListView_GetItem(hwnd, &lvi)) {
-			LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
-			lvi.mask = LVIF_IMAGE;
-
-			if (!lpshi || S_OK != lpshi->GetIconOf(reinterpret_cast<PCUITEMID_CHILD>(lplvid->pidl), GIL_FORSHELL, &lvi.iImage)) {
-				SHFILEINFO shfi;
-				LPITEMIDLIST pidl = IL_Create(lpdl->pidl, lpdl->cbidl, lplvid->pidl, 0);
-				SHGetFileInfo(reinterpret_cast<LPCWSTR>(pidl), 0, &shfi, sizeof(SHFILEINFO), SHGFI_PIDL | SHGFI_SYSICONINDEX | SHGFI_SMALLICON);
-				CoTaskMemFree(pidl);
-				lvi.iImage = shfi.iIcon;
-			}
+	if (dwAttributes & SFGAO_LINK) {
+		state |= INDEXTOOVERLAYMASK(2);
+	}
 
-			// It proved necessary to reset the state bits...
-			lvi.stateMask = 0;
-			lvi.state = 0;
+	if (dwAttributes & SFGAO_SHARE) {
+		state |= INDEXTOOVERLAYMASK(1);
+	}
 
-			DWORD dwAttributes = SFGAO_LINK | SFGAO_SHARE;
-			// Link and Share Overlay
-			lplvid->lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&lplvid->pidl), &dwAttributes);
+	entry.state = state;
+	entry.iImage = max(iImage, 0);
+}
 
-			if (dwAttributes & SFGAO_LINK) {
-				lvi.mask |= LVIF_STATE;
-				lvi.stateMask |= LVIS_OVERLAYMASK;
-				lvi.state |= INDEXTOOVERLAYMASK(2);
-			}
+void DirListIconWorker::DoWork() noexcept {
+	const BackgroundWorker &worker = lpdl->worker;
+	const HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
 
-			if (dwAttributes & SFGAO_SHARE) {
-				lvi.mask |= LVIF_STATE;
-				lvi.stateMask |= LVIS_OVERLAYMASK;
-				lvi.state |= INDEXTOOVERLAYMASK(1);
-			}
+	// Get IShellIcon
+	IShellIcon *lpshi = nullptr;
+	lpdl->lpsf->QueryInterface(IID_IShellIcon, AsPPVArgs(&lpshi));
 
-			// Fade hidden/system files
-			if (!lpdl->bNoFadeHidden) {
-				WIN32_FIND_DATA fd;
-				if (S_OK == SHGetDataFromIDList(lplvid->lpsf, reinterpret_cast<PCUITEMID_CHILD>(lplvid->pidl), SHGDFIL_FINDDATA, &fd, sizeof(WIN32_FIND_DATA))) {
-					if ((fd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) || (fd.dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)) {
-						lvi.mask |= LVIF_STATE;
-						lvi.stateMask |= LVIS_CUT;
-						lvi.state |= LVIS_CUT;
-					}
-				}
+	while (worker.Continue()) {
+		const int index = InterlockedIncrement(&nextItem) - 1;
+		if (index >= iMaxItem) {
+			break;
+		}
+		int iItem = iTopItem + index;
+		if (iItem >= iMaxItem) {
+			iItem -= iMaxItem;
+		}
+		if (lpdl->entries[iItem].iImage < 0) {
+			ResolveIcon(iItem, lpshi);
+			// other rows are drawn after icons are resolved
+			if (index < iVisibleCount) {
+				ListView_RedrawItems(worker.hwnd, iItem, iItem);
 			}
-			lvi.iSubItem = 0;
-			ListView_SetItem(hwnd, &lvi);
 		}
-		iItem++;
 	}
 
 	if (lpshi) {
 		lpshi->Release();
 	}
+	if (SUCCEEDED(hr)) {
+		CoUninitialize();
+	}
+}
+
+//=============================================================================
+//
+//  DirList_IconThread()
+//
+//  Thread to extract file icons in the background
+//
+DWORD WINAPI DirList_IconThread(LPVOID lpParam) {
+	DLDATA * const lpdl = static_cast<DLDATA *>(lpParam);
+
+	// Exit immediately if DirList_Fill() hasn't been called
+	if (!lpdl->lpsf || lpdl->entryCount == 0) {
+		return 0;
+	}
+
+	HWND hwnd = lpdl->worker.hwnd;
+	DirListIconWorker worker;
+	worker.lpdl = lpdl;
+	worker.iMaxItem = lpdl->entryCount;
+	// start with visible rows
+	worker.iTopItem = clamp(ListView_GetTopIndex(hwnd), 0, worker.iMaxItem - 1);
+	worker.iVisibleCount = ListView_GetCountPerPage(hwnd) + 1;
+	worker.nextItem = 0;
+	worker.bFileSystem = SHGetPathFromIDList(reinterpret_cast<PCIDLIST_ABSOLUTE>(lpdl->pidl), worker.szDir);
+
+	// this thread is kept as BackgroundWorker::workerThread, waits for pool workers
+	const UINT threadCount = min<UINT>(min<UINT>(GetHardwareConcurrency(), DL_ICON_WORKER_COUNT), worker.iMaxItem);
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(DirListIconWorker::WorkCallback, &worker, nullptr) : nullptr;
+	if (work != nullptr) {
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	worker.DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
 
 	return 0;
 }
@@ -340,92 +847,266 @@ DWORD WINAPI DirList_IconThread(LPVOID lpParam) {
 //  the listview control
 //
 bool DirList_GetDispInfo(HWND hwnd, LPARAM lParam) {
-	UNREFERENCED_PARAMETER(hwnd);
-
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
 	LV_DISPINFO *lpdi = AsPointer<LV_DISPINFO *>(lParam);
-	LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lpdi->item.lParam);
 
 	// SubItem 0 is handled only
-	if (lpdi->item.iSubItem != 0) {
+	const DirListEntry *entry = DirList_GetEntry(lpdl, lpdi->item.iItem);
+	if (lpdi->item.iSubItem != 0 || entry == nullptr) {
 		return false;
 	}
 
 	// Text
 	if (lpdi->item.mask & LVIF_TEXT) {
-		IL_GetDisplayName(lplvid->lpsf, lplvid->pidl, SHGDN_INFOLDER, lpdi->item.pszText, lpdi->item.cchTextMax);
+		IL_GetDisplayName(lpdl->lpsf, entry->pidl, SHGDN_INFOLDER, lpdi->item.pszText, lpdi->item.cchTextMax);
+	}
+
+	// Icon - Folder or File until resolved by icon thread
+	if (lpdi->item.mask & LVIF_IMAGE) {
+		const int iImage = entry->iImage;
+		if (iImage >= 0) {
+			lpdi->item.iImage = iImage;
+		} else {
+			lpdi->item.iImage = (entry->dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ? lpdl->iDefIconFolder : lpdl->iDefIconFile;
+		}
 	}
 
-	// Set values
-	lpdi->item.mask |= LVIF_DI_SETITEM;
+	// Overlay and faded hidden/system files
+	if (lpdi->item.mask & LVIF_STATE) {
+		UINT state = entry->state;
+		if (!lpdl->bNoFadeHidden && (entry->dwAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM))) {
+			state |= LVIS_CUT;
+		}
+		lpdi->item.state |= state & lpdi->item.stateMask;
+	}
 
 	return true;
 }
 
+// Find entry by display name, starts at iStart and wraps around when requested
+static int DirList_FindEntry(const DLDATA *lpdl, int iStart, LPCWSTR lpszName, UINT flags) {
+	const int iMaxItem = lpdl->entryCount;
+	if (iStart < 0 || iStart >= iMaxItem) {
+		iStart = (flags & LVFI_WRAP) ? 0 : iMaxItem;
+	}
+
+	const int iCount = (flags & LVFI_WRAP) ? iMaxItem : iMaxItem - iStart;
+	const int cchName = lstrlen(lpszName);
+	WCHAR szDisplayName[MAX_PATH];
+	for (int index = 0; index < iCount; index++) {
+		int iItem = iStart + index;
+		if (iItem >= iMaxItem) {
+			iItem -= iMaxItem;
+		}
+		if (IL_GetDisplayName(lpdl->lpsf, lpdl->entries[iItem].pidl, SHGDN_INFOLDER, szDisplayName, MAX_PATH)) {
+			if ((flags & LVFI_PARTIAL) ? (StrCmpNI(szDisplayName, lpszName, cchName) == 0) : StrCaseEqual(szDisplayName, lpszName)) {
+				return iItem;
+			}
+		}
+	}
+	return -1;
+}
+
 //=============================================================================
 //
-//  DirList_DeleteItem()
+//  DirList_FindItem()
 //
-//  Must be called in response to a WM_NOTIFY/LVN_DELETEITEM message
-//  from the control
+//  Must be called in response to a WM_NOTIFY/LVN_ODFINDITEM message from
+//  the listview control
 //
-bool DirList_DeleteItem(HWND hwnd, LPARAM lParam) {
-	const NM_LISTVIEW *lpnmlv = AsPointer<NM_LISTVIEW *>(lParam);
-
-	LV_ITEM lvi;
-	lvi.iItem = lpnmlv->iItem;
-	lvi.iSubItem = 0;
-	lvi.mask = LVIF_PARAM;
+int DirList_FindItem(HWND hwnd, LPARAM lParam) {
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	const NMLVFINDITEM *lpfi = AsPointer<NMLVFINDITEM *>(lParam);
 
-	if (ListView_GetItem(hwnd, &lvi)) {
-		// Free mem
-		LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
-		CoTaskMemFree(lplvid->pidl);
-		lplvid->lpsf->Release();
-		CoTaskMemFree(lplvid);
-		return true;
+	const UINT flags = lpfi->lvfi.flags;
+	if (!(flags & (LVFI_STRING | LVFI_PARTIAL)) || lpfi->lvfi.psz == nullptr || lpdl->lpsf == nullptr) {
+		return -1;
 	}
-	return false;
+	return DirList_FindEntry(lpdl, lpfi->iStart, lpfi->lvfi.psz, flags);
 }
 
 //=============================================================================
 //
 //  DirList_CompareProc()
 //
-//  Compares two list items
+//  Compares two entries, folders are placed before files
 //
-int CALLBACK DirList_CompareProcFw(LPARAM lp1, LPARAM lp2, LPARAM lFlags) {
-	const LV_ITEMDATA * const lplvid1 = AsPointer<const LV_ITEMDATA *>(lp1);
-	const LV_ITEMDATA * const lplvid2 = AsPointer<const LV_ITEMDATA *>(lp2);
+static inline int DirList_CompareFolder(const DirListEntry *entry1, const DirListEntry *entry2) noexcept {
+	return static_cast<int>((entry2->dwAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+		- static_cast<int>((entry1->dwAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+}
 
-	HRESULT hr = lplvid1->lpsf->CompareIDs(lFlags, reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid1->pidl), reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid2->pidl));
-	int result = static_cast<short>(HRESULT_CODE(hr));
+static int __cdecl DirList_CompareName(const void *p1, const void *p2) noexcept {
+	const DirListEntry *entry1 = static_cast<const DirListEntry *>(p1);
+	const DirListEntry *entry2 = static_cast<const DirListEntry *>(p2);
+	int result = DirList_CompareFolder(entry1, entry2);
+	if (result == 0) {
+		result = StrCmpLogicalW(entry1->pszName, entry2->pszName);
+	}
+	return result;
+}
 
-	if (result != 0 || lFlags == 0) {
-		return result;
+static int __cdecl DirList_CompareSize(const void *p1, const void *p2) noexcept {
+	const DirListEntry *entry1 = static_cast<const DirListEntry *>(p1);
+	const DirListEntry *entry2 = static_cast<const DirListEntry *>(p2);
+	int result = DirList_CompareFolder(entry1, entry2);
+	if (result == 0) {
+		result = (entry1->size > entry2->size) - (entry1->size < entry2->size);
+		if (result == 0) {
+			result = StrCmpLogicalW(entry1->pszName, entry2->pszName);
+		}
 	}
+	return result;
+}
 
-	hr = lplvid1->lpsf->CompareIDs(0, reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid1->pidl), reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid2->pidl));
-	result = static_cast<short>(HRESULT_CODE(hr));
+static int __cdecl DirList_CompareType(const void *p1, const void *p2) noexcept {
+	const DirListEntry *entry1 = static_cast<const DirListEntry *>(p1);
+	const DirListEntry *entry2 = static_cast<const DirListEntry *>(p2);
+	int result = DirList_CompareFolder(entry1, entry2);
+	if (result == 0) {
+		result = StrCmpIW(entry1->pszName + entry1->cchExtension, entry2->pszName + entry2->cchExtension);
+		if (result == 0) {
+			result = StrCmpLogicalW(entry1->pszName, entry2->pszName);
+		}
+	}
+	return result;
+}
 
+static int __cdecl DirList_CompareLastMod(const void *p1, const void *p2) noexcept {
+	const DirListEntry *entry1 = static_cast<const DirListEntry *>(p1);
+	const DirListEntry *entry2 = static_cast<const DirListEntry *>(p2);
+	int result = DirList_CompareFolder(entry1, entry2);
+	if (result == 0) {
+		result = CompareFileTime(&entry1->ftLastWriteTime, &entry2->ftLastWriteTime);
+		if (result == 0) {
+			result = StrCmpLogicalW(entry1->pszName, entry2->pszName);
+		}
+	}
 	return result;
 }
 
-int CALLBACK DirList_CompareProcRw(LPARAM lp1, LPARAM lp2, LPARAM lFlags) {
-	const LV_ITEMDATA * const lplvid1 = AsPointer<const LV_ITEMDATA *>(lp1);
-	const LV_ITEMDATA * const lplvid2 = AsPointer<const LV_ITEMDATA *>(lp2);
+typedef int (__cdecl *DirListCompareProc)(const void *p1, const void *p2);
 
-	HRESULT hr = lplvid1->lpsf->CompareIDs(lFlags, reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid1->pidl), reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid2->pidl));
-	int result = -static_cast<short>(HRESULT_CODE(hr));
+// indexed by DS_NAME, DS_SIZE, DS_TYPE and DS_LASTMOD
+static const DirListCompareProc DirList_CompareProc[] = {
+	DirList_CompareName,
+	DirList_CompareSize,
+	DirList_CompareType,
+	DirList_CompareLastMod,
+};
 
-	if (result != 0) {
-		return result;
+//==== Parallel Sort ==========================================================
+#define DL_PARALLEL_SORT_MIN_ITEMS	(64*1024)
+
+// sort runs of entries on thread pool, runs are then merged on caller thread.
+struct DirListSortWorker {
+	DirListEntry *entries;
+	const int *runs;
+	UINT runCount;
+	LONG nextRun;
+	DirListCompareProc compare;
+
+	void DoWork() noexcept {
+		while (true) {
+			const UINT index = static_cast<UINT>(InterlockedIncrement(&nextRun) - 1);
+			if (index >= runCount) {
+				break;
+			}
+			qsort(entries + runs[index], runs[index + 1] - runs[index], sizeof(DirListEntry), compare);
+		}
 	}
 
-	hr = lplvid1->lpsf->CompareIDs(0, reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid1->pidl), reinterpret_cast<PCUIDLIST_RELATIVE>(lplvid2->pidl));
-	result = -static_cast<short>(HRESULT_CODE(hr));
-
-	return result;
-}
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		DirListSortWorker *worker = static_cast<DirListSortWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+static void DirList_MergeEntries(DirListCompareProc compare, DirListEntry *dest, const DirListEntry *left, const DirListEntry *leftEnd, const DirListEntry *right, const DirListEntry *rightEnd) noexcept {
+	while (left < leftEnd && right < rightEnd) {
+		if (compare(right, left) < 0) {
+			*dest++ = *right++;
+		} else {
+			*dest++ = *left++;
+		}
+	}
+	memcpy(dest, left, (leftEnd - left)*sizeof(DirListEntry));
+	dest += leftEnd - left;
+	memcpy(dest, right, (rightEnd - right)*sizeof(DirListEntry));
+}
+
+// same result as qsort(), comparisons never return zero for different entries.
+static void DirList_SortEntries(DirListEntry *entries, int iCount, DirListCompareProc compare) noexcept {
+	UINT runCount = 1;
+	DirListEntry *pTemp = nullptr;
+	if (iCount >= DL_PARALLEL_SORT_MIN_ITEMS) {
+		runCount = min<UINT>(GetHardwareConcurrency(), 64);
+		if (runCount > 1) {
+			pTemp = static_cast<DirListEntry *>(NP2HeapAlloc(sizeof(DirListEntry) * iCount));
+		}
+	}
+	if (pTemp == nullptr) {
+		qsort(entries, iCount, sizeof(DirListEntry), compare);
+		return;
+	}
+
+	int runs[64 + 1];
+	for (UINT i = 0; i <= runCount; i++) {
+		runs[i] = static_cast<int>(static_cast<LONGLONG>(iCount)*i/runCount);
+	}
+	DirListSortWorker worker { entries, runs, runCount, 0, compare };
+	PTP_WORK work = CreateThreadpoolWork(DirListSortWorker::WorkCallback, &worker, nullptr);
+	if (work != nullptr) {
+		for (UINT i = 1; i < runCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	worker.DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+
+	// merge adjacent runs until only one remains
+	DirListEntry *src = entries;
+	DirListEntry *dest = pTemp;
+	while (runCount > 1) {
+		UINT count = 0;
+		for (UINT i = 0; i < runCount; i += 2) {
+			const int start = runs[i];
+			const int middle = runs[i + 1];
+			const int end = (i + 2 <= runCount) ? runs[i + 2] : middle;
+			DirList_MergeEntries(compare, dest + start, src + start, src + middle, src + middle, src + end);
+			runs[count++] = start;
+		}
+		runs[count] = iCount;
+		runCount = count;
+		DirListEntry * const swap = src;
+		src = dest;
+		dest = swap;
+	}
+	if (src != entries) {
+		memcpy(entries, src, sizeof(DirListEntry) * iCount);
+	}
+	NP2HeapFree(pTemp);
+}
+
+static int __cdecl DirList_CompareChange(const void *p1, const void *p2) noexcept {
+	return StrCmpIW(static_cast<const DirListChange *>(p1)->szName, static_cast<const DirListChange *>(p2)->szName);
+}
+
+static int __cdecl DirList_FindChange(const void *key, const void *p) noexcept {
+	return StrCmpIW(static_cast<LPCWSTR>(key), static_cast<const DirListChange *>(p)->szName);
+}
+
+static inline void DirList_ReverseEntries(DirListEntry *entries, int iCount) noexcept {
+	for (int i = 0, j = iCount - 1; i < j; i++, j--) {
+		const DirListEntry temp = entries[i];
+		entries[i] = entries[j];
+		entries[j] = temp;
+	}
+}
+
 
 //=============================================================================
 //
@@ -434,7 +1115,227 @@ int CALLBACK DirList_CompareProcRw(LPARAM lp1, LPARAM lp2, LPARAM lFlags) {
 //  Sorts the listview control by the specified order
 //
 BOOL DirList_Sort(HWND hwnd, int lFlags, bool fRev) noexcept {
-	return ListView_SortItems(hwnd, (fRev? DirList_CompareProcRw : DirList_CompareProcFw), lFlags);
+	DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	lpdl->iSortFlags = lFlags;
+	lpdl->fSortRev = fRev;
+	const int iMaxItem = lpdl->entryCount;
+	if (iMaxItem == 0) {
+		return TRUE;
+	}
+
+	// entries are updated by icon thread
+	const bool bIconThread = lpdl->worker.workerThread != nullptr;
+	lpdl->worker.Cancel();
+
+	// selection is kept by index in owner data listview
+	const int iSelItem = ListView_GetNextItem(hwnd, -1, LVNI_ALL | LVNI_SELECTED);
+	const int iFocusItem = ListView_GetNextItem(hwnd, -1, LVNI_ALL | LVNI_FOCUSED);
+	const DirListEntry *entry = DirList_GetEntry(lpdl, iSelItem);
+	PCITEMID_CHILD pidlSel = entry ? entry->pidl : nullptr;
+	entry = DirList_GetEntry(lpdl, iFocusItem);
+	PCITEMID_CHILD pidlFocus = entry ? entry->pidl : nullptr;
+
+	const DirListCompareProc compare = DirList_CompareProc[(static_cast<UINT>(lFlags) < COUNTOF(DirList_CompareProc)) ? lFlags : DS_NAME];
+	DirListEntry *entries = lpdl->entries;
+	DirList_SortEntries(entries, iMaxItem, compare);
+	if (fRev) {
+		DirList_ReverseEntries(entries, iMaxItem);
+	}
+
+	if (pidlSel != nullptr || pidlFocus != nullptr) {
+		for (int iItem = 0; iItem < iMaxItem; iItem++) {
+			const PCITEMID_CHILD pidl = entries[iItem].pidl;
+			if (pidl == pidlSel && iItem != iSelItem) {
+				ListView_SetItemState(hwnd, iItem, LVIS_SELECTED, LVIS_SELECTED);
+			}
+			if (pidl == pidlFocus && iItem != iFocusItem) {
+				ListView_SetItemState(hwnd, iItem, LVIS_FOCUSED, LVIS_FOCUSED);
+			}
+		}
+	}
+	ListView_RedrawItems(hwnd, 0, iMaxItem - 1);
+
+	if (bIconThread) {
+		DirList_StartIconThread(hwnd);
+	}
+	return TRUE;
+}
+
+//=============================================================================
+//
+//  DirList_ApplyChanges()
+//
+//  Updates changed items queued by DirList_WatchThread(),
+//  returns false when DirList_Fill() is required
+//
+bool DirList_ApplyChanges(HWND hwnd) {
+	DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+
+	AcquireSRWLockExclusive(&lpdl->watchLock);
+	DirListChange * const changes = lpdl->changes;
+	int changeCount = lpdl->changeCount;
+	const bool bOverflow = lpdl->bChangeOverflow;
+	lpdl->changes = nullptr;
+	lpdl->changeCount = 0;
+	lpdl->changeCapacity = 0;
+	lpdl->bChangePending = false;
+	lpdl->bChangeOverflow = false;
+	ReleaseSRWLockExclusive(&lpdl->watchLock);
+
+	if (bOverflow || changeCount == 0 || lpdl->lpsf == nullptr) {
+		if (changes) {
+			NP2HeapFree(changes);
+		}
+		return !bOverflow;
+	}
+
+	// entries are updated by icon thread
+	const bool bIconThread = lpdl->worker.workerThread != nullptr;
+	lpdl->worker.Cancel();
+
+	// names may be reported multiple times
+	qsort(changes, changeCount, sizeof(DirListChange), DirList_CompareChange);
+	int count = 1;
+	for (int i = 1; i < changeCount; i++) {
+		if (DirList_CompareChange(&changes[count - 1], &changes[i]) != 0) {
+			if (count != i) {
+				changes[count] = changes[i];
+			}
+			count++;
+		}
+	}
+	changeCount = count;
+
+	// items are no longer at same index, restore selection by name
+	WCHAR szSelName[MAX_PATH] = L"";
+	WCHAR szFocusName[MAX_PATH] = L"";
+	const int iFocusItem = ListView_GetNextItem(hwnd, -1, LVNI_ALL | LVNI_FOCUSED);
+	const DirListEntry *entry = DirList_GetEntry(lpdl, ListView_GetNextItem(hwnd, -1, LVNI_ALL | LVNI_SELECTED));
+	if (entry) {
+		lstrcpy(szSelName, entry->pszName);
+	}
+	entry = DirList_GetEntry(lpdl, iFocusItem);
+	if (entry) {
+		lstrcpy(szFocusName, entry->pszName);
+	}
+
+	// remove changed items, they are added again when still exist
+	DirListEntry *entries = lpdl->entries;
+	const int iOldCount = lpdl->entryCount;
+	count = 0;
+	for (int i = 0; i < iOldCount; i++) {
+		if (bsearch(entries[i].pszName, changes, changeCount, sizeof(DirListChange), DirList_FindChange)) {
+			CoTaskMemFree(entries[i].pidl);
+		} else {
+			entries[count++] = entries[i];
+		}
+	}
+
+	DirListEntry *added = static_cast<DirListEntry *>(NP2HeapAlloc(changeCount * sizeof(DirListEntry)));
+	DirListNames *names = static_cast<DirListNames *>(NP2HeapAlloc(sizeof(DirListNames) + changeCount * MAX_PATH * sizeof(WCHAR)));
+	int addedCount = 0;
+	if (added && names) {
+		LPSHELLFOLDER lpsf = lpdl->lpsf;
+		const DWORD grfFlags = lpdl->grfFlags;
+		LPWSTR pszName = DirList_NameBuffer(names);
+		for (int i = 0; i < changeCount; i++) {
+			ULONG chParsed = 0;
+			ULONG dwAttributes = SFGAO_FILESYSTEM;
+			PIDLIST_RELATIVE pidl = nullptr;
+			if (S_OK != lpsf->ParseDisplayName(hwnd, nullptr, changes[i].szName, &chParsed, &pidl, &dwAttributes)) {
+				continue;
+			}
+
+			PITEMID_CHILD pidlEntry = reinterpret_cast<PITEMID_CHILD>(pidl);
+			bool bAdd = false;
+			if (dwAttributes & SFGAO_FILESYSTEM) {
+				WIN32_FIND_DATA fd;
+				DirList_GetFindData(lpsf, pidlEntry, fd);
+				const bool bFolder = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+				// same as flags passed to IShellFolder::EnumObjects()
+				bAdd = (grfFlags & (bFolder ? DL_FOLDERS : DL_NONFOLDERS))
+					&& ((grfFlags & DL_INCLHIDDEN) || !(fd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN))
+					&& lpdl->filter.Match(fd);
+				if (bAdd) {
+					const UINT cchName = lstrlen(fd.cFileName);
+					memcpy(pszName, fd.cFileName, (cchName + 1) * sizeof(WCHAR));
+					DirList_InitEntry(added[addedCount++], pidlEntry, pszName, cchName, fd);
+					pszName += cchName + 1;
+				}
+			}
+			if (!bAdd) {
+				CoTaskMemFree(pidlEntry);
+			}
+		}
+	}
+
+	NP2HeapFree(changes);
+	lpdl->entryCount = count;
+	if (addedCount != 0) {
+		DirListEntry *merged = static_cast<DirListEntry *>(NP2HeapAlloc((count + addedCount) * sizeof(DirListEntry)));
+		if (merged == nullptr) {
+			for (int i = 0; i < addedCount; i++) {
+				CoTaskMemFree(added[i].pidl);
+			}
+			addedCount = 0;
+		} else {
+			// merge added items into sorted items
+			const int lFlags = lpdl->iSortFlags;
+			const DirListCompareProc compare = DirList_CompareProc[(static_cast<UINT>(lFlags) < COUNTOF(DirList_CompareProc)) ? lFlags : DS_NAME];
+			qsort(added, addedCount, sizeof(DirListEntry), compare);
+			if (lpdl->fSortRev) {
+				DirList_ReverseEntries(entries, count);
+			}
+			DirList_MergeEntries(compare, merged, entries, entries + count, added, added + addedCount);
+			count += addedCount;
+			if (lpdl->fSortRev) {
+				DirList_ReverseEntries(merged, count);
+			}
+
+			if (entries) {
+				NP2HeapFree(entries);
+			}
+			lpdl->entries = merged;
+			lpdl->entryCount = count;
+			lpdl->entryCapacity = count;
+			names->next = lpdl->names;
+			lpdl->names = names;
+			names = nullptr;
+		}
+	}
+	if (added) {
+		NP2HeapFree(added);
+	}
+	if (names) {
+		NP2HeapFree(names);
+	}
+
+	ListView_SetItemCountEx(hwnd, count, LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+	ListView_SetItemState(hwnd, -1, 0, LVIS_SELECTED | LVIS_FOCUSED);
+	int iNewFocus = -1;
+	entries = lpdl->entries;
+	for (int iItem = 0; iItem < count; iItem++) {
+		LPCWSTR pszName = entries[iItem].pszName;
+		if (StrCaseEqual(pszName, szSelName)) {
+			ListView_SetItemState(hwnd, iItem, LVIS_SELECTED, LVIS_SELECTED);
+		}
+		if (StrCaseEqual(pszName, szFocusName)) {
+			iNewFocus = iItem;
+		}
+	}
+	// focused item is deleted, keep focus near old position
+	if (iNewFocus < 0 && iFocusItem >= 0 && count != 0) {
+		iNewFocus = min(max(iFocusItem - 1, 0), count - 1);
+	}
+	if (iNewFocus >= 0) {
+		ListView_SetItemState(hwnd, iNewFocus, LVIS_FOCUSED, LVIS_FOCUSED);
+	}
+	InvalidateRect(hwnd, nullptr, TRUE);
+
+	if (bIconThread || addedCount != 0) {
+		DirList_StartIconThread(hwnd);
+	}
+	return true;
 }
 
 //=============================================================================
@@ -452,40 +1353,28 @@ int DirList_GetItem(HWND hwnd, int iItem, DirListItem *lpdli) {
 		}
 	}
 
-	LV_ITEM lvi;
-	lvi.mask = LVIF_PARAM;
-	lvi.iItem = iItem;
-	lvi.iSubItem = 0;
-
-	if (!ListView_GetItem(hwnd, &lvi)) {
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	const DirListEntry *entry = DirList_GetEntry(lpdl, iItem);
+	if (entry == nullptr) {
 		if (lpdli->mask & DLI_TYPE) {
 			lpdli->ntype = DLE_NONE;
 		}
 		return -1;
 	}
 
-	LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
-
 	// Filename
 	if (lpdli->mask & DLI_FILENAME) {
-		IL_GetDisplayName(lplvid->lpsf, lplvid->pidl, SHGDN_FORPARSING, lpdli->szFileName, MAX_PATH);
+		IL_GetDisplayName(lpdl->lpsf, entry->pidl, SHGDN_FORPARSING, lpdli->szFileName, MAX_PATH);
 	}
 
 	// Displayname
 	if (lpdli->mask & DLI_DISPNAME) {
-		IL_GetDisplayName(lplvid->lpsf, lplvid->pidl, SHGDN_INFOLDER, lpdli->szDisplayName, MAX_PATH);
+		IL_GetDisplayName(lpdl->lpsf, entry->pidl, SHGDN_INFOLDER, lpdli->szDisplayName, MAX_PATH);
 	}
 
 	// Type (File / Directory)
 	if (lpdli->mask & DLI_TYPE) {
-		WIN32_FIND_DATA fd;
-		//ULONG dwAttributes = SFGAO_FILESYSTEM;
-
-		if (S_OK == SHGetDataFromIDList(lplvid->lpsf, reinterpret_cast<PCUITEMID_CHILD>(lplvid->pidl), SHGDFIL_FINDDATA, &fd, sizeof(WIN32_FIND_DATA))) {
-			lpdli->ntype = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? DLE_DIR : DLE_FILE;
-		}
-		//lplvid->lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&lplvid->pidl), &dwAttributes);
-		//lpdli->ntype = (dwAttributes & SFGAO_FOLDER) ? DLE_DIR : DLE_FILE;
+		lpdli->ntype = (entry->dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ? DLE_DIR : DLE_FILE;
 	}
 
 	return iItem;
@@ -506,17 +1395,13 @@ int DirList_GetItemEx(HWND hwnd, int iItem, LPWIN32_FIND_DATA pfd) noexcept {
 		}
 	}
 
-	LV_ITEM lvi;
-	lvi.mask = LVIF_PARAM;
-	lvi.iItem = iItem;
-	lvi.iSubItem = 0;
-
-	if (!ListView_GetItem(hwnd, &lvi)) {
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	const DirListEntry *entry = DirList_GetEntry(lpdl, iItem);
+	if (entry == nullptr) {
 		return -1;
 	}
 
-	LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
-	if (S_OK == SHGetDataFromIDList(lplvid->lpsf, reinterpret_cast<PCUITEMID_CHILD>(lplvid->pidl), SHGDFIL_FINDDATA, pfd, sizeof(WIN32_FIND_DATA))) {
+	if (S_OK == SHGetDataFromIDList(lpdl->lpsf, entry->pidl, SHGDFIL_FINDDATA, pfd, sizeof(WIN32_FIND_DATA))) {
 		return iItem;
 	}
 	return -1;
@@ -537,20 +1422,16 @@ bool DirList_PropertyDlg(HWND hwnd, int iItem) {
 		}
 	}
 
-	LV_ITEM lvi;
-	lvi.mask = LVIF_PARAM;
-	lvi.iItem = iItem;
-	lvi.iSubItem = 0;
-
-	if (!ListView_GetItem(hwnd, &lvi)) {
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	const DirListEntry *entry = DirList_GetEntry(lpdl, iItem);
+	if (entry == nullptr) {
 		return false;
 	}
 
 	bool bSuccess = true;
-	LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
 	LPCONTEXTMENU lpcm;
 
-	if (S_OK == lplvid->lpsf->GetUIObjectOf(GetParent(hwnd), 1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&lplvid->pidl), IID_IContextMenu, nullptr, AsPPVArgs(&lpcm))) {
+	if (S_OK == lpdl->lpsf->GetUIObjectOf(GetParent(hwnd), 1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&entry->pidl), IID_IContextMenu, nullptr, AsPPVArgs(&lpcm))) {
 		CMINVOKECOMMANDINFO cmi;
 		cmi.cbSize = sizeof(CMINVOKECOMMANDINFO);
 		cmi.fMask = 0;
@@ -582,16 +1463,12 @@ bool DirList_PropertyDlg(HWND hwnd, int iItem) {
 //
 void DirList_DoDragDrop(HWND hwnd, LPARAM lParam) {
 	const NM_LISTVIEW *pnmlv = AsPointer<NM_LISTVIEW *>(lParam);
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	const DirListEntry *entry = DirList_GetEntry(lpdl, pnmlv->iItem);
 
-	LV_ITEM lvi;
-	lvi.iItem = pnmlv->iItem;
-	lvi.iSubItem = 0;
-	lvi.mask = LVIF_PARAM;
-
-	if (ListView_GetItem(hwnd, &lvi)) {
-		LV_ITEMDATA *lplvid = AsPointer<LV_ITEMDATA *>(lvi.lParam);
+	if (entry != nullptr) {
 		LPDATAOBJECT lpdo;
-		if (SUCCEEDED(lplvid->lpsf->GetUIObjectOf(GetParent(hwnd), 1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&lplvid->pidl), IID_IDataObject, nullptr, AsPPVArgs(&lpdo)))) {
+		if (SUCCEEDED(lpdl->lpsf->GetUIObjectOf(GetParent(hwnd), 1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&entry->pidl), IID_IDataObject, nullptr, AsPPVArgs(&lpdo)))) {
 			CDropSource lpds;
 			DWORD dwEffect;
 
@@ -641,15 +1518,16 @@ bool DirList_SelectItem(HWND hwnd, LPCWSTR lpszDisplayName, LPCWSTR lpszFullPath
 		lstrcpyn(shfi.szDisplayName, lpszDisplayName, MAX_PATH);
 	}
 
-	LV_FINDINFO lvfi;
-	lvfi.flags = LVFI_STRING;
-	lvfi.psz = shfi.szDisplayName;
+	const DLDATA * const lpdl = static_cast<DLDATA *>(GetProp(hwnd, pDirListProp));
+	if (lpdl->lpsf == nullptr) {
+		return false;
+	}
 
 	DirListItem dli;
 	dli.mask = DLI_ALL;
 
 	int i = -1;
-	while ((i = ListView_FindItem(hwnd, i, &lvfi)) >= 0) {
+	while ((i = DirList_FindEntry(lpdl, i + 1, shfi.szDisplayName, LVFI_STRING)) >= 0) {
 		DirList_GetItem(hwnd, i, &dli);
 		GetShortPathName(dli.szFileName, dli.szFileName, MAX_PATH);
 
@@ -682,8 +1560,53 @@ bool DirList_IsFileSelected(HWND hwnd) {
 
 //=============================================================================
 //
-//  Create a valid DirListFilter structure
+// Create a valid DirListFilter structure
+//
+// Filter is compiled into a hash set of extensions for filters like *.cpp,
+// other wildcard filters are matched against lower case file name.
 //
+static UINT DirListFilter_Hash(LPCWSTR lpszExt) noexcept {
+	// FNV-1a
+	UINT hash = 2166136261U;
+	while (*lpszExt) {
+		hash = (hash ^ *lpszExt++) * 16777619U;
+	}
+	return hash;
+}
+
+// filters like *.cpp, extension contains no wildcard or dot
+static inline bool DirListFilter_IsExtension(LPCWSTR lpszFilter) noexcept {
+	if (lpszFilter[0] != L'*' || lpszFilter[1] != L'.') {
+		return false;
+	}
+	return StrPBrk(lpszFilter + 2, L"*?.") == nullptr;
+}
+
+// '*' matches any sequence, '?' matches any character
+static bool DirListFilter_WildcardMatch(LPCWSTR pattern, LPCWSTR name) noexcept {
+	LPCWSTR star = nullptr;
+	LPCWSTR resume = nullptr;
+	while (*name) {
+		if (*pattern == L'*') {
+			star = ++pattern;
+			resume = name;
+		} else if (*pattern == L'?' || *pattern == *name) {
+			++pattern;
+			++name;
+		} else if (star != nullptr) {
+			// let last '*' match one more character
+			pattern = star;
+			name = ++resume;
+		} else {
+			return false;
+		}
+	}
+	while (*pattern == L'*') {
+		++pattern;
+	}
+	return *pattern == L'\0';
+}
+
 void DirListFilter::Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept {
 	memset(this, 0, sizeof(DirListFilter));
 	if (StrIsEmpty(lpszFileSpec) || StrEqualEx(lpszFileSpec, L"*.*")) {
@@ -691,31 +1614,88 @@ void DirListFilter::Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept {
 	}
 
 	lstrcpyn(tFilterBuf, lpszFileSpec, (DL_FILTER_BUFSIZE - 1));
+	CharLower(tFilterBuf);
 	bExcludeFilter = bExclude;
 	nCount = 1;
-	pFilter[0] = tFilterBuf;    // Zeile zum Ausprobieren
 
-	WCHAR *p;
-	while ((p = StrChr(pFilter[nCount - 1], L';')) != nullptr) {
-		*p = L'\0';                              // Replace L';' by L'\0'
-		pFilter[nCount] = (p + 1);  // Next position after L';'
-		nCount++;                         // Increase number of filters
+	LPWSTR p = tFilterBuf;
+	while (true) {
+		LPWSTR end = StrChr(p, L';');
+		if (end != nullptr) {
+			*end = L'\0';		// Replace L';' by L'\0'
+		}
+		if (*p) { // Filters like L"\0" are ignored
+			if (StrEqualEx(p, L"*") || StrEqualEx(p, L"*.*")) {
+				bMatchAll = true;
+			} else if (StrEqualEx(p, L"*.")) {
+				bMatchNoExtension = true;
+			} else if (DirListFilter_IsExtension(p)) {
+				LPCWSTR ext = p + 2;
+				UINT index = DirListFilter_Hash(ext) & (DL_FILTER_HASHSIZE - 1);
+				while (pExtension[index] != nullptr && !StrEqual(pExtension[index], ext)) {
+					index = (index + 1) & (DL_FILTER_HASHSIZE - 1);
+				}
+				pExtension[index] = ext;
+				nExtension++;
+			} else {
+				pFilter[nPattern++] = p;
+			}
+		}
+		if (end == nullptr) {
+			break;
+		}
+		p = end + 1;	// Next position after L';'
+		nCount++;		// Increase number of filters
 	}
 }
 
 //=============================================================================
 //
-//  Check if a specified item matches a given filter
+// Check if a file name matches any filter
 //
-bool DirListFilter::Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept {
+bool DirListFilter::MatchName(LPCWSTR lpszName) const noexcept {
+	if (bMatchAll) {
+		return true;
+	}
+
+	WCHAR szName[MAX_PATH];
+	lstrcpyn(szName, lpszName, COUNTOF(szName));
+	CharLower(szName);
+
+	LPCWSTR ext = PathFindExtension(szName);
+	if (*ext == L'\0') {
+		if (bMatchNoExtension) {
+			return true;
+		}
+	} else if (nExtension != 0 && ext[1] != L'\0') {
+		ext++;
+		UINT index = DirListFilter_Hash(ext) & (DL_FILTER_HASHSIZE - 1);
+		while (pExtension[index] != nullptr) {
+			if (StrEqual(pExtension[index], ext)) {
+				return true;
+			}
+			index = (index + 1) & (DL_FILTER_HASHSIZE - 1);
+		}
+	}
+
+	for (int i = 0; i < nPattern; i++) {
+		if (DirListFilter_WildcardMatch(pFilter[i], szName)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+//=============================================================================
+//
+// Check if a specified item matches a given filter
+//
+bool DirListFilter::Match(const WIN32_FIND_DATA &fd) const noexcept {
 	// Immediately return true if lpszFileSpec is *.* or nullptr
 	if (nCount == 0 && !bExcludeFilter) {
 		return true;
 	}
 
-	WIN32_FIND_DATA fd;
-	SHGetDataFromIDList(lpsf, reinterpret_cast<PCUITEMID_CHILD>(pidl), SHGDFIL_FINDDATA, &fd, sizeof(WIN32_FIND_DATA));
-
 	// All the directories are added
 	if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
 		return true;
@@ -726,42 +1706,499 @@ bool DirListFilter::Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept
 		return false;
 	}
 
-	for (int i = 0; i < nCount; i++) {
-		if (*pFilter[i]) { // Filters like L"\0" are ignored
-			const BOOL bMatchSpec = PathMatchSpec(fd.cFileName, pFilter[i]);
-			if (bMatchSpec) {
-				return !bExcludeFilter;
-			}
-		}
+	if (MatchName(fd.cFileName)) {
+		return !bExcludeFilter;
 	}
 
 	// No matching
 	return bExcludeFilter;
 }
 
+//==== FileSearch =============================================================
+#define FS_MAX_WORKER_COUNT		16
+#define FS_BATCH_SIZE			256
+
+// directory waiting to be enumerated, full path without trailing backslash
+struct FileSearchDir {
+	FileSearchDir *next;
+	UINT cchPath;
+	WCHAR szPath[1];
+};
+
+// matched paths of one worker, committed after each directory or when full
+struct FileSearchBatch {
+	UINT count;
+	UINT cchNames;
+	UINT offsets[FS_BATCH_SIZE];
+	WCHAR names[FS_BATCH_SIZE * MAX_PATH];
+};
+
+struct FileSearch {
+	BackgroundWorker worker;	// workerThread waits for pool workers
+	DirListFilter filter;		// matched against every name
+	DirListFilter exclude;		// directories not descended into
+	bool bIncludeHidden;
+	UINT cchRoot;
+	SRWLOCK lock;
+	CONDITION_VARIABLE cvPending;
+	FileSearchDir *pending;		// directories not yet enumerated, used as stack
+	UINT busyCount;				// workers enumerating a directory
+	LPCWSTR *results;			// Full path of matched items
+	int resultCount;
+	int resultCapacity;
+	DirListNames *names;		// Blocks referenced by results
+	LONG64 scanCount;			// Enumerated items
+	LONG finished;
+	WCHAR szRoot[MAX_PATH];
+
+	void Commit(FileSearchBatch *batch, FileSearchDir *head, FileSearchDir *tail, bool finishedDir) noexcept;
+	void ScanDirectory(const FileSearchDir *dir, FileSearchBatch *batch) noexcept;
+	void DoWork() noexcept;
+	void WakeAll() noexcept {
+		AcquireSRWLockExclusive(&lock);
+		ReleaseSRWLockExclusive(&lock);
+		WakeAllConditionVariable(&cvPending);
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		FileSearch *search = static_cast<FileSearch *>(context);
+		search->DoWork();
+	}
+};
+
+static FileSearchDir *FileSearch_NewDir(LPCWSTR lpszParent, UINT cchParent, LPCWSTR lpszName, UINT cchName) noexcept {
+	const UINT cchPath = cchParent + (cchParent != 0) + cchName;
+	FileSearchDir *dir = static_cast<FileSearchDir *>(NP2HeapAlloc(sizeof(FileSearchDir) + cchPath * sizeof(WCHAR)));
+	if (dir) {
+		dir->cchPath = cchPath;
+		LPWSTR p = dir->szPath;
+		if (cchParent != 0) {
+			memcpy(p, lpszParent, cchParent * sizeof(WCHAR));
+			p += cchParent;
+			*p++ = L'\\';
+		}
+		memcpy(p, lpszName, (cchName + 1) * sizeof(WCHAR));
+	}
+	return dir;
+}
+
+// append results and subdirectories with single lock
+void FileSearch::Commit(FileSearchBatch *batch, FileSearchDir *head, FileSearchDir *tail, bool finishedDir) noexcept {
+	DirListNames *block = nullptr;
+	if (batch->count != 0) {
+		block = static_cast<DirListNames *>(NP2HeapAlloc(sizeof(DirListNames) + batch->cchNames * sizeof(WCHAR)));
+		if (block) {
+			memcpy(DirList_NameBuffer(block), batch->names, batch->cchNames * sizeof(WCHAR));
+		}
+	}
+
+	AcquireSRWLockExclusive(&lock);
+	if (block) {
+		const int count = resultCount + batch->count;
+		if (count > resultCapacity) {
+			const int capacity = max(max(resultCapacity * 2, count), 1024);
+			LPCWSTR *items;
+			if (results) {
+				items = static_cast<LPCWSTR *>(NP2HeapReAlloc(results, capacity * sizeof(LPCWSTR)));
+			} else {
+				items = static_cast<LPCWSTR *>(NP2HeapAlloc(capacity * sizeof(LPCWSTR)));
+			}
+			if (items) {
+				results = items;
+				resultCapacity = capacity;
+			}
+		}
+		if (count <= resultCapacity) {
+			LPCWSTR buffer = DirList_NameBuffer(block);
+			for (UINT i = 0; i < batch->count; i++) {
+				results[resultCount++] = buffer + batch->offsets[i];
+			}
+			block->next = names;
+			names = block;
+			block = nullptr;
+		}
+	}
+	if (head) {
+		tail->next = pending;
+		pending = head;
+	}
+	if (finishedDir) {
+		--busyCount;
+	}
+	const bool wake = head != nullptr || (finishedDir && busyCount == 0);
+	ReleaseSRWLockExclusive(&lock);
+
+	if (wake) {
+		WakeAllConditionVariable(&cvPending);
+	}
+	if (block) {
+		NP2HeapFree(block);
+	}
+	batch->count = 0;
+	batch->cchNames = 0;
+}
+
+void FileSearch::ScanDirectory(const FileSearchDir *dir, FileSearchBatch *batch) noexcept {
+	WCHAR szPath[MAX_PATH + 2];
+	const UINT cchDir = dir->cchPath;
+	memcpy(szPath, dir->szPath, cchDir * sizeof(WCHAR));
+	szPath[cchDir] = L'\\';
+	szPath[cchDir + 1] = L'*';
+	szPath[cchDir + 2] = L'\0';
+
+	FileSearchDir *head = nullptr;
+	FileSearchDir *tail = nullptr;
+	WIN32_FIND_DATA fd;
+	HANDLE hFind = FindFirstFileEx(szPath, FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+	if (hFind != INVALID_HANDLE_VALUE) {
+		const bool bMatchAll = filter.nCount == 0;
+		LONG64 count = 0;
+		do {
+			LPCWSTR pszName = fd.cFileName;
+			if (pszName[0] == L'.' && (pszName[1] == L'\0' || (pszName[1] == L'.' && pszName[2] == L'\0'))) {
+				continue;
+			}
+			++count;
+			if ((count & 1023) == 0 && !worker.Continue()) {
+				break;
+			}
+			if (!bIncludeHidden && (fd.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM))) {
+				continue;
+			}
+			const UINT cchName = lstrlen(pszName);
+			const UINT cchPath = cchDir + 1 + cchName;
+			// path can't be opened later
+			if (cchPath >= MAX_PATH - 1) {
+				continue;
+			}
+
+			if (bMatchAll || filter.MatchName(pszName)) {
+				if (batch->count == FS_BATCH_SIZE) {
+					Commit(batch, nullptr, nullptr, false);
+				}
+				LPWSTR p = batch->names + batch->cchNames;
+				batch->offsets[batch->count++] = batch->cchNames;
+				memcpy(p, szPath, (cchDir + 1) * sizeof(WCHAR));
+				memcpy(p + cchDir + 1, pszName, (cchName + 1) * sizeof(WCHAR));
+				batch->cchNames += cchPath + 1;
+			}
+			// junctions and symbolic links are not followed to avoid cycles
+			if ((fd.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) == FILE_ATTRIBUTE_DIRECTORY
+				&& !exclude.MatchName(pszName)) {
+				FileSearchDir *child = FileSearch_NewDir(szPath, cchDir, pszName, cchName);
+				if (child) {
+					child->next = head;
+					head = child;
+					if (tail == nullptr) {
+						tail = child;
+					}
+				}
+			}
+		} while (FindNextFile(hFind, &fd));
+		FindClose(hFind);
+		InterlockedExchangeAdd64(&scanCount, count);
+	}
+
+	Commit(batch, head, tail, true);
+}
+
+void FileSearch::DoWork() noexcept {
+	FileSearchBatch *batch = static_cast<FileSearchBatch *>(NP2HeapAlloc(sizeof(FileSearchBatch)));
+	if (batch == nullptr) {
+		return;
+	}
+
+	while (true) {
+		AcquireSRWLockExclusive(&lock);
+		// wait for subdirectories found by other workers
+		while (pending == nullptr && busyCount != 0 && worker.Continue()) {
+			SleepConditionVariableSRW(&cvPending, &lock, INFINITE, 0);
+		}
+		FileSearchDir *dir = worker.Continue() ? pending : nullptr;
+		if (dir) {
+			pending = dir->next;
+			++busyCount;
+		}
+		ReleaseSRWLockExclusive(&lock);
+		if (dir == nullptr) {
+			break;
+		}
+
+		ScanDirectory(dir, batch);
+		NP2HeapFree(dir);
+	}
+
+	NP2HeapFree(batch);
+}
+
+static DWORD WINAPI FileSearch_Thread(LPVOID lpParam) noexcept {
+	FileSearch * const search = static_cast<FileSearch *>(lpParam);
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), FS_MAX_WORKER_COUNT);
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(FileSearch::WorkCallback, search, nullptr) : nullptr;
+	if (work != nullptr) {
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	search->DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+
+	InterlockedExchange(&search->finished, TRUE);
+	return 0;
+}
+
+//=============================================================================
+//
+// FileSearch_Start()
+//
+// Search names under lpszRoot recursively on pool workers, directories
+// matching lpszExclude are skipped. Returns nullptr when failed.
+//
+FileSearch *FileSearch_Start(LPCWSTR lpszRoot, LPCWSTR lpszFileSpec, LPCWSTR lpszExclude, bool bIncludeHidden) noexcept {
+	UINT cchRoot = lstrlen(lpszRoot);
+	while (cchRoot != 0 && lpszRoot[cchRoot - 1] == L'\\') {
+		--cchRoot;
+	}
+	if (cchRoot == 0 || cchRoot >= MAX_PATH - 2) {
+		return nullptr;
+	}
+
+	FileSearch *search = static_cast<FileSearch *>(NP2HeapAlloc(sizeof(FileSearch)));
+	if (search == nullptr) {
+		return nullptr;
+	}
+
+	search->worker.Init(nullptr);
+	search->filter.Create(lpszFileSpec, false);
+	search->exclude.Create(lpszExclude, false);
+	search->bIncludeHidden = bIncludeHidden;
+	InitializeSRWLock(&search->lock);
+	InitializeConditionVariable(&search->cvPending);
+	memcpy(search->szRoot, lpszRoot, cchRoot * sizeof(WCHAR));
+	search->cchRoot = cchRoot;
+	search->pending = FileSearch_NewDir(nullptr, 0, search->szRoot, cchRoot);
+	if (search->pending) {
+		search->worker.workerThread = CreateThread(nullptr, 0, FileSearch_Thread, search, 0, nullptr);
+	}
+	if (search->worker.workerThread == nullptr) {
+		FileSearch_Free(search);
+		return nullptr;
+	}
+	return search;
+}
+
+// Returns false after search is finished or canceled
+bool FileSearch_GetStatus(FileSearch *search, int *pResultCount, LONG64 *pScanCount) noexcept {
+	AcquireSRWLockShared(&search->lock);
+	*pResultCount = search->resultCount;
+	ReleaseSRWLockShared(&search->lock);
+	*pScanCount = InterlockedCompareExchange64(&search->scanCount, 0, 0);
+	return !InterlockedCompareExchange(&search->finished, 0, 0);
+}
+
+// Full path or path relative to search root of matched item
+bool FileSearch_GetResult(FileSearch *search, int iItem, LPWSTR lpszPath, int cchPath, bool bFullPath) noexcept {
+	bool result = false;
+	AcquireSRWLockShared(&search->lock);
+	if (iItem >= 0 && iItem < search->resultCount) {
+		LPCWSTR path = search->results[iItem];
+		if (!bFullPath) {
+			path += search->cchRoot + 1;
+		}
+		lstrcpyn(lpszPath, path, cchPath);
+		result = true;
+	}
+	ReleaseSRWLockShared(&search->lock);
+	return result;
+}
+
+void FileSearch_Cancel(FileSearch *search) noexcept {
+	SetEvent(search->worker.eventCancel);
+	search->WakeAll();
+	search->worker.Stop();
+}
+
+void FileSearch_Free(FileSearch *search) noexcept {
+	if (search->worker.eventCancel) {
+		FileSearch_Cancel(search);
+		CloseHandle(search->worker.eventCancel);
+	}
+
+	FileSearchDir *dir = search->pending;
+	while (dir) {
+		FileSearchDir * const next = dir->next;
+		NP2HeapFree(dir);
+		dir = next;
+	}
+	DirListNames *names = search->names;
+	while (names) {
+		DirListNames * const next = names->next;
+		NP2HeapFree(names);
+		names = next;
+	}
+	if (search->results) {
+		NP2HeapFree(search->results);
+	}
+	NP2HeapFree(search);
+}
+
 //==== DriveBox ===============================================================
 
 //=============================================================================
 //
-//  Internal Itemdata Structure
+//  Drive Cache
 //
-struct DC_ITEMDATA {
-	LPITEMIDLIST pidl;
-	LPSHELLFOLDER lpsf;
+// names and icons of drives are resolved on thread pool, results are cached
+// between refreshes, items are identified by drive index + 1 in lParam.
+#define DRIVEBOX_DRIVE_COUNT	26
+
+struct DriveBoxDrive {
+	WCHAR szName[MAX_PATH];		// Display name, empty when not available
+	int iImage;					// Icon of drive
+	int iDefImage;				// Stock icon for drive type, used before drive is resolved
+	bool bResolved;
+	bool bPending;				// Query is running on thread pool
+	bool bStale;				// Drive is changed while query is running
 };
 
+static SRWLOCK driveBoxLock = SRWLOCK_INIT;
+static DriveBoxDrive driveBoxCache[DRIVEBOX_DRIVE_COUNT];
+static HWND hwndDriveBoxNotify;
+static UINT uDriveBoxMsgNotify;
+
+static inline void DriveBox_GetRoot(int iDrive, LPWSTR szRoot) noexcept {
+	szRoot[0] = static_cast<WCHAR>(L'A' + iDrive);
+	szRoot[1] = L':';
+	szRoot[2] = L'\\';
+	szRoot[3] = L'\0';
+}
+
+static int DriveBox_GetItemDrive(HWND hwnd, int iItem) noexcept {
+	COMBOBOXEXITEM cbei;
+	cbei.mask = CBEIF_LPARAM;
+	cbei.iItem = iItem;
+	cbei.lParam = 0;
+	SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei));
+	return static_cast<int>(cbei.lParam) - 1;
+}
+
+// a disconnected network drive or a sleeping disk may block for seconds
+static VOID CALLBACK DriveBox_ResolveCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context) noexcept {
+	const int iDrive = static_cast<int>(reinterpret_cast<INT_PTR>(context));
+	const HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+
+	WCHAR szRoot[4];
+	DriveBox_GetRoot(iDrive, szRoot);
+	SHFILEINFO shfi;
+	memset(&shfi, 0, sizeof(SHFILEINFO));
+	const bool bSuccess = 0 != SHGetFileInfo(szRoot, 0, &shfi, sizeof(SHFILEINFO), SHGFI_DISPLAYNAME | SHGFI_SYSICONINDEX | SHGFI_SMALLICON);
+	if (SUCCEEDED(hr)) {
+		CoUninitialize();
+	}
+
+	AcquireSRWLockExclusive(&driveBoxLock);
+	DriveBoxDrive &drive = driveBoxCache[iDrive];
+	drive.bPending = false;
+	if (drive.bStale) {
+		// result is outdated, query again
+		drive.bStale = false;
+	} else {
+		drive.bResolved = true;
+		drive.iImage = bSuccess ? shfi.iIcon : drive.iDefImage;
+		lstrcpyn(drive.szName, bSuccess ? shfi.szDisplayName : L"", MAX_PATH);
+	}
+	HWND hwndNotify = hwndDriveBoxNotify;
+	const UINT uMsgNotify = uDriveBoxMsgNotify;
+	ReleaseSRWLockExclusive(&driveBoxLock);
+	PostMessage(hwndNotify, uMsgNotify, iDrive, 0);
+}
+
+// query running for a drive is never submitted again, a hung drive only occupies one thread.
+static void DriveBox_QueryDrive(int iDrive) noexcept {
+	AcquireSRWLockExclusive(&driveBoxLock);
+	DriveBoxDrive &drive = driveBoxCache[iDrive];
+	if (!drive.bResolved && !drive.bPending) {
+		drive.bPending = true;
+		if (!TrySubmitThreadpoolCallback(DriveBox_ResolveCallback, reinterpret_cast<PVOID>(static_cast<INT_PTR>(iDrive)), nullptr)) {
+			drive.bPending = false;
+		}
+	}
+	ReleaseSRWLockExclusive(&driveBoxLock);
+}
+
+static void DriveBox_InvalidateDrive(int iDrive) noexcept {
+	AcquireSRWLockExclusive(&driveBoxLock);
+	DriveBoxDrive &drive = driveBoxCache[iDrive];
+	drive.bResolved = false;
+	drive.bStale = drive.bPending;
+	ReleaseSRWLockExclusive(&driveBoxLock);
+}
+
+// placeholder is shown until drive is resolved
+static void DriveBox_InsertDrive(HWND hwnd, int iItem, int iDrive) noexcept {
+	WCHAR szRoot[4];
+	DriveBox_GetRoot(iDrive, szRoot);
+	SHSTOCKICONID siid;
+	switch (GetDriveType(szRoot)) {
+	case DRIVE_REMOVABLE:
+		siid = SIID_DRIVEREMOVE;
+		break;
+	case DRIVE_REMOTE:
+		siid = SIID_DRIVENET;
+		break;
+	case DRIVE_CDROM:
+		siid = SIID_DRIVECD;
+		break;
+	case DRIVE_RAMDISK:
+		siid = SIID_DRIVERAM;
+		break;
+	default:
+		siid = SIID_DRIVEFIXED;
+		break;
+	}
+
+	SHSTOCKICONINFO sii;
+	sii.cbSize = sizeof(SHSTOCKICONINFO);
+	sii.iSysImageIndex = 0;
+	SHGetStockIconInfo(siid, SHGSI_SYSICONINDEX | SHGSI_SMALLICON, &sii);
+	AcquireSRWLockExclusive(&driveBoxLock);
+	driveBoxCache[iDrive].iDefImage = sii.iSysImageIndex;
+	ReleaseSRWLockExclusive(&driveBoxLock);
+
+	COMBOBOXEXITEM cbei;
+	memset(&cbei, 0, sizeof(COMBOBOXEXITEM));
+	cbei.mask = CBEIF_TEXT | CBEIF_IMAGE | CBEIF_SELECTEDIMAGE | CBEIF_LPARAM;
+	cbei.iItem = iItem;
+	cbei.pszText = LPSTR_TEXTCALLBACK;
+	cbei.cchTextMax = MAX_PATH;
+	cbei.iImage = I_IMAGECALLBACK;
+	cbei.iSelectedImage = I_IMAGECALLBACK;
+	cbei.lParam = iDrive + 1;
+	SendMessage(hwnd, CBEM_INSERTITEM, 0, AsInteger<LPARAM>(&cbei));
+
+	DriveBox_QueryDrive(iDrive);
+}
+
 //=============================================================================
 //
 //  DriveBox_Init()
 //
-//  Initializes the drive box
+//  Initializes the drive box, uMsgNotify is posted to hwndNotify with
+//  drive index in wParam when a drive is resolved
 //
-bool DriveBox_Init(HWND hwnd) noexcept {
+bool DriveBox_Init(HWND hwnd, HWND hwndNotify, UINT uMsgNotify) noexcept {
 	SHFILEINFO shfi;
 	DWORD_PTR hil = SHGetFileInfo(L"C:\\", 0, &shfi, sizeof(SHFILEINFO), SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
 	SendMessage(hwnd, CBEM_SETIMAGELIST, 0, hil);
 	SendMessage(hwnd, CBEM_SETEXTENDEDSTYLE, CBES_EX_NOSIZELIMIT, CBES_EX_NOSIZELIMIT);
 
+	AcquireSRWLockExclusive(&driveBoxLock);
+	hwndDriveBoxNotify = hwndNotify;
+	uDriveBoxMsgNotify = uMsgNotify;
+	ReleaseSRWLockExclusive(&driveBoxLock);
 	return true;
 }
 
@@ -769,89 +2206,93 @@ bool DriveBox_Init(HWND hwnd) noexcept {
 //
 //  DriveBox_Fill
 //
+//  Only drives added or removed since last fill are updated
+//
 int DriveBox_Fill(HWND hwnd) {
-	// Init ComboBox
-	SendMessage(hwnd, WM_SETREDRAW, 0, 0);
-	ComboBox_ResetContent(hwnd);
-
-	COMBOBOXEXITEM cbei;
-	memset(&cbei, 0, sizeof(COMBOBOXEXITEM));
-	cbei.mask = CBEIF_TEXT | CBEIF_IMAGE | CBEIF_SELECTEDIMAGE | CBEIF_LPARAM;
-	cbei.pszText = LPSTR_TEXTCALLBACK;
-	cbei.cchTextMax = MAX_PATH;
-	cbei.iImage = I_IMAGECALLBACK;
-	cbei.iSelectedImage = I_IMAGECALLBACK;
-
-	// Get pidl to [My Computer]
-	PIDLIST_ABSOLUTE pidl;
-	if (S_OK == SHGetKnownFolderIDList(FOLDERID_ComputerFolder, KF_FLAG_DEFAULT, nullptr, &pidl)) {
-		// Get Desktop Folder
-		LPSHELLFOLDER lpsfDesktop;
-		if (S_OK == SHGetDesktopFolder(&lpsfDesktop)) {
-			// Bind pidl to IShellFolder
-			LPSHELLFOLDER lpsf; // Workspace == FOLDERID_ComputerFolder
-			if (S_OK == lpsfDesktop->BindToObject(pidl, nullptr, IID_IShellFolder, AsPPVArgs(&lpsf))) {
-				// Create an Enumeration object for lpsf
-				constexpr DWORD grfFlags = SHCONTF_FOLDERS;
-				LPENUMIDLIST lpe;
-				if (S_OK == lpsf->EnumObjects(hwnd, grfFlags, &lpe)) {
-					// Enumerate the contents of [My Computer]
-					PITEMID_CHILD pidlEntry;
-					while (S_OK == lpe->Next(1, &pidlEntry, nullptr)) {
-						// Add item to the List if it is part of the
-						// Filesystem
-						ULONG dwAttributes = SFGAO_FILESYSTEM;
-						lpsf->GetAttributesOf(1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&pidlEntry), &dwAttributes);
-
-						if (dwAttributes & SFGAO_FILESYSTEM) {
-							// Windows XP: check if pidlEntry is a drive
-							SHDESCRIPTIONID di;
-							HRESULT hr = SHGetDataFromIDList(lpsf, pidlEntry, SHGDFIL_DESCRIPTIONID, &di, sizeof(SHDESCRIPTIONID));
-							if (hr != S_OK || (di.dwDescriptionId >= SHDID_COMPUTER_DRIVE35 && di.dwDescriptionId <= SHDID_COMPUTER_OTHER)) {
-								DC_ITEMDATA * const lpdcid = static_cast<DC_ITEMDATA *>(CoTaskMemAlloc(sizeof(DC_ITEMDATA)));
-								//lpdcid->pidl = IL_Copy(pidlEntry);
-								lpdcid->pidl = pidlEntry;
-								lpdcid->lpsf = lpsf;
-								lpsf->AddRef();
-
-								// Insert sorted ...
-								{
-									COMBOBOXEXITEM cbei2;
-									cbei2.mask = CBEIF_LPARAM;
-									cbei2.iItem = 0;
-
-									while ((SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei2)))) {
-										const LV_ITEMDATA * const lpdcid2 = AsPointer<const LV_ITEMDATA *>(cbei2.lParam);
-										hr = lpdcid->lpsf->CompareIDs(0, reinterpret_cast<PCUIDLIST_RELATIVE>(lpdcid->pidl), reinterpret_cast<PCUIDLIST_RELATIVE>(lpdcid2->pidl));
-
-										if (static_cast<short>(HRESULT_CODE(hr)) < 0) {
-											break;
-										}
-										cbei2.iItem++;
-									}
+	const DWORD dwDrives = GetLogicalDrives();
+
+	// Remove drives no longer available
+	DWORD dwListed = 0;
+	int iItem = ComboBox_GetCount(hwnd);
+	while (iItem > 0) {
+		--iItem;
+		const int iDrive = DriveBox_GetItemDrive(hwnd, iItem);
+		if (iDrive >= 0 && iDrive < DRIVEBOX_DRIVE_COUNT && (dwDrives & (1U << iDrive)) && !(dwListed & (1U << iDrive))) {
+			dwListed |= 1U << iDrive;
+		} else {
+			SendMessage(hwnd, CBEM_DELETEITEM, iItem, 0);
+			if (iDrive >= 0 && iDrive < DRIVEBOX_DRIVE_COUNT && !(dwListed & (1U << iDrive))) {
+				DriveBox_InvalidateDrive(iDrive);
+			}
+		}
+	}
 
-									cbei.iItem = cbei2.iItem;
-									cbei.lParam = AsInteger<LPARAM>(lpdcid);
-									SendMessage(hwnd, CBEM_INSERTITEM, 0, AsInteger<LPARAM>(&cbei));
-								}
-							}
-						}
-					} // IEnumIDList::Next()
+	// Insert new drives sorted by letter
+	iItem = 0;
+	for (int iDrive = 0; iDrive < DRIVEBOX_DRIVE_COUNT; iDrive++) {
+		const DWORD mask = 1U << iDrive;
+		if (dwListed & mask) {
+			iItem++;
+		} else if (dwDrives & mask) {
+			DriveBox_InsertDrive(hwnd, iItem, iDrive);
+			iItem++;
+		}
+	}
 
-					lpe->Release();
-				} // IShellFolder::EnumObjects()
+	// Return number of items added to combo box
+	return ComboBox_GetCount(hwnd);
+}
 
-				lpsf->Release();
-			} // IShellFolder::BindToObject()
-			CoTaskMemFree(pidl);
-		} // SHGetDesktopFolder()
+//=============================================================================
+//
+//  DriveBox_UpdateDrive
+//
+//  Redraws the drive after it's resolved, called for uMsgNotify
+//
+void DriveBox_UpdateDrive(HWND hwnd, int iDrive) {
+	const int cbItems = ComboBox_GetCount(hwnd);
+	for (int iItem = 0; iItem < cbItems; iItem++) {
+		if (DriveBox_GetItemDrive(hwnd, iItem) == iDrive) {
+			// query again when drive is changed while resolving
+			DriveBox_QueryDrive(iDrive);
+
+			// reset text and icon stored by CBEIF_DI_SETITEM
+			COMBOBOXEXITEM cbei;
+			memset(&cbei, 0, sizeof(COMBOBOXEXITEM));
+			cbei.mask = CBEIF_TEXT | CBEIF_IMAGE | CBEIF_SELECTEDIMAGE;
+			cbei.iItem = iItem;
+			cbei.pszText = LPSTR_TEXTCALLBACK;
+			cbei.cchTextMax = MAX_PATH;
+			cbei.iImage = I_IMAGECALLBACK;
+			cbei.iSelectedImage = I_IMAGECALLBACK;
+			SendMessage(hwnd, CBEM_SETITEM, 0, AsInteger<LPARAM>(&cbei));
+			InvalidateRect(hwnd, nullptr, TRUE);
+			break;
+		}
+	}
+}
 
-		lpsfDesktop->Release();
-	} // SHGetKnownFolderIDList()
+//=============================================================================
+//
+//  DriveBox_Refresh
+//
+//  Updates changed drives, e.g. from DEV_BROADCAST_VOLUME::dbcv_unitmask
+//
+int DriveBox_Refresh(HWND hwnd, DWORD dwChangedDrives) {
+	for (int iDrive = 0; iDrive < DRIVEBOX_DRIVE_COUNT; iDrive++) {
+		if (dwChangedDrives & (1U << iDrive)) {
+			DriveBox_InvalidateDrive(iDrive);
+		}
+	}
 
-	SendMessage(hwnd, WM_SETREDRAW, 1, 0);
-	// Return number of items added to combo box
-	return ComboBox_GetCount(hwnd);
+	const int cbItems = DriveBox_Fill(hwnd);
+	for (int iItem = 0; iItem < cbItems; iItem++) {
+		const int iDrive = DriveBox_GetItemDrive(hwnd, iItem);
+		if (iDrive >= 0 && (dwChangedDrives & (1U << iDrive))) {
+			DriveBox_UpdateDrive(hwnd, iDrive);
+		}
+	}
+	return cbItems;
 }
 
 //=============================================================================
@@ -865,15 +2306,15 @@ bool DriveBox_GetSelDrive(HWND hwnd, LPWSTR lpszDrive, int nDrive, bool fNoSlash
 		return false;
 	}
 
-	// Get DC_ITEMDATA* of selected Item
-	COMBOBOXEXITEM cbei;
-	cbei.mask = CBEIF_LPARAM;
-	cbei.iItem = i;
-	SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei));
-	const DC_ITEMDATA * const lpdcid = AsPointer<const DC_ITEMDATA *>(cbei.lParam);
+	const int iDrive = DriveBox_GetItemDrive(hwnd, i);
+	if (iDrive < 0) {
+		return false;
+	}
 
 	// Get File System Path for Drive
-	IL_GetDisplayName(lpdcid->lpsf, lpdcid->pidl, SHGDN_FORPARSING, lpszDrive, nDrive);
+	WCHAR szRoot[4];
+	DriveBox_GetRoot(iDrive, szRoot);
+	lstrcpyn(lpszDrive, szRoot, nDrive);
 
 	// Remove Backslash if required (makes Drive relative!!!)
 	if (fNoSlash) {
@@ -894,20 +2335,15 @@ bool DriveBox_SelectDrive(HWND hwnd, LPCWSTR lpszPath) {
 		return false;
 	}
 
-	COMBOBOXEXITEM cbei;
-	cbei.mask = CBEIF_LPARAM;
-
 	for (int i = 0; i < cbItems; i++) {
-		WCHAR szRoot[64] = L"";
-		// Get DC_ITEMDATA* of Item i
-		cbei.iItem = i;
-		SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei));
-		const DC_ITEMDATA * const lpdcid = AsPointer<const DC_ITEMDATA *>(cbei.lParam);
-
-		// Get File System Path for Drive
-		IL_GetDisplayName(lpdcid->lpsf, lpdcid->pidl, SHGDN_FORPARSING, szRoot, COUNTOF(szRoot));
+		const int iDrive = DriveBox_GetItemDrive(hwnd, i);
+		if (iDrive < 0) {
+			continue;
+		}
 
 		// Compare Root Directory with Path
+		WCHAR szRoot[4];
+		DriveBox_GetRoot(iDrive, szRoot);
 		if (PathIsSameRoot(lpszPath, szRoot)) {
 			// Select matching Drive
 			ComboBox_SetCurSel(hwnd, i);
@@ -927,66 +2363,41 @@ bool DriveBox_SelectDrive(HWND hwnd, LPCWSTR lpszPath) {
 //  Shows standard Win95 Property Dlg for selected Drive
 //
 bool DriveBox_PropertyDlg(HWND hwnd) {
-	const int iItem = ComboBox_GetCurSel(hwnd);
-	if (iItem == CB_ERR) {
+	WCHAR szRoot[4];
+	if (!DriveBox_GetSelDrive(hwnd, szRoot, COUNTOF(szRoot), false)) {
 		return false;
 	}
 
-	bool bSuccess = true;
-	COMBOBOXEXITEM cbei;
-	cbei.mask = CBEIF_LPARAM;
-	cbei.iItem = iItem;
-	SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei));
-	const DC_ITEMDATA * const lpdcid = AsPointer<const DC_ITEMDATA *>(cbei.lParam);
-	LPCONTEXTMENU lpcm;
-
-	if (S_OK == lpdcid->lpsf->GetUIObjectOf(GetParent(hwnd), 1, reinterpret_cast<PCUITEMID_CHILD_ARRAY>(&lpdcid->pidl), IID_IContextMenu, nullptr, AsPPVArgs(&lpcm))) {
-		CMINVOKECOMMANDINFO cmi;
-		cmi.cbSize = sizeof(CMINVOKECOMMANDINFO);
-		cmi.fMask = 0;
-		cmi.hwnd = GetParent(hwnd);
-		cmi.lpVerb = "properties";
-		cmi.lpParameters = nullptr;
-		cmi.lpDirectory = nullptr;
-		cmi.nShow = SW_SHOWNORMAL;
-		cmi.dwHotKey = 0;
-		cmi.hIcon = nullptr;
-
-		if (S_OK != lpcm->InvokeCommand(&cmi)) {
-			bSuccess = false;
+	bool bSuccess = false;
+	PIDLIST_ABSOLUTE pidl;
+	if (S_OK == SHParseDisplayName(szRoot, nullptr, &pidl, 0, nullptr)) {
+		LPSHELLFOLDER lpsf;
+		PCUITEMID_CHILD pidlChild;
+		if (S_OK == SHBindToParent(pidl, IID_IShellFolder, AsPPVArgs(&lpsf), &pidlChild)) {
+			LPCONTEXTMENU lpcm;
+			if (S_OK == lpsf->GetUIObjectOf(GetParent(hwnd), 1, &pidlChild, IID_IContextMenu, nullptr, AsPPVArgs(&lpcm))) {
+				CMINVOKECOMMANDINFO cmi;
+				cmi.cbSize = sizeof(CMINVOKECOMMANDINFO);
+				cmi.fMask = 0;
+				cmi.hwnd = GetParent(hwnd);
+				cmi.lpVerb = "properties";
+				cmi.lpParameters = nullptr;
+				cmi.lpDirectory = nullptr;
+				cmi.nShow = SW_SHOWNORMAL;
+				cmi.dwHotKey = 0;
+				cmi.hIcon = nullptr;
+
+				bSuccess = S_OK == lpcm->InvokeCommand(&cmi);
+				lpcm->Release();
+			}
+			lpsf->Release();
 		}
-
-		lpcm->Release();
-	} else {
-		bSuccess = false;
+		CoTaskMemFree(pidl);
 	}
 
 	return bSuccess;
 }
 
-//=============================================================================
-//
-//  DriveBox_DeleteItem
-//
-bool DriveBox_DeleteItem(HWND hwnd, LPARAM lParam) {
-	const NMCOMBOBOXEX *lpnmcbe = AsPointer<NMCOMBOBOXEX *>(lParam);
-	COMBOBOXEXITEM cbei;
-	cbei.iItem = lpnmcbe->ceItem.iItem;
-
-	cbei.mask = CBEIF_LPARAM;
-	SendMessage(hwnd, CBEM_GETITEM, 0, AsInteger<LPARAM>(&cbei));
-	DC_ITEMDATA * const lpdcid = AsPointer<DC_ITEMDATA *>(cbei.lParam);
-
-	// Free pidl
-	CoTaskMemFree(lpdcid->pidl);
-	// Release lpsf
-	lpdcid->lpsf->Release();
-	// Free lpdcid itself
-	CoTaskMemFree(lpdcid);
-
-	return true;
-}
-
 //=============================================================================
 //
 //  DriveBox_GetDispInfo
@@ -995,29 +2406,38 @@ bool DriveBox_GetDispInfo(HWND hwnd, LPARAM lParam) {
 	UNREFERENCED_PARAMETER(hwnd);
 
 	NMCOMBOBOXEX *lpnmcbe = AsPointer<NMCOMBOBOXEX *>(lParam);
-	const DC_ITEMDATA * const lpdcid = AsPointer<const DC_ITEMDATA *>(lpnmcbe->ceItem.lParam);
-
-	if (!lpdcid) {
+	const int iDrive = static_cast<int>(lpnmcbe->ceItem.lParam) - 1;
+	if (iDrive < 0 || iDrive >= DRIVEBOX_DRIVE_COUNT) {
 		return false;
 	}
 
-	// Get Display Name
+	AcquireSRWLockShared(&driveBoxLock);
+	const DriveBoxDrive &drive = driveBoxCache[iDrive];
+	const bool bResolved = drive.bResolved;
+	// Get Display Name, drive letter is shown before drive is resolved
 	if (lpnmcbe->ceItem.mask & CBEIF_TEXT) {
-		IL_GetDisplayName(lpdcid->lpsf, lpdcid->pidl, SHGDN_NORMAL, lpnmcbe->ceItem.pszText, lpnmcbe->ceItem.cchTextMax);
+		if (bResolved && StrNotEmpty(drive.szName)) {
+			lstrcpyn(lpnmcbe->ceItem.pszText, drive.szName, lpnmcbe->ceItem.cchTextMax);
+		} else {
+			WCHAR szRoot[4];
+			DriveBox_GetRoot(iDrive, szRoot);
+			PathRemoveBackslash(szRoot);
+			lstrcpyn(lpnmcbe->ceItem.pszText, szRoot, lpnmcbe->ceItem.cchTextMax);
+		}
 	}
 
 	// Get Icon Index
 	if (lpnmcbe->ceItem.mask & (CBEIF_IMAGE | CBEIF_SELECTEDIMAGE)) {
-		WCHAR szTemp[MAX_PATH];
-		SHFILEINFO shfi;
-		IL_GetDisplayName(lpdcid->lpsf, lpdcid->pidl, SHGDN_FORPARSING, szTemp, MAX_PATH);
-		SHGetFileInfo(szTemp, 0, &shfi, sizeof(SHFILEINFO), SHGFI_SYSICONINDEX | SHGFI_SMALLICON);
-		lpnmcbe->ceItem.iImage = shfi.iIcon;
-		lpnmcbe->ceItem.iSelectedImage = shfi.iIcon;
+		const int iImage = bResolved ? drive.iImage : drive.iDefImage;
+		lpnmcbe->ceItem.iImage = iImage;
+		lpnmcbe->ceItem.iSelectedImage = iImage;
 	}
+	ReleaseSRWLockShared(&driveBoxLock);
 
-	// Set values
-	lpnmcbe->ceItem.mask |= CBEIF_DI_SETITEM;
+	// Set values, placeholder is requested again
+	if (bResolved) {
+		lpnmcbe->ceItem.mask |= CBEIF_DI_SETITEM;
+	}
 
 	return true;
 }
@@ -1098,3 +2518,151 @@ bool IL_GetDisplayName(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl, DWORD dwFlags, LP
 
 	return false;
 }
+
+//==== IconCache ==============================================================
+
+// system image list index of files, shared by icon threads.
+struct IconCacheEntry {
+	LPWSTR key;					// Lower case extension, or path for files with own icon
+	UINT hash;
+	int iImage;
+	FILETIME ftLastWriteTime;	// Validates cached icon of file with own icon
+};
+
+static SRWLOCK iconCacheLock = SRWLOCK_INIT;
+static IconCacheEntry *iconCacheTable;
+static UINT iconCacheCount;
+static UINT iconCacheCapacity;
+
+// icon of these files is extracted from the file itself
+static bool IconCache_HasOwnIcon(LPCWSTR pszExt) noexcept {
+	static const WCHAR * const ownIconExtensions[] = {
+		L".exe", L".lnk", L".ico", L".cur", L".ani", L".url",
+	};
+	for (LPCWSTR ext : ownIconExtensions) {
+		if (StrCaseEqual(pszExt, ext)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static UINT IconCache_Hash(LPCWSTR key) noexcept {
+	// FNV-1a
+	UINT hash = 2166136261U;
+	while (*key) {
+		hash = (hash ^ *key++) * 16777619U;
+	}
+	return hash;
+}
+
+// open addressing with linear probing, returns empty slot when key is not found
+static IconCacheEntry *IconCache_FindSlot(IconCacheEntry *table, UINT capacity, LPCWSTR key, UINT hash) noexcept {
+	UINT index = hash & (capacity - 1);
+	while (table[index].key != nullptr) {
+		if (table[index].hash == hash && StrEqual(table[index].key, key)) {
+			break;
+		}
+		index = (index + 1) & (capacity - 1);
+	}
+	return &table[index];
+}
+
+static bool IconCache_Lookup(LPCWSTR key, UINT hash, const FILETIME &ftLastWriteTime, int *piImage) noexcept {
+	bool found = false;
+	AcquireSRWLockShared(&iconCacheLock);
+	if (iconCacheTable != nullptr) {
+		const IconCacheEntry *entry = IconCache_FindSlot(iconCacheTable, iconCacheCapacity, key, hash);
+		if (entry->key != nullptr && CompareFileTime(&entry->ftLastWriteTime, &ftLastWriteTime) == 0) {
+			*piImage = entry->iImage;
+			found = true;
+		}
+	}
+	ReleaseSRWLockShared(&iconCacheLock);
+	return found;
+}
+
+static void IconCache_Insert(LPCWSTR key, UINT hash, const FILETIME &ftLastWriteTime, int iImage) noexcept {
+	AcquireSRWLockExclusive(&iconCacheLock);
+	// keep load factor below 3/4
+	if ((iconCacheCount + 1) * 4 > iconCacheCapacity * 3) {
+		const UINT capacity = max(iconCacheCapacity * 2, 256U);
+		IconCacheEntry *table = static_cast<IconCacheEntry *>(NP2HeapAlloc(capacity * sizeof(IconCacheEntry)));
+		if (table != nullptr) {
+			for (UINT i = 0; i < iconCacheCapacity; i++) {
+				const IconCacheEntry &entry = iconCacheTable[i];
+				if (entry.key != nullptr) {
+					*IconCache_FindSlot(table, capacity, entry.key, entry.hash) = entry;
+				}
+			}
+			if (iconCacheTable != nullptr) {
+				NP2HeapFree(iconCacheTable);
+			}
+			iconCacheTable = table;
+			iconCacheCapacity = capacity;
+		}
+	}
+
+	if ((iconCacheCount + 1) * 4 <= iconCacheCapacity * 3) {
+		IconCacheEntry *entry = IconCache_FindSlot(iconCacheTable, iconCacheCapacity, key, hash);
+		if (entry->key == nullptr) {
+			const size_t cbKey = (lstrlen(key) + 1) * sizeof(WCHAR);
+			LPWSTR pszKey = static_cast<LPWSTR>(NP2HeapAlloc(cbKey));
+			if (pszKey != nullptr) {
+				memcpy(pszKey, key, cbKey);
+				entry->key = pszKey;
+				entry->hash = hash;
+				iconCacheCount++;
+			}
+		}
+		if (entry->key != nullptr) {
+			entry->iImage = iImage;
+			entry->ftLastWriteTime = ftLastWriteTime;
+		}
+	}
+	ReleaseSRWLockExclusive(&iconCacheLock);
+}
+
+//=============================================================================
+//
+// IconCache_GetFileIcon()
+//
+// Gets small icon index in system image list for a file, icon is cached
+// by extension, or by path and last write time for files with own icon.
+// pftLastWriteTime is nullptr for files not accessible, which use icon of
+// the extension.
+//
+int IconCache_GetFileIcon(LPCWSTR lpszPath, DWORD dwFileAttributes, const FILETIME *pftLastWriteTime) noexcept {
+	SHFILEINFO shfi;
+	shfi.iIcon = 0;
+	// folders may have custom icon
+	if (dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+		SHGetFileInfo(lpszPath, 0, &shfi, sizeof(SHFILEINFO), SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+		return shfi.iIcon;
+	}
+
+	LPCWSTR pszExt = PathFindExtension(lpszPath);
+	const bool bOwnIcon = pftLastWriteTime != nullptr && IconCache_HasOwnIcon(pszExt);
+
+	WCHAR key[MAX_PATH];
+	lstrcpyn(key, bOwnIcon ? lpszPath : pszExt, COUNTOF(key));
+	CharLower(key);
+	const UINT hash = IconCache_Hash(key);
+	FILETIME ftLastWriteTime = { 0, 0 };
+	if (bOwnIcon) {
+		ftLastWriteTime = *pftLastWriteTime;
+	}
+
+	int iImage;
+	if (IconCache_Lookup(key, hash, ftLastWriteTime, &iImage)) {
+		return iImage;
+	}
+
+	if (bOwnIcon) {
+		SHGetFileInfo(lpszPath, 0, &shfi, sizeof(SHFILEINFO), SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+	} else {
+		SHGetFileInfo(StrIsEmpty(pszExt) ? L"File" : pszExt, FILE_ATTRIBUTE_NORMAL, &shfi, sizeof(SHFILEINFO), SHGFI_USEFILEATTRIBUTES | SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+	}
+	IconCache_Insert(key, hash, ftLastWriteTime, shfi.iIcon);
+	return shfi.iIcon;
+}
@@ -37,7 +37,7 @@ int DirList_Fill(HWND hwnd, LPCWSTR lpszDir, DWORD grfFlags, LPCWSTR lpszFileSpe
 				 int iSortFlags, bool fSortRev);
 DWORD WINAPI DirList_IconThread(LPVOID lpParam);
 bool DirList_GetDispInfo(HWND hwnd, LPARAM lParam);
-bool DirList_DeleteItem(HWND hwnd, LPARAM lParam);
+int DirList_FindItem(HWND hwnd, LPARAM lParam);
 
 #define DS_NAME     0
 #define DS_SIZE     1
@@ -45,6 +45,9 @@ bool DirList_DeleteItem(HWND hwnd, LPARAM lParam);
 #define DS_LASTMOD  3
 
 BOOL DirList_Sort(HWND hwnd, int lFlags, bool fRev) noexcept;
+void DirList_WatchChanges(HWND hwnd, HWND hwndNotify, UINT uMsgNotify) noexcept;
+bool DirList_IsWatching(HWND hwnd) noexcept;
+bool DirList_ApplyChanges(HWND hwnd);
 
 #define DLE_NONE 0
 #define DLE_DIR  1
@@ -71,23 +74,40 @@ bool DirList_SelectItem(HWND hwnd, LPCWSTR lpszDisplayName, LPCWSTR lpszFullPath
 bool DirList_IsFileSelected(HWND hwnd);
 
 #define DL_FILTER_BUFSIZE 128
+#define DL_FILTER_HASHSIZE 64	// power of 2, larger than number of extension filters
 struct DirListFilter {
 	int nCount;
+	int nPattern;
+	int nExtension;
 	bool bExcludeFilter;
+	bool bMatchAll;				// * or *.*
+	bool bMatchNoExtension;		// *.
 	WCHAR tFilterBuf[DL_FILTER_BUFSIZE];
 	LPWSTR pFilter[DL_FILTER_BUFSIZE];
+	LPCWSTR pExtension[DL_FILTER_HASHSIZE];
 	void Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept;
-	bool Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept;
+	bool MatchName(LPCWSTR lpszName) const noexcept;
+	bool Match(const WIN32_FIND_DATA &fd) const noexcept;
 };
 
-bool DriveBox_Init(HWND hwnd) noexcept;
+struct FileSearch;
+FileSearch *FileSearch_Start(LPCWSTR lpszRoot, LPCWSTR lpszFileSpec, LPCWSTR lpszExclude, bool bIncludeHidden) noexcept;
+bool FileSearch_GetStatus(FileSearch *search, int *pResultCount, LONG64 *pScanCount) noexcept;
+bool FileSearch_GetResult(FileSearch *search, int iItem, LPWSTR lpszPath, int cchPath, bool bFullPath) noexcept;
+void FileSearch_Cancel(FileSearch *search) noexcept;
+void FileSearch_Free(FileSearch *search) noexcept;
+
+bool DriveBox_Init(HWND hwnd, HWND hwndNotify, UINT uMsgNotify) noexcept;
 int  DriveBox_Fill(HWND hwnd);
+void DriveBox_UpdateDrive(HWND hwnd, int iDrive);
+int  DriveBox_Refresh(HWND hwnd, DWORD dwChangedDrives);
 bool DriveBox_GetSelDrive(HWND hwnd, LPWSTR lpszDrive, int nDrive, bool fNoSlash);
 bool DriveBox_SelectDrive(HWND hwnd, LPCWSTR lpszPath);
 bool DriveBox_PropertyDlg(HWND hwnd);
-bool DriveBox_DeleteItem(HWND hwnd, LPARAM lParam);
 bool DriveBox_GetDispInfo(HWND hwnd, LPARAM lParam);
 
 LPITEMIDLIST IL_Create(LPCITEMIDLIST pidl1, UINT cb1, LPCITEMIDLIST pidl2, UINT cb2) noexcept;
 UINT IL_GetSize(LPCITEMIDLIST pidl) noexcept;
 bool IL_GetDisplayName(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl, DWORD dwFlags, LPWSTR lpszDisplayName, int nDisplayName);
+
+int IconCache_GetFileIcon(LPCWSTR lpszPath, DWORD dwFileAttributes, const FILETIME *pftLastWriteTime) noexcept;
@@ -398,6 +398,21 @@ void BackgroundWorker::Destroy() noexcept {
 	CloseHandle(eventCancel);
 }
 
+UINT GetHardwareConcurrency() noexcept {
+	static UINT hardwareConcurrency = 0;
+	if (hardwareConcurrency == 0) {
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+		hardwareConcurrency = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+		SYSTEM_INFO info;
+		GetNativeSystemInfo(&info);
+		hardwareConcurrency = info.dwNumberOfProcessors;
+#endif
+		hardwareConcurrency = max(hardwareConcurrency, 1U);
+	}
+	return hardwareConcurrency;
+}
+
 //=============================================================================
 //
 // PrivateSetCurrentProcessExplicitAppUserModelID()
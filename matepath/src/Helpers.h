@@ -310,6 +310,7 @@ inline int GetBitmapResourceIdForCurrentDPI(int resourceId) noexcept {
 // https://docs.microsoft.com/en-us/windows/desktop/Memory/comparing-memory-allocation-methods
 // https://blogs.msdn.microsoft.com/oldnewthing/20120316-00/?p=8083/
 #define NP2HeapAlloc(size)			HeapAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, (size))
+#define NP2HeapReAlloc(hMem, size)	HeapReAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, (hMem), (size))
 #define NP2HeapFree(hMem)			HeapFree(g_hDefaultHeap, 0, (hMem))
 // #define NP2HeapSize(hMem)			HeapSize(g_hDefaultHeap, 0, (hMem))
 
@@ -476,6 +477,9 @@ struct BackgroundWorker {
 	}
 };
 
+// number of logical processors, used to limit thread pool work items.
+UINT GetHardwareConcurrency() noexcept;
+
 HRESULT PrivateSetCurrentProcessExplicitAppUserModelID(LPCWSTR AppID) noexcept;
 bool IsElevated() noexcept;
 bool ExeNameFromWnd(HWND hwnd, LPWSTR szExeName, DWORD cchExeName) noexcept;
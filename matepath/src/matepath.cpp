@@ -25,6 +25,7 @@
 #include <shlobj.h>
 #include <shellapi.h>
 #include <commdlg.h>
+#include <dbt.h>
 #include <uxtheme.h>
 // #include <dbghelp.h>
 #include <cstdio>
@@ -50,6 +51,8 @@ static HWND hwndReBar;
 
 #define TOOLBAR_COMMAND_BASE	IDT_HISTORY_BACK
 #define DefaultToolbarButtons	L"1 2 3 4 5 0 8"
+// directories skipped by FindFileDlg()
+#define DefaultFindFileExclude	L".git;.svn;.hg;node_modules"
 static TBBUTTON tbbMainWnd[] = {
 	{0, 0, 0, TBSTYLE_SEP, {0}, 0, 0},
 	{0, IDT_HISTORY_BACK, TBSTATE_ENABLED, TBSTYLE_BUTTON, {0}, 0, 0},
@@ -113,6 +116,7 @@ static bool bShowDriveBox;
 
 WCHAR		tchFilter[DL_FILTER_BUFSIZE];
 bool		bNegFilter;
+WCHAR		tchFindFileExclude[DL_FILTER_BUFSIZE];
 bool		bDefColorNoFilter;
 bool		bDefColorFilter;
 COLORREF	colorNoFilter;
@@ -538,6 +542,7 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 		if (!bShutdownOK) {
 			// Terminate directory watching
 			KillTimer(hwnd, ID_TIMER);
+			KillTimer(hwnd, ID_WATCHTIMER);
 			FindCloseChangeNotification(hChangeHandle);
 
 			DirList_Destroy(hwndDirList);
@@ -606,6 +611,32 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hwnd, umsg, wParam, lParam);
 
 	case WM_TIMER:
+		if (wParam == ID_WATCHTIMER) {
+			KillTimer(hwnd, ID_WATCHTIMER);
+			if (DirList_ApplyChanges(hwndDirList)) {
+				if (ListView_GetSelectedCount(hwndDirList) == 0) {
+					WCHAR tch[256];
+					WCHAR tchnum[64];
+					FormatNumber(tchnum, ListView_GetItemCount(hwndDirList));
+					WCHAR fmt[64];
+					FormatString(tch, fmt, HasFilter() ? IDS_NUMFILES_FILTER : IDS_NUMFILES, tchnum);
+					StatusSetText(hwndStatus, ID_FILEINFO, tch);
+				}
+				break;
+			}
+
+			// too many changes, refill the list
+			DirListItem dli;
+			dli.mask = DLI_ALL;
+			dli.ntype = DLE_NONE;
+			DirList_GetItem(hwndDirList, -1, &dli);
+			SendWMCommand(hwnd, IDM_VIEW_UPDATE);
+			if (dli.ntype != DLE_NONE) {
+				DirList_SelectItem(hwndDirList, dli.szDisplayName, dli.szFileName);
+			}
+			break;
+		}
+
 		// Check Change Notification Handle
 		if (WAIT_OBJECT_0 == WaitForSingleObject(hChangeHandle, 0)) {
 			// Store information about currently selected item
@@ -775,6 +806,27 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 		}
 		break;
 
+	case APPM_DRIVEBOXCHANGED:
+		DriveBox_UpdateDrive(hwndDriveBox, static_cast<int>(wParam));
+		break;
+
+	case WM_DEVICECHANGE:
+		// Update drives of changed volumes
+		if (wParam == DBT_DEVICEARRIVAL || wParam == DBT_DEVICEREMOVECOMPLETE) {
+			const DEV_BROADCAST_HDR * const pdbh = AsPointer<const DEV_BROADCAST_HDR *>(lParam);
+			if (pdbh != nullptr && pdbh->dbch_devicetype == DBT_DEVTYP_VOLUME) {
+				const DEV_BROADCAST_VOLUME * const pdbv = reinterpret_cast<const DEV_BROADCAST_VOLUME *>(pdbh);
+				DriveBox_Refresh(hwndDriveBox, pdbv->dbcv_unitmask);
+				DriveBox_SelectDrive(hwndDriveBox, szCurDir);
+			}
+		}
+		return TRUE;
+
+	case APPM_DIRLISTCHANGED:
+		// restart timer to apply changes in batch
+		SetTimer(hwnd, ID_WATCHTIMER, WATCHTIMER_DELAY, nullptr);
+		break;
+
 	case APPM_CENTER_MESSAGE_BOX: {
 		HWND box = FindWindow(L"#32770", nullptr);
 		HWND parent = GetParent(box);
@@ -839,7 +891,7 @@ LRESULT MsgCreate(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 
 	// Window Initialization
 	// DriveBox
-	DriveBox_Init(hwndDriveBox);
+	DriveBox_Init(hwndDriveBox, hwnd, APPM_DRIVEBOXCHANGED);
 	ComboBox_SetExtendedUI(hwndDriveBox, TRUE);
 	// DirList
 	const LVCOLUMN lvc = { LVCF_FMT | LVCF_TEXT, LVCFMT_LEFT, 0, nullptr, -1, 0, 0, 0
@@ -850,6 +902,10 @@ LRESULT MsgCreate(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	ListView_SetExtendedListViewStyle(hwndDirList, LVS_EX_DOUBLEBUFFER | LVS_EX_LABELTIP);
 	ListView_InsertColumn(hwndDirList, 0, &lvc);
 	DirList_Init(hwndDirList);
+	if (iAutoRefreshRate) {
+		// changes are applied incrementally, timer is used when directory can't be watched
+		DirList_WatchChanges(hwndDirList, hwnd, APPM_DIRLISTCHANGED);
+	}
 	if (bTrackSelect) {
 		ListView_SetExtendedListViewStyleEx(hwndDirList,
 											LVS_EX_TRACKSELECT | LVS_EX_ONECLICKACTIVATE,
@@ -1366,6 +1422,10 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		GotoDlg(hwnd);
 		break;
 
+	case IDM_FILE_FINDFILE:
+		FindFileDlg(hwnd, (dwFillMask & DL_INCLHIDDEN) != 0);
+		break;
+
 	case IDM_FILE_NEW: {
 		WCHAR szNewFile[MAX_PATH];
 		WCHAR szFilter[128];
@@ -2124,9 +2184,8 @@ LRESULT MsgNotify(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 			DirList_GetDispInfo(hwndDirList, lParam);
 			break;
 
-		case LVN_DELETEITEM:
-			DirList_DeleteItem(hwndDirList, lParam);
-			break;
+		case LVN_ODFINDITEM:
+			return DirList_FindItem(hwndDirList, lParam);
 
 		case LVN_BEGINDRAG:
 		case LVN_BEGINRDRAG:
@@ -2220,10 +2279,6 @@ LRESULT MsgNotify(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		case CBEN_GETDISPINFO:
 			DriveBox_GetDispInfo(hwndDriveBox, lParam);
 			break;
-
-		case CBEN_DELETEITEM:
-			DriveBox_DeleteItem(hwndDriveBox, lParam);
-			break;
 		}
 		break;
 
@@ -2351,7 +2406,7 @@ bool ChangeDirectory(HWND hwnd, LPCWSTR lpszNewDir, bool bUpdateHistory) {
 
 		// setup new change notification handle
 		FindCloseChangeNotification(hChangeHandle);
-		hChangeHandle = FindFirstChangeNotification(szCurDir, FALSE,
+		hChangeHandle = DirList_IsWatching(hwndDirList) ? nullptr : FindFirstChangeNotification(szCurDir, FALSE,
 						FILE_NOTIFY_CHANGE_FILE_NAME  | \
 						FILE_NOTIFY_CHANGE_DIR_NAME   | \
 						FILE_NOTIFY_CHANGE_ATTRIBUTES | \
@@ -2603,6 +2658,8 @@ void LoadSettings() noexcept {
 		lpFilterArg = nullptr;
 	}
 
+	section.GetString(L"FindFileExclude", DefaultFindFileExclude, tchFindFileExclude);
+
 	bDefColorNoFilter = section.GetBool(L"DefColorNoFilter", true);
 	bDefColorFilter = section.GetBool(L"DefColorFilter", true);
 
@@ -2648,6 +2705,8 @@ void LoadSettings() noexcept {
 		record.cxCopyMoveDlg = section.GetInt(L"CopyMoveDlgSizeX", 0);
 		record.cxTargetApplicationDlg = section.GetInt(L"TargetApplicationDlgSizeX", 0);
 		record.cxFindWindowDlg = section.GetInt(L"FindWindowDlgSizeX", 0);
+		record.cxFindFileDlg = section.GetInt(L"FindFileDlgSizeX", 0);
+		record.cyFindFileDlg = section.GetInt(L"FindFileDlgSizeY", 0);
 	}
 
 	section.Free();
@@ -2758,6 +2817,7 @@ void SaveSettings(bool bSaveSettingsNow) noexcept {
 	section.SetBoolEx(L"SortReverse", fSortRev, false);
 	section.SetStringEx(L"FileFilter", tchFilter, L"*.*");
 	section.SetBoolEx(L"NegativeFilter", bNegFilter, false);
+	section.SetStringEx(L"FindFileExclude", tchFindFileExclude, DefaultFindFileExclude);
 	section.SetBoolEx(L"DefColorNoFilter", bDefColorNoFilter, true);
 	section.SetBoolEx(L"DefColorFilter", bDefColorFilter, true);
 	section.SetIntEx(L"ColorNoFilter", colorNoFilter, GetSysColor(COLOR_WINDOWTEXT));
@@ -2809,6 +2869,8 @@ void SaveWindowPosition(WCHAR *pIniSectionBuf) noexcept {
 	section.SetIntEx(L"CopyMoveDlgSizeX", record.cxCopyMoveDlg, 0);
 	section.SetIntEx(L"TargetApplicationDlgSizeX", record.cxTargetApplicationDlg, 0);
 	section.SetIntEx(L"FindWindowDlgSizeX", record.cxFindWindowDlg, 0);
+	section.SetIntEx(L"FindFileDlgSizeX", record.cxFindFileDlg, 0);
+	section.SetIntEx(L"FindFileDlgSizeY", record.cyFindFileDlg, 0);
 
 	SaveIniSection(sectionName, pIniSectionBuf);
 }
@@ -45,6 +45,7 @@
 					WS_CLIPSIBLINGS | \
 					WS_CLIPCHILDREN | \
 					LVS_REPORT | \
+					LVS_OWNERDATA | \
 					LVS_NOCOLUMNHEADER | \
 					LVS_SHAREIMAGELISTS | \
 					LVS_AUTOARRANGE | \
@@ -81,12 +82,20 @@
 
 //==== Timer for Change Notifications =========================================
 #define ID_TIMER		0xA000
+#define ID_WATCHTIMER	0xA001
+// coalesce changes reported by DirList_WatchChanges()
+#define WATCHTIMER_DELAY	150
+#define ID_FINDFILETIMER	0xA002
+// results of FindFileDlg() are shown periodically
+#define FINDFILETIMER_DELAY	200
 
 /**
  * App message used to center MessageBox to the window of the program.
  */
 #define APPM_CENTER_MESSAGE_BOX		(WM_APP + 1)
 #define APPM_TRAYMESSAGE			(WM_APP + 4) // Callback Message from System Tray
+#define APPM_DIRLISTCHANGED			(WM_APP + 5) // Queued changes of current directory
+#define APPM_DRIVEBOXCHANGED		(WM_APP + 6) // Drive in wParam is resolved
 
 enum EscFunction {
 	EscFunction_None = 0,
@@ -139,6 +148,8 @@ struct WindowPositionRecord {
 	int	cxCopyMoveDlg;
 	int	cxTargetApplicationDlg;
 	int	cxFindWindowDlg;
+	int	cxFindFileDlg;
+	int	cyFindFileDlg;
 };
 
 extern WindowPositionRecord positionRecord;
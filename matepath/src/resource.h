@@ -151,6 +151,12 @@
 #define IDC_WINMODULE					102
 #define IDC_CROSSCURSOR					103
 #define IDC_FINDWINDESC					104
+// Find Files
+#define IDD_FINDFILE					114
+#define IDC_FINDFILE_NAME				100
+#define IDC_FINDFILE_EXCLUDE			101
+#define IDC_FINDFILE_RESULT				102
+#define IDC_FINDFILE_STATUS				103
 
 #define IDS_APPTITLE					10000
 #define IDS_NUMFILES					10001
@@ -169,6 +175,9 @@
 #define IDS_CREATELINK					11010
 #define IDS_SAVESETTINGS				11011
 #define IDS_LINKDESCRIPTION				11012
+#define IDS_FINDFILE_STATUS				11013
+#define IDS_FINDFILE_FIND				11014
+#define IDS_FINDFILE_STOP				11015
 
 #define IDM_FILE_OPENSAME				40001
 #define IDM_FILE_OPENNEW				40002
@@ -191,6 +200,7 @@
 #define IDM_FILE_DRIVEPROP				40019
 #define IDM_FILE_EXPLORER				40020
 #define IDM_FILE_RESTART				40021
+#define IDM_FILE_FINDFILE				40022
 
 #define IDM_VIEW_NEWWINDOW				40201
 #define IDM_VIEW_FOLDERS				40202
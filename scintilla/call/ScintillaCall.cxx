@@ -430,6 +430,10 @@ void ScintillaCall::MarkerAddSet(Line line, int markerSet) {
 	Call(Message::MarkerAddSet, line, markerSet);
 }
 
+Line ScintillaCall::MarkerAddLines(int markerNumber, void *lines) {
+	return CallPointer(Message::MarkerAddLines, markerNumber, lines);
+}
+
 Layer ScintillaCall::MarkerGetLayer(int markerNumber) {
 	return static_cast<Scintilla::Layer>(Call(Message::MarkerGetLayer, markerNumber));
 }
@@ -634,6 +638,18 @@ void ScintillaCall::StyleSetHotSpot(int style, bool hotspot) {
 	Call(Message::StyleSetHotSpot, style, hotspot);
 }
 
+void ScintillaCall::StyleSetBulk(int count, StyleRecord *records) {
+	CallPointer(Message::StyleSetBulk, count, records);
+}
+
+void ScintillaCall::BeginStyleUpdate() {
+	Call(Message::BeginStyleUpdate);
+}
+
+void ScintillaCall::EndStyleUpdate() {
+	Call(Message::EndStyleUpdate);
+}
+
 void ScintillaCall::StyleSetStretch(int style, Scintilla::FontStretch stretch) {
 	Call(Message::StyleSetStretch, style, static_cast<intptr_t>(stretch));
 }
@@ -774,6 +790,10 @@ void ScintillaCall::EndUndoAction() {
 	Call(Message::EndUndoAction);
 }
 
+intptr_t ScintillaCall::SendCommands(Position count, CommandRecord *commands) {
+	return CallPointer(Message::SendCommands, count, commands);
+}
+
 int ScintillaCall::UndoSequence() {
 	return static_cast<int>(Call(Message::GetUndoSequence));
 }
@@ -838,6 +858,22 @@ std::string ScintillaCall::UndoActionText(int action) {
 	return CallReturnString(Message::GetUndoActionText, action);
 }
 
+void ScintillaCall::SetUndoMemoryLimit(Position limit) {
+	Call(Message::SetUndoMemoryLimit, limit);
+}
+
+Position ScintillaCall::UndoMemoryLimit() {
+	return Call(Message::GetUndoMemoryLimit);
+}
+
+Position ScintillaCall::UndoMemory() {
+	return Call(Message::GetUndoMemory);
+}
+
+Position ScintillaCall::MemoryUsage(Scintilla::MemoryCategory category) {
+	return Call(Message::GetMemoryUsage, static_cast<uintptr_t>(category));
+}
+
 void ScintillaCall::IndicSetStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle) {
 	Call(Message::IndicSetStyle, indicator, static_cast<intptr_t>(indicatorStyle));
 }
@@ -862,6 +898,14 @@ bool ScintillaCall::IndicGetUnder(int indicator) {
 	return Call(Message::IndicGetUnder, indicator);
 }
 
+void ScintillaCall::IndicSetOverviewRuler(int indicator, bool show) {
+	Call(Message::IndicSetOverviewRuler, indicator, show);
+}
+
+bool ScintillaCall::IndicGetOverviewRuler(int indicator) {
+	return Call(Message::IndicGetOverviewRuler, indicator);
+}
+
 void ScintillaCall::IndicSetHoverStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle) {
 	Call(Message::IndicSetHoverStyle, indicator, static_cast<intptr_t>(indicatorStyle));
 }
@@ -1106,6 +1150,10 @@ void ScintillaCall::CountCharactersAndColumns(TextToFindFull *ft) {
 	CallPointer(Message::CountCharactersAndColumns, 0, ft);
 }
 
+void ScintillaCall::CountTextStatistics(TextStatistics *statistics) {
+	CallPointer(Message::CountTextStatistics, 0, statistics);
+}
+
 Position ScintillaCall::CountCodeUnits(Position start, Position end) {
 	return Call(Message::CountCodeUnits, start, end);
 }
@@ -1190,6 +1238,22 @@ Position ScintillaCall::FindTextFull(Scintilla::FindOption searchFlags, TextToFi
 	return CallPointer(Message::FindTextFull, static_cast<uintptr_t>(searchFlags), ft);
 }
 
+Position ScintillaCall::FindAll(Scintilla::FindOption searchFlags, TextToFindFull *ft) {
+	return CallPointer(Message::FindAll, static_cast<uintptr_t>(searchFlags), ft);
+}
+
+void *ScintillaCall::FindAllRanges() {
+	return AsPointer<void *>(Call(Message::GetFindAllRanges));
+}
+
+void ScintillaCall::SetSearchIndexThreshold(Position threshold) {
+	Call(Message::SetSearchIndexThreshold, threshold);
+}
+
+Position ScintillaCall::SearchIndexThreshold() {
+	return Call(Message::GetSearchIndexThreshold);
+}
+
 Position ScintillaCall::FormatRangeFull(bool draw, const RangeToFormatFull *fr) {
 	return CallConstPointer(Message::FormatRangeFull, draw, fr);
 }
@@ -1202,6 +1266,10 @@ ChangeHistoryOption ScintillaCall::ChangeHistory() {
 	return static_cast<Scintilla::ChangeHistoryOption>(Call(Message::GetChangeHistory));
 }
 
+Line ScintillaCall::ChangeHistoryLineNext(Line lineStart, int markerMask) {
+	return Call(Message::ChangeHistoryLineNext, lineStart, markerMask);
+}
+
 void ScintillaCall::SetUndoSelectionHistory(Scintilla::UndoSelectionHistoryOption undoSelectionHistory) {
 	Call(Message::SetUndoSelectionHistory, static_cast<uintptr_t>(undoSelectionHistory));
 }
@@ -1246,6 +1314,22 @@ int ScintillaCall::MarginRight() {
 	return static_cast<int>(Call(Message::GetMarginRight));
 }
 
+void ScintillaCall::SetOverviewRulerWidth(int pixelWidth) {
+	Call(Message::SetOverviewRulerWidth, pixelWidth);
+}
+
+int ScintillaCall::OverviewRulerWidth() {
+	return static_cast<int>(Call(Message::GetOverviewRulerWidth));
+}
+
+void ScintillaCall::SetOverviewRulerMarkers(int markerMask) {
+	Call(Message::SetOverviewRulerMarkers, markerMask);
+}
+
+int ScintillaCall::OverviewRulerMarkers() {
+	return static_cast<int>(Call(Message::GetOverviewRulerMarkers));
+}
+
 bool ScintillaCall::Modify() {
 	return Call(Message::GetModify);
 }
@@ -1462,6 +1546,10 @@ Position ScintillaCall::SearchInTarget(Position length, const char *text) {
 	return CallString(Message::SearchInTarget, length, text);
 }
 
+Position ScintillaCall::ReplaceAllInTarget(const char *find, const char *replace) {
+	return CallString(Message::ReplaceAllInTarget, AsInteger<uintptr_t>(find), replace);
+}
+
 void ScintillaCall::SetSearchFlags(Scintilla::FindOption searchFlags) {
 	Call(Message::SetSearchFlags, static_cast<uintptr_t>(searchFlags));
 }
@@ -1554,6 +1642,10 @@ void ScintillaCall::HideLines(Line lineStart, Line lineEnd) {
 	Call(Message::HideLines, lineStart, lineEnd);
 }
 
+Line ScintillaCall::HideLinesExceptFindAll(Line lineStart, Line contextLines) {
+	return Call(Message::HideLinesExceptFindAll, lineStart, contextLines);
+}
+
 bool ScintillaCall::LineVisible(Line line) {
 	return Call(Message::GetLineVisible, line);
 }
@@ -1614,6 +1706,10 @@ void ScintillaCall::FoldAll(Scintilla::FoldAction action) {
 	Call(Message::FoldAll, static_cast<uintptr_t>(action));
 }
 
+void ScintillaCall::FoldAllLevel(int level, Scintilla::FoldAction action) {
+	Call(Message::FoldAllLevel, level, static_cast<intptr_t>(action));
+}
+
 void ScintillaCall::EnsureVisible(Line line) {
 	Call(Message::EnsureVisible, line);
 }
@@ -1678,6 +1774,14 @@ IdleStyling ScintillaCall::IdleStyling() {
 	return static_cast<Scintilla::IdleStyling>(Call(Message::GetIdleStyling));
 }
 
+void ScintillaCall::SetBackgroundStyling(bool backgroundStyling) {
+	Call(Message::SetBackgroundStyling, backgroundStyling);
+}
+
+bool ScintillaCall::BackgroundStyling() {
+	return Call(Message::GetBackgroundStyling);
+}
+
 void ScintillaCall::SetWrapMode(Scintilla::Wrap wrapMode) {
 	Call(Message::SetWrapMode, static_cast<uintptr_t>(wrapMode));
 }
@@ -1726,6 +1830,34 @@ LineCache ScintillaCall::LayoutCache() {
 	return static_cast<Scintilla::LineCache>(Call(Message::GetLayoutCache));
 }
 
+void ScintillaCall::SetLayoutCacheLimit(Position bytes) {
+	Call(Message::SetLayoutCacheLimit, bytes);
+}
+
+Position ScintillaCall::LayoutCacheLimit() {
+	return Call(Message::GetLayoutCacheLimit);
+}
+
+void ScintillaCall::SetLayoutThreads(int threads) {
+	Call(Message::SetLayoutThreads, threads);
+}
+
+int ScintillaCall::LayoutThreads() {
+	return static_cast<int>(Call(Message::GetLayoutThreads));
+}
+
+void ScintillaCall::SetBackgroundWorkThrottled(bool throttled) {
+	Call(Message::SetBackgroundWorkThrottled, throttled);
+}
+
+bool ScintillaCall::BackgroundWorkThrottled() {
+	return Call(Message::GetBackgroundWorkThrottled);
+}
+
+void ScintillaCall::GetPaintStatistics(bool reset, PaintStatistics *statistics) {
+	CallPointer(Message::GetPaintStatistics, reset, statistics);
+}
+
 void ScintillaCall::SetScrollWidth(int pixelWidth) {
 	Call(Message::SetScrollWidth, pixelWidth);
 }
@@ -1814,6 +1946,10 @@ void ScintillaCall::LinesSplit(int pixelWidth) {
 	Call(Message::LinesSplit, pixelWidth);
 }
 
+Position ScintillaCall::LinesPad(Scintilla::LinesPadFlag flags) {
+	return Call(Message::LinesPad, static_cast<uintptr_t>(flags));
+}
+
 void ScintillaCall::SetFoldMarginColour(bool useSetting, Colour back) {
 	Call(Message::SetFoldMarginColour, useSetting, back);
 }
@@ -2214,6 +2350,10 @@ DocumentOption ScintillaCall::DocumentOptions() {
 	return static_cast<Scintilla::DocumentOption>(Call(Message::GetDocumentOptions));
 }
 
+void ScintillaCall::ConvertToLargeDocument() {
+	Call(Message::ConvertToLargeDocument);
+}
+
 ModificationFlags ScintillaCall::ModEventMask() {
 	return static_cast<Scintilla::ModificationFlags>(Call(Message::GetModEventMask));
 }
@@ -2634,6 +2774,10 @@ void ScintillaCall::IndicatorFillRange(Position start, Position lengthFill) {
 	Call(Message::IndicatorFillRange, start, lengthFill);
 }
 
+void ScintillaCall::IndicatorFillRanges(Position count, void *ranges) {
+	CallPointer(Message::IndicatorFillRanges, count, ranges);
+}
+
 void ScintillaCall::IndicatorClearRange(Position start, Position lengthClear) {
 	Call(Message::IndicatorClearRange, start, lengthClear);
 }
@@ -2662,6 +2806,10 @@ int ScintillaCall::PositionCache() {
 	return static_cast<int>(Call(Message::GetPositionCache));
 }
 
+void ScintillaCall::ReleaseResources() {
+	Call(Message::ReleaseResources);
+}
+
 void ScintillaCall::CopyAllowLine() {
 	Call(Message::CopyAllowLine);
 }
@@ -2694,6 +2842,10 @@ Position ScintillaCall::GapPosition() {
 	return Call(Message::GetGapPosition);
 }
 
+Position ScintillaCall::GetRangeSegments(TextSegments *segments) {
+	return CallPointer(Message::GetRangeSegments, 0, segments);
+}
+
 void ScintillaCall::IndicSetAlpha(int indicator, Scintilla::Alpha alpha) {
 	Call(Message::IndicSetAlpha, indicator, static_cast<intptr_t>(alpha));
 }
@@ -2818,6 +2970,10 @@ int ScintillaCall::AnnotationGetLines(Line line) {
 	return static_cast<int>(Call(Message::AnnotationGetLines, line));
 }
 
+void ScintillaCall::AnnotationSetBulk(Position count, const AnnotationRecord *records) {
+	CallConstPointer(Message::AnnotationSetBulk, count, records);
+}
+
 void ScintillaCall::AnnotationClearAll() {
 	Call(Message::AnnotationClearAll);
 }
@@ -3218,6 +3374,10 @@ int ScintillaCall::EOLAnnotationGetStyle(Line line) {
 	return static_cast<int>(Call(Message::EOLAnnotationGetStyle, line));
 }
 
+void ScintillaCall::EOLAnnotationSetBulk(Position count, const AnnotationRecord *records) {
+	CallConstPointer(Message::EOLAnnotationSetBulk, count, records);
+}
+
 void ScintillaCall::EOLAnnotationClearAll() {
 	Call(Message::EOLAnnotationClearAll);
 }
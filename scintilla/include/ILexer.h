@@ -44,6 +44,11 @@ public:
 	virtual Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept = 0;
 	virtual int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept = 0;
 	virtual CharacterClass SCI_METHOD GetCharacterClass(unsigned int character) const noexcept = 0;
+	// return pointer indexed by document position for the contiguous text [*pStart, *pEnd) containing position,
+	// or nullptr when the text is not directly readable.
+	virtual const char * SCI_METHOD GetTextSegment(Sci_Position position, Sci_Position *pStart, Sci_Position *pEnd) const noexcept = 0;
+	// set fold level for count lines starting at lineStart.
+	virtual void SCI_METHOD SetLevels(Sci_Line lineStart, Sci_Line count, const int *levels) = 0;
 };
 
 enum {
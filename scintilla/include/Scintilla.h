@@ -16,6 +16,7 @@ void Scintilla_LoadDpiForWindow(void);
 /* Return false on failure: */
 int Scintilla_RegisterClasses(void *hInstance);
 int Scintilla_ReleaseResources(void);
+void Scintilla_PreloadDirectWrite(void);
 #endif
 
 }
@@ -178,6 +179,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_MARKERPREVIOUS 2048
 #define SCI_MARKERDEFINEPIXMAP 2049
 #define SCI_MARKERADDSET 2466
+#define SCI_MARKERADDLINES 2832
 #define SCI_MARKERGETLAYER 2734
 #define SCI_MARKERSETLAYER 2735
 #define SC_MAX_MARGIN 4
@@ -278,6 +280,20 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_STYLEGETWEIGHT 2064
 #define SCI_STYLESETCHARACTERSET 2066
 #define SCI_STYLESETHOTSPOT 2409
+#define SC_STYLERECORD_FORE 0x001
+#define SC_STYLERECORD_BACK 0x002
+#define SC_STYLERECORD_SIZE 0x004
+#define SC_STYLERECORD_WEIGHT 0x008
+#define SC_STYLERECORD_FONT 0x010
+#define SC_STYLERECORD_CHARACTERSET 0x020
+#define SC_STYLERECORD_ITALIC 0x040
+#define SC_STYLERECORD_UNDERLINE 0x080
+#define SC_STYLERECORD_STRIKE 0x100
+#define SC_STYLERECORD_OVERLINE 0x200
+#define SC_STYLERECORD_EOLFILLED 0x400
+#define SCI_STYLESETBULK 2841
+#define SCI_BEGINSTYLEUPDATE 2842
+#define SCI_ENDSTYLEUPDATE 2843
 #define SC_STRETCH_ULTRA_CONDENSED 1
 #define SC_STRETCH_EXTRA_CONDENSED 2
 #define SC_STRETCH_CONDENSED 3
@@ -347,6 +363,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETCHARACTERCATEGORYOPTIMIZATION 2721
 #define SCI_BEGINUNDOACTION 2078
 #define SCI_ENDUNDOACTION 2079
+#define SCI_SENDCOMMANDS 2846
 #define SCI_GETUNDOSEQUENCE 2799
 #define SCI_GETUNDOACTIONS 2790
 #define SCI_SETUNDOSAVEPOINT 2791
@@ -362,6 +379,21 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETUNDOACTIONTYPE 2802
 #define SCI_GETUNDOACTIONPOSITION 2803
 #define SCI_GETUNDOACTIONTEXT 2804
+#define SCI_SETUNDOMEMORYLIMIT 2820
+#define SCI_GETUNDOMEMORYLIMIT 2821
+#define SCI_GETUNDOMEMORY 2822
+#define SC_MEMORY_TOTAL 0
+#define SC_MEMORY_TEXT 1
+#define SC_MEMORY_STYLES 2
+#define SC_MEMORY_LINES 3
+#define SC_MEMORY_UNDO_HISTORY 4
+#define SC_MEMORY_CHANGE_HISTORY 5
+#define SC_MEMORY_DECORATIONS 6
+#define SC_MEMORY_PER_LINE 7
+#define SC_MEMORY_LINE_LAYOUT_CACHE 8
+#define SC_MEMORY_POSITION_CACHE 9
+#define SC_MEMORY_SEARCH_INDEX 10
+#define SCI_GETMEMORYUSAGE 2825
 #define INDIC_PLAIN 0
 #define INDIC_SQUIGGLE 1
 #define INDIC_TT 2
@@ -404,6 +436,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_INDICGETFORE 2083
 #define SCI_INDICSETUNDER 2510
 #define SCI_INDICGETUNDER 2511
+#define SCI_INDICSETOVERVIEWRULER 2856
+#define SCI_INDICGETOVERVIEWRULER 2857
 #define SCI_INDICSETHOVERSTYLE 2680
 #define SCI_INDICGETHOVERSTYLE 2681
 #define SCI_INDICSETHOVERFORE 2682
@@ -445,6 +479,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_AUTOCOMPLETE_NORMAL 0
 #define SC_AUTOCOMPLETE_FIXED_SIZE 1
 #define SC_AUTOCOMPLETE_SELECT_FIRST_ITEM 2
+#define SC_AUTOCOMPLETE_FILTER_LIST 4
 #define SCI_AUTOCSETOPTIONS 2638
 #define SCI_AUTOCGETOPTIONS 2639
 #define SCI_AUTOCSETDROPRESTOFWORD 2270
@@ -472,6 +507,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETCOLUMN 2129
 #define SCI_COUNTCHARACTERS 2633
 #define SCI_COUNTCHARACTERSANDCOLUMNS 2522
+#define SCI_COUNTTEXTSTATISTICS 2845
 #define SCI_COUNTCODEUNITS 2715
 #define SCI_SETHSCROLLBAR 2130
 #define SCI_GETHSCROLLBAR 2131
@@ -512,6 +548,10 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCFIND_CXX11REGEX 0x80
 #define SCFIND_REGEX_DOT_ALL 0x100
 #define SCI_FINDTEXTFULL 2196
+#define SCI_FINDALL 2826
+#define SCI_GETFINDALLRANGES 2827
+#define SCI_SETSEARCHINDEXTHRESHOLD 2828
+#define SCI_GETSEARCHINDEXTHRESHOLD 2829
 #define SCI_FORMATRANGEFULL 2777
 #define SC_CHANGE_HISTORY_DISABLED 0
 #define SC_CHANGE_HISTORY_ENABLED 1
@@ -519,6 +559,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_CHANGE_HISTORY_INDICATORS 4
 #define SCI_SETCHANGEHISTORY 2780
 #define SCI_GETCHANGEHISTORY 2781
+#define SCI_CHANGEHISTORYLINENEXT 2851
 #define SC_UNDO_SELECTION_HISTORY_DISABLED 0
 #define SC_UNDO_SELECTION_HISTORY_ENABLED 1
 #define SC_UNDO_SELECTION_HISTORY_SCROLL 2
@@ -532,6 +573,10 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETMARGINLEFT 2156
 #define SCI_SETMARGINRIGHT 2157
 #define SCI_GETMARGINRIGHT 2158
+#define SCI_SETOVERVIEWRULERWIDTH 2852
+#define SCI_GETOVERVIEWRULERWIDTH 2853
+#define SCI_SETOVERVIEWRULERMARKERS 2854
+#define SCI_GETOVERVIEWRULERMARKERS 2855
 #define SCI_GETMODIFY 2159
 #define SCI_SETSEL 2160
 #define SCI_GETSELTEXT 2161
@@ -583,6 +628,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_REPLACETARGETRE 2195
 #define SCI_REPLACETARGETMINIMAL 2779
 #define SCI_SEARCHINTARGET 2197
+#define SCI_REPLACEALLINTARGET 2830
 #define SCI_SETSEARCHFLAGS 2198
 #define SCI_GETSEARCHFLAGS 2199
 #define SCI_CALLTIPSHOW 2200
@@ -615,6 +661,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETFOLDPARENT 2225
 #define SCI_SHOWLINES 2226
 #define SCI_HIDELINES 2227
+#define SCI_HIDELINESEXCEPTFINDALL 2850
 #define SCI_GETLINEVISIBLE 2228
 #define SCI_GETALLLINESVISIBLE 2236
 #define SCI_SETFOLDEXPANDED 2229
@@ -632,10 +679,12 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_FOLDACTION_EXPAND 1
 #define SC_FOLDACTION_TOGGLE 2
 #define SC_FOLDACTION_CONTRACT_EVERY_LEVEL 4
+#define SC_FOLDACTION_NESTED_LEVEL 8
 #define SCI_FOLDLINE 2237
 #define SCI_FOLDCHILDREN 2238
 #define SCI_EXPANDCHILDREN 2239
 #define SCI_FOLDALL 2662
+#define SCI_FOLDALLLEVEL 2835
 #define SCI_ENSUREVISIBLE 2232
 #define SC_AUTOMATICFOLD_NONE 0x0000
 #define SC_AUTOMATICFOLD_SHOW 0x0001
@@ -668,6 +717,8 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_IDLESTYLING_ALL 3
 #define SCI_SETIDLESTYLING 2692
 #define SCI_GETIDLESTYLING 2693
+#define SCI_SETBACKGROUNDSTYLING 2833
+#define SCI_GETBACKGROUNDSTYLING 2834
 #define SC_WRAP_NONE 0
 #define SC_WRAP_WORD 1
 #define SC_WRAP_CHAR 2
@@ -700,6 +751,13 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SC_CACHE_DOCUMENT 3
 #define SCI_SETLAYOUTCACHE 2272
 #define SCI_GETLAYOUTCACHE 2273
+#define SCI_SETLAYOUTCACHELIMIT 2836
+#define SCI_GETLAYOUTCACHELIMIT 2837
+#define SCI_SETLAYOUTTHREADS 2838
+#define SCI_GETLAYOUTTHREADS 2839
+#define SCI_SETBACKGROUNDWORKTHROTTLED 2848
+#define SCI_GETBACKGROUNDWORKTHROTTLED 2849
+#define SCI_GETPAINTSTATISTICS 2840
 #define SCI_SETSCROLLWIDTH 2274
 #define SCI_GETSCROLLWIDTH 2275
 #define SCI_SETSCROLLWIDTHTRACKING 2516
@@ -731,6 +789,10 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETTAG 2616
 #define SCI_LINESJOIN 2288
 #define SCI_LINESSPLIT 2289
+#define SC_LINESPAD_NONE 0
+#define SC_LINESPAD_SKIPEMPTY 1
+#define SC_LINESPAD_RECTANGULAR 2
+#define SCI_LINESPAD 2844
 #define SCI_SETFOLDMARGINCOLOUR 2290
 #define SCI_SETFOLDMARGINHICOLOUR 2291
 #define SC_ACCESSIBILITY_DISABLED 0
@@ -843,11 +905,14 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETZOOM 2374
 #define SC_DOCUMENTOPTION_DEFAULT 0
 #define SC_DOCUMENTOPTION_STYLES_NONE 0x1
+#define SC_DOCUMENTOPTION_STYLES_COMPRESSED 0x2
 #define SC_DOCUMENTOPTION_TEXT_LARGE 0x100
+#define SC_DOCUMENTOPTION_TEXT_PIECES 0x200
 #define SCI_CREATEDOCUMENT 2375
 #define SCI_ADDREFDOCUMENT 2376
 #define SCI_RELEASEDOCUMENT 2377
 #define SCI_GETDOCUMENTOPTIONS 2379
+#define SCI_CONVERTTOLARGEDOCUMENT 2824
 #define SCI_GETMODEVENTMASK 2378
 #define SCI_SETCOMMANDEVENTS 2717
 #define SCI_GETCOMMANDEVENTS 2718
@@ -982,6 +1047,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_SETINDICATORVALUE 2502
 #define SCI_GETINDICATORVALUE 2503
 #define SCI_INDICATORFILLRANGE 2504
+#define SCI_INDICATORFILLRANGES 2831
 #define SCI_INDICATORCLEARRANGE 2505
 #define SCI_INDICATORALLONFOR 2506
 #define SCI_INDICATORVALUEAT 2507
@@ -989,6 +1055,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_INDICATOREND 2509
 #define SCI_SETPOSITIONCACHE 2514
 #define SCI_GETPOSITIONCACHE 2515
+#define SCI_RELEASERESOURCES 2847
 #define SCI_COPYALLOWLINE 2519
 #define SCI_CUTALLOWLINE 2810
 #define SCI_SETCOPYSEPARATOR 2811
@@ -996,6 +1063,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_GETCHARACTERPOINTER 2520
 #define SCI_GETRANGEPOINTER 2643
 #define SCI_GETGAPPOSITION 2644
+#define SCI_GETRANGESEGMENTS 2823
 #define SCI_INDICSETALPHA 2523
 #define SCI_INDICGETALPHA 2524
 #define SCI_INDICSETOUTLINEALPHA 2558
@@ -1025,6 +1093,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_ANNOTATIONSETSTYLES 2544
 #define SCI_ANNOTATIONGETSTYLES 2545
 #define SCI_ANNOTATIONGETLINES 2546
+#define SCI_ANNOTATIONSETBULK 2858
 #define SCI_ANNOTATIONCLEARALL 2547
 #define ANNOTATION_HIDDEN 0
 #define ANNOTATION_STANDARD 1
@@ -1143,6 +1212,7 @@ typedef sptr_t (*SciFnDirectStatus)(sptr_t ptr, unsigned int iMessage, uptr_t wP
 #define SCI_EOLANNOTATIONGETTEXT 2741
 #define SCI_EOLANNOTATIONSETSTYLE 2742
 #define SCI_EOLANNOTATIONGETSTYLE 2743
+#define SCI_EOLANNOTATIONSETBULK 2859
 #define SCI_EOLANNOTATIONCLEARALL 2744
 #define EOLANNOTATION_HIDDEN 0x0
 #define EOLANNOTATION_STANDARD 0x1
@@ -1338,6 +1408,63 @@ struct Sci_TextRangeFull {
 	char *lpstrText;
 };
 
+struct Sci_TextSegments {
+	struct Sci_CharacterRangeFull chrg;
+	const char *segment1;
+	Sci_Position length1;
+	const char *segment2;
+	Sci_Position length2;
+};
+
+struct Sci_TextStatistics {
+	struct Sci_CharacterRangeFull chrg;
+	Sci_Position characters;
+	Sci_Position utf16Units;
+	Sci_Position words;
+	Sci_Position lines;
+	Sci_Position emptyLines;
+	Sci_Position longestLine;
+	Sci_Position invalidBytes;
+};
+
+struct Sci_PaintStatistics {
+	int frames;
+	int paintTime;
+	int layoutTime;
+	int linesLaidOut;
+	int positionCacheHits;
+	int positionCacheMisses;
+	int styleBytesPerMillisecond;
+	int wrapBytesPerMillisecond;
+	int idlePending;
+	int lineLayoutHits;
+	int lineLayoutMisses;
+};
+
+struct Sci_StyleRecord {
+	int style;
+	int mask;
+	int fore;
+	int back;
+	int sizeFractional;
+	int weight;
+	int characterSet;
+	int attributes;
+	const char *fontName;
+};
+
+struct Sci_CommandRecord {
+	unsigned int message;
+	uptr_t wParam;
+	sptr_t lParam;
+};
+
+struct Sci_AnnotationRecord {
+	Sci_Position line;
+	int style;
+	const char *text;
+};
+
 struct Sci_TextToFindFull {
 	struct Sci_CharacterRangeFull chrg;
 	const char *lpstrText;
@@ -15,6 +15,12 @@ enum class Message;	// Declare in case ScintillaMessages.h not included
 
 // Declare in case ScintillaStructures.h not included
 struct TextRangeFull;
+struct TextSegments;
+struct TextStatistics;
+struct PaintStatistics;
+struct StyleRecord;
+struct CommandRecord;
+struct AnnotationRecord;
 struct TextToFindFull;
 struct RangeToFormatFull;
 
@@ -154,6 +160,7 @@ public:
 	Line MarkerPrevious(Line lineStart, int markerMask);
 	void MarkerDefinePixmap(int markerNumber, const char *pixmap);
 	void MarkerAddSet(Line line, int markerSet);
+	Line MarkerAddLines(int markerNumber, void *lines);
 	Scintilla::Layer MarkerGetLayer(int markerNumber);
 	void MarkerSetLayer(int markerNumber, Scintilla::Layer layer);
 	void SetMarginTypeN(int margin, Scintilla::MarginType marginType);
@@ -205,6 +212,9 @@ public:
 	Scintilla::FontWeight StyleGetWeight(int style);
 	void StyleSetCharacterSet(int style, Scintilla::CharacterSet characterSet);
 	void StyleSetHotSpot(int style, bool hotspot);
+	void StyleSetBulk(int count, StyleRecord *records);
+	void BeginStyleUpdate();
+	void EndStyleUpdate();
 	void StyleSetStretch(int style, Scintilla::FontStretch stretch);
 	Scintilla::FontStretch StyleGetStretch(int style);
 	void StyleSetInvisibleRepresentation(int style, const char *representation);
@@ -240,6 +250,7 @@ public:
 	int CharacterCategoryOptimization();
 	void BeginUndoAction();
 	void EndUndoAction();
+	intptr_t SendCommands(Position count, CommandRecord *commands);
 	int UndoSequence();
 	int UndoActions();
 	void SetUndoSavePoint(int action);
@@ -256,12 +267,18 @@ public:
 	Position UndoActionPosition(int action);
 	int UndoActionText(int action, char *text);
 	std::string UndoActionText(int action);
+	void SetUndoMemoryLimit(Position limit);
+	Position UndoMemoryLimit();
+	Position UndoMemory();
+	Position MemoryUsage(Scintilla::MemoryCategory category);
 	void IndicSetStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle);
 	Scintilla::IndicatorStyle IndicGetStyle(int indicator);
 	void IndicSetFore(int indicator, Colour fore);
 	Colour IndicGetFore(int indicator);
 	void IndicSetUnder(int indicator, bool under);
 	bool IndicGetUnder(int indicator);
+	void IndicSetOverviewRuler(int indicator, bool show);
+	bool IndicGetOverviewRuler(int indicator);
 	void IndicSetHoverStyle(int indicator, Scintilla::IndicatorStyle indicatorStyle);
 	Scintilla::IndicatorStyle IndicGetHoverStyle(int indicator);
 	void IndicSetHoverFore(int indicator, Colour fore);
@@ -323,6 +340,7 @@ public:
 	Position Column(Position pos);
 	Position CountCharacters(Position start, Position end);
 	void CountCharactersAndColumns(TextToFindFull *ft);
+	void CountTextStatistics(TextStatistics *statistics);
 	Position CountCodeUnits(Position start, Position end);
 	void SetHScrollBar(bool visible);
 	bool HScrollBar();
@@ -344,9 +362,14 @@ public:
 	void SetPrintColourMode(Scintilla::PrintOption mode);
 	Scintilla::PrintOption PrintColourMode();
 	Position FindTextFull(Scintilla::FindOption searchFlags, TextToFindFull *ft);
+	Position FindAll(Scintilla::FindOption searchFlags, TextToFindFull *ft);
+	void *FindAllRanges();
+	void SetSearchIndexThreshold(Position threshold);
+	Position SearchIndexThreshold();
 	Position FormatRangeFull(bool draw, const RangeToFormatFull *fr);
 	void SetChangeHistory(Scintilla::ChangeHistoryOption changeHistory);
 	Scintilla::ChangeHistoryOption ChangeHistory();
+	Line ChangeHistoryLineNext(Line lineStart, int markerMask);
 	void SetUndoSelectionHistory(Scintilla::UndoSelectionHistoryOption undoSelectionHistory);
 	Scintilla::UndoSelectionHistoryOption UndoSelectionHistory();
 	Line FirstVisibleLine();
@@ -358,6 +381,10 @@ public:
 	int MarginLeft();
 	void SetMarginRight(int pixelWidth);
 	int MarginRight();
+	void SetOverviewRulerWidth(int pixelWidth);
+	int OverviewRulerWidth();
+	void SetOverviewRulerMarkers(int markerMask);
+	int OverviewRulerMarkers();
 	bool Modify();
 	void SetSel(Position anchor, Position caret);
 	Position GetSelText(bool asBinary, char *text);
@@ -412,6 +439,7 @@ public:
 	Position ReplaceTargetRE(Position length, const char *text);
 	Position ReplaceTargetMinimal(Position length, const char *text);
 	Position SearchInTarget(Position length, const char *text);
+	Position ReplaceAllInTarget(const char *find, const char *replace);
 	void SetSearchFlags(Scintilla::FindOption searchFlags);
 	Scintilla::FindOption SearchFlags();
 	void CallTipShow(Position pos, const char *definition);
@@ -435,6 +463,7 @@ public:
 	Line FoldParent(Line line);
 	void ShowLines(Line lineStart, Line lineEnd);
 	void HideLines(Line lineStart, Line lineEnd);
+	Line HideLinesExceptFindAll(Line lineStart, Line contextLines);
 	bool LineVisible(Line line);
 	bool AllLinesVisible();
 	void SetFoldExpanded(Line line, bool expanded);
@@ -450,6 +479,7 @@ public:
 	void FoldChildren(Line line, Scintilla::FoldAction action);
 	void ExpandChildren(Line line, Scintilla::FoldLevel level);
 	void FoldAll(Scintilla::FoldAction action);
+	void FoldAllLevel(int level, Scintilla::FoldAction action);
 	void EnsureVisible(Line line);
 	void SetAutomaticFold(Scintilla::AutomaticFold automaticFold);
 	Scintilla::AutomaticFold AutomaticFold();
@@ -466,6 +496,8 @@ public:
 	bool IsRangeWord(Position start, Position end);
 	void SetIdleStyling(Scintilla::IdleStyling idleStyling);
 	Scintilla::IdleStyling IdleStyling();
+	void SetBackgroundStyling(bool backgroundStyling);
+	bool BackgroundStyling();
 	void SetWrapMode(Scintilla::Wrap wrapMode);
 	Scintilla::Wrap WrapMode();
 	void SetWrapVisualFlags(Scintilla::WrapVisualFlag wrapVisualFlags);
@@ -478,6 +510,13 @@ public:
 	Scintilla::WrapIndentMode WrapIndentMode();
 	void SetLayoutCache(Scintilla::LineCache cacheMode);
 	Scintilla::LineCache LayoutCache();
+	void SetLayoutCacheLimit(Position bytes);
+	Position LayoutCacheLimit();
+	void SetLayoutThreads(int threads);
+	int LayoutThreads();
+	void SetBackgroundWorkThrottled(bool throttled);
+	bool BackgroundWorkThrottled();
+	void GetPaintStatistics(bool reset, PaintStatistics *statistics);
 	void SetScrollWidth(int pixelWidth);
 	int ScrollWidth();
 	void SetScrollWidthTracking(bool tracking);
@@ -500,6 +539,7 @@ public:
 	std::string Tag(int tagNumber);
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
+	Position LinesPad(Scintilla::LinesPadFlag flags);
 	void SetFoldMarginColour(bool useSetting, Colour back);
 	void SetFoldMarginHiColour(bool useSetting, Colour fore);
 	void SetAccessibility(Scintilla::Accessibility accessibility);
@@ -600,6 +640,7 @@ public:
 	void AddRefDocument(IDocumentEditable *doc);
 	void ReleaseDocument(IDocumentEditable *doc);
 	Scintilla::DocumentOption DocumentOptions();
+	void ConvertToLargeDocument();
 	Scintilla::ModificationFlags ModEventMask();
 	void SetCommandEvents(bool commandEvents);
 	bool CommandEvents();
@@ -705,6 +746,7 @@ public:
 	void SetIndicatorValue(int value);
 	int IndicatorValue();
 	void IndicatorFillRange(Position start, Position lengthFill);
+	void IndicatorFillRanges(Position count, void *ranges);
 	void IndicatorClearRange(Position start, Position lengthClear);
 	int IndicatorAllOnFor(Position pos);
 	int IndicatorValueAt(int indicator, Position pos);
@@ -712,6 +754,7 @@ public:
 	Position IndicatorEnd(int indicator, Position pos);
 	void SetPositionCache(int size);
 	int PositionCache();
+	void ReleaseResources();
 	void CopyAllowLine();
 	void CutAllowLine();
 	void SetCopySeparator(const char *separator);
@@ -720,6 +763,7 @@ public:
 	void *CharacterPointer();
 	void *RangePointer(Position start, Position lengthRange);
 	Position GapPosition();
+	Position GetRangeSegments(TextSegments *segments);
 	void IndicSetAlpha(int indicator, Scintilla::Alpha alpha);
 	Scintilla::Alpha IndicGetAlpha(int indicator);
 	void IndicSetOutlineAlpha(int indicator, Scintilla::Alpha alpha);
@@ -751,6 +795,7 @@ public:
 	int AnnotationGetStyles(Line line, char *styles);
 	std::string AnnotationGetStyles(Line line);
 	int AnnotationGetLines(Line line);
+	void AnnotationSetBulk(Position count, const AnnotationRecord *records);
 	void AnnotationClearAll();
 	void AnnotationSetVisible(Scintilla::AnnotationVisible visible);
 	Scintilla::AnnotationVisible AnnotationGetVisible();
@@ -851,6 +896,7 @@ public:
 	std::string EOLAnnotationGetText(Line line);
 	void EOLAnnotationSetStyle(Line line, int style);
 	int EOLAnnotationGetStyle(Line line);
+	void EOLAnnotationSetBulk(Position count, const AnnotationRecord *records);
 	void EOLAnnotationClearAll();
 	void EOLAnnotationSetVisible(Scintilla::EOLAnnotationVisible visible);
 	Scintilla::EOLAnnotationVisible EOLAnnotationGetVisible();
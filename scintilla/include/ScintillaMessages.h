@@ -83,6 +83,7 @@ enum class Message {
 	MarkerPrevious = 2048,
 	MarkerDefinePixmap = 2049,
 	MarkerAddSet = 2466,
+	MarkerAddLines = 2832,
 	MarkerGetLayer = 2734,
 	MarkerSetLayer = 2735,
 	SetMarginTypeN = 2240,
@@ -133,6 +134,9 @@ enum class Message {
 	StyleGetWeight = 2064,
 	StyleSetCharacterSet = 2066,
 	StyleSetHotSpot = 2409,
+	StyleSetBulk = 2841,
+	BeginStyleUpdate = 2842,
+	EndStyleUpdate = 2843,
 	StyleSetStretch = 2258,
 	StyleGetStretch = 2259,
 	StyleSetInvisibleRepresentation = 2256,
@@ -166,6 +170,7 @@ enum class Message {
 	GetCharacterCategoryOptimization = 2721,
 	BeginUndoAction = 2078,
 	EndUndoAction = 2079,
+	SendCommands = 2846,
 	GetUndoSequence = 2799,
 	GetUndoActions = 2790,
 	SetUndoSavePoint = 2791,
@@ -181,12 +186,18 @@ enum class Message {
 	GetUndoActionType = 2802,
 	GetUndoActionPosition = 2803,
 	GetUndoActionText = 2804,
+	SetUndoMemoryLimit = 2820,
+	GetUndoMemoryLimit = 2821,
+	GetUndoMemory = 2822,
+	GetMemoryUsage = 2825,
 	IndicSetStyle = 2080,
 	IndicGetStyle = 2081,
 	IndicSetFore = 2082,
 	IndicGetFore = 2083,
 	IndicSetUnder = 2510,
 	IndicGetUnder = 2511,
+	IndicSetOverviewRuler = 2856,
+	IndicGetOverviewRuler = 2857,
 	IndicSetHoverStyle = 2680,
 	IndicGetHoverStyle = 2681,
 	IndicSetHoverFore = 2682,
@@ -248,6 +259,7 @@ enum class Message {
 	GetColumn = 2129,
 	CountCharacters = 2633,
 	CountCharactersAndColumns = 2522,
+	CountTextStatistics = 2845,
 	CountCodeUnits = 2715,
 	SetHScrollBar = 2130,
 	GetHScrollBar = 2131,
@@ -269,9 +281,14 @@ enum class Message {
 	SetPrintColourMode = 2148,
 	GetPrintColourMode = 2149,
 	FindTextFull = 2196,
+	FindAll = 2826,
+	GetFindAllRanges = 2827,
+	SetSearchIndexThreshold = 2828,
+	GetSearchIndexThreshold = 2829,
 	FormatRangeFull = 2777,
 	SetChangeHistory = 2780,
 	GetChangeHistory = 2781,
+	ChangeHistoryLineNext = 2851,
 	SetUndoSelectionHistory = 2782,
 	GetUndoSelectionHistory = 2783,
 	GetFirstVisibleLine = 2152,
@@ -282,6 +299,10 @@ enum class Message {
 	GetMarginLeft = 2156,
 	SetMarginRight = 2157,
 	GetMarginRight = 2158,
+	SetOverviewRulerWidth = 2852,
+	GetOverviewRulerWidth = 2853,
+	SetOverviewRulerMarkers = 2854,
+	GetOverviewRulerMarkers = 2855,
 	GetModify = 2159,
 	SetSel = 2160,
 	GetSelText = 2161,
@@ -333,6 +354,7 @@ enum class Message {
 	ReplaceTargetRE = 2195,
 	ReplaceTargetMinimal = 2779,
 	SearchInTarget = 2197,
+	ReplaceAllInTarget = 2830,
 	SetSearchFlags = 2198,
 	GetSearchFlags = 2199,
 	CallTipShow = 2200,
@@ -356,6 +378,7 @@ enum class Message {
 	GetFoldParent = 2225,
 	ShowLines = 2226,
 	HideLines = 2227,
+	HideLinesExceptFindAll = 2850,
 	GetLineVisible = 2228,
 	GetAllLinesVisible = 2236,
 	SetFoldExpanded = 2229,
@@ -370,6 +393,7 @@ enum class Message {
 	FoldChildren = 2238,
 	ExpandChildren = 2239,
 	FoldAll = 2662,
+	FoldAllLevel = 2835,
 	EnsureVisible = 2232,
 	SetAutomaticFold = 2663,
 	GetAutomaticFold = 2664,
@@ -386,6 +410,8 @@ enum class Message {
 	IsRangeWord = 2691,
 	SetIdleStyling = 2692,
 	GetIdleStyling = 2693,
+	SetBackgroundStyling = 2833,
+	GetBackgroundStyling = 2834,
 	SetWrapMode = 2268,
 	GetWrapMode = 2269,
 	SetWrapVisualFlags = 2460,
@@ -398,6 +424,13 @@ enum class Message {
 	GetWrapIndentMode = 2473,
 	SetLayoutCache = 2272,
 	GetLayoutCache = 2273,
+	SetLayoutCacheLimit = 2836,
+	GetLayoutCacheLimit = 2837,
+	SetLayoutThreads = 2838,
+	GetLayoutThreads = 2839,
+	SetBackgroundWorkThrottled = 2848,
+	GetBackgroundWorkThrottled = 2849,
+	GetPaintStatistics = 2840,
 	SetScrollWidth = 2274,
 	GetScrollWidth = 2275,
 	SetScrollWidthTracking = 2516,
@@ -419,6 +452,7 @@ enum class Message {
 	GetTag = 2616,
 	LinesJoin = 2288,
 	LinesSplit = 2289,
+	LinesPad = 2844,
 	SetFoldMarginColour = 2290,
 	SetFoldMarginHiColour = 2291,
 	SetAccessibility = 2702,
@@ -519,6 +553,7 @@ enum class Message {
 	AddRefDocument = 2376,
 	ReleaseDocument = 2377,
 	GetDocumentOptions = 2379,
+	ConvertToLargeDocument = 2824,
 	GetModEventMask = 2378,
 	SetCommandEvents = 2717,
 	GetCommandEvents = 2718,
@@ -619,6 +654,7 @@ enum class Message {
 	SetIndicatorValue = 2502,
 	GetIndicatorValue = 2503,
 	IndicatorFillRange = 2504,
+	IndicatorFillRanges = 2831,
 	IndicatorClearRange = 2505,
 	IndicatorAllOnFor = 2506,
 	IndicatorValueAt = 2507,
@@ -626,6 +662,7 @@ enum class Message {
 	IndicatorEnd = 2509,
 	SetPositionCache = 2514,
 	GetPositionCache = 2515,
+	ReleaseResources = 2847,
 	CopyAllowLine = 2519,
 	CutAllowLine = 2810,
 	SetCopySeparator = 2811,
@@ -633,6 +670,7 @@ enum class Message {
 	GetCharacterPointer = 2520,
 	GetRangePointer = 2643,
 	GetGapPosition = 2644,
+	GetRangeSegments = 2823,
 	IndicSetAlpha = 2523,
 	IndicGetAlpha = 2524,
 	IndicSetOutlineAlpha = 2558,
@@ -660,6 +698,7 @@ enum class Message {
 	AnnotationSetStyles = 2544,
 	AnnotationGetStyles = 2545,
 	AnnotationGetLines = 2546,
+	AnnotationSetBulk = 2858,
 	AnnotationClearAll = 2547,
 	AnnotationSetVisible = 2548,
 	AnnotationGetVisible = 2549,
@@ -758,6 +797,7 @@ enum class Message {
 	EOLAnnotationGetText = 2741,
 	EOLAnnotationSetStyle = 2742,
 	EOLAnnotationGetStyle = 2743,
+	EOLAnnotationSetBulk = 2859,
 	EOLAnnotationClearAll = 2744,
 	EOLAnnotationSetVisible = 2745,
 	EOLAnnotationGetVisible = 2746,
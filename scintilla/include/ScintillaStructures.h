@@ -20,6 +20,54 @@ struct TextRangeFull final {
 	char *lpstrText;
 };
 
+struct TextSegments final {
+	CharacterRangeFull chrg;
+	const char *segment1;
+	Position length1;
+	const char *segment2;
+	Position length2;
+};
+
+// longestLine is measured in characters without line end
+struct TextStatistics final {
+	CharacterRangeFull chrg;
+	Position characters;
+	Position utf16Units;
+	Position words;
+	Position lines;
+	Position emptyLines;
+	Position longestLine;
+	Position invalidBytes;
+};
+
+// times are in microseconds
+struct PaintStatistics final {
+	int frames;
+	int paintTime;
+	int layoutTime;
+	int linesLaidOut;
+	int positionCacheHits;
+	int positionCacheMisses;
+	int styleBytesPerMillisecond;
+	int wrapBytesPerMillisecond;
+	int idlePending;
+	int lineLayoutHits;
+	int lineLayoutMisses;
+};
+
+// bool attributes are selected by mask and their values are taken from attributes
+struct StyleRecord final {
+	int style;
+	int mask;
+	int fore;
+	int back;
+	int sizeFractional;
+	int weight;
+	int characterSet;
+	int attributes;
+	const char *fontName;
+};
+
 struct TextToFindFull final {
 	CharacterRangeFull chrg;
 	const char *lpstrText;
@@ -56,6 +104,19 @@ struct NotifyHeader final {
 
 enum class Message;	// Declare in case ScintillaMessages.h not included
 
+struct CommandRecord final {
+	Message message;
+	uptr_t wParam;
+	sptr_t lParam;
+};
+
+// text is copied, a nullptr text clears annotation of the line
+struct AnnotationRecord final {
+	Position line;
+	int style;
+	const char *text;
+};
+
 struct NotificationData final {
 	NotifyHeader nmhdr;
 	Position position;
@@ -166,6 +166,20 @@ enum class FontWeight {
 	Bold = 700,
 };
 
+enum class StyleRecordMask {
+	Fore = 0x001,
+	Back = 0x002,
+	Size = 0x004,
+	Weight = 0x008,
+	Font = 0x010,
+	CharacterSet = 0x020,
+	Italic = 0x040,
+	Underline = 0x080,
+	Strike = 0x100,
+	Overline = 0x200,
+	EolFilled = 0x400,
+};
+
 enum class FontStretch {
 	UltraCondensed = 1,
 	ExtraCondensed = 2,
@@ -211,6 +225,20 @@ enum class Layer {
 	OverText = 2,
 };
 
+enum class MemoryCategory {
+	Total = 0,
+	Text = 1,
+	Styles = 2,
+	Lines = 3,
+	UndoHistory = 4,
+	ChangeHistory = 5,
+	Decorations = 6,
+	PerLine = 7,
+	LineLayoutCache = 8,
+	PositionCache = 9,
+	SearchIndex = 10,
+};
+
 enum class IndicatorStyle {
 	Plain = 0,
 	Squiggle = 1,
@@ -267,6 +295,7 @@ enum class AutoCompleteOption {
 	Normal = 0,
 	FixedSize = 1,
 	SelectFirstItem = 2,
+	FilterList = 4,
 };
 
 enum class IndentView {
@@ -336,6 +365,7 @@ enum class FoldAction {
 	Expand = 1,
 	Toggle = 2,
 	ContractEveryLevel = 4,
+	NestedLevel = 8,
 };
 
 enum class AutomaticFold {
@@ -416,6 +446,12 @@ enum class MultiPaste {
 	Each = 1,
 };
 
+enum class LinesPadFlag {
+	None = 0,
+	SkipEmpty = 1,
+	Rectangular = 2,
+};
+
 enum class Accessibility {
 	Disabled = 0,
 	Enabled = 1,
@@ -443,7 +479,9 @@ enum class PopUp {
 enum class DocumentOption {
 	Default = 0,
 	StylesNone = 0x1,
+	StylesCompressed = 0x2,
 	TextLarge = 0x100,
+	TextPieces = 0x200,
 };
 
 enum class Status {
@@ -23,8 +23,12 @@
 	#define NP2_USE_SSE2		0
 	#define NP2_USE_AVX2		0
 	#define NP2_USE_AVX512		0
+	// Advanced SIMD is mandatory for ARMv8-A
+	#define NP2_USE_NEON		1
+	#include <arm_neon.h>
 #else
 	#define NP2_TARGET_ARM		0
+	#define NP2_USE_NEON		0
 	// SSE2 enabled by default
 	#define NP2_USE_SSE2		1
 
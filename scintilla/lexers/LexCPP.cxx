@@ -372,11 +372,15 @@ void ColouriseCppDoc(Sci_PositionU startPos, Sci_Position length, int initStyle,
 			if (sc.Match('*', '/')) {
 				sc.Forward();
 				sc.ForwardSetState(SCE_C_DEFAULT);
+			} else if (sc.ch != '\\') {
+				sc.AdvanceBefore("*\\");
 			}
 			break;
 		case SCE_C_COMMENTLINE:
 			if (sc.atLineStart && !continuationLine) {
 				sc.SetState(SCE_C_DEFAULT);
+			} else if (sc.ch != '\\') {
+				sc.AdvanceBefore("\\");
 			}
 			break;
 		case SCE_C_COMMENTDOC:
@@ -79,7 +79,7 @@ constexpr bool IsCssIdentifierStartEx(int ch, int chNext, Preprocessor preproces
 
 void ColouriseCssDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
 	const Preprocessor preprocessor = static_cast<Preprocessor>(styler.GetPropertyInt("lexer.lang"));
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 	bool propertyValue = false;
 	bool attributeSelector = false;
 	bool calcFunc = false;
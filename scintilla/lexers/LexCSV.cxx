@@ -38,11 +38,17 @@ inline uint32_t asU4(const char *s) noexcept {
 }
 
 void ColouriseCSVDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList /*keywordLists*/, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 	const char * const option = styler.GetProperty("lexer.lang");
 	const uint32_t csvOption = asU4(option);
 	const uint8_t delimiter = csvOption & 0xff;
 	const uint8_t quoteChar = (csvOption >> 8) & 0x7f;
+	// trail byte in DBCS character may equal to delimiter
+	const bool fastScan = styler.Encoding() != EncodingType::dbcs;
+	const bool escape = (csvOption & CsvOption_BackslashEscape) != 0;
+	// bytes that end a run of field content or quoted content
+	const char fieldStops[3] = { static_cast<char>(delimiter), escape ? '\\' : '\0', '\0' };
+	const char quotedStops[3] = { static_cast<char>(quoteChar), escape ? '\\' : '\0', '\0' };
 
 	bool quoted = false;
 	int rows = CsvRowGroup - 1;
@@ -99,7 +105,7 @@ void ColouriseCSVDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSty
 		chPrev = ch;
 		if (ch > ' ') {
 			chPrevNonWhite = ch;
-			if (ch == '\\' && (csvOption & CsvOption_BackslashEscape) != 0) {
+			if (ch == '\\' && escape) {
 				startPos++;
 			}
 			if (styler.IsLeadByte(ch)) {
@@ -108,6 +114,22 @@ void ColouriseCSVDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSty
 			}
 		}
 
+		if (fastScan) {
+			const Sci_PositionU limit = sci::min(lineStartNext, endPos);
+			if (startPos < limit) {
+				if (quoted) {
+					startPos = styler.FindAnyOf(startPos, limit, quotedStops);
+				} else if (chPrevNonWhite != delimiter) {
+					// inside field, quote is not special
+					const Sci_PositionU next = styler.FindAnyOf(startPos, limit, fieldStops);
+					if (next != startPos) {
+						chPrev = 0;
+						startPos = next;
+					}
+				}
+			}
+		}
+
 		if (startPos == lineStartNext) {
 			if (fold) {
 				++rows;
@@ -115,14 +115,21 @@ inline int ColouriseDiffLine(const char (&lineBuffer)[DIFF_BUFFER_START_SIZE]) n
 }
 
 void ColouriseDiffDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList /*keywordLists*/, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 
-	styler.StartAt(startPos);
-	styler.StartSegment(startPos);
 	const Sci_Position endPos = startPos + lengthDoc;
 	const Sci_Line maxLines = styler.GetLine((endPos == styler.Length()) ? endPos : endPos - 1);
 
 	Sci_Line lineCurrent = styler.GetLine(startPos);
+	if (fold && lineCurrent > 0) {
+		// header flag of previous line depends on current line
+		lineCurrent--;
+		startPos = styler.LineStart(lineCurrent);
+		initStyle = (lineCurrent > 0) ? styler.StyleIndexAt(startPos - 1) : SCE_DIFF_DEFAULT;
+	}
+
+	styler.StartAt(startPos);
+	styler.StartSegment(startPos);
 	int prevLevel = (lineCurrent > 0) ? styler.LevelAt(lineCurrent - 1) : SC_FOLDLEVELBASE;
 
 	Sci_PositionU lineStartCurrent = styler.LineStart(lineCurrent);
@@ -169,4 +176,5 @@ void ColouriseDiffDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 
 }
 
-extern const LexerModule lmDiff(SCLEX_DIFF, ColouriseDiffDoc, "diff");
+// lexing restarts from previous line, whose fold level depends on level of the line before it
+extern const LexerModule lmDiff(SCLEX_DIFF, ColouriseDiffDoc, "diff", nullptr, 2, 0, true);
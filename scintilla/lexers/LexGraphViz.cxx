@@ -56,7 +56,7 @@ inline bool IsAttributeValue(const LexAccessor &styler, Sci_PositionU startPos)
 }
 
 void ColouriseGraphVizDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 	int levelCurrent = SC_FOLDLEVELBASE;
 
 	int htmlTagLevel = 0;
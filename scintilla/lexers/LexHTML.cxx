@@ -49,6 +49,10 @@ enum script_mode { eHtml = 0, eNonHtmlScript, eNonHtmlPreProc, eNonHtmlScriptPre
 // Put an upper limit to bound time taken for unexpected text.
 constexpr Sci_PositionU maxLengthCheck = 200;
 
+// line state bits for lines that can't be restart point
+constexpr int LineStateTagOpened = 1 << 2;
+constexpr int LineStateLookbackLine = 1 << 29; // no non-white character on this line
+
 script_type segIsScriptingIndicator(const LexAccessor &styler, Sci_PositionU start, Sci_PositionU end, script_type prevValue) {
 	char s[128];
 	styler.GetRangeLowered(start, end, s, sizeof(s));
@@ -373,7 +377,7 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 	script_type clientScript = static_cast<script_type>((lineState >> 8) & 0x0F); // 4 bits of script name
 	int beforePreProc = (lineState >> 12) & 0xFF; // 8 bits of state
 	bool isLanguageType = (lineState >> 20) & 1; // type or language attribute for script tag
-	int sgmlBlockLevel = (lineState >> 21);
+	int sgmlBlockLevel = (lineState >> 21) & 0xFF;
 
 	script_type scriptLanguage = ScriptOfState(state);
 	// If eNonHtmlScript coincides with SCE_H_COMMENT, assume eScriptComment
@@ -387,7 +391,7 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 	//	The fold option must also be on for folding to occur.
 	constexpr bool foldHTML = true;//styler.GetPropertyBool("fold.html", true);
 
-	const bool fold = foldHTML & styler.GetPropertyInt("fold");
+	const bool fold = foldHTML && styler.IsFoldEnabled();
 
 	// property fold.html.preprocessor
 	//	Folding is turned on or off for scripts embedded in HTML files with this option.
@@ -409,6 +413,7 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 	int chPrev = ' ';
 	int ch = ' ';
 	int chPrevNonWhite = ' ';
+	int nonWhiteChars = 0;
 	// look back to set chPrevNonWhite properly for better regex colouring
 	if (scriptLanguage == eScriptJS && startPos > 0) {
 		Sci_Position back = startPos;
@@ -431,8 +436,10 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 		const int chPrev2 = chPrev;
 		chPrev = ch;
 		if (!IsASpace(ch) && state != SCE_HJ_COMMENT &&
-			state != SCE_HJ_COMMENTLINE && state != SCE_HJ_COMMENTDOC)
+			state != SCE_HJ_COMMENTLINE && state != SCE_HJ_COMMENTDOC) {
 			chPrevNonWhite = ch;
+			nonWhiteChars++;
+		}
 		ch = static_cast<unsigned char>(styler[i]);
 		int chNext = styler.SafeGetUCharAt(i + 1);
 		const int chNext2 = styler.SafeGetUCharAt(i + 2);
@@ -481,8 +488,10 @@ void ColouriseHyperTextDoc(Sci_PositionU startPos, Sci_Position length, int init
 			                    (static_cast<int>(clientScript) << 8) |
 			                    (beforePreProc << 12) |
 			                    (static_cast<int>(isLanguageType) << 20) |
-			                    (sgmlBlockLevel << 21));
+			                    (sgmlBlockLevel << 21) |
+			                    ((nonWhiteChars == 0) ? LineStateLookbackLine : 0));
 			lineCurrent++;
+			nonWhiteChars = 0;
 		}
 
 		// generic end of script processing
@@ -1291,5 +1300,5 @@ void ColouriseHTMLDoc(Sci_PositionU startPos, Sci_Position length, int initStyle
 
 }
 
-extern const LexerModule lmHTML(SCLEX_HTML, ColouriseHTMLDoc, "hypertext");
-extern const LexerModule lmXML(SCLEX_XML, ColouriseXMLDoc, "xml");
+extern const LexerModule lmHTML(SCLEX_HTML, ColouriseHTMLDoc, "hypertext", nullptr, 2, LineStateTagOpened | LineStateLookbackLine);
+extern const LexerModule lmXML(SCLEX_XML, ColouriseXMLDoc, "xml", nullptr, 2, LineStateTagOpened | LineStateLookbackLine);
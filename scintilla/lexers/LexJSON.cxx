@@ -57,7 +57,8 @@ bool IsJsonProperty(LexAccessor &styler, Sci_PositionU startPos, uint8_t chNext)
 }
 
 void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
+	const bool dbcs = styler.Encoding() == EncodingType::dbcs;
 
 	// JSON5 line continuation
 	bool lineContinuation = false;
@@ -182,6 +183,10 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 				styler.ColorTo(startPos, state);
 				state = SCE_JSON_DEFAULT;
 				continue;
+			} else if (!dbcs) {
+				// skip string body to next escape, quote or line start
+				startPos = styler.FindAnyOf(startPos, sci::min(lineStartNext, endPos), (state == SCE_JSON_STRING_DQ) ? "\\\"" : "\\\'");
+				chNext = styler[startPos];
 			}
 			break;
 
@@ -189,6 +194,9 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 			if (atLineStart) {
 				styler.ColorTo(currentPos, state);
 				state = SCE_JSON_DEFAULT;
+			} else if (!dbcs) {
+				startPos = sci::min(lineStartNext, endPos);
+				chNext = styler[startPos];
 			}
 			break;
 
@@ -201,6 +209,10 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 				levelNext--;
 				continue;
 			}
+			if (!dbcs) {
+				startPos = styler.FindAnyOf(startPos, sci::min(lineStartNext, endPos), "*");
+				chNext = styler[startPos];
+			}
 			break;
 		}
 
@@ -239,6 +251,10 @@ void ColouriseJSONDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSt
 				default:
 					break;
 				}
+			} else if (!dbcs && (chNext == ' ' || chNext == '\t')) {
+				// skip indentation of pretty printed document
+				startPos = styler.SkipAnyOf(startPos, sci::min(lineStartNext, endPos), " \t");
+				chNext = styler[startPos];
 			}
 		}
 
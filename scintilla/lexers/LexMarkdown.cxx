@@ -642,6 +642,11 @@ int MarkdownLexer::GetListChildIndentCount(int indentCurrent) const noexcept {
 }
 
 int MarkdownLexer::UpdateParentIndentCount(int indentCurrent) noexcept {
+	// line without indentation is never inside a container, avoid scanning whole paragraph backward
+	if (indentCurrent == 0) {
+		indentParent = 0;
+		return indentCurrent;
+	}
 	int indentCount = indentCurrent;
 	Sci_Line line = sc.currentLine;
 	while (line != 0) {
@@ -659,6 +664,9 @@ int MarkdownLexer::UpdateParentIndentCount(int indentCurrent) noexcept {
 			indentCount = GetIndentCount(lineState);
 			if (indentCurrent < 0) {
 				indentCurrent = indentCount;
+				if (indentCurrent == 0) {
+					break;
+				}
 			} else if (lineState & LineStateListItemFirstLine) {
 				if (indentCount < indentCurrent) {
 					indentParent = GetIndentChild(lineState);
@@ -1632,7 +1640,7 @@ void ColouriseMarkdownDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int in
 	}
 
 	MarkdownLexer lexer(startPos, lengthDoc, initStyle, keywordLists, styler);
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 
 	StyleContext &sc = lexer.sc;
 	uint32_t lineState = 0;
@@ -37,7 +37,7 @@ enum class SlotType {
 };
 
 void ColouriseMathematicaDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 
 	SlotType slotType = SlotType::None;
 	int outerState = SCE_MATHEMATICA_DEFAULT;
@@ -45,74 +45,11 @@ void ColouriseNullDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int /*init
 void FoldNullDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int /*initStyle*/, LexerWordList /*keywordLists*/, Accessor &styler) {
 	const Sci_Position maxPos = startPos + lengthDoc;
 	styler.StartAt(maxPos);
-	if (!styler.GetPropertyInt("fold")) {
+	if (!styler.IsFoldEnabled()) {
 		return;
 	}
 
-	const Sci_Line docLines = styler.GetLine(styler.Length());	// Available last line
-	const Sci_Line maxLines = (maxPos == styler.Length()) ? docLines : styler.GetLine(maxPos - 1);	// Requested last line
-
-	// Backtrack to previous non-blank line so we can determine indent level
-	// for any white space lines
-	// and so we can fix any preceding fold level (which is why we go back
-	// at least one line in all cases)
-	Sci_Line lineCurrent = styler.GetLine(startPos);
-	int indentCurrent = styler.IndentAmount(lineCurrent);
-	while (lineCurrent > 0) {
-		lineCurrent--;
-		indentCurrent = styler.IndentAmount(lineCurrent);
-		if (!(indentCurrent & SC_FOLDLEVELWHITEFLAG)) {
-			break;
-		}
-	}
-
-	// Process all characters to end of requested range
-	// Cap processing in all cases
-	// to end of document (in case of unclosed quote at end).
-	while (lineCurrent <= maxLines) {
-		// Gather info
-		Sci_Line lineNext = lineCurrent + 1;
-		int indentNext = indentCurrent;
-		while (lineNext <= docLines) {
-			// Information about next line is only available if not at end of document
-			indentNext = styler.IndentAmount(lineNext);
-			// Skip past any blank lines for next indent level info
-			if (!(indentNext & SC_FOLDLEVELWHITEFLAG)) {
-				break;
-			}
-			lineNext++;
-		}
-
-		// Set fold header
-		int lev = indentCurrent;
-		if (!(indentCurrent & SC_FOLDLEVELWHITEFLAG)) {
-			if ((indentCurrent & SC_FOLDLEVELNUMBERMASK) < (indentNext & SC_FOLDLEVELNUMBERMASK)) {
-				lev |= SC_FOLDLEVELHEADERFLAG;
-			}
-		}
-
-		// Set fold level for this line and move to next line
-		styler.SetLevel(lineCurrent, lev & ~SC_FOLDLEVELWHITEFLAG);
-		lineCurrent++;
-		indentCurrent = indentNext;
-
-		const int levelAfterBlank = indentNext & SC_FOLDLEVELNUMBERMASK;
-		const int skipLevel = levelAfterBlank;
-
-		// Now set all the indent levels on the lines we skipped
-		// [ignore following comment: only blank block is skipped]
-		// Do this from end to start. Once we encounter one line
-		// which is indented more than the line after the end of
-		// the blank-block, use the level of the block before
-
-		for (; lineCurrent < lineNext; lineCurrent++) {
-			styler.SetLevel(lineCurrent, skipLevel);
-		}
-	}
-
-	// NOTE: Cannot set level of last line here because indentCurrent doesn't have
-	// header flag set; the loop above is crafted to take care of this case!
-	//styler.SetLevel(lineCurrent, indentCurrent);
+	styler.FoldIndentation(startPos, lengthDoc);
 }
 #endif
 }
@@ -120,5 +57,6 @@ void FoldNullDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int /*initStyle
 #if !ENABLE_FOLD_NULL_DOCUMENT
 extern const LexerModule lmNull(SCLEX_NULL, ColouriseNullDoc, "null");
 #else
-extern const LexerModule lmNull(SCLEX_NULL, FoldNullDoc, "null");
+// folding only depends on text
+extern const LexerModule lmNull(SCLEX_NULL, FoldNullDoc, "null", nullptr, 0, 0, true);
 #endif
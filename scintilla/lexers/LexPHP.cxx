@@ -49,6 +49,7 @@ enum {
 	LineStateAttributeLine = 1 << 3,
 	JsLineStateLineContinuation = 1 << 4,
 	CssLineStatePropertyValue = 1 << 5,
+	LineStateLookbackLine = 1 << 6,	// script line without non-white character
 };
 
 //KeywordIndex++Autogenerated -- start of section automatically generated
@@ -794,6 +795,7 @@ void ColourisePHPDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSty
 
 	int visibleChars = 0;
 	int visibleCharsBefore = 0;
+	int nonWhiteChars = 0;
 	int chPrevNonWhite = 0;
 	int stylePrevNonWhite = SCE_H_DEFAULT;
 	DocTagState docTagState = DocTagState::None;
@@ -806,7 +808,8 @@ void ColourisePHPDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSty
 		1: lineStateAttribute
 		1: lineContinuation
 		1: propertyValue
-		2: unused
+		1: lookbackLine
+		1: unused
 		8: parenCount
 		8: selectorLevel
 		*/
@@ -1397,14 +1400,20 @@ void ColourisePHPDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initSty
 			if (!(IsJsSpaceEquiv(sc.state) || IsCssSpaceEquiv(sc.state))) {
 				chPrevNonWhite = sc.ch;
 				stylePrevNonWhite = sc.state;
+				nonWhiteChars++;
 			}
 		}
 		if (sc.atLineEnd) {
-			styler.SetLineState(sc.currentLine, lexer.LineState());
+			int lineState = lexer.LineState();
+			if (nonWhiteChars == 0 && GetHtmlTextBlock(sc.state) != HtmlTextBlock::Html) {
+				lineState |= LineStateLookbackLine;
+			}
+			styler.SetLineState(sc.currentLine, lineState);
 			lexer.lineStateLineType = 0;
 			lexer.kwType = KeywordType::None;
 			visibleChars = 0;
 			visibleCharsBefore = 0;
+			nonWhiteChars = 0;
 			docTagState = DocTagState::None;
 		}
 		sc.Forward();
@@ -1558,4 +1567,4 @@ void FoldPHPDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, L
 
 }
 
-extern const LexerModule lmPHPScript(SCLEX_PHPSCRIPT, ColourisePHPDoc, "php", FoldPHPDoc);
+extern const LexerModule lmPHPScript(SCLEX_PHPSCRIPT, ColourisePHPDoc, "php", FoldPHPDoc, 2, LineStateNestedStateLine | LineStateLookbackLine);
@@ -53,7 +53,7 @@ void ColourisePropsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initS
 	Sci_PositionU lineStartNext = styler.LineStart(lineCurrent + 1);
 
 #if !ENABLE_FOLD_PROPS_COMMENT
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 	int prevLevel = (lineCurrent > 0) ? styler.LevelAt(lineCurrent - 1) : SC_FOLDLEVELBASE;
 #endif
 
@@ -204,7 +204,8 @@ void FoldPropsDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int /*initStyl
 }
 
 #if ENABLE_FOLD_PROPS_COMMENT
-extern const LexerModule lmProps(SCLEX_PROPERTIES, ColourisePropsDoc, "props", FoldPropsDoc);
+// folding restarts from previous line, and comment folding looks at line state of two lines before it
+extern const LexerModule lmProps(SCLEX_PROPERTIES, ColourisePropsDoc, "props", FoldPropsDoc, 3, 0, true);
 #else
 extern const LexerModule lmProps(SCLEX_PROPERTIES, ColourisePropsDoc, "props");
 #endif
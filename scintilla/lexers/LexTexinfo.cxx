@@ -121,7 +121,7 @@ void HandleBlockEnd(StyleContext &sc, LexAccessor &styler, int &lineState) {
 }
 
 void ColouriseTexiDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 
 	int visibleChars = 0;
 	int outerState = SCE_TEXINFO_DEFAULT;
@@ -370,7 +370,7 @@ void ColouriseTypstDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initS
 	}
 
 	TypstLexer lexer(startPos, lengthDoc, initStyle, styler);
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 
 	StyleContext &sc = lexer.sc;
 	uint32_t lineState = 0;
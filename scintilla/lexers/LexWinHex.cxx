@@ -34,7 +34,7 @@ enum {
 //KeywordIndex--Autogenerated -- end of section automatically generated
 
 void ColouriseWinHexDoc(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, LexerWordList keywordLists, Accessor &styler) {
-	const bool fold = styler.GetPropertyBool("fold");
+	const bool fold = styler.IsFoldEnabled();
 	StyleContext sc(startPos, lengthDoc, initStyle, styler);
 	int levelCurrent = SC_FOLDLEVELBASE;
 	if (sc.currentLine > 0) {
@@ -22,6 +22,39 @@
 
 using namespace Lexilla;
 
+namespace {
+
+// leading whitespace width with fold flags, runs of spaces are skipped with SIMD.
+int MeasureIndentation(LexAccessor &styler, Sci_Position pos, Sci_Position end) noexcept {
+	char ch = '\0';
+	int indent = 0;
+
+	// TODO: avoid expanding tab, mixed indentation with space and tab is syntax error in languages like Python.
+	while (pos < end) {
+		const Sci_Position next = styler.SkipAnyOf(pos, end, " ");
+		indent += static_cast<int>(next - pos);
+		pos = next;
+		if (pos == end) {
+			break;
+		}
+		ch = styler[pos];
+		if (ch != '\t') {
+			break;
+		}
+		constexpr int defaultTabSpaces = 4;
+		indent = (indent + defaultTabSpaces) & ~(defaultTabSpaces - 1);
+		++pos;
+	}
+
+	indent += SC_FOLDLEVELBASE;
+	if ((pos == end) || (ch == '\n' || ch == '\r')) {
+		indent |= SC_FOLDLEVELWHITEFLAG;
+	}
+	return indent;
+}
+
+}
+
 Accessor::Accessor(Scintilla::IDocument *pAccess_, const PropSetSimple &props_) noexcept : LexAccessor(pAccess_), props(props_) {
 }
 
@@ -33,29 +66,71 @@ int Accessor::GetPropertyInt(const char *key, size_t keyLen, int defaultValue) c
 	return props.GetInt(key, keyLen, defaultValue);
 }
 
+bool Accessor::IsFoldEnabled() const noexcept {
+	return props.IsFoldEnabled();
+}
+
 int Accessor::IndentAmount(Sci_Line line) noexcept {
-	const Sci_Position end = Length();
-	Sci_Position pos = LineStart(line);
+	return MeasureIndentation(*this, LineStart(line), Length());
+}
 
-	char ch = '\0';
-	int indent = 0;
+void Accessor::FoldIndentation(Sci_PositionU startPos, Sci_Position lengthDoc) {
+	const Sci_Position maxPos = startPos + lengthDoc;
+	const Sci_Position docLength = Length();
+	const Sci_Line docLines = GetLine(docLength);	// Available last line
+	const Sci_Line maxLines = (maxPos == docLength) ? docLines : GetLine(maxPos - 1);	// Requested last line
 
-	// TODO: avoid expanding tab, mixed indentation with space and tab is syntax error in languages like Python.
-	while (pos < end) {
-		ch = (*this)[pos++];
-		if (ch == ' ') {
-			indent++;
-		} else if (ch == '\t') {
-			constexpr int defaultTabSpaces = 4;
-			indent = (indent + defaultTabSpaces) & ~(defaultTabSpaces - 1);
-		} else {
+	// Backtrack to previous non-blank line so we can determine indent level
+	// for any white space lines, and fix any preceding fold level.
+	Sci_Line lineBegin = GetLine(startPos);
+	while (lineBegin > 0) {
+		lineBegin--;
+		if (!(IndentAmount(lineBegin) & SC_FOLDLEVELWHITEFLAG)) {
 			break;
 		}
 	}
 
-	indent += SC_FOLDLEVELBASE;
-	if ((pos == end) || (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r')) {
-		indent |= SC_FOLDLEVELWHITEFLAG;
+	// measure every line in requested range, plus blank lines after it up to next non-blank line
+	std::vector<int> indents;
+	indents.reserve(maxLines - lineBegin + 2);
+	Sci_Line line = lineBegin;
+	while (line <= docLines) {
+		const int indent = MeasureIndentation(*this, LineStart(line), docLength);
+		indents.push_back(indent);
+		if (line > maxLines && !(indent & SC_FOLDLEVELWHITEFLAG)) {
+			break;
+		}
+		++line;
 	}
-	return indent;
+
+	// derive fold levels in one pass, a line is header when next non-blank line is indented more,
+	// blank lines take level of next non-blank line.
+	std::vector<int> levels;
+	levels.reserve(indents.size());
+	Sci_Line lineCurrent = lineBegin;
+	int indentCurrent = indents[0];
+	while (lineCurrent <= maxLines) {
+		Sci_Line lineNext = lineCurrent + 1;
+		int indentNext = indentCurrent;
+		while (lineNext <= docLines) {
+			indentNext = indents[lineNext - lineBegin];
+			if (!(indentNext & SC_FOLDLEVELWHITEFLAG)) {
+				break;
+			}
+			lineNext++;
+		}
+
+		int lev = indentCurrent;
+		if (!(indentCurrent & SC_FOLDLEVELWHITEFLAG)) {
+			if ((indentCurrent & SC_FOLDLEVELNUMBERMASK) < (indentNext & SC_FOLDLEVELNUMBERMASK)) {
+				lev |= SC_FOLDLEVELHEADERFLAG;
+			}
+		}
+		levels.push_back(lev & ~SC_FOLDLEVELWHITEFLAG);
+		levels.resize(lineNext - lineBegin, indentNext & SC_FOLDLEVELNUMBERMASK);
+		lineCurrent = lineNext;
+		indentCurrent = indentNext;
+	}
+
+	SetLevels(lineBegin, static_cast<Sci_Line>(levels.size()), levels.data());
 }
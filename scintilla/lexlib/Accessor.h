@@ -39,7 +39,11 @@ public:
 		return GetPropertyInt(key, N - 1, defaultValue) & true;
 	}
 
+	bool IsFoldEnabled() const noexcept;
+
 	int IndentAmount(Sci_Line line) noexcept;
+	// indentation based folding for lines in [startPos, startPos + lengthDoc), levels are written in bulk.
+	void FoldIndentation(Sci_PositionU startPos, Sci_Position lengthDoc);
 
 	[[deprecated]]
 	int IndentAmount(Sci_Line line, [[maybe_unused]] int *flags, [[maybe_unused]] PFNIsCommentLeader pfnIsCommentLeader = nullptr) noexcept {
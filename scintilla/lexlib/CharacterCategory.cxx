@@ -790,7 +790,7 @@ constexpr int maskCategory = 0x1F;
 // possibly for 0..0xff for most Western European text or 0..0xfff for most
 // alphabetic languages.
 
-CharacterCategory CategoriseCharacter(int character) noexcept {
+CharacterCategory CategoriseCharacterNonASCII(int character) noexcept {
 	if (character < 0 || character > maxUnicode) {
 		return ccCn;
 	}
@@ -801,7 +801,7 @@ CharacterCategory CategoriseCharacter(int character) noexcept {
 
 #else
 //function++Autogenerated -- start of section automatically generated
-CharacterCategory CategoriseCharacter(int character) noexcept {
+CharacterCategory CategoriseCharacterNonASCII(int character) noexcept {
 	if (character < 0 || character > maxUnicode) {
 		return ccCn;
 	}
@@ -913,7 +913,7 @@ bool OmitXidContinue(int character) noexcept {
 
 // UAX #31 defines ID_Start as
 // [[:L:][:Nl:][:Other_ID_Start:]--[:Pattern_Syntax:]--[:Pattern_White_Space:]]
-bool IsIdStart(int character) noexcept {
+bool IsIdStartNonASCII(int character) noexcept {
 	if (IsIdPattern(character)) {
 		return false;
 	}
@@ -928,7 +928,7 @@ bool IsIdStart(int character) noexcept {
 
 // UAX #31 defines ID_Continue as
 // [[:ID_Start:][:Mn:][:Mc:][:Nd:][:Pc:][:Other_ID_Continue:]--[:Pattern_Syntax:]--[:Pattern_White_Space:]]
-bool IsIdContinue(int character) noexcept {
+bool IsIdContinueNonASCII(int character) noexcept {
 	if (IsIdPattern(character)) {
 		return false;
 	}
@@ -942,7 +942,7 @@ bool IsIdContinue(int character) noexcept {
 }
 
 // XID_Start is ID_Start modified for Normalization Form KC in UAX #31
-bool IsXidStart(int character) noexcept {
+bool IsXidStartNonASCII(int character) noexcept {
 	if (OmitXidStart(character)) {
 		return false;
 	}
@@ -950,7 +950,7 @@ bool IsXidStart(int character) noexcept {
 }
 
 // XID_Continue is ID_Continue modified for Normalization Form KC in UAX #31
-bool IsXidContinue(int character) noexcept {
+bool IsXidContinueNonASCII(int character) noexcept {
 	if (OmitXidContinue(character)) {
 		return false;
 	}
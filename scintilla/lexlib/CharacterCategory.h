@@ -19,13 +19,61 @@ enum CharacterCategory {
 	ccCc, ccCf, ccCs, ccCo, ccCn
 };
 
-CharacterCategory CategoriseCharacter(int character) noexcept;
+CharacterCategory CategoriseCharacterNonASCII(int character) noexcept;
+
+// ASCII bitmask for the categories, bit 0 to 127 is character 0 to 127.
+constexpr uint32_t asciiLetterMask[4] = { 0, 0, 0x07fffffe, 0x07fffffe }; // Lu, Ll
+constexpr uint32_t asciiIdContinueMask[4] = { 0, 0x03ff0000, 0x87fffffe, 0x07fffffe }; // Lu, Ll, Nd, Pc
+
+constexpr bool IsASCIIMaskSet(const uint32_t (&mask)[4], int character) noexcept {
+	return (mask[character >> 5] >> (character & 31)) & true;
+}
+
+inline CharacterCategory CategoriseCharacter(int character) noexcept {
+	if (static_cast<unsigned>(character) < 0x80) {
+		// https://www.unicode.org/charts/PDF/U0000.pdf
+		if (IsASCIIMaskSet(asciiIdContinueMask, character)) {
+			return (character >= 'a') ? ccLl : ((character >= 'A') ? ((character == '_') ? ccPc : ccLu) : ccNd);
+		}
+	}
+	return CategoriseCharacterNonASCII(character);
+}
 
 // Common definitions of allowable characters in identifiers from UAX #31.
-bool IsIdStart(int character) noexcept;
-bool IsIdContinue(int character) noexcept;
-bool IsXidStart(int character) noexcept;
-bool IsXidContinue(int character) noexcept;
+bool IsIdStartNonASCII(int character) noexcept;
+bool IsIdContinueNonASCII(int character) noexcept;
+bool IsXidStartNonASCII(int character) noexcept;
+bool IsXidContinueNonASCII(int character) noexcept;
+
+// ID_Start and XID_Start are [A-Za-z] for ASCII
+inline bool IsIdStart(int character) noexcept {
+	if (static_cast<unsigned>(character) < 0x80) {
+		return IsASCIIMaskSet(asciiLetterMask, character);
+	}
+	return IsIdStartNonASCII(character);
+}
+
+// ID_Continue and XID_Continue are [0-9A-Za-z_] for ASCII
+inline bool IsIdContinue(int character) noexcept {
+	if (static_cast<unsigned>(character) < 0x80) {
+		return IsASCIIMaskSet(asciiIdContinueMask, character);
+	}
+	return IsIdContinueNonASCII(character);
+}
+
+inline bool IsXidStart(int character) noexcept {
+	if (static_cast<unsigned>(character) < 0x80) {
+		return IsASCIIMaskSet(asciiLetterMask, character);
+	}
+	return IsXidStartNonASCII(character);
+}
+
+inline bool IsXidContinue(int character) noexcept {
+	if (static_cast<unsigned>(character) < 0x80) {
+		return IsASCIIMaskSet(asciiIdContinueMask, character);
+	}
+	return IsXidContinueNonASCII(character);
+}
 
 class CharacterCategoryMap final {
 private:
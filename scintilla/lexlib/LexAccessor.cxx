@@ -12,14 +12,85 @@
 #include "ILexer.h"
 #include "Scintilla.h"
 
+#include "VectorISA.h"
 #include "LexAccessor.h"
 #include "CharacterSet.h"
 #include "LexerUtils.h"
 
 using namespace Lexilla;
 
+namespace {
+
+// find first byte which is (or when skip is true, is not) one of delimiters
+template <bool skip>
+Sci_Position FindAnyOfSegment(const char *text, Sci_Position pos, Sci_Position end, const char *delimiters, size_t count) noexcept {
+#if NP2_USE_AVX2
+	while (pos + static_cast<Sci_Position>(sizeof(__m256i)) <= end) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		__m256i match = _mm256_setzero_si256();
+		for (size_t i = 0; i < count; i++) {
+			match = _mm256_or_si256(match, _mm256_cmpeq_epi8(chunk, mm256_set1_epi8(delimiters[i])));
+		}
+		uint32_t mask = mm256_movemask_epi8(match);
+		if constexpr (skip) {
+			mask = ~mask;
+		}
+		if (mask) {
+			return pos + np2_ctz(mask);
+		}
+		pos += sizeof(__m256i);
+	}
+#elif NP2_USE_SSE2
+	while (pos + static_cast<Sci_Position>(sizeof(__m128i)) <= end) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		__m128i match = _mm_setzero_si128();
+		for (size_t i = 0; i < count; i++) {
+			match = _mm_or_si128(match, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(delimiters[i])));
+		}
+		uint32_t mask = mm_movemask_epi8(match);
+		if constexpr (skip) {
+			mask ^= 0xffff;
+		}
+		if (mask) {
+			return pos + np2_ctz(mask);
+		}
+		pos += sizeof(__m128i);
+	}
+#endif
+	while (pos < end && (memchr(delimiters, static_cast<unsigned char>(text[pos]), count) == nullptr) != skip) {
+		++pos;
+	}
+	return pos;
+}
+
+template <bool skip>
+Sci_Position FindAnyOfImpl(LexAccessor &styler, Sci_Position position, Sci_Position limit, const char *delimiters) noexcept {
+	const size_t count = strlen(delimiters);
+	limit = sci::min(limit, styler.Length());
+	while (position < limit) {
+		Sci_Position segmentEnd;
+		const char * const p = styler.TextAt(position, segmentEnd);
+		const Sci_Position end = sci::min(limit, segmentEnd);
+		position = FindAnyOfSegment<skip>(p, position, end, delimiters, count);
+		if (position < end) {
+			return position;
+		}
+	}
+	return limit;
+}
+
+}
+
 namespace Lexilla {
 
+Sci_Position LexAccessor::FindAnyOf(Sci_Position position, Sci_Position limit, const char *delimiters) noexcept {
+	return FindAnyOfImpl<false>(*this, position, limit, delimiters);
+}
+
+Sci_Position LexAccessor::SkipAnyOf(Sci_Position position, Sci_Position limit, const char *chars) noexcept {
+	return FindAnyOfImpl<true>(*this, position, limit, chars);
+}
+
 bool LexAccessor::MatchIgnoreCase(Sci_Position pos, const char *s) noexcept {
 	for (; *s; s++, pos++) {
 		if (*s != MakeLowerCase((*this)[pos])) {
@@ -46,7 +117,7 @@ void LexAccessor::GetRange(Sci_PositionU startPos_, Sci_PositionU endPos_, char
 	//endPos_ = sci::min(endPos_, static_cast<Sci_PositionU>(lenDoc));
 	len = endPos_ - startPos_;
 	if (startPos_ >= static_cast<Sci_PositionU>(startPos) && endPos_ <= static_cast<Sci_PositionU>(endPos)) {
-		const char * const p = buf + (startPos_ - startPos);
+		const char * const p = text + startPos_;
 		memcpy(s, p, len);
 	} else {
 		pAccess->GetCharRange(s, startPos_, len);
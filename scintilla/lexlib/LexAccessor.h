@@ -25,6 +25,8 @@ class LexAccessor {
 		slopSize = bufferSize / 8,
 	};
 	char buf[bufferSize + sizeof(int)];
+	// either text segment of the document or buf, indexed by document position in [startPos, endPos)
+	const char *text;
 	const EncodingType encodingType;
 	Sci_Position startPos = 0;
 	Sci_Position endPos = 0;
@@ -37,6 +39,15 @@ class LexAccessor {
 	Sci_Position startPosStyling = 0;
 
 	void Fill(Sci_Position position) noexcept {
+		if (position >= 0 && position < lenDoc) {
+			// read document text in place, only refilled when crossing the gap or a piece boundary
+			const char * const segment = pAccess->GetTextSegment(position, &startPos, &endPos);
+			if (segment) {
+				text = segment;
+				return;
+			}
+		}
+
 		Sci_Position m = lenDoc - bufferSize;
 		startPos = position - slopSize;
 		startPos = sci::min(startPos, m);
@@ -50,6 +61,7 @@ class LexAccessor {
 #endif
 		pAccess->GetCharRange(buf, startPos, m);
 		buf[m] = '\0';
+		text = buf - startPos;
 	}
 
 	static constexpr EncodingType EncodingTypeForCodePage(int codePage) noexcept {
@@ -59,6 +71,7 @@ class LexAccessor {
 public:
 	explicit LexAccessor(Scintilla::IDocument *pAccess_) noexcept :
 		pAccess(pAccess_),
+		text(buf),
 		//codePage(pAccess->CodePage()),
 		//documentVersion(pAccess->Version()),
 		encodingType(EncodingTypeForCodePage(pAccess->CodePage())),
@@ -73,8 +86,21 @@ public:
 		if (position < startPos || position >= endPos) {
 			Fill(position);
 		}
-		return buf[position - startPos];
+		return text[position];
 	}
+	// Get text indexed by document position for position inside document, segmentEnd is set to end of the contiguous text.
+	const char *TextAt(Sci_Position position, Sci_Position &segmentEnd) noexcept {
+		if (position < startPos || position >= endPos) {
+			Fill(position);
+		}
+		segmentEnd = endPos;
+		return text;
+	}
+	// Find first byte in [position, limit) which is one of ASCII delimiters, returns limit (capped to document length) when not found.
+	// Bytes are scanned without regard of DBCS trail byte.
+	Sci_Position FindAnyOf(Sci_Position position, Sci_Position limit, const char *delimiters) noexcept;
+	// Find first byte in [position, limit) which is not one of ASCII characters, e.g. end of indentation.
+	Sci_Position SkipAnyOf(Sci_Position position, Sci_Position limit, const char *chars) noexcept;
 	constexpr Scintilla::IDocument *MultiByteAccess() const noexcept {
 		return pAccess;
 	}
@@ -103,7 +129,7 @@ public:
 				return '\0';
 			}
 		}
-		return buf[position - startPos];
+		return text[position];
 	}
 	unsigned char SafeGetUCharAt(Sci_Position position) noexcept {
 		return SafeGetCharAt(position);
@@ -118,7 +144,7 @@ public:
 				return chDefault;
 			}
 		}
-		return buf[position - startPos];
+		return text[position];
 	}
 	[[deprecated]]
 	unsigned char SafeGetUCharAt(Sci_Position position, char chDefault) noexcept {
@@ -252,6 +278,9 @@ public:
 	void SetLevelIfDifferent(Sci_Line line, int level) {
 		pAccess->SetLevel(line, level);
 	}
+	void SetLevels(Sci_Line lineStart, Sci_Line count, const int *levels) {
+		pAccess->SetLevels(lineStart, count, levels);
+	}
 	void IndicatorFill(Sci_Position start, Sci_Position end, int indicator, int value) {
 		pAccess->DecorationSetCurrentIndicator(indicator);
 		pAccess->DecorationFillRange(start, value, end - start);
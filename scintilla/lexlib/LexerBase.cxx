@@ -81,7 +81,7 @@ void SCI_METHOD LexerBase::Lex(Sci_PositionU startPos, Sci_Position lengthDoc, i
 }
 
 void SCI_METHOD LexerBase::Fold(Sci_PositionU startPos, Sci_Position lengthDoc, int initStyle, Scintilla::IDocument *pAccess) {
-	if (lexer.fnFolder && props.GetInt("fold")) {
+	if (lexer.fnFolder && props.IsFoldEnabled()) {
 		Sci_Line lineCurrent = pAccess->LineFromPosition(startPos);
 		// Move back one line in case deletion wrecked current line fold state
 		if (lineCurrent != 0) {
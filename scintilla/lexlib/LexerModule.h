@@ -26,17 +26,33 @@ public:
 	LexerFunction const fnFolder;
 	LexerFactoryFunction const fnFactory;
 	const char *const languageName;
+	// number of previous lines whose line state, fold level and style at line end
+	// are enough to restart lexing and folding at a line, zero when lexer looks further back.
+	const int restartLines;
+	// line state bits marking lines that can't be restart point, e.g. line inside embedded script
+	// whose lexing needs nested state or looks back for previous non-white character.
+	const int nestedStateMask;
+	// lexing and folding can restart at any line start, result only depends on text or converges
+	// after restartLines lines, and lexer function has no shared state, so chunks of document
+	// can be lexed concurrently.
+	const bool lineLocal;
 
 	constexpr LexerModule(
 		int language_,
 		LexerFunction fnLexer_,
 		const char *languageName_ = nullptr,
-		LexerFunction fnFolder_ = nullptr) noexcept:
+		LexerFunction fnFolder_ = nullptr,
+		int restartLines_ = 0,
+		int nestedStateMask_ = 0,
+		bool lineLocal_ = false) noexcept:
 		language(language_),
 		fnLexer(fnLexer_),
 		fnFolder(fnFolder_),
 		fnFactory(nullptr),
-		languageName(languageName_) {
+		languageName(languageName_),
+		restartLines(restartLines_),
+		nestedStateMask(nestedStateMask_),
+		lineLocal(lineLocal_) {
 	}
 
 	constexpr LexerModule(
@@ -47,7 +63,10 @@ public:
 		fnLexer(nullptr),
 		fnFolder(nullptr),
 		fnFactory(fnFactory_),
-		languageName(languageName_) {
+		languageName(languageName_),
+		restartLines(0),
+		nestedStateMask(0),
+		lineLocal(false) {
 	}
 
 	constexpr int GetLanguage() const noexcept {
@@ -19,28 +19,33 @@
 
 using namespace Lexilla;
 
+PropSetSimple::PropValue::PropValue(std::string_view val): value(val), intValue(atoi(value.c_str())) {}
+
 bool PropSetSimple::Set(std::string_view key, std::string_view val) {
+	if (key == "fold") {
+		fold = PropValue(val).intValue;
+	}
 #if PropSetSimpleUseMap
 	const auto it = props.find(key);
 	if (it != props.end()) {
-		if (it->second == val) {
+		if (it->second.value == val) {
 			return false;
 		}
-		it->second = val;
+		it->second = PropValue(val);
 	} else {
-		props.emplace(key, val);
+		props.emplace(key, PropValue(val));
 	}
 #else
 	for (auto &it : props) {
 		if (it.first == key) {
-			if (it.second == val) {
+			if (it.second.value == val) {
 				return false;
 			}
-			it.second = val;
+			it.second = PropValue(val);
 			return true;
 		}
 	}
-	props.emplace_back(key, val);
+	props.emplace_back(key, PropValue(val));
 #endif
 	return true;
 }
@@ -49,12 +54,12 @@ const char *PropSetSimple::Get(std::string_view key) const {
 #if PropSetSimpleUseMap
 	const auto it = props.find(key);
 	if (it != props.end()) {
-		return it->second.c_str();
+		return it->second.value.c_str();
 	}
 #else
 	for (const auto &it : props) {
 		if (it.first == key) {
-			return it.second.c_str();
+			return it.second.value.c_str();
 		}
 	}
 #endif
@@ -65,13 +70,13 @@ int PropSetSimple::GetInt(const char *key, size_t keyLen, int defaultValue) cons
 #if PropSetSimpleUseMap
 	const auto it = props.find(std::string_view(key, keyLen));
 	if (it != props.end()) {
-		defaultValue = atoi(it->second.c_str());
+		defaultValue = it->second.intValue;
 	}
 #else
 	const std::string_view sv{key, keyLen};
 	for (const auto &it : props) {
 		if (it.first == sv) {
-			defaultValue = atoi(it.second.c_str());
+			defaultValue = it.second.intValue;
 			break;
 		}
 	}
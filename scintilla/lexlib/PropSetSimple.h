@@ -11,11 +11,18 @@ namespace Lexilla {
 #define PropSetSimpleUseMap		0
 
 class PropSetSimple final {
+	// integer value is parsed once in Set(), lexers query properties on every styling slice
+	struct PropValue {
+		std::string value;
+		int intValue;
+		explicit PropValue(std::string_view val);
+	};
 #if PropSetSimpleUseMap
-	std::map<std::string, std::string, std::less<>> props;
+	std::map<std::string, PropValue, std::less<>> props;
 #else
-	std::vector<std::pair<std::string, std::string>> props;
+	std::vector<std::pair<std::string, PropValue>> props;
 #endif
+	int fold = 0;
 public:
 	bool Set(std::string_view key, std::string_view val);
 	const char *Get(std::string_view key) const;
@@ -25,6 +32,9 @@ public:
 	int GetInt(const char (&key)[N], int defaultValue = 0) const {
 		return GetInt(key, N - 1, defaultValue);
 	}
+	bool IsFoldEnabled() const noexcept {
+		return fold & true;
+	}
 };
 
 }
@@ -24,6 +24,22 @@ private:
 	Sci_Position offsetRelative = 0;
 #endif
 
+	// position of the character for which atLineEnd is true, capped to end of styling range.
+	Sci_PositionU LineLimit() const noexcept {
+		return sci::min<Sci_PositionU>(endPos, lineStartNext - (currentLine < lineDocEnd));
+	}
+	static bool IsDelimiter(int chTest, const char *delimiters) noexcept {
+		return chTest != 0 && chTest < 0x80 && strchr(delimiters, chTest) != nullptr;
+	}
+	// single byte only, move forward to pos inside current line.
+	void SkipTo(Sci_PositionU pos) noexcept {
+		if (pos > currentPos) {
+			atLineStart = false;
+			SeekTo(pos);
+			chPrev = static_cast<unsigned char>(styler[pos - 1]);
+		}
+	}
+
 	void GetNextChar() noexcept {
 		if (!multiByteAccess) {
 			chNext = styler.SafeGetUCharAt(currentPos + 1);
@@ -271,6 +287,60 @@ public:
 		}
 	}
 
+	// Bulk advance inside current line for body of comment, string, etc.
+	// Characters after current one are skipped without visiting until the one before
+	// first stop character or line end, following Forward() will visit the stop character.
+	// DBCS document falls back to Forward() as trail byte can be ASCII.
+	void AdvanceBefore(const char *delimiters) noexcept {
+		const Sci_PositionU limit = LineLimit();
+		if (currentPos + 1 < limit) {
+			if (multiByteAccess) {
+				while (currentPos + width < limit && !IsDelimiter(chNext, delimiters)) {
+					Forward();
+				}
+			} else {
+				SkipTo(styler.FindAnyOf(currentPos + 1, limit, delimiters) - 1);
+			}
+		}
+	}
+	void AdvanceBeforeLineEnd() noexcept {
+		const Sci_PositionU limit = LineLimit();
+		if (currentPos + 1 < limit) {
+			if (multiByteAccess) {
+				while (currentPos + width < limit) {
+					Forward();
+				}
+			} else {
+				SkipTo(limit - 1);
+			}
+		}
+	}
+	template <typename Predicate>
+	void AdvanceWhile(Predicate predicate) noexcept {
+		const Sci_PositionU limit = LineLimit();
+		if (currentPos + 1 < limit) {
+			if (multiByteAccess) {
+				while (currentPos + width < limit && predicate(chNext)) {
+					Forward();
+				}
+			} else {
+				Sci_PositionU pos = currentPos + 1;
+				do {
+					Sci_Position segmentEnd;
+					const char * const text = styler.TextAt(pos, segmentEnd);
+					const Sci_PositionU end = sci::min<Sci_PositionU>(limit, segmentEnd);
+					while (pos < end && predicate(static_cast<unsigned char>(text[pos]))) {
+						++pos;
+					}
+					if (pos < end) {
+						break;
+					}
+				} while (pos < limit);
+				SkipTo(pos - 1);
+			}
+		}
+	}
+
 	bool LineEndsWith(char ch0) const noexcept {
 		return chPrev == static_cast<unsigned char>(ch0)
 			|| (chPrev == '\r' && ch == '\n' && currentPos >= 2 && ch0 == styler[currentPos - 2]);
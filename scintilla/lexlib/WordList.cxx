@@ -98,6 +98,16 @@ inline char **ArrayFromWordList(char *wordlist, size_t slen, range_t *len) {
  */
 constexpr range_t WordListLinearSearchThreshold = 5;
 
+// FNV-1a hash
+inline uint32_t HashWord(const char *s) noexcept {
+	uint32_t hash = 2166136261U;
+	while (*s) {
+		hash = (hash ^ static_cast<unsigned char>(*s)) * 16777619U;
+		++s;
+	}
+	return hash;
+}
+
 // words in [start, end) starts with same character, maximum word count limited to 0xffff.
 struct Range {
 	range_t start;
@@ -136,8 +146,11 @@ void WordList::Clear() noexcept {
 	if (words) {
 		delete[]words;
 		delete[]list;
+		delete[]table;
 		words = nullptr;
 		list = nullptr;
+		table = nullptr;
+		tableMask = 0;
 		//len = 0;
 	}
 }
@@ -186,6 +199,28 @@ bool WordList::Set(const char *s, KeywordAttr attribute) {
 		assert(static_cast<unsigned>(indexChar - MinIndexChar) < std::size(ranges));
 		ranges[indexChar - MinIndexChar] = start | (i << 16);
 	}
+
+	// hash exact words for InList(), keep load factor below half to make probe sequence short.
+	if (len != 0) {
+		range_t size = 8;
+		while (size < 2*len) {
+			size <<= 1;
+		}
+		table = new range_t[2*size]();
+		tableMask = size - 1;
+		for (range_t i = 0; i < len; i++) {
+			const char *word = words[i];
+			if (*word != '^') {
+				const uint32_t hash = HashWord(word);
+				range_t slot = hash & tableMask;
+				while (table[2*slot + 1] != 0) {
+					slot = (slot + 1) & tableMask;
+				}
+				table[2*slot] = hash;
+				table[2*slot + 1] = i + 1;
+			}
+		}
+	}
 	return true;
 }
 
@@ -202,47 +237,19 @@ bool WordList::InList(const char *s) const noexcept {
 	if (index > std::size(ranges) - 1) {
 		return false;
 	}
-	range_t end = ranges[index];
-	if (end) {
-		Range range(end);
-		range_t count = range.Length();
-		if (count < WordListLinearSearchThreshold) {
-			do {
-				const char *a = words[range.start] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				if (!*a && !*b) {
-					return true;
-				}
-			} while (range.Next());
-		} else {
-			do {
-				const range_t step = count >> 1;
-				const range_t mid = range.start + step;
-				const char *a = words[mid] + 1;
-				const char *b = s + 1;
-				while (*a && *a == *b) {
-					a++;
-					b++;
-				}
-				const int diff = static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
-				if (diff == 0) {
-					return true;
-				}
-				if (diff < 0) {
-					range.start = mid + 1;
-					count -= step + 1;
-				} else {
-					count = step;
-				}
-			} while (count != 0);
+	if (ranges[index]) {
+		const uint32_t hash = HashWord(s);
+		range_t slot = hash & tableMask;
+		range_t entry;
+		while ((entry = table[2*slot + 1]) != 0) {
+			if (table[2*slot] == hash && strcmp(words[entry - 1], s) == 0) {
+				return true;
+			}
+			slot = (slot + 1) & tableMask;
 		}
 	}
 
-	end = ranges[static_cast<unsigned char>('^') - MinIndexChar];
+	const range_t end = ranges[static_cast<unsigned char>('^') - MinIndexChar];
 	if (end) {
 		Range range(end);
 		do {
@@ -25,6 +25,9 @@ private:
 	// Each word contains at least one character - an empty word acts as sentinel at the end.
 	char **words = nullptr;
 	char *list = nullptr;
+	// open addressing hash table for exact words, each slot is pair of hash and word index + 1.
+	range_t *table = nullptr;
+	range_t tableMask = 0;
 	//range_t len = 0;
 #if 1
 	// ASCII graphic character only, most word starts with character in '_a-zA-Z'
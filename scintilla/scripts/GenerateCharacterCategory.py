@@ -419,7 +419,7 @@ def updateCharacterCategoryTable(filename):
 
 	config = {
 		'tableName': 'catTable',
-		'function': """CharacterCategory CategoriseCharacter(int character) noexcept {
+		'function': """CharacterCategory CategoriseCharacterNonASCII(int character) noexcept {
 	if (character < 0 || character > maxUnicode) {
 		return ccCn;
 	}""",
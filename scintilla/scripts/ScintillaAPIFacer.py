@@ -23,12 +23,18 @@ typeAliases = {
 	"int": "int",
 	"keymod": "int",
 	"line": "Line",
+	"paintstatistics": "PaintStatistics *",
 	"pointer": "void *",
 	"position": "Position",
 	"string": "const char *",
+	"stylerecords": "StyleRecord *",
+	"commandrecords": "CommandRecord *",
+	"annotationrecords": "const AnnotationRecord *",
 	"stringresult": "char *",
 	"textrange": "const TextRangeFull *",
 	"textrangefull": "const TextRangeFull *",
+	"textsegments": "TextSegments *",
+	"textstatistics": "TextStatistics *",
 }
 
 basicTypes = [
@@ -147,9 +147,12 @@ void FillSortMatrix(std::vector<int> &sortMatrix, unsigned itemCount) {
 }
 
 void AutoComplete::SetList(const char *list) {
+	filterWord.clear();
 	if (autoSort == Ordering::PreSorted) {
 		lb->SetList(list, separator, typesep);
 		FillSortMatrix(sortMatrix, lb->Length());
+		filterFirst = 0;
+		filterCount = lb->Length();
 		return;
 	}
 
@@ -159,6 +162,8 @@ void AutoComplete::SetList(const char *list) {
 	if (autoSort == Ordering::Custom || sortMatrix.size() < 2) {
 		lb->SetList(list, separator, typesep);
 		PLATFORM_ASSERT(lb->Length() == static_cast<int>(sortMatrix.size()));
+		filterFirst = 0;
+		filterCount = lb->Length();
 		return;
 	}
 
@@ -187,6 +192,8 @@ void AutoComplete::SetList(const char *list) {
 	}
 	*back = '\0';
 	lb->SetList(sortedList.get(), separator, typesep);
+	filterFirst = 0;
+	filterCount = lb->Length();
 }
 
 int AutoComplete::GetSelection() const noexcept {
@@ -212,17 +219,89 @@ void AutoComplete::Cancel() noexcept {
 }
 
 void AutoComplete::Move(int delta) const {
-	const int count = lb->Length();
+	const int last = filterFirst + filterCount - 1;
 	int current = lb->GetSelection();
 	current += delta;
-	if (current >= count)
-		current = count - 1;
-	if (current < 0)
-		current = 0;
+	if (current > last)
+		current = last;
+	if (current < filterFirst)
+		current = filterFirst;
 	lb->Select(current);
 }
 
+void AutoComplete::Filter(const char *word) {
+	const size_t lenWord = strlen(word);
+	const auto compare = [this, word, lenWord](int index) {
+		const std::string item = lb->GetValue(index);
+		return ignoreCase ? CompareNCaseInsensitive(word, item.c_str(), lenWord) : strncmp(word, item.c_str(), lenWord);
+	};
+
+	// when word is extended, matched items are inside previous range
+	int start = 0;
+	int limit = lb->Length();
+	if (!filterWord.empty() && lenWord >= filterWord.length() && memcmp(word, filterWord.data(), filterWord.length()) == 0) {
+		start = filterFirst;
+		limit = filterFirst + filterCount;
+	}
+	// items are sorted, find the first item starting with word
+	int end = limit;
+	while (start < end) {
+		const int pivot = (start + end) / 2;
+		if (compare(pivot) > 0) {
+			start = pivot + 1;
+		} else {
+			end = pivot;
+		}
+	}
+	const int first = start;
+	end = limit;
+	// then the first item after them
+	while (start < end) {
+		const int pivot = (start + end) / 2;
+		if (compare(pivot) == 0) {
+			start = pivot + 1;
+		} else {
+			end = pivot;
+		}
+	}
+	const int last = start;
+
+	if (first == last) {
+		filterWord.clear();
+		filterFirst = 0;
+		filterCount = lb->Length();
+		if (autoHide) {
+			Cancel();
+		} else {
+			lb->SetItemRange(filterFirst, filterCount);
+			lb->Select(-1);
+		}
+		return;
+	}
+
+	filterWord = word;
+	filterFirst = first;
+	filterCount = last - first;
+	lb->SetItemRange(first, filterCount);
+	int location = first;
+	if (ignoreCase && ignoreCaseBehaviour == CaseInsensitiveBehaviour::RespectCase) {
+		// Check for exact-case match
+		for (int i = first; i < last; i++) {
+			const std::string item = lb->GetValue(i);
+			if (!strncmp(word, item.c_str(), lenWord)) {
+				location = i;
+				break;
+			}
+		}
+	}
+	lb->Select(location);
+}
+
 void AutoComplete::Select(const char *word) {
+	if (FlagSet(options, AutoCompleteOption::FilterList) && autoSort != Ordering::Custom) {
+		Filter(word);
+		return;
+	}
 	const size_t lenWord = strlen(word);
 	int location = -1;
 	int start = 0; // lower bound of the api array block to search
@@ -17,6 +17,12 @@ class AutoComplete {
 	std::string stopChars;
 	std::string fillUpChars;
 	std::vector<int> sortMatrix;
+	// items starting with filterWord, used by AutoCompleteOption::FilterList
+	int filterFirst = 0;
+	int filterCount = 0;
+	std::string filterWord;
+
+	void Filter(const char *word);
 
 public:
 
@@ -0,0 +1,697 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+/** @file BackgroundStyler.cxx
+ ** Lex chunks of document on a worker thread against a copy of the text.
+ **/
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <forward_list>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "ParallelSupport.h"
+
+#include "ScintillaTypes.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+
+#include "CharacterSet.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "UniConversion.h"
+#include "BackgroundStyler.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace {
+
+// bytes styled by one chunk, extended to end of line
+constexpr Sci::Position ChunkSize = 1024*1024;
+// lines and bytes before chunk for backtracking, and bytes after chunk for LexAccessor buffer
+constexpr Sci::Line LookbackLines = 256;
+constexpr Sci::Position LookbackBytes = 64*1024;
+constexpr Sci::Position LookaheadBytes = 64*1024;
+// maximum number of chunks lexed concurrently for line-local lexer
+constexpr uint32_t MaxParallelChunks = 16;
+
+constexpr Sci::Position NextTab(Sci::Position pos, Sci::Position tabSize) noexcept {
+	return ((pos / tabSize) + 1) * tabSize;
+}
+
+struct IndicatorFill {
+	int indicator;
+	int value;
+	Sci::Position position;
+	Sci::Position fillLength;
+};
+
+}
+
+namespace Scintilla::Internal {
+
+// IDocument over text in [windowStart, windowEnd) and data of lines in [lineFirst, lineLast],
+// reading or writing outside it sets failed, as the result may differ from styling the document.
+class StylingSnapshot final : public IDocument {
+public:
+	ILexer5 *instance = nullptr;
+	Sci::Position startPos = 0;
+	Sci::Position lengthLex = 0;
+	Sci::Position boundary = 0;	// end of previous chunk, lexing starts before it to converge
+	int initStyle = 0;
+	bool failed = false;
+
+	Sci::Position lengthDocument = 0;
+	Sci::Line linesTotal = 0;
+	Sci::Position windowStart = 0;
+	Sci::Position windowEnd = 0;
+	Sci::Line lineFirst = 0;
+	Sci::Line lineLast = 0;
+	std::unique_ptr<char[]> text;
+	std::unique_ptr<unsigned char[]> styles;
+	// [lineFirst, lineLast + 1]
+	std::vector<Sci::Position> lineStarts;
+	std::vector<int> lineStates;
+	std::vector<int> levels;
+	// [lineFirst, lineLast]
+	std::vector<Sci::Position> lineEnds;
+
+	int codePage = 0;
+	int tabInChars = 8;
+	CharacterClass charClass[256]{};
+
+	Sci::Position endStyled = 0;
+	Sci::Position styledStart = PTRDIFF_MAX;
+	Sci::Position styledEnd = 0;
+	int currentIndicator = 0;
+	int errorStatus = 0;
+	std::vector<IndicatorFill> fills;
+	std::vector<Sci::Position> lexerStates;	// start, end pairs
+
+	StylingSnapshot() noexcept = default;
+
+	void Lex() noexcept {
+		try {
+			instance->Lex(startPos, lengthLex, initStyle, this);
+			instance->Fold(startPos, lengthLex, initStyle, this);
+		} catch (...) {
+			failed = true;
+		}
+	}
+
+	bool InWindow(Sci::Position position, Sci::Position length) const noexcept {
+		return position >= windowStart && position + length <= windowEnd;
+	}
+	bool InLines(Sci::Line line) const noexcept {
+		return line >= lineFirst && line <= lineLast + 1;
+	}
+
+	unsigned char UCharAt(Sci::Position position) noexcept {
+		if (position >= windowStart && position < windowEnd) {
+			return text[position - windowStart];
+		}
+		if (IsValidIndex(position, lengthDocument)) {
+			failed = true;
+		}
+		return 0;
+	}
+
+	bool SetStyled(Sci::Position length) noexcept {
+		if (length <= 0) {
+			return false;
+		}
+		if (!InWindow(endStyled, length)) {
+			failed = true;
+			return false;
+		}
+		styledStart = std::min(styledStart, endStyled);
+		endStyled += length;
+		styledEnd = std::max(styledEnd, endStyled);
+		return true;
+	}
+
+	Sci::Position NextPosition(Sci::Position pos, int moveDir) noexcept {
+		if (pos + moveDir <= 0) {
+			return 0;
+		}
+		if (pos + moveDir >= lengthDocument) {
+			return lengthDocument;
+		}
+		if (moveDir > 0) {
+			Sci_Position width = 1;
+			GetCharacterAndWidth(pos, &width);
+			return pos + width;
+		}
+		pos--;
+		if (UTF8IsTrailByte(UCharAt(pos))) {
+			// same as Document::InGoodUTF8()
+			Sci::Position trail = pos;
+			while ((trail > 0) && (pos - trail < UTF8MaxBytes) && UTF8IsTrailByte(UCharAt(trail - 1))) {
+				trail--;
+			}
+			const Sci::Position start = (trail > 0) ? trail - 1 : trail;
+			Sci_Position width = 1;
+			GetCharacterAndWidth(start, &width);
+			if (width > pos - start) {
+				pos = start;
+			}
+		}
+		return pos;
+	}
+
+	int SCI_METHOD Version() const noexcept override {
+		return dvRelease4;
+	}
+
+	void SCI_METHOD SetErrorStatus(int status) noexcept override {
+		errorStatus = status;
+	}
+
+	Sci_Position SCI_METHOD Length() const noexcept override {
+		return lengthDocument;
+	}
+
+	void SCI_METHOD GetCharRange(char *buffer, Sci_Position position, Sci_Position lengthRetrieve) const noexcept override {
+		if (InWindow(position, lengthRetrieve)) {
+			memcpy(buffer, text.get() + position - windowStart, lengthRetrieve);
+		} else {
+			StylingSnapshot *self = const_cast<StylingSnapshot *>(this);
+			for (Sci_Position i = 0; i < lengthRetrieve; i++) {
+				buffer[i] = self->UCharAt(position + i);
+			}
+		}
+	}
+
+	unsigned char SCI_METHOD StyleAt(Sci_Position position) const noexcept override {
+		if (position >= windowStart && position < windowEnd) {
+			return styles[position - windowStart];
+		}
+		if (IsValidIndex(position, lengthDocument)) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+		}
+		return 0;
+	}
+
+	Sci_Line SCI_METHOD LineFromPosition(Sci_Position position) const noexcept override {
+		if (position <= 0) {
+			return 0;
+		}
+		if (position >= lengthDocument) {
+			return linesTotal - 1;
+		}
+		if (position < windowStart || position > windowEnd) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+			return (position < windowStart) ? lineFirst : lineLast;
+		}
+		const auto first = lineStarts.begin();
+		const auto last = first + (lineLast - lineFirst + 1);
+		return lineFirst + (std::upper_bound(first, last, position) - first) - 1;
+	}
+
+	Sci_Position SCI_METHOD LineStart(Sci_Line line) const noexcept override {
+		if (line < 0) {
+			return 0;
+		}
+		if (line >= linesTotal) {
+			return lengthDocument;
+		}
+		if (!InLines(line)) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+			return (line < lineFirst) ? windowStart : windowEnd;
+		}
+		return lineStarts[line - lineFirst];
+	}
+
+	int SCI_METHOD GetLevel(Sci_Line line) const noexcept override {
+		if (InLines(line)) {
+			return levels[line - lineFirst];
+		}
+		if (IsValidIndex(line, linesTotal)) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+		}
+		return static_cast<int>(FoldLevel::Base);
+	}
+
+	int SCI_METHOD SetLevel(Sci_Line line, int level) override {
+		if (!IsValidIndex(line, linesTotal)) {
+			return level;
+		}
+		if (!InLines(line)) {
+			failed = true;
+			return level;
+		}
+		const int prev = levels[line - lineFirst];
+		levels[line - lineFirst] = level;
+		return prev;
+	}
+
+	void SCI_METHOD SetLevels(Sci_Line lineStart, Sci_Line count, const int *levels_) override {
+		count = std::min(count, linesTotal - lineStart);
+		if (count <= 0) {
+			return;
+		}
+		if (!InLines(lineStart) || !InLines(lineStart + count - 1)) {
+			failed = true;
+			return;
+		}
+		memcpy(levels.data() + (lineStart - lineFirst), levels_, count*sizeof(int));
+	}
+
+	int SCI_METHOD GetLineState(Sci_Line line) const noexcept override {
+		if (InLines(line)) {
+			return lineStates[line - lineFirst];
+		}
+		if (IsValidIndex(line, linesTotal)) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+		}
+		return 0;
+	}
+
+	int SCI_METHOD SetLineState(Sci_Line line, int state) override {
+		if (!IsValidIndex(line, linesTotal)) {
+			return state;
+		}
+		if (!InLines(line)) {
+			failed = true;
+			return state;
+		}
+		const int prev = lineStates[line - lineFirst];
+		lineStates[line - lineFirst] = state;
+		return prev;
+	}
+
+	void SCI_METHOD StartStyling(Sci_Position position) noexcept override {
+		endStyled = position;
+	}
+
+	bool SCI_METHOD SetStyleFor(Sci_Position length, unsigned char style) override {
+		const Sci::Position position = endStyled;
+		if (!SetStyled(length)) {
+			return false;
+		}
+		memset(styles.get() + position - windowStart, style, length);
+		return true;
+	}
+
+	bool SCI_METHOD SetStyles(Sci_Position length, const unsigned char *styles_) override {
+		const Sci::Position position = endStyled;
+		if (!SetStyled(length)) {
+			return false;
+		}
+		memcpy(styles.get() + position - windowStart, styles_, length);
+		return true;
+	}
+
+	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) noexcept override {
+		currentIndicator = indicator;
+	}
+
+	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override {
+		fills.push_back({ currentIndicator, value, position, fillLength });
+	}
+
+	void SCI_METHOD ChangeLexerState(Sci_Position start, Sci_Position end) override {
+		lexerStates.push_back(start);
+		lexerStates.push_back(end);
+	}
+
+	int SCI_METHOD CodePage() const noexcept override {
+		return codePage;
+	}
+
+	bool SCI_METHOD IsDBCSLeadByte([[maybe_unused]] unsigned char ch) const noexcept override {
+		// only single byte code page and UTF-8 are styled in background
+		return false;
+	}
+
+	const char * SCI_METHOD BufferPointer() noexcept override {
+		failed = true;
+		return text.get();
+	}
+
+	int SCI_METHOD GetLineIndentation(Sci_Line line) const noexcept override {
+		int indent = 0;
+		if (IsValidIndex(line, linesTotal)) {
+			StylingSnapshot *self = const_cast<StylingSnapshot *>(this);
+			for (Sci::Position i = LineStart(line); i < lengthDocument; i++) {
+				const char ch = self->UCharAt(i);
+				if (ch == ' ')
+					indent++;
+				else if (ch == '\t')
+					indent = static_cast<int>(NextTab(indent, tabInChars));
+				else
+					return indent;
+			}
+		}
+		return indent;
+	}
+
+	Sci_Position SCI_METHOD LineEnd(Sci_Line line) const noexcept override {
+		if (line < 0) {
+			return 0;
+		}
+		if (line >= linesTotal - 1) {
+			return lengthDocument;
+		}
+		if (line < lineFirst || line > lineLast) {
+			const_cast<StylingSnapshot *>(this)->failed = true;
+			return (line < lineFirst) ? windowStart : windowEnd;
+		}
+		return lineEnds[line - lineFirst];
+	}
+
+	Sci_Position SCI_METHOD GetRelativePosition(Sci_Position positionStart, Sci_Position characterOffset) const noexcept override {
+		Sci::Position pos = positionStart;
+		if (codePage) {
+			StylingSnapshot *self = const_cast<StylingSnapshot *>(this);
+			const int increment = (characterOffset > 0) ? 1 : -1;
+			while (characterOffset != 0) {
+				const Sci::Position posNext = self->NextPosition(pos, increment);
+				if (posNext == pos)
+					return Sci::invalidPosition;
+				pos = posNext;
+				characterOffset -= increment;
+			}
+		} else {
+			pos = positionStart + characterOffset;
+			if (!IsValidIndex(pos, lengthDocument))
+				return Sci::invalidPosition;
+		}
+		return pos;
+	}
+
+	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept override {
+		StylingSnapshot *self = const_cast<StylingSnapshot *>(this);
+		int bytesInCharacter = 1;
+		const unsigned char leadByte = self->UCharAt(position);
+		int character = leadByte;
+		if (!UTF8IsAscii(leadByte) && codePage) {
+			const int widthCharBytes = UTF8BytesOfLead(leadByte);
+			unsigned char charBytes[UTF8MaxBytes] = { leadByte, 0, 0, 0 };
+			for (int b = 1; b < widthCharBytes; b++) {
+				charBytes[b] = self->UCharAt(position + b);
+			}
+			const int utf8status = UTF8ClassifyMulti(charBytes, widthCharBytes);
+			if (utf8status & UTF8MaskInvalid) {
+				// Report as singleton surrogate values which are invalid Unicode
+				character = 0xDC80 + character;
+			} else {
+				bytesInCharacter = utf8status & UTF8MaskWidth;
+				character = UnicodeFromUTF8(charBytes);
+			}
+		}
+		if (pWidth) {
+			*pWidth = bytesInCharacter;
+		}
+		return character;
+	}
+
+	CharacterClass SCI_METHOD GetCharacterClass(unsigned int character) const noexcept override {
+		if (character < 256) {
+			return charClass[character];
+		}
+		if (codePage) {
+			return CharClassify::ClassifyCharacter(character);
+		}
+		return charClass[character & 0xff];
+	}
+
+	const char * SCI_METHOD GetTextSegment(Sci_Position position, Sci_Position *pStart, Sci_Position *pEnd) const noexcept override {
+		if (position >= windowStart && position < windowEnd) {
+			*pStart = windowStart;
+			*pEnd = windowEnd;
+			return text.get() - windowStart;
+		}
+		// let caller copy text through GetCharRange(), which marks the failure
+		return nullptr;
+	}
+};
+
+}
+
+BackgroundStyler::BackgroundStyler(Document *pdoc_) noexcept : pdoc{pdoc_} {
+	eventFinished = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (eventFinished) {
+		work = CreateThreadpoolWork(WorkCallback, this, nullptr);
+	}
+}
+
+BackgroundStyler::~BackgroundStyler() {
+	Stop();
+	if (work) {
+		CloseThreadpoolWork(work);
+	}
+	if (eventFinished) {
+		CloseHandle(eventFinished);
+	}
+}
+
+VOID CALLBACK BackgroundStyler::WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
+	BackgroundStyler *styler = static_cast<BackgroundStyler *>(context);
+	{
+		std::optional<BackgroundWorkScope> scope;
+		if (!styler->foreground) {
+			scope.emplace();
+		}
+		const size_t index = styler->nextChunk.fetch_add(1, std::memory_order_relaxed);
+		styler->snapshots[index]->Lex();
+	}
+	if (styler->pendingChunks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		SetEvent(styler->eventFinished);
+	}
+}
+
+// copy text and line data around [lexStart, end) to lex the chunk [start, end).
+std::unique_ptr<StylingSnapshot> BackgroundStyler::Snapshot(ILexer5 *instance, Sci::Position start, Sci::Position end, Sci::Position lexStart) const {
+	const Sci::Position lengthDocument = pdoc->LengthNoExcept();
+	std::unique_ptr<StylingSnapshot> snap = std::make_unique<StylingSnapshot>();
+	snap->instance = instance;
+	snap->startPos = lexStart;
+	snap->lengthLex = end - lexStart;
+	snap->boundary = start;
+	snap->initStyle = (lexStart > 0) ? pdoc->StyleIndexAt(lexStart - 1) : 0;
+	snap->endStyled = lexStart;
+	snap->lengthDocument = lengthDocument;
+	snap->linesTotal = pdoc->LinesTotal();
+
+	const Sci::Line lineStart = pdoc->SciLineFromPosition(lexStart);
+	Sci::Line lineFirst = std::max(lineStart - LookbackLines, pdoc->SciLineFromPosition(lexStart - LookbackBytes));
+	if (lineFirst < lineStart && pdoc->LineStart(lineFirst) < lexStart - LookbackBytes) {
+		lineFirst++;
+	}
+	const Sci::Position windowStart = pdoc->LineStart(lineFirst);
+	const Sci::Position windowEnd = std::min(lengthDocument, end + LookaheadBytes);
+	const Sci::Line lineLast = pdoc->SciLineFromPosition(windowEnd);
+	snap->windowStart = windowStart;
+	snap->windowEnd = windowEnd;
+	snap->lineFirst = lineFirst;
+	snap->lineLast = lineLast;
+
+	const Sci::Position lengthWindow = windowEnd - windowStart;
+	snap->text = std::make_unique<char[]>(lengthWindow);
+	snap->styles = std::make_unique<unsigned char[]>(lengthWindow);
+	pdoc->GetCharRange(snap->text.get(), windowStart, lengthWindow);
+	pdoc->GetStyleRange(snap->styles.get(), windowStart, lengthWindow);
+
+	const size_t lineCount = lineLast - lineFirst + 1;
+	snap->lineStarts.resize(lineCount + 1);
+	snap->lineStates.resize(lineCount + 1);
+	snap->levels.resize(lineCount + 1);
+	snap->lineEnds.resize(lineCount);
+	for (size_t i = 0; i <= lineCount; i++) {
+		const Sci::Line line = lineFirst + i;
+		snap->lineStarts[i] = pdoc->LineStart(line);
+		snap->lineStates[i] = pdoc->GetLineState(line);
+		snap->levels[i] = pdoc->GetLevel(line);
+		if (i < lineCount) {
+			snap->lineEnds[i] = pdoc->LineEnd(line);
+		}
+	}
+
+	snap->codePage = pdoc->dbcsCodePage;
+	snap->tabInChars = pdoc->tabInChars;
+	for (unsigned int ch = 0; ch < 256; ch++) {
+		snap->charClass[ch] = pdoc->GetCharacterClass(ch);
+	}
+	return snap;
+}
+
+// copy text and line data around [start, end) then lex it on worker, returns false when failed to start.
+// range of line-local lexer is split into chunks lexed concurrently.
+bool BackgroundStyler::Start(ILexer5 *instance, Sci::Position start, Sci::Position end, bool lineLocal, int restartLines_, int nestedStateMask_) {
+	if (work == nullptr || running) {
+		return false;
+	}
+	snapshots.clear();
+	restartLines = restartLines_;
+	nestedStateMask = nestedStateMask_;
+	const uint32_t maxChunks = lineLocal ? std::min(GetHardwareConcurrency(), MaxParallelChunks) : 1;
+	Sci::Position lexStart = start;
+	while (start < end && snapshots.size() < maxChunks) {
+		Sci::Position chunkEnd = end;
+		if (start + ChunkSize < end) {
+			chunkEnd = std::min(end, pdoc->LineStart(pdoc->SciLineFromPosition(start + ChunkSize) + 1));
+		}
+		snapshots.push_back(Snapshot(instance, start, chunkEnd, lexStart));
+		start = chunkEnd;
+		if (restartLines != 0 && start < end) {
+			// restart some lines before next chunk, its data should converge with current chunk
+			const Sci::Line lineBoundary = pdoc->SciLineFromPosition(start);
+			const Sci::Line lineStart = std::max(lineBoundary - LookbackLines, pdoc->SciLineFromPosition(start - LookbackBytes) + 1);
+			lexStart = pdoc->LineStart(std::min(lineStart, lineBoundary));
+		} else {
+			lexStart = start;
+		}
+	}
+	if (snapshots.empty()) {
+		return false;
+	}
+
+	endStyled = pdoc->GetEndStyled();
+	modifiedAt = PTRDIFF_MAX;
+	running = true;
+	nextChunk.store(0, std::memory_order_relaxed);
+	pendingChunks.store(snapshots.size(), std::memory_order_relaxed);
+	for (size_t i = 0; i < snapshots.size(); i++) {
+		SubmitThreadpoolWork(work);
+	}
+	return true;
+}
+
+// wait for worker while UI input is not available, returns true when worker finished.
+bool BackgroundStyler::Wait(DWORD milliseconds) noexcept {
+	if (running) {
+		const DWORD result = MsgWaitForMultipleObjectsEx(1, &eventFinished, milliseconds, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		if (result != WAIT_OBJECT_0) {
+			return false;
+		}
+		Join();
+	}
+	return true;
+}
+
+// wait for worker to release the lexer, finished chunk can still be committed.
+void BackgroundStyler::Join() noexcept {
+	if (running) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		ResetEvent(eventFinished);
+		running = false;
+	}
+}
+
+void BackgroundStyler::Stop() noexcept {
+	Join();
+	snapshots.clear();
+}
+
+// find first line of chunk whose data is the same as lexed from the document, or -1 when not converged.
+Sci::Line BackgroundStyler::ConvergedLine(const StylingSnapshot &snap) const noexcept {
+	const Sci::Line lineBoundary = pdoc->SciLineFromPosition(snap.boundary);
+	if (restartLines == 0) {
+		return lineBoundary;
+	}
+	// line before boundary is restyled, as its data may depend on following line
+	int matched = 0;
+	for (Sci::Line line = pdoc->SciLineFromPosition(snap.startPos); line + 1 < lineBoundary; line++) {
+		const size_t index = line - snap.lineFirst;
+		const Sci::Position lineEnd = pdoc->LineStart(line + 1) - 1;
+		const int lineState = pdoc->GetLineState(line);
+		if ((lineState & nestedStateMask) == 0 && lineState == snap.lineStates[index]
+			&& pdoc->GetLevel(line) == snap.levels[index]
+			&& pdoc->StyleIndexAt(lineEnd) == snap.styles[lineEnd - snap.windowStart]) {
+			matched++;
+			if (matched >= restartLines) {
+				return line + 1;
+			}
+		} else {
+			matched = 0;
+		}
+	}
+	return -1;
+}
+
+void BackgroundStyler::CommitSnapshot(const StylingSnapshot &snap, Sci::Line lineCommit) {
+	const Sci::Position posCommit = pdoc->LineStart(lineCommit);
+	const Sci::Position styledStart = std::max(snap.styledStart, posCommit);
+	if (styledStart < snap.styledEnd) {
+		pdoc->StartStyling(styledStart);
+		pdoc->SetStyles(snap.styledEnd - styledStart, snap.styles.get() + styledStart - snap.windowStart);
+	}
+	const Sci::Line lineEnd = std::min(snap.lineLast + 1, pdoc->LinesTotal());
+	for (Sci::Line line = std::max(snap.lineFirst, lineCommit); line < lineEnd; line++) {
+		const size_t index = line - snap.lineFirst;
+		if (snap.lineStates[index] != pdoc->GetLineState(line)) {
+			pdoc->SetLineState(line, snap.lineStates[index]);
+		}
+		if (snap.levels[index] != pdoc->GetLevel(line)) {
+			pdoc->SetLevel(line, snap.levels[index]);
+		}
+	}
+	for (const IndicatorFill &fill : snap.fills) {
+		const Sci::Position position = std::max(fill.position, posCommit);
+		if (position < fill.position + fill.fillLength) {
+			pdoc->DecorationSetCurrentIndicator(fill.indicator);
+			pdoc->DecorationFillRange(position, fill.value, fill.position + fill.fillLength - position);
+		}
+	}
+	for (size_t i = 0; i < snap.lexerStates.size(); i += 2) {
+		pdoc->ChangeLexerState(snap.lexerStates[i], snap.lexerStates[i + 1]);
+	}
+	if (snap.errorStatus) {
+		pdoc->SetErrorStatus(snap.errorStatus);
+	}
+}
+
+// apply finished chunks to document in order, returns false when first chunk was discarded as it's outdated or failed.
+// following chunks are discarded when they failed or not converged with previous chunk.
+bool BackgroundStyler::Commit(Sci::Position &start, Sci::Position &length) {
+	const std::vector<std::unique_ptr<StylingSnapshot>> snaps = std::move(snapshots);
+	snapshots.clear();
+	if (snaps.empty()) {
+		return false;
+	}
+	failed = snaps[0]->failed;
+	if (failed || pdoc->GetEndStyled() != endStyled) {
+		return false;
+	}
+
+	start = snaps[0]->startPos;
+	length = 0;
+	for (size_t i = 0; i < snaps.size(); i++) {
+		const StylingSnapshot &snap = *snaps[i];
+		if (snap.failed || modifiedAt <= snap.windowEnd) {
+			break;
+		}
+		const Sci::Line lineCommit = (i == 0) ? snap.lineFirst : ConvergedLine(snap);
+		if (lineCommit < 0) {
+			break;
+		}
+		if (i == 0) {
+			pdoc->IncrementStyleClock();
+		}
+		CommitSnapshot(snap, lineCommit);
+		length = snap.startPos + snap.lengthLex - start;
+	}
+	return length != 0;
+}
@@ -0,0 +1,67 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Scintilla::Internal {
+
+class StylingSnapshot;
+
+/// Run lexer on a thread pool worker against a copy of text around the range to be styled,
+/// then commit styles, line states and fold levels to the document on the UI thread.
+/// A chunk is discarded when document is edited inside the copied text or styled by other means,
+/// or when lexer accesses data outside the copy, caller should then style it synchronously.
+/// For line-local lexers, consecutive chunks are lexed concurrently on multiple workers, each chunk
+/// after the first one restarts some lines before its start and is committed in order from where
+/// its data converged with previous chunk, rest of chunks are discarded when they don't converge.
+class BackgroundStyler {
+	Document *pdoc;
+	std::vector<std::unique_ptr<StylingSnapshot>> snapshots;
+	PTP_WORK work = nullptr;
+	HANDLE eventFinished = nullptr;
+	std::atomic<size_t> nextChunk = 0;
+	std::atomic<size_t> pendingChunks = 0;
+	bool running = false;
+	bool failed = false;	///< Lexer accessed data outside the copy
+	bool foreground = false;	///< Caller waits for chunks, workers are not throttled
+	int restartLines = 0;	///< Lexing after a line only depends on data of these previous lines
+	int nestedStateMask = 0;	///< Line state bits for lines that can't be restart point
+	Sci::Position endStyled = 0;	///< Document end styled when chunk started
+	Sci::Position modifiedAt = 0;	///< First modified position since chunk started
+
+	static VOID CALLBACK WorkCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work);
+	std::unique_ptr<StylingSnapshot> Snapshot(Scintilla::ILexer5 *instance, Sci::Position start, Sci::Position end, Sci::Position lexStart) const;
+	Sci::Line ConvergedLine(const StylingSnapshot &snap) const noexcept;
+	void CommitSnapshot(const StylingSnapshot &snap, Sci::Line lineCommit);
+
+public:
+	explicit BackgroundStyler(Document *pdoc_) noexcept;
+	// Deleted so BackgroundStyler objects can not be copied.
+	BackgroundStyler(const BackgroundStyler &) = delete;
+	BackgroundStyler(BackgroundStyler &&) = delete;
+	BackgroundStyler &operator=(const BackgroundStyler &) = delete;
+	BackgroundStyler &operator=(BackgroundStyler &&) = delete;
+	~BackgroundStyler();
+
+	bool Start(Scintilla::ILexer5 *instance, Sci::Position start, Sci::Position end, bool lineLocal = false, int restartLines_ = 0, int nestedStateMask_ = 0);
+	void SetForeground(bool foreground_) noexcept {
+		foreground = foreground_;
+	}
+	bool Running() const noexcept {
+		return running;
+	}
+	bool Finished() const noexcept {
+		return !running && !snapshots.empty();
+	}
+	bool Wait(DWORD milliseconds) noexcept;
+	void Join() noexcept;
+	void Stop() noexcept;
+	void ModifiedAt(Sci::Position pos) noexcept {
+		modifiedAt = std::min(modifiedAt, pos);
+	}
+	bool Failed() const noexcept {
+		return failed;
+	}
+	bool Commit(Sci::Position &start, Sci::Position &length);
+};
+
+}
@@ -0,0 +1,89 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+/** @file BraceIndex.cxx
+ ** Chunked brace balance for brace matching in huge documents.
+ **/
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+#include <algorithm>
+
+#include "Position.h"
+#include "BraceIndex.h"
+
+using namespace Scintilla::Internal;
+
+BraceIndex::ChunkList &BraceIndex::Chunks(unsigned char chOpen, int style) noexcept {
+	for (Pair &pair : pairs) {
+		if (pair.chOpen == chOpen && pair.style == style) {
+			return pair.chunks;
+		}
+	}
+	// replace oldest pair
+	Pair &pair = pairs[nextPair];
+	nextPair = (nextPair + 1) % PairCount;
+	pair.chOpen = chOpen;
+	pair.style = style;
+	pair.chunks.clear();
+	return pair.chunks;
+}
+
+size_t BraceIndex::FindChunk(const ChunkList &chunks, Sci::Position position) noexcept {
+	const auto it = std::partition_point(chunks.begin(), chunks.end(), [position](const Chunk &chunk) noexcept {
+		return chunk.end <= position;
+	});
+	return it - chunks.begin();
+}
+
+// chunks added by a search only fill gaps between existing chunks
+void BraceIndex::Merge(ChunkList &chunks, ChunkList &added, int direction) noexcept {
+	if (added.empty()) {
+		return;
+	}
+	if (direction < 0) {
+		std::reverse(added.begin(), added.end());
+	}
+	try {
+		const size_t count = chunks.size();
+		chunks.insert(chunks.end(), added.begin(), added.end());
+		std::inplace_merge(chunks.begin(), chunks.begin() + count, chunks.end(), [](const Chunk &lhs, const Chunk &rhs) noexcept {
+			return lhs.start < rhs.start;
+		});
+	} catch (...) {
+		// chunks are only a shortcut, keep what is already counted
+	}
+}
+
+void BraceIndex::TextModified(Sci::Position position, Sci::Position lengthChange) noexcept {
+	const Sci::Position end = position + std::max<Sci::Position>(-lengthChange, 0);
+	for (Pair &pair : pairs) {
+		ChunkList &chunks = pair.chunks;
+		// chunks adjacent to changed text are also removed, as DBCS lead bytes before them may change
+		auto first = std::partition_point(chunks.begin(), chunks.end(), [position](const Chunk &chunk) noexcept {
+			return chunk.end < position;
+		});
+		const auto last = std::partition_point(first, chunks.end(), [end](const Chunk &chunk) noexcept {
+			return chunk.start <= end;
+		});
+		first = chunks.erase(first, last);
+		for (; first != chunks.end(); ++first) {
+			first->start += lengthChange;
+			first->end += lengthChange;
+		}
+	}
+}
+
+void BraceIndex::StyleModified(Sci::Position start, Sci::Position end) noexcept {
+	for (Pair &pair : pairs) {
+		ChunkList &chunks = pair.chunks;
+		const auto first = std::partition_point(chunks.begin(), chunks.end(), [start](const Chunk &chunk) noexcept {
+			return chunk.end <= start;
+		});
+		const auto last = std::partition_point(first, chunks.end(), [end](const Chunk &chunk) noexcept {
+			return chunk.start < end;
+		});
+		chunks.erase(first, last);
+	}
+}
@@ -0,0 +1,42 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Scintilla::Internal {
+
+/// Brace balance of styled text in chunks, used by Document::BraceMatch() to skip balanced
+/// chunks of huge documents. Counts are kept per brace pair and style, chunks touched by
+/// text or style changes are removed and counted again on later search.
+class BraceIndex {
+public:
+	static constexpr Sci::Position MinDocumentLength = 1024*1024;
+	static constexpr Sci::Position ChunkSize = 4096;
+	struct Chunk {
+		Sci::Position start;
+		Sci::Position end;
+		int delta;		// open braces minus close braces
+		int forward;	// maximum unmatched close braces in prefix
+		int backward;	// maximum unmatched open braces in suffix
+	};
+	using ChunkList = std::vector<Chunk>;
+
+private:
+	static constexpr int PairCount = 4;
+	struct Pair {
+		unsigned char chOpen = 0;
+		int style = -1;
+		ChunkList chunks;
+	};
+	Pair pairs[PairCount];
+	int nextPair = 0;
+
+public:
+	ChunkList &Chunks(unsigned char chOpen, int style) noexcept;
+	// first chunk that ends after position
+	static size_t FindChunk(const ChunkList &chunks, Sci::Position position) noexcept;
+	static void Merge(ChunkList &chunks, ChunkList &added, int direction) noexcept;
+	void TextModified(Sci::Position position, Sci::Position lengthChange) noexcept;
+	void StyleModified(Sci::Position start, Sci::Position end) noexcept;
+};
+
+}
@@ -9,6 +9,7 @@
 // The License.txt file describes the conditions under which this software may be distributed.
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 
 #include <stdexcept>
@@ -607,6 +608,8 @@ class CaseConverter final : public ICaseConverter {
 	// The parallel arrays
 	std::vector<int> characters;
 	std::vector<ConversionString> conversions;
+	// bitmap for BMP characters that have a conversion, others convert to themselves
+	uint32_t bmpConversionMask[0x10000 / 32]{};
 
 public:
 	[[nodiscard]] bool Initialised() const noexcept {
@@ -616,6 +619,9 @@ public:
 		characterToConversion.emplace_back(character, conversion);
 	}
 	const char *Find(int character) const {
+		if (static_cast<unsigned>(character) < 0x10000 && !((bmpConversionMask[character >> 5] >> (character & 31)) & 1)) {
+			return nullptr;
+		}
 		const auto it = std::lower_bound(characters.begin(), characters.end(), character);
 		if (it == characters.end())
 			return nullptr;
@@ -674,6 +680,9 @@ public:
 		for (const CharacterConversion &chConv : characterToConversion) {
 			characters.push_back(chConv.character);
 			conversions.push_back(chConv.conversion);
+			if (chConv.character < 0x10000) {
+				bmpConversionMask[chConv.character >> 5] |= 1U << (chConv.character & 31);
+			}
 		}
 		// Empty the original calculated data completely
 		CharacterToConversion().swap(characterToConversion);
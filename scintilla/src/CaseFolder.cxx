@@ -5,9 +5,13 @@
 // Copyright 1998-2013 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstdint>
+
 #include <stdexcept>
 #include <string>
+#include <algorithm>
 
+#include "VectorISA.h"
 #include "CaseFolder.h"
 #include "CaseConvert.h"
 
@@ -24,6 +28,49 @@ constexpr unsigned char IndexFromChar(char ch) noexcept {
 	return static_cast<unsigned char>(ch);
 }
 
+// lowercase leading ASCII bytes, returns length of the ASCII run
+size_t FoldASCII(char *folded, const char *mixed, size_t length) noexcept {
+	size_t index = 0;
+#if NP2_USE_AVX2
+	const __m256i lowerBound = mm256_set1_epi8('A' - 1);
+	const __m256i upperBound = mm256_set1_epi8('Z' + 1);
+	const __m256i caseBit = mm256_set1_epi8(0x20);
+	while (index + sizeof(__m256i) <= length) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mixed + index));
+		if (mm256_movemask_epi8(chunk)) {
+			break;
+		}
+		// signed comparison is fine as all bytes are ASCII
+		const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, lowerBound), _mm256_cmpgt_epi8(upperBound, chunk));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(folded + index), _mm256_or_si256(chunk, _mm256_and_si256(upper, caseBit)));
+		index += sizeof(__m256i);
+	}
+#elif NP2_USE_SSE2
+	const __m128i lowerBound = _mm_set1_epi8('A' - 1);
+	const __m128i upperBound = _mm_set1_epi8('Z' + 1);
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	while (index + sizeof(__m128i) <= length) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mixed + index));
+		if (mm_movemask_epi8(chunk)) {
+			break;
+		}
+		// signed comparison is fine as all bytes are ASCII
+		const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, lowerBound), _mm_cmpgt_epi8(upperBound, chunk));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(folded + index), _mm_or_si128(chunk, _mm_and_si128(upper, caseBit)));
+		index += sizeof(__m128i);
+	}
+#endif
+	while (index < length) {
+		const char ch = mixed[index];
+		if (static_cast<signed char>(ch) < 0) {
+			break;
+		}
+		folded[index] = MakeLowerCase(ch);
+		++index;
+	}
+	return index;
+}
+
 }
 
 CaseFolderTable::CaseFolderTable() noexcept {
@@ -50,7 +97,31 @@ size_t CaseFolderUnicode::Fold(char *folded, size_t sizeFolded, const char *mixe
 	if ((lenMixed == 1) && (sizeFolded > 0)) {
 		folded[0] = mapping[IndexFromChar(mixed[0])];
 		return 1;
-	} else {
-		return converter->CaseConvertString(folded, sizeFolded, mixed, lenMixed);
 	}
+	// ASCII runs are folded directly, converter is only used for non-ASCII sequences
+	size_t lenFolded = 0;
+	size_t pos = 0;
+	while (pos < lenMixed) {
+		const size_t lenASCII = FoldASCII(folded + lenFolded, mixed + pos, std::min(lenMixed - pos, sizeFolded - lenFolded));
+		pos += lenASCII;
+		lenFolded += lenASCII;
+		// same as CaseConvertString(), return 0 when output is full
+		if (lenFolded >= sizeFolded) {
+			return 0;
+		}
+		if (pos == lenMixed) {
+			break;
+		}
+		size_t end = pos + 1;
+		while (end < lenMixed && static_cast<signed char>(mixed[end]) < 0) {
+			++end;
+		}
+		const size_t lenConverted = converter->CaseConvertString(folded + lenFolded, sizeFolded - lenFolded, mixed + pos, end - pos);
+		if (lenConverted == 0) {
+			return 0;
+		}
+		pos = end;
+		lenFolded += lenConverted;
+	}
+	return lenFolded;
 }
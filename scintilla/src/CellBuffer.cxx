@@ -15,14 +15,17 @@
 #include <climits>
 
 #include <stdexcept>
+#include <utility>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <optional>
 #include <algorithm>
 #include <memory>
+#include <atomic>
 //#include <type_traits>
 
+#include "ParallelSupport.h"
 #include "ScintillaTypes.h"
 
 #include "Debugging.h"
@@ -31,6 +34,7 @@
 #include "Position.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "PieceTable.h"
 #include "RunStyles.h"
 #include "SparseVector.h"
 #include "ChangeHistory.h"
@@ -41,6 +45,81 @@
 
 namespace Scintilla::Internal {
 
+namespace {
+
+constexpr size_t virtualBufferGranularity = 64*1024;
+#if defined(_WIN64)
+// address space is cheap, reserve enough to avoid copying in most cases
+constexpr size_t virtualBufferMinReserve = 1024*1024*1024;
+constexpr size_t virtualBufferReserveFactor = 4;
+#else
+constexpr size_t virtualBufferMinReserve = 16*1024*1024;
+constexpr size_t virtualBufferReserveFactor = 2;
+#endif
+
+constexpr size_t RoundUpGranularity(size_t size) noexcept {
+	return (size + virtualBufferGranularity - 1) & ~(virtualBufferGranularity - 1);
+}
+
+}
+
+void VirtualBuffer::Release() noexcept {
+	if (buffer) {
+		VirtualFree(buffer, 0, MEM_RELEASE);
+		buffer = nullptr;
+	}
+	length = 0;
+	committed = 0;
+	reserved = 0;
+}
+
+void VirtualBuffer::reserve(size_t newCapacity) {
+	if (newCapacity <= committed) {
+		return;
+	}
+	const size_t bytes = RoundUpGranularity(newCapacity);
+	if (bytes > reserved) {
+		// move into a larger range, the only place where existing characters are copied
+		size_t reserve = (bytes < SIZE_MAX/virtualBufferReserveFactor) ? bytes*virtualBufferReserveFactor : bytes;
+		reserve = RoundUpGranularity(std::max(reserve, virtualBufferMinReserve));
+		char *ptr = static_cast<char *>(VirtualAlloc(nullptr, reserve, MEM_RESERVE, PAGE_NOACCESS));
+		if (ptr == nullptr) {
+			reserve = bytes;
+			ptr = static_cast<char *>(VirtualAlloc(nullptr, reserve, MEM_RESERVE, PAGE_NOACCESS));
+			if (ptr == nullptr) {
+				throw std::bad_alloc();
+			}
+		}
+		if (VirtualAlloc(ptr, bytes, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+			VirtualFree(ptr, 0, MEM_RELEASE);
+			throw std::bad_alloc();
+		}
+		const size_t size = length;
+		if (size != 0) {
+			memcpy(ptr, buffer, size);
+		}
+		Release();
+		buffer = ptr;
+		length = size;
+		reserved = reserve;
+	} else if (VirtualAlloc(buffer + committed, bytes - committed, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+		throw std::bad_alloc();
+	}
+	committed = bytes;
+}
+
+void VirtualBuffer::shrink_to_fit() noexcept {
+	if (length == 0) {
+		Release();
+		return;
+	}
+	const size_t bytes = RoundUpGranularity(length);
+	if (bytes < committed) {
+		VirtualFree(buffer + bytes, committed - bytes, MEM_DECOMMIT);
+		committed = bytes;
+	}
+}
+
 struct CountWidths {
 	// Measures the number of characters in a string divided into those
 	// from the Base Multilingual Plane and those from other planes.
@@ -90,6 +169,8 @@ public:
 	virtual bool ReleaseLineCharacterIndex(Scintilla::LineCharacterIndexType lineCharacterIndex) = 0;
 	virtual Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept = 0;
 	virtual Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
+	virtual bool ConcurrentRead() const noexcept = 0;
 	virtual ~ILineVector() = default;
 };
 
@@ -100,6 +181,25 @@ using namespace Scintilla::Internal;
 
 namespace {
 
+// copy partitions between different position types without inserting them one by one
+template <typename Target, typename Source>
+void CopyPartitions(Target &target, const Source &source) {
+	constexpr Sci::Position blockSize = 64*1024;
+	using POS = decltype(target.Length());
+	const Sci::Position partitions = source.Partitions();
+	target.ReAllocate(partitions + 1);
+	target.InsertText(0, static_cast<POS>(source.Length()));
+	std::vector<POS> positions;
+	for (Sci::Position first = 1; first < partitions; first += blockSize) {
+		const Sci::Position count = std::min(blockSize, partitions - first);
+		positions.resize(count);
+		for (Sci::Position index = 0; index < count; index++) {
+			positions[index] = source.PositionFromPartition(static_cast<decltype(source.Length())>(first + index));
+		}
+		target.InsertPartitions(static_cast<POS>(first), positions.data(), static_cast<size_t>(count));
+	}
+}
+
 template <typename POS>
 class LineStartIndex final {
 	// line_cast(): cast Sci::Line to either 32-bit or 64-bit value
@@ -147,6 +247,13 @@ public:
 			starts.ReAllocate(lines);
 		}
 	}
+	template <typename OTHER>
+	void Assign(const LineStartIndex<OTHER> &other) {
+		refCount = other.refCount;
+		if (other.Active()) {
+			CopyPartitions(starts, other.starts);
+		}
+	}
 	void InsertLines(Sci::Line line, Sci::Line lines) {
 		// Insert multiple lines with each temporarily 1 character wide.
 		// The line widths will be fixed up by later measuring code.
@@ -160,7 +267,10 @@ public:
 
 template <typename POS>
 class LineVector final : public ILineVector {
-	Partitioning<POS> starts;
+	template <typename OTHER>
+	friend class LineVector;
+
+	AdaptivePartitioning<POS> starts;
 	PerLine *perLine = nullptr;
 	LineStartIndex<POS> startsUTF16;
 	LineStartIndex<POS> startsUTF32;
@@ -197,6 +307,15 @@ public:
 	void SetPerLine(PerLine *pl) noexcept override {
 		perLine = pl;
 	}
+	/// Copy line starts and character indices from line vector of other position type.
+	template <typename OTHER>
+	void Assign(const LineVector<OTHER> &other) {
+		CopyPartitions(starts, other.starts);
+		startsUTF16.Assign(other.startsUTF16);
+		startsUTF32.Assign(other.startsUTF32);
+		activeIndices = other.activeIndices;
+		perLine = other.perLine;
+	}
 	void InsertText(Sci::Line line, Sci::Position delta) noexcept override {
 		starts.InsertText(pos_cast(line), pos_cast(delta));
 	}
@@ -335,6 +454,98 @@ public:
 			return line_from_pos_cast(startsUTF16.starts.PartitionFromPosition(pos_cast(pos)));
 		}
 	}
+	size_t MemoryUsage() const noexcept override {
+		return starts.MemoryUsage() + startsUTF16.starts.MemoryUsage() + startsUTF32.starts.MemoryUsage();
+	}
+	bool ConcurrentRead() const noexcept override {
+		return starts.ConcurrentRead();
+	}
+};
+
+// find line ends for huge insertion (e.g. loading file) in multiple threads
+constexpr Sci::Position MinParallelLineEndSize = 4*1024*1024;
+constexpr Sci::Position ParallelLineEndBlockSize = 1024*1024;
+
+// record position after LF, CR+LF and CR, text[end] must be valid
+void FindLineEnds(const char *text, Sci::Position index, Sci::Position end, Sci::Position offset, std::vector<Sci::Position> &positions) {
+#if NP2_USE_AVX2
+	const __m256i vectCR = _mm256_set1_epi8('\r');
+	const __m256i vectLF = _mm256_set1_epi8('\n');
+	for (; index + static_cast<Sci::Position>(sizeof(__m256i)) <= end; index += sizeof(__m256i)) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + index));
+		uint32_t mask = mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectCR), _mm256_cmpeq_epi8(chunk, vectLF)));
+		while (mask) {
+			const Sci::Position pos = index + np2::ctz(mask);
+			mask &= mask - 1;
+			if (text[pos] == '\n' || text[pos + 1] != '\n') {
+				positions.push_back(offset + pos + 1);
+			}
+		}
+	}
+#elif NP2_USE_SSE2
+	const __m128i vectCR = _mm_set1_epi8('\r');
+	const __m128i vectLF = _mm_set1_epi8('\n');
+	for (; index + static_cast<Sci::Position>(sizeof(__m128i)) <= end; index += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + index));
+		uint32_t mask = mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vectCR), _mm_cmpeq_epi8(chunk, vectLF)));
+		while (mask) {
+			const Sci::Position pos = index + np2::ctz(mask);
+			mask &= mask - 1;
+			if (text[pos] == '\n' || text[pos + 1] != '\n') {
+				positions.push_back(offset + pos + 1);
+			}
+		}
+	}
+#endif
+	for (; index < end; index++) {
+		const char ch = text[index];
+		if (ch == '\n' || (ch == '\r' && text[index + 1] != '\n')) {
+			positions.push_back(offset + index + 1);
+		}
+	}
+}
+
+class LineEndWorker {
+	const char * const text;
+	const Sci::Position length;
+	const Sci::Position offset;
+	std::atomic<size_t> nextBlock = 0;
+	std::atomic<bool> failed = false;
+
+public:
+	std::vector<std::vector<Sci::Position>> blockPositions;
+
+	LineEndWorker(const char *text_, Sci::Position length_, Sci::Position offset_):
+		text{text_}, length{length_}, offset{offset_},
+		blockPositions((length_ + ParallelLineEndBlockSize - 1) / ParallelLineEndBlockSize) {}
+
+	bool Run() {
+		const uint32_t threadCount = std::min<uint32_t>(GetHardwareConcurrency(), static_cast<uint32_t>(blockPositions.size()));
+		if (threadCount < 2) {
+			return false;
+		}
+		RunParallelWork(*this, threadCount);
+		return !failed.load(std::memory_order_relaxed);
+	}
+
+	void DoWork() noexcept {
+		while (true) {
+			const size_t index = nextBlock.fetch_add(1, std::memory_order_relaxed);
+			if (index >= blockPositions.size()) {
+				break;
+			}
+			const Sci::Position start = index*ParallelLineEndBlockSize;
+			const Sci::Position end = std::min(start + ParallelLineEndBlockSize, length);
+			try {
+				std::vector<Sci::Position> &positions = blockPositions[index];
+				positions.reserve((end - start)/32);
+				FindLineEnds(text, start, end, offset, positions);
+			} catch (...) {
+				failed.store(true, std::memory_order_relaxed);
+				break;
+			}
+		}
+	}
 };
 
 std::unique_ptr<ILineVector> LineVectorCreate(bool largeDocument) {
@@ -346,8 +557,37 @@ std::unique_ptr<ILineVector> LineVectorCreate(bool largeDocument) {
 
 }
 
-CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
-	hasStyles(hasStyles_), largeDocument(largeDocument_),
+char TextSnapshot::CharAt(Sci::Position position) const noexcept {
+	if (!IsValidIndex(position, length)) {
+		return '\0';
+	}
+	const auto it = std::upper_bound(segments.begin(), segments.end(), position, [](Sci::Position pos, const Segment &segment) noexcept {
+		return pos < segment.start;
+	});
+	return it[-1].data[position];
+}
+
+void TextSnapshot::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const noexcept {
+	if ((position | lengthRetrieve) <= 0 || (position + lengthRetrieve) > length) {
+		return;
+	}
+	auto it = std::upper_bound(segments.begin(), segments.end(), position, [](Sci::Position pos, const Segment &segment) noexcept {
+		return pos < segment.start;
+	}) - 1;
+	while (lengthRetrieve > 0) {
+		const Sci::Position lengthCopy = std::min(lengthRetrieve, it[1].start - position);
+		memcpy(buffer, it->data + position, lengthCopy);
+		buffer += lengthCopy;
+		position += lengthCopy;
+		lengthRetrieve -= lengthCopy;
+		++it;
+	}
+}
+
+CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_, bool pieceTable_, bool compressStyles_) :
+	hasStyles(hasStyles_), largeDocument(largeDocument_), compressStyles(compressStyles_),
+	pieceTable{pieceTable_ ? std::make_unique<PieceTable>() : nullptr},
+	styleRuns{(hasStyles_ && compressStyles_) ? std::make_unique<RunStyles<Sci::Position, char>>() : nullptr},
 	uh{std::make_unique<UndoHistory>()},
 	plv{LineVectorCreate(largeDocument_)} {
 	readOnly = false;
@@ -358,25 +598,52 @@ CellBuffer::CellBuffer(bool hasStyles_, bool largeDocument_) :
 
 CellBuffer::~CellBuffer() noexcept = default;
 
+void CellBuffer::ConvertToLarge() {
+	if (largeDocument) {
+		return;
+	}
+	std::unique_ptr<LineVector<Sci::Position>> plvLarge = std::make_unique<LineVector<Sci::Position>>();
+	plvLarge->Assign(static_cast<const LineVector<int> &>(*plv));
+	plv = std::move(plvLarge);
+	largeDocument = true;
+}
+
 char CellBuffer::CharAt(Sci::Position position) const noexcept {
+	if (pieceTable) {
+		return pieceTable->ValueAt(position);
+	}
 	return substance.ValueAt(position);
 }
 
+Sci::Position CellBuffer::Length() const noexcept {
+	if (pieceTable) {
+		return pieceTable->Length();
+	}
+	return substance.Length();
+}
+
 void CellBuffer::GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const noexcept {
 	if ((position | lengthRetrieve) <= 0) {
 		return;
 	}
-	if ((position + lengthRetrieve) > substance.Length()) {
+	if ((position + lengthRetrieve) > Length()) {
 		//Platform::DebugPrintf("Bad GetCharRange %.0f for %.0f of %.0f\n",
 		//					static_cast<double>(position),
 		//					static_cast<double>(lengthRetrieve),
 		//					static_cast<double>(substance.Length()));
 		return;
 	}
+	if (pieceTable) {
+		pieceTable->GetRange(buffer, position, lengthRetrieve);
+		return;
+	}
 	substance.GetRange(buffer, position, lengthRetrieve);
 }
 
 char CellBuffer::StyleAt(Sci::Position position) const noexcept {
+	if (styleRuns) {
+		return IsValidIndex(position, Length()) ? styleRuns->ValueAt(position) : '\0';
+	}
 	return hasStyles ? style.ValueAt(position) : '\0';
 }
 
@@ -388,37 +655,129 @@ void CellBuffer::GetStyleRange(unsigned char *buffer, Sci::Position position, Sc
 		std::fill_n(buffer, lengthRetrieve, static_cast<unsigned char>(0));
 		return;
 	}
-	if ((position + lengthRetrieve) > style.Length()) {
+	if ((position + lengthRetrieve) > Length()) {
 		//Platform::DebugPrintf("Bad GetStyleRange %.0f for %.0f of %.0f\n",
 		//					static_cast<double>(position),
 		//					static_cast<double>(lengthRetrieve),
-		//					static_cast<double>(style.Length()));
+		//					static_cast<double>(Length()));
+		return;
+	}
+	if (styleRuns) {
+		while (lengthRetrieve > 0) {
+			const Sci::Position lengthRun = std::min(styleRuns->EndRun(position) - position, lengthRetrieve);
+			std::fill_n(buffer, lengthRun, static_cast<unsigned char>(styleRuns->ValueAt(position)));
+			buffer += lengthRun;
+			position += lengthRun;
+			lengthRetrieve -= lengthRun;
+		}
 		return;
 	}
 	style.GetRange(reinterpret_cast<char *>(buffer), position, lengthRetrieve);
 }
 
 const char *CellBuffer::BufferPointer() noexcept {
+	if (pieceTable) {
+		return pieceTable->BufferPointer();
+	}
 	return substance.BufferPointer();
 }
 
 const char *CellBuffer::RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept {
+	if (pieceTable) {
+		return pieceTable->RangePointer(position, rangeLength);
+	}
 	return substance.RangePointer(position, rangeLength);
 }
 
+// Contiguous text containing position without moving the gap, position must be inside the buffer.
+const char *CellBuffer::TextSegment(Sci::Position position, Sci::Position &start, Sci::Position &end) const noexcept {
+	if (pieceTable) {
+		return pieceTable->PieceText(position, start, end);
+	}
+	const Sci::Position gap = substance.GapPosition();
+	if (position < gap) {
+		start = 0;
+		end = gap;
+		return substance.Segment1Pointer(0);
+	}
+	start = gap;
+	end = substance.Length();
+	return substance.Segment1Pointer(0) + substance.GapLength();
+}
+
 int CellBuffer::CheckRange(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
-	int result = substance.CheckRange(chars, position, rangeLength);
-	if (hasStyles) {
+	int result = pieceTable ? pieceTable->CheckRange(chars, position, rangeLength) : substance.CheckRange(chars, position, rangeLength);
+	if (styleRuns) {
+		const Sci::Position end = position + rangeLength;
+		for (; position < end; position++, styles++) {
+			result |= *styles ^ styleRuns->ValueAt(position);
+		}
+	} else if (hasStyles) {
 		result |= style.CheckRange(styles, position, rangeLength);
 	}
 	return result;
 }
 
 Sci::Position CellBuffer::GapPosition() const noexcept {
+	if (pieceTable) {
+		return (pieceTable->Pieces() > 1) ? pieceTable->PieceStart(1) : pieceTable->Length();
+	}
 	return substance.GapPosition();
 }
 
+SplitRange CellBuffer::RangeView(Sci::Position position, Sci::Position rangeLength) const noexcept {
+	if (pieceTable) {
+		// characters after first piece are merged into one segment
+		Sci::Position length1 = 0;
+		const char * const segment1 = pieceTable->SegmentPointer(position, rangeLength, length1);
+		if (length1 == rangeLength) {
+			return { segment1, length1 };
+		}
+		return {
+			segment1,
+			length1,
+			pieceTable->RangePointer(position + length1, rangeLength - length1),
+			rangeLength - length1
+		};
+	}
+	const Sci::Position gap = substance.GapPosition();
+	if (position >= gap || position + rangeLength <= gap) {
+		return { substance.ElementPointer(position), rangeLength };
+	}
+	const Sci::Position length1 = gap - position;
+	return {
+		substance.Segment1Pointer(position),
+		length1,
+		substance.ElementPointer(gap),
+		rangeLength - length1
+	};
+}
+
 SplitView CellBuffer::AllView() const noexcept {
+	if (pieceTable) {
+		// at most two pieces after merging, segment2 is indexed by document position
+		pieceTable->MergeForView();
+		const size_t length = pieceTable->Length();
+		const char * const segment1 = pieceTable->PiecePointer(0);
+		if (pieceTable->Pieces() < 2) {
+			memset(const_cast<char *>(segment1 + length), 0, sizeof(int));
+			return SplitView {
+				segment1,
+				length,
+				segment1,
+				length
+			};
+		}
+		const size_t length1 = pieceTable->PieceStart(1);
+		const char * const segment2 = pieceTable->PiecePointer(1) - length1;
+		memset(const_cast<char *>(segment2 + length), 0, sizeof(int));
+		return SplitView {
+			segment1,
+			length1,
+			segment2,
+			length
+		};
+	}
 	const size_t length = substance.Length();
 	size_t length1 = substance.GapPosition();
 	const char *segment1 = substance.Segment1Pointer(0);
@@ -504,7 +863,46 @@ void SetBytes(char *data, char styleValue, Sci::Position length, ChangedRange &r
 
 }
 
+ChangedRange CellBuffer::SetStyleRuns(Sci::Position position, Sci::Position lengthStyle, const char *styles) {
+	ChangedRange range;
+	//! required for StyleContext optimizition, where position + lengthStyle <= lengthBody + 1
+	const Sci::Position end = std::min(position + lengthStyle, Length());
+	while (position < end) {
+		const char value = *styles;
+		Sci::Position lengthRun = 1;
+		while (position + lengthRun < end && styles[lengthRun] == value) {
+			++lengthRun;
+		}
+		const FillResult<Sci::Position> result = styleRuns->FillRange(position, value, lengthRun);
+		if (result.changed) {
+			if (range.Empty()) {
+				range.start = result.position;
+			}
+			range.end = result.position + result.fillLength;
+		}
+		position += lengthRun;
+		styles += lengthRun;
+	}
+	// each run takes more than 8 bytes, switch to plain style buffer when runs are short
+	constexpr Sci::Position minRunsToExpand = 1024*1024;
+	if (styleRuns->Runs() > std::max(Length() / 16, minRunsToExpand)) {
+		ExpandStyleRuns();
+	}
+	return range;
+}
+
+void CellBuffer::ExpandStyleRuns() {
+	const Sci::Position length = Length();
+	style.ReAllocate(length);
+	unsigned char * const data = reinterpret_cast<unsigned char *>(style.InsertEmpty(0, length));
+	GetStyleRange(data, 0, length);
+	styleRuns.reset();
+}
+
 ChangedRange CellBuffer::SetStyles(Sci::Position position, Sci::Position lengthStyle, const char *styles) noexcept {
+	if (styleRuns) {
+		return SetStyleRuns(position, lengthStyle, styles);
+	}
 	ChangedRange range;
 	Sci::Position range1Length = 0;
 	const Sci::Position part1Length = style.GapPosition();
@@ -527,6 +925,15 @@ ChangedRange CellBuffer::SetStyles(Sci::Position position, Sci::Position lengthS
 
 ChangedRange CellBuffer::SetStyleFor(Sci::Position position, Sci::Position lengthStyle, char styleValue) noexcept {
 	ChangedRange range;
+	if (styleRuns) {
+		lengthStyle = std::min(lengthStyle, Length() - position);
+		const FillResult<Sci::Position> result = styleRuns->FillRange(position, styleValue, lengthStyle);
+		if (result.changed) {
+			range.start = result.position;
+			range.end = result.position + result.fillLength;
+		}
+		return range;
+	}
 	Sci::Position range1Length = 0;
 	const Sci::Position part1Length = style.GapPosition();
 	char *data = style.Segment1Pointer(position);
@@ -554,7 +961,7 @@ const char *CellBuffer::DeleteChars(Sci::Position position, Sci::Position delete
 		if (collectingUndo) {
 			// Save into the undo/redo stack, but only the characters - not the formatting
 			// The gap would be moved to position anyway for the deletion so this doesn't cost extra
-			data = substance.RangePointer(position, deleteLength);
+			data = RangePointer(position, deleteLength);
 			data = uh->AppendAction(ActionType::remove, position, data, deleteLength, startSequence);
 		}
 
@@ -572,8 +979,12 @@ void CellBuffer::Allocate(Sci::Position newSize) {
 	//if (!largeDocument && (newSize > INT32_MAX)) {
 	//	throw std::runtime_error("CellBuffer::Allocate: size of standard document limited to 2G.");
 	//}
-	substance.ReAllocate(newSize);
-	if (hasStyles) {
+	if (pieceTable) {
+		pieceTable->ReAllocate(newSize);
+	} else {
+		substance.ReAllocate(newSize);
+	}
+	if (hasStyles && !styleRuns) {
 		style.ReAllocate(newSize);
 	}
 }
@@ -582,9 +993,15 @@ bool CellBuffer::EnsureStyleBuffer(bool hasStyles_) {
 	if (hasStyles != hasStyles_) {
 		hasStyles = hasStyles_;
 		if (hasStyles_) {
-			style.InsertValue(0, substance.Length(), 0);
+			if (compressStyles) {
+				styleRuns = std::make_unique<RunStyles<Sci::Position, char>>();
+				styleRuns->InsertSpace(0, Length());
+			} else {
+				style.InsertValue(0, Length(), 0);
+			}
 		} else {
 			style.DeleteAll();
+			styleRuns.reset();
 		}
 		return true;
 	}
@@ -630,8 +1047,8 @@ LineCharacterIndexType CellBuffer::LineCharacterIndex() const noexcept {
 void CellBuffer::AllocateLineCharacterIndex(LineCharacterIndexType lineCharacterIndex) {
 	if (utf8Substance) {
 		if (plv->AllocateLineCharacterIndex(lineCharacterIndex, Lines())) {
-			// Changed so recalculate whole file
-			RecalculateIndexLineStarts(0, Lines() - 1);
+			// Changed so whole file is measured again on query
+			indexValidLines = 0;
 		}
 	}
 }
@@ -686,11 +1103,30 @@ Sci::Line CellBuffer::LineFromPosition(Sci::Position pos) const noexcept {
 	return plv->LineFromPosition(pos);
 }
 
-Sci::Position CellBuffer::IndexLineStart(Sci::Line line, LineCharacterIndexType lineCharacterIndex) const noexcept {
+Sci::Position CellBuffer::IndexLineStart(Sci::Line line, LineCharacterIndexType lineCharacterIndex) const {
+	EnsureIndexLineStarts(line);
 	return plv->IndexLineStart(line, lineCharacterIndex);
 }
 
-Sci::Line CellBuffer::LineFromPositionIndex(Sci::Position pos, LineCharacterIndexType lineCharacterIndex) const noexcept {
+Sci::Line CellBuffer::LineFromPositionIndex(Sci::Position pos, LineCharacterIndexType lineCharacterIndex) const {
+	// start of first line not measured is correct
+	while (indexValidLines < Lines() && plv->IndexLineStart(indexValidLines, lineCharacterIndex) <= pos) {
+		EnsureIndexLineStarts(indexValidLines + 1);
+	}
+	if (indexValidLines < Lines()) {
+		// starts of lines inserted but not measured may be out of order, only search measured lines
+		Sci::Line lower = 0;
+		Sci::Line upper = indexValidLines - 1;
+		while (lower < upper) {
+			const Sci::Line middle = (lower + upper + 1) / 2;
+			if (plv->IndexLineStart(middle, lineCharacterIndex) <= pos) {
+				lower = middle;
+			} else {
+				upper = middle - 1;
+			}
+		}
+		return lower;
+	}
 	return plv->LineFromPositionIndex(pos, lineCharacterIndex);
 }
 
@@ -733,10 +1169,10 @@ void CellBuffer::RemoveLine(Sci::Line line) {
 
 bool CellBuffer::UTF8LineEndOverlaps(Sci::Position position) const noexcept {
 	const unsigned char bytes[] = {
-		static_cast<unsigned char>(substance.ValueAt(position - 2)),
-		static_cast<unsigned char>(substance.ValueAt(position - 1)),
-		static_cast<unsigned char>(substance.ValueAt(position)),
-		static_cast<unsigned char>(substance.ValueAt(position + 1)),
+		static_cast<unsigned char>(CharAt(position - 2)),
+		static_cast<unsigned char>(CharAt(position - 1)),
+		static_cast<unsigned char>(CharAt(position)),
+		static_cast<unsigned char>(CharAt(position + 1)),
 	};
 	return UTF8IsSeparator(bytes) || UTF8IsSeparator(bytes + 1) || UTF8IsNEL(bytes + 1);
 }
@@ -750,7 +1186,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const noexcept
 			if (posBack < 0) {
 				return false;
 			}
-			const char chAt = substance.ValueAt(posBack);
+			const char chAt = CharAt(posBack);
 			back[UTF8MaxBytes - 1 - i] = chAt;
 			if (!UTF8IsTrailByte(chAt)) {
 				if (i > 0) {
@@ -765,7 +1201,7 @@ bool CellBuffer::UTF8IsCharacterBoundary(Sci::Position position) const noexcept
 		}
 	}
 	if (position < Length()) {
-		const unsigned char fore = substance.ValueAt(position);
+		const unsigned char fore = CharAt(position);
 		if (UTF8IsTrailByte(fore)) {
 			return false;
 		}
@@ -778,6 +1214,7 @@ void CellBuffer::ResetLineEnds() {
 	const Sci::Line lines = plv->Lines();
 	plv->Init();
 	plv->AllocateLines(lines);
+	indexValidLines = 0;
 
 	constexpr Sci::Position position = 0;
 	const Sci::Position length = Length();
@@ -787,7 +1224,7 @@ void CellBuffer::ResetLineEnds() {
 	unsigned char chBeforePrev = 0;
 	unsigned char chPrev = 0;
 	for (Sci::Position i = 0; i < length; i++) {
-		const unsigned char ch = substance[position + 1];
+		const unsigned char ch = CharAt(position + 1);
 		if (ch == '\r') {
 			InsertLine(lineInsert, (position + i) + 1, atLineStart);
 			lineInsert++;
@@ -812,10 +1249,39 @@ void CellBuffer::ResetLineEnds() {
 
 namespace {
 
+// lines measured together when character index is computed on query
+constexpr Sci::Line IndexBlockLines = 4096;
+
+// length of ASCII prefix
+size_t CountASCII(std::string_view sv) noexcept {
+	size_t pos = 0;
+	const size_t length = sv.length();
+#if NP2_USE_SSE2
+	for (; pos + sizeof(__m128i) <= length; pos += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(sv.data() + pos));
+		const uint32_t mask = mm_movemask_epi8(chunk);
+		if (mask) {
+			return pos + np2::ctz(mask);
+		}
+	}
+#endif
+	while (pos < length && UTF8IsAscii(sv[pos])) {
+		pos++;
+	}
+	return pos;
+}
+
 CountWidths CountCharacterWidthsUTF8(std::string_view sv) noexcept {
 	CountWidths cw;
 	size_t remaining = sv.length();
 	while (remaining > 0) {
+		const size_t ascii = CountASCII(sv);
+		if (ascii != 0) {
+			cw.countBasePlane += ascii;
+			sv.remove_prefix(ascii);
+			remaining -= ascii;
+			continue;
+		}
 		const int utf8Status = UTF8Classify(sv);
 		const int lenChar = utf8Status & UTF8MaskWidth;
 		cw.CountChar(lenChar);
@@ -831,7 +1297,7 @@ bool CellBuffer::MaintainingLineCharacterIndex() const noexcept {
 	return plv->LineCharacterIndex() != LineCharacterIndexType::None;
 }
 
-void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast) {
+void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast) const {
 	std::string text;
 	Sci::Position posLineEnd = LineStart(lineFirst);
 	for (Sci::Line line = lineFirst; line <= lineLast; line++) {
@@ -846,12 +1312,23 @@ void CellBuffer::RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineL
 	}
 }
 
+// measure lines before line in blocks, this is done on query instead of on load or big edit.
+void CellBuffer::EnsureIndexLineStarts(Sci::Line line) const {
+	if (line > indexValidLines) {
+		const Sci::Line lineLast = std::min(((line + IndexBlockLines - 1) / IndexBlockLines) * IndexBlockLines, Lines()) - 1;
+		if (lineLast >= indexValidLines) {
+			RecalculateIndexLineStarts(indexValidLines, lineLast);
+			indexValidLines = lineLast + 1;
+		}
+	}
+}
+
 void CellBuffer::BasicInsertString(const Sci::Position position, const char * const s, const Sci::Position insertLength) {
 	if (insertLength == 0)
 		return;
 	PLATFORM_ASSERT(insertLength > 0);
 
-	const unsigned char chAfter = substance.ValueAt(position);
+	const unsigned char chAfter = CharAt(position);
 	bool breakingUTF8LineEnd = false;
 	if (utf8LineEnds != LineEndType::Default && UTF8IsTrailByte(chAfter)) {
 		breakingUTF8LineEnd = UTF8LineEndOverlaps(position);
@@ -866,7 +1343,7 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 	const bool maintainingIndex = MaintainingLineCharacterIndex();
 
 	// Check for breaking apart a UTF-8 sequence and inserting invalid UTF-8
-	if (utf8Substance && maintainingIndex) {
+	if (utf8Substance && maintainingIndex && linePosition < indexValidLines) {
 		// Actually, don't need to check that whole insertion is valid just that there
 		// are no potential fragments at ends.
 		simpleInsertion = UTF8IsCharacterBoundary(position) &&
@@ -875,8 +1352,17 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 
 {
 	// const ElapsedPeriod period;
-	substance.InsertFromArray(position, s, insertLength);
-	if (hasStyles) {
+	++textVersion;
+	snapshot.reset();
+	if (pieceTable) {
+		pieceTable->InsertFromArray(position, s, insertLength);
+	} else {
+		substance.InsertFromArray(position, s, insertLength);
+	}
+	if (styleRuns) {
+		styleRuns->InsertSpace(position, insertLength);
+		styleRuns->FillRange(position, 0, insertLength);
+	} else if (hasStyles) {
 		style.InsertValue(position, insertLength, 0);
 	}
 	// const double duration = period.Duration()*1e3;
@@ -886,8 +1372,8 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 	const bool atLineStart = plv->LineStart(lineInsert - 1) == position;
 	// Point all the lines after the insertion point further along in the buffer
 	plv->InsertText(lineInsert - 1, insertLength);
-	unsigned char chBeforePrev = substance.ValueAt(position - 2);
-	unsigned char chPrev = substance.ValueAt(position - 1);
+	unsigned char chBeforePrev = CharAt(position - 2);
+	unsigned char chPrev = CharAt(position - 1);
 	if (chPrev == '\r' && chAfter == '\n') {
 		// Splitting up a crlf pair at position
 		InsertLine(lineInsert, position, false);
@@ -919,6 +1405,19 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 		simpleInsertion = false;
 	}
 
+	if (utf8LineEnds == LineEndType::Default && end - ptr >= MinParallelLineEndSize) {
+		LineEndWorker worker(ptr, end - ptr, position + ptr - s);
+		if (worker.Run()) {
+			for (const auto &positions : worker.blockPositions) {
+				if (!positions.empty()) {
+					plv->InsertLines(lineInsert, positions.data(), positions.size(), atLineStart);
+					lineInsert += positions.size();
+				}
+			}
+			ptr = end;
+		}
+	}
+
 	// set EditDetectEOLMode()
 #if 0//NP2_USE_AVX512
 	if (utf8LineEnds == LineEndType::Default && ptr + sizeof(__m512i) <= end) {
@@ -1305,7 +1804,7 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 		chPrev = ch;
 		// May have end of UTF-8 line end in buffer and start in insertion
 		for (int j = 0; j < UTF8SeparatorLength - 1; j++) {
-			const unsigned char chAt = substance.ValueAt(position + insertLength + j);
+			const unsigned char chAt = CharAt(position + insertLength + j);
 			const unsigned char back3[3] = { chBeforePrev, chPrev, chAt };
 			if (UTF8IsSeparator(back3)) {
 				InsertLine(lineInsert, (position + insertLength + j) + 1, atLineStart);
@@ -1319,12 +1818,17 @@ void CellBuffer::BasicInsertString(const Sci::Position position, const char * co
 			chPrev = chAt;
 		}
 	}
-	if (maintainingIndex) {
+	// lines not measured yet are ignored
+	if (maintainingIndex && linePosition < indexValidLines) {
 		if (simpleInsertion && (lineInsert == lineStart)) {
 			const CountWidths cw = CountCharacterWidthsUTF8(std::string_view(s, insertLength));
 			plv->InsertCharacters(linePosition, cw);
-		} else {
+		} else if (lineInsert - linePosition <= IndexBlockLines) {
 			RecalculateIndexLineStarts(linePosition, lineInsert - 1);
+			indexValidLines += lineInsert - linePosition - 1;
+		} else {
+			// big insertion is measured on query
+			indexValidLines = linePosition;
 		}
 	}
 }
@@ -1334,26 +1838,31 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 		return;
 
 	Sci::Line lineRecalculateStart = Sci::invalidPosition;
+	Sci::Line linesBefore = 0;
+	Sci::Line lineDelete = 0;
 
-	if ((position == 0) && (deleteLength == substance.Length())) {
+	if ((position == 0) && (deleteLength == Length())) {
 		// If whole buffer is being deleted, faster to reinitialise lines data
 		// than to delete each line.
 		plv->Init();
+		indexValidLines = 0;
 	} else {
 		// Have to fix up line positions before doing deletion as looking at text in buffer
 		// to work out which lines have been removed
 
 		const Sci::Line linePosition = plv->LineFromPosition(position);
 		Sci::Line lineRemove = linePosition + 1;
+		linesBefore = plv->Lines();
+		lineDelete = linePosition;
 
 		plv->InsertText(lineRemove - 1, -deleteLength);
-		const unsigned char chPrev = substance.ValueAt(position - 1);
+		const unsigned char chPrev = CharAt(position - 1);
 		const unsigned char chBefore = chPrev;
-		unsigned char chNext = substance.ValueAt(position);
+		unsigned char chNext = CharAt(position);
 
 		// Check for breaking apart a UTF-8 sequence
 		// Needs further checks that text is UTF-8 or that some other break apart is occurring
-		if (utf8Substance && MaintainingLineCharacterIndex()) {
+		if (utf8Substance && MaintainingLineCharacterIndex() && linePosition < indexValidLines) {
 			const Sci::Position posEnd = position + deleteLength;
 			const Sci::Line lineEndRemove = plv->LineFromPosition(posEnd);
 			const bool simpleDeletion =
@@ -1389,7 +1898,7 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 
 		unsigned char ch = chNext;
 		for (Sci::Position i = 0; i < deleteLength; i++) {
-			chNext = substance.ValueAt(position + i + 1);
+			chNext = CharAt(position + i + 1);
 			if (ch == '\r') {
 				if (chNext != '\n') {
 					RemoveLine(lineRemove);
@@ -1403,7 +1912,7 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 			} else if (utf8LineEnds != LineEndType::Default) {
 				if (!UTF8IsAscii(ch)) {
 					const unsigned char next3[3] = { ch, chNext,
-						static_cast<unsigned char>(substance.ValueAt(position + i + 2)) };
+						static_cast<unsigned char>(CharAt(position + i + 2)) };
 					if (UTF8IsSeparator(next3) || UTF8IsNEL(next3)) {
 						RemoveLine(lineRemove);
 					}
@@ -1414,18 +1923,30 @@ void CellBuffer::BasicDeleteChars(const Sci::Position position, const Sci::Posit
 		}
 		// May have to fix up end if last deletion causes CR to be next to LF
 		// or removes one of a CR LF pair
-		const char chAfter = substance.ValueAt(position + deleteLength);
+		const char chAfter = CharAt(position + deleteLength);
 		if (chBefore == '\r' && chAfter == '\n') {
 			// Using lineRemove-1 as CR ended line before start of deletion
 			RemoveLine(lineRemove - 1);
 			plv->SetLineStart(lineRemove - 1, position + 1);
 		}
 	}
-	substance.DeleteRange(position, deleteLength);
+	++textVersion;
+	snapshot.reset();
+	if (pieceTable) {
+		pieceTable->DeleteRange(position, deleteLength);
+	} else {
+		substance.DeleteRange(position, deleteLength);
+	}
 	if (lineRecalculateStart >= 0) {
 		RecalculateIndexLineStarts(lineRecalculateStart, lineRecalculateStart);
 	}
-	if (hasStyles) {
+	if (lineDelete < indexValidLines) {
+		// measured lines after removed lines are still valid
+		indexValidLines = std::max(lineDelete + 1, indexValidLines - (linesBefore - plv->Lines()));
+	}
+	if (styleRuns) {
+		styleRuns->DeleteRange(position, deleteLength);
+	} else if (hasStyles) {
 		style.DeleteRange(position, deleteLength);
 	}
 }
@@ -1481,7 +2002,7 @@ void CellBuffer::PerformUndoStep() {
 		changeHistory->StartReversion();
 	}
 	if (previousStep.at == ActionType::insert) {
-		if (substance.Length() < previousStep.lenData) {
+		if (Length() < previousStep.lenData) {
 			throw std::runtime_error(
 				"CellBuffer::PerformUndoStep: deletion must be less than document length.");
 		}
@@ -1659,6 +2180,79 @@ void CellBuffer::ChangeLastUndoActionText(size_t length, const char *text) {
 	uh->ChangeLastUndoActionText(length, text);
 }
 
+void CellBuffer::SetUndoMemoryLimit(size_t limit) noexcept {
+	uh->SetMemoryLimit(limit);
+}
+
+size_t CellBuffer::UndoMemoryLimit() const noexcept {
+	return uh->MemoryLimit();
+}
+
+size_t CellBuffer::UndoMemory() const noexcept {
+	return uh->MemoryUsage();
+}
+
+// Same snapshot is returned until text is changed, styles are copied on each call as
+// they are changed by lexer without changing text.
+std::shared_ptr<const TextSnapshot> CellBuffer::Snapshot(bool withStyles) {
+	const Sci::Position length = Length();
+	if (!snapshot) {
+		std::shared_ptr<TextSnapshot> current = std::make_shared<TextSnapshot>();
+		current->length = length;
+		current->version = textVersion;
+		if (pieceTable) {
+			const Sci::Position count = pieceTable->Pieces();
+			current->segments.reserve(count + 1);
+			for (Sci::Position piece = 0; piece < count; piece++) {
+				const Sci::Position start = pieceTable->PieceStart(piece);
+				current->segments.push_back({ start, pieceTable->PiecePointer(piece) - start });
+			}
+			pieceTable->ShareBlocks(current->blocks);
+		} else {
+			std::shared_ptr<char[]> text(new char[length + 1]);
+			substance.GetRange(text.get(), 0, length);
+			text[length] = '\0';
+			current->segments.push_back({ 0, text.get() });
+			current->blocks.push_back(std::move(text));
+		}
+		current->segments.push_back({ length, nullptr });
+		snapshot = std::move(current);
+	}
+	if (!withStyles) {
+		return snapshot;
+	}
+
+	std::shared_ptr<TextSnapshot> styled = std::make_shared<TextSnapshot>();
+	styled->length = length;
+	styled->version = textVersion;
+	styled->segments = snapshot->segments;
+	styled->blocks = snapshot->blocks;
+	styled->styles = std::make_unique<unsigned char[]>(length + 1);
+	GetStyleRange(styled->styles.get(), 0, length);
+	return styled;
+}
+
+bool CellBuffer::ConcurrentRead() const noexcept {
+	// piece table caches last accessed piece
+	return !pieceTable && plv->ConcurrentRead();
+}
+
+size_t CellBuffer::TextMemory() const noexcept {
+	return pieceTable ? pieceTable->MemoryUsage() : substance.MemoryUsage();
+}
+
+size_t CellBuffer::StyleMemory() const noexcept {
+	return style.MemoryUsage() + (styleRuns ? styleRuns->MemoryUsage() : 0);
+}
+
+size_t CellBuffer::LineMemory() const noexcept {
+	return plv->MemoryUsage();
+}
+
+size_t CellBuffer::ChangeHistoryMemory() const noexcept {
+	return changeHistory ? changeHistory->MemoryUsage() : 0;
+}
+
 void CellBuffer::ChangeHistorySet(bool set) {
 	if (set) {
 		if (!changeHistory && !uh->CanUndo()) {
@@ -24,10 +24,14 @@ public:
 	virtual void InsertLine(Sci::Line line) = 0;
 	virtual void InsertLines(Sci::Line line, Sci::Line lines) = 0;
 	virtual void RemoveLine(Sci::Line line) = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
 };
 
 class UndoHistory;
 class ChangeHistory;
+class PieceTable;
+template <typename DISTANCE, typename STYLE>
+class RunStyles;
 
 /**
  * The line vector contains information about each of the lines in a cell buffer.
@@ -71,6 +75,47 @@ struct SplitView {
 	}
 };
 
+/// Characters of a range split into two parts at the gap, segment2 is empty when the range is contiguous.
+struct SplitRange {
+	const char *segment1 = nullptr;
+	Sci::Position length1 = 0;
+	const char *segment2 = nullptr;
+	Sci::Position length2 = 0;
+};
+
+/**
+ * Read-only text of a document at a version, shared by background readers without locking.
+ * Text is a sequence of segments sorted by start position, the last one is an end marker.
+ * Piece table text shares blocks with the live buffer, gap buffer text is copied once.
+ */
+class TextSnapshot {
+public:
+	struct Segment {
+		Sci::Position start;
+		const char *data;	///< Indexed by document position
+	};
+	std::vector<Segment> segments;
+	std::vector<std::shared_ptr<const char[]>> blocks;
+	std::unique_ptr<unsigned char[]> styles;
+	Sci::Position length = 0;
+	uint32_t version = 0;
+
+	TextSnapshot() noexcept = default;
+	// Deleted so TextSnapshot objects can not be copied.
+	TextSnapshot(const TextSnapshot &) = delete;
+	TextSnapshot(TextSnapshot &&) = delete;
+	TextSnapshot &operator=(const TextSnapshot &) = delete;
+	TextSnapshot &operator=(TextSnapshot &&) = delete;
+	~TextSnapshot() = default;
+
+	/// Retrieving positions outside the range of the text returns 0
+	char CharAt(Sci::Position position) const noexcept;
+	unsigned char StyleAt(Sci::Position position) const noexcept {
+		return (styles && IsValidIndex(position, length)) ? styles[position] : 0;
+	}
+	void GetCharRange(char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const noexcept;
+};
+
 struct ChangedRange {
 	Sci::Position start = 0;
 	Sci::Position end = 0;
@@ -90,31 +135,43 @@ struct ChangedRange {
 class CellBuffer {
 private:
 	bool hasStyles;
-	const bool largeDocument;
+	bool largeDocument;
+	const bool compressStyles;
 	bool readOnly;
 	bool utf8Substance;
 	Scintilla::LineEndType utf8LineEnds;
-	SplitVector<char> substance;
-	SplitVector<char> style;
+	SplitVector<char, VirtualBuffer> substance;
+	SplitVector<char, VirtualBuffer> style;
+	const std::unique_ptr<PieceTable> pieceTable;
+	/// Runs of styles used instead of style until average run is too short.
+	std::unique_ptr<RunStyles<Sci::Position, char>> styleRuns;
 
 	bool collectingUndo;
 	const std::unique_ptr<UndoHistory> uh;
 
 	std::unique_ptr<ChangeHistory> changeHistory;
 
-	const std::unique_ptr<ILineVector> plv;
+	std::unique_ptr<ILineVector> plv;
+	/// Lines at start of document with up to date character index, the rest is measured on query.
+	mutable Sci::Line indexValidLines = 0;
+
+	uint32_t textVersion = 0;
+	std::shared_ptr<const TextSnapshot> snapshot;
 
 	bool UTF8LineEndOverlaps(Sci::Position position) const noexcept;
 	bool UTF8IsCharacterBoundary(Sci::Position position) const noexcept;
 	void ResetLineEnds();
-	void RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast);
+	void RecalculateIndexLineStarts(Sci::Line lineFirst, Sci::Line lineLast) const;
+	void EnsureIndexLineStarts(Sci::Line line) const;
 	bool MaintainingLineCharacterIndex() const noexcept;
 	/// Actions without undo
 	void BasicInsertString(Sci::Position position, const char *s, Sci::Position insertLength);
 	void BasicDeleteChars(Sci::Position position, Sci::Position deleteLength);
+	ChangedRange SetStyleRuns(Sci::Position position, Sci::Position lengthStyle, const char *styles);
+	void ExpandStyleRuns();
 
 public:
-	CellBuffer(bool hasStyles_, bool largeDocument_);
+	CellBuffer(bool hasStyles_, bool largeDocument_, bool pieceTable_, bool compressStyles_);
 	// Deleted so CellBuffer objects can not be copied.
 	CellBuffer(const CellBuffer &) = delete;
 	CellBuffer(CellBuffer &&) = delete;
@@ -132,13 +189,13 @@ public:
 	void GetStyleRange(unsigned char *buffer, Sci::Position position, Sci::Position lengthRetrieve) const noexcept;
 	const char *BufferPointer() noexcept;
 	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) noexcept;
+	const char *TextSegment(Sci::Position position, Sci::Position &start, Sci::Position &end) const noexcept;
 	int CheckRange(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept;
 	Sci::Position GapPosition() const noexcept;
 	SplitView AllView() const noexcept;
+	SplitRange RangeView(Sci::Position position, Sci::Position rangeLength) const noexcept;
 
-	Sci::Position Length() const noexcept {
-		return substance.Length();
-	}
+	Sci::Position Length() const noexcept;
 	void Allocate(Sci::Position newSize);
 	bool EnsureStyleBuffer(bool hasStyles_);
 	void SetUTF8Substance(bool utf8Substance_) noexcept {
@@ -157,9 +214,9 @@ public:
 	void AllocateLines(Sci::Line lines);
 	Sci::Position LineStart(Sci::Line line) const noexcept;
 	Sci::Position LineEnd(Sci::Line line) const noexcept;
-	Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
+	Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const;
 	Sci::Line LineFromPosition(Sci::Position pos) const noexcept;
-	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
+	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const;
 	void InsertLine(Sci::Line line, Sci::Position position, bool lineStart);
 	void RemoveLine(Sci::Line line);
 	const char *InsertString(Sci::Position position, const char *s, Sci::Position insertLength, bool &startSequence);
@@ -180,9 +237,24 @@ public:
 	bool IsLarge() const noexcept {
 		return largeDocument;
 	}
+	/// Widen line starts to 64-bit, text and styles are kept.
+	void ConvertToLarge();
 	bool HasStyles() const noexcept {
 		return hasStyles;
 	}
+	bool IsPieceTable() const noexcept {
+		return pieceTable != nullptr;
+	}
+	/// Whether text and lines can be read from multiple threads at the same time.
+	bool ConcurrentRead() const noexcept;
+	/// Incremented on each text change, used to check whether a snapshot is current.
+	uint32_t TextVersion() const noexcept {
+		return textVersion;
+	}
+	std::shared_ptr<const TextSnapshot> Snapshot(bool withStyles);
+	bool IsStylesCompressed() const noexcept {
+		return compressStyles;
+	}
 
 	/// The save point is a marker in the undo stack where the container has stated that
 	/// the buffer was saved. Undo and redo can move over the save point.
@@ -230,6 +302,13 @@ public:
 	std::string_view UndoActionText(int action) const noexcept;
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	void SetUndoMemoryLimit(size_t limit) noexcept;
+	size_t UndoMemoryLimit() const noexcept;
+	size_t UndoMemory() const noexcept;
+	size_t TextMemory() const noexcept;
+	size_t StyleMemory() const noexcept;
+	size_t LineMemory() const noexcept;
+	size_t ChangeHistoryMemory() const noexcept;
 
 	void ChangeHistorySet(bool set);
 	[[nodiscard]] int EditionAt(Sci::Position pos) const noexcept;
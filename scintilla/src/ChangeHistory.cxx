@@ -41,9 +41,8 @@ namespace {
 constexpr bool InsertionSpanSameDeletion(const ChangeSpan &is, Sci::Position positionDeletion, int edition) noexcept {
 	// Equal except for count
 	return
-		is.direction == ChangeSpan::Direction::deletion &&
+		is.IsDeletion() &&
 		is.start == positionDeletion &&
-		is.length == 0 &&
 		is.edition == edition;
 }
 
@@ -52,7 +51,7 @@ constexpr bool InsertionSpanSameDeletion(const ChangeSpan &is, Sci::Position pos
 void ChangeStack::PushDeletion(Sci::Position positionDeletion, const EditionCount &ec) {
 	steps.back() += ec.count;
 	if (changes.empty() || !InsertionSpanSameDeletion(changes.back(), positionDeletion, ec.edition)) {
-		changes.push_back({ positionDeletion, 0, ec.edition, ec.count, ChangeSpan::Direction::deletion });
+		changes.push_back({ positionDeletion, 0, ec.edition, ec.count });
 	} else {
 		changes.back().count += ec.count;
 	}
@@ -60,7 +59,7 @@ void ChangeStack::PushDeletion(Sci::Position positionDeletion, const EditionCoun
 
 void ChangeStack::PushInsertion(Sci::Position positionInsertion, Sci::Position length, int edition) {
 	steps.back()++;
-	changes.push_back({ positionInsertion, length, edition, 1, ChangeSpan::Direction::insertion });
+	changes.push_back({ positionInsertion, length, edition, 1 });
 }
 
 int ChangeStack::PopStep() noexcept {
@@ -90,6 +89,10 @@ void ChangeStack::SetSavePoint() noexcept {
 	}
 }
 
+size_t ChangeStack::MemoryUsage() const noexcept {
+	return steps.capacity()*sizeof(int) + changes.capacity()*sizeof(ChangeSpan);
+}
+
 void ChangeStack::Check() const noexcept {
 #ifndef NDEBUG
 	// Ensure count in steps same as insertions;
@@ -123,10 +126,9 @@ void ChangeLog::DeleteRange(Sci::Position position, Sci::Position deleteLength)
 	const EditionSetOwned empty{};
 	const EditionSetOwned &editions = deleteEdition.ValueOr(position, empty);
 	if (editions) {
-		const EditionSet savedEditions = *editions;
+		EditionSetOwned savedEditions = std::move(const_cast<EditionSetOwned &>(editions));
 		deleteEdition.DeleteRange(position, deleteLength);
-		EditionSetOwned reset = std::make_unique<EditionSet>(savedEditions);
-		deleteEdition.SetValueAt(position, std::move(reset));
+		deleteEdition.SetValueAt(position, std::move(savedEditions));
 	} else {
 		deleteEdition.DeleteRange(position, deleteLength);
 	}
@@ -138,65 +140,100 @@ void ChangeLog::Insert(Sci::Position start, Sci::Position length, int edition) {
 }
 
 void ChangeLog::CollapseRange(Sci::Position position, Sci::Position deleteLength) {
+	// Save deletions inside range into undo stack then move them to position.
+	// Only positions with deletions are visited, so replacing text without history is cheap.
 	const Sci::Position positionMax = position + deleteLength;
-	Sci::Position positionDeletion = position + 1;
+	Sci::Position positionDeletion = deleteEdition.PositionNext(position);
 	while (positionDeletion <= positionMax) {
-		EditionSetOwned empty{};
+		const EditionSetOwned empty{};
 		const EditionSetOwned &editions = deleteEdition.ValueOr(positionDeletion, empty);
 		if (editions) {
-			for (const EditionCount &ec : *editions) {
+			const EditionSetOwned moved = std::move(const_cast<EditionSetOwned &>(editions));
+			for (const EditionCount &ec : moved) {
+				changeStack.PushDeletion(positionDeletion, ec);
 				PushDeletionAt(position, ec);
 			}
-			deleteEdition.SetValueAt(positionDeletion, std::move(empty));
+			deleteEdition.SetValueAt(positionDeletion, EditionSetOwned{});
 		}
 		positionDeletion = deleteEdition.PositionNext(positionDeletion);
 	}
 }
 
-namespace {
-
 // EditionSets have repeat counts on items so push and pop may just
 // manipulate the count field or may push/pop items.
 
-void EditionSetPush(EditionSet &set, EditionCount ec) {
-	if (set.empty() || (set.back().edition != ec.edition)) {
-		set.push_back(ec);
-	} else {
-		set.back().count += ec.count;
+int EditionSetOwned::Count() const noexcept {
+	int count = 0;
+	for (const EditionCount &ec : *this) {
+		count += ec.count;
 	}
+	return count;
 }
 
-void EditionSetPop(EditionSet &set) noexcept {
-	if (set.back().count == 1) {
-		set.pop_back();
+void EditionSetOwned::Push(EditionCount ec) {
+	if (set) {
+		if (set->back().edition != ec.edition) {
+			set->push_back(ec);
+		} else {
+			set->back().count += ec.count;
+		}
+	} else if (single.count == 0) {
+		single = ec;
+	} else if (single.edition == ec.edition) {
+		single.count += ec.count;
 	} else {
-		set.back().count--;
+		set = std::make_unique<EditionSet>(EditionSet{ single, ec });
+		single = {};
 	}
 }
 
-int EditionSetCount(const EditionSet &set) noexcept {
-	int count = 0;
-	for (const EditionCount &ec : set) {
-		count += ec.count;
+void EditionSetOwned::PushFront(EditionCount ec) {
+	if (!set && single.count == 0) {
+		single = ec;
+		return;
 	}
-	return count;
+	if (!set) {
+		set = std::make_unique<EditionSet>(1, single);
+		single = {};
+	}
+	set->insert(set->begin(), ec);
 }
 
+void EditionSetOwned::Pop() noexcept {
+	if (set) {
+		if (set->back().count == 1) {
+			set->pop_back();
+			if (set->size() == 1) {
+				// back to inline storage
+				single = set->front();
+				set.reset();
+			}
+		} else {
+			set->back().count--;
+		}
+	} else if (single.count == 1) {
+		single = {};
+	} else {
+		single.count--;
+	}
+}
+
+EditionSet EditionSetOwned::ToSet() const {
+	return EditionSet(begin(), end());
 }
 
 void ChangeLog::Add(Sci::Position position, EditionCount ec, bool front) {
 	const EditionSetOwned empty{};
 	const EditionSetOwned &editions = deleteEdition.ValueOr(position, empty);
 	if (editions) {
+		EditionSetOwned &value = const_cast<EditionSetOwned &>(editions);
 		if (front) {
-			const_cast<EditionSetOwned &>(editions)->insert(editions->begin(), ec);
+			value.PushFront(ec);
 		} else {
-			EditionSetPush(*const_cast<EditionSetOwned &>(editions), ec);
+			value.Push(ec);
 		}
 	} else {
-		EditionSetOwned editionSet = std::make_unique<EditionSet>();
-		editionSet->push_back(ec);
-		deleteEdition.SetValueAt(position, std::move(editionSet));
+		deleteEdition.SetValueAt(position, EditionSetOwned(ec));
 	}
 }
 
@@ -223,17 +260,6 @@ void ChangeLog::SaveRange(Sci::Position position, Sci::Position length) {
 			insertEdition.ValueAt(positionInsertion));
 		positionInsertion = insertEdition.EndRun(positionEndInsertion);
 	}
-	Sci::Position positionDeletion = position + 1;
-	while (positionDeletion <= positionMax) {
-		const EditionSetOwned empty{};
-		const EditionSetOwned &editions = deleteEdition.ValueOr(positionDeletion, empty);
-		if (editions) {
-			for (const EditionCount &ec : *editions) {
-				changeStack.PushDeletion(positionDeletion, ec);
-			}
-		}
-		positionDeletion = deleteEdition.PositionNext(positionDeletion);
-	}
 }
 
 void ChangeLog::PopDeletion(Sci::Position position, Sci::Position deleteLength) {
@@ -242,21 +268,21 @@ void ChangeLog::PopDeletion(Sci::Position position, Sci::Position deleteLength)
 	EditionSetOwned eso = deleteEdition.Extract(position + deleteLength);
 	deleteEdition.SetValueAt(position, std::move(eso));
 	const EditionSetOwned empty{};
-	const EditionSetOwned &editions = deleteEdition.ValueOr(position, empty);
+	EditionSetOwned &editions = const_cast<EditionSetOwned &>(deleteEdition.ValueOr(position, empty));
 	assert(editions);
-	EditionSetPop(*editions);
+	editions.Pop();
 	const int inserts = changeStack.PopStep();
 	for (int i = 0; i < inserts;) {
 		const ChangeSpan span = changeStack.PopSpan(inserts);
-		if (span.direction == ChangeSpan::Direction::insertion) {
+		if (!span.IsDeletion()) {
 			assert(span.count == 1);	// Insertions are never compressed
 			insertEdition.FillRange(span.start, span.edition, span.length);
 			i++;
 		} else {
 			assert(editions);
-			assert(editions->back().edition == span.edition);
+			assert(editions.Back().edition == span.edition);
 			for (int j = 0; j < span.count; j++) {
-				EditionSetPop(*editions);
+				editions.Pop();
 			}
 			// Iterating backwards (pop) through changeStack, reverse order of insertion
 			// and original deletion list.
@@ -266,7 +292,7 @@ void ChangeLog::PopDeletion(Sci::Position position, Sci::Position deleteLength)
 		}
 	}
 
-	if (editions->empty()) {
+	if (editions.Empty()) {
 		deleteEdition.SetValueAt(position, EditionSetOwned{});
 	}
 }
@@ -302,7 +328,7 @@ void ChangeLog::SetSavePoint() {
 		const EditionSetOwned empty{};
 		const EditionSetOwned &editions = deleteEdition.ValueOr(positionDeletion, empty);
 		if (editions) {
-			for (EditionCount &ec : *editions) {
+			for (EditionCount &ec : const_cast<EditionSetOwned &>(editions)) {
 				if (ec.edition == changeModified) {
 					ec.edition = changeSaved;
 				}
@@ -323,13 +349,22 @@ size_t ChangeLog::DeletionCount(Sci::Position start, Sci::Position length) const
 		const EditionSetOwned empty{};
 		const EditionSetOwned &editions = deleteEdition.ValueOr(start, empty);
 		if (editions) {
-			count += EditionSetCount(*editions);
+			count += editions.Count();
 		}
 		start = deleteEdition.PositionNext(start);
 	}
 	return count;
 }
 
+size_t ChangeLog::MemoryUsage() const noexcept {
+	size_t usage = changeStack.MemoryUsage() + insertEdition.MemoryUsage() + deleteEdition.MemoryUsage();
+	const EditionSetOwned empty{};
+	for (Sci::Position element = 0; element < deleteEdition.Elements(); element++) {
+		usage += deleteEdition.ValueOr(deleteEdition.PositionOfElement(element), empty).MemoryUsage();
+	}
+	return usage;
+}
+
 void ChangeLog::Check() const noexcept {
 #ifndef NDEBUG
 	assert(insertEdition.Length() == deleteEdition.Length());
@@ -467,7 +502,7 @@ unsigned int ChangeHistory::EditionDeletesAt(Sci::Position pos) const noexcept {
 	const EditionSetOwned empty{};
 	const EditionSetOwned &editionSetDeletions = changeLog.deleteEdition.ValueOr(pos, empty);
 	if (editionSetDeletions) {
-		for (const EditionCount &ec : *editionSetDeletions) {
+		for (const EditionCount &ec : editionSetDeletions) {
 			editionSet = editionSet | (1u << (ec.edition-1));
 		}
 	}
@@ -498,13 +533,14 @@ size_t ChangeHistory::DeletionCount(Sci::Position start, Sci::Position length) c
 	return changeLog.DeletionCount(start, length);
 }
 
+size_t ChangeHistory::MemoryUsage() const noexcept {
+	return changeLog.MemoryUsage() + (changeLogReversions ? changeLogReversions->MemoryUsage() : 0);
+}
+
 EditionSet ChangeHistory::DeletionsAt(Sci::Position pos) const {
 	const EditionSetOwned empty{};
 	const EditionSetOwned &editions = changeLog.deleteEdition.ValueOr(pos, empty);
-	if (editions) {
-		return *editions;
-	}
-	return {};
+	return editions.ToSet();
 }
 
 void ChangeHistory::Check() const noexcept {
@@ -20,12 +20,15 @@ constexpr unsigned int bitSaved = 2;
 constexpr unsigned int bitModified = 4;
 constexpr unsigned int bitRevertedToModified = 8;
 
+// Deletion spans have zero length, so direction is not stored which keeps the span in 24 bytes.
 struct ChangeSpan {
 	Sci::Position start;
 	Sci::Position length;
 	int edition;
 	int count;
-	enum class Direction { insertion, deletion } direction;
+	[[nodiscard]] constexpr bool IsDeletion() const noexcept {
+		return length == 0;
+	}
 };
 
 struct EditionCount {
@@ -39,7 +42,62 @@ struct EditionCount {
 
 // EditionSet is ordered from oldest to newest, its not really a set
 using EditionSet = std::vector<EditionCount>;
-using EditionSetOwned = std::unique_ptr<EditionSet>;
+
+// Deletions at one position. After replacing text there is usually only one EditionCount,
+// it is stored inline instead of allocating an EditionSet for every replacement.
+class EditionSetOwned {
+	EditionCount single {};
+	std::unique_ptr<EditionSet> set;
+public:
+	EditionSetOwned() noexcept = default;
+	explicit EditionSetOwned(EditionCount ec) noexcept : single{ec} {}
+	EditionSetOwned(const EditionSetOwned &) = delete;
+	EditionSetOwned(EditionSetOwned &&other) noexcept :
+		single{std::exchange(other.single, {})}, set{std::move(other.set)} {}
+	EditionSetOwned &operator=(const EditionSetOwned &) = delete;
+	EditionSetOwned &operator=(EditionSetOwned &&other) noexcept {
+		single = std::exchange(other.single, {});
+		set = std::move(other.set);
+		return *this;
+	}
+	~EditionSetOwned() = default;
+
+	explicit operator bool() const noexcept {
+		return single.count != 0 || set;
+	}
+	// Values are owned, so only empty values are equal
+	bool operator==(const EditionSetOwned &other) const noexcept {
+		return single == other.single && set == other.set;
+	}
+
+	[[nodiscard]] bool Empty() const noexcept {
+		return !*this;
+	}
+	[[nodiscard]] const EditionCount &Back() const noexcept {
+		return set ? set->back() : single;
+	}
+	[[nodiscard]] int Count() const noexcept;
+	void Push(EditionCount ec);
+	void PushFront(EditionCount ec);
+	void Pop() noexcept;
+	[[nodiscard]] EditionSet ToSet() const;
+	[[nodiscard]] size_t MemoryUsage() const noexcept {
+		return set ? sizeof(EditionSet) + set->capacity()*sizeof(EditionCount) : 0;
+	}
+
+	EditionCount *begin() noexcept {
+		return set ? set->data() : &single;
+	}
+	EditionCount *end() noexcept {
+		return set ? set->data() + set->size() : &single + (single.count != 0);
+	}
+	const EditionCount *begin() const noexcept {
+		return set ? set->data() : &single;
+	}
+	const EditionCount *end() const noexcept {
+		return set ? set->data() + set->size() : &single + (single.count != 0);
+	}
+};
 
 class ChangeStack {
 	std::vector<int> steps;
@@ -52,6 +110,7 @@ public:
 	[[nodiscard]] int PopStep() noexcept;
 	[[nodiscard]] ChangeSpan PopSpan(int maxSteps) noexcept;
 	void SetSavePoint() noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 	void Check() const noexcept;
 };
 
@@ -76,6 +135,7 @@ struct ChangeLog {
 
 	Sci::Position Length() const noexcept;
 	[[nodiscard]] size_t DeletionCount(Sci::Position start, Sci::Position length) const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 	void Check() const noexcept;
 };
 
@@ -112,6 +172,8 @@ public:
 	[[nodiscard]] unsigned int EditionDeletesAt(Sci::Position pos) const noexcept;
 	[[nodiscard]] Sci::Position EditionNextDelete(Sci::Position pos) const noexcept;
 
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
+
 	// Testing - not used by Scintilla
 	[[nodiscard]] size_t DeletionCount(Sci::Position start, Sci::Position length) const noexcept;
 	EditionSet DeletionsAt(Sci::Position pos) const;
@@ -47,8 +47,11 @@ class ContractionState final : public IContractionState {
 #endif
 	std::unique_ptr<Partitioning<LINE>> displayLines;
 	Sci::Line linesInDocument = 1;
+	bool batch = false;
+	bool displayChanged = false;
 
 	void EnsureData();
+	void RebuildDisplayLines();
 
 	bool OneToOne() const noexcept {
 		// True when each document line is exactly one display line so need for
@@ -87,6 +90,8 @@ public:
 	bool GetVisible(Sci::Line lineDoc) const noexcept override;
 	bool SetVisible(Sci::Line lineDocStart, Sci::Line lineDocEnd, bool isVisible) override;
 	bool HiddenLines() const noexcept override;
+	void BeginBatch() noexcept override;
+	void EndBatch() override;
 
 #if EnablePerLineFoldDisplayText
 	const char *GetFoldDisplayText(Sci::Line lineDoc) const noexcept override;
@@ -183,6 +188,7 @@ void ContractionState<LINE>::Clear() noexcept {
 #endif
 	displayLines.reset();
 	linesInDocument = 1;
+	displayChanged = false;
 }
 
 #define OneToMany_LinesInDoc()		(displayLines->Partitions() - 1)
@@ -345,6 +351,12 @@ bool ContractionState<LINE>::SetVisible(Sci::Line lineDocStart, Sci::Line lineDo
 		EnsureData();
 		Check();
 		if (InRangeInclusive(lineDocStart, lineDocEnd) && (lineDocEnd < OneToMany_LinesInDoc())) {
+			if (batch) {
+				const bool changed = visible->FillRange(line_cast(lineDocStart), static_cast<char>(isVisible),
+					line_cast(lineDocEnd - lineDocStart) + 1).changed;
+				displayChanged = displayChanged || changed;
+				return changed;
+			}
 			bool changed = false;
 			for (Sci::Line lineDoc = lineDocStart; lineDoc <= lineDocEnd; lineDoc++) {
 				const LINE line = line_cast(lineDoc);
@@ -377,6 +389,43 @@ bool ContractionState<LINE>::HiddenLines() const noexcept {
 	}
 }
 
+template <typename LINE>
+void ContractionState<LINE>::BeginBatch() noexcept {
+	batch = true;
+}
+
+template <typename LINE>
+void ContractionState<LINE>::EndBatch() {
+	batch = false;
+	if (displayChanged) {
+		displayChanged = false;
+		RebuildDisplayLines();
+	}
+	Check();
+}
+
+// Recompute display line of every document line from visible and heights in one pass over their runs.
+template <typename LINE>
+void ContractionState<LINE>::RebuildDisplayLines() {
+	const LINE lines = line_cast(OneToMany_LinesInDoc());
+	// start of each line after the first one, followed by end of last line
+	std::vector<LINE> starts(lines);
+	LINE lineDisplay = 0;
+	LINE lineDoc = 0;
+	while (lineDoc < lines) {
+		const LINE runEnd = std::min({visible->EndRun(lineDoc), heights->EndRun(lineDoc), lines});
+		const LINE height = visible->ValueAt(lineDoc) ? heights->ValueAt(lineDoc) : 0;
+		for (; lineDoc < runEnd; lineDoc++) {
+			lineDisplay += height;
+			starts[lineDoc] = lineDisplay;
+		}
+	}
+	displayLines->DeleteAll();
+	displayLines->InsertPartitions(1, starts.data(), lines);
+	// empty partition after last line
+	displayLines->InsertText(lines, lineDisplay);
+}
+
 #if EnablePerLineFoldDisplayText
 template <typename LINE>
 const char *ContractionState<LINE>::GetFoldDisplayText(Sci::Line lineDoc) const noexcept {
@@ -478,6 +527,11 @@ bool ContractionState<LINE>::SetHeight(Sci::Line lineDoc, int height) {
 		EnsureData();
 		const int h = heights->ValueAt(line_cast(lineDoc));
 		if (h != height) {
+			if (batch) {
+				heights->SetValueAt(line_cast(lineDoc), height);
+				displayChanged = true;
+				return true;
+			}
 			if (visible->ValueAt(line_cast(lineDoc))) {
 				displayLines->InsertText(line_cast(lineDoc), height - h);
 			}
@@ -505,6 +559,10 @@ void ContractionState<LINE>::ShowAll() noexcept {
 #ifdef CHECK_CORRECTNESS
 template <typename LINE>
 void ContractionState<LINE>::Check() const noexcept {
+	if (batch) {
+		// display lines are stale until EndBatch()
+		return;
+	}
 	for (Sci::Line vline = 0; vline < LinesDisplayed(); vline++) {
 		const Sci::Line lineDoc = DocFromDisplay(vline);
 		PLATFORM_ASSERT(GetVisible(lineDoc));
@@ -35,6 +35,10 @@ public:
 	virtual bool GetVisible(Sci::Line lineDoc) const noexcept = 0;
 	virtual bool SetVisible(Sci::Line lineDocStart, Sci::Line lineDocEnd, bool isVisible) = 0;
 	virtual bool HiddenLines() const noexcept = 0;
+	// Between BeginBatch() and EndBatch(), SetVisible() and SetHeight() only record the value,
+	// display lines are rebuilt once by EndBatch() and must not be queried before.
+	virtual void BeginBatch() noexcept = 0;
+	virtual void EndBatch() = 0;
 
 #if EnablePerLineFoldDisplayText
 	virtual const char *GetFoldDisplayText(Sci::Line lineDoc) const noexcept = 0;
@@ -67,6 +67,14 @@ public:
 	Sci::Position EndRun(Sci::Position position) const noexcept override {
 		return rs.EndRun(pos_cast(position));
 	}
+	int RunAt(Sci::Position position, Sci::Position &startRun, Sci::Position &endRun) const noexcept override {
+		POS start = 0;
+		POS end = 0;
+		const int value = rs.RunAt(pos_cast(position), start, end);
+		startRun = start;
+		endRun = end;
+		return value;
+	}
 	void SetValueAt(Sci::Position position, int value) override {
 		rs.SetValueAt(pos_cast(position), value);
 	}
@@ -76,6 +84,9 @@ public:
 	Sci::Position Runs() const noexcept override {
 		return rs.Runs();
 	}
+	size_t MemoryUsage() const noexcept override {
+		return sizeof(Decoration) + rs.MemoryUsage();
+	}
 };
 
 template <typename POS>
@@ -121,6 +132,7 @@ public:
 
 	// Returns changed=true if some values may have changed
 	FillResult<Sci::Position> FillRange(Sci::Position position, int value, Sci::Position fillLength) override;
+	FillResult<Sci::Position> FillRanges(const Sci::Position *ranges, size_t count, int value) override;
 
 	void InsertSpace(Sci::Position position, Sci::Position insertLength) override;
 	void DeleteRange(Sci::Position position, Sci::Position deleteLength) override;
@@ -138,6 +150,14 @@ public:
 	void SetClickNotified(bool notified) noexcept override {
 		clickNotified = notified;
 	}
+
+	size_t MemoryUsage() const noexcept override {
+		size_t usage = decorationList.capacity()*sizeof(void *) + decorationView.capacity()*sizeof(void *);
+		for (const auto &deco : decorationList) {
+			usage += deco->MemoryUsage();
+		}
+		return usage;
+	}
 };
 
 template <typename POS>
@@ -197,6 +217,25 @@ void DecorationList<POS>::SetCurrentValue(int value) noexcept {
 
 template <typename POS>
 FillResult<Sci::Position> DecorationList<POS>::FillRange(Sci::Position position, int value, Sci::Position fillLength) {
+	if (value == 0) {
+		// clearing doesn't create decoration, clearing whole document just drops it
+		if (!current) {
+			current = DecorationFromIndicator(currentIndicator);
+			if (!current) {
+				return { false, position, fillLength };
+			}
+		}
+		if (position == 0 && fillLength == lengthDocument && lengthDocument > 0) {
+			const POS length = pos_cast(lengthDocument);
+			const POS first = current->rs.ValueAt(0) ? 0 : current->rs.EndRun(0);
+			const POS last = current->rs.ValueAt(length - 1) ? length : current->rs.StartRun(length - 1);
+			Delete(currentIndicator);
+			if (first >= last) {
+				return { false, position, fillLength };
+			}
+			return { true, first, last - first };
+		}
+	}
 	if (!current) {
 		current = DecorationFromIndicator(currentIndicator);
 		if (!current) {
@@ -212,6 +251,22 @@ FillResult<Sci::Position> DecorationList<POS>::FillRange(Sci::Position position,
 	return fr;
 }
 
+template <typename POS>
+FillResult<Sci::Position> DecorationList<POS>::FillRanges(const Sci::Position *ranges, size_t count, int value) {
+	if (!current) {
+		current = DecorationFromIndicator(currentIndicator);
+		if (!current) {
+			current = Create(currentIndicator, lengthDocument);
+		}
+	}
+	const FillResult<POS> frInPOS = current->rs.FillRanges(ranges, count, value);
+	const FillResult<Sci::Position> fr{ frInPOS.changed, frInPOS.position, frInPOS.fillLength };
+	if (current->Empty()) {
+		Delete(currentIndicator);
+	}
+	return fr;
+}
+
 template <typename POS>
 void DecorationList<POS>::InsertSpace(Sci::Position position, Sci::Position insertLength) {
 	const bool atEnd = position == lengthDocument;
@@ -16,9 +16,11 @@ public:
 	virtual int ValueAt(Sci::Position position) const noexcept = 0;
 	virtual Sci::Position StartRun(Sci::Position position) const noexcept = 0;
 	virtual Sci::Position EndRun(Sci::Position position) const noexcept = 0;
+	virtual int RunAt(Sci::Position position, Sci::Position &startRun, Sci::Position &endRun) const noexcept = 0;
 	virtual void SetValueAt(Sci::Position position, int value) = 0;
 	virtual void InsertSpace(Sci::Position position, Sci::Position insertLength) = 0;
 	virtual Sci::Position Runs() const noexcept = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
 };
 
 class IDecorationList {
@@ -35,6 +37,7 @@ public:
 
 	// Returns with changed=true if some values may have changed
 	virtual FillResult<Sci::Position> FillRange(Sci::Position position, int value, Sci::Position fillLength) = 0;
+	virtual FillResult<Sci::Position> FillRanges(const Sci::Position *ranges, size_t count, int value) = 0;
 	virtual void InsertSpace(Sci::Position position, Sci::Position insertLength) = 0;
 	virtual void DeleteRange(Sci::Position position, Sci::Position deleteLength) = 0;
 	virtual void DeleteLexerDecorations() = 0;
@@ -46,6 +49,7 @@ public:
 
 	virtual bool ClickNotified() const noexcept = 0;
 	virtual void SetClickNotified(bool notified) noexcept = 0;
+	virtual size_t MemoryUsage() const noexcept = 0;
 };
 
 std::unique_ptr<IDecoration> DecorationCreate(bool largeDocument, int indicator);
@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <atomic>
 
 #include <windows.h>
 #if defined(BOOST_REGEX_STANDALONE)
@@ -51,6 +52,8 @@
 #include "Partitioning.h"
 #include "RunStyles.h"
 #include "CellBuffer.h"
+#include "SearchIndex.h"
+#include "BraceIndex.h"
 #include "PerLine.h"
 #include "CharClassify.h"
 #include "Decoration.h"
@@ -59,6 +62,9 @@
 #include "RESearch.h"
 #include "UniConversion.h"
 #include "ElapsedPeriod.h"
+#include "EventTrace.h"
+#include "ParallelSupport.h"
+#include "BackgroundStyler.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -69,12 +75,21 @@ LexInterface::LexInterface(Document *pdoc_) noexcept : pdoc{pdoc_} {
 
 LexInterface::~LexInterface() noexcept = default;
 
+namespace {
+
+// range of line-local lexer longer than this is lexed concurrently in chunks
+constexpr Sci::Position ParallelColouriseSize = 4*1024*1024;
+
+}
+
 void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 	if (pdoc && instance && !performingStyle) {
 		// Protect against reentrance, which may occur, for example, when
 		// fold points are discovered while performing styling and the folding
 		// code looks for child lines which may trigger styling.
 		performingStyle = true;
+		// lexer instance is not thread safe
+		JoinBackground();
 
 		const Sci::Position lengthDoc = pdoc->LengthNoExcept();
 		if (end < 0) {
@@ -90,10 +105,25 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 			if (start > 0) {
 				styleStart = pdoc->StyleIndexAt(start - 1);
 			}
-			instance->Lex(start, len, styleStart, pdoc);
-			instance->Fold(start, len, styleStart, pdoc);
+			EventTraceActivity activity;
+			EventTraceStart(activity, "Colourise", TraceLoggingString(instance->GetName(), "Lexer"),
+				TraceLoggingInt64(start, "Start"), TraceLoggingInt64(len, "Bytes"));
+			const Sci::Line lineFirst = SaveCheckpoints(start, end);
+			Sci::Position startSerial = start;
+			if (lineLocal && len >= ParallelColouriseSize && pdoc->CanStyleBackground()) {
+				startSerial = ColouriseChunks(start, end);
+				styleStart = (startSerial > 0) ? pdoc->StyleIndexAt(startSerial - 1) : 0;
+			}
+			if (startSerial < end) {
+				instance->Lex(startSerial, end - startSerial, styleStart, pdoc);
+				instance->Fold(startSerial, end - startSerial, styleStart, pdoc);
+			}
+			if (lineFirst >= 0) {
+				RestoreConverged(lineFirst, end);
+			}
+			EventTraceStop(activity, "Colourise", TraceLoggingInt64(pdoc->GetEndStyled(), "EndStyled"));
 			if (enableUrlHighlight) {
-				pdoc->HighlightUrl(start, len, urlIgnoreStyle);
+				pdoc->HighlightUrl(startSerial, end - startSerial, urlIgnoreStyle);
 			}
 		}
 
@@ -101,6 +131,163 @@ void LexInterface::Colourise(Sci::Position start, Sci::Position end) {
 	}
 }
 
+// style [start, end) in chunks on worker thread, returns false when caller should style synchronously.
+bool LexInterface::ColouriseBackground(Sci::Position start, Sci::Position end) {
+	if (!pdoc || !instance || performingStyle) {
+		return false;
+	}
+	if (!background) {
+		background = std::make_unique<BackgroundStyler>(pdoc);
+	}
+	if (background->Running()) {
+		// give worker a little time, but keep responsive to user input
+		if (!background->Wait(1)) {
+			return true;
+		}
+	}
+	if (background->Finished()) {
+		performingStyle = true;
+		Sci::Position position = 0;
+		Sci::Position length = 0;
+		const bool committed = background->Commit(position, length);
+		if (committed && enableUrlHighlight) {
+			pdoc->HighlightUrl(position, length, urlIgnoreStyle);
+		}
+		performingStyle = false;
+		if (!committed && background->Failed()) {
+			return false;
+		}
+		// continue from current end styled, document may be styled or modified since chunk started
+		start = pdoc->LineStartPosition(pdoc->GetEndStyled());
+	}
+	if (start >= end) {
+		return true;
+	}
+	return background->Start(instance.get(), start, end, lineLocal, restartLines, nestedStateMask);
+}
+
+// lex [start, end) in chunks on worker threads and wait for them, returns position to continue lexing serially.
+Sci::Position LexInterface::ColouriseChunks(Sci::Position start, Sci::Position end) {
+	if (!background) {
+		background = std::make_unique<BackgroundStyler>(pdoc);
+	}
+	background->Stop();
+	background->SetForeground(true);
+	while (end - start >= ParallelColouriseSize && background->Start(instance.get(), start, end, lineLocal, restartLines, nestedStateMask)) {
+		background->Join();
+		Sci::Position position = 0;
+		Sci::Position length = 0;
+		if (!background->Commit(position, length)) {
+			break;
+		}
+		if (enableUrlHighlight) {
+			pdoc->HighlightUrl(position, length, urlIgnoreStyle);
+		}
+		// chunks not converged are lexed again from end of committed chunk
+		start = position + length;
+	}
+	background->SetForeground(false);
+	return start;
+}
+
+void LexInterface::JoinBackground() noexcept {
+	if (background) {
+		background->Join();
+	}
+}
+
+void LexInterface::StopBackground() noexcept {
+	if (background) {
+		background->Stop();
+	}
+}
+
+void LexInterface::ModifiedAt(Sci::Position pos) noexcept {
+	if (background) {
+		background->ModifiedAt(pos);
+	}
+	// lexer or document setting changed, can't reuse styles after it
+	styledTail = -1;
+}
+
+void LexInterface::TextModifiedAt(Sci::Position endStyled, Sci::Position pos, Sci::Position lengthChange) noexcept {
+	if (background) {
+		background->ModifiedAt(pos);
+	}
+	if (restartLines == 0) {
+		return;
+	}
+	const Sci::Position lengthDoc = pdoc->LengthNoExcept();
+	const Sci::Position tail = lengthDoc - (pos + std::max<Sci::Position>(lengthChange, 0));
+	if (styledTail < 0) {
+		if (endStyled > pos) {
+			styledTail = lengthDoc - lengthChange - endStyled;
+			unchangedTail = tail;
+		}
+	} else {
+		unchangedTail = std::min(unchangedTail, tail);
+	}
+}
+
+LineCheckpoint LexInterface::GetCheckpoint(Sci::Line line) const noexcept {
+	const Sci::Position lineEnd = pdoc->LineStart(line + 1);
+	const int style = pdoc->StyleIndexAt(lineEnd - 1);
+	return { pdoc->GetLineState(line), pdoc->GetLevel(line), static_cast<unsigned char>(style) };
+}
+
+// save data of lines in unchanged text after modification, returns first saved line or -1.
+Sci::Line LexInterface::SaveCheckpoints(Sci::Position start, Sci::Position end) {
+	checkpoints.clear();
+	if (styledTail < 0) {
+		return -1;
+	}
+	const Sci::Position lengthDoc = pdoc->LengthNoExcept();
+	if (end >= lengthDoc - styledTail || unchangedTail <= styledTail) {
+		// no styles before modification to be reused
+		styledTail = -1;
+		return -1;
+	}
+	// line containing end of modified text may get new line data even when its text is unchanged
+	const Sci::Line lineFirst = std::max(pdoc->SciLineFromPosition(lengthDoc - unchangedTail) + 1, pdoc->SciLineFromPosition(start));
+	const Sci::Line lineLast = pdoc->SciLineFromPosition(end);
+	for (Sci::Line line = lineFirst; line <= lineLast; line++) {
+		checkpoints.push_back(GetCheckpoint(line));
+	}
+	return lineFirst;
+}
+
+// when data of restartLines lines is same as before modification, lexing after them
+// will produce same result as before, so keep the rest styled before modification.
+// lines with nested state (e.g. inside embedded script) are not counted.
+void LexInterface::RestoreConverged(Sci::Line lineFirst, Sci::Position end) {
+	const Sci::Line count = checkpoints.size();
+	int matched = 0;
+	for (Sci::Line index = 0; index < count; index++) {
+		const Sci::Line line = lineFirst + index;
+		if (pdoc->LineStart(line + 1) > end) {
+			break;
+		}
+		const LineCheckpoint &previous = checkpoints[index];
+		if ((previous.lineState & nestedStateMask) == 0 && GetCheckpoint(line) == previous) {
+			matched++;
+			if (matched >= restartLines) {
+				// restore data for remaining lines, which may be changed by looking ahead
+				for (index++; index < count; index++) {
+					const LineCheckpoint &checkpoint = checkpoints[index];
+					pdoc->SetLineState(lineFirst + index, checkpoint.lineState);
+					pdoc->SetLevel(lineFirst + index, checkpoint.level);
+				}
+				pdoc->StartStyling(pdoc->LengthNoExcept() - styledTail);
+				styledTail = -1;
+				break;
+			}
+		} else {
+			matched = 0;
+		}
+	}
+	checkpoints.clear();
+}
+
 bool LexInterface::UseContainerLexing() const noexcept {
 	return !instance;
 }
@@ -151,7 +338,8 @@ CharacterExtracted::CharacterExtracted(const unsigned char *charBytes, size_t wi
 }
 
 Document::Document(DocumentOption options) :
-	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge)),
+	cb(!FlagSet(options, DocumentOption::StylesNone), FlagSet(options, DocumentOption::TextLarge), FlagSet(options, DocumentOption::TextPieces),
+		FlagSet(options, DocumentOption::StylesCompressed)),
 	durationStyleOneUnit(1e-6),
 	decorations{DecorationListCreate(IsLarge())} {
 
@@ -286,6 +474,7 @@ bool Document::SetDBCSCodePage(int dbcsCodePage_) {
 		dbcsCharClass.reset(classify);
 		pcf.reset();
 		regex.reset();
+		braceIndex.reset();
 		cb.SetLineEndTypes(lineEndBitSet & LineEndTypesSupported());
 		cb.SetUTF8Substance(CpUtf8 == dbcsCodePage);
 		ModifiedAt(0);	// Need to restyle whole document
@@ -339,7 +528,7 @@ void Document::TentativeUndo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != ActionType::container) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position, (action.at == ActionType::insert) ? -action.lenData : action.lenData);
 				}
 
 				ModificationFlags modFlags = ModificationFlags::Undo;
@@ -430,6 +619,51 @@ void Document::ChangeLastUndoActionText(size_t length, const char *text) {
 	cb.ChangeLastUndoActionText(length, text);
 }
 
+void Document::SetUndoMemoryLimit(size_t limit) noexcept {
+	cb.SetUndoMemoryLimit(limit);
+}
+
+size_t Document::UndoMemoryLimit() const noexcept {
+	return cb.UndoMemoryLimit();
+}
+
+size_t Document::UndoMemory() const noexcept {
+	return cb.UndoMemory();
+}
+
+size_t Document::MemoryUsage() const noexcept {
+	size_t usage = 0;
+	for (const auto &pl : perLineData) {
+		if (pl) {
+			usage += pl->MemoryUsage();
+		}
+	}
+	return usage;
+}
+
+size_t Document::MemoryUsage(MemoryCategory category) const noexcept {
+	switch (category) {
+	case MemoryCategory::Text:
+		return cb.TextMemory();
+	case MemoryCategory::Styles:
+		return cb.StyleMemory();
+	case MemoryCategory::Lines:
+		return cb.LineMemory();
+	case MemoryCategory::UndoHistory:
+		return cb.UndoMemory();
+	case MemoryCategory::ChangeHistory:
+		return cb.ChangeHistoryMemory();
+	case MemoryCategory::Decorations:
+		return decorations->MemoryUsage();
+	case MemoryCategory::PerLine:
+		return MemoryUsage();
+	case MemoryCategory::SearchIndex:
+		return searchIndex ? searchIndex->MemoryUsage() : 0;
+	default:
+		return 0;
+	}
+}
+
 MarkerMask Document::GetMark(Sci::Line line, bool includeChangeHistory) const noexcept {
 	MarkerMask marksHistory = 0;
 	if (includeChangeHistory && (line < LinesTotal())) {
@@ -461,6 +695,39 @@ Sci::Line Document::MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexc
 	return Markers()->MarkerNext(lineStart, mask);
 }
 
+// same lines as marked by GetMark(), cost is proportional to number of edition runs instead of lines.
+Sci::Line Document::ChangeHistoryLineNext(Sci::Line lineStart, MarkerMask mask) const noexcept {
+	constexpr unsigned int editionShift = static_cast<unsigned int>(MarkerOutline::HistoryRevertedToOrigin);
+	const unsigned int editionMask = mask >> editionShift;
+	if (editionMask == 0 || lineStart >= LinesTotal()) {
+		return -1;
+	}
+
+	const Sci::Position length = LengthNoExcept();
+	const Sci::Position start = LineStart(std::max<Sci::Line>(lineStart, 0));
+	Sci::Position found = length + 1;
+	for (Sci::Position position = start; position < length;) {
+		const int edition = EditionAt(position);
+		if (edition && (editionMask & (1U << (edition - 1)))) {
+			found = position;
+			break;
+		}
+		position = EditionEndRun(position);
+	}
+	for (Sci::Position position = start; position < found;) {
+		if (EditionDeletesAt(position) & editionMask) {
+			found = position;
+			break;
+		}
+		position = EditionNextDelete(position);
+	}
+	return (found > length) ? -1 : SciLineFromPosition(found);
+}
+
+Sci::Line Document::MarkerPrevious(Sci::Line lineStart, MarkerMask mask) const noexcept {
+	return Markers()->MarkerPrevious(lineStart, mask);
+}
+
 int Document::AddMark(Sci::Line line, int markerNum) {
 	const Sci::Line lines = LinesTotal();
 	if (IsValidIndex(line, lines)) {
@@ -486,6 +753,17 @@ void Document::AddMarkSet(Sci::Line line, MarkerMask valueSet) {
 	NotifyModified(mh);
 }
 
+// single notification for all lines
+Sci::Line Document::AddMarkLines(const Sci::Line *lineList, int markerNum) {
+	const Sci::Line count = Markers()->AddMarkLines(lineList, markerNum, LinesTotal());
+	if (count != 0) {
+		DocModification mh(ModificationFlags::ChangeMarker);
+		mh.line = -1;
+		NotifyModified(mh);
+	}
+	return count;
+}
+
 void Document::DeleteMark(Sci::Line line, int markerNum) {
 	Markers()->DeleteMark(line, markerNum, false);
 	const DocModification mh(ModificationFlags::ChangeMarker, LineStart(line), 0, 0, nullptr, line);
@@ -500,13 +778,7 @@ void Document::DeleteMarkFromHandle(int markerHandle) {
 }
 
 void Document::DeleteAllMarks(int markerNum) {
-	bool someChanges = false;
-	const Sci::Line lines = LinesTotal();
-	for (Sci::Line line = 0; line < lines; line++) {
-		if (Markers()->DeleteMark(line, markerNum, true))
-			someChanges = true;
-	}
-	if (someChanges) {
+	if (Markers()->DeleteAllMarks(markerNum)) {
 		DocModification mh(ModificationFlags::ChangeMarker);
 		mh.line = -1;
 		NotifyModified(mh);
@@ -594,11 +866,11 @@ Sci::Position Document::VCHomePosition(Sci::Position position) const noexcept {
 		return startText;
 }
 
-Sci::Position Document::IndexLineStart(Sci::Line line, LineCharacterIndexType lineCharacterIndex) const noexcept {
+Sci::Position Document::IndexLineStart(Sci::Line line, LineCharacterIndexType lineCharacterIndex) const {
 	return cb.IndexLineStart(line, lineCharacterIndex);
 }
 
-Sci::Line Document::LineFromPositionIndex(Sci::Position pos, LineCharacterIndexType lineCharacterIndex) const noexcept {
+Sci::Line Document::LineFromPositionIndex(Sci::Position pos, LineCharacterIndexType lineCharacterIndex) const {
 	return cb.LineFromPositionIndex(pos, lineCharacterIndex);
 }
 
@@ -624,6 +896,23 @@ int SCI_METHOD Document::SetLevel(Sci_Line line, int level) {
 	return prev;
 }
 
+void SCI_METHOD Document::SetLevels(Sci_Line lineStart, Sci_Line count, const int *levels) {
+	const Sci::Line lines = LinesTotal();
+	count = std::min(count, lines - lineStart);
+	for (Sci::Line index = 0; index < count; index++) {
+		const Sci::Line line = lineStart + index;
+		const int level = levels[index];
+		const int prev = Levels()->SetLevel(line, level, lines);
+		if (prev != level) {
+			DocModification mh(ModificationFlags::ChangeFold | ModificationFlags::ChangeMarker,
+				LineStart(line), 0, 0, nullptr, line);
+			mh.foldLevelNow = static_cast<FoldLevel>(level);
+			mh.foldLevelPrev = static_cast<FoldLevel>(prev);
+			NotifyModified(mh);
+		}
+	}
+}
+
 FoldLevel Document::GetFoldLevel(Sci_Position line) const noexcept {
 	return static_cast<FoldLevel>(Levels()->GetLevel(line));
 }
@@ -658,6 +947,11 @@ Sci::Line Document::GetLastChild(Sci::Line lineParent, FoldLevel level, Sci::Lin
 	}
 	Sci::Line lineEndStyled = SciLineFromPosition(GetEndStyled()) - 1;
 	Sci::Line lineMaxSubord = lineParent;
+	FoldLevelRange &childRange = Levels()->ChildRange();
+	if (childRange.valid && childRange.start == lineParent && childRange.level == levelStart) {
+		// lines before range end are subordinate, start after styled lines and lastLine are checked
+		lineMaxSubord = std::max(lineParent, std::min({childRange.end - 1, lastLine, lineEndStyled}));
+	}
 	while (lineMaxSubord < maxLine) {
 		if (lineMaxSubord >= lineEndStyled) {
 			// two or more lines are required to make stable fold for most lexer
@@ -671,6 +965,9 @@ Sci::Line Document::GetLastChild(Sci::Line lineParent, FoldLevel level, Sci::Lin
 			break;
 		lineMaxSubord++;
 	}
+	if (!(childRange.valid && childRange.start == lineParent && childRange.level == levelStart && childRange.end > lineMaxSubord)) {
+		childRange.Set(lineParent, lineMaxSubord + 1, levelStart);
+	}
 	if (lineMaxSubord > lineParent) {
 		if (levelStart > LevelNumberPart(GetFoldLevel(lineMaxSubord + 1))) {
 			// Have chewed up some whitespace that belongs to a parent so seek back
@@ -726,14 +1023,23 @@ void Document::GetHighlightDelimiters(HighlightDelimiter &highlightDelimiter, Sc
 		}
 	}
 	if (firstChangeableLineBefore < 0) {
-		for (lookLine = line - 1, lookLineLevel = GetFoldLevel(lookLine), lookLineLevelNum = LevelNumberPart(lookLineLevel);
-			lookLine >= beginFoldBlock;
-			lookLineLevel = GetFoldLevel(--lookLine), lookLineLevelNum = LevelNumberPart(lookLineLevel)) {
-			if (LevelIsWhitespace(lookLineLevel) || (lookLineLevelNum > LevelNumberPart(level))) {
+		const FoldLevel levelNum = LevelNumberPart(level);
+		FoldLevelRange &changeableRange = Levels()->ChangeableRange();
+		lookLine = line - 1;
+		while (lookLine >= beginFoldBlock) {
+			if (changeableRange.Contains(lookLine) && levelNum >= changeableRange.level) {
+				// skip lines checked by previous call
+				lookLine = changeableRange.start;
+				continue;
+			}
+			lookLineLevel = GetFoldLevel(lookLine);
+			if (LevelIsWhitespace(lookLineLevel) || (LevelNumberPart(lookLineLevel) > levelNum)) {
 				firstChangeableLineBefore = lookLine;
 				break;
 			}
+			lookLine--;
 		}
+		changeableRange.Set(std::max(lookLine, beginFoldBlock - 1), line, levelNum);
 	}
 	if (firstChangeableLineBefore < 0)
 		firstChangeableLineBefore = beginFoldBlock - 1;
@@ -1298,6 +1604,16 @@ EncodingFamily Document::CodePageFamily() const noexcept {
 void Document::ModifiedAt(Sci::Position pos) noexcept {
 	if (endStyled > pos)
 		endStyled = pos;
+	if (pli)
+		pli->ModifiedAt(pos);
+}
+
+// text inserted (lengthChange > 0) or deleted (lengthChange < 0) at pos
+void Document::TextModifiedAt(Sci::Position pos, Sci::Position lengthChange) noexcept {
+	if (pli)
+		pli->TextModifiedAt(endStyled, pos, lengthChange);
+	if (endStyled > pos)
+		endStyled = pos;
 }
 
 void Document::CheckReadOnly() noexcept {
@@ -1351,9 +1667,9 @@ bool Document::DeleteChars(Sci::Position pos, Sci::Position len) {
 		if (startSavePoint && cb.IsCollectingUndo())
 			NotifySavePoint(false);
 		if ((pos < LengthNoExcept()) || (pos == 0))
-			ModifiedAt(pos);
+			TextModifiedAt(pos, -len);
 		else
-			ModifiedAt(pos - 1);
+			TextModifiedAt(pos - 1, -len);
 		NotifyModified(
 			DocModification(
 				ModificationFlags::DeleteText | ModificationFlags::User |
@@ -1438,7 +1754,7 @@ Sci::Position Document::InsertString(Sci::Position position, const char *s, Sci:
 #endif
 	if (startSavePoint && cb.IsCollectingUndo())
 		NotifySavePoint(false);
-	ModifiedAt(position);
+	TextModifiedAt(position, insertLength);
 	NotifyModified(
 		DocModification(
 			ModificationFlags::InsertText | ModificationFlags::User |
@@ -1504,10 +1820,11 @@ Sci::Position Document::Undo() {
 				}
 				cb.PerformUndoStep();
 				if (action.at != ActionType::container) {
+					const Sci::Position lengthChange = (action.at == ActionType::insert) ? -action.lenData : action.lenData;
 					if ((action.at == ActionType::insert) && (action.position >= LengthNoExcept()) && (action.position > 0))
-						ModifiedAt(action.position - 1);
+						TextModifiedAt(action.position - 1, lengthChange);
 					else
-						ModifiedAt(action.position);
+						TextModifiedAt(action.position, lengthChange);
 					newPos = action.position;
 				}
 
@@ -1574,7 +1891,7 @@ Sci::Position Document::Redo() {
 				}
 				cb.PerformRedoStep();
 				if (action.at != ActionType::container) {
-					ModifiedAt(action.position);
+					TextModifiedAt(action.position, (action.at == ActionType::insert) ? action.lenData : -action.lenData);
 					newPos = action.position;
 				}
 
@@ -1640,19 +1957,213 @@ void Document::DelCharBack(Sci::Position pos) {
 	}
 }
 
+namespace {
+
+// scan 16 or 32 bytes at once, text is indexed by document position.
+
+// find first byte in [pos, end) not a space or tab, returns end when not found
+Sci::Position SkipSpaceTab(const char *text, Sci::Position pos, Sci::Position end) noexcept {
+#if NP2_USE_AVX2
+	const __m256i vectSpace = _mm256_set1_epi8(' ');
+	const __m256i vectTab = _mm256_set1_epi8('\t');
+	for (; pos + static_cast<Sci::Position>(sizeof(__m256i)) <= end; pos += sizeof(__m256i)) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		const uint32_t mask = mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectSpace), _mm256_cmpeq_epi8(chunk, vectTab)));
+		if (mask != UINT32_MAX) {
+			return pos + np2::ctz(~mask);
+		}
+	}
+#elif NP2_USE_SSE2
+	const __m128i vectSpace = _mm_set1_epi8(' ');
+	const __m128i vectTab = _mm_set1_epi8('\t');
+	for (; pos + static_cast<Sci::Position>(sizeof(__m128i)) <= end; pos += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		const uint32_t mask = mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vectSpace), _mm_cmpeq_epi8(chunk, vectTab)));
+		if (mask != 0xffff) {
+			return pos + np2::ctz(~mask);
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		if (!IsSpaceOrTab(text[pos])) {
+			break;
+		}
+	}
+	return pos;
+}
+
+// classify ASCII bytes against one character class, non-ASCII bytes never match.
+class ASCIIClassScanner {
+	const CharClassify &charClass;
+	const CharacterClass cc;
+#if NP2_USE_AVX2
+	// bit h of rows[l] is set when character h*16 + l has the class.
+	bool hasRows = false;
+	alignas(16) uint8_t rows[16]{};
+
+	// mask of bytes in the 32 byte chunk without the class
+	uint32_t Mismatch(const unsigned char *text) noexcept {
+		if (!hasRows) {
+			hasRows = true;
+			for (unsigned ch = 0; ch < 0x80; ch++) {
+				if (charClass.GetClass(static_cast<unsigned char>(ch)) == cc) {
+					rows[ch & 15] |= 1 << (ch >> 4);
+				}
+			}
+		}
+		const __m256i vectRows = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(rows)));
+		// high nibble 8 to 15 gives zero bit.
+		const __m256i vectBits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+			1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+		const __m256i lowNibble = _mm256_set1_epi8(15);
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text));
+		const __m256i high = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), lowNibble);
+		const __m256i row = _mm256_shuffle_epi8(vectRows, _mm256_and_si256(chunk, lowNibble));
+		const __m256i bit = _mm256_shuffle_epi8(vectBits, high);
+		return mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256()));
+	}
+#endif
+
+	bool Match(unsigned char ch) const noexcept {
+		return UTF8IsAscii(ch) && charClass.GetClass(ch) == cc;
+	}
+
+public:
+	// most words are short, the vector table is built after this many matched bytes.
+	static constexpr Sci::Position scalarLength = 16;
+
+	ASCIIClassScanner(const CharClassify &charClass_, CharacterClass cc_) noexcept:
+		charClass{charClass_}, cc{cc_} {}
+
+	// first position in [pos, end) without the class
+	Sci::Position Forward(const char *text, Sci::Position pos, Sci::Position end) noexcept {
+		const unsigned char *ptr = reinterpret_cast<const unsigned char *>(text);
+		const Sci::Position scalarEnd = std::min(pos + scalarLength, end);
+		for (; pos < scalarEnd; pos++) {
+			if (!Match(ptr[pos])) {
+				return pos;
+			}
+		}
+#if NP2_USE_AVX2
+		for (; pos + static_cast<Sci::Position>(sizeof(__m256i)) <= end; pos += sizeof(__m256i)) {
+			const uint32_t mask = Mismatch(ptr + pos);
+			if (mask) {
+				return pos + np2::ctz(mask);
+			}
+		}
+#endif
+		for (; pos < end; pos++) {
+			if (!Match(ptr[pos])) {
+				break;
+			}
+		}
+		return pos;
+	}
+
+	// last position in [start, pos) where the byte before has the class, start when all match
+	Sci::Position Backward(const char *text, Sci::Position start, Sci::Position pos) noexcept {
+		const unsigned char *ptr = reinterpret_cast<const unsigned char *>(text);
+		const Sci::Position scalarStart = std::max(pos - scalarLength, start);
+		for (; pos > scalarStart; pos--) {
+			if (!Match(ptr[pos - 1])) {
+				return pos;
+			}
+		}
+#if NP2_USE_AVX2
+		for (; pos - static_cast<Sci::Position>(sizeof(__m256i)) >= start; pos -= sizeof(__m256i)) {
+			const uint32_t mask = Mismatch(ptr + pos - sizeof(__m256i));
+			if (mask) {
+				return pos - sizeof(__m256i) + np2_bsr(mask) + 1;
+			}
+		}
+#endif
+		for (; pos > start; pos--) {
+			if (!Match(ptr[pos - 1])) {
+				break;
+			}
+		}
+		return pos;
+	}
+};
+
+}
+
+Sci::Position Document::SkipSpaceOrTab(Sci::Position pos, Sci::Position end) const noexcept {
+	while (pos < end) {
+		Sci::Position segmentStart;
+		Sci::Position segmentEnd;
+		const char * const text = cb.TextSegment(pos, segmentStart, segmentEnd);
+		const Sci::Position limit = std::min(end, segmentEnd);
+		pos = SkipSpaceTab(text, pos, limit);
+		if (pos < limit) {
+			break;
+		}
+	}
+	return pos;
+}
+
+Sci::Position Document::SkipCharacterClass(Sci::Position pos, CharacterClass cc, int delta) const noexcept {
+	ASCIIClassScanner scanner(charClass, cc);
+	Sci::Position segmentStart;
+	Sci::Position segmentEnd;
+	if (delta < 0) {
+		// ASCII byte may be trail byte of DBCS character
+		const bool scanASCII = dbcsCodePage == 0 || dbcsCodePage == CpUtf8;
+		while (pos > 0) {
+			if (scanASCII) {
+				const char * const text = cb.TextSegment(pos - 1, segmentStart, segmentEnd);
+				const Sci::Position next = scanner.Backward(text, segmentStart, pos);
+				if (next == segmentStart && next != pos) {
+					// whole segment matched, continue with previous segment
+					pos = next;
+					continue;
+				}
+				pos = next;
+				if (pos == 0) {
+					break;
+				}
+			}
+			const CharacterExtracted ce = CharacterBefore(pos);
+			if (WordCharacterClass(ce.character) != cc) {
+				break;
+			}
+			pos -= ce.widthBytes;
+		}
+	} else {
+		const Sci::Position length = LengthNoExcept();
+		while (pos < length) {
+			const char * const text = cb.TextSegment(pos, segmentStart, segmentEnd);
+			const Sci::Position limit = std::min(length, segmentEnd);
+			const Sci::Position next = scanner.Forward(text, pos, limit);
+			if (next == limit && next != pos) {
+				pos = next;
+				continue;
+			}
+			pos = next;
+			if (pos >= length) {
+				break;
+			}
+			// non-ASCII character or ASCII character with different class
+			const CharacterExtracted ce = CharacterAfter(pos);
+			if (WordCharacterClass(ce.character) != cc) {
+				break;
+			}
+			pos += ce.widthBytes;
+		}
+	}
+	return pos;
+}
+
 int SCI_METHOD Document::GetLineIndentation(Sci_Line line) const noexcept {
 	int indent = 0;
 	if (IsValidIndex(line, LinesTotal())) {
 		const Sci::Position lineStart = LineStart(line);
-		const Sci::Position length = LengthNoExcept();
-		for (Sci::Position i = lineStart; i < length; i++) {
-			const char ch = cb.CharAt(i);
-			if (ch == ' ')
+		const Sci::Position indentPos = SkipSpaceOrTab(lineStart, LengthNoExcept());
+		for (Sci::Position i = lineStart; i < indentPos; i++) {
+			if (cb.CharAt(i) == ' ')
 				indent++;
-			else if (ch == '\t')
-				indent = static_cast<int>(NextTab(indent, tabInChars));
 			else
-				return indent;
+				indent = static_cast<int>(NextTab(indent, tabInChars));
 		}
 	}
 	return indent;
@@ -1686,12 +2197,7 @@ Sci::Position Document::SetLineIndentation(Sci::Line line, Sci::Position indent)
 Sci::Position Document::GetLineIndentPosition(Sci::Line line) const noexcept {
 	if (line < 0)
 		return 0;
-	Sci::Position pos = cb.LineStart(line);
-	const Sci::Position length = LengthNoExcept();
-	while ((pos < length) && IsSpaceOrTab(cb.CharAt(pos))) {
-		pos++;
-	}
-	return pos;
+	return SkipSpaceOrTab(cb.LineStart(line), LengthNoExcept());
 }
 
 Sci::Position Document::GetColumn(Sci::Position pos) const noexcept {
@@ -1722,58 +2228,473 @@ Sci::Position Document::GetColumn(Sci::Position pos) const noexcept {
 	return column;
 }
 
-Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position endPos) const noexcept {
-	startPos = MovePositionOutsideChar(startPos, 1, false);
-	endPos = MovePositionOutsideChar(endPos, -1, false);
-	Sci::Position count = 0;
-	Sci::Position i = startPos;
-	while (i < endPos) {
-		count++;
-		i = NextPosition(i, 1);
-	}
-	return count;
-}
-
-void Document::CountCharactersAndColumns(sptr_t lParam) const noexcept {
-	TextToFindFull *ft = AsPointer<TextToFindFull *>(lParam);
-	const Sci::Position startPos = ft->chrg.cpMin;
-	const Sci::Position endPos = ft->chrg.cpMax;
-	Sci::Position count = ft->chrgText.cpMin;
-	Sci::Position column = ft->chrgText.cpMax;
+namespace {
 
-	Sci::Position i = startPos;
-	while (i < endPos) {
-		const unsigned char ch = cb.UCharAt(i);
-		if (ch == '\t') {
-			column = NextTab(column, tabInChars);
-			i++;
-		} else if (UTF8IsAscii(ch)) {
-			column++;
-			i++;
-		} else {
-			column++;
-			i = NextPosition(i, 1);
+// count characters above this size on multiple threads
+constexpr Sci::Position ParallelCountBlockSize = 1024*1024;
+constexpr Sci::Position ParallelCountMinLength = 4*ParallelCountBlockSize;
+
+// find first non-ASCII byte in [pos, end), returns end when not found
+size_t SkipASCII(const unsigned char *text, size_t pos, size_t end) noexcept {
+#if NP2_USE_AVX2
+	for (; pos + sizeof(__m256i) <= end; pos += sizeof(__m256i)) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		const uint32_t mask = mm256_movemask_epi8(chunk);
+		if (mask) {
+			return pos + np2::ctz(mask);
 		}
-		count++;
 	}
-
-	ft->chrgText.cpMin = count;
-	ft->chrgText.cpMax = column;
+#elif NP2_USE_SSE2
+	for (; pos + sizeof(__m128i) <= end; pos += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		const uint32_t mask = mm_movemask_epi8(chunk);
+		if (mask) {
+			return pos + np2::ctz(mask);
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		if (!UTF8IsAscii(text[pos])) {
+			break;
+		}
+	}
+	return pos;
 }
 
-Sci::Position Document::CountUTF16(Sci::Position startPos, Sci::Position endPos) const noexcept {
-	startPos = MovePositionOutsideChar(startPos, 1, false);
-	endPos = MovePositionOutsideChar(endPos, -1, false);
+// count characters same as moving with Document::NextPosition(), dbcs is nullptr for UTF-8.
+class CharacterCounter {
+	const DBCSCharClassify * const dbcs;
+	const bool countUTF16;
+
+public:
 	Sci::Position count = 0;
-	Sci::Position i = startPos;
-	while (i < endPos) {
+
+	CharacterCounter(const DBCSCharClassify *dbcs_, bool countUTF16_) noexcept:
+		dbcs{dbcs_}, countUTF16{countUTF16_} {}
+
+	// width of non-ASCII character with available bytes
+	size_t CharacterWidth(const unsigned char *text, size_t available) noexcept {
 		count++;
-		const Sci::Position next = NextPosition(i, 1);
-		if ((next - i) > 3)
-			count++;
-		i = next;
-	}
-	return count;
+		if (dbcs) {
+			return (available > 1 && dbcs->IsLeadByte(text[0]) && dbcs->IsTrailByte(text[1])) ? 2 : 1;
+		}
+		const size_t widthCharBytes = UTF8BytesOfLead(text[0]);
+		if (widthCharBytes == 1) {
+			return 1;
+		}
+		const int utf8status = UTF8ClassifyMulti(text, std::min(widthCharBytes, available));
+		if (utf8status & UTF8MaskInvalid) {
+			return 1;
+		}
+		const size_t width = utf8status & UTF8MaskWidth;
+		if (countUTF16 && width == UTF8MaxBytes) {
+			count++;
+		}
+		return width;
+	}
+
+	// returns position of first character continues after length
+	size_t Count(const unsigned char *text, size_t length) noexcept {
+		size_t pos = 0;
+		while (pos < length) {
+			const unsigned char ch = text[pos];
+			if (UTF8IsAscii(ch)) {
+				const size_t end = SkipASCII(text, pos + 1, length);
+				count += end - pos;
+				pos = end;
+				continue;
+			}
+			const size_t available = length - pos;
+			if ((dbcs ? (available < 2 && dbcs->IsLeadByte(ch)) : (static_cast<size_t>(UTF8BytesOfLead(ch)) > available))) {
+				break;
+			}
+			pos += CharacterWidth(text + pos, available);
+		}
+		return pos;
+	}
+
+	void Count(const SplitRange &range) noexcept {
+		const unsigned char *segment1 = reinterpret_cast<const unsigned char *>(range.segment1);
+		const unsigned char *segment2 = reinterpret_cast<const unsigned char *>(range.segment2);
+		const size_t length1 = range.length1;
+		const size_t length2 = range.length2;
+		size_t pos = Count(segment1, length1);
+		while (pos < length1) {
+			// character crosses the gap or range end
+			unsigned char buffer[UTF8MaxBytes];
+			const size_t tail = length1 - pos;
+			const size_t head = std::min(UTF8MaxBytes - tail, length2);
+			memcpy(buffer, segment1 + pos, tail);
+			memcpy(buffer + tail, segment2, head);
+			pos += CharacterWidth(buffer, tail + head);
+		}
+		pos -= length1;
+		if (pos < length2) {
+			pos += Count(segment2 + pos, length2 - pos);
+			while (pos < length2) {
+				pos += CharacterWidth(segment2 + pos, length2 - pos);
+			}
+		}
+	}
+};
+
+// split UTF-8 text into blocks at character boundary, non-trail byte always starts a character.
+class CharacterCountWorker {
+	const SplitRange range;
+	const Sci::Position length;
+	const size_t blockCount;
+	const bool countUTF16;
+	std::atomic<size_t> nextBlock = 0;
+
+	unsigned char ByteAt(Sci::Position position) const noexcept {
+		if (position < range.length1) {
+			return range.segment1[position];
+		}
+		return range.segment2[position - range.length1];
+	}
+
+	Sci::Position BlockStart(size_t index) const noexcept {
+		Sci::Position position = index*ParallelCountBlockSize;
+		if (position == 0 || position >= length) {
+			return std::min(position, length);
+		}
+		// valid character has at most three trail bytes
+		for (int count = 1; count < UTF8MaxBytes && position < length; count++) {
+			if (!UTF8IsTrailByte(ByteAt(position))) {
+				break;
+			}
+			position++;
+		}
+		return position;
+	}
+
+	SplitRange SubRange(Sci::Position start, Sci::Position end) const noexcept {
+		if (end <= range.length1) {
+			return { range.segment1 + start, end - start };
+		}
+		if (start >= range.length1) {
+			return { range.segment2 + start - range.length1, end - start };
+		}
+		return { range.segment1 + start, range.length1 - start, range.segment2, end - range.length1 };
+	}
+
+public:
+	std::atomic<Sci::Position> count = 0;
+
+	CharacterCountWorker(const SplitRange &range_, bool countUTF16_) noexcept:
+		range{range_}, length{range_.length1 + range_.length2},
+		blockCount{static_cast<size_t>((length + ParallelCountBlockSize - 1) / ParallelCountBlockSize)},
+		countUTF16{countUTF16_} {}
+
+	void Run() noexcept {
+		const uint32_t threadCount = std::min<uint32_t>(GetHardwareConcurrency(), static_cast<uint32_t>(blockCount));
+		RunParallelWork(*this, threadCount);
+	}
+
+	void DoWork() noexcept {
+		while (true) {
+			const size_t index = nextBlock.fetch_add(1, std::memory_order_relaxed);
+			if (index >= blockCount) {
+				break;
+			}
+			const Sci::Position start = BlockStart(index);
+			const Sci::Position end = BlockStart(index + 1);
+			if (start < end) {
+				CharacterCounter counter{nullptr, countUTF16};
+				counter.Count(SubRange(start, end));
+				count.fetch_add(counter.count, std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+}
+
+// count characters like moving with NextPosition() from startPos to endPos.
+Sci::Position Document::CountCharactersInRange(Sci::Position startPos, Sci::Position endPos, bool countUTF16) const noexcept {
+	if (startPos >= endPos) {
+		return 0;
+	}
+	if (!dbcsCodePage) {
+		return endPos - startPos;
+	}
+	const SplitRange range = cb.RangeView(startPos, endPos - startPos);
+	if (CpUtf8 == dbcsCodePage && endPos - startPos >= ParallelCountMinLength) {
+		CharacterCountWorker worker{range, countUTF16};
+		worker.Run();
+		return worker.count.load(std::memory_order_relaxed);
+	}
+	CharacterCounter counter{(CpUtf8 == dbcsCodePage) ? nullptr : dbcsCharClass.get(), countUTF16};
+	counter.Count(range);
+	return counter.count;
+}
+
+Sci::Position Document::CountCharacters(Sci::Position startPos, Sci::Position endPos) const noexcept {
+	startPos = MovePositionOutsideChar(startPos, 1, false);
+	endPos = MovePositionOutsideChar(endPos, -1, false);
+	return CountCharactersInRange(startPos, endPos, false);
+}
+
+void Document::CountCharactersAndColumns(sptr_t lParam) const noexcept {
+	TextToFindFull *ft = AsPointer<TextToFindFull *>(lParam);
+	const Sci::Position startPos = ft->chrg.cpMin;
+	const Sci::Position endPos = ft->chrg.cpMax;
+	Sci::Position count = ft->chrgText.cpMin;
+	Sci::Position column = ft->chrgText.cpMax;
+
+	Sci::Position i = startPos;
+	while (i < endPos) {
+		const unsigned char ch = cb.UCharAt(i);
+		if (ch == '\t') {
+			column = NextTab(column, tabInChars);
+			i++;
+		} else if (UTF8IsAscii(ch)) {
+			column++;
+			i++;
+		} else {
+			column++;
+			i = NextPosition(i, 1);
+		}
+		count++;
+	}
+
+	ft->chrgText.cpMin = count;
+	ft->chrgText.cpMax = column;
+}
+
+Sci::Position Document::CountUTF16(Sci::Position startPos, Sci::Position endPos) const noexcept {
+	startPos = MovePositionOutsideChar(startPos, 1, false);
+	endPos = MovePositionOutsideChar(endPos, -1, false);
+	return CountCharactersInRange(startPos, endPos, true);
+}
+
+namespace {
+
+struct TextCounts {
+	Sci::Position characters = 0;
+	Sci::Position utf16Units = 0;
+	Sci::Position words = 0;
+	Sci::Position lines = 0;
+	Sci::Position emptyLines = 0;
+	Sci::Position longestLine = 0;
+	Sci::Position invalidBytes = 0;
+
+	void Add(const TextCounts &other) noexcept {
+		characters += other.characters;
+		utf16Units += other.utf16Units;
+		words += other.words;
+		lines += other.lines;
+		emptyLines += other.emptyLines;
+		longestLine = std::max(longestLine, other.longestLine);
+		invalidBytes += other.invalidBytes;
+	}
+};
+
+// characters are split same as CharacterCounter, words are runs of word class characters,
+// each CJK character is a word. lines are split at CR, LF and CR+LF.
+class TextStatisticsCounter {
+	const Document &doc;
+	const DBCSCharClassify * const dbcs;
+	const bool multiByte;
+	bool inWord = false;
+	bool afterCR = false;
+	Sci::Position lineLength = 0;
+
+	void AddCharacter(unsigned int ch) noexcept {
+		counts.characters++;
+		counts.utf16Units++;
+		if (ch == '\n') {
+			if (!afterCR) {
+				EndLine();
+			}
+			afterCR = false;
+			inWord = false;
+			return;
+		}
+		afterCR = ch == '\r';
+		if (afterCR) {
+			EndLine();
+			inWord = false;
+			return;
+		}
+		lineLength++;
+		const CharacterClass cc = doc.WordCharacterClass(ch);
+		if (cc == CharacterClass::cjkWord) {
+			counts.words++;
+			inWord = false;
+		} else {
+			const bool word = cc == CharacterClass::word;
+			counts.words += word && !inWord;
+			inWord = word;
+		}
+	}
+
+	// width of non-ASCII character with available bytes
+	size_t CharacterWidth(const unsigned char *text, size_t available) noexcept {
+		if (!multiByte) {
+			AddCharacter(text[0]);
+			return 1;
+		}
+		if (dbcs) {
+			if (available > 1 && dbcs->IsLeadByte(text[0]) && dbcs->IsTrailByte(text[1])) {
+				AddCharacter((text[0] << 8) | text[1]);
+				return 2;
+			}
+			counts.invalidBytes += dbcs->IsLeadByte(text[0]);
+			AddCharacter(text[0]);
+			return 1;
+		}
+		const size_t widthCharBytes = UTF8BytesOfLead(text[0]);
+		const int utf8status = (widthCharBytes == 1) ? UTF8MaskInvalid : UTF8ClassifyMulti(text, std::min(widthCharBytes, available));
+		if (utf8status & UTF8MaskInvalid) {
+			counts.invalidBytes++;
+			AddCharacter(unicodeReplacementChar);
+			return 1;
+		}
+		const size_t width = utf8status & UTF8MaskWidth;
+		AddCharacter(UnicodeFromUTF8(text));
+		if (width == UTF8MaxBytes) {
+			counts.utf16Units++;
+		}
+		return width;
+	}
+
+	// returns position of first character continues after length
+	size_t Count(const unsigned char *text, size_t length) noexcept {
+		size_t pos = 0;
+		while (pos < length) {
+			const unsigned char ch = text[pos];
+			if (UTF8IsAscii(ch)) {
+				AddCharacter(ch);
+				pos++;
+				continue;
+			}
+			const size_t available = length - pos;
+			if (multiByte && (dbcs ? (available < 2 && dbcs->IsLeadByte(ch)) : (static_cast<size_t>(UTF8BytesOfLead(ch)) > available))) {
+				break;
+			}
+			pos += CharacterWidth(text + pos, available);
+		}
+		return pos;
+	}
+
+public:
+	TextCounts counts;
+
+	TextStatisticsCounter(const Document &doc_, const DBCSCharClassify *dbcs_, bool multiByte_) noexcept:
+		doc{doc_}, dbcs{dbcs_}, multiByte{multiByte_} {}
+
+	void EndLine() noexcept {
+		counts.lines++;
+		counts.emptyLines += lineLength == 0;
+		counts.longestLine = std::max(counts.longestLine, lineLength);
+		lineLength = 0;
+	}
+
+	void Count(const SplitRange &range) noexcept {
+		const unsigned char *segment1 = reinterpret_cast<const unsigned char *>(range.segment1);
+		const unsigned char *segment2 = reinterpret_cast<const unsigned char *>(range.segment2);
+		const size_t length1 = range.length1;
+		const size_t length2 = range.length2;
+		size_t pos = Count(segment1, length1);
+		while (pos < length1) {
+			// character crosses the gap or range end
+			unsigned char buffer[UTF8MaxBytes];
+			const size_t tail = length1 - pos;
+			const size_t head = std::min(UTF8MaxBytes - tail, length2);
+			memcpy(buffer, segment1 + pos, tail);
+			memcpy(buffer + tail, segment2, head);
+			pos += CharacterWidth(buffer, tail + head);
+		}
+		pos -= length1;
+		if (pos < length2) {
+			pos += Count(segment2 + pos, length2 - pos);
+			while (pos < length2) {
+				pos += CharacterWidth(segment2 + pos, length2 - pos);
+			}
+		}
+	}
+};
+
+// blocks start at line start, so lines and words never cross block boundary.
+class TextStatisticsWorker {
+	const Document &doc;
+	const DBCSCharClassify * const dbcs;
+	const bool multiByte;
+	const std::vector<Sci::Position> &starts;
+	std::vector<TextCounts> &results;
+	std::atomic<size_t> nextBlock = 0;
+
+public:
+	TextStatisticsWorker(const Document &doc_, const DBCSCharClassify *dbcs_, bool multiByte_,
+		const std::vector<Sci::Position> &starts_, std::vector<TextCounts> &results_) noexcept:
+		doc{doc_}, dbcs{dbcs_}, multiByte{multiByte_}, starts{starts_}, results{results_} {}
+
+	void DoWork() noexcept {
+		const size_t blockCount = results.size();
+		while (true) {
+			const size_t index = nextBlock.fetch_add(1, std::memory_order_relaxed);
+			if (index >= blockCount) {
+				break;
+			}
+			const Sci::Position start = starts[index];
+			const Sci::Position end = starts[index + 1];
+			TextStatisticsCounter counter{doc, dbcs, multiByte};
+			counter.Count(doc.RangeView(start, end - start));
+			if (index + 1 == blockCount) {
+				// last line of the range
+				counter.EndLine();
+			}
+			results[index] = counter.counts;
+		}
+	}
+};
+
+}
+
+void Document::CountTextStatistics(sptr_t lParam) const {
+	TextStatistics *ts = AsPointer<TextStatistics *>(lParam);
+	const Sci::Position length = LengthNoExcept();
+	Sci::Position startPos = std::clamp<Sci::Position>(ts->chrg.cpMin, 0, length);
+	Sci::Position endPos = ts->chrg.cpMax;
+	if (endPos < 0 || endPos > length) {
+		endPos = length;
+	}
+	startPos = MovePositionOutsideChar(startPos, 1, false);
+	endPos = MovePositionOutsideChar(std::max(startPos, endPos), -1, false);
+
+	std::vector<Sci::Position> starts{startPos};
+	if (endPos - startPos >= ParallelCountMinLength) {
+		Sci::Position position = startPos;
+		while (true) {
+			position = LineStart(SciLineFromPosition(position + ParallelCountBlockSize) + 1);
+			if (position >= endPos) {
+				break;
+			}
+			starts.push_back(position);
+		}
+	}
+	starts.push_back(endPos);
+
+	std::vector<TextCounts> results(starts.size() - 1);
+	const DBCSCharClassify *dbcs = (dbcsCodePage && CpUtf8 != dbcsCodePage) ? dbcsCharClass.get() : nullptr;
+	TextStatisticsWorker worker{*this, dbcs, dbcsCodePage != 0, starts, results};
+	const uint32_t threadCount = std::min<uint32_t>(GetHardwareConcurrency(), static_cast<uint32_t>(results.size()));
+	RunParallelWork(worker, threadCount);
+
+	TextCounts counts;
+	for (const TextCounts &block : results) {
+		counts.Add(block);
+	}
+	ts->chrg.cpMin = startPos;
+	ts->chrg.cpMax = endPos;
+	ts->characters = counts.characters;
+	ts->utf16Units = counts.utf16Units;
+	ts->words = counts.words;
+	ts->lines = counts.lines;
+	ts->emptyLines = counts.emptyLines;
+	ts->longestLine = counts.longestLine;
+	ts->invalidBytes = counts.invalidBytes;
 }
 
 Sci::Position Document::FindColumn(Sci::Line line, Sci::Position column) const noexcept {
@@ -1851,10 +2772,109 @@ std::string Document::TransformLineEnds(std::string_view s, EndOfLine eolModeWan
 	return dest;
 }
 
+namespace {
+
+// convert with single replacement when many line ends differ from wanted mode,
+// keeps undo history compact and rebuilds line starts through parallel line end search.
+constexpr size_t ConvertLineEndsBulkThreshold = 1024;
+
+// find next CR or LF in [pos, end), returns end when not found
+Sci::Position FindLineEndChar(const char *text, Sci::Position pos, Sci::Position end) noexcept {
+#if NP2_USE_AVX2
+	const __m256i vectCR = _mm256_set1_epi8('\r');
+	const __m256i vectLF = _mm256_set1_epi8('\n');
+	for (; pos + static_cast<Sci::Position>(sizeof(__m256i)) <= end; pos += sizeof(__m256i)) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		const uint32_t mask = mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectCR), _mm256_cmpeq_epi8(chunk, vectLF)));
+		if (mask) {
+			return pos + np2::ctz(mask);
+		}
+	}
+#elif NP2_USE_SSE2
+	const __m128i vectCR = _mm_set1_epi8('\r');
+	const __m128i vectLF = _mm_set1_epi8('\n');
+	for (; pos + static_cast<Sci::Position>(sizeof(__m128i)) <= end; pos += sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		const uint32_t mask = mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vectCR), _mm_cmpeq_epi8(chunk, vectLF)));
+		if (mask) {
+			return pos + np2::ctz(mask);
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		const char ch = text[pos];
+		if (ch == '\r' || ch == '\n') {
+			break;
+		}
+	}
+	return pos;
+}
+
+constexpr EndOfLine LineEndAt(const char *text, Sci::Position pos) noexcept {
+	if (text[pos] == '\n') {
+		return EndOfLine::Lf;
+	}
+	return (text[pos + 1] == '\n') ? EndOfLine::CrLf : EndOfLine::Cr;
+}
+
+}
+
 void Document::ConvertLineEnds(EndOfLine eolModeSet) {
+	// text[length] is NUL
+	const char *text = BufferPointer();
+	const Sci::Position length = LengthNoExcept();
+	Sci::Position first = -1;
+	Sci::Position last = 0;
+	size_t count = 0;
+	for (Sci::Position pos = FindLineEndChar(text, 0, length); pos < length; pos = FindLineEndChar(text, pos, length)) {
+		const EndOfLine eol = LineEndAt(text, pos);
+		const Sci::Position next = pos + ((eol == EndOfLine::CrLf) ? 2 : 1);
+		if (eol != eolModeSet) {
+			if (first < 0) {
+				first = pos;
+			}
+			last = next;
+			++count;
+		}
+		pos = next;
+	}
+	if (count == 0) {
+		return;
+	}
+
 	const UndoGroup ug(this);
+	if (count >= ConvertLineEndsBulkThreshold) {
+		const std::string_view eolSet = EOLForMode(eolModeSet);
+		std::string converted;
+		converted.reserve(last - first + count);
+		for (Sci::Position pos = first; pos < last;) {
+			const Sci::Position lineEnd = FindLineEndChar(text, pos, last);
+			converted.append(text + pos, lineEnd - pos);
+			converted.append(eolSet);
+			pos = lineEnd + ((LineEndAt(text, lineEnd) == EndOfLine::CrLf) ? 2 : 1);
+		}
+
+		// line count is unchanged, restore markers merged by deleting lines
+		const Sci::Line lineFirst = SciLineFromPosition(first);
+		const Sci::Line lineLast = SciLineFromPosition(last);
+		std::vector<std::pair<Sci::Line, MarkerMask>> marks;
+		for (Sci::Line line = MarkerNext(lineFirst, ~MarkerMask{}); line >= 0 && line <= lineLast; line = MarkerNext(line + 1, ~MarkerMask{})) {
+			marks.emplace_back(line, GetMark(line, false));
+		}
+		if (!DeleteChars(first, last - first)) {
+			return;
+		}
+		InsertString(first, converted);
+		if (!marks.empty()) {
+			DeleteMark(lineFirst, -1);
+			for (const auto &mark : marks) {
+				AddMarkSet(mark.first, mark.second);
+			}
+		}
+		return;
+	}
 
-	for (Sci::Position pos = 0; pos < LengthNoExcept(); pos++) {
+	for (Sci::Position pos = first; pos < LengthNoExcept(); pos++) {
 		const char ch = cb.CharAt(pos);
 		if (ch == '\r') {
 			if (cb.CharAt(pos + 1) == '\n') {
@@ -1895,21 +2915,49 @@ std::string_view Document::EOLString() const noexcept {
 
 DocumentOption Document::Options() const noexcept {
 	return (IsLarge() ? DocumentOption::TextLarge : DocumentOption::Default) |
-		(cb.HasStyles() ? DocumentOption::Default : DocumentOption::StylesNone);
+		(cb.HasStyles() ? DocumentOption::Default : DocumentOption::StylesNone) |
+		(cb.IsPieceTable() ? DocumentOption::TextPieces : DocumentOption::Default) |
+		(cb.IsStylesCompressed() ? DocumentOption::StylesCompressed : DocumentOption::Default);
 }
 
-bool Document::IsWhiteLine(Sci::Line line) const noexcept {
-	Sci::Position currentChar = LineStart(line);
-	const Sci::Position endLine = LineEnd(line);
-	while (currentChar < endLine) {
-		if (!IsSpaceOrTab(cb.CharAt(currentChar))) {
-			return false;
+// switch to 64-bit line starts and decorations, keeping text, styles, undo and change history
+bool Document::ConvertToLarge() {
+	if (IsLarge()) {
+		return false;
+	}
+	const Sci::Position length = LengthNoExcept();
+	std::unique_ptr<IDecorationList> decorationsLarge = DecorationListCreate(true);
+	decorationsLarge->InsertSpace(0, length);
+	for (const IDecoration *deco : decorations->View()) {
+		decorationsLarge->SetCurrentIndicator(deco->Indicator());
+		Sci::Position position = 0;
+		while (position < length) {
+			const Sci::Position end = deco->EndRun(position);
+			if (end <= position) {
+				break;
+			}
+			const int value = deco->ValueAt(position);
+			if (value != 0) {
+				decorationsLarge->SetCurrentValue(value);
+				decorationsLarge->FillRange(position, value, end - position);
+			}
+			position = end;
 		}
-		++currentChar;
 	}
+	decorationsLarge->SetCurrentIndicator(decorations->GetCurrentIndicator());
+	decorationsLarge->SetCurrentValue(decorations->GetCurrentValue());
+	decorationsLarge->SetClickNotified(decorations->ClickNotified());
+
+	cb.ConvertToLarge();
+	decorations = std::move(decorationsLarge);
 	return true;
 }
 
+bool Document::IsWhiteLine(Sci::Line line) const noexcept {
+	const Sci::Position endLine = LineEnd(line);
+	return SkipSpaceOrTab(LineStart(line), endLine) == endLine;
+}
+
 Sci::Position Document::ParaUp(Sci::Position pos) const noexcept {
 	Sci::Line line = SciLineFromPosition(pos);
 	const Sci::Position start = LineStart(line);
@@ -1969,13 +3017,7 @@ Sci::Position Document::ExtendWordSelect(Sci::Position pos, int delta, bool only
 				return MovePositionOutsideChar(pos, delta, true);
 			}
 		}
-		//const int style = StyleIndexAt(pos);
-		while (pos > 0) {
-			const CharacterExtracted ce = CharacterBefore(pos);
-			if (/*StyleIndexAt(pos - 1) != style || */WordCharacterClass(ce.character) != ccStart)
-				break;
-			pos -= ce.widthBytes;
-		}
+		pos = SkipCharacterClass(pos, ccStart, delta);
 	} else {
 		if (pos < LengthNoExcept()) {
 			const CharacterExtracted ce = CharacterAfter(pos);
@@ -1987,13 +3029,7 @@ Sci::Position Document::ExtendWordSelect(Sci::Position pos, int delta, bool only
 				return MovePositionOutsideChar(pos, delta, true);
 			}
 		}
-		//const int style = StyleIndexAt(pos - 1);
-		while (pos < LengthNoExcept()) {
-			const CharacterExtracted ce = CharacterAfter(pos);
-			if (/*StyleIndexAt(pos) != style || */WordCharacterClass(ce.character) != ccStart)
-				break;
-			pos += ce.widthBytes;
-		}
+		pos = SkipCharacterClass(pos, ccStart, delta);
 	}
 	return MovePositionOutsideChar(pos, delta, true);
 }
@@ -2007,37 +3043,17 @@ Sci::Position Document::ExtendWordSelect(Sci::Position pos, int delta, bool only
  */
 Sci::Position Document::NextWordStart(Sci::Position pos, int delta) const noexcept {
 	if (delta < 0) {
-		while (pos > 0) {
-			const CharacterExtracted ce = CharacterBefore(pos);
-			if (WordCharacterClass(ce.character) != CharacterClass::space)
-				break;
-			pos -= ce.widthBytes;
-		}
+		pos = SkipCharacterClass(pos, CharacterClass::space, delta);
 		if (pos > 0) {
-			CharacterExtracted ce = CharacterBefore(pos);
+			const CharacterExtracted ce = CharacterBefore(pos);
 			const CharacterClass ccStart = WordCharacterClass(ce.character);
-			while (pos > 0) {
-				ce = CharacterBefore(pos);
-				if (WordCharacterClass(ce.character) != ccStart)
-					break;
-				pos -= ce.widthBytes;
-			}
+			pos = SkipCharacterClass(pos, ccStart, delta);
 		}
 	} else {
-		CharacterExtracted ce = CharacterAfter(pos);
+		const CharacterExtracted ce = CharacterAfter(pos);
 		const CharacterClass ccStart = WordCharacterClass(ce.character);
-		while (pos < LengthNoExcept()) {
-			ce = CharacterAfter(pos);
-			if (WordCharacterClass(ce.character) != ccStart)
-				break;
-			pos += ce.widthBytes;
-		}
-		while (pos < LengthNoExcept()) {
-			ce = CharacterAfter(pos);
-			if (WordCharacterClass(ce.character) != CharacterClass::space)
-				break;
-			pos += ce.widthBytes;
-		}
+		pos = SkipCharacterClass(pos, ccStart, delta);
+		pos = SkipCharacterClass(pos, CharacterClass::space, delta);
 	}
 	return pos;
 }
@@ -2052,39 +3068,19 @@ Sci::Position Document::NextWordStart(Sci::Position pos, int delta) const noexce
 Sci::Position Document::NextWordEnd(Sci::Position pos, int delta) const noexcept {
 	if (delta < 0) {
 		if (pos > 0) {
-			CharacterExtracted ce = CharacterBefore(pos);
+			const CharacterExtracted ce = CharacterBefore(pos);
 			const CharacterClass ccStart = WordCharacterClass(ce.character);
 			if (ccStart != CharacterClass::space) {
-				while (pos > 0) {
-					ce = CharacterBefore(pos);
-					if (WordCharacterClass(ce.character) != ccStart)
-						break;
-					pos -= ce.widthBytes;
-				}
-			}
-			while (pos > 0) {
-				ce = CharacterBefore(pos);
-				if (WordCharacterClass(ce.character) != CharacterClass::space)
-					break;
-				pos -= ce.widthBytes;
+				pos = SkipCharacterClass(pos, ccStart, delta);
 			}
+			pos = SkipCharacterClass(pos, CharacterClass::space, delta);
 		}
 	} else {
-		while (pos < LengthNoExcept()) {
-			const CharacterExtracted ce = CharacterAfter(pos);
-			if (WordCharacterClass(ce.character) != CharacterClass::space)
-				break;
-			pos += ce.widthBytes;
-		}
+		pos = SkipCharacterClass(pos, CharacterClass::space, delta);
 		if (pos < LengthNoExcept()) {
-			CharacterExtracted ce = CharacterAfter(pos);
+			const CharacterExtracted ce = CharacterAfter(pos);
 			const CharacterClass ccStart = WordCharacterClass(ce.character);
-			while (pos < LengthNoExcept()) {
-				ce = CharacterAfter(pos);
-				if (WordCharacterClass(ce.character) != ccStart)
-					break;
-				pos += ce.widthBytes;
-			}
+			pos = SkipCharacterClass(pos, ccStart, delta);
 		}
 	}
 	return pos;
@@ -2133,6 +3129,106 @@ public:
 	}
 };
 
+// Bytes (at most two) that fold to the byte of pattern, used for candidate filtering.
+bool FoldedByteSet(const CaseFolderTable *folder, char folded, bool asciiOnly, unsigned char (&bytes)[2]) noexcept {
+	unsigned count = 0;
+	for (unsigned ch = 0; ch < (asciiOnly ? 0x80U : 0x100U); ch++) {
+		if (folder->FoldChar(static_cast<unsigned char>(ch)) == folded) {
+			if (count == 2) {
+				return false;
+			}
+			bytes[count++] = static_cast<unsigned char>(ch);
+		}
+	}
+	if (count == 0) {
+		return false;
+	}
+	bytes[1] = bytes[count - 1];
+	return true;
+}
+
+// Find first candidate in [pos, end) of contiguous text whose first and last byte matches
+// any of the two bytes, then the whole candidate is checked by verify.
+// see "generic SIMD" algorithm in http://0x80.pl/articles/simd-strfind.html
+template <typename Verify>
+Sci::Position FindCandidate(const char *text, Sci::Position pos, Sci::Position end, Sci::Position lastOffset,
+	const unsigned char (&first)[2], const unsigned char (&last)[2], Verify verify) {
+#if NP2_USE_AVX2
+	const __m256i firstLower = _mm256_set1_epi8(first[0]);
+	const __m256i firstUpper = _mm256_set1_epi8(first[1]);
+	const __m256i lastLower = _mm256_set1_epi8(last[0]);
+	const __m256i lastUpper = _mm256_set1_epi8(last[1]);
+	for (; pos + static_cast<Sci::Position>(sizeof(__m256i)) <= end; pos += sizeof(__m256i)) {
+		const __m256i chunkFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		const __m256i chunkLast = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos + lastOffset));
+		const __m256i matchFirst = _mm256_or_si256(_mm256_cmpeq_epi8(chunkFirst, firstLower), _mm256_cmpeq_epi8(chunkFirst, firstUpper));
+		const __m256i matchLast = _mm256_or_si256(_mm256_cmpeq_epi8(chunkLast, lastLower), _mm256_cmpeq_epi8(chunkLast, lastUpper));
+		uint32_t mask = mm256_movemask_epi8(_mm256_and_si256(matchFirst, matchLast));
+		while (mask) {
+			const Sci::Position candidate = pos + np2::ctz(mask);
+			mask &= mask - 1;
+			if (verify(candidate)) {
+				return candidate;
+			}
+		}
+	}
+#elif NP2_USE_SSE2
+	const __m128i firstLower = _mm_set1_epi8(first[0]);
+	const __m128i firstUpper = _mm_set1_epi8(first[1]);
+	const __m128i lastLower = _mm_set1_epi8(last[0]);
+	const __m128i lastUpper = _mm_set1_epi8(last[1]);
+	for (; pos + static_cast<Sci::Position>(sizeof(__m128i)) <= end; pos += sizeof(__m128i)) {
+		const __m128i chunkFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		const __m128i chunkLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos + lastOffset));
+		const __m128i matchFirst = _mm_or_si128(_mm_cmpeq_epi8(chunkFirst, firstLower), _mm_cmpeq_epi8(chunkFirst, firstUpper));
+		const __m128i matchLast = _mm_or_si128(_mm_cmpeq_epi8(chunkLast, lastLower), _mm_cmpeq_epi8(chunkLast, lastUpper));
+		uint32_t mask = mm_movemask_epi8(_mm_and_si128(matchFirst, matchLast));
+		while (mask) {
+			const Sci::Position candidate = pos + np2::ctz(mask);
+			mask &= mask - 1;
+			if (verify(candidate)) {
+				return candidate;
+			}
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		const unsigned char chFirst = text[pos];
+		const unsigned char chLast = text[pos + lastOffset];
+		if ((chFirst == first[0] || chFirst == first[1]) && (chLast == last[0] || chLast == last[1]) && verify(pos)) {
+			return pos;
+		}
+	}
+	return -1;
+}
+
+// Forward search candidates in [pos, endSearch) over both sides of the gap,
+// candidates crossing the gap are checked byte by byte.
+template <typename Verify>
+Sci::Position FindCandidate(const SplitView &cbView, Sci::Position pos, Sci::Position endSearch, Sci::Position lengthFind,
+	const unsigned char (&first)[2], const unsigned char (&last)[2], Verify verify) {
+	const Sci::Position lastOffset = lengthFind - 1;
+	const Sci::Position length1 = cbView.length1;
+	Sci::Position end = std::min(endSearch, length1 - lastOffset);
+	if (pos < end) {
+		const Sci::Position found = FindCandidate(cbView.segment1, pos, end, lastOffset, first, last, verify);
+		if (found >= 0) {
+			return found;
+		}
+		pos = end;
+	}
+	end = std::min(endSearch, length1);
+	for (; pos < end; pos++) {
+		if (verify(pos)) {
+			return pos;
+		}
+	}
+	if (pos < endSearch) {
+		return FindCandidate(cbView.segment2, pos, endSearch, lastOffset, first, last, verify);
+	}
+	return -1;
+}
+
 }
 
 /**
@@ -2242,262 +3338,542 @@ Sci::Position Document::FindText(Sci::Position minPos, Sci::Position maxPos, con
 	if (*length <= 0) {
 		return minPos;
 	}
+	// stop event is written on return
+	EventTraceActivity activity;
+	EventTraceStart(activity, "FindText", TraceLoggingInt64(minPos, "Start"), TraceLoggingInt64(maxPos, "End"),
+		TraceLoggingInt64(*length, "Length"), TraceLoggingUInt32(static_cast<uint32_t>(flags), "Flags"));
 	if (FlagSet(flags, FindOption::RegExp)) {
 		if (!regex) {
 			regex = std::unique_ptr<RegexSearchBase>(CreateRegexSearch(&charClass));
 		}
 		return regex->FindText(this, minPos, maxPos, search, flags, length);
+	}
+	if (searchIndexThreshold != 0 && *length >= 3 && EnsureSearchIndex()) {
+		return FindIndexed(minPos, maxPos, search, flags, length);
+	}
+	return FindLiteral(minPos, maxPos, search, flags, length);
+}
+
+void Document::SetSearchIndexThreshold(Sci::Position threshold) noexcept {
+	searchIndexThreshold = std::max<Sci::Position>(threshold, 0);
+	if (searchIndexThreshold == 0) {
+		searchIndex.reset();
+	}
+}
+
+bool Document::EnsureSearchIndex() {
+	if (LengthNoExcept() < searchIndexThreshold) {
+		return false;
+	}
+	if (!searchIndex) {
+		try {
+			std::unique_ptr<SearchIndex> index = std::make_unique<SearchIndex>();
+			index->Build(cb);
+			searchIndex = std::move(index);
+		} catch (const std::bad_alloc &) {
+			// disable the index instead of retrying on every search
+			searchIndexThreshold = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Search only blocks that may contain the literal pattern according to the search index,
+ * bytes folded to ASCII by case insensitive search must be ASCII in the document.
+ */
+Sci::Position Document::FindIndexed(Sci::Position minPos, Sci::Position maxPos, const char *search, FindOption flags, Sci::Position *length) {
+	const Sci::Position lengthFind = *length;
+	if (!FlagSet(flags, FindOption::MatchCase)) {
+		// same as UTF-8 byte folded search: Unicode case folding maps some characters to 'f', 'k' or 's'
+		if (dbcsCodePage != CpUtf8 || !std::all_of(search, search + lengthFind, [](char ch) noexcept {
+			return UTF8IsAscii(ch) && !AnyOf(MakeLowerCase(ch), 'f', 'k', 's');
+		})) {
+			return FindLiteral(minPos, maxPos, search, flags, length);
+		}
+	}
+
+	SearchIndex::Pattern pattern;
+	SearchIndex::MakePattern(search, lengthFind, pattern);
+	const Sci::Position lowPos = std::min(minPos, maxPos);
+	const Sci::Position highPos = std::max(minPos, maxPos);
+	const Sci::Position firstBlock = searchIndex->BlockFromPosition(lowPos);
+	const Sci::Position lastBlock = searchIndex->BlockFromPosition(highPos);
+	// search each run of candidate blocks for matches starting inside them
+	if (minPos <= maxPos) {
+		Sci::Position block = firstBlock;
+		while (block <= lastBlock) {
+			if (searchIndex->MayContain(block, pattern)) {
+				Sci::Position end = block + 1;
+				while (end <= lastBlock && searchIndex->MayContain(end, pattern)) {
+					end++;
+				}
+				const Sci::Position start = std::max(lowPos, searchIndex->BlockStart(block));
+				const Sci::Position stop = std::min(highPos, searchIndex->BlockStart(end) + lengthFind - 1);
+				const Sci::Position found = FindLiteral(start, stop, search, flags, length);
+				if (found >= 0) {
+					return found;
+				}
+				*length = lengthFind;
+				block = end;
+			}
+			block++;
+		}
 	} else {
-		const Sci::Position direction = maxPos - minPos;
-		//const bool forward = direction >= 0;
-		const int increment = (direction >= 0) ? 1 : -1;
-		// table for the condition: forward ? (pos < endSearch) : (pos >= endSearch)
-		//                   direction >= 0  direction < 0
-		// pos >= endSearch: break           continue
-		// pos < endSearch:  continue        break
-		// i.e. continue search when direction and (pos - endSearch) have opposite signs,
-		// which can be written as: (direction ^ (pos - endSearch)) < 0
-
-		// Range endpoints should not be inside DBCS characters, but just in case, move them.
-		const Sci::Position startPos = MovePositionOutsideChar(minPos, increment, false);
-		const Sci::Position endPos = MovePositionOutsideChar(maxPos, increment, false);
-
-		// Compute actual search ranges needed
-		const Sci::Position lengthFind = *length;
-
-		//Platform::DebugPrintf("Find %d %d %s %d\n", startPos, endPos, search, lengthFind);
-		const Sci::Position limitPos = std::max(startPos, endPos);
-		Sci::Position pos = startPos;
-		if (direction < 0 && !FlagSet(flags, FindOption::MatchCase)) {
-			// Back all of a character
-			pos = NextPosition(pos, -1);
-		}
-		const SplitView cbView = cb.AllView();
-		SearchThing searchThing;
-		if (FlagSet(flags, FindOption::MatchCase)) {
-			const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(search);
-			// Boyer-Moore-Horspool-Sunday Algorithm / Quick Search Algorithm
-			// https://www-igm.univ-mlv.fr/~lecroq/string/index.html
-			// https://www-igm.univ-mlv.fr/~lecroq/string/node19.html
-			// https://www.inf.hs-flensburg.de/lang/algorithmen/pattern/sundayen.htm
-			auto& shiftTable = searchThing.shiftTable;
-			if (lengthFind != 1) {
-				Sci::Position shift = lengthFind;
-				const Sci::Position value = (shift + 1) * increment;
-				//std::fill_n(shiftTable, std::size(shiftTable), value);
-				//__stosq((uint64_t *)(&shiftTable[0]), value, 256);
-				//__stosd((uint32_t *)(&shiftTable[0]), value, 256);
-				for (auto &it : shiftTable) {
-					it = value;
-				}
-				if (direction >= 0) {
-					const unsigned char *ptr = searchData;
-					while (*ptr != 0) {
-						shiftTable[*ptr++] = shift--;
-					}
-				} else {
-					const unsigned char *ptr = searchData + shift - 1;
-					shift = -shift;
-					while (ptr >= searchData) {
-						shiftTable[*ptr--] = shift++;
-					}
+		Sci::Position block = lastBlock;
+		while (block >= firstBlock) {
+			if (searchIndex->MayContain(block, pattern)) {
+				Sci::Position begin = block;
+				while (begin > firstBlock && searchIndex->MayContain(begin - 1, pattern)) {
+					begin--;
+				}
+				const Sci::Position start = std::min(highPos, searchIndex->BlockStart(block + 1) + lengthFind - 1);
+				const Sci::Position stop = std::max(lowPos, searchIndex->BlockStart(begin));
+				const Sci::Position found = FindLiteral(start, stop, search, flags, length);
+				if (found >= 0) {
+					return found;
 				}
+				*length = lengthFind;
+				block = begin;
 			}
+			block--;
+		}
+	}
+	return -1;
+}
+
+Sci::Position Document::FindLiteral(Sci::Position minPos, Sci::Position maxPos, const char *search, FindOption flags, Sci::Position *length) {
+	const Sci::Position direction = maxPos - minPos;
+	//const bool forward = direction >= 0;
+	const int increment = (direction >= 0) ? 1 : -1;
+	// table for the condition: forward ? (pos < endSearch) : (pos >= endSearch)
+	//                   direction >= 0  direction < 0
+	// pos >= endSearch: break           continue
+	// pos < endSearch:  continue        break
+	// i.e. continue search when direction and (pos - endSearch) have opposite signs,
+	// which can be written as: (direction ^ (pos - endSearch)) < 0
 
-			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
-			const Sci::Position skip = (direction >= 0) ? lengthFind : -1;
-			const unsigned char safeChar = (skip == 1) ? forwardSafeChar : backwardSafeChar;
-			const unsigned char charStartSearch = searchData[0];
-			if (direction < 0) {
-				pos = MovePositionOutsideChar(pos - lengthFind, -1, false);
+	// Range endpoints should not be inside DBCS characters, but just in case, move them.
+	const Sci::Position startPos = MovePositionOutsideChar(minPos, increment, false);
+	const Sci::Position endPos = MovePositionOutsideChar(maxPos, increment, false);
+
+	// Compute actual search ranges needed
+	const Sci::Position lengthFind = *length;
+
+	//Platform::DebugPrintf("Find %d %d %s %d\n", startPos, endPos, search, lengthFind);
+	const Sci::Position limitPos = std::max(startPos, endPos);
+	Sci::Position pos = startPos;
+	if (direction < 0 && !FlagSet(flags, FindOption::MatchCase)) {
+		// Back all of a character
+		pos = NextPosition(pos, -1);
+	}
+	const SplitView cbView = cb.AllView();
+	// forward search for byte folded pattern, fails when too many bytes fold to first or last byte
+	const auto findFolded = [&](const CaseFolderTable *folder, const char *searchData, bool asciiOnly) -> std::optional<Sci::Position> {
+		unsigned char first[2];
+		unsigned char last[2];
+		if (!FoldedByteSet(folder, searchData[0], asciiOnly, first) || !FoldedByteSet(folder, searchData[lengthFind - 1], asciiOnly, last)) {
+			return std::nullopt;
+		}
+		return FindCandidate(cbView, pos, endPos - lengthFind + 1, lengthFind, first, last, [&](Sci::Position candidate) noexcept {
+			for (Sci::Position indexSearch = 0; indexSearch < lengthFind; indexSearch++) {
+				if (folder->FoldChar(cbView[candidate + indexSearch]) != searchData[indexSearch]) {
+					return false;
+				}
 			}
-			//while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-			while ((direction ^ (pos - endSearch)) < 0) {
-				const unsigned char leadByte = cbView[pos];
-				if (charStartSearch == leadByte) {
-					bool found = (pos + lengthFind) <= limitPos;
-					for (Sci::Position indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
-						const unsigned char ch = cbView[pos + indexSearch];
-						found = ch == searchData[indexSearch];
-					}
-					if (found && MatchesWordOptions(flags, pos, lengthFind)) {
-						return pos;
+			return MatchesWordOptions(flags, candidate, lengthFind);
+		});
+	};
+	SearchThing searchThing;
+	if (FlagSet(flags, FindOption::MatchCase)) {
+		const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(search);
+		// match can't start at trail byte when pattern starts with ASCII or lead byte
+		if (direction >= 0 && (dbcsCodePage == 0 || (dbcsCodePage == CpUtf8 && !UTF8IsTrailByte(searchData[0])))) {
+			const unsigned char first[2] = {searchData[0], searchData[0]};
+			const unsigned char last[2] = {searchData[lengthFind - 1], searchData[lengthFind - 1]};
+			return FindCandidate(cbView, pos, endPos - lengthFind + 1, lengthFind, first, last, [&](Sci::Position candidate) noexcept {
+				for (Sci::Position indexSearch = 0; indexSearch < lengthFind; indexSearch++) {
+					if (static_cast<unsigned char>(cbView[candidate + indexSearch]) != searchData[indexSearch]) {
+						return false;
 					}
 				}
-
-				if (lengthFind == 1) {
-					if (leadByte <= safeChar) {
-						pos += increment;
-					} else {
-						if (!NextCharacter(pos, increment)) {
-							break;
-						}
-					}
-				} else {
-					const unsigned char nextByte = cbView.CharAt(pos + skip);
-					pos += shiftTable[nextByte];
-					if (nextByte > safeChar) {
-						pos = MovePositionOutsideChar(pos, increment, false);
-					}
+				return MatchesWordOptions(flags, candidate, lengthFind);
+			});
+		}
+		// Boyer-Moore-Horspool-Sunday Algorithm / Quick Search Algorithm
+		// https://www-igm.univ-mlv.fr/~lecroq/string/index.html
+		// https://www-igm.univ-mlv.fr/~lecroq/string/node19.html
+		// https://www.inf.hs-flensburg.de/lang/algorithmen/pattern/sundayen.htm
+		auto& shiftTable = searchThing.shiftTable;
+		if (lengthFind != 1) {
+			Sci::Position shift = lengthFind;
+			const Sci::Position value = (shift + 1) * increment;
+			//std::fill_n(shiftTable, std::size(shiftTable), value);
+			//__stosq((uint64_t *)(&shiftTable[0]), value, 256);
+			//__stosd((uint32_t *)(&shiftTable[0]), value, 256);
+			for (auto &it : shiftTable) {
+				it = value;
+			}
+			if (direction >= 0) {
+				const unsigned char *ptr = searchData;
+				while (*ptr != 0) {
+					shiftTable[*ptr++] = shift--;
+				}
+			} else {
+				const unsigned char *ptr = searchData + shift - 1;
+				shift = -shift;
+				while (ptr >= searchData) {
+					shiftTable[*ptr--] = shift++;
 				}
 			}
-		} else if (CpUtf8 == dbcsCodePage) {
-			constexpr size_t maxFoldingExpansion = 3; // same as maxExpansionCaseConversion
-			searchThing.Allocate((lengthFind + UTF8MaxBytes) * maxFoldingExpansion + 1);
-			const size_t lenSearch = pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(searchThing.data());
-			//while (forward ? (pos < endPos) : (pos >= endPos)) {
-			while ((direction ^ (pos - endPos)) < 0) {
-				int widthFirstCharacter = 1;
-				Sci::Position posIndexDocument = pos;
-				size_t indexSearch = 0;
-				bool characterMatches = true;
-				for (;;) {
-					const unsigned char leadByte = cbView[posIndexDocument];
-					int widthChar = 1;
-					size_t lenFlat = 1;
-					if (UTF8IsAscii(leadByte)) {
-						if ((posIndexDocument + 1) > limitPos) {
-							break;
-						}
-						characterMatches = searchData[indexSearch] == MakeLowerCase(leadByte);
-					} else {
-						char bytes[UTF8MaxBytes + 1]{ static_cast<char>(leadByte) };
-						const int widthCharBytes = UTF8BytesOfLead(leadByte);
-						for (int b = 1; b < widthCharBytes; b++) {
-							bytes[b] = cbView.CharAt(posIndexDocument + b);
-						}
-						widthChar = UTF8ClassifyMulti(reinterpret_cast<const unsigned char *>(bytes), widthCharBytes) & UTF8MaskWidth;
-						if (!indexSearch) {
-							widthFirstCharacter = widthChar;
-						}
-						if ((posIndexDocument + widthChar) > limitPos) {
-							break;
-						}
-						char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
-						lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
-						// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
-						assert((indexSearch + lenFlat) <= searchThing.size());
-						// Does folded match the buffer
-						characterMatches = 0 == memcmp(folded, searchData + indexSearch, lenFlat);
-					}
-					if (!characterMatches) {
-						break;
-					}
-					posIndexDocument += widthChar;
-					indexSearch += lenFlat;
-					if (indexSearch >= lenSearch) {
-						break;
-					}
+		}
+
+		const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+		const Sci::Position skip = (direction >= 0) ? lengthFind : -1;
+		const unsigned char safeChar = (skip == 1) ? forwardSafeChar : backwardSafeChar;
+		const unsigned char charStartSearch = searchData[0];
+		if (direction < 0) {
+			pos = MovePositionOutsideChar(pos - lengthFind, -1, false);
+		}
+		//while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+		while ((direction ^ (pos - endSearch)) < 0) {
+			const unsigned char leadByte = cbView[pos];
+			if (charStartSearch == leadByte) {
+				bool found = (pos + lengthFind) <= limitPos;
+				for (Sci::Position indexSearch = 1; (indexSearch < lengthFind) && found; indexSearch++) {
+					const unsigned char ch = cbView[pos + indexSearch];
+					found = ch == searchData[indexSearch];
 				}
-				if (characterMatches && (indexSearch == lenSearch)) {
-					posIndexDocument -= pos;
-					if (MatchesWordOptions(flags, pos, posIndexDocument)) {
-						*length = posIndexDocument;
-						return pos;
-					}
+				if (found && MatchesWordOptions(flags, pos, lengthFind)) {
+					return pos;
 				}
-				if (direction >= 0) {
-					pos += widthFirstCharacter;
+			}
+
+			if (lengthFind == 1) {
+				if (leadByte <= safeChar) {
+					pos += increment;
 				} else {
 					if (!NextCharacter(pos, increment)) {
 						break;
 					}
 				}
+			} else {
+				const unsigned char nextByte = cbView.CharAt(pos + skip);
+				pos += shiftTable[nextByte];
+				if (nextByte > safeChar) {
+					pos = MovePositionOutsideChar(pos, increment, false);
+				}
+			}
+		}
+	} else if (CpUtf8 == dbcsCodePage) {
+		constexpr size_t maxFoldingExpansion = 3; // same as maxExpansionCaseConversion
+		searchThing.Allocate((lengthFind + UTF8MaxBytes) * maxFoldingExpansion + 1);
+		const size_t lenSearch = pcf->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(searchThing.data());
+		// ASCII pattern only matches ASCII text, unless it contains letters that non-ASCII characters
+		// fold into: K (Kelvin sign) to k, long s and sharp s to s, ligatures to f and s.
+		if (direction >= 0 && std::all_of(search, search + lengthFind, [](char ch) noexcept { return UTF8IsAscii(ch); })
+			&& std::string_view(searchThing.data(), lenSearch).find_first_of("fks") == std::string_view::npos) {
+			const std::optional<Sci::Position> found = findFolded(down_cast<CaseFolderTable *>(pcf.get()), searchThing.data(), true);
+			if (found) {
+				return *found;
 			}
-		} else if (dbcsCodePage) {
-			searchThing.Allocate(lengthFind + 2 + 1);
-			const CaseFolderTable * const folder = down_cast<CaseFolderTable *>(pcf.get());
-			const size_t lenSearch = folder->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(searchThing.data());
-			//while (forward ? (pos < endPos) : (pos >= endPos)) {
-			while ((direction ^ (pos - endPos)) < 0) {
-				int widthFirstCharacter = 1;
-				Sci::Position indexDocument = pos;
-				size_t indexSearch = 0;
-				bool characterMatches = true;
-				for (;;) {
-					const char leadByte = cbView[indexDocument];
-					int widthChar = 1;
-					if ((indexDocument + 1) > limitPos) {
+		}
+		//while (forward ? (pos < endPos) : (pos >= endPos)) {
+		while ((direction ^ (pos - endPos)) < 0) {
+			int widthFirstCharacter = 1;
+			Sci::Position posIndexDocument = pos;
+			size_t indexSearch = 0;
+			bool characterMatches = true;
+			for (;;) {
+				const unsigned char leadByte = cbView[posIndexDocument];
+				int widthChar = 1;
+				size_t lenFlat = 1;
+				if (UTF8IsAscii(leadByte)) {
+					if ((posIndexDocument + 1) > limitPos) {
 						break;
 					}
-					const char chTest = searchData[indexSearch];
-					if (!IsDBCSLeadByteNoExcept(leadByte)) {
-						characterMatches = chTest == folder->FoldChar(leadByte);
-					} else {
-						const char trailByte = cbView[indexDocument + 1];
-						if (IsDBCSTrailByteNoExcept(trailByte)) {
-							widthChar = 2;
-							if (!indexSearch) {
-								widthFirstCharacter = widthChar;
-							}
-							if ((indexDocument + widthChar) > limitPos) {
-								break;
-							}
-							char folded[2] = {
-								leadByte,
-								trailByte,
-							};
-							folder->Fold(folded, sizeof(folded), folded, widthChar);
-							// memcmp may examine widthChar bytes in both arguments so assert it doesn't read past end of searchThing
-							assert((indexSearch + widthChar) <= searchThing.size());
-							// Does folded match the buffer
-							characterMatches = 0 == memcmp(folded, searchData + indexSearch, widthChar);
-						} else {
-							characterMatches = chTest == leadByte;
-						}
+					characterMatches = searchData[indexSearch] == MakeLowerCase(leadByte);
+				} else {
+					char bytes[UTF8MaxBytes + 1]{ static_cast<char>(leadByte) };
+					const int widthCharBytes = UTF8BytesOfLead(leadByte);
+					for (int b = 1; b < widthCharBytes; b++) {
+						bytes[b] = cbView.CharAt(posIndexDocument + b);
 					}
-					if (!characterMatches) {
-						break;
+					widthChar = UTF8ClassifyMulti(reinterpret_cast<const unsigned char *>(bytes), widthCharBytes) & UTF8MaskWidth;
+					if (!indexSearch) {
+						widthFirstCharacter = widthChar;
 					}
-					indexDocument += widthChar;
-					indexSearch += widthChar;
-					if (indexSearch >= lenSearch) {
+					if ((posIndexDocument + widthChar) > limitPos) {
 						break;
 					}
+					char folded[UTF8MaxBytes * maxFoldingExpansion + 1];
+					lenFlat = pcf->Fold(folded, sizeof(folded), bytes, widthChar);
+					// memcmp may examine lenFlat bytes in both arguments so assert it doesn't read past end of searchThing
+					assert((indexSearch + lenFlat) <= searchThing.size());
+					// Does folded match the buffer
+					characterMatches = 0 == memcmp(folded, searchData + indexSearch, lenFlat);
 				}
-				if (characterMatches && (indexSearch == lenSearch)) {
-					indexDocument -= pos;
-					if (MatchesWordOptions(flags, pos, indexDocument)) {
-						*length = indexDocument;
-						return pos;
-					}
+				if (!characterMatches) {
+					break;
+				}
+				posIndexDocument += widthChar;
+				indexSearch += lenFlat;
+				if (indexSearch >= lenSearch) {
+					break;
+				}
+			}
+			if (characterMatches && (indexSearch == lenSearch)) {
+				posIndexDocument -= pos;
+				if (MatchesWordOptions(flags, pos, posIndexDocument)) {
+					*length = posIndexDocument;
+					return pos;
+				}
+			}
+			if (direction >= 0) {
+				pos += widthFirstCharacter;
+			} else {
+				if (!NextCharacter(pos, increment)) {
+					break;
+				}
+			}
+		}
+	} else if (dbcsCodePage) {
+		searchThing.Allocate(lengthFind + 2 + 1);
+		const CaseFolderTable * const folder = down_cast<CaseFolderTable *>(pcf.get());
+		const size_t lenSearch = folder->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		const unsigned char * const searchData = reinterpret_cast<const unsigned char *>(searchThing.data());
+		//while (forward ? (pos < endPos) : (pos >= endPos)) {
+		while ((direction ^ (pos - endPos)) < 0) {
+			int widthFirstCharacter = 1;
+			Sci::Position indexDocument = pos;
+			size_t indexSearch = 0;
+			bool characterMatches = true;
+			for (;;) {
+				const char leadByte = cbView[indexDocument];
+				int widthChar = 1;
+				if ((indexDocument + 1) > limitPos) {
+					break;
 				}
-				if (direction >= 0) {
-					pos += widthFirstCharacter;
+				const char chTest = searchData[indexSearch];
+				if (!IsDBCSLeadByteNoExcept(leadByte)) {
+					characterMatches = chTest == folder->FoldChar(leadByte);
 				} else {
-					if (!NextCharacter(pos, increment)) {
-						break;
+					const char trailByte = cbView[indexDocument + 1];
+					if (IsDBCSTrailByteNoExcept(trailByte)) {
+						widthChar = 2;
+						if (!indexSearch) {
+							widthFirstCharacter = widthChar;
+						}
+						if ((indexDocument + widthChar) > limitPos) {
+							break;
+						}
+						char folded[2] = {
+							leadByte,
+							trailByte,
+						};
+						folder->Fold(folded, sizeof(folded), folded, widthChar);
+						// memcmp may examine widthChar bytes in both arguments so assert it doesn't read past end of searchThing
+						assert((indexSearch + widthChar) <= searchThing.size());
+						// Does folded match the buffer
+						characterMatches = 0 == memcmp(folded, searchData + indexSearch, widthChar);
+					} else {
+						characterMatches = chTest == leadByte;
 					}
 				}
-			}
-		} else {
-			const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
-			searchThing.Allocate(lengthFind + 1);
-			const CaseFolderTable * const folder = down_cast<CaseFolderTable *>(pcf.get());
-			folder->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
-			const char * const searchData = searchThing.data();
-			//while (forward ? (pos < endSearch) : (pos >= endSearch)) {
-			while ((direction ^ (pos - endSearch)) < 0) {
-				bool found = (pos + lengthFind) <= limitPos;
-				for (Sci::Position indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
-					const char ch = cbView[pos + indexSearch];
-					const char chTest = searchData[indexSearch];
-					const char folded = folder->FoldChar(ch);
-					found = chTest == folded;
+				if (!characterMatches) {
+					break;
 				}
-				if (found && MatchesWordOptions(flags, pos, lengthFind)) {
+				indexDocument += widthChar;
+				indexSearch += widthChar;
+				if (indexSearch >= lenSearch) {
+					break;
+				}
+			}
+			if (characterMatches && (indexSearch == lenSearch)) {
+				indexDocument -= pos;
+				if (MatchesWordOptions(flags, pos, indexDocument)) {
+					*length = indexDocument;
 					return pos;
 				}
-				pos += increment;
 			}
+			if (direction >= 0) {
+				pos += widthFirstCharacter;
+			} else {
+				if (!NextCharacter(pos, increment)) {
+					break;
+				}
+			}
+		}
+	} else {
+		const Sci::Position endSearch = (startPos <= endPos) ? endPos - lengthFind + 1 : endPos;
+		searchThing.Allocate(lengthFind + 1);
+		const CaseFolderTable * const folder = down_cast<CaseFolderTable *>(pcf.get());
+		folder->Fold(searchThing.data(), searchThing.size(), search, lengthFind);
+		const char * const searchData = searchThing.data();
+		if (direction >= 0) {
+			const std::optional<Sci::Position> found = findFolded(folder, searchData, false);
+			if (found) {
+				return *found;
+			}
+		}
+		//while (forward ? (pos < endSearch) : (pos >= endSearch)) {
+		while ((direction ^ (pos - endSearch)) < 0) {
+			bool found = (pos + lengthFind) <= limitPos;
+			for (Sci::Position indexSearch = 0; (indexSearch < lengthFind) && found; indexSearch++) {
+				const char ch = cbView[pos + indexSearch];
+				const char chTest = searchData[indexSearch];
+				const char folded = folder->FoldChar(ch);
+				found = chTest == folded;
+			}
+			if (found && MatchesWordOptions(flags, pos, lengthFind)) {
+				return pos;
+			}
+			pos += increment;
 		}
 	}
 	//Platform::DebugPrintf("Not found\n");
 	return -1;
 }
 
+namespace {
+
+// search line aligned chunks of the document in multiple threads
+constexpr Sci::Position FindAllChunkSize = 1024*1024;
+
+class FindAllWorker {
+	Document * const doc;
+	const CharClassify * const charClassTable;
+	const char * const search;
+	const Sci::Position lengthSearch;
+	const FindOption flags;
+	const std::vector<Sci::Position> &chunkStarts;
+	std::atomic<size_t> nextChunk = 0;
+	std::atomic<bool> failed = false;
+
+public:
+	std::vector<std::vector<Sci::Position>> chunkRanges;
+
+	FindAllWorker(Document *doc_, const CharClassify *charClassTable_, const char *search_, Sci::Position lengthSearch_, FindOption flags_, const std::vector<Sci::Position> &chunkStarts_):
+		doc{doc_}, charClassTable{charClassTable_}, search{search_}, lengthSearch{lengthSearch_}, flags{flags_}, chunkStarts{chunkStarts_},
+		chunkRanges(chunkStarts_.size() - 1) {}
+
+	bool Run() {
+		const uint32_t threadCount = std::min<uint32_t>(GetHardwareConcurrency(), static_cast<uint32_t>(chunkRanges.size()));
+		PTP_WORK work = nullptr;
+		if (threadCount > 1) {
+			work = CreateThreadpoolWork(WorkCallback, this, nullptr);
+		}
+		if (work == nullptr) {
+			DoWork();
+		} else {
+			for (uint32_t i = 0; i < threadCount; i++) {
+				SubmitThreadpoolWork(work);
+			}
+			WaitForThreadpoolWorkCallbacks(work, FALSE);
+			CloseThreadpoolWork(work);
+		}
+		return !failed.load(std::memory_order_relaxed);
+	}
+
+	void FindChunk(RegexSearchBase *regex, size_t index) {
+		const Sci::Position end = chunkStarts[index + 1];
+		// match at start of next chunk (e.g. empty match for ^) belongs to next chunk
+		const bool lastChunk = index + 2 == chunkStarts.size();
+		std::vector<Sci::Position> &ranges = chunkRanges[index];
+		Sci::Position pos = chunkStarts[index];
+		while (pos < end) {
+			Sci::Position length = lengthSearch;
+			const Sci::Position found = regex ? regex->FindText(doc, pos, end, search, flags, &length)
+				: doc->FindText(pos, end, search, flags, &length);
+			if (found < 0 || (found >= end && !lastChunk)) {
+				break;
+			}
+			Sci::Position endMatch = found + length;
+			if (FlagSet(flags, FindOption::MatchToWordEnd)) {
+				endMatch = doc->ExtendWordSelect(endMatch, 1, true);
+			}
+			ranges.push_back(found);
+			ranges.push_back(endMatch - found);
+			pos = (endMatch == found) ? doc->NextPosition(found, 1) : endMatch;
+		}
+	}
+
+	void DoWork() noexcept {
+		try {
+			// RegexSearchBase keeps compiled pattern and matched groups, each thread needs its own one
+			std::unique_ptr<RegexSearchBase> regex;
+			if (FlagSet(flags, FindOption::RegExp)) {
+				regex.reset(CreateRegexSearch(charClassTable));
+			}
+			while (!failed.load(std::memory_order_relaxed)) {
+				const size_t index = nextChunk.fetch_add(1, std::memory_order_relaxed);
+				if (index >= chunkRanges.size()) {
+					break;
+				}
+				FindChunk(regex.get(), index);
+			}
+		} catch (...) {
+			failed.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
+		FindAllWorker *worker = static_cast<FindAllWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+}
+
+/**
+ * Find all matches in [minPos, maxPos) forward, ranges are filled with pairs of
+ * match position and match length, as if calling FindText() from end of previous match.
+ * Returns number of matches, or -1 when the search can't be split into independent
+ * chunks, i.e. match may cross line end or document can't be read concurrently.
+ */
+Sci::Position Document::FindAll(Sci::Position minPos, Sci::Position maxPos, const char *search, FindOption flags, Sci::Position length, std::vector<Sci::Position> &ranges) {
+	ranges.clear();
+	if (length <= 0 || minPos >= maxPos || !cb.ConcurrentRead()) {
+		return -1;
+	}
+	if (FlagSet(flags, FindOption::RegExp)) {
+		// builtin regex matches inside a line, C++ regex may match line ends
+		if (FlagSet(flags, FindOption::Cxx11RegEx)) {
+			return -1;
+		}
+	} else if (std::string_view(search, length).find_first_of("\r\n") != std::string_view::npos) {
+		return -1;
+	}
+
+	std::vector<Sci::Position> chunkStarts;
+	Sci::Position pos = minPos;
+	do {
+		chunkStarts.push_back(pos);
+		pos = std::min(LineStart(SciLineFromPosition(pos + FindAllChunkSize) + 1), maxPos);
+	} while (pos < maxPos);
+	chunkStarts.push_back(maxPos);
+
+	if (searchIndexThreshold != 0 && !FlagSet(flags, FindOption::RegExp)) {
+		// build the index before it's read by worker threads
+		EnsureSearchIndex();
+	}
+	FindAllWorker worker(this, &charClass, search, length, flags, chunkStarts);
+	if (!worker.Run()) {
+		return -1;
+	}
+	size_t count = 0;
+	for (const auto &chunk : worker.chunkRanges) {
+		count += chunk.size();
+	}
+	ranges.reserve(count);
+	for (const auto &chunk : worker.chunkRanges) {
+		ranges.insert(ranges.end(), chunk.begin(), chunk.end());
+	}
+	return count/2;
+}
+
 const char *Document::SubstituteByPosition(const char *text, Sci::Position *length) {
 	if (regex)
 		return regex->SubstituteByPosition(this, text, length);
@@ -2520,16 +3896,20 @@ void Document::AllocateLines(Sci::Line lines) {
 	cb.AllocateLines(lines);
 }
 
+// compiled \w and \W in regex depend on word characters
 void Document::SetDefaultCharClasses(bool includeWordClass) noexcept {
 	charClass.SetDefaultCharClasses(includeWordClass);
+	regex.reset();
 }
 
 void Document::SetCharClasses(const unsigned char *chars, CharacterClass newCharClass) noexcept {
 	charClass.SetCharClasses(chars, newCharClass);
+	regex.reset();
 }
 
 void Document::SetCharClassesEx(const unsigned char *chars, size_t length) noexcept {
 	charClass.SetCharClassesEx(chars, length);
+	regex.reset();
 }
 
 int Document::GetCharsOfClass(CharacterClass characterClass, unsigned char *buffer) const noexcept {
@@ -2606,9 +3986,27 @@ void Document::StyleToAdjustingLineDuration(Sci::Position pos) {
 	durationStyleOneUnit.AddSample(bytesBeingStyled, epStyling.Duration());
 }
 
+// style to pos on worker thread, returns false when it should be styled synchronously.
+// text is copied to be lexed on worker thread, only single byte code page and UTF-8 are supported.
+bool Document::CanStyleBackground() const noexcept {
+	return cb.HasStyles() && pli && !pli->UseContainerLexing()
+		&& (dbcsCodePage == 0 || dbcsCodePage == CpUtf8);
+}
+
+bool Document::StyleBackground(Sci::Position pos) {
+	if (enteredStyling != 0 || !CanStyleBackground()) {
+		return false;
+	}
+	if (pos <= GetEndStyled()) {
+		return true;
+	}
+	return pli->ColouriseBackground(LineStartPosition(GetEndStyled()), pos);
+}
+
 void Document::LexerChanged(bool hasStyles_) { //! removed in Scintilla 5.3
 	if (cb.EnsureStyleBuffer(hasStyles_)) {
 		endStyled = 0;
+		braceIndex.reset();
 	}
 }
 
@@ -2750,16 +4148,54 @@ int Document::AnnotationLines(Sci::Line line) const noexcept {
 	return Annotations()->Lines(line);
 }
 
+namespace {
+
+// first and last valid line of the records, first is greater than last when there is none.
+std::pair<Sci::Line, Sci::Line> AnnotationRecordLines(const AnnotationRecord *records, size_t count, Sci::Line linesTotal) noexcept {
+	Sci::Line lineFirst = linesTotal;
+	Sci::Line lineLast = -1;
+	const AnnotationRecord * const end = records + count;
+	for (; records < end; ++records) {
+		const Sci::Line line = records->line;
+		if (IsValidIndex(line, linesTotal)) {
+			lineFirst = std::min(lineFirst, line);
+			lineLast = std::max(lineLast, line);
+		}
+	}
+	return {lineFirst, lineLast};
+}
+
+}
+
+// Changes of many lines are reported with one notification, its position and length cover
+// all changed lines while a single line change has zero length.
+void Document::AnnotationSetBulk(size_t count, sptr_t lParam) {
+	const AnnotationRecord *records = AsPointer<const AnnotationRecord *>(lParam);
+	const Sci::Line linesTotal = LinesTotal();
+	const auto [lineFirst, lineLast] = AnnotationRecordLines(records, count, linesTotal);
+	if (lineFirst <= lineLast) {
+		const Sci::Position position = LineStart(lineFirst);
+		DocModification mh(ModificationFlags::ChangeAnnotation, position,
+			LineStart(lineLast + 1) - position, 0, nullptr, lineFirst);
+		mh.annotationLinesAdded = Annotations()->SetBulk(records, count, linesTotal);
+		NotifyModified(mh);
+	}
+}
+
 void Document::AnnotationClearAll() {
-	if (Annotations()->Empty()) {
+	LineAnnotation *pla = Annotations();
+	if (pla->Empty()) {
 		return;
 	}
 	const Sci::Line maxEditorLine = LinesTotal();
+	Sci::Line linesRemoved = 0;
 	for (Sci::Line l = 0; l < maxEditorLine; l++) {
-		AnnotationSetText(l, nullptr);
+		linesRemoved += pla->Lines(l);
 	}
-	// Free remaining data
-	Annotations()->ClearAll();
+	pla->ClearAll();
+	DocModification mh(ModificationFlags::ChangeAnnotation, 0, LengthNoExcept(), 0, nullptr, 0);
+	mh.annotationLinesAdded = -linesRemoved;
+	NotifyModified(mh);
 }
 
 StyledText Document::EOLAnnotationStyledText(Sci::Line line) const noexcept {
@@ -2786,16 +4222,26 @@ void Document::EOLAnnotationSetStyle(Sci::Line line, int style) {
 	}
 }
 
+void Document::EOLAnnotationSetBulk(size_t count, sptr_t lParam) {
+	const AnnotationRecord *records = AsPointer<const AnnotationRecord *>(lParam);
+	const Sci::Line linesTotal = LinesTotal();
+	const auto [lineFirst, lineLast] = AnnotationRecordLines(records, count, linesTotal);
+	if (lineFirst <= lineLast) {
+		EOLAnnotations()->SetBulk(records, count, linesTotal);
+		const Sci::Position position = LineStart(lineFirst);
+		const DocModification mh(ModificationFlags::ChangeEOLAnnotation, position,
+			LineStart(lineLast + 1) - position, 0, nullptr, lineFirst);
+		NotifyModified(mh);
+	}
+}
+
 void Document::EOLAnnotationClearAll() {
 	if (EOLAnnotations()->Empty()) {
 		return;
 	}
-	const Sci::Line maxEditorLine = LinesTotal();
-	for (Sci::Line l = 0; l < maxEditorLine; l++) {
-		EOLAnnotationSetText(l, nullptr);
-	}
-	// Free remaining data
 	EOLAnnotations()->ClearAll();
+	const DocModification mh(ModificationFlags::ChangeEOLAnnotation, 0, LengthNoExcept(), 0, nullptr, 0);
+	NotifyModified(mh);
 }
 
 void Document::IncrementStyleClock() noexcept {
@@ -2816,6 +4262,15 @@ void SCI_METHOD Document::DecorationFillRange(Sci_Position position, int value,
 	}
 }
 
+void Document::DecorationFillRanges(const Sci::Position *ranges, size_t count, int value) {
+	const FillResult<Sci::Position> fr = decorations->FillRanges(ranges, count, value);
+	if (fr.changed) {
+		const DocModification mh(ModificationFlags::ChangeIndicator | ModificationFlags::User,
+			fr.position, fr.fillLength);
+		NotifyModified(mh);
+	}
+}
+
 bool Document::AddWatcher(DocWatcher *watcher, void *userData) {
 	const WatcherWithUserData wwud(watcher, userData);
 	const auto it = std::find(watchers.begin(), watchers.end(), wwud);
@@ -2877,8 +4332,32 @@ void Document::NotifyGroupCompleted() noexcept {
 void Document::NotifyModified(DocModification mh) {
 	if (FlagSet(mh.modificationType, ModificationFlags::InsertText)) {
 		decorations->InsertSpace(mh.position, mh.length);
+		if (searchIndex) {
+			searchIndex->InsertText(cb, mh.position, mh.length);
+		}
+		if (braceIndex) {
+			if (multiEditDepth != 0) {
+				braceIndex.reset();
+			} else {
+				braceIndex->TextModified(mh.position, mh.length);
+			}
+		}
 	} else if (FlagSet(mh.modificationType, ModificationFlags::DeleteText)) {
 		decorations->DeleteRange(mh.position, mh.length);
+		if (searchIndex) {
+			searchIndex->DeleteText(cb, mh.position, mh.length);
+		}
+		if (braceIndex) {
+			if (multiEditDepth != 0) {
+				braceIndex.reset();
+			} else {
+				braceIndex->TextModified(mh.position, -mh.length);
+			}
+		}
+	} else if (FlagSet(mh.modificationType, ModificationFlags::ChangeStyle)) {
+		if (braceIndex) {
+			braceIndex->StyleModified(mh.position, mh.position + mh.length);
+		}
 	}
 	for (const auto &watcher : watchers) {
 		watcher.watcher->NotifyModified(this, mh, watcher.userData);
@@ -3037,7 +4516,7 @@ constexpr char BraceOpposite(char ch) noexcept {
 }
 
 // TODO: should be able to extend styled region to find matching brace
-Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxReStyle*/, Sci::Position startPos, bool useStartPos) const noexcept {
+Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxReStyle*/, Sci::Position startPos, bool useStartPos) noexcept {
 	const unsigned char chBrace = CharAt(position);
 	const unsigned char chSeek = BraceOpposite(chBrace);
 	if (chSeek == '\0') {
@@ -3049,6 +4528,9 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 	position = useStartPos ? startPos : position + direction;
 	const Sci::Position endStylePos = GetEndStyled();
 	const Sci::Position length = LengthNoExcept();
+	if (length >= BraceIndex::MinDocumentLength) {
+		return BraceMatchIndexed(position, chBrace, chSeek, styBrace, direction);
+	}
 	const SplitView cbView = cb.AllView();
 	int depth = 1;
 	if (IsValidIndex(position + 64*direction, length)) {
@@ -3355,21 +4837,209 @@ Sci::Position Document::BraceMatch(Sci::Position position, Sci::Position /*maxRe
 	return -1;
 }
 
+// same as BraceMatch(), balanced chunks of styled text are skipped with counts from braceIndex.
+Sci::Position Document::BraceMatchIndexed(Sci::Position position, unsigned char chBrace, unsigned char chSeek, int style, int direction) noexcept {
+	if (!braceIndex) {
+		try {
+			braceIndex = std::make_unique<BraceIndex>();
+		} catch (...) {
+			return -1;
+		}
+	}
+
+	const unsigned char chOpen = (direction > 0) ? chBrace : chSeek;
+	BraceIndex::ChunkList &chunks = braceIndex->Chunks(chOpen, style);
+	const unsigned char safeChar = asciiBackwardSafeChar;
+	const Sci::Position endStylePos = GetEndStyled();
+	const Sci::Position length = LengthNoExcept();
+	const SplitView cbView = cb.AllView();
+	const auto isBrace = [&](Sci::Position index, unsigned char ch) noexcept {
+		return (index > endStylePos || StyleIndexAt(index) == style) &&
+			(ch <= safeChar || index == MovePositionOutsideChar(index, direction, false));
+	};
+	// count braces in styled range [start, end)
+	const auto countBraces = [&](Sci::Position start, Sci::Position end) noexcept {
+		int depth = 0;
+		int minDepth = 0;
+		for (Sci::Position index = start; index < end; index++) {
+			const unsigned char ch = cbView[index];
+			if (AnyOf(ch, chBrace, chSeek) && isBrace(index, ch)) {
+				depth += (ch == chOpen) ? 1 : -1;
+				minDepth = std::min(minDepth, depth);
+			}
+		}
+		return BraceIndex::Chunk{ start, end, depth, -minDepth, depth - minDepth };
+	};
+
+	// chunks after endStylePos are kept for unchanged styles, but only used after styled again
+	BraceIndex::ChunkList added;
+	Sci::Position result = -1;
+	int depth = 1;
+	if (direction > 0) {
+		while (position < length) {
+			const size_t index = BraceIndex::FindChunk(chunks, position);
+			Sci::Position end;
+			if (index < chunks.size() && chunks[index].start <= position) {
+				const BraceIndex::Chunk &chunk = chunks[index];
+				end = chunk.end;
+				if (position == chunk.start && chunk.end <= endStylePos && chunk.forward < depth) {
+					depth += chunk.delta;
+					position = end;
+					continue;
+				}
+			} else {
+				end = std::min(position + BraceIndex::ChunkSize, (index < chunks.size()) ? chunks[index].start : length);
+				if (end <= endStylePos) {
+					const BraceIndex::Chunk chunk = countBraces(position, end);
+					try {
+						added.push_back(chunk);
+					} catch (...) {
+					}
+					if (chunk.forward < depth) {
+						depth += chunk.delta;
+						position = end;
+						continue;
+					}
+				}
+			}
+			for (; position < end; position++) {
+				const unsigned char ch = cbView[position];
+				if (AnyOf(ch, chBrace, chSeek) && isBrace(position, ch)) {
+					depth += (ch == chBrace) ? 1 : -1;
+					if (depth == 0) {
+						result = position;
+						break;
+					}
+				}
+			}
+			if (result >= 0) {
+				break;
+			}
+		}
+	} else {
+		while (position >= 0) {
+			const size_t index = BraceIndex::FindChunk(chunks, position);
+			Sci::Position start;
+			if (index < chunks.size() && chunks[index].start <= position) {
+				const BraceIndex::Chunk &chunk = chunks[index];
+				start = chunk.start;
+				if (position + 1 == chunk.end && chunk.end <= endStylePos && chunk.backward < depth) {
+					depth -= chunk.delta;
+					position = start - 1;
+					continue;
+				}
+			} else {
+				start = std::max(position + 1 - BraceIndex::ChunkSize, (index != 0) ? chunks[index - 1].end : 0);
+				if (position < endStylePos) {
+					const BraceIndex::Chunk chunk = countBraces(start, position + 1);
+					try {
+						added.push_back(chunk);
+					} catch (...) {
+					}
+					if (chunk.backward < depth) {
+						depth -= chunk.delta;
+						position = start - 1;
+						continue;
+					}
+				}
+			}
+			for (; position >= start; position--) {
+				const unsigned char ch = cbView[position];
+				if (AnyOf(ch, chBrace, chSeek) && isBrace(position, ch)) {
+					depth += (ch == chBrace) ? 1 : -1;
+					if (depth == 0) {
+						result = position;
+						break;
+					}
+				}
+			}
+			if (result >= 0) {
+				break;
+			}
+		}
+	}
+	BraceIndex::Merge(chunks, added, direction);
+	return result;
+}
+
 namespace {
 
+// Whole document text as raw segments, segment2 is indexed by document position.
+SplitView DocumentView(const Document *doc) noexcept {
+	const Sci::Position length = doc->LengthNoExcept();
+	const SplitRange range = doc->RangeView(0, length);
+	if (range.length2 == 0) {
+		return { range.segment1, static_cast<size_t>(length), range.segment1, static_cast<size_t>(length) };
+	}
+	return { range.segment1, static_cast<size_t>(range.length1), range.segment2 - range.length1, static_cast<size_t>(length) };
+}
+
+// find last ch in [start, end) of contiguous text, returns -1 when not found
+Sci::Position FindLastByte(const char *text, Sci::Position start, Sci::Position end, unsigned char ch) noexcept {
+#if NP2_USE_AVX2
+	const __m256i needle = _mm256_set1_epi8(ch);
+	for (; start + static_cast<Sci::Position>(sizeof(__m256i)) <= end; end -= sizeof(__m256i)) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + end - sizeof(__m256i)));
+		const uint32_t mask = mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+		if (mask) {
+			return end - sizeof(__m256i) + np2_bsr(mask);
+		}
+	}
+#elif NP2_USE_SSE2
+	const __m128i needle = _mm_set1_epi8(ch);
+	for (; start + static_cast<Sci::Position>(sizeof(__m128i)) <= end; end -= sizeof(__m128i)) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + end - sizeof(__m128i)));
+		const uint32_t mask = mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+		if (mask) {
+			return end - sizeof(__m128i) + np2_bsr(mask);
+		}
+	}
+#endif
+	while (end > start) {
+		--end;
+		if (static_cast<unsigned char>(text[end]) == ch) {
+			return end;
+		}
+	}
+	return -1;
+}
+
+// find ch in [start, end) of the document, returns -1 when not found
+Sci::Position FindByte(const SplitView &view, Sci::Position start, Sci::Position end, unsigned char ch, bool backward) noexcept {
+	const Sci::Position length1 = view.length1;
+	if (backward) {
+		if (end > length1) {
+			const Sci::Position found = FindLastByte(view.segment2, std::max(start, length1), end, ch);
+			if (found >= 0) {
+				return found;
+			}
+			end = length1;
+		}
+		return (start < end) ? FindLastByte(view.segment1, start, end, ch) : -1;
+	}
+	if (start < length1) {
+		const Sci::Position last = std::min(end, length1);
+		const char *p = static_cast<const char *>(memchr(view.segment1 + start, ch, last - start));
+		if (p) {
+			return p - view.segment1;
+		}
+		start = last;
+	}
+	if (start < end) {
+		const char *p = static_cast<const char *>(memchr(view.segment2 + start, ch, end - start));
+		if (p) {
+			return p - view.segment2;
+		}
+	}
+	return -1;
+}
+
 // Define a way for the Regular Expression code to access the document
 class DocumentIndexer final : public CharacterIndexer {
 	const Document *pdoc;
-	Sci::Position end;
 public:
-	DocumentIndexer(const Document *pdoc_, Sci::Position end_) noexcept :
-		pdoc(pdoc_), end(end_) {}
-
-	[[nodiscard]] char CharAt(Sci::Position index) const noexcept override {
-		if (IsValidIndex(index, end))
-			return pdoc->CharAt(index);
-		return '\0';
-	}
+	DocumentIndexer(const Document *pdoc_, const SplitView &view, Sci::Position end_) noexcept :
+		CharacterIndexer(view.segment1, view.length1, view.segment2, end_), pdoc(pdoc_) {}
 
 	[[nodiscard]] Sci::Position MovePositionOutsideChar(Sci::Position pos, int moveDir) const noexcept override {
 		return pdoc->MovePositionOutsideChar(pos, moveDir, false);
@@ -3382,7 +5052,7 @@ class RESearchRange;
  */
 class BuiltinRegex final : public RegexSearchBase {
 public:
-	explicit BuiltinRegex(const CharClassify *charClassTable) : search(charClassTable) {}
+	explicit BuiltinRegex(const CharClassify *charClassTable_) : charClassTable(charClassTable_), search(charClassTable_) {}
 
 	Sci::Position FindText(const Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *pattern, FindOption flags, Sci::Position *length) override;
 
@@ -3393,18 +5063,32 @@ public:
 #endif
 
 private:
-#if defined(BOOST_REGEX_STANDALONE)
-	boost::wregex regexUTF8;
-#elif !defined(NO_CXX11_REGEX)
-	std::wregex regexUTF8;
-#endif
+	// number of recently used patterns kept compiled besides current one,
+	// e.g. mark occurrences and find next use different patterns.
+	static constexpr size_t patternCacheSize = 3;
+
+	const CharClassify *charClassTable;
 	RESearch search;
+	// most recently used first
+	std::vector<std::unique_ptr<RESearch>> patternCache;
 #if defined(BOOST_REGEX_STANDALONE) || !defined(NO_CXX11_REGEX)
-	// cache for previous pattern to avoid recompile
-	FindOption previousFlags = FindOption::None;
-	std::string cachedPattern;
+#if defined(BOOST_REGEX_STANDALONE)
+	using RegexType = boost::wregex;
+#else
+	using RegexType = std::wregex;
+#endif
+	struct CompiledRegex {
+		FindOption flags;
+		std::string pattern;
+		RegexType regex;
+	};
+	// most recently used first, front is the current pattern
+	std::vector<CompiledRegex> regexCache;
+	const RegexType &CompileRegex(const Document *doc, const char *pattern, size_t length, FindOption flags, RegexType::flag_type flagsRe);
 #endif
 	std::string substituted;
+
+	const char *CompileSearch(const char *pattern, size_t length, FindOption flags);
 };
 
 /**
@@ -3464,6 +5148,8 @@ class UTF8Iterator {
 	unsigned int characterIndex = 0;
 	// Remaining fields are derived from the determining fields so are excluded in comparisons
 	CharacterWideInfo charInfo;
+	// read ASCII directly from the segments, avoid per byte access through the document
+	SplitView view;
 public:
 	using iterator_category = std::bidirectional_iterator_tag;
 	using value_type = wchar_t;
@@ -3473,6 +5159,9 @@ public:
 
 	explicit UTF8Iterator(const Document *doc_ = nullptr, Sci::Position position_ = 0, bool start = false) noexcept :
 		doc(doc_), position(position_) {
+		if (doc) {
+			view = DocumentView(doc);
+		}
 		if (start) {
 			ReadCharacter();
 		}
@@ -3506,7 +5195,12 @@ public:
 		if (characterIndex) {
 			characterIndex--;
 		} else {
-			position = doc->NextPosition(position, -1);
+			// ASCII byte before position can't be DBCS trail byte in UTF-8 or single byte code page
+			if (position > 0 && UTF8IsAscii(view.CharAt(position - 1)) && (doc->dbcsCodePage == 0 || doc->dbcsCodePage == CpUtf8)) {
+				position--;
+			} else {
+				position = doc->NextPosition(position, -1);
+			}
 			ReadCharacter();
 			characterIndex = charInfo.lenCharacters - 1;
 		}
@@ -3533,7 +5227,14 @@ public:
 	}
 private:
 	void ReadCharacter() noexcept {
-		doc->ExtractCharacter(position, charInfo);
+		const unsigned char ch = view.CharAt(position);
+		if (UTF8IsAscii(ch)) {
+			charInfo.buffer[0] = ch;
+			charInfo.lenCharacters = 1;
+			charInfo.lenBytes = 1;
+		} else {
+			doc->ExtractCharacter(position, charInfo);
+		}
 	}
 };
 
@@ -3617,18 +5318,10 @@ Sci::Position BuiltinRegex::CxxRegexFindText(const Document *doc, const RESearch
 		// Clear the RESearch so can fill in matches
 		search.Clear();
 
-		const size_t patternLen = *length;
-		bool matched = flags != previousFlags || patternLen != cachedPattern.length()
-			|| memcmp(pattern, cachedPattern.data(), patternLen) != 0;
-		if (matched) {
-			const std::wstring ws = WStringFromMultiByte(doc->dbcsCodePage, pattern, patternLen);
-			regexUTF8.assign(ws, flagsRe);
-			previousFlags = flags;
-			cachedPattern.assign(pattern, patternLen);
-		}
+		const RegexType &regexUTF8 = CompileRegex(doc, pattern, *length, flags, flagsRe);
 
 		Sci::Position posMatch = -1;
-		matched = MatchOnLines<UTF8Iterator>(doc, regexUTF8, resr, search, flags);
+		const bool matched = MatchOnLines<UTF8Iterator>(doc, regexUTF8, resr, search, flags);
 		if (matched) {
 			posMatch = search.bopat[0];
 			*length = search.eopat[0] - search.bopat[0];
@@ -3747,18 +5440,10 @@ Sci::Position BuiltinRegex::CxxRegexFindText(const Document *doc, const RESearch
 		// Clear the RESearch so can fill in matches
 		search.Clear();
 
-		const size_t patternLen = *length;
-		bool matched = flags != previousFlags || patternLen != cachedPattern.length()
-			|| memcmp(pattern, cachedPattern.data(), patternLen) != 0;
-		if (matched) {
-			const std::wstring ws = WStringFromMultiByte(doc->dbcsCodePage, pattern, patternLen);
-			regexUTF8.assign(ws, flagsRe);
-			previousFlags = flags;
-			cachedPattern.assign(pattern, patternLen);
-		}
+		const RegexType &regexUTF8 = CompileRegex(doc, pattern, *length, flags, flagsRe);
 
 		Sci::Position posMatch = -1;
-		matched = MatchOnLines<UTF8Iterator>(doc, regexUTF8, resr, search);
+		const bool matched = MatchOnLines<UTF8Iterator>(doc, regexUTF8, resr, search);
 		if (matched) {
 			posMatch = search.bopat[0];
 			*length = search.eopat[0] - search.bopat[0];
@@ -3780,8 +5465,45 @@ Sci::Position BuiltinRegex::CxxRegexFindText(const Document *doc, const RESearch
 
 #endif // BOOST_REGEX_STANDALONE
 
+const BuiltinRegex::RegexType &BuiltinRegex::CompileRegex(const Document *doc, const char *pattern, size_t length, FindOption flags, RegexType::flag_type flagsRe) {
+	const std::string_view sv(pattern, length);
+	const auto it = std::find_if(regexCache.begin(), regexCache.end(), [flags, sv](const CompiledRegex &compiled) noexcept {
+		return compiled.flags == flags && compiled.pattern == sv;
+	});
+	if (it != regexCache.end()) {
+		std::rotate(regexCache.begin(), it, it + 1);
+	} else {
+		const std::wstring ws = WStringFromMultiByte(doc->dbcsCodePage, pattern, length);
+		RegexType regex(ws, flagsRe);
+		if (regexCache.size() > patternCacheSize) {
+			regexCache.pop_back();
+		}
+		regexCache.insert(regexCache.begin(), CompiledRegex{flags, std::string(sv), std::move(regex)});
+	}
+	return regexCache.front().regex;
+}
+
 #endif // BOOST_REGEX_STANDALONE || !NO_CXX11_REGEX
 
+// Compile pattern into search, recently used patterns are swapped in without recompiling.
+const char *BuiltinRegex::CompileSearch(const char *pattern, size_t length, FindOption flags) {
+	if (!search.IsCompiled(pattern, length, flags)) {
+		auto it = std::find_if(patternCache.begin(), patternCache.end(), [pattern, length, flags](const std::unique_ptr<RESearch> &compiled) noexcept {
+			return compiled->IsCompiled(pattern, length, flags);
+		});
+		if (it == patternCache.end()) {
+			// reuse least recently used one
+			if (patternCache.size() < patternCacheSize) {
+				patternCache.push_back(std::make_unique<RESearch>(charClassTable));
+			}
+			it = patternCache.end() - 1;
+		}
+		std::swap(search, **it);
+		std::rotate(patternCache.begin(), it, it + 1);
+	}
+	return search.Compile(pattern, length, flags);
+}
+
 Sci::Position BuiltinRegex::FindText(const Document *doc, Sci::Position minPos, Sci::Position maxPos, const char *pattern, FindOption flags, Sci::Position *length) {
 	const RESearchRange resr(doc, minPos, maxPos);
 #if defined(BOOST_REGEX_STANDALONE) || !defined(NO_CXX11_REGEX)
@@ -3791,7 +5513,7 @@ Sci::Position BuiltinRegex::FindText(const Document *doc, Sci::Position minPos,
 #endif
 
 	const size_t patternLen = *length;
-	const char *errmsg = search.Compile(pattern, patternLen, flags);
+	const char *errmsg = CompileSearch(pattern, patternLen, flags);
 	if (errmsg) {
 		return -1;
 	}
@@ -3805,7 +5527,24 @@ Sci::Position BuiltinRegex::FindText(const Document *doc, Sci::Position minPos,
 	const char searchEnd = pattern[patternLen - 1];
 	const char searchEndPrev = (patternLen > 1) ? pattern[patternLen - 2] : '\0';
 	const bool searchforLineEnd = (searchEnd == '$') && (searchEndPrev != '\\');
+	const SplitView view = DocumentView(doc);
+	const int required = search.RequiredCharacter();
 	for (Sci::Line line = resr.lineRangeStart; line != resr.lineRangeBreak; line += resr.increment) {
+		if (required >= 0) {
+			// skip lines without the character, in both directions
+			Sci::Position found;
+			if (resr.increment > 0) {
+				const Sci::Position start = (line == resr.lineRangeStart) ? resr.startPos : doc->LineStart(line);
+				found = FindByte(view, start, resr.endPos, static_cast<unsigned char>(required), false);
+			} else {
+				const Sci::Position end = (line == resr.lineRangeStart) ? resr.startPos : doc->LineEnd(line);
+				found = FindByte(view, resr.endPos, end, static_cast<unsigned char>(required), true);
+			}
+			if (found < 0) {
+				break;
+			}
+			line = doc->SciLineFromPosition(found);
+		}
 		const Sci::Position lineStartPos = doc->LineStart(line);
 		const Sci::Position lineEndPos = doc->LineEnd(line);
 		Sci::Position startOfLine = lineStartPos;
@@ -3835,7 +5574,7 @@ Sci::Position BuiltinRegex::FindText(const Document *doc, Sci::Position minPos,
 			}
 		}
 
-		const DocumentIndexer di(doc, endOfLine);
+		const DocumentIndexer di(doc, view, endOfLine);
 		search.SetLineRange(lineStartPos, lineEndPos);
 		int success = search.Execute(di, startOfLine, endOfLine);
 		if (success) {
@@ -15,6 +15,9 @@ class LineMarkers;
 class LineLevels;
 class LineState;
 class LineAnnotation;
+class SearchIndex;
+class BraceIndex;
+class BackgroundStyler;
 
 enum class EncodingFamily {
 	eightBit, unicode, dbcs
@@ -198,6 +201,16 @@ struct LexerReleaser {
 
 using LexerInstance = std::unique_ptr<Scintilla::ILexer5, LexerReleaser>;
 
+// Line data saved before re-lexing unchanged text after modification.
+struct LineCheckpoint {
+	int lineState;
+	int level;
+	unsigned char styleEnd;
+	bool operator==(const LineCheckpoint &other) const noexcept {
+		return lineState == other.lineState && level == other.level && styleEnd == other.styleEnd;
+	}
+};
+
 // LexInterface defines the interface to ILexer used in Document.
 // The LexState subclass is actually created and that is used within ScintillaBase
 // to provide more methods that are exposed through Scintilla's external API.
@@ -205,10 +218,21 @@ class LexInterface {
 protected:
 	Document *pdoc;
 	LexerInstance instance;
+	std::unique_ptr<BackgroundStyler> background;
 	bool performingStyle = false;	///< Prevent reentrance
 	bool enableUrlHighlight = false;
 	int lexerLanguage = 0;
+	int restartLines = 0;	///< Lexing after a line only depends on data of these previous lines
+	int nestedStateMask = 0;	///< Line state bits for lines that can't be restart point
+	bool lineLocal = false;	///< Chunks of document can be lexed concurrently
+	Sci::Position styledTail = -1;	///< Distance from document end to end styled before modification
+	Sci::Position unchangedTail = 0;	///< Distance from document end to end of modified text
+	std::vector<LineCheckpoint> checkpoints;
 	uint32_t urlIgnoreStyle[8];
+	LineCheckpoint GetCheckpoint(Sci::Line line) const noexcept;
+	Sci::Line SaveCheckpoints(Sci::Position start, Sci::Position end);
+	void RestoreConverged(Sci::Line lineFirst, Sci::Position end);
+	Sci::Position ColouriseChunks(Sci::Position start, Sci::Position end);
 public:
 	explicit LexInterface(Document *pdoc_) noexcept;
 	LexInterface(const LexInterface &) = delete;
@@ -217,6 +241,11 @@ public:
 	LexInterface &operator=(LexInterface &&) = delete;
 	virtual ~LexInterface() noexcept;
 	void Colourise(Sci::Position start, Sci::Position end);
+	bool ColouriseBackground(Sci::Position start, Sci::Position end);
+	void JoinBackground() noexcept;
+	void StopBackground() noexcept;
+	void ModifiedAt(Sci::Position pos) noexcept;
+	void TextModifiedAt(Sci::Position endStyled, Sci::Position pos, Sci::Position lengthChange) noexcept;
 	virtual Scintilla::LineEndType LineEndTypesSupported() const noexcept;
 	bool UseContainerLexing() const noexcept;
 };
@@ -248,6 +277,9 @@ public:
 	double Duration() const noexcept {
 		return duration;
 	}
+	int BytesPerMillisecond() const noexcept {
+		return static_cast<int>(unitBytes / (duration * 1000.0));
+	}
 	int ActionsInAllowedTime(double secondsAllowed) const noexcept;
 };
 
@@ -329,6 +361,13 @@ private:
 	LineAnnotation *EOLAnnotations() const noexcept;
 
 	std::unique_ptr<RegexSearchBase> regex;
+	// trigram index for literal search, built on first search when document is not smaller than threshold
+	std::unique_ptr<SearchIndex> searchIndex;
+	Sci::Position searchIndexThreshold = 0;
+	// brace balance chunks for BraceMatch(), created on first match in huge document
+	std::unique_ptr<BraceIndex> braceIndex;
+	// nesting of MultiEditGroup, indexes are dropped instead of updated for each edit
+	int multiEditDepth = 0;
 	std::unique_ptr<LexInterface> pli;
 	std::unique_ptr<DBCSCharClassify> dbcsCharClass;
 
@@ -354,7 +393,7 @@ public:
 	uint8_t asciiBackwardSafeChar = 0xff;
 	ActionDuration durationStyleOneUnit;
 
-	const std::unique_ptr<IDecorationList> decorations;
+	std::unique_ptr<IDecorationList> decorations;
 
 	explicit Document(Scintilla::DocumentOption options);
 	// Deleted so Document objects can not be copied.
@@ -373,6 +412,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	Scintilla::LineEndType LineEndTypesSupported() const noexcept;
 	bool SetDBCSCodePage(int dbcsCodePage_);
@@ -412,6 +452,12 @@ public:
 	Sci::Position GetRelativePositionUTF16(Sci::Position positionStart, Sci::Position characterOffset) const noexcept;
 	int SCI_METHOD GetCharacterAndWidth(Sci_Position position, Sci_Position *pWidth) const noexcept override;
 	CharacterClass SCI_METHOD GetCharacterClass(unsigned int ch) const noexcept override;
+	const char * SCI_METHOD GetTextSegment(Sci_Position position, Sci_Position *pStart, Sci_Position *pEnd) const noexcept override {
+		if (IsValidIndex(position, LengthNoExcept())) {
+			return cb.TextSegment(position, *pStart, *pEnd);
+		}
+		return nullptr;
+	}
 	int SCI_METHOD CodePage() const noexcept override;
 	bool SCI_METHOD IsDBCSLeadByte(unsigned char ch) const noexcept override;
 	bool IsDBCSLeadByteNoExcept(unsigned char ch) const noexcept {
@@ -431,6 +477,7 @@ public:
 
 	// Gateways to modifying document
 	void ModifiedAt(Sci::Position pos) noexcept;
+	void TextModifiedAt(Sci::Position pos, Sci::Position lengthChange) noexcept;
 	void CheckReadOnly() noexcept;
 	void TrimReplacement(std::string_view &text, Range &range) const noexcept;
 	bool DeleteChars(Sci::Position pos, Sci::Position len);
@@ -476,6 +523,12 @@ public:
 	}
 	void BeginDelaySavePoint() noexcept;
 	void EndDelaySavePoint() noexcept;
+	void BeginMultiEdit() noexcept {
+		++multiEditDepth;
+	}
+	void EndMultiEdit() noexcept {
+		--multiEditDepth;
+	}
 
 	void TentativeStart() noexcept {
 		cb.TentativeStart();
@@ -502,6 +555,10 @@ public:
 	std::string_view UndoActionText(int action) const noexcept;
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
+	void SetUndoMemoryLimit(size_t limit) noexcept;
+	size_t UndoMemoryLimit() const noexcept;
+	size_t UndoMemory() const noexcept;
+	size_t MemoryUsage(Scintilla::MemoryCategory category) const noexcept;
 
 	void ChangeHistorySet(bool enable) {
 		cb.ChangeHistorySet(enable);
@@ -528,13 +585,18 @@ public:
 	Sci::Position GapPosition() const noexcept {
 		return cb.GapPosition();
 	}
+	SplitRange RangeView(Sci::Position position, Sci::Position rangeLength) const noexcept {
+		return cb.RangeView(position, rangeLength);
+	}
 
 	int SCI_METHOD GetLineIndentation(Sci_Line line) const noexcept override;
 	Sci::Position SetLineIndentation(Sci::Line line, Sci::Position indent);
 	Sci::Position GetLineIndentPosition(Sci::Line line) const noexcept;
 	Sci::Position GetColumn(Sci::Position pos) const noexcept;
+	Sci::Position CountCharactersInRange(Sci::Position startPos, Sci::Position endPos, bool countUTF16) const noexcept;
 	Sci::Position CountCharacters(Sci::Position startPos, Sci::Position endPos) const noexcept;
 	void CountCharactersAndColumns(Scintilla::sptr_t lParam) const noexcept;
+	void CountTextStatistics(Scintilla::sptr_t lParam) const;
 	Sci::Position CountUTF16(Sci::Position startPos, Sci::Position endPos) const noexcept;
 	Sci::Position FindColumn(Sci::Line line, Sci::Position column) const noexcept;
 	void Indent(bool forwards, Sci::Line lineBottom, Sci::Line lineTop);
@@ -551,6 +613,7 @@ public:
 		return cb.IsLarge();
 	}
 	Scintilla::DocumentOption Options() const noexcept;
+	bool ConvertToLarge();
 
 	void DelChar(Sci::Position pos);
 	void DelCharBack(Sci::Position pos);
@@ -576,10 +639,20 @@ public:
 	int CheckRange(const char *chars, const char *styles, Sci::Position position, Sci::Position rangeLength) const noexcept {
 		return cb.CheckRange(chars, styles, position, rangeLength);
 	}
+	// Read-only text (and styles) for background readers, call on the thread modifying the document.
+	std::shared_ptr<const TextSnapshot> Snapshot(bool withStyles = false) {
+		return cb.Snapshot(withStyles);
+	}
+	uint32_t TextVersion() const noexcept {
+		return cb.TextVersion();
+	}
 	MarkerMask GetMark(Sci::Line line, bool includeChangeHistory) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept;
+	Sci::Line ChangeHistoryLineNext(Sci::Line lineStart, MarkerMask mask) const noexcept;
+	Sci::Line MarkerPrevious(Sci::Line lineStart, MarkerMask mask) const noexcept;
 	int AddMark(Sci::Line line, int markerNum);
 	void AddMarkSet(Sci::Line line, MarkerMask valueSet);
+	Sci::Line AddMarkLines(const Sci::Line *lineList, int markerNum);
 	void DeleteMark(Sci::Line line, int markerNum);
 	void DeleteMarkFromHandle(int markerHandle);
 	void DeleteAllMarks(int markerNum);
@@ -595,11 +668,12 @@ public:
 	bool IsLineEndPosition(Sci::Position position) const noexcept;
 	bool IsPositionInLineEnd(Sci::Position position) const noexcept;
 	Sci::Position VCHomePosition(Sci::Position position) const noexcept;
-	Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
-	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const noexcept;
+	Sci::Position IndexLineStart(Sci::Line line, Scintilla::LineCharacterIndexType lineCharacterIndex) const;
+	Sci::Line LineFromPositionIndex(Sci::Position pos, Scintilla::LineCharacterIndexType lineCharacterIndex) const;
 	Sci::Line LineFromPositionAfter(Sci::Line line, Sci::Position length) const noexcept;
 
 	int SCI_METHOD SetLevel(Sci_Line line, int level) override;
+	void SCI_METHOD SetLevels(Sci_Line lineStart, Sci_Line count, const int *levels) override;
 	int SCI_METHOD GetLevel(Sci_Line line) const noexcept override;
 	Scintilla::FoldLevel GetFoldLevel(Sci_Position line) const noexcept;
 	void ClearLevels();
@@ -630,6 +704,11 @@ public:
 	bool HasCaseFolder() const noexcept;
 	void SetCaseFolder(std::unique_ptr<CaseFolder> pcf_) noexcept;
 	Sci::Position FindText(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position *length);
+	Sci::Position FindAll(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position length, std::vector<Sci::Position> &ranges);
+	void SetSearchIndexThreshold(Sci::Position threshold) noexcept;
+	Sci::Position SearchIndexThreshold() const noexcept {
+		return searchIndexThreshold;
+	}
 	const char *SubstituteByPosition(const char *text, Sci::Position *length);
 	Scintilla::LineCharacterIndexType LineCharacterIndex() const noexcept;
 	void AllocateLineCharacterIndex(Scintilla::LineCharacterIndexType lineCharacterIndex);
@@ -654,6 +733,8 @@ public:
 		return endStyled;
 	}
 	void EnsureStyledTo(Sci::Position pos);
+	bool CanStyleBackground() const noexcept;
+	bool StyleBackground(Sci::Position pos);
 	void StyleToAdjustingLineDuration(Sci::Position pos);
 	void LexerChanged(bool hasStyles_);
 	bool EnableUrlHighlight() const noexcept;
@@ -664,6 +745,7 @@ public:
 	void IncrementStyleClock() noexcept;
 	void SCI_METHOD DecorationSetCurrentIndicator(int indicator) noexcept override;
 	void SCI_METHOD DecorationFillRange(Sci_Position position, int value, Sci_Position fillLength) override;
+	void DecorationFillRanges(const Sci::Position *ranges, size_t count, int value);
 	LexInterface *GetLexInterface() const noexcept;
 	void SetLexInterface(std::unique_ptr<LexInterface> pLexInterface) noexcept;
 
@@ -686,19 +768,32 @@ public:
 	void AnnotationSetStyle(Sci::Line line, int style);
 	void AnnotationSetStyles(Sci::Line line, const unsigned char *styles);
 	int AnnotationLines(Sci::Line line) const noexcept;
+	void AnnotationSetBulk(size_t count, Scintilla::sptr_t lParam);
 	void AnnotationClearAll();
 
 	StyledText EOLAnnotationStyledText(Sci::Line line) const noexcept;
 	void EOLAnnotationSetStyle(Sci::Line line, int style);
 	void EOLAnnotationSetText(Sci::Line line, const char *text);
+	void EOLAnnotationSetBulk(size_t count, Scintilla::sptr_t lParam);
 	void EOLAnnotationClearAll();
 
 	bool AddWatcher(DocWatcher *watcher, void *userData);
 	bool RemoveWatcher(DocWatcher *watcher, void *userData) noexcept;
 
+	// same as GetCharacterClass() without virtual call, used in word selection loops
 	CharacterClass WordCharacterClass(unsigned int ch) const noexcept {
-		return GetCharacterClass(ch);
+		if (ch < 0x80 || !dbcsCodePage) {
+			return charClass.GetClass(static_cast<unsigned char>(ch));
+		}
+		if (CpUtf8 == dbcsCodePage) {
+			return CharClassify::ClassifyCharacter(ch);
+		}
+		return dbcsCharClass->ClassifyCharacter(ch);
 	}
+	// skip characters with class cc in either a forward (delta >= 0) or backwards direction (delta < 0).
+	Sci::Position SkipCharacterClass(Sci::Position pos, CharacterClass cc, int delta) const noexcept;
+	// first position in [pos, end) not a space or tab.
+	Sci::Position SkipSpaceOrTab(Sci::Position pos, Sci::Position end) const noexcept;
 	bool IsWordPartSeparator(unsigned int ch) const noexcept;
 	Sci::Position WordPartLeft(Sci::Position pos) const noexcept;
 	Sci::Position WordPartRight(Sci::Position pos) const noexcept;
@@ -709,13 +804,17 @@ public:
 	int IndentSize() const noexcept {
 		return actualIndentInChars;
 	}
-	Sci::Position BraceMatch(Sci::Position position, Sci::Position maxReStyle, Sci::Position startPos, bool useStartPos) const noexcept;
+	Sci::Position BraceMatch(Sci::Position position, Sci::Position maxReStyle, Sci::Position startPos, bool useStartPos) noexcept;
 
 private:
 	void NotifyModifyAttempt() noexcept;
 	void NotifySavePoint(bool atSavePoint) noexcept;
 	void NotifyGroupCompleted() noexcept;
 	void NotifyModified(DocModification mh);
+	bool EnsureSearchIndex();
+	Sci::Position FindLiteral(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position *length);
+	Sci::Position FindIndexed(Sci::Position minPos, Sci::Position maxPos, const char *search, Scintilla::FindOption flags, Sci::Position *length);
+	Sci::Position BraceMatchIndexed(Sci::Position position, unsigned char chBrace, unsigned char chSeek, int style, int direction) noexcept;
 };
 
 class DelaySavePoint {
@@ -757,6 +856,32 @@ public:
 	}
 };
 
+/**
+ * Many small edits at different positions, e.g. typing with thousands of carets.
+ * Indexes which cost O(size) for each edit are dropped and rebuilt on next use.
+ */
+class MultiEditGroup {
+	Document *pdoc;
+	bool groupNeeded;
+public:
+	explicit MultiEditGroup(Document *pdoc_, bool groupNeeded_ = true) noexcept :
+		pdoc(pdoc_), groupNeeded(groupNeeded_) {
+		if (groupNeeded) {
+			pdoc->BeginMultiEdit();
+		}
+	}
+	// Deleted so MultiEditGroup objects can not be copied.
+	MultiEditGroup(const MultiEditGroup &) = delete;
+	MultiEditGroup(MultiEditGroup &&) = delete;
+	void operator=(const MultiEditGroup &) = delete;
+	MultiEditGroup &operator=(MultiEditGroup &&) = delete;
+	~MultiEditGroup() {
+		if (groupNeeded) {
+			pdoc->EndMultiEdit();
+		}
+	}
+};
+
 
 /**
  * To optimise processing of document modifications by DocWatchers, a hint is passed indicating the
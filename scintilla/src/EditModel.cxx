@@ -121,15 +121,7 @@ EditModel::EditModel() :
 	pdoc = new Document(DocumentOption::StylesNone);
 	pdoc->AddRef();
 
-#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
-	// support more than 64 processors on Windows 11, Windows Server 2022 and later system
-	// https://learn.microsoft.com/en-us/windows/win32/procthread/processor-groups
-	hardwareConcurrency = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
-#else
-	SYSTEM_INFO info;
-	GetNativeSystemInfo(&info);
-	hardwareConcurrency = info.dwNumberOfProcessors;
-#endif
+	hardwareConcurrency = GetHardwareConcurrency();
 	idleTaskTimer = CreateWaitableTimer(nullptr, true, nullptr);
 	SetIdleTaskTime(IdleLineWrapTime);
 	UpdateParallelLayoutThreshold();
@@ -223,3 +215,9 @@ void EditModel::UpdateParallelLayoutThreshold() noexcept {
 	minParallelLayoutLength = std::max(ParallelLayoutBlockSize, idleLength/128); // (0.5ms ~ 1ms)*2
 	maxParallelLayoutLength = idleLength*hardwareConcurrency;
 }
+
+void EditModel::SetLayoutThreads(uint32_t threads) noexcept {
+	const uint32_t processors = std::max(GetHardwareConcurrency(), 1U);
+	hardwareConcurrency = (threads == 0) ? processors : std::min(threads, processors);
+	UpdateParallelLayoutThreshold();
+}
@@ -124,6 +124,7 @@ public:
 	void SetIdleTaskTime(uint32_t milliseconds) const noexcept;
 	bool IdleTaskTimeExpired() const noexcept;
 	void UpdateParallelLayoutThreshold() noexcept;
+	void SetLayoutThreads(uint32_t threads) noexcept;
 };
 
 }
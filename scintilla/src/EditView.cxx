@@ -67,6 +67,7 @@
 #include "MarginView.h"
 #include "EditView.h"
 #include "ElapsedPeriod.h"
+#include "EventTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -466,12 +467,7 @@ struct LayoutWorker {
 			}
 
 #elif USE_WIN32_PTP_WORK
-			PTP_WORK work = CreateThreadpoolWork(WorkCallback, this, nullptr);
-			for (uint32_t i = 0; i < threadCount; i++) {
-				SubmitThreadpoolWork(work);
-			}
-			WaitForThreadpoolWorkCallbacks(work, FALSE);
-			CloseThreadpoolWork(work);
+			RunParallelWork(*this, threadCount);
 #endif // USE_WIN32_PTP_WORK
 			return threadCount;
 		}
@@ -523,14 +519,25 @@ struct LayoutWorker {
 
 		UpdateMaximum(finishedCount, finished);
 	}
+};
 
-#if USE_WIN32_PTP_WORK
-	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
-		LayoutWorker *worker = static_cast<LayoutWorker *>(context);
-		worker->DoWork();
+// Fill positions for graphic ASCII characters in visible fixed width styles without measuring them,
+// stop before any other character. Used to skip text far before the position to show in a very long line.
+int LayoutFixedWidthText(LineLayout *ll, const ViewStyle &vstyle, const SpecialRepresentations &reprs, int startPos, int endPos) noexcept {
+	XYPOSITION xPosition = ll->positions[startPos];
+	int pos = startPos;
+	while (pos < endPos) {
+		const unsigned char ch = ll->chars[pos];
+		const Style &style = vstyle.styles[ll->styles[pos]];
+		if (ch < ' ' || ch >= 0x7f || reprs.MayContains(ch) || !style.monospaceASCII || !style.visible) {
+			break;
+		}
+		xPosition += style.aveCharWidth;
+		++pos;
+		ll->positions[pos] = xPosition;
 	}
-#endif
-};
+	return pos;
+}
 
 }
 
@@ -597,6 +604,7 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 		ll->edgeColumn = -1;
 		ll->widthLine = LineLayout::wrapWidthInfinite;
 		ll->lines = 1;
+		ll->bidiValid = false;
 		ll->ClearPositions();
 		if (numCharsInLine == 0) {
 			// empty line with viewEOL disabled
@@ -621,6 +629,16 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 		//}
 		//const ElapsedPeriod period;
 		//posInLine = ll->numCharsInLine; // whole line
+		if (option < LayoutLineOption::Printing && !model.BidirectionalEnabled()) {
+			// keep at least one block before the position for normal layout
+			const int skipEnd = std::min(std::max(posInLine, ll->caretPosition), ll->numCharsInLine) - LayoutWorker::blockSize;
+			if (skipEnd - ll->lastSegmentEnd > LayoutWorker::blockSize) {
+				ll->lastSegmentEnd = LayoutFixedWidthText(ll, vstyle, *model.reprs, ll->lastSegmentEnd, skipEnd);
+			}
+		}
+		EventTraceActivity activity;
+		EventTraceStart(activity, "LayoutLine", TraceLoggingInt64(line, "Line"), TraceLoggingInt32(ll->numCharsInLine, "Bytes"),
+			TraceLoggingInt32(ll->lastSegmentEnd, "Start"), TraceLoggingInt32(posInLine, "End"));
 		LayoutWorker worker{ ll, vstyle, surface, posCache, model, {}};
 		const uint32_t threadCount = worker.Start(posLineStart, posInLine, option);
 
@@ -670,6 +688,7 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 	if ((validity == LineLayout::ValidLevel::positions) || (ll->widthLine != width)) {
 		const int linesWrapped = ll->lines;
 		ll->widthLine = width;
+		ll->bidiValid = false;
 		if (width == LineLayout::wrapWidthInfinite) {
 			ll->lines = 1;
 		} else if (width > ll->positions[ll->lastSegmentEnd]) {
@@ -724,16 +743,93 @@ uint32_t EditView::LayoutLine(const EditModel &model, Surface *surface, const Vi
 			|| (option == LayoutLineOption::PaintText && ll->PartialPosition()))) {
 			const_cast<EditModel &>(model).OnLineWrapped(line, ll->lines, static_cast<int>(option));
 		}
+		EventTraceStop(activity, "LayoutLine", TraceLoggingUInt32(threadCount, "Threads"),
+			TraceLoggingInt32(ll->lastSegmentEnd, "LayoutTo"), TraceLoggingInt32(ll->lines, "Lines"));
 	}
 	ll->validity = validity;
 	return wrappedBytes;
 }
 
-// Fill the LineLayout bidirectional data fields according to each char style
+namespace {
+
+// Conservative check for characters that may reorder the line: Hebrew, Arabic, Syriac, Thaana, NKo (U+0590-U+08FF),
+// directional marks and formatting characters, Hebrew and Arabic presentation forms (U+FB1D-U+FEFF)
+// and supplementary right-to-left scripts. ASCII-only lines exit on the first comparison for each byte.
+bool MayContainRightToLeft(const char *chars, int length) noexcept {
+	const unsigned char *s = reinterpret_cast<const unsigned char *>(chars);
+	for (int i = 0; i < length; i++) {
+		const unsigned char ch = s[i];
+		if (ch < 0xD6) {
+			continue; // ASCII, trail byte or below U+0580
+		}
+		if (ch <= 0xDF) {
+			return true; // U+0580-U+07FF
+		}
+		const unsigned char next = (i + 1 < length) ? s[i + 1] : 0;
+		switch (ch) {
+		case 0xE0:
+			if (next >= 0xA0 && next <= 0xA3) {
+				return true; // U+0800-U+08FF
+			}
+			break;
+		case 0xE2:
+			if (next == 0x80 || next == 0x81) {
+				// U+200E-U+200F, U+202A-U+202E, U+2066-U+2069
+				const unsigned char last = (i + 2 < length) ? s[i + 2] : 0;
+				if ((next == 0x80) ? (last == 0x8E || last == 0x8F || (last >= 0xAA && last <= 0xAE)) : (last >= 0xA6 && last <= 0xA9)) {
+					return true;
+				}
+			}
+			break;
+		case 0xEF:
+			if (next >= 0xAC && next <= 0xBB) {
+				return true; // U+FB00-U+FEFF
+			}
+			break;
+		case 0xF0:
+			if (next == 0x90 || next == 0x9E) {
+				return true; // U+10000-U+10FFF, U+1E000-U+1EFFF
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+// Platform layout for the sub line, created on first use and kept in bidiData until the line is laid out again.
+// Text format doesn't wrap, so layout width only matters when creating the layout.
+IScreenLineLayout *CachedScreenLayout(Surface *surface, const LineLayout *ll, int subLine, const ViewStyle &vs, XYPOSITION width, int tabWidthMinimumPixels) {
+	std::vector<std::unique_ptr<IScreenLineLayout>> &screenLayouts = ll->bidiData->screenLayouts;
+	if (static_cast<size_t>(subLine) >= screenLayouts.size()) {
+		screenLayouts.resize(std::max(subLine + 1, ll->lines));
+	}
+	std::unique_ptr<IScreenLineLayout> &slLayout = screenLayouts[subLine];
+	if (!slLayout) {
+		const ScreenLine screenLine(ll, subLine, vs, width, tabWidthMinimumPixels);
+		slLayout = surface->Layout(&screenLine);
+	}
+	return slLayout.get();
+}
+
+}
+
+// Fill the LineLayout bidirectional data fields according to each char style.
+// Lines without right-to-left characters drop bidiData so normal layout is used.
 
 void EditView::UpdateBidiData(const EditModel &model, const ViewStyle &vstyle, LineLayout *ll) {
 	if (model.BidirectionalEnabled() && (ll->numCharsInLine >= 0)) {
+		if (ll->bidiValid) {
+			return;
+		}
+		ll->bidiValid = true;
+		if (!MayContainRightToLeft(ll->chars.get(), ll->numCharsInLine)) {
+			ll->bidiData.reset();
+			return;
+		}
 		ll->EnsureBidiData();
+		ll->bidiData->screenLayouts.clear();
 		for (int stylesInLine = 0; stylesInLine < ll->numCharsInLine; stylesInLine++) {
 			ll->bidiData->stylesFonts[stylesInLine] = vstyle.styles[ll->styles[stylesInLine]].font;
 		}
@@ -757,6 +853,7 @@ void EditView::UpdateBidiData(const EditModel &model, const ViewStyle &vstyle, L
 		ll->bidiData->widthReprs[ll->numCharsInLine] = 0.0f;
 	} else {
 		ll->bidiData.reset();
+		ll->bidiValid = false;
 	}
 }
 
@@ -782,15 +879,15 @@ Point EditView::LocationFromPosition(Surface *surface, const EditModel &model, S
 		if (model.BidirectionalEnabled()) {
 			// Fill the line bidi data
 			UpdateBidiData(model, vs, ll);
-
+		}
+		if (ll->bidiData) {
 			// Find subLine
 			const int subLine = ll->SubLineFromPosition(posInLine, pe);
 			const int lineStart = ll->LineStart(subLine);
 			const int caretPosition = posInLine - lineStart;
 
 			// Get the point from current position
-			const ScreenLine screenLine(ll, subLine, vs, rcClient.right, tabWidthMinimumPixels);
-			const std::unique_ptr<IScreenLineLayout> slLayout = surface->Layout(&screenLine);
+			IScreenLineLayout *slLayout = CachedScreenLayout(surface, ll, subLine, vs, rcClient.right, tabWidthMinimumPixels);
 			pt.x = slLayout->XFromPosition(caretPosition);
 
 			pt.x += vs.textStart - model.xOffset;
@@ -860,9 +957,9 @@ SelectionPosition EditView::SPositionFromLocation(Surface *surface, const EditMo
 			if (model.BidirectionalEnabled()) {
 				// Fill the line bidi data
 				UpdateBidiData(model, vs, ll);
-
-				const ScreenLine screenLine(ll, subLine, vs, rcClient.right, tabWidthMinimumPixels);
-				const std::unique_ptr<IScreenLineLayout> slLayout = surface->Layout(&screenLine);
+			}
+			if (ll->bidiData) {
+				IScreenLineLayout *slLayout = CachedScreenLayout(surface, ll, subLine, vs, rcClient.right, tabWidthMinimumPixels);
 				positionInLine = slLayout->PositionFromX(pt.x, charPosition) +
 					rangeSubLine.start;
 			} else {
@@ -1160,7 +1257,9 @@ void EditView::DrawEOL(Surface *surface, const EditModel &model, const ViewStyle
 		if (vsDraw.selection.visible && (vsDraw.selection.layer == Layer::Base)) {
 			const SelectionSegment virtualSpaceRange(SelectionPosition(model.pdoc->LineEnd(line)),
 				SelectionPosition(model.pdoc->LineEnd(line), virtualSpaces));
-			for (size_t r = 0; r < model.sel.Count(); r++) {
+			const auto [first, last] = model.sel.RangesTouching(virtualSpaceRange.start.Position(), virtualSpaceRange.end.Position());
+			for (size_t i = first; i < last; i++) {
+				const size_t r = model.sel.RangeIndexed(i);
 				const SelectionSegment portion = model.sel.Range(r).Intersect(virtualSpaceRange);
 				if (!portion.Empty()) {
 					rcSegment.left = xStart + ll->positions[portion.start.Position() - posLineStart] -
@@ -1654,8 +1753,11 @@ void EditView::DrawCarets(Surface *surface, const EditModel &model, const ViewSt
 		return;
 	}
 	const Sci::Position posLineStart = model.pdoc->LineStart(lineDoc);
+	const auto [first, last] = drawDrag ? std::pair<size_t, size_t>(0, 1) :
+		model.sel.RangesTouching(posLineStart, model.pdoc->LineStart(lineDoc + 1));
 	// For each selection draw
-	for (size_t r = 0; (r < model.sel.Count()) || drawDrag; r++) {
+	for (size_t i = first; i < last; i++) {
+		const size_t r = drawDrag ? i : model.sel.RangeIndexed(i);
 		const bool mainCaret = r == model.sel.Main();
 		SelectionPosition posCaret = (drawDrag ? model.posDrag : model.sel.Range(r).caret);
 		if (vsDraw.DrawCaretInsideSelection(model.inOverstrike, imeCaretBlockOverride) &&
@@ -1676,13 +1778,11 @@ void EditView::DrawCarets(Surface *surface, const EditModel &model, const ViewSt
 		if (ll->InLine(offset, subLine) && offset <= ll->numCharsBeforeEOL) {
 			const int lineStart = ll->LineStart(subLine);
 			XYPOSITION xposCaret = ll->positions[offset] + virtualOffset - ll->positions[lineStart];
-			if (model.BidirectionalEnabled() && (posCaret.VirtualSpace() == 0)) {
+			if (ll->bidiData && (posCaret.VirtualSpace() == 0)) {
 				// Get caret point
-				const ScreenLine screenLine(ll, subLine, vsDraw, rcLine.right, tabWidthMinimumPixels);
-
 				const int caretPosition = offset - lineStart;
 
-				const std::unique_ptr<IScreenLineLayout> slLayout = surface->Layout(&screenLine);
+				IScreenLineLayout *slLayout = CachedScreenLayout(surface, ll, subLine, vsDraw, rcLine.right, tabWidthMinimumPixels);
 				const XYPOSITION caretLeft = slLayout->XFromPosition(caretPosition);
 
 				// In case of start of line, the cursor should be at the right
@@ -1754,8 +1854,6 @@ void EditView::DrawCarets(Surface *surface, const EditModel &model, const ViewSt
 				}
 			}
 		}
-		if (drawDrag)
-			break;
 	}
 }
 
@@ -1938,7 +2036,9 @@ void DrawTranslucentSelection(Surface *surface, const EditModel &model, const Vi
 		const SelectionPosition posStart(posLineStart + lineRange.start);
 		const SelectionPosition posEnd(posLineStart + lineRange.end, virtualSpaces);
 		const SelectionSegment virtualSpaceRange(posStart, posEnd);
-		for (size_t r = 0; r < model.sel.Count(); r++) {
+		const auto [first, last] = model.sel.RangesTouching(posStart.Position(), posEnd.Position());
+		for (size_t i = first; i < last; i++) {
+			const size_t r = model.sel.RangeIndexed(i);
 			const SelectionSegment portion = model.sel.Range(r).Intersect(virtualSpaceRange);
 			if (!portion.Empty()) {
 				const SelectionSegment portionInLine = portion.Subtract(posLineStart);
@@ -1947,11 +2047,10 @@ void DrawTranslucentSelection(Surface *surface, const EditModel &model, const Vi
 				const Interval intervalVirtual{
 					portion.start.VirtualSpaceWidth(spaceWidth),
 					portion.end.VirtualSpaceWidth(spaceWidth) };
-				if (model.BidirectionalEnabled()) {
+				if (ll->bidiData) {
 					const SelectionSegment portionInSubLine = portionInLine.Subtract(lineRange.start);
 
-					const ScreenLine screenLine(ll, subLine, vsDraw, rcLine.right, tabWidthMinimumPixels);
-					const std::unique_ptr<IScreenLineLayout> slLayout = surface->Layout(&screenLine);
+					IScreenLineLayout *slLayout = CachedScreenLayout(surface, ll, subLine, vsDraw, rcLine.right, tabWidthMinimumPixels);
 
 					if (slLayout) {
 						const std::vector<Interval> intervals = slLayout->FindRangeIntervals(
@@ -2103,11 +2202,10 @@ void DrawIndicator(int indicNum, Sci::Position startPos, Sci::Position endPos, S
 	const PRectangle rcIndic(left, ybase, right,
 		std::max(ybase + 3, rcLine.bottom));
 
-	if (bidiEnabled) {
-		ScreenLine screenLine(ll, subLine, vsDraw, rcLine.right - xStart, tabWidthMinimumPixels);
+	if (bidiEnabled && ll->bidiData) {
 		const Range lineRange = ll->SubLineRange(subLine, LineLayout::Scope::visibleOnly);
 
-		const std::unique_ptr<IScreenLineLayout> slLayout = surface->Layout(&screenLine);
+		IScreenLineLayout *slLayout = CachedScreenLayout(surface, ll, subLine, vsDraw, rcLine.right - xStart, tabWidthMinimumPixels);
 		const std::vector<Interval> intervals = slLayout->FindRangeIntervals(
 			startPos - lineRange.start, endPos - lineRange.start);
 		for (const Interval &interval : intervals) {
@@ -2145,9 +2243,11 @@ void DrawIndicators(Surface *surface, const EditModel &model, const ViewStyle &v
 		if (under == vsDraw.indicators[deco->Indicator()].under) {
 			Sci::Position startPos = posLineStart + lineStart;
 			while (startPos < posLineEnd) {
-				const Range rangeRun(deco->StartRun(startPos), deco->EndRun(startPos));
+				Sci::Position startRun = 0;
+				Sci::Position endRun = 0;
+				const int value = deco->RunAt(startPos, startRun, endRun);
+				const Range rangeRun(startRun, endRun);
 				const Sci::Position endPos = std::min(rangeRun.end, posLineEnd);
-				const int value = deco->ValueAt(startPos);
 				if (value) {
 					const bool hover = vsDraw.indicators[deco->Indicator()].IsDynamic() &&
 						rangeRun.ContainsCharacter(model.hoverIndicatorPos);
@@ -2334,9 +2434,10 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 						const Indicator &indicator = vsDraw.indicators[deco->Indicator()];
 						bool hover = false;
 						if (indicator.IsDynamic()) {
-							const Sci::Position startPos = ts.start + posLineStart;
-							const Range rangeRun(deco->StartRun(startPos), deco->EndRun(startPos));
-							hover =	rangeRun.ContainsCharacter(model.hoverIndicatorPos);
+							Sci::Position startRun;
+							Sci::Position endRun;
+							deco->RunAt(ts.start + posLineStart, startRun, endRun);
+							hover =	Range(startRun, endRun).ContainsCharacter(model.hoverIndicatorPos);
 						}
 						if (hover) {
 							if (indicator.sacHover.style == IndicatorStyle::TextFore) {
@@ -2442,6 +2543,10 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 				}
 				if (vsDraw.viewWhitespace != WhiteSpace::Invisible ||
 					(inIndentation && vsDraw.viewIndentationGuides != IndentView::None)) {
+					// dots for spaces in the segment have same colour, fill them in batches
+					const ColourRGBA whiteSpaceFore = vsDraw.ElementColour(Element::WhiteSpace).value_or(textFore);
+					std::array<PRectangle, 64> dots;
+					size_t dotCount = 0;
 					for (int cpos = 0; cpos <= i - ts.start; cpos++) {
 						if (ll->chars[cpos + ts.start] == ' ') {
 							if (vsDraw.viewWhitespace != WhiteSpace::Invisible) {
@@ -2458,8 +2563,11 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 										rcSegment.top + (vsDraw.lineHeight / 2), 0.0f, 0.0f);
 									rcDot.right = rcDot.left + vsDraw.whitespaceSize;
 									rcDot.bottom = rcDot.top + vsDraw.whitespaceSize;
-									const ColourRGBA whiteSpaceFore = vsDraw.ElementColour(Element::WhiteSpace).value_or(textFore);
-									surface->FillRectangleAligned(rcDot, Fill(whiteSpaceFore));
+									dots[dotCount++] = rcDot;
+									if (dotCount == dots.size()) {
+										surface->FillRectanglesAligned(dots.data(), dotCount, Fill(whiteSpaceFore));
+										dotCount = 0;
+									}
 								}
 							}
 							if (inIndentation && vsDraw.viewIndentationGuides == IndentView::Real) {
@@ -2477,6 +2585,9 @@ void EditView::DrawForeground(Surface *surface, const EditModel &model, const Vi
 							inIndentation = false;
 						}
 					}
+					if (dotCount != 0) {
+						surface->FillRectanglesAligned(dots.data(), dotCount, Fill(whiteSpaceFore));
+					}
 				}
 			}
 			if (hoverUnderline || (inHotspot && vsDraw.hotspotUnderline)) {
@@ -2676,6 +2787,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 		}
 
 		model.SetIdleTaskTime(EditModel::MaxPaintTextTime);
+		model.sel.BuildIndex();
 		const Point ptOrigin = model.GetVisibleOriginInMain();
 
 		const int screenLinePaintFirst = static_cast<int>(rcArea.top) / vsDraw.lineHeight;
@@ -2688,7 +2800,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 		PRectangle rcTextArea = rcClient;
 		if (vsDraw.marginInside) {
 			rcTextArea.left += vsDraw.textStart;
-			rcTextArea.right -= vsDraw.rightMarginWidth;
+			rcTextArea.right -= vsDraw.RightSideWidth();
 		} else {
 			rcTextArea = rcArea;
 		}
@@ -2739,12 +2851,15 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 #endif
 				if (lineDoc != lineDocPrevious) {
 					lineDocPrevious = lineDoc;
+					const ElapsedPeriod epLayout;
 					ll = RetrieveLineLayout(lineDoc, model);
+					paintCounters.linesLaidOut += ll->validity != LineLayout::ValidLevel::lines;
 					LayoutLine(model, surface, vsDraw, ll, model.wrapWidth, LayoutLineOption::PaintText);
 					if (model.BidirectionalEnabled()) {
 						// Fill the line bidi data
 						UpdateBidiData(model, vsDraw, ll);
 					}
+					paintCounters.layoutTime += epLayout.Duration();
 				}
 #if defined(TIME_PAINTING)
 				durLayout += ep.Reset();
@@ -2793,7 +2908,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 					if (bufferedDraw) {
 						const Point from = Point::FromInts(vsDraw.textStart - leftTextOverlap, 0);
 						const PRectangle rcCopyArea = PRectangle::FromInts(vsDraw.textStart - leftTextOverlap, yposScreen,
-							static_cast<int>(rcClient.right - vsDraw.rightMarginWidth),
+							static_cast<int>(rcClient.right - vsDraw.RightSideWidth()),
 							yposScreen + vsDraw.lineHeight);
 						pixmapLine->FlushDrawing();
 						surfaceWindow->Copy(rcCopyArea, from, *pixmapLine);
@@ -2825,7 +2940,7 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 		// Right column limit indicator
 		PRectangle rcBeyondEOF = (vsDraw.marginInside) ? rcClient : rcArea;
 		rcBeyondEOF.left = static_cast<XYPOSITION>(vsDraw.textStart);
-		rcBeyondEOF.right = rcBeyondEOF.right - ((vsDraw.marginInside) ? vsDraw.rightMarginWidth : 0);
+		rcBeyondEOF.right = rcBeyondEOF.right - ((vsDraw.marginInside) ? vsDraw.RightSideWidth() : 0);
 		rcBeyondEOF.top = static_cast<XYPOSITION>((model.pcs->LinesDisplayed() - model.TopLineOfMain()) * vsDraw.lineHeight);
 		if (rcBeyondEOF.top < rcBeyondEOF.bottom) {
 			surfaceWindow->FillRectangleAligned(rcBeyondEOF, Fill(vsDraw.styles[StyleDefault].back));
@@ -2852,8 +2967,9 @@ void EditView::PaintText(Surface *surfaceWindow, const EditModel &model, const V
 		//Platform::DebugPrintf("start display %d, offset = %d\n", model.pdoc->LengthNoExcept(), model.xOffset);
 #if defined(TIME_PAINTING)
 		Platform::DebugPrintf(
-			"Layout:%9.6g    Paint:%9.6g    Ratio:%9.6g   Copy:%9.6g   Total:%9.6g\n",
-			durLayout, durPaint, durLayout / durPaint, durCopy, epWhole.Duration());
+			"Layout:%9.6g    Paint:%9.6g    Ratio:%9.6g   Copy:%9.6g   Total:%9.6g   Allocations:%zu\n",
+			durLayout, durPaint, durLayout / durPaint, durCopy, epWhole.Duration(), llc.allocations);
+		llc.allocations = 0;
 #endif
 	}
 }
@@ -2918,6 +3034,7 @@ Sci::Position EditView::FormatRange(bool draw, CharacterRangeFull chrg, Scintill
 	// Printing uses different margins, so reset screen margins
 	vsPrint.leftMarginWidth = 0;
 	vsPrint.rightMarginWidth = 0;
+	vsPrint.overviewRulerWidth = 0;
 
 	vsPrint.Refresh(*surfaceMeasure, model.pdoc->tabInChars);
 	// Determining width must happen after fonts have been realised in Refresh
@@ -100,6 +100,14 @@ public:
 
 	LineLayoutCache llc;
 	PositionCache posCache;
+
+	// accumulated for SCI_GETPAINTSTATISTICS, reset by Editor
+	struct PaintCounters {
+		uint32_t frames = 0;
+		uint32_t linesLaidOut = 0;
+		double paintTime = 0;
+		double layoutTime = 0;
+	} paintCounters;
 	PrintParameters printParameters;
 
 	int tabArrowHeight; // draw arrow heads this many pixels above/below line midpoint
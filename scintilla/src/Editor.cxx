@@ -23,6 +23,7 @@
 #include <forward_list>
 #include <optional>
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <memory>
 #include <atomic>
@@ -65,8 +66,10 @@
 #include "EditModel.h"
 #include "MarginView.h"
 #include "EditView.h"
+#include "OverviewRuler.h"
 #include "Editor.h"
 #include "ElapsedPeriod.h"
+#include "EventTrace.h"
 
 using namespace Scintilla;
 using namespace Scintilla::Internal;
@@ -124,6 +127,37 @@ public:
 	}
 };
 
+// set flag while sweeping selection ranges, cleared on exception
+class DeferSelectionMove {
+	bool &flag;
+public:
+	DeferSelectionMove(bool &flag_, bool defer) noexcept : flag{flag_} {
+		flag = defer;
+	}
+	~DeferSelectionMove() {
+		flag = false;
+	}
+};
+
+// column of position from start of its line, ASCII and tab are counted without decoding characters
+Sci::Position LineColumn(Document *pdoc, Sci::Position lineStart, Sci::Position position) noexcept {
+	const Sci::Position length = position - lineStart;
+	const char * const text = pdoc->RangePointer(lineStart, length);
+	const Sci::Position tabInChars = pdoc->tabInChars;
+	Sci::Position column = 0;
+	for (Sci::Position i = 0; i < length; i++) {
+		const char ch = text[i];
+		if (ch == '\t') {
+			column = ((column / tabInChars) + 1) * tabInChars;
+		} else if (UTF8IsAscii(ch)) {
+			column++;
+		} else {
+			return pdoc->GetColumn(position);
+		}
+	}
+	return column;
+}
+
 }
 
 Timer::Timer() noexcept :
@@ -204,9 +238,11 @@ Editor::Editor() {
 	willRedrawAll = false;
 	idleStyling = IdleStyling::None;
 	needIdleStyling = false;
+	backgroundStyling = false;
 
 	recordingMacro = false;
 	convertPastes = true;
+	deferSelectionMove = false;
 
 	commandEvents = true;
 	modEventMask = ModificationFlags::EventMaskAll;
@@ -238,6 +274,14 @@ void Editor::DropGraphics() noexcept {
 	view.DropGraphics();
 }
 
+void Editor::ReleaseResources() noexcept {
+	DropGraphics();
+	view.llc.Deallocate();
+	view.posCache.Clear();
+	overviewRuler.DropBuckets();
+	FontRealised::ReleaseUnused();
+}
+
 void Editor::InvalidateStyleData() noexcept {
 	stylesValid = false;
 	vs.technology = technology;
@@ -252,6 +296,43 @@ void Editor::InvalidateStyleRedraw() noexcept {
 	Redraw();
 }
 
+// for changes which only affect colours or decorations when inside SCI_BEGINSTYLEUPDATE,
+// layout caches are kept until SCI_ENDSTYLEUPDATE finds fonts are changed.
+void Editor::InvalidateStyleColours() noexcept {
+	if (styleUpdateLevel == 0) {
+		InvalidateStyleRedraw();
+	} else {
+		stylesValid = false;
+		styleUpdatePending = true;
+	}
+}
+
+void Editor::BeginStyleUpdate() {
+	if (styleUpdateLevel++ == 0) {
+		RefreshStyleData();
+		stylesBeforeUpdate = vs.styles;
+		styleUpdatePending = false;
+	}
+}
+
+void Editor::EndStyleUpdate() {
+	if (styleUpdateLevel == 0 || --styleUpdateLevel != 0) {
+		return;
+	}
+	if (styleUpdatePending) {
+		styleUpdatePending = false;
+		if (vs.SameLayoutStyles(stylesBeforeUpdate)) {
+			// LineLayoutCache, PositionCache and wrapping are still valid
+			RefreshStyleData();
+			Redraw();
+		} else {
+			InvalidateStyleRedraw();
+		}
+	}
+	stylesBeforeUpdate.clear();
+	stylesBeforeUpdate.shrink_to_fit();
+}
+
 void Editor::RefreshStyleData() {
 	if (!stylesValid) {
 		stylesValid = true;
@@ -307,10 +388,22 @@ PRectangle Editor::GetClientDrawingRectangle() const noexcept {
 PRectangle Editor::GetTextRectangle() const noexcept {
 	PRectangle rc = GetClientRectangle();
 	rc.left += vs.textStart;
-	rc.right -= vs.rightMarginWidth;
+	rc.right -= vs.RightSideWidth();
+	return rc;
+}
+
+PRectangle Editor::GetOverviewRulerRectangle() const noexcept {
+	PRectangle rc = GetClientRectangle();
+	rc.left = rc.right - vs.overviewRulerWidth;
 	return rc;
 }
 
+void Editor::RedrawOverviewRuler() noexcept {
+	if (vs.overviewRulerWidth > 0) {
+		RedrawRect(GetOverviewRulerRectangle());
+	}
+}
+
 Sci::Line Editor::LinesOnScreen() const noexcept {
 	//const Point sizeClient = ClientSize();
 	//const int htClient = static_cast<int>(sizeClient.y);
@@ -860,7 +953,7 @@ void Editor::MovedCaret(SelectionPosition newPos, SelectionPosition previousPos,
 	if (ensureVisible) {
 		// In case in need of wrapping to ensure DisplayFromDoc works.
 		if (currentLine >= wrapPending.start) {
-			if (WrapLines(WrapScope::wsAll)) {
+			if (WrapLines(WrapScope::wsTarget, currentLine)) {
 				Redraw();
 			}
 		}
@@ -1007,6 +1100,8 @@ void Editor::ScrollTo(Sci::Line line, bool moveThumb) {
 		// Perform redraw rather than scroll if many lines would be redrawn anyway.
 		if (performBlit) {
 			ScrollText(linesToMove);
+			// visible range on the ruler is moved
+			RedrawOverviewRuler();
 		} else {
 			Redraw();
 		}
@@ -1626,12 +1721,7 @@ struct WrapBlockWorker {
 			f.wait();
 		}
 #else
-		PTP_WORK work = CreateThreadpoolWork(WorkCallback, this, nullptr);
-		for (uint32_t i = 0; i < threadCount; i++) {
-			SubmitThreadpoolWork(work);
-		}
-		WaitForThreadpoolWorkCallbacks(work, FALSE);
-		CloseThreadpoolWork(work);
+		RunParallelWork(*this, threadCount);
 #endif
 
 		const uint32_t wrappedBytes = wrappedBytesAllThread.load(std::memory_order_relaxed);
@@ -1640,7 +1730,11 @@ struct WrapBlockWorker {
 
 	void DoWork() {
 		// llTemporary is reused for non-significant lines, avoiding allocation costs.
-		LineLayout llTemporary(-1, -1);
+		std::unique_ptr<LineLayout> llTemporary;
+		{
+			const LockGuard<NativeMutex> guard(mutexRetrieve);
+			llTemporary = view.llc.AcquireTemporary();
+		}
 		uint32_t wrappedBytesOneThread = 0;
 		const int lengthToMultiThread = 2*model.minParallelLayoutLength;
 		const int wrapWidth = std::max(model.wrapWidth, LineLayout::wrapWidthMinimum);
@@ -1667,7 +1761,7 @@ struct WrapBlockWorker {
 					linesAfterWrap[index] = 1;
 					continue;
 				} else {
-					ll = &llTemporary;
+					ll = llTemporary.get();
 					ll->Reset(lineNumber, lengthLine);
 				}
 				const uint32_t wrappedBytes = view.LayoutLine(model, surface, vstyle, ll, wrapWidth, LayoutLineOption::CallerMultiThreaded);
@@ -1676,14 +1770,9 @@ struct WrapBlockWorker {
 			}
 		}
 		wrappedBytesAllThread.fetch_add(wrappedBytesOneThread, std::memory_order_relaxed);
+		const LockGuard<NativeMutex> guard(mutexRetrieve);
+		view.llc.ReleaseTemporary(std::move(llTemporary));
 	}
-
-#if USE_WIN32_PTP_WORK
-	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
-		WrapBlockWorker *worker = static_cast<WrapBlockWorker *>(context);
-		worker->DoWork();
-	}
-#endif
 };
 
 }
@@ -1729,12 +1818,24 @@ int Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToWr
 	durationWrapOneUnit.AddSample(wrappedBytesAllThread, duration);
 	UpdateParallelLayoutThreshold();
 
+	// sample wrap factor of long lines to refine estimated heights for lines still pending
+	const double charsPerLine = std::max(1.0, wrapWidth / vs.aveCharWidth);
+	double subLinesEstimated = 0;
+	Sci::Line subLinesWrapped = 0;
+	Sci::Position posLineEnd = pdoc->LineStart(lineToWrap);
 	for (size_t index = 0; index < worker.linesBeingWrapped; index++) {
 		const Sci::Line lineNumber = lineToWrap + index;
+		const Sci::Position posLineStart = posLineEnd;
+		posLineEnd = pdoc->LineStart(lineNumber + 1);
 		int linesWrapped = worker.linesAfterWrap[index];
 		if (linesWrapped == 0) {
 			continue;
 		}
+		const Sci::Position lengthLine = posLineEnd - posLineStart;
+		if (linesWrapped > 1 || lengthLine > charsPerLine) {
+			subLinesEstimated += (lengthLine - 1) / charsPerLine;
+			subLinesWrapped += linesWrapped - 1;
+		}
 		if (vs.annotationVisible != AnnotationVisible::Hidden) {
 			linesWrapped += pdoc->AnnotationLines(lineNumber);
 		}
@@ -1743,16 +1844,48 @@ int Editor::WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToWr
 		}
 	}
 
-	wrapPending.start = std::max(wrapPending.start, lineToWrapEnd);
+	if (subLinesEstimated >= 16) {
+		const double factor = std::clamp(subLinesWrapped / subLinesEstimated, 0.25, 4.0);
+		wrapEstimateFactor = (wrapEstimateFactor + factor) / 2;
+	}
+
+	// lines wrapped ahead of pending start (visible or target region) are wrapped
+	// again when wrapping reaches them, so lines skipped over keep estimated heights.
+	if (lineToWrap <= wrapPending.start) {
+		wrapPending.start = std::max(wrapPending.start, lineToWrapEnd);
+	}
 	return wrapOccurred;
 }
 
+// Guess display lines for lines waiting to be wrapped from their length and average character width,
+// so scroll bar and line counts are close to final while idle wrapping works through the document.
+// Average character width is corrected by wrap factor sampled from wrapped lines.
+bool Editor::EstimateWrapHeights(Sci::Line lineStart, Sci::Line lineEnd) {
+	const double charsPerLine = std::max(1.0, wrapWidth / vs.aveCharWidth / wrapEstimateFactor);
+	const bool annotationVisible = vs.annotationVisible != AnnotationVisible::Hidden;
+	bool changed = false;
+	pcs->BeginBatch();
+	Sci::Position posLineEnd = pdoc->LineStart(lineStart);
+	for (Sci::Line lineDoc = lineStart; lineDoc < lineEnd; lineDoc++) {
+		const Sci::Position posLineStart = posLineEnd;
+		posLineEnd = pdoc->LineStart(lineDoc + 1);
+		int linesWrapped = 1 + static_cast<int>(std::max<Sci::Position>(posLineEnd - posLineStart - 1, 0) / charsPerLine);
+		if (annotationVisible) {
+			linesWrapped += pdoc->AnnotationLines(lineDoc);
+		}
+		changed |= pcs->SetHeight(lineDoc, linesWrapped);
+	}
+	pcs->EndBatch();
+	return changed;
+}
+
 // Perform  wrapping for a subset of the lines needing wrapping.
 // wsAll: wrap all lines which need wrapping in this single call
 // wsVisible: wrap currently visible lines
 // wsIdle: wrap one page + 100 lines
+// wsTarget: wrap lines around lineTarget ahead of lines before it
 // Return true if wrapping occurred.
-bool Editor::WrapLines(WrapScope ws) {
+bool Editor::WrapLines(WrapScope ws, Sci::Line lineTarget) {
 	// const ElapsedPeriod period;
 	Sci::Line goodTopLine = topLine;
 	int wrapOccurred = false;
@@ -1805,6 +1938,15 @@ bool Editor::WrapLines(WrapScope ws) {
 				// Currently visible text does not need wrapping
 				return false;
 			}
+		} else if (ws == WrapScope::wsTarget) {
+			const Sci::Line lines = LinesOnScreen() + 1;
+			lineToWrapEnd = pdoc->LineFromPositionAfter(lineToWrap, maxParallelLayoutLength);
+			if (lineToWrapEnd < lineTarget + lines) {
+				// Target is far away (e.g. caret moved to end of document), priority wrap a page around it,
+				// pending lines before it keep estimated heights until idle wrapping reaches them.
+				lineToWrap = std::max(lineTarget - lines, lineToWrap);
+				lineToWrapEnd = lineTarget + lines;
+			}
 		} else /*if (ws == WrapScope::wsIdle)*/ {
 			// Try to keep time taken by wrapping reasonable so interaction remains smooth.
 			// constexpr double secondsAllowed = 0.05;
@@ -1820,13 +1962,22 @@ bool Editor::WrapLines(WrapScope ws) {
 		if (lineToWrap < lineToWrapEnd) {
 			PRectangle rcTextArea = GetClientRectangle();
 			rcTextArea.left = static_cast<XYPOSITION>(vs.textStart);
-			rcTextArea.right -= vs.rightMarginWidth;
+			rcTextArea.right -= vs.RightSideWidth();
+			const int wrapWidthPrevious = wrapWidth;
 			wrapWidth = static_cast<int>(rcTextArea.Width());
 			RefreshStyleData();
+			if (ws != WrapScope::wsAll && (wrapWidth != wrapWidthPrevious || !wrapPending.estimated)) {
+				wrapPending.estimated = true;
+				wrapOccurred = EstimateWrapHeights(wrapPending.start, lineEndNeedWrap);
+			}
 			const AutoSurface surface(this);
 			if (surface) {
 				//Platform::DebugPrintf("Wraplines: scope=%0d need=%0d..%0d perform=%0d..%0d\n", ws, wrapPending.start, wrapPending.end, lineToWrap, lineToWrapEnd);
-				wrapOccurred = WrapBlock(surface, lineToWrap, lineToWrapEnd);
+				EventTraceActivity activity;
+				EventTraceStart(activity, "WrapLines", TraceLoggingInt32(static_cast<int>(ws), "Scope"),
+					TraceLoggingInt64(lineToWrap, "LineStart"), TraceLoggingInt64(lineToWrapEnd, "LineEnd"));
+				wrapOccurred |= WrapBlock(surface, lineToWrap, lineToWrapEnd);
+				EventTraceStop(activity, "WrapLines", TraceLoggingInt64(wrapPending.start, "WrappedTo"));
 				goodTopLine = pcs->DisplayFromDocSub(lineScrollTo.lineDoc, lineScrollTo.subLine);
 			}
 		}
@@ -1871,6 +2022,71 @@ bool Editor::WrapLines(WrapScope ws) {
 	return wrapOccurred;
 }
 
+// Keep lines with largest byte length from lines in [lineStart, lineEnd) and previous candidates,
+// so scrollWidth is known from the first paint without layout of every line.
+void Editor::FindWideLineCandidates(Sci::Line lineStart, Sci::Line lineEnd) {
+	constexpr size_t maxCandidates = 16;
+	lineEnd = std::min(lineEnd, pdoc->LinesTotal());
+	// lines that can't be wider than scrollWidth even every byte is a tab or a representation blob
+	const int maxByteLength = std::max(Representation::maxByteLength, pdoc->tabInChars);
+	const Sci::Position minLength = static_cast<Sci::Position>(scrollWidth / (std::max(vs.aveCharWidth, 1.0) * maxByteLength));
+	// min heap of byte length and line
+	using Candidate = std::pair<Sci::Position, Sci::Line>;
+	std::vector<Candidate> heap;
+	heap.reserve(maxCandidates + wideLineCandidates.size());
+	const auto addCandidate = [&heap, minLength](Sci::Position length, Sci::Line line) {
+		if (length <= minLength || (heap.size() == maxCandidates && length <= heap.front().first)) {
+			return;
+		}
+		heap.emplace_back(length, line);
+		std::push_heap(heap.begin(), heap.end(), std::greater<>());
+		if (heap.size() > maxCandidates) {
+			std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+			heap.pop_back();
+		}
+	};
+
+	const Sci::Line linesTotal = pdoc->LinesTotal();
+	for (const Sci::Line line : wideLineCandidates) {
+		if (line < linesTotal && (line < lineStart || line >= lineEnd)) {
+			addCandidate(pdoc->LineStart(line + 1) - pdoc->LineStart(line), line);
+		}
+	}
+	Sci::Position posLineEnd = pdoc->LineStart(lineStart);
+	for (Sci::Line line = lineStart; line < lineEnd; line++) {
+		const Sci::Position posLineStart = posLineEnd;
+		posLineEnd = pdoc->LineStart(line + 1);
+		addCandidate(posLineEnd - posLineStart, line);
+	}
+
+	wideLineCandidates.clear();
+	for (const Candidate &candidate : heap) {
+		wideLineCandidates.push_back(candidate.second);
+	}
+}
+
+// Only candidates are measured precisely, very long lines are estimated from average character width.
+void Editor::MeasureWideLineCandidates(Surface *surface) {
+	constexpr Sci::Position maxMeasureLength = 64*1024;
+	const Sci::Line linesTotal = pdoc->LinesTotal();
+	for (const Sci::Line line : wideLineCandidates) {
+		if (line >= linesTotal) {
+			continue;
+		}
+		const Sci::Position length = pdoc->LineEnd(line) - pdoc->LineStart(line);
+		XYPOSITION width = std::min<XYPOSITION>(length * vs.aveCharWidth, INT_MAX/2);
+		if (length <= maxMeasureLength) {
+			LineLayout * const ll = view.RetrieveLineLayout(line, *this);
+			view.LayoutLine(*this, surface, vs, ll, wrapWidth, LayoutLineOption::AutoUpdate);
+			if (!ll->PartialPosition()) {
+				width = ll->positions[ll->numCharsInLine];
+			}
+		}
+		view.lineWidthMaxSeen = std::max(view.lineWidthMaxSeen, static_cast<int>(width));
+	}
+	wideLineCandidates.clear();
+}
+
 void Editor::LinesJoin() {
 	if (!RangeContainsProtected(targetRange.start.Position(), targetRange.end.Position())) {
 		const UndoGroup ug(pdoc);
@@ -1918,6 +2134,71 @@ void Editor::LinesSplit(int pixelWidth) {
 	}
 }
 
+Sci::Position Editor::LinesPad(LinesPadFlag flags) {
+	struct LinePad {
+		Sci::Position position;
+		Sci::Position column;
+	};
+	const bool skipEmpty = FlagSet(flags, LinesPadFlag::SkipEmpty);
+	const bool rectangular = FlagSet(flags, LinesPadFlag::Rectangular) && sel.IsRectangular();
+	std::vector<LinePad> pads;
+	Sci::Position maxColumn = 0;
+	if (rectangular) {
+		// rectangular selection has one range per line, only lines ending inside the selection are padded
+		pads.reserve(sel.Count());
+		for (size_t r = 0; r < sel.Count(); r++) {
+			const Sci::Position position = sel.Range(r).End().Position();
+			const Sci::Line line = pdoc->SciLineFromPosition(position);
+			const Sci::Position lineStart = pdoc->LineStart(line);
+			const Sci::Position column = LineColumn(pdoc, lineStart, position);
+			maxColumn = std::max(maxColumn, column);
+			if (position == pdoc->LineEnd(line) && !(skipEmpty && position == lineStart)) {
+				pads.push_back({position, column});
+			}
+		}
+		if (pads.size() > 1 && pads.front().position > pads.back().position) {
+			std::reverse(pads.begin(), pads.end());
+		}
+	} else {
+		const Sci::Line lineStart = pdoc->SciLineFromPosition(targetRange.start.Position());
+		const Sci::Line lineEnd = pdoc->SciLineFromPosition(targetRange.end.Position());
+		pads.reserve(lineEnd - lineStart + 1);
+		for (Sci::Line line = lineStart; line <= lineEnd; line++) {
+			const Sci::Position start = pdoc->LineStart(line);
+			const Sci::Position position = pdoc->LineEnd(line);
+			const Sci::Position column = LineColumn(pdoc, start, position);
+			maxColumn = std::max(maxColumn, column);
+			if (!(skipEmpty && position == start)) {
+				pads.push_back({position, column});
+			}
+		}
+	}
+
+	Sci::Position padded = 0;
+	if (!pads.empty() && !RangeContainsProtected(pads.front().position, pads.back().position)) {
+		const std::string spaces(maxColumn, ' ');
+		// ranges of rectangular selection are rebuilt after all lines are padded
+		const bool deferred = rectangular && sel.selType == Selection::SelTypes::rectangle;
+		const UndoGroup ug(pdoc);
+		{
+			const DeferSelectionMove dsm(deferSelectionMove, deferred);
+			const MultiEditGroup meg(pdoc, pads.size() > 1);
+			// Loop in reverse to avoid disturbing positions of lines yet to be padded.
+			for (auto it = pads.rbegin(); it != pads.rend(); ++it) {
+				const Sci::Position length = maxColumn - it->column;
+				if (length > 0) {
+					pdoc->InsertString(it->position, spaces.data(), length);
+					padded++;
+				}
+			}
+		}
+		if (deferred) {
+			SetRectangularRange();
+		}
+	}
+	return padded;
+}
+
 void Editor::PaintSelMargin(Surface *surfaceWindow, PRectangle rc) {
 	if (vs.fixedColumnWidth == 0)
 		return;
@@ -1973,8 +2254,12 @@ void Editor::RefreshPixMaps(Surface *surfaceWindow) {
 }
 
 void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
+	const ElapsedPeriod epPaint;
 	redrawPendingText = false;
 	redrawPendingMargin = false;
+	EventTraceActivity activity;
+	EventTraceStart(activity, "Paint", TraceLoggingInt64(topLine, "TopLine"),
+		TraceLoggingInt32(static_cast<int>(rcArea.top), "Top"), TraceLoggingInt32(static_cast<int>(rcArea.bottom), "Bottom"));
 
 	//Platform::DebugPrintf("Paint:%1d (%.0f,%.0f) ... (%.0f,%.0f)\n",
 	//	paintingAllText, rcArea.left, rcArea.top, rcArea.right, rcArea.bottom);
@@ -2019,7 +2304,7 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 		if (vs.marginInside) {
 			PaintSelMargin(surfaceWindow, rcArea);
 			PRectangle rcRightMargin = rcClient;
-			rcRightMargin.left = rcRightMargin.right - vs.rightMarginWidth;
+			rcRightMargin.left = rcRightMargin.right - vs.RightSideWidth();
 			if (rcArea.Intersects(rcRightMargin)) {
 				surfaceWindow->FillRectangle(rcRightMargin, vs.styles[StyleDefault].back);
 			}
@@ -2050,7 +2335,13 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	}
 
 	view.PaintText(surfaceWindow, *this, vs, rcArea, rcClient);
+	if (vs.overviewRulerWidth > 0 && vs.marginInside) {
+		PaintOverviewRuler(surfaceWindow, rcArea);
+	}
 
+	if (!wideLineCandidates.empty() && trackLineWidth && !Wrapping()) {
+		MeasureWideLineCandidates(surfaceWindow);
+	}
 	if (horizontalScrollBarVisible && trackLineWidth && (view.lineWidthMaxSeen > scrollWidth)) {
 		scrollWidth = view.lineWidthMaxSeen;
 		if (!FineTickerRunning(TickReason::widen)) {
@@ -2061,9 +2352,21 @@ void Editor::Paint(Surface *surfaceWindow, PRectangle rcArea) {
 	if (!view.bufferedDraw)
 		surfaceWindow->PopClip();
 
+	view.paintCounters.frames++;
+	view.paintCounters.paintTime += epPaint.Duration();
+	EventTraceStop(activity, "Paint", TraceLoggingInt64(pdoc->GetEndStyled(), "EndStyled"));
 	NotifyPainted();
 }
 
+void Editor::PaintOverviewRuler(Surface *surfaceWindow, PRectangle rcArea) {
+	const PRectangle rcRuler = GetOverviewRulerRectangle();
+	if (rcArea.Intersects(rcRuler)) {
+		const Sci::Line linesOnScreen = LinesOnScreen();
+		overviewRuler.Fill(*pdoc, *pcs, static_cast<int>(rcRuler.Height()), linesOnScreen);
+		overviewRuler.Paint(surfaceWindow, rcRuler, vs, topLine, linesOnScreen);
+	}
+}
+
 // This is mostly copied from the Paint method but with some things omitted
 // such as the margin markers, line numbers, selection and caret
 // Should be merged back into a combined Draw method.
@@ -2127,7 +2430,7 @@ void Editor::ChangeSize() {
 	if (Wrapping()) {
 		PRectangle rcTextArea = GetClientRectangle();
 		rcTextArea.left = static_cast<XYPOSITION>(vs.textStart);
-		rcTextArea.right -= vs.rightMarginWidth;
+		rcTextArea.right -= vs.RightSideWidth();
 		if (wrapWidth != rcTextArea.Width()) {
 			NeedWrapping();
 			Redraw();
@@ -2193,6 +2496,10 @@ void Editor::InsertCharacter(std::string_view sv, CharacterSource charSource) {
 
 		// Vector elements point into selection in order to change selection.
 		const std::vector<SelectionRange *> selPtrs = sel.SortedRanges();
+		std::vector<Sci::Position> lengthAfter;
+		const bool deferred = CanDeferSelectionMove(selPtrs, lengthAfter);
+		const DeferSelectionMove dsm(deferSelectionMove, deferred);
+		const MultiEditGroup meg(pdoc, deferred);
 		// Loop in reverse to avoid disturbing positions of selections yet to be processed.
 		for (auto rit = selPtrs.rbegin(); rit != selPtrs.rend(); ++rit) {
 			SelectionRange *currentSel = *rit;
@@ -2250,6 +2557,12 @@ void Editor::InsertCharacter(std::string_view sv, CharacterSource charSource) {
 					}
 				}
 			}
+			if (deferred) {
+				lengthAfter[selPtrs.rend() - rit - 1] = pdoc->LengthNoExcept();
+			}
+		}
+		if (deferred) {
+			MoveDeferredSelection(selPtrs, lengthAfter);
 		}
 
 		ThinRectangularRange();
@@ -2302,7 +2615,10 @@ void Editor::InsertCharacter(std::string_view sv, CharacterSource charSource) {
 void Editor::ClearSelectionRange(SelectionRange &range) {
 	if (!range.Empty()) {
 		if (range.Length()) {
-			pdoc->DeleteChars(range.Start().Position(), range.Length());
+			const Sci::Position start = range.Start().Position();
+			if (pdoc->DeleteChars(start, range.Length()) && deferSelectionMove) {
+				range = SelectionRange(start);
+			}
 			range.ClearVirtualSpace();
 		} else {
 			// Range is all virtual so collapse to start of virtual space
@@ -2311,6 +2627,34 @@ void Editor::ClearSelectionRange(SelectionRange &range) {
 	}
 }
 
+// With many ranges, moving every range on each modification is quadratic. When ranges are
+// processed in reverse order, each edit only moves ranges already processed, all by the same
+// amount, so they are moved once at the end by the length change after they were processed.
+// Virtual space is excluded as realizing it depends on ranges on the same line being moved.
+bool Editor::CanDeferSelectionMove(const std::vector<SelectionRange *> &selPtrs, std::vector<Sci::Position> &lengthAfter) {
+	if (selPtrs.size() < DeferSelectionMoveMinRanges) {
+		return false;
+	}
+	for (const SelectionRange *range : selPtrs) {
+		if (range->caret.VirtualSpace() || range->anchor.VirtualSpace()) {
+			return false;
+		}
+	}
+	lengthAfter.assign(selPtrs.size(), pdoc->LengthNoExcept());
+	return true;
+}
+
+void Editor::MoveDeferredSelection(const std::vector<SelectionRange *> &selPtrs, const std::vector<Sci::Position> &lengthAfter) noexcept {
+	const Sci::Position length = pdoc->LengthNoExcept();
+	for (size_t index = 0; index < selPtrs.size(); index++) {
+		const Sci::Position delta = length - lengthAfter[index];
+		if (delta != 0) {
+			selPtrs[index]->caret.Add(delta);
+			selPtrs[index]->anchor.Add(delta);
+		}
+	}
+}
+
 void Editor::ClearBeforeTentativeStart() {
 	// Make positions for the first composition string.
 	FilterSelections();
@@ -2349,9 +2693,9 @@ void Editor::InsertPaste(std::string_view text) {
 	}
 }
 
-void Editor::InsertPasteShape(std::string_view text, PasteShape shape) {
+void Editor::InsertPasteShape(std::string_view text, PasteShape shape, bool lineEndsConverted) {
 	std::string convertedText;
-	if (convertPastes) {
+	if (convertPastes && !lineEndsConverted) {
 		// Convert line endings of the paste into our local line-endings mode
 		convertedText = Document::TransformLineEnds(text, pdoc->eolMode);
 		text = convertedText;
@@ -2380,17 +2724,38 @@ void Editor::ClearSelection(bool retainMultipleSelections) {
 	if (!sel.IsRectangular() && !retainMultipleSelections)
 		FilterSelections();
 	const UndoGroup ug(pdoc);
-	for (size_t r = 0; r < sel.Count(); r++) {
-		if (!sel.Range(r).Empty()) {
-			SelectionRange rangeNew = sel.Range(r);
-			if (sel.selType == Selection::SelTypes::lines && sel.Count() == 1) {
-				// remove EOLs
-				rangeNew = LineSelectionRange(rangeNew.caret, rangeNew.anchor, true);
+	std::vector<SelectionRange *> selPtrs;
+	std::vector<Sci::Position> lengthAfter;
+	if (sel.Count() >= DeferSelectionMoveMinRanges) {
+		selPtrs = sel.SortedRanges();
+	}
+	if (CanDeferSelectionMove(selPtrs, lengthAfter)) {
+		const DeferSelectionMove dsm(deferSelectionMove, true);
+		const MultiEditGroup meg(pdoc);
+		for (size_t index = selPtrs.size(); index != 0;) {
+			--index;
+			SelectionRange &range = *selPtrs[index];
+			if (!range.Empty() && !RangeContainsProtected(range)) {
+				const SelectionPosition start = range.Start();
+				pdoc->DeleteChars(start.Position(), range.Length());
+				range = SelectionRange(start);
 			}
-			if (!RangeContainsProtected(sel.Range(r))) {
-				pdoc->DeleteChars(rangeNew.Start().Position(),
-					rangeNew.Length());
-				sel.Range(r) = SelectionRange(rangeNew.Start());
+			lengthAfter[index] = pdoc->LengthNoExcept();
+		}
+		MoveDeferredSelection(selPtrs, lengthAfter);
+	} else {
+		for (size_t r = 0; r < sel.Count(); r++) {
+			if (!sel.Range(r).Empty()) {
+				SelectionRange rangeNew = sel.Range(r);
+				if (sel.selType == Selection::SelTypes::lines && sel.Count() == 1) {
+					// remove EOLs
+					rangeNew = LineSelectionRange(rangeNew.caret, rangeNew.anchor, true);
+				}
+				if (!RangeContainsProtected(sel.Range(r))) {
+					pdoc->DeleteChars(rangeNew.Start().Position(),
+						rangeNew.Length());
+					sel.Range(r) = SelectionRange(rangeNew.Start());
+				}
 			}
 		}
 	}
@@ -2659,28 +3024,51 @@ void Editor::DelCharBack(bool allowLineStartDeletion) {
 		allowLineStartDeletion = false;
 	const UndoGroup ug(pdoc, (sel.Count() > 1) || !sel.Empty());
 	if (sel.Empty()) {
-		for (size_t r = 0; r < sel.Count(); r++) {
-			const Sci::Position caretPosition = sel.Range(r).caret.Position();
+		// unindent may change text before other carets on the same line
+		std::vector<SelectionRange *> selPtrs;
+		std::vector<Sci::Position> lengthAfter;
+		if (sel.Count() >= DeferSelectionMoveMinRanges && pdoc->backspaceUnindents == 0) {
+			selPtrs = sel.SortedRanges();
+		}
+		const bool deferred = CanDeferSelectionMove(selPtrs, lengthAfter);
+		const DeferSelectionMove dsm(deferSelectionMove, deferred);
+		const MultiEditGroup meg(pdoc, deferred);
+		const size_t count = sel.Count();
+		for (size_t r = 0; r < count; r++) {
+			// deferred ranges are processed in reverse order
+			const size_t index = count - 1 - r;
+			SelectionRange &range = deferred ? *selPtrs[index] : sel.Range(r);
+			const Sci::Position caretPosition = range.caret.Position();
 			if (!RangeContainsProtected(caretPosition - 1, caretPosition)) {
-				if (sel.Range(r).caret.VirtualSpace()) {
-					sel.Range(r).caret.SetVirtualSpace(sel.Range(r).caret.VirtualSpace() - 1);
-					sel.Range(r).anchor.SetVirtualSpace(sel.Range(r).caret.VirtualSpace());
+				if (range.caret.VirtualSpace()) {
+					range.caret.SetVirtualSpace(range.caret.VirtualSpace() - 1);
+					range.anchor.SetVirtualSpace(range.caret.VirtualSpace());
 				} else {
 					const Sci::Line lineCurrentPos = pdoc->SciLineFromPosition(caretPosition);
 					if (allowLineStartDeletion || (pdoc->LineStart(lineCurrentPos) != caretPosition)) {
 						Sci::Position posSelect;
 						if (BackspaceUnindent(lineCurrentPos, caretPosition, &posSelect)) {
 							// SetEmptySelection
-							sel.Range(r) = SelectionRange(posSelect);
+							range = SelectionRange(posSelect);
 						} else {
+							const Sci::Position length = pdoc->LengthNoExcept();
 							pdoc->DelCharBack(caretPosition);
+							if (deferred) {
+								range = SelectionRange(caretPosition - (length - pdoc->LengthNoExcept()));
+							}
 						}
 					}
 				}
 			} else {
-				sel.Range(r).ClearVirtualSpace();
+				range.ClearVirtualSpace();
+			}
+			if (deferred) {
+				lengthAfter[index] = pdoc->LengthNoExcept();
 			}
 		}
+		if (deferred) {
+			MoveDeferredSelection(selPtrs, lengthAfter);
+		}
 		ThinRectangularRange();
 	} else {
 		ClearSelection();
@@ -2744,6 +3132,8 @@ void Editor::NotifySavePoint(bool isSavePoint) noexcept {
 	if (isSavePoint) {
 		scn.nmhdr.code = Notification::SavePointReached;
 		if (changeHistoryOption != ChangeHistoryOption::Disabled) {
+			// modified lines become saved lines
+			overviewRuler.Invalidate();
 			Redraw();
 		}
 	} else {
@@ -2974,9 +3364,13 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		if (paintState == PaintState::painting) {
 			CheckForChangeOutsidePaint(
 				Range(mh.position, pdoc->LineStart(mh.line + 1)));
-		} else {
-			// Could check that change is before last visible line.
-			Redraw();
+		} else if (!redrawPendingText) {
+			// Line state is not drawn, changed styles of following lines are notified separately.
+			// Only the line is redrawn, e.g. for FoldFlag::LineState in margin.
+			InvalidateRange(mh.position, pdoc->LineStart(mh.line + 1));
+			if (FlagSet(foldFlags, FoldFlag::LineState)) {
+				RedrawSelMargin(mh.line);
+			}
 		}
 	}
 	if (FlagSet(mh.modificationType, ModificationFlags::ChangeTabStops)) {
@@ -3009,7 +3403,9 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	} else {
 		if (FlagSet(undoSelectionHistoryOption, UndoSelectionHistoryOption::Enabled) &&
 			FlagSet(mh.modificationType, ModificationFlags::User)) {
-			if (FlagSet(mh.modificationType, ModificationFlags::BeforeInsert | ModificationFlags::BeforeDelete)) {
+			if (FlagSet(mh.modificationType, ModificationFlags::BeforeInsert | ModificationFlags::BeforeDelete)
+				&& !(deferSelectionMove && pdoc->AfterUndoSequenceStart())) {
+				// inside a group only selection before the first action is put onto stack
 				RememberSelectionForUndo(pdoc->UndoCurrent());
 			}
 			if (FlagSet(mh.modificationType, ModificationFlags::InsertText | ModificationFlags::DeleteText)) {
@@ -3018,11 +3414,19 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 		}
 		// Move selection and brace highlights
 		if (FlagSet(mh.modificationType, ModificationFlags::InsertText)) {
-			sel.MovePositions(true, mh.position, mh.length);
+			if (deferSelectionMove) {
+				sel.MoveRectangularPositions(true, mh.position, mh.length);
+			} else {
+				sel.MovePositions(true, mh.position, mh.length);
+			}
 			braces[0] = MovePositionForInsertion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForInsertion(braces[1], mh.position, mh.length);
 		} else if (FlagSet(mh.modificationType, ModificationFlags::DeleteText)) {
-			sel.MovePositions(false, mh.position, mh.length);
+			if (deferSelectionMove) {
+				sel.MoveRectangularPositions(false, mh.position, mh.length);
+			} else {
+				sel.MovePositions(false, mh.position, mh.length);
+			}
 			braces[0] = MovePositionForDeletion(braces[0], mh.position, mh.length);
 			braces[1] = MovePositionForDeletion(braces[1], mh.position, mh.length);
 		}
@@ -3042,12 +3446,29 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 				pcs->DeleteLines(lineOfPos, -mh.linesAdded);
 			}
 			view.LinesAddedOrRemoved(lineOfPos, mh.linesAdded);
+			// keep wide line candidates on their lines, removed lines are joined into lineOfPos
+			for (Sci::Line &line : wideLineCandidates) {
+				if (line >= lineOfPos) {
+					line = (line < lineOfPos - mh.linesAdded) ? lineOfPos : line + mh.linesAdded;
+				}
+			}
 		}
 		if (FlagSet(mh.modificationType, ModificationFlags::ChangeAnnotation)) {
 			const Sci::Line lineDoc = pdoc->SciLineFromPosition(mh.position);
 			if (vs.annotationVisible != AnnotationVisible::Hidden) {
-				if (pcs->SetHeight(lineDoc, pcs->GetHeight(lineDoc) + static_cast<int>(mh.annotationLinesAdded))) {
-					SetScrollBars();
+				if (mh.length == 0) {
+					if (pcs->SetHeight(lineDoc, pcs->GetHeight(lineDoc) + static_cast<int>(mh.annotationLinesAdded))) {
+						SetScrollBars();
+					}
+				} else {
+					// bulk change, heights of the lines are updated once
+					const Sci::Position end = mh.position + mh.length;
+					const Sci::Line lineEnd = (end < pdoc->LengthNoExcept()) ? pdoc->SciLineFromPosition(end) : pdoc->LinesTotal();
+					if (Wrapping()) {
+						NeedWrapping(lineDoc, lineEnd, false);
+					} else {
+						SetAnnotationHeights(lineDoc, lineEnd);
+					}
 				}
 				Redraw();
 			}
@@ -3074,6 +3495,9 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 			RefreshStyleData();
 			// Fix up annotation heights
 			SetAnnotationHeights(lineDoc, lineDoc + lines + 2);
+			if (trackLineWidth && !Wrapping()) {
+				FindWideLineCandidates(lineDoc, lineDoc + lines + 1);
+			}
 		}
 		if (mh.linesAdded != 0) {
 			// Avoid scrolling of display if change before current display
@@ -3121,6 +3545,9 @@ void Editor::NotifyModified(Document *, DocModification mh, void *) {
 	if ((FlagSet(mh.modificationType, ModificationFlags::ChangeFold)) && (FlagSet(foldAutomatic, AutomaticFold::Change))) {
 		FoldChanged(mh.line, mh.foldLevelNow, mh.foldLevelPrev);
 	}
+	if (vs.overviewRulerWidth > 0 && overviewRuler.NotifyModified(*pdoc, mh)) {
+		RedrawOverviewRuler();
+	}
 
 	// NOW pay the piper WRT "deferred" visual updates
 	if (IsLastStep(mh)) {
@@ -4509,6 +4936,28 @@ Sci::Position Editor::FindTextFull(
 #endif
 }
 
+/**
+ * Find all matches in the range of @c TextToFindFull, matches are kept until next call.
+ * @return number of matches, or -1 when matches should be found one by one with FindTextFull.
+ */
+Sci::Position Editor::FindAll(uptr_t wParam, sptr_t lParam) {
+	const TextToFindFull *ft = AsPointer<const TextToFindFull *>(lParam);
+	if (ft == nullptr) {
+		findAllRanges.clear();
+		findAllRanges.shrink_to_fit();
+		return 0;
+	}
+	if (!pdoc->HasCaseFolder())
+		pdoc->SetCaseFolder(CaseFolderForEncoding());
+	try {
+		return pdoc->FindAll(ft->chrg.cpMin, ft->chrg.cpMax, ft->lpstrText,
+			static_cast<FindOption>(wParam), strlen(ft->lpstrText), findAllRanges);
+	} catch (const std::bad_alloc &) {
+		findAllRanges.clear();
+		return -1;
+	}
+}
+
 /**
  * Relocatable search support : Searches relative to current selection
  * point and sets the selection to the found text range with
@@ -4585,6 +5034,85 @@ Sci::Position Editor::SearchInTarget(const char *text, Sci::Position length) {
 	}
 }
 
+/**
+ * Replace all matches of find inside the target with a single deletion and insertion,
+ * replace is processed as ReplaceTargetRE when search flags contain RegExp.
+ * Returns count of replacements, target is set to the changed range.
+ */
+Sci::Position Editor::ReplaceAllInTarget(const char *find, const char *replace) {
+	const Sci::Position lengthFind = strlen(find);
+	const Sci::Position startTarget = targetRange.start.Position();
+	const Sci::Position endTarget = targetRange.end.Position();
+	if (lengthFind == 0 || startTarget >= endTarget) {
+		return 0;
+	}
+
+	if (!pdoc->HasCaseFolder())
+		pdoc->SetCaseFolder(CaseFolderForEncoding());
+	const bool regex = FlagSet(searchFlags, FindOption::RegExp);
+	const std::string_view replacement(replace);
+	std::string text;
+	Sci::Position startChange = -1;
+	Sci::Position endChange = 0;
+	Sci::Position count = 0;
+	const auto append = [&](Sci::Position position, Sci::Position length, std::string_view substituted) {
+		if (startChange < 0) {
+			startChange = position;
+			endChange = position;
+		}
+		const size_t size = text.length();
+		text.resize(size + position - endChange);
+		pdoc->GetCharRange(text.data() + size, endChange, position - endChange);
+		text.append(substituted);
+		endChange = position + length;
+		++count;
+	};
+
+	try {
+		std::vector<Sci::Position> ranges;
+		if (!regex && pdoc->FindAll(startTarget, endTarget, find, searchFlags, lengthFind, ranges) >= 0) {
+			for (size_t i = 0; i < ranges.size(); i += 2) {
+				append(ranges[i], ranges[i + 1], replacement);
+			}
+		} else {
+			// search the original text, so later matches are not affected by replacements
+			Sci::Position pos = startTarget;
+			while (pos < endTarget) {
+				Sci::Position lengthFound = lengthFind;
+				const Sci::Position found = pdoc->FindText(pos, endTarget, find, searchFlags, &lengthFound);
+				if (found < 0) {
+					break;
+				}
+				std::string_view substituted = replacement;
+				if (regex) {
+					Sci::Position length = replacement.length();
+					const char *p = pdoc->SubstituteByPosition(replace, &length);
+					if (!p) {
+						break;
+					}
+					substituted = std::string_view(p, length);
+				}
+				append(found, lengthFound, substituted);
+				pos = (lengthFound == 0) ? pdoc->NextPosition(found, 1) : found + lengthFound;
+			}
+		}
+	} catch (const RegexError &) {
+		errorStatus = Status::RegEx;
+		return -1;
+	}
+
+	if (count != 0) {
+		const UndoGroup ug(pdoc);
+		if (endChange > startChange) {
+			pdoc->DeleteChars(startChange, endChange - startChange);
+		}
+		const Sci::Position lengthInserted = pdoc->InsertString(startChange, text);
+		targetRange.start.SetPosition(startChange);
+		targetRange.end.SetPosition(startChange + lengthInserted);
+	}
+	return count;
+}
+
 void Editor::GoToLine(Sci::Line lineNo) {
 	lineNo = std::clamp<Sci::Line>(lineNo, 0, pdoc->LinesTotal());
 	SetEmptySelection(pdoc->LineStart(lineNo));
@@ -4712,7 +5240,7 @@ bool Editor::DragThreshold(Point ptStart, Point ptNow) const noexcept {
 	return distanceSquared > 16.0f;
 }
 
-void Editor::DropAt(SelectionPosition position, std::string_view value, bool moving, bool rectangular) {
+void Editor::DropAt(SelectionPosition position, std::string_view value, bool moving, bool rectangular, bool lineEndsConverted) {
 	//Platform::DebugPrintf("DropAt %d %d\n", inDragDrop, position);
 	if (inDragDrop == DragDrop::dragging)
 		dropWentOutside = false;
@@ -4752,17 +5280,21 @@ void Editor::DropAt(SelectionPosition position, std::string_view value, bool mov
 		}
 		position = positionAfterDeletion;
 
-		const std::string convertedText = Document::TransformLineEnds(value, pdoc->eolMode);
+		std::string convertedText;
+		if (!lineEndsConverted) {
+			convertedText = Document::TransformLineEnds(value, pdoc->eolMode);
+			value = convertedText;
+		}
 
 		if (rectangular) {
-			PasteRectangular(position, convertedText);
+			PasteRectangular(position, value);
 			// Should try to select new rectangle but it may not be a rectangle now so just select the drop position
 			SetEmptySelection(position);
 		} else {
 			position = MovePositionOutsideChar(position, sel.MainCaret() - position.Position());
 			position = RealizeVirtualSpace(position);
 			const Sci::Position lengthInserted = pdoc->InsertString(
-				position.Position(), convertedText);
+				position.Position(), value);
 			if (lengthInserted > 0) {
 				SelectionPosition posAfterInsertion = position;
 				posAfterInsertion.Add(lengthInserted);
@@ -4779,8 +5311,9 @@ void Editor::DropAt(SelectionPosition position, std::string_view value, bool mov
  */
 bool Editor::PositionInSelection(Sci::Position pos) const noexcept {
 	pos = MovePositionOutsideChar(pos, sel.MainCaret() - pos);
-	for (size_t r = 0; r < sel.Count(); r++) {
-		if (sel.Range(r).Contains(pos))
+	const auto [first, last] = sel.RangesTouching(pos, pos);
+	for (size_t i = first; i < last; i++) {
+		if (sel.Range(sel.RangeIndexed(i)).Contains(pos))
 			return true;
 	}
 	return false;
@@ -4789,8 +5322,10 @@ bool Editor::PositionInSelection(Sci::Position pos) const noexcept {
 bool Editor::PointInSelection(Point pt) {
 	const SelectionPosition pos = SPositionFromLocation(pt, false, true);
 	const Point ptPos = LocationFromPosition(pos);
-	for (size_t r = 0; r < sel.Count(); r++) {
-		const SelectionRange &range = sel.Range(r);
+	const Selection &selection = sel;
+	const auto [first, last] = selection.RangesTouching(pos.Position(), pos.Position());
+	for (size_t i = first; i < last; i++) {
+		const SelectionRange &range = selection.Range(selection.RangeIndexed(i));
 		if (range.Contains(pos)) {
 			bool hit = true;
 			if (pos == range.Start()) {
@@ -4834,6 +5369,10 @@ ptrdiff_t Editor::SelectionFromPoint(Point pt) {
 	return -1;
 }
 
+bool Editor::PointInOverviewRuler(Point pt) const noexcept {
+	return vs.overviewRulerWidth > 0 && vs.marginInside && GetOverviewRulerRectangle().ContainsWholePixel(pt);
+}
+
 bool Editor::PointInSelMargin(Point pt) const noexcept {
 	// Really means: "Point in a margin"
 	if (vs.fixedColumnWidth > 0) {	// There is a margin
@@ -4951,6 +5490,12 @@ void Editor::ButtonDownWithModifiers(Point pt, unsigned int curTime, KeyMod modi
 	SetHoverIndicatorPoint(pt);
 	//Platform::DebugPrintf("ButtonDown %d %d = %d modifiers=%d %d\n", curTime, lastClickTime, curTime - lastClickTime, modifiers, inDragDrop);
 	ptMouseLast = pt;
+	if (PointInOverviewRuler(pt)) {
+		// center lines of the clicked bucket
+		const PRectangle rcRuler = GetOverviewRulerRectangle();
+		ScrollTo(overviewRuler.DisplayFromY(static_cast<int>(pt.y - rcRuler.top)) - LinesOnScreen() / 2);
+		return;
+	}
 	const bool ctrl = FlagSet(modifiers, KeyMod::Ctrl);
 	const bool shift = FlagSet(modifiers, KeyMod::Shift);
 	const bool alt = FlagSet(modifiers, KeyMod::Alt);
@@ -5305,6 +5850,12 @@ void Editor::ButtonMoveWithModifiers(Point pt, unsigned int, KeyMod modifiers) {
 		}
 
 	} else {
+		if (PointInOverviewRuler(pt)) {
+			DisplayCursor(Window::Cursor::arrow);
+			SetHotSpotRange(nullptr);
+			SetHoverIndicatorPosition(Sci::invalidPosition);
+			return;
+		}
 		if (vs.fixedColumnWidth > 0) {	// There is a margin
 			if (PointInSelMargin(pt)) {
 				DisplayCursor(GetMarginCursor(pt));
@@ -5582,6 +6133,13 @@ void Editor::IdleStyle() {
 	const Sci::Position posAfterArea = PositionAfterArea(GetClientRectangle());
 	const Sci::Position endGoal = (idleStyling >= IdleStyling::AfterVisible) ?
 		pdoc->LengthNoExcept() : posAfterArea;
+	// style text after visible area on worker thread
+	if (backgroundStyling && pdoc->GetEndStyled() >= posAfterArea && pdoc->StyleBackground(endGoal)) {
+		if (pdoc->GetEndStyled() >= endGoal) {
+			needIdleStyling = false;
+		}
+		return;
+	}
 	const Sci::Position posAfterMax = PositionAfterMaxStyling(endGoal, false);
 	pdoc->StyleToAdjustingLineDuration(posAfterMax);
 	if (pdoc->GetEndStyled() >= endGoal) {
@@ -5689,6 +6247,48 @@ void Editor::SetAnnotationHeights(Sci::Line start, Sci::Line end) {
 	}
 }
 
+size_t Editor::MemoryUsage(MemoryCategory category) {
+	switch (category) {
+	case MemoryCategory::Total: {
+		size_t usage = 0;
+		for (int cat = static_cast<int>(MemoryCategory::Text); cat <= static_cast<int>(MemoryCategory::SearchIndex); cat++) {
+			usage += MemoryUsage(static_cast<MemoryCategory>(cat));
+		}
+		return usage;
+	}
+	case MemoryCategory::LineLayoutCache:
+		return view.llc.MemoryUsage();
+	case MemoryCategory::PositionCache:
+		return view.posCache.MemoryUsage();
+	default:
+		return pdoc->MemoryUsage(category);
+	}
+}
+
+void Editor::GetPaintStatistics(bool reset, PaintStatistics *statistics) noexcept {
+	if (statistics) {
+		uint32_t hits;
+		uint32_t misses;
+		view.posCache.Statistics(hits, misses, reset);
+		const EditView::PaintCounters &counters = view.paintCounters;
+		statistics->frames = counters.frames;
+		statistics->paintTime = static_cast<int>(counters.paintTime * 1e6);
+		statistics->layoutTime = static_cast<int>(counters.layoutTime * 1e6);
+		statistics->linesLaidOut = counters.linesLaidOut;
+		statistics->positionCacheHits = hits;
+		statistics->positionCacheMisses = misses;
+		statistics->styleBytesPerMillisecond = pdoc->durationStyleOneUnit.BytesPerMillisecond();
+		statistics->wrapBytesPerMillisecond = durationWrapOneUnit.BytesPerMillisecond();
+		statistics->idlePending = idler.state || needIdleStyling || wrapPending.NeedsWrap();
+		view.llc.Statistics(hits, misses, reset);
+		statistics->lineLayoutHits = hits;
+		statistics->lineLayoutMisses = misses;
+	}
+	if (reset) {
+		view.paintCounters = {};
+	}
+}
+
 void Editor::SetDocPointer(Document *document) {
 	//Platform::DebugPrintf("** %p setdoc to %p\n", pdoc, document);
 	pdoc->RemoveWatcher(this, nullptr);
@@ -5701,6 +6301,7 @@ void Editor::SetDocPointer(Document *document) {
 	pdoc->AddRef();
 	modelState.reset();
 	pcs = ContractionStateCreate(pdoc->IsLarge());
+	overviewRuler.Invalidate();
 
 	// Ensure all positions within document
 	sel.Clear();
@@ -5721,6 +6322,10 @@ void Editor::SetDocPointer(Document *document) {
 	SetAnnotationHeights(0, pdoc->LinesTotal());
 	view.llc.Deallocate();
 	NeedWrapping();
+	wideLineCandidates.clear();
+	if (trackLineWidth && !Wrapping()) {
+		FindWideLineCandidates(0, pdoc->LinesTotal());
+	}
 
 	hotspot = Range(Sci::invalidPosition);
 	hoverIndicatorPos = Sci::invalidPosition;
@@ -5732,6 +6337,35 @@ void Editor::SetDocPointer(Document *document) {
 	Redraw();
 }
 
+// recreate contraction state for large document, keeping folded and hidden lines
+void Editor::ConvertContractionState() {
+	const Sci::Line lines = pdoc->LinesTotal();
+	std::unique_ptr<IContractionState> pcsLarge = ContractionStateCreate(true);
+	pcsLarge->InsertLines(0, lines - 1);
+	for (Sci::Line line = pcs->ContractedNext(0); line >= 0 && line < lines; line = pcs->ContractedNext(line + 1)) {
+		pcsLarge->SetExpanded(line, false);
+	}
+	if (pcs->HiddenLines()) {
+		Sci::Line line = 0;
+		while (line < lines) {
+			if (pcs->GetVisible(line)) {
+				line++;
+			} else {
+				const Sci::Line lineStart = line;
+				while (line < lines && !pcs->GetVisible(line)) {
+					line++;
+				}
+				pcsLarge->SetVisible(lineStart, line - 1, false);
+			}
+		}
+	}
+	pcs = std::move(pcsLarge);
+	SetAnnotationHeights(0, lines);
+	NeedWrapping();
+	SetScrollBars();
+	Redraw();
+}
+
 void Editor::SetAnnotationVisible(AnnotationVisible visible) {
 	if (vs.annotationVisible != visible) {
 		const bool changedFromOrToHidden = ((vs.annotationVisible != AnnotationVisible::Hidden) != (visible != AnnotationVisible::Hidden));
@@ -5786,6 +6420,19 @@ Sci::Line Editor::ExpandLine(Sci::Line line, FoldLevel level, Sci::Line *parentL
 	return lineMaxSubord;
 }
 
+// Same as EnsureLineVisible() without updating display, used inside ContractionState batch.
+void Editor::ExpandParents(Sci::Line lineDoc) {
+	const Sci::Line lineParent = pdoc->GetFoldParent(lineDoc);
+	if (lineParent >= 0) {
+		if (!pcs->GetVisible(lineParent)) {
+			ExpandParents(lineParent);
+		}
+		if (pcs->SetExpanded(lineParent, true)) {
+			ExpandLine(lineParent);
+		}
+	}
+}
+
 void Editor::SetFoldExpanded(Sci::Line lineDoc, bool expanded) {
 	if (pcs->SetExpanded(lineDoc, expanded)) {
 		RedrawSelMargin();
@@ -5883,7 +6530,7 @@ Sci::Line Editor::ContractedFoldNext(Sci::Line lineStart) const noexcept {
 void Editor::EnsureLineVisible(Sci::Line lineDoc, bool enforcePolicy) {
 	// In case in need of wrapping to ensure DisplayFromDoc works.
 	if (lineDoc >= wrapPending.start) {
-		if (WrapLines(WrapScope::wsAll)) {
+		if (WrapLines(WrapScope::wsTarget, lineDoc)) {
 			Redraw();
 		}
 	}
@@ -5942,6 +6589,7 @@ void Editor::FoldAll(FoldAction action) {
 		pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
 	}
 
+	pcs->BeginBatch();
 	Sci::Line line = 0;
 	if (action == FoldAction::Toggle) {
 		// Discover current state
@@ -5984,11 +6632,111 @@ void Editor::FoldAll(FoldAction action) {
 			}
 		}
 	}
+	pcs->EndBatch();
+
+	SetScrollBars();
+	Redraw();
+}
+
+void Editor::FoldAllLevel(int levelNumber, FoldAction action) {
+	pdoc->EnsureStyledTo(pdoc->LengthNoExcept());
+	const Sci::Line maxLine = pdoc->LinesTotal();
+	const bool nested = FlagSet(action, FoldAction::NestedLevel);
+	action = static_cast<FoldAction>(static_cast<int>(action) & ~static_cast<int>(FoldAction::NestedLevel));
+	bool sniff = action == FoldAction::Toggle;
+	bool expanding = action == FoldAction::Expand;
+	const FoldLevel levelMatch = static_cast<FoldLevel>(levelNumber + static_cast<int>(FoldLevel::Base));
+
+	// level numbers of enclosing headers, only used for nesting depth
+	std::vector<FoldLevel> headers;
+	pcs->BeginBatch();
+	for (Sci::Line line = 0; line < maxLine; line++) {
+		const FoldLevel level = pdoc->GetFoldLevel(line);
+		if (!LevelIsHeader(level)) {
+			continue;
+		}
+		const FoldLevel levelNum = LevelNumberPart(level);
+		bool matched;
+		if (nested) {
+			while (!headers.empty() && levelNum <= headers.back()) {
+				headers.pop_back();
+			}
+			matched = headers.size() == static_cast<size_t>(levelNumber);
+			headers.push_back(levelNum);
+		} else {
+			matched = levelNum == levelMatch;
+		}
+		if (!matched) {
+			continue;
+		}
+
+		const Sci::Line lineMaxSubord = pdoc->GetLastChild(line, level);
+		if (lineMaxSubord > line) {
+			// header without children doesn't decide toggle direction
+			if (sniff) {
+				sniff = false;
+				expanding = !pcs->GetExpanded(line);
+			}
+			if (expanding) {
+				if (!pcs->GetVisible(line)) {
+					ExpandParents(line);
+				}
+				if (pcs->SetExpanded(line, true)) {
+					ExpandLine(line, level);
+				}
+			} else if (pcs->SetExpanded(line, false) && pcs->GetVisible(line)) {
+				pcs->SetVisible(line + 1, lineMaxSubord, false);
+			}
+		}
+		line = lineMaxSubord;
+	}
+	pcs->EndBatch();
 
+	const Sci::Line lineCurrent = pdoc->SciLineFromPosition(sel.MainCaret());
+	if (!pcs->GetVisible(lineCurrent)) {
+		EnsureCaretVisible();
+	}
 	SetScrollBars();
 	Redraw();
 }
 
+/**
+ * Hide lines from @a lineStart to the end of the document, except lines of matches
+ * from last FindAll and @a contextLines lines around them, visible lines before
+ * @a lineStart are kept so matches appended to the document can be filtered again.
+ * @return number of lines shown from matches.
+ */
+Sci::Line Editor::HideLinesExceptFindAll(Sci::Line lineStart, Sci::Line contextLines) {
+	const Sci::Line maxLine = pdoc->LinesTotal();
+	lineStart = std::clamp<Sci::Line>(lineStart, 0, maxLine - 1);
+	contextLines = std::max<Sci::Line>(contextLines, 0);
+
+	Sci::Line shownLines = 0;
+	Sci::Line lineShown = -1;
+	pcs->BeginBatch();
+	if (lineStart == 0) {
+		pcs->ExpandAll();
+	}
+	pcs->SetVisible(lineStart, maxLine - 1, false);
+	// matches are sorted by position
+	for (size_t i = 0; i < findAllRanges.size(); i += 2) {
+		const Sci::Position position = findAllRanges[i];
+		Sci::Line lineFirst = pdoc->SciLineFromPosition(position) - contextLines;
+		const Sci::Line lineLast = std::min(pdoc->SciLineFromPosition(position + findAllRanges[i + 1]) + contextLines, maxLine - 1);
+		lineFirst = std::max({lineFirst, lineShown + 1, static_cast<Sci::Line>(0)});
+		if (lineFirst <= lineLast) {
+			pcs->SetVisible(lineFirst, lineLast, true);
+			shownLines += lineLast - lineFirst + 1;
+			lineShown = lineLast;
+		}
+	}
+	pcs->EndBatch();
+
+	SetScrollBars();
+	Redraw();
+	return shownLines;
+}
+
 void Editor::FoldChanged(Sci::Line line, FoldLevel levelNow, FoldLevel levelPrev) {
 	if (LevelIsHeader(levelNow)) {
 		if (!LevelIsHeader(levelPrev)) {
@@ -6278,7 +7026,65 @@ void Editor::StyleSetMessage(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	default:
 		break;
 	}
-	InvalidateStyleRedraw();
+	InvalidateStyleColours();
+}
+
+sptr_t Editor::SendCommands(const CommandRecord *commands, size_t count) {
+	const UndoGroup ug(pdoc);
+	const BatchUpdateGroup group(this);
+	sptr_t result = 0;
+	const CommandRecord * const end = commands + count;
+	for (; commands < end; commands++) {
+		result = WndProc(commands->message, commands->wParam, commands->lParam);
+	}
+	return result;
+}
+
+void Editor::StyleSetBulk(const StyleRecord *records, size_t count) {
+	const StyleRecord * const end = records + count;
+	for (; records < end; records++) {
+		const int mask = records->mask;
+		const int attributes = records->attributes;
+		const size_t index = records->style;
+		vs.EnsureStyle(index);
+		Style &style = vs.styles[index];
+		if (mask & static_cast<int>(StyleRecordMask::Fore)) {
+			style.fore = ColourRGBA::FromIpRGB(records->fore);
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Back)) {
+			style.back = ColourRGBA::FromIpRGB(records->back);
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Size)) {
+			style.size = records->sizeFractional;
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Weight)) {
+			style.weight = static_cast<FontWeight>(records->weight);
+		}
+		if (mask & static_cast<int>(StyleRecordMask::CharacterSet)) {
+			style.characterSet = static_cast<CharacterSet>(records->characterSet);
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Italic)) {
+			style.italic = (attributes & static_cast<int>(StyleRecordMask::Italic)) != 0;
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Underline)) {
+			style.underline = (attributes & static_cast<int>(StyleRecordMask::Underline)) != 0;
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Strike)) {
+			style.strike = (attributes & static_cast<int>(StyleRecordMask::Strike)) != 0;
+		}
+		if (mask & static_cast<int>(StyleRecordMask::Overline)) {
+			style.overline = (attributes & static_cast<int>(StyleRecordMask::Overline)) != 0;
+		}
+		if (mask & static_cast<int>(StyleRecordMask::EolFilled)) {
+			style.eolFilled = (attributes & static_cast<int>(StyleRecordMask::EolFilled)) != 0;
+		}
+		if ((mask & static_cast<int>(StyleRecordMask::Font)) && records->fontName) {
+			vs.SetStyleFontName(static_cast<int>(index), records->fontName);
+		}
+	}
+	// fonts are realized once on next refresh
+	vs.fontsValid = false;
+	InvalidateStyleColours();
 }
 
 sptr_t Editor::StyleGetMessage(Message iMessage, uptr_t wParam, sptr_t lParam) {
@@ -6704,6 +7510,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		PLATFORM_ASSERT(lParam);
 		return SearchInTarget(ConstCharPtrFromSPtr(lParam), PositionFromUPtr(wParam));
 
+	case Message::ReplaceAllInTarget:
+		PLATFORM_ASSERT(wParam && lParam);
+		return ReplaceAllInTarget(ConstCharPtrFromUPtr(wParam), ConstCharPtrFromSPtr(lParam));
+
 	case Message::SetSearchFlags:
 		searchFlags = static_cast<FindOption>(wParam);
 		break;
@@ -6792,6 +7602,19 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::FindTextFull:
 		return FindTextFull(wParam, lParam);
 
+	case Message::FindAll:
+		return FindAll(wParam, lParam);
+
+	case Message::GetFindAllRanges:
+		return AsInteger<sptr_t>(findAllRanges.data());
+
+	case Message::SetSearchIndexThreshold:
+		pdoc->SetSearchIndexThreshold(PositionFromUPtr(wParam));
+		break;
+
+	case Message::GetSearchIndexThreshold:
+		return pdoc->SearchIndexThreshold();
+
 	case Message::GetTextRangeFull:
 		if (const TextRangeFull *tr = AsPointer<const TextRangeFull *>(lParam)) {
 			return GetTextRange(tr->lpstrText, tr->chrg.cpMin, tr->chrg.cpMax);
@@ -6827,6 +7650,24 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		InvalidateStyleRedraw();
 		break;
 
+	case Message::GetOverviewRulerWidth:
+		return vs.overviewRulerWidth;
+
+	case Message::SetOverviewRulerWidth:
+		vs.overviewRulerWidth = std::max(static_cast<int>(wParam), 0);
+		overviewRuler.Invalidate();
+		InvalidateStyleRedraw();
+		break;
+
+	case Message::GetOverviewRulerMarkers:
+		return overviewRuler.markerMask;
+
+	case Message::SetOverviewRulerMarkers:
+		overviewRuler.markerMask = static_cast<MarkerMask>(wParam);
+		overviewRuler.Invalidate();
+		RedrawOverviewRuler();
+		break;
+
 		// Control specific messages
 
 	case Message::AddText: {
@@ -6906,6 +7747,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		}
 		return 0;
 
+	case Message::SendCommands:
+		if (wParam != 0 && lParam != 0) {
+			return SendCommands(AsPointer<const CommandRecord *>(lParam), wParam);
+		}
+		return 0;
+
 	case Message::GetUndoSequence:
 		return pdoc->UndoSequenceDepth();
 
@@ -6959,6 +7806,19 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->ChangeLastUndoActionText(wParam, CharPtrFromSPtr(lParam));
 		break;
 
+	case Message::SetUndoMemoryLimit:
+		pdoc->SetUndoMemoryLimit(wParam);
+		break;
+
+	case Message::GetUndoMemoryLimit:
+		return pdoc->UndoMemoryLimit();
+
+	case Message::GetUndoMemory:
+		return pdoc->UndoMemory();
+
+	case Message::GetMemoryUsage:
+		return MemoryUsage(static_cast<MemoryCategory>(wParam));
+
 	case Message::GetCaretPeriod:
 		return caret.period;
 
@@ -7255,13 +8115,16 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			InvalidateStyleRedraw();
 		break;
 
-	case Message::SetFontQuality:
-		vs.extraFontFlag = static_cast<FontQuality>(
+	case Message::SetFontQuality: {
+		const FontQuality extraFontFlag = static_cast<FontQuality>(
 			(static_cast<int>(vs.extraFontFlag) & ~static_cast<int>(FontQuality::QualityMask)) |
 			(wParam & static_cast<int>(FontQuality::QualityMask)));
-		vs.fontsValid = false;
-		InvalidateStyleRedraw();
-		break;
+		if (vs.extraFontFlag != extraFontFlag) {
+			vs.extraFontFlag = extraFontFlag;
+			vs.fontsValid = false;
+			InvalidateStyleRedraw();
+		}
+	} break;
 
 	case Message::GetFontQuality:
 		return static_cast<int>(vs.extraFontFlag) & static_cast<int>(FontQuality::QualityMask);
@@ -7371,6 +8234,13 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetIdleStyling:
 		return static_cast<sptr_t>(idleStyling);
 
+	case Message::SetBackgroundStyling:
+		backgroundStyling = wParam != 0;
+		break;
+
+	case Message::GetBackgroundStyling:
+		return backgroundStyling;
+
 	case Message::SetWrapMode:
 		if (vs.SetWrapState(static_cast<Wrap>(wParam))) {
 			xOffset = 0;
@@ -7431,6 +8301,24 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetLayoutCache:
 		return static_cast<sptr_t>(view.llc.GetLevel());
 
+	case Message::SetLayoutCacheLimit:
+		view.llc.SetMemoryLimit(wParam);
+		break;
+
+	case Message::GetLayoutCacheLimit:
+		return view.llc.GetMemoryLimit();
+
+	case Message::SetLayoutThreads:
+		SetLayoutThreads(static_cast<uint32_t>(wParam));
+		break;
+
+	case Message::GetLayoutThreads:
+		return hardwareConcurrency;
+
+	case Message::GetPaintStatistics:
+		GetPaintStatistics(wParam != 0, AsPointer<PaintStatistics *>(lParam));
+		break;
+
 	case Message::SetPositionCache:
 		view.posCache.SetSize(wParam);
 		break;
@@ -7438,6 +8326,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetPositionCache:
 		return view.posCache.GetSize();
 
+	case Message::ReleaseResources:
+		ReleaseResources();
+		break;
+
 	case Message::SetScrollWidth:
 		PLATFORM_ASSERT(wParam > 0);
 		if ((wParam > 0) && (wParam != static_cast<unsigned int>(scrollWidth))) {
@@ -7465,6 +8357,9 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		LinesSplit(static_cast<int>(wParam));
 		break;
 
+	case Message::LinesPad:
+		return LinesPad(static_cast<LinesPadFlag>(wParam));
+
 	case Message::TextWidth:
 		PLATFORM_ASSERT(wParam < vs.styles.size());
 		PLATFORM_ASSERT(lParam);
@@ -7619,25 +8514,33 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::MarkerSetForeTranslucent:
 		if (wParam <= MarkerMax)
 			vs.markers[wParam].fore = ColourRGBA(static_cast<unsigned int>(lParam));
-		InvalidateStyleData();
+		if (styleUpdateLevel == 0) {
+			InvalidateStyleData();
+		}
 		RedrawSelMargin();
 		break;
 	case Message::MarkerSetBackTranslucent:
 		if (wParam <= MarkerMax)
 			vs.markers[wParam].back = ColourRGBA(static_cast<unsigned int>(lParam));
-		InvalidateStyleData();
+		if (styleUpdateLevel == 0) {
+			InvalidateStyleData();
+		}
 		RedrawSelMargin();
 		break;
 	case Message::MarkerSetBackSelectedTranslucent:
 		if (wParam <= MarkerMax)
 			vs.markers[wParam].backSelected = ColourRGBA(static_cast<unsigned int>(lParam));
-		InvalidateStyleData();
+		if (styleUpdateLevel == 0) {
+			InvalidateStyleData();
+		}
 		RedrawSelMargin();
 		break;
 	case Message::MarkerSetStrokeWidth:
 		if (wParam <= MarkerMax)
 			vs.markers[wParam].strokeWidth = static_cast<XYPOSITION>(lParam) / 100.0f;
-		InvalidateStyleData();
+		if (styleUpdateLevel == 0) {
+			InvalidateStyleData();
+		}
 		RedrawSelMargin();
 		break;
 	case Message::MarkerEnableHighlight:
@@ -7663,6 +8566,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			pdoc->AddMarkSet(LineFromUPtr(wParam), static_cast<MarkerMask>(lParam));
 		break;
 
+	case Message::MarkerAddLines:
+		if (wParam <= MarkerMax && lParam != 0) {
+			return pdoc->AddMarkLines(AsPointer<const Sci::Line *>(lParam), static_cast<int>(wParam));
+		}
+		return 0;
+
 	case Message::MarkerDelete:
 		pdoc->DeleteMark(LineFromUPtr(wParam), static_cast<int>(lParam));
 		break;
@@ -7678,6 +8587,9 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		return pdoc->MarkerNext(LineFromUPtr(wParam), static_cast<MarkerMask>(lParam));
 
 	case Message::MarkerPrevious: {
+			if (!((lParam & MaskHistory) && FlagSet(changeHistoryOption, ChangeHistoryOption::Markers))) {
+				return pdoc->MarkerPrevious(LineFromUPtr(wParam), static_cast<MarkerMask>(lParam));
+			}
 			for (Sci::Line iLine = LineFromUPtr(wParam); iLine >= 0; iLine--) {
 				if ((GetMark(iLine) & lParam) != 0)
 					return iLine;
@@ -7805,12 +8717,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::StyleClearAll:
 		vs.ClearStyles();
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::CopyStyles:
 		vs.CopyStyles(wParam, lParam);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::StyleSetFore:
@@ -7836,6 +8748,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		StyleSetMessage(iMessage, wParam, lParam);
 		break;
 
+	case Message::StyleSetBulk:
+		StyleSetBulk(AsPointer<const StyleRecord *>(lParam), wParam);
+		break;
+
 	case Message::StyleGetFore:
 	case Message::StyleGetBack:
 	case Message::StyleGetBold:
@@ -7859,12 +8775,20 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::StyleResetDefault:
 		vs.ResetDefaultStyle();
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
+		break;
+
+	case Message::BeginStyleUpdate:
+		BeginStyleUpdate();
+		break;
+
+	case Message::EndStyleUpdate:
+		EndStyleUpdate();
 		break;
 
 	case Message::SetElementColour:
 		if (vs.SetElementColour(static_cast<Element>(wParam), ColourRGBA(static_cast<unsigned int>(lParam)))) {
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -7873,7 +8797,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::ResetElementColour:
 		if (vs.ResetElement(static_cast<Element>(wParam))) {
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -7919,7 +8843,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		return vs.caretLine.frame;
 	case Message::SetCaretLineFrame:
 		vs.caretLine.frame = static_cast<int>(wParam);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::GetCaretLineLayer:
@@ -7972,6 +8896,9 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		Redraw();
 		break;
 
+	case Message::HideLinesExceptFindAll:
+		return HideLinesExceptFindAll(LineFromUPtr(wParam), lParam);
+
 	case Message::GetLineVisible:
 		return pcs->GetVisible(LineFromUPtr(wParam));
 
@@ -8036,6 +8963,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		FoldAll(static_cast<FoldAction>(wParam));
 		break;
 
+	case Message::FoldAllLevel:
+		FoldAllLevel(static_cast<int>(wParam), static_cast<FoldAction>(lParam));
+		break;
+
 	case Message::ExpandChildren:
 		FoldExpand(LineFromUPtr(wParam), FoldAction::Expand, static_cast<FoldLevel>(lParam));
 		break;
@@ -8083,12 +9014,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::SetSelEOLFilled:
 		vs.selection.eolFilled = wParam != 0;
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::SetEOLSelectedWidth:
 		vs.selection.eolSelectedWidth = std::clamp(static_cast<int>(wParam), 0, 100);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::SetSelectionLayer:
@@ -8108,7 +9039,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		else
 			/* Default to the line caret */
 			vs.caret.style = CaretStyle::Line;
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::GetCaretStyle:
@@ -8117,7 +9048,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::SetCaretWidth:
 		// Windows accessibility allows 20 pixels caret width.
 		vs.caret.width = std::clamp(static_cast<int>(wParam), 0, 20);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::GetCaretWidth:
@@ -8141,7 +9072,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		if (wParam <= IndicatorMax) {
 			vs.indicators[wParam].sacNormal.style = static_cast<IndicatorStyle>(lParam);
 			vs.indicators[wParam].sacHover.style = static_cast<IndicatorStyle>(lParam);
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -8152,7 +9083,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		if (wParam <= IndicatorMax) {
 			vs.indicators[wParam].sacNormal.fore = ColourRGBA::FromIpRGB(lParam);
 			vs.indicators[wParam].sacHover.fore = ColourRGBA::FromIpRGB(lParam);
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -8192,17 +9123,29 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::IndicSetUnder:
 		if (wParam <= IndicatorMax) {
 			vs.indicators[wParam].under = lParam != 0;
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
 	case Message::IndicGetUnder:
 		return (wParam <= IndicatorMax) ? vs.indicators[wParam].under : 0;
 
+	case Message::IndicSetOverviewRuler:
+		if (wParam <= IndicatorMax) {
+			const uint64_t bit = UINT64_C(1) << wParam;
+			overviewRuler.indicatorMask = (lParam != 0) ? (overviewRuler.indicatorMask | bit) : (overviewRuler.indicatorMask & ~bit);
+			overviewRuler.Invalidate();
+			RedrawOverviewRuler();
+		}
+		break;
+
+	case Message::IndicGetOverviewRuler:
+		return (wParam <= IndicatorMax) && (overviewRuler.indicatorMask & (UINT64_C(1) << wParam)) != 0;
+
 	case Message::IndicSetAlpha:
 		if (wParam <= IndicatorMax && lParam >=0 && lParam <= 255) {
 			vs.indicators[wParam].fillAlpha = static_cast<int>(lParam);
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -8212,7 +9155,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::IndicSetOutlineAlpha:
 		if (wParam <= IndicatorMax && lParam >=0 && lParam <= 255) {
 			vs.indicators[wParam].outlineAlpha = static_cast<int>(lParam);
-			InvalidateStyleRedraw();
+			InvalidateStyleColours();
 		}
 		break;
 
@@ -8252,6 +9195,13 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->DecorationFillRange(PositionFromUPtr(wParam), 0, lParam);
 		break;
 
+	case Message::IndicatorFillRanges:
+		if (lParam != 0) {
+			pdoc->DecorationFillRanges(AsPointer<const Sci::Position *>(lParam), wParam,
+				pdoc->decorations->GetCurrentValue());
+		}
+		break;
+
 	case Message::IndicatorAllOnFor:
 		return pdoc->decorations->AllOnFor(PositionFromUPtr(wParam));
 
@@ -8428,7 +9378,13 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		if (zoomLevel != vs.zoomLevel) {
 			vs.zoomLevel = zoomLevel;
 			vs.fontsValid = false;
-			InvalidateStyleRedraw();
+			// PositionCache is keyed by zoom level, keep widths measured at other levels
+			// so zoom in then out (e.g. Ctrl+wheel) only measures each level once.
+			view.posCache.SetZoomLevel(zoomLevel);
+			NeedWrapping();
+			stylesValid = false;
+			view.llc.Invalidate(LineLayout::ValidLevel::invalid);
+			Redraw();
 			NotifyZoom();
 		}
 		break;
@@ -8450,7 +9406,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::SetEdgeMode:
 		vs.edgeState = static_cast<EdgeVisualStyle>(wParam);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::GetEdgeColour:
@@ -8458,7 +9414,7 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::SetEdgeColour:
 		vs.theEdge.colour = ColourRGBA::FromIpRGB(SPtrFromUPtr(wParam));
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::MultiEdgeAddLine:
@@ -8514,6 +9470,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetDocumentOptions:
 		return static_cast<sptr_t>(pdoc->Options());
 
+	case Message::ConvertToLargeDocument:
+		if (pdoc->ConvertToLarge()) {
+			ConvertContractionState();
+		}
+		break;
+
 	case Message::CreateLoader: {
 			Document *doc = new Document(static_cast<DocumentOption>(lParam));
 			doc->AddRef();
@@ -8693,12 +9655,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 
 	case Message::SetFoldMarginColour:
 		vs.foldmarginColour = OptionalColour(wParam, lParam);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::SetFoldMarginHiColour:
 		vs.foldmarginHighlightColour = OptionalColour(wParam, lParam);
-		InvalidateStyleRedraw();
+		InvalidateStyleColours();
 		break;
 
 	case Message::SetHotspotActiveUnderline:
@@ -8733,14 +9695,37 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::GetGapPosition:
 		return pdoc->GapPosition();
 
+	case Message::GetRangeSegments:
+		if (TextSegments *ts = AsPointer<TextSegments *>(lParam)) {
+			const Sci::Position length = pdoc->LengthNoExcept();
+			const Sci::Position start = std::clamp<Sci::Position>(ts->chrg.cpMin, 0, length);
+			Sci::Position end = ts->chrg.cpMax;
+			if (end < 0 || end > length) {
+				end = length;
+			}
+			end = std::max(start, end);
+			const SplitRange range = pdoc->RangeView(start, end - start);
+			ts->segment1 = range.segment1;
+			ts->length1 = range.length1;
+			ts->segment2 = range.segment2;
+			ts->length2 = range.length2;
+			return end - start;
+		}
+		return 0;
+
 	case Message::SetChangeHistory:
 		changeHistoryOption = static_cast<ChangeHistoryOption>(wParam);
 		pdoc->ChangeHistorySet(wParam & static_cast<int>(ChangeHistoryOption::Enabled));
+		overviewRuler.Invalidate();
+		RedrawOverviewRuler();
 		break;
 
 	case Message::GetChangeHistory:
 		return static_cast<sptr_t>(changeHistoryOption);
 
+	case Message::ChangeHistoryLineNext:
+		return pdoc->ChangeHistoryLineNext(LineFromUPtr(wParam), static_cast<MarkerMask>(lParam));
+
 	case Message::SetUndoSelectionHistory:
 		ChangeUndoSelectionHistory(static_cast<UndoSelectionHistoryOption>(wParam));
 		break;
@@ -8760,16 +9745,20 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 #endif
 
 	case Message::SetExtraAscent:
-		vs.extraAscent = static_cast<int>(wParam);
-		InvalidateStyleRedraw();
+		if (vs.extraAscent != static_cast<int>(wParam)) {
+			vs.extraAscent = static_cast<int>(wParam);
+			InvalidateStyleRedraw();
+		}
 		break;
 
 	case Message::GetExtraAscent:
 		return vs.extraAscent;
 
 	case Message::SetExtraDescent:
-		vs.extraDescent = static_cast<int>(wParam);
-		InvalidateStyleRedraw();
+		if (vs.extraDescent != static_cast<int>(wParam)) {
+			vs.extraDescent = static_cast<int>(wParam);
+			InvalidateStyleRedraw();
+		}
 		break;
 
 	case Message::GetExtraDescent:
@@ -8851,6 +9840,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 	case Message::AnnotationGetLines:
 		return pdoc->AnnotationLines(LineFromUPtr(wParam));
 
+	case Message::AnnotationSetBulk:
+		pdoc->AnnotationSetBulk(wParam, lParam);
+		break;
+
 	case Message::AnnotationClearAll:
 		pdoc->AnnotationClearAll();
 		break;
@@ -8888,6 +9881,10 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->EOLAnnotationSetStyle(LineFromUPtr(wParam), static_cast<int>(lParam));
 		break;
 
+	case Message::EOLAnnotationSetBulk:
+		pdoc->EOLAnnotationSetBulk(wParam, lParam);
+		break;
+
 	case Message::EOLAnnotationClearAll:
 		pdoc->EOLAnnotationClearAll();
 		break;
@@ -9141,6 +10138,12 @@ sptr_t Editor::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		pdoc->CountCharactersAndColumns(lParam);
 		break;
 
+	case Message::CountTextStatistics:
+		if (lParam != 0) {
+			pdoc->CountTextStatistics(lParam);
+		}
+		break;
+
 	case Message::CountCodeUnits:
 		return pdoc->CountUTF16(PositionFromUPtr(wParam), lParam);
 
@@ -123,13 +123,16 @@ struct WrapPending {
 	};
 	Sci::Line start;	// When there are wraps pending, will be in document range
 	Sci::Line end;	// May be lineLarge to indicate all of the document after start
+	bool estimated;	// Heights of lines in range are estimated, see Editor::EstimateWrapHeights()
 	WrapPending() noexcept {
 		start = lineLarge;
 		end = lineLarge;
+		estimated = false;
 	}
 	void Reset() noexcept {
 		start = lineLarge;
 		end = lineLarge;
+		estimated = false;
 	}
 	void Wrapped(Sci::Line line) noexcept {
 		if (start == line)
@@ -148,6 +151,7 @@ struct WrapPending {
 		if ((end < lineEnd) || !neededWrap) {
 			end = lineEnd;
 			changed = true;
+			estimated = false;
 		}
 		return changed;
 	}
@@ -203,6 +207,10 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	/** Style resources may be expensive to allocate so are cached between uses.
 	 * When a style attribute is changed, this cache is flushed. */
 	bool stylesValid;
+	// nested SCI_BEGINSTYLEUPDATE, style changes are compared with stylesBeforeUpdate on the outermost end.
+	int styleUpdateLevel = 0;
+	bool styleUpdatePending = false;
+	std::vector<Style> stylesBeforeUpdate;
 	ViewStyle vs;
 	Scintilla::Technology technology;
 	Point sizeRGBAImage;
@@ -210,6 +218,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	MarginView marginView;
 	EditView view;
+	OverviewRuler overviewRuler;
 
 	Scintilla::CursorShape cursorMode;
 
@@ -220,6 +229,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	bool verticalScrollBarVisible;
 	int xCaretMargin;	///< Ensure this many pixels visible on both sides of caret
 	int scrollWidth;
+	// Longest lines by byte length found in modified lines, measured in next paint
+	std::vector<Sci::Line> wideLineCandidates;
 	int endAtLastLine;
 	Scintilla::CaretSticky caretSticky;
 	Scintilla::MarginOption marginOptions;
@@ -280,9 +291,12 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	WorkNeeded workNeeded;
 	Scintilla::IdleStyling idleStyling;
 	bool needIdleStyling;
+	bool backgroundStyling;
 
 	bool recordingMacro;
 	bool convertPastes;
+	// ranges are moved once by MoveDeferredSelection() instead of on each modification
+	bool deferSelectionMove;
 
 	bool commandEvents;
 	Scintilla::ModificationFlags modEventMask;
@@ -293,6 +307,7 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	VisiblePolicySlop visiblePolicy;
 
 	Sci::Position searchAnchor;
+	std::vector<Sci::Position> findAllRanges;
 
 	Scintilla::AutomaticFold foldAutomatic;
 
@@ -307,6 +322,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	// Wrapping support
 	WrapPending wrapPending;
 	bool insideWrapScroll;
+	// Ratio of measured to estimated sub lines of wrapped long lines
+	double wrapEstimateFactor = 1.0;
 	struct LineDocSub {
 		Scintilla::Line lineDoc = 0;
 		Scintilla::Line subLine = 0;
@@ -320,9 +337,13 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	void InvalidateStyleData() noexcept;
 	void InvalidateStyleRedraw() noexcept;
+	void InvalidateStyleColours() noexcept;
+	void BeginStyleUpdate();
+	void EndStyleUpdate();
 	void RefreshStyleData();
 	void SetRepresentations();
 	void DropGraphics() noexcept;
+	void ReleaseResources() noexcept;
 
 	bool HasMarginWindow() const noexcept;
 	// The top left visible point in main window coordinates. Will be (0, 0) except for
@@ -334,6 +355,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	virtual PRectangle GetClientRectangle() const noexcept;
 	virtual PRectangle GetClientDrawingRectangle() const noexcept;
 	PRectangle GetTextRectangle() const noexcept;
+	PRectangle GetOverviewRulerRectangle() const noexcept;
+	void RedrawOverviewRuler() noexcept;
 
 	Sci::Line LinesOnScreen() const noexcept override;
 	void OnLineWrapped(Sci::Line lineDoc, int linesWrapped, int option) override;
@@ -430,14 +453,19 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void NeedWrapping(Sci::Line docLineStart = 0, Sci::Line docLineEnd = WrapPending::lineLarge, bool invalidate = true) noexcept;
 	bool WrapOneLine(Surface *surface, Sci::Position positionInsert);
 	int WrapBlock(Surface *surface, Sci::Line lineToWrap, Sci::Line lineToWrapEnd);
+	bool EstimateWrapHeights(Sci::Line lineStart, Sci::Line lineEnd);
 	enum class WrapScope {
-		wsAll, wsVisible, wsIdle
+		wsAll, wsVisible, wsIdle, wsTarget
 	};
-	bool WrapLines(WrapScope ws);
+	bool WrapLines(WrapScope ws, Sci::Line lineTarget = 0);
+	void FindWideLineCandidates(Sci::Line lineStart, Sci::Line lineEnd);
+	void MeasureWideLineCandidates(Surface *surface);
 	void LinesJoin();
 	void LinesSplit(int pixelWidth);
+	Sci::Position LinesPad(Scintilla::LinesPadFlag flags);
 
 	void SCICALL PaintSelMargin(Surface *surfaceWindow, PRectangle rc);
+	void SCICALL PaintOverviewRuler(Surface *surfaceWindow, PRectangle rcArea);
 	void RefreshPixMaps(Surface *surfaceWindow);
 	void SCICALL Paint(Surface *surfaceWindow, PRectangle rcArea);
 	Sci::Position FormatRange(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
@@ -456,12 +484,15 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void AddChar(char ch);
 	virtual void InsertCharacter(std::string_view sv, Scintilla::CharacterSource charSource);
 	void ClearSelectionRange(SelectionRange &range);
+	static constexpr size_t DeferSelectionMoveMinRanges = 64;
+	bool CanDeferSelectionMove(const std::vector<SelectionRange *> &selPtrs, std::vector<Sci::Position> &lengthAfter);
+	void MoveDeferredSelection(const std::vector<SelectionRange *> &selPtrs, const std::vector<Sci::Position> &lengthAfter) noexcept;
 	void ClearBeforeTentativeStart();
 	void InsertPaste(std::string_view text);
 	enum class PasteShape {
 		stream = 0, rectangular = 1, line = 2
 	};
-	void InsertPasteShape(std::string_view text, PasteShape shape);
+	void InsertPasteShape(std::string_view text, PasteShape shape, bool lineEndsConverted = false);
 	void ClearSelection(bool retainMultipleSelections = false);
 	void ClearAll();
 	void ClearDocumentStyle();
@@ -550,9 +581,11 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	virtual std::unique_ptr<CaseFolder> CaseFolderForEncoding() const;
 	Sci::Position FindTextFull(Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
+	Sci::Position FindAll(Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
 	void SearchAnchor() noexcept;
 	Sci::Position SearchText(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
 	Sci::Position SearchInTarget(const char *text, Sci::Position length);
+	Sci::Position ReplaceAllInTarget(const char *find, const char *replace);
 	void GoToLine(Sci::Line lineNo);
 
 	virtual void CopyToClipboard(const SelectionText &selectedText) const = 0;
@@ -565,12 +598,13 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	virtual void DisplayCursor(Window::Cursor c) noexcept;
 	virtual bool SCICALL DragThreshold(Point ptStart, Point ptNow) const noexcept;
 	virtual void StartDrag() = 0;
-	void DropAt(SelectionPosition position, std::string_view value, bool moving, bool rectangular);
+	void DropAt(SelectionPosition position, std::string_view value, bool moving, bool rectangular, bool lineEndsConverted = false);
 	/** PositionInSelection returns true if position in selection. */
 	bool PositionInSelection(Sci::Position pos) const noexcept;
 	bool SCICALL PointInSelection(Point pt);
 	ptrdiff_t SCICALL SelectionFromPoint(Point pt);
 	bool SCICALL PointInSelMargin(Point pt) const noexcept;
+	bool SCICALL PointInOverviewRuler(Point pt) const noexcept;
 	Window::Cursor GetMarginCursor(Point pt) const noexcept;
 	void DropSelection(size_t part) noexcept;
 	void TrimAndSetSelection(Sci::Position currentPos_, Sci::Position anchor_);
@@ -618,11 +652,15 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 
 	void SetAnnotationHeights(Sci::Line start, Sci::Line end);
 	virtual void SetDocPointer(Document *document);
+	void ConvertContractionState();
+	size_t MemoryUsage(Scintilla::MemoryCategory category);
+	void GetPaintStatistics(bool reset, Scintilla::PaintStatistics *statistics) noexcept;
 
 	void SetAnnotationVisible(Scintilla::AnnotationVisible visible);
 	void SetEOLAnnotationVisible(Scintilla::EOLAnnotationVisible visible) noexcept;
 
 	Sci::Line ExpandLine(Sci::Line line, Scintilla::FoldLevel level = Scintilla::FoldLevel::None, Sci::Line *parentLine = nullptr);
+	void ExpandParents(Sci::Line lineDoc);
 	void SetFoldExpanded(Sci::Line lineDoc, bool expanded);
 	void FoldLine(Sci::Line line, Scintilla::FoldAction action);
 	void FoldExpand(Sci::Line line, Scintilla::FoldAction action, Scintilla::FoldLevel level);
@@ -631,6 +669,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	void FoldChanged(Sci::Line line, Scintilla::FoldLevel levelNow, Scintilla::FoldLevel levelPrev);
 	void NeedShown(Sci::Position pos, Sci::Position len);
 	void FoldAll(Scintilla::FoldAction action);
+	void FoldAllLevel(int levelNumber, Scintilla::FoldAction action);
+	Sci::Line HideLinesExceptFindAll(Sci::Line lineStart, Sci::Line contextLines);
 
 	Sci::Position GetTag(char *tagValue, int tagNumber);
 	Sci::Position ReplaceTarget(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
@@ -655,6 +695,8 @@ protected:	// ScintillaBase subclass needs access to much of Editor
 	virtual sptr_t DefWndProc(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam) = 0;
 	bool ValidMargin(Scintilla::uptr_t wParam) const noexcept;
 	void StyleSetMessage(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
+	void StyleSetBulk(const Scintilla::StyleRecord *records, size_t count);
+	Scintilla::sptr_t SendCommands(const Scintilla::CommandRecord *commands, size_t count);
 	Scintilla::sptr_t StyleGetMessage(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam);
 	void SetSelectionNMessage(Scintilla::Message iMessage, Scintilla::uptr_t wParam, Scintilla::sptr_t lParam) noexcept;
 	void SetSelectionMode(uptr_t wParam, bool setMoveExtends);
@@ -0,0 +1,39 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+// TraceLogging events for Windows Performance Analyzer, each operation writes start and stop events
+// of an activity on current thread, payload is written with TraceLoggingInt64() etc. Record events with:
+// tracelog -start Notepad4 -f Notepad4.etl -guid #F5D84DE7-41B5-5786-2935-617A7DD4BC73
+// tracelog -stop Notepad4
+// Provider GUID is derived from name "Notepad4", so "*Notepad4" also works with tools supporting it.
+
+#ifndef NP2_ENABLE_EVENT_TRACE
+#if _WIN32_WINNT >= 0x0600 && defined(__has_include)
+#if __has_include(<TraceLoggingActivity.h>)
+#define NP2_ENABLE_EVENT_TRACE	1
+#endif
+#endif
+#endif
+
+#if NP2_ENABLE_EVENT_TRACE
+#include <TraceLoggingProvider.h>
+#include <TraceLoggingActivity.h>
+
+TRACELOGGING_DECLARE_PROVIDER(np2TraceProvider);
+
+// stop event is written by destructor when function returned before EventTraceStop().
+using EventTraceActivity = TraceLoggingThreadActivity<np2TraceProvider>;
+#define EventTraceStart(activity, name, ...)		TraceLoggingWriteStart(activity, name, __VA_ARGS__)
+#define EventTraceStop(activity, name, ...)		TraceLoggingWriteStop(activity, name, __VA_ARGS__)
+// single event without activity.
+#define EventTraceWrite(name, ...)		TraceLoggingWrite(np2TraceProvider, name, __VA_ARGS__)
+
+#else
+struct EventTraceActivity {
+	EventTraceActivity() noexcept {}
+};
+#define EventTraceStart(activity, name, ...)
+#define EventTraceStop(activity, name, ...)
+#define EventTraceWrite(name, ...)
+#endif
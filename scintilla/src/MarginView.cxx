@@ -277,6 +277,16 @@ void MarginView::PaintOneMargin(Surface *surface, PRectangle rc, PRectangle rcOn
 	const EditModel &model, const ViewStyle &vs) const {
 	const Point ptOrigin = model.GetVisibleOriginInMain();
 	const Style &lineNumberStyle = vs.styles[StyleLineNumber];
+	// line number widths are composed from digit widths measured once per paint
+	XYPOSITION digitWidths[10]{};
+	const bool composeNumberWidth = marginStyle.style == MarginType::Number
+		&& !FlagSet(model.foldFlags, (FoldFlag::LevelNumbers | FoldFlag::LineState));
+	if (composeNumberWidth) {
+		for (int digit = 0; digit < 10; digit++) {
+			const char ch = static_cast<char>('0' + digit);
+			digitWidths[digit] = surface->WidthText(lineNumberStyle.font.get(), std::string_view(&ch, 1));
+		}
+	}
 	const Sci::Line lineStartPaint = static_cast<Sci::Line>(rcOneMargin.top + ptOrigin.y) / vs.lineHeight;
 	Sci::Line visibleLine = model.TopLineOfMain() + lineStartPaint;
 	XYPOSITION yposScreen = static_cast<XYPOSITION>(lineStartPaint * vs.lineHeight) - ptOrigin.y;
@@ -389,7 +399,14 @@ void MarginView::PaintOneMargin(Surface *surface, PRectangle rc, PRectangle rcOn
 				}
 				PRectangle rcNumber = rcMarker;
 				// Right justify
-				const XYPOSITION width = surface->WidthText(lineNumberStyle.font.get(), sNumber);
+				XYPOSITION width = 0;
+				if (composeNumberWidth) {
+					for (const char ch : sNumber) {
+						width += digitWidths[ch - '0'];
+					}
+				} else {
+					width = surface->WidthText(lineNumberStyle.font.get(), sNumber);
+				}
 				const XYPOSITION xpos = rcNumber.right - width - vs.marginNumberPadding;
 				rcNumber.left = xpos;
 				DrawTextNoClipPhase(surface, rcNumber, lineNumberStyle,
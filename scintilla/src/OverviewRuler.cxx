@@ -0,0 +1,232 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+/** @file OverviewRuler.cxx
+ ** Overview ruler of markers and indicators beside the vertical scroll bar.
+ **/
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <memory>
+
+#include "ParallelSupport.h"
+#include "ScintillaTypes.h"
+#include "ScintillaMessages.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+#include "VectorISA.h"
+
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "OverviewRuler.h"
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+void OverviewRuler::InvalidateLines(Sci::Line lineStart, Sci::Line lineEnd) noexcept {
+	if (dirtyStart < dirtyEnd) {
+		dirtyStart = std::min(dirtyStart, lineStart);
+		dirtyEnd = std::max(dirtyEnd, lineEnd);
+	} else {
+		dirtyStart = lineStart;
+		dirtyEnd = lineEnd;
+	}
+}
+
+bool OverviewRuler::NotifyModified(const Document &doc, const DocModification &mh) noexcept {
+	const ModificationFlags type = mh.modificationType;
+	if (FlagSet(type, ModificationFlags::InsertText | ModificationFlags::DeleteText)) {
+		if (mh.linesAdded != 0) {
+			// following lines are moved into other buckets
+			valid = false;
+		} else {
+			// change history of the line
+			const Sci::Line line = doc.SciLineFromPosition(mh.position);
+			InvalidateLines(line, line + 1);
+		}
+		return true;
+	}
+	// fold level changes are also reported as marker changes
+	if (FlagSet(type, ModificationFlags::ChangeMarker) && !FlagSet(type, ModificationFlags::ChangeFold)) {
+		if (mh.line < 0) {
+			valid = false;
+		} else {
+			InvalidateLines(mh.line, mh.line + 1);
+		}
+		return true;
+	}
+	if (FlagSet(type, ModificationFlags::ChangeIndicator)) {
+		InvalidateLines(doc.SciLineFromPosition(mh.position), doc.SciLineFromPosition(mh.position + mh.length) + 1);
+		return true;
+	}
+	return false;
+}
+
+// first document line that is displayed inside the bucket or is hidden before such line
+Sci::Line OverviewRuler::DocFromBucket(const IContractionState &cs, int bucket) const noexcept {
+	const Sci::Line lineDisplay = DisplayFromBucket(bucket);
+	return (lineDisplay == 0) ? 0 : cs.DocFromDisplay(lineDisplay - 1) + 1;
+}
+
+void OverviewRuler::FillRange(Document &doc, const IContractionState &cs, int bucketStart, int bucketEnd) {
+	const Sci::Line lineStart = DocFromBucket(cs, bucketStart);
+	const Sci::Line linesTotal = doc.LinesTotal();
+	// seek from each bucket, remaining marks inside the bucket are skipped
+	const auto fillLane = [&](auto nextLine, uint8_t Bucket::*slot, uint8_t number) {
+		Sci::Line line = lineStart;
+		while (line < linesTotal) {
+			const Sci::Line next = nextLine(line);
+			if (next < 0) {
+				break;
+			}
+			const int bucket = BucketFromDisplay(cs.DisplayFromDoc(next));
+			if (bucket >= bucketEnd) {
+				break;
+			}
+			uint8_t &mark = buckets[bucket].*slot;
+			if (mark == NoMark) {
+				mark = number;
+			}
+			line = std::max(next + 1, DocFromBucket(cs, bucket + 1));
+		}
+	};
+
+	constexpr int historyFirst = static_cast<int>(MarkerOutline::HistoryRevertedToOrigin);
+	constexpr int historyLast = static_cast<int>(MarkerOutline::HistoryRevertedToModified);
+	for (MarkerMask mask = markerMask; mask != 0; mask &= mask - 1) {
+		const int marker = np2_ctz(mask);
+		const MarkerMask markerBit = 1U << marker;
+		if (marker >= historyFirst && marker <= historyLast) {
+			fillLane([&](Sci::Line line) noexcept {
+				return doc.ChangeHistoryLineNext(line, markerBit);
+			}, &Bucket::marker, static_cast<uint8_t>(marker));
+		} else {
+			fillLane([&](Sci::Line line) noexcept {
+				return doc.MarkerNext(line, markerBit);
+			}, &Bucket::marker, static_cast<uint8_t>(marker));
+		}
+	}
+
+	const Sci::Position length = doc.LengthNoExcept();
+	for (uint64_t mask = indicatorMask; mask != 0; mask &= mask - 1) {
+		const int indicator = np2_ctz64(mask);
+		fillLane([&](Sci::Line line) noexcept {
+			Sci::Position position = doc.LineStart(line);
+			if (doc.decorations->ValueAt(indicator, position) == 0) {
+				// End() returns 0 when indicator is not used
+				const Sci::Position end = doc.decorations->End(indicator, position);
+				position = (end > position) ? end : length;
+			}
+			return (position < length) ? doc.SciLineFromPosition(position) : -1;
+		}, &Bucket::indicator, static_cast<uint8_t>(indicator));
+	}
+}
+
+void OverviewRuler::Fill(Document &doc, const IContractionState &cs, int height, Sci::Line linesOnScreen) {
+	height = std::max(height, 0);
+	const Sci::Line linesDisplayedNow = cs.LinesDisplayed();
+	const Sci::Line scaleNow = std::max<Sci::Line>({linesDisplayedNow, linesOnScreen, 1});
+	if (!valid || linesDisplayed != linesDisplayedNow || scale != scaleNow || buckets.size() != static_cast<size_t>(height)) {
+		linesDisplayed = linesDisplayedNow;
+		scale = scaleNow;
+		buckets.assign(height, Bucket{NoMark, NoMark});
+		if (height != 0) {
+			FillRange(doc, cs, 0, height);
+		}
+	} else if (dirtyStart < dirtyEnd && height != 0) {
+		const Sci::Line linesTotal = doc.LinesTotal();
+		const Sci::Line lineFirst = std::min(dirtyStart, linesTotal - 1);
+		const Sci::Line lineLast = std::min(dirtyEnd, linesTotal) - 1;
+		const int bucketStart = BucketFromDisplay(cs.DisplayFromDoc(lineFirst));
+		const int bucketEnd = std::min(BucketFromDisplay(cs.DisplayFromDoc(std::max(lineFirst, lineLast))) + 1, height);
+		std::fill(buckets.begin() + bucketStart, buckets.begin() + bucketEnd, Bucket{NoMark, NoMark});
+		FillRange(doc, cs, bucketStart, bucketEnd);
+	}
+	valid = true;
+	dirtyStart = 0;
+	dirtyEnd = 0;
+}
+
+Sci::Line OverviewRuler::DisplayFromY(int y) const noexcept {
+	if (buckets.empty()) {
+		return 0;
+	}
+	const int bucket = std::clamp(y, 0, static_cast<int>(buckets.size()) - 1);
+	return DisplayFromBucket(bucket);
+}
+
+void OverviewRuler::Paint(Surface *surface, PRectangle rc, const ViewStyle &vs, Sci::Line topLine, Sci::Line linesOnScreen) const {
+	surface->FillRectangle(rc, vs.selbar);
+	const int height = static_cast<int>(buckets.size());
+	if (height == 0) {
+		return;
+	}
+
+	// visible lines use text background
+	PRectangle rcView = rc;
+	rcView.top = rc.top + BucketFromDisplay(topLine);
+	rcView.bottom = std::min(std::max(rc.top + BucketFromDisplay(topLine + linesOnScreen), rcView.top + 2), rc.bottom);
+	surface->FillRectangle(rcView, vs.styles[StyleDefault].back);
+
+	// a mark covers at least 2 pixels, or the whole line when lines are taller than a pixel
+	const int markHeight = std::max(2, static_cast<int>((height + scale - 1) / scale));
+	const auto paintLane = [&](uint8_t Bucket::*slot, XYPOSITION left, XYPOSITION right, auto colour) {
+		for (int bucket = 0; bucket < height;) {
+			const uint8_t mark = buckets[bucket].*slot;
+			int end = bucket + 1;
+			if (mark != NoMark) {
+				while (end < height && buckets[end].*slot == mark) {
+					end++;
+				}
+				const PRectangle rcMark(left, rc.top + bucket, right, std::min(rc.top + end - 1 + markHeight, rc.bottom));
+				surface->FillRectangle(rcMark, colour(mark));
+			}
+			bucket = end;
+		}
+	};
+
+	// markers on left half, indicators on right half
+	const XYPOSITION left = rc.left + 1;
+	const XYPOSITION middle = std::round((rc.left + rc.right) / 2);
+	if (markerMask != 0) {
+		paintLane(&Bucket::marker, left, (indicatorMask != 0) ? middle : rc.right, [&vs](uint8_t marker) noexcept {
+			return vs.markers[marker].back;
+		});
+	}
+	if (indicatorMask != 0) {
+		paintLane(&Bucket::indicator, (markerMask != 0) ? middle : left, rc.right, [&vs](uint8_t indicator) noexcept {
+			return vs.indicators[indicator].sacNormal.fore;
+		});
+	}
+}
@@ -0,0 +1,54 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Scintilla::Internal {
+
+/// Marks beside the vertical scroll bar, each pixel row is a bucket of display lines.
+/// Buckets are filled by seeking to the next marked line or indicator run from each bucket,
+/// so both filling and painting cost depends on ruler height instead of document size.
+class OverviewRuler {
+	static constexpr uint8_t NoMark = 0xff;
+	struct Bucket {
+		uint8_t marker;
+		uint8_t indicator;
+	};
+	std::vector<Bucket> buckets;
+	Sci::Line scale = 0;		// display lines mapped onto buckets
+	Sci::Line linesDisplayed = 0;	// changed by folding and wrapping
+	Sci::Line dirtyStart = 0;	// document lines to refill
+	Sci::Line dirtyEnd = 0;
+	bool valid = false;
+
+	int BucketFromDisplay(Sci::Line lineDisplay) const noexcept {
+		return static_cast<int>(lineDisplay * static_cast<Sci::Line>(buckets.size()) / scale);
+	}
+	Sci::Line DisplayFromBucket(int bucket) const noexcept {
+		const Sci::Line height = buckets.size();
+		return (bucket * scale + height - 1) / height;
+	}
+	Sci::Line DocFromBucket(const IContractionState &cs, int bucket) const noexcept;
+	void FillRange(Document &doc, const IContractionState &cs, int bucketStart, int bucketEnd);
+
+public:
+	MarkerMask markerMask = 0;
+	uint64_t indicatorMask = 0;
+
+	bool Enabled() const noexcept {
+		return markerMask != 0 || indicatorMask != 0;
+	}
+	void Invalidate() noexcept {
+		valid = false;
+	}
+	void InvalidateLines(Sci::Line lineStart, Sci::Line lineEnd) noexcept;
+	bool NotifyModified(const Document &doc, const DocModification &mh) noexcept;
+	void Fill(Document &doc, const IContractionState &cs, int height, Sci::Line linesOnScreen);
+	Sci::Line DisplayFromY(int y) const noexcept;
+	void Paint(Surface *surface, PRectangle rc, const ViewStyle &vs, Sci::Line topLine, Sci::Line linesOnScreen) const;
+	void DropBuckets() noexcept {
+		buckets = {};
+		valid = false;
+	}
+};
+
+}
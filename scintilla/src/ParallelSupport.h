@@ -2,6 +2,8 @@
 // See License.txt for details about distribution and modification.
 #pragma once
 
+#include <atomic>
+
 #include <windows.h>
 
 #ifndef _WIN32_WINNT_WIN7
@@ -17,6 +19,99 @@ inline bool WaitableTimerExpired(HANDLE timer) noexcept {
 	return WaitForSingleObject(timer, 0) == WAIT_OBJECT_0;
 }
 
+inline uint32_t GetHardwareConcurrency() noexcept {
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+	// support more than 64 processors on Windows 11, Windows Server 2022 and later system
+	// https://learn.microsoft.com/en-us/windows/win32/procthread/processor-groups
+	return GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+	SYSTEM_INFO info;
+	GetNativeSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#endif
+}
+
+// Background work nobody waits for (e.g. background styling) runs with EcoQoS and below
+// normal priority while the flag is set (SCI_SETBACKGROUNDWORKTHROTTLED), e.g. when the
+// application is inactive or on battery. Parallel layout and find keep normal priority.
+inline std::atomic<bool> backgroundWorkThrottled;
+
+inline void SetCurrentThreadThrottled(bool throttled) noexcept {
+	// THREAD_POWER_THROTTLING_STATE, SetThreadInformation() requires Windows 8 and EcoQoS Windows 10 1709
+	struct PowerThrottlingState {
+		ULONG Version;
+		ULONG ControlMask;
+		ULONG StateMask;
+	};
+	using SetThreadInformationSig = BOOL (WINAPI *)(HANDLE hThread, int threadInformationClass, LPVOID threadInformation, DWORD threadInformationSize);
+	static const SetThreadInformationSig fnSetThreadInformation = __builtin_bit_cast(SetThreadInformationSig,
+		::GetProcAddress(::GetModuleHandleW(L"kernel32.dll"), "SetThreadInformation"));
+
+	HANDLE thread = GetCurrentThread();
+	if (fnSetThreadInformation) {
+		constexpr int ThreadPowerThrottling = 3;
+		constexpr ULONG ExecutionSpeed = 1; // THREAD_POWER_THROTTLING_EXECUTION_SPEED
+		// empty control mask lets system manage the thread again
+		const ULONG mask = throttled ? ExecutionSpeed : 0;
+		PowerThrottlingState state = { 1, mask, mask };
+		fnSetThreadInformation(thread, ThreadPowerThrottling, &state, sizeof(state));
+	}
+	SetThreadPriority(thread, throttled ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_NORMAL);
+}
+
+// throttle pool thread during a background callback, restored before the thread is returned to pool.
+class BackgroundWorkScope {
+	const bool throttled;
+public:
+	BackgroundWorkScope() noexcept : throttled{backgroundWorkThrottled.load(std::memory_order_relaxed)} {
+		if (throttled) {
+			SetCurrentThreadThrottled(true);
+		}
+	}
+	~BackgroundWorkScope() {
+		if (throttled) {
+			SetCurrentThreadThrottled(false);
+		}
+	}
+	BackgroundWorkScope(const BackgroundWorkScope &) = delete;
+	BackgroundWorkScope(BackgroundWorkScope &&) = delete;
+	BackgroundWorkScope &operator=(const BackgroundWorkScope &) = delete;
+	BackgroundWorkScope &operator=(BackgroundWorkScope &&) = delete;
+};
+
+#if USE_WIN32_PTP_WORK
+template <typename Worker>
+VOID CALLBACK ParallelWorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
+	static_cast<Worker *>(context)->DoWork();
+}
+
+// Run worker.DoWork() on threadCount threads from system thread pool, the calling thread
+// takes one part instead of idle waiting. DoWork() should take items from a shared counter
+// until all of them are done, so it also works when fewer threads are available.
+template <typename Worker>
+void RunParallelWork(Worker &worker, uint32_t threadCount) {
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(ParallelWorkCallback<Worker>, &worker, nullptr) : nullptr;
+	if (work) {
+		for (uint32_t i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	try {
+		worker.DoWork();
+	} catch (...) {
+		if (work) {
+			WaitForThreadpoolWorkCallbacks(work, FALSE);
+			CloseThreadpoolWork(work);
+		}
+		throw;
+	}
+	if (work) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+}
+#endif
+
 // MSVC Code Analysis
 #ifndef _Acquires_lock_
 #define _Acquires_lock_(x)
@@ -80,6 +80,10 @@ public:
 		return static_cast<T>(body.Length()) - 1;
 	}
 
+	size_t MemoryUsage() const noexcept {
+		return body.MemoryUsage();
+	}
+
 	void ReAllocate(ptrdiff_t newSize) {
 		// + 1 accounts for initial element that is always 0.
 		// + 2 to avoid reallocation.
@@ -253,4 +257,464 @@ public:
 };
 
 
+/// Partitioning for scattered modifications, e.g. editing with many carets.
+/// Partition start positions are stored in blocks relative to the first one in the block,
+/// block lengths and element counts are summed with Fenwick trees, so each modification
+/// costs O(blockSize + log(blocks)) instead of moving the step over O(partitions) elements.
+template <typename T>
+class BlockPartitioning {
+	static constexpr size_t blockSize = 512;
+	struct Location {
+		size_t block;
+		T first;
+		T base;
+	};
+
+	std::vector<std::vector<T>> blocks;
+	std::vector<T> blockLength;	// distance from first element to first element of next block
+	std::vector<T> treeLength;
+	std::vector<T> treeCount;
+	size_t treeStep = 1;
+	T elementCount = 0;
+	mutable Location cache {};
+	mutable bool cacheValid = false;
+
+	static void TreeAdd(std::vector<T> &tree, size_t index, T delta) noexcept {
+		for (++index; index <= tree.size(); index += index & (0 - index)) {
+			tree[index - 1] += delta;
+		}
+	}
+
+	static T TreeSum(const std::vector<T> &tree, size_t index) noexcept {
+		T sum = 0;
+		for (; index != 0; index &= index - 1) {
+			sum += tree[index - 1];
+		}
+		return sum;
+	}
+
+	void RebuildTrees() {
+		const size_t count = blocks.size();
+		treeLength = blockLength;
+		treeCount.resize(count);
+		for (size_t block = 0; block < count; block++) {
+			treeCount[block] = static_cast<T>(blocks[block].size());
+		}
+		for (size_t index = 1; index <= count; index++) {
+			const size_t parent = index + (index & (0 - index));
+			if (parent <= count) {
+				treeLength[parent - 1] += treeLength[index - 1];
+				treeCount[parent - 1] += treeCount[index - 1];
+			}
+		}
+		treeStep = 1;
+		while (treeStep*2 <= count) {
+			treeStep *= 2;
+		}
+		cacheValid = false;
+	}
+
+	void AddLength(size_t block, T delta) noexcept {
+		blockLength[block] += delta;
+		TreeAdd(treeLength, block, delta);
+	}
+
+	/// Find block contains element, element must be less than elementCount.
+	Location Locate(T element) const noexcept {
+		if (cacheValid && element >= cache.first && element - cache.first < static_cast<T>(blocks[cache.block].size())) {
+			return cache;
+		}
+		size_t block = 0;
+		T first = 0;
+		for (size_t step = treeStep; step != 0; step >>= 1) {
+			const size_t next = block + step;
+			if (next <= treeCount.size() && first + treeCount[next - 1] <= element) {
+				block = next;
+				first += treeCount[next - 1];
+			}
+		}
+		block = std::min(block, blocks.size() - 1);
+		cache = { block, TreeSum(treeCount, block), TreeSum(treeLength, block) };
+		cacheValid = true;
+		return cache;
+	}
+
+	/// Make first element of the block to be zero by moving block start.
+	void Rebase(size_t block) noexcept {
+		std::vector<T> &positions = blocks[block];
+		const T shift = positions[0];
+		if (shift != 0 && block != 0) {
+			for (T &pos : positions) {
+				pos -= shift;
+			}
+			AddLength(block, -shift);
+			AddLength(block - 1, shift);
+		}
+	}
+
+	void SplitBlock(size_t block) {
+		while (blocks[block].size() > 2*blockSize) {
+			std::vector<T> &positions = blocks[block];
+			const T shift = positions[blockSize];
+			std::vector<T> tail(positions.begin() + blockSize, positions.end());
+			positions.resize(blockSize);
+			for (T &pos : tail) {
+				pos -= shift;
+			}
+			blocks.insert(blocks.begin() + block + 1, std::move(tail));
+			blockLength.insert(blockLength.begin() + block + 1, blockLength[block] - shift);
+			blockLength[block] = shift;
+			block++;
+		}
+	}
+
+public:
+	BlockPartitioning() {
+		DeleteAll();
+	}
+
+	template <typename Source>
+	explicit BlockPartitioning(const Source &source) {
+		const T count = source.Partitions() + 1;
+		blocks.reserve(count/blockSize + 1);
+		for (T element = 0; element < count; element += blockSize) {
+			const T end = std::min<T>(element + blockSize, count);
+			const T base = source.PositionFromPartition(element);
+			std::vector<T> positions(end - element);
+			for (T index = element; index < end; index++) {
+				positions[index - element] = source.PositionFromPartition(index) - base;
+			}
+			blockLength.push_back(((end < count) ? source.PositionFromPartition(end) : source.Length()) - base);
+			blocks.push_back(std::move(positions));
+		}
+		elementCount = count;
+		RebuildTrees();
+	}
+
+	T Partitions() const noexcept {
+		return elementCount - 1;
+	}
+
+	size_t MemoryUsage() const noexcept {
+		size_t usage = (blocks.capacity()*sizeof(std::vector<T>))
+			+ (blockLength.capacity() + treeLength.capacity() + treeCount.capacity())*sizeof(T);
+		for (const std::vector<T> &block : blocks) {
+			usage += block.capacity()*sizeof(T);
+		}
+		return usage;
+	}
+
+	void ReAllocate(ptrdiff_t newSize) {
+		blocks.reserve(newSize/blockSize + 1);
+	}
+
+	T Length() const noexcept {
+		return TreeSum(treeLength, blocks.size());
+	}
+
+	void InsertPartition(T partition, T pos) {
+		InsertPartitions(partition, &pos, 1);
+	}
+
+	template <typename P>
+	void InsertPartitions(T partition, const P *positions, size_t length) {
+		PLATFORM_ASSERT(partition > 0 && partition <= elementCount);
+		size_t block;
+		size_t index;
+		T base;
+		if (partition == elementCount) {
+			block = blocks.size() - 1;
+			index = blocks[block].size();
+			base = TreeSum(treeLength, block);
+		} else {
+			const Location location = Locate(partition);
+			block = location.block;
+			index = partition - location.first;
+			base = location.base;
+			if (index == 0) {
+				// append to previous block to keep first element unchanged
+				--block;
+				index = blocks[block].size();
+				base -= blockLength[block];
+			}
+		}
+
+		std::vector<T> &values = blocks[block];
+		const bool lastElement = block + 1 == blocks.size() && index == values.size();
+		const T back = values.back();
+		values.insert(values.begin() + index, length, 0);
+		for (size_t i = 0; i < length; i++) {
+			values[index + i] = static_cast<T>(positions[i]) - base;
+		}
+		if (lastElement) {
+			AddLength(block, values.back() - back);
+		}
+		elementCount += static_cast<T>(length);
+		if (values.size() > 2*blockSize) {
+			SplitBlock(block);
+			RebuildTrees();
+		} else {
+			TreeAdd(treeCount, block, static_cast<T>(length));
+			cacheValid = false;
+		}
+	}
+
+	void InsertPartitionsWithCast(T partition, const ptrdiff_t *positions, size_t length) {
+		InsertPartitions(partition, positions, length);
+	}
+
+	void SetPartitionStartPosition(T partition, T pos) noexcept {
+		if (!IsValidIndex(partition, elementCount)) {
+			return;
+		}
+		const Location location = Locate(partition);
+		std::vector<T> &values = blocks[location.block];
+		const size_t index = partition - location.first;
+		const T back = values.back();
+		values[index] = pos - location.base;
+		if (location.block + 1 == blocks.size()) {
+			AddLength(location.block, values.back() - back);
+		}
+		if (index == 0) {
+			Rebase(location.block);
+		}
+		cacheValid = false;
+	}
+
+	void InsertText(T partitionInsert, T delta) noexcept {
+		// Point all the partitions after the insertion point further along in the buffer
+		const T element = partitionInsert + 1;
+		if (!IsValidIndex(element, elementCount)) {
+			return;
+		}
+		const Location location = Locate(element);
+		const size_t index = element - location.first;
+		if (index == 0) {
+			AddLength(location.block - 1, delta);
+		} else {
+			std::vector<T> &values = blocks[location.block];
+			for (auto it = values.begin() + index; it != values.end(); ++it) {
+				*it += delta;
+			}
+			AddLength(location.block, delta);
+		}
+		cacheValid = false;
+	}
+
+	void RemovePartition(T partition) {
+		PLATFORM_ASSERT(partition > 0 && partition < elementCount);
+		const Location location = Locate(partition);
+		const size_t block = location.block;
+		std::vector<T> &values = blocks[block];
+		const size_t index = partition - location.first;
+		const T back = values.back();
+		values.erase(values.begin() + index);
+		--elementCount;
+		if (values.empty()) {
+			// removed element was at start of the block, previous block extends over it
+			const T length = blockLength[block];
+			blocks.erase(blocks.begin() + block);
+			blockLength.erase(blockLength.begin() + block);
+			if (block == blocks.size()) {
+				// previous block becomes the last
+				blockLength[block - 1] = blocks[block - 1].back();
+			} else {
+				blockLength[block - 1] += length;
+			}
+			RebuildTrees();
+			return;
+		}
+		if (block + 1 == blocks.size() && index == values.size()) {
+			AddLength(block, values.back() - back);
+		}
+		TreeAdd(treeCount, block, -1);
+		if (index == 0) {
+			Rebase(block);
+		}
+		cacheValid = false;
+	}
+
+	T PositionFromPartition(T partition) const noexcept {
+		PLATFORM_ASSERT(partition >= 0);
+		PLATFORM_ASSERT(partition < elementCount);
+		if (!IsValidIndex(partition, elementCount)) {
+			return 0;
+		}
+		const Location location = Locate(partition);
+		return location.base + blocks[location.block][partition - location.first];
+	}
+
+	/// Return value in range [0 .. Partitions() - 1] even for arguments outside interval
+	T PartitionFromPosition(T pos) const noexcept {
+		if (elementCount <= 2) {
+			return 0;
+		}
+		if (pos >= Length()) {
+			return Partitions() - 1;
+		}
+		Location location;
+		if (cacheValid && pos >= cache.base && pos - cache.base < blockLength[cache.block]) {
+			location = cache;
+		} else {
+			size_t block = 0;
+			T base = 0;
+			for (size_t step = treeStep; step != 0; step >>= 1) {
+				const size_t next = block + step;
+				if (next <= treeLength.size() && base + treeLength[next - 1] <= pos) {
+					block = next;
+					base += treeLength[next - 1];
+				}
+			}
+			block = std::min(block, blocks.size() - 1);
+			location = { block, TreeSum(treeCount, block), TreeSum(treeLength, block) };
+			cache = location;
+			cacheValid = true;
+		}
+		const std::vector<T> &values = blocks[location.block];
+		const T index = static_cast<T>(std::upper_bound(values.begin(), values.end(), pos - location.base) - values.begin()) - 1;
+		return std::clamp<T>(location.first + index, 0, Partitions() - 1);
+	}
+
+	void DeleteAll() {
+		blocks.assign(1, std::vector<T>(2));
+		blockLength.assign(1, 0);
+		elementCount = 2;
+		RebuildTrees();
+	}
+
+	void Check() const noexcept {}
+};
+
+/// Partitioning that switches to BlockPartitioning when modifications are scattered.
+template <typename T>
+class AdaptivePartitioning {
+	static constexpr T minBlockPartitions = 64*1024;
+	static constexpr uint32_t checkInterval = 64;
+	static constexpr ptrdiff_t minFarDistance = 4096;
+
+	Partitioning<T> starts;
+	std::unique_ptr<BlockPartitioning<T>> blocks;
+	T lastPartition = 0;
+	uint32_t modifications = 0;
+	uint32_t farModifications = 0;
+
+	// Partitioning moves the step over all partitions between two modifications,
+	// a single jump (e.g. first edit after loading) is cheap, only switch when most jumps are far.
+	bool UseBlocks(T partition) noexcept {
+		if (blocks) {
+			return true;
+		}
+		if (starts.Partitions() >= minBlockPartitions) {
+			const ptrdiff_t distance = (partition > lastPartition) ? partition - lastPartition : lastPartition - partition;
+			farModifications += distance > minFarDistance;
+			lastPartition = partition;
+			if (++modifications == checkInterval) {
+				if (farModifications > checkInterval/2) {
+					try {
+						blocks = std::make_unique<BlockPartitioning<T>>(starts);
+						starts.DeleteAll();
+					} catch (...) {
+						blocks.reset();
+					}
+				}
+				modifications = 0;
+				farModifications = 0;
+			}
+		}
+		return blocks != nullptr;
+	}
+
+public:
+	explicit AdaptivePartitioning(size_t growSize = 8): starts(growSize) {}
+
+	T Partitions() const noexcept {
+		return blocks ? blocks->Partitions() : starts.Partitions();
+	}
+
+	/// BlockPartitioning caches last located block, so it can't be read from multiple threads.
+	bool ConcurrentRead() const noexcept {
+		return blocks == nullptr;
+	}
+
+	size_t MemoryUsage() const noexcept {
+		return starts.MemoryUsage() + (blocks ? blocks->MemoryUsage() : 0);
+	}
+
+	void ReAllocate(ptrdiff_t newSize) {
+		if (blocks) {
+			blocks->ReAllocate(newSize);
+		} else {
+			starts.ReAllocate(newSize);
+		}
+	}
+
+	T Length() const noexcept {
+		return blocks ? blocks->Length() : starts.Length();
+	}
+
+	void InsertPartition(T partition, T pos) {
+		if (UseBlocks(partition)) {
+			blocks->InsertPartition(partition, pos);
+		} else {
+			starts.InsertPartition(partition, pos);
+		}
+	}
+
+	void InsertPartitions(T partition, const T *positions, size_t length) {
+		if (blocks) {
+			blocks->InsertPartitions(partition, positions, length);
+		} else {
+			starts.InsertPartitions(partition, positions, length);
+		}
+	}
+
+	void InsertPartitionsWithCast(T partition, const ptrdiff_t *positions, size_t length) {
+		if (blocks) {
+			blocks->InsertPartitionsWithCast(partition, positions, length);
+		} else {
+			starts.InsertPartitionsWithCast(partition, positions, length);
+		}
+	}
+
+	void SetPartitionStartPosition(T partition, T pos) noexcept {
+		if (UseBlocks(partition)) {
+			blocks->SetPartitionStartPosition(partition, pos);
+		} else {
+			starts.SetPartitionStartPosition(partition, pos);
+		}
+	}
+
+	void InsertText(T partitionInsert, T delta) noexcept {
+		if (UseBlocks(partitionInsert)) {
+			blocks->InsertText(partitionInsert, delta);
+		} else {
+			starts.InsertText(partitionInsert, delta);
+		}
+	}
+
+	void RemovePartition(T partition) {
+		if (UseBlocks(partition)) {
+			blocks->RemovePartition(partition);
+		} else {
+			starts.RemovePartition(partition);
+		}
+	}
+
+	T PositionFromPartition(T partition) const noexcept {
+		return blocks ? blocks->PositionFromPartition(partition) : starts.PositionFromPartition(partition);
+	}
+
+	T PartitionFromPosition(T pos) const noexcept {
+		return blocks ? blocks->PartitionFromPosition(pos) : starts.PartitionFromPosition(pos);
+	}
+
+	void DeleteAll() {
+		blocks.reset();
+		starts.DeleteAll();
+		lastPartition = 0;
+		modifications = 0;
+		farModifications = 0;
+	}
+};
+
 }
@@ -14,12 +14,14 @@
 #include <utility>
 #include <string_view>
 #include <vector>
+#include <map>
 #include <forward_list>
 #include <optional>
 #include <algorithm>
 #include <memory>
 
 #include "ScintillaTypes.h"
+#include "ScintillaStructures.h"
 
 #include "Debugging.h"
 #include "Geometry.h"
@@ -28,6 +30,7 @@
 #include "Position.h"
 #include "SplitVector.h"
 #include "Partitioning.h"
+#include "RunStyles.h"
 #include "CellBuffer.h"
 #include "PerLine.h"
 
@@ -90,23 +93,64 @@ void MarkerHandleSet::CombineWith(MarkerHandleSet *other) noexcept {
 	mhList.splice_after(mhList.before_begin(), other->mhList);
 }
 
+size_t MarkerHandleSet::MemoryUsage() const noexcept {
+	// each node of forward_list holds a next pointer and the value
+	const size_t count = std::distance(mhList.begin(), mhList.end());
+	return sizeof(MarkerHandleSet) + count*(sizeof(void *) + sizeof(MarkerHandleNumber));
+}
+
 void LineMarkers::Init() {
 	markers.DeleteAll();
+	markedLines.DeleteAll();
+}
+
+void LineMarkers::Allocate(Sci::Line lines) {
+	if (!markers.Length()) {
+		// No existing markers so allocate one element per line
+		markers.InsertEmpty(0, lines);
+		markedLines.DeleteAll();
+		markedLines.InsertText(0, lines + 1);
+	}
+}
+
+void LineMarkers::MarkLine(Sci::Line line) {
+	const Sci::Line partition = markedLines.PartitionFromPosition(line + 1);
+	if (markedLines.PositionFromPartition(partition) != line + 1) {
+		markedLines.InsertPartition(partition + 1, line + 1);
+	}
+}
+
+void LineMarkers::UnmarkLine(Sci::Line line) {
+	const Sci::Line partition = markedLines.PartitionFromPosition(line + 1);
+	if (partition != 0 && markedLines.PositionFromPartition(partition) == line + 1) {
+		markedLines.RemovePartition(partition);
+	}
 }
 
 bool LineMarkers::IsActive() const noexcept {
 	return markers.Length() != 0;
 }
 
+size_t LineMarkers::MemoryUsage() const noexcept {
+	size_t usage = markers.MemoryUsage() + markedLines.MemoryUsage();
+	const Sci::Line partitions = markedLines.Partitions();
+	for (Sci::Line partition = 1; partition < partitions; partition++) {
+		usage += markers[markedLines.PositionFromPartition(partition) - 1]->MemoryUsage();
+	}
+	return usage;
+}
+
 void LineMarkers::InsertLine(Sci::Line line) {
 	if (markers.Length()) {
 		markers.Insert(line, nullptr);
+		markedLines.InsertText(markedLines.PartitionFromPosition(line), 1);
 	}
 }
 
 void LineMarkers::InsertLines(Sci::Line line, Sci::Line lines) {
 	if (markers.Length()) {
 		markers.InsertEmpty(line, lines);
+		markedLines.InsertText(markedLines.PartitionFromPosition(line), lines);
 	}
 }
 
@@ -115,14 +159,21 @@ void LineMarkers::RemoveLine(Sci::Line line) {
 	if (markers.Length()) {
 		if (line > 0) {
 			MergeMarkers(line - 1);
+		} else if (markers[line]) {
+			// deleted element is left in gap without destruction
+			markers[line].reset();
+			UnmarkLine(line);
 		}
 		markers.Delete(line);
+		markedLines.InsertText(markedLines.PartitionFromPosition(line + 1), -1);
 	}
 }
 
 Sci::Line LineMarkers::LineFromHandle(int markerHandle) const noexcept {
-	for (Sci::Line line = 0; line < markers.Length(); line++) {
-		if (markers[line] && markers[line]->Contains(markerHandle)) {
+	const Sci::Line partitions = markedLines.Partitions();
+	for (Sci::Line partition = 1; partition < partitions; partition++) {
+		const Sci::Line line = markedLines.PositionFromPartition(partition) - 1;
+		if (markers[line]->Contains(markerHandle)) {
 			return line;
 		}
 	}
@@ -151,6 +202,8 @@ void LineMarkers::MergeMarkers(Sci::Line line) {
 			markers[line] = std::make_unique<MarkerHandleSet>();
 		markers[line]->CombineWith(markers[line + 1].get());
 		markers[line + 1].reset();
+		UnmarkLine(line + 1);
+		MarkLine(line);
 	}
 }
 
@@ -164,23 +217,34 @@ MarkerMask LineMarkers::MarkValue(Sci::Line line) const noexcept {
 Sci::Line LineMarkers::MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept {
 	if (lineStart < 0)
 		lineStart = 0;
-	const Sci::Line length = markers.Length();
-	for (Sci::Line iLine = lineStart; iLine < length; iLine++) {
-		const MarkerHandleSet *onLine = markers[iLine].get();
-		if (onLine && ((onLine->MarkValue() & mask) != 0))
-			return iLine;
+	// first marked line not before lineStart
+	const Sci::Line partitions = markedLines.Partitions();
+	for (Sci::Line partition = markedLines.PartitionFromPosition(lineStart) + 1; partition < partitions; partition++) {
+		const Sci::Line line = markedLines.PositionFromPartition(partition) - 1;
+		if ((markers[line]->MarkValue() & mask) != 0)
+			return line;
 	}
 	return -1;
 }
 
-int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
-	if (!markers.Length()) {
-		// No existing markers so allocate one element per line
-		markers.InsertEmpty(0, lines);
+Sci::Line LineMarkers::MarkerPrevious(Sci::Line lineStart, MarkerMask mask) const noexcept {
+	if (lineStart < 0)
+		return -1;
+	// last marked line not after lineStart
+	for (Sci::Line partition = markedLines.PartitionFromPosition(lineStart + 1); partition > 0; partition--) {
+		const Sci::Line line = markedLines.PositionFromPartition(partition) - 1;
+		if ((markers[line]->MarkValue() & mask) != 0)
+			return line;
 	}
+	return -1;
+}
+
+int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
+	Allocate(lines);
 	if (!markers[line]) {
 		// Need new structure to hold marker handle
 		markers[line] = std::make_unique<MarkerHandleSet>();
+		MarkLine(line);
 	}
 
 	handleCurrent++;
@@ -188,48 +252,219 @@ int LineMarkers::AddMark(Sci::Line line, int markerNum, Sci::Line lines) {
 	return handleCurrent;
 }
 
+// lineList is sorted and terminated by negative line, lines already have the marker are skipped.
+Sci::Line LineMarkers::AddMarkLines(const Sci::Line *lineList, int markerNum, Sci::Line lines) {
+	Allocate(lines);
+	const MarkerMask mask = 1U << markerNum;
+	Sci::Line count = 0;
+	Sci::Line prev = -1;
+	for (; *lineList >= 0; lineList++) {
+		const Sci::Line line = *lineList;
+		if (line == prev || line >= lines) {
+			continue;
+		}
+		prev = line;
+		std::unique_ptr<MarkerHandleSet> &onLine = markers[line];
+		if (!onLine) {
+			onLine = std::make_unique<MarkerHandleSet>();
+			MarkLine(line);
+		} else if (onLine->MarkValue() & mask) {
+			continue;
+		}
+		handleCurrent++;
+		onLine->InsertHandle(handleCurrent, markerNum);
+		count++;
+	}
+	return count;
+}
+
 bool LineMarkers::DeleteMark(Sci::Line line, int markerNum, bool all) {
 	bool someChanges = false;
 	if (IsValidIndex(line, markers.Length()) && markers[line]) {
 		if (markerNum < 0) {
 			someChanges = true;
 			markers[line].reset();
+			UnmarkLine(line);
 		} else {
 			someChanges = markers[line]->RemoveNumber(markerNum, all);
 			if (markers[line]->Empty()) {
 				markers[line].reset();
+				UnmarkLine(line);
 			}
 		}
 	}
 	return someChanges;
 }
 
+bool LineMarkers::DeleteAllMarks(int markerNum) {
+	bool someChanges = false;
+	// backward as deleting mark may remove current partition
+	for (Sci::Line partition = markedLines.Partitions() - 1; partition > 0; partition--) {
+		if (DeleteMark(markedLines.PositionFromPartition(partition) - 1, markerNum, true)) {
+			someChanges = true;
+		}
+	}
+	return someChanges;
+}
+
 void LineMarkers::DeleteMarkFromHandle(int markerHandle) {
 	const Sci::Line line = LineFromHandle(markerHandle);
 	if (line >= 0) {
 		markers[line]->RemoveHandle(markerHandle);
 		if (markers[line]->Empty()) {
 			markers[line].reset();
+			UnmarkLine(line);
 		}
 	}
 }
 
+void FoldLevelRange::InsertLines(Sci::Line line, Sci::Line lines) noexcept {
+	// inserted lines copy level of the line at insertion point
+	if (start >= line) {
+		start += lines;
+	}
+	if (end > line) {
+		end += lines;
+	}
+}
+
+void FoldLevelRange::RemoveLine(Sci::Line line, bool headerMerged) noexcept {
+	if (valid) {
+		if (line == start || (headerMerged && Contains(line - 1))) {
+			valid = false;
+			return;
+		}
+		if (start > line) {
+			--start;
+		}
+		if (end > line) {
+			--end;
+		}
+	}
+}
+
+// runs use about three times memory of one value for each line, plus gap in their buffers
+void LineValues::CheckCompact() {
+	if (runs.Runs() > runs.Length() / 4) {
+		const Sci::Line length = runs.Length();
+		values.ReAllocate(length);
+		Sci::Line line = 0;
+		while (line < length) {
+			const Sci::Line end = runs.EndRun(line);
+			values.InsertValue(line, end - line, runs.ValueAt(line));
+			line = end;
+		}
+		runs.DeleteAll();
+		compact = false;
+		InvalidateCache();
+	}
+}
+
+Sci::Line LineValues::Length() const noexcept {
+	return compact ? runs.Length() : values.Length();
+}
+
+int LineValues::ValueAt(Sci::Line line) const noexcept {
+	if (!compact) {
+		return values[line];
+	}
+	if (line < cacheStart || line >= cacheEnd) {
+		cacheStart = runs.StartRun(line);
+		cacheEnd = runs.EndRun(line);
+		cacheValue = runs.ValueAt(line);
+	}
+	return cacheValue;
+}
+
+int LineValues::ReplaceValueAt(Sci::Line line, int value) {
+	if (!compact) {
+		return values.ReplaceValueAt(line, value);
+	}
+	const int prev = ValueAt(line);
+	if (prev != value) {
+		runs.SetValueAt(line, value);
+		InvalidateCache();
+		CheckCompact();
+	}
+	return prev;
+}
+
+void LineValues::InsertValue(Sci::Line line, Sci::Line insertLength, int value) {
+	if (insertLength <= 0) {
+		return;
+	}
+	if (!compact) {
+		values.InsertValue(line, insertLength, value);
+		return;
+	}
+	runs.InsertSpace(line, insertLength);
+	runs.FillRange(line, value, insertLength);
+	InvalidateCache();
+	CheckCompact();
+}
+
+void LineValues::Delete(Sci::Line line) {
+	if (!compact) {
+		values.Delete(line);
+		return;
+	}
+	runs.DeleteRange(line, 1);
+	InvalidateCache();
+}
+
+void LineValues::DeleteAll() {
+	values.DeleteAll();
+	runs.DeleteAll();
+	compact = true;
+	InvalidateCache();
+}
+
+void LineValues::EnsureLength(Sci::Line wantedLength) {
+	const Sci::Line length = Length();
+	if (wantedLength > length) {
+		InsertValue(length, wantedLength - length, 0);
+	}
+}
+
+size_t LineValues::MemoryUsage() const noexcept {
+	return values.MemoryUsage() + runs.MemoryUsage();
+}
+
+void LineLevels::InvalidateRanges() noexcept {
+	parentRange.Invalidate();
+	changeableRange.Invalidate();
+	childRange.Invalidate();
+}
+
+void LineLevels::InsertRanges(Sci::Line line, Sci::Line lines) noexcept {
+	parentRange.InsertLines(line, lines);
+	changeableRange.InsertLines(line, lines);
+	childRange.InsertLines(line, lines);
+}
+
 void LineLevels::Init() {
 	levels.DeleteAll();
+	InvalidateRanges();
 }
 
 bool LineLevels::IsActive() const noexcept {
 	return levels.Length() != 0;
 }
 
+size_t LineLevels::MemoryUsage() const noexcept {
+	return levels.MemoryUsage();
+}
+
 void LineLevels::InsertLine(Sci::Line line) {
+	InsertRanges(line, 1);
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
-		levels.Insert(line, level);
+		levels.InsertValue(line, 1, level);
 	}
 }
 
 void LineLevels::InsertLines(Sci::Line line, Sci::Line lines) {
+	InsertRanges(line, lines);
 	if (levels.Length()) {
 		const int level = (line < levels.Length()) ? levels[line] : static_cast<int>(Scintilla::FoldLevel::Base);
 		levels.InsertValue(line, lines, level);
@@ -237,24 +472,33 @@ void LineLevels::InsertLines(Sci::Line line, Sci::Line lines) {
 }
 
 void LineLevels::RemoveLine(Sci::Line line) {
-	if (levels.Length()) {
+	if (levels.Length() == 0) {
+		parentRange.RemoveLine(line, false);
+		changeableRange.RemoveLine(line, false);
+		childRange.RemoveLine(line, false);
+	} else {
 		// Move up following lines but merge header flag from this line
 		// to line before to avoid a temporary disappearance causing expansion.
 		const int firstHeader = levels[line] & static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
+		parentRange.RemoveLine(line, firstHeader != 0);
+		changeableRange.RemoveLine(line, firstHeader != 0);
+		childRange.RemoveLine(line, firstHeader != 0);
 		levels.Delete(line);
 		if (line == levels.Length() - 1) // Last line loses the header flag
-			levels[line - 1] &= ~static_cast<int>(Scintilla::FoldLevel::HeaderFlag);
+			levels.ReplaceValueAt(line - 1, levels[line - 1] & ~static_cast<int>(Scintilla::FoldLevel::HeaderFlag));
 		else if (line > 0)
-			levels[line - 1] |= firstHeader;
+			levels.ReplaceValueAt(line - 1, levels[line - 1] | firstHeader);
 	}
 }
 
 void LineLevels::ExpandLevels(Sci::Line sizeNew) {
+	InvalidateRanges();
 	levels.InsertValue(levels.Length(), sizeNew - levels.Length(), static_cast<int>(Scintilla::FoldLevel::Base));
 }
 
 void LineLevels::ClearLevels() {
 	levels.DeleteAll();
+	InvalidateRanges();
 }
 
 int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
@@ -262,7 +506,13 @@ int LineLevels::SetLevel(Sci::Line line, int level, Sci::Line lines) {
 		if (!levels.Length()) {
 			ExpandLevels(lines + 1);
 		}
-		return levels.ReplaceValueAt(line, level);
+		const int prev = levels.ReplaceValueAt(line, level);
+		if (prev != level) {
+			parentRange.LevelChanged(line);
+			changeableRange.LevelChanged(line);
+			childRange.LevelChanged(line);
+		}
+		return prev;
 	}
 	return level;
 }
@@ -288,12 +538,21 @@ Sci::Line LineLevels::GetFoldParent(Sci::Line line) const noexcept {
 		if (level <= FoldLevel::Base) {
 			return -1;
 		}
-		for (Sci::Line lineLook = line - 1; lineLook >= 0; lineLook--) {
+		Sci::Line lineLook = line - 1;
+		while (lineLook >= 0) {
+			if (parentRange.Contains(lineLook) && level <= parentRange.level) {
+				// skip lines checked by previous query
+				lineLook = parentRange.start;
+				continue;
+			}
 			const FoldLevel levelTry = GetFoldLevel(lineLook);
 			if (LevelIsHeader(levelTry) && LevelNumberPart(levelTry) < level) {
-				return lineLook;
+				break;
 			}
+			lineLook--;
 		}
+		parentRange.Set(lineLook, line, level);
+		return lineLook;
 	}
 	return -1;
 }
@@ -306,10 +565,14 @@ bool LineState::IsActive() const noexcept {
 	return lineStates.Length() != 0;
 }
 
+size_t LineState::MemoryUsage() const noexcept {
+	return lineStates.MemoryUsage();
+}
+
 void LineState::InsertLine(Sci::Line line) {
 	if (lineStates.Length()) {
 		const int val = (line < lineStates.Length()) ? lineStates[line] : 0;
-		lineStates.Insert(line, val);
+		lineStates.InsertValue(line, 1, val);
 	}
 }
 
@@ -358,9 +621,34 @@ inline size_t NumberLines(std::string_view sv) {
 	return std::count(sv.begin(), sv.end(), '\n') + 1;
 }
 
-std::unique_ptr<char[]> AllocateAnnotation(size_t length, int style) {
-	const size_t len = sizeof(AnnotationHeader) + length + ((style == IndividualStyles) ? length : 0);
-	return std::make_unique<char[]>(len);
+constexpr size_t AnnotationSize(size_t length, int style) noexcept {
+	return sizeof(AnnotationHeader) + length + ((style == IndividualStyles) ? length : 0);
+}
+
+std::shared_ptr<char[]> AllocateAnnotation(size_t length, int style) {
+	return std::shared_ptr<char[]>(new char[AnnotationSize(length, style)]());
+}
+
+std::shared_ptr<char[]> AllocateText(std::string_view text, int style) {
+	std::shared_ptr<char[]> annotation = AllocateAnnotation(text.length(), style);
+	char *pa = annotation.get();
+	AnnotationHeader *pah = reinterpret_cast<AnnotationHeader *>(pa);
+	pah->style = static_cast<short>(style);
+	pah->length = static_cast<int>(text.length());
+	pah->lines = static_cast<short>(NumberLines(text));
+	memcpy(pa + sizeof(AnnotationHeader), text.data(), text.length());
+	return annotation;
+}
+
+// copy allocation shared with other lines before changing it
+void MakeUnique(SharedAnnotation &annotation) {
+	if (annotation.use_count() > 1) {
+		const AnnotationHeader *pah = reinterpret_cast<const AnnotationHeader *>(annotation.get());
+		const size_t len = AnnotationSize(pah->length, pah->style);
+		std::shared_ptr<char[]> allocation(new char[len]);
+		memcpy(allocation.get(), annotation.get(), len);
+		annotation = std::move(allocation);
+	}
 }
 
 }
@@ -377,10 +665,22 @@ bool LineAnnotation::IsActive() const noexcept {
 	return annotations.Length() != 0;
 }
 
+size_t LineAnnotation::MemoryUsage() const noexcept {
+	size_t usage = annotations.MemoryUsage();
+	for (Sci::Line line = 0; line < annotations.Length(); line++) {
+		if (annotations[line]) {
+			// shared allocation is divided among the lines
+			const AnnotationHeader *pah = reinterpret_cast<const AnnotationHeader *>(annotations[line].get());
+			usage += AnnotationSize(pah->length, pah->style) / annotations[line].use_count();
+		}
+	}
+	return usage;
+}
+
 void LineAnnotation::InsertLine(Sci::Line line) {
 	if (annotations.Length()) {
 		annotations.EnsureLength(line);
-		annotations.Insert(line, std::unique_ptr<char[]>());
+		annotations.Insert(line, SharedAnnotation());
 	}
 }
 
@@ -430,16 +730,7 @@ const unsigned char *LineAnnotation::Styles(Sci::Line line) const noexcept {
 void LineAnnotation::SetText(Sci::Line line, const char *text) {
 	if (text && (line >= 0)) {
 		annotations.EnsureLength(line + 1);
-		const int style = Style(line);
-		const size_t length = strlen(text);
-		annotations[line] = AllocateAnnotation(length, style);
-		char *pa = annotations[line].get();
-		assert(pa);
-		AnnotationHeader *pah = reinterpret_cast<AnnotationHeader *>(pa);
-		pah->style = static_cast<short>(style);
-		pah->length = static_cast<int>(length);
-		pah->lines = static_cast<short>(NumberLines(std::string_view(text, length)));
-		memcpy(pa + sizeof(AnnotationHeader), text, length);
+		annotations[line] = AllocateText(text, Style(line));
 	} else {
 		if (IsValidIndex(line, annotations.Length()) && annotations[line]) {
 			annotations[line].reset();
@@ -455,6 +746,8 @@ void LineAnnotation::SetStyle(Sci::Line line, int style) {
 	annotations.EnsureLength(line + 1);
 	if (!annotations[line]) {
 		annotations[line] = AllocateAnnotation(0, style);
+	} else {
+		MakeUnique(annotations[line]);
 	}
 	reinterpret_cast<AnnotationHeader *>(annotations[line].get())->style = static_cast<short>(style);
 }
@@ -467,12 +760,14 @@ void LineAnnotation::SetStyles(Sci::Line line, const unsigned char *styles) {
 		} else {
 			const AnnotationHeader *pahSource = reinterpret_cast<AnnotationHeader *>(annotations[line].get());
 			if (pahSource->style != IndividualStyles) {
-				std::unique_ptr<char[]> allocation = AllocateAnnotation(pahSource->length, IndividualStyles);
+				std::shared_ptr<char[]> allocation = AllocateAnnotation(pahSource->length, IndividualStyles);
 				AnnotationHeader *pahAlloc = reinterpret_cast<AnnotationHeader *>(allocation.get());
 				pahAlloc->length = pahSource->length;
 				pahAlloc->lines = pahSource->lines;
 				memcpy(allocation.get() + sizeof(AnnotationHeader), annotations[line].get() + sizeof(AnnotationHeader), pahSource->length);
 				annotations[line] = std::move(allocation);
+			} else {
+				MakeUnique(annotations[line]);
 			}
 		}
 		AnnotationHeader *pah = reinterpret_cast<AnnotationHeader *>(annotations[line].get());
@@ -481,6 +776,41 @@ void LineAnnotation::SetStyles(Sci::Line line, const unsigned char *styles) {
 	}
 }
 
+// returns change of annotation lines
+Sci::Line LineAnnotation::SetBulk(const AnnotationRecord *records, size_t count, Sci::Line linesTotal) {
+	Sci::Line lineMax = -1;
+	for (size_t index = 0; index < count; index++) {
+		if (records[index].text && IsValidIndex(records[index].line, linesTotal)) {
+			lineMax = std::max(lineMax, records[index].line);
+		}
+	}
+	annotations.EnsureLength(lineMax + 1);
+	const Sci::Line lineLimit = std::min(linesTotal, annotations.Length());
+
+	// duplicate messages only allocated once, text is owned by caller during the call
+	std::map<std::pair<int, std::string_view>, std::shared_ptr<char[]>> interned;
+	Sci::Line linesAdded = 0;
+	const AnnotationRecord * const end = records + count;
+	for (; records < end; ++records) {
+		const Sci::Line line = records->line;
+		if (!IsValidIndex(line, lineLimit)) {
+			continue;
+		}
+		linesAdded -= Lines(line);
+		if (records->text) {
+			std::shared_ptr<char[]> &annotation = interned[{records->style, records->text}];
+			if (!annotation) {
+				annotation = AllocateText(records->text, records->style);
+			}
+			annotations[line] = annotation;
+			linesAdded += Lines(line);
+		} else {
+			annotations[line].reset();
+		}
+	}
+	return linesAdded;
+}
+
 int LineAnnotation::Length(Sci::Line line) const noexcept {
 	if (IsValidIndex(line, annotations.Length()) && annotations[line])
 		return reinterpret_cast<AnnotationHeader *>(annotations[line].get())->length;
@@ -503,6 +833,16 @@ bool LineTabstops::IsActive() const noexcept {
 	return tabstops.Length() != 0;
 }
 
+size_t LineTabstops::MemoryUsage() const noexcept {
+	size_t usage = tabstops.MemoryUsage();
+	for (Sci::Line line = 0; line < tabstops.Length(); line++) {
+		if (tabstops[line]) {
+			usage += sizeof(TabstopList) + tabstops[line]->capacity()*sizeof(int);
+		}
+	}
+	return usage;
+}
+
 void LineTabstops::InsertLine(Sci::Line line) {
 	if (tabstops.Length()) {
 		tabstops.EnsureLength(line);
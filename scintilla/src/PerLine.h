@@ -33,13 +33,20 @@ public:
 	void RemoveHandle(int handle);
 	bool RemoveNumber(int markerNum, bool all);
 	void CombineWith(MarkerHandleSet *other) noexcept;
+	size_t MemoryUsage() const noexcept;
 	MarkerHandleNumber const *GetMarkerHandleNumber(int which) const noexcept;
 };
 
 class LineMarkers final : public PerLine {
 	SplitVector<std::unique_ptr<MarkerHandleSet>> markers;
+	/// Partition starts (except first) are line + 1 of lines with markers,
+	/// so sparse markers can be found without scanning every line.
+	Partitioning<Sci::Line> markedLines;
 	/// Handles are allocated sequentially and should never have to be reused as 32 bit ints are very big.
 	int handleCurrent;
+	void Allocate(Sci::Line lines);
+	void MarkLine(Sci::Line line);
+	void UnmarkLine(Sci::Line line);
 public:
 	LineMarkers() noexcept : handleCurrent(0) {}
 	void Init() override;
@@ -47,21 +54,98 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	MarkerMask MarkValue(Sci::Line line) const noexcept;
 	Sci::Line MarkerNext(Sci::Line lineStart, MarkerMask mask) const noexcept;
+	Sci::Line MarkerPrevious(Sci::Line lineStart, MarkerMask mask) const noexcept;
+	Sci::Line MarkedLineCount() const noexcept {
+		return markedLines.Partitions() - 1;
+	}
 	int AddMark(Sci::Line line, int markerNum, Sci::Line lines);
+	Sci::Line AddMarkLines(const Sci::Line *lineList, int markerNum, Sci::Line lines);
 	void MergeMarkers(Sci::Line line);
 	bool DeleteMark(Sci::Line line, int markerNum, bool all);
+	bool DeleteAllMarks(int markerNum);
 	void DeleteMarkFromHandle(int markerHandle);
 	Sci::Line LineFromHandle(int markerHandle) const noexcept;
 	int HandleFromLine(Sci::Line line, int which) const noexcept;
 	int NumberFromLine(Sci::Line line, int which) const noexcept;
 };
 
+/**
+ * Lines between start and end (both exclusive) known to satisfy a fold level query for level.
+ * Kept valid while lines outside the range are changed, and moved with inserted or removed lines.
+ */
+struct FoldLevelRange {
+	Sci::Line start = -1;
+	Sci::Line end = -1;
+	Scintilla::FoldLevel level = Scintilla::FoldLevel::None;
+	bool valid = false;
+
+	void Set(Sci::Line start_, Sci::Line end_, Scintilla::FoldLevel level_) noexcept {
+		start = start_;
+		end = end_;
+		level = level_;
+		valid = true;
+	}
+	void Invalidate() noexcept {
+		valid = false;
+	}
+	bool Contains(Sci::Line line) const noexcept {
+		return valid && start < line && line < end;
+	}
+	void LevelChanged(Sci::Line line) noexcept {
+		if (Contains(line)) {
+			valid = false;
+		}
+	}
+	void InsertLines(Sci::Line line, Sci::Line lines) noexcept;
+	void RemoveLine(Sci::Line line, bool headerMerged) noexcept;
+};
+
+/**
+ * Value for each line, stored as runs of lines with same value while most adjacent lines
+ * share their value, and expanded to one value for each line once runs would use more memory.
+ */
+class LineValues {
+	SplitVector<int> values;
+	RunStyles<Sci::Line, int> runs;
+	bool compact = true;
+	// run containing last looked up line, makes sequential access constant time
+	mutable Sci::Line cacheStart = 0;
+	mutable Sci::Line cacheEnd = 0;
+	mutable int cacheValue = 0;
+	void InvalidateCache() noexcept {
+		cacheStart = 0;
+		cacheEnd = 0;
+	}
+	void CheckCompact();
+public:
+	Sci::Line Length() const noexcept;
+	int ValueAt(Sci::Line line) const noexcept;
+	int operator[](Sci::Line line) const noexcept {
+		return ValueAt(line);
+	}
+	int ReplaceValueAt(Sci::Line line, int value);
+	void InsertValue(Sci::Line line, Sci::Line insertLength, int value);
+	void Delete(Sci::Line line);
+	void DeleteAll();
+	void EnsureLength(Sci::Line wantedLength);
+	size_t MemoryUsage() const noexcept;
+};
+
 class LineLevels final : public PerLine {
-	SplitVector<int> levels;
+	LineValues levels;
+	/// no fold header with level number less than level
+	mutable FoldLevelRange parentRange;
+	/// used by Document::GetHighlightDelimiters(): no whitespace line or level number greater than level
+	FoldLevelRange changeableRange;
+	/// used by Document::GetLastChild(): subordinate lines of the header at start with level
+	FoldLevelRange childRange;
 	Scintilla::FoldLevel GetFoldLevel(Sci::Line line) const noexcept;
+	void InvalidateRanges() noexcept;
+	void InsertRanges(Sci::Line line, Sci::Line lines) noexcept;
 public:
 	LineLevels() noexcept = default;
 	void Init() override;
@@ -69,16 +153,23 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	void ExpandLevels(Sci::Line sizeNew = -1);
 	void ClearLevels();
 	int SetLevel(Sci::Line line, int level, Sci::Line lines);
 	int GetLevel(Sci::Line line) const noexcept;
 	Sci::Line GetFoldParent(Sci::Line line) const noexcept;
+	FoldLevelRange &ChangeableRange() noexcept {
+		return changeableRange;
+	}
+	FoldLevelRange &ChildRange() noexcept {
+		return childRange;
+	}
 };
 
 class LineState final : public PerLine {
-	SplitVector<int> lineStates;
+	LineValues lineStates;
 public:
 	LineState() noexcept = default;
 	void Init() override;
@@ -86,13 +177,43 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	int SetLineState(Sci::Line line, int state, Sci::Line lines);
 	int GetLineState(Sci::Line line) const noexcept;
 };
 
+// Lines with same text and style set by SetBulk() share one allocation,
+// which is copied when style of any such line is changed.
+// The handle is move only as SplitVector requires, elements inside the gap are not destroyed.
+class SharedAnnotation {
+	std::shared_ptr<char[]> allocation;
+public:
+	SharedAnnotation() noexcept = default;
+	SharedAnnotation(std::shared_ptr<char[]> allocation_) noexcept : allocation{std::move(allocation_)} {}
+	// Deleted so SharedAnnotation objects can not be copied.
+	SharedAnnotation(const SharedAnnotation &) = delete;
+	SharedAnnotation &operator=(const SharedAnnotation &) = delete;
+	SharedAnnotation(SharedAnnotation &&) noexcept = default;
+	SharedAnnotation &operator=(SharedAnnotation &&) noexcept = default;
+	~SharedAnnotation() = default;
+
+	char *get() const noexcept {
+		return allocation.get();
+	}
+	explicit operator bool() const noexcept {
+		return static_cast<bool>(allocation);
+	}
+	long use_count() const noexcept {
+		return allocation.use_count();
+	}
+	void reset() noexcept {
+		allocation.reset();
+	}
+};
+
 class LineAnnotation : public PerLine {
-	SplitVector<std::unique_ptr<char[]>> annotations;
+	SplitVector<SharedAnnotation> annotations;
 public:
 	LineAnnotation() noexcept = default;
 
@@ -102,6 +223,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	bool MultipleStyles(Sci::Line line) const noexcept;
 	int Style(Sci::Line line) const noexcept;
@@ -111,6 +233,7 @@ public:
 	void ClearAll();
 	void SetStyle(Sci::Line line, int style);
 	void SetStyles(Sci::Line line, const unsigned char *styles);
+	Sci::Line SetBulk(const Scintilla::AnnotationRecord *records, size_t count, Sci::Line linesTotal);
 	int Length(Sci::Line line) const noexcept;
 	int Lines(Sci::Line line) const noexcept;
 };
@@ -126,6 +249,7 @@ public:
 	void InsertLine(Sci::Line line) override;
 	void InsertLines(Sci::Line line, Sci::Line lines) override;
 	void RemoveLine(Sci::Line line) override;
+	size_t MemoryUsage() const noexcept override;
 
 	bool ClearTabstops(Sci::Line line) noexcept;
 	bool AddTabstop(Sci::Line line, int x);
@@ -0,0 +1,376 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Scintilla::Internal {
+
+/// Piece table used to hold text of huge documents.
+/// Text is a sequence of pieces, each piece is a run of characters inside one block.
+/// Characters inside a block are never modified once referenced by a piece, the
+/// first insertion becomes the original block, later insertions are appended to the add block.
+/// Insertion and deletion cost O(log pieces) instead of moving the gap over the document.
+/// Blocks are shared with snapshots, so characters referenced by them stay valid.
+class PieceTable {
+	struct Block {
+		std::shared_ptr<char[]> data;
+		size_t size;
+	};
+	/// Piece that contains last accessed position, data is relative to document start.
+	struct PieceCache {
+		Sci::Position start;
+		Sci::Position end;
+		const char *data;
+	};
+
+	// over allocation to simplify SplitView usage
+	static constexpr size_t sentinel = sizeof(int);
+	static constexpr size_t minBlockSize = 1024*1024;
+
+	Partitioning<Sci::Position> starts;
+	SplitVector<const char *> pieces;
+	std::vector<Block> blocks;
+	char *addData = nullptr;
+	size_t addSize = 0;
+	size_t addUsed = 0;
+	mutable PieceCache cache {};
+	char emptyText[sentinel] {};
+
+	char *AllocateBlock(size_t size) {
+		Block block { std::shared_ptr<char[]>(new char[size + sentinel]), size };
+		char * const data = block.data.get();
+		memset(data + size, 0, sentinel);
+		blocks.push_back(std::move(block));
+		return data;
+	}
+
+	char *AddSpace(size_t insertLength) {
+		if (addSize - addUsed < insertLength) {
+			addSize = std::max(insertLength, minBlockSize);
+			addData = AllocateBlock(addSize);
+			addUsed = 0;
+		}
+		char * const data = addData + addUsed;
+		addUsed += insertLength;
+		return data;
+	}
+
+	/// Whether the sentinel after end can be written.
+	bool IsBlockEnd(const char *end) const noexcept {
+		if (end == addData + addUsed) {
+			return true;
+		}
+		for (const Block &block : blocks) {
+			if (block.data.get() + block.size == end) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Locate(Sci::Position position) const noexcept {
+		const Sci::Position piece = starts.PartitionFromPosition(position);
+		cache.start = starts.PositionFromPartition(piece);
+		cache.end = starts.PositionFromPartition(piece + 1);
+		cache.data = pieces[piece] - cache.start;
+	}
+
+	/// Split the piece at position, return index of the piece starts at position.
+	Sci::Position SplitAt(Sci::Position position) {
+		if (position >= Length()) {
+			return Pieces();
+		}
+		const Sci::Position piece = starts.PartitionFromPosition(position);
+		const Sci::Position start = starts.PositionFromPartition(piece);
+		if (position == start) {
+			return piece;
+		}
+		starts.InsertPartition(piece + 1, position);
+		pieces.Insert(piece + 1, pieces[piece] + (position - start));
+		return piece + 1;
+	}
+
+	/// Copy pieces in [first, last) into a new block to make them contiguous.
+	const char *Coalesce(Sci::Position first, Sci::Position last) {
+		if (last - first > 1) {
+			const Sci::Position start = starts.PositionFromPartition(first);
+			const Sci::Position end = starts.PositionFromPartition(last);
+			char * const data = AllocateBlock(end - start);
+			GetRange(data, start, end - start);
+			for (Sci::Position piece = last - 1; piece > first; piece--) {
+				starts.RemovePartition(piece);
+			}
+			pieces.DeleteRange(first + 1, last - first - 1);
+			pieces[first] = data;
+			cache = {};
+		}
+		return pieces[first];
+	}
+
+	/// Ensure last piece is followed by writable sentinel.
+	void EnsureTail() {
+		const Sci::Position piece = Pieces() - 1;
+		const Sci::Position start = starts.PositionFromPartition(piece);
+		const size_t length = Length() - start;
+		if (!IsBlockEnd(pieces[piece] + length)) {
+			char * const data = AllocateBlock(length);
+			memcpy(data, pieces[piece], length);
+			pieces[piece] = data;
+			cache = {};
+		}
+	}
+
+	/// Free blocks no longer referenced after pieces merged.
+	void ReleaseBlocks() {
+		const Sci::Position count = Pieces();
+		blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [this, count](const Block &block) noexcept {
+			const char * const data = block.data.get();
+			if (data == addData) {
+				return false;
+			}
+			for (Sci::Position piece = 0; piece < count; piece++) {
+				const char * const ptr = pieces[piece];
+				if (ptr >= data && ptr < data + block.size) {
+					return false;
+				}
+			}
+			return true;
+		}), blocks.end());
+	}
+
+public:
+	PieceTable() = default;
+
+	/// Retrieve the length of the text.
+	Sci::Position Length() const noexcept {
+		return starts.Length();
+	}
+
+	Sci::Position Pieces() const noexcept {
+		return pieces.Length();
+	}
+
+	Sci::Position PieceStart(Sci::Position piece) const noexcept {
+		return starts.PositionFromPartition(piece);
+	}
+
+	const char *PiecePointer(Sci::Position piece) const noexcept {
+		return (piece < Pieces()) ? pieces[piece] : emptyText;
+	}
+
+	/// Return a pointer to characters from position to the end of its piece,
+	/// segmentLength is set to the length of that part inside the range.
+	const char *SegmentPointer(Sci::Position position, Sci::Position rangeLength, Sci::Position &segmentLength) const noexcept {
+		if (Pieces() == 0) {
+			segmentLength = 0;
+			return emptyText;
+		}
+		const Sci::Position piece = starts.PartitionFromPosition(position);
+		const Sci::Position start = starts.PositionFromPartition(piece);
+		segmentLength = std::min(rangeLength, starts.PositionFromPartition(piece + 1) - position);
+		return pieces[piece] + (position - start);
+	}
+
+	/// Return a pointer indexed by document position for the piece containing position.
+	const char *PieceText(Sci::Position position, Sci::Position &start, Sci::Position &end) const noexcept {
+		if (position < cache.start || position >= cache.end) {
+			Locate(position);
+		}
+		start = cache.start;
+		end = cache.end;
+		return cache.data;
+	}
+
+	size_t MemoryUsage() const noexcept {
+		size_t usage = starts.MemoryUsage() + pieces.MemoryUsage() + blocks.capacity()*sizeof(Block);
+		for (const Block &block : blocks) {
+			usage += block.size + sentinel;
+		}
+		return usage;
+	}
+
+	/// Preallocate add block for following insertions, e.g. when loading a file.
+	void ReAllocate(Sci::Position newSize) {
+		if (newSize > Length()) {
+			const size_t insertLength = newSize - Length();
+			if (addSize - addUsed < insertLength) {
+				addSize = insertLength;
+				addData = AllocateBlock(addSize);
+				addUsed = 0;
+			}
+		}
+	}
+
+	/// Retrieving positions outside the range of the text returns 0.
+	char ValueAt(Sci::Position position) const noexcept {
+		if (position < cache.start || position >= cache.end) {
+			if (!IsValidIndex(position, Length())) {
+				return '\0';
+			}
+			Locate(position);
+		}
+		return cache.data[position];
+	}
+
+	void GetRange(char *buffer, Sci::Position position, Sci::Position retrieveLength) const noexcept {
+		Sci::Position piece = starts.PartitionFromPosition(position);
+		Sci::Position start = starts.PositionFromPartition(piece);
+		while (retrieveLength > 0) {
+			const Sci::Position end = starts.PositionFromPartition(piece + 1);
+			const Sci::Position lengthCopy = std::min(retrieveLength, end - position);
+			memcpy(buffer, pieces[piece] + (position - start), lengthCopy);
+			buffer += lengthCopy;
+			position += lengthCopy;
+			retrieveLength -= lengthCopy;
+			start = end;
+			piece++;
+		}
+	}
+
+	int CheckRange(const char *buffer, Sci::Position position, Sci::Position rangeLength) const noexcept {
+		int result = 0;
+		Sci::Position piece = starts.PartitionFromPosition(position);
+		Sci::Position start = starts.PositionFromPartition(piece);
+		while (rangeLength > 0) {
+			const Sci::Position end = starts.PositionFromPartition(piece + 1);
+			const Sci::Position lengthCheck = std::min(rangeLength, end - position);
+			// NOLINTNEXTLINE(bugprone-suspicious-string-compare)
+			result |= memcmp(buffer, pieces[piece] + (position - start), lengthCheck);
+			buffer += lengthCheck;
+			position += lengthCheck;
+			rangeLength -= lengthCheck;
+			start = end;
+			piece++;
+		}
+		return result;
+	}
+
+	void InsertFromArray(Sci::Position position, const char *s, Sci::Position insertLength) {
+		PLATFORM_ASSERT((position >= 0) && (position <= Length()));
+		if (insertLength <= 0 || !InRangeInclusive(position, Length())) {
+			return;
+		}
+
+		cache = {};
+		char * const data = AddSpace(insertLength);
+		memcpy(data, s, insertLength);
+		if (Pieces() == 0) {
+			starts.InsertText(0, insertLength);
+			pieces.Insert(0, data);
+			return;
+		}
+		if (position != 0) {
+			// typing after previous insertion only extends the piece
+			const Sci::Position piece = starts.PartitionFromPosition(position - 1);
+			const Sci::Position start = starts.PositionFromPartition(piece);
+			if (position == starts.PositionFromPartition(piece + 1) && pieces[piece] + (position - start) == data) {
+				starts.InsertText(piece, insertLength);
+				return;
+			}
+		}
+
+		const Sci::Position piece = SplitAt(position);
+		if (piece == Pieces()) {
+			starts.InsertText(piece - 1, insertLength);
+			starts.InsertPartition(piece, position);
+		} else {
+			starts.InsertText(piece, insertLength);
+			starts.InsertPartition(piece + 1, position + insertLength);
+		}
+		pieces.Insert(piece, data);
+	}
+
+	void DeleteRange(Sci::Position position, Sci::Position deleteLength) {
+		PLATFORM_ASSERT((position >= 0) && (position + deleteLength <= Length()));
+		if ((position == 0) && (deleteLength == Length())) {
+			// Full deallocation returns storage
+			DeleteAll();
+		} else if (position >= 0 && deleteLength > 0 && (position + deleteLength) <= Length()) {
+			cache = {};
+			const Sci::Position first = SplitAt(position);
+			const Sci::Position last = SplitAt(position + deleteLength);
+			// merge deleted pieces, then remove the empty piece
+			for (Sci::Position piece = last - 1; piece > first; piece--) {
+				starts.RemovePartition(piece);
+			}
+			starts.InsertText(first, -deleteLength);
+			starts.RemovePartition(first + 1);
+			pieces.DeleteRange(first, last - first);
+		}
+	}
+
+	void DeleteAll() {
+		starts.DeleteAll();
+		pieces.DeleteAll();
+		blocks.clear();
+		addData = nullptr;
+		addSize = 0;
+		addUsed = 0;
+		cache = {};
+	}
+
+	/// Merge all pieces and return a pointer to the first character.
+	/// Also ensures there is an empty character beyond logical end.
+	const char *BufferPointer() {
+		const Sci::Position count = Pieces();
+		if (count == 0) {
+			return emptyText;
+		}
+		Coalesce(0, count);
+		EnsureTail();
+		ReleaseBlocks();
+		char * const data = const_cast<char *>(pieces[0]);
+		memset(data + Length(), 0, sentinel);
+		return data;
+	}
+
+	/// Return a pointer to a range of characters, merging pieces if
+	/// needed to make that range contiguous.
+	const char *RangePointer(Sci::Position position, Sci::Position rangeLength) {
+		if (Pieces() == 0) {
+			return emptyText;
+		}
+		const Sci::Position piece = starts.PartitionFromPosition(position);
+		const Sci::Position start = starts.PositionFromPartition(piece);
+		if (position + rangeLength <= starts.PositionFromPartition(piece + 1)) {
+			return pieces[piece] + (position - start);
+		}
+		const Sci::Position last = starts.PartitionFromPosition(position + rangeLength - 1) + 1;
+		return Coalesce(piece, last) + (position - start);
+	}
+
+	/// Add references to all blocks so pieces copied by a snapshot stay valid.
+	void ShareBlocks(std::vector<std::shared_ptr<const char[]>> &shared) const {
+		shared.reserve(shared.size() + blocks.size());
+		for (const Block &block : blocks) {
+			shared.push_back(block.data);
+		}
+	}
+
+	/// Merge pieces into two segments for SplitView, copying least characters
+	/// like moving the gap of SplitVector.
+	void MergeForView() {
+		const Sci::Position count = Pieces();
+		if (count == 0) {
+			return;
+		}
+		if (count > 2) {
+			const Sci::Position length = Length();
+			Sci::Position split = 1;
+			Sci::Position best = PTRDIFF_MAX;
+			for (Sci::Position piece = 1; piece < count; piece++) {
+				const Sci::Position pos = starts.PositionFromPartition(piece);
+				const Sci::Position cost = ((piece > 1) ? pos : 0) + ((count - piece > 1) ? length - pos : 0);
+				if (cost < best) {
+					best = cost;
+					split = piece;
+				}
+			}
+			Coalesce(split, count);
+			Coalesce(0, split);
+		}
+		EnsureTail();
+		ReleaseBlocks();
+	}
+};
+
+}
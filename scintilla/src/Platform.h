@@ -223,6 +223,7 @@ public:
 	virtual void SCICALL RectangleFrame(PRectangle rc, Stroke stroke) = 0;
 	virtual void SCICALL FillRectangle(PRectangle rc, Fill fill) = 0;
 	virtual void SCICALL FillRectangleAligned(PRectangle rc, Fill fill) = 0;
+	virtual void SCICALL FillRectanglesAligned(const PRectangle *rcs, size_t count, Fill fill) = 0;
 	virtual void SCICALL FillRectangle(PRectangle rc, Surface &surfacePattern) = 0;
 	virtual void SCICALL RoundedRectangle(PRectangle rc, FillStroke fillStroke) = 0;
 	virtual void SCICALL AlphaRectangle(PRectangle rc, XYPOSITION cornerSize, FillStroke fillStroke) = 0;
@@ -360,6 +361,8 @@ public:
 	virtual void ClearRegisteredImages() noexcept = 0;
 	virtual void SetDelegate(IListBoxDelegate *lbDelegate) noexcept = 0;
 	virtual void SetList(const char* list, char separator, char typesep) = 0;
+	// only show items in [first, first + count), item index is not changed
+	virtual void SetItemRange(int first, int count) = 0;
 	virtual void SCICALL SetOptions(const ListOptions &options_) noexcept = 0;
 };
 
@@ -77,10 +77,13 @@ LineLayout::LineLayout(Sci::Line lineNumber_, int maxLineLength_) :
 
 void LineLayout::Resize(int maxLineLength_) {
 	if (maxLineLength_ > maxLineLength) {
-		lenLineStarts = 0;
 		constexpr size_t sentinel = sizeof(int); // fix out-of-bounds read for KeyFromString()
 		constexpr size_t alignment = sizeof(XYPOSITION)*2;
 		unsigned length = maxLineLength_ + sentinel;
+		if (maxLineLength > 0) {
+			// reused layout grows by half to avoid reallocating for each slightly longer line
+			length = std::max<unsigned>(length, maxLineLength + maxLineLength/2 + sentinel);
+		}
 		length = NP2_align_up(length, alignment);
 		const size_t lineAllocation = length;
 		length -= sentinel;
@@ -92,9 +95,24 @@ void LineLayout::Resize(int maxLineLength_) {
 		// Extra position allocated as sometimes the Windows
 		// GetTextExtentExPoint API writes an extra element.
 		positions = reinterpret_cast<XYPOSITION *>(styles + lineAllocation);
-		lineStarts.reset();
+		// lineStarts is independent of line length, kept for reuse.
 		bidiData.reset();
+		bidiValid = false;
+	}
+}
+
+size_t LineLayout::MemoryUsage() const noexcept {
+	constexpr size_t sentinel = sizeof(int);
+	size_t usage = sizeof(LineLayout) + lenLineStarts*sizeof(int);
+	if (chars) {
+		usage += (maxLineLength + sentinel)*(2 + sizeof(XYPOSITION));
 	}
+	if (bidiData) {
+		usage += sizeof(BidiData) + bidiData->stylesFonts.capacity()*sizeof(std::shared_ptr<Font>)
+			+ bidiData->widthReprs.capacity()*sizeof(XYPOSITION)
+			+ bidiData->screenLayouts.capacity()*sizeof(std::unique_ptr<IScreenLineLayout>);
+	}
+	return usage;
 }
 
 void LineLayout::Reset(Sci::Line lineNumber_, int maxLineLength_) {
@@ -701,7 +719,11 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 	}
 	if (lengthForLevel != shortCache.size()) {
 		maxValidity = LineLayout::ValidLevel::lines;
+		const bool shrink = lengthForLevel < shortCache.size();
 		shortCache.resize(lengthForLevel);
+		if (shrink) {
+			CountMemory();
+		}
 		//printf("%s level=%d, size=%zu/%zu, LineLayout=%zu/%zu, BidiData=%zu, XYPOSITION=%zu\n",
 		//	__func__, level, shortCache.size(), shortCache.capacity(), sizeof(LineLayout),
 		//	sizeof(std::unique_ptr<LineLayout>), sizeof(BidiData), sizeof(XYPOSITION));
@@ -712,8 +734,113 @@ void LineLayoutCache::AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesI
 void LineLayoutCache::Deallocate() noexcept {
 	maxValidity = LineLayout::ValidLevel::invalid;
 	lastCaretSlot = SIZE_MAX;
+	memoryUsed = 0;
 	shortCache.clear();
 	longCache.clear();
+	temporaryCache.clear();
+}
+
+std::unique_ptr<LineLayout> LineLayoutCache::AcquireTemporary() {
+	if (temporaryCache.empty()) {
+		++allocations;
+		return std::make_unique<LineLayout>(-1, -1);
+	}
+	std::unique_ptr<LineLayout> ll = std::move(temporaryCache.back());
+	temporaryCache.pop_back();
+	return ll;
+}
+
+void LineLayoutCache::ReleaseTemporary(std::unique_ptr<LineLayout> &&ll) {
+	temporaryCache.push_back(std::move(ll));
+}
+
+void LineLayoutCache::CountMemory() noexcept {
+	memoryUsed = 0;
+	for (const auto &ll : shortCache) {
+		if (ll) {
+			ll->memoryUsage = ll->MemoryUsage();
+			memoryUsed += ll->memoryUsage;
+		}
+	}
+	for (const auto &ll : longCache) {
+		ll->memoryUsage = ll->MemoryUsage();
+		memoryUsed += ll->memoryUsage;
+	}
+}
+
+void LineLayoutCache::FreeLeastRecentlyUsed(size_t recentUses) {
+	// sizes may have grown after layouts were retrieved
+	CountMemory();
+	if (memoryUsed <= memoryLimit) {
+		return;
+	}
+	// layouts retrieved recently may still be used by callers, e.g. caret line while painting.
+	const size_t recentClock = (useClock > recentUses) ? useClock - recentUses : 0;
+	std::vector<std::pair<size_t, size_t>> usages;
+	for (const auto &ll : shortCache) {
+		if (ll && ll->lastUsed < recentClock) {
+			usages.emplace_back(ll->lastUsed, ll->memoryUsage);
+		}
+	}
+	for (const auto &ll : longCache) {
+		if (ll->lastUsed < recentClock) {
+			usages.emplace_back(ll->lastUsed, ll->memoryUsage);
+		}
+	}
+	std::sort(usages.begin(), usages.end());
+	// free down to 3/4 of the limit so the scan is not repeated for each new layout.
+	const size_t target = memoryLimit - memoryLimit/4;
+	size_t remain = memoryUsed;
+	size_t oldest = 0;
+	for (const auto &usage : usages) {
+		if (remain <= target) {
+			break;
+		}
+		oldest = usage.first + 1;
+		remain -= usage.second;
+	}
+	if (oldest == 0) {
+		return;
+	}
+	for (auto &ll : shortCache) {
+		if (ll && ll->lastUsed < oldest) {
+			ll.reset();
+		}
+	}
+	longCache.erase(std::remove_if(longCache.begin(), longCache.end(), [oldest](const std::unique_ptr<LineLayout> &ll) noexcept {
+		return ll->lastUsed < oldest;
+	}), longCache.end());
+	if (lastCaretSlot != SIZE_MAX && !shortCache[lastCaretSlot]) {
+		lastCaretSlot = SIZE_MAX;
+	}
+	memoryUsed = remain;
+}
+
+size_t LineLayoutCache::MemoryUsage() const noexcept {
+	size_t usage = (shortCache.capacity() + longCache.capacity() + temporaryCache.capacity())*sizeof(std::unique_ptr<LineLayout>);
+	for (const auto &ll : shortCache) {
+		if (ll) {
+			usage += ll->MemoryUsage();
+		}
+	}
+	for (const auto &ll : longCache) {
+		if (ll) {
+			usage += ll->MemoryUsage();
+		}
+	}
+	for (const auto &ll : temporaryCache) {
+		usage += ll->MemoryUsage();
+	}
+	return usage;
+}
+
+void LineLayoutCache::Statistics(uint32_t &hits_, uint32_t &misses_, bool reset) noexcept {
+	hits_ = hits;
+	misses_ = misses;
+	if (reset) {
+		hits = 0;
+		misses = 0;
+	}
 }
 
 void LineLayoutCache::Invalidate(LineLayout::ValidLevel validity_) noexcept {
@@ -737,6 +864,7 @@ void LineLayoutCache::SetLevel(LineCache level_) noexcept {
 		level = level_;
 		maxValidity = LineLayout::ValidLevel::invalid;
 		lastCaretSlot = SIZE_MAX;
+		memoryUsed = 0;
 		shortCache.clear();
 		longCache.clear();
 	}
@@ -771,7 +899,7 @@ LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret,
 		pos = 1 + (lineNumber % gap) + ((diff < gap) ? 0 : gap);
 		// first slot reserved for caret line, which is rapidly retrieved when caret blinking.
 		if (lineNumber == lineCaret) {
-			if (lastCaretSlot == 0 && shortCache[0]->LineNumber() == lineCaret) {
+			if (lastCaretSlot == 0 && shortCache[0] && shortCache[0]->LineNumber() == lineCaret) {
 				pos = 0;
 			} else {
 				lastCaretSlot = pos;
@@ -794,8 +922,12 @@ LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret,
 		if (!ret->CanHold(lineNumber, maxChars)) {
 			//printf("USE line=%zd/%zd, caret=%zd/%zd top=%zd, pos=%zu, clock=%d\n",
 			//	lineNumber, ret->LineNumber(), lineCaret, lastCaretSlot, topLine, pos, styleClock_);
+			const int maxLineLength = ret->maxLineLength;
 			ret->Reset(lineNumber, maxChars);
+			allocations += ret->maxLineLength != maxLineLength;
+			++misses;
 		} else {
+			++hits;
 			//printf("HIT line=%zd, caret=%zd/%zd top=%zd, pos=%zu, clock=%d, validity=%d\n",
 			//	lineNumber, lineCaret, lastCaretSlot, topLine, pos, styleClock_, ret->validity);
 		}
@@ -803,6 +935,8 @@ LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret,
 		//printf("NEW line=%zd, caret=%zd/%zd top=%zd, pos=%zu, clock=%d\n",
 		//	lineNumber, lineCaret, lastCaretSlot, topLine, pos, styleClock_);
 		auto ll = std::make_unique<LineLayout>(lineNumber, maxChars);
+		++allocations;
+		++misses;
 		ret = ll.get();
 		if (useLongCache) {
 			longCache.push_back(std::move(ll));
@@ -811,6 +945,14 @@ LineLayout *LineLayoutCache::Retrieve(Sci::Line lineNumber, Sci::Line lineCaret,
 		}
 	}
 
+	ret->lastUsed = ++useClock;
+	const size_t usage = ret->MemoryUsage();
+	memoryUsed = memoryUsed - ret->memoryUsage + usage;
+	ret->memoryUsage = usage;
+	if (memoryLimit && memoryUsed > memoryLimit) {
+		FreeLeastRecentlyUsed(static_cast<size_t>(4*linesOnScreen) + 64);
+	}
+
 	// LineLineCache::None is not supported, we only use LineCache::Page.
 	return ret;
 }
@@ -1165,10 +1307,11 @@ TextSegment BreakFinder::Next() {
 	return {startSegment, lengthSegment, nullptr};
 }
 
-void PositionCacheEntry::Set(uint16_t styleNumber_, size_t length, std::unique_ptr<char[]> &positions_, uint32_t clock_) noexcept {
+void PositionCacheEntry::Set(uint16_t styleNumber_, int zoomLevel_, size_t length, std::unique_ptr<char[]> &positions_, uint32_t clock_) noexcept {
 	styleNumber = styleNumber_;
 	clock = static_cast<uint16_t>(clock_);
-	len = static_cast<uint32_t>(length);
+	len = static_cast<uint16_t>(length);
+	zoomLevel = static_cast<int16_t>(zoomLevel_);
 	positions.swap(positions_);
 }
 
@@ -1176,11 +1319,12 @@ void PositionCacheEntry::Clear() noexcept {
 	styleNumber = 0;
 	clock = 0;
 	len = 0;
+	zoomLevel = 0;
 	positions.reset();
 }
 
-bool PositionCacheEntry::Retrieve(uint16_t styleNumber_, std::string_view sv, XYPOSITION *positions_) const noexcept {
-	if (styleNumber == styleNumber_ && len == sv.length()) {
+bool PositionCacheEntry::Retrieve(uint16_t styleNumber_, int zoomLevel_, std::string_view sv, XYPOSITION *positions_) const noexcept {
+	if (styleNumber == styleNumber_ && zoomLevel == zoomLevel_ && len == sv.length()) {
 		const size_t offset = sv.length()*sizeof(XYPOSITION);
 		if (memcmp(&positions[offset], sv.data(), sv.length()) == 0) {
 			memcpy(positions_, &positions[0], offset);
@@ -1190,7 +1334,7 @@ bool PositionCacheEntry::Retrieve(uint16_t styleNumber_, std::string_view sv, XY
 	return false;
 }
 
-size_t PositionCacheEntry::Hash(uint16_t styleNumber_, std::string_view sv) noexcept {
+size_t PositionCacheEntry::Hash(uint16_t styleNumber_, int zoomLevel_, std::string_view sv) noexcept {
 #if 0
 	const size_t h1 = std::hash<std::string_view>{}(sv);
 	const size_t h2 = std::hash<uint8_t>{}(styleNumber_ & 0xff);
@@ -1207,7 +1351,7 @@ size_t PositionCacheEntry::Hash(uint16_t styleNumber_, std::string_view sv) noex
 		h1 ^= static_cast<uint8_t>(ch);
 		h1 *= FNV_prime;
 	}
-	h1 ^= styleNumber_;
+	h1 ^= styleNumber_ | (static_cast<uint32_t>(static_cast<uint16_t>(zoomLevel_)) << 16);
 	h1 *= FNV_prime;
 	return h1;
 #endif
@@ -1226,13 +1370,26 @@ void PositionCacheEntry::ResetClock() noexcept {
 PositionCache::PositionCache() = default;
 
 void PositionCache::Clear() noexcept {
-	if (!allClear) {
-		for (auto &pce : pces) {
-			pce.Clear();
+	const size_t shardSize = pces.size() / shardCount;
+#if 0
+	for (size_t index = 0; index < shardCount; index++) {
+		const Shard &shard = shards[index];
+		printf("%s shard %zu hits=%u, misses=%u\n", __func__, index, shard.hits, shard.misses);
+	}
+#endif
+	for (size_t index = 0; index < shardCount; index++) {
+		Shard &shard = shards[index];
+		if (!shard.allClear) {
+			PositionCacheEntry * const entries = &pces[index*shardSize];
+			for (size_t i = 0; i < shardSize; i++) {
+				entries[i].Clear();
+			}
 		}
+		shard.clock = 1;
+		shard.hits = 0;
+		shard.misses = 0;
+		shard.allClear = true;
 	}
-	clock = 1;
-	allClear = true;
 }
 
 void PositionCache::SetSize(size_t size_) {
@@ -1240,6 +1397,8 @@ void PositionCache::SetSize(size_t size_) {
 	if (size_ & (size_ - 1)) {
 		size_ = NextPowerOfTwo(size_);
 	}
+	// at least two entries for each shard
+	size_ = std::max(size_, shardCount*2);
 	pces.resize(size_);
 }
 
@@ -1247,6 +1406,34 @@ size_t PositionCache::GetSize() const noexcept {
 	return pces.size();
 }
 
+size_t PositionCache::MemoryUsage() noexcept {
+	for (Shard &shard : shards) {
+		shard.lock.lock();
+	}
+	size_t usage = pces.capacity()*sizeof(PositionCacheEntry);
+	for (const auto &pce : pces) {
+		usage += pce.MemoryUsage();
+	}
+	for (Shard &shard : shards) {
+		shard.lock.unlock();
+	}
+	return usage;
+}
+
+void PositionCache::Statistics(uint32_t &hits, uint32_t &misses, bool reset) noexcept {
+	hits = 0;
+	misses = 0;
+	for (Shard &shard : shards) {
+		const LockGuard<NativeMutex> guard(shard.lock);
+		hits += shard.hits;
+		misses += shard.misses;
+		if (reset) {
+			shard.hits = 0;
+			shard.misses = 0;
+		}
+	}
+}
+
 void PositionCache::MeasureWidths(Surface *surface, const Style &style, unsigned styleNumber_, std::string_view sv, XYPOSITION *positions) {
 	if (style.monospaceASCII && AllGraphicASCII(sv)) {
 		XYPOSITION characterWidth = style.aveCharWidth;
@@ -1306,28 +1493,30 @@ void PositionCache::MeasureWidths(Surface *surface, const Style &style, unsigned
 
 	PositionCacheEntry *entry = nullptr;
 	PositionCacheEntry *entry2 = nullptr;
+	Shard *shard = nullptr;
 	const uint16_t styleNumber = styleNumber_ & UINT16_MAX;
 	constexpr size_t maxLength = 512/(sizeof(XYPOSITION) + sizeof(char));
 	if (sv.length() <= maxLength) {
 		// Only store short strings in the cache so it doesn't churn with
 		// long comments with only a single comment.
 
-		// Two way associative: try two probe positions.
-		const size_t hashValue = PositionCacheEntry::Hash(styleNumber, sv);
-		const size_t mask = pces.size() - 1;
-		const size_t probe = hashValue & mask;
-		entry = &pces[probe];
-
-		const LockGuard<NativeMutex> readLock(cacheLock);
-		if (entry->Retrieve(styleNumber, sv, positions)) {
-			return;
-		}
-
-		const size_t probe2 = (hashValue * 37) & mask;
-		entry2 = &pces[probe2];
-		if (entry2->Retrieve(styleNumber, sv, positions)) {
+		// Two way associative: try two probe positions inside the shard.
+		const size_t hashValue = PositionCacheEntry::Hash(styleNumber, zoomLevel, sv);
+		const size_t index = hashValue & (shardCount - 1);
+		const size_t shardSize = pces.size() / shardCount;
+		const size_t mask = shardSize - 1;
+		PositionCacheEntry * const entries = &pces[index*shardSize];
+		shard = &shards[index];
+		const size_t hashShard = hashValue / shardCount;
+		entry = &entries[hashShard & mask];
+		entry2 = &entries[(hashShard * 37) & mask];
+
+		const LockGuard<NativeMutex> readLock(shard->lock);
+		if (entry->Retrieve(styleNumber, zoomLevel, sv, positions) || entry2->Retrieve(styleNumber, zoomLevel, sv, positions)) {
+			shard->hits++;
 			return;
 		}
+		shard->misses++;
 	}
 
 	if (styleNumber_ & positionCacheUnicode) {
@@ -1344,22 +1533,24 @@ void PositionCache::MeasureWidths(Surface *surface, const Style &style, unsigned
 		memcpy(&positions_[offset], sv.data(), length);
 
 		// Store into cache
-		const LockGuard<NativeMutex> writeLock(cacheLock);
+		const LockGuard<NativeMutex> writeLock(shard->lock);
 		// Choose the oldest of the two slots to replace
 		if (entry->NewerThan(*entry2)) {
 			entry = entry2;
 		}
 
-		clock++;
-		if (clock > UINT16_MAX) {
+		shard->clock++;
+		if (shard->clock > UINT16_MAX) {
 			// Since there are only 16 bits for the clock, wrap it round and
-			// reset all cache entries so none get stuck with a high clock.
-			for (PositionCacheEntry &pce : pces) {
-				pce.ResetClock();
+			// reset all entries in the shard so none get stuck with a high clock.
+			const size_t shardSize = pces.size() / shardCount;
+			PositionCacheEntry * const entries = &pces[(shard - shards)*shardSize];
+			for (size_t i = 0; i < shardSize; i++) {
+				entries[i].ResetClock();
 			}
-			clock = 2;
+			shard->clock = 2;
 		}
-		allClear = false;
-		entry->Set(styleNumber, length, positions_, clock);
+		shard->allClear = false;
+		entry->Set(styleNumber, zoomLevel, length, positions_, shard->clock);
 	}
 }
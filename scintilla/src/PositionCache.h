@@ -37,6 +37,8 @@ class BidiData final {
 public:
 	std::vector<std::shared_ptr<Font>> stylesFonts;
 	std::vector<XYPOSITION> widthReprs;
+	// Platform layouts for each sub line, reused for drawing and hit testing until the line is laid out again
+	std::vector<std::unique_ptr<IScreenLineLayout>> screenLayouts;
 	void Resize(size_t maxLineLength_);
 };
 
@@ -70,16 +72,23 @@ public:
 	unsigned char *styles = nullptr;
 	XYPOSITION *positions = nullptr;
 	std::unique_ptr<BidiData> bidiData;
+	// bidiData matches current text, positions and sub lines, null bidiData means visual order is logical order
+	bool bidiValid = false;
 
 	// Wrapped line support
 	int widthLine = wrapWidthInfinite;
 	int lines = 1;
 	XYPOSITION wrapIndent = 0; // In pixels
 
+	// Least recently used clock and memory accounted by LineLayoutCache
+	size_t lastUsed = 0;
+	size_t memoryUsage = 0;
+
 	LineLayout(Sci::Line lineNumber_, int maxLineLength_);
 	void Resize(int maxLineLength_);
 	void Reset(Sci::Line lineNumber_, int maxLineLength_);
 	void EnsureBidiData();
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 	void ClearPositions() const noexcept;
 	void Invalidate(ValidLevel validity_) noexcept;
 	Sci::Line LineNumber() const noexcept {
@@ -159,12 +168,22 @@ class LineLayoutCache final {
 private:
 	std::vector<std::unique_ptr<LineLayout>> shortCache;
 	std::vector<std::unique_ptr<LineLayout>> longCache;
+	// layouts for lines not kept in cache, reused by wrapping threads.
+	std::vector<std::unique_ptr<LineLayout>> temporaryCache;
 	size_t lastCaretSlot;
 	Scintilla::LineCache level;
 	LineLayout::ValidLevel maxValidity;
 	int styleClock;
+	size_t useClock = 0;
+	size_t memoryUsed = 0;
+	size_t memoryLimit = 0;
+	uint32_t hits = 0;
+	uint32_t misses = 0;
 	void AllocateForLevel(Sci::Line linesOnScreen, Sci::Line linesInDoc);
+	void CountMemory() noexcept;
+	void FreeLeastRecentlyUsed(size_t recentUses);
 public:
+	size_t allocations = 0;	///< Layout buffers allocated, for instrumentation
 	LineLayoutCache() noexcept;
 	// Deleted so LineLayoutCache objects can not be copied.
 	LineLayoutCache(const LineLayoutCache &) = delete;
@@ -178,6 +197,17 @@ public:
 	Scintilla::LineCache GetLevel() const noexcept {
 		return level;
 	}
+	void SetMemoryLimit(size_t limit) noexcept {
+		memoryLimit = limit;
+	}
+	size_t GetMemoryLimit() const noexcept {
+		return memoryLimit;
+	}
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
+	void Statistics(uint32_t &hits_, uint32_t &misses_, bool reset) noexcept;
+	// not thread safe, caller should lock like for Retrieve().
+	std::unique_ptr<LineLayout> AcquireTemporary();
+	void ReleaseTemporary(std::unique_ptr<LineLayout> &&ll);
 	LineLayout* SCICALL Retrieve(Sci::Line lineNumber, Sci::Line lineCaret, int maxChars, int styleClock_,
 		Sci::Line linesOnScreen, Sci::Line linesInDoc, Sci::Line topLine);
 	LineLayout* Retrieve(Sci::Line lineNumber, const SignificantLines &significantLines, int maxChars) {
@@ -194,15 +224,20 @@ public:
 class PositionCacheEntry {
 	uint16_t styleNumber = 0;
 	uint16_t clock = 0;
-	uint32_t len = 0;
+	uint16_t len = 0;
+	// entries measured at different zoom levels are kept side by side
+	int16_t zoomLevel = 0;
 	std::unique_ptr<char[]> positions;
 public:
-	void Set(uint16_t styleNumber_, size_t length, std::unique_ptr<char[]> &positions_, uint32_t clock_) noexcept;
+	void Set(uint16_t styleNumber_, int zoomLevel_, size_t length, std::unique_ptr<char[]> &positions_, uint32_t clock_) noexcept;
 	void Clear() noexcept;
-	bool Retrieve(uint16_t styleNumber_, std::string_view sv, XYPOSITION *positions_) const noexcept;
-	static size_t Hash(uint16_t styleNumber_, std::string_view sv) noexcept;
+	bool Retrieve(uint16_t styleNumber_, int zoomLevel_, std::string_view sv, XYPOSITION *positions_) const noexcept;
+	static size_t Hash(uint16_t styleNumber_, int zoomLevel_, std::string_view sv) noexcept;
 	[[nodiscard]] bool NewerThan(const PositionCacheEntry &other) const noexcept;
 	void ResetClock() noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept {
+		return positions ? len*(sizeof(XYPOSITION) + 1) : 0;
+	}
 };
 
 class Representation {
@@ -316,10 +351,19 @@ constexpr size_t positionCacheDefaultSize = 0x400;
 constexpr unsigned positionCacheUnicode = 1 << 16;
 
 class PositionCache {
+	// Entries are split into shards selected by hash, each shard has its own lock and clock,
+	// so parallel layout workers only contend when they look up strings in the same shard.
+	static constexpr size_t shardCount = 16;
+	struct alignas(64) Shard {
+		NativeMutex lock;
+		uint32_t clock = 1;
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+		bool allClear = true;
+	};
 	std::vector<PositionCacheEntry> pces { positionCacheDefaultSize };
-	NativeMutex cacheLock;
-	uint32_t clock = 1;
-	bool allClear = true;
+	Shard shards[shardCount];
+	int zoomLevel = 0;
 public:
 	PositionCache();
 	// Deleted so PositionCache objects can not be copied.
@@ -332,6 +376,11 @@ public:
 	void Clear() noexcept;
 	void SetSize(size_t size_);
 	[[nodiscard]] size_t GetSize() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() noexcept;
+	void Statistics(uint32_t &hits, uint32_t &misses, bool reset) noexcept;
+	void SetZoomLevel(int zoomLevel_) noexcept {
+		zoomLevel = zoomLevel_;
+	}
 	void MeasureWidths(Surface *surface, const Style &style, unsigned styleNumber_, std::string_view sv, XYPOSITION *positions);
 };
 
@@ -176,6 +176,10 @@
  *	constant 32 bytes in the internal nfa, and RESearch::Execute does a single
  *  bit comparison to locate the character in the set.
  *
+ *  Patterns without back reference are also converted into a sequence of
+ *  items for a lazily built DFA. It rejects text that can't match in a
+ *  single pass, so PMatch is only called on possible match starts.
+ *
  * Examples:
  *
  *  pattern:    foo*.*
@@ -206,6 +210,7 @@
 
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include <array>
 #include <algorithm>
 #include <iterator>
@@ -311,6 +316,30 @@ constexpr int isinset(const char *ap, unsigned char c) noexcept {
 	return ap[c >> 3] & (1 << (c & BITIND));
 }
 
+constexpr int isinset(const unsigned char *ap, unsigned char c) noexcept {
+	return ap[c >> 3] & (1 << (c & BITIND));
+}
+
+// DFA state key: bit set of NFA positions (item index, item count for match) and flags
+constexpr size_t DfaMaxItems = 60;
+constexpr size_t DfaMaxStates = 1024;
+constexpr Sci::Position DfaDirectMatchLength = 64;
+// transition is next state * 4 + flags
+constexpr int DfaMatched = 1;	// match ended before the character
+constexpr int DfaRestart = 2;	// no position for anchored scan, or only start position for unanchored scan
+constexpr uint64_t DfaUnanchored = UINT64_C(1) << 61;	// new match can start at every position
+constexpr uint64_t DfaPrevWord = UINT64_C(1) << 62;		// previous character is word character
+constexpr uint64_t DfaPrevHigh = UINT64_C(1) << 63;		// previous byte may be part of multi-byte character
+constexpr uint64_t DfaFlagMask = DfaUnanchored | DfaPrevWord | DfaPrevHigh;
+
+constexpr uint64_t DfaPosition(size_t index) noexcept {
+	return UINT64_C(1) << index;
+}
+
+constexpr bool IsNormalLiteral(int ch) noexcept {
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == ' ';
+}
+
 }
 
 /**
@@ -470,14 +499,19 @@ int RESearch::GetBackslashExpression(const char *pattern, int &incr) noexcept {
 	return result;
 }
 
-const char *RESearch::Compile(const char *pattern, size_t length, FindOption flags) {
-	if (sta == OKP && (flags == previousFlags
+bool RESearch::IsCompiled(const char *pattern, size_t length, FindOption flags) const noexcept {
+	return sta == OKP && (flags == previousFlags
 		&& length == cachedPattern.length()
-		&& memcmp(pattern, cachedPattern.data(), length) == 0)) {
+		&& memcmp(pattern, cachedPattern.data(), length) == 0);
+}
+
+const char *RESearch::Compile(const char *pattern, size_t length, FindOption flags) {
+	if (IsCompiled(pattern, length, flags)) {
 		return nullptr;
 	}
 
 	const char * const errmsg = DoCompile(pattern, length, flags);
+	BuildDfa();
 	if (errmsg == nullptr) {
 		previousFlags = flags;
 		cachedPattern.assign(pattern, length);
@@ -799,6 +833,319 @@ const char *RESearch::DoCompile(const char *pattern, size_t length, FindOption f
  *  respectively.
  *
  */
+// find first ch in [lp, endp) with memchr on each segment, returns endp when not found.
+Sci::Position CharacterIndexer::Find(unsigned char ch, Sci::Position lp, Sci::Position endp) const noexcept {
+	endp = std::min(endp, end);
+	if (lp < length1) {
+		const Sci::Position last = std::min(endp, length1);
+		const char *p = static_cast<const char *>(memchr(segment1 + lp, ch, last - lp));
+		if (p) {
+			return p - segment1;
+		}
+		lp = last;
+	}
+	if (lp < endp) {
+		const char *p = static_cast<const char *>(memchr(segment2 + lp, ch, endp - lp));
+		if (p) {
+			return p - segment2;
+		}
+	}
+	return endp;
+}
+
+/*
+ * BuildDfa: convert the nfa into DFA items when it only contains
+ * characters, optional closures and zero width assertions.
+ * The DFA may find a match where PMatch fails (e.g. BOT inside character),
+ * but never misses a match, tags are ignored.
+ */
+void RESearch::BuildDfa() {
+	dfaItems.clear();
+	dfaStates.clear();
+	dfaTransitions.clear();
+	dfaLiteral = -1;
+	dfaFirst = -1;
+	dfaFlags = DfaUnanchored;
+	if (sta != OKP || *nfa == BOL) {
+		// BOL pattern is matched only once
+		return;
+	}
+
+	const char *ap = nfa;
+	while (*ap != END) {
+		if (dfaItems.size() == DfaMaxItems) {
+			dfaItems.clear();
+			return;
+		}
+		DfaItem &item = dfaItems.emplace_back();
+		item.op = static_cast<uint8_t>(*ap++);
+		item.closure = END;
+		if (item.op == CLO || item.op == LCLO || item.op == CLQ) {
+			// CLQ on CCL is same as CLO in PMatch
+			item.closure = (item.op == CLQ && *ap != CCL) ? CLQ : CLO;
+			item.op = static_cast<uint8_t>(*ap++);
+		}
+		switch (item.op) {
+		case CHR:
+			if (*ap == '\0') {
+				// PMatch may match NUL after end of range
+				dfaItems.clear();
+				return;
+			}
+			memset(item.bits, 0, BITBLK);
+			item.bits[static_cast<uint8_t>(*ap) >> 3] = static_cast<unsigned char>(1 << (*ap & BITIND));
+			ap++;
+			item.op = CCL;
+			break;
+		case ANY:
+			memset(item.bits, 0xff, BITBLK);
+			item.op = CCL;
+			break;
+		case CCL:
+			memcpy(item.bits, ap, BITBLK);
+			ap += BITBLK;
+			break;
+		case BOW:
+		case EOW:
+			dfaFlags |= DfaPrevWord;
+			break;
+		case EOT:
+			dfaFlags |= DfaPrevHigh;
+			ap++;
+			break;
+		case BOT:
+			ap++;
+			break;
+		case EOL:
+			break;
+		default:
+			// REF or closure on unsupported item
+			dfaItems.clear();
+			return;
+		}
+		if (item.closure != END) {
+			if (item.op != CCL || *ap != END) {
+				dfaItems.clear();
+				return;
+			}
+			ap++;
+		}
+	}
+
+	// pick a character every match must contain, prefer punctuation over letters, digits and space
+	for (const DfaItem &item : dfaItems) {
+		if (item.op == CCL && item.closure == END) {
+			int ch = -1;
+			for (int c = 0; c < MAXCHR; c++) {
+				if (isinset(item.bits, static_cast<unsigned char>(c))) {
+					if (ch >= 0) {
+						ch = -1;
+						break;
+					}
+					ch = c;
+				}
+			}
+			if (ch >= 0 && (dfaLiteral < 0 || (IsNormalLiteral(dfaLiteral) && !IsNormalLiteral(ch)))) {
+				dfaLiteral = ch;
+			}
+			if (&item == &dfaItems.front()) {
+				dfaFirst = ch;
+			}
+		}
+	}
+}
+
+int RESearch::DfaStartState(const CharacterIndexer &ci, Sci::Position lp, bool anchored) {
+	uint64_t key = DfaPosition(0);
+	if (!anchored) {
+		key |= DfaUnanchored;
+	}
+	if (lp != lineStartPos && iswordc(ci.CharAt(lp - 1))) {
+		key |= DfaPrevWord;
+	}
+	if (ci.CharAt(lp - 1) & 0x80) {
+		key |= DfaPrevHigh;
+	}
+	return DfaState(key & ~(DfaFlagMask & ~dfaFlags));
+}
+
+int RESearch::DfaState(uint64_t key) {
+	const auto it = std::find(dfaStates.begin(), dfaStates.end(), key);
+	if (it != dfaStates.end()) {
+		return static_cast<int>(it - dfaStates.begin());
+	}
+	dfaStates.push_back(key);
+	dfaTransitions.resize(dfaStates.size() * MAXCHR, -1);
+	return static_cast<int>(dfaStates.size() - 1);
+}
+
+// add positions reachable without consuming character
+uint64_t RESearch::DfaClosure(uint64_t key, bool nextWord, bool atEnd) const noexcept {
+	// items only move forward so single pass is enough
+	for (size_t index = 0; index < dfaItems.size(); index++) {
+		if (key & DfaPosition(index)) {
+			const DfaItem &item = dfaItems[index];
+			bool pass = true;
+			switch (item.op) {
+			case CCL:
+				pass = item.closure != END;
+				break;
+			case BOW:
+				pass = !(key & DfaPrevWord) && nextWord;
+				break;
+			case EOW:
+				pass = (key & DfaPrevWord) && !nextWord;
+				break;
+			case EOL:
+				pass = atEnd;
+				break;
+			default:
+				break;
+			}
+			if (pass) {
+				key |= DfaPosition(index + 1);
+			}
+		}
+	}
+	return key;
+}
+
+int RESearch::DfaTransition(int state, unsigned char ch) {
+	if (dfaStates.size() >= DfaMaxStates) {
+		// flush the cache, keeps table size bounded for complex pattern
+		const uint64_t key = dfaStates[state];
+		dfaStates.clear();
+		dfaTransitions.clear();
+		state = DfaState(key);
+	}
+
+	const uint64_t current = DfaClosure(dfaStates[state], iswordc(ch), false);
+	uint64_t next = current & DfaUnanchored;
+	if (next) {
+		next |= DfaPosition(0);
+	}
+	if (current & DfaPrevHigh) {
+		// EOT may skip rest bytes of current character
+		for (size_t index = 0; index < dfaItems.size(); index++) {
+			if ((current & DfaPosition(index)) && dfaItems[index].op == EOT) {
+				next |= DfaPosition(index);
+			}
+		}
+	}
+	for (size_t index = 0; index < dfaItems.size(); index++) {
+		const DfaItem &item = dfaItems[index];
+		if ((current & DfaPosition(index)) && item.op == CCL && isinset(item.bits, ch)) {
+			next |= DfaPosition((item.closure == CLO) ? index : index + 1);
+		}
+	}
+	if (iswordc(ch)) {
+		next |= DfaPrevWord;
+	}
+	if (ch & 0x80) {
+		next |= DfaPrevHigh;
+	}
+	next &= ~(DfaFlagMask & ~dfaFlags);
+
+	const int target = DfaState(next);
+	int value = target*4;
+	if (current & DfaPosition(dfaItems.size())) {
+		value |= DfaMatched;
+	}
+	if ((next & ~DfaFlagMask) == ((next & DfaUnanchored) ? DfaPosition(0) : 0)) {
+		value |= DfaRestart;
+	}
+	dfaTransitions[state*MAXCHR + ch] = value;
+	return value;
+}
+
+/*
+ * DfaScan: returns end of first match found by DFA in [lp, endp],
+ * or NOTFOUND. When anchored only match starts at lp is found.
+ */
+Sci::Position RESearch::DfaScan(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp, bool anchored) {
+	const bool skipToFirst = dfaFirst >= 0 && !anchored;
+	if (skipToFirst) {
+		lp = ci.Find(static_cast<unsigned char>(dfaFirst), lp, endp);
+		if (lp >= endp) {
+			return NOTFOUND;
+		}
+	}
+	int state = DfaStartState(ci, lp, anchored);
+	for (; lp < endp; lp++) {
+		const unsigned char ch = ci.CharAt(lp);
+		int value = dfaTransitions[state*MAXCHR + ch];
+		if (value < 0) {
+			value = DfaTransition(state, ch);
+		}
+		if (value & DfaMatched) {
+			return lp;
+		}
+		state = value >> 2;
+		if (value & DfaRestart) {
+			if (anchored) {
+				return NOTFOUND;
+			}
+			if (skipToFirst) {
+				// no partial match, locate next start with memchr
+				const Sci::Position next = ci.Find(static_cast<unsigned char>(dfaFirst), lp + 1, endp);
+				if (next >= endp) {
+					return NOTFOUND;
+				}
+				if (next != lp + 1) {
+					state = DfaStartState(ci, next, anchored);
+				}
+				lp = next - 1;
+			}
+		}
+	}
+	const uint64_t key = DfaClosure(dfaStates[state], iswordc(ci.CharAt(endp)), endp >= lineEndPos);
+	return (key & DfaPosition(dfaItems.size())) ? endp : NOTFOUND;
+}
+
+/*
+ * DfaExecute: match starts at lp or later, complete match is found by PMatch.
+ */
+Sci::Position RESearch::DfaExecute(const CharacterIndexer &ci, Sci::Position &lp, Sci::Position endp) {
+	const char * const ap = nfa;
+	if (dfaLiteral >= 0 && ci.Find(static_cast<unsigned char>(dfaLiteral), lp, endp) >= endp) {
+		lp = endp;
+		return NOTFOUND;
+	}
+	// frequent match is found faster by calling PMatch directly
+	Sci::Position last = std::min(lp + DfaDirectMatchLength, endp);
+	bool anchoredScan = false;
+	while (true) {
+		while (lp < last) {
+			if (*ap == CHR) {
+				lp = ci.Find(ap[1], lp, last);
+				if (lp >= last) {
+					break;
+				}
+			}
+			if (!anchoredScan || DfaScan(ci, lp, endp, true) != NOTFOUND) {
+				const Sci::Position ep = PMatch(ci, lp, endp, ap);
+				// fix match started from middle of character like DBCS trailing ASCII byte
+				if (ep != NOTFOUND && ci.MovePositionOutsideChar(lp, -1) == lp) {
+					return ep;
+				}
+			}
+			lp++;
+		}
+		if (lp >= endp) {
+			break;
+		}
+		const Sci::Position end = DfaScan(ci, lp, endp, false);
+		if (end == NOTFOUND) {
+			break;
+		}
+		// leftmost match starts before first match end
+		last = std::min(end + 1, endp);
+		anchoredScan = last - lp > DfaDirectMatchLength;
+	}
+	lp = endp;
+	return NOTFOUND;
+}
+
 int RESearch::Execute(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp) {
 	Sci::Position ep = NOTFOUND;
 	const char * const ap = nfa;
@@ -818,17 +1165,20 @@ int RESearch::Execute(const CharacterIndexer &ci, Sci::Position lp, Sci::Positio
 		} else {
 			return 0;
 		}
-	case CHR: {			/* ordinary char: locate it fast */
-		const unsigned char c = ap[1];
-		while ((lp < endp) && (static_cast<unsigned char>(ci.CharAt(lp)) != c)) {
-			lp++;
-		}
-		if (lp >= endp)	/* if EOS, fail, else fall through. */
-			return 0;
-	}
-	[[fallthrough]];
+	case CHR:			/* ordinary char: locate it fast */
 	default:			/* regular matching all the way. */
+		if (!dfaItems.empty() && endp <= lineEndPos && ci.CharAt(endp) == '\0') {
+			// nothing after endp can be matched
+			ep = DfaExecute(ci, lp, endp);
+			break;
+		}
 		while (lp < endp) {
+			if (*ap == CHR) {
+				// skip to next candidate after each failed match
+				lp = ci.Find(ap[1], lp, endp);
+				if (lp >= endp)	/* if EOS, fail */
+					return 0;
+			}
 			ep = PMatch(ci, lp, endp, ap);
 			if (ep != NOTFOUND) {
 				// fix match started from middle of character like DBCS trailing ASCII byte
@@ -10,22 +10,40 @@
 namespace Scintilla::Internal {
 
 class CharacterIndexer {
+	// text is split into two segments at the gap, segment2 is indexed by position
+	const char *segment1;
+	Sci::Position length1;
+	const char *segment2;
+	Sci::Position end;
 public:
-	virtual char CharAt(Sci::Position index) const noexcept = 0;
+	CharacterIndexer(const char *segment1_, Sci::Position length1_, const char *segment2_, Sci::Position end_) noexcept :
+		segment1(segment1_), length1(length1_), segment2(segment2_), end(end_) {}
+	char CharAt(Sci::Position index) const noexcept {
+		if (index >= 0 && index < end) {
+			return (index < length1) ? segment1[index] : segment2[index];
+		}
+		return '\0';
+	}
+	Sci::Position Find(unsigned char ch, Sci::Position lp, Sci::Position endp) const noexcept;
 	virtual Sci::Position MovePositionOutsideChar(Sci::Position pos, int moveDir) const noexcept = 0;
 };
 
 class RESearch {
 public:
 	explicit RESearch(const CharClassify *charClassTable) noexcept;
-	// No dynamic allocation so default copy constructor and assignment operator are OK.
+	// Default copy constructor and assignment operator are OK.
 	void Clear() noexcept;
 	const char *Compile(const char *pattern, size_t length, Scintilla::FindOption flags);
+	bool IsCompiled(const char *pattern, size_t length, Scintilla::FindOption flags) const noexcept;
 	int Execute(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp);
 	void SetLineRange(Sci::Position startPos, Sci::Position endPos) noexcept {
 		lineStartPos = startPos;
 		lineEndPos = endPos;
 	}
+	// character every match must contain, or -1 when unknown
+	int RequiredCharacter() const noexcept {
+		return dfaLiteral;
+	}
 
 	static constexpr int MAXTAG = 10;
 	static constexpr int NOTFOUND = -1;
@@ -48,6 +66,28 @@ private:
 	const char *DoCompile(const char *pattern, size_t length, Scintilla::FindOption flags) noexcept;
 	Sci::Position PMatch(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp, const char *ap);
 
+	// lazily built DFA for pattern without back reference, used to skip text that can't match
+	// before PMatch() is called to find the actual match.
+	struct DfaItem {
+		int op;			// CCL for one character in bits, or BOW, EOW, EOL, BOT, EOT
+		int closure;	// END, CLO or CLQ
+		unsigned char bits[BITBLK];
+	};
+	std::vector<DfaItem> dfaItems;
+	std::vector<uint64_t> dfaStates;	// NFA positions and flags
+	std::vector<int> dfaTransitions;	// next state and flags for each character
+	int dfaLiteral = -1;				// character required by any match
+	int dfaFirst = -1;					// character every match starts with
+	uint64_t dfaFlags = 0;				// flags need to be tracked by states
+
+	void BuildDfa();
+	int DfaState(uint64_t key);
+	int DfaStartState(const CharacterIndexer &ci, Sci::Position lp, bool anchored);
+	int DfaTransition(int state, unsigned char ch);
+	uint64_t DfaClosure(uint64_t key, bool nextWord, bool atEnd) const noexcept;
+	Sci::Position DfaScan(const CharacterIndexer &ci, Sci::Position lp, Sci::Position endp, bool anchored);
+	Sci::Position DfaExecute(const CharacterIndexer &ci, Sci::Position &lp, Sci::Position endp);
+
 	// positions to match line start and line end
 	Sci::Position lineStartPos;
 	Sci::Position lineEndPos;
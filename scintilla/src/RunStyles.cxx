@@ -124,6 +124,14 @@ DISTANCE RunStyles<DISTANCE, STYLE>::EndRun(DISTANCE position) const noexcept {
 	return starts.PositionFromPartition(starts.PartitionFromPosition(position) + 1);
 }
 
+template <typename DISTANCE, typename STYLE>
+STYLE RunStyles<DISTANCE, STYLE>::RunAt(DISTANCE position, DISTANCE &startRun, DISTANCE &endRun) const noexcept {
+	const DISTANCE run = starts.PartitionFromPosition(position);
+	startRun = starts.PositionFromPartition(run);
+	endRun = starts.PositionFromPartition(run + 1);
+	return styles.ValueAt(run);
+}
+
 template <typename DISTANCE, typename STYLE>
 FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, STYLE value, DISTANCE fillLength) {
 	const FillResult<DISTANCE> resultNoChange{ false, position, fillLength };
@@ -192,6 +200,94 @@ FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRange(DISTANCE position, ST
 	return resultNoChange;
 }
 
+// Merge existing runs with ranges ordered by position in one pass instead of splitting
+// runs for each range, which moves the gap of both vectors back and forth.
+template <typename DISTANCE, typename STYLE>
+FillResult<DISTANCE> RunStyles<DISTANCE, STYLE>::FillRanges(const Sci::Position *ranges, size_t count, STYLE value) {
+	const DISTANCE length = Length();
+	std::vector<DISTANCE> runStarts;
+	std::vector<STYLE> runStyles;
+	runStarts.reserve(starts.Partitions() + 2*count);
+	runStyles.reserve(starts.Partitions() + 2*count);
+	const auto addRun = [&runStarts, &runStyles](DISTANCE position, STYLE style) {
+		if (!runStyles.empty()) {
+			if (runStyles.back() == style) {
+				return;
+			}
+			if (runStarts.back() == position) {
+				runStarts.pop_back();
+				runStyles.pop_back();
+				if (!runStyles.empty() && runStyles.back() == style) {
+					return;
+				}
+			}
+		}
+		runStarts.push_back(position);
+		runStyles.push_back(style);
+	};
+
+	// run contains position
+	DISTANCE position = 0;
+	DISTANCE run = 0;
+	const auto copyRuns = [&](DISTANCE end) {
+		while (position < end) {
+			addRun(position, styles.ValueAt(run));
+			const DISTANCE endRun = starts.PositionFromPartition(run + 1);
+			if (endRun > end) {
+				position = end;
+				break;
+			}
+			position = endRun;
+			run++;
+		}
+	};
+	const auto skipRuns = [&](DISTANCE end) noexcept {
+		bool changed = false;
+		while (position < end) {
+			changed = changed || styles.ValueAt(run) != value;
+			const DISTANCE endRun = starts.PositionFromPartition(run + 1);
+			if (endRun > end) {
+				position = end;
+				break;
+			}
+			position = endRun;
+			run++;
+		}
+		return changed;
+	};
+
+	DISTANCE changedStart = length;
+	DISTANCE changedEnd = 0;
+	for (size_t i = 0; i < count; i++) {
+		// same as FillRange(), ignore range past document end
+		const Sci::Position start = std::max<Sci::Position>(ranges[2*i], position);
+		const Sci::Position end = ranges[2*i] + ranges[2*i + 1];
+		if (start < end && end <= length) {
+			copyRuns(static_cast<DISTANCE>(start));
+			addRun(static_cast<DISTANCE>(start), value);
+			if (skipRuns(static_cast<DISTANCE>(end))) {
+				changedStart = std::min(changedStart, static_cast<DISTANCE>(start));
+				changedEnd = static_cast<DISTANCE>(end);
+			}
+		}
+	}
+	if (changedStart >= changedEnd) {
+		return { false, 0, 0 };
+	}
+	copyRuns(length);
+
+	const DISTANCE runs = static_cast<DISTANCE>(runStarts.size());
+	starts = Partitioning<DISTANCE>();
+	starts.ReAllocate(runs);
+	starts.InsertText(0, length);
+	starts.InsertPartitions(1, runStarts.data() + 1, runs - 1);
+	styles = SplitVector<STYLE>();
+	styles.ReAllocate(runs + 1);
+	styles.InsertFromArray(0, runStyles.data(), runs);
+	styles.InsertValue(runs, 1, STYLE());
+	return { true, changedStart, changedEnd - changedStart };
+}
+
 template <typename DISTANCE, typename STYLE>
 void RunStyles<DISTANCE, STYLE>::SetValueAt(DISTANCE position, STYLE value) {
 	FillRange(position, value, 1);
@@ -260,6 +356,11 @@ DISTANCE RunStyles<DISTANCE, STYLE>::Runs() const noexcept {
 	return starts.Partitions();
 }
 
+template <typename DISTANCE, typename STYLE>
+size_t RunStyles<DISTANCE, STYLE>::MemoryUsage() const noexcept {
+	return starts.MemoryUsage() + styles.MemoryUsage();
+}
+
 template <typename DISTANCE, typename STYLE>
 bool RunStyles<DISTANCE, STYLE>::AllSame() const noexcept {
 	for (DISTANCE run = 1; run < starts.Partitions(); run++) {
@@ -37,13 +37,18 @@ public:
 	DISTANCE FindNextChange(DISTANCE position, DISTANCE end) const noexcept;
 	DISTANCE StartRun(DISTANCE position) const noexcept;
 	DISTANCE EndRun(DISTANCE position) const noexcept;
+	// Value and extent of run containing position with one search
+	STYLE RunAt(DISTANCE position, DISTANCE &startRun, DISTANCE &endRun) const noexcept;
 	// Returns changed=true if some values may have changed
 	FillResult<DISTANCE> FillRange(DISTANCE position, STYLE value, DISTANCE fillLength);
+	// Fill sorted (position, length) pairs, runs are rebuilt in one pass
+	FillResult<DISTANCE> FillRanges(const Sci::Position *ranges, size_t count, STYLE value);
 	void SetValueAt(DISTANCE position, STYLE value);
 	void InsertSpace(DISTANCE position, DISTANCE insertLength);
 	void DeleteAll();
 	void DeleteRange(DISTANCE position, DISTANCE deleteLength);
 	DISTANCE Runs() const noexcept;
+	size_t MemoryUsage() const noexcept;
 	bool AllSame() const noexcept;
 	bool AllSameAs(STYLE value) const noexcept;
 	DISTANCE Find(STYLE value, DISTANCE start) const noexcept;
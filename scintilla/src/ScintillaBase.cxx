@@ -64,6 +64,7 @@
 #include "EditModel.h"
 #include "MarginView.h"
 #include "EditView.h"
+#include "OverviewRuler.h"
 #include "Editor.h"
 #include "AutoComplete.h"
 #include "ScintillaBase.h"
@@ -690,7 +691,12 @@ LexState::LexState(Document *pdoc_) noexcept : LexInterface(pdoc_) {
 }
 
 void LexState::SetInstance(ILexer5 *instance_) {
+	StopBackground();
 	instance.reset(instance_);
+	restartLines = 0;
+	nestedStateMask = 0;
+	lineLocal = false;
+	styledTail = -1;
 	const int language = instance_ ? instance_->GetIdentifier() : SCLEX_CONTAINER;
 	lexerLanguage = language;
 	pdoc->LexerChanged(language != SCLEX_NULL);
@@ -700,17 +706,31 @@ LexState *ScintillaBase::DocumentLexState() {
 	if (!pdoc->GetLexInterface()) {
 		pdoc->SetLexInterface(std::make_unique<LexState>(pdoc));
 	}
-	return down_cast<LexState *>(pdoc->GetLexInterface());
+	LexState *lexState = down_cast<LexState *>(pdoc->GetLexInterface());
+	// lexer instance is not thread safe
+	lexState->JoinBackground();
+	return lexState;
 }
 
 void LexState::SetLexer(int language) { //! removed in Scintilla 5
 	ILexer5 *instance_ = nullptr;
+	int restartLines_ = 0;
+	int nestedStateMask_ = 0;
+	bool lineLocal_ = false;
 	if (language != SCLEX_CONTAINER) {
 		const LexerModule *lex = LexerModule::Find(language);
 		language = lex->GetLanguage();
 		instance_ = lex->Create();
+		restartLines_ = lex->restartLines;
+		nestedStateMask_ = lex->nestedStateMask;
+		lineLocal_ = lex->lineLocal;
 	}
+	StopBackground();
 	instance.reset(instance_);
+	restartLines = restartLines_;
+	nestedStateMask = nestedStateMask_;
+	lineLocal = lineLocal_;
+	styledTail = -1;
 	lexerLanguage = language;
 	pdoc->LexerChanged(language != SCLEX_NULL);
 }
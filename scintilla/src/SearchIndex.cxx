@@ -0,0 +1,248 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+/** @file SearchIndex.cxx
+ ** Block level trigram index for literal search in huge documents.
+ **/
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <cassert>
+#include <cstring>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+
+#include "ScintillaTypes.h"
+
+#include "Debugging.h"
+
+#include "CharacterSet.h"
+
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "CellBuffer.h"
+#include "SearchIndex.h"
+#include "ParallelSupport.h"
+
+using namespace Scintilla::Internal;
+using namespace Lexilla;
+
+namespace {
+
+constexpr uint32_t TrigramBit(uint32_t trigram) noexcept {
+	// Fibonacci hashing into 16 bits
+	return (trigram * 0x9E3779B1U) >> 16;
+}
+
+constexpr void SetBit(uint64_t *bits, uint32_t bit) noexcept {
+	bits[bit >> 6] |= UINT64_C(1) << (bit & 63);
+}
+
+constexpr bool TestBit(const uint64_t *bits, uint32_t bit) noexcept {
+	return (bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+SplitRange RangeOfView(const SplitView &view, Sci::Position start, Sci::Position end) noexcept {
+	const Sci::Position length1 = view.length1;
+	if (end <= length1) {
+		return { view.segment1 + start, end - start };
+	}
+	if (start >= length1) {
+		return { view.segment2 + start, end - start };
+	}
+	return { view.segment1 + start, length1 - start, view.segment2 + length1, end - length1 };
+}
+
+// add trigrams starting in range, except for the last two characters which only end trigrams
+void AddTrigrams(uint64_t *bits, const SplitRange &range) noexcept {
+	uint32_t trigram = 0;
+	Sci::Position count = 0;
+	const auto add = [&](const char *text, Sci::Position length) noexcept {
+		for (Sci::Position i = 0; i < length; i++) {
+			trigram = ((trigram << 8) | MakeLowerCase(static_cast<uint8_t>(text[i]))) & 0xffffff;
+			if (++count >= 3) {
+				SetBit(bits, TrigramBit(trigram));
+			}
+		}
+	};
+	add(range.segment1, range.length1);
+	add(range.segment2, range.length2);
+}
+
+// fill bit sets of blocks in multiple threads
+class BuildWorker {
+	const std::vector<SplitRange> &ranges;
+	uint64_t * const *bits;
+	std::atomic<size_t> nextBlock = 0;
+
+public:
+	BuildWorker(const std::vector<SplitRange> &ranges_, uint64_t * const *bits_) noexcept:
+		ranges{ranges_}, bits{bits_} {}
+
+	void Run() noexcept {
+		const uint32_t threadCount = std::min<uint32_t>(GetHardwareConcurrency(), static_cast<uint32_t>(ranges.size()));
+		PTP_WORK work = nullptr;
+		if (threadCount > 1) {
+			work = CreateThreadpoolWork(WorkCallback, this, nullptr);
+		}
+		if (work == nullptr) {
+			DoWork();
+		} else {
+			for (uint32_t i = 0; i < threadCount; i++) {
+				SubmitThreadpoolWork(work);
+			}
+			WaitForThreadpoolWorkCallbacks(work, FALSE);
+			CloseThreadpoolWork(work);
+		}
+	}
+
+	void DoWork() noexcept {
+		while (true) {
+			const size_t index = nextBlock.fetch_add(1, std::memory_order_relaxed);
+			if (index >= ranges.size()) {
+				break;
+			}
+			AddTrigrams(bits[index], ranges[index]);
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) {
+		BuildWorker *worker = static_cast<BuildWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+}
+
+SearchIndex::SearchIndex() noexcept = default;
+
+// add trigrams starting in [position, position + length), which may cross blocks
+void SearchIndex::AddText(Sci::Position block, const CellBuffer &cb, Sci::Position position, Sci::Position length) {
+	const Sci::Position lengthDocument = cb.Length();
+	const Sci::Position end = std::min(position + length, lengthDocument);
+	position = std::max<Sci::Position>(position, 0);
+	while (position < end && block < Blocks()) {
+		const Sci::Position endBlock = std::min(BlockStart(block + 1), end);
+		if (position < endBlock) {
+			const Sci::Position endRange = std::min(endBlock + 2, lengthDocument);
+			AddTrigrams(blocks[block].get(), cb.RangeView(position, endRange - position));
+			position = endBlock;
+		}
+		block++;
+	}
+}
+
+// recompute trigrams of block, split it when too large
+void SearchIndex::Rebuild(Sci::Position block, const CellBuffer &cb) {
+	const Sci::Position start = BlockStart(block);
+	const Sci::Position end = BlockStart(block + 1);
+	const Sci::Position count = std::max<Sci::Position>((end - start + BlockSize - 1) / BlockSize, 1);
+	std::vector<BitSet> bitSets(count - 1);
+	for (BitSet &bits : bitSets) {
+		bits = std::make_unique<uint64_t[]>(WordsPerBlock);
+	}
+	memset(blocks[block].get(), 0, WordsPerBlock*sizeof(uint64_t));
+	blocks.insert(blocks.begin() + block + 1, std::make_move_iterator(bitSets.begin()), std::make_move_iterator(bitSets.end()));
+	for (Sci::Position i = 1; i < count; i++) {
+		starts.InsertPartition(block + i, start + i*BlockSize);
+	}
+	AddText(block, cb, start, end - start);
+}
+
+void SearchIndex::Build(const CellBuffer &cb) {
+	const SplitView view = cb.AllView();
+	const Sci::Position length = view.length;
+	const Sci::Position count = std::max<Sci::Position>((length + BlockSize - 1) / BlockSize, 1);
+	std::vector<BitSet> bitSets(count);
+	std::vector<uint64_t *> bits(count);
+	std::vector<SplitRange> ranges(count);
+	for (Sci::Position i = 0; i < count; i++) {
+		bitSets[i] = std::make_unique<uint64_t[]>(WordsPerBlock);
+		bits[i] = bitSets[i].get();
+		const Sci::Position start = i*BlockSize;
+		ranges[i] = RangeOfView(view, start, std::min(start + BlockSize + 2, length));
+	}
+
+	starts.DeleteAll();
+	starts.InsertText(0, length);
+	for (Sci::Position i = 1; i < count; i++) {
+		starts.InsertPartition(i, i*BlockSize);
+	}
+	blocks = std::move(bitSets);
+
+	BuildWorker worker(ranges, bits.data());
+	worker.Run();
+}
+
+void SearchIndex::InsertText(const CellBuffer &cb, Sci::Position position, Sci::Position insertLength) {
+	const Sci::Position block = BlockFromPosition(position);
+	starts.InsertText(block, insertLength);
+	if (BlockStart(block + 1) - BlockStart(block) > MaxBlockSize) {
+		// trigrams before insertion may belong to previous block
+		AddText(BlockFromPosition(position - 2), cb, position - 2, 2);
+		Rebuild(block, cb);
+	} else {
+		AddText(BlockFromPosition(position - 2), cb, position - 2, insertLength + 2);
+	}
+}
+
+void SearchIndex::DeleteText(const CellBuffer &cb, Sci::Position position, Sci::Position deleteLength) {
+	// block positions are not yet updated for the deletion
+	const Sci::Position block = BlockFromPosition(position);
+	const Sci::Position last = BlockFromPosition(position + deleteLength);
+	if (last > block) {
+		// blocks inside deleted range are dropped, remaining of last block is merged into first block
+		uint64_t *bits = blocks[block].get();
+		const uint64_t *lastBits = blocks[last].get();
+		for (int i = 0; i < WordsPerBlock; i++) {
+			bits[i] |= lastBits[i];
+		}
+		for (Sci::Position i = block + 1; i <= last; i++) {
+			starts.RemovePartition(block + 1);
+		}
+		blocks.erase(blocks.begin() + block + 1, blocks.begin() + last + 1);
+	}
+	starts.InsertText(block, -deleteLength);
+	AddText(BlockFromPosition(position - 2), cb, position - 2, 2);
+	if (BlockStart(block + 1) - BlockStart(block) > MaxBlockSize) {
+		Rebuild(block, cb);
+	}
+}
+
+bool SearchIndex::MakePattern(const char *text, Sci::Position length, Pattern &pattern) {
+	pattern.bits.clear();
+	pattern.length = length;
+	if (length < 3) {
+		return false;
+	}
+	uint32_t trigram = MakeLowerCase(static_cast<uint8_t>(text[0])) << 8 | MakeLowerCase(static_cast<uint8_t>(text[1]));
+	for (Sci::Position i = 2; i < length; i++) {
+		trigram = ((trigram << 8) | MakeLowerCase(static_cast<uint8_t>(text[i]))) & 0xffffff;
+		pattern.bits.push_back(TrigramBit(trigram));
+	}
+	std::sort(pattern.bits.begin(), pattern.bits.end());
+	pattern.bits.erase(std::unique(pattern.bits.begin(), pattern.bits.end()), pattern.bits.end());
+	return true;
+}
+
+// whether a match may start inside block, its trigrams start in this or following blocks
+bool SearchIndex::MayContain(Sci::Position block, const Pattern &pattern) const noexcept {
+	const Sci::Position last = BlockFromPosition(BlockStart(block + 1) + pattern.length - 3);
+	for (const uint32_t bit : pattern.bits) {
+		Sci::Position index = block;
+		while (!TestBit(blocks[index].get(), bit)) {
+			++index;
+			if (index > last) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
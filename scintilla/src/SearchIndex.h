@@ -0,0 +1,53 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#pragma once
+
+namespace Scintilla::Internal {
+
+/// Trigram index used to skip blocks of huge documents that can't contain a literal pattern.
+/// Each block keeps a bit set of hashed trigrams (ASCII lower cased), bits are only added by
+/// insertion and deletion, so the set is a superset of trigrams inside the block.
+class SearchIndex {
+public:
+	static constexpr Sci::Position BlockSize = 64*1024;
+	// trigrams of pattern for MayContain()
+	struct Pattern {
+		std::vector<uint32_t> bits;
+		Sci::Position length;
+	};
+
+private:
+	static constexpr int BitsPerBlock = 64*1024;
+	static constexpr int WordsPerBlock = BitsPerBlock / 64;
+	static constexpr Sci::Position MaxBlockSize = 4*BlockSize;
+	using BitSet = std::unique_ptr<uint64_t[]>;
+
+	Partitioning<Sci::Position> starts;
+	std::vector<BitSet> blocks;
+
+	void AddText(Sci::Position block, const CellBuffer &cb, Sci::Position position, Sci::Position length);
+	void Rebuild(Sci::Position block, const CellBuffer &cb);
+
+public:
+	SearchIndex() noexcept;
+	void Build(const CellBuffer &cb);
+	void InsertText(const CellBuffer &cb, Sci::Position position, Sci::Position insertLength);
+	void DeleteText(const CellBuffer &cb, Sci::Position position, Sci::Position deleteLength);
+
+	static bool MakePattern(const char *text, Sci::Position length, Pattern &pattern);
+	Sci::Position Blocks() const noexcept {
+		return starts.Partitions();
+	}
+	Sci::Position BlockFromPosition(Sci::Position pos) const noexcept {
+		return starts.PartitionFromPosition(pos);
+	}
+	Sci::Position BlockStart(Sci::Position block) const noexcept {
+		return starts.PositionFromPartition(block);
+	}
+	bool MayContain(Sci::Position block, const Pattern &pattern) const noexcept;
+	size_t MemoryUsage() const noexcept {
+		return starts.MemoryUsage() + blocks.capacity()*sizeof(BitSet) + blocks.size()*WordsPerBlock*sizeof(uint64_t);
+	}
+};
+
+}
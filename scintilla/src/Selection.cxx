@@ -103,6 +103,9 @@ const char *ValueFromString(const char *p, T &value) noexcept {
 }
 #endif
 
+// linear search is fast enough for few ranges
+constexpr size_t rangeIndexMinCount = 16;
+
 }
 
 SelectionPosition::SelectionPosition(const char *&sv) noexcept {
@@ -460,6 +463,7 @@ void Selection::SetMain(size_t r) noexcept {
 }
 
 SelectionRange &Selection::Range(size_t r) noexcept {
+	InvalidateIndex();
 	return ranges[r];
 }
 
@@ -468,6 +472,7 @@ const SelectionRange &Selection::Range(size_t r) const noexcept {
 }
 
 SelectionRange &Selection::RangeMain() noexcept {
+	InvalidateIndex();
 	return ranges[mainRange];
 }
 
@@ -518,6 +523,7 @@ Sci::Position Selection::Length() const noexcept {
 }
 
 void Selection::MovePositions(bool insertion, Sci::Position startChange, Sci::Position length) noexcept {
+	InvalidateIndex();
 	for (auto &range : ranges) {
 		range.MoveForInsertDelete(insertion, startChange, length);
 	}
@@ -526,7 +532,14 @@ void Selection::MovePositions(bool insertion, Sci::Position startChange, Sci::Po
 	}
 }
 
+void Selection::MoveRectangularPositions(bool insertion, Sci::Position startChange, Sci::Position length) noexcept {
+	if (selType == SelTypes::rectangle) {
+		rangeRectangular.MoveForInsertDelete(insertion, startChange, length);
+	}
+}
+
 void Selection::TrimSelection(SelectionRange range) noexcept {
+	InvalidateIndex();
 	for (size_t i = 0; i < ranges.size();) {
 		if ((i != mainRange) && (ranges[i].Trim(range))) {
 			// Trimmed to empty so remove
@@ -543,6 +556,7 @@ void Selection::TrimSelection(SelectionRange range) noexcept {
 }
 
 void Selection::TrimOtherSelections(size_t r, SelectionRange range) noexcept {
+	InvalidateIndex();
 	for (size_t i = 0; i < ranges.size(); ++i) {
 		if (i != r) {
 			ranges[i].Trim(range);
@@ -551,6 +565,7 @@ void Selection::TrimOtherSelections(size_t r, SelectionRange range) noexcept {
 }
 
 void Selection::SetSelection(SelectionRange range) noexcept {
+	InvalidateIndex();
 	if (ranges.size() > 1) {
 		ranges.erase(ranges.begin() + 1, ranges.end());
 	}
@@ -565,11 +580,13 @@ void Selection::AddSelection(SelectionRange range) {
 }
 
 void Selection::AddSelectionWithoutTrim(SelectionRange range) {
+	InvalidateIndex();
 	ranges.push_back(range);
 	mainRange = ranges.size() - 1;
 }
 
 void Selection::DropSelection(size_t r) noexcept {
+	InvalidateIndex();
 	if ((ranges.size() > 1) && (r < ranges.size())) {
 		size_t mainNew = mainRange;
 		if (mainNew >= r) {
@@ -589,6 +606,7 @@ void Selection::DropAdditionalRanges() noexcept {
 }
 
 void Selection::TentativeSelection(SelectionRange range) {
+	InvalidateIndex();
 	if (!tentativeMain) {
 		rangesSaved = ranges;
 	}
@@ -608,6 +626,18 @@ InSelection Selection::RangeType(size_t r) const noexcept {
 }
 
 InSelection Selection::CharacterInSelection(Sci::Position posCharacter) const noexcept {
+	if (!index.empty()) {
+		// first range in original order wins when ranges overlap
+		size_t found = ranges.size();
+		const auto [first, last] = RangesTouching(posCharacter, posCharacter);
+		for (size_t i = first; i < last; i++) {
+			const IndexEntry &entry = index[i];
+			if (entry.range < found && posCharacter >= entry.start && posCharacter < entry.end) {
+				found = entry.range;
+			}
+		}
+		return (found < ranges.size()) ? RangeType(found) : InSelection::inNone;
+	}
 	for (size_t i = 0; i < ranges.size(); i++) {
 		if (ranges[i].ContainsCharacter(posCharacter))
 			return RangeType(i);
@@ -616,6 +646,17 @@ InSelection Selection::CharacterInSelection(Sci::Position posCharacter) const no
 }
 
 InSelection Selection::InSelectionForEOL(Sci::Position pos) const noexcept {
+	if (!index.empty()) {
+		size_t found = ranges.size();
+		const auto [first, last] = RangesTouching(pos, pos);
+		for (size_t i = first; i < last; i++) {
+			const IndexEntry &entry = index[i];
+			if (entry.range < found && pos > entry.start && pos <= entry.end && !ranges[entry.range].Empty()) {
+				found = entry.range;
+			}
+		}
+		return (found < ranges.size()) ? RangeType(found) : InSelection::inNone;
+	}
 	for (size_t i = 0; i < ranges.size(); i++) {
 		if (!ranges[i].Empty() && (pos > ranges[i].Start().Position()) && (pos <= ranges[i].End().Position()))
 			return RangeType(i);
@@ -625,7 +666,9 @@ InSelection Selection::InSelectionForEOL(Sci::Position pos) const noexcept {
 
 Sci::Position Selection::VirtualSpaceFor(Sci::Position pos) const noexcept {
 	Sci::Position virtualSpace = 0;
-	for (const auto &range : ranges) {
+	const auto [first, last] = RangesTouching(pos, pos);
+	for (size_t i = first; i < last; i++) {
+		const SelectionRange &range = ranges[RangeIndexed(i)];
 		if ((range.caret.Position() == pos) && (virtualSpace < range.caret.VirtualSpace()))
 			virtualSpace = range.caret.VirtualSpace();
 		if ((range.anchor.Position() == pos) && (virtualSpace < range.anchor.VirtualSpace()))
@@ -635,6 +678,7 @@ Sci::Position Selection::VirtualSpaceFor(Sci::Position pos) const noexcept {
 }
 
 void Selection::Clear() noexcept {
+	InvalidateIndex();
 	if (ranges.size() > 1) {
 		ranges.erase(ranges.begin() + 1, ranges.end());
 	}
@@ -655,6 +699,7 @@ void Selection::Reset() noexcept {
 }
 
 void Selection::RemoveDuplicates() noexcept {
+	InvalidateIndex();
 	for (size_t i = 0; i < ranges.size() - 1; i++) {
 		if (ranges[i].Empty()) {
 			size_t j = i + 1;
@@ -677,6 +722,7 @@ void Selection::RotateMain() noexcept {
 }
 
 std::vector<SelectionRange *> Selection::SortedRanges() {
+	InvalidateIndex();
 	std::vector<SelectionRange *> selPtrs;
 	for (SelectionRange &range : ranges) {
 		selPtrs.push_back(&range);
@@ -689,12 +735,51 @@ std::vector<SelectionRange *> Selection::SortedRanges() {
 	return selPtrs;
 }
 
+void Selection::BuildIndex() const {
+	if (indexValid) {
+		return;
+	}
+	indexValid = true;
+	if (ranges.size() < rangeIndexMinCount) {
+		return;
+	}
+	index.resize(ranges.size());
+	for (size_t r = 0; r < ranges.size(); r++) {
+		const SelectionRange &range = ranges[r];
+		index[r] = { range.Start().Position(), range.End().Position(), 0, r };
+	}
+	std::sort(index.begin(), index.end(), [](const IndexEntry &a, const IndexEntry &b) noexcept {
+		return a.start < b.start;
+	});
+	Sci::Position maxEnd = Sci::invalidPosition;
+	for (IndexEntry &entry : index) {
+		maxEnd = std::max(maxEnd, entry.end);
+		entry.maxEnd = maxEnd;
+	}
+}
+
+std::pair<size_t, size_t> Selection::RangesTouching(Sci::Position start, Sci::Position end) const noexcept {
+	if (index.empty()) {
+		return { 0, ranges.size() };
+	}
+	// skip ranges that all end before start, stop at first range starts after end
+	const auto itFirst = std::partition_point(index.begin(), index.end(), [start](const IndexEntry &entry) noexcept {
+		return entry.maxEnd < start;
+	});
+	const auto itLast = std::partition_point(itFirst, index.end(), [end](const IndexEntry &entry) noexcept {
+		return entry.start <= end;
+	});
+	return { itFirst - index.begin(), itLast - index.begin() };
+}
+
 void Selection::SetRanges(const Ranges &rangesToSet) {
+	InvalidateIndex();
 	ranges = rangesToSet;
 }
 
 void Selection::Truncate(Sci::Position length) noexcept {
 	// This may be needed when applying a persisted selection onto a document that has been shortened.
+	InvalidateIndex();
 	for (SelectionRange &range : ranges) {
 		range.Truncate(length);
 	}
@@ -166,12 +166,25 @@ enum InSelection { inNone, inMain, inAdditional };
 
 class Selection {
 	using Ranges = std::vector<SelectionRange>;
+	// Ranges ordered by start with running maximum of end, built for many ranges
+	struct IndexEntry {
+		Sci::Position start;
+		Sci::Position end;
+		Sci::Position maxEnd;
+		size_t range;
+	};
 	Ranges ranges;
 	Ranges rangesSaved;
+	mutable std::vector<IndexEntry> index;
+	mutable bool indexValid = false;
 	SelectionRange rangeRectangular;
 	size_t mainRange;
 	bool moveExtends;
 	bool tentativeMain;
+	void InvalidateIndex() noexcept {
+		index.clear();
+		indexValid = false;
+	}
 public:
 	enum class SelTypes {
 		none, stream, rectangle, lines, thin
@@ -204,6 +217,7 @@ public:
 	SelectionPosition Last() const noexcept;
 	Sci::Position Length() const noexcept;
 	void MovePositions(bool insertion, Sci::Position startChange, Sci::Position length) noexcept;
+	void MoveRectangularPositions(bool insertion, Sci::Position startChange, Sci::Position length) noexcept;
 	void TrimSelection(SelectionRange range) noexcept;
 	void TrimOtherSelections(size_t r, SelectionRange range) noexcept;
 	void SetSelection(SelectionRange range) noexcept;
@@ -225,6 +239,13 @@ public:
 		return tentativeMain;
 	}
 	std::vector<SelectionRange *> SortedRanges();
+	// Index speeds up position queries while ranges are not changed
+	void BuildIndex() const;
+	// Calling RangeIndexed() for [first, last) gives ranges that may touch [start, end]
+	std::pair<size_t, size_t> RangesTouching(Sci::Position start, Sci::Position end) const noexcept;
+	size_t RangeIndexed(size_t i) const noexcept {
+		return index.empty() ? i : index[i].range;
+	}
 #if 0
 	Ranges RangesCopy() const {
 		return ranges;
@@ -37,6 +37,11 @@ public:
 		return starts.Partitions();
 	}
 
+	/// Bytes allocated for positions and values, not including memory owned by values.
+	size_t MemoryUsage() const noexcept {
+		return starts.MemoryUsage() + values.MemoryUsage();
+	}
+
 	Sci::Position PositionOfElement(Sci::Position element) const noexcept {
 		return starts.PositionFromPartition(element);
 	}
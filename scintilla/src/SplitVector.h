@@ -55,10 +55,68 @@ public:
 #endif
 };
 
-template <typename T>
+/// Character storage that reserves a large address range and commits pages on demand,
+/// so growing never copies existing characters until the reserved range is exhausted.
+/// Committed pages beyond the size can be returned with shrink_to_fit().
+class VirtualBuffer {
+	char *buffer = nullptr;
+	size_t length = 0;
+	size_t committed = 0;
+	size_t reserved = 0;
+
+	void Release() noexcept;
+
+public:
+	VirtualBuffer() noexcept = default;
+	// Deleted so VirtualBuffer objects can not be copied.
+	VirtualBuffer(const VirtualBuffer &) = delete;
+	VirtualBuffer(VirtualBuffer &&) = delete;
+	void operator=(const VirtualBuffer &) = delete;
+	void operator=(VirtualBuffer &&) = delete;
+	~VirtualBuffer() noexcept {
+		Release();
+	}
+
+	char *data() noexcept {
+		return buffer;
+	}
+	const char *data() const noexcept {
+		return buffer;
+	}
+	size_t size() const noexcept {
+		return length;
+	}
+	size_t capacity() const noexcept {
+		return committed;
+	}
+	char &operator[](size_t position) noexcept {
+		return buffer[position];
+	}
+	const char &operator[](size_t position) const noexcept {
+		return buffer[position];
+	}
+
+	void reserve(size_t newCapacity);
+	void resize(size_t newSize) {
+		reserve(newSize);
+		length = newSize;
+	}
+	void clear() noexcept {
+		length = 0;
+	}
+	/// Decommit pages after the end, release whole range when empty.
+	void shrink_to_fit() noexcept;
+};
+
+template <typename T, typename Storage = std::vector<T, default_init_allocator<T>>>
 class SplitVector {
+	// over allocation to simplify SplitView usage
+	static constexpr size_t sentinel = (sizeof(T) == sizeof(char)) ? sizeof(int) : 0;
+	// gap at end larger than this is returned to system when storage can shrink in place
+	static constexpr ptrdiff_t trimGapSize = 16*1024*1024;
+
 	// std::vector<T> body;
-	std::vector<T, default_init_allocator<T>> body;
+	Storage body;
 	ptrdiff_t lengthBody = 0;
 	ptrdiff_t part1Length = 0;
 	ptrdiff_t gapLength = 0;	/// invariant: gapLength == body.size() - lengthBody
@@ -125,6 +183,10 @@ public:
 	size_t capacity() const noexcept {
 		return body.capacity();
 	}
+	/// Bytes allocated for elements, not including memory owned by the elements.
+	size_t MemoryUsage() const noexcept {
+		return body.capacity()*sizeof(T);
+	}
 
 	size_t GetGrowSize() const noexcept {
 		return growSize;
@@ -138,8 +200,6 @@ public:
 	/// copy existing contents to the new buffer.
 	/// Must not be used to decrease the size of the buffer.
 	void ReAllocate(size_t newSize) {
-		// over allocation to simplify SplitView usage
-		constexpr size_t sentinel = (sizeof(T) == sizeof(char)) ? sizeof(int) : 0;
 		newSize += sentinel;
 		const size_t size = body.size();
 		if (newSize > size) {
@@ -358,6 +418,14 @@ public:
 			GapTo(position);
 			lengthBody -= deleteLength;
 			gapLength += deleteLength;
+			if constexpr (std::is_same_v<Storage, VirtualBuffer>) {
+				if (part1Length == lengthBody && gapLength > trimGapSize) {
+					// deleted the tail, give back memory without copying
+					gapLength = growSize;
+					body.resize(lengthBody + gapLength + sentinel);
+					body.shrink_to_fit();
+				}
+			}
 		}
 	}
 
@@ -206,6 +206,91 @@ size_t ScaledVector::SizeInBytes() const noexcept {
 	return bytes.size();
 }
 
+// decode first length values of block into cache, returns offset after last difference
+size_t DeltaVector::DecodeBlock(size_t block, size_t length) const noexcept {
+	size_t value = blocks[block].value;
+	size_t offset = blocks[block].offset;
+	cache[0] = value;
+	for (size_t i = 1; i < length; i++) {
+		size_t zigzag = 0;
+		unsigned shift = 0;
+		uint8_t ch;
+		do {
+			ch = bytes[offset++];
+			zigzag |= static_cast<size_t>(ch & 0x7f) << shift;
+			shift += 7;
+		} while (ch & 0x80);
+		value += (zigzag >> 1) ^ (0 - (zigzag & 1));
+		cache[i] = value;
+	}
+	cacheBlock = block;
+	cacheCount = length;
+	return offset;
+}
+
+size_t DeltaVector::ValueAt(size_t index) const noexcept {
+	const size_t block = index / deltaBlockSize;
+	const size_t within = index % deltaBlockSize;
+	if (block != cacheBlock || within >= cacheCount) {
+		DecodeBlock(block, std::min(deltaBlockSize, count - block*deltaBlockSize));
+	}
+	return cache[within];
+}
+
+void DeltaVector::PushBack(size_t value) {
+	const size_t within = count % deltaBlockSize;
+	if (within == 0) {
+		blocks.push_back({ value, bytes.size() });
+	} else {
+		// zigzag encoding for signed difference, then 7 bits in each byte
+		const intptr_t delta = value - lastValue;
+		size_t zigzag = (static_cast<size_t>(delta) << 1) ^ static_cast<size_t>(delta >> (sizeof(intptr_t)*8 - 1));
+		uint8_t buffer[(sizeof(size_t)*8 + 6) / 7];
+		size_t length = 0;
+		while (zigzag >= 0x80) {
+			buffer[length++] = static_cast<uint8_t>(zigzag | 0x80);
+			zigzag >>= 7;
+		}
+		buffer[length++] = static_cast<uint8_t>(zigzag);
+		bytes.insert(bytes.end(), buffer, buffer + length);
+	}
+	if (cacheBlock == count / deltaBlockSize && cacheCount == within) {
+		cache[within] = value;
+		cacheCount++;
+	}
+	lastValue = value;
+	count++;
+}
+
+void DeltaVector::Clear() noexcept {
+	blocks.clear();
+	bytes.clear();
+	count = 0;
+	lastValue = 0;
+	cacheBlock = SIZE_MAX;
+}
+
+void DeltaVector::Truncate(size_t length) noexcept {
+	if (length >= count) {
+		return;
+	}
+	if (length == 0) {
+		Clear();
+		return;
+	}
+	const size_t block = (length - 1) / deltaBlockSize;
+	const size_t within = length - block*deltaBlockSize;
+	const size_t offset = DecodeBlock(block, within);
+	lastValue = cache[within - 1];
+	count = length;
+	VectorTruncate(blocks, block + 1);
+	VectorTruncate(bytes, offset);
+}
+
+size_t DeltaVector::SizeInBytes() const noexcept {
+	return blocks.size()*sizeof(Block) + bytes.size();
+}
+
 UndoActions::UndoActions() noexcept = default;
 
 void UndoActions::Truncate(size_t length) noexcept {
@@ -217,7 +302,6 @@ void UndoActions::Truncate(size_t length) noexcept {
 
 void UndoActions::PushBack() {
 	types.emplace_back();
-	positions.PushBack();
 	lengths.PushBack();
 }
 
@@ -234,7 +318,9 @@ intptr_t UndoActions::SSize() const noexcept {
 void UndoActions::Create(size_t index, ActionType at_, Sci::Position position_, Sci::Position lenData_, bool mayCoalesce_) {
 	types[index].at = at_;
 	types[index].mayCoalesce = mayCoalesce_;
-	positions.SetValueAt(index, position_);
+	// only last action is created, position of replaced action is dropped
+	positions.Truncate(index);
+	positions.PushBack(position_);
 	lengths.SetValueAt(index, lenData_);
 }
 
@@ -261,42 +347,337 @@ Sci::Position UndoActions::Length(int action) const noexcept {
 	return lengths.SignedValueAt(action);
 }
 
+namespace {
+
+// LZ4 like block compression for text of old undo actions
+constexpr size_t minMatch = 4;
+constexpr int hashBits = 12;
+constexpr size_t maxMatchOffset = UINT16_MAX;
+constexpr size_t tokenMask = 15;
+
+constexpr size_t CompressBound(size_t length) noexcept {
+	return length + length/255 + 16;
+}
+
+inline uint32_t HashSequence(const uint8_t *ptr) noexcept {
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(value));
+	return (value * 2654435761U) >> (32 - hashBits);
+}
+
+uint8_t *WriteLength(uint8_t *op, size_t length) noexcept {
+	while (length >= UINT8_MAX) {
+		*op++ = UINT8_MAX;
+		length -= UINT8_MAX;
+	}
+	*op++ = static_cast<uint8_t>(length);
+	return op;
+}
+
+uint8_t *WriteSequence(uint8_t *op, const uint8_t *literal, size_t literalLength, size_t matchLength) noexcept {
+	*op++ = static_cast<uint8_t>((std::min(literalLength, tokenMask) << 4) | std::min(matchLength, tokenMask));
+	if (literalLength >= tokenMask) {
+		op = WriteLength(op, literalLength - tokenMask);
+	}
+	memcpy(op, literal, literalLength);
+	return op + literalLength;
+}
+
+size_t CompressText(const char *text, size_t length, char *output) noexcept {
+	const uint8_t * const begin = reinterpret_cast<const uint8_t *>(text);
+	const uint8_t * const end = begin + length;
+	const uint8_t * const limit = (length > minMatch) ? end - minMatch : begin;
+	uint8_t * const start = reinterpret_cast<uint8_t *>(output);
+	uint8_t *op = start;
+	const uint8_t *ip = begin;
+	const uint8_t *anchor = begin;
+	uint32_t table[1 << hashBits]{};
+	while (ip < limit) {
+		const uint32_t hash = HashSequence(ip);
+		const uint8_t *ref = begin + table[hash];
+		table[hash] = static_cast<uint32_t>(ip - begin);
+		if (ref >= ip || static_cast<size_t>(ip - ref) > maxMatchOffset || memcmp(ref, ip, minMatch) != 0) {
+			// skip faster over incompressible text
+			ip += 1 + ((ip - anchor) >> 6);
+			continue;
+		}
+		const size_t offset = ip - ref;
+		const uint8_t *matchEnd = ip + minMatch;
+		ref += minMatch;
+		while (matchEnd < end && *matchEnd == *ref) {
+			++matchEnd;
+			++ref;
+		}
+		const size_t matchLength = matchEnd - ip - minMatch;
+		op = WriteSequence(op, anchor, ip - anchor, matchLength);
+		*op++ = static_cast<uint8_t>(offset);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+		if (matchLength >= tokenMask) {
+			op = WriteLength(op, matchLength - tokenMask);
+		}
+		ip = matchEnd;
+		anchor = ip;
+	}
+	op = WriteSequence(op, anchor, end - anchor, 0);
+	return op - start;
+}
+
+size_t ReadLength(const uint8_t *&ip, size_t length) noexcept {
+	if (length == tokenMask) {
+		uint8_t value;
+		do {
+			value = *ip++;
+			length += value;
+		} while (value == UINT8_MAX);
+	}
+	return length;
+}
+
+void DecompressText(const char *data, size_t dataLength, char *text) noexcept {
+	const uint8_t *ip = reinterpret_cast<const uint8_t *>(data);
+	const uint8_t * const end = ip + dataLength;
+	char *op = text;
+	while (ip < end) {
+		const uint8_t token = *ip++;
+		const size_t literalLength = ReadLength(ip, token >> 4);
+		memcpy(op, ip, literalLength);
+		ip += literalLength;
+		op += literalLength;
+		if (ip >= end) {
+			break;
+		}
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		const size_t matchLength = ReadLength(ip, token & tokenMask) + minMatch;
+		// overlapped copy repeats the pattern
+		const char *ref = op - offset;
+		for (size_t i = 0; i < matchLength; i++) {
+			op[i] = ref[i];
+		}
+		op += matchLength;
+	}
+}
+
+int SeekFile(FILE *fp, int64_t offset) noexcept {
+#if defined(_WIN32)
+	return _fseeki64(fp, offset, SEEK_SET);
+#else
+	return fseeko(fp, offset, SEEK_SET);
+#endif
+}
+
+constexpr size_t minSegmentSize = 64*1024;
+constexpr size_t maxSegmentSize = 16*1024*1024;
+
+}
+
+ScrapStack::~ScrapStack() noexcept {
+	if (spillFile) {
+		fclose(spillFile);
+	}
+}
+
 void ScrapStack::Clear() noexcept {
 	stack.clear();
 	current = 0;
+	base = 0;
+	compressedMemory = 0;
+	spilledSegments = 0;
+	segments.clear();
+	spillEnd = 0;
+	cachedSegment = SIZE_MAX;
+	cachedText.clear();
+	extractText.clear();
 }
 
 const char *ScrapStack::Push(const char *text, size_t length) {
-	if (current < stack.length()) {
-		stack.resize(current);
+	if (current < base + stack.length()) {
+		stack.resize(current - base);
 	}
 	stack.append(text, length);
-	current = stack.length();
-	return stack.data() + current - length;
+	current = base + stack.length();
+	return stack.data() + stack.length() - length;
 }
 
-void ScrapStack::SetCurrent(size_t position) noexcept {
+void ScrapStack::SetCurrent(size_t position) {
+	while (position < base) {
+		Restore();
+	}
 	current = position;
 }
 
 void ScrapStack::MoveForward(size_t length) noexcept {
-	if ((current + length) <= stack.length()) {
+	if ((current + length) <= base + stack.length()) {
 		current += length;
 	}
 }
 
 void ScrapStack::MoveBack(size_t length) noexcept {
-	if (current >= length) {
+	if (current >= base + length) {
 		current -= length;
 	}
 }
 
 const char *ScrapStack::CurrentText() const noexcept {
-	return stack.data() + current;
+	return stack.data() + (current - base);
 }
 
-const char *ScrapStack::TextAt(size_t position) const noexcept {
-	return stack.data() + position;
+std::string_view ScrapStack::TextAt(size_t position, size_t length) {
+	if (position >= base) {
+		return {stack.data() + (position - base), length};
+	}
+	// copy from segments without restoring them
+	extractText.clear();
+	size_t index = std::upper_bound(segments.begin(), segments.end(), position, [](size_t pos, const Segment &segment) noexcept {
+		return pos < segment.start;
+	}) - segments.begin() - 1;
+	while (length != 0) {
+		if (position >= base) {
+			extractText.append(stack.data() + (position - base), length);
+			break;
+		}
+		const Segment &segment = segments[index];
+		if (cachedSegment != index) {
+			cachedSegment = SIZE_MAX;
+			LoadSegment(index, cachedText);
+			cachedSegment = index;
+		}
+		const size_t offset = position - segment.start;
+		const size_t lengthCopy = std::min(length, segment.length - offset);
+		if (lengthCopy == length && extractText.empty()) {
+			return {cachedText.data() + offset, length};
+		}
+		extractText.append(cachedText.data() + offset, lengthCopy);
+		position += lengthCopy;
+		length -= lengthCopy;
+		++index;
+	}
+	return extractText;
+}
+
+void ScrapStack::LoadBefore(size_t length) {
+	const size_t position = (length < current) ? current - length : 0;
+	while (position < base) {
+		Restore();
+	}
+}
+
+size_t ScrapStack::SegmentSize() const noexcept {
+	return std::clamp(memoryLimit/8, minSegmentSize, maxSegmentSize);
+}
+
+void ScrapStack::Compact(size_t keep) noexcept {
+	if (memoryLimit == 0) {
+		return;
+	}
+	const size_t segmentSize = SegmentSize();
+	// recent text before current is kept uncompressed for quick undo
+	keep = std::min(keep, current);
+	if (stack.length() > memoryLimit/2 && keep >= base + 2*segmentSize) {
+		size_t length = 0;
+		try {
+			std::string buffer(CompressBound(segmentSize), '\0');
+			while (stack.length() - length > memoryLimit/2 && keep >= base + length + 2*segmentSize) {
+				const char * const text = stack.data() + length;
+				const size_t compressedLength = CompressText(text, segmentSize, buffer.data());
+				Segment segment { base + length, segmentSize, {}, compressedLength, -1 };
+				if (compressedLength < segmentSize) {
+					segment.data.assign(buffer.data(), compressedLength);
+				} else {
+					// stored as is
+					segment.compressedLength = segmentSize;
+					segment.data.assign(text, segmentSize);
+				}
+				segments.push_back(std::move(segment));
+				compressedMemory += segments.back().compressedLength;
+				length += segmentSize;
+			}
+		} catch (...) {
+			// keep remaining text uncompressed
+		}
+		stack.erase(0, length);
+		base += length;
+		if (stack.capacity() > 2*stack.length() + segmentSize) {
+			stack.shrink_to_fit();
+		}
+	}
+	Spill();
+}
+
+void ScrapStack::Spill() noexcept {
+	while (compressedMemory > memoryLimit/2 && spilledSegments < segments.size()) {
+		if (!spillFile) {
+			spillFile = tmpfile();
+			if (!spillFile) {
+				return;
+			}
+		}
+		Segment &segment = segments[spilledSegments];
+		if (SeekFile(spillFile, spillEnd) != 0
+			|| fwrite(segment.data.data(), 1, segment.compressedLength, spillFile) != segment.compressedLength) {
+			return;
+		}
+		segment.fileOffset = spillEnd;
+		spillEnd += segment.compressedLength;
+		compressedMemory -= segment.compressedLength;
+		segment.data.clear();
+		segment.data.shrink_to_fit();
+		++spilledSegments;
+	}
+}
+
+void ScrapStack::LoadSegment(size_t index, std::string &text) const {
+	const Segment &segment = segments[index];
+	std::string data;
+	const char *compressed = segment.data.data();
+	if (segment.fileOffset >= 0) {
+		data.resize(segment.compressedLength);
+		if (SeekFile(spillFile, segment.fileOffset) != 0
+			|| fread(data.data(), 1, segment.compressedLength, spillFile) != segment.compressedLength) {
+			throw std::runtime_error("ScrapStack::LoadSegment: failed to read undo text.");
+		}
+		compressed = data.data();
+	}
+	text.resize(segment.length);
+	if (segment.compressedLength == segment.length) {
+		memcpy(text.data(), compressed, segment.length);
+	} else {
+		DecompressText(compressed, segment.compressedLength, text.data());
+	}
+}
+
+void ScrapStack::Restore() {
+	const size_t index = segments.size() - 1;
+	std::string text;
+	if (cachedSegment == index) {
+		text.swap(cachedText);
+		cachedSegment = SIZE_MAX;
+	} else {
+		LoadSegment(index, text);
+	}
+	stack.insert(0, text);
+	const Segment &segment = segments.back();
+	base = segment.start;
+	if (segment.fileOffset >= 0) {
+		// reuse file space for next spilled segment
+		spillEnd = segment.fileOffset;
+		--spilledSegments;
+	} else {
+		compressedMemory -= segment.compressedLength;
+	}
+	segments.pop_back();
+}
+
+void ScrapStack::SetMemoryLimit(size_t limit) noexcept {
+	memoryLimit = limit;
+}
+
+size_t ScrapStack::MemoryLimit() const noexcept {
+	return memoryLimit;
+}
+
+size_t ScrapStack::MemoryUsage() const noexcept {
+	return stack.capacity() + compressedMemory + cachedText.capacity() + extractText.capacity();
 }
 
 // The undo history stores a sequence of user operations that represent the user's view of the
@@ -402,10 +783,20 @@ const char *UndoHistory::AppendAction(ActionType at, Sci::Position position, con
 	}
 	actions.Create(currentAction, at, position, lengthData, mayCoalesce);
 	currentAction++;
-	const char *dataNew = lengthData ? scraps->Push(data, lengthData) : nullptr;
+	const char *dataNew = nullptr;
+	if (lengthData) {
+		CompactScraps();
+		dataNew = scraps->Push(data, lengthData);
+	}
 	return dataNew;
 }
 
+void UndoHistory::CompactScraps() noexcept {
+	// text of tentative actions is needed by TentativeUndo() without loading
+	const size_t keep = (tentativePoint >= 0) ? actions.LengthTo(tentativePoint) : SIZE_MAX;
+	scraps->Compact(keep);
+}
+
 void UndoHistory::BeginUndoAction(bool mayCoalesce) noexcept {
 	if (undoSequenceDepth == 0) {
 		if (currentAction > 0) {
@@ -586,9 +977,12 @@ std::string_view UndoHistory::Text(int action) noexcept {
 		position += actions.Length(act);
 	}
 	const size_t length = actions.Length(action);
-	const char *scrap = scraps->TextAt(position);
 	memory = {action, position};
-	return {scrap, length};
+	try {
+		return scraps->TextAt(position, length);
+	} catch (...) {
+		return {};
+	}
 }
 
 void UndoHistory::PushUndoActionType(int type, Sci::Position position) {
@@ -600,9 +994,24 @@ void UndoHistory::PushUndoActionType(int type, Sci::Position position) {
 void UndoHistory::ChangeLastUndoActionText(size_t length, const char *text) {
 	assert(actions.lengths.ValueAt(actions.SSize() - 1) == 0);
 	actions.lengths.SetValueAt(actions.SSize() - 1, length);
+	CompactScraps();
 	scraps->Push(text, length);
 }
 
+void UndoHistory::SetMemoryLimit(size_t limit) noexcept {
+	scraps->SetMemoryLimit(limit);
+	CompactScraps();
+}
+
+size_t UndoHistory::MemoryLimit() const noexcept {
+	return scraps->MemoryLimit();
+}
+
+size_t UndoHistory::MemoryUsage() const noexcept {
+	return scraps->MemoryUsage() + actions.types.capacity()*sizeof(UndoActionType)
+		+ actions.positions.SizeInBytes() + actions.lengths.SizeInBytes();
+}
+
 void UndoHistory::SetTentative(int action) noexcept {
 	tentativePoint = action;
 }
@@ -636,7 +1045,7 @@ bool UndoHistory::CanUndo() const noexcept {
 	return (currentAction > 0) && (actions.SSize() != 0);
 }
 
-int UndoHistory::StartUndo() const noexcept {
+int UndoHistory::StartUndo() noexcept {
 	assert(currentAction >= 0);
 
 	// Count the steps in this action
@@ -645,8 +1054,16 @@ int UndoHistory::StartUndo() const noexcept {
 	}
 
 	int act = currentAction - 1;
+	size_t lengthSteps = actions.Length(act);
 	while (act > 0 && !actions.AtStart(act)) {
 		act--;
+		lengthSteps += actions.Length(act);
+	}
+	try {
+		// restore compressed text for these steps
+		scraps->LoadBefore(lengthSteps);
+	} catch (...) {
+		return 0;
 	}
 	return currentAction - act;
 }
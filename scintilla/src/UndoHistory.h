@@ -38,6 +38,43 @@ public:
 	[[nodiscard]] size_t SizeInBytes() const noexcept;
 };
 
+// DeltaVector stores positions as variable length differences from the previous position,
+// with an absolute position every deltaBlockSize elements for random access.
+// Positions of consecutive actions are usually close, including actions of multiple carets
+// in one group, so most differences take 1 or 2 bytes.
+
+constexpr size_t deltaBlockSize = 32;
+
+class DeltaVector {
+	struct Block {
+		size_t value;	// first value in block
+		size_t offset;	// offset of following differences in bytes
+	};
+	std::vector<Block> blocks;
+	std::vector<uint8_t> bytes;
+	size_t count = 0;
+	size_t lastValue = 0;
+	// values of one block are decoded on access, undo and redo read actions in sequence
+	mutable size_t cacheBlock = SIZE_MAX;
+	mutable size_t cacheCount = 0;
+	mutable size_t cache[deltaBlockSize];
+
+	size_t DecodeBlock(size_t block, size_t length) const noexcept;
+public:
+	[[nodiscard]] size_t Size() const noexcept {
+		return count;
+	}
+	[[nodiscard]] size_t ValueAt(size_t index) const noexcept;
+	[[nodiscard]] intptr_t SignedValueAt(size_t index) const noexcept {
+		return ValueAt(index);
+	}
+	void PushBack(size_t value);
+	void Clear() noexcept;
+	void Truncate(size_t length) noexcept;
+
+	[[nodiscard]] size_t SizeInBytes() const noexcept;
+};
+
 class UndoActionType {
 public:
 	ActionType at = ActionType::insert;
@@ -46,7 +83,7 @@ public:
 
 struct UndoActions {
 	std::vector<UndoActionType> types;
-	ScaledVector positions;
+	DeltaVector positions;
 	ScaledVector lengths;
 
 	UndoActions() noexcept;
@@ -61,17 +98,58 @@ struct UndoActions {
 	[[nodiscard]] Sci::Position Length(int action) const noexcept;
 };
 
+// With a memory limit, old text is compressed into segments, and compressed segments
+// are written to a temporary file when they exceed half of the limit.
+// Segments are restored when undo reaches them.
+
 class ScrapStack {
-	std::string stack;
+	struct Segment {
+		size_t start;
+		size_t length;
+		std::string data;	// compressed text, empty after written to file
+		size_t compressedLength;
+		int64_t fileOffset;
+	};
+	std::string stack;	// text after base
 	size_t current = 0;
+	size_t base = 0;
+	size_t memoryLimit = 0;
+	size_t compressedMemory = 0;
+	size_t spilledSegments = 0;
+	std::vector<Segment> segments;
+	FILE *spillFile = nullptr;
+	int64_t spillEnd = 0;
+	size_t cachedSegment = SIZE_MAX;
+	std::string cachedText;
+	std::string extractText;
+
+	[[nodiscard]] size_t SegmentSize() const noexcept;
+	void Spill() noexcept;
+	void LoadSegment(size_t index, std::string &text) const;
+	void Restore();
 public:
+	ScrapStack() noexcept = default;
+	// Deleted so ScrapStack objects can not be copied.
+	ScrapStack(const ScrapStack &) = delete;
+	ScrapStack(ScrapStack &&) = delete;
+	ScrapStack &operator=(const ScrapStack &) = delete;
+	ScrapStack &operator=(ScrapStack &&) = delete;
+	~ScrapStack() noexcept;
+
 	void Clear() noexcept;
 	const char *Push(const char *text, size_t length);
-	void SetCurrent(size_t position) noexcept;
+	void SetCurrent(size_t position);
 	void MoveForward(size_t length) noexcept;
 	void MoveBack(size_t length) noexcept;
 	[[nodiscard]] const char *CurrentText() const noexcept;
-	[[nodiscard]] const char *TextAt(size_t position) const noexcept;
+	[[nodiscard]] std::string_view TextAt(size_t position, size_t length);
+	/// Ensure text before current with length is in memory.
+	void LoadBefore(size_t length);
+	/// Compress old text not after keep when exceeding the memory limit.
+	void Compact(size_t keep) noexcept;
+	void SetMemoryLimit(size_t limit) noexcept;
+	[[nodiscard]] size_t MemoryLimit() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
 };
 
 constexpr int coalesceFlag = 0x100;
@@ -91,6 +169,7 @@ class UndoHistory final {
 	std::optional<actPos> memory;
 
 	int PreviousAction() const noexcept;
+	void CompactScraps() noexcept;
 
 public:
 	UndoHistory();
@@ -135,6 +214,11 @@ public:
 	void PushUndoActionType(int type, Sci::Position position);
 	void ChangeLastUndoActionText(size_t length, const char *text);
 
+	/// Text held in memory is limited by compressing it and writing it to a temporary file.
+	void SetMemoryLimit(size_t limit) noexcept;
+	[[nodiscard]] size_t MemoryLimit() const noexcept;
+	[[nodiscard]] size_t MemoryUsage() const noexcept;
+
 	// Tentative actions are used for input composition so that it can be undone cleanly
 	void SetTentative(int action) noexcept;
 	[[nodiscard]] int TentativePoint() const noexcept;
@@ -146,7 +230,7 @@ public:
 	/// To perform an undo, StartUndo is called to retrieve the number of steps, then UndoStep is
 	/// called that many times. Similarly for redo.
 	bool CanUndo() const noexcept;
-	int StartUndo() const noexcept;
+	int StartUndo() noexcept;
 	Action GetUndoStep() const noexcept;
 	void CompletedUndoStep() noexcept;
 	bool CanRedo() const noexcept;
@@ -51,7 +51,7 @@ size_t UTF8PositionFromUTF16Position(std::string_view u8Text, size_t positionUTF
 #define SURROGATE_OFFSET			(0x10000 - (0xD800 << 10) - 0xDC00)
 #define UTF16_TO_UTF32(lead, trail)	(((lead) << 10) + (trail) + SURROGATE_OFFSET)
 
-void UTF8FromUTF16(std::wstring_view wsv, char *putf, size_t len) noexcept {
+size_t UTF8FromUTF16(std::wstring_view wsv, char *putf, size_t len) noexcept {
 	size_t k = 0;
 	for (size_t i = 0; i < wsv.length() && wsv[i];) {
 		const unsigned int uch = wsv[i];
@@ -78,6 +78,7 @@ void UTF8FromUTF16(std::wstring_view wsv, char *putf, size_t len) noexcept {
 	if (k < len) {
 		putf[k] = '\0';
 	}
+	return k;
 }
 
 void UTF8FromUTF32Character(int uch, char *putf) noexcept {
@@ -18,11 +18,13 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <tuple>
 #include <optional>
 #include <algorithm>
 #include <memory>
 #include <numeric>
 
+#include "ParallelSupport.h"
 #include "ScintillaTypes.h"
 
 #include "Debugging.h"
@@ -155,6 +157,70 @@ void FontRealised::Realise(Surface &surface, int zoomLevel, Technology technolog
 	}
 }
 
+namespace {
+
+struct FontCacheKey {
+	std::string fontName;
+	std::string localeName;
+	int sizeZoomed;
+	int logPixelsY;
+	FontWeight weight;
+	FontStretch stretch;
+	bool italic;
+	CharacterSet characterSet;
+	FontQuality extraFontFlag;
+	Technology technology;
+	bool operator<(const FontCacheKey &other) const noexcept {
+		return std::tie(sizeZoomed, logPixelsY, weight, stretch, italic, characterSet, extraFontFlag, technology, fontName, localeName)
+			< std::tie(other.sizeZoomed, other.logPixelsY, other.weight, other.stretch, other.italic, other.characterSet, other.extraFontFlag, other.technology, other.fontName, other.localeName);
+	}
+};
+
+// Fonts no longer used by any view are kept for switching back (e.g. scheme or monitor DPI),
+// and only removed when the cache becomes large or resources are released.
+constexpr size_t maxFontCacheSize = 128;
+NativeMutex fontCacheMutex;
+std::map<FontCacheKey, std::shared_ptr<FontRealised>> fontCache;
+
+void ReleaseUnusedFonts() noexcept {
+	for (auto it = fontCache.begin(); it != fontCache.end();) {
+		if (it->second.use_count() == 1) {
+			it = fontCache.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+}
+
+std::shared_ptr<FontRealised> FontRealised::Acquire(Surface &surface, int zoomLevel, Technology technology, const FontSpecification &fs, const char *localeName) {
+	FontCacheKey key { fs.fontName, localeName, GetFontSizeZoomed(fs.size, zoomLevel), surface.LogPixelsY(),
+		fs.weight, fs.stretch, fs.italic, fs.characterSet, fs.extraFontFlag, technology };
+	const LockGuard<NativeMutex> guard(fontCacheMutex);
+	const auto it = fontCache.find(key);
+	if (it != fontCache.end()) {
+		return it->second;
+	}
+	if (fontCache.size() >= maxFontCacheSize) {
+		ReleaseUnusedFonts();
+	}
+	std::shared_ptr<FontRealised> fr = std::make_shared<FontRealised>();
+	fr->Realise(surface, zoomLevel, technology, fs, localeName);
+	fontCache.emplace(std::move(key), fr);
+	return fr;
+}
+
+void FontRealised::ReleaseUnused() noexcept {
+	const LockGuard<NativeMutex> guard(fontCacheMutex);
+	ReleaseUnusedFonts();
+}
+
+void FontRealised::ReleaseAll() noexcept {
+	const LockGuard<NativeMutex> guard(fontCacheMutex);
+	fontCache.clear();
+}
+
 ViewStyle::ViewStyle(size_t stylesSize_):
 	styles(stylesSize_),
 	markers(MarkerMax + 1),
@@ -264,6 +330,7 @@ ViewStyle::ViewStyle(size_t stylesSize_):
 	marginInside = true;
 	leftMarginWidth = 1;
 	rightMarginWidth = 1;
+	overviewRulerWidth = 0;
 	ms[0] = MarginStyle(MarginType::Number);
 	constexpr int widthMarks = 16;
 	ms[1] = MarginStyle(MarginType::Symbol, widthMarks, ~MaskFolders);
@@ -336,6 +403,7 @@ ViewStyle::ViewStyle(const ViewStyle &source) : ViewStyle(source.styles.size())
 	marginInside = source.marginInside;
 	leftMarginWidth = source.leftMarginWidth;
 	rightMarginWidth = source.rightMarginWidth;
+	overviewRulerWidth = source.overviewRulerWidth;
 	maskInLine = source.maskInLine;
 	maskDrawInText = source.maskDrawInText;
 	maskDrawWrapped = source.maskDrawWrapped;
@@ -418,6 +486,8 @@ void ViewStyle::CalculateMarginWidthAndMask() noexcept {
 void ViewStyle::Refresh(Surface &surface, int tabInChars) {
 	if (!fontsValid) {
 		fontsValid = true;
+		// keep previous fonts alive until same fonts are acquired again from font cache
+		const FontMap previousFonts = std::move(fonts);
 		fonts.clear();
 
 		// Apply the extra font flag which controls text drawing quality to each style.
@@ -428,9 +498,9 @@ void ViewStyle::Refresh(Surface &surface, int tabInChars) {
 			CreateAndAddFont(style);
 		}
 
-		// Ask platform to allocate each unique font.
-		for (const auto &font : fonts) {
-			font.second->Realise(surface, zoomLevel, technology, font.first, localeName.c_str());
+		// Ask platform to allocate each unique font, or reuse font realised by any view.
+		for (auto &font : fonts) {
+			font.second = FontRealised::Acquire(surface, zoomLevel, technology, font.first, localeName.c_str());
 		}
 
 		// Set the platform font handle and measurements for each style.
@@ -552,6 +622,24 @@ void ViewStyle::CopyStyles(size_t sourceIndex, size_t destStyles) noexcept {
 	} while (destStyles);
 }
 
+// whether other styles would lay out text the same, only colours or decorations differ.
+bool ViewStyle::SameLayoutStyles(const std::vector<Style> &other) const noexcept {
+	if (styles.size() != other.size()) {
+		return false;
+	}
+	for (size_t index = 0; index < styles.size(); index++) {
+		const Style &style = styles[index];
+		const Style &previous = other[index];
+		if (!(static_cast<const FontSpecification &>(style) == previous)
+			|| style.caseForce != previous.caseForce
+			|| style.visible != previous.visible
+			|| style.GetInvisibleRepresentation() != previous.GetInvisibleRepresentation()) {
+			return false;
+		}
+	}
+	return true;
+}
+
 void ViewStyle::SetStyleFontName(int styleIndex, const char *name) {
 	fontsValid = false;
 	styles[styleIndex].fontName = fontNames.Save(name);
@@ -859,7 +947,7 @@ void ViewStyle::CreateAndAddFont(const FontSpecification &fs) {
 	if (fs.fontName) {
 		const auto it = fonts.find(fs);
 		if (it == fonts.end()) {
-			fonts.emplace(fs, std::make_unique<FontRealised>());
+			fonts.emplace(fs, nullptr);
 		}
 	}
 }
@@ -32,9 +32,13 @@ public:
 	FontMeasurements measurements;
 	std::shared_ptr<Font> font;
 	void Realise(Surface &surface, int zoomLevel, Scintilla::Technology technology, const FontSpecification &fs, const char *localeName);
+	// Realised fonts are shared by all views in the process through a cache keyed by font parameters and DPI.
+	static std::shared_ptr<FontRealised> Acquire(Surface &surface, int zoomLevel, Scintilla::Technology technology, const FontSpecification &fs, const char *localeName);
+	static void ReleaseUnused() noexcept;
+	static void ReleaseAll() noexcept;
 };
 
-using FontMap = std::map<FontSpecification, std::unique_ptr<FontRealised>>;
+using FontMap = std::map<FontSpecification, std::shared_ptr<FontRealised>>;
 using ColourOptional = std::optional<ColourRGBA>;
 
 constexpr int GetFontSizeZoomed(int size, int zoomLevel) noexcept {
@@ -147,6 +151,7 @@ public:
 	/// Margins are ordered: Line Numbers, Selection Margin, Spacing Margin
 	int leftMarginWidth;	///< Spacing margin on left of text
 	int rightMarginWidth;	///< Spacing margin on right of text
+	int overviewRulerWidth;	///< Overview ruler on right of spacing margin
 	MarkerMask maskInLine = 0;	///< Mask for markers to be put into text because there is nowhere for them to go in margin
 	MarkerMask maskDrawInText = 0;///< Mask for markers that always draw in text
 	MarkerMask maskDrawWrapped = 0;	///< Mask for markers that draw on wrapped lines
@@ -213,10 +218,15 @@ public:
 	void EnsureStyle(size_t index) const noexcept;
 	void ResetDefaultStyle();
 	void ClearStyles() noexcept;
+	bool SameLayoutStyles(const std::vector<Style> &other) const noexcept;
 	void SetStyleFontName(int styleIndex, const char *name);
 	void SetFontLocaleName(const char *name);
 	bool ProtectionActive() const noexcept;
 	int ExternalMarginWidth() const noexcept;
+	// right margin and overview ruler are not covered by text
+	int RightSideWidth() const noexcept {
+		return rightMarginWidth + overviewRulerWidth;
+	}
 	int SCICALL MarginFromLocation(Point pt) const noexcept;
 	bool ValidStyle(size_t styleIndex) const noexcept;
 	void CalcLargestMarkerHeight() noexcept;
@@ -0,0 +1,531 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <stdexcept>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <optional>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+
+#include <windows.h>
+
+#include "ParallelSupport.h"
+#include "ScintillaTypes.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Debugging.h"
+#include "Geometry.h"
+#include "Platform.h"
+#include "CharacterSet.h"
+#include "Position.h"
+#include "UniqueString.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "ContractionState.h"
+#include "CellBuffer.h"
+#include "UndoHistory.h"
+#include "Indicator.h"
+#include "LineMarker.h"
+#include "Style.h"
+#include "ViewStyle.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "Selection.h"
+#include "PositionCache.h"
+#include "EditModel.h"
+#include "ElapsedPeriod.h"
+
+// Micro benchmarks for core data structures, prints ns/op and allocations for each case.
+// CoreBenchmark [--json] [scale]
+// scale multiplies operation count of each case, JSON output is one object per case for trend tracking.
+// cl /utf-8 /EHsc /std:c++20 /DNDEBUG /O2 /GS- /GR- /W4 /arch:AVX2 /I../include /I../src /I../lexlib CoreBenchmark.cpp
+//	../src/Document.cxx ../src/CellBuffer.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx
+//	../src/UndoHistory.cxx ../src/ChangeHistory.cxx ../src/SearchIndex.cxx ../src/BraceIndex.cxx ../src/BackgroundStyler.cxx ../src/CharClassify.cxx
+//	../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../src/PositionCache.cxx
+//	../src/EditModel.cxx ../src/ContractionState.cxx ../src/Selection.cxx ../src/ViewStyle.cxx ../src/Style.cxx
+//	../src/Indicator.cxx ../src/LineMarker.cxx ../src/XPM.cxx ../src/Geometry.cxx ../src/UniqueString.cxx
+//	../win32/PlatWin.cxx ../lexlib/*.cxx user32.lib gdi32.lib ole32.lib imm32.lib
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+
+namespace Scintilla::Internal {
+
+// defined in ScintillaBase.cxx, no lexer is used.
+void Document::HighlightUrl([[maybe_unused]] Sci_PositionU startPos, [[maybe_unused]] Sci_Position length, [[maybe_unused]] const uint32_t (&urlIgnoreStyle)[8]) {}
+
+}
+
+namespace {
+
+size_t allocationCount = 0;
+size_t allocationBytes = 0;
+
+// simple deterministic generator, so each run edits the same positions.
+struct Random {
+	uint64_t state;
+	explicit Random(uint64_t seed) noexcept : state{seed} {}
+	uint32_t Next() noexcept {
+		state = state*6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<uint32_t>(state >> 33);
+	}
+	ptrdiff_t Next(ptrdiff_t range) noexcept {
+		return range ? static_cast<ptrdiff_t>(Next() % static_cast<uint64_t>(range)) : 0;
+	}
+};
+
+struct Result {
+	const char *name;
+	size_t ops;
+	double duration;
+	size_t allocations;
+	size_t bytes;
+	double NanosecondsPerOp() const noexcept {
+		return duration*1e9 / static_cast<double>(std::max<size_t>(ops, 1));
+	}
+};
+
+std::vector<Result> results;
+bool jsonOutput = false;
+size_t checksum = 0;	// consumed by main() to keep results of lookup loops alive
+
+// setup outside of body is not measured.
+template <typename Body>
+void Measure(const char *name, size_t ops, Body body) {
+	const size_t allocations = allocationCount;
+	const size_t bytes = allocationBytes;
+	const ElapsedPeriod period;
+	body();
+	const double duration = period.Duration();
+	const Result &result = results.emplace_back(name, ops, duration, allocationCount - allocations, allocationBytes - bytes);
+	if (!jsonOutput) {
+		printf("%-32s %12.3f %12zu %12zu\n", result.name, result.NanosecondsPerOp(), result.allocations, result.bytes);
+	}
+}
+
+// lines of words with varying length, similar to source code.
+std::string MakeText(size_t size, uint64_t seed) {
+	constexpr const char *words[] = {
+		"int", "return", "value", "const", "if", "for", "(", ")", "{", "}", ";", "=", "+",
+		"position", "length", "std::string", "nullptr", "0", "1024", "//", "name", "été", "中文",
+	};
+	Random random(seed);
+	std::string text;
+	text.reserve(size + 128);
+	while (text.size() < size) {
+		const ptrdiff_t indent = random.Next(4);
+		text.append(indent, '\t');
+		const ptrdiff_t count = 2 + random.Next(10);
+		for (ptrdiff_t i = 0; i < count; i++) {
+			text += words[random.Next(std::size(words))];
+			text += ' ';
+		}
+		text.back() = '\n';
+	}
+	return text;
+}
+
+void SplitVectorBenchmark(size_t scale) {
+	const size_t appendCount = 4*1024*1024*scale;
+	Measure("SplitVector append", appendCount, [=] {
+		SplitVector<char> sv;
+		for (size_t i = 0; i < appendCount; i++) {
+			sv.Insert(sv.Length(), static_cast<char>('a' + (i & 15)));
+		}
+		checksum += sv.Length();
+	});
+
+	SplitVector<char> sv;
+	sv.InsertValue(0, 8*1024*1024, ' ');
+	const size_t typingCount = 4*1024*1024*scale;
+	Measure("SplitVector typing", typingCount, [&] {
+		ptrdiff_t position = sv.Length() / 2;
+		for (size_t i = 0; i < typingCount; i++) {
+			if ((i & 7) == 7) {
+				--position;
+				sv.Delete(position);
+			} else {
+				sv.Insert(position, 'x');
+				++position;
+			}
+		}
+		checksum += sv.Length();
+	});
+
+	const size_t scatteredCount = 1000*scale;
+	Measure("SplitVector gap move", scatteredCount, [&] {
+		Random random(1);
+		for (size_t i = 0; i < scatteredCount; i++) {
+			const ptrdiff_t position = random.Next(sv.Length());
+			if (i & 1) {
+				sv.DeleteRange(position, std::min<ptrdiff_t>(4, sv.Length() - position));
+			} else {
+				sv.InsertFromArray(position, "text", 4);
+			}
+		}
+		checksum += sv.Length();
+	});
+
+	const size_t readCount = 16*1024*1024*scale;
+	Measure("SplitVector ValueAt", readCount, [&] {
+		Random random(2);
+		const ptrdiff_t length = sv.Length();
+		size_t sum = 0;
+		for (size_t i = 0; i < readCount; i++) {
+			sum += static_cast<unsigned char>(sv.ValueAt(random.Next(length)));
+		}
+		checksum += sum;
+	});
+}
+
+constexpr Sci::Position averageLineLength = 40;
+
+template <typename Part>
+void BuildLines(Part &part, Sci::Position lines) {
+	part.InsertText(0, lines*averageLineLength);
+	for (Sci::Position line = 1; line < lines; line++) {
+		part.InsertPartition(line, line*averageLineLength);
+	}
+}
+
+template <typename Part>
+void PartitioningBenchmark(const char *stepped, const char *scattered, const char *lookup, size_t scale) {
+	constexpr Sci::Position lines = 1024*1024;
+	Part part;
+	BuildLines(part, lines);
+
+	const size_t steppedCount = 4*1024*1024*scale;
+	Measure(stepped, steppedCount, [&] {
+		// typing on successive lines moves the step forward a little each time
+		Sci::Position line = 0;
+		for (size_t i = 0; i < steppedCount; i++) {
+			part.InsertText(line, 1);
+			line = (line + 1) & (lines - 1);
+		}
+		checksum += part.Length();
+	});
+
+	const size_t scatteredCount = 4000*scale;
+	Measure(scattered, scatteredCount, [&] {
+		// multiple carets or replace all, step moves across the whole document
+		Random random(3);
+		for (size_t i = 0; i < scatteredCount; i++) {
+			part.InsertText(random.Next(lines), (i & 1) ? -1 : 1);
+		}
+		checksum += part.Length();
+	});
+
+	const size_t lookupCount = 4*1024*1024*scale;
+	Measure(lookup, lookupCount, [&] {
+		Random random(4);
+		const Sci::Position length = part.Length();
+		size_t sum = 0;
+		for (size_t i = 0; i < lookupCount; i++) {
+			sum += part.PartitionFromPosition(random.Next(length));
+		}
+		checksum += sum;
+	});
+}
+
+void RunStylesBenchmark(size_t scale) {
+	constexpr Sci::Position length = 16*1024*1024;
+	const size_t fillCount = 64*1024*scale;
+	RunStyles<Sci::Position, int> rs;
+	rs.InsertSpace(0, length);
+	Measure("RunStyles fill", fillCount, [&] {
+		// like indicators for find all or spell check: many short runs
+		Random random(5);
+		for (size_t i = 0; i < fillCount; i++) {
+			const Sci::Position position = random.Next(length - 16);
+			rs.FillRange(position, static_cast<int>(i & 3), 1 + random.Next(15));
+		}
+		checksum += rs.Runs();
+	});
+
+	const size_t splitCount = 16*1024*scale;
+	Measure("RunStyles split", splitCount, [&] {
+		Random random(6);
+		for (size_t i = 0; i < splitCount; i++) {
+			const Sci::Position position = random.Next(rs.Length());
+			if (i & 1) {
+				rs.DeleteRange(position, std::min<Sci::Position>(2, rs.Length() - position));
+			} else {
+				rs.InsertSpace(position, 2);
+			}
+		}
+		checksum += rs.Runs();
+	});
+
+	const size_t lookupCount = 4*1024*1024*scale;
+	Measure("RunStyles ValueAt", lookupCount, [&] {
+		Random random(7);
+		const Sci::Position end = rs.Length();
+		size_t sum = 0;
+		for (size_t i = 0; i < lookupCount; i++) {
+			sum += rs.ValueAt(random.Next(end));
+		}
+		checksum += sum;
+	});
+}
+
+void CellBufferBenchmark(size_t scale) {
+	const std::string text = MakeText(32*1024*1024*scale, 8);
+	Measure("LineVector build", text.size(), [&] {
+		CellBuffer cb(true, false, false, false);
+		cb.SetUndoCollection(false);
+		bool startSequence = false;
+		cb.InsertString(0, text.data(), text.size(), startSequence);
+		checksum += cb.Lines();
+	});
+
+	const size_t editCount = 256*1024*scale;
+	CellBuffer cb(true, false, false, false);
+	cb.SetUndoCollection(false);
+	bool startSequence = false;
+	cb.InsertString(0, text.data(), text.size() / 4, startSequence);
+	cb.SetUndoCollection(true);
+	cb.ChangeHistorySet(true);
+	Measure("CellBuffer insert undo history", editCount, [&] {
+		Random random(9);
+		Sci::Position position = cb.Length() / 2;
+		for (size_t i = 0; i < editCount; i++) {
+			if ((i & 63) == 0) {
+				// move caret to another place after typing a word
+				position = random.Next(cb.Length());
+			}
+			const char ch = static_cast<char>('a' + (i & 15));
+			cb.InsertString(position, &ch, 1, startSequence);
+			++position;
+		}
+		checksum += cb.Length();
+	});
+
+	const int steps = cb.StartUndo();
+	Measure("CellBuffer undo", editCount, [&] {
+		for (size_t i = 0; i < editCount && cb.CanUndo(); i++) {
+			const int count = cb.StartUndo();
+			for (int step = 0; step < count; step++) {
+				cb.PerformUndoStep();
+			}
+		}
+		checksum += cb.Length() + steps;
+	});
+}
+
+void UndoHistoryBenchmark(size_t scale) {
+	const size_t actionCount = 1024*1024*scale;
+	UndoHistory uh;
+	Measure("UndoHistory push", actionCount, [&] {
+		bool startSequence = false;
+		for (size_t i = 0; i < actionCount; i++) {
+			// coalesce typed characters, start another action for each word
+			const ActionType at = (i % 16 == 15) ? ActionType::remove : ActionType::insert;
+			uh.AppendAction(at, static_cast<Sci::Position>(i), "word", 4, startSequence, (i & 7) != 0);
+		}
+		checksum += uh.Actions();
+	});
+
+	Measure("UndoHistory undo", actionCount, [&] {
+		size_t steps = 0;
+		while (uh.CanUndo()) {
+			const int count = uh.StartUndo();
+			for (int step = 0; step < count; step++) {
+				steps += uh.GetUndoStep().lenData;
+				uh.CompletedUndoStep();
+			}
+		}
+		checksum += steps;
+	});
+
+	// typing with many carets, each group inserts one character on every line from last line
+	const size_t caretCount = 64*1024;
+	UndoHistory uhCarets;
+	Measure("UndoHistory carets", actionCount, [&] {
+		bool startSequence = false;
+		for (size_t i = 0; i < actionCount; i += caretCount) {
+			uhCarets.BeginUndoAction();
+			for (size_t caret = caretCount; caret != 0; caret--) {
+				const Sci::Position position = 16*1024*1024 + caret*40 + i/caretCount;
+				uhCarets.AppendAction(ActionType::insert, position, "x", 1, startSequence);
+			}
+			uhCarets.EndUndoAction();
+		}
+		checksum += uhCarets.MemoryUsage();
+	});
+}
+
+void LookupBenchmark(size_t scale) {
+	const std::string text = MakeText(16*1024*1024, 10);
+	const size_t rounds = scale;
+
+	CaseFolderTable folderTable;
+	for (unsigned char ch = 'A'; ch <= 'Z'; ch++) {
+		folderTable.SetTranslation(ch, static_cast<char>(ch - 'A' + 'a'));
+	}
+	std::string folded(text.size()*3, '\0');
+	Measure("CaseFolderTable fold", text.size()*rounds, [&] {
+		for (size_t round = 0; round < rounds; round++) {
+			checksum += folderTable.Fold(folded.data(), folded.size(), text.data(), text.size());
+		}
+	});
+
+	const CaseFolderUnicode folderUnicode;
+	Measure("CaseFolderUnicode fold", text.size()*rounds, [&] {
+		for (size_t round = 0; round < rounds; round++) {
+			checksum += folderUnicode.Fold(folded.data(), folded.size(), text.data(), text.size());
+		}
+	});
+
+	CharClassify charClassify;
+	Measure("CharClassify GetClass", text.size()*rounds, [&] {
+		size_t words = 0;
+		for (size_t round = 0; round < rounds; round++) {
+			for (const char ch : text) {
+				words += charClassify.IsWord(static_cast<unsigned char>(ch));
+			}
+		}
+		checksum += words;
+	});
+
+	Measure("CharClassify ClassifyCharacter", text.size()*rounds, [&] {
+		size_t words = 0;
+		for (size_t round = 0; round < rounds; round++) {
+			// code points in BMP
+			for (size_t i = 0; i < text.size(); i++) {
+				words += CharClassify::ClassifyCharacter(static_cast<uint32_t>(i & 0xffff)) == CharacterClass::word;
+			}
+		}
+		checksum += words;
+	});
+}
+
+class BenchmarkModel final : public EditModel {
+public:
+	Sci::Line TopLineOfMain() const noexcept override {
+		return 0;
+	}
+	Point GetVisibleOriginInMain() const noexcept override {
+		return {};
+	}
+	Sci::Line LinesOnScreen() const noexcept override {
+		return 1;
+	}
+	void OnLineWrapped([[maybe_unused]] Sci::Line lineDoc, [[maybe_unused]] int linesWrapped, [[maybe_unused]] int option) override {}
+};
+
+void BreakFinderBenchmark(size_t scale) {
+	BenchmarkModel model;
+	model.pdoc->SetDBCSCodePage(CpUtf8);
+	// minified file: one long line, style changes at each word
+	std::string text = MakeText(4*1024*1024, 11);
+	std::replace(text.begin(), text.end(), '\n', ' ');
+	const int length = static_cast<int>(text.size());
+	LineLayout ll(0, length + 1);
+	memcpy(ll.chars.get(), text.data(), length);
+	unsigned char style = 0;
+	for (int i = 0; i < length; i++) {
+		if (text[i] == ' ') {
+			style = (style + 1) & 7;
+		}
+		ll.styles[i] = style;
+	}
+	ll.numCharsInLine = length;
+
+	const size_t rounds = scale*4;
+	Measure("BreakFinder long line", static_cast<size_t>(length)*rounds, [&] {
+		size_t segments = 0;
+		for (size_t round = 0; round < rounds; round++) {
+			BreakFinder bfLayout(&ll, nullptr, Range(0, length), 0, 0, BreakFinder::BreakFor::Text, model, nullptr, 0);
+			while (bfLayout.More()) {
+				const TextSegment ts = bfLayout.Next();
+				segments += ts.length != 0;
+			}
+		}
+		checksum += segments;
+	});
+}
+
+void PrintJSONString(const char *s) {
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') {
+			putchar('\\');
+		}
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+}
+
+void *operator new(size_t size) {
+	++allocationCount;
+	allocationBytes += size;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] size_t size) noexcept {
+	free(ptr);
+}
+
+int __cdecl main(int argc, char *argv[]) {
+	size_t scale = 1;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--json") == 0) {
+			jsonOutput = true;
+		} else {
+			scale = std::max<size_t>(strtoul(argv[i], nullptr, 10), 1);
+		}
+	}
+
+	if (!jsonOutput) {
+		printf("%-32s %12s %12s %12s\n", "case", "ns/op", "allocations", "bytes");
+	}
+	SplitVectorBenchmark(scale);
+	PartitioningBenchmark<Partitioning<Sci::Position>>("Partitioning stepped", "Partitioning scattered", "Partitioning lookup", scale);
+	PartitioningBenchmark<BlockPartitioning<Sci::Position>>("BlockPartitioning stepped", "BlockPartitioning scattered", "BlockPartitioning lookup", scale);
+	RunStylesBenchmark(scale);
+	CellBufferBenchmark(scale);
+	UndoHistoryBenchmark(scale);
+	LookupBenchmark(scale);
+	BreakFinderBenchmark(scale);
+
+	if (jsonOutput) {
+		printf("[\n");
+		for (size_t i = 0; i < results.size(); i++) {
+			const Result &result = results[i];
+			printf("\t{\"name\": ");
+			PrintJSONString(result.name);
+			printf(", \"ops\": %zu, \"ns_per_op\": %.3f, \"allocations\": %zu, \"bytes\": %zu}%s\n",
+				result.ops, result.NanosecondsPerOp(), result.allocations, result.bytes,
+				(i + 1 < results.size()) ? "," : "");
+		}
+		printf("]\n");
+	}
+	fprintf(stderr, "checksum %zu\n", checksum);
+	return 0;
+}
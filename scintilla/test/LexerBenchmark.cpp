@@ -0,0 +1,238 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <forward_list>
+
+#include <windows.h>
+
+#include "ScintillaTypes.h"
+#include "ScintillaStructures.h"
+#include "ILoader.h"
+#include "ILexer.h"
+#include "Scintilla.h"
+#include "SciLexer.h"
+#include "Debugging.h"
+#include "CharacterSet.h"
+#include "Position.h"
+#include "SplitVector.h"
+#include "Partitioning.h"
+#include "RunStyles.h"
+#include "CellBuffer.h"
+#include "PerLine.h"
+#include "CharClassify.h"
+#include "Decoration.h"
+#include "CaseFolder.h"
+#include "Document.h"
+#include "ElapsedPeriod.h"
+#include "PropSetSimple.h"
+#include "WordList.h"
+#include "LexAccessor.h"
+#include "Accessor.h"
+#include "LexerModule.h"
+
+// Lexer and folder throughput over samples in tools/lang, results are written as CSV to stdout.
+// LexerBenchmark [target size in MiB] [baseline.csv]
+// each sample is replicated to target size when given, lexers slower than 90% of baseline are reported to stderr.
+// cl /utf-8 /EHsc /std:c++20 /DNDEBUG /O2 /GS- /GR- /W4 /arch:AVX2 /I../include /I../src /I../lexlib LexerBenchmark.cpp
+//	../src/Document.cxx ../src/CellBuffer.cxx ../src/RunStyles.cxx ../src/PerLine.cxx ../src/Decoration.cxx
+//	../src/UndoHistory.cxx ../src/ChangeHistory.cxx ../src/SearchIndex.cxx ../src/BraceIndex.cxx ../src/BackgroundStyler.cxx ../src/CharClassify.cxx
+//	../src/CaseFolder.cxx ../src/CaseConvert.cxx ../src/UniConversion.cxx ../src/RESearch.cxx ../lexlib/*.cxx ../lexers/*.cxx
+
+using namespace Scintilla;
+using namespace Scintilla::Internal;
+using namespace Lexilla;
+
+namespace Scintilla::Internal {
+
+// same as PlatWin.cxx
+int64_t QueryPerformanceFrequency() noexcept {
+	LARGE_INTEGER freq;
+	::QueryPerformanceFrequency(&freq);
+	return freq.QuadPart;
+}
+
+int64_t QueryPerformanceCounter() noexcept {
+	LARGE_INTEGER count;
+	::QueryPerformanceCounter(&count);
+	return count.QuadPart;
+}
+
+// defined in ScintillaBase.cxx, not called as lexers are invoked directly.
+void Document::HighlightUrl([[maybe_unused]] Sci_PositionU startPos, [[maybe_unused]] Sci_Position length, [[maybe_unused]] const uint32_t (&urlIgnoreStyle)[8]) {}
+
+}
+
+namespace {
+
+size_t allocationCount = 0;
+
+struct Sample {
+	const char *path;
+	int language;
+};
+
+constexpr Sample samples[] = {
+	{ "Bash.sh", SCLEX_BASH },
+	{ "C.c", SCLEX_CPP },
+	{ "CPP.cpp", SCLEX_CPP },
+	{ "CSS.css", SCLEX_CSS },
+	{ "Go.go", SCLEX_GO },
+	{ "html.html", SCLEX_HTML },
+	{ "Java.java", SCLEX_JAVA },
+	{ "JavaScript.js", SCLEX_JAVASCRIPT },
+	{ "Lua.lua", SCLEX_LUA },
+	{ "Perl.pl", SCLEX_PERL },
+	{ "Python.py", SCLEX_PYTHON },
+	{ "Ruby.rb", SCLEX_RUBY },
+	{ "Rust.rs", SCLEX_RUST },
+	{ "SQL.sql", SCLEX_SQL },
+	{ "XML.xml", SCLEX_XML },
+};
+
+struct Result {
+	std::string lexer;
+	std::string file;
+	size_t bytes;
+	double lexTime;
+	double foldTime;
+	size_t allocations;
+	double LexSpeed() const noexcept {
+		return bytes / (1024.0*1024.0) / lexTime;
+	}
+};
+
+bool ReadSample(const char *path, std::string &text) {
+	FILE *fp = fopen(path, "rb");
+	if (!fp) {
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	const long len = ftell(fp);
+	rewind(fp);
+	text.resize(std::max(len, 0L));
+	const size_t readLen = fread(text.data(), 1, text.size(), fp);
+	fclose(fp);
+	return len > 0 && readLen == text.size();
+}
+
+void Replicate(std::string &text, size_t targetSize) {
+	const size_t length = text.size();
+	text.reserve(targetSize + length);
+	while (text.size() < targetSize) {
+		text.append(text.data(), length);
+	}
+}
+
+bool RunSample(const Sample &sample, size_t targetSize, Result &result) {
+	const LexerModule *lm = LexerModule::Find(sample.language);
+	if (lm->GetLanguage() != sample.language) {
+		return false;
+	}
+	const std::string path = std::string("../../tools/lang/") + sample.path;
+	std::string text;
+	if (!ReadSample(path.c_str(), text)) {
+		fprintf(stderr, "failed to read %s\n", path.c_str());
+		return false;
+	}
+	Replicate(text, targetSize);
+
+	Document doc(DocumentOption::Default);
+	doc.SetDBCSCodePage(CpUtf8);
+	doc.InsertString(0, text.data(), text.size());
+	const Sci_Position length = doc.Length();
+
+	ILexer5 *lexer = lm->Create();
+	lexer->PropertySet("fold", "1");
+	const size_t allocations = allocationCount;
+	ElapsedPeriod period;
+	lexer->Lex(0, length, 0, &doc);
+	result.lexTime = period.Reset();
+	lexer->Fold(0, length, 0, &doc);
+	result.foldTime = period.Reset();
+	result.allocations = allocationCount - allocations;
+	result.lexer = lexer->GetName();
+	result.file = sample.path;
+	result.bytes = length;
+	lexer->Release();
+	return true;
+}
+
+// read lexer speed from CSV written by previous run.
+std::optional<double> BaselineSpeed(const char *path, const std::string &file) {
+	FILE *fp = fopen(path, "r");
+	if (!fp) {
+		return {};
+	}
+	std::optional<double> speed;
+	char line[512];
+	while (fgets(line, sizeof(line), fp)) {
+		char lexer[128];
+		char name[128];
+		double value;
+		if (sscanf(line, "%127[^,],%127[^,],%*[^,],%*[^,],%lf", lexer, name, &value) == 3 && file == name) {
+			speed = value;
+			break;
+		}
+	}
+	fclose(fp);
+	return speed;
+}
+
+}
+
+void *operator new(size_t size) {
+	++allocationCount;
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] size_t size) noexcept {
+	free(ptr);
+}
+
+int __cdecl main(int argc, char *argv[]) {
+	const size_t targetSize = (argc > 1) ? strtoul(argv[1], nullptr, 10)*1024*1024 : 0;
+	const char *baseline = (argc > 2) ? argv[2] : nullptr;
+	int regressions = 0;
+
+	printf("lexer,file,bytes,lex ms,lex MiB/s,fold ms,fold MiB/s,allocations\n");
+	for (const Sample &sample : samples) {
+		Result result;
+		if (!RunSample(sample, targetSize, result)) {
+			continue;
+		}
+		const double size = result.bytes / (1024.0*1024.0);
+		printf("%s,%s,%zu,%.3f,%.2f,%.3f,%.2f,%zu\n", result.lexer.c_str(), result.file.c_str(), result.bytes,
+			result.lexTime*1000, result.LexSpeed(), result.foldTime*1000, size / result.foldTime, result.allocations);
+		if (baseline) {
+			const std::optional<double> speed = BaselineSpeed(baseline, result.file);
+			if (speed && result.LexSpeed() < *speed*0.9) {
+				++regressions;
+				fprintf(stderr, "%s: %.2f MiB/s, baseline %.2f MiB/s\n", result.file.c_str(), result.LexSpeed(), *speed);
+			}
+		}
+	}
+	return regressions;
+}
@@ -0,0 +1,369 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+#define _CRT_SECURE_NO_WARNINGS
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include <windows.h>
+
+#include "Scintilla.h"
+#include "SciLexer.h"
+
+// Paint cost of a Scintilla view for each rendering technology, results are written as a table to stdout.
+// RenderBenchmark [frame count]
+// The view is a layered popup window with nearly transparent alpha, so it is not seen nor activated
+// but still receives WM_PAINT for the invalidated region like a normal window.
+// Every frame is painted synchronously with UpdateWindow() and timed, PositionCache and
+// LineLayoutCache hit rates are taken from SCI_GETPAINTSTATISTICS over the frames of each scenario.
+// cl /utf-8 /EHsc /std:c++20 /DNDEBUG /O2 /GS- /GR- /W4 /arch:AVX2 /I../include /I../src /I../lexlib RenderBenchmark.cpp
+//	../src/*.cxx ../win32/*.cxx ../lexlib/*.cxx ../lexers/*.cxx
+//	user32.lib gdi32.lib ole32.lib oleaut32.lib imm32.lib msimg32.lib uuid.lib
+
+namespace {
+
+constexpr int benchmarkClientWidth = 1280;
+constexpr int benchmarkClientHeight = 1024;
+constexpr int benchmarkFrameCount = 100;
+// same as fineTimerStart + TickReason::caret in ScintillaWin.cxx
+constexpr WPARAM caretTimerID = 3;
+
+struct Technology {
+	const char *name;
+	int technology;
+};
+
+constexpr Technology technologies[] = {
+	{ "GDI", SC_TECHNOLOGY_DEFAULT },
+	{ "D2D", SC_TECHNOLOGY_DIRECTWRITE },
+	{ "D2D DC", SC_TECHNOLOGY_DIRECTWRITEDC },
+};
+
+struct Document {
+	const char *name;
+	std::string text;
+	int lexer;
+	bool indicators;
+};
+
+struct FrameTimer {
+	double total = 0;
+	double longest = 0;
+	int frames = 0;
+	std::chrono::steady_clock::time_point start;
+
+	void Start() noexcept {
+		start = std::chrono::steady_clock::now();
+	}
+	void Stop() noexcept {
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+		const double period = duration.count();
+		total += period;
+		longest = std::max(longest, period);
+		frames++;
+	}
+};
+
+class View {
+	HWND hwnd = nullptr;
+	SciFnDirect fn = nullptr;
+	sptr_t ptr = 0;
+
+public:
+	bool Create(HINSTANCE hInstance, int technology);
+	void Destroy() noexcept {
+		if (hwnd) {
+			DestroyWindow(hwnd);
+			hwnd = nullptr;
+		}
+	}
+	sptr_t Call(unsigned int message, uptr_t wParam = 0, sptr_t lParam = 0) const {
+		return fn(ptr, message, wParam, lParam);
+	}
+	void Invalidate() const noexcept {
+		InvalidateRect(hwnd, nullptr, FALSE);
+	}
+	void Update() const noexcept {
+		UpdateWindow(hwnd);
+	}
+	void BlinkCaret() const noexcept {
+		SendMessage(hwnd, WM_TIMER, caretTimerID, 0);
+	}
+	void Load(const Document &doc) const;
+};
+
+bool View::Create(HINSTANCE hInstance, int technology) {
+	hwnd = CreateWindowEx(WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
+		L"Scintilla", nullptr, WS_POPUP | WS_VSCROLL | WS_HSCROLL,
+		0, 0, benchmarkClientWidth, benchmarkClientHeight, nullptr, nullptr, hInstance, nullptr);
+	if (hwnd == nullptr) {
+		return false;
+	}
+	SetLayeredWindowAttributes(hwnd, 0, 1, LWA_ALPHA);
+	ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+	fn = reinterpret_cast<SciFnDirect>(SendMessage(hwnd, SCI_GETDIRECTFUNCTION, 0, 0));
+	ptr = SendMessage(hwnd, SCI_GETDIRECTPOINTER, 0, 0);
+	Call(SCI_SETTECHNOLOGY, technology);
+	if (Call(SCI_GETTECHNOLOGY) != technology) {
+		Destroy();
+		return false;
+	}
+	Call(SCI_SETCODEPAGE, SC_CP_UTF8);
+	Call(SCI_SETLAYOUTCACHE, SC_CACHE_PAGE);
+	Call(SCI_SETMARGINTYPEN, 0, SC_MARGIN_NUMBER);
+	Call(SCI_SETMARGINWIDTHN, 0, 64);
+	Call(SCI_STYLESETFONT, STYLE_DEFAULT, reinterpret_cast<sptr_t>("Consolas"));
+	Call(SCI_STYLESETSIZE, STYLE_DEFAULT, 11);
+	Call(SCI_STYLECLEARALL);
+	// distinct colour and weight for lexer styles, so style runs split text into segments like in Notepad4.
+	for (int style = 1; style < 64; style++) {
+		if (style >= STYLE_FIRSTPREDEFINED && style <= STYLE_LASTPREDEFINED) {
+			continue;
+		}
+		const unsigned value = style*2654435761U;
+		Call(SCI_STYLESETFORE, style, value & 0x7f7f7f);
+		Call(SCI_STYLESETBOLD, style, (style & 3) == 1);
+		Call(SCI_STYLESETITALIC, style, (style & 7) == 2);
+	}
+	Call(SCI_SETCARETPERIOD, 0);
+	Call(SCI_SETFOCUS, true);
+	return true;
+}
+
+constexpr int indicatorStyles[] = {
+	INDIC_ROUNDBOX, INDIC_SQUIGGLE, INDIC_BOX, INDIC_STRAIGHTBOX, INDIC_DOTBOX, INDIC_FULLBOX, INDIC_TEXTFORE, INDIC_DASH,
+};
+
+void View::Load(const Document &doc) const {
+	Call(SCI_CLEARALL);
+	Call(SCI_SETLEXER, doc.lexer);
+	Call(SCI_SETKEYWORDS, 0, reinterpret_cast<sptr_t>("auto break case char class const constexpr continue default "
+		"do double else enum for if int namespace noexcept return size_t static struct switch template "
+		"typename uint32_t unsigned using void while"));
+	Call(SCI_SETUNDOCOLLECTION, false);
+	Call(SCI_APPENDTEXT, doc.text.length(), reinterpret_cast<sptr_t>(doc.text.data()));
+	Call(SCI_SETUNDOCOLLECTION, true);
+	Call(SCI_COLOURISE, 0, -1);
+	if (doc.indicators) {
+		// mark every 3rd word with one of the indicators, adjacent indicators overlap.
+		for (int index = 0; index < static_cast<int>(std::size(indicatorStyles)); index++) {
+			const int indicator = INDICATOR_CONTAINER + index;
+			Call(SCI_INDICSETSTYLE, indicator, indicatorStyles[index]);
+			Call(SCI_INDICSETFORE, indicator, (index*0x3f1f7fU) & 0xffffff);
+			Call(SCI_INDICSETALPHA, indicator, 60);
+		}
+		const char *text = doc.text.data();
+		size_t word = 0;
+		size_t start = 0;
+		const size_t length = doc.text.length();
+		while (start < length) {
+			size_t end = start;
+			while (end < length && text[end] != ' ' && text[end] != '\n') {
+				end++;
+			}
+			if (end > start && (word % 3) == 0) {
+				const int index = static_cast<int>((word / 3) % std::size(indicatorStyles));
+				Call(SCI_SETINDICATORCURRENT, INDICATOR_CONTAINER + index);
+				Call(SCI_INDICATORFILLRANGE, start, end + 2 - start);
+			}
+			word++;
+			start = end + 1;
+		}
+	}
+	Call(SCI_GOTOPOS, 0);
+	Call(SCI_SETZOOM, 0);
+}
+
+// simple linear congruential generator, same documents are made on every run.
+struct Random {
+	unsigned seed = 1;
+	unsigned Next() noexcept {
+		seed = seed*214013 + 2531011;
+		return seed >> 16;
+	}
+};
+
+void AppendUTF8(std::string &text, unsigned ch) {
+	if (ch < 0x80) {
+		text += static_cast<char>(ch);
+	} else if (ch < 0x800) {
+		text += static_cast<char>(0xC0 | (ch >> 6));
+		text += static_cast<char>(0x80 | (ch & 0x3f));
+	} else {
+		text += static_cast<char>(0xE0 | (ch >> 12));
+		text += static_cast<char>(0x80 | ((ch >> 6) & 0x3f));
+		text += static_cast<char>(0x80 | (ch & 0x3f));
+	}
+}
+
+// Han ideographs with CJK punctuation and some ASCII.
+std::string MakeCJKText() {
+	std::string text;
+	Random random;
+	for (int line = 0; line < 20000; line++) {
+		const unsigned count = 40 + random.Next() % 40;
+		for (unsigned i = 0; i < count; i++) {
+			const unsigned value = random.Next();
+			if ((value & 15) == 0) {
+				AppendUTF8(text, 0x3001 + (value >> 4) % 2);
+			} else if ((value & 31) == 1) {
+				text += "ASCII ";
+			} else {
+				AppendUTF8(text, 0x4E00 + value % 0x5000);
+			}
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+// source code with comments, strings and numbers, short identifiers on every line.
+std::string MakeCppText() {
+	static const char * const snippets[] = {
+		"static constexpr size_t count = 0x1234; // number of items\n",
+		"template <typename T> struct Holder { T value; unsigned flags = 0; };\n",
+		"\tfor (int index = 0; index < count; index++) {\n",
+		"\t\tif (text[index] == '\\t' || text[index] == ' ') { continue; }\n",
+		"\t\tresult += Compute(index, \"format %d %s\", 3.14159e+2);\n",
+		"\t}\n",
+		"/* block comment describing the following function in a few words */\n",
+		"void Function(const char *text, size_t length, int &result) noexcept {\n",
+		"\tswitch (length) { case 1: return; default: break; }\n",
+		"}\n",
+	};
+	std::string text;
+	Random random;
+	for (int line = 0; line < 50000; line++) {
+		text += snippets[random.Next() % std::size(snippets)];
+	}
+	return text;
+}
+
+// lines with 20000 to 40000 bytes of words, most lines are wider than the view.
+std::string MakeLongLineText() {
+	static const char * const words[] = {
+		"alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta", "0123456789", "=", "+", "(x)",
+	};
+	std::string text;
+	Random random;
+	for (int line = 0; line < 400; line++) {
+		const size_t length = text.length() + 20000 + random.Next() % 20000;
+		while (text.length() < length) {
+			text += words[random.Next() % std::size(words)];
+			text += ' ';
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+struct Scenario {
+	const char *name;
+	void (*frame)(const View &view, int frame);
+};
+
+void FullPaint(const View &view, [[maybe_unused]] int frame) {
+	view.Invalidate();
+	view.Update();
+}
+
+void ScrollByOne(const View &view, int frame) {
+	// scroll down then back up, so lines stay inside the reference document.
+	view.Call(SCI_LINESCROLL, 0, (frame & 32) ? -1 : 1);
+	view.Update();
+}
+
+void CaretBlink(const View &view, [[maybe_unused]] int frame) {
+	view.BlinkCaret();
+	view.Update();
+}
+
+void ZoomStep(const View &view, int frame) {
+	// zoom between -2 and +5 points.
+	static constexpr int levels[] = { 0, 1, 2, 3, 4, 5, 4, 3, 2, 1, 0, -1, -2, -1 };
+	view.Call(SCI_SETZOOM, levels[frame % std::size(levels)]);
+	view.Update();
+}
+
+constexpr Scenario scenarios[] = {
+	{ "full paint", FullPaint },
+	{ "scroll by one", ScrollByOne },
+	{ "caret blink", CaretBlink },
+	{ "zoom step", ZoomStep },
+};
+
+double HitRate(int hits, int misses) noexcept {
+	const int total = hits + misses;
+	return total ? 100.0*hits/total : 0.0;
+}
+
+void PumpMessages() noexcept {
+	MSG msg;
+	while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+}
+
+}
+
+int __cdecl main(int argc, char *argv[]) {
+	int frameCount = benchmarkFrameCount;
+	if (argc > 1) {
+		frameCount = std::max(atoi(argv[1]), 1);
+	}
+
+	HINSTANCE hInstance = GetModuleHandle(nullptr);
+	if (!Scintilla_RegisterClasses(hInstance)) {
+		fprintf(stderr, "Scintilla_RegisterClasses() failed.\n");
+		return 1;
+	}
+
+	const Document documents[] = {
+		{ "wide CJK", MakeCJKText(), SCLEX_NULL, false },
+		{ "dense C++", MakeCppText(), SCLEX_CPP, false },
+		{ "long lines", MakeLongLineText(), SCLEX_NULL, false },
+		{ "heavy indicators", MakeCppText(), SCLEX_CPP, true },
+	};
+
+	printf("%-8s %-18s %-14s %10s %10s %10s %10s\n", "tech", "document", "scenario", "mean ms", "max ms", "poscache", "layout");
+	for (const Technology &tech : technologies) {
+		View view;
+		if (!view.Create(hInstance, tech.technology)) {
+			fprintf(stderr, "technology %s is not supported.\n", tech.name);
+			continue;
+		}
+		for (const Document &doc : documents) {
+			view.Load(doc);
+			for (const Scenario &scenario : scenarios) {
+				// settle window and caches before measuring.
+				FullPaint(view, 0);
+				PumpMessages();
+				Sci_PaintStatistics stats{};
+				view.Call(SCI_GETPAINTSTATISTICS, true, reinterpret_cast<sptr_t>(&stats));
+				FrameTimer timer;
+				for (int frame = 0; frame < frameCount; frame++) {
+					timer.Start();
+					scenario.frame(view, frame);
+					timer.Stop();
+				}
+				view.Call(SCI_GETPAINTSTATISTICS, true, reinterpret_cast<sptr_t>(&stats));
+				printf("%-8s %-18s %-14s %10.3f %10.3f %9.1f%% %9.1f%%\n", tech.name, doc.name, scenario.name,
+					timer.total/timer.frames, timer.longest,
+					HitRate(stats.positionCacheHits, stats.positionCacheMisses),
+					HitRate(stats.lineLayoutHits, stats.lineLayoutMisses));
+				fflush(stdout);
+			}
+		}
+		view.Destroy();
+	}
+
+	Scintilla_ReleaseResources();
+	return 0;
+}
@@ -135,6 +135,8 @@ class ListBoxX final : public ListBox {
 	RGBAImageSet images;
 	LineToItem lti;
 	HWND lb {};
+	int firstItem = 0;	// item for first row
+	int rowCount = 0;	// rows in the list box
 	int codePage = 0;
 	int desiredVisibleRows = defaultVisibleRows;
 	unsigned int maxItemCharacters = 0;
@@ -215,6 +217,7 @@ public:
 	void ClearRegisteredImages() noexcept override;
 	void SetDelegate(IListBoxDelegate *lbDelegate) noexcept override;
 	void SetList(const char *list, char separator, char typesep) override;
+	void SetItemRange(int first, int count) override;
 	void SCICALL SetOptions(const ListOptions &options_) noexcept override;
 	void Draw(const DRAWITEMSTRUCT *pDrawItem);
 	LRESULT WndProc(HWND hWnd, UINT iMessage, WPARAM wParam, LPARAM lParam);
@@ -287,7 +290,7 @@ HWND ListBoxX::GetHWND() const noexcept {
 PRectangle ListBoxX::GetDesiredRect() {
 	PRectangle rcDesired = GetPosition();
 
-	int rows = Length();
+	int rows = rowCount;
 	if ((rows == 0) || (rows > desiredVisibleRows))
 		rows = desiredVisibleRows;
 	rcDesired.bottom = rcDesired.top + ItemHeight() * rows;
@@ -323,7 +326,7 @@ PRectangle ListBoxX::GetDesiredRect() {
 	width = std::max<int>(width, (maxItemCharacters + 1) * aveCharWidth);
 
 	rcDesired.right = rcDesired.left + TextOffset() + width + (TextInset.x * 2);
-	if (Length() > rows) {
+	if (rowCount > rows) {
 		rcDesired.right += SystemMetricsForDpi(SM_CXVSCROLL, dpi);
 	}
 
@@ -344,6 +347,8 @@ int ListBoxX::CaretFromEdge() const noexcept {
 
 void ListBoxX::Clear() noexcept {
 	ListBox_ResetContent(lb);
+	firstItem = 0;
+	rowCount = 0;
 	maxItemCharacters = 0;
 #if LISTBOXX_USE_WIDEST_ITEM
 	widestItem = nullptr;
@@ -365,14 +370,16 @@ void ListBoxX::Select(int n) {
 	// redraw to avoid flicker caused by a painting new selection twice in unselected and then
 	// selected states
 	SetRedraw(false);
-	CentreItem(n);
-	ListBox_SetCurSel(lb, n);
+	const int row = (n >= firstItem && n < firstItem + rowCount) ? n - firstItem : -1;
+	CentreItem(row);
+	ListBox_SetCurSel(lb, row);
 	OnSelChange();
 	SetRedraw(true);
 }
 
 int ListBoxX::GetSelection() const noexcept {
-	return ListBox_GetCurSel(lb);
+	const int row = ListBox_GetCurSel(lb);
+	return (row < 0) ? row : row + firstItem;
 }
 
 // This is not actually called at present
@@ -435,7 +442,7 @@ void ListBoxX::Draw(const DRAWITEMSTRUCT *pDrawItem) {
 		colourFore = colorText;
 	}
 
-	const ListItemData item = lti.Get(pDrawItem->itemID);
+	const ListItemData item = lti.Get(pDrawItem->itemID + firstItem);
 	const int pixId = item.pixId;
 	const char *text = item.text;
 	const unsigned int len = item.len;
@@ -525,12 +532,23 @@ void ListBoxX::SetList(const char *list, const char separator, const char typese
 		AppendListItem(startword, numword, static_cast<unsigned int>(endword - startword));
 	}
 
-	// Finally populate the listbox itself with the correct number of items
-	const int count = lti.Count();
-	::SendMessage(lb, LB_INITSTORAGE, count, 0);
-	for (int j = 0; j < count; j++) {
-		ListBox_AddItemData(lb, j + 1);
+	// Finally populate the listbox itself with the correct number of items,
+	// items are drawn by owner, the no data list box only stores the count.
+	rowCount = lti.Count();
+	::SendMessage(lb, LB_SETCOUNT, rowCount, 0);
+	SetRedraw(true);
+}
+
+void ListBoxX::SetItemRange(int first, int count) {
+	first = std::clamp(first, 0, lti.Count());
+	count = std::clamp(count, 0, lti.Count() - first);
+	if (first == firstItem && count == rowCount) {
+		return;
 	}
+	SetRedraw(false);
+	firstItem = first;
+	rowCount = count;
+	::SendMessage(lb, LB_SETCOUNT, rowCount, 0);
 	SetRedraw(true);
 }
 
@@ -573,7 +591,7 @@ POINT ListBoxX::MaxTrackSize() const noexcept {
 		TextOffset() + SystemMetricsForDpi(SM_CXVSCROLL, dpi);
 	PRectangle rc = PRectangle::FromInts(0, 0,
 		std::max(MinClientWidth(), width),
-		ItemHeight() * lti.Count());
+		ItemHeight() * rowCount);
 	AdjustWindowRect(&rc);
 	POINT ret = { static_cast<LONG>(rc.Width()), static_cast<LONG>(rc.Height()) };
 	return ret;
@@ -775,7 +793,7 @@ void ListBoxX::CentreItem(int n) noexcept {
 	if (n >= 0) {
 		const POINT extent = GetClientExtent();
 		const int visible = extent.y / ItemHeight();
-		if (visible < Length()) {
+		if (visible < rowCount) {
 			const int top = ListBox_GetTopIndex(lb);
 			const int half = (visible - 1) / 2;
 			if (n > (top + half))
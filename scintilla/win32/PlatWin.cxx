@@ -45,6 +45,7 @@
 #include "XPM.h"
 #include "CharClassify.h"
 #include "UniConversion.h"
+#include "EventTrace.h"
 
 #include "WinTypes.h"
 #include "PlatWin.h"
@@ -52,6 +53,12 @@
 
 extern UINT g_uSystemDPI;
 
+#if NP2_ENABLE_EVENT_TRACE
+// {F5D84DE7-41B5-5786-2935-617A7DD4BC73}
+TRACELOGGING_DEFINE_PROVIDER(np2TraceProvider, "Notepad4",
+	(0xf5d84de7, 0x41b5, 0x5786, 0x29, 0x35, 0x61, 0x7a, 0x7d, 0xd4, 0xbc, 0x73));
+#endif
+
 using namespace Scintilla;
 
 #if _WIN32_WINNT < _WIN32_WINNT_WIN10
@@ -854,6 +861,9 @@ void Platform_Initialise(void *hInstance) noexcept {
 	hinstPlatformRes = static_cast<HINSTANCE>(hInstance);
 	//LoadDpiForWindow() is moved into wWinMain().
 	ListBoxX_Register();
+#if NP2_ENABLE_EVENT_TRACE
+	TraceLoggingRegister(np2TraceProvider);
+#endif
 }
 
 void Platform_Finalise(bool fromDllMain) noexcept {
@@ -864,6 +874,9 @@ void Platform_Finalise(bool fromDllMain) noexcept {
 #endif
 	}
 	ListBoxX_Unregister();
+#if NP2_ENABLE_EVENT_TRACE
+	TraceLoggingUnregister(np2TraceProvider);
+#endif
 }
 
 }
@@ -47,6 +47,7 @@ using Microsoft::WRL::ComPtr;
 #if _WIN32_WINNT >= _WIN32_WINNT_WIN7
 #include <d2d1_1.h>
 #include <d3d11_1.h>
+#include <dxgi1_3.h>
 #include <dwrite_1.h>
 #else
 #include <d2d1.h>
@@ -57,8 +58,8 @@ using Microsoft::WRL::ComPtr;
 #define USE_STD_CALL_ONCE		0
 // use InitOnceExecuteOnce()
 #define USE_WIN32_INIT_ONCE		0
-// fallback to InterlockedCompareExchange(). it's not same as std::call_once(),
-// but should safe in Windows message handlers (for WM_CREATE and SCI_SETTECHNOLOGY).
+// fallback to InterlockedCompareExchange(), other callers spin until first one finished,
+// safe in Windows message handlers (for WM_CREATE and SCI_SETTECHNOLOGY) and PreloadD2D().
 
 // since Windows 10, version 1607
 #if _WIN32_WINNT >= _WIN32_WINNT_WIN10
@@ -248,6 +249,19 @@ struct FontWin final : public Font {
 	FLOAT yDescent = 1.0f;
 	FLOAT yInternalLeading = 0.0f;
 	LOGFONTW lf {};
+	// DirectWrite advance widths of graphic ASCII characters, built on first use by SurfaceD2D.
+	// asciiWidths[0] is negative when the font kerns or forms ligatures from ASCII characters.
+	static constexpr size_t asciiWidthCount = 0x7f - ' ';
+	mutable INIT_ONCE asciiWidthsOnce = INIT_ONCE_STATIC_INIT;
+	mutable FLOAT asciiWidths[asciiWidthCount] {};
+	// font face and glyph indices to draw graphic ASCII text without a text layout, null when some character requires font fallback.
+	mutable ComPtr<IDWriteFontFace> asciiFontFace;
+	mutable UINT16 asciiGlyphs[asciiWidthCount] {};
+	// GDI advance widths and glyph indices of graphic ASCII characters, built on first use by SurfaceGDI.
+	// gdiAsciiWidths[0] is negative when some character is missing or measured differently inside text.
+	mutable INIT_ONCE gdiAsciiOnce = INIT_ONCE_STATIC_INIT;
+	mutable int gdiAsciiWidths[asciiWidthCount] {};
+	mutable WORD gdiAsciiGlyphs[asciiWidthCount] {};
 	explicit FontWin(const FontParameters &fp);
 	FontWin(const FontWin &) = delete;
 	FontWin(FontWin &&) = delete;
@@ -91,8 +91,11 @@ Used by VSCode, Atom etc.
 #include "EditModel.h"
 #include "MarginView.h"
 #include "EditView.h"
+#include "OverviewRuler.h"
 #include "Editor.h"
-//#include "ElapsedPeriod.h"
+#if defined(TIME_PAINTING)
+#include "ElapsedPeriod.h"
+#endif
 
 #include "AutoComplete.h"
 #include "ScintillaBase.h"
@@ -598,6 +601,11 @@ class ScintillaWin final :
 	public ScintillaBase {
 
 	bool lastKeyDownConsumed = false;
+#if defined(TIME_PAINTING)
+	// latency from first unpainted keystroke to presenting the painted frame
+	bool keyInputPending = false;
+	ElapsedPeriod periodKeyInput;
+#endif
 	bool styleIdleInQueue = false;
 	wchar_t lastHighSurrogateChar = 0;
 
@@ -621,6 +629,9 @@ class ScintillaWin final :
 	PRectangle rectangleClient;
 	HRGN hRgnUpdate {};
 
+	// text of a large copy, converted to UTF-16 only when clipboard data is requested
+	mutable SelectionText delayedClipboard;
+
 	CLIPFORMAT cfColumnSelect;
 	CLIPFORMAT cfBorlandIDEBlockType;
 	CLIPFORMAT cfLineSelect;
@@ -655,6 +666,10 @@ class ScintillaWin final :
 #if _WIN32_WINNT >= _WIN32_WINNT_WIN7
 	DirectDevice device;
 	ComPtr<IDXGISwapChain1> pDXGISwapChain;
+	UINT swapChainFlags = 0;
+	bool flipSwapChain = false;
+	int scrollPendingY = 0;	// offset of previous frame to be copied by Present1()
+	HANDLE frameLatencyWaitable = nullptr;
 #endif
 	RenderTargets targets;
 	// rendering parameters for current monitor
@@ -675,6 +690,8 @@ class ScintillaWin final :
 	HRESULT Create3D() noexcept;
 	HRESULT SetBackBuffer(IDXGISwapChain1 *pSwapChain) const noexcept;
 	HRESULT CreateSwapChain(HWND hwnd) noexcept;
+	void DropSwapChain() noexcept;
+	HRESULT PresentSwapChain(const RECT *rcDirty) noexcept;
 #endif
 	void EnsureRenderTarget(HDC hdc) noexcept;
 	void DropRenderTarget() noexcept {
@@ -787,6 +804,8 @@ class ScintillaWin final :
 	void GetMouseParameters() noexcept;
 	void CopyToGlobal(GlobalMemory &gmUnicode, const SelectionText &selectedText, CopyEncoding encoding) const;
 	void CopyToClipboard(const SelectionText &selectedText) const override;
+	void RenderClipboardFormat(UINT uFormat) const;
+	void RenderAllClipboardFormats() const;
 	void ScrollMessage(WPARAM wParam);
 	void HorizontalScrollMessage(WPARAM wParam);
 	void FullPaint();
@@ -944,6 +963,9 @@ void ScintillaWin::Finalise() noexcept {
 	}
 	SetIdle(false);
 	DropRenderTarget();
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+	DropSwapChain();
+#endif
 	::RevokeDragDrop(MainHWND());
 }
 
@@ -1010,7 +1032,7 @@ HRESULT ScintillaWin::Create3D() noexcept {
 		return S_OK;
 	}
 	targets.Release();
-	pDXGISwapChain = nullptr;
+	DropSwapChain();
 	device.Release();
 	const HRESULT hr = device.CreateDevice();
 	if (FAILED(hr)) {
@@ -1112,7 +1134,7 @@ HRESULT ScintillaWin::SetBackBuffer(IDXGISwapChain1 *pSwapChain) const noexcept
 HRESULT ScintillaWin::CreateSwapChain(HWND hwnd) noexcept {
 	// Sets pDXGISwapChain but only when each call succeeds
 	// Needs pDXGIDevice, pDirect3DDevice
-	pDXGISwapChain = nullptr;
+	DropSwapChain();
 	assert(device.pDXGIDevice);
 
 	// At each stage, place object in a unique_ptr to ensure release occurs
@@ -1136,14 +1158,28 @@ HRESULT ScintillaWin::CreateSwapChain(HWND hwnd) noexcept {
 	swapChainDesc.SampleDesc.Quality = 0;
 	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
 	swapChainDesc.BufferCount = 2;
-	swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-	swapChainDesc.Flags = 0;
+	// Flip model (Windows 8) lets DWM compose our buffer without a copy and keeps content
+	// outside dirty rectangles, frame latency waitable object requires Windows 8.1.
+	swapChainDesc.Scaling = DXGI_SCALING_NONE;
+	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+	swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
 	// DXGI swap chain for window
 	ComPtr<IDXGISwapChain1> pSwapChain;
 	hr = dxgiFactory->CreateSwapChainForHwnd(device.pDirect3DDevice.Get(), hwnd, &swapChainDesc,
 		nullptr, nullptr, pSwapChain.GetAddressOf());
+	if (FAILED(hr)) {
+		swapChainDesc.Flags = 0;
+		hr = dxgiFactory->CreateSwapChainForHwnd(device.pDirect3DDevice.Get(), hwnd, &swapChainDesc,
+			nullptr, nullptr, pSwapChain.GetAddressOf());
+	}
+	if (FAILED(hr)) {
+		// fallback to bit-block transfer model for Windows 7
+		swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+		hr = dxgiFactory->CreateSwapChainForHwnd(device.pDirect3DDevice.Get(), hwnd, &swapChainDesc,
+			nullptr, nullptr, pSwapChain.GetAddressOf());
+	}
 	if (FAILED(hr))
 		return hr;
 
@@ -1151,10 +1187,61 @@ HRESULT ScintillaWin::CreateSwapChain(HWND hwnd) noexcept {
 	if (FAILED(hr))
 		return hr;
 
+	if (swapChainDesc.Flags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) {
+		ComPtr<IDXGISwapChain2> pSwapChain2;
+		if (SUCCEEDED(pSwapChain.As(&pSwapChain2))) {
+			// at most one queued frame, so paint starts right after previous frame is shown
+			pSwapChain2->SetMaximumFrameLatency(1);
+			frameLatencyWaitable = pSwapChain2->GetFrameLatencyWaitableObject();
+		}
+	}
+
 	// All successful so export swap chain for later presentation
+	swapChainFlags = swapChainDesc.Flags;
+	flipSwapChain = swapChainDesc.SwapEffect == DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
 	pDXGISwapChain = std::move(pSwapChain);
 	return S_OK;
 }
+
+void ScintillaWin::DropSwapChain() noexcept {
+	if (frameLatencyWaitable) {
+		::CloseHandle(frameLatencyWaitable);
+		frameLatencyWaitable = nullptr;
+	}
+	swapChainFlags = 0;
+	flipSwapChain = false;
+	scrollPendingY = 0;
+	pDXGISwapChain = nullptr;
+}
+
+HRESULT ScintillaWin::PresentSwapChain(const RECT *rcDirty) noexcept {
+	DXGI_PRESENT_PARAMETERS parameters{};
+	RECT rcPresent;
+	RECT rcScroll;
+	POINT ptScroll;
+	if (flipSwapChain && rcDirty) {
+		// only changed area is presented, rest of previous frame is kept by flip model
+		const RECT rcClient = GetClientRect(MainHWND());
+		if (::IntersectRect(&rcPresent, rcDirty, &rcClient) && !::EqualRect(&rcPresent, &rcClient)) {
+			parameters.DirtyRectsCount = 1;
+			parameters.pDirtyRects = &rcPresent;
+			if (scrollPendingY) {
+				// area of previous frame moved by ScrollText(), painted lines take priority
+				rcScroll = rcClient;
+				if (scrollPendingY > 0) {
+					rcScroll.bottom -= scrollPendingY;
+				} else {
+					rcScroll.top -= scrollPendingY;
+				}
+				ptScroll = { 0, scrollPendingY };
+				parameters.pScrollRect = &rcScroll;
+				parameters.pScrollOffset = &ptScroll;
+			}
+		}
+	}
+	scrollPendingY = 0;
+	return pDXGISwapChain->Present1(1, 0, &parameters);
+}
 #endif // _WIN32_WINNT >= _WIN32_WINNT_WIN7
 
 void ScintillaWin::EnsureRenderTarget(HDC hdc) noexcept {
@@ -1413,6 +1500,12 @@ bool ScintillaWin::PaintDC(HDC hdc) {
 			const AutoSurface surfaceWindow(pRenderTarget, this);
 			if (surfaceWindow) {
 				SetRenderingParams(surfaceWindow);
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+				if (frameLatencyWaitable) {
+					// wait for previous frame instead of blocking inside Present1()
+					::WaitForSingleObjectEx(frameLatencyWaitable, 100, TRUE);
+				}
+#endif
 				pRenderTarget->BeginDraw();
 				Paint(surfaceWindow, rcPaint);
 				surfaceWindow->Release();
@@ -1422,9 +1515,10 @@ bool ScintillaWin::PaintDC(HDC hdc) {
 					return false;
 				}
 #if _WIN32_WINNT >= _WIN32_WINNT_WIN7
-				if ((technology == Technology::DirectWrite1) && pDXGISwapChain) {
-					const DXGI_PRESENT_PARAMETERS parameters{};
-					const HRESULT hrPresent = pDXGISwapChain->Present1(1, 0, &parameters);
+				// abandoned frame is not presented, whole window is painted again by FullPaint()
+				if ((technology == Technology::DirectWrite1) && pDXGISwapChain && paintState != PaintState::abandoned) {
+					const RECT rcDirty = RectFromPRectangle(rcPaint);
+					const HRESULT hrPresent = PresentSwapChain(&rcDirty);
 					if (FAILED(hrPresent)) {
 						DropRenderTarget();
 						return false;
@@ -1435,6 +1529,12 @@ bool ScintillaWin::PaintDC(HDC hdc) {
 		}
 	}
 
+#if defined(TIME_PAINTING)
+	if (keyInputPending && paintState != PaintState::abandoned) {
+		keyInputPending = false;
+		Platform::DebugPrintf("Keystroke to present: %9.6g ms\n", periodKeyInput.Duration()*1e3);
+	}
+#endif
 	return true;
 }
 
@@ -1877,6 +1977,9 @@ Window::Cursor ScintillaWin::ContextCursor(Point pt) {
 	if (inDragDrop == DragDrop::dragging) {
 		return Window::Cursor::up;
 	}
+	if (PointInOverviewRuler(pt)) {
+		return Window::Cursor::arrow;
+	}
 	// Display regular (drag) cursor over selection
 	if (PointInSelMargin(pt)) {
 		return GetMarginCursor(pt);
@@ -1931,7 +2034,7 @@ void ScintillaWin::SizeWindow() {
 	if ((technology == Technology::DirectWrite1) && pDXGISwapChain && targets.pDeviceContext &&
 		(paintState == PaintState::notPainting)) {
 		targets.pDeviceContext->SetTarget(nullptr);	// ResizeBuffers fails if bitmap still owned by swap chain
-		hrResize = pDXGISwapChain->ResizeBuffers(0, 0, 0, DXGI_FORMAT_UNKNOWN, 0);
+		hrResize = pDXGISwapChain->ResizeBuffers(0, 0, 0, DXGI_FORMAT_UNKNOWN, swapChainFlags);
 		if (SUCCEEDED(hrResize)) {
 			hrResize = SetBackBuffer(pDXGISwapChain.Get());
 		} else {
@@ -2066,6 +2169,12 @@ sptr_t ScintillaWin::MouseMessage(unsigned int iMessage, uptr_t wParam, sptr_t l
 }
 
 sptr_t ScintillaWin::KeyMessage(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
+#if defined(TIME_PAINTING)
+	if (!keyInputPending) {
+		keyInputPending = true;
+		periodKeyInput.Reset();
+	}
+#endif
 	switch (iMessage) {
 
 	case WM_SYSKEYDOWN:
@@ -2472,6 +2581,19 @@ sptr_t ScintillaWin::SciMessage(Message iMessage, uptr_t wParam, sptr_t lParam)
 		InvalidateStyleRedraw();
 		break;
 
+	case Message::SetBackgroundWorkThrottled:
+		backgroundWorkThrottled.store(wParam != 0, std::memory_order_relaxed);
+		break;
+
+	case Message::GetBackgroundWorkThrottled:
+		return backgroundWorkThrottled.load(std::memory_order_relaxed);
+
+	case Message::ReleaseResources:
+		// Direct2D render target and device dependent bitmaps
+		DropRenderTarget();
+		ReleaseResources();
+		break;
+
 	case Message::TargetAsUTF8:
 		return TargetAsUTF8(CharPtrFromSPtr(lParam));
 
@@ -2640,6 +2762,18 @@ sptr_t ScintillaWin::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 			capturedMouse = false;
 			return 0;
 
+		case WM_RENDERFORMAT:
+			RenderClipboardFormat(static_cast<UINT>(wParam));
+			return 0;
+
+		case WM_RENDERALLFORMATS:
+			RenderAllClipboardFormats();
+			return 0;
+
+		case WM_DESTROYCLIPBOARD:
+			delayedClipboard.Clear();
+			return 0;
+
 			// These are not handled in Scintilla and it's faster to dispatch them here.
 			// Also moves time out to here so profile doesn't count lots of empty message calls.
 
@@ -2708,6 +2842,9 @@ sptr_t ScintillaWin::WndProc(Message iMessage, uptr_t wParam, sptr_t lParam) {
 		case Message::GrabFocus:
 		case Message::SetTechnology:
 		case Message::SetBidirectional:
+		case Message::ReleaseResources:
+		case Message::SetBackgroundWorkThrottled:
+		case Message::GetBackgroundWorkThrottled:
 		case Message::TargetAsUTF8:
 		case Message::EncodedFromUTF8:
 			return SciMessage(iMessage, wParam, lParam);
@@ -2888,12 +3025,34 @@ bool ScintillaWin::PaintContains(PRectangle rc) const noexcept {
 	return true;
 }
 
-void ScintillaWin::ScrollText(Sci::Line /* linesToMove */) {
+void ScintillaWin::ScrollText(Sci::Line linesToMove) {
 	//Platform::DebugPrintf("ScintillaWin::ScrollText %d\n", linesToMove);
-	//::ScrollWindow(MainHWND(), 0,
-	//	vs.lineHeight * linesToMove, 0, 0);
-	//::UpdateWindow(MainHWND());
-	Redraw();
+	// Only GDI keeps window content in sync with what was painted, Direct2D presents
+	// its own back buffer which is not moved by ScrollWindowEx().
+	// Pending invalid area is painted first as it would not be moved along with the content.
+	const HWND hwnd = MainHWND();
+	const int dy = static_cast<int>(vs.lineHeight * linesToMove);
+	if (technology == Technology::Default && !::GetUpdateRect(hwnd, nullptr, FALSE)) {
+		// margins and text are scrolled together, only newly exposed lines are painted
+		const RECT rcClient = RectFromPRectangle(GetClientRectangle());
+		::ScrollWindowEx(hwnd, 0, dy, &rcClient, &rcClient, nullptr, nullptr, SW_INVALIDATE);
+	}
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+	else if (flipSwapChain && scrollPendingY == 0 && !::GetUpdateRect(hwnd, nullptr, FALSE)) {
+		// flip model swap chain copies the scrolled area from previous frame in Present1()
+		RECT rcExposed = RectFromPRectangle(GetClientRectangle());
+		if (dy > 0) {
+			rcExposed.bottom = std::min(rcExposed.bottom, rcExposed.top + dy);
+		} else {
+			rcExposed.top = std::max(rcExposed.top, rcExposed.bottom + dy);
+		}
+		scrollPendingY = dy;
+		::InvalidateRect(hwnd, &rcExposed, FALSE);
+	}
+#endif
+	else {
+		Redraw();
+	}
 	UpdateSystemCaret();
 }
 
@@ -3445,6 +3604,131 @@ public:
 	}
 };
 
+// copies larger than this put only a placeholder onto clipboard
+constexpr size_t MinDelayedClipboardLength = 1024*1024;
+
+// end of text before next line end, next is set to start of the following line
+size_t NextLineEnd(std::wstring_view wsv, size_t start, size_t &next) noexcept {
+	size_t end = start;
+	while (end < wsv.length() && wsv[end] != L'\r' && wsv[end] != L'\n') {
+		end++;
+	}
+	next = end + ((end + 1 < wsv.length() && wsv[end] == L'\r' && wsv[end + 1] == L'\n') ? 2 : 1);
+	return end;
+}
+
+// convert pasted text to UTF-8 and change line ends to eol without an intermediate copy
+std::string UTF8FromUTF16ConvertEOL(std::wstring_view wsv, std::string_view eol) {
+	size_t len = 0;
+	for (size_t start = 0, next = 0; start < wsv.length(); start = next) {
+		const size_t end = NextLineEnd(wsv, start, next);
+		len += UTF8Length(wsv.substr(start, end - start));
+		if (end < wsv.length()) {
+			len += eol.length();
+		}
+	}
+	std::string putf(len, '\0');
+	size_t k = 0;
+	for (size_t start = 0, next = 0; start < wsv.length(); start = next) {
+		const size_t end = NextLineEnd(wsv, start, next);
+		k += UTF8FromUTF16(wsv.substr(start, end - start), putf.data() + k, len - k);
+		if (end < wsv.length()) {
+			memcpy(putf.data() + k, eol.data(), eol.length());
+			k += eol.length();
+		}
+	}
+	return putf;
+}
+
+// drops larger than this show wait cursor while text is read and inserted
+constexpr size_t MinProgressDropLength = 16*1024*1024;
+// UTF-16 code units read from dropped stream at once
+constexpr size_t StreamDropChunkLength = 1024*1024;
+
+// read dropped UTF-16 text from stream chunk by chunk, convert it to document encoding
+// and change line ends to eol, appending to single output buffer.
+class StreamTextReader {
+	std::string &dest;
+	const std::string_view eol;
+	const UINT codePage;
+	bool skipLF = false;
+
+	void AppendSegment(std::wstring_view wsv) {
+		if (wsv.empty()) {
+			return;
+		}
+		if (codePage == CP_UTF8) {
+			const size_t len = UTF8Length(wsv);
+			const size_t offset = dest.length();
+			dest.resize(offset + len);
+			UTF8FromUTF16(wsv, dest.data() + offset, len);
+		} else {
+			dest += StringEncode(wsv, codePage);
+		}
+	}
+	void Append(std::wstring_view wsv) {
+		size_t start = 0;
+		if (skipLF && !wsv.empty()) {
+			// CR at end of previous chunk
+			skipLF = false;
+			start = wsv.front() == L'\n';
+		}
+		for (size_t next = start; start < wsv.length(); start = next) {
+			const size_t end = NextLineEnd(wsv, start, next);
+			AppendSegment(wsv.substr(start, end - start));
+			if (end < wsv.length()) {
+				dest.append(eol);
+				skipLF = end + 1 == wsv.length() && wsv[end] == L'\r';
+			}
+		}
+	}
+
+public:
+	StreamTextReader(std::string &dest_, std::string_view eol_, UINT codePage_) noexcept :
+		dest{dest_}, eol{eol_}, codePage{codePage_} {}
+	HRESULT Read(IStream *pstm) {
+		STATSTG stat {};
+		if (SUCCEEDED(pstm->Stat(&stat, STATFLAG_NONAME))) {
+			// exact for ASCII text converted to UTF-8, grows for other text.
+			dest.reserve(static_cast<size_t>(stat.cbSize.QuadPart / sizeof(wchar_t)));
+		}
+		std::unique_ptr<wchar_t[]> buffer = std::make_unique<wchar_t[]>(StreamDropChunkLength);
+		char * const bytes = reinterpret_cast<char *>(buffer.get());
+		constexpr ULONG chunkBytes = StreamDropChunkLength*sizeof(wchar_t);
+		// bytes kept from previous chunk: odd byte or high surrogate
+		ULONG carry = 0;
+		while (true) {
+			ULONG cbRead = 0;
+			const HRESULT hr = pstm->Read(bytes + carry, chunkBytes - carry, &cbRead);
+			if (FAILED(hr)) {
+				return hr;
+			}
+			const ULONG total = carry + cbRead;
+			size_t count = total / sizeof(wchar_t);
+			std::wstring_view wsv(buffer.get(), count);
+			const size_t nul = wsv.find(L'\0');
+			const bool finished = cbRead == 0 || nul != std::wstring_view::npos;
+			if (finished) {
+				Append(wsv.substr(0, nul));
+				break;
+			}
+			carry = total & 1;
+			if (count != 0 && IS_HIGH_SURROGATE(wsv.back())) {
+				--count;
+				carry += sizeof(wchar_t);
+			}
+			Append(wsv.substr(0, count));
+			memmove(bytes, bytes + total - carry, carry);
+		}
+		return S_OK;
+	}
+};
+
+// text may be offered as stream by the drop source, other formats are only read from global memory.
+constexpr DWORD DropMediumType(CLIPFORMAT fmt) noexcept {
+	return (fmt == CF_UNICODETEXT) ? (TYMED_HGLOBAL | TYMED_ISTREAM) : TYMED_HGLOBAL;
+}
+
 inline bool IsValidFormatEtc(const FORMATETC *pFE) noexcept {
 	return pFE->ptd == nullptr
 		&& (pFE->dwAspect & DVASPECT_CONTENT) != 0
@@ -3463,6 +3747,7 @@ void ScintillaWin::Paste(bool asBinary) {
 	bool isLine = false;
 	bool isRectangular = false;
 	bool hasUnicodeText = false;
+	bool lineEndsConverted = false;
 #if DebugCopyAsRichTextFormat
 	bool hasRTF = false;
 #endif
@@ -3496,7 +3781,12 @@ void ScintillaWin::Paste(bool asBinary) {
 		GlobalMemory memUSelection(::GetClipboardData(CF_UNICODETEXT));
 		if (const wchar_t *uptr = static_cast<const wchar_t *>(memUSelection.ptr)) {
 			hasUnicodeText = true;
-			putf = EncodeWString(uptr);
+			if (convertPastes && IsUnicodeMode()) {
+				putf = UTF8FromUTF16ConvertEOL(uptr, pdoc->EOLString());
+				lineEndsConverted = true;
+			} else {
+				putf = EncodeWString(uptr);
+			}
 			memUSelection.Unlock();
 		}
 
@@ -3525,7 +3815,7 @@ void ScintillaWin::Paste(bool asBinary) {
 		const UndoGroup ug(pdoc);
 		const PasteShape pasteShape = isRectangular ? PasteShape::rectangular : (isLine ? PasteShape::line : PasteShape::stream);
 		ClearSelection(multiPasteMode == MultiPaste::Each);
-		InsertPasteShape(putf, pasteShape);
+		InsertPasteShape(putf, pasteShape, lineEndsConverted);
 	}
 	Redraw();
 }
@@ -3976,16 +4266,23 @@ void ScintillaWin::CopyToClipboard(const SelectionText &selectedText) const {
 	if (!clipboard) {
 		return;
 	}
+	// also sends WM_DESTROYCLIPBOARD to clear previous delayed text
 	::EmptyClipboard();
 
-	GlobalMemory uniText;
-	CopyToGlobal(uniText, selectedText, selectedText.asBinary ? CopyEncoding::Binary : CopyEncoding::Unicode);
+	if (!selectedText.asBinary && selectedText.Length() >= MinDelayedClipboardLength) {
+		// delayed rendering, text is converted in WM_RENDERFORMAT
+		delayedClipboard = selectedText;
+		::SetClipboardData(CF_UNICODETEXT, {});
+	} else {
+		GlobalMemory uniText;
+		CopyToGlobal(uniText, selectedText, selectedText.asBinary ? CopyEncoding::Binary : CopyEncoding::Unicode);
 
-	if (uniText) {
-		uniText.SetClip(selectedText.asBinary ? CF_TEXT : CF_UNICODETEXT);
+		if (uniText) {
+			uniText.SetClip(selectedText.asBinary ? CF_TEXT : CF_UNICODETEXT);
 
-		if (selectedText.asBinary) {
-			// encode length information
+			if (selectedText.asBinary) {
+				// encode length information
+			}
 		}
 	}
 
@@ -4010,6 +4307,26 @@ void ScintillaWin::CopyToClipboard(const SelectionText &selectedText) const {
 	//}
 }
 
+// clipboard is already opened by the requesting application
+void ScintillaWin::RenderClipboardFormat(UINT uFormat) const {
+	if (uFormat == CF_UNICODETEXT && !delayedClipboard.Empty()) {
+		GlobalMemory uniText;
+		CopyToGlobal(uniText, delayedClipboard, CopyEncoding::Unicode);
+		if (uniText) {
+			uniText.SetClip(CF_UNICODETEXT);
+		}
+		delayedClipboard.Clear();
+	}
+}
+
+// sent before window is destroyed, keep copied text available for other applications
+void ScintillaWin::RenderAllClipboardFormats() const {
+	const Clipboard clipboard(MainHWND());
+	if (clipboard && ::GetClipboardOwner() == MainHWND()) {
+		RenderClipboardFormat(CF_UNICODETEXT);
+	}
+}
+
 void ScintillaWin::ScrollMessage(WPARAM wParam) {
 	//DWORD dwStart = GetTickCount();
 	//Platform::DebugPrintf("Scroll %x %d\n", wParam, lParam);
@@ -4292,7 +4609,7 @@ STDMETHODIMP ScintillaWin::DragEnter(LPDATAOBJECT pIDataSource, DWORD grfKeyStat
 
 		for (UINT fmtIndex = 0; fmtIndex < dropFormatCount; fmtIndex++) {
 			const CLIPFORMAT fmt = dropFormat[fmtIndex];
-			FORMATETC fmtu = { fmt, nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL };
+			FORMATETC fmtu = { fmt, nullptr, DVASPECT_CONTENT, -1, DropMediumType(fmt) };
 			const HRESULT hrHasUText = pIDataSource->QueryGetData(&fmtu);
 			hasOKText = (hrHasUText == S_OK);
 			if (hasOKText) {
@@ -4354,17 +4671,30 @@ STDMETHODIMP ScintillaWin::Drop(LPDATAOBJECT pIDataSource, DWORD grfKeyState, PO
 		SetDragPosition(SelectionPosition(Sci::invalidPosition));
 
 		std::string putf;
+		bool lineEndsConverted = false;
 		HRESULT hr = DV_E_FORMATETC;
 
 		//EnumDataSourceFormat("Drop", pIDataSource);
 		for (UINT fmtIndex = 0; fmtIndex < dropFormatCount; fmtIndex++) {
 			const CLIPFORMAT fmt = dropFormat[fmtIndex];
-			FORMATETC fmtu = { fmt, nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL };
+			FORMATETC fmtu = { fmt, nullptr, DVASPECT_CONTENT, -1, DropMediumType(fmt) };
 			STGMEDIUM medium;
 			memset(&medium, 0, sizeof(medium));
 			hr = pIDataSource->GetData(&fmtu, &medium);
 
-			if (SUCCEEDED(hr) && medium.hGlobal) {
+			if (SUCCEEDED(hr) && medium.tymed == TYMED_ISTREAM) {
+				// Unicode Text from stream, read in chunks without copy of whole payload
+				if (medium.pstm) {
+					STATSTG stat {};
+					if (SUCCEEDED(medium.pstm->Stat(&stat, STATFLAG_NONAME)) && stat.cbSize.QuadPart >= MinProgressDropLength) {
+						DisplayCursor(Window::Cursor::wait);
+					}
+					const UINT codePage = IsUnicodeMode() ? CP_UTF8 : CodePageOfDocument();
+					StreamTextReader reader(putf, pdoc->EOLString(), codePage);
+					hr = reader.Read(medium.pstm);
+					lineEndsConverted = true;
+				}
+			} else if (SUCCEEDED(hr) && medium.hGlobal) {
 				// File Drop
 				if (fmt == CF_HDROP
 #if EnableDrop_VisualStudioProjectItem
@@ -4389,7 +4719,16 @@ STDMETHODIMP ScintillaWin::Drop(LPDATAOBJECT pIDataSource, DWORD grfKeyState, PO
 				else if (fmt == CF_UNICODETEXT) {
 					GlobalMemory memUDrop(medium.hGlobal);
 					if (const wchar_t *uptr = static_cast<const wchar_t *>(memUDrop.ptr)) {
-						putf = EncodeWString(uptr);
+						const std::wstring_view wsv(uptr, wcsnlen(uptr, memUDrop.Size() / sizeof(wchar_t)));
+						if (wsv.length() >= MinProgressDropLength / sizeof(wchar_t)) {
+							DisplayCursor(Window::Cursor::wait);
+						}
+						if (IsUnicodeMode()) {
+							putf = UTF8FromUTF16ConvertEOL(wsv, pdoc->EOLString());
+							lineEndsConverted = true;
+						} else {
+							putf = EncodeWString(wsv);
+						}
 					}
 					memUDrop.Unlock();
 				}
@@ -4434,7 +4773,10 @@ STDMETHODIMP ScintillaWin::Drop(LPDATAOBJECT pIDataSource, DWORD grfKeyState, PO
 			::ScreenToClient(MainHWND(), &rpt);
 			const SelectionPosition movePos = SPositionFromLocation(PointFromPOINT(rpt), false, false, UserVirtualSpace());
 
-			DropAt(movePos, putf, *pdwEffect == DROPEFFECT_MOVE, isRectangular);
+			DropAt(movePos, putf, *pdwEffect == DROPEFFECT_MOVE, isRectangular, lineEndsConverted);
+		}
+		if (putf.length() >= MinProgressDropLength) {
+			DisplayCursor(Window::Cursor::text);
 		}
 
 		return S_OK;
@@ -4728,9 +5070,15 @@ int Scintilla_RegisterClasses(void *hInstance) {
 	return result;
 }
 
+// Load Direct2D and DirectWrite in background before first Scintilla window is created.
+void Scintilla_PreloadDirectWrite(void) {
+	PreloadD2D();
+}
+
 // This function is externally visible so it can be called from container when building statically.
 int Scintilla_ReleaseResources(void) {
 	const bool result = ScintillaWin::Unregister();
+	FontRealised::ReleaseAll();
 	Platform_Finalise(false);
 	return result;
 }
@@ -414,6 +414,7 @@ public:
 	void SCICALL RectangleFrame(PRectangle rc, Stroke stroke) override;
 	void SCICALL FillRectangle(PRectangle rc, Fill fill) override;
 	void SCICALL FillRectangleAligned(PRectangle rc, Fill fill) override;
+	void SCICALL FillRectanglesAligned(const PRectangle *rcs, size_t count, Fill fill) override;
 	void SCICALL FillRectangle(PRectangle rc, Surface &surfacePattern) override;
 	void SCICALL RoundedRectangle(PRectangle rc, FillStroke fillStroke) override;
 	void SCICALL AlphaRectangle(PRectangle rc, XYPOSITION cornerSize, FillStroke fillStroke) override;
@@ -425,6 +426,7 @@ public:
 
 	std::unique_ptr<IScreenLineLayout> Layout(const IScreenLine *screenLine) override;
 
+	bool SCICALL DrawTextASCII(const FontDirectWrite *pfm, XYPOSITION x, XYPOSITION ybase, std::string_view text) noexcept;
 	void SCICALL DrawTextCommon(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, int codePageOverride, UINT fuOptions);
 
 	void SCICALL DrawTextNoClip(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, ColourRGBA fore, ColourRGBA back) override;
@@ -693,6 +695,35 @@ void SurfaceD2D::FillRectangleAligned(PRectangle rc, Fill fill) {
 	FillRectangle(PixelAlign(rc, 1), fill);
 }
 
+// Fill all rectangles (e.g. whitespace dots) with one path geometry.
+void SurfaceD2D::FillRectanglesAligned(const PRectangle *rcs, size_t count, Fill fill) {
+	if (count == 1) {
+		FillRectangleAligned(*rcs, fill);
+		return;
+	}
+	if (pRenderTarget && count != 0) {
+		const Geometry geometry = GeometryCreate();
+		if (geometry) {
+			if (const GeometrySink sink = GeometrySinkCreate(geometry.Get())) {
+				for (size_t i = 0; i < count; i++) {
+					const D2D1_RECT_F rect = RectangleFromPRectangleEx(PixelAlign(rcs[i], 1));
+					const D2D1_POINT_2F pts[] = {
+						{ rect.right, rect.top },
+						{ rect.right, rect.bottom },
+						{ rect.left, rect.bottom },
+					};
+					sink->BeginFigure({ rect.left, rect.top }, D2D1_FIGURE_BEGIN_FILLED);
+					sink->AddLines(pts, 3);
+					sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+				}
+				sink->Close();
+			}
+			D2DPenColourAlpha(fill.colour);
+			pRenderTarget->FillGeometry(geometry.Get(), pBrush.Get());
+		}
+	}
+}
+
 void SurfaceD2D::FillRectangle(PRectangle rc, Surface &surfacePattern) {
 	SurfaceD2D *psurfOther = down_cast<SurfaceD2D *>(&surfacePattern);
 	PLATFORM_ASSERT(psurfOther);
@@ -1328,18 +1359,45 @@ std::unique_ptr<IScreenLineLayout> SurfaceD2D::Layout(const IScreenLine *screenL
 	return std::make_unique<ScreenLineLayout>(screenLine);
 }
 
+bool ASCIIGlyphRun(const FontDirectWrite *pfm, std::string_view text, UINT16 *glyphs, FLOAT *advances) noexcept;
+
+// Plain ASCII segments, which are most of styled source code, are drawn directly
+// from cached glyph indices instead of converting and laying out each segment.
+bool SurfaceD2D::DrawTextASCII(const FontDirectWrite *pfm, XYPOSITION x, XYPOSITION ybase, std::string_view text) noexcept {
+	UINT16 glyphs[stackBufferLength];
+	FLOAT advances[stackBufferLength];
+	if (text.length() > stackBufferLength || !ASCIIGlyphRun(pfm, text, glyphs, advances)) {
+		return false;
+	}
+	DWRITE_GLYPH_RUN glyphRun {};
+	glyphRun.fontFace = pfm->asciiFontFace.Get();
+	glyphRun.fontEmSize = pfm->pTextFormat->GetFontSize();
+	glyphRun.glyphCount = static_cast<UINT32>(text.length());
+	glyphRun.glyphIndices = glyphs;
+	glyphRun.glyphAdvances = advances;
+	pRenderTarget->DrawGlyphRun(DPointFromPoint(Point(x, ybase)), &glyphRun, pBrush.Get(), DWRITE_MEASURING_MODE_NATURAL);
+	return true;
+}
+
 void SurfaceD2D::DrawTextCommon(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, int codePageOverride, UINT fuOptions) {
 	const FontDirectWrite *pfm = down_cast<const FontDirectWrite *>(font_);
 	if (pfm->pTextFormat) {
-		// Use Unicode calls
-		const int codePageDraw = codePageOverride ? codePageOverride : mode.codePage;
-		const TextWide tbuf(text, codePageDraw);
-
 		SetFontQuality(pfm->extraFontFlag);
 		if (fuOptions & ETO_CLIPPED) {
 			const D2D1_RECT_F rcClip = RectangleFromPRectangle(rc);
 			pRenderTarget->PushAxisAlignedClip(rcClip, D2D1_ANTIALIAS_MODE_ALIASED);
 		}
+
+		if (DrawTextASCII(pfm, rc.left, ybase, text)) {
+			if (fuOptions & ETO_CLIPPED) {
+				pRenderTarget->PopAxisAlignedClip();
+			}
+			return;
+		}
+
+		// Use Unicode calls
+		const int codePageDraw = codePageOverride ? codePageOverride : mode.codePage;
+		const TextWide tbuf(text, codePageDraw);
 		//pfm->pTextFormat->SetReadingDirection(mode.bidiR2L ? DWRITE_READING_DIRECTION_RIGHT_TO_LEFT : DWRITE_READING_DIRECTION_LEFT_TO_RIGHT);
 
 		// Explicitly creating a text layout appears a little faster
@@ -1456,6 +1514,115 @@ public:
 	}
 };
 
+ComPtr<IDWriteFontFace> CreateASCIIFontFace(IDWriteTextFormat *pTextFormat, UINT16 *glyphs) noexcept {
+	ComPtr<IDWriteFontCollection> collection;
+	HRESULT hr = pTextFormat->GetFontCollection(collection.GetAddressOf());
+	if (SUCCEEDED(hr) && !collection) {
+		hr = pIDWriteFactory->GetSystemFontCollection(collection.GetAddressOf(), FALSE);
+	}
+	WCHAR familyName[LF_FULLFACESIZE]{};
+	if (FAILED(hr) || pTextFormat->GetFontFamilyNameLength() >= std::size(familyName)
+		|| FAILED(pTextFormat->GetFontFamilyName(familyName, static_cast<UINT32>(std::size(familyName))))) {
+		return {};
+	}
+	UINT32 index = 0;
+	BOOL exists = FALSE;
+	ComPtr<IDWriteFontFamily> family;
+	ComPtr<IDWriteFont> font;
+	ComPtr<IDWriteFontFace> fontFace;
+	if (FAILED(collection->FindFamilyName(familyName, &index, &exists)) || !exists
+		|| FAILED(collection->GetFontFamily(index, family.GetAddressOf()))
+		|| FAILED(family->GetFirstMatchingFont(pTextFormat->GetFontWeight(), pTextFormat->GetFontStretch(),
+			pTextFormat->GetFontStyle(), font.GetAddressOf()))
+		|| FAILED(font->CreateFontFace(fontFace.GetAddressOf()))) {
+		return {};
+	}
+	UINT32 codePoints[FontDirectWrite::asciiWidthCount];
+	for (size_t i = 0; i < std::size(codePoints); i++) {
+		codePoints[i] = static_cast<UINT32>(' ' + i);
+	}
+	if (FAILED(fontFace->GetGlyphIndices(codePoints, static_cast<UINT32>(std::size(codePoints)), glyphs))) {
+		return {};
+	}
+	for (size_t i = 0; i < std::size(codePoints); i++) {
+		if (glyphs[i] == 0) {
+			// missing glyph, text layout would use a fallback font
+			return {};
+		}
+	}
+	return fontFace;
+}
+
+BOOL CALLBACK BuildASCIIWidths([[maybe_unused]] PINIT_ONCE initOnce, PVOID parameter, [[maybe_unused]] PVOID *context) noexcept {
+	const FontDirectWrite *pfm = static_cast<const FontDirectWrite *>(parameter);
+	FLOAT widths[FontDirectWrite::asciiWidthCount];
+	bool usable = pfm->pTextFormat != nullptr;
+	for (size_t index = 0; usable && index < std::size(widths); index++) {
+		const WCHAR ch = static_cast<WCHAR>(' ' + index);
+		const TextLayout pTextLayout = LayoutCreate(std::wstring_view{&ch, 1}, pfm->pTextFormat.Get());
+		DWRITE_CLUSTER_METRICS clusterMetrics {};
+		UINT32 count = 0;
+		usable = pTextLayout && SUCCEEDED(pTextLayout->GetClusterMetrics(&clusterMetrics, 1, &count)) && count == 1;
+		widths[index] = clusterMetrics.width;
+	}
+	if (usable) {
+		// widths inside text with common kerning pairs and ligatures must match sum of advance widths
+		constexpr std::wstring_view sample = L"AVAWAYATLTLYPAFATaToVaWaYaffiflfi->!=<=www";
+		constexpr UINT32 length = static_cast<UINT32>(sample.length());
+		DWRITE_CLUSTER_METRICS clusterMetrics[length] {};
+		UINT32 count = 0;
+		const TextLayout pTextLayout = LayoutCreate(sample, pfm->pTextFormat.Get());
+		usable = pTextLayout && SUCCEEDED(pTextLayout->GetClusterMetrics(clusterMetrics, length, &count)) && count == length;
+		for (UINT32 index = 0; usable && index < count; index++) {
+			usable = std::abs(clusterMetrics[index].width - widths[sample[index] - ' ']) < 0.001f;
+		}
+	}
+	if (usable) {
+		pfm->asciiFontFace = CreateASCIIFontFace(pfm->pTextFormat.Get(), pfm->asciiGlyphs);
+	} else {
+		widths[0] = -1.0f;
+	}
+	memcpy(pfm->asciiWidths, widths, sizeof(widths));
+	return TRUE;
+}
+
+// Measure graphic ASCII text from advance widths of the font without creating a text layout.
+bool MeasureASCIIWidths(const Font *font_, std::string_view text, XYPOSITION *positions) noexcept {
+	const FontDirectWrite *pfm = down_cast<const FontDirectWrite *>(font_);
+	InitOnceExecuteOnce(&pfm->asciiWidthsOnce, BuildASCIIWidths, const_cast<FontDirectWrite *>(pfm), nullptr);
+	const FLOAT * const widths = pfm->asciiWidths;
+	if (widths[0] < 0) {
+		return false;
+	}
+	XYPOSITION position = 0.0;
+	for (size_t i = 0; i < text.length(); i++) {
+		const unsigned index = static_cast<unsigned char>(text[i]) - ' ';
+		if (index >= FontDirectWrite::asciiWidthCount) {
+			return false;
+		}
+		position += widths[index];
+		positions[i] = position;
+	}
+	return true;
+}
+
+// Glyph run of graphic ASCII text from glyph indices and advance widths built for measuring.
+bool ASCIIGlyphRun(const FontDirectWrite *pfm, std::string_view text, UINT16 *glyphs, FLOAT *advances) noexcept {
+	InitOnceExecuteOnce(&pfm->asciiWidthsOnce, BuildASCIIWidths, const_cast<FontDirectWrite *>(pfm), nullptr);
+	if (!pfm->asciiFontFace) {
+		return false;
+	}
+	for (size_t i = 0; i < text.length(); i++) {
+		const unsigned index = static_cast<unsigned char>(text[i]) - ' ';
+		if (index >= FontDirectWrite::asciiWidthCount) {
+			return false;
+		}
+		glyphs[i] = pfm->asciiGlyphs[index];
+		advances[i] = pfm->asciiWidths[index];
+	}
+	return true;
+}
+
 HRESULT MeasurePositions(const Font *font_, TextWideD2D &tbuf) {
 	const FontDirectWrite *pfm = down_cast<const FontDirectWrite *>(font_);
 	if (!pfm->pTextFormat) {
@@ -1494,6 +1661,9 @@ HRESULT MeasurePositions(const Font *font_, TextWideD2D &tbuf) {
 }
 
 void SurfaceD2D::MeasureWidths(const Font *font_, std::string_view text, XYPOSITION *positions) {
+	if (MeasureASCIIWidths(font_, text, positions)) {
+		return;
+	}
 	TextWideD2D tbuf(text, mode.codePage);
 	if (FAILED(MeasurePositions(font_, tbuf))) {
 		return;
@@ -1587,6 +1757,9 @@ void SurfaceD2D::DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPOS
 }
 
 void SurfaceD2D::MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) {
+	if (MeasureASCIIWidths(font_, text, positions)) {
+		return;
+	}
 	TextWideD2D tbuf(text, CpUtf8);
 	if (FAILED(MeasurePositions(font_, tbuf))) {
 		return;
@@ -1774,15 +1947,50 @@ bool LoadD2D() noexcept {
 	static INIT_ONCE once = INIT_ONCE_STATIC_INIT;
 	::InitOnceExecuteOnce(&once, LoadD2DOnce, nullptr, nullptr);
 #else
+	// 0: not loaded, 1: loading, 2: loaded
 	static LONG once = 0;
-	if (::InterlockedCompareExchange(&once, 1, 0) == 0) {
+	LONG state = ::InterlockedCompareExchange(&once, 1, 0);
+	if (state == 0) {
 		LoadD2DOnce();
+		::InterlockedExchange(&once, 2);
+	} else {
+		// wait for PreloadD2D() thread
+		while (state == 1) {
+			::Sleep(0);
+			state = ::InterlockedCompareExchange(&once, 1, 1);
+		}
 	}
 #endif
 	return pIDWriteFactory && pD2DFactory;
 }
 
+namespace {
+
+HANDLE hPreloadThread {};
+
+DWORD WINAPI PreloadD2DThread([[maybe_unused]] LPVOID lpParameter) noexcept {
+	if (LoadD2D()) {
+		// system font collection is loaded on first use, which is slow for cold start.
+		ComPtr<IDWriteFontCollection> collection;
+		pIDWriteFactory->GetSystemFontCollection(collection.GetAddressOf(), FALSE);
+	}
+	return 0;
+}
+
+}
+
+void PreloadD2D() noexcept {
+	if (!hPreloadThread) {
+		hPreloadThread = ::CreateThread(nullptr, 0, PreloadD2DThread, nullptr, 0, nullptr);
+	}
+}
+
 void ReleaseD2D() noexcept {
+	if (hPreloadThread) {
+		::WaitForSingleObject(hPreloadThread, INFINITE);
+		::CloseHandle(hPreloadThread);
+		hPreloadThread = {};
+	}
 	ReleaseUnknown(gdiInterop);
 	ReleaseUnknown(pIDWriteFactory);
 	ReleaseUnknown(pD2DFactory);
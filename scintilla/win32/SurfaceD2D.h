@@ -9,6 +9,8 @@
 namespace Scintilla::Internal {
 
 extern bool LoadD2D() noexcept;
+// start LoadD2D() on a worker thread
+extern void PreloadD2D() noexcept;
 extern void ReleaseD2D() noexcept;
 
 using DCRenderTarget = ComPtr<ID2D1DCRenderTarget>;
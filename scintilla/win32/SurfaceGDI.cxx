@@ -64,12 +64,14 @@ class SurfaceGDI final : public Surface {
 	HBRUSH brush{};
 	HBRUSH brushOld{};
 	HFONT fontOld{};
+	HFONT fontCurrent{};
 	HBITMAP bitmap{};
 	HBITMAP bitmapOld{};
 
 	NativeMutex measureLock;
 	SurfaceMode mode;
 	bool hdcOwned = false;
+	bool printing = false;
 	int logPixelsY = USER_DEFAULT_SCREEN_DPI;
 
 	static constexpr int maxWidthMeasure = INT_MAX;
@@ -79,6 +81,7 @@ class SurfaceGDI final : public Surface {
 	void PenColour(ColourRGBA fore, XYPOSITION widthStroke) noexcept;
 	void BrushColour(ColourRGBA back) noexcept;
 	void SetFont(const Font *font_) noexcept;
+	const FontGDI *ASCIIFont(const Font *font_) noexcept;
 	void Clear() noexcept;
 
 public:
@@ -112,6 +115,7 @@ public:
 	void SCICALL RectangleFrame(PRectangle rc, Stroke stroke) noexcept override;
 	void SCICALL FillRectangle(PRectangle rc, Fill fill) noexcept override;
 	void SCICALL FillRectangleAligned(PRectangle rc, Fill fill) noexcept override;
+	void SCICALL FillRectanglesAligned(const PRectangle *rcs, size_t count, Fill fill) noexcept override;
 	void SCICALL FillRectangle(PRectangle rc, Surface &surfacePattern) noexcept override;
 	void SCICALL RoundedRectangle(PRectangle rc, FillStroke fillStroke) noexcept override;
 	void SCICALL AlphaRectangle(PRectangle rc, XYPOSITION cornerSize, FillStroke fillStroke) noexcept override;
@@ -184,6 +188,7 @@ void SurfaceGDI::Clear() noexcept {
 		::SelectObject(hdc, fontOld);
 		fontOld = {};
 	}
+	fontCurrent = {};
 	if (bitmapOld) {
 		::SelectObject(hdc, bitmapOld);
 		::DeleteObject(bitmap);
@@ -216,12 +221,13 @@ void SurfaceGDI::Init(WindowID wid) noexcept {
 	logPixelsY = DpiForWindow(wid);
 }
 
-void SurfaceGDI::Init(SurfaceID sid, WindowID wid, bool printing) noexcept {
+void SurfaceGDI::Init(SurfaceID sid, WindowID wid, bool printing_) noexcept {
 	hdc = static_cast<HDC>(sid);
 	::SetTextAlign(hdc, TA_BASELINE);
+	printing = printing_;
 	// Windows on screen are scaled but printers are not.
 	//const bool printing = (::GetDeviceCaps(hdc, TECHNOLOGY) != DT_RASDISPLAY);
-	logPixelsY = printing ? ::GetDeviceCaps(hdc, LOGPIXELSY) : DpiForWindow(wid);
+	logPixelsY = printing_ ? ::GetDeviceCaps(hdc, LOGPIXELSY) : DpiForWindow(wid);
 }
 
 std::unique_ptr<Surface> SurfaceGDI::AllocatePixMap(int width, int height) {
@@ -271,6 +277,11 @@ void SurfaceGDI::BrushColour(ColourRGBA back) noexcept {
 void SurfaceGDI::SetFont(const Font *font_) noexcept {
 	const FontGDI *pfm = down_cast<const FontGDI *>(font_);
 	PLATFORM_ASSERT(pfm);
+	// consecutive segments of a line mostly use same font
+	if (pfm->hfont == fontCurrent) {
+		return;
+	}
+	fontCurrent = pfm->hfont;
 	if (fontOld) {
 		SelectFont(hdc, pfm->hfont);
 	} else {
@@ -278,6 +289,75 @@ void SurfaceGDI::SetFont(const Font *font_) noexcept {
 	}
 }
 
+struct ASCIIWidthsBuilder {
+	const FontGDI *pfm;
+	HDC hdc;
+};
+
+BOOL CALLBACK BuildASCIIWidthsGDI([[maybe_unused]] PINIT_ONCE initOnce, PVOID parameter, [[maybe_unused]] PVOID *context) noexcept {
+	const ASCIIWidthsBuilder *builder = static_cast<const ASCIIWidthsBuilder *>(parameter);
+	const FontGDI *pfm = builder->pfm;
+	const HDC hdc = builder->hdc;
+	WCHAR chars[FontGDI::asciiWidthCount];
+	for (size_t i = 0; i < std::size(chars); i++) {
+		chars[i] = static_cast<WCHAR>(' ' + i);
+	}
+	int * const widths = pfm->gdiAsciiWidths;
+	WORD * const glyphs = pfm->gdiAsciiGlyphs;
+	bool usable = ::GetCharWidth32W(hdc, ' ', ' ' + FontGDI::asciiWidthCount - 1, widths)
+		&& ::GetGlyphIndicesW(hdc, chars, FontGDI::asciiWidthCount, glyphs, GGI_MARK_NONEXISTING_GLYPHS) == FontGDI::asciiWidthCount;
+	for (size_t i = 0; usable && i < std::size(chars); i++) {
+		// missing glyph, text would be drawn with a linked font
+		usable = glyphs[i] != 0xffff;
+	}
+	if (usable) {
+		// positions inside text with common kerning pairs must match sum of advance widths
+		constexpr std::wstring_view sample = L"AVAWAYATLTLYPAFATaToVaWaYaffiflfi->!=<=www";
+		constexpr int length = static_cast<int>(sample.length());
+		int poses[length] {};
+		int fit = 0;
+		SIZE sz {};
+		usable = ::GetTextExtentExPointW(hdc, sample.data(), length, INT_MAX, &fit, poses, &sz) && fit == length;
+		int position = 0;
+		for (int index = 0; usable && index < length; index++) {
+			position += widths[sample[index] - ' '];
+			usable = poses[index] == position;
+		}
+	}
+	if (!usable) {
+		widths[0] = -1;
+	}
+	return TRUE;
+}
+
+// Font with cached widths and glyph indices when text is graphic ASCII, otherwise null.
+const FontGDI *SurfaceGDI::ASCIIFont(const Font *font_) noexcept {
+	if (printing) {
+		// cache is built with screen DC
+		return nullptr;
+	}
+	const FontGDI *pfm = down_cast<const FontGDI *>(font_);
+	BOOL pending = FALSE;
+	if (!::InitOnceBeginInitialize(&pfm->gdiAsciiOnce, INIT_ONCE_CHECK_ONLY, &pending, nullptr)) {
+		// measured with the same DC as other text, which may be shared between layout threads.
+		const LockGuard<NativeMutex> guard(measureLock);
+		SetFont(font_);
+		ASCIIWidthsBuilder builder { pfm, hdc };
+		::InitOnceExecuteOnce(&pfm->gdiAsciiOnce, BuildASCIIWidthsGDI, &builder, nullptr);
+	}
+	return (pfm->gdiAsciiWidths[0] < 0) ? nullptr : pfm;
+}
+
+constexpr bool IsGraphicASCII(std::string_view text) noexcept {
+	for (const char ch : text) {
+		const unsigned index = static_cast<unsigned char>(ch) - ' ';
+		if (index >= FontGDI::asciiWidthCount) {
+			return false;
+		}
+	}
+	return true;
+}
+
 int SurfaceGDI::LogPixelsY() const noexcept {
 	return logPixelsY;
 }
@@ -343,6 +423,20 @@ void SurfaceGDI::FillRectangleAligned(PRectangle rc, Fill fill) noexcept {
 	FillRectangle(PixelAlign(rc, 1), fill);
 }
 
+void SurfaceGDI::FillRectanglesAligned(const PRectangle *rcs, size_t count, Fill fill) noexcept {
+	if (fill.colour.IsOpaque()) {
+		::SetBkColor(hdc, fill.colour.OpaqueRGB());
+		for (size_t i = 0; i < count; i++) {
+			const RECT rcw = RectFromPRectangleEx(PixelAlign(rcs[i], 1));
+			::ExtTextOut(hdc, rcw.left, rcw.top, ETO_OPAQUE, &rcw, TEXT(""), 0, nullptr);
+		}
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			FillRectangleAligned(rcs[i], fill);
+		}
+	}
+}
+
 void SurfaceGDI::FillRectangle(PRectangle rc, Surface &surfacePattern) noexcept {
 	HBRUSH br{};
 	if (const SurfaceGDI *psgdi = down_cast<SurfaceGDI *>(&surfacePattern); psgdi && psgdi->bitmap) {
@@ -646,12 +740,44 @@ std::unique_ptr<IScreenLineLayout> SurfaceGDI::Layout(const IScreenLine *) noexc
 
 using TextPositionsGDI = VarBuffer<int, stackBufferLength>;
 
+// Plain ASCII segments are drawn from cached glyph indices, GDI skips character to glyph
+// mapping and script processing, and UTF-8 text needs no conversion.
+bool DrawTextASCII(HDC hdc, const FontGDI *pfm, int x, int yBaseInt, UINT fuOptions, const RECT &rcw, std::string_view text) noexcept {
+	if (pfm == nullptr || text.length() > stackBufferLength || !IsGraphicASCII(text)) {
+		return false;
+	}
+	WORD glyphs[stackBufferLength];
+	for (size_t i = 0; i < text.length(); i++) {
+		glyphs[i] = pfm->gdiAsciiGlyphs[static_cast<unsigned char>(text[i]) - ' '];
+	}
+	::ExtTextOutW(hdc, x, yBaseInt, fuOptions | ETO_GLYPH_INDEX, &rcw, reinterpret_cast<LPCWSTR>(glyphs), static_cast<UINT>(text.length()), nullptr);
+	return true;
+}
+
+// Positions of graphic ASCII text from cached advance widths without calling GDI.
+bool MeasureASCIIWidths(const FontGDI *pfm, std::string_view text, XYPOSITION *positions) noexcept {
+	if (pfm == nullptr || !IsGraphicASCII(text)) {
+		return false;
+	}
+	const int * const widths = pfm->gdiAsciiWidths;
+	int position = 0;
+	for (size_t i = 0; i < text.length(); i++) {
+		position += widths[static_cast<unsigned char>(text[i]) - ' '];
+		positions[i] = static_cast<XYPOSITION>(position);
+	}
+	return true;
+}
+
 void SurfaceGDI::DrawTextCommon(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, UINT fuOptions) {
+	const FontGDI *pfm = ASCIIFont(font_);
 	SetFont(font_);
 	const RECT rcw = RectFromPRectangleEx(rc);
 	const int x = static_cast<int>(rcw.left);
 	const int yBaseInt = static_cast<int>(ybase);
 
+	if (DrawTextASCII(hdc, pfm, x, yBaseInt, fuOptions, rcw, text)) {
+		return;
+	}
 	if (mode.codePage == CpUtf8) {
 		const TextWide tbuf(text, CpUtf8);
 		::ExtTextOutW(hdc, x, yBaseInt, fuOptions, &rcw, tbuf.data(), tbuf.length(), nullptr);
@@ -689,6 +815,9 @@ void SurfaceGDI::DrawTextTransparent(PRectangle rc, const Font *font_, XYPOSITIO
 }
 
 void SurfaceGDI::MeasureWidths(const Font *font_, std::string_view text, XYPOSITION *positions) {
+	if (MeasureASCIIWidths(ASCIIFont(font_), text, positions)) {
+		return;
+	}
 	SIZE sz {};
 	int fit = 0;
 	int i = 0;
@@ -752,11 +881,15 @@ XYPOSITION SurfaceGDI::WidthText(const Font *font_, std::string_view text) {
 }
 
 void SurfaceGDI::DrawTextCommonUTF8(PRectangle rc, const Font *font_, XYPOSITION ybase, std::string_view text, UINT fuOptions) {
+	const FontGDI *pfm = ASCIIFont(font_);
 	SetFont(font_);
 	const RECT rcw = RectFromPRectangleEx(rc);
 	const int x = static_cast<int>(rcw.left);
 	const int yBaseInt = static_cast<int>(ybase);
 
+	if (DrawTextASCII(hdc, pfm, x, yBaseInt, fuOptions, rcw, text)) {
+		return;
+	}
 	const TextWide tbuf(text, CpUtf8);
 	::ExtTextOutW(hdc, x, yBaseInt, fuOptions, &rcw, tbuf.data(), tbuf.length(), nullptr);
 }
@@ -790,6 +923,9 @@ void SurfaceGDI::DrawTextTransparentUTF8(PRectangle rc, const Font *font_, XYPOS
 }
 
 void SurfaceGDI::MeasureWidthsUTF8(const Font *font_, std::string_view text, XYPOSITION *positions) {
+	if (MeasureASCIIWidths(ASCIIFont(font_), text, positions)) {
+		return;
+	}
 	SIZE sz = { 0,0 };
 	int fit = 0;
 	int i = 0;
@@ -0,0 +1,339 @@
+// This file is part of Notepad4.
+// See License.txt for details about distribution and modification.
+// Editing scenarios benchmark, started with command line option: /benchmark <result file>
+// Scenarios are driven through SciCall on a hidden Scintilla window, painting is forced with
+// WM_PRINTCLIENT into a memory bitmap. Each scenario is written as one line in fixed order
+// so results from different builds can be compared with a diff tool.
+
+#include <windows.h>
+#include <windowsx.h>
+#include <psapi.h>
+#include <cstdio>
+#include <cinttypes>
+#include "SciCall.h"
+#include "SciLexer.h"
+#include "Helpers.h"
+#include "Notepad4.h"
+#include "Edit.h"
+
+namespace {
+
+#if defined(_WIN64)
+constexpr size_t benchmarkLogSize = 1024*1024*1024;
+#else
+constexpr size_t benchmarkLogSize = 128*1024*1024;
+#endif
+constexpr size_t benchmarkXmlSize = 64*1024*1024;
+constexpr int benchmarkTypingCount = 1000;
+constexpr int benchmarkCaretCount = 10000;
+constexpr int benchmarkClientWidth = 1280;
+constexpr int benchmarkClientHeight = 1024;
+
+using GetProcessMemoryInfoSig = BOOL (WINAPI *)(HANDLE hProcess, PPROCESS_MEMORY_COUNTERS ppsmemCounters, DWORD cb);
+
+struct ScenarioBenchmark {
+	HWND hwnd;
+	HDC hdc;
+	HBITMAP hbmp;
+	HBITMAP hbmpOld;
+	FILE *fp;
+	GetProcessMemoryInfoSig pfnGetProcessMemoryInfo;
+	StopWatch watch;
+
+	bool Init(HINSTANCE hInstance, LPCWSTR path) noexcept;
+	void Close() noexcept;
+	void Paint() const noexcept {
+		SendMessage(hwnd, WM_PRINTCLIENT, AsInteger<WPARAM>(hdc), PRF_CLIENT);
+	}
+	void Begin() noexcept {
+		watch.Start();
+	}
+	void End(const char *name, Sci_Position count = 0) noexcept;
+	void LoadText(const char *text, size_t length, size_t lineCount, int lexer) noexcept;
+};
+
+bool ScenarioBenchmark::Init(HINSTANCE hInstance, LPCWSTR path) noexcept {
+	memset(this, 0, sizeof(ScenarioBenchmark));
+	fp = _wfopen(path, L"w");
+	if (fp == nullptr) {
+		return false;
+	}
+	pfnGetProcessMemoryInfo = DLLFunctionEx<GetProcessMemoryInfoSig>(L"kernel32.dll", "K32GetProcessMemoryInfo");
+	hwnd = CreateWindowEx(0, L"Scintilla", nullptr, WS_POPUP | WS_VSCROLL | WS_HSCROLL,
+		0, 0, benchmarkClientWidth, benchmarkClientHeight, nullptr, nullptr, hInstance, nullptr);
+	if (hwnd == nullptr) {
+		return false;
+	}
+
+	InitScintillaHandle(hwnd);
+	SciCall_SetCodePage(SC_CP_UTF8);
+	SciCall_SetMarginWidth(0, 64);
+	HDC hdcWindow = GetDC(hwnd);
+	hdc = CreateCompatibleDC(hdcWindow);
+	hbmp = CreateCompatibleBitmap(hdcWindow, benchmarkClientWidth, benchmarkClientHeight);
+	hbmpOld = SelectBitmap(hdc, hbmp);
+	ReleaseDC(hwnd, hdcWindow);
+	return true;
+}
+
+void ScenarioBenchmark::Close() noexcept {
+	if (hdc) {
+		SelectBitmap(hdc, hbmpOld);
+		DeleteObject(hbmp);
+		DeleteDC(hdc);
+	}
+	if (hwnd) {
+		DestroyWindow(hwnd);
+	}
+	if (fp) {
+		PROCESS_MEMORY_COUNTERS pmc;
+		if (pfnGetProcessMemoryInfo && pfnGetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+			fprintf(fp, "%-24s %16zu MiB\n", "peak working set", static_cast<size_t>(pmc.PeakWorkingSetSize >> 20));
+		}
+		fclose(fp);
+	}
+}
+
+void ScenarioBenchmark::End(const char *name, Sci_Position count) noexcept {
+	watch.Stop();
+	size_t workingSet = 0;
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (pfnGetProcessMemoryInfo && pfnGetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+		workingSet = pmc.WorkingSetSize >> 20;
+	}
+	fprintf(fp, "%-24s %10.1f ms %8zu MiB", name, watch.Get(), workingSet);
+	if (count) {
+		fprintf(fp, " %12" PRId64, static_cast<int64_t>(count));
+	}
+	fputc('\n', fp);
+	fflush(fp);
+}
+
+void ScenarioBenchmark::LoadText(const char *text, size_t length, size_t lineCount, int lexer) noexcept {
+	int options = SC_DOCUMENTOPTION_DEFAULT;
+#if defined(_WIN64)
+	if (length + lineCount >= MAX_SMALL_FILE_SIZE) {
+		options = SC_DOCUMENTOPTION_TEXT_LARGE | SC_DOCUMENTOPTION_STYLES_NONE;
+	}
+#endif
+	HANDLE pdoc = SciCall_CreateDocument(static_cast<Sci_Position>(length + 1), options);
+	SciCall_SetDocPointer(pdoc);
+	SciCall_ReleaseDocument(pdoc);
+	SciCall_SetCodePage(SC_CP_UTF8);
+	SciCall_SetLexer(lexer);
+	SciCall_SetProperty("fold", "1");
+	SciCall_SetUndoCollection(false);
+	SciCall_AllocateLines(static_cast<Sci_Line>(lineCount));
+	SciCall_AppendText(static_cast<Sci_Position>(length), text);
+	SciCall_SetUndoCollection(true);
+	SciCall_EmptyUndoBuffer();
+}
+
+// server log with timestamp, level and request id.
+char *MakeLogText(size_t size, size_t &length, size_t &lineCount) noexcept {
+	static const char * const levels[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+	char *text = static_cast<char *>(NP2HeapAlloc(size + 256));
+	if (text == nullptr) {
+		return nullptr;
+	}
+	length = 0;
+	lineCount = 0;
+	unsigned seed = 1;
+	while (length < size) {
+		seed = seed*214013 + 2531011;
+		const unsigned value = seed >> 16;
+		const unsigned ms = static_cast<unsigned>(lineCount % 86400000);
+		length += wsprintfA(text + length, "2024-01-01 %02u:%02u:%02u.%03u [%s] worker-%u request id=%u path=/api/v1/items/%u completed in %u ms\r\n",
+			ms / 3600000, (ms / 60000) % 60, (ms / 1000) % 60, ms % 1000, levels[value % COUNTOF(levels)],
+			value & 15, static_cast<unsigned>(lineCount), value, value % 997);
+		++lineCount;
+	}
+	return text;
+}
+
+// nested XML elements with attributes and text.
+char *MakeXmlText(size_t size, size_t &length, size_t &lineCount) noexcept {
+	char *text = static_cast<char *>(NP2HeapAlloc(size + 1024));
+	if (text == nullptr) {
+		return nullptr;
+	}
+	length = wsprintfA(text, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n<catalog>\r\n");
+	lineCount = 2;
+	unsigned item = 0;
+	while (length < size) {
+		length += wsprintfA(text + length, "\t<book id=\"bk%u\">\r\n\t\t<author>Author %u</author>\r\n"
+			"\t\t<title>Title of book number %u</title>\r\n\t\t<price>%u.95</price>\r\n"
+			"\t\t<chapters>\r\n\t\t\t<chapter n=\"1\">Introduction</chapter>\r\n\t\t\t<chapter n=\"2\">Summary</chapter>\r\n\t\t</chapters>\r\n"
+			"\t</book>\r\n", item, item % 101, item, item % 50);
+		lineCount += 9;
+		++item;
+	}
+	length += wsprintfA(text + length, "</catalog>\r\n");
+	++lineCount;
+	return text;
+}
+
+void RunLogScenarios(ScenarioBenchmark &bench) noexcept {
+	size_t length;
+	size_t lineCount;
+	char *text = MakeLogText(benchmarkLogSize, length, lineCount);
+	if (text == nullptr) {
+		return;
+	}
+
+	bench.Begin();
+	bench.LoadText(text, length, lineCount, SCLEX_NULL);
+	bench.Paint();
+	bench.End("open log", static_cast<Sci_Position>(length));
+	NP2HeapFree(text);
+
+	bench.Begin();
+	SciCall_DocumentEnd();
+	bench.Paint();
+	bench.End("go to end");
+
+	bench.Begin();
+	SciCall_DocumentStart();
+	for (int i = 0; i < benchmarkTypingCount; i++) {
+		const char ch = (i % 8 == 7) ? ' ' : static_cast<char>('a' + (i % 26));
+		SciCall_AddText(1, &ch);
+		bench.Paint();
+	}
+	bench.End("type at top", benchmarkTypingCount);
+
+	bench.Begin();
+	while (SciCall_CanUndo()) {
+		SciCall_Undo();
+	}
+	bench.Paint();
+	bench.End("undo typing");
+
+	bench.Begin();
+	SciCall_SetMultipleSelection(true);
+	SciCall_SetAdditionalSelectionTyping(true);
+	SciCall_SetSelection(0, 0);
+	for (Sci_Line line = 1; line < benchmarkCaretCount; line++) {
+		const Sci_Position position = SciCall_PositionFromLine(line);
+		SciCall_AddSelection(position, position);
+	}
+	bench.Paint();
+	bench.End("add carets", benchmarkCaretCount);
+
+	bench.Begin();
+	for (int i = 0; i < 10; i++) {
+		SciCall_Tab();
+		bench.Paint();
+	}
+	for (int i = 0; i < 10; i++) {
+		SciCall_DeleteBack();
+		bench.Paint();
+	}
+	bench.End("multiple caret edit", benchmarkCaretCount);
+	SciCall_GotoPos(0);
+
+	bench.Begin();
+	SciCall_SetTargetRange(0, SciCall_GetLength());
+	SciCall_SetSearchFlags(SCFIND_MATCHCASE);
+	SciCall_BeginBatchUpdate();
+	Sci_Position count = SciCall_ReplaceAllInTarget("INFO", "NOTE");
+	SciCall_EndBatchUpdate();
+	bench.Paint();
+	bench.End("replace all", count);
+
+	bench.Begin();
+	SciCall_Undo();
+	bench.Paint();
+	bench.End("undo replace all");
+
+	bench.Begin();
+	count = 0;
+	SciCall_SetIndicatorCurrent(IndicatorNumber_MarkOccurrence);
+	SciCall_SetSearchFlags(SCFIND_REGEXP | SCFIND_POSIX);
+	const Sci_Position iLength = SciCall_GetLength();
+	Sci_Position position = 0;
+	while (position < iLength) {
+		SciCall_SetTargetRange(position, iLength);
+		constexpr char pattern[] = "\\[(WARN|ERROR)\\]";
+		const Sci_Position start = SciCall_SearchInTarget(CSTRLEN(pattern), pattern);
+		if (start < 0) {
+			break;
+		}
+		const Sci_Position end = SciCall_GetTargetEnd();
+		SciCall_IndicatorFillRange(start, end - start);
+		position = max(end, start + 1);
+		++count;
+	}
+	bench.Paint();
+	bench.End("regex mark all", count);
+
+	bench.Begin();
+	SciCall_IndicatorClearRange(0, iLength);
+	bench.Paint();
+	bench.End("clear marks");
+
+	bench.Begin();
+	SciCall_SetWrapMode(SC_WRAP_WORD);
+	bench.Paint();
+	bench.End("wrap on");
+
+	bench.Begin();
+	SciCall_SetWrapMode(SC_WRAP_NONE);
+	bench.Paint();
+	bench.End("wrap off");
+
+	bench.Begin();
+	SciCall_SetZoom(200);
+	bench.Paint();
+	SciCall_SetZoom(50);
+	bench.Paint();
+	SciCall_SetZoom(100);
+	bench.Paint();
+	bench.End("zoom");
+}
+
+void RunXmlScenarios(ScenarioBenchmark &bench) noexcept {
+	size_t length;
+	size_t lineCount;
+	char *text = MakeXmlText(benchmarkXmlSize, length, lineCount);
+	if (text == nullptr) {
+		return;
+	}
+
+	bench.Begin();
+	bench.LoadText(text, length, lineCount, SCLEX_XML);
+	bench.Paint();
+	bench.End("open xml", static_cast<Sci_Position>(length));
+	NP2HeapFree(text);
+
+	bench.Begin();
+	SciCall_ColouriseAll();
+	bench.End("lex xml", static_cast<Sci_Position>(length));
+
+	bench.Begin();
+	SciCall_FoldAll(SC_FOLDACTION_CONTRACT);
+	bench.Paint();
+	bench.End("fold all");
+
+	bench.Begin();
+	SciCall_FoldAll(SC_FOLDACTION_EXPAND);
+	bench.Paint();
+	bench.End("expand all");
+
+	bench.Begin();
+	SciCall_DocumentEnd();
+	bench.Paint();
+	bench.End("go to end xml");
+}
+
+}
+
+int RunScenarioBenchmark(HINSTANCE hInstance, LPCWSTR path) noexcept {
+	ScenarioBenchmark bench;
+	const bool success = bench.Init(hInstance, path);
+	if (success) {
+		RunLogScenarios(bench);
+		RunXmlScenarios(bench);
+	}
+	bench.Close();
+	return success ? 0 : 1;
+}
@@ -57,6 +57,57 @@ namespace {
 HGLOBAL hDevMode {};
 HGLOBAL hDevNames {};
 
+// page layout for the printed range, any difference makes cached page breaks invalid
+struct PrintPageLayout {
+	Sci_Position startPos;
+	Sci_Position endPos;
+	RECT rc;
+	RECT rcPage;
+	POINT ptDpi;
+	int zoom;
+	int fontSize;
+
+	bool operator==(const PrintPageLayout &other) const noexcept {
+		return startPos == other.startPos && endPos == other.endPos
+			&& EqualRect(&rc, &other.rc) && EqualRect(&rcPage, &other.rcPage)
+			&& ptDpi.x == other.ptDpi.x && ptDpi.y == other.ptDpi.y
+			&& zoom == other.zoom && fontSize == other.fontSize;
+	}
+};
+
+// start positions of pages laid out by previous print, printing page range
+// then starts from first requested page without formatting all pages before it.
+struct PrintPageCache {
+	PrintPageLayout layout;
+	UINT pageCount;
+	UINT capacity;
+	Sci_Position *pageStart; // pageStart[n] is start position of page n + 1
+};
+
+PrintPageCache printPageCache;
+
+void PrintPageCache_Add(UINT pageNum, Sci_Position position) noexcept {
+	PrintPageCache &cache = printPageCache;
+	if (pageNum != cache.pageCount + 1) {
+		return;
+	}
+	if (cache.pageCount == cache.capacity) {
+		const UINT capacity = max(cache.capacity*2, 256U);
+		Sci_Position *pageStart;
+		if (cache.pageStart == nullptr) {
+			pageStart = static_cast<Sci_Position *>(NP2HeapAlloc(capacity * sizeof(Sci_Position)));
+		} else {
+			pageStart = static_cast<Sci_Position *>(NP2HeapReAlloc(cache.pageStart, capacity * sizeof(Sci_Position)));
+		}
+		if (pageStart == nullptr) {
+			return;
+		}
+		cache.pageStart = pageStart;
+		cache.capacity = capacity;
+	}
+	cache.pageStart[cache.pageCount++] = position;
+}
+
 // https://docs.microsoft.com/en-us/windows/win32/intl/locale-imeasure
 // This value is 0 if the metric system (Systéme International d'Units,
 // or S.I.) is used, and 1 if the United States system is used.
@@ -319,8 +370,27 @@ bool EditPrint(HWND hwnd, LPCWSTR pszDocTitle, BOOL bDefault) noexcept {
 	frPrint.rc.top		+= headerLineHeight + headerLineHeight / 2;
 	frPrint.rc.bottom	-= footerLineHeight + footerLineHeight / 2;
 
+	PrintPageLayout layout;
+	layout.startPos = lengthPrinted;
+	layout.endPos = lengthDoc;
+	layout.rc = frPrint.rc;
+	layout.rcPage = frPrint.rcPage;
+	layout.ptDpi = ptDpi;
+	layout.zoom = iPrintZoom;
+	layout.fontSize = fontSize;
+	if (!(layout == printPageCache.layout)) {
+		printPageCache.layout = layout;
+		printPageCache.pageCount = 0;
+	}
+	PrintPageCache_Add(1, lengthPrinted);
+
 	// Print each page
 	UINT pageNum = 1;
+	if ((pdlg.Flags & PD_PAGENUMS) && pdlg.nFromPage > 1) {
+		// skip pages laid out by previous print
+		pageNum = min<UINT>(pdlg.nFromPage, printPageCache.pageCount);
+		lengthPrinted = printPageCache.pageStart[pageNum - 1];
+	}
 	WCHAR tchPageFormat[128];
 	WCHAR tchPageStatus[128];
 	GetString(IDS_PRINT_PAGENUM, tchPageFormat, COUNTOF(tchPageFormat));
@@ -393,6 +463,16 @@ bool EditPrint(HWND hwnd, LPCWSTR pszDocTitle, BOOL bDefault) noexcept {
 		frPrint.chrg.cpMax = lengthDoc;
 
 		lengthPrinted = SciCall_FormatRangeFull(printPage, &frPrint);
+		if (lengthPrinted < lengthDoc) {
+			PrintPageCache_Add(pageNum + 1, lengthPrinted);
+		}
+
+		if (!printPage && (pageNum & 63) == 0) {
+			// Display layout progress for pages before first printed page
+			StatusSetText(hwndStatus, STATUS_HELP, pageString);
+			StatusSetSimple(hwndStatus, TRUE);
+			UpdateWindow(hwndStatus);
+		}
 
 		if (printPage) {
 			SetTextColor(hdc, RGB(0, 0, 0));
@@ -452,6 +532,17 @@ bool EditPrint(HWND hwnd, LPCWSTR pszDocTitle, BOOL bDefault) noexcept {
 	return true;
 }
 
+// document changed, or styles changed on lexer change
+void EditPrintReset() noexcept {
+	PrintPageCache &cache = printPageCache;
+	cache.pageCount = 0;
+	if (cache.pageStart != nullptr) {
+		NP2HeapFree(cache.pageStart);
+		cache.pageStart = nullptr;
+		cache.capacity = 0;
+	}
+}
+
 //=============================================================================
 //
 // EditPrintSetup() - Code from SciTEWin::PrintSetup()
@@ -577,49 +668,123 @@ void EditPrintSetup(HWND hwnd) noexcept {
 	NP2HeapFree(pDlgTemplate);
 }
 
+// styled text is read in chunks to avoid copying whole document with styles (2x document size)
+#define STYLED_TEXT_CHUNK_SIZE		(1U << 20)
+// CRLF and UTF-8 character may cross chunk end
+#define STYLED_TEXT_CHUNK_LOOKAHEAD	8
+
 #if 0 // lexer debug
 void EditDumpDocumentStyledText(LPCWSTR lpszFile) {
-	size_t textLength = SciCall_GetLength();
-	const std::unique_ptr<char[]> styledText = std::make_unique_for_overwrite<char[]>(2*textLength + 2);
-	const Sci_TextRangeFull tr { { 0, static_cast<Sci_Position>(textLength) }, styledText.get() };
-	textLength = SciCall_GetStyledTextFull(&tr);
-	const char * const textBuffer = styledText.get() + textLength + 1;
-	std::string output; // similar to Lexilla test output format
-	char fmtbuf[8]{};
-	int stylePrev = -1;
-	size_t startPos = 0;
-	for (size_t offset = 0; offset < textLength; offset++) {
-		const int style = static_cast<uint8_t>(styledText[offset]);
-		if (style != stylePrev) {
-			if (startPos != offset) {
-				output.append(textBuffer + startPos, offset - startPos);
-			}
-			stylePrev = style;
-			startPos = offset;
-			const unsigned fmtlen = sprintf(fmtbuf, "{%d}", style);
-			output.append(fmtbuf, fmtlen);
-		}
-	}
-	if (startPos != textLength) {
-		output.append(textBuffer + startPos, textLength - startPos);
-	}
-
 	WCHAR tchPath[MAX_PATH];
 	lstrcpy(tchPath, lpszFile);
 	lstrcat(tchPath, L".styled.log");
 	HANDLE hFile = CreateFile(tchPath,
 						GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
 						nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-	if (hFile != INVALID_HANDLE_VALUE) {
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	const Sci_Position length = SciCall_GetLength();
+	const std::unique_ptr<char[]> styledText = std::make_unique_for_overwrite<char[]>(2*STYLED_TEXT_CHUNK_SIZE + 2);
+	std::string output; // similar to Lexilla test output format
+	char fmtbuf[8]{};
+	int stylePrev = -1;
+	for (Sci_Position chunkStart = 0; chunkStart < length; chunkStart += STYLED_TEXT_CHUNK_SIZE) {
+		const Sci_TextRangeFull tr { { chunkStart, min<Sci_Position>(chunkStart + STYLED_TEXT_CHUNK_SIZE, length) }, styledText.get() };
+		const size_t textLength = SciCall_GetStyledTextFull(&tr);
+		const char * const textBuffer = styledText.get() + textLength + 1;
+		size_t startPos = 0;
+		for (size_t offset = 0; offset < textLength; offset++) {
+			const int style = static_cast<uint8_t>(styledText[offset]);
+			if (style != stylePrev) {
+				if (startPos != offset) {
+					output.append(textBuffer + startPos, offset - startPos);
+				}
+				stylePrev = style;
+				startPos = offset;
+				const unsigned fmtlen = sprintf(fmtbuf, "{%d}", style);
+				output.append(fmtbuf, fmtlen);
+			}
+		}
+		if (startPos != textLength) {
+			output.append(textBuffer + startPos, textLength - startPos);
+		}
+
 		DWORD dwBytesWritten = static_cast<DWORD>(output.length());
 		WriteFile(hFile, output.c_str(), dwBytesWritten, &dwBytesWritten, nullptr);
-		CloseHandle(hFile);
+		output.clear();
 	}
+	CloseHandle(hFile);
 }
 #endif
 
 namespace { // copy as RTF
 
+// output is written directly into clipboard memory
+class GlobalMemoryStream {
+	HGLOBAL handle = nullptr;
+	char *buffer = nullptr;
+	size_t length = 0;
+	size_t capacity = 0;
+
+	void Reserve(size_t size) {
+		if (size <= capacity) {
+			return;
+		}
+		size = max(size, capacity + capacity/2);
+		HGLOBAL hmem;
+		if (handle == nullptr) {
+			hmem = ::GlobalAlloc(GMEM_MOVEABLE, size + 1); // +1 for NUL
+		} else {
+			::GlobalUnlock(handle);
+			hmem = ::GlobalReAlloc(handle, size + 1, GMEM_MOVEABLE);
+			if (hmem == nullptr) {
+				buffer = static_cast<char *>(::GlobalLock(handle));
+			}
+		}
+		if (hmem == nullptr) {
+			throw std::bad_alloc();
+		}
+		handle = hmem;
+		buffer = static_cast<char *>(::GlobalLock(hmem));
+		capacity = size;
+	}
+
+public:
+	explicit GlobalMemoryStream(size_t size) {
+		Reserve(size);
+	}
+	GlobalMemoryStream(const GlobalMemoryStream &) = delete;
+	GlobalMemoryStream &operator=(const GlobalMemoryStream &) = delete;
+	~GlobalMemoryStream() {
+		if (handle != nullptr) {
+			::GlobalUnlock(handle);
+			::GlobalFree(handle);
+		}
+	}
+
+	GlobalMemoryStream &operator+=(std::string_view sv) {
+		Reserve(length + sv.length());
+		memcpy(buffer + length, sv.data(), sv.length());
+		length += sv.length();
+		return *this;
+	}
+	GlobalMemoryStream &operator+=(char ch) {
+		Reserve(length + 1);
+		buffer[length++] = ch;
+		return *this;
+	}
+	// caller owns returned memory
+	HGLOBAL Detach() noexcept {
+		buffer[length] = '\0';
+		::GlobalUnlock(handle);
+		HGLOBAL hmem = handle;
+		handle = nullptr;
+		return hmem;
+	}
+};
+
 struct DocumentStyledText {
 	std::unique_ptr<StyleDefinition[]> styleList;
 	unsigned styleCount;
@@ -639,15 +804,19 @@ void GetStyleDefinitionFor(int style, StyleDefinition &definition) noexcept {
 	SciCall_StyleGetFont(style, definition.fontFace);
 }
 
-DocumentStyledText GetDocumentStyledText(uint8_t (&styleMap)[STYLE_MAX + 1], const char *styledText, size_t textLength) noexcept {
+DocumentStyledText GetDocumentStyledText(uint8_t (&styleMap)[STYLE_MAX + 1], char *styledText, Sci_Position startPos, Sci_Position endPos) {
 	uint32_t styleUsed[8]{}; // bitmap for styles used in the range
 	styleUsed[STYLE_DEFAULT >> 5] |= (1U << (STYLE_DEFAULT & 31));
 	unsigned maxStyle = STYLE_DEFAULT;
 
-	for (size_t offset = 0; offset < textLength; offset++) {
-		const uint8_t style = styledText[offset];
-		styleUsed[style >> 5] |= (1U << (style & 31));
-		maxStyle = max<unsigned>(style, maxStyle);
+	for (Sci_Position chunkStart = startPos; chunkStart < endPos; chunkStart += STYLED_TEXT_CHUNK_SIZE) {
+		const Sci_TextRangeFull tr { { chunkStart, min<Sci_Position>(chunkStart + STYLED_TEXT_CHUNK_SIZE, endPos) }, styledText };
+		const size_t textLength = SciCall_GetStyledTextFull(&tr);
+		for (size_t offset = 0; offset < textLength; offset++) {
+			const uint8_t style = styledText[offset];
+			styleUsed[style >> 5] |= (1U << (style & 31));
+			maxStyle = max<unsigned>(style, maxStyle);
+		}
 	}
 
 	++maxStyle;
@@ -773,10 +942,14 @@ constexpr int GetRTFFontSize(int size) noexcept {
 	return size / (SC_FONT_SIZE_MULTIPLIER / 2);
 }
 
-void SaveToStreamRTF(std::string &os, const char *styledText, size_t textLength, Sci_Position startPos, Sci_Position endPos) {
+void SaveToStreamRTF(GlobalMemoryStream &os, Sci_Position startPos, Sci_Position endPos) {
+	const std::unique_ptr<char[]> styledText = std::make_unique_for_overwrite<char[]>(2*(STYLED_TEXT_CHUNK_SIZE + STYLED_TEXT_CHUNK_LOOKAHEAD) + 2);
 	uint8_t styleMap[STYLE_MAX + 1];
-	const auto [styleList, styleCount, cpEdit] = GetDocumentStyledText(styleMap, styledText, textLength);
+	const auto [styleList, styleCount, cpEdit] = GetDocumentStyledText(styleMap, styledText.get(), startPos, endPos);
 	const std::unique_ptr<std::string[]> styles = std::make_unique_for_overwrite<std::string[]>(styleCount);
+	// style change from previous style (or paragraph begin at styleCount) to current style
+	const std::unique_ptr<std::string[]> styleDelta = std::make_unique<std::string[]>((styleCount + 1)*styleCount);
+	const std::unique_ptr<bool[]> styleDeltaValid = std::make_unique<bool[]>((styleCount + 1)*styleCount);
 	const std::unique_ptr<LPCSTR[]> fontList = std::make_unique_for_overwrite<LPCSTR[]>(styleCount);
 	const std::unique_ptr<COLORREF[]> colorList = std::make_unique_for_overwrite<COLORREF[]>(2*styleCount);
 
@@ -859,8 +1032,7 @@ void SaveToStreamRTF(std::string &os, const char *styledText, size_t textLength,
 	}
 	os += RTF_COLORDEFCLOSE RTF_HEADERCLOSE RTF_BODYOPEN;
 
-	const char *lastStyle = "";
-	unsigned styleCurrent = STYLE_MAX + 1;
+	unsigned styleCurrent = styleCount;
 	unsigned column = 0;
 	// check eolFilled on first line
 	constexpr uint8_t defaultBackground = 2; // omitted default, STYLE_DEFAULT foreColor, STYLE_DEFAULT backColor
@@ -871,8 +1043,7 @@ void SaveToStreamRTF(std::string &os, const char *styledText, size_t textLength,
 		const Sci_Line line = SciCall_LineFromPosition(startPos);
 		const Sci_Position pos = SciCall_PositionFromLine(line + 1);
 		if (pos < endPos) {
-			uint8_t eolStyle = styledText[2*(pos - startPos) - 1];
-			eolStyle = styleMap[eolStyle];
+			const uint8_t eolStyle = styleMap[SciCall_GetStyleIndexAt(pos - 1)];
 			eolFilled = styleList[eolStyle].eolFilled;
 			if (eolFilled) {
 				background = styleList[eolStyle].backIndex;
@@ -882,95 +1053,104 @@ void SaveToStreamRTF(std::string &os, const char *styledText, size_t textLength,
 		os += std::string_view{fmtbuf, fmtlen};
 	}
 
-	const char * const textBuffer = styledText + textLength + 1;
-	for (size_t offset = 0; offset < textLength; offset++) {
-		uint8_t style = styledText[offset];
-		style = styleMap[style];
-		if (style != styleCurrent) {
-			styleCurrent = style;
-			const char * const currentStyle = styles[style].c_str();
-			GetRTFStyleChange(os, lastStyle, currentStyle);
-			lastStyle = currentStyle;
-			// detect background color change
-			unsigned backIndex = styleList[style].backIndex;
-			backIndex = (backIndex == background)? 0 : backIndex;
-			if (backIndex != highlight) {
-				highlight = backIndex;
-				fmtlen = sprintf(fmtbuf, RTF_SETBACKGROUND "%u ", backIndex);
-				os += std::string_view{fmtbuf, fmtlen};
+	for (Sci_Position chunkStart = startPos; chunkStart < endPos; ) {
+		const Sci_Position chunkEnd = min<Sci_Position>(chunkStart + STYLED_TEXT_CHUNK_SIZE, endPos);
+		const Sci_TextRangeFull tr { { chunkStart, min<Sci_Position>(chunkEnd + STYLED_TEXT_CHUNK_LOOKAHEAD, endPos) }, styledText.get() };
+		const size_t textLength = SciCall_GetStyledTextFull(&tr);
+		const size_t chunkLength = chunkEnd - chunkStart;
+		const char * const textBuffer = styledText.get() + textLength + 1;
+		size_t offset = 0;
+		for (; offset < chunkLength; offset++) {
+			const uint8_t style = styleMap[static_cast<uint8_t>(styledText[offset])];
+			if (style != styleCurrent) {
+				const unsigned index = styleCurrent*styleCount + style;
+				std::string &delta = styleDelta[index];
+				if (!styleDeltaValid[index]) {
+					styleDeltaValid[index] = true;
+					GetRTFStyleChange(delta, (styleCurrent == styleCount) ? "" : styles[styleCurrent].c_str(), styles[style].c_str());
+				}
+				os += delta;
+				styleCurrent = style;
+				// detect background color change
+				unsigned backIndex = styleList[style].backIndex;
+				backIndex = (backIndex == background)? 0 : backIndex;
+				if (backIndex != highlight) {
+					highlight = backIndex;
+					fmtlen = sprintf(fmtbuf, RTF_SETBACKGROUND "%u ", backIndex);
+					os += std::string_view{fmtbuf, fmtlen};
+				}
 			}
-		}
 
-		const char ch = textBuffer[offset];
-		std::string_view sv;
-		column++;
-		if (ch == '\t') {
-			if (!fvCurFile.bTabsAsSpaces) {
-				sv = RTF_TAB;
-			} else {
-				const unsigned tabWidth = fvCurFile.iTabWidth;
-				const unsigned padding = tabWidth - ((column - 1) % tabWidth);
-				column += padding;
-				for (unsigned itab = 0; itab < padding; itab++) {
-					os += ' ';
+			const char ch = textBuffer[offset];
+			std::string_view sv;
+			column++;
+			if (ch == '\t') {
+				if (!fvCurFile.bTabsAsSpaces) {
+					sv = RTF_TAB;
+				} else {
+					const unsigned tabWidth = fvCurFile.iTabWidth;
+					const unsigned padding = tabWidth - ((column - 1) % tabWidth);
+					column += padding;
+					for (unsigned itab = 0; itab < padding; itab++) {
+						os += ' ';
+					}
 				}
-			}
-		} else if (ch == '\r' || ch == '\n') {
-			sv = RTF_EOL;
-			column = 0;
-			if (ch == '\r' && textBuffer[offset + 1] == '\n') {
-				offset += 1;
-			}
-			// check eolFilled on next line
-			const Sci_Line line = SciCall_LineFromPosition(startPos + offset);
-			const Sci_Position pos = SciCall_PositionFromLine(line + 2);
-			if (pos < endPos) {
-				uint8_t eolStyle = styledText[2*(pos - startPos) - 1];
-				eolStyle = styleMap[eolStyle];
-				bool changed = styleList[eolStyle].eolFilled;
-				if (changed) {
-					eolFilled = true;
-					const unsigned backIndex = styleList[eolStyle].backIndex;
-					changed = backIndex != background;
-					background = backIndex;
-				} else if (eolFilled) {
-					changed = true;
-					eolFilled = false;
-					background = defaultBackground;
+			} else if (ch == '\r' || ch == '\n') {
+				sv = RTF_EOL;
+				column = 0;
+				if (ch == '\r' && textBuffer[offset + 1] == '\n') {
+					offset += 1;
 				}
-				if (changed) {
-					lastStyle = "";
-					styleCurrent = STYLE_MAX + 1;
-					highlight = 0;
-					fmtlen = sprintf(fmtbuf, RTF_PARAGRAPH_END RTF_PARAGRAPH_BEGIN, background);
-					sv = {fmtbuf, fmtlen};
+				// check eolFilled on next line
+				const Sci_Line line = SciCall_LineFromPosition(chunkStart + offset);
+				const Sci_Position pos = SciCall_PositionFromLine(line + 2);
+				if (pos < endPos) {
+					const uint8_t eolStyle = styleMap[SciCall_GetStyleIndexAt(pos - 1)];
+					bool changed = styleList[eolStyle].eolFilled;
+					if (changed) {
+						eolFilled = true;
+						const unsigned backIndex = styleList[eolStyle].backIndex;
+						changed = backIndex != background;
+						background = backIndex;
+					} else if (eolFilled) {
+						changed = true;
+						eolFilled = false;
+						background = defaultBackground;
+					}
+					if (changed) {
+						styleCurrent = styleCount;
+						highlight = 0;
+						fmtlen = sprintf(fmtbuf, RTF_PARAGRAPH_END RTF_PARAGRAPH_BEGIN, background);
+						sv = {fmtbuf, fmtlen};
+					}
 				}
+			} else if (static_cast<signed char>(ch) < 0 && cpEdit == SC_CP_UTF8) {
+				const Sci_Position pos = chunkStart + offset;
+				Sci_Position width = 0;
+				const unsigned int u32 = SciCall_GetCharacterAndWidth(pos, &width);
+				offset += width - 1;
+				if (u32 < 0x10000) {
+					fmtlen = sprintf(fmtbuf, "\\u%d?", static_cast<short>(u32));
+				} else {
+					fmtlen = sprintf(fmtbuf, "\\u%d?\\u%d?",
+						static_cast<short>(((u32 - 0x10000) >> 10) + 0xD800),
+						static_cast<short>((u32 & 0x3ff) + 0xDC00));
+				}
+				sv = {fmtbuf, fmtlen};
 			}
-		} else if (static_cast<signed char>(ch) < 0 && cpEdit == SC_CP_UTF8) {
-			const Sci_Position pos = startPos + offset;
-			Sci_Position width = 0;
-			const unsigned int u32 = SciCall_GetCharacterAndWidth(pos, &width);
-			offset += width - 1;
-			if (u32 < 0x10000) {
-				fmtlen = sprintf(fmtbuf, "\\u%d?", static_cast<short>(u32));
-			} else {
-				fmtlen = sprintf(fmtbuf, "\\u%d?\\u%d?",
-					static_cast<short>(((u32 - 0x10000) >> 10) + 0xD800),
-					static_cast<short>((u32 & 0x3ff) + 0xDC00));
-			}
-			sv = {fmtbuf, fmtlen};
-		}
 
-		if (sv.empty()) {
-			if (ch != '\t') {
-				if (ch == '{' || ch == '}' || ch == '\\') {
-					os += '\\';
+			if (sv.empty()) {
+				if (ch != '\t') {
+					if (ch == '{' || ch == '}' || ch == '\\') {
+						os += '\\';
+					}
+					os += ch;
 				}
-				os += ch;
+			} else {
+				os += sv;
 			}
-		} else {
-			os += sv;
 		}
+		chunkStart += offset;
 	}
 
 	os += RTF_PARAGRAPH_END RTF_BODYCLOSE;
@@ -1319,6 +1499,239 @@ void CodePretty(std::string &output, LPCEDITLEXER pLex, const char *styledText,
 	}
 }
 
+// document text in two segments around the gap, read without copying
+class JsonText {
+	const char *segment1;
+	const char *segment2;
+	size_t length1;
+	size_t length;
+
+	// find first byte in [pos, end) which is one of ch1, ch2, ch3, or (when skip is true) isn't any of them
+	template <bool skip>
+	static size_t FindSegment(const char *text, size_t pos, size_t end, uint8_t ch1, uint8_t ch2, uint8_t ch3) noexcept {
+#if NP2_USE_AVX2
+		const __m256i chars1 = mm256_set1_epi8(ch1);
+		const __m256i chars2 = mm256_set1_epi8(ch2);
+		const __m256i chars3 = mm256_set1_epi8(ch3);
+		while (pos + sizeof(__m256i) <= end) {
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+			const __m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, chars1), _mm256_cmpeq_epi8(chunk, chars2)), _mm256_cmpeq_epi8(chunk, chars3));
+			uint32_t mask = mm256_movemask_epi8(match);
+			if constexpr (skip) {
+				mask = ~mask;
+			}
+			if (mask) {
+				return pos + np2_ctz(mask);
+			}
+			pos += sizeof(__m256i);
+		}
+#elif NP2_USE_SSE2
+		const __m128i chars1 = _mm_set1_epi8(ch1);
+		const __m128i chars2 = _mm_set1_epi8(ch2);
+		const __m128i chars3 = _mm_set1_epi8(ch3);
+		while (pos + sizeof(__m128i) <= end) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+			const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, chars1), _mm_cmpeq_epi8(chunk, chars2)), _mm_cmpeq_epi8(chunk, chars3));
+			uint32_t mask = mm_movemask_epi8(match);
+			if constexpr (skip) {
+				mask ^= 0xffff;
+			}
+			if (mask) {
+				return pos + np2_ctz(mask);
+			}
+			pos += sizeof(__m128i);
+		}
+#endif
+		while (pos < end) {
+			const uint8_t ch = text[pos];
+			if ((ch == ch1 || ch == ch2 || ch == ch3) != skip) {
+				break;
+			}
+			++pos;
+		}
+		return pos;
+	}
+
+	template <bool skip>
+	size_t Find(size_t pos, uint8_t ch1, uint8_t ch2, uint8_t ch3) const noexcept {
+		if (pos < length1) {
+			pos = FindSegment<skip>(segment1, pos, length1, ch1, ch2, ch3);
+			if (pos < length1) {
+				return pos;
+			}
+		}
+		return length1 + FindSegment<skip>(segment2, pos - length1, length - length1, ch1, ch2, ch3);
+	}
+
+public:
+	explicit JsonText(const Sci_TextSegments &segments) noexcept:
+		segment1{segments.segment1}, segment2{segments.segment2},
+		length1{static_cast<size_t>(segments.length1)}, length{static_cast<size_t>(segments.length1 + segments.length2)} {}
+
+	size_t Length() const noexcept {
+		return length;
+	}
+	uint8_t operator[](size_t pos) const noexcept {
+		return (pos < length1) ? segment1[pos] : ((pos < length) ? segment2[pos - length1] : '\0');
+	}
+	void Append(std::string &output, size_t pos, size_t end) const {
+		if (pos < length1) {
+			const size_t split = min(end, length1);
+			output.append(segment1 + pos, split - pos);
+			pos = split;
+		}
+		if (pos < end) {
+			output.append(segment2 + (pos - length1), end - pos);
+		}
+	}
+	// space, tab and line breaks between tokens
+	size_t SkipWhiteSpace(size_t pos) const noexcept {
+		while (pos < length) {
+			pos = Find<true>(pos, ' ', '\n', '\r');
+			if ((*this)[pos] != '\t') {
+				break;
+			}
+			++pos;
+		}
+		return pos;
+	}
+	// closing quote, escape or line break in string body
+	size_t FindStringStop(size_t pos, uint8_t quote) const noexcept {
+		return Find<false>(pos, quote, '\\', '\n');
+	}
+};
+
+constexpr bool IsJsonIdentifierChar(uint8_t ch) noexcept {
+	return IsAlphaNumeric(ch) || ch == '_' || ch >= 0x80;
+}
+
+constexpr bool IsJsonNumberChar(uint8_t ch) noexcept {
+	return IsAlphaNumeric(ch) || ch == '.' || ch == '+' || ch == '-';
+}
+
+// Format JSON (IDM_EDIT_CODE_PRETTY or IDM_EDIT_CODE_COMPRESS) tokenized directly from document text
+// without styling it, output is same as CodePretty(). returns false for comment, string with
+// line continuation and other character not in plain JSON, caller then uses styled text instead.
+bool JsonFormat(std::string &output, const JsonText &text, bool compress) {
+	const size_t length = text.Length();
+	const int eolMode = SciCall_GetEOLMode();
+	const std::string_view eol = (eolMode == SC_EOL_CRLF) ? "\r\n" : ((eolMode == SC_EOL_CR) ? "\r" : "\n");
+	char indent = '\t';
+	uint32_t indentWidth = 1;
+	if (fvCurFile.bTabsAsSpaces) {
+		indent = ' ';
+		indentWidth = fvCurFile.iTabWidth;
+	}
+
+	output.reserve(compress ? length : length + length/2);
+	uint32_t blockLevel = 0;
+	uint8_t chPrev = 0; // '\n' after line break, ' ' after space
+	uint8_t chPrevNonWhite = 0;
+	size_t pos = text.SkipWhiteSpace(0);
+	while (pos < length) {
+		const uint8_t ch = text[pos];
+		size_t end = pos + 1;
+		int spaceOption = SpaceOption_None;
+		switch (ch) {
+		case '\"':
+		case '\'':
+			while (true) {
+				end = text.FindStringStop(end, ch);
+				const uint8_t chNext = text[end];
+				if (chNext == ch) {
+					++end;
+					break;
+				}
+				// unterminated string or line continuation
+				if (chNext != '\\' || end + 1 >= length || IsEOLChar(text[end + 1])) {
+					return false;
+				}
+				end += 2;
+			}
+			break;
+
+		case '{':
+		case '[':
+			spaceOption = SpaceOption_NewLineAfter | SpaceOption_IndentAfter;
+			break;
+
+		case '}':
+		case ']':
+			spaceOption = SpaceOption_NewLineBefore | SpaceOption_NewLineAfter;
+			if (blockLevel > 0) {
+				--blockLevel;
+			}
+			break;
+
+		case ':':
+			spaceOption = SpaceOption_SpaceAfter;
+			break;
+
+		case ',':
+			spaceOption = SpaceOption_NewLineAfter;
+			break;
+
+		default:
+			// number, keyword and JSON5 identifier, see AddStyleSeparator()
+			if (IsJsonIdentifierChar(ch) && !IsADigit(ch)) {
+				while (IsJsonIdentifierChar(text[end])) {
+					++end;
+				}
+			} else if (IsJsonNumberChar(ch)) {
+				while (IsJsonNumberChar(text[end])) {
+					++end;
+				}
+			} else {
+				return false;
+			}
+			if (BitTestEx(DefaultWordCharSet, chPrev) && (ch == '.' || BitTestEx(DefaultWordCharSet, ch))) {
+				spaceOption = SpaceOption_SpaceBefore;
+			}
+			break;
+		}
+
+		if (compress) {
+			if (spaceOption & SpaceOption_SpaceBefore) {
+				output.push_back(' ');
+			}
+			text.Append(output, pos, end);
+			chPrev = text[end - 1];
+		} else {
+			if (chPrev == '\n' && (ch == ',' || ch == ':' || ((ch == ']' || ch == '}') && chPrevNonWhite == ch - 2))) {
+				// "}," "]," and empty [] {}
+				output.resize(output.size() - eol.size());
+				chPrev = '\0';
+				if ((spaceOption & SpaceOption_NewLineBefore) == 0) {
+					chPrev = output.back();
+				}
+			}
+			if (chPrev > ' ') {
+				if (spaceOption & SpaceOption_NewLineBefore) {
+					chPrev = '\n';
+					output += eol;
+				} else if (spaceOption & SpaceOption_SpaceBefore) {
+					output.push_back(' ');
+				}
+			}
+			if (chPrev == '\n' && blockLevel != 0) {
+				output.append(blockLevel*indentWidth, indent);
+			}
+			text.Append(output, pos, end);
+			chPrevNonWhite = chPrev = text[end - 1];
+			if (spaceOption & SpaceOption_NewLineAfter) {
+				blockLevel += spaceOption & SpaceOption_IndentAfter;
+				chPrev = '\n';
+				output += eol;
+			} else if (spaceOption & SpaceOption_SpaceAfter) {
+				chPrev = ' ';
+				output.push_back(' ');
+			}
+		}
+		pos = text.SkipWhiteSpace(end);
+	}
+	return true;
+}
+
 }
 
 void EditFormatCode(int menu) noexcept {
@@ -1339,29 +1752,48 @@ void EditFormatCode(int menu) noexcept {
 	}
 
 	try {
-		SciCall_EnsureStyledTo(endPos);
-		const std::unique_ptr<char[]> styledText = std::make_unique_for_overwrite<char[]>(2*(endPos - startPos) + 2);
-		const Sci_TextRangeFull tr { { startPos, endPos }, styledText.get() };
-		const size_t textLength = SciCall_GetStyledTextFull(&tr);
 		std::string output;
 		std::string_view result;
 		bool changed = false;
-
 		if (menu == IDM_EDIT_COPYRTF) {
 			// code from SciTEWin::CopyAsRTF()
-			SaveToStreamRTF(output, styledText.get(), textLength, startPos, endPos);
-			//printf("%s:\n%s\n", __func__, output.c_str());
+			SciCall_EnsureStyledTo(endPos);
+			GlobalMemoryStream os(endPos - startPos + 4096);
+			SaveToStreamRTF(os, startPos, endPos);
 			if (::OpenClipboard(hwndMain)) {
-				const size_t len = output.length() + 1; // +1 for NUL
-				HGLOBAL handle = ::GlobalAlloc(GMEM_MOVEABLE | GMEM_ZEROINIT, len);
-				char *ptr = static_cast<char *>(::GlobalLock(handle));
-				memcpy(ptr, output.c_str(), len);
-				::GlobalUnlock(handle);
+				HGLOBAL handle = os.Detach();
 				::EmptyClipboard();
-				::SetClipboardData(::RegisterClipboardFormat(CF_RTF), handle);
+				if (!::SetClipboardData(::RegisterClipboardFormat(CF_RTF), handle)) {
+					::GlobalFree(handle);
+				}
 				::CloseClipboard();
 			}
-		} else if (menu == IDM_EDIT_CODE_COMPRESS) {
+			return;
+		}
+		if (pLex->iLexer == SCLEX_JSON) {
+			// plain JSON is formatted from document text without styling it
+			Sci_TextSegments segments = { { startPos, endPos }, nullptr, 0, nullptr, 0 };
+			const Sci_Position length = SciCall_GetRangeSegments(&segments);
+			if (JsonFormat(output, JsonText{segments}, menu == IDM_EDIT_CODE_COMPRESS)) {
+				if (output.length() != static_cast<size_t>(length)) {
+					if (wholeDoc) {
+						SciCall_TargetWholeDocument();
+						SciCall_ReplaceTarget(output.length(), output.data());
+					} else {
+						EditReplaceMainSelection(output.length(), output.data());
+					}
+				}
+				return;
+			}
+			output.clear();
+		}
+
+		SciCall_EnsureStyledTo(endPos);
+		const std::unique_ptr<char[]> styledText = std::make_unique_for_overwrite<char[]>(2*(endPos - startPos) + 2);
+		const Sci_TextRangeFull tr { { startPos, endPos }, styledText.get() };
+		const size_t textLength = SciCall_GetStyledTextFull(&tr);
+
+		if (menu == IDM_EDIT_CODE_COMPRESS) {
 			size_t index = 0;
 			int chPrev = 0;
 			int stylePrev = static_cast<uint8_t>(styledText[0]);
@@ -363,7 +363,7 @@ INT_PTR CALLBACK AboutDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam
 				NP2_COMPILER_WARNING_POP
 
 				WCHAR wch[128];
-				WCHAR tch[512];
+				WCHAR tch[2048];
 				LPCWSTR arch = GetProcessorArchitecture();
 				const int iEncoding = Encoding_GetIndex(mEncoding[CPI_DEFAULT].uCodePage);
 				Encoding_GetLabel(iEncoding);
@@ -374,6 +374,20 @@ INT_PTR CALLBACK AboutDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam
 					PathFindExtension(szCurFile), pLexCurrent->pszName,
 					version.dwMajorVersion, version.dwMinorVersion, version.dwBuildNumber,
 					version.szCSDVersion, arch);
+				WCHAR tchMemory[SC_MEMORY_SEARCH_INDEX + 1][32];
+				for (int category = SC_MEMORY_TOTAL; category <= SC_MEMORY_SEARCH_INDEX; category++) {
+					StrFormatByteSize(SciCall_GetMemoryUsage(category), tchMemory[category], COUNTOF(tchMemory[0]));
+				}
+				wsprintf(tch + lstrlen(tch), L"Memory: %s (Text %s, Styles %s, Lines %s, Undo %s, Changes %s, Indicators %s, Per-line %s, Layout %s, Position %s, Search %s)\n",
+					tchMemory[SC_MEMORY_TOTAL], tchMemory[SC_MEMORY_TEXT], tchMemory[SC_MEMORY_STYLES],
+					tchMemory[SC_MEMORY_LINES], tchMemory[SC_MEMORY_UNDO_HISTORY], tchMemory[SC_MEMORY_CHANGE_HISTORY],
+					tchMemory[SC_MEMORY_DECORATIONS], tchMemory[SC_MEMORY_PER_LINE],
+					tchMemory[SC_MEMORY_LINE_LAYOUT_CACHE], tchMemory[SC_MEMORY_POSITION_CACHE],
+					tchMemory[SC_MEMORY_SEARCH_INDEX]);
+				GetStartupTiming(tch + lstrlen(tch));
+#if NP2_ENABLE_HEAP_STATISTICS
+				HeapStatistics_Format(tch + lstrlen(tch));
+#endif
 				SetClipData(hwnd, tch);
 			}
 			EndDialog(hwnd, IDOK);
@@ -923,72 +937,261 @@ extern MRUList mruFile;
 extern bool bSaveRecentFiles;
 extern int iMaxRecentFiles;
 
-static DWORD WINAPI FileMRUIconThread(LPVOID lpParam) noexcept {
-	const BackgroundWorker * const worker = static_cast<const BackgroundWorker *>(lpParam);
+#define FILEMRU_WORKER_COUNT	8		// existence checks are I/O bound
+#define FILEMRU_MAX_SHARES		64
+#define FILEMRU_SHARE_TIMEOUT	500		// wait time for probing a network share
+#define FILEMRU_SHARE_EXPIRE	30000	// network share is probed again after expired
+
+// resolved recent file, kept between dialog openings and validated by last write time.
+struct FileMRUCacheEntry {
+	WCHAR szPath[MAX_PATH];
+	FILETIME ftLastWriteTime;
+	DWORD dwFileAttributes;
+	DWORD dwShellAttributes;	// SFGAO_LINK and SFGAO_SHARE
+	int iImage;
+};
 
-	WCHAR tch[MAX_PATH] = L"";
-	DWORD dwFlags = SHGFI_SMALLICON | SHGFI_SYSICONINDEX | SHGFI_ATTRIBUTES | SHGFI_ATTR_SPECIFIED;
+// \\server\share of recent files, probed once instead of blocking on each file.
+struct FileMRUShare {
+	WCHAR szShare[MAX_PATH];
+	HANDLE hEvent;				// set when probe is finished
+	DWORD dwProbeTick;
+	bool bDone;
+	bool bReachable;
+};
 
-	HWND hwnd = worker->hwnd;
-	const int iMaxItem = ListView_GetItemCount(hwnd);
-	int iItem = 0;
+static SRWLOCK fileMRULock = SRWLOCK_INIT;
+static FileMRUCacheEntry *fileMRUCache;
+static UINT fileMRUCacheCount;
+static UINT fileMRUCacheCapacity;
+static FileMRUShare fileMRUShares[FILEMRU_MAX_SHARES];
+static UINT fileMRUShareCount;
+
+// caller holds fileMRULock
+static FileMRUCacheEntry *FileMRUCache_Find(LPCWSTR lpszPath) noexcept {
+	for (UINT i = 0; i < fileMRUCacheCount; i++) {
+		if (StrCaseEqual(fileMRUCache[i].szPath, lpszPath)) {
+			return &fileMRUCache[i];
+		}
+	}
+	return nullptr;
+}
+
+static bool FileMRUCache_Lookup(LPCWSTR lpszPath, FileMRUCacheEntry &result) noexcept {
+	AcquireSRWLockShared(&fileMRULock);
+	const FileMRUCacheEntry *entry = FileMRUCache_Find(lpszPath);
+	if (entry != nullptr) {
+		result = *entry;
+	}
+	ReleaseSRWLockShared(&fileMRULock);
+	return entry != nullptr;
+}
+
+static void FileMRUCache_Insert(const FileMRUCacheEntry &result) noexcept {
+	AcquireSRWLockExclusive(&fileMRULock);
+	FileMRUCacheEntry *entry = FileMRUCache_Find(result.szPath);
+	if (entry == nullptr) {
+		if (fileMRUCacheCount == fileMRUCacheCapacity) {
+			const UINT capacity = max(2*fileMRUCacheCapacity, 64U);
+			void *ptr = (fileMRUCache == nullptr) ? NP2HeapAlloc(capacity*sizeof(FileMRUCacheEntry)) : NP2HeapReAlloc(fileMRUCache, capacity*sizeof(FileMRUCacheEntry));
+			if (ptr != nullptr) {
+				fileMRUCache = static_cast<FileMRUCacheEntry *>(ptr);
+				fileMRUCacheCapacity = capacity;
+			}
+		}
+		if (fileMRUCacheCount < fileMRUCacheCapacity) {
+			entry = &fileMRUCache[fileMRUCacheCount++];
+		}
+	}
+	if (entry != nullptr) {
+		*entry = result;
+	}
+	ReleaseSRWLockExclusive(&fileMRULock);
+}
+
+static VOID CALLBACK FileMRU_ProbeShareCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context) noexcept {
+	FileMRUShare * const share = static_cast<FileMRUShare *>(context);
+	// szShare is not changed after added
+	const bool bReachable = GetFileAttributes(share->szShare) != INVALID_FILE_ATTRIBUTES;
+	AcquireSRWLockExclusive(&fileMRULock);
+	share->bDone = true;
+	share->bReachable = bReachable;
+	share->dwProbeTick = GetTickCount();
+	ReleaseSRWLockExclusive(&fileMRULock);
+	SetEvent(share->hEvent);
+}
+
+// files on share not reachable in time are not checked, probe is continued
+// on thread pool and the result is used for next dialog opening.
+static bool FileMRU_ProbeShare(LPCWSTR lpszPath, HANDLE eventCancel) noexcept {
+	WCHAR szShare[MAX_PATH];
+	lstrcpyn(szShare, lpszPath, COUNTOF(szShare));
+	if (!PathStripToRoot(szShare)) {
+		return false;
+	}
 
+	FileMRUShare *share = nullptr;
+	bool bProbe = false;
+	AcquireSRWLockExclusive(&fileMRULock);
+	for (UINT i = 0; i < fileMRUShareCount; i++) {
+		if (StrCaseEqual(fileMRUShares[i].szShare, szShare)) {
+			share = &fileMRUShares[i];
+			bProbe = share->bDone && (GetTickCount() - share->dwProbeTick) >= FILEMRU_SHARE_EXPIRE;
+			break;
+		}
+	}
+	if (share == nullptr && fileMRUShareCount < FILEMRU_MAX_SHARES) {
+		HANDLE hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		if (hEvent != nullptr) {
+			share = &fileMRUShares[fileMRUShareCount++];
+			lstrcpy(share->szShare, szShare);
+			share->hEvent = hEvent;
+			bProbe = true;
+		}
+	}
+	if (bProbe) {
+		share->bDone = false;
+		ResetEvent(share->hEvent);
+		if (!TrySubmitThreadpoolCallback(FileMRU_ProbeShareCallback, share, nullptr)) {
+			share->bDone = true;
+			share->bReachable = false;
+			share->dwProbeTick = GetTickCount();
+			SetEvent(share->hEvent);
+		}
+	}
+	ReleaseSRWLockExclusive(&fileMRULock);
+	if (share == nullptr) {
+		return false;
+	}
+
+	const HANDLE handles[2] = { share->hEvent, eventCancel };
+	WaitForMultipleObjects(COUNTOF(handles), handles, FALSE, FILEMRU_SHARE_TIMEOUT);
+	AcquireSRWLockShared(&fileMRULock);
+	const bool bReachable = share->bDone && share->bReachable;
+	ReleaseSRWLockShared(&fileMRULock);
+	return bReachable;
+}
+
+static void FileMRU_SetItemIcon(HWND hwnd, int iItem, int iImage, DWORD dwShellAttributes, DWORD dwFileAttributes) noexcept {
 	LV_ITEM lvi;
 	memset(&lvi, 0, sizeof(LV_ITEM));
+	lvi.mask = LVIF_IMAGE;
+	lvi.iItem = iItem;
+	lvi.iImage = iImage;
+
+	if (dwShellAttributes & SFGAO_LINK) {
+		lvi.mask |= LVIF_STATE;
+		lvi.stateMask |= LVIS_OVERLAYMASK;
+		lvi.state |= INDEXTOOVERLAYMASK(2);
+	}
 
-	while (iItem < iMaxItem && worker->Continue()) {
-		lvi.mask = LVIF_TEXT;
-		lvi.pszText = tch;
-		lvi.cchTextMax = COUNTOF(tch);
-		lvi.iItem = iItem;
-		if (ListView_GetItem(hwnd, &lvi)) {
-			SHFILEINFO shfi;
-			DWORD dwAttr = 0;
-			if (PathIsUNC(tch) || !PathIsFile(tch)) {
-				dwFlags |= SHGFI_USEFILEATTRIBUTES;
-				dwAttr = FILE_ATTRIBUTE_NORMAL;
-				shfi.dwAttributes = 0;
-				SHGetFileInfo(PathFindFileName(tch), dwAttr, &shfi, sizeof(SHFILEINFO), dwFlags);
-			} else {
-				shfi.dwAttributes = SFGAO_LINK | SFGAO_SHARE;
-				SHGetFileInfo(tch, dwAttr, &shfi, sizeof(SHFILEINFO), dwFlags);
-			}
+	if (dwShellAttributes & SFGAO_SHARE) {
+		lvi.mask |= LVIF_STATE;
+		lvi.stateMask |= LVIS_OVERLAYMASK;
+		lvi.state |= INDEXTOOVERLAYMASK(1);
+	}
 
-			lvi.mask = LVIF_IMAGE;
-			lvi.iImage = shfi.iIcon;
-			lvi.stateMask = 0;
-			lvi.state = 0;
+	if (!flagNoFadeHidden && (dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM))) {
+		lvi.mask |= LVIF_STATE;
+		lvi.stateMask |= LVIS_CUT;
+		lvi.state |= LVIS_CUT;
+	}
 
-			if (shfi.dwAttributes & SFGAO_LINK) {
-				lvi.mask |= LVIF_STATE;
-				lvi.stateMask |= LVIS_OVERLAYMASK;
-				lvi.state |= INDEXTOOVERLAYMASK(2);
-			}
+	ListView_SetItem(hwnd, &lvi);
+}
 
-			if (shfi.dwAttributes & SFGAO_SHARE) {
-				lvi.mask |= LVIF_STATE;
-				lvi.stateMask |= LVIS_OVERLAYMASK;
-				lvi.state |= INDEXTOOVERLAYMASK(1);
-			}
+// resolve rows on thread pool, a file on slow network share only blocks one worker.
+struct FileMRUIconWorker {
+	const BackgroundWorker *worker;
+	int iMaxItem;
+	LONG nextItem;
 
-			if (PathIsUNC(tch)) {
-				dwAttr = FILE_ATTRIBUTE_NORMAL;
-			} else {
-				dwAttr = GetFileAttributes(tch);
-			}
+	void ResolveItem(int iItem) const noexcept;
+	void DoWork() noexcept;
 
-			if (!flagNoFadeHidden &&
-					dwAttr != INVALID_FILE_ATTRIBUTES &&
-					dwAttr & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM)) {
-				lvi.mask |= LVIF_STATE;
-				lvi.stateMask |= LVIS_CUT;
-				lvi.state |= LVIS_CUT;
-			}
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		FileMRUIconWorker *iconWorker = static_cast<FileMRUIconWorker *>(context);
+		iconWorker->DoWork();
+	}
+};
 
-			lvi.iSubItem = 0;
-			ListView_SetItem(hwnd, &lvi);
+void FileMRUIconWorker::ResolveItem(int iItem) const noexcept {
+	HWND hwnd = worker->hwnd;
+	WCHAR tch[MAX_PATH] = L"";
+	LV_ITEM lvi;
+	memset(&lvi, 0, sizeof(LV_ITEM));
+	lvi.mask = LVIF_TEXT;
+	lvi.pszText = tch;
+	lvi.cchTextMax = COUNTOF(tch);
+	lvi.iItem = iItem;
+	if (!ListView_GetItem(hwnd, &lvi)) {
+		return;
+	}
+
+	WIN32_FILE_ATTRIBUTE_DATA fad;
+	const bool bCheck = !PathIsUNC(tch) || FileMRU_ProbeShare(tch, worker->eventCancel);
+	const bool bExists = bCheck && GetFileAttributesEx(tch, GetFileExInfoStandard, &fad);
+	const DWORD dwFileAttributes = bExists ? fad.dwFileAttributes : FILE_ATTRIBUTE_NORMAL;
+	DWORD dwShellAttributes = 0;
+	int iImage;
+	// icon is shared with DirList through IconCache_GetFileIcon()
+	if (!bExists || (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+		iImage = IconCache_GetFileIcon(PathFindFileName(tch), FILE_ATTRIBUTE_NORMAL, nullptr);
+	} else {
+		FileMRUCacheEntry entry;
+		if (FileMRUCache_Lookup(tch, entry) && entry.dwFileAttributes == fad.dwFileAttributes
+			&& CompareFileTime(&entry.ftLastWriteTime, &fad.ftLastWriteTime) == 0) {
+			dwShellAttributes = entry.dwShellAttributes;
+			iImage = entry.iImage;
+		} else {
+			SHFILEINFO shfi;
+			shfi.dwAttributes = SFGAO_LINK | SFGAO_SHARE;
+			SHGetFileInfo(tch, 0, &shfi, sizeof(SHFILEINFO), SHGFI_ATTRIBUTES | SHGFI_ATTR_SPECIFIED);
+			dwShellAttributes = shfi.dwAttributes & (SFGAO_LINK | SFGAO_SHARE);
+			iImage = IconCache_GetFileIcon(tch, fad.dwFileAttributes, &fad.ftLastWriteTime);
+
+			lstrcpy(entry.szPath, tch);
+			entry.ftLastWriteTime = fad.ftLastWriteTime;
+			entry.dwFileAttributes = fad.dwFileAttributes;
+			entry.dwShellAttributes = dwShellAttributes;
+			entry.iImage = iImage;
+			FileMRUCache_Insert(entry);
+		}
+	}
+
+	FileMRU_SetItemIcon(hwnd, iItem, iImage, dwShellAttributes, dwFileAttributes);
+}
+
+void FileMRUIconWorker::DoWork() noexcept {
+	const HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+	while (worker->Continue()) {
+		const int iItem = InterlockedIncrement(&nextItem) - 1;
+		if (iItem >= iMaxItem) {
+			break;
 		}
-		iItem++;
+		ResolveItem(iItem);
+	}
+	if (SUCCEEDED(hr)) {
+		CoUninitialize();
+	}
+}
+
+static DWORD WINAPI FileMRUIconThread(LPVOID lpParam) noexcept {
+	const BackgroundWorker * const worker = static_cast<const BackgroundWorker *>(lpParam);
+
+	// this thread is kept as BackgroundWorker::workerThread, waits for pool workers
+	FileMRUIconWorker iconWorker { worker, ListView_GetItemCount(worker->hwnd), 0 };
+	const UINT threadCount = min<UINT>(FILEMRU_WORKER_COUNT, iconWorker.iMaxItem);
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(FileMRUIconWorker::WorkCallback, &iconWorker, nullptr) : nullptr;
+	if (work != nullptr) {
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	iconWorker.DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
 	}
 
 	return 0;
@@ -1170,6 +1373,11 @@ static INT_PTR CALLBACK FileMRUDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPAR
 				lvi.iItem = i;
 				lvi.pszText = path;
 				ListView_InsertItem(hwndLV, &lvi);
+				// show icon of last opening, validated by icon thread
+				FileMRUCacheEntry entry;
+				if (FileMRUCache_Lookup(path, entry)) {
+					FileMRU_SetItemIcon(hwndLV, i, entry.iImage, entry.dwShellAttributes, entry.dwFileAttributes);
+				}
 			}
 
 			ListView_SetItemState(hwndLV, 0, LVIS_FOCUSED, LVIS_FOCUSED);
@@ -1241,6 +1449,947 @@ bool FileMRUDlg(HWND hwnd, LPWSTR lpstrFile) noexcept {
 	return iResult == IDOK;
 }
 
+//=============================================================================
+//
+// Find in Files
+//
+// directory walker thread appends files to queue, thread pool work items search them in order,
+// each file with matches is posted to the dialog as one heap block.
+//
+#define FindInFiles_MaxFileSize		(256*1024*1024)
+#define FindInFiles_MaxLineText		256
+#define FindInFiles_MaxFilter		32
+
+struct FindInFilesHit {
+	UINT line;		// 1-based line number
+	UINT column;	// character offset of match in line
+	UINT length;	// character count of match
+	UINT text;		// offset of line text in text pool
+};
+
+// hit array followed by text pool, which starts with path relative to search directory.
+struct FindInFilesResult {
+	UINT count;
+	const FindInFilesHit *Hits() const noexcept {
+		return reinterpret_cast<const FindInFilesHit *>(this + 1);
+	}
+	LPCWSTR Text(UINT offset) const noexcept {
+		return reinterpret_cast<LPCWSTR>(Hits() + count) + offset;
+	}
+};
+
+struct FindInFilesItem {
+	UINT file;
+	UINT hit;
+};
+
+// per work item buffers, reused for all files
+struct FindInFilesBuffer {
+	char *data;
+	char *converted;
+	FindInFilesHit *hits;
+	LPWSTR text;
+	UINT dataSize;
+	UINT convertedSize;
+	UINT hitCount;
+	UINT hitCapacity;
+	UINT textLength;
+	UINT textCapacity;
+};
+
+struct FindInFilesContext {
+	BackgroundWorker worker;	// where HWND is the dialog
+	UINT generation;			// results posted by canceled search are discarded
+	bool matchCase;
+	bool wholeWord;
+	bool asciiPattern;
+	int lengthUTF8;
+	int lengthANSI;				// zero when pattern is not representable in ANSI code page
+	int includeCount;
+	int excludeCount;
+	UINT rootLength;
+	LONG searchedCount;
+
+	SRWLOCK lock;
+	CONDITION_VARIABLE cond;
+	bool walkDone;
+	UINT fileCount;
+	UINT fileCapacity;
+	UINT nextFile;
+	LPWSTR *files;
+
+	// owned by the dialog, kept until next search
+	FindInFilesResult **results;
+	FindInFilesItem *items;
+	UINT resultCount;
+	UINT resultCapacity;
+	UINT itemCount;
+	UINT itemCapacity;
+
+	LPCWSTR include[FindInFiles_MaxFilter];
+	LPCWSTR exclude[FindInFiles_MaxFilter];
+	WCHAR filter[MAX_PATH];
+	WCHAR filterText[MAX_PATH];
+	WCHAR root[MAX_PATH];
+	WCHAR text[NP2_FIND_REPLACE_LIMIT/4];
+	// lower cased for case insensitive search
+	char patternUTF8[NP2_FIND_REPLACE_LIMIT];
+	char patternANSI[NP2_FIND_REPLACE_LIMIT];
+};
+
+static FindInFilesContext findInFiles;
+
+template <typename T>
+static bool FindInFiles_Reserve(T *&buffer, UINT &capacity, UINT size) noexcept {
+	if (size <= capacity) {
+		return true;
+	}
+	size = max(size, 2*capacity);
+	void *ptr = (buffer == nullptr) ? NP2HeapAlloc(size*sizeof(T)) : NP2HeapReAlloc(buffer, size*sizeof(T));
+	if (ptr == nullptr) {
+		return false;
+	}
+	buffer = static_cast<T *>(ptr);
+	capacity = size;
+	return true;
+}
+
+// ';' separated wildcards, file or directory matches wildcard prefixed with '-' is skipped.
+static void FindInFiles_ParseFilter(FindInFilesContext &context) noexcept {
+	context.includeCount = 0;
+	context.excludeCount = 0;
+	lstrcpy(context.filter, context.filterText);
+	LPWSTR p = context.filter;
+	while (*p) {
+		while (*p == L';' || *p == L' ') {
+			++p;
+		}
+		LPWSTR spec = p;
+		while (*p && *p != L';') {
+			++p;
+		}
+		if (*p) {
+			*p++ = L'\0';
+		}
+		if (*spec == L'-') {
+			++spec;
+			if (*spec && context.excludeCount < FindInFiles_MaxFilter) {
+				context.exclude[context.excludeCount++] = spec;
+			}
+		} else if (*spec && context.includeCount < FindInFiles_MaxFilter) {
+			context.include[context.includeCount++] = spec;
+		}
+	}
+}
+
+static bool FindInFiles_MatchSpec(LPCWSTR const *specs, int count, LPCWSTR name) noexcept {
+	for (int i = 0; i < count; i++) {
+		if (PathMatchSpec(name, specs[i])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void FindInFiles_AddFile(FindInFilesContext &context, LPCWSTR path) noexcept {
+	const size_t size = (lstrlen(path) + 1)*sizeof(WCHAR);
+	LPWSTR copy = static_cast<LPWSTR>(NP2HeapAlloc(size));
+	if (copy == nullptr) {
+		return;
+	}
+	memcpy(copy, path, size);
+	AcquireSRWLockExclusive(&context.lock);
+	if (FindInFiles_Reserve(context.files, context.fileCapacity, context.fileCount + 1)) {
+		context.files[context.fileCount++] = copy;
+		copy = nullptr;
+	}
+	ReleaseSRWLockExclusive(&context.lock);
+	if (copy == nullptr) {
+		WakeConditionVariable(&context.cond);
+	} else {
+		NP2HeapFree(copy);
+	}
+}
+
+// path[0, length) is the directory, hidden directories and symbolic links are skipped.
+static void FindInFiles_Walk(FindInFilesContext &context, LPWSTR path, UINT length) noexcept {
+	if (length + 2 >= MAX_PATH) {
+		return;
+	}
+	path[length] = L'\\';
+	path[length + 1] = L'*';
+	path[length + 2] = L'\0';
+	WIN32_FIND_DATA fd;
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+	HANDLE hFind = FindFirstFileEx(path, FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+#else
+	HANDLE hFind = FindFirstFile(path, &fd);
+#endif
+	if (hFind == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	do {
+		LPCWSTR name = fd.cFileName;
+		if ((name[0] == L'.' && (name[1] == L'\0' || (name[1] == L'.' && name[2] == L'\0')))
+			|| (fd.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM))
+			|| FindInFiles_MatchSpec(context.exclude, context.excludeCount, name)) {
+			continue;
+		}
+		const UINT cchName = lstrlen(name);
+		if (length + 1 + cchName >= MAX_PATH) {
+			continue;
+		}
+		memcpy(path + length + 1, name, (cchName + 1)*sizeof(WCHAR));
+		if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+				FindInFiles_Walk(context, path, length + 1 + cchName);
+			}
+		} else if (context.includeCount == 0 || FindInFiles_MatchSpec(context.include, context.includeCount, name)) {
+			FindInFiles_AddFile(context, path + context.rootLength + 1);
+		}
+	} while (context.worker.Continue() && FindNextFile(hFind, &fd));
+	FindClose(hFind);
+}
+
+static UINT FindInFiles_CountCharacters(const char *s, UINT length, UINT cpText) noexcept {
+	if (cpText == CP_UTF8) {
+		UINT count = 0;
+		for (UINT i = 0; i < length; i++) {
+			count += (static_cast<uint8_t>(s[i]) & 0xC0) != 0x80;
+		}
+		return count;
+	}
+	return MultiByteToWideChar(cpText, 0, s, length, nullptr, 0);
+}
+
+static bool FindInFiles_AddHit(FindInFilesBuffer &buffer, UINT line, const char *lineStart, const char *lineEnd, const char *match, int length, UINT cpText) noexcept {
+	if (!FindInFiles_Reserve(buffer.hits, buffer.hitCapacity, buffer.hitCount + 1)) {
+		return false;
+	}
+
+	// character offset is the same as Scintilla's character position after loading the file
+	FindInFilesHit &hit = buffer.hits[buffer.hitCount];
+	hit.line = line;
+	hit.column = FindInFiles_CountCharacters(lineStart, static_cast<UINT>(match - lineStart), cpText);
+	hit.length = FindInFiles_CountCharacters(match, length, cpText);
+
+	while (lineStart < match && (*lineStart == ' ' || *lineStart == '\t')) {
+		++lineStart;
+	}
+	if (lineEnd > match + length && lineEnd[-1] == '\r') {
+		--lineEnd;
+	}
+	const int cbLine = static_cast<int>(min<ptrdiff_t>(lineEnd - lineStart, FindInFiles_MaxLineText));
+	const int cchLine = MultiByteToWideChar(cpText, 0, lineStart, cbLine, nullptr, 0);
+	if (!FindInFiles_Reserve(buffer.text, buffer.textCapacity, buffer.textLength + cchLine + 1)) {
+		return false;
+	}
+
+	LPWSTR text = buffer.text + buffer.textLength;
+	MultiByteToWideChar(cpText, 0, lineStart, cbLine, text, cchLine);
+	for (int i = 0; i < cchLine; i++) {
+		if (text[i] == L'\t') {
+			text[i] = L' ';
+		}
+	}
+	text[cchLine] = L'\0';
+	hit.text = buffer.textLength;
+	buffer.textLength += cchLine + 1;
+	buffer.hitCount++;
+	return true;
+}
+
+static inline bool FindInFiles_EqualFold(const char *s, const char *pattern, int length) noexcept {
+	for (int i = 0; i < length; i++) {
+		if (ToLowerA(static_cast<uint8_t>(s[i])) != static_cast<uint8_t>(pattern[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// literal search, only ASCII letters are case folded, first match of each line is reported.
+static void FindInFiles_SearchText(const FindInFilesContext &context, FindInFilesBuffer &buffer, const char *text, UINT cbText, UINT cpText) noexcept {
+	const char *pattern = context.patternUTF8;
+	int length = context.lengthUTF8;
+	if (cpText != CP_UTF8) {
+		pattern = context.patternANSI;
+		length = context.lengthANSI;
+	}
+	if (length == 0 || cbText < static_cast<UINT>(length)) {
+		return;
+	}
+
+	const char * const end = text + cbText;
+	const char * const last = end - length;
+	const uint8_t first = pattern[0];
+	const char *lineStart = text;
+	UINT line = 1;
+	const char *p = text;
+	while (p <= last) {
+		if (context.matchCase) {
+			p = static_cast<const char *>(memchr(p, first, last - p + 1));
+			if (p == nullptr) {
+				break;
+			}
+			if (memcmp(p + 1, pattern + 1, length - 1) != 0) {
+				++p;
+				continue;
+			}
+		} else if (ToLowerA(static_cast<uint8_t>(*p)) != first || !FindInFiles_EqualFold(p + 1, pattern + 1, length - 1)) {
+			++p;
+			continue;
+		}
+		if (context.wholeWord && ((p != text && IsDocWordChar(static_cast<uint8_t>(p[-1])))
+			|| (p + length < end && IsDocWordChar(static_cast<uint8_t>(p[length]))))) {
+			++p;
+			continue;
+		}
+
+		const char *lineEnd;
+		while ((lineEnd = static_cast<const char *>(memchr(lineStart, '\n', p - lineStart))) != nullptr) {
+			++line;
+			lineStart = lineEnd + 1;
+		}
+		lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		if (!FindInFiles_AddHit(buffer, line, lineStart, lineEnd, p, length, cpText) || lineEnd == end) {
+			break;
+		}
+		++line;
+		p = lineEnd + 1;
+		lineStart = p;
+	}
+}
+
+// file encoding is detected here instead of EditDetermineEncoding(), which uses global state:
+// UTF-16 with BOM is converted to UTF-8, file contains NUL is treated as binary and skipped,
+// invalid UTF-8 is searched with the pattern in ANSI code page.
+static void FindInFiles_SearchFile(FindInFilesContext &context, FindInFilesBuffer &buffer, LPCWSTR relative) noexcept {
+	WCHAR path[MAX_PATH];
+	memcpy(path, context.root, context.rootLength*sizeof(WCHAR));
+	path[context.rootLength] = L'\\';
+	lstrcpy(path + context.rootLength + 1, relative);
+
+	HANDLE hFile = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	LARGE_INTEGER fileSize;
+	DWORD cbData = 0;
+	const bool success = GetFileSizeEx(hFile, &fileSize)
+		&& fileSize.QuadPart > 0 && fileSize.QuadPart <= FindInFiles_MaxFileSize
+		&& FindInFiles_Reserve(buffer.data, buffer.dataSize, static_cast<UINT>(fileSize.QuadPart) + NP2_ENCODING_DETECTION_PADDING)
+		&& ReadFile(hFile, buffer.data, static_cast<DWORD>(fileSize.QuadPart), &cbData, nullptr);
+	CloseHandle(hFile);
+	if (!success || cbData == 0) {
+		return;
+	}
+
+	InterlockedIncrement(&context.searchedCount);
+	memset(buffer.data + cbData, 0, NP2_ENCODING_DETECTION_PADDING);
+	const char *text = buffer.data;
+	UINT cpText = CP_UTF8;
+	const UINT bom = *reinterpret_cast<const uint16_t *>(text);
+	if (cbData >= 2 && (bom == BOM_UTF16LE || bom == BOM_UTF16BE)) {
+		LPWSTR wide = reinterpret_cast<LPWSTR>(buffer.data + 2);
+		const int cchWide = (cbData - 2)/sizeof(WCHAR);
+		if (bom == BOM_UTF16BE) {
+			for (int i = 0; i < cchWide; i++) {
+				wide[i] = _byteswap_ushort(wide[i]);
+			}
+		}
+		const int cbText = WideCharToMultiByte(CP_UTF8, 0, wide, cchWide, nullptr, 0, nullptr, nullptr);
+		if (cbText <= 0 || !FindInFiles_Reserve(buffer.converted, buffer.convertedSize, static_cast<UINT>(cbText))) {
+			return;
+		}
+		cbData = WideCharToMultiByte(CP_UTF8, 0, wide, cchWide, buffer.converted, cbText, nullptr, nullptr);
+		text = buffer.converted;
+	} else {
+		if (memchr(text, 0, min<DWORD>(cbData, 4096))) {
+			return;
+		}
+		if (cbData >= 3 && IsUTF8Signature(text)) {
+			text += 3;
+			cbData -= 3;
+		} else if (!context.asciiPattern && !IsUTF8(text, cbData)) {
+			cpText = CP_ACP;
+		}
+	}
+
+	const UINT cchPath = lstrlen(relative) + 1;
+	if (!FindInFiles_Reserve(buffer.text, buffer.textCapacity, cchPath)) {
+		return;
+	}
+	memcpy(buffer.text, relative, cchPath*sizeof(WCHAR));
+	buffer.textLength = cchPath;
+	buffer.hitCount = 0;
+	FindInFiles_SearchText(context, buffer, text, cbData, cpText);
+	if (buffer.hitCount == 0) {
+		return;
+	}
+
+	const size_t hitSize = buffer.hitCount*sizeof(FindInFilesHit);
+	FindInFilesResult *result = static_cast<FindInFilesResult *>(NP2HeapAlloc(sizeof(FindInFilesResult) + hitSize + buffer.textLength*sizeof(WCHAR)));
+	if (result != nullptr) {
+		result->count = buffer.hitCount;
+		memcpy(result + 1, buffer.hits, hitSize);
+		memcpy(reinterpret_cast<char *>(result + 1) + hitSize, buffer.text, buffer.textLength*sizeof(WCHAR));
+		if (!PostMessage(context.worker.hwnd, APPM_FINDINFILES, context.generation, AsInteger<LPARAM>(result))) {
+			NP2HeapFree(result);
+		}
+	}
+}
+
+static void FindInFiles_DoWork(FindInFilesContext &context) noexcept {
+	FindInFilesBuffer buffer;
+	memset(&buffer, 0, sizeof(FindInFilesBuffer));
+	while (context.worker.Continue()) {
+		LPCWSTR path = nullptr;
+		AcquireSRWLockExclusive(&context.lock);
+		while (context.nextFile == context.fileCount && !context.walkDone) {
+			SleepConditionVariableSRW(&context.cond, &context.lock, INFINITE, 0);
+		}
+		if (context.nextFile < context.fileCount) {
+			path = context.files[context.nextFile++];
+		}
+		ReleaseSRWLockExclusive(&context.lock);
+		if (path == nullptr) {
+			break;
+		}
+		FindInFiles_SearchFile(context, buffer, path);
+	}
+
+	if (buffer.data) {
+		NP2HeapFree(buffer.data);
+	}
+	if (buffer.converted) {
+		NP2HeapFree(buffer.converted);
+	}
+	if (buffer.hits) {
+		NP2HeapFree(buffer.hits);
+	}
+	if (buffer.text) {
+		NP2HeapFree(buffer.text);
+	}
+}
+
+static VOID CALLBACK FindInFiles_WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+	FindInFiles_DoWork(*static_cast<FindInFilesContext *>(context));
+}
+
+static DWORD WINAPI FindInFilesThread(LPVOID lpParam) noexcept {
+	FindInFilesContext &context = *static_cast<FindInFilesContext *>(lpParam);
+	// search while walking the directory
+	PTP_WORK work = CreateThreadpoolWork(FindInFiles_WorkCallback, &context, nullptr);
+	if (work != nullptr) {
+		const UINT threadCount = GetHardwareConcurrency();
+		for (UINT i = 0; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+
+	WCHAR path[MAX_PATH];
+	memcpy(path, context.root, (context.rootLength + 1)*sizeof(WCHAR));
+	FindInFiles_Walk(context, path, context.rootLength);
+
+	AcquireSRWLockExclusive(&context.lock);
+	context.walkDone = true;
+	ReleaseSRWLockExclusive(&context.lock);
+	WakeAllConditionVariable(&context.cond);
+	if (work == nullptr) {
+		FindInFiles_DoWork(context);
+	} else {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+
+	for (UINT i = 0; i < context.fileCount; i++) {
+		NP2HeapFree(context.files[i]);
+	}
+	if (context.files) {
+		NP2HeapFree(context.files);
+	}
+	context.files = nullptr;
+	context.fileCount = 0;
+	context.fileCapacity = 0;
+	context.nextFile = 0;
+	// lParam is zero for search finished
+	PostMessage(context.worker.hwnd, APPM_FINDINFILES, context.generation, 0);
+	return 0;
+}
+
+static void FindInFiles_AddResult(FindInFilesContext &context, WPARAM generation, FindInFilesResult *result) noexcept {
+	if (generation == context.generation
+		&& FindInFiles_Reserve(context.results, context.resultCapacity, context.resultCount + 1)
+		&& FindInFiles_Reserve(context.items, context.itemCapacity, context.itemCount + result->count)) {
+		const UINT file = context.resultCount++;
+		context.results[file] = result;
+		for (UINT i = 0; i < result->count; i++) {
+			FindInFilesItem &item = context.items[context.itemCount++];
+			item.file = file;
+			item.hit = i;
+		}
+	} else {
+		NP2HeapFree(result);
+	}
+}
+
+static void FindInFiles_UpdateStatus(HWND hwnd, const FindInFilesContext &context) noexcept {
+	WCHAR tchMatch[32];
+	WCHAR tchFile[32];
+	WCHAR tchSearched[32];
+	WCHAR tchFmt[128];
+	WCHAR tchStatus[256];
+	FormatNumber(tchMatch, context.itemCount);
+	FormatNumber(tchFile, context.resultCount);
+	FormatNumber(tchSearched, static_cast<UINT>(context.searchedCount));
+	FormatString(tchStatus, tchFmt, IDS_FINDINFILES_STATUS, tchMatch, tchFile, tchSearched);
+	SetDlgItemText(hwnd, IDC_FINDINFILES_STATUS, tchStatus);
+}
+
+static void FindInFiles_Start(HWND hwnd, FindInFilesContext &context) noexcept {
+	context.worker.Cancel();
+	context.generation++;
+	for (UINT i = 0; i < context.resultCount; i++) {
+		NP2HeapFree(context.results[i]);
+	}
+	context.resultCount = 0;
+	context.itemCount = 0;
+	context.searchedCount = 0;
+	ListView_SetItemCount(GetDlgItem(hwnd, IDC_FINDINFILES_RESULT), 0);
+
+	GetDlgItemText(hwnd, IDC_FINDINFILES_TEXT, context.text, COUNTOF(context.text));
+	GetDlgItemText(hwnd, IDC_FINDINFILES_DIR, context.root, COUNTOF(context.root));
+	GetDlgItemText(hwnd, IDC_FINDINFILES_FILTER, context.filterText, COUNTOF(context.filterText));
+	context.matchCase = IsButtonChecked(hwnd, IDC_FINDCASE);
+	context.wholeWord = IsButtonChecked(hwnd, IDC_FINDWORD);
+	FindInFiles_UpdateStatus(hwnd, context);
+
+	UINT rootLength = lstrlen(context.root);
+	while (rootLength != 0 && context.root[rootLength - 1] == L'\\') {
+		--rootLength;
+	}
+	context.root[rootLength] = L'\0';
+	context.rootLength = rootLength;
+	context.lengthUTF8 = WideCharToMultiByte(CP_UTF8, 0, context.text, -1, context.patternUTF8, COUNTOF(context.patternUTF8), nullptr, nullptr) - 1;
+	if (context.lengthUTF8 <= 0 || rootLength == 0 || !PathIsDirectory(context.root)) {
+		return;
+	}
+
+	BOOL bUsedDefault = FALSE;
+	context.lengthANSI = WideCharToMultiByte(CP_ACP, 0, context.text, -1, context.patternANSI, COUNTOF(context.patternANSI), nullptr, &bUsedDefault) - 1;
+	if (bUsedDefault || context.lengthANSI < 0) {
+		context.lengthANSI = 0;
+	}
+	context.asciiPattern = true;
+	for (int i = 0; i < context.lengthUTF8; i++) {
+		const uint8_t ch = context.patternUTF8[i];
+		context.asciiPattern = context.asciiPattern && ch < 0x80;
+		if (!context.matchCase) {
+			context.patternUTF8[i] = static_cast<char>(ToLowerA(ch));
+		}
+	}
+	if (!context.matchCase) {
+		for (int i = 0; i < context.lengthANSI; i++) {
+			context.patternANSI[i] = static_cast<char>(ToLowerA(static_cast<uint8_t>(context.patternANSI[i])));
+		}
+	}
+
+	FindInFiles_ParseFilter(context);
+	context.walkDone = false;
+	context.worker.workerThread = CreateThread(nullptr, 0, FindInFilesThread, &context, 0, nullptr);
+}
+
+//=============================================================================
+//
+// FindInFilesDlgProc()
+//
+//
+static INT_PTR CALLBACK FindInFilesDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam) noexcept {
+	static const DWORD controlDefinition[] = {
+		DeferCtlMove(IDC_RESIZEGRIP),
+		DeferCtlMoveX(IDOK),
+		DeferCtlMoveX(IDCANCEL),
+		DeferCtlSizeX(IDC_FINDINFILES_TEXT),
+		DeferCtlSizeX(IDC_FINDINFILES_DIR),
+		DeferCtlMoveX(IDC_FINDINFILES_BROWSE),
+		DeferCtlSizeX(IDC_FINDINFILES_FILTER),
+		DeferCtlSize(IDC_FINDINFILES_RESULT) | RESIZE_AUTOSIZE_USEHEADER,
+		DeferCtlMoveYSizeX(IDC_FINDINFILES_STATUS) | RESIZE_INVALIDATE_RECT,
+	};
+
+	FindInFilesContext &context = findInFiles;
+	switch (umsg) {
+	case WM_INITDIALOG: {
+		SetWindowLongPtr(hwnd, DWLP_USER, lParam);
+		context.worker.Init(hwnd);
+		InitializeSRWLock(&context.lock);
+		InitializeConditionVariable(&context.cond);
+		ResizeDlg_Init(hwnd, &positionRecord.cxFindInFilesDlg, &positionRecord.cyFindInFilesDlg, controlDefinition, COUNTOF(controlDefinition));
+
+		HWND hwndLV = GetDlgItem(hwnd, IDC_FINDINFILES_RESULT);
+		InitWindowCommon(hwndLV);
+		ListView_SetExtendedListViewStyle(hwndLV, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER | LVS_EX_LABELTIP);
+		const LVCOLUMN lvc = { LVCF_FMT | LVCF_TEXT, LVCFMT_LEFT, 0, nullptr, -1, 0, 0, 0
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+			, 0, 0, 0
+#endif
+		};
+		ListView_InsertColumn(hwndLV, 0, &lvc);
+		ListView_SetColumnWidth(hwndLV, 0, LVSCW_AUTOSIZE_USEHEADER);
+		ListView_SetItemCount(hwndLV, context.itemCount);
+
+		// single line selection as search text
+		const Sci_Position iSelStart = SciCall_GetSelectionStart();
+		const Sci_Position iSelEnd = SciCall_GetSelectionEnd();
+		const Sci_Position cchSelection = iSelEnd - iSelStart;
+		if (cchSelection != 0 && cchSelection < static_cast<Sci_Position>(COUNTOF(context.text))
+			&& SciCall_LineFromPosition(iSelStart) == SciCall_LineFromPosition(iSelEnd)) {
+			char *szSel = static_cast<char *>(NP2HeapAlloc(cchSelection + 1));
+			SciCall_GetSelText(szSel);
+			const int cchText = MultiByteToWideChar(SciCall_GetCodePage(), 0, szSel, static_cast<int>(cchSelection), context.text, COUNTOF(context.text) - 1);
+			context.text[cchText] = L'\0';
+			NP2HeapFree(szSel);
+		}
+		if (StrIsEmpty(context.root)) {
+			if (StrNotEmpty(szCurFile)) {
+				lstrcpy(context.root, szCurFile);
+				PathRemoveFileSpec(context.root);
+			} else {
+				GetCurrentDirectory(COUNTOF(context.root), context.root);
+			}
+		}
+
+		Edit_LimitText(GetDlgItem(hwnd, IDC_FINDINFILES_TEXT), COUNTOF(context.text) - 1);
+		Edit_LimitText(GetDlgItem(hwnd, IDC_FINDINFILES_DIR), COUNTOF(context.root) - 1);
+		Edit_LimitText(GetDlgItem(hwnd, IDC_FINDINFILES_FILTER), COUNTOF(context.filterText) - 1);
+		SetDlgItemText(hwnd, IDC_FINDINFILES_TEXT, context.text);
+		SetDlgItemText(hwnd, IDC_FINDINFILES_DIR, context.root);
+		SetDlgItemText(hwnd, IDC_FINDINFILES_FILTER, context.filterText);
+		CheckDlgButton(hwnd, IDC_FINDCASE, context.matchCase ? BST_CHECKED : BST_UNCHECKED);
+		CheckDlgButton(hwnd, IDC_FINDWORD, context.wholeWord ? BST_CHECKED : BST_UNCHECKED);
+		if (context.items != nullptr) {
+			FindInFiles_UpdateStatus(hwnd, context);
+		}
+
+		CenterDlgInParent(hwnd);
+	}
+	return TRUE;
+
+	case WM_DESTROY: {
+		context.worker.Destroy();
+		// results posted before the worker stopped
+		MSG msg;
+		while (PeekMessage(&msg, hwnd, APPM_FINDINFILES, APPM_FINDINFILES, PM_REMOVE)) {
+			if (msg.lParam) {
+				FindInFiles_AddResult(context, msg.wParam, AsPointer<FindInFilesResult *>(msg.lParam));
+			}
+		}
+		GetDlgItemText(hwnd, IDC_FINDINFILES_TEXT, context.text, COUNTOF(context.text));
+		GetDlgItemText(hwnd, IDC_FINDINFILES_FILTER, context.filterText, COUNTOF(context.filterText));
+		context.matchCase = IsButtonChecked(hwnd, IDC_FINDCASE);
+		context.wholeWord = IsButtonChecked(hwnd, IDC_FINDWORD);
+	}
+	return FALSE;
+
+	case APPM_FINDINFILES:
+		if (lParam) {
+			FindInFiles_AddResult(context, wParam, AsPointer<FindInFilesResult *>(lParam));
+			ListView_SetItemCountEx(GetDlgItem(hwnd, IDC_FINDINFILES_RESULT), context.itemCount, LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+		}
+		if (wParam == context.generation) {
+			FindInFiles_UpdateStatus(hwnd, context);
+		}
+		return TRUE;
+
+	case WM_NOTIFY: {
+		LPNMHDR pnmhdr = AsPointer<LPNMHDR>(lParam);
+		if (pnmhdr->idFrom == IDC_FINDINFILES_RESULT) {
+			switch (pnmhdr->code) {
+			case NM_DBLCLK: {
+				const int iItem = AsPointer<LPNMITEMACTIVATE>(lParam)->iItem;
+				if (iItem >= 0 && static_cast<UINT>(iItem) < context.itemCount) {
+					const FindInFilesItem &item = context.items[iItem];
+					const FindInFilesResult *result = context.results[item.file];
+					const FindInFilesHit &hit = result->Hits()[item.hit];
+					FindInFilesMatch *match = AsPointer<FindInFilesMatch *>(GetWindowLongPtr(hwnd, DWLP_USER));
+					memcpy(match->path, context.root, context.rootLength*sizeof(WCHAR));
+					match->path[context.rootLength] = L'\\';
+					lstrcpy(match->path + context.rootLength + 1, result->Text(0));
+					match->line = hit.line;
+					match->column = hit.column;
+					match->length = hit.length;
+					EndDialog(hwnd, IDOK);
+				}
+			}
+			break;
+
+			case LVN_GETDISPINFO: {
+				NMLVDISPINFO *lpdi = AsPointer<NMLVDISPINFO *>(lParam);
+				const int iItem = lpdi->item.iItem;
+				if ((lpdi->item.mask & LVIF_TEXT) && iItem >= 0 && static_cast<UINT>(iItem) < context.itemCount) {
+					const FindInFilesItem &item = context.items[iItem];
+					const FindInFilesResult *result = context.results[item.file];
+					const FindInFilesHit &hit = result->Hits()[item.hit];
+					wnsprintf(lpdi->item.pszText, lpdi->item.cchTextMax, L"%s:%u: %s", result->Text(0), hit.line, result->Text(hit.text));
+				}
+			}
+			break;
+			}
+		}
+	}
+	return TRUE;
+
+	case WM_COMMAND:
+		switch (LOWORD(wParam)) {
+		case IDC_FINDINFILES_BROWSE: {
+			WCHAR tchDir[MAX_PATH];
+			GetDlgItemText(hwnd, IDC_FINDINFILES_DIR, tchDir, COUNTOF(tchDir));
+			if (GetDirectory(hwnd, IDS_FINDINFILES_BROWSE, tchDir, tchDir)) {
+				SetDlgItemText(hwnd, IDC_FINDINFILES_DIR, tchDir);
+			}
+		}
+		break;
+
+		case IDOK:
+			FindInFiles_Start(hwnd, context);
+			break;
+
+		case IDCANCEL:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+		}
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+//=============================================================================
+//
+// FindInFilesDlg()
+//
+//
+bool FindInFilesDlg(HWND hwnd, FindInFilesMatch *match) noexcept {
+	const INT_PTR iResult = ThemedDialogBoxParam(g_hInstance, MAKEINTRESOURCE(IDD_FINDINFILES), hwnd, FindInFilesDlgProc, AsInteger<LPARAM>(match));
+	return iResult == IDOK;
+}
+
+//=============================================================================
+//
+// GotoSymbolDlgProc()
+//
+//
+#define GotoSymbol_MaxLineText		256
+
+struct GotoSymbolContext {
+	const Sci_Line *lines;
+	UINT count;
+	UINT *items;	// index into lines for symbols matched by filter
+	UINT itemCount;
+	UINT cpEdit;
+	int patternLength;
+	char pattern[256];
+};
+
+static GotoSymbolContext gotoSymbol;
+
+static bool GotoSymbol_Match(Sci_Line line, const char *pattern, int patternLength) noexcept {
+	const Sci_Position lineStart = SciCall_PositionFromLine(line);
+	const Sci_Position length = min<Sci_Position>(SciCall_GetLineEndPosition(line) - lineStart, GotoSymbol_MaxLineText);
+	if (length < patternLength) {
+		return false;
+	}
+	const char *text = SciCall_GetRangePointer(lineStart, length);
+	const char * const end = text + length - patternLength;
+	for (; text <= end; text++) {
+		if (FindInFiles_EqualFold(text, pattern, patternLength)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void GotoSymbol_Filter(HWND hwnd, GotoSymbolContext &context) noexcept {
+	WCHAR wchPattern[COUNTOF(context.pattern)/kMaxMultiByteCount];
+	GetDlgItemText(hwnd, IDC_GOTOSYMBOL_FILTER, wchPattern, COUNTOF(wchPattern));
+	char pattern[COUNTOF(context.pattern)];
+	int length = WideCharToMultiByte(context.cpEdit, 0, wchPattern, -1, pattern, COUNTOF(pattern), nullptr, nullptr) - 1;
+	length = max(length, 0);
+	for (int i = 0; i < length; i++) {
+		pattern[i] = static_cast<char>(ToLowerA(static_cast<uint8_t>(pattern[i])));
+	}
+	pattern[length] = '\0';
+
+	UINT count = 0;
+	if (context.patternLength != 0 && context.patternLength <= length
+		&& memcmp(context.pattern, pattern, context.patternLength) == 0) {
+		// pattern is extended, narrow current items
+		for (UINT i = 0; i < context.itemCount; i++) {
+			const UINT index = context.items[i];
+			if (GotoSymbol_Match(context.lines[index], pattern, length)) {
+				context.items[count++] = index;
+			}
+		}
+	} else {
+		for (UINT index = 0; index < context.count; index++) {
+			if (length == 0 || GotoSymbol_Match(context.lines[index], pattern, length)) {
+				context.items[count++] = index;
+			}
+		}
+	}
+	memcpy(context.pattern, pattern, length + 1);
+	context.patternLength = length;
+	context.itemCount = count;
+
+	HWND hwndLV = GetDlgItem(hwnd, IDC_GOTOSYMBOL_LIST);
+	ListView_SetItemCountEx(hwndLV, count, LVSICF_NOSCROLL);
+	if (count != 0) {
+		ListView_SetItemState(hwndLV, 0, LVIS_FOCUSED | LVIS_SELECTED, LVIS_FOCUSED | LVIS_SELECTED);
+		ListView_EnsureVisible(hwndLV, 0, FALSE);
+	}
+	EnableWindow(GetDlgItem(hwnd, IDOK), count != 0);
+}
+
+static bool GotoSymbol_Choose(HWND hwnd, const GotoSymbolContext &context, int iItem) noexcept {
+	if (iItem >= 0 && static_cast<UINT>(iItem) < context.itemCount) {
+		Sci_Line *line = AsPointer<Sci_Line *>(GetWindowLongPtr(hwnd, DWLP_USER));
+		*line = context.lines[context.items[iItem]];
+		EndDialog(hwnd, IDOK);
+		return true;
+	}
+	return false;
+}
+
+static INT_PTR CALLBACK GotoSymbolDlgProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam) noexcept {
+	static const DWORD controlDefinition[] = {
+		DeferCtlMove(IDC_RESIZEGRIP),
+		DeferCtlMove(IDOK),
+		DeferCtlMove(IDCANCEL),
+		DeferCtlSizeX(IDC_GOTOSYMBOL_FILTER),
+		DeferCtlSize(IDC_GOTOSYMBOL_LIST) | RESIZE_AUTOSIZE_USEHEADER,
+	};
+
+	GotoSymbolContext &context = gotoSymbol;
+	switch (umsg) {
+	case WM_INITDIALOG: {
+		SetWindowLongPtr(hwnd, DWLP_USER, lParam);
+		ResizeDlg_Init(hwnd, &positionRecord.cxGotoSymbolDlg, &positionRecord.cyGotoSymbolDlg, controlDefinition, COUNTOF(controlDefinition));
+
+		memset(&context, 0, sizeof(GotoSymbolContext));
+		context.lines = EditOutlineUpdate(&context.count);
+		context.cpEdit = SciCall_GetCodePage();
+		if (context.count != 0) {
+			context.items = static_cast<UINT *>(NP2HeapAlloc(context.count*sizeof(UINT)));
+		}
+
+		HWND hwndLV = GetDlgItem(hwnd, IDC_GOTOSYMBOL_LIST);
+		InitWindowCommon(hwndLV);
+		ListView_SetExtendedListViewStyle(hwndLV, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER | LVS_EX_LABELTIP);
+		const LVCOLUMN lvc = { LVCF_FMT | LVCF_TEXT, LVCFMT_LEFT, 0, nullptr, -1, 0, 0, 0
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+			, 0, 0, 0
+#endif
+		};
+		ListView_InsertColumn(hwndLV, 0, &lvc);
+		ListView_SetColumnWidth(hwndLV, 0, LVSCW_AUTOSIZE_USEHEADER);
+		Edit_LimitText(GetDlgItem(hwnd, IDC_GOTOSYMBOL_FILTER), COUNTOF(context.pattern)/kMaxMultiByteCount - 1);
+		if (context.items != nullptr) {
+			GotoSymbol_Filter(hwnd, context);
+			// select symbol containing the caret
+			const Sci_Line iCurLine = SciCall_LineFromPosition(SciCall_GetCurrentPos());
+			UINT index = 0;
+			while (index + 1 < context.count && context.lines[index + 1] <= iCurLine) {
+				++index;
+			}
+			ListView_SetItemState(hwndLV, index, LVIS_FOCUSED | LVIS_SELECTED, LVIS_FOCUSED | LVIS_SELECTED);
+			ListView_EnsureVisible(hwndLV, index, FALSE);
+		} else {
+			EnableWindow(GetDlgItem(hwnd, IDOK), FALSE);
+		}
+
+		CenterDlgInParent(hwnd);
+	}
+	return TRUE;
+
+	case WM_DESTROY:
+		if (context.items != nullptr) {
+			NP2HeapFree(context.items);
+		}
+		memset(&context, 0, sizeof(GotoSymbolContext));
+		return FALSE;
+
+	case WM_NOTIFY: {
+		LPNMHDR pnmhdr = AsPointer<LPNMHDR>(lParam);
+		if (pnmhdr->idFrom == IDC_GOTOSYMBOL_LIST) {
+			switch (pnmhdr->code) {
+			case NM_DBLCLK:
+				GotoSymbol_Choose(hwnd, context, AsPointer<LPNMITEMACTIVATE>(lParam)->iItem);
+				break;
+
+			case LVN_GETDISPINFO: {
+				NMLVDISPINFO *lpdi = AsPointer<NMLVDISPINFO *>(lParam);
+				const int iItem = lpdi->item.iItem;
+				if ((lpdi->item.mask & LVIF_TEXT) && iItem >= 0 && static_cast<UINT>(iItem) < context.itemCount) {
+					const Sci_Line line = context.lines[context.items[iItem]];
+					Sci_Position lineStart = SciCall_PositionFromLine(line);
+					const Sci_Position lineEnd = min<Sci_Position>(SciCall_GetLineEndPosition(line), lineStart + GotoSymbol_MaxLineText);
+					const char *text = SciCall_GetRangePointer(lineStart, lineEnd - lineStart);
+					while (lineStart < lineEnd && IsASpaceOrTab(*text)) {
+						++lineStart;
+						++text;
+					}
+					const int cchPrefix = wnsprintf(lpdi->item.pszText, lpdi->item.cchTextMax, L"%u: ", static_cast<UINT>(line + 1));
+					if (cchPrefix >= 0 && cchPrefix < lpdi->item.cchTextMax - 1) {
+						const int cchText = MultiByteToWideChar(context.cpEdit, 0, text, static_cast<int>(lineEnd - lineStart),
+							lpdi->item.pszText + cchPrefix, lpdi->item.cchTextMax - cchPrefix - 1);
+						lpdi->item.pszText[cchPrefix + cchText] = L'\0';
+					}
+				}
+			}
+			break;
+			}
+		}
+	}
+	return TRUE;
+
+	case WM_COMMAND:
+		switch (LOWORD(wParam)) {
+		case IDC_GOTOSYMBOL_FILTER:
+			if (HIWORD(wParam) == EN_CHANGE && context.items != nullptr) {
+				GotoSymbol_Filter(hwnd, context);
+			}
+			break;
+
+		case IDOK:
+			GotoSymbol_Choose(hwnd, context, ListView_GetNextItem(GetDlgItem(hwnd, IDC_GOTOSYMBOL_LIST), -1, LVNI_ALL | LVNI_SELECTED));
+			break;
+
+		case IDCANCEL:
+			EndDialog(hwnd, IDCANCEL);
+			break;
+		}
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+//=============================================================================
+//
+// GotoSymbolDlg()
+//
+//
+bool GotoSymbolDlg(HWND hwnd, Sci_Line *line) noexcept {
+	const INT_PTR iResult = ThemedDialogBoxParam(g_hInstance, MAKEINTRESOURCE(IDD_GOTOSYMBOL), hwnd, GotoSymbolDlgProc, AsInteger<LPARAM>(line));
+	return iResult == IDOK;
+}
+
 //=============================================================================
 //
 // ChangeNotifyDlgProc()
@@ -2286,7 +3435,8 @@ static INT_PTR CALLBACK AutoCompletionSettingsDlgProc(HWND hwnd, UINT umsg, WPAR
 		case IDOK: {
 			autoCompletionConfig.bIndentText = IsButtonChecked(hwnd, IDC_AUTO_INDENT_TEXT);
 
-			int mask = AutoCompletionOption_None;
+			// fuzzy match and project files are only available from ini file
+			int mask = autoCompletionConfig.iCompleteOption & (AutoCompletionOption_FuzzyMatch | AutoCompletionOption_ScanProjectFiles);
 			if (IsButtonChecked(hwnd, IDC_AUTO_CLOSE_TAGS)) {
 				mask |= AutoCompletionOption_CloseTags;
 			}
@@ -41,6 +41,15 @@ bool	OpenWithDlg(HWND hwnd, LPCWSTR lpstrFile);
 bool	FavoritesDlg(HWND hwnd, LPWSTR lpstrFile) noexcept;
 bool	AddToFavDlg(HWND hwnd, LPCWSTR lpszName, LPCWSTR lpszTarget);
 bool	FileMRUDlg(HWND hwnd, LPWSTR lpstrFile) noexcept;
+
+struct FindInFilesMatch {
+	WCHAR path[MAX_PATH];
+	UINT line;		// 1-based line number
+	UINT column;	// character offset of match in line
+	UINT length;	// character count of match
+};
+bool	FindInFilesDlg(HWND hwnd, FindInFilesMatch *match) noexcept;
+bool	GotoSymbolDlg(HWND hwnd, Sci_Line *line) noexcept;
 bool	ChangeNotifyDlg(HWND hwnd) noexcept;
 bool	ColumnWrapDlg(HWND hwnd) noexcept;
 bool	WordWrapSettingsDlg(HWND hwnd) noexcept;
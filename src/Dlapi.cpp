@@ -643,6 +643,51 @@ bool DirList_SelectItem(HWND hwnd, LPCWSTR lpszDisplayName, LPCWSTR lpszFullPath
 //
 // Create a valid DirListFilter structure
 //
+// Filter is compiled into a hash set of extensions for filters like *.cpp,
+// other wildcard filters are matched against lower case file name.
+//
+static UINT DirListFilter_Hash(LPCWSTR lpszExt) noexcept {
+	// FNV-1a
+	UINT hash = 2166136261U;
+	while (*lpszExt) {
+		hash = (hash ^ *lpszExt++) * 16777619U;
+	}
+	return hash;
+}
+
+// filters like *.cpp, extension contains no wildcard or dot
+static inline bool DirListFilter_IsExtension(LPCWSTR lpszFilter) noexcept {
+	if (lpszFilter[0] != L'*' || lpszFilter[1] != L'.') {
+		return false;
+	}
+	return StrPBrk(lpszFilter + 2, L"*?.") == nullptr;
+}
+
+// '*' matches any sequence, '?' matches any character
+static bool DirListFilter_WildcardMatch(LPCWSTR pattern, LPCWSTR name) noexcept {
+	LPCWSTR star = nullptr;
+	LPCWSTR resume = nullptr;
+	while (*name) {
+		if (*pattern == L'*') {
+			star = ++pattern;
+			resume = name;
+		} else if (*pattern == L'?' || *pattern == *name) {
+			++pattern;
+			++name;
+		} else if (star != nullptr) {
+			// let last '*' match one more character
+			pattern = star;
+			name = ++resume;
+		} else {
+			return false;
+		}
+	}
+	while (*pattern == L'*') {
+		++pattern;
+	}
+	return *pattern == L'\0';
+}
+
 void DirListFilter::Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept {
 	memset(this, 0, sizeof(DirListFilter));
 	if (StrIsEmpty(lpszFileSpec) || StrEqualEx(lpszFileSpec, L"*.*")) {
@@ -650,18 +695,78 @@ void DirListFilter::Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept {
 	}
 
 	lstrcpyn(tFilterBuf, lpszFileSpec, (DL_FILTER_BUFSIZE - 1));
+	CharLower(tFilterBuf);
 	bExcludeFilter = bExclude;
 	nCount = 1;
-	pFilter[0] = tFilterBuf; // Zeile zum Ausprobieren
 
-	WCHAR *p;
-	while ((p = StrChr(pFilter[nCount - 1], L';')) != nullptr) {
-		*p = L'\0';			// Replace L';' by L'\0'
-		pFilter[nCount] = (p + 1);	// Next position after L';'
+	LPWSTR p = tFilterBuf;
+	while (true) {
+		LPWSTR end = StrChr(p, L';');
+		if (end != nullptr) {
+			*end = L'\0';		// Replace L';' by L'\0'
+		}
+		if (*p) { // Filters like L"\0" are ignored
+			if (StrEqualEx(p, L"*") || StrEqualEx(p, L"*.*")) {
+				bMatchAll = true;
+			} else if (StrEqualEx(p, L"*.")) {
+				bMatchNoExtension = true;
+			} else if (DirListFilter_IsExtension(p)) {
+				LPCWSTR ext = p + 2;
+				UINT index = DirListFilter_Hash(ext) & (DL_FILTER_HASHSIZE - 1);
+				while (pExtension[index] != nullptr && !StrEqual(pExtension[index], ext)) {
+					index = (index + 1) & (DL_FILTER_HASHSIZE - 1);
+				}
+				pExtension[index] = ext;
+				nExtension++;
+			} else {
+				pFilter[nPattern++] = p;
+			}
+		}
+		if (end == nullptr) {
+			break;
+		}
+		p = end + 1;	// Next position after L';'
 		nCount++;		// Increase number of filters
 	}
 }
 
+//=============================================================================
+//
+// Check if a file name matches any filter
+//
+bool DirListFilter::MatchName(LPCWSTR lpszName) const noexcept {
+	if (bMatchAll) {
+		return true;
+	}
+
+	WCHAR szName[MAX_PATH];
+	lstrcpyn(szName, lpszName, COUNTOF(szName));
+	CharLower(szName);
+
+	LPCWSTR ext = PathFindExtension(szName);
+	if (*ext == L'\0') {
+		if (bMatchNoExtension) {
+			return true;
+		}
+	} else if (nExtension != 0 && ext[1] != L'\0') {
+		ext++;
+		UINT index = DirListFilter_Hash(ext) & (DL_FILTER_HASHSIZE - 1);
+		while (pExtension[index] != nullptr) {
+			if (StrEqual(pExtension[index], ext)) {
+				return true;
+			}
+			index = (index + 1) & (DL_FILTER_HASHSIZE - 1);
+		}
+	}
+
+	for (int i = 0; i < nPattern; i++) {
+		if (DirListFilter_WildcardMatch(pFilter[i], szName)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 //=============================================================================
 //
 // Check if a specified item matches a given filter
@@ -674,6 +779,14 @@ bool DirListFilter::Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept
 
 	WIN32_FIND_DATA fd;
 	SHGetDataFromIDList(lpsf, reinterpret_cast<PCUITEMID_CHILD>(pidl), SHGDFIL_FINDDATA, &fd, sizeof(WIN32_FIND_DATA));
+	return Match(fd);
+}
+
+bool DirListFilter::Match(const WIN32_FIND_DATA &fd) const noexcept {
+	// Immediately return true if lpszFileSpec is *.* or nullptr
+	if (nCount == 0 && !bExcludeFilter) {
+		return true;
+	}
 
 	// All the directories are added
 	if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
@@ -685,13 +798,8 @@ bool DirListFilter::Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept
 		return false;
 	}
 
-	for (int i = 0; i < nCount; i++) {
-		if (*pFilter[i]) { // Filters like L"\0" are ignored
-			const BOOL bMatchSpec = PathMatchSpec(fd.cFileName, pFilter[i]);
-			if (bMatchSpec) {
-				return !bExcludeFilter;
-			}
-		}
+	if (MatchName(fd.cFileName)) {
+		return !bExcludeFilter;
 	}
 
 	// No matching
@@ -1059,3 +1167,151 @@ bool IL_GetDisplayName(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl, DWORD dwFlags, LP
 
 	return false;
 }
+
+//==== IconCache ==============================================================
+
+// system image list index of files, shared by icon threads.
+struct IconCacheEntry {
+	LPWSTR key;					// Lower case extension, or path for files with own icon
+	UINT hash;
+	int iImage;
+	FILETIME ftLastWriteTime;	// Validates cached icon of file with own icon
+};
+
+static SRWLOCK iconCacheLock = SRWLOCK_INIT;
+static IconCacheEntry *iconCacheTable;
+static UINT iconCacheCount;
+static UINT iconCacheCapacity;
+
+// icon of these files is extracted from the file itself
+static bool IconCache_HasOwnIcon(LPCWSTR pszExt) noexcept {
+	static const WCHAR * const ownIconExtensions[] = {
+		L".exe", L".lnk", L".ico", L".cur", L".ani", L".url",
+	};
+	for (LPCWSTR ext : ownIconExtensions) {
+		if (StrCaseEqual(pszExt, ext)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static UINT IconCache_Hash(LPCWSTR key) noexcept {
+	// FNV-1a
+	UINT hash = 2166136261U;
+	while (*key) {
+		hash = (hash ^ *key++) * 16777619U;
+	}
+	return hash;
+}
+
+// open addressing with linear probing, returns empty slot when key is not found
+static IconCacheEntry *IconCache_FindSlot(IconCacheEntry *table, UINT capacity, LPCWSTR key, UINT hash) noexcept {
+	UINT index = hash & (capacity - 1);
+	while (table[index].key != nullptr) {
+		if (table[index].hash == hash && StrEqual(table[index].key, key)) {
+			break;
+		}
+		index = (index + 1) & (capacity - 1);
+	}
+	return &table[index];
+}
+
+static bool IconCache_Lookup(LPCWSTR key, UINT hash, const FILETIME &ftLastWriteTime, int *piImage) noexcept {
+	bool found = false;
+	AcquireSRWLockShared(&iconCacheLock);
+	if (iconCacheTable != nullptr) {
+		const IconCacheEntry *entry = IconCache_FindSlot(iconCacheTable, iconCacheCapacity, key, hash);
+		if (entry->key != nullptr && CompareFileTime(&entry->ftLastWriteTime, &ftLastWriteTime) == 0) {
+			*piImage = entry->iImage;
+			found = true;
+		}
+	}
+	ReleaseSRWLockShared(&iconCacheLock);
+	return found;
+}
+
+static void IconCache_Insert(LPCWSTR key, UINT hash, const FILETIME &ftLastWriteTime, int iImage) noexcept {
+	AcquireSRWLockExclusive(&iconCacheLock);
+	// keep load factor below 3/4
+	if ((iconCacheCount + 1) * 4 > iconCacheCapacity * 3) {
+		const UINT capacity = max(iconCacheCapacity * 2, 256U);
+		IconCacheEntry *table = static_cast<IconCacheEntry *>(NP2HeapAlloc(capacity * sizeof(IconCacheEntry)));
+		if (table != nullptr) {
+			for (UINT i = 0; i < iconCacheCapacity; i++) {
+				const IconCacheEntry &entry = iconCacheTable[i];
+				if (entry.key != nullptr) {
+					*IconCache_FindSlot(table, capacity, entry.key, entry.hash) = entry;
+				}
+			}
+			if (iconCacheTable != nullptr) {
+				NP2HeapFree(iconCacheTable);
+			}
+			iconCacheTable = table;
+			iconCacheCapacity = capacity;
+		}
+	}
+
+	if ((iconCacheCount + 1) * 4 <= iconCacheCapacity * 3) {
+		IconCacheEntry *entry = IconCache_FindSlot(iconCacheTable, iconCacheCapacity, key, hash);
+		if (entry->key == nullptr) {
+			const size_t cbKey = (lstrlen(key) + 1) * sizeof(WCHAR);
+			LPWSTR pszKey = static_cast<LPWSTR>(NP2HeapAlloc(cbKey));
+			if (pszKey != nullptr) {
+				memcpy(pszKey, key, cbKey);
+				entry->key = pszKey;
+				entry->hash = hash;
+				iconCacheCount++;
+			}
+		}
+		if (entry->key != nullptr) {
+			entry->iImage = iImage;
+			entry->ftLastWriteTime = ftLastWriteTime;
+		}
+	}
+	ReleaseSRWLockExclusive(&iconCacheLock);
+}
+
+//=============================================================================
+//
+// IconCache_GetFileIcon()
+//
+// Gets small icon index in system image list for a file, icon is cached
+// by extension, or by path and last write time for files with own icon.
+// pftLastWriteTime is nullptr for files not accessible, which use icon of
+// the extension.
+//
+int IconCache_GetFileIcon(LPCWSTR lpszPath, DWORD dwFileAttributes, const FILETIME *pftLastWriteTime) noexcept {
+	SHFILEINFO shfi;
+	shfi.iIcon = 0;
+	// folders may have custom icon
+	if (dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+		SHGetFileInfo(lpszPath, 0, &shfi, sizeof(SHFILEINFO), SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+		return shfi.iIcon;
+	}
+
+	LPCWSTR pszExt = PathFindExtension(lpszPath);
+	const bool bOwnIcon = pftLastWriteTime != nullptr && IconCache_HasOwnIcon(pszExt);
+
+	WCHAR key[MAX_PATH];
+	lstrcpyn(key, bOwnIcon ? lpszPath : pszExt, COUNTOF(key));
+	CharLower(key);
+	const UINT hash = IconCache_Hash(key);
+	FILETIME ftLastWriteTime = { 0, 0 };
+	if (bOwnIcon) {
+		ftLastWriteTime = *pftLastWriteTime;
+	}
+
+	int iImage;
+	if (IconCache_Lookup(key, hash, ftLastWriteTime, &iImage)) {
+		return iImage;
+	}
+
+	if (bOwnIcon) {
+		SHGetFileInfo(lpszPath, 0, &shfi, sizeof(SHFILEINFO), SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+	} else {
+		SHGetFileInfo(StrIsEmpty(pszExt) ? L"File" : pszExt, FILE_ATTRIBUTE_NORMAL, &shfi, sizeof(SHFILEINFO), SHGFI_USEFILEATTRIBUTES | SHGFI_SMALLICON | SHGFI_SYSICONINDEX);
+	}
+	IconCache_Insert(key, hash, ftLastWriteTime, shfi.iIcon);
+	return shfi.iIcon;
+}
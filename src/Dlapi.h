@@ -69,13 +69,21 @@ bool DirList_GetLongPathName(HWND hwnd, LPWSTR lpszLongPath) noexcept;
 bool DirList_SelectItem(HWND hwnd, LPCWSTR lpszDisplayName, LPCWSTR lpszFullPath);
 
 #define DL_FILTER_BUFSIZE 128
+#define DL_FILTER_HASHSIZE 64	// power of 2, larger than number of extension filters
 struct DirListFilter {
 	int nCount;
+	int nPattern;
+	int nExtension;
 	bool bExcludeFilter;
+	bool bMatchAll;				// * or *.*
+	bool bMatchNoExtension;		// *.
 	WCHAR tFilterBuf[DL_FILTER_BUFSIZE];
 	LPWSTR pFilter[DL_FILTER_BUFSIZE];
+	LPCWSTR pExtension[DL_FILTER_HASHSIZE];
 	void Create(LPCWSTR lpszFileSpec, bool bExclude) noexcept;
+	bool MatchName(LPCWSTR lpszName) const noexcept;
 	bool Match(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl) const noexcept;
+	bool Match(const WIN32_FIND_DATA &fd) const noexcept;
 };
 
 bool DriveBox_Init(HWND hwnd) noexcept;
@@ -89,3 +97,5 @@ bool DriveBox_GetDispInfo(HWND hwnd, LPARAM lParam);
 LPITEMIDLIST IL_Create(LPCITEMIDLIST pidl1, UINT cb1, LPCITEMIDLIST pidl2, UINT cb2) noexcept;
 UINT IL_GetSize(LPCITEMIDLIST pidl) noexcept;
 bool IL_GetDisplayName(LPSHELLFOLDER lpsf, LPCITEMIDLIST pidl, DWORD dwFlags, LPWSTR lpszDisplayName, int nDisplayName);
+
+int IconCache_GetFileIcon(LPCWSTR lpszPath, DWORD dwFileAttributes, const FILETIME *pftLastWriteTime) noexcept;
@@ -34,6 +34,7 @@
 #include <cinttypes>
 #include "SciCall.h"
 #include "VectorISA.h"
+#include "EventTrace.h"
 #include "Helpers.h"
 #include "Notepad4.h"
 #include "Edit.h"
@@ -43,6 +44,7 @@
 
 extern HWND hwndMain;
 extern HWND hwndEdit;
+extern HWND hwndStatus;
 extern DWORD dwLastIOError;
 extern HWND hDlgFindReplace;
 extern bool bReplaceInitialized;
@@ -50,8 +52,12 @@ extern bool bReplaceInitialized;
 extern int iDefaultEOLMode;
 extern bool bFixLineEndings;
 extern bool bAutoStripBlanks;
+extern bool bFixOnlyModifiedLines;
+extern bool bHexDumpBinaryFile;
 extern int iChangeHistoryMarker;
 extern int iSelectOption;
+extern unsigned int dwUndoMemoryLimit;
+extern unsigned int dwSearchIndexThreshold;
 
 // Default Codepage and Character Set
 extern int iDefaultCodePage;
@@ -97,6 +103,10 @@ wcsftimeSig GetFunctionPointer_wcsftime() noexcept {
 #endif
 
 void Edit_ReleaseResources() noexcept {
+	EditProjectWordsRelease();
+	EditOutlineReset();
+	EditHyperlinkReset();
+	EditPrintReset();
 	NP2HeapFree(wchPrefixSelection);
 	NP2HeapFree(wchAppendSelection);
 	NP2HeapFree(wchPrefixLines);
@@ -134,7 +144,51 @@ extern bool bLargeFileMode;
 extern int iWrapColumn;
 extern int iWordWrapIndent;
 
-void EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
+// text larger than this is appended in chunks, first screen is painted before appending remaining text.
+#define MIN_PROGRESSIVE_LOAD_SIZE		(16U << 20)
+#define PROGRESSIVE_LOAD_FIRST_CHUNK	(64U << 10)
+#define PROGRESSIVE_LOAD_CHUNK_SIZE		(8U << 20)
+
+static bool EditAppendTextProgressive(LPCSTR lpstrText, DWORD cbText) noexcept {
+	// cut first chunk at line end to avoid half line on first screen
+	DWORD length = PROGRESSIVE_LOAD_FIRST_CHUNK;
+	while (length > PROGRESSIVE_LOAD_FIRST_CHUNK/2 && lpstrText[length - 1] != '\n') {
+		--length;
+	}
+	SciCall_AppendText(length, lpstrText);
+	SendMessage(hwndEdit, WM_SETREDRAW, TRUE, 0);
+	InvalidateRect(hwndEdit, nullptr, TRUE);
+	UpdateWindow(hwndEdit);
+	SendMessage(hwndEdit, WM_SETREDRAW, FALSE, 0);
+
+	WCHAR tchFormat[128];
+	WCHAR tchStatus[128];
+	GetString(IDS_LOADFILE_PROGRESS, tchFormat, COUNTOF(tchFormat));
+	DWORD offset = length;
+	while (offset < cbText) {
+		// key messages are discarded while loading, Esc stops loading remaining text.
+		MSG msg;
+		while (PeekMessage(&msg, nullptr, WM_KEYDOWN, WM_KEYDOWN, PM_REMOVE)) {
+			if (msg.wParam == VK_ESCAPE) {
+				return false;
+			}
+		}
+		length = min<DWORD>(cbText - offset, PROGRESSIVE_LOAD_CHUNK_SIZE);
+		SciCall_AppendText(length, lpstrText + offset);
+		offset += length;
+		wsprintf(tchStatus, tchFormat, static_cast<UINT>((static_cast<uint64_t>(offset) * 100U) / cbText));
+		StatusSetText(hwndStatus, STATUS_HELP, tchStatus);
+		UpdateWindow(hwndStatus);
+	}
+	return true;
+}
+
+bool EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
+	EditWordIndexReset();
+	EditOutlineReset();
+	EditHyperlinkReset();
+	EditPrintReset();
+	EditFilterLinesReset();
 	bFreezeAppTitle = true;
 	bReadOnlyMode = false;
 	iWrapColumn = 0;
@@ -152,7 +206,11 @@ void EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
 #if defined(_WIN64)
 	// enable conversion between line endings
 	if (bLargeFileMode || cbText + lineCount >= MAX_SMALL_FILE_SIZE) {
-		constexpr int mask = SC_DOCUMENTOPTION_TEXT_LARGE | SC_DOCUMENTOPTION_STYLES_NONE;
+		int mask = SC_DOCUMENTOPTION_TEXT_LARGE | SC_DOCUMENTOPTION_STYLES_NONE | SC_DOCUMENTOPTION_STYLES_COMPRESSED;
+		if (cbText >= MAX_SMALL_FILE_SIZE) {
+			// editing far away from previous position no longer moves gigabytes of text
+			mask |= SC_DOCUMENTOPTION_TEXT_PIECES;
+		}
 		const int options = SciCall_GetDocumentOptions();
 		if ((options & mask) != mask) {
 			HANDLE pdoc = SciCall_CreateDocument(cbText + 1, options | mask);
@@ -164,6 +222,7 @@ void EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
 
 	fvCurFile.Apply();
 
+	bool completed = true;
 	if (cbText > 0) {
 		SendMessage(hwndEdit, WM_SETREDRAW, FALSE, 0);
 		SciCall_SetModEventMask(SC_MOD_NONE);
@@ -172,7 +231,11 @@ void EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
 		watch.Start();
 #endif
 		SciCall_AllocateLines(lineCount);
-		SciCall_AppendText(cbText, lpstrText);
+		if (cbText >= MIN_PROGRESSIVE_LOAD_SIZE) {
+			completed = EditAppendTextProgressive(lpstrText, cbText);
+		} else {
+			SciCall_AppendText(cbText, lpstrText);
+		}
 #if 0
 		watch.Stop();
 		watch.ShowLog("AddText time");
@@ -184,17 +247,122 @@ void EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept {
 
 	SciCall_SetUndoCollection(true);
 	SciCall_EmptyUndoBuffer();
+	SciCall_SetUndoMemoryLimit(static_cast<size_t>(dwUndoMemoryLimit) << 20);
+	SciCall_SetSearchIndexThreshold(static_cast<Sci_Position>(dwSearchIndexThreshold) << 20);
 	SciCall_SetSavePoint();
-	SciCall_SetChangeHistory(iChangeHistoryMarker);
+	SciCall_SetChangeHistory(EditGetChangeHistoryOption());
 	SciCall_SetUndoSelectionHistory((iSelectOption & SelectOption_UndoRedoRememberSelection) ? (SC_UNDO_SELECTION_HISTORY_ENABLED | SC_UNDO_SELECTION_HISTORY_SCROLL): SC_UNDO_SELECTION_HISTORY_DISABLED);
 
 	bFreezeAppTitle = false;
+	return completed;
+}
+
+namespace {
+
+bool IsASCIIText(const char *text, size_t length) noexcept {
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(text);
+	const uint8_t * const end = ptr + length;
+#if NP2_USE_AVX2
+	while (ptr + 2*sizeof(__m256i) <= end) {
+		const __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+		const __m256i chunk2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr + sizeof(__m256i)));
+		if (mm256_movemask_epi8(_mm256_or_si256(chunk1, chunk2)) != 0) {
+			return false;
+		}
+		ptr += 2*sizeof(__m256i);
+	}
+#elif NP2_USE_SSE2
+	while (ptr + 2*sizeof(__m128i) <= end) {
+		const __m128i chunk1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		const __m128i chunk2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + sizeof(__m128i)));
+		if (mm_movemask_epi8(_mm_or_si128(chunk1, chunk2)) != 0) {
+			return false;
+		}
+		ptr += 2*sizeof(__m128i);
+	}
+#endif
+	while (ptr < end) {
+		if (*ptr++ & 0x80) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// text inserted or removed by undo and redo must also read the same in both code pages
+bool IsUndoHistoryASCII() noexcept {
+	const int count = static_cast<int>(SciCall_GetUndoActions());
+	char *buffer = nullptr;
+	size_t capacity = 0;
+	bool ascii = true;
+	for (int action = 0; action < count && ascii; action++) {
+		const size_t length = SciCall_GetUndoActionText(action, nullptr);
+		if (length == 0) {
+			continue;
+		}
+		if (length > capacity) {
+			if (buffer != nullptr) {
+				NP2HeapFree(buffer);
+			}
+			capacity = max<size_t>(length, 4096);
+			buffer = static_cast<char *>(NP2HeapAlloc(capacity));
+			if (buffer == nullptr) {
+				return false;
+			}
+		}
+		SciCall_GetUndoActionText(action, buffer);
+		ascii = IsASCIIText(buffer, length);
+	}
+	if (buffer != nullptr) {
+		NP2HeapFree(buffer);
+	}
+	return ascii;
+}
+
+// convert UTF-8 text to ANSI code page chunk by chunk, output is not longer than input.
+#define CONVERT_TEXT_CHUNK_SIZE		(4U << 20)
+
+char *ConvertUTF8ToCodePage(const char *text, size_t length, UINT cpDest, UINT *cbText) noexcept {
+	char *pchText = static_cast<char *>(NP2HeapAlloc(length + 16));
+	LPWSTR pwchText = static_cast<LPWSTR>(NP2HeapAlloc((CONVERT_TEXT_CHUNK_SIZE + 16) * sizeof(WCHAR)));
+	size_t offset = 0;
+	if (pchText != nullptr && pwchText != nullptr) {
+		size_t position = 0;
+		while (position < length) {
+			size_t end = min<size_t>(position + CONVERT_TEXT_CHUNK_SIZE, length);
+			if (end < length) {
+				// don't split UTF-8 character
+				size_t back = end;
+				while (back > position && (static_cast<uint8_t>(text[back]) & 0xc0) == 0x80) {
+					--back;
+				}
+				if (back > position) {
+					end = back;
+				}
+			}
+			const int cchWide = MultiByteToWideChar(CP_UTF8, 0, text + position, static_cast<int>(end - position), pwchText, CONVERT_TEXT_CHUNK_SIZE + 16);
+			offset += WideCharToMultiByte(cpDest, 0, pwchText, cchWide, pchText + offset, static_cast<int>(length + 16 - offset), nullptr, nullptr);
+			position = end;
+		}
+	}
+	if (pwchText != nullptr) {
+		NP2HeapFree(pwchText);
+	}
+	*cbText = static_cast<UINT>(offset);
+	return pchText;
+}
+
 }
 
 //=============================================================================
 //
 // EditConvertText()
 //
+// Text only containing ASCII (text of undo history included) reads the same in
+// both code pages, only code page is changed, so undo history, bookmarks and
+// folding are kept. Other text is recoded to a new buffer directly from the
+// document, and undo history is dropped as undo can't restore the code page.
+//
 bool EditConvertText(UINT cpSource, UINT cpDest) noexcept {
 	if (cpSource == cpDest) {
 		return true;
@@ -208,17 +376,28 @@ bool EditConvertText(UINT cpSource, UINT cpDest) noexcept {
 	char *pchText = nullptr;
 	UINT cbText = 0;
 	if (length != 0) {
-		// DBCS: length -> WCHAR: sizeof(WCHAR) * (length / 2) -> UTF-8: kMaxMultiByteCount * (length / 2)
-		const size_t allocSize = NP2_align_up(length + 1, MEMORY_ALLOCATION_ALIGNMENT);
-		pchText = static_cast<char *>(NP2HeapAlloc(allocSize * sizeof(WCHAR)));
-		SciCall_GetText(length, pchText);
-
-		WCHAR *pwchText = static_cast<WCHAR *>(NP2HeapAlloc(allocSize * sizeof(WCHAR)));
-		const int cbwText = MultiByteToWideChar(cpSource, 0, pchText, static_cast<int>(length), pwchText, static_cast<int>(allocSize));
-		cbText = WideCharToMultiByte(cpDest, 0, pwchText, cbwText, pchText, static_cast<int>(allocSize * sizeof(WCHAR)), nullptr, nullptr);
-		NP2HeapFree(pwchText);
+		const char *text = SciCall_GetRangePointer(0, length);
+		if (IsASCIIText(text, length) && IsUndoHistoryASCII()) {
+			SciCall_SetCodePage(cpDest);
+			return true;
+		}
+		if (cpDest == SC_CP_UTF8) {
+			// table driven and parallel recoding
+			DWORD cbData = static_cast<DWORD>(length);
+			pchText = RecodeAsUTF8(const_cast<char *>(text), &cbData, cpSource, 0);
+			cbText = cbData;
+		} else {
+			pchText = ConvertUTF8ToCodePage(text, length, cpDest, &cbText);
+		}
+		if (pchText == nullptr) {
+			return false;
+		}
 	}
 
+	EditWordIndexReset();
+	EditOutlineReset();
+	EditHyperlinkReset();
+	EditPrintReset();
 	bReadOnlyMode = false;
 	SciCall_SetReadOnly(false);
 	SciCall_Cancel();
@@ -247,7 +426,7 @@ bool EditConvertText(UINT cpSource, UINT cpDest) noexcept {
 	if (length == 0 && StrIsEmpty(szCurFile)) {
 		SciCall_SetSavePoint();
 	}
-	SciCall_SetChangeHistory(iChangeHistoryMarker);
+	SciCall_SetChangeHistory(EditGetChangeHistoryOption());
 	SciCall_SetUndoSelectionHistory((iSelectOption & SelectOption_UndoRedoRememberSelection) ? (SC_UNDO_SELECTION_HISTORY_ENABLED | SC_UNDO_SELECTION_HISTORY_SCROLL): SC_UNDO_SELECTION_HISTORY_DISABLED);
 	UpdateLineNumberWidth();
 	return true;
@@ -255,55 +434,78 @@ bool EditConvertText(UINT cpSource, UINT cpDest) noexcept {
 
 #if defined(_WIN64)
 void EditConvertToLargeMode() noexcept {
-	int options = SciCall_GetDocumentOptions();
+	const int options = SciCall_GetDocumentOptions();
 	if (options & SC_DOCUMENTOPTION_TEXT_LARGE) {
 		return;
 	}
 
-	options |= SC_DOCUMENTOPTION_TEXT_LARGE;
-	const Sci_Position length = SciCall_GetLength();
-	HANDLE pdoc = SciCall_CreateDocument(length + 1, options);
-	char *pchText = nullptr;
-	if (length != 0) {
-		pchText = static_cast<char *>(NP2HeapAlloc(length + 1));
-		SciCall_GetText(length, pchText);
-	}
-
-	bReadOnlyMode = false;
-	SciCall_SetReadOnly(false);
-	SciCall_Cancel();
-	SciCall_SetChangeHistory(SC_CHANGE_HISTORY_DISABLED);
-	SciCall_SetUndoSelectionHistory(SC_UNDO_SELECTION_HISTORY_DISABLED);
-	SciCall_SetUndoCollection(false);
-	SciCall_EmptyUndoBuffer();
-	SciCall_ClearAll();
-	SciCall_ClearMarker();
+	// widen line starts in place, text, styles, undo and change history are kept
+	SciCall_ConvertToLargeDocument();
+	bLargeFileMode = true;
+}
+#endif
 
-	EditReplaceDocument(pdoc);
-	fvCurFile.Apply();
+namespace {
 
-	if (length != 0) {
-		SendMessage(hwndEdit, WM_SETREDRAW, FALSE, 0);
-		SciCall_SetModEventMask(SC_MOD_NONE);
-		SciCall_AppendText(length, pchText);
-		SciCall_SetModEventMask(SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT);
-		SendMessage(hwndEdit, WM_SETREDRAW, TRUE, 0);
-		InvalidateRect(hwndEdit, nullptr, TRUE);
-	}
-	if (pchText != nullptr) {
-		NP2HeapFree(pchText);
+// change of length after converting line endings to iEOLMode,
+// only CRLF mode grows and other modes only shrink.
+template <typename T>
+ptrdiff_t ClipboardLineEndingsDelta(const T *s, int iEOLMode) noexcept {
+	ptrdiff_t delta = 0;
+	while (*s != '\0') {
+		const T ch = *s++;
+		if (ch == '\r' && *s == '\n') {
+			s++;
+			if (iEOLMode != SC_EOL_CRLF) {
+				--delta;
+			}
+		} else if ((ch == '\n' || ch == '\r') && iEOLMode == SC_EOL_CRLF) {
+			++delta;
+		}
 	}
+	return delta;
+}
 
-	SciCall_SetUndoCollection(true);
-	SciCall_EmptyUndoBuffer();
-	SciCall_SetSavePoint();
-	SciCall_SetChangeHistory(iChangeHistoryMarker);
-	SciCall_SetUndoSelectionHistory((iSelectOption & SelectOption_UndoRedoRememberSelection) ? (SC_UNDO_SELECTION_HISTORY_ENABLED | SC_UNDO_SELECTION_HISTORY_SCROLL): SC_UNDO_SELECTION_HISTORY_DISABLED);
+// convert line endings in place, buffer has room for max(length, length + delta) + 1 units.
+template <typename T>
+void ConvertClipboardLineEndings(T *s, size_t length, ptrdiff_t delta, int iEOLMode) noexcept {
+	if (iEOLMode == SC_EOL_CRLF) {
+		// expand from the end to not overwrite unread text
+		const T *p = s + length;
+		T *d = s + length + delta;
+		*d = '\0';
+		while (p != d) {
+			const T ch = *--p;
+			if (ch == '\n' || ch == '\r') {
+				if (ch == '\n' && p != s && p[-1] == '\r') {
+					--p;
+				}
+				*--d = '\n';
+				*--d = '\r';
+			} else {
+				*--d = ch;
+			}
+		}
+	} else {
+		const T eol = (iEOLMode == SC_EOL_LF) ? '\n' : '\r';
+		const T * const end = s + length;
+		T *d = s;
+		for (const T *p = s; p < end;) {
+			const T ch = *p++;
+			if (ch == '\n' || ch == '\r') {
+				if (ch == '\r' && p < end && *p == '\n') {
+					p++;
+				}
+				*d++ = eol;
+			} else {
+				*d++ = ch;
+			}
+		}
+		*d = '\0';
+	}
+}
 
-	Style_SetLexer(pLexCurrent, true);
-	bLargeFileMode = true;
 }
-#endif
 
 //=============================================================================
 //
@@ -316,44 +518,21 @@ char* EditGetClipboardText(HWND hwnd) noexcept {
 
 	HANDLE hmem = GetClipboardData(CF_UNICODETEXT);
 	LPCWSTR pwch = static_cast<LPCWSTR>(GlobalLock(hmem));
+	char *pmch = nullptr;
 
-	const UINT cpEdit = SciCall_GetCodePage();
-	const UINT mlen = WideCharToMultiByte(cpEdit, 0, pwch, -1, nullptr, 0, nullptr, nullptr);
-	char *pmch = static_cast<char *>(LocalAlloc(LPTR, mlen*2));
-	char *ptmp = static_cast<char *>(NP2HeapAlloc(mlen));
-
-	if (pmch && ptmp) {
-		WideCharToMultiByte(cpEdit, 0, pwch, -1, ptmp, mlen, nullptr, nullptr);
+	if (pwch) {
+		// convert directly into result, then fix line endings in place
+		const UINT cpEdit = SciCall_GetCodePage();
 		const int iEOLMode = SciCall_GetEOLMode();
-		const char *s = ptmp;
-		char *d = pmch;
-		while (*s != '\0') {
-			if (*s == '\n' || *s == '\r') {
-				switch (iEOLMode) {
-				default: // SC_EOL_CRLF
-					*d++ = '\r';
-					*d++ = '\n';
-					break;
-				case SC_EOL_LF:
-					*d++ = '\n';
-					break;
-				case SC_EOL_CR:
-					*d++ = '\r';
-					break;
-				}
-				if (*s == '\r' && s[1] == '\n') {
-					s++;
-				}
-				s++;
-			} else {
-				*d++ = *s++;
-			}
+		const ptrdiff_t delta = ClipboardLineEndingsDelta(pwch, iEOLMode);
+		const UINT mlen = WideCharToMultiByte(cpEdit, 0, pwch, -1, nullptr, 0, nullptr, nullptr);
+		pmch = static_cast<char *>(LocalAlloc(LPTR, mlen + max<ptrdiff_t>(delta, 0)));
+		if (pmch) {
+			WideCharToMultiByte(cpEdit, 0, pwch, -1, pmch, mlen, nullptr, nullptr);
+			ConvertClipboardLineEndings(pmch, mlen - 1, delta, iEOLMode);
 		}
-
-		*d++ = '\0';
 	}
 
-	NP2HeapFree(ptmp);
 	GlobalUnlock(hmem);
 	CloseClipboard();
 
@@ -367,37 +546,17 @@ LPWSTR EditGetClipboardTextW() noexcept {
 
 	HANDLE hmem = GetClipboardData(CF_UNICODETEXT);
 	LPCWSTR pwch = static_cast<LPCWSTR>(GlobalLock(hmem));
-	const UINT wlen = lstrlen(pwch);
-	LPWSTR ptmp = static_cast<LPWSTR>(NP2HeapAlloc((2*wlen + 1)*sizeof(WCHAR)));
+	LPWSTR ptmp = nullptr;
 
-	if (pwch && ptmp) {
+	if (pwch) {
 		const int iEOLMode = SciCall_GetEOLMode();
-		LPCWSTR s = pwch;
-		LPWSTR d = ptmp;
-		while (*s != L'\0') {
-			if (*s == L'\n' || *s == L'\r') {
-				switch (iEOLMode) {
-				default: // SC_EOL_CRLF
-					*d++ = L'\r';
-					*d++ = L'\n';
-					break;
-				case SC_EOL_LF:
-					*d++ = L'\n';
-					break;
-				case SC_EOL_CR:
-					*d++ = L'\r';
-					break;
-				}
-				if (*s == L'\r' && s[1] == L'\n') {
-					s++;
-				}
-				s++;
-			} else {
-				*d++ = *s++;
-			}
+		const ptrdiff_t delta = ClipboardLineEndingsDelta(pwch, iEOLMode);
+		const size_t wlen = lstrlen(pwch);
+		ptmp = static_cast<LPWSTR>(NP2HeapAlloc((wlen + max<ptrdiff_t>(delta, 0) + 1)*sizeof(WCHAR)));
+		if (ptmp) {
+			memcpy(ptmp, pwch, wlen*sizeof(WCHAR));
+			ConvertClipboardLineEndings(ptmp, wlen, delta, iEOLMode);
 		}
-
-		*d++ = L'\0';
 	}
 
 	GlobalUnlock(hmem);
@@ -473,7 +632,7 @@ void EditCopyAppend(HWND hwnd) noexcept {
 //
 // EditDetectEOLMode()
 //
-void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) noexcept {
+static void EditCountLineEndings(LPCSTR lpData, DWORD cbData, size_t (&linesCount)[3]) noexcept {
 	/* '\r' and '\n' is not reused (e.g. as trailing byte in DBCS) by any known encoding,
 	it's safe to check whole data byte by byte.*/
 
@@ -524,7 +683,7 @@ void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) no
 		_mm512_storeu_si512(buffer, zero);
 		__movsb(buffer, ptr, end - ptr);
 
-		const __m512i chunk = _mm512_loadu_si512(ptr);
+		const __m512i chunk = _mm512_loadu_si512(buffer);
 		uint64_t maskLF = _mm512_cmpeq_epi8_mask(chunk, vectLF);
 		uint64_t maskCR = _mm512_cmpeq_epi8_mask(chunk, vectCR);
 
@@ -778,6 +937,42 @@ void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) no
 	// end NP2_USE_SSE2
 #else
 
+#if NP2_USE_NEON
+	// count CR, LF and CR+LF in byte counters, flush them before overflow.
+	// CR+LF is counted when CR is inside the chunk, LF alone = LF - CR+LF, CR alone = CR - CR+LF,
+	// modular arithmetic makes the sum correct when CR+LF crosses flushing boundary.
+	const uint8x16_t vectCR = vdupq_n_u8('\r');
+	const uint8x16_t vectLF = vdupq_n_u8('\n');
+	if (ptr + sizeof(uint8x16_t) <= end) {
+		do {
+			uint8x16_t countCR = vdupq_n_u8(0);
+			uint8x16_t countLF = vdupq_n_u8(0);
+			uint8x16_t countCRLF = vdupq_n_u8(0);
+			UINT round = 0;
+			do {
+				// end is last byte, reading ptr[16] is safe
+				const uint8x16_t chunk = vld1q_u8(ptr);
+				const uint8x16_t next = vld1q_u8(ptr + 1);
+				ptr += sizeof(uint8x16_t);
+				const uint8x16_t maskCR = vceqq_u8(chunk, vectCR);
+				countCR = vsubq_u8(countCR, maskCR);
+				countLF = vsubq_u8(countLF, vceqq_u8(chunk, vectLF));
+				countCRLF = vsubq_u8(countCRLF, vandq_u8(maskCR, vceqq_u8(next, vectLF)));
+				++round;
+			} while (round < 255 && ptr + sizeof(uint8x16_t) <= end);
+			const size_t crlf = vaddlvq_u8(countCRLF);
+			lineCountCRLF += crlf;
+			lineCountCR += vaddlvq_u8(countCR) - crlf;
+			lineCountLF += vaddlvq_u8(countLF) - crlf;
+		} while (ptr + sizeof(uint8x16_t) <= end);
+		if (ptr[-1] == '\r' && *ptr == '\n') {
+			// LF of CR+LF across the last chunk
+			++lineCountLF;
+			++ptr;
+		}
+	}
+#endif
+
 #if defined(__clang__) || defined(__GNUC__) || defined(__ICL) || !defined(_MSC_VER)
 	while (ptr < end) {
 		const uint8_t ch = *ptr++;
@@ -837,10 +1032,83 @@ void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) no
 	}
 #endif
 
+	linesCount[SC_EOL_CRLF] = lineCountCRLF;
+	linesCount[SC_EOL_CR] = lineCountCR;
+	linesCount[SC_EOL_LF] = lineCountLF;
+}
+
+// count line endings of large buffer in chunks on thread pool, chunk boundary
+// is moved forward to not split CR+LF, so sum of chunk counts is the total count.
+#define MIN_PARALLEL_EOL_DETECTION_SIZE		(16U << 20)
+#define PARALLEL_EOL_DETECTION_CHUNK_SIZE	(2U << 20)
+
+struct LineEndingCountWorker {
+	const char *data;
+	DWORD length;
+	DWORD chunkCount;
+	LONG nextChunk;
+	volatile LONG64 linesCount[3];
+
+	DWORD ChunkStart(DWORD index) const noexcept {
+		if (index == 0) {
+			return 0;
+		}
+		if (index >= chunkCount) {
+			return length;
+		}
+		const DWORD position = index*PARALLEL_EOL_DETECTION_CHUNK_SIZE;
+		return position + (data[position - 1] == '\r' && data[position] == '\n');
+	}
+
+	void DoWork() noexcept {
+		while (true) {
+			const DWORD index = static_cast<DWORD>(InterlockedIncrement(&nextChunk) - 1);
+			if (index >= chunkCount) {
+				break;
+			}
+			const DWORD start = ChunkStart(index);
+			const DWORD end = ChunkStart(index + 1);
+			size_t counts[3];
+			EditCountLineEndings(data + start, end - start, counts);
+			for (int i = 0; i < 3; i++) {
+				InterlockedAdd64(&linesCount[i], static_cast<LONG64>(counts[i]));
+			}
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		LineEndingCountWorker *worker = static_cast<LineEndingCountWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) noexcept {
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), cbData/PARALLEL_EOL_DETECTION_CHUNK_SIZE);
+	PTP_WORK work = nullptr;
+	LineEndingCountWorker worker {
+		lpData, cbData, (cbData + PARALLEL_EOL_DETECTION_CHUNK_SIZE - 1)/PARALLEL_EOL_DETECTION_CHUNK_SIZE, 0, {}
+	};
+	if (cbData >= MIN_PARALLEL_EOL_DETECTION_SIZE && threadCount > 1) {
+		work = CreateThreadpoolWork(LineEndingCountWorker::WorkCallback, &worker, nullptr);
+	}
+	if (work == nullptr) {
+		EditCountLineEndings(lpData, cbData, status.linesCount);
+	} else {
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+		worker.DoWork();
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+		for (int i = 0; i < 3; i++) {
+			status.linesCount[i] = static_cast<size_t>(worker.linesCount[i]);
+		}
+	}
+
+	const size_t lineCountCRLF = status.linesCount[SC_EOL_CRLF];
+	const size_t lineCountCR = status.linesCount[SC_EOL_CR];
+	const size_t lineCountLF = status.linesCount[SC_EOL_LF];
 	const size_t linesMax = max(max(lineCountCRLF, lineCountCR), lineCountLF);
-	status.linesCount[SC_EOL_CRLF] = lineCountCRLF;
-	status.linesCount[SC_EOL_CR] = lineCountCR;
-	status.linesCount[SC_EOL_LF] = lineCountLF;
 	int iEOLMode = status.iEOLMode;
 	if (linesMax != status.linesCount[iEOLMode]) {
 		if (linesMax == lineCountCRLF) {
@@ -857,26 +1125,16 @@ void EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) no
 	status.totalLineCount = lineCountCRLF + lineCountCR + lineCountLF + 1;
 }
 
-void EditDetectIndentation(LPCSTR lpData, DWORD cbData, EditFileVars &fv) noexcept {
-	if ((fv.mask & FV_MaskHasFileTabSettings) == FV_MaskHasFileTabSettings) {
-		return;
-	}
-	if (!tabSettings.bDetectIndentation) {
-		return;
-	}
-
-#if 0
-	StopWatch watch;
-	watch.Start();
-#endif
+#define MAX_DETECTED_TAB_WIDTH	8
+// line count for ambiguous lines, line indented by 1 to 8 spaces, line starts with tab.
+#define INDENT_LINE_COUNT_SIZE	(1 + MAX_DETECTED_TAB_WIDTH + 1 + (6*NP2_USE_AVX2))
+// head of the file is scanned in full, then evenly spaced blocks (include the tail) are sampled,
+// so time to detect indentation is bounded for large file.
+#define DETECT_INDENTATION_HEAD_SIZE	(1U << 20)
+#define DETECT_INDENTATION_BLOCK_SIZE	(64U << 10)
+#define DETECT_INDENTATION_BLOCK_COUNT	16
 
-	// code based on SciTEBase::DiscoverIndentSetting().
-	cbData = min<DWORD>(cbData, 1*1024*1024);
-	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(lpData);
-	const uint8_t * const end = ptr + cbData;
-	#define MAX_DETECTED_TAB_WIDTH	8
-	// line count for ambiguous lines, line indented by 1 to 8 spaces, line starts with tab.
-	uint32_t indentLineCount[1 + MAX_DETECTED_TAB_WIDTH + 1 + (6*NP2_USE_AVX2)]{};
+static void EditCountIndentLines(const uint8_t *ptr, const uint8_t * const end, uint32_t (&indentLineCount)[INDENT_LINE_COUNT_SIZE]) noexcept {
 	int prevIndentCount = 0;
 	int prevTabWidth = 0;
 
@@ -960,13 +1218,33 @@ labelStart:
 			// nop
 		}
 	}
+}
+
+static int EditDetectTabWidth(LPCSTR lpData, DWORD cbData) noexcept {
+	// code based on SciTEBase::DiscoverIndentSetting().
+	uint32_t indentLineCount[INDENT_LINE_COUNT_SIZE]{};
+	const uint8_t * const start = reinterpret_cast<const uint8_t *>(lpData);
+	EditCountIndentLines(start, start + min(cbData, DETECT_INDENTATION_HEAD_SIZE), indentLineCount);
+	if (cbData >= DETECT_INDENTATION_HEAD_SIZE + DETECT_INDENTATION_BLOCK_SIZE*DETECT_INDENTATION_BLOCK_COUNT) {
+		const DWORD step = (cbData - DETECT_INDENTATION_HEAD_SIZE) / DETECT_INDENTATION_BLOCK_COUNT;
+		for (UINT i = 1; i <= DETECT_INDENTATION_BLOCK_COUNT; i++) {
+			const uint8_t * const end = (i == DETECT_INDENTATION_BLOCK_COUNT) ? (start + cbData) : (start + DETECT_INDENTATION_HEAD_SIZE + step*i);
+			// skip partial first line
+			const uint8_t *ptr = end - DETECT_INDENTATION_BLOCK_SIZE;
+			while (ptr < end && *ptr != '\r' && *ptr != '\n') {
+				++ptr;
+			}
+			EditCountIndentLines(ptr, end, indentLineCount);
+		}
+	}
 
+	int tabWidth;
 	// reduce code size for the unrolled loop
 #if NP2_USE_AVX512
 	const __m512i chunk = _mm512_loadu_si512(indentLineCount);
 	const __m512i maxAll = _mm512_set1_epi32(_mm512_reduce_max_epu32(chunk));
 	const uint32_t mask = _mm512_cmpeq_epu32_mask(chunk, maxAll);
-	prevTabWidth = np2_ctz(mask);
+	tabWidth = np2_ctz(mask);
 #elif NP2_USE_AVX2
 	const __m256i chunk1 = _mm256_loadu_si256(reinterpret_cast<__m256i *>(indentLineCount));
 	const __m256i chunk2 = _mm256_loadu_si256(reinterpret_cast<__m256i *>(indentLineCount + 8));
@@ -977,140 +1255,294 @@ labelStart:
 	const __m256i chunk = _mm256_broadcastd_epi32(maxAll);
 	uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, chunk1)));
 	mask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(chunk, chunk2)))) << 8;
-	prevTabWidth = np2_ctz(mask);
+	tabWidth = np2_ctz(mask);
 
 #else
-	prevTabWidth = 0;
+	tabWidth = 0;
 	for (int i = 1; i < MAX_DETECTED_TAB_WIDTH + 2; i++) {
-		if (indentLineCount[i] > indentLineCount[prevTabWidth]) {
-			prevTabWidth = i;
+		if (indentLineCount[i] > indentLineCount[tabWidth]) {
+			tabWidth = i;
 		}
 	}
 #endif
-	if (prevTabWidth != 0) {
-		const bool bTabsAsSpaces = prevTabWidth <= MAX_DETECTED_TAB_WIDTH;
-		fv.mask |= FV_TABSASSPACES;
-		fv.bTabsAsSpaces = bTabsAsSpaces;
-		if (bTabsAsSpaces) {
-			fv.mask |= FV_MaskHasTabIndentWidth;
-			fv.iTabWidth = prevTabWidth;
-			fv.iIndentWidth = prevTabWidth;
-		}
-	}
 
 #if 0
-	watch.Stop();
-	const double duration = watch.Get();
-	printf("indentation %u, duration=%.06f, tab width=%d\n", (UINT)cbData, duration, prevTabWidth);
+	printf("indentation %u, tab width=%d\n", (UINT)cbData, tabWidth);
 	for (int i = 0; i < MAX_DETECTED_TAB_WIDTH + 2; i++) {
 		printf("\tindentLineCount[%d] = %u\n", i, indentLineCount[i]);
 	}
 #endif
+	return tabWidth;
+}
+
+// detectedTabWidth is reused when it's not negative, e.g. from file snapshot.
+static void EditDetectIndentation(LPCSTR lpData, DWORD cbData, EditFileVars &fv, int &detectedTabWidth) noexcept {
+	if ((fv.mask & FV_MaskHasFileTabSettings) == FV_MaskHasFileTabSettings) {
+		return;
+	}
+	if (!tabSettings.bDetectIndentation) {
+		return;
+	}
+
+#if 0
+	StopWatch watch;
+	watch.Start();
+#endif
+	if (detectedTabWidth < 0) {
+		detectedTabWidth = EditDetectTabWidth(lpData, cbData);
+	}
+#if 0
+	watch.Stop();
+	const double duration = watch.Get();
+	printf("indentation %u, duration=%.06f, tab width=%d\n", (UINT)cbData, duration, detectedTabWidth);
+#endif
+
+	const int tabWidth = detectedTabWidth;
+	if (tabWidth != 0) {
+		const bool bTabsAsSpaces = tabWidth <= MAX_DETECTED_TAB_WIDTH;
+		fv.mask |= FV_TABSASSPACES;
+		fv.bTabsAsSpaces = bTabsAsSpaces;
+		if (bTabsAsSpaces) {
+			fv.mask |= FV_MaskHasTabIndentWidth;
+			fv.iTabWidth = tabWidth;
+			fv.iIndentWidth = tabWidth;
+		}
+	}
 }
 
 //=============================================================================
 //
 // EditLoadFile()
 //
-bool EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept {
-	HANDLE hFile = CreateFile(pszFile,
-					   GENERIC_READ,
-					   FILE_SHARE_READ | FILE_SHARE_WRITE,
-					   nullptr, OPEN_EXISTING,
-					   FILE_ATTRIBUTE_NORMAL,
-					   nullptr);
-	dwLastIOError = GetLastError();
+#if defined(_WIN64)
+// file larger than this is loaded through a copy-on-write file mapping instead of reading into heap buffer.
+#define MIN_MAPPED_FILE_SIZE	(64U << 20)
+#endif
 
-	if (hFile == INVALID_HANDLE_VALUE) {
-		return false;
+// identity of current file on disk and length of document prefix unchanged since
+// it was loaded or saved, used to only rewrite the changed tail of append-mostly file.
+#define INCREMENTAL_SAVE_VERIFY_SIZE	(64U << 10)
+
+static struct SavedFileInformation {
+	bool valid;
+	int iEncoding;
+	Sci_Position iUnchanged;
+	ULONGLONG fileSize;
+	FILETIME ftLastWriteTime;
+	FILE_ID_INFO fileId;
+} savedCurFile;
+
+static inline bool IsByteIdenticalEncoding(UINT uFlags) noexcept {
+	return (uFlags & (NCP_UTF8 | NCP_DEFAULT)) != 0;
+}
+
+void EditSavedFileNotify(Sci_Position position) noexcept {
+	if (position < savedCurFile.iUnchanged) {
+		savedCurFile.iUnchanged = position;
 	}
+}
+
+// file larger than this or on network share is loaded on a background thread.
+#define MIN_BACKGROUND_LOAD_SIZE	(4U << 20)
+#define LOAD_FILE_CHUNK_SIZE		(4U << 20)
 
+struct EditFileLoader {
+	BackgroundWorker worker;
+	LPCWSTR pszFile;
+	EditFileIOStatus *status;
+	HANDLE hFile;
 	LARGE_INTEGER fileSize;
-	fileSize.QuadPart = 0;
-	if (!GetFileSizeEx(hFile, &fileSize)) {
-		dwLastIOError = GetLastError();
-		CloseHandle(hFile);
-		return false;
+	bool bMappedLoad;
+	bool bHeadOnly;
+	bool bHexDump;
+	bool success;
+	ULONGLONG totalPhys;
+	volatile LONG progress;
+	// output
+	char *lpData;
+	char *lpDataUTF8;
+	char *lpMappedView;
+	DWORD cbData;
+	UINT uFlags;
+};
+
+static inline void EditFreeFileData(char *lpData, const char *lpMappedView) noexcept {
+	if (lpData != nullptr && lpData == lpMappedView) {
+		UnmapViewOfFile(lpData);
+	} else {
+		NP2HeapFree(lpData);
 	}
+}
 
-	// display real path name
-	PathGetRealPath(hFile, pszFile, pszFile);
+// hex dump of binary file like `hexdump -C`: offset, 16 hex bytes and ASCII columns.
+// line number maps to offset, and byte sequence can be searched as hex text.
+#define HEX_DUMP_BYTES_PER_LINE		16
+#define HEX_DUMP_ASCII_COLUMN		(8 + 2 + HEX_DUMP_BYTES_PER_LINE*3 + 1 + 1)
+#define HEX_DUMP_LINE_LENGTH		(HEX_DUMP_ASCII_COLUMN + 1 + HEX_DUMP_BYTES_PER_LINE + 2)
+// limit dump size to DWORD
+#define MAX_HEX_DUMP_DATA_SIZE		((UINT_MAX / HEX_DUMP_LINE_LENGTH) * HEX_DUMP_BYTES_PER_LINE - HEX_DUMP_BYTES_PER_LINE)
 
-	// Check if a warning message should be displayed for large files
-#if defined(_WIN64)
-	// less than 1/2 available physical memory:
-	//     1. Buffers we allocated below or when saving file, depends on encoding.
-	//     2. Scintilla's content buffer and style buffer, see CellBuffer class.
-	//        The style buffer is disabled when using SCLEX_NULL (Text File, 2nd Text File, ANSI Art).
-	//        i.e. when default scheme is Text File or 2nd Text File, memory required to load the file
-	//        is about fileSize*2, buffers we allocated below can be reused by system to served
-	//        as Scintilla's style buffer when calling SciCall_SetLexer() inside Style_SetLexer().
-	//     3. Extra memory when moving gaps on editing, it may require more than 2/3 physical memory.
-	// large file TODO: https://github.com/zufuliu/notepad4/issues/125
-	// [ ] [> 4 GiB] use SetFilePointerEx() and ReadFile()/WriteFile() to read/write file.
-	// [-] [> 1 GiB] fix encoding conversion with MultiByteToWideChar() and WideCharToMultiByte().
-	LONGLONG maxFileSize = INT64_C(4) << 30;
-#else
-	// 2 GiB: ptrdiff_t / Sci_Position used in Scintilla
-	LONGLONG maxFileSize = INT64_C(2) << 30;
-#endif
-
-	MEMORYSTATUSEX statex;
-	statex.dwLength = sizeof(statex);
-	statex.ullTotalPhys = 0;
-	GlobalMemoryStatusEx(&statex);
-	const ULONGLONG maxMem = statex.ullTotalPhys/2U;
-	if (maxMem < static_cast<ULONGLONG>(maxFileSize)) {
-		maxFileSize = static_cast<LONGLONG>(maxMem);
+static char *EditHexDumpData(const char *lpData, DWORD cbData, DWORD *cbDump) noexcept {
+	const DWORD lineCount = (cbData + HEX_DUMP_BYTES_PER_LINE - 1) / HEX_DUMP_BYTES_PER_LINE;
+	char *lpDump = static_cast<char *>(NP2HeapAllocTag(static_cast<size_t>(lineCount)*HEX_DUMP_LINE_LENGTH + NP2_ENCODING_DETECTION_PADDING, HeapTag_ConversionBuffer));
+	if (lpDump == nullptr) {
+		return nullptr;
 	}
 
-	if (fileSize.QuadPart > maxFileSize) {
-		CloseHandle(hFile);
-		status.bFileTooBig = true;
-		WCHAR tchDocSize[32];
-		WCHAR tchMaxSize[32];
-		WCHAR tchDocBytes[32];
-		WCHAR tchMaxBytes[32];
-		StrFormatByteSize(fileSize.QuadPart, tchDocSize, COUNTOF(tchDocSize));
-		StrFormatByteSize(maxFileSize, tchMaxSize, COUNTOF(tchMaxSize));
-		FormatNumber64(tchDocBytes, fileSize.QuadPart);
-		FormatNumber64(tchMaxBytes, maxFileSize);
-		MsgBoxWarn(MB_OK, IDS_WARNLOADBIGFILE, pszFile, tchDocSize, tchDocBytes, tchMaxSize, tchMaxBytes);
-		return false;
-	}
+	constexpr char hexDigits[] = "0123456789ABCDEF";
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(lpData);
+	char *p = lpDump;
+	for (DWORD offset = 0; offset < cbData; offset += HEX_DUMP_BYTES_PER_LINE) {
+		const UINT count = min<DWORD>(cbData - offset, HEX_DUMP_BYTES_PER_LINE);
+		memset(p, ' ', HEX_DUMP_ASCII_COLUMN);
+		for (int shift = 28; shift >= 0; shift -= 4) {
+			*p++ = hexDigits[(offset >> shift) & 15];
+		}
+		p += 2;
+		char *ascii = p + HEX_DUMP_BYTES_PER_LINE*3 + 2;
+		*ascii++ = '|';
+		for (UINT i = 0; i < count; i++) {
+			const uint8_t ch = ptr[i];
+			p[0] = hexDigits[ch >> 4];
+			p[1] = hexDigits[ch & 15];
+			p += (i == HEX_DUMP_BYTES_PER_LINE/2 - 1) ? 4 : 3;
+			*ascii++ = (ch >= ' ' && ch < 0x7f) ? static_cast<char>(ch) : '.';
+		}
+		*ascii++ = '|';
+		*ascii++ = '\n';
+		p = ascii;
+		ptr += count;
+	}
+	*cbDump = static_cast<DWORD>(p - lpDump);
+	return lpDump;
+}
+
+// read, detect encoding, convert to UTF-8, detect line endings and indentation,
+// runs on a background thread for large or remote file.
+static bool EditReadFileData(EditFileLoader &loader) noexcept {
+	LPCWSTR pszFile = loader.pszFile;
+	HANDLE hFile = loader.hFile;
+	const LARGE_INTEGER fileSize = loader.fileSize;
+	EditFileIOStatus &status = *loader.status;
 
-	char *lpData = static_cast<char *>(NP2HeapAlloc(static_cast<size_t>(fileSize.QuadPart) + NP2_ENCODING_DETECTION_PADDING*2));
-	char *lpDataUTF8 = reinterpret_cast<char *>(NP2_align_up(reinterpret_cast<uintptr_t>(lpData), NP2_ENCODING_DETECTION_PADDING));
+	char *lpData = nullptr;
+	char *lpDataUTF8 = nullptr;
+	char *lpMappedView = nullptr;
 	DWORD cbData = 0;
-	const BOOL bReadSuccess = ReadFile(hFile, lpDataUTF8, static_cast<DWORD>(fileSize.QuadPart), &cbData, nullptr);
-	dwLastIOError = GetLastError();
-	CloseHandle(hFile);
+	if (loader.bMappedLoad) {
+		// copy-on-write view, encoding detection and byte swapping may modify the buffer.
+		// only map the head of too large file, the rest of the file is always longer than the padding.
+		HANDLE hMapping = CreateFileMapping(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (hMapping != nullptr) {
+			const SIZE_T cbView = loader.bHeadOnly ? static_cast<SIZE_T>(fileSize.QuadPart) + NP2_ENCODING_DETECTION_PADDING : 0;
+			lpMappedView = static_cast<char *>(MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, cbView));
+			CloseHandle(hMapping);
+		}
+		dwLastIOError = GetLastError();
+		// fallback to ReadFile() only when the file is small enough for the heap buffer
+		if (lpMappedView == nullptr && static_cast<ULONGLONG>(fileSize.QuadPart) > loader.totalPhys/2U) {
+			CloseHandle(hFile);
+			return false;
+		}
+	}
 
-	if (!bReadSuccess) {
-		NP2HeapFree(lpData);
-		return false;
+	if (lpMappedView != nullptr) {
+		CloseHandle(hFile);
+		lpData = lpMappedView;
+		lpDataUTF8 = lpMappedView;
+		cbData = static_cast<DWORD>(fileSize.QuadPart);
+	} else {
+		lpData = static_cast<char *>(NP2HeapAllocTag(static_cast<size_t>(fileSize.QuadPart) + NP2_ENCODING_DETECTION_PADDING*2, HeapTag_LoadBuffer));
+		lpDataUTF8 = reinterpret_cast<char *>(NP2_align_up(reinterpret_cast<uintptr_t>(lpData), NP2_ENCODING_DETECTION_PADDING));
+		// read in chunks to report progress and check for cancellation
+		const DWORD size = static_cast<DWORD>(fileSize.QuadPart);
+		BOOL bReadSuccess = TRUE;
+		while (cbData < size) {
+			DWORD cbRead = 0;
+			bReadSuccess = ReadFile(hFile, lpDataUTF8 + cbData, min<DWORD>(size - cbData, LOAD_FILE_CHUNK_SIZE), &cbRead, nullptr);
+			dwLastIOError = GetLastError();
+			if (!bReadSuccess || cbRead == 0) {
+				break;
+			}
+			cbData += cbRead;
+			loader.progress = static_cast<LONG>((static_cast<uint64_t>(cbData) * 100U) / size);
+			if (!loader.worker.Continue()) {
+				bReadSuccess = FALSE;
+				dwLastIOError = ERROR_CANCELLED;
+				break;
+			}
+		}
+		CloseHandle(hFile);
+
+		if (!bReadSuccess) {
+			NP2HeapFree(lpData);
+			return false;
+		}
 	}
 
+	status.fileSize = cbData;
 	status.iEOLMode = GetScintillaEOLMode(iDefaultEOLMode);
 	status.bInconsistent = false;
 	status.totalLineCount = 1;
+	status.iDetectedTabWidth = -1;
 
+	const EditFileSnapshot *snapshot = status.snapshot;
+	if (bHexDumpBinaryFile && snapshot != nullptr && (snapshot->encodingFlag & EncodingFlag_Binary)) {
+		// line endings and indentation of the dump does not match the snapshot
+		snapshot = nullptr;
+		status.snapshot = nullptr;
+	}
 	int encodingFlag = EncodingFlag_None;
-	int iEncoding = EditDetermineEncoding(pszFile, lpDataUTF8, cbData, &encodingFlag);
-	if (iEncoding == CPI_DEFAULT && encodingFlag == EncodingFlag_UTF7) {
-		iEncoding = Encoding_GetAnsiIndex();
+	int iEncoding;
+	if (snapshot != nullptr) {
+		// unchanged file, reuse previous detection result
+		encodingFlag = snapshot->encodingFlag;
+		iEncoding = snapshot->iEncoding;
+		if (!(mEncoding[iEncoding].uFlags & NCP_UNICODE)) {
+			fvCurFile.Init(lpDataUTF8, cbData);
+		}
+	} else {
+		EventTraceActivity activity;
+		EventTraceStart(activity, "DetermineEncoding", TraceLoggingUInt32(cbData, "Bytes"));
+		iEncoding = EditDetermineEncoding(pszFile, lpDataUTF8, cbData, &encodingFlag);
+		EventTraceStop(activity, "DetermineEncoding", TraceLoggingInt32(iEncoding, "Encoding"), TraceLoggingInt32(encodingFlag, "Flag"));
+		if (iEncoding == CPI_DEFAULT && encodingFlag == EncodingFlag_UTF7) {
+			iEncoding = Encoding_GetAnsiIndex();
+		}
 	}
 	status.iEncoding = iEncoding;
+	status.encodingFlag = encodingFlag;
 	status.bBinaryFile = encodingFlag & EncodingFlag_Binary;
 	UINT uFlags = mEncoding[iEncoding].uFlags;
 
 	if (cbData == 0) {
-		SciCall_SetCodePage((uFlags & NCP_DEFAULT) ? iDefaultCodePage : SC_CP_UTF8);
-		EditSetEmptyText();
-		SciCall_SetEOLMode(status.iEOLMode);
-		NP2HeapFree(lpData);
+		loader.lpData = lpData;
+		loader.lpMappedView = lpMappedView;
+		loader.uFlags = uFlags;
 		return true;
 	}
+	if (!loader.worker.Continue()) {
+		EditFreeFileData(lpData, lpMappedView);
+		dwLastIOError = ERROR_CANCELLED;
+		return false;
+	}
+
+	// binary file is shown as hex dump, encoding conversion is not needed
+	if (status.bBinaryFile && bHexDumpBinaryFile && cbData <= MAX_HEX_DUMP_DATA_SIZE) {
+		DWORD cbDump = 0;
+		char *lpDump = EditHexDumpData(lpDataUTF8, cbData, &cbDump);
+		if (lpDump != nullptr) {
+			EditFreeFileData(lpData, lpMappedView);
+			lpData = lpDump;
+			lpDataUTF8 = lpDump;
+			cbData = cbDump;
+			iEncoding = CPI_UTF8;
+			status.iEncoding = iEncoding;
+			uFlags = mEncoding[iEncoding].uFlags;
+			fvCurFile.Init(lpData, cbData);
+			loader.bHexDump = true;
+		}
+	}
 
 	DWORD offset = 0; // include BOM to make lpDataUTF8 aligned
 	if (uFlags & NCP_UTF8) {
@@ -1121,36 +1553,46 @@ bool EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept {
 		}
 	} else if (uFlags & NCP_UNICODE) {
 		LPCWSTR pszTextW = (uFlags & NCP_UNICODE_BOM) ? (reinterpret_cast<LPWSTR>(lpDataUTF8) + 1) : reinterpret_cast<LPWSTR>(lpDataUTF8);
-		// NOTE: requires two extra trailing NULL bytes.
-		const DWORD cchTextW = (uFlags & NCP_UNICODE_BOM) ? (cbData / sizeof(WCHAR)) : ((cbData / sizeof(WCHAR)) + 1);
-		if ((uFlags & NCP_UNICODE_REVERSE) != 0 && encodingFlag != EncodingFlag_Reversed) {
-			_swab(lpDataUTF8, lpDataUTF8, cbData);
-		}
-		// cbData/2 => WCHAR, WCHAR*3 => UTF-8
-		const DWORD size = (cbData + 1)*sizeof(WCHAR);
-		lpDataUTF8 = static_cast<char *>(NP2HeapAlloc(size));
-		cbData = WideCharToMultiByte(CP_UTF8, 0, pszTextW, cchTextW, lpDataUTF8, size, nullptr, nullptr);
-		if (cbData == 0) {
-			const UINT legacyACP = mEncoding[CPI_DEFAULT].uCodePage;
-			cbData = WideCharToMultiByte(legacyACP, 0, pszTextW, -1, lpDataUTF8, size, nullptr, nullptr);
-			status.bUnicodeErr = true;
-		}
-		if (cbData != 0) {
-			// remove the NULL terminator.
-			cbData -= 1;
+		const bool reverse = (uFlags & NCP_UNICODE_REVERSE) != 0 && encodingFlag != EncodingFlag_Reversed;
+		const size_t cchText = (cbData / sizeof(WCHAR)) - ((uFlags & NCP_UNICODE_BOM) != 0);
+		// exact UTF-8 length, SIZE_MAX for unpaired surrogate
+		const size_t length = UTF8LengthFromUTF16(pszTextW, cchText, reverse);
+		if (length < UINT_MAX - NP2_ENCODING_DETECTION_PADDING) {
+			// convert with inline byte swapping, source buffer is not modified
+			lpDataUTF8 = static_cast<char *>(NP2HeapAllocTag(length + NP2_ENCODING_DETECTION_PADDING, HeapTag_ConversionBuffer));
+			cbData = static_cast<DWORD>(UTF16ToUTF8(pszTextW, cchText, reverse, lpDataUTF8));
+		} else {
+			// NOTE: requires two extra trailing NULL bytes.
+			const DWORD cchTextW = static_cast<DWORD>(cchText) + 1;
+			if (reverse) {
+				_swab(lpDataUTF8, lpDataUTF8, cbData);
+			}
+			// cbData/2 => WCHAR, WCHAR*3 => UTF-8
+			const DWORD size = (cbData + 1)*sizeof(WCHAR);
+			lpDataUTF8 = static_cast<char *>(NP2HeapAllocTag(size, HeapTag_ConversionBuffer));
+			cbData = WideCharToMultiByte(CP_UTF8, 0, pszTextW, cchTextW, lpDataUTF8, size, nullptr, nullptr);
+			if (cbData == 0) {
+				const UINT legacyACP = mEncoding[CPI_DEFAULT].uCodePage;
+				cbData = WideCharToMultiByte(legacyACP, 0, pszTextW, -1, lpDataUTF8, size, nullptr, nullptr);
+				status.bUnicodeErr = true;
+			}
+			if (cbData != 0) {
+				// remove the NULL terminator.
+				cbData -= 1;
+			}
 		}
 
-		NP2HeapFree(lpData);
+		EditFreeFileData(lpData, lpMappedView);
 		lpData = lpDataUTF8;
 		fvCurFile.Init(lpData, cbData);
 	} else if (uFlags & (NCP_8BIT | NCP_7BIT)) {
 		if (encodingFlag != EncodingFlag_UTF7 || (uFlags & NCP_7BIT) != 0) {
 			const UINT uCodePage = mEncoding[iEncoding].uCodePage;
 			lpDataUTF8 = RecodeAsUTF8(lpDataUTF8, &cbData, uCodePage, 0);
-			NP2HeapFree(lpData);
+			EditFreeFileData(lpData, lpMappedView);
 			lpData = lpDataUTF8;
 		}
-	} else if (cbData < MAX_NON_UTF8_SIZE && (encodingFlag & (EncodingFlag_Binary | EncodingFlag_Invalid)) == 0
+	} else if (snapshot == nullptr && cbData < MAX_NON_UTF8_SIZE && (encodingFlag & (EncodingFlag_Binary | EncodingFlag_Invalid)) == 0
 		&& ((bLoadANSIasUTF8 && !(iSrcEncoding == CPI_DEFAULT || iWeakSrcEncoding == CPI_DEFAULT))
 		|| (GetACP() == CP_UTF8))) {
 		// try to load ANSI / unknown encoding as UTF-8
@@ -1158,7 +1600,7 @@ bool EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept {
 		const UINT legacyACP = mEncoding[CPI_DEFAULT].uCodePage;
 		char * const result = RecodeAsUTF8(lpDataUTF8, &back, legacyACP, MB_ERR_INVALID_CHARS);
 		if (result) {
-			NP2HeapFree(lpData);
+			EditFreeFileData(lpData, lpMappedView);
 			lpDataUTF8 = result;
 			lpData = result;
 			cbData = back;
@@ -1167,26 +1609,434 @@ bool EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept {
 		}
 	}
 
+	if (!loader.worker.Continue()) {
+		EditFreeFileData(lpData, lpMappedView);
+		dwLastIOError = ERROR_CANCELLED;
+		return false;
+	}
+
 	if (cbData) {
 		// StopWatch watch;
 		// watch.Start();
-		EditDetectEOLMode(lpDataUTF8 - offset, cbData + offset, status);
+		if (snapshot != nullptr) {
+			status.iEOLMode = snapshot->iEOLMode;
+			status.bInconsistent = snapshot->bInconsistent;
+			status.totalLineCount = snapshot->totalLineCount;
+			memcpy(status.linesCount, snapshot->linesCount, sizeof(status.linesCount));
+			status.iDetectedTabWidth = snapshot->iDetectedTabWidth;
+		} else {
+			EditDetectEOLMode(lpDataUTF8 - offset, cbData + offset, status);
+		}
 		// watch.Stop();
 		// watch.ShowLog("EOL time");
 		// printf("CR+LF: %zu, LF: %zu, CR: %zu\n", status.linesCount[SC_EOL_CRLF], status.linesCount[SC_EOL_LF], status.linesCount[SC_EOL_CR]);
-		EditDetectIndentation(lpDataUTF8, cbData, fvCurFile);
+		EditDetectIndentation(lpDataUTF8, cbData, fvCurFile, status.iDetectedTabWidth);
 	}
+	loader.lpData = lpData;
+	loader.lpDataUTF8 = lpDataUTF8;
+	loader.lpMappedView = lpMappedView;
+	loader.cbData = cbData;
+	loader.uFlags = uFlags;
+	return true;
+}
+
+static DWORD WINAPI EditReadFileThread(LPVOID lpParam) noexcept {
+	EditFileLoader *loader = static_cast<EditFileLoader *>(lpParam);
+	loader->success = EditReadFileData(*loader);
+	return 0;
+}
+
+// wait for background loading, keep window painted, input is discarded and Esc cancels loading.
+static bool EditReadFileBackground(EditFileLoader &loader) noexcept {
+	HANDLE hThread = CreateThread(nullptr, 0, EditReadFileThread, &loader, 0, nullptr);
+	if (hThread == nullptr) {
+		return EditReadFileData(loader);
+	}
+
+	loader.worker.workerThread = hThread;
+	WCHAR tchFormat[128];
+	WCHAR tchStatus[128];
+	GetString(IDS_LOADFILE_PROGRESS, tchFormat, COUNTOF(tchFormat));
+	LONG progress = -1;
+	bool quit = false;
+	WPARAM exitCode = 0;
+	while (MsgWaitForMultipleObjects(1, &hThread, FALSE, 100, QS_ALLINPUT) != WAIT_OBJECT_0) {
+		MSG msg;
+		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+			const UINT message = msg.message;
+			if (message == WM_QUIT) {
+				quit = true;
+				exitCode = msg.wParam;
+			} else if (message >= WM_KEYFIRST && message <= WM_KEYLAST) {
+				if (message == WM_KEYDOWN && msg.wParam == VK_ESCAPE) {
+					SetEvent(loader.worker.eventCancel);
+				}
+			} else if (!((message >= WM_MOUSEFIRST && message <= WM_MOUSELAST)
+				|| (message >= WM_NCMOUSEMOVE && message <= WM_NCXBUTTONDBLCLK)
+				|| message == WM_TIMER || message == WM_COMMAND)) {
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+		}
+		if (progress != loader.progress) {
+			progress = loader.progress;
+			wsprintf(tchStatus, tchFormat, static_cast<UINT>(progress));
+			StatusSetText(hwndStatus, STATUS_HELP, tchStatus);
+			UpdateWindow(hwndStatus);
+		}
+	}
+	if (quit) {
+		PostQuitMessage(static_cast<int>(exitCode));
+	}
+	return loader.success;
+}
+
+bool EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept {
+	HANDLE hFile = CreateFile(pszFile,
+					   GENERIC_READ,
+					   FILE_SHARE_READ | FILE_SHARE_WRITE,
+					   nullptr, OPEN_EXISTING,
+					   FILE_ATTRIBUTE_NORMAL,
+					   nullptr);
+	dwLastIOError = GetLastError();
+
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = 0;
+	if (!GetFileSizeEx(hFile, &fileSize)) {
+		dwLastIOError = GetLastError();
+		CloseHandle(hFile);
+		return false;
+	}
+
+	// display real path name
+	PathGetRealPath(hFile, pszFile, pszFile);
+	PathGetFileId(hFile, &status.fileId);
+	GetFileTime(hFile, nullptr, nullptr, &status.ftLastWriteTime);
+	if (status.snapshot != nullptr) {
+		const EditFileSnapshot &snapshot = *status.snapshot;
+		if (snapshot.fileSize != static_cast<ULONGLONG>(fileSize.QuadPart)
+			|| CompareFileTime(&snapshot.ftLastWriteTime, &status.ftLastWriteTime) != 0
+			|| memcmp(&snapshot.fileId, &status.fileId, sizeof(FILE_ID_INFO)) != 0
+			|| !PathEqual(snapshot.szFile, pszFile)) {
+			status.snapshot = nullptr;
+		}
+	}
+
+	// Check if a warning message should be displayed for large files
+#if defined(_WIN64)
+	// less than 1/2 available physical memory:
+	//     1. Buffers we allocated below or when saving file, depends on encoding.
+	//     2. Scintilla's content buffer and style buffer, see CellBuffer class.
+	//        The style buffer is disabled when using SCLEX_NULL (Text File, 2nd Text File, ANSI Art).
+	//        i.e. when default scheme is Text File or 2nd Text File, memory required to load the file
+	//        is about fileSize*2, buffers we allocated below can be reused by system to served
+	//        as Scintilla's style buffer when calling SciCall_SetLexer() inside Style_SetLexer().
+	//        In large file mode styles are kept as runs until the lexer produces too many short runs.
+	//     3. Extra memory when moving gaps on editing, it may require more than 2/3 physical memory.
+	//     When the file is loaded through a file mapping, buffer in 1 is backed by the file cache
+	//     (except pages modified by byte swapping) and not counted, the limit is raised to 3/4.
+	// large file TODO: https://github.com/zufuliu/notepad4/issues/125
+	// [-] [> 4 GiB] use file mapping to read file, UTF-8 and UTF-16 text is written in chunks.
+	// [x] [> 1 GiB] fix encoding conversion with MultiByteToWideChar() and WideCharToMultiByte(),
+	//     DBCS and single byte code pages are converted in chunks by RecodeAsUTF8().
+	LONGLONG maxFileSize = INT64_C(4) << 30;
+	bool bMappedLoad = false;
+	if (fileSize.QuadPart >= MIN_MAPPED_FILE_SIZE) {
+		// encoding detection may read NP2_ENCODING_DETECTION_PADDING bytes beyond cbData,
+		// it's safe when these bytes are inside the zero filled remainder of the last page.
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		const DWORD tail = static_cast<DWORD>(fileSize.QuadPart & (info.dwPageSize - 1));
+		bMappedLoad = tail != 0 && tail <= info.dwPageSize - NP2_ENCODING_DETECTION_PADDING;
+	}
+#else
+	// 2 GiB: ptrdiff_t / Sci_Position used in Scintilla
+	LONGLONG maxFileSize = INT64_C(2) << 30;
+	constexpr bool bMappedLoad = false;
+#endif
+
+	MEMORYSTATUSEX statex;
+	statex.dwLength = sizeof(statex);
+	statex.ullTotalPhys = 0;
+	GlobalMemoryStatusEx(&statex);
+	const ULONGLONG maxMem = bMappedLoad ? (statex.ullTotalPhys/4U)*3U : statex.ullTotalPhys/2U;
+	if (maxMem < static_cast<ULONGLONG>(maxFileSize)) {
+		maxFileSize = static_cast<LONGLONG>(maxMem);
+	}
+
+	// too large file can be viewed partially: load the head in read only mode.
+	bool bHeadOnly = false;
+	if (fileSize.QuadPart > maxFileSize) {
+		WCHAR tchDocSize[32];
+		WCHAR tchMaxSize[32];
+		WCHAR tchDocBytes[32];
+		WCHAR tchMaxBytes[32];
+		StrFormatByteSize(fileSize.QuadPart, tchDocSize, COUNTOF(tchDocSize));
+		StrFormatByteSize(maxFileSize, tchMaxSize, COUNTOF(tchMaxSize));
+		FormatNumber64(tchDocBytes, fileSize.QuadPart);
+		FormatNumber64(tchMaxBytes, maxFileSize);
+		if (IDYES != MsgBoxWarn(MB_YESNO, IDS_ASK_LOADBIGFILE, pszFile, tchDocSize, tchDocBytes, tchMaxSize, tchMaxBytes)) {
+			CloseHandle(hFile);
+			status.bFileTooBig = true;
+			return false;
+		}
+		// keep even size for UTF-16 and page aligned view for mapped load
+		bHeadOnly = true;
+		fileSize.QuadPart = maxFileSize & ~static_cast<LONGLONG>(0xffff);
+	}
+
+	EventTraceActivity activity;
+	EventTraceStart(activity, "LoadFile", TraceLoggingInt64(fileSize.QuadPart, "Bytes"), TraceLoggingBool(bMappedLoad, "Mapped"));
+	EditFileLoader loader {};
+	loader.worker.Init(hwndMain);
+	loader.pszFile = pszFile;
+	loader.status = &status;
+	loader.hFile = hFile;
+	loader.fileSize = fileSize;
+	loader.bMappedLoad = bMappedLoad;
+	loader.bHeadOnly = bHeadOnly;
+	loader.totalPhys = statex.ullTotalPhys;
+	const bool background = fileSize.QuadPart >= MIN_BACKGROUND_LOAD_SIZE || PathIsUNC(pszFile);
+	EventTraceActivity stage;
+	EventTraceStart(stage, "ReadFile", TraceLoggingBool(background, "Background"));
+	const bool success = background ? EditReadFileBackground(loader) : EditReadFileData(loader);
+	EventTraceStop(stage, "ReadFile", TraceLoggingBool(success, "Success"), TraceLoggingUInt32(loader.cbData, "Bytes"));
+	loader.worker.Destroy();
+	if (!success) {
+		return false;
+	}
+
+	const UINT uFlags = loader.uFlags;
 	SciCall_SetCodePage((uFlags & NCP_DEFAULT) ? iDefaultCodePage : SC_CP_UTF8);
-	EditSetNewText(lpDataUTF8, cbData, status.totalLineCount);
+	if (loader.cbData == 0) {
+		EditSetEmptyText();
+		SciCall_SetEOLMode(status.iEOLMode);
+	} else {
+		EventTraceActivity setText;
+		EventTraceStart(setText, "SetText", TraceLoggingUInt32(loader.cbData, "Bytes"), TraceLoggingUInt64(status.totalLineCount, "Lines"));
+		status.bLoadCanceled = !EditSetNewText(loader.lpDataUTF8, loader.cbData, status.totalLineCount);
+		EventTraceStop(setText, "SetText", TraceLoggingBool(status.bLoadCanceled, "Canceled"));
+	}
+	status.bLoadCanceled |= bHeadOnly || loader.bHexDump;
+
+	EditFreeFileData(loader.lpData, loader.lpMappedView);
+	// partially loaded or hex dumped file is opened in read only mode
+	savedCurFile.valid = !status.bLoadCanceled && IsByteIdenticalEncoding(mEncoding[status.iEncoding].uFlags);
+	savedCurFile.iEncoding = status.iEncoding;
+	savedCurFile.iUnchanged = SciCall_GetLength();
+	savedCurFile.fileSize = status.fileSize;
+	savedCurFile.ftLastWriteTime = status.ftLastWriteTime;
+	memcpy(&savedCurFile.fileId, &status.fileId, sizeof(FILE_ID_INFO));
+	EventTraceStop(activity, "LoadFile", TraceLoggingInt32(status.iEncoding, "Encoding"), TraceLoggingUInt64(status.totalLineCount, "Lines"));
+	HeapStatistics_Trace("LoadFile");
+	return true;
+}
 
-	NP2HeapFree(lpData);
+// snapshot file is named by hash of lower case path in a subfolder of AutoSave folder.
+static void EditGetFileSnapshotPath(LPCWSTR pszFile, LPWSTR pszPath) noexcept {
+	WCHAR szLower[MAX_PATH];
+	lstrcpyn(szLower, pszFile, COUNTOF(szLower));
+	CharLower(szLower);
+	// FNV-1a
+	uint64_t hash = UINT64_C(14695981039346656037);
+	for (LPCWSTR p = szLower; *p; p++) {
+		hash = (hash ^ *p) * UINT64_C(1099511628211);
+	}
+
+	PathCombine(pszPath, AutoSave_GetDefaultFolder(), L"Snapshot");
+	if (!PathIsDirectory(pszPath)) {
+		SHCreateDirectoryEx(nullptr, pszPath, nullptr);
+	}
+	WCHAR szName[32];
+	wsprintf(szName, L"%08X%08X.snapshot", static_cast<UINT>(hash >> 32), static_cast<UINT>(hash));
+	PathAppend(pszPath, szName);
+}
+
+//=============================================================================
+//
+// EditReadFileSnapshot()
+//
+bool EditReadFileSnapshot(LPCWSTR pszFile, EditFileSnapshot &snapshot) noexcept {
+	WCHAR szPath[MAX_PATH];
+	EditGetFileSnapshotPath(pszFile, szPath);
+	HANDLE hFile = CreateFile(szPath,
+					   GENERIC_READ,
+					   FILE_SHARE_READ | FILE_SHARE_DELETE,
+					   nullptr, OPEN_EXISTING,
+					   FILE_ATTRIBUTE_NORMAL,
+					   nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	DWORD cbRead = 0;
+	const BOOL bReadSuccess = ReadFile(hFile, &snapshot, sizeof(EditFileSnapshot), &cbRead, nullptr);
+	CloseHandle(hFile);
+	// also rejects snapshot written by build with different layout
+	return bReadSuccess && cbRead == sizeof(EditFileSnapshot)
+		&& snapshot.magic == EDIT_SNAPSHOT_MAGIC
+		&& snapshot.version == EDIT_SNAPSHOT_VERSION
+		&& Encoding_IsValid(snapshot.iEncoding)
+		&& mEncoding[snapshot.iEncoding].uCodePage == snapshot.uCodePage
+		&& static_cast<UINT>(snapshot.iEOLMode) <= SC_EOL_LF
+		&& snapshot.totalLineCount != 0
+		&& snapshot.szFile[MAX_PATH - 1] == L'\0'
+		&& PathEqual(snapshot.szFile, pszFile);
+}
+
+//=============================================================================
+//
+// EditWriteFileSnapshot()
+//
+bool EditWriteFileSnapshot(const EditFileSnapshot &snapshot) noexcept {
+	WCHAR szPath[MAX_PATH];
+	EditGetFileSnapshotPath(snapshot.szFile, szPath);
+	HANDLE hFile = CreateFile(szPath,
+					   GENERIC_WRITE,
+					   FILE_SHARE_READ,
+					   nullptr, CREATE_ALWAYS,
+					   FILE_ATTRIBUTE_NORMAL,
+					   nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	DWORD cbWritten = 0;
+	const BOOL bWriteSuccess = WriteFile(hFile, &snapshot, sizeof(EditFileSnapshot), &cbWritten, nullptr);
+	CloseHandle(hFile);
+	if (!bWriteSuccess || cbWritten != sizeof(EditFileSnapshot)) {
+		DeleteFile(szPath);
+		return false;
+	}
 	return true;
 }
 
+// write document in chunks directly from Scintilla's buffer without copying whole text,
+// UTF-8 text is converted to UTF-16 chunk by chunk.
+#define SAVE_FILE_CHUNK_SIZE	(4U << 20)
+
+static BOOL EditWriteDocument(HANDLE hFile, UINT uFlags, Sci_Position start) noexcept {
+	// text before and after the gap, the gap is never moved
+	Sci_TextSegments segments = { { start, -1 }, nullptr, 0, nullptr, 0 };
+	const Sci_Position length = SciCall_GetRangeSegments(&segments);
+	const Sci_Position length1 = segments.length1;
+	const auto pointer = [&segments, length1](Sci_Position position) noexcept {
+		return (position < length1) ? segments.segment1 + position : segments.segment2 + (position - length1);
+	};
+	const bool unicode = (uFlags & NCP_UNICODE) != 0;
+	const bool reverse = (uFlags & NCP_UNICODE_REVERSE) != 0;
+	LPWSTR lpDataWide = unicode ? static_cast<LPWSTR>(NP2HeapAlloc((SAVE_FILE_CHUNK_SIZE + 16)*sizeof(WCHAR))) : nullptr;
+	BOOL bWriteSuccess = TRUE;
+	Sci_Position position = 0;
+	while (bWriteSuccess && position < length) {
+		Sci_Position end = min<Sci_Position>(position + SAVE_FILE_CHUNK_SIZE, length);
+		const char *ptr = pointer(position);
+		char splitChar[2*kMaxMultiByteCount + 2];
+		if (position < length1 && end > length1) {
+			end = length1;
+			if (unicode && length1 - position <= kMaxMultiByteCount) {
+				// copy the UTF-8 character split by the gap
+				memcpy(splitChar, ptr, length1 - position);
+				while (end < length && end - position < static_cast<Sci_Position>(sizeof(splitChar))
+					&& (static_cast<uint8_t>(*pointer(end)) & 0xc0) == 0x80) {
+					splitChar[end - position] = *pointer(end);
+					++end;
+				}
+				ptr = splitChar;
+			}
+		}
+		if (unicode && end < length && ptr != splitChar) {
+			// don't split UTF-8 character
+			Sci_Position back = end;
+			while (back > position && (static_cast<uint8_t>(*pointer(back)) & 0xc0) == 0x80) {
+				--back;
+			}
+			if (back > position) {
+				end = back;
+			}
+		}
+
+		const DWORD cbData = static_cast<DWORD>(end - position);
+		DWORD dwBytesWritten;
+		if (unicode) {
+			DWORD cchTextW;
+			if (IsUTF8(ptr, cbData)) {
+				cchTextW = static_cast<DWORD>(UTF8ToUTF16(ptr, cbData, reverse, lpDataWide));
+			} else {
+				cchTextW = MultiByteToWideChar(CP_UTF8, 0, ptr, cbData, lpDataWide, cbData);
+				if (reverse) {
+					_swab(reinterpret_cast<char *>(lpDataWide), reinterpret_cast<char *>(lpDataWide), cchTextW*sizeof(WCHAR));
+				}
+			}
+			bWriteSuccess = WriteFile(hFile, lpDataWide, cchTextW*sizeof(WCHAR), &dwBytesWritten, nullptr);
+		} else {
+			bWriteSuccess = WriteFile(hFile, ptr, cbData, &dwBytesWritten, nullptr);
+		}
+		position = end;
+	}
+	if (lpDataWide != nullptr) {
+		NP2HeapFree(lpDataWide);
+	}
+	return bWriteSuccess;
+}
+
 //=============================================================================
 //
 // EditSaveFile()
 //
+static void EditUpdateSavedFile(HANDLE hFile, int iEncoding) noexcept {
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = 0;
+	savedCurFile.valid = IsByteIdenticalEncoding(mEncoding[iEncoding].uFlags)
+		&& GetFileSizeEx(hFile, &fileSize)
+		&& GetFileTime(hFile, nullptr, nullptr, &savedCurFile.ftLastWriteTime)
+		&& PathGetFileId(hFile, &savedCurFile.fileId);
+	savedCurFile.iEncoding = iEncoding;
+	savedCurFile.iUnchanged = SciCall_GetLength();
+	savedCurFile.fileSize = fileSize.QuadPart;
+}
+
+// returns length of document prefix that is still same as file content after BOM.
+static Sci_Position EditGetUnchangedPrefix(HANDLE hFile, int iEncoding, DWORD bomLength) noexcept {
+	const Sci_Position position = min(savedCurFile.iUnchanged, SciCall_GetLength());
+	if (!savedCurFile.valid || savedCurFile.iEncoding != iEncoding || position <= 0) {
+		return 0;
+	}
+
+	LARGE_INTEGER fileSize;
+	FILETIME ftLastWriteTime;
+	FILE_ID_INFO fileId;
+	if (!GetFileSizeEx(hFile, &fileSize) || static_cast<ULONGLONG>(fileSize.QuadPart) != savedCurFile.fileSize
+		|| static_cast<ULONGLONG>(position) + bomLength > savedCurFile.fileSize
+		|| !GetFileTime(hFile, nullptr, nullptr, &ftLastWriteTime)
+		|| CompareFileTime(&ftLastWriteTime, &savedCurFile.ftLastWriteTime) != 0
+		|| !PathGetFileId(hFile, &fileId)
+		|| memcmp(&fileId, &savedCurFile.fileId, sizeof(FILE_ID_INFO)) != 0) {
+		return 0;
+	}
+
+	// compare end of the prefix, changed by other program without updating timestamp
+	const DWORD cbVerify = static_cast<DWORD>(min<Sci_Position>(position, INCREMENTAL_SAVE_VERIFY_SIZE));
+	char *lpData = static_cast<char *>(NP2HeapAlloc(cbVerify));
+	LARGE_INTEGER offset;
+	offset.QuadPart = bomLength + position - cbVerify;
+	DWORD cbRead = 0;
+	bool same = SetFilePointerEx(hFile, offset, nullptr, FILE_BEGIN)
+		&& ReadFile(hFile, lpData, cbVerify, &cbRead, nullptr) && cbRead == cbVerify;
+	if (same) {
+		Sci_TextSegments segments = { { position - cbVerify, position }, nullptr, 0, nullptr, 0 };
+		SciCall_GetRangeSegments(&segments);
+		same = memcmp(lpData, segments.segment1, segments.length1) == 0
+			&& (segments.length2 == 0 || memcmp(lpData + segments.length1, segments.segment2, segments.length2) == 0);
+	}
+	NP2HeapFree(lpData);
+	return same ? position : 0;
+}
+
 bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &status) noexcept {
 	HANDLE hFile = CreateFile(pszFile,
 					   GENERIC_READ | GENERIC_WRITE,
@@ -1224,14 +2074,21 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 	}
 
 	if (!(saveFlag & FileSaveFlag_EndSession) && !bReadOnlyMode) {
-		// ensure consistent line endings
-		if (bFixLineEndings) {
-			EditEnsureConsistentLineEndings();
-		}
+		if (bFixOnlyModifiedLines && (SciCall_GetChangeHistory() & SC_CHANGE_HISTORY_ENABLED)) {
+			// only lines changed since last save, cost is proportional to the edit
+			if (bFixLineEndings || bAutoStripBlanks) {
+				EditFixModifiedLines(bFixLineEndings, bAutoStripBlanks);
+			}
+		} else {
+			// ensure consistent line endings
+			if (bFixLineEndings) {
+				EditEnsureConsistentLineEndings();
+			}
 
-		// strip trailing blanks
-		if (bAutoStripBlanks) {
-			EditStripTrailingBlanks(hwnd, true);
+			// strip trailing blanks
+			if (bAutoStripBlanks) {
+				EditStripTrailingBlanks(hwnd, true);
+			}
 		}
 	}
 
@@ -1240,6 +2097,8 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 	char *lpData = nullptr;
 	const int iEncoding = status.iEncoding;
 	UINT uFlags = mEncoding[iEncoding].uFlags;
+	EventTraceActivity activity;
+	EventTraceStart(activity, "SaveFile", TraceLoggingUInt32(cbData, "Bytes"), TraceLoggingInt32(iEncoding, "Encoding"));
 
 	// get content and convert encoding
 	if (cbData != 0) {
@@ -1252,8 +2111,6 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 			}
 		}
 
-		lpData = static_cast<char *>(NP2HeapAlloc(cbData + 1));
-		SciCall_GetText(cbData, lpData);
 #if 0
 		// FIXME: move checks in front of disk file access
 		if ((uFlags & (NCP_UNICODE | NCP_UTF8_SIGN)) == 0) {
@@ -1271,30 +2128,22 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 		}
 #endif
 
-		if (uFlags & (NCP_UTF8 | NCP_DEFAULT)) {
-			// no encoding conversion for UTF-8 or ANSI
-		} else if (uFlags & NCP_UNICODE) {
-			DWORD cbDataWide = (cbData + 1)*sizeof(WCHAR);
-			LPWSTR lpDataWide = static_cast<LPWSTR>(NP2HeapAlloc(cbDataWide));
-			cbDataWide = MultiByteToWideChar(CP_UTF8, 0, lpData, cbData, lpDataWide, cbData);
-			NP2HeapFree(lpData);
-			lpData = reinterpret_cast<char *>(lpDataWide);
-			cbData = cbDataWide * sizeof(WCHAR);
-
-			if (uFlags & NCP_UNICODE_REVERSE) {
-				_swab(lpData, lpData, cbData);
-			}
+		if (uFlags & (NCP_UTF8 | NCP_DEFAULT | NCP_UNICODE)) {
+			// written in chunks directly from document buffer by EditWriteDocument()
 		} else { // NCP_8BIT, NCP_7BIT
+			lpData = static_cast<char *>(NP2HeapAllocTag(cbData + 1, HeapTag_ConversionBuffer));
+			SciCall_GetText(cbData, lpData);
+
 			BOOL bCancelDataLoss = FALSE;
 			const UINT uCodePage = mEncoding[iEncoding].uCodePage;
 			DWORD cbDataWide = (cbData + 1)*sizeof(WCHAR);
-			LPWSTR lpDataWide = static_cast<LPWSTR>(NP2HeapAlloc(cbDataWide));
+			LPWSTR lpDataWide = static_cast<LPWSTR>(NP2HeapAllocTag(cbDataWide, HeapTag_ConversionBuffer));
 			cbDataWide = MultiByteToWideChar(CP_UTF8, 0, lpData, cbData, lpDataWide, cbData);
 
 			if (IsZeroFlagsCodePage(uCodePage)) {
 				NP2HeapFree(lpData);
 				cbData = ((cbData + 16)*sizeof(WCHAR))*2; // why?
-				lpData = static_cast<char *>(NP2HeapAlloc(cbData + 1));
+				lpData = static_cast<char *>(NP2HeapAllocTag(cbData + 1, HeapTag_ConversionBuffer));
 			} else {
 				memset(lpData, 0, cbData);
 				cbData = WideCharToMultiByte(uCodePage, WC_NO_BEST_FIT_CHARS, lpDataWide, cbDataWide, lpData, cbData, nullptr, &bCancelDataLoss);
@@ -1316,9 +2165,6 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 
 	// write content
 	{
-		BOOL bWriteSuccess = SetEndOfFile(hFile);
-		DWORD dwBytesWritten;
-		// write encoding BOM
 		DWORD bom;
 		DWORD length = 0;
 		if (uFlags & NCP_UNICODE_BOM) {
@@ -1328,7 +2174,23 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 			bom = BOM_UTF8;
 			length = 3;
 		}
-		if (length != 0) {
+		// only rewrite from first changed position when document bytes are same as file content
+		Sci_Position iUnchanged = 0;
+		if (lpData == nullptr && IsByteIdenticalEncoding(uFlags)) {
+			iUnchanged = EditGetUnchangedPrefix(hFile, iEncoding, length);
+		}
+		if (!(saveFlag & FileSaveFlag_SaveCopy)) {
+			savedCurFile.valid = false;
+		}
+
+		EventTraceActivity stage;
+		EventTraceStart(stage, "WriteFile", TraceLoggingUInt32(cbData, "Bytes"), TraceLoggingBool(lpData == nullptr, "Direct"), TraceLoggingInt64(iUnchanged, "Unchanged"));
+		LARGE_INTEGER offset;
+		offset.QuadPart = (iUnchanged != 0) ? (iUnchanged + length) : 0;
+		BOOL bWriteSuccess = SetFilePointerEx(hFile, offset, nullptr, FILE_BEGIN) && SetEndOfFile(hFile);
+		DWORD dwBytesWritten;
+		// write encoding BOM
+		if (iUnchanged == 0 && length != 0) {
 			bWriteSuccess = WriteFile(hFile, &bom, length, &dwBytesWritten, nullptr);
 		}
 		dwLastIOError = GetLastError();
@@ -1336,11 +2198,18 @@ bool EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &st
 			bWriteSuccess = WriteFile(hFile, lpData, cbData, &dwBytesWritten, nullptr);
 			dwLastIOError = GetLastError();
 			NP2HeapFree(lpData);
+		} else if (cbData != 0) {
+			bWriteSuccess = EditWriteDocument(hFile, uFlags, iUnchanged);
+			dwLastIOError = GetLastError();
 		}
 		if (saveFlag & FileSaveFlag_OriginalTimestamp) {
 			SetFileInformationByHandle(hFile, FileBasicInfo, &timestamp, sizeof(timestamp));
 		}
+		if (bWriteSuccess && !(saveFlag & FileSaveFlag_SaveCopy)) {
+			EditUpdateSavedFile(hFile, iEncoding);
+		}
 		CloseHandle(hFile);
+		EventTraceStop(stage, "WriteFile", TraceLoggingBool(bWriteSuccess, "Success"));
 		if (bWriteSuccess) {
 			if (!(saveFlag & FileSaveFlag_SaveCopy)) {
 				SciCall_SetSavePoint();
@@ -1535,60 +2404,203 @@ constexpr bool IsSentenceTerminator(wchar_t ch) noexcept {
 		;
 }
 
+bool IsAsciiText(const char *text, size_t length) noexcept {
+	const char * const end = text + length;
+	while (text + sizeof(uint64_t) <= end) {
+		uint64_t value;
+		memcpy(&value, text, sizeof(uint64_t));
+		if (value & UINT64_C(0x8080808080808080)) {
+			return false;
+		}
+		text += sizeof(uint64_t);
+	}
+	while (text < end) {
+		if (static_cast<uint8_t>(*text) & 0x80) {
+			return false;
+		}
+		++text;
+	}
+	return true;
 }
 
-//=============================================================================
-//
-// EditMapTextCase(), used by ScintillaWin::CaseMapString()
-//
-char *EditMapTextCase(int menu, const char *pszText, size_t &iSelCount, UINT cpEdit) noexcept {
-	DWORD flags = 0;
-	const GUID *pGuid = nullptr;
+// Turkish and Azerbaijani dotted and dotless I, ASCII case mapping is not locale neutral.
+bool IsTurkicUserLocale() noexcept {
+	WCHAR localeName[LOCALE_NAME_MAX_LENGTH] = L"";
+	GetUserDefaultLocaleName(localeName, COUNTOF(localeName));
+	return ((localeName[0] == L't' && localeName[1] == L'r') || (localeName[0] == L'a' && localeName[1] == L'z'))
+		&& (localeName[2] == L'\0' || localeName[2] == L'-');
+}
+
+// map pure ASCII text without UTF-16 conversion, returns false when the mapping is not handled.
+bool MapAsciiTextCase(int menu, const char *pszText, size_t iSelCount, char *&pszOut) noexcept {
 	switch (menu) {
-	case IDM_EDIT_SENTENCECASE:
-	case IDM_EDIT_TITLECASE:
-		flags = LCMAP_LINGUISTIC_CASING | LCMAP_LOWERCASE;
-		break;
-	case IDM_EDIT_MAP_FULLWIDTH:
-		flags = LCMAP_FULLWIDTH;
-		break;
 	case IDM_EDIT_MAP_HALFWIDTH:
-		flags = LCMAP_HALFWIDTH;
-		break;
 	case IDM_EDIT_MAP_SIMPLIFIED_CHINESE:
-		flags = LCMAP_SIMPLIFIED_CHINESE;
-		pGuid = &ELS_GUID_TRANSLITERATION_HANT_TO_HANS;
-		break;
 	case IDM_EDIT_MAP_TRADITIONAL_CHINESE:
-		flags = LCMAP_TRADITIONAL_CHINESE;
-		pGuid = &ELS_GUID_TRANSLITERATION_HANS_TO_HANT;
-		break;
 	case IDM_EDIT_MAP_HIRAGANA:
-		flags = LCMAP_HIRAGANA;
-		break;
 	case IDM_EDIT_MAP_KATAKANA:
-		flags = LCMAP_KATAKANA;
-		break;
 	case IDM_EDIT_MAP_MALAYALAM_LATIN:
-		pGuid = &ELS_GUID_TRANSLITERATION_MALAYALAM_TO_LATIN;
-		break;
 	case IDM_EDIT_MAP_DEVANAGARI_LATIN:
-		pGuid = &ELS_GUID_TRANSLITERATION_DEVANAGARI_TO_LATIN;
-		break;
 	case IDM_EDIT_MAP_CYRILLIC_LATIN:
-		pGuid = &ELS_GUID_TRANSLITERATION_CYRILLIC_TO_LATIN;
-		break;
 	case IDM_EDIT_MAP_BENGALI_LATIN:
-		pGuid = &ELS_GUID_TRANSLITERATION_BENGALI_TO_LATIN;
-		break;
 	case IDM_EDIT_MAP_HANGUL_DECOMPOSITION:
-		pGuid = &WIN10_ELS_GUID_TRANSLITERATION_HANGUL_DECOMPOSITION;
-		break;
+		// ASCII is unchanged
+		pszOut = nullptr;
+		return true;
+	case IDM_EDIT_SENTENCECASE:
 	case IDM_EDIT_INVERTCASE:
-	default:
 		break;
+	default:
+		// full width and title case (word breaking rules of LCMAP_TITLECASE)
+		return false;
+	}
+	if (IsTurkicUserLocale()) {
+		return false;
+	}
+
+	char *output = static_cast<char *>(NP2HeapAlloc(iSelCount + 1));
+	bool bChanged = false;
+	if (menu == IDM_EDIT_INVERTCASE) {
+		for (size_t i = 0; i < iSelCount; i++) {
+			const uint8_t ch = pszText[i];
+			if (IsAlpha(ch)) {
+				output[i] = static_cast<char>(ch ^ 0x20);
+				bChanged = true;
+			} else {
+				output[i] = ch;
+			}
+		}
+	} else {
+		bool bNewSentence = true;
+		for (size_t i = 0; i < iSelCount; i++) {
+			uint8_t ch = pszText[i];
+			if (ch == '\r' || ch == '\n' || ch == '.' || ch == ';' || ch == '!' || ch == '?') {
+				bNewSentence = true;
+			} else if (IsAlphaNumeric(ch)) {
+				if (IsAlpha(ch)) {
+					ch = bNewSentence ? UnsafeUpper(ch) : UnsafeLower(ch);
+				}
+				bNewSentence = false;
+			}
+			output[i] = ch;
+			bChanged |= ch != static_cast<uint8_t>(pszText[i]);
+		}
+	}
+	if (!bChanged) {
+		NP2HeapFree(output);
+		output = nullptr;
+	}
+	pszOut = output;
+	return true;
+}
+
+struct TextCaseMapper {
+	int menu;
+	DWORD flags;
+	const GUID *pGuid;
+	UINT cpEdit;
+
+	char *Map(const char *pszText, size_t &iSelCount) const noexcept;
+};
+
+// chunked case mapping, chunks are split after line feed, which is never a DBCS trail byte
+// and always starts a new sentence and word.
+#define MIN_PARALLEL_MAP_CASE_SIZE	(4U << 20)
+#define PARALLEL_MAP_CASE_CHUNK_SIZE	(1U << 20)
+
+struct TextCaseChunk {
+	const char *text;
+	size_t length;
+	char *mapped;
+};
+
+struct TextCaseMapWorker {
+	const TextCaseMapper *mapper;
+	TextCaseChunk *chunks;
+	UINT chunkCount;
+	LONG nextChunk;
+
+	void DoWork() noexcept {
+		while (true) {
+			const UINT index = static_cast<UINT>(InterlockedIncrement(&nextChunk) - 1);
+			if (index >= chunkCount) {
+				break;
+			}
+			TextCaseChunk &chunk = chunks[index];
+			chunk.mapped = mapper->Map(chunk.text, chunk.length);
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		TextCaseMapWorker *worker = static_cast<TextCaseMapWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+char *MapTextCaseParallel(const TextCaseMapper &mapper, const char *pszText, size_t &iSelCount) noexcept {
+	const size_t length = iSelCount;
+	const UINT chunkCount = static_cast<UINT>((length + PARALLEL_MAP_CASE_CHUNK_SIZE - 1)/PARALLEL_MAP_CASE_CHUNK_SIZE);
+	TextCaseChunk *chunks = static_cast<TextCaseChunk *>(NP2HeapAlloc(chunkCount * sizeof(TextCaseChunk)));
+	size_t start = 0;
+	for (UINT index = 0; index < chunkCount; index++) {
+		size_t end = length;
+		const size_t position = (index + 1)*static_cast<size_t>(PARALLEL_MAP_CASE_CHUNK_SIZE);
+		if (position > start && position < length) {
+			const char *lf = static_cast<const char *>(memchr(pszText + position, '\n', length - position));
+			if (lf != nullptr) {
+				end = lf - pszText + 1;
+			}
+		}
+		end = max(start, end);
+		chunks[index].text = pszText + start;
+		chunks[index].length = end - start;
+		start = end;
+	}
+
+	// text services may not be thread safe, transliteration only reduces memory usage
+	const UINT threadCount = (mapper.pGuid != nullptr) ? 1 : min<UINT>(GetHardwareConcurrency(), chunkCount);
+	TextCaseMapWorker worker { &mapper, chunks, chunkCount, 0 };
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(TextCaseMapWorker::WorkCallback, &worker, nullptr) : nullptr;
+	if (work != nullptr) {
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	worker.DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+
+	size_t total = 0;
+	bool bChanged = false;
+	for (UINT index = 0; index < chunkCount; index++) {
+		total += chunks[index].length;
+		bChanged |= chunks[index].mapped != nullptr;
+	}
+	char *pszOut = nullptr;
+	if (bChanged) {
+		pszOut = static_cast<char *>(NP2HeapAlloc(total + 1));
+		char *ptr = pszOut;
+		for (UINT index = 0; index < chunkCount; index++) {
+			const TextCaseChunk &chunk = chunks[index];
+			memcpy(ptr, (chunk.mapped != nullptr) ? chunk.mapped : chunk.text, chunk.length);
+			ptr += chunk.length;
+		}
+		iSelCount = total;
+	}
+	for (UINT index = 0; index < chunkCount; index++) {
+		if (chunks[index].mapped != nullptr) {
+			NP2HeapFree(chunks[index].mapped);
+		}
 	}
+	NP2HeapFree(chunks);
+	return pszOut;
+}
+
+}
 
+char *TextCaseMapper::Map(const char *pszText, size_t &iSelCount) const noexcept {
 	LPWSTR pszTextW = static_cast<LPWSTR>(NP2HeapAlloc((iSelCount + 1) * sizeof(WCHAR)));
 	UINT cchTextW = MultiByteToWideChar(cpEdit, 0, pszText, static_cast<int>(iSelCount), pszTextW, static_cast<int>(iSelCount + 1));
 
@@ -1676,6 +2688,71 @@ char *EditMapTextCase(int menu, const char *pszText, size_t &iSelCount, UINT cpE
 	return pszOut;
 }
 
+//=============================================================================
+//
+// EditMapTextCase(), used by ScintillaWin::CaseMapString()
+//
+char *EditMapTextCase(int menu, const char *pszText, size_t &iSelCount, UINT cpEdit) noexcept {
+	DWORD flags = 0;
+	const GUID *pGuid = nullptr;
+	switch (menu) {
+	case IDM_EDIT_SENTENCECASE:
+	case IDM_EDIT_TITLECASE:
+		flags = LCMAP_LINGUISTIC_CASING | LCMAP_LOWERCASE;
+		break;
+	case IDM_EDIT_MAP_FULLWIDTH:
+		flags = LCMAP_FULLWIDTH;
+		break;
+	case IDM_EDIT_MAP_HALFWIDTH:
+		flags = LCMAP_HALFWIDTH;
+		break;
+	case IDM_EDIT_MAP_SIMPLIFIED_CHINESE:
+		flags = LCMAP_SIMPLIFIED_CHINESE;
+		pGuid = &ELS_GUID_TRANSLITERATION_HANT_TO_HANS;
+		break;
+	case IDM_EDIT_MAP_TRADITIONAL_CHINESE:
+		flags = LCMAP_TRADITIONAL_CHINESE;
+		pGuid = &ELS_GUID_TRANSLITERATION_HANS_TO_HANT;
+		break;
+	case IDM_EDIT_MAP_HIRAGANA:
+		flags = LCMAP_HIRAGANA;
+		break;
+	case IDM_EDIT_MAP_KATAKANA:
+		flags = LCMAP_KATAKANA;
+		break;
+	case IDM_EDIT_MAP_MALAYALAM_LATIN:
+		pGuid = &ELS_GUID_TRANSLITERATION_MALAYALAM_TO_LATIN;
+		break;
+	case IDM_EDIT_MAP_DEVANAGARI_LATIN:
+		pGuid = &ELS_GUID_TRANSLITERATION_DEVANAGARI_TO_LATIN;
+		break;
+	case IDM_EDIT_MAP_CYRILLIC_LATIN:
+		pGuid = &ELS_GUID_TRANSLITERATION_CYRILLIC_TO_LATIN;
+		break;
+	case IDM_EDIT_MAP_BENGALI_LATIN:
+		pGuid = &ELS_GUID_TRANSLITERATION_BENGALI_TO_LATIN;
+		break;
+	case IDM_EDIT_MAP_HANGUL_DECOMPOSITION:
+		pGuid = &WIN10_ELS_GUID_TRANSLITERATION_HANGUL_DECOMPOSITION;
+		break;
+	case IDM_EDIT_INVERTCASE:
+	default:
+		break;
+	}
+
+	// skip UTF-16 conversion for ASCII text
+	char *pszOut = nullptr;
+	if (IsAsciiText(pszText, iSelCount) && MapAsciiTextCase(menu, pszText, iSelCount, pszOut)) {
+		return pszOut;
+	}
+
+	const TextCaseMapper mapper { menu, flags, pGuid, cpEdit };
+	if (iSelCount >= MIN_PARALLEL_MAP_CASE_SIZE) {
+		return MapTextCaseParallel(mapper, pszText, iSelCount);
+	}
+	return mapper.Map(pszText, iSelCount);
+}
+
 #ifndef URL_ESCAPE_AS_UTF8		// NTDDI_VERSION >= NTDDI_WIN7
 #define URL_ESCAPE_AS_UTF8		0x00040000
 #endif
@@ -1894,7 +2971,62 @@ void EditUnescapeCChars(HWND hwnd) noexcept {
 //
 // EditEscapeXHTMLChars()
 //
-void EditEscapeXHTMLChars(HWND hwnd) noexcept {
+// find next character escaped by EditEscapeXHTMLChars(), space and tab are escaped when not XML.
+static const char *FindXHTMLEscapeChar(const char *ptr, const char *end, bool escapeSpace) noexcept {
+	const char space = escapeSpace ? ' ' : '&';
+	const char tab = escapeSpace ? '\t' : '&';
+#if NP2_USE_AVX2
+	const __m256i vectAmp = _mm256_set1_epi8('&');
+	const __m256i vectQuot = _mm256_set1_epi8('\"');
+	const __m256i vectApos = _mm256_set1_epi8('\'');
+	const __m256i vectLess = _mm256_set1_epi8('<');
+	const __m256i vectGreater = _mm256_set1_epi8('>');
+	const __m256i vectSpace = _mm256_set1_epi8(space);
+	const __m256i vectTab = _mm256_set1_epi8(tab);
+	while (ptr + sizeof(__m256i) <= end) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+		__m256i result = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectAmp), _mm256_cmpeq_epi8(chunk, vectQuot));
+		result = _mm256_or_si256(result, _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectApos), _mm256_cmpeq_epi8(chunk, vectLess)));
+		result = _mm256_or_si256(result, _mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectGreater), _mm256_cmpeq_epi8(chunk, vectSpace)));
+		result = _mm256_or_si256(result, _mm256_cmpeq_epi8(chunk, vectTab));
+		const uint32_t mask = mm256_movemask_epi8(result);
+		if (mask != 0) {
+			return ptr + np2_ctz(mask);
+		}
+		ptr += sizeof(__m256i);
+	}
+#elif NP2_USE_SSE2
+	const __m128i vectAmp = _mm_set1_epi8('&');
+	const __m128i vectQuot = _mm_set1_epi8('\"');
+	const __m128i vectApos = _mm_set1_epi8('\'');
+	const __m128i vectLess = _mm_set1_epi8('<');
+	const __m128i vectGreater = _mm_set1_epi8('>');
+	const __m128i vectSpace = _mm_set1_epi8(space);
+	const __m128i vectTab = _mm_set1_epi8(tab);
+	while (ptr + sizeof(__m128i) <= end) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		__m128i result = _mm_or_si128(_mm_cmpeq_epi8(chunk, vectAmp), _mm_cmpeq_epi8(chunk, vectQuot));
+		result = _mm_or_si128(result, _mm_or_si128(_mm_cmpeq_epi8(chunk, vectApos), _mm_cmpeq_epi8(chunk, vectLess)));
+		result = _mm_or_si128(result, _mm_or_si128(_mm_cmpeq_epi8(chunk, vectGreater), _mm_cmpeq_epi8(chunk, vectSpace)));
+		result = _mm_or_si128(result, _mm_cmpeq_epi8(chunk, vectTab));
+		const uint32_t mask = mm_movemask_epi8(result);
+		if (mask != 0) {
+			return ptr + np2_ctz(mask);
+		}
+		ptr += sizeof(__m128i);
+	}
+#endif
+	while (ptr < end) {
+		const char ch = *ptr;
+		if (ch == '&' || ch == '\"' || ch == '\'' || ch == '<' || ch == '>' || ch == space || ch == tab) {
+			break;
+		}
+		++ptr;
+	}
+	return ptr;
+}
+
+void EditEscapeXHTMLChars([[maybe_unused]] HWND hwnd) noexcept {
 	if (SciCall_IsSelectionEmpty()) {
 		return;
 	}
@@ -1903,42 +3035,56 @@ void EditEscapeXHTMLChars(HWND hwnd) noexcept {
 		return;
 	}
 
-	EDITFINDREPLACE * const efr = static_cast<EDITFINDREPLACE *>(NP2HeapAlloc(sizeof(EDITFINDREPLACE)));
-	efr->hwnd = hwnd;
-	SciCall_BeginBatchUpdate();
-
-	StrCpyEx(efr->szFind, "&");
-	StrCpyEx(efr->szReplace, "&amp;");
-	EditReplaceAllInSelection(hwnd, efr);
-
-	StrCpyEx(efr->szFind, "\"");
-	StrCpyEx(efr->szReplace, "&quot;");
-	EditReplaceAllInSelection(hwnd, efr);
-
-	StrCpyEx(efr->szFind, "\'");
-	StrCpyEx(efr->szReplace, "&apos;");
-	EditReplaceAllInSelection(hwnd, efr);
-
-	StrCpyEx(efr->szFind, "<");
-	StrCpyEx(efr->szReplace, "&lt;");
-	EditReplaceAllInSelection(hwnd, efr);
-
-	StrCpyEx(efr->szFind, ">");
-	StrCpyEx(efr->szReplace, "&gt;");
-	EditReplaceAllInSelection(hwnd, efr);
-
-	if (pLexCurrent->iLexer != SCLEX_XML) {
-		StrCpyEx(efr->szFind, " ");
-		StrCpyEx(efr->szReplace, "&nbsp;");
-		EditReplaceAllInSelection(hwnd, efr);
-
-		StrCpyEx(efr->szFind, "\t");
-		StrCpyEx(efr->szReplace, "&emsp;");
-		EditReplaceAllInSelection(hwnd, efr);
+	// escape in one pass, unchanged text between escaped characters is copied at once
+	const Sci_Position iSelStart = SciCall_GetSelectionStart();
+	const Sci_Position iSelCount = SciCall_GetSelectionEnd() - iSelStart;
+	const bool escapeSpace = pLexCurrent->iLexer != SCLEX_XML;
+	const char *ptr = SciCall_GetRangePointer(iSelStart, iSelCount);
+	const char * const end = ptr + iSelCount;
+	char * const output = static_cast<char *>(NP2HeapAlloc(iSelCount*CSTRLEN("&nbsp;") + 1));
+	char *out = output;
+	while (ptr < end) {
+		const char *next = FindXHTMLEscapeChar(ptr, end, escapeSpace);
+		memcpy(out, ptr, next - ptr);
+		out += next - ptr;
+		if (next == end) {
+			break;
+		}
+		const char *entity;
+		switch (*next) {
+		case '&':
+			entity = "&amp;";
+			break;
+		case '\"':
+			entity = "&quot;";
+			break;
+		case '\'':
+			entity = "&apos;";
+			break;
+		case '<':
+			entity = "&lt;";
+			break;
+		case '>':
+			entity = "&gt;";
+			break;
+		case ' ':
+			entity = "&nbsp;";
+			break;
+		default:
+			entity = "&emsp;";
+			break;
+		}
+		const size_t length = strlen(entity);
+		memcpy(out, entity, length);
+		out += length;
+		ptr = next + 1;
 	}
 
-	NP2HeapFree(efr);
-	SciCall_EndBatchUpdate();
+	const Sci_Position cchText = out - output;
+	if (cchText != iSelCount) {
+		EditReplaceMainSelection(cchText, output);
+	}
+	NP2HeapFree(output);
 }
 
 //=============================================================================
@@ -2253,6 +3399,36 @@ using u_getPropertyValueNameSig = const char * (__cdecl *)(int property, int32_t
 	SetClipData(hwndMain, wchBuf);
 }
 
+// statistics of selection or whole document when selection is empty
+void EditShowTextStatistics() noexcept {
+	if (SciCall_IsRectangularSelection()) {
+		NotifyRectangularSelection();
+		return;
+	}
+
+	Sci_TextStatistics ts{};
+	ts.chrg.cpMin = SciCall_GetSelectionStart();
+	ts.chrg.cpMax = SciCall_GetSelectionEnd();
+	if (ts.chrg.cpMin == ts.chrg.cpMax) {
+		ts.chrg.cpMin = 0;
+		ts.chrg.cpMax = -1;
+	}
+	BeginWaitCursor();
+	SciCall_CountTextStatistics(&ts);
+	EndWaitCursor();
+
+	char buffer[512];
+	sprintf(buffer, "Bytes: %" PRId64 "\nCharacters: %" PRId64 "\nUTF-16: %" PRId64 "\nWords: %" PRId64
+		"\nLines: %" PRId64 "\nEmpty Lines: %" PRId64 "\nLongest Line: %" PRId64 "\nInvalid Bytes: %" PRId64,
+		static_cast<int64_t>(ts.chrg.cpMax - ts.chrg.cpMin), static_cast<int64_t>(ts.characters),
+		static_cast<int64_t>(ts.utf16Units), static_cast<int64_t>(ts.words),
+		static_cast<int64_t>(ts.lines), static_cast<int64_t>(ts.emptyLines),
+		static_cast<int64_t>(ts.longestLine), static_cast<int64_t>(ts.invalidBytes));
+
+	const WPARAM notifyPos = (static_cast<WPARAM>(ts.chrg.cpMin) << 2) | SC_NOTIFICATIONPOSITION_NONE;
+	ShowNotificationA(notifyPos, buffer);
+}
+
 void EditBase64Encode(Base64EncodingFlag encodingFlag) noexcept {
 	const size_t iSelByte = SciCall_GetSelTextLength();
 	if (iSelByte == 0) {
@@ -3526,8 +4702,7 @@ void EditToggleLineComments(LPCWSTR pwszComment, int commentFlag) noexcept {
 //
 // EditPadWithSpaces()
 //
-void EditPadWithSpaces(bool bSkipEmpty, bool bNoUndoGroup) noexcept {
-	Sci_Position iMaxColumn = 0;
+void EditPadWithSpaces(bool bSkipEmpty) noexcept {
 	bool bReducedSelection = false;
 
 	Sci_Position iSelStart = 0;
@@ -3560,11 +4735,6 @@ void EditPadWithSpaces(bool bSkipEmpty, bool bNoUndoGroup) noexcept {
 				}
 			}
 		}
-
-		for (Sci_Line iLine = iLineStart; iLine <= iLineEnd; iLine++) {
-			const Sci_Position iPos = SciCall_GetLineEndPosition(iLine);
-			iMaxColumn = max(iMaxColumn, SciCall_GetColumn(iPos));
-		}
 	} else {
 		const Sci_Position iCurPos = SciCall_GetCurrentPos();
 		const Sci_Position iAnchorPos = SciCall_GetAnchor();
@@ -3574,51 +4744,16 @@ void EditPadWithSpaces(bool bSkipEmpty, bool bNoUndoGroup) noexcept {
 
 		iRcCurCol = SciCall_GetColumn(iCurPos);
 		iRcAnchorCol = SciCall_GetColumn(iAnchorPos);
-
-		iLineStart = 0;
-		iLineEnd = SciCall_GetLineCount() - 1;
-
-		for (Sci_Line iLine = iLineStart; iLine <= iLineEnd; iLine++) {
-			const Sci_Position iPos = SciCall_GetLineSelEndPosition(iLine);
-			if (iPos >= 0) {
-				iMaxColumn = max(iMaxColumn, SciCall_GetColumn(iPos));
-			}
-		}
 	}
 
-	char *pmszPadStr = static_cast<char *>(NP2HeapAlloc((iMaxColumn + 1) * sizeof(char)));
-	if (pmszPadStr) {
-		memset(pmszPadStr, ' ', iMaxColumn);
-		if (!bNoUndoGroup) {
-			SciCall_BeginUndoAction();
-		}
-
-		for (Sci_Line iLine = iLineStart; iLine <= iLineEnd; iLine++) {
-			const Sci_Position iLineSelEndPos = SciCall_GetLineSelEndPosition(iLine);
-			if (bIsRectangular && iLineSelEndPos < 0) {
-				continue;
-			}
-
-			const Sci_Position iPos = SciCall_GetLineEndPosition(iLine);
-			if (bIsRectangular && iPos > iLineSelEndPos) {
-				continue;
-			}
-
-			if (bSkipEmpty && SciCall_PositionFromLine(iLine) >= iPos) {
-				continue;
-			}
-
-			const Sci_Position iPadLen = iMaxColumn - SciCall_GetColumn(iPos);
-
-			SciCall_SetTargetRange(iPos, iPos);
-			SciCall_ReplaceTarget(iPadLen, pmszPadStr);
-		}
-
-		NP2HeapFree(pmszPadStr);
-		if (!bNoUndoGroup) {
-			SciCall_EndUndoAction();
-		}
+	// lines are measured and padded in one pass by Scintilla
+	int flags = bSkipEmpty ? SC_LINESPAD_SKIPEMPTY : SC_LINESPAD_NONE;
+	if (bIsRectangular) {
+		flags |= SC_LINESPAD_RECTANGULAR;
+	} else {
+		SciCall_SetTargetRange(SciCall_PositionFromLine(iLineStart), SciCall_GetLineEndPosition(iLineEnd));
 	}
+	SciCall_LinesPad(flags);
 
 	if (!bIsRectangular && SciCall_LineFromPosition(iSelStart) != SciCall_LineFromPosition(iSelEnd)) {
 		Sci_Position iCurPos = SciCall_GetCurrentPos();
@@ -3721,6 +4856,117 @@ void EditStripLastCharacter() noexcept {
 	SciCall_EndUndoAction();
 }
 
+//=============================================================================
+//
+// EditTransformLines()
+//
+// copy line [text, end) without line ending to output and return end of output, nullptr removes the line.
+// line must not become longer.
+typedef char *(*LineTransformProc)(const char *text, const char *end, char *output, void *param) noexcept;
+
+// find end of line text in [text, end), next is set to start of next line.
+static inline const char *FindLineEnd(const char *text, const char *end, const char **next) noexcept {
+	while (text < end && *text != '\r' && *text != '\n') {
+		++text;
+	}
+	const char *ptr = text;
+	if (ptr < end) {
+		ptr += (ptr[0] == '\r' && ptr + 1 < end && ptr[1] == '\n') ? 2 : 1;
+	}
+	*next = ptr;
+	return text;
+}
+
+// move position inside line [lineStart, lineStart + length) (line ending excluded) to transformed line.
+static inline Sci_Position TransformLinePosition(Sci_Position position, Sci_Position lineStart, Sci_Position length, Sci_Position outStart, Sci_Position outLength) noexcept {
+	const Sci_Position offset = position - lineStart;
+	return outStart + ((offset > length) ? (outLength + offset - length) : min(offset, outLength));
+}
+
+// rewrite lines [iLineStart, iLineEnd] in one pass over the text, only changed text is replaced
+// in a single undo action, caret and anchor stay on their lines.
+static void EditTransformLines(Sci_Line iLineStart, Sci_Line iLineEnd, LineTransformProc transform, void *param) noexcept {
+	const Sci_Position iStartPos = SciCall_PositionFromLine(iLineStart);
+	const Sci_Position iEndPos = SciCall_PositionFromLine(iLineEnd + 1);
+	const Sci_Position iLength = iEndPos - iStartPos;
+	if (iLength <= 0) {
+		return;
+	}
+
+	const char * const text = SciCall_GetRangePointer(iStartPos, iLength);
+	char * const output = static_cast<char *>(NP2HeapAlloc(iLength + 1));
+	const Sci_Position iCurPos = SciCall_GetCurrentPos();
+	const Sci_Position iAnchorPos = SciCall_GetAnchor();
+	Sci_Position iNewCurPos = iCurPos;
+	Sci_Position iNewAnchorPos = iAnchorPos;
+
+	const char * const end = text + iLength;
+	const char *ptr = text;
+	char *out = output;
+	while (ptr < end) {
+		const char *next;
+		const char *lineEnd = FindLineEnd(ptr, end, &next);
+		char *lineOut = transform(ptr, lineEnd, out, param);
+		const Sci_Position lineStart = iStartPos + (ptr - text);
+		const Sci_Position lineLength = lineEnd - ptr;
+		const Sci_Position outStart = iStartPos + (out - output);
+		Sci_Position outLength = 0;
+		if (lineOut != nullptr) {
+			outLength = lineOut - out;
+			memcpy(lineOut, lineEnd, next - lineEnd);
+			out = lineOut + (next - lineEnd);
+		}
+		const Sci_Position nextStart = iStartPos + (next - text);
+		if (iCurPos >= lineStart && iCurPos < nextStart) {
+			iNewCurPos = (lineOut == nullptr) ? outStart : TransformLinePosition(iCurPos, lineStart, lineLength, outStart, outLength);
+		}
+		if (iAnchorPos >= lineStart && iAnchorPos < nextStart) {
+			iNewAnchorPos = (lineOut == nullptr) ? outStart : TransformLinePosition(iAnchorPos, lineStart, lineLength, outStart, outLength);
+		}
+		ptr = next;
+	}
+
+	const Sci_Position outLength = out - output;
+	Sci_Position prefix = 0;
+	const Sci_Position common = min(iLength, outLength);
+	while (prefix < common && text[prefix] == output[prefix]) {
+		++prefix;
+	}
+	if (prefix != iLength || outLength != iLength) {
+		Sci_Position suffix = 0;
+		while (suffix < common - prefix && text[iLength - 1 - suffix] == output[outLength - 1 - suffix]) {
+			++suffix;
+		}
+		const Sci_Position delta = outLength - iLength;
+		if (iCurPos >= iEndPos) {
+			iNewCurPos = iCurPos + delta;
+		}
+		if (iAnchorPos >= iEndPos) {
+			iNewAnchorPos = iAnchorPos + delta;
+		}
+		SciCall_SetTargetRange(iStartPos + prefix, iEndPos - suffix);
+		SciCall_ReplaceTarget(outLength - prefix - suffix, output + prefix);
+		SciCall_SetSel(iNewAnchorPos, iNewCurPos);
+	}
+	NP2HeapFree(output);
+}
+
+static char *StripTrailingBlanksProc(const char *text, const char *end, char *output, [[maybe_unused]] void *param) noexcept {
+	while (end > text && IsASpaceOrTab(end[-1])) {
+		--end;
+	}
+	memcpy(output, text, end - text);
+	return output + (end - text);
+}
+
+static char *StripLeadingBlanksProc(const char *text, const char *end, char *output, [[maybe_unused]] void *param) noexcept {
+	while (text < end && IsASpaceOrTab(*text)) {
+		++text;
+	}
+	memcpy(output, text, end - text);
+	return output + (end - text);
+}
+
 //=============================================================================
 //
 // EditStripTrailingBlanks()
@@ -3739,26 +4985,7 @@ void EditStripTrailingBlanks(HWND hwnd, bool bIgnoreSelection) noexcept {
 		}
 	}
 
-	// Code from SciTE...
-	SciCall_BeginUndoAction();
-	const Sci_Line maxLines = SciCall_GetLineCount();
-	for (Sci_Line line = 0; line < maxLines; line++) {
-		const Sci_Position lineStart = SciCall_PositionFromLine(line);
-		const Sci_Position lineEnd = SciCall_GetLineEndPosition(line);
-		Sci_Position i = lineEnd;
-		while (i >= lineStart) {
-			i--;
-			const int ch = SciCall_GetCharAt(i);
-			if (!IsASpaceOrTab(ch)) {
-				break;
-			}
-		}
-		i++;
-		if (i < lineEnd) {
-			SciCall_DeleteRange(i, lineEnd - i);
-		}
-	}
-	SciCall_EndUndoAction();
+	EditTransformLines(0, SciCall_GetLineCount() - 1, StripTrailingBlanksProc, nullptr);
 }
 
 //=============================================================================
@@ -3779,17 +5006,7 @@ void EditStripLeadingBlanks(HWND hwnd, bool bIgnoreSelection) noexcept {
 		}
 	}
 
-	// Code from SciTE...
-	SciCall_BeginUndoAction();
-	const Sci_Line maxLines = SciCall_GetLineCount();
-	for (Sci_Line line = 0; line < maxLines; line++) {
-		const Sci_Position lineStart = SciCall_PositionFromLine(line);
-		const Sci_Position lineEnd = SciCall_GetLineIndentPosition(line);
-		if (lineEnd > lineStart) {
-			SciCall_DeleteRange(lineStart, lineEnd - lineStart);
-		}
-	}
-	SciCall_EndUndoAction();
+	EditTransformLines(0, SciCall_GetLineCount() - 1, StripLeadingBlanksProc, nullptr);
 }
 
 //=============================================================================
@@ -3859,6 +5076,30 @@ void EditCompressSpaces() noexcept {
 	NP2HeapFree(pszIn);
 }
 
+struct RemoveBlankLinesParam {
+	bool bMerge;
+	bool bPrevBlank;
+};
+
+// blank line is kept when merging and previous line is not blank
+static char *RemoveBlankLinesProc(const char *text, const char *end, char *output, void *param) noexcept {
+	RemoveBlankLinesParam * const blank = static_cast<RemoveBlankLinesParam *>(param);
+	const char *ptr = text;
+	while (ptr < end && IsASpaceOrTab(*ptr)) {
+		++ptr;
+	}
+	if (ptr == end) {
+		if (!blank->bMerge || blank->bPrevBlank) {
+			return nullptr;
+		}
+		blank->bPrevBlank = true;
+	} else {
+		blank->bPrevBlank = false;
+	}
+	memcpy(output, text, end - text);
+	return output + (end - text);
+}
+
 //=============================================================================
 //
 // EditRemoveBlankLines()
@@ -3888,37 +5129,155 @@ void EditRemoveBlankLines(bool bMerge) noexcept {
 		iLineEnd--;
 	}
 
-	SciCall_BeginUndoAction();
-	for (Sci_Line iLine = iLineStart; iLine <= iLineEnd;) {
-		Sci_Line nBlanks = 0;
-		while (iLine + nBlanks <= iLineEnd && SciCall_GetLineIndentPosition(iLine + nBlanks) == SciCall_GetLineEndPosition(iLine + nBlanks)) {
-			nBlanks++;
-		}
+	RemoveBlankLinesParam param = { bMerge, false };
+	EditTransformLines(iLineStart, iLineEnd, RemoveBlankLinesProc, &param);
+}
 
-		if (nBlanks == 0 || (nBlanks == 1 && bMerge)) {
-			iLine += nBlanks + 1;
-		} else {
-			if (bMerge) {
-				nBlanks--;
+// lines are found with open addressing hash table, first line of each text is kept.
+struct DuplicateLineSlot {
+	const char *text;
+	uint32_t length;
+	uint32_t line;
+};
+
+struct RemoveDuplicateLinesParam {
+	const bool *keep;
+	Sci_Line line;
+};
+
+static inline uint32_t DuplicateLine_Hash(const char *text, uint32_t length) noexcept {
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (uint32_t i = 0; i < length; i++) {
+		hash = (hash ^ static_cast<uint8_t>(text[i])) * 16777619U;
+	}
+	return hash;
+}
+
+static char *RemoveDuplicateLinesProc(const char *text, const char *end, char *output, void *param) noexcept {
+	RemoveDuplicateLinesParam * const dup = static_cast<RemoveDuplicateLinesParam *>(param);
+	if (!dup->keep[dup->line++]) {
+		return nullptr;
+	}
+	memcpy(output, text, end - text);
+	return output + (end - text);
+}
+
+//=============================================================================
+//
+// EditRemoveDuplicateLines()
+//
+void EditRemoveDuplicateLines(bool bMerge) noexcept {
+	if (SciCall_IsRectangularSelection()) {
+		EditSortLines(static_cast<EditSortFlag>(EditSortFlag_DontSort | (bMerge ? EditSortFlag_MergeDuplicate : EditSortFlag_RemoveDuplicate)));
+		return;
+	}
+
+	const Sci_Position iSelEnd = SciCall_GetSelectionEnd();
+	const Sci_Line iLineStart = SciCall_LineFromPosition(SciCall_GetSelectionStart());
+	Sci_Line iLineEnd = SciCall_LineFromPosition(iSelEnd);
+	if (iSelEnd <= SciCall_PositionFromLine(iLineEnd)) {
+		iLineEnd--;
+	}
+
+	const Sci_Line iLineCount = iLineEnd - iLineStart + 1;
+	if (iLineCount < 2 || iLineCount > INT_MAX/2) {
+		return;
+	}
+
+	UINT capacity = 64;
+	while (capacity < iLineCount + iLineCount/2) {
+		capacity <<= 1;
+	}
+	bool * const keep = static_cast<bool *>(NP2HeapAlloc(iLineCount * sizeof(bool)));
+	DuplicateLineSlot * const slots = static_cast<DuplicateLineSlot *>(NP2HeapAlloc(capacity * sizeof(DuplicateLineSlot)));
+
+	const Sci_Position iStartPos = SciCall_PositionFromLine(iLineStart);
+	const Sci_Position iLength = SciCall_PositionFromLine(iLineEnd + 1) - iStartPos;
+	const char *ptr = SciCall_GetRangePointer(iStartPos, iLength);
+	const char * const end = ptr + iLength;
+	bool bModified = false;
+	// same lines as EditTransformLines(), empty last line is not included
+	for (uint32_t line = 0; ptr < end; line++) {
+		const char *next;
+		const char *lineEnd = FindLineEnd(ptr, end, &next);
+		const uint32_t length = static_cast<uint32_t>(lineEnd - ptr);
+		uint32_t index = DuplicateLine_Hash(ptr, length) & (capacity - 1);
+		while (true) {
+			DuplicateLineSlot &slot = slots[index];
+			if (slot.text == nullptr) {
+				slot.text = ptr;
+				slot.length = length;
+				slot.line = line;
+				keep[line] = true;
+				break;
+			}
+			if (slot.length == length && memcmp(slot.text, ptr, length) == 0) {
+				// remove all lines with duplicate text when not merging
+				keep[slot.line] = bMerge;
+				bModified = true;
+				break;
 			}
+			index = (index + 1) & (capacity - 1);
+		}
+		ptr = next;
+	}
+
+	NP2HeapFree(slots);
+	if (bModified) {
+		RemoveDuplicateLinesParam param = { keep, 0 };
+		EditTransformLines(iLineStart, iLineEnd, RemoveDuplicateLinesProc, &param);
+	}
+	NP2HeapFree(keep);
+}
+
+//=============================================================================
+//
+// EditWrapToColumn()
+//
+// number of UTF-16 code units for character at ptr, which is moved to next character.
+static inline int NextCharUnits(const char *&ptr, const char *end, UINT cpEdit) noexcept {
+	const uint8_t ch = *ptr++;
+	if (ch < 0x80 || cpEdit == 0) {
+		return 1;
+	}
+	if (cpEdit == CP_UTF8) {
+		// trail byte is counted with lead byte, 4 bytes sequence is surrogate pair
+		return (ch >= 0xF0) ? 2 : ((ch & 0xC0) != 0x80);
+	}
+	if (ptr < end && IsDBCSLeadByteEx(cpEdit, ch)) {
+		++ptr;
+	}
+	return 1;
+}
 
-			const Sci_Position iTargetStart = SciCall_PositionFromLine(iLine);
-			const Sci_Position iTargetEnd = SciCall_PositionFromLine(iLine + nBlanks);
-			SciCall_DeleteRange(iTargetStart, iTargetEnd - iTargetStart);
+// replace [iStartPos, iStartPos + iLength) with output and select it, only changed text is replaced.
+static void EditReplaceChangedRange(Sci_Position iStartPos, const char *text, Sci_Position iLength, const char *output, Sci_Position outLength) noexcept {
+	Sci_Position prefix = 0;
+	const Sci_Position common = min(iLength, outLength);
+	while (prefix < common && text[prefix] == output[prefix]) {
+		++prefix;
+	}
+	Sci_Position suffix = 0;
+	while (suffix < common - prefix && text[iLength - 1 - suffix] == output[outLength - 1 - suffix]) {
+		++suffix;
+	}
 
-			if (bMerge) {
-				iLine++;
-			}
-			iLineEnd -= nBlanks;
-		}
+	Sci_Position iCurPos = SciCall_GetCurrentPos();
+	Sci_Position iAnchorPos = SciCall_GetAnchor();
+	if (iAnchorPos > iCurPos) {
+		iCurPos = iStartPos;
+		iAnchorPos = iStartPos + outLength;
+	} else {
+		iAnchorPos = iStartPos;
+		iCurPos = iStartPos + outLength;
 	}
-	SciCall_EndUndoAction();
+	SciCall_SetTargetRange(iStartPos + prefix, iStartPos + iLength - suffix);
+	SciCall_ReplaceTarget(outLength - prefix - suffix, output + prefix);
+	SciCall_SetSel(iAnchorPos, iCurPos);
 }
 
-//=============================================================================
-//
-// EditWrapToColumn()
-//
+// reflow in single pass over range pointer, columns are counted in UTF-16 code units.
 void EditWrapToColumn(int nColumn/*, int nTabWidth*/) noexcept {
 	if (SciCall_IsSelectionEmpty()) {
 		return;
@@ -3935,112 +5294,69 @@ void EditWrapToColumn(int nColumn/*, int nTabWidth*/) noexcept {
 	iSelStart = SciCall_PositionFromLine(iLine);
 
 	const Sci_Position iSelCount = iSelEnd - iSelStart;
-	const size_t allocSize = NP2_align_up(iSelCount + 1 + 2, MEMORY_ALLOCATION_ALIGNMENT);
-	char *pszText = static_cast<char *>(NP2HeapAlloc(allocSize * (sizeof(char) + sizeof(WCHAR))));
-	WCHAR * const pszTextW = reinterpret_cast<LPWSTR>(pszText + allocSize);
-
-	const Sci_TextRangeFull tr = { { iSelStart, iSelEnd }, pszText };
-	SciCall_GetTextRangeFull(&tr);
+	const char * const text = SciCall_GetRangePointer(iSelStart, iSelCount);
+	const char * const end = text + iSelCount;
+	// each white space run becomes at most one line ending
+	char * const output = static_cast<char *>(NP2HeapAlloc(2*iSelCount + 2));
 
 	const UINT cpEdit = SciCall_GetCodePage();
-	const UINT cchTextW = MultiByteToWideChar(cpEdit, 0, pszText, static_cast<int>(iSelCount), pszTextW, static_cast<int>(allocSize));
-
-	LPWSTR pszConvW = static_cast<LPWSTR>(NP2HeapAlloc(cchTextW * sizeof(WCHAR) * 3 + 2));
-
 	const unsigned iEOLMode = SciCall_GetEOLMode();
-	unsigned wszEOL = '\r' | ('\n' << 16);
-	wszEOL >>= 16*(iEOLMode >> 1);
-
-#define ISDELIMITER(wc) StrChr(L",;.:-+%&\xA6|/*?!\"\'~\xB4#=", wc)
-#define ISWHITE(wc)		IsASpaceOrTab(wc)
-#define ISWORDEND(wc)	(/*ISDELIMITER(wc) ||*/ IsASpace(wc))
+	unsigned szEOL = '\r' | ('\n' << 8);
+	szEOL >>= 8*(iEOLMode >> 1);
+	const int cchEOL = (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
 
-	UINT cchConvW = 0;
+	char *out = output;
 	int iLineLength = 0;
 	bool bModified = false;
-	for (UINT iTextW = 0; iTextW < cchTextW; iTextW++) {
-		const WCHAR w = pszTextW[iTextW];
-
-		//if (ISDELIMITER(w)) {
-		//	int iNextWordLen = 0;
-		//	WCHAR w2 = pszTextW[iTextW + 1];
-		//
-		//	if (iLineLength + iNextWordLen + 1 > nColumn) {
-		//		memcpy(pszConvW + cchConvW, &wszEOL, 2*sizeof(WCHAR));
-		//		cchConvW += (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
-		//		iLineLength = 0;
-		//		bModified = true;
-		//	}
-		//
-		//	while (w2 != L'\0' && !ISWORDEND(w2)) {
-		//		iNextWordLen++;
-		//		w2 = pszTextW[iTextW + iNextWordLen + 1];
-		//	}
-		//
-		//	if (ISDELIMITER(w2) && iNextWordLen > 0) // delimiters go with the word
-		//		iNextWordLen++;
-		//
-		//	pszConvW[cchConvW++] = w;
-		//	iLineLength++;
-		//
-		//	if (iNextWordLen > 0) {
-		//		if (iLineLength + iNextWordLen + 1 > nColumn) {
-		//			memcpy(pszConvW + cchConvW, &wszEOL, 2*sizeof(WCHAR));
-		//			cchConvW += (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
-		//			iLineLength = 0;
-		//			bModified = true;
-		//		}
-		//	}
-		//}
-
-		if (ISWHITE(w)) {
-			while (IsASpaceOrTab(pszTextW[iTextW + 1])) {
-				iTextW++;
-				bModified = true;
-			} // Modified: left out some whitespaces
+	const char *ptr = text;
+	while (ptr < end) {
+		const uint8_t ch = *ptr;
+		if (IsASpaceOrTab(ch)) {
+			++ptr;
+			if (ptr < end && IsASpaceOrTab(*ptr)) {
+				bModified = true; // Modified: left out some whitespaces
+				do {
+					++ptr;
+				} while (ptr < end && IsASpaceOrTab(*ptr));
+			}
 
-			WCHAR w2 = pszTextW[iTextW + 1];
+			const char *wordEnd = ptr;
 			int iNextWordLen = 0;
-
-			while (w2 != L'\0' && !ISWORDEND(w2)) {
-				iNextWordLen++;
-				w2 = pszTextW[iTextW + iNextWordLen + 1];
+			while (wordEnd < end && !IsASpace(*wordEnd)) {
+				iNextWordLen += NextCharUnits(wordEnd, end, cpEdit);
 			}
-
-			//if (ISDELIMITER(w2) /*&& iNextWordLen > 0*/) // delimiters go with the word
-			//	iNextWordLen++;
 			if (iNextWordLen > 0) {
 				if (iLineLength + iNextWordLen + 1 > nColumn) {
-					memcpy(pszConvW + cchConvW, &wszEOL, 2*sizeof(WCHAR));
-					cchConvW += (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
+					memcpy(out, &szEOL, 2);
+					out += cchEOL;
 					iLineLength = 0;
 					bModified = true;
-				} else {
-					if (iLineLength > 0) {
-						pszConvW[cchConvW++] = L' ';
-						iLineLength++;
-					}
+				} else if (iLineLength > 0) {
+					*out++ = ' ';
+					iLineLength++;
 				}
-			}
+				memcpy(out, ptr, wordEnd - ptr);
+				out += wordEnd - ptr;
+				iLineLength += iNextWordLen;
+				ptr = wordEnd;
+			}
+		} else if (IsEOLChar(ch)) {
+			*out++ = ch;
+			++ptr;
+			iLineLength = 0;
 		} else {
-			pszConvW[cchConvW++] = w;
-			if (w == L'\r' || w == L'\n') {
-				iLineLength = 0;
-			} else {
-				iLineLength++;
-			}
+			const char *next = ptr;
+			iLineLength += NextCharUnits(next, end, cpEdit);
+			memcpy(out, ptr, next - ptr);
+			out += next - ptr;
+			ptr = next;
 		}
 	}
 
-	NP2HeapFree(pszText);
 	if (bModified) {
-		const UINT outLen = cchConvW * kMaxMultiByteCount + 1;
-		pszText = static_cast<char *>(NP2HeapAlloc(outLen));
-		const UINT cchText = WideCharToMultiByte(cpEdit, 0, pszConvW, cchConvW, pszText, outLen, nullptr, nullptr);
-		EditReplaceRange(iSelStart, iSelEnd, cchText, pszText);
-		NP2HeapFree(pszText);
+		EditReplaceChangedRange(iSelStart, text, iSelCount, output, out - output);
 	}
-	NP2HeapFree(pszConvW);
+	NP2HeapFree(output);
 }
 
 //=============================================================================
@@ -4062,50 +5378,58 @@ void EditJoinLinesEx() noexcept {
 	iSelStart = SciCall_PositionFromLine(iLine);
 
 	const Sci_Position iSelCount = iSelEnd - iSelStart;
-	const size_t allocSize = NP2_align_up(iSelCount + 1 + 2, MEMORY_ALLOCATION_ALIGNMENT);
-	char * const pszText = static_cast<char *>(NP2HeapAlloc(allocSize * 2));
-	char * const pszJoin = pszText + allocSize;
-
-	const Sci_TextRangeFull tr = { { iSelStart, iSelEnd }, pszText };
-	SciCall_GetTextRangeFull(&tr);
+	const char * const text = SciCall_GetRangePointer(iSelStart, iSelCount);
+	const char * const end = text + iSelCount;
+	// run of line endings becomes at most two line endings
+	char * const output = static_cast<char *>(NP2HeapAlloc(2*iSelCount + 4));
 
 	const unsigned iEOLMode = SciCall_GetEOLMode();
 	unsigned szEOL = '\r' | ('\n' << 8);
 	szEOL >>= 8*(iEOLMode >> 1);
+	const int cchEOL = (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
 
-	Sci_Position cchJoin = 0;
+	char *out = output;
 	bool bModified = false;
-	for (Sci_Position i = 0; i < iSelCount; i++) {
-		if (IsEOLChar(pszText[i])) {
-			if (pszText[i] == '\r' && pszText[i + 1] == '\n') {
-				i++;
-			}
-			if (!IsEOLChar(pszText[i + 1]) && pszText[i + 1] != '\0') {
-				pszJoin[cchJoin++] = ' ';
+	const char *ptr = text;
+	while (ptr < end) {
+		const char *lineEnd = static_cast<const char *>(memchr(ptr, '\n', end - ptr));
+		const char *cr = static_cast<const char *>(memchr(ptr, '\r', ((lineEnd != nullptr) ? lineEnd : end) - ptr));
+		if (cr != nullptr) {
+			lineEnd = cr;
+		} else if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		memcpy(out, ptr, lineEnd - ptr);
+		out += lineEnd - ptr;
+		ptr = lineEnd;
+		if (ptr == end) {
+			break;
+		}
+
+		ptr += (ptr[0] == '\r' && ptr + 1 < end && ptr[1] == '\n') ? 2 : 1;
+		if (ptr < end && !IsEOLChar(*ptr)) {
+			*out++ = ' ';
+			bModified = true;
+		} else {
+			while (ptr < end && IsEOLChar(*ptr)) {
+				++ptr;
 				bModified = true;
-			} else {
-				while (IsEOLChar(pszText[i + 1])) {
-					i++;
-					bModified = true;
-				}
-				if (pszText[i + 1] != '\0') {
-					if (cchJoin != 0) {
-						memcpy(pszJoin + cchJoin, &szEOL, 2);
-						cchJoin += (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
-					}
-					memcpy(pszJoin + cchJoin, &szEOL, 2);
-					cchJoin += (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
+			}
+			if (ptr < end) {
+				if (out != output) {
+					memcpy(out, &szEOL, 2);
+					out += cchEOL;
 				}
+				memcpy(out, &szEOL, 2);
+				out += cchEOL;
 			}
-		} else {
-			pszJoin[cchJoin++] = pszText[i];
 		}
 	}
 
 	if (bModified) {
-		EditReplaceRange(iSelStart, iSelEnd, cchJoin, pszJoin);
+		EditReplaceChangedRange(iSelStart, text, iSelCount, output, out - output);
 	}
-	NP2HeapFree(pszText);
+	NP2HeapFree(output);
 }
 
 //=============================================================================
@@ -4114,14 +5438,28 @@ void EditJoinLinesEx() noexcept {
 //
 namespace {
 
+#define PARALLEL_SORT_MIN_LINES	(64*1024)
+
 struct SORTLINE {
 	LPCWSTR pwszLine;
 	LPCWSTR pwszSortEntry;
 	LPCWSTR pwszSortLine;
+	uint64_t key; // first 4 characters of pwszSortEntry, compared before calling wcscmp()
 	int iLine;
 	EditSortFlag iSortFlags;
 };
 
+inline uint64_t GetSortKey(LPCWSTR pwsz) noexcept {
+	uint64_t key = 0;
+	for (int i = 0; i < 4; i++) {
+		key <<= 16;
+		if (*pwsz) {
+			key |= static_cast<uint16_t>(*pwsz++);
+		}
+	}
+	return key;
+}
+
 int __cdecl CmpSortLine(const void *p1, const void *p2) noexcept {
 	const SORTLINE *s1 = static_cast<const SORTLINE *>(p1);
 	const SORTLINE *s2 = static_cast<const SORTLINE *>(p2);
@@ -4134,7 +5472,11 @@ int __cdecl CmpSortLine(const void *p1, const void *p2) noexcept {
 		}
 	}
 	if (cmp == 0) {
-		cmp = wcscmp(s1->pwszSortEntry, s2->pwszSortEntry);
+		if (s1->key != s2->key) {
+			cmp = (s1->key < s2->key) ? -1 : 1;
+		} else {
+			cmp = wcscmp(s1->pwszSortEntry, s2->pwszSortEntry);
+		}
 		if (cmp == 0 && (iSortFlags & (EditSortFlag_ColumnSort | EditSortFlag_GroupByFileType))) {
 			cmp = wcscmp(s1->pwszSortLine, s2->pwszSortLine);
 		}
@@ -4158,6 +5500,98 @@ int __cdecl DontSortLine(const void *p1, const void *p2) noexcept {
 	return s1->iLine - s2->iLine;
 }
 
+// sort runs of lines on thread pool, runs are then merged on caller thread.
+struct SortLinesWorker {
+	SORTLINE *pLines;
+	const Sci_Line *runs;
+	UINT runCount;
+	LONG nextRun;
+
+	void DoWork() noexcept {
+		while (true) {
+			const UINT index = static_cast<UINT>(InterlockedIncrement(&nextRun) - 1);
+			if (index >= runCount) {
+				break;
+			}
+			qsort(pLines + runs[index], runs[index + 1] - runs[index], sizeof(SORTLINE), CmpSortLine);
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		SortLinesWorker *worker = static_cast<SortLinesWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+void MergeSortLines(SORTLINE *dest, const SORTLINE *left, const SORTLINE *leftEnd, const SORTLINE *right, const SORTLINE *rightEnd) noexcept {
+	while (left < leftEnd && right < rightEnd) {
+		if (CmpSortLine(right, left) < 0) {
+			*dest++ = *right++;
+		} else {
+			*dest++ = *left++;
+		}
+	}
+	memcpy(dest, left, (leftEnd - left)*sizeof(SORTLINE));
+	dest += leftEnd - left;
+	memcpy(dest, right, (rightEnd - right)*sizeof(SORTLINE));
+}
+
+// same result as qsort() with CmpSortLine(), which never returns zero for different lines.
+void SortLines(SORTLINE *pLines, Sci_Line iLineCount) noexcept {
+	UINT runCount = 1;
+	SORTLINE *pTemp = nullptr;
+	if (iLineCount >= PARALLEL_SORT_MIN_LINES) {
+		runCount = min<UINT>(GetHardwareConcurrency(), 64);
+		if (runCount > 1) {
+			pTemp = static_cast<SORTLINE *>(NP2HeapAllocTag(sizeof(SORTLINE) * iLineCount, HeapTag_SortLines));
+		}
+	}
+	if (pTemp == nullptr) {
+		qsort(pLines, iLineCount, sizeof(SORTLINE), CmpSortLine);
+		return;
+	}
+
+	Sci_Line runs[64 + 1];
+	for (UINT i = 0; i <= runCount; i++) {
+		runs[i] = iLineCount*i/runCount;
+	}
+	SortLinesWorker worker { pLines, runs, runCount, 0 };
+	PTP_WORK work = CreateThreadpoolWork(SortLinesWorker::WorkCallback, &worker, nullptr);
+	if (work != nullptr) {
+		for (UINT i = 1; i < runCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+	}
+	worker.DoWork();
+	if (work != nullptr) {
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+
+	// merge adjacent runs until only one remains
+	SORTLINE *src = pLines;
+	SORTLINE *dest = pTemp;
+	while (runCount > 1) {
+		UINT count = 0;
+		for (UINT i = 0; i < runCount; i += 2) {
+			const Sci_Line start = runs[i];
+			const Sci_Line middle = runs[i + 1];
+			const Sci_Line end = (i + 2 <= runCount) ? runs[i + 2] : middle;
+			MergeSortLines(dest + start, src + start, src + middle, src + middle, src + end);
+			runs[count++] = start;
+		}
+		runs[count] = iLineCount;
+		runCount = count;
+		SORTLINE * const swap = src;
+		src = dest;
+		dest = swap;
+	}
+	if (src != pLines) {
+		memcpy(pLines, src, sizeof(SORTLINE) * iLineCount);
+	}
+	NP2HeapFree(pTemp);
+}
+
 }
 
 void EditSortLines(EditSortFlag iSortFlags) noexcept {
@@ -4212,7 +5646,7 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 
 	SciCall_BeginUndoAction();
 	if (bIsRectangular) {
-		EditPadWithSpaces(!(iSortFlags & EditSortFlag_Shuffle), true);
+		EditPadWithSpaces(!(iSortFlags & EditSortFlag_Shuffle));
 	}
 
 	const UINT cpEdit = SciCall_GetCodePage();
@@ -4223,36 +5657,43 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 	if (iSortFlags & EditSortFlag_IgnoreCase) {
 		cchTextW += cchTextW;
 	}
-	char * const pmszBuf = static_cast<char *>(NP2HeapAlloc(cbPmszBuf + cchTextW + sizeof(SORTLINE) * iLineCount));
+	char * const pmszBuf = static_cast<char *>(NP2HeapAllocTag(cbPmszBuf + cchTextW + sizeof(SORTLINE) * iLineCount, HeapTag_SortLines));
 	WCHAR * const pszTextW = reinterpret_cast<WCHAR *>(pmszBuf + cbPmszBuf);
 	SORTLINE * const pLines = reinterpret_cast<SORTLINE *>(pmszBuf + cbPmszBuf + cchTextW);
-	size_t cchTotal = alignof(WCHAR *)/sizeof(WCHAR); // first pointer reserved for empty line
 
-	for (Sci_Line i = 0, iLine = iLineStart; iLine <= iLineEnd; i++, iLine++) {
-		SciCall_GetLine(iLine, pmszBuf);
-		const Sci_Position cbLine = SciCall_GetLineLength(iLine);
+	// convert whole range at once, then split lines in place
+	const Sci_Position iTargetLength = iTargetEnd - iTargetStart;
+	const char * const pszText = SciCall_GetRangePointer(iTargetStart, iTargetLength);
+	const UINT cchRangeW = MultiByteToWideChar(cpEdit, 0, pszText, static_cast<int>(iTargetLength), pszTextW, static_cast<int>(cbPmszBuf));
+	pszTextW[cchRangeW] = L'\0';
+	size_t cchUpperOffset = 0;
+	if (iSortFlags & EditSortFlag_IgnoreCase) {
+		// convert to uppercase for case insensitive comparison, the mapping keeps string length.
+		// https://learn.microsoft.com/en-us/dotnet/api/system.string.toupper?view=net-7.0#system-string-toupper
+		cchUpperOffset = NP2_align_up(cchRangeW + 1, alignof(WCHAR *)/sizeof(WCHAR));
+		LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, pszTextW, cchRangeW + 1, pszTextW + cchUpperOffset, static_cast<int>(cbPmszBuf), nullptr, nullptr, 0);
+	}
 
-		// remove EOL
-		char *p = pmszBuf + cbLine - 1;
-		if (*p == '\n' || *p == '\r') {
-			*p-- = '\0';
+	WCHAR *pwszNext = pszTextW;
+	WCHAR * const pwszEnd = pszTextW + cchRangeW;
+	for (Sci_Line i = 0, iLine = iLineStart; iLine <= iLineEnd; i++, iLine++) {
+		LPWSTR pwszLine = pwszNext;
+		WCHAR *p = pwszLine;
+		while (p < pwszEnd && *p != L'\r' && *p != L'\n') {
+			++p;
 		}
-		if (*p == '\r') {
-			*p-- = '\0';
+		pwszNext = p;
+		if (p < pwszEnd) {
+			pwszNext += (p[0] == L'\r' && p + 1 < pwszEnd && p[1] == L'\n') ? 2 : 1;
 		}
+		// remove EOL
+		*p = L'\0';
 
-		if (p >= pmszBuf) {
-			LPWSTR pwszLine = pszTextW + cchTotal;
-			const UINT cchLine = MultiByteToWideChar(cpEdit, 0, pmszBuf, -1, pwszLine, static_cast<int>(cbPmszBuf));
-			cchTotal += NP2_align_up(cchLine, alignof(WCHAR *)/sizeof(WCHAR));
+		if (*pwszLine) {
 			pLines[i].pwszLine = pwszLine;
 			if (iSortFlags & EditSortFlag_IgnoreCase) {
-				// convert to uppercase for case insensitive comparison
-				// https://learn.microsoft.com/en-us/dotnet/api/system.string.toupper?view=net-7.0#system-string-toupper
-				LPWSTR pwszSortLine = pszTextW + cchTotal;
-				const UINT charsConverted = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_UPPERCASE, pwszLine, cchLine, pwszSortLine, static_cast<int>(cbPmszBuf), nullptr, nullptr, 0);
-				cchTotal += NP2_align_up(charsConverted, alignof(WCHAR *)/sizeof(WCHAR));
-				pwszLine = pwszSortLine;
+				pwszLine[cchUpperOffset + (p - pwszLine)] = L'\0';
+				pwszLine += cchUpperOffset;
 			}
 
 			pLines[i].pwszSortLine = pwszLine;
@@ -4283,12 +5724,14 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 				pwszLine = PathFindExtension(pwszLine);
 			}
 			pLines[i].pwszSortEntry = pwszLine;
+			pLines[i].key = GetSortKey(pwszLine);
 			pLines[i].iLine = static_cast<int>(iLine);
 			pLines[i].iSortFlags = iSortFlags;
 		} else {
-			pLines[i].pwszLine = pszTextW;
-			pLines[i].pwszSortEntry = pszTextW;
-			pLines[i].pwszSortLine = pszTextW;
+			pLines[i].pwszLine = pwszEnd;
+			pLines[i].pwszSortEntry = pwszEnd;
+			pLines[i].pwszSortLine = pwszEnd;
+			pLines[i].key = 0;
 			pLines[i].iLine = static_cast<int>(iLine);
 			pLines[i].iSortFlags = iSortFlags;
 		}
@@ -4306,7 +5749,7 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 			pLines[j] = sLine;
 		}
 	} else {
-		qsort(pLines, iLineCount, sizeof(SORTLINE), CmpSortLine);
+		SortLines(pLines, iLineCount);
 		if (iSortFlags > EditSortFlag_Shuffle) {
 			bool bLastDup = false;
 			for (Sci_Line i = 0; i < iLineCount; i++) {
@@ -4333,7 +5776,7 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 	szEOL >>= 8*(iEOLMode >> 1);
 
 	char *pszOut = pmszBuf;
-	cchTotal = 0;
+	size_t cchTotal = 0;
 	for (Sci_Line i = 0; i < iLineCount; i++) {
 		LPCWSTR pwszLine = pLines[i].pwszLine;
 		if (pwszLine) {
@@ -4357,6 +5800,7 @@ void EditSortLines(EditSortFlag iSortFlags) noexcept {
 	SciCall_ReplaceTarget(cchTotal, pmszBuf);
 	SciCall_EndUndoAction();
 	NP2HeapFree(pmszBuf);
+	HeapStatistics_Trace("SortLines");
 
 	if (!bIsRectangular) {
 		if (iAnchorPos > iCurPos) {
@@ -4483,8 +5927,8 @@ void EditEnsureConsistentLineEndings() noexcept {
 		return;
 	}
 	const size_t actions = SciCall_GetUndoActions();
-	if (lineCount + actions >= MAX_SMALL_FILE_SIZE) {
-		// Scintilla undo stack is indexed with int
+	if (actions + 1024 >= MAX_SMALL_FILE_SIZE) {
+		// Scintilla undo stack is indexed with int, ConvertEOLs() adds at most 1024 actions
 		return;
 	}
 
@@ -4506,6 +5950,120 @@ void EditEnsureConsistentLineEndings() noexcept {
 	EditFixPositions();
 }
 
+// change history tracks edits without markers when fixing only modified lines on save.
+int EditGetChangeHistoryOption() noexcept {
+	if (bFixOnlyModifiedLines && (bFixLineEndings || bAutoStripBlanks)) {
+		return iChangeHistoryMarker | SC_CHANGE_HISTORY_ENABLED;
+	}
+	return iChangeHistoryMarker;
+}
+
+// convert line endings of lines [iLineStart, iLineEnd] to iEOLMode in a single replacement.
+static void EditConvertLineEndings(Sci_Line iLineStart, Sci_Line iLineEnd, int iEOLMode) noexcept {
+	const Sci_Position iStartPos = SciCall_PositionFromLine(iLineStart);
+	const Sci_Position iEndPos = SciCall_PositionFromLine(iLineEnd + 1);
+	const Sci_Position iLength = iEndPos - iStartPos;
+	if (iLength <= 0) {
+		return;
+	}
+
+	const char * const eol = (iEOLMode == SC_EOL_CRLF) ? "\r\n" : ((iEOLMode == SC_EOL_CR) ? "\r" : "\n");
+	const Sci_Position eolLength = (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
+	const char * const text = SciCall_GetRangePointer(iStartPos, iLength);
+	const char * const end = text + iLength;
+	const char *first = end;
+	for (const char *ptr = text; ptr < end;) {
+		const char *next;
+		const char *lineEnd = FindLineEnd(ptr, end, &next);
+		if (next != lineEnd && (next - lineEnd != eolLength || memcmp(lineEnd, eol, eolLength) != 0)) {
+			first = lineEnd;
+			break;
+		}
+		ptr = next;
+	}
+	if (first == end) {
+		return;
+	}
+
+	// each line ending becomes at most one character longer
+	const Sci_Position iFirstPos = iStartPos + (first - text);
+	char * const output = static_cast<char *>(NP2HeapAlloc(2*(end - first) + 1));
+	const Sci_Position iCurPos = SciCall_GetCurrentPos();
+	const Sci_Position iAnchorPos = SciCall_GetAnchor();
+	Sci_Position iNewCurPos = iCurPos;
+	Sci_Position iNewAnchorPos = iAnchorPos;
+	char *out = output;
+	const char *ptr = first;
+	while (ptr < end) {
+		const char *next;
+		const char *lineEnd = FindLineEnd(ptr, end, &next);
+		const Sci_Position lineStart = iFirstPos + (ptr - first);
+		const Sci_Position eolStart = lineStart + (lineEnd - ptr);
+		const Sci_Position outStart = iFirstPos + (out - output);
+		memcpy(out, ptr, lineEnd - ptr);
+		out += lineEnd - ptr;
+		if (next != lineEnd) {
+			memcpy(out, eol, eolLength);
+			out += eolLength;
+		}
+		// position inside old line ending moves to start of new line ending
+		if (iCurPos >= lineStart && iCurPos < iFirstPos + (next - first)) {
+			iNewCurPos = outStart + min(iCurPos, eolStart) - lineStart;
+		}
+		if (iAnchorPos >= lineStart && iAnchorPos < iFirstPos + (next - first)) {
+			iNewAnchorPos = outStart + min(iAnchorPos, eolStart) - lineStart;
+		}
+		ptr = next;
+	}
+
+	const Sci_Position delta = (out - output) - (end - first);
+	if (iCurPos >= iEndPos) {
+		iNewCurPos = iCurPos + delta;
+	}
+	if (iAnchorPos >= iEndPos) {
+		iNewAnchorPos = iAnchorPos + delta;
+	}
+	SciCall_SetTargetRange(iFirstPos, iEndPos);
+	SciCall_ReplaceTarget(out - output, output);
+	SciCall_SetSel(iNewAnchorPos, iNewCurPos);
+	NP2HeapFree(output);
+}
+
+//=============================================================================
+//
+// EditFixModifiedLines()
+//
+// Applies on save fixes only to lines changed since last save point, which are
+// found from change history instead of scanning whole document.
+//
+void EditFixModifiedLines(bool fixLineEndings, bool stripBlanks) noexcept {
+	constexpr int markerMask = (1 << SC_MARKNUM_HISTORY_REVERTED_TO_ORIGIN)
+		| (1 << SC_MARKNUM_HISTORY_MODIFIED)
+		| (1 << SC_MARKNUM_HISTORY_REVERTED_TO_MODIFIED);
+	const int iEOLMode = SciCall_GetEOLMode();
+	Sci_Line line = SciCall_ChangeHistoryLineNext(0, markerMask);
+	if (line < 0) {
+		return;
+	}
+
+	SciCall_BeginUndoAction();
+	while (line >= 0) {
+		// fixes keep line count, so later lines are not shifted
+		Sci_Line lineEnd = line;
+		while (SciCall_ChangeHistoryLineNext(lineEnd + 1, markerMask) == lineEnd + 1) {
+			++lineEnd;
+		}
+		if (fixLineEndings) {
+			EditConvertLineEndings(line, lineEnd, iEOLMode);
+		}
+		if (stripBlanks) {
+			EditTransformLines(line, lineEnd, StripTrailingBlanksProc, nullptr);
+		}
+		line = SciCall_ChangeHistoryLineNext(lineEnd + 1, markerMask);
+	}
+	SciCall_EndUndoAction();
+}
+
 //=============================================================================
 //
 // EditGetExcerpt()
@@ -5553,6 +7111,8 @@ extern HANDLE idleTaskTimer;
 // when selection no longer changed, this make continuous selecting smooth.
 #define EditMarkAll_DefaultDuration		64
 #define EditMarkAll_RangeCacheCount		256
+// mark visible lines first for mark occurrences in large document
+#define EditMarkAll_VisibleMinSize		(16*EditMarkAll_MeasuredSize)
 //static UINT EditMarkAll_Runs;
 
 void EditMarkAll::Reset(int findFlag, Sci_Position iSelCount, LPSTR text) noexcept {
@@ -5585,6 +7145,7 @@ void EditMarkAll::Reset(int findFlag, Sci_Position iSelCount, LPSTR text) noexce
 	lastMatchPos = 0;
 	prevStopPos = 0;
 	prevBookmarkLine = -1;
+	visibleStart = 0;
 }
 
 void EditMarkAll::Start(BOOL bChanged, int findFlag, Sci_Position iSelCount, LPSTR text) noexcept {
@@ -5620,7 +7181,32 @@ void EditMarkAll::Start(BOOL bChanged, int findFlag, Sci_Position iSelCount, LPS
 		bookmarkForFindAll = (findFlag & NP2_FromFindAll) != 0;
 		Style_SetBookmark();
 	}
-	Continue(idleTaskTimer);
+	if ((findFlag & (NP2_FromFindAll | NP2_MarkAllSelectAll | NP2_MarkAllMultiline)) == 0 && SciCall_GetLength() >= EditMarkAll_VisibleMinSize) {
+		// scanning whole document on every selection change is slow
+		MarkVisible();
+		return;
+	}
+	if (!FindAll()) {
+		WaitableTimer_Set(idleTaskTimer, WaitableTimer_IdleTaskTimeSlot);
+		Continue(idleTaskTimer);
+	}
+}
+
+void EditMarkAll::MarkVisible() noexcept {
+	// visible lines with one screen margin above and below
+	const Sci_Line lineCount = SciCall_LinesOnScreen();
+	const Sci_Line firstLine = SciCall_DocLineFromVisible(SciCall_GetFirstVisibleLine());
+	const Sci_Line lineEnd = firstLine + 2*lineCount + 1;
+	visibleStart = SciCall_PositionFromLine(max<Sci_Line>(firstLine - lineCount, 0));
+	const Sci_Position visibleEnd = (lineEnd < SciCall_GetLineCount()) ? SciCall_PositionFromLine(lineEnd) : SciCall_GetLength();
+
+	SciCall_SetIndicatorCurrent(IndicatorNumber_MarkOccurrence);
+	// remaining text is marked from end of visible range by Continue(),
+	// which is cancelled by Reset() when selection changed.
+	prevStopPos = MarkRange(visibleStart, visibleEnd, nullptr);
+	pending = true;
+	UpdateStatusBarCache(StatusItem_Find);
+	UpdateStatusbar();
 }
 
 void EditMarkAll::Stop() noexcept {
@@ -5631,6 +7217,8 @@ void EditMarkAll::Stop() noexcept {
 }
 
 static Sci_Line EditMarkAll_Bookmark(Sci_Line bookmarkLine, const Sci_Position *ranges, UINT index, int findFlag, Sci_Position matchCount) noexcept {
+	Sci_CommandRecord commands[EditMarkAll_RangeCacheCount];
+	UINT count = 0;
 	if (findFlag & NP2_MarkAllSelectAll) {
 		UINT i = 0;
 		if (matchCount == static_cast<Sci_Position>(index/2)) {
@@ -5638,12 +7226,12 @@ static Sci_Line EditMarkAll_Bookmark(Sci_Line bookmarkLine, const Sci_Position *
 			SciCall_SetSelection(ranges[0] + ranges[1], ranges[0]);
 		}
 		for (; i < index; i += 2) {
-			SciCall_AddSelection(ranges[i] + ranges[i + 1], ranges[i]);
+			commands[count++] = { SCI_ADDSELECTION, static_cast<uptr_t>(ranges[i] + ranges[i + 1]), ranges[i] };
 		}
+		SciCall_SendCommands(count, commands);
+		count = 0;
 	} else {
-		for (UINT i = 0; i < index; i += 2) {
-			SciCall_IndicatorFillRange(ranges[i], ranges[i + 1]);
-		}
+		SciCall_IndicatorFillRanges(index/2, ranges);
 	}
 	if (!(findFlag & NP2_MarkAllBookmark)) {
 		return bookmarkLine;
@@ -5654,41 +7242,90 @@ static Sci_Line EditMarkAll_Bookmark(Sci_Line bookmarkLine, const Sci_Position *
 			const Sci_Line lineEnd = SciCall_LineFromPosition(ranges[i] + ranges[i + 1]);
 			line = max(bookmarkLine + 1, line);
 			while (line <= lineEnd) {
-				SciCall_MarkerAdd(line, MarkerNumber_Bookmark);
+				if (count == EditMarkAll_RangeCacheCount) {
+					SciCall_SendCommands(count, commands);
+					count = 0;
+				}
+				commands[count++] = { SCI_MARKERADD, static_cast<uptr_t>(line), MarkerNumber_Bookmark };
 				++line;
 			}
 			bookmarkLine = lineEnd;
 		}
+		SciCall_SendCommands(count, commands);
 	} else {
+		Sci_Line lines[EditMarkAll_RangeCacheCount + 1];
 		for (UINT i = 0; i < index; i += 2) {
 			const Sci_Line line = SciCall_LineFromPosition(ranges[i]);
 			if (line != bookmarkLine) {
-				SciCall_MarkerAdd(line, MarkerNumber_Bookmark);
+				lines[count++] = line;
 				bookmarkLine = line;
 			}
 		}
+		lines[count] = -1;
+		SciCall_MarkerAddLines(MarkerNumber_Bookmark, lines);
 	}
 	return bookmarkLine;
 }
 
-void EditMarkAll::Continue(HANDLE timer) noexcept {
-	// use increment search to ensure FindText() terminated in expected time.
-	//++EditMarkAll_Runs;
-	//printf("match %3u %s\n", EditMarkAll_Runs, GetCurrentLogTime());
-	QueryPerformanceCounter(&watch.begin);
+// find all matches at once in multiple threads when pattern doesn't cross line end.
+bool EditMarkAll::FindAll() noexcept {
 	const Sci_Position iLength = SciCall_GetLength();
-	Sci_Position iStartPos = prevStopPos;
-	Sci_Position iMaxLength = incrementSize * EditMarkAll_MeasuredSize;
-	iMaxLength += iStartPos + length;
-	iMaxLength = min(iMaxLength, iLength);
-	if (iMaxLength < iLength) {
-		// match on whole line to avoid rewinding.
-		iMaxLength = SciCall_PositionFromLine(SciCall_LineFromPosition(iMaxLength) + 1);
-		if (iMaxLength + EditMarkAll_MeasuredSize >= iLength) {
-			iMaxLength = iLength;
+	const int findFlag = markFlag;
+	Sci_TextToFindFull ttf = { { 0, iLength }, pszText, { 0, 0 } };
+	const Sci_Position count = SciCall_FindAll(findFlag, &ttf);
+	if (count < 0) {
+		return false;
+	}
+
+	const Sci_Position * const matches = SciCall_GetFindAllRanges();
+	Sci_Position matchCount_ = 0;
+	Sci_Position cpMax = 0;
+	UINT index = 0;
+	Sci_Position ranges[EditMarkAll_RangeCacheCount*2];
+	Sci_Line bookmarkLine = -1;
+
+	SciCall_SetIndicatorCurrent(IndicatorNumber_MarkOccurrence);
+	for (Sci_Position i = 0; i < count*2; i += 2) {
+		const Sci_Position iPos = matches[i];
+		const Sci_Position iSelCount = matches[i + 1];
+		++matchCount_;
+		if (iSelCount == 0) {
+			// empty regex
+			continue;
+		}
+
+		if (index != 0 && iPos == cpMax && (findFlag & (NP2_MarkAllSelectAll | NP2_SearchForLineEnd)) == 0) {
+			ranges[index - 1] += iSelCount;
+		} else {
+			ranges[index] = iPos;
+			ranges[index + 1] = iSelCount;
+			index += 2;
+			if (index == COUNTOF(ranges)) {
+				bookmarkLine = EditMarkAll_Bookmark(bookmarkLine, ranges, index, findFlag, matchCount_);
+				index = 0;
+			}
 		}
+		cpMax = iPos + iSelCount;
+	}
+	if (index) {
+		bookmarkLine = EditMarkAll_Bookmark(bookmarkLine, ranges, index, findFlag, matchCount_);
 	}
+	// release matches
+	SciCall_FindAll(0, nullptr);
+
+	pending = false;
+	ignoreSelectionUpdate = matchCount_ && (findFlag & NP2_MarkAllSelectAll);
+	lastMatchPos = iLength;
+	prevStopPos = iLength;
+	prevBookmarkLine = bookmarkLine;
+	matchCount = matchCount_;
+	UpdateStatusBarCache(StatusItem_Find);
+	UpdateStatusbar();
+	return true;
+}
 
+// mark matches in [iStartPos, iMaxLength) until timer expired, returns stop position.
+Sci_Position EditMarkAll::MarkRange(Sci_Position iStartPos, Sci_Position iMaxLength, HANDLE timer) noexcept {
 	// rewind start position
 	const int findFlag = markFlag;
 	if (findFlag & NP2_MarkAllMultiline) {
@@ -5703,9 +7340,7 @@ void EditMarkAll::Continue(HANDLE timer) noexcept {
 	Sci_Position ranges[EditMarkAll_RangeCacheCount*2];
 	Sci_Line bookmarkLine = prevBookmarkLine;
 
-	SciCall_SetIndicatorCurrent(IndicatorNumber_MarkOccurrence);
-	WaitableTimer_Set(timer, WaitableTimer_IdleTaskTimeSlot);
-	while (cpMin < iMaxLength && WaitableTimer_Continue(timer)) {
+	while (cpMin < iMaxLength && (timer == nullptr || IdleTask_Continue(timer))) {
 		ttf.chrg.cpMin = cpMin;
 		const Sci_Position iPos = SciCall_FindTextFull(findFlag, &ttf);
 		if (iPos < 0) {
@@ -5739,9 +7374,47 @@ void EditMarkAll::Continue(HANDLE timer) noexcept {
 		bookmarkLine = EditMarkAll_Bookmark(bookmarkLine, ranges, index, findFlag, matchCount_);
 	}
 
-	iStartPos = max(iStartPos, cpMin);
-	pending = iStartPos < iLength;
+	ignoreSelectionUpdate = matchCount_ && (findFlag & NP2_MarkAllSelectAll);
+	lastMatchPos = cpMin;
+	prevBookmarkLine = bookmarkLine;
+	matchCount = matchCount_;
+	return max(iStartPos, cpMin);
+}
+
+void EditMarkAll::Continue(HANDLE timer) noexcept {
+	// use increment search to ensure FindText() terminated in expected time.
+	//++EditMarkAll_Runs;
+	//printf("match %3u %s\n", EditMarkAll_Runs, GetCurrentLogTime());
+	QueryPerformanceCounter(&watch.begin);
+	const Sci_Position iLength = SciCall_GetLength();
+	// text before visible range is searched after reaching document end
+	const bool wrapped = prevStopPos < visibleStart;
+	const Sci_Position iEndPos = wrapped ? visibleStart : iLength;
+	Sci_Position iStartPos = prevStopPos;
+	Sci_Position iMaxLength = incrementSize * EditMarkAll_MeasuredSize;
+	iMaxLength += iStartPos + length;
+	iMaxLength = min(iMaxLength, iEndPos);
+	if (iMaxLength < iEndPos) {
+		// match on whole line to avoid rewinding.
+		iMaxLength = min(SciCall_PositionFromLine(SciCall_LineFromPosition(iMaxLength) + 1), iEndPos);
+		if (iMaxLength + EditMarkAll_MeasuredSize >= iEndPos) {
+			iMaxLength = iEndPos;
+		}
+	}
+
+	const Sci_Position prevMatchCount = matchCount;
+	EventTraceActivity activity;
+	EventTraceStart(activity, "MarkAll", TraceLoggingInt64(iStartPos, "Start"), TraceLoggingInt64(iMaxLength, "End"));
+	SciCall_SetIndicatorCurrent(IndicatorNumber_MarkOccurrence);
+	iStartPos = MarkRange(iStartPos, iMaxLength, timer);
+	EventTraceStop(activity, "MarkAll", TraceLoggingInt64(iStartPos, "StopPos"), TraceLoggingInt64(matchCount, "Matches"));
+
+	pending = iStartPos < iEndPos;
 	if (pending) {
+		if (iStartPos == prevStopPos) {
+			// pre-empted by user input before any progress
+			return;
+		}
 		// dynamic compute increment search size, see ActionDuration in Scintilla.
 		watch.Stop();
 		const double period = watch.Get();
@@ -5753,14 +7426,16 @@ void EditMarkAll::Continue(HANDLE timer) noexcept {
 		incrementSize = 1 + static_cast<int>(WaitableTimer_IdleTaskTimeSlot / duration);
 		//printf("match %3u (%zd, %zd) length=%.3f / %zd, one=%.3f, duration=%.3f / %.3f, increment=%d\n", EditMarkAll_Runs,
 		//	prevStopPos, iStartPos, period, iMaxLength, durationOne, duration, duration_, incrementSize);
+	} else if (!wrapped && visibleStart != 0) {
+		// wrap around to document start
+		pending = true;
+		iStartPos = 0;
+		lastMatchPos = 0;
+		prevBookmarkLine = -1;
 	}
 
-	ignoreSelectionUpdate = matchCount_ && (findFlag & NP2_MarkAllSelectAll);
-	lastMatchPos = cpMin;
 	prevStopPos = iStartPos;
-	prevBookmarkLine = bookmarkLine;
-	if (!pending || matchCount_ != matchCount) {
-		matchCount = matchCount_;
+	if (!pending || matchCount != prevMatchCount) {
 		UpdateStatusBarCache(StatusItem_Find);
 		UpdateStatusbar();
 	}
@@ -5835,6 +7510,98 @@ void EditFindAll(const EDITFINDREPLACE *lpefr, bool selectAll) noexcept {
 	editMarkAll.Start(FALSE, searchFlags, strlen(szFind2), szFind2);
 }
 
+// filter view, lines without matches are hidden, the document is not modified.
+struct EditFilterView {
+	int searchFlags;			// NP2_InvalidSearchFlags when not filtered
+	Sci_Line contextLines;		// lines shown before and after each match
+	char szFind[NP2_FIND_REPLACE_LIMIT];
+};
+
+static EditFilterView editFilterView = { NP2_InvalidSearchFlags, 0, "" };
+
+bool EditIsFilterActive() noexcept {
+	return editFilterView.searchFlags != NP2_InvalidSearchFlags;
+}
+
+void EditFilterLinesReset() noexcept {
+	editFilterView.searchFlags = NP2_InvalidSearchFlags;
+}
+
+// hide lines from lineStart without matches, return number of shown lines.
+static Sci_Line EditFilterLinesFrom(Sci_Line lineStart) noexcept {
+	const int searchFlags = editFilterView.searchFlags;
+	const Sci_Line contextLines = editFilterView.contextLines;
+	const Sci_Position iLength = SciCall_GetLength();
+	// matches before lineStart may show context lines after it
+	Sci_TextToFindFull ttf = { { SciCall_PositionFromLine(max<Sci_Line>(lineStart - contextLines, 0)), iLength }, editFilterView.szFind, { 0, 0 } };
+	if (SciCall_FindAll(searchFlags, &ttf) >= 0) {
+		const Sci_Line shownLines = SciCall_HideLinesExceptFindAll(lineStart, contextLines);
+		// release matches
+		SciCall_FindAll(0, nullptr);
+		return shownLines;
+	}
+
+	// pattern crosses line end, find matches one by one
+	SciCall_FindAll(0, nullptr);
+	SciCall_HideLinesExceptFindAll(lineStart, contextLines);
+	const Sci_Line lineCount = SciCall_GetLineCount();
+	Sci_Line shownLines = 0;
+	Sci_Line lineShown = -1;
+	while (ttf.chrg.cpMin <= iLength && SciCall_FindTextFull(searchFlags, &ttf) >= 0) {
+		const Sci_Line lineFirst = max(SciCall_LineFromPosition(ttf.chrgText.cpMin) - contextLines, max<Sci_Line>(lineShown + 1, 0));
+		const Sci_Line lineLast = min(SciCall_LineFromPosition(ttf.chrgText.cpMax) + contextLines, lineCount - 1);
+		if (lineFirst <= lineLast) {
+			SciCall_ShowLines(lineFirst, lineLast);
+			shownLines += lineLast - lineFirst + 1;
+			lineShown = lineLast;
+		}
+		if (ttf.chrgText.cpMax >= iLength) {
+			break;
+		}
+		ttf.chrg.cpMin = (ttf.chrgText.cpMax > ttf.chrgText.cpMin) ? ttf.chrgText.cpMax : SciCall_PositionAfter(ttf.chrgText.cpMax);
+	}
+	return shownLines;
+}
+
+void EditFilterLines(const EDITFINDREPLACE *lpefr, Sci_Line contextLines) noexcept {
+	const int searchFlags = EditPrepareFind(editFilterView.szFind, lpefr);
+	if (searchFlags == NP2_InvalidSearchFlags) {
+		return;
+	}
+
+	BeginWaitCursor();
+	editFilterView.searchFlags = searchFlags;
+	editFilterView.contextLines = contextLines;
+	const Sci_Line shownLines = EditFilterLinesFrom(0);
+	const Sci_Line iCurLine = SciCall_LineFromPosition(SciCall_GetCurrentPos());
+	if (shownLines != 0 && !SciCall_GetLineVisible(iCurLine)) {
+		// move to first shown line after caret, or last shown line
+		SciCall_GotoLine(SciCall_DocLineFromVisible(SciCall_VisibleFromDocLine(iCurLine)));
+	}
+	EndWaitCursor();
+
+	WCHAR tchShown[32];
+	WCHAR tchTotal[32];
+	FormatNumber(tchShown, shownLines);
+	FormatNumber(tchTotal, SciCall_GetLineCount());
+	ShowNotificationMessage(SC_NOTIFICATIONPOSITION_CENTER, IDS_FILTER_LINES_STATUS, tchShown, tchTotal);
+}
+
+// filter lines appended to the document, e.g. in tail mode.
+void EditFilterLinesAppended(Sci_Line lineCount) noexcept {
+	if (EditIsFilterActive()) {
+		// last line may contain more text
+		EditFilterLinesFrom(lineCount - 1);
+	}
+}
+
+void EditFilterLinesClear() noexcept {
+	EditFilterLinesReset();
+	// rebuild display lines once
+	SciCall_FoldAll(SC_FOLDACTION_EXPAND);
+	SciCall_ScrollCaret();
+}
+
 void EditToggleBookmarkAt(Sci_Position iPos) noexcept {
 	if (iPos < 0) {
 		iPos = SciCall_GetCurrentPos();
@@ -5860,8 +7627,14 @@ void EditBookmarkSelectAll() noexcept {
 		size_t main = 0;
 		size_t selection = 0;
 		Sci_Line minDiff = abs(line - iCurLine);
+		Sci_CommandRecord commands[EditMarkAll_RangeCacheCount];
+		UINT count = 0;
 		while ((line = SciCall_MarkerNext(line + 1, MarkerBitmask_Bookmark)) >= 0) {
-			SciCall_AddSelection(SciCall_PositionFromLine(line), SciCall_PositionFromLine(line + 1));
+			if (count == EditMarkAll_RangeCacheCount) {
+				SciCall_SendCommands(count, commands);
+				count = 0;
+			}
+			commands[count++] = { SCI_ADDSELECTION, static_cast<uptr_t>(SciCall_PositionFromLine(line)), SciCall_PositionFromLine(line + 1) };
 			++selection;
 			const Sci_Line diff = abs(line - iCurLine);
 			if (diff < minDiff) {
@@ -5869,10 +7642,82 @@ void EditBookmarkSelectAll() noexcept {
 				main = selection;
 			}
 		}
+		SciCall_SendCommands(count, commands);
 		SciCall_SetMainSelection(main);
 	}
 }
 
+//=============================================================================
+//
+// EditGetBookmarkedLines()
+//
+// Gathers bookmarked lines with line endings into one buffer, text is copied
+// from both sides of the gap, document and selection are not changed.
+//
+char *EditGetBookmarkedLines(Sci_Position *pcchText, Sci_Line *pLineCount) noexcept {
+	Sci_Position cchText = 0;
+	Sci_Line lineCount = 0;
+	for (Sci_Line line = SciCall_MarkerNext(0, MarkerBitmask_Bookmark); line >= 0; line = SciCall_MarkerNext(line + 1, MarkerBitmask_Bookmark)) {
+		cchText += SciCall_PositionFromLine(line + 1) - SciCall_PositionFromLine(line);
+		++lineCount;
+	}
+	if (lineCount == 0) {
+		return nullptr;
+	}
+
+	char *pszText = static_cast<char *>(NP2HeapAlloc(cchText + 1));
+	if (pszText == nullptr) {
+		return nullptr;
+	}
+
+	Sci_TextSegments segments = { { 0, -1 }, nullptr, 0, nullptr, 0 };
+	SciCall_GetRangeSegments(&segments);
+	const Sci_Position length1 = segments.length1;
+	char *ptr = pszText;
+	for (Sci_Line line = SciCall_MarkerNext(0, MarkerBitmask_Bookmark); line >= 0; line = SciCall_MarkerNext(line + 1, MarkerBitmask_Bookmark)) {
+		Sci_Position start = SciCall_PositionFromLine(line);
+		const Sci_Position end = SciCall_PositionFromLine(line + 1);
+		if (start < length1) {
+			const Sci_Position count = min(end, length1) - start;
+			memcpy(ptr, segments.segment1 + start, count);
+			ptr += count;
+			start += count;
+		}
+		if (start < end) {
+			memcpy(ptr, segments.segment2 + (start - length1), end - start);
+			ptr += end - start;
+		}
+	}
+
+	*pcchText = cchText;
+	*pLineCount = lineCount;
+	return pszText;
+}
+
+// replace all matches inside target with single modification, returns count of replacements.
+static Sci_Position EditReplaceAllInTarget(int searchFlags, const char *szFind2, const char *pszReplace2, BOOL bReplaceRE) noexcept {
+	char *pszEscaped = nullptr;
+	if (!bReplaceRE && (searchFlags & SCFIND_REGEXP)) {
+		// replacement follows search flags, escape literal text (e.g. clipboard) for regex substitution
+		const size_t len = strlen(pszReplace2);
+		pszEscaped = static_cast<char *>(NP2HeapAlloc(2*len + 1));
+		char *p = pszEscaped;
+		for (const char *s = pszReplace2; *s; s++) {
+			if (*s == '\\' || *s == '$') {
+				*p++ = *s;
+			}
+			*p++ = *s;
+		}
+	}
+
+	SciCall_SetSearchFlags(searchFlags);
+	const Sci_Position iCount = SciCall_ReplaceAllInTarget(szFind2, (pszEscaped != nullptr) ? pszEscaped : pszReplace2);
+	if (pszEscaped != nullptr) {
+		NP2HeapFree(pszEscaped);
+	}
+	return iCount;
+}
+
 static void ShwowReplaceCount(Sci_Position iCount) noexcept {
 	if (iCount > 0) {
 		WCHAR tchNum[32];
@@ -5903,50 +7748,19 @@ void EditReplaceAll(HWND hwnd, const EDITFINDREPLACE *lpefr) noexcept {
 	watch.Start();
 #endif
 
-	const bool bRegexStartOfLine = bReplaceRE && (szFind2[0] == '^');
-	Sci_TextToFindFull ttf = { { 0, SciCall_GetLength() }, szFind2, { 0, 0 } };
-	Sci_Position iCount = 0;
-	while (SciCall_FindTextFull(searchFlags, &ttf) >= 0) {
-		++iCount;
-		if (iCount == 1) {
-			SciCall_BeginBatchUpdate();
-		}
-
-		SciCall_SetTargetRange(ttf.chrgText.cpMin, ttf.chrgText.cpMax);
-		const Sci_Position iReplacedLen = SciCall_ReplaceTargetEx(bReplaceRE, -1, pszReplace2);
-
-		ttf.chrg.cpMin = (ttf.chrgText.cpMin + iReplacedLen);
-		// document length change: iReplacedLen - (ttf.chrgText.cpMax - ttf.chrgText.cpMin)
-		ttf.chrg.cpMax += ttf.chrg.cpMin - ttf.chrgText.cpMax;
-
-		if (ttf.chrg.cpMin == ttf.chrg.cpMax) {
-			break;
-		}
-
-		if (ttf.chrgText.cpMin == ttf.chrgText.cpMax && !bRegexStartOfLine) {
-			// move to next line after the replacement.
-			ttf.chrg.cpMin = SciCall_PositionAfter(ttf.chrg.cpMin);
-		}
-
-		if (bRegexStartOfLine) {
-			const Sci_Line iLine = SciCall_LineFromPosition(ttf.chrg.cpMin);
-			const Sci_Position ilPos = SciCall_PositionFromLine(iLine);
-
-			if (ilPos == ttf.chrg.cpMin) {
-				ttf.chrg.cpMin = SciCall_PositionFromLine(iLine + 1);
-			}
-			if (ttf.chrg.cpMin == ttf.chrg.cpMax) {
-				break;
-			}
-		}
-	}
+	EventTraceActivity activity;
+	EventTraceStart(activity, "ReplaceAll", TraceLoggingInt64(SciCall_GetLength(), "Bytes"), TraceLoggingInt32(searchFlags, "Flags"));
+	SciCall_SetTargetRange(0, SciCall_GetLength());
+	SciCall_BeginBatchUpdate();
+	const Sci_Position iCount = EditReplaceAllInTarget(searchFlags, szFind2, pszReplace2, bReplaceRE);
+	SciCall_EndBatchUpdate();
+	EventTraceStop(activity, "ReplaceAll", TraceLoggingInt64(iCount, "Count"));
 
 #if 0
 	watch.Stop();
 	watch.ShowLog("EditReplaceAll() time");
 #endif
-	if (iCount) {
-		SciCall_EndBatchUpdate();
+	if (iCount > 0) {
 		EditEnsureSelectionVisible();
 	}
 
@@ -5977,52 +7791,16 @@ void EditReplaceAllInSelection(HWND hwnd, const EDITFINDREPLACE *lpefr, EditRepl
 	// Show wait cursor...
 	BeginWaitCursor();
 
-	const bool bRegexStartOfLine = bReplaceRE && (szFind2[0] == '^');
-	Sci_TextToFindFull ttf = { { SciCall_GetSelectionStart(), SciCall_GetLength() }, szFind2, { 0, 0 } };
-	Sci_Position iCount = 0;
-	while (SciCall_FindTextFull(searchFlags, &ttf) >= 0) {
-		if (ttf.chrgText.cpMax <= SciCall_GetSelectionEnd()) {
-			++iCount;
-			if (iCount == 1 && (flag & EditReplaceAllFlag_UndoGroup) != 0) {
-				SciCall_BeginBatchUpdate();
-			}
-
-			SciCall_SetTargetRange(ttf.chrgText.cpMin, ttf.chrgText.cpMax);
-			const Sci_Position iReplacedLen = SciCall_ReplaceTargetEx(bReplaceRE, -1, pszReplace2);
-
-			ttf.chrg.cpMin = (ttf.chrgText.cpMin + iReplacedLen);
-			// document length change: iReplacedLen - (ttf.chrgText.cpMax - ttf.chrgText.cpMin)
-			ttf.chrg.cpMax += ttf.chrg.cpMin - ttf.chrgText.cpMax;
-
-			if (ttf.chrg.cpMin == ttf.chrg.cpMax) {
-				break;
-			}
-
-			if (ttf.chrgText.cpMin == ttf.chrgText.cpMax && !bRegexStartOfLine) {
-				// move to next line after the replacement.
-				ttf.chrg.cpMin = SciCall_PositionAfter(ttf.chrg.cpMin);
-			}
-
-			if (bRegexStartOfLine) {
-				const Sci_Line iLine = SciCall_LineFromPosition(ttf.chrg.cpMin);
-				const Sci_Position ilPos = SciCall_PositionFromLine(iLine);
-
-				if (ilPos == ttf.chrg.cpMin) {
-					ttf.chrg.cpMin = SciCall_PositionFromLine(iLine + 1);
-				}
-				if (ttf.chrg.cpMin == ttf.chrg.cpMax) {
-					break;
-				}
-			}
-		} else { // gone across selection, cancel
-			break;
-		}
+	SciCall_SetTargetRange(SciCall_GetSelectionStart(), SciCall_GetSelectionEnd());
+	if ((flag & EditReplaceAllFlag_UndoGroup) != 0) {
+		SciCall_BeginBatchUpdate();
+	}
+	const Sci_Position iCount = EditReplaceAllInTarget(searchFlags, szFind2, pszReplace2, bReplaceRE);
+	if ((flag & EditReplaceAllFlag_UndoGroup) != 0) {
+		SciCall_EndBatchUpdate();
 	}
 
-	if (iCount) {
-		if ((flag & EditReplaceAllFlag_UndoGroup) != 0) {
-			SciCall_EndBatchUpdate();
-		}
+	if (iCount > 0) {
 		const Sci_Position iPos = SciCall_GetTargetEnd();
 		if (SciCall_GetSelectionEnd() < iPos) {
 			Sci_Position iAnchorPos = SciCall_GetAnchor();
@@ -7037,6 +8815,11 @@ char *EditGetStringAroundCaret(LPCSTR delimiters) noexcept {
 
 		return EditGetTextRange(iLineStart, iLineEnd);
 	}
+	if (SciCall_IndicatorValueAt(IndicatorNumber_Hyperlink, iCurrentPos)) {
+		iLineStart = SciCall_IndicatorStart(IndicatorNumber_Hyperlink, iCurrentPos);
+		iLineEnd = SciCall_IndicatorEnd(IndicatorNumber_Hyperlink, iCurrentPos);
+		return EditGetTextRange(iLineStart, iLineEnd);
+	}
 
 	Sci_TextToFindFull ft = { { iCurrentPos, 0 }, delimiters, { 0, 0 } };
 	constexpr int findFlag = SCFIND_REGEXP | SCFIND_POSIX;
@@ -7841,43 +9624,16 @@ void FoldToggleAll(FOLD_ACTION action) noexcept {
 
 void FoldToggleLevel(int lev, FOLD_ACTION action) noexcept {
 	SciCall_ColouriseAll();
-	const Sci_Line lineCount = SciCall_GetLineCount();
-	Sci_Line line = 0;
-
 	SendMessage(hwndEdit, WM_SETREDRAW, FALSE, 0);
 #if 0
 	StopWatch watch;
 	watch.Start();
 #endif
+	int flags = static_cast<int>(action);
 	if (pLexCurrent->lexerAttr & LexerAttr_IndentBasedFolding) {
-		FoldLevelStack levelStack{};
-		++lev;
-		while (line < lineCount) {
-			int level = SciCall_GetFoldLevel(line);
-			if (level & SC_FOLDLEVELHEADERFLAG) {
-				level &= SC_FOLDLEVELNUMBERMASK;
-				levelStack.Push(level);
-				if (lev == levelStack.levelCount) {
-					action = FoldToggleNode(line, action);
-					line = SciCall_GetLastChildEx(line, level);
-				}
-			}
-			++line;
-		}
-	} else {
-		lev += SC_FOLDLEVELBASE;
-		while (line < lineCount) {
-			int level = SciCall_GetFoldLevel(line);
-			if (level & SC_FOLDLEVELHEADERFLAG) {
-				level &= SC_FOLDLEVELNUMBERMASK;
-				if (lev == level) {
-					action = FoldToggleNode(line, action);
-					line = SciCall_GetLastChildEx(line, level);
-				}
-			}
-			++line;
-		}
+		flags |= SC_FOLDACTION_NESTED_LEVEL;
 	}
+	SciCall_FoldAllLevel(lev, flags);
 
 #if 0
 	watch.Stop();
@@ -8187,3 +9943,454 @@ void EditGotoBlock(int menu) noexcept {
 		EditJumpTo(iLine + 1, column + 1);
 	}
 }
+
+//=============================================================================
+//
+// Symbol outline
+//
+// symbols are fold header lines selected with default fold settings of current scheme,
+// index is updated for edited lines when requested.
+#define OUTLINE_MIN_CAPACITY		256U
+// unchanged symbols after edited lines before rescan stops
+#define OUTLINE_CONVERGE_COUNT		2
+
+namespace {
+
+struct OutlineIndex {
+	LPCEDITLEXER pLex;
+	Sci_Line *lines;
+	Sci_Line *scratch;
+	UINT count;
+	UINT capacity;
+	UINT scratchCapacity;
+	bool valid;
+	Sci_Line dirtyFirst;	// -1 for no edit since last update
+	Sci_Line dirtyLast;
+
+	void Reset() noexcept;
+	UINT LowerBound(Sci_Line line) const noexcept;
+	void Notify(Sci_Position position, Sci_Line linesAdded) noexcept;
+	bool Rescan(Sci_Line first, Sci_Line last, UINT *next) noexcept;
+	void Update() noexcept;
+};
+
+OutlineIndex outlineIndex;
+
+bool Outline_Reserve(Sci_Line *&buffer, UINT &capacity, UINT size) noexcept {
+	if (size <= capacity) {
+		return true;
+	}
+	const UINT newCapacity = max(max(size, capacity*2), OUTLINE_MIN_CAPACITY);
+	Sci_Line *newBuffer = static_cast<Sci_Line *>(buffer ? NP2HeapReAlloc(buffer, newCapacity*sizeof(Sci_Line)) : NP2HeapAlloc(newCapacity*sizeof(Sci_Line)));
+	if (newBuffer == nullptr) {
+		return false;
+	}
+	buffer = newBuffer;
+	capacity = newCapacity;
+	return true;
+}
+
+bool Outline_IsSymbol(Sci_Line line) noexcept {
+	const int level = SciCall_GetFoldLevel(line);
+	if (!(level & SC_FOLDLEVELHEADERFLAG)) {
+		return false;
+	}
+	const int lev = (level & SC_FOLDLEVELNUMBERMASK) - SC_FOLDLEVELBASE;
+	const int style = pLexCurrent->defaultFoldIgnoreInner;
+	if (style == 0) {
+		// no function definition style, use top level blocks
+		return lev == 0;
+	}
+	if (EditIsLineContainsStyle(line, style)) {
+		return true;
+	}
+	if (pLexCurrent->lexerAttr & LexerAttr_IndentBasedFolding) {
+		return false;
+	}
+	// outer levels of default folding: namespace, class, etc.
+	const UINT levelMask = pLexCurrent->defaultFoldLevelMask;
+	return lev < np2_bsr(levelMask) && (levelMask & (1U << lev)) != 0;
+}
+
+void OutlineIndex::Reset() noexcept {
+	if (lines) {
+		NP2HeapFree(lines);
+	}
+	if (scratch) {
+		NP2HeapFree(scratch);
+	}
+	memset(this, 0, sizeof(OutlineIndex));
+	dirtyFirst = -1;
+}
+
+UINT OutlineIndex::LowerBound(Sci_Line line) const noexcept {
+	UINT low = 0;
+	UINT high = count;
+	while (low < high) {
+		const UINT mid = (low + high) / 2;
+		if (lines[mid] < line) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+void OutlineIndex::Notify(Sci_Position position, Sci_Line linesAdded) noexcept {
+	if (!valid) {
+		return;
+	}
+	const Sci_Line line = SciCall_LineFromPosition(position);
+	if (linesAdded != 0) {
+		const UINT start = LowerBound(line + 1);
+		UINT index = start;
+		if (linesAdded < 0) {
+			// lines after line are joined into it
+			const Sci_Line removed = line - linesAdded;
+			while (index < count && lines[index] <= removed) {
+				++index;
+			}
+		}
+		for (UINT i = index; i < count; i++) {
+			lines[i - (index - start)] = lines[i] + linesAdded;
+		}
+		count -= index - start;
+		if (dirtyFirst >= 0 && dirtyLast > line) {
+			dirtyLast = max(dirtyLast + linesAdded, line);
+		}
+	}
+	const Sci_Line last = line + max<Sci_Line>(linesAdded, 0);
+	if (dirtyFirst < 0) {
+		dirtyFirst = line;
+		dirtyLast = last;
+	} else {
+		dirtyFirst = min(dirtyFirst, line);
+		dirtyLast = max(dirtyLast, last);
+	}
+}
+
+// replace symbols in lines [first, last], returns whether they are changed.
+bool OutlineIndex::Rescan(Sci_Line first, Sci_Line last, UINT *next) noexcept {
+	UINT found = 0;
+	for (Sci_Line line = first; line <= last; line++) {
+		if (Outline_IsSymbol(line)) {
+			if (!Outline_Reserve(scratch, scratchCapacity, found + 1)) {
+				break;
+			}
+			scratch[found++] = line;
+		}
+	}
+
+	const UINT start = LowerBound(first);
+	const UINT end = LowerBound(last + 1);
+	*next = start + found;
+	const UINT old = end - start;
+	if (old == found && (found == 0 || memcmp(lines + start, scratch, found*sizeof(Sci_Line)) == 0)) {
+		return false;
+	}
+	if (!Outline_Reserve(lines, capacity, count - old + found)) {
+		*next = end;
+		return false;
+	}
+	memmove(lines + start + found, lines + end, (count - end)*sizeof(Sci_Line));
+	memcpy(lines + start, scratch, found*sizeof(Sci_Line));
+	count = count - old + found;
+	return true;
+}
+
+void OutlineIndex::Update() noexcept {
+	if (pLex != pLexCurrent) {
+		Reset();
+	}
+	const Sci_Line lineCount = SciCall_GetLineCount();
+	// symbols are detected from fold levels and styles
+	SciCall_EnsureStyledTo(SciCall_GetLength());
+	UINT next;
+	if (!valid) {
+		count = 0;
+		Rescan(0, lineCount - 1, &next);
+		pLex = pLexCurrent;
+		valid = true;
+	} else if (dirtyFirst >= 0) {
+		Sci_Line last = min(dirtyLast, lineCount - 1);
+		Rescan(min(dirtyFirst, last), last, &next);
+		// lexer state and fold level changes may propagate after edited lines,
+		// rescan until some stored symbols are found unchanged.
+		int unchanged = 0;
+		while (last + 1 < lineCount && unchanged < OUTLINE_CONVERGE_COUNT) {
+			const Sci_Line first = last + 1;
+			last = (next < count) ? lines[next] : (lineCount - 1);
+			if (Rescan(first, last, &next)) {
+				unchanged = 0;
+			} else {
+				++unchanged;
+			}
+		}
+	}
+	dirtyFirst = -1;
+}
+
+}
+
+void EditOutlineReset() noexcept {
+	outlineIndex.Reset();
+}
+
+void EditOutlineNotify(Sci_Position position, Sci_Line linesAdded) noexcept {
+	outlineIndex.Notify(position, linesAdded);
+}
+
+const Sci_Line *EditOutlineUpdate(UINT *count) noexcept {
+	outlineIndex.Update();
+	*count = outlineIndex.count;
+	return outlineIndex.lines;
+}
+
+//=============================================================================
+//
+// Hyperlink
+//
+// links in visible lines are marked with indicator, each line is scanned once
+// after it becomes visible or is edited.
+#define HYPERLINK_RANGE_CACHE_COUNT		128
+// edited lines above this count (relative to lines on screen) are dropped instead of rescanned
+#define HYPERLINK_MAX_DIRTY_SCREENS		4
+
+extern bool bHighlightHyperlink;
+
+namespace {
+
+struct HyperlinkIndex {
+	Sci_Line scanFirst;		// links in lines [scanFirst, scanLast) are marked
+	Sci_Line scanLast;
+	Sci_Line dirtyFirst;	// -1 for no edit since last update
+	Sci_Line dirtyLast;
+
+	void Reset() noexcept;
+	void Notify(Sci_Position position, Sci_Line linesAdded) noexcept;
+	void Update() noexcept;
+};
+
+HyperlinkIndex hyperlinkIndex;
+
+constexpr bool IsHyperlinkChar(uint8_t ch) noexcept {
+	// printable characters except quotes and angle brackets
+	return ch > ' ' && ch != '\"' && ch != '\'' && ch != '`' && ch != '<' && ch != '>' && ch != 0x7f;
+}
+
+// returns position of next ':' or 'w' (ignore case), which may start or be inside a link.
+size_t Hyperlink_NextCandidate(const char *text, size_t pos, size_t length) noexcept {
+#if NP2_USE_SSE2 || NP2_USE_AVX2
+	const __m128i vectColon = _mm_set1_epi8(':');
+	const __m128i vectW = _mm_set1_epi8('w');
+	const __m128i vectCase = _mm_set1_epi8(0x20);
+	while (pos + sizeof(__m128i) <= length) {
+		// ':' is unchanged by setting the case bit
+		const __m128i chunk = _mm_or_si128(vectCase, _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos)));
+		const uint32_t mask = mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vectColon), _mm_cmpeq_epi8(chunk, vectW)));
+		if (mask) {
+			return pos + np2_ctz(mask);
+		}
+		pos += sizeof(__m128i);
+	}
+#endif
+	while (pos < length) {
+		const uint8_t ch = text[pos] | 0x20;
+		if (ch == ':' || ch == 'w') {
+			break;
+		}
+		++pos;
+	}
+	return pos;
+}
+
+// match scheme://, www. or drive letter around position of candidate character
+bool Hyperlink_Match(const char *text, size_t pos, size_t length, size_t *linkStart, size_t *linkEnd) noexcept {
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(text);
+	size_t start = pos;
+	size_t minEnd;
+	if (ptr[pos] == ':') {
+		if (pos + 2 < length && ptr[pos + 1] == '/' && ptr[pos + 2] == '/') {
+			while (start != 0 && IsSchemeNameChar(ptr[start - 1])) {
+				--start;
+			}
+			while (start < pos && !IsAlpha(ptr[start])) {
+				++start;
+			}
+		}
+		minEnd = pos + 3;
+		if (pos - start < 2) {
+			// drive letter: C:\ or C:/
+			if (pos == 0 || !IsAlpha(ptr[pos - 1]) || (pos >= 2 && IsAlphaNumeric(ptr[pos - 2]))
+				|| pos + 1 >= length || (ptr[pos + 1] != '\\' && ptr[pos + 1] != '/')) {
+				return false;
+			}
+			start = pos - 1;
+			minEnd = pos + 2;
+		}
+	} else {
+		if (pos + 4 >= length || (pos != 0 && (IsSchemeNameChar(ptr[pos - 1]) || ptr[pos - 1] == '/'))
+			|| (ptr[pos + 1] | 0x20) != 'w' || (ptr[pos + 2] | 0x20) != 'w' || ptr[pos + 3] != '.'
+			|| !IsAlphaNumeric(ptr[pos + 4])) {
+			return false;
+		}
+		minEnd = pos + 5;
+	}
+
+	size_t end = minEnd;
+	while (end < length && IsHyperlinkChar(ptr[end])) {
+		++end;
+	}
+	// trailing punctuation and unmatched closing bracket belong to surrounding text
+	while (end > minEnd) {
+		const uint8_t ch = ptr[end - 1];
+		if (ch == ')' || ch == ']') {
+			const char *open = static_cast<const char *>(memchr(text + start, (ch == ')') ? '(' : '[', end - start));
+			if (open != nullptr) {
+				break;
+			}
+		} else if (ch != '.' && ch != ',' && ch != ';' && ch != ':' && ch != '!' && ch != '?') {
+			break;
+		}
+		--end;
+	}
+	*linkStart = start;
+	*linkEnd = end;
+	return true;
+}
+
+// mark links in lines [first, last)
+void Hyperlink_ScanLines(Sci_Line first, Sci_Line last) noexcept {
+	const Sci_Position startPos = SciCall_PositionFromLine(first);
+	const Sci_Position endPos = SciCall_PositionFromLine(last);
+	if (startPos >= endPos) {
+		return;
+	}
+
+	const Sci_Position length = endPos - startPos;
+	const char *text = SciCall_GetRangePointer(startPos, length);
+	SciCall_IndicatorClearRange(startPos, length);
+	Sci_Position ranges[HYPERLINK_RANGE_CACHE_COUNT*2];
+	UINT index = 0;
+	size_t pos = 0;
+	while ((pos = Hyperlink_NextCandidate(text, pos, length)) < static_cast<size_t>(length)) {
+		size_t linkStart;
+		size_t linkEnd;
+		if (!Hyperlink_Match(text, pos, length, &linkStart, &linkEnd)) {
+			++pos;
+			continue;
+		}
+		ranges[index] = startPos + static_cast<Sci_Position>(linkStart);
+		ranges[index + 1] = static_cast<Sci_Position>(linkEnd - linkStart);
+		index += 2;
+		if (index == COUNTOF(ranges)) {
+			SciCall_IndicatorFillRanges(index/2, ranges);
+			index = 0;
+		}
+		pos = linkEnd;
+	}
+	if (index != 0) {
+		SciCall_IndicatorFillRanges(index/2, ranges);
+	}
+}
+
+void HyperlinkIndex::Reset() noexcept {
+	scanFirst = 0;
+	scanLast = 0;
+	dirtyFirst = -1;
+	dirtyLast = -1;
+}
+
+void HyperlinkIndex::Notify(Sci_Position position, Sci_Line linesAdded) noexcept {
+	if (scanFirst >= scanLast) {
+		return;
+	}
+	const Sci_Line line = SciCall_LineFromPosition(position);
+	if (line >= scanLast) {
+		return;
+	}
+	if (line < scanFirst) {
+		if (linesAdded != 0) {
+			// lines after line are joined into it when linesAdded is negative
+			scanFirst = max(scanFirst + linesAdded, line + 1);
+			scanLast = max(scanLast + linesAdded, scanFirst);
+			if (dirtyFirst >= 0) {
+				dirtyFirst = max(dirtyFirst + linesAdded, scanFirst);
+				dirtyLast = max(dirtyLast + linesAdded, dirtyFirst);
+			}
+		}
+		return;
+	}
+	if (linesAdded != 0) {
+		scanLast = max(scanLast + linesAdded, line + 1);
+		if (dirtyFirst >= 0 && dirtyLast > line) {
+			dirtyLast = max(dirtyLast + linesAdded, line);
+		}
+	}
+	const Sci_Line last = line + max<Sci_Line>(linesAdded, 0);
+	if (dirtyFirst < 0) {
+		dirtyFirst = line;
+		dirtyLast = last;
+	} else {
+		dirtyFirst = min(dirtyFirst, line);
+		dirtyLast = max(dirtyLast, last);
+	}
+}
+
+void HyperlinkIndex::Update() noexcept {
+	const Sci_Line lineCount = SciCall_GetLineCount();
+	const Sci_Line linesOnScreen = SciCall_LinesOnScreen();
+	const Sci_Line visibleLine = SciCall_GetFirstVisibleLine();
+	const Sci_Line first = SciCall_DocLineFromVisible(visibleLine);
+	const Sci_Line last = min(SciCall_DocLineFromVisible(visibleLine + linesOnScreen) + 1, lineCount);
+	scanLast = min(scanLast, lineCount);
+
+	SciCall_SetIndicatorCurrent(IndicatorNumber_Hyperlink);
+	if (dirtyFirst >= 0) {
+		const Sci_Line dirtyEnd = min(dirtyLast + 1, scanLast);
+		if (dirtyFirst < dirtyEnd) {
+			if (dirtyEnd - dirtyFirst <= HYPERLINK_MAX_DIRTY_SCREENS*linesOnScreen) {
+				Hyperlink_ScanLines(dirtyFirst, dirtyEnd);
+			} else {
+				// huge edit, the part inside visible lines is rescanned below
+				scanLast = max(dirtyFirst, scanFirst);
+			}
+		}
+		dirtyFirst = -1;
+	}
+
+	if (scanFirst >= scanLast || last < scanFirst || first > scanLast) {
+		// no overlap with scanned lines
+		Hyperlink_ScanLines(first, last);
+		scanFirst = first;
+		scanLast = last;
+	} else {
+		if (first < scanFirst) {
+			Hyperlink_ScanLines(first, scanFirst);
+			scanFirst = first;
+		}
+		if (last > scanLast) {
+			Hyperlink_ScanLines(scanLast, last);
+			scanLast = last;
+		}
+	}
+}
+
+}
+
+void EditHyperlinkReset() noexcept {
+	hyperlinkIndex.Reset();
+}
+
+void EditHyperlinkNotify(Sci_Position position, Sci_Line linesAdded) noexcept {
+	if (bHighlightHyperlink) {
+		hyperlinkIndex.Notify(position, linesAdded);
+	}
+}
+
+void EditHyperlinkUpdate() noexcept {
+	if (bHighlightHyperlink) {
+		hyperlinkIndex.Update();
+	}
+}
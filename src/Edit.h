@@ -117,7 +117,7 @@ enum {
 
 void	Edit_ReleaseResources() noexcept;
 void	EditCreate(HWND hwndParent) noexcept;
-void	EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept;
+bool	EditSetNewText(LPCSTR lpstrText, DWORD cbText, size_t lineCount) noexcept;
 
 static inline void EditSetEmptyText() noexcept{
 	EditSetNewText("", 0, 1);
@@ -142,7 +142,10 @@ constexpr int GetSettingsEOLMode(int mode) noexcept {
 struct EditFileIOStatus;
 void 	EditDetectEOLMode(LPCSTR lpData, DWORD cbData, EditFileIOStatus &status) noexcept;
 bool	EditLoadFile(LPWSTR pszFile, EditFileIOStatus &status) noexcept;
+bool	EditReadFileSnapshot(LPCWSTR pszFile, EditFileSnapshot &snapshot) noexcept;
+bool	EditWriteFileSnapshot(const EditFileSnapshot &snapshot) noexcept;
 bool	EditSaveFile(HWND hwnd, LPCWSTR pszFile, int saveFlag, EditFileIOStatus &status) noexcept;
+void	EditSavedFileNotify(Sci_Position position) noexcept;
 
 void	EditReplaceMainSelection(Sci_Position cchText, LPCSTR pszText) noexcept;
 
@@ -157,6 +160,7 @@ void	EditCharacterToHex() noexcept;
 void	EditHexToCharacter() noexcept;
 void	EditShowHex() noexcept;
 void	EditShowCharacterInfo() noexcept;
+void	EditShowTextStatistics() noexcept;
 
 enum Base64EncodingFlag {
 	Base64EncodingFlag_Default,
@@ -177,13 +181,14 @@ void	EditModifyLines(LPCWSTR pwszPrefix, LPCWSTR pwszAppend, bool skipEmptyLine)
 void	EditAlignText(EditAlignMode nMode) noexcept;
 void	EditEncloseSelection(LPCWSTR pwszOpen, LPCWSTR pwszClose) noexcept;
 void	EditToggleLineComments(LPCWSTR pwszComment, int commentFlag) noexcept;
-void	EditPadWithSpaces(bool bSkipEmpty, bool bNoUndoGroup) noexcept;
+void	EditPadWithSpaces(bool bSkipEmpty) noexcept;
 void	EditStripFirstCharacter() noexcept;
 void	EditStripLastCharacter() noexcept;
 void	EditStripTrailingBlanks(HWND hwnd, bool bIgnoreSelection) noexcept;
 void	EditStripLeadingBlanks(HWND hwnd, bool bIgnoreSelection) noexcept;
 void	EditCompressSpaces() noexcept;
 void	EditRemoveBlankLines(bool bMerge) noexcept;
+void	EditRemoveDuplicateLines(bool bMerge) noexcept;
 void	EditWrapToColumn(int nColumn/*, int nTabWidth*/) noexcept;
 void	EditJoinLinesEx() noexcept;
 void	EditSortLines(EditSortFlag iSortFlags) noexcept;
@@ -193,6 +198,8 @@ void	EditSelectEx(Sci_Position iAnchorPos, Sci_Position iCurrentPos) noexcept;
 void	EditFixPositions() noexcept;
 void	EditEnsureSelectionVisible() noexcept;
 void	EditEnsureConsistentLineEndings() noexcept;
+int		EditGetChangeHistoryOption() noexcept;
+void	EditFixModifiedLines(bool fixLineEndings, bool stripBlanks) noexcept;
 void	EditGetExcerpt(LPWSTR lpszExcerpt, DWORD cchExcerpt) noexcept;
 
 void	EditSelectWord() noexcept;
@@ -202,6 +209,11 @@ HWND	EditFindReplaceDlg(HWND hwnd, EDITFINDREPLACE *lpefr, bool bReplace) noexce
 void	EditFindNext(const EDITFINDREPLACE *lpefr, bool fExtendSelection) noexcept;
 void	EditFindPrev(const EDITFINDREPLACE *lpefr, bool fExtendSelection) noexcept;
 void	EditFindAll(const EDITFINDREPLACE *lpefr, bool selectAll) noexcept;
+bool	EditIsFilterActive() noexcept;
+void	EditFilterLinesReset() noexcept;
+void	EditFilterLines(const EDITFINDREPLACE *lpefr, Sci_Line contextLines) noexcept;
+void	EditFilterLinesAppended(Sci_Line lineCount) noexcept;
+void	EditFilterLinesClear() noexcept;
 void	EditReplace(HWND hwnd, const EDITFINDREPLACE *lpefr) noexcept;
 enum EditReplaceAllFlag {
 	EditReplaceAllFlag_None,
@@ -235,17 +247,25 @@ void EditOpenSelection(OpenSelectionType type);
 
 // in Bridge.cpp
 bool	EditPrint(HWND hwnd, LPCWSTR pszDocTitle, BOOL bDefault) noexcept;
+void	EditPrintReset() noexcept;
 void	EditPrintSetup(HWND hwnd) noexcept;
 void	EditDumpDocumentStyledText(LPCWSTR lpszFile);
 void	EditFormatCode(int menu) noexcept;
 
 enum {
 	MarkerNumber_Bookmark = 0,
+	// line background of compare result
+	MarkerNumber_DiffAdded = 1,
+	MarkerNumber_DiffDeleted = 2,
+	MarkerNumber_DiffChanged = 3,
+	MarkerNumber_DiffGap = 4,
 
 	// [0, INDICATOR_CONTAINER) are reserved for lexer.
 	IndicatorNumber_MarkOccurrence = INDICATOR_CONTAINER + 0,
 	IndicatorNumber_MatchBrace = INDICATOR_CONTAINER + 1,
 	IndicatorNumber_MatchBraceError = INDICATOR_CONTAINER + 2,
+	IndicatorNumber_Hyperlink = INDICATOR_CONTAINER + 3,
+	IndicatorNumber_DiffChange = INDICATOR_CONTAINER + 4,
 	// [INDICATOR_IME, INDICATOR_IME_MAX] are reserved for IME.
 
 	MarginNumber_LineNumber = 0,
@@ -253,8 +273,19 @@ enum {
 	MarginNumber_CodeFolding = 2,
 
 	MarkerBitmask_Bookmark = 1 << MarkerNumber_Bookmark,
+	MarkerBitmask_Diff = (1 << MarkerNumber_DiffAdded) | (1 << MarkerNumber_DiffDeleted)
+		| (1 << MarkerNumber_DiffChanged) | (1 << MarkerNumber_DiffGap),
 };
 
+// in EditCompare.cpp
+void	EditCompareWithFile(HWND hwnd) noexcept;
+void	EditCompareSelections() noexcept;
+bool	EditCompareCanExport() noexcept;
+void	EditCompareExportDiff(HWND hwnd) noexcept;
+// returns line of next or previous difference, or -1 when not found
+Sci_Line EditCompareFindDifference(bool next) noexcept;
+void	EditCompareClear() noexcept;
+
 enum {
 	MarkOccurrences_None = 0,
 	MarkOccurrences_Enable = 1,
@@ -276,6 +307,7 @@ struct EditMarkAll {
 	Sci_Position lastMatchPos;	// last matching position
 	Sci_Position prevStopPos;	// previous stop position
 	Sci_Line prevBookmarkLine;	// previous bookmark line
+	Sci_Position visibleStart;	// start of visible range marked first, background search wraps around to it
 	StopWatch watch;			// used to dynamic compute increment size
 
 	void Reset(int findFlag, Sci_Position iSelCount, LPSTR text) noexcept;
@@ -283,6 +315,9 @@ struct EditMarkAll {
 		Reset(0, 0, nullptr);
 	}
 	void Start(BOOL bChanged, int findFlag, Sci_Position iSelCount, LPSTR text) noexcept;
+	bool FindAll() noexcept;
+	void MarkVisible() noexcept;
+	Sci_Position MarkRange(Sci_Position iStartPos, Sci_Position iMaxLength, HANDLE timer) noexcept;
 	void Continue(HANDLE timer) noexcept;
 	void Stop() noexcept;
 	void MarkAll(BOOL bChanged, int option) noexcept;
@@ -290,6 +325,7 @@ struct EditMarkAll {
 
 void EditToggleBookmarkAt(Sci_Position iPos) noexcept;
 void EditBookmarkSelectAll() noexcept;
+char *EditGetBookmarkedLines(Sci_Position *pcchText, Sci_Line *pLineCount) noexcept;
 
 // auto completion fill-up characters
 #define MAX_AUTO_COMPLETION_FILLUP_LENGTH	32		// Only 32 ASCII punctuation
@@ -361,6 +397,8 @@ enum {
 	AutoCompletionOption_ScanWordsInDocument = 4,
 	AutoCompletionOption_OnlyWordsInDocument = 8,
 	AutoCompletionOption_EnglishIMEModeOnly = 16,
+	AutoCompletionOption_FuzzyMatch = 32,
+	AutoCompletionOption_ScanProjectFiles = 64,
 	AutoCompletionOption_Default = 7,
 };
 
@@ -395,6 +433,16 @@ void	EditCompleteUpdateConfig() noexcept;
 bool	IsDocWordChar(uint32_t ch) noexcept;
 bool	IsAutoCompletionWordCharacter(uint32_t ch) noexcept;
 void	EditCompleteWord(int iCondition, bool autoInsert) noexcept;
+extern bool autoCompletePending;
+void	EditCompleteWordOnTyping() noexcept;
+void	EditCompleteWordContinue(HANDLE timer) noexcept;
+// document word index, updated from SCN_MODIFIED
+extern bool docWordIndexPending;
+void	EditWordIndexReset() noexcept;
+void	EditWordIndexContinue(HANDLE timer) noexcept;
+void	EditWordIndexNotify(int modificationType, Sci_Position position, Sci_Position length, Sci_Line linesAdded) noexcept;
+void	EditProjectWordsInvalidate() noexcept;
+void	EditProjectWordsRelease() noexcept;
 bool	EditIsOpenBraceMatched(Sci_Position pos, Sci_Position startPos) noexcept;
 void	EditAutoCloseBraceQuote(int ch, AutoInsertCharacter what) noexcept;
 void	EditAutoCloseXMLTag() noexcept;
@@ -600,6 +648,10 @@ constexpr BOOL Encoding_HasBOM(int iEncoding) noexcept {
 		|| iEncoding == CPI_UTF8SIGN) ? iEncoding : FALSE;
 }
 
+size_t UTF8LengthFromUTF16(LPCWSTR pszTextW, size_t cchTextW, bool reverse) noexcept;
+size_t UTF16ToUTF8(LPCWSTR pszTextW, size_t cchTextW, bool reverse, char *lpData) noexcept;
+size_t UTF16LengthFromUTF8(const char *lpData, size_t cbData) noexcept;
+size_t UTF8ToUTF16(const char *lpData, size_t cbData, bool reverse, LPWSTR pszTextW) noexcept;
 LPSTR RecodeAsUTF8(LPSTR lpData, DWORD *cbData, UINT codePage, DWORD flags) noexcept;
 int EditDetermineEncoding(LPCWSTR pszFile, char *lpData, DWORD cbData, int *encodingFlag) noexcept;
 bool IsStringCaseSensitiveW(LPCWSTR pszTextW) noexcept;
@@ -673,6 +725,14 @@ void FoldToggleDefault(FOLD_ACTION action) noexcept;
 void FoldClickAt(Sci_Position pos, int mode) noexcept;
 void FoldAltArrow(int key, int mode) noexcept;
 void EditGotoBlock(int menu) noexcept;
+void EditOutlineReset() noexcept;
+void EditOutlineNotify(Sci_Position position, Sci_Line linesAdded) noexcept;
+// returns sorted lines of symbols in current document
+const Sci_Line *EditOutlineUpdate(UINT *count) noexcept;
+void EditHyperlinkReset() noexcept;
+void EditHyperlinkNotify(Sci_Position position, Sci_Line linesAdded) noexcept;
+// mark links in visible lines which are not yet scanned
+void EditHyperlinkUpdate() noexcept;
 
 enum SelectOption {
 	SelectOption_None = 0,
@@ -22,6 +22,9 @@
 #define NP2_AUTOC_MAX_WORD_LENGTH	(128 - 3 - 1)	// SP + '(' + ')' + '\0'
 #define NP2_AUTOC_WORD_BUFFER_SIZE	128
 #define NP2_AUTOC_INIT_BUFFER_SIZE	(4096)
+#define NP2_AUTOC_INIT_TABLE_SIZE	256		// power of 2
+#define NP2_AUTOC_FUZZY_MIN_ROOT_LENGTH	2
+#define NP2_AUTOC_FUZZY_MAX_ITEM_COUNT	100
 
 // optimization for small string
 template <size_t StackSize = 32>
@@ -57,18 +60,17 @@ struct WordListBuffer {
 
 struct WordNode;
 struct WordList {
-	int (__cdecl *WL_strcmp)(LPCSTR, LPCSTR);
 	int (__cdecl *WL_strncmp)(LPCSTR, LPCSTR, size_t);
 #if NP2_AUTOC_CACHE_SORT_KEY
 	uint32_t (*WL_SortKeyFunc)(const void *, uint32_t);
 #endif
 
-	WordNode *pListHead;
+	WordNode **pTable;
+	UINT tableSize;
 	LPCSTR pWordStart;
 	UINT iStartLen;
 #if NP2_AUTOC_CACHE_SORT_KEY
 	UINT startSortKey;
-	bool bIgnoreCase;
 #endif
 	UINT nWordCount;
 	UINT nTotalLen;
@@ -81,6 +83,7 @@ struct WordList {
 	void Free() const noexcept;
 	char *GetList() const noexcept;
 	void AddBuffer() noexcept;
+	void GrowTable() noexcept;
 	void AddWord(LPCSTR pWord, UINT len) noexcept;
 	void UpdateRoot(LPCSTR pRoot, UINT iRootLen) noexcept;
 	bool StartsWith(LPCSTR pWord) const noexcept;
@@ -152,141 +155,95 @@ uint32_t WordList_SortKeyCase(const void *pWord, uint32_t len) noexcept {
 }
 #endif
 
-// Tree
+// Hash set
 struct WordNode {
-	union {
-		WordNode *link[2];
-		struct {
-			WordNode *left;
-			WordNode *right;
-		};
-	};
 #if NP2_AUTOC_USE_WORD_POINTER
 	char *word;
 #endif
+	uint32_t hash;
 #if NP2_AUTOC_CACHE_SORT_KEY
 	UINT sortKey;
 #endif
 	UINT len;
-	UINT level;
 };
 
-#define NP2_TREE_HEIGHT_LIMIT	32
 // store word right after the node as most word are short.
 #define WordNode_GetWord(node)		(reinterpret_cast<char *>(node) + sizeof(WordNode))
-// TODO: since the tree is sorted, nodes greater than some level can be deleted to reduce total words.
-// or only limit word count in WordList::GetList().
-
-// Andersson Tree, source from https://www.eternallyconfuzzled.com/tuts/datastructures/jsw_tut_andersson.aspx
-// see also https://en.wikipedia.org/wiki/AA_tree
-#define aa_tree_skew(t) \
-	if ((t)->level && (t)->left && (t)->level == (t)->left->level) {\
-		WordNode *save = (t)->left;					\
-		(t)->left = save->right;							\
-		save->right = (t);									\
-		(t) = save;											\
-	}
-#define aa_tree_split(t) \
-	if ((t)->level && (t)->right && (t)->right->right && (t)->level == (t)->right->right->level) {\
-		WordNode *save = (t)->right;					\
-		(t)->right = save->left;							\
-		save->left = (t);									\
-		(t) = save;											\
-		++(t)->level;										\
+
+// words are appended into block buffers and found with open addressing hash table,
+// then sorted once in WordList::GetList().
+static inline uint32_t WordList_Hash(LPCSTR pWord, UINT len) noexcept {
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (UINT i = 0; i < len; i++) {
+		hash = (hash ^ static_cast<uint8_t>(pWord[i])) * 16777619U;
 	}
+	return hash;
+}
 
 #define WordList_AddNode()	(reinterpret_cast<WordNode *>(reinterpret_cast<char *>(buffer) + offset))
 void WordList::AddBuffer() noexcept {
-	WordListBuffer *block = static_cast<WordListBuffer *>(NP2HeapAlloc(capacity));
+	WordListBuffer *block = static_cast<WordListBuffer *>(NP2HeapAllocTag(capacity, HeapTag_AutoCompletion));
 	block->next = buffer;
 	offset = NP2_align_up(sizeof(WordListBuffer), alignof(WordNode));
 	buffer = block;
 }
 
-void WordList::AddWord(LPCSTR pWord, UINT len) noexcept {
-	WordNode *root = pListHead;
-#if NP2_AUTOC_CACHE_SORT_KEY
-	const UINT sortKey = (iStartLen > NP2_AUTOC_SORT_KEY_LENGTH) ? 0 : WL_SortKeyFunc(pWord, len);
-#endif
-	if (root == nullptr) {
-		WordNode *node = WordList_AddNode();
-		char *word = WordNode_GetWord(node);
-		memcpy(word, pWord, len);
-#if NP2_AUTOC_USE_WORD_POINTER
-		node->word = word;
-#endif
-#if NP2_AUTOC_CACHE_SORT_KEY
-		node->sortKey = sortKey;
-#endif
-		node->len = len;
-		node->level = 1;
-		root = node;
-	} else {
-		WordNode *iter = root;
-		WordNode *path[NP2_TREE_HEIGHT_LIMIT]{};
-		int top = 0;
-		int dir;
-
-		// find a spot and save the path
-		for (;;) {
-			path[top++] = iter;
-#if NP2_AUTOC_CACHE_SORT_KEY
-			dir = static_cast<int>(iter->sortKey - sortKey);
-			if (dir == 0 && (len > NP2_AUTOC_SORT_KEY_LENGTH || iter->len > NP2_AUTOC_SORT_KEY_LENGTH || bIgnoreCase)) {
-				dir = WL_strcmp(WordNode_GetWord(iter), pWord);
-			}
-#else
-			dir = WL_strcmp(WordNode_GetWord(iter), pWord);
-#endif
-			if (dir == 0) {
-				return;
-			}
-			dir = dir < 0;
-			if (iter->link[dir] == nullptr) {
-				break;
+void WordList::GrowTable() noexcept {
+	const UINT size = tableSize*2;
+	WordNode **table = static_cast<WordNode **>(NP2HeapAllocTag(size*sizeof(WordNode *), HeapTag_AutoCompletion));
+	for (UINT i = 0; i < tableSize; i++) {
+		WordNode *node = pTable[i];
+		if (node) {
+			UINT index = node->hash & (size - 1);
+			while (table[index]) {
+				index = (index + 1) & (size - 1);
 			}
-			iter = iter->link[dir];
+			table[index] = node;
 		}
+	}
+	NP2HeapFree(pTable);
+	pTable = table;
+	tableSize = size;
+}
 
-		if (capacity < offset + len + 1 + sizeof(WordNode)) {
-			capacity <<= 1;
-			AddBuffer();
+void WordList::AddWord(LPCSTR pWord, UINT len) noexcept {
+	const uint32_t hash = WordList_Hash(pWord, len);
+	UINT index = hash & (tableSize - 1);
+	WordNode *iter;
+	while ((iter = pTable[index]) != nullptr) {
+		if (iter->hash == hash && iter->len == len && memcmp(WordNode_GetWord(iter), pWord, len) == 0) {
+			return;
 		}
+		index = (index + 1) & (tableSize - 1);
+	}
+
+	if (capacity < offset + len + 1 + sizeof(WordNode)) {
+		capacity <<= 1;
+		AddBuffer();
+	}
 
-		WordNode *node = WordList_AddNode();
-		char *word = WordNode_GetWord(node);
-		memcpy(word, pWord, len);
+	WordNode *node = WordList_AddNode();
+	char *word = WordNode_GetWord(node);
+	memcpy(word, pWord, len);
+	word[len] = '\0';
 #if NP2_AUTOC_USE_WORD_POINTER
-		node->word = word;
+	node->word = word;
 #endif
+	node->hash = hash;
 #if NP2_AUTOC_CACHE_SORT_KEY
-		node->sortKey = sortKey;
+	node->sortKey = (iStartLen > NP2_AUTOC_SORT_KEY_LENGTH) ? 0 : WL_SortKeyFunc(pWord, len);
 #endif
-		node->len = len;
-		node->level = 1;
-		iter->link[dir] = node;
-
-		// walk back and rebalance
-		while (--top >= 0) {
-			// which child?
-			if (top != 0) {
-				dir = path[top - 1]->right == path[top];
-			}
-			aa_tree_skew(path[top]);
-			aa_tree_split(path[top]);
-			// fix the parent
-			if (top != 0) {
-				path[top - 1]->link[dir] = path[top];
-			} else {
-				root = path[top];
-			}
-		}
-	}
+	node->len = len;
+	pTable[index] = node;
 
-	pListHead = root;
 	nWordCount++;
 	nTotalLen += len + 1;
 	offset += NP2_align_up(len + 1 + sizeof(WordNode), alignof(WordNode));
+	// keep load factor below 50%
+	if (nWordCount*2 > tableSize) {
+		GrowTable();
+	}
 }
 
 void WordList::Free() const noexcept {
@@ -296,27 +253,53 @@ void WordList::Free() const noexcept {
 		NP2HeapFree(block);
 		block = next;
 	}
+	NP2HeapFree(pTable);
 }
 
-char* WordList::GetList() const noexcept {
-	WordNode *root = pListHead;
-	WordNode *path[NP2_TREE_HEIGHT_LIMIT]{};
-	int top = 0;
-	char *buf = static_cast<char *>(NP2HeapAlloc(nTotalLen + 1));// additional separator
-	char * const pList = buf;
+struct WordSortItem {
+#if NP2_AUTOC_CACHE_SORT_KEY
+	UINT sortKey;
+#endif
+	UINT len;
+	LPCSTR word;
+};
 
-	while (root || top > 0) {
-		if (root) {
-			path[top++] = root;
-			root = root->left;
-		} else {
-			root = path[--top];
-			memcpy(buf, WordNode_GetWord(root), root->len);
-			buf += root->len;
-			*buf++ = '\n'; // the separator char
-			root = root->right;
+static int __cdecl CmpWordSortItem(const void *p1, const void *p2) noexcept {
+	const WordSortItem *item1 = static_cast<const WordSortItem *>(p1);
+	const WordSortItem *item2 = static_cast<const WordSortItem *>(p2);
+#if NP2_AUTOC_CACHE_SORT_KEY
+	if (item1->sortKey != item2->sortKey) {
+		return (item1->sortKey < item2->sortKey) ? -1 : 1;
+	}
+#endif
+	return strcmp(item1->word, item2->word);
+}
+
+char* WordList::GetList() const noexcept {
+	// sort key is compared first without touching words in block buffers
+	WordSortItem *items = static_cast<WordSortItem *>(NP2HeapAllocTag(nWordCount*sizeof(WordSortItem), HeapTag_AutoCompletion));
+	UINT count = 0;
+	for (UINT i = 0; i < tableSize; i++) {
+		WordNode *node = pTable[i];
+		if (node) {
+			WordSortItem &item = items[count++];
+#if NP2_AUTOC_CACHE_SORT_KEY
+			item.sortKey = node->sortKey;
+#endif
+			item.len = node->len;
+			item.word = WordNode_GetWord(node);
 		}
 	}
+	qsort(items, count, sizeof(WordSortItem), CmpWordSortItem);
+
+	char *buf = static_cast<char *>(NP2HeapAllocTag(nTotalLen + 1, HeapTag_AutoCompletion));// additional separator
+	char * const pList = buf;
+	for (UINT i = 0; i < count; i++) {
+		memcpy(buf, items[i].word, items[i].len);
+		buf += items[i].len;
+		*buf++ = '\n'; // the separator char
+	}
+	NP2HeapFree(items);
 	// trim last separator char
 	if (buf != pList) {
 		*(--buf) = '\0';
@@ -329,15 +312,13 @@ void WordList::Init(LPCSTR pRoot, UINT iRootLen, bool ignoreCase) noexcept {
 	pWordStart = pRoot;
 	iStartLen = iRootLen;
 
+	// words are compared with memcmp() instead of _stricmp() to keep all matched string instead of just first one
 	if (ignoreCase) {
-		// use strcmp() instead of _stricmp() to keep all matched string instead of just first one
-		WL_strcmp = strcmp;
 		WL_strncmp = _strnicmp;
 #if NP2_AUTOC_CACHE_SORT_KEY
 		WL_SortKeyFunc = WordList_SortKeyCase;
 #endif
 	} else {
-		WL_strcmp = strcmp;
 		WL_strncmp = strncmp;
 #if NP2_AUTOC_CACHE_SORT_KEY
 		WL_SortKeyFunc = WordList_SortKey;
@@ -345,11 +326,12 @@ void WordList::Init(LPCSTR pRoot, UINT iRootLen, bool ignoreCase) noexcept {
 	}
 #if NP2_AUTOC_CACHE_SORT_KEY
 	startSortKey = WL_SortKeyFunc(pRoot, iRootLen);
-	bIgnoreCase = ignoreCase;
 #endif
 
 	capacity = NP2_AUTOC_INIT_BUFFER_SIZE;
 	AddBuffer();
+	tableSize = NP2_AUTOC_INIT_TABLE_SIZE;
+	pTable = static_cast<WordNode **>(NP2HeapAllocTag(tableSize*sizeof(WordNode *), HeapTag_AutoCompletion));
 }
 
 void WordList::UpdateRoot(LPCSTR pRoot, UINT iRootLen) noexcept {
@@ -823,9 +805,657 @@ void EscapeRegex(LPSTR pszOut, LPCSTR pszIn) noexcept {
 	*pszOut++ = '\0';
 }
 
-static void AutoC_AddDocWord(WordList &pWList, const uint32_t (&ignoredStyleMask)[8], bool bIgnoreCase, char prefix) noexcept {
+//=============================================================================
+// document word index
+// words in document with occurrence count, built in idle time and updated for edited lines,
+// so completion no longer searches whole document on each request.
+//
+enum {
+	DocWordClass_Code = 1,
+	DocWordClass_Comment = 2,
+	DocWordClass_String = 4,
+	DocWordClass_PlainText = 8,
+	DocWordClass_Ignored = 16,
+	DocWordClass_All = 31,
+};
+
+enum DocWordIndexState {
+	DocWordIndexState_None,
+	DocWordIndexState_Building,
+	DocWordIndexState_Ready,
+};
+
+#define DOC_WORD_INDEX_INIT_TABLE_SIZE	4096
+#define DOC_WORD_INDEX_BUFFER_SIZE		(64*1024)
+#define DOC_WORD_INDEX_PREFIX_COUNT		4096			// first byte and low 4 bits of second byte
+#define DOC_WORD_INDEX_BUILD_LINES		256				// lines styled and indexed at once
+#define DOC_WORD_INDEX_MAX_EDIT_LINES	4096			// rebuild instead of updating huge change
+#define DOC_WORD_INDEX_MAX_MISSING		1024			// rebuild when too many removed words not found
+
+struct DocWord {
+	DocWord *nextHash;
+	DocWord *nextPrefix;
+	DocWord *older;		// previous allocated word
+	uint32_t hash;
+	uint32_t charMask;	// characters used by fuzzy match
+	UINT count;
+	uint8_t len;
+	uint8_t wordClass;	// union of classes for all occurrences
+	bool chained;		// contains '::', '->', '.' or '-'
+};
+
+// store word right after the node, same as WordNode.
+#define DocWord_GetWord(node)		(reinterpret_cast<char *>(node) + sizeof(DocWord))
+
+struct DocWordToken {
+	char word[NP2_AUTOC_WORD_BUFFER_SIZE];
+	UINT len;
+	uint8_t wordClass;
+	bool chained;
+};
+
+struct DocWordIndex {
+	DocWord **table;
+	UINT tableSize;
+	UINT wordCount;
+	UINT missingCount;
+	DocWordIndexState state;
+	Sci_Line indexedLine;	// lines before it are indexed
+	Sci_Line pendingFirst;	// lines removed by SC_MOD_BEFOREINSERT or SC_MOD_BEFOREDELETE
+	Sci_Line pendingLast;
+
+	UINT offset;
+	WordListBuffer *buffer;
+	DocWord *newest;
+	DocWord *prefix[DOC_WORD_INDEX_PREFIX_COUNT];
+
+	void Reset() noexcept;
+	void Start() noexcept;
+	void Continue(HANDLE timer) noexcept;
+	void Notify(int modificationType, Sci_Position position, Sci_Position length, Sci_Line linesAdded) noexcept;
+	void UpdateLines(Sci_Line first, Sci_Line last, bool add) noexcept;
+	void Add(const DocWordToken &token, uint32_t hash) noexcept;
+	void Remove(const DocWordToken &token, uint32_t hash) noexcept;
+	DocWord *Find(const DocWordToken &token, uint32_t hash) const noexcept;
+	void Grow() noexcept;
+	bool IsReady() const noexcept {
+		return state == DocWordIndexState_Ready;
+	}
+};
+
+static DocWordIndex docWordIndex;
+static UINT docWordIndexGeneration;	// changed when words are released
+bool docWordIndexPending;
+
+static constexpr uint8_t DocWord_LowerCase(uint8_t ch) noexcept {
+	return (ch >= 'A' && ch <= 'Z') ? static_cast<uint8_t>(ch + 'a' - 'A') : ch;
+}
+
+static inline UINT DocWord_PrefixIndex(const char *word, UINT len) noexcept {
+	const UINT second = (len > 1) ? DocWord_LowerCase(word[1]) : 0;
+	return (DocWord_LowerCase(word[0]) << 4) | (second & 15);
+}
+
+static inline uint32_t DocWord_Hash(const char *word, UINT len) noexcept {
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (UINT i = 0; i < len; i++) {
+		hash = (hash ^ static_cast<uint8_t>(word[i])) * 16777619U;
+	}
+	return hash;
+}
+
+// one bit for each letter ignoring case, other characters are grouped.
+static constexpr uint32_t DocWord_CharBit(uint8_t ch) noexcept {
+	ch = DocWord_LowerCase(ch);
+	if (ch >= 'a' && ch <= 'z') {
+		return 1U << (ch - 'a');
+	}
+	if (ch >= '0' && ch <= '9') {
+		return 1U << 26;
+	}
+	return 1U << (27 + (ch & 3));
+}
+
+static inline uint32_t DocWord_CharMask(const char *word, UINT len) noexcept {
+	uint32_t mask = 0;
+	for (UINT i = 0; i < len; i++) {
+		mask |= DocWord_CharBit(word[i]);
+	}
+	return mask;
+}
+
+static uint8_t DocWord_GetClass(int style) noexcept {
+	if (BitTestEx(IgnoreWordStyleMask, style)) {
+		return DocWordClass_Ignored;
+	}
+	if (IsCommentStyle(style)) {
+		return DocWordClass_Comment;
+	}
+	if (BitTestEx(AllStringStyleMask, style)) {
+		return DocWordClass_String;
+	}
+	if (BitTestEx(PlainTextStyleMask, style)) {
+		return DocWordClass_PlainText;
+	}
+	return DocWordClass_Code;
+}
+
+// scan word at start of text, words after '::', '->', '.' and '-' are joined like AutoC_AddDocWord().
+// returns end of the first word.
+static size_t DocWord_Scan(const char *text, size_t length, size_t start, Sci_Position startPos, DocWordToken &token) noexcept {
+	size_t end = start;
+	while (end < length && IsDocWordChar(static_cast<uint8_t>(text[end]))) {
+		++end;
+	}
+	const size_t wordEnd = end;
+	const int style = SciCall_GetStyleIndexAt(startPos + wordEnd - 1);
+	token.wordClass = DocWord_GetClass(style);
+	token.chained = false;
+
+	while (end < length) {
+		const uint8_t ch = text[end];
+		size_t next = end + 1;
+		if ((ch == '-' && next < length && text[next] == '>') || (ch == ':' && next < length && text[next] == ':')) {
+			++next;
+		} else if (!(ch == '.' || (ch == '-' && style == SciCall_GetStyleIndexAt(startPos + end)))) {
+			break;
+		}
+		if (next >= length || !IsDocWordChar(static_cast<uint8_t>(text[next]))) {
+			break;
+		}
+		while (next < length && IsDocWordChar(static_cast<uint8_t>(text[next]))) {
+			++next;
+		}
+		if (next - start > NP2_AUTOC_MAX_WORD_LENGTH) {
+			break;
+		}
+		end = next;
+		token.chained = true;
+	}
+
+	UINT len = static_cast<UINT>(min<size_t>(end - start, NP2_AUTOC_MAX_WORD_LENGTH));
+	char *word = token.word;
+	memcpy(word, text + start, len);
+	if (start != 0) {
+		const int chPrev = static_cast<uint8_t>(text[start - 1]);
+		// word after escape character or format specifier
+		if ((chPrev == '%' || chPrev == pLexCurrent->escapeCharacterStart) && len > 1
+			&& IsEscapeCharOrFormatSpecifier(startPos + start - 1, static_cast<uint8_t>(word[0]), chPrev, style, false)) {
+			--len;
+			memmove(word, word + 1, len);
+		}
+	}
+
+	const int iLexer = pLexCurrent->iLexer;
+	if (end < length && text[end] == '!' && iLexer == SCLEX_RUST && style == SCE_RUST_MACRO) {
+		// macro: println!()
+		word[len++] = '!';
+		++end;
+	} else if (end + 1 < length && text[end] == '!' && text[end + 1] == '(' && (iLexer == SCLEX_JULIA || iLexer == SCLEX_RUST)) {
+		word[len++] = '!';
+		++end;
+	}
+	bool space = false;
+	if (!(iLexer == SCLEX_CPP && style == SCE_C_MACRO)) {
+		while (end < length && IsASpaceOrTab(text[end])) {
+			space = true;
+			++end;
+		}
+	}
+	if (end < length && text[end] == '(') {
+		word[len] = '\0';
+		if (space && word[len - 1] != '!' && NeedSpaceAfterKeyword(word, len)) {
+			word[len++] = ' ';
+		}
+		word[len++] = '(';
+		word[len++] = ')';
+	}
+	word[len] = '\0';
+	token.len = len;
+	return wordEnd;
+}
+
+void DocWordIndex::Reset() noexcept {
+	WordListBuffer *block = buffer;
+	while (block) {
+		WordListBuffer * const next = block->next;
+		NP2HeapFree(block);
+		block = next;
+	}
+	if (table) {
+		NP2HeapFree(table);
+	}
+	memset(this, 0, sizeof(DocWordIndex));
+	++docWordIndexGeneration;
+	docWordIndexPending = false;
+}
+
+void DocWordIndex::Start() noexcept {
+	Reset();
+	tableSize = DOC_WORD_INDEX_INIT_TABLE_SIZE;
+	table = static_cast<DocWord **>(NP2HeapAllocTag(tableSize*sizeof(DocWord *), HeapTag_AutoCompletion));
+	offset = DOC_WORD_INDEX_BUFFER_SIZE;
+	pendingFirst = -1;
+	state = DocWordIndexState_Building;
+	docWordIndexPending = true;
+	// remove words from lines before they are changed
+	SciCall_SetModEventMask(SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT | SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE);
+}
+
+void DocWordIndex::Continue(HANDLE timer) noexcept {
+	const Sci_Line lineCount = SciCall_GetLineCount();
+	while (indexedLine < lineCount) {
+		const Sci_Line last = min(indexedLine + DOC_WORD_INDEX_BUILD_LINES, lineCount) - 1;
+		// word class depends on style
+		SciCall_EnsureStyledTo(SciCall_GetLineEndPosition(last));
+		UpdateLines(indexedLine, last, true);
+		indexedLine = last + 1;
+		if (!IdleTask_Continue(timer)) {
+			return;
+		}
+	}
+	state = DocWordIndexState_Ready;
+	docWordIndexPending = false;
+}
+
+void DocWordIndex::Notify(int modificationType, Sci_Position position, Sci_Position length, Sci_Line linesAdded) noexcept {
+	if (state == DocWordIndexState_None) {
+		return;
+	}
+	if (modificationType & (SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE)) {
+		pendingFirst = -1;
+		const Sci_Line first = SciCall_LineFromPosition(position);
+		if (first >= indexedLine) {
+			// not indexed yet
+			return;
+		}
+		const Sci_Line last = (modificationType & SC_MOD_BEFOREDELETE) ? SciCall_LineFromPosition(position + length) : first;
+		if (last - first > DOC_WORD_INDEX_MAX_EDIT_LINES) {
+			Start();
+			return;
+		}
+		if (last >= indexedLine) {
+			// lines after first are indexed again by Continue()
+			UpdateLines(first, indexedLine - 1, false);
+			indexedLine = first;
+			return;
+		}
+		UpdateLines(first, last, false);
+		pendingFirst = first;
+		pendingLast = last;
+	} else if (pendingFirst >= 0) {
+		const Sci_Line first = pendingFirst;
+		pendingFirst = -1;
+		if (linesAdded > DOC_WORD_INDEX_MAX_EDIT_LINES || missingCount > DOC_WORD_INDEX_MAX_MISSING) {
+			Start();
+			return;
+		}
+		UpdateLines(first, pendingLast + linesAdded, true);
+		indexedLine += linesAdded;
+	}
+}
+
+void DocWordIndex::UpdateLines(Sci_Line first, Sci_Line last, bool add) noexcept {
+	DocWordToken token;
+	for (Sci_Line line = first; line <= last; line++) {
+		const Sci_Position startPos = SciCall_PositionFromLine(line);
+		const size_t length = SciCall_GetLineEndPosition(line) - startPos;
+		if (length == 0) {
+			continue;
+		}
+		const char *text = SciCall_GetRangePointer(startPos, length);
+		size_t index = 0;
+		while (index < length) {
+			if (!IsDocWordChar(static_cast<uint8_t>(text[index]))) {
+				++index;
+				continue;
+			}
+			index = DocWord_Scan(text, length, index, startPos, token);
+			const uint32_t hash = DocWord_Hash(token.word, token.len);
+			if (add) {
+				Add(token, hash);
+			} else {
+				Remove(token, hash);
+			}
+		}
+	}
+}
+
+DocWord *DocWordIndex::Find(const DocWordToken &token, uint32_t hash) const noexcept {
+	DocWord *node = table[hash & (tableSize - 1)];
+	while (node) {
+		if (node->hash == hash && node->len == token.len && memcmp(DocWord_GetWord(node), token.word, token.len) == 0) {
+			break;
+		}
+		node = node->nextHash;
+	}
+	return node;
+}
+
+void DocWordIndex::Grow() noexcept {
+	const UINT size = tableSize*2;
+	DocWord **newTable = static_cast<DocWord **>(NP2HeapAllocTag(size*sizeof(DocWord *), HeapTag_AutoCompletion));
+	for (UINT i = 0; i < tableSize; i++) {
+		DocWord *node = table[i];
+		while (node) {
+			DocWord * const next = node->nextHash;
+			DocWord **head = newTable + (node->hash & (size - 1));
+			node->nextHash = *head;
+			*head = node;
+			node = next;
+		}
+	}
+	NP2HeapFree(table);
+	table = newTable;
+	tableSize = size;
+}
+
+void DocWordIndex::Add(const DocWordToken &token, uint32_t hash) noexcept {
+	DocWord *node = Find(token, hash);
+	if (node == nullptr) {
+		// removed words are kept with zero count, memory is released by Reset().
+		const UINT size = NP2_align_up(sizeof(DocWord) + token.len + 1, alignof(DocWord));
+		if (offset + size > DOC_WORD_INDEX_BUFFER_SIZE) {
+			WordListBuffer *block = static_cast<WordListBuffer *>(NP2HeapAllocTag(DOC_WORD_INDEX_BUFFER_SIZE, HeapTag_AutoCompletion));
+			block->next = buffer;
+			buffer = block;
+			offset = NP2_align_up(sizeof(WordListBuffer), alignof(DocWord));
+		}
+		node = reinterpret_cast<DocWord *>(reinterpret_cast<char *>(buffer) + offset);
+		offset += size;
+		memcpy(DocWord_GetWord(node), token.word, token.len + 1);
+		node->hash = hash;
+		node->charMask = DocWord_CharMask(token.word, token.len);
+		node->count = 0;
+		node->len = static_cast<uint8_t>(token.len);
+		node->wordClass = 0;
+		node->chained = token.chained;
+		if (wordCount >= tableSize) {
+			Grow();
+		}
+		++wordCount;
+		DocWord **head = table + (hash & (tableSize - 1));
+		node->nextHash = *head;
+		*head = node;
+		head = prefix + DocWord_PrefixIndex(token.word, token.len);
+		node->nextPrefix = *head;
+		*head = node;
+		node->older = newest;
+		newest = node;
+	}
+	node->count++;
+	node->wordClass |= token.wordClass;
+}
+
+void DocWordIndex::Remove(const DocWordToken &token, uint32_t hash) noexcept {
+	DocWord *node = Find(token, hash);
+	if (node == nullptr || node->count == 0) {
+		// style changed after the line was indexed
+		++missingCount;
+		return;
+	}
+	node->count--;
+	if (node->count == 0) {
+		node->wordClass = 0;
+	}
+}
+
+static void AutoC_AddIndexedWord(WordList &pWList, uint8_t wordClass, Sci_Position iCurrentPos) noexcept {
+	LPCSTR const pRoot = pWList.pWordStart;
+	const UINT iRootLen = pWList.iStartLen;
+
+	// the word being typed is indexed, skip it unless it occurs elsewhere
+	DocWordToken current;
+	current.len = 0;
+	{
+		const Sci_Position lineEnd = SciCall_GetLineEndPosition(SciCall_LineFromPosition(iCurrentPos));
+		const size_t length = lineEnd - iCurrentPos;
+		if (length != 0) {
+			const char *text = SciCall_GetRangePointer(iCurrentPos, length);
+			DocWord_Scan(text, length, 0, iCurrentPos, current);
+		}
+	}
+
+	UINT index = DocWord_PrefixIndex(pRoot, iRootLen);
+	UINT count = 1;
+	if (iRootLen == 1) {
+		// all second bytes
+		count = 16;
+	}
+	char wordBuf[NP2_AUTOC_WORD_BUFFER_SIZE];
+	for (; count != 0; count--, index++) {
+		DocWord *node = docWordIndex.prefix[index];
+		while (node) {
+			const char *word = DocWord_GetWord(node);
+			if ((node->wordClass & wordClass) && node->len >= iRootLen && pWList.StartsWith(word)
+				&& !(node->count == 1 && node->len == current.len && memcmp(word, current.word, current.len) == 0)) {
+				const UINT len = node->len;
+				memcpy(wordBuf, word, len + 1);
+				pWList.AddWord(wordBuf, len);
+				if (node->chained) {
+					pWList.AddSubWord(wordBuf, len, iRootLen);
+				}
+			}
+			node = node->nextPrefix;
+		}
+	}
+}
+
+// fuzzy match: root is matched as case insensitive subsequence of indexed words.
+struct FuzzyMatchItem {
+	int score;
+	const DocWord *node;
+};
+
+struct FuzzyMatchCache {
+	DocWord **items;	// all words matched the root, narrowed when root is extended
+	UINT count;
+	UINT capacity;
+	UINT generation;
+	const DocWord *newest;
+	UINT rootLen;
+	char root[NP2_AUTOC_WORD_BUFFER_SIZE];
+};
+
+static FuzzyMatchCache fuzzyMatchCache;
+static bool autoCompleteFuzzyList;
+
+static constexpr bool DocWord_IsUpper(uint8_t ch) noexcept {
+	return ch >= 'A' && ch <= 'Z';
+}
+
+static constexpr bool DocWord_IsLowerOrDigit(uint8_t ch) noexcept {
+	return (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9');
+}
+
+// returns 0 when root is not a subsequence of word, matches at word start,
+// after separator or at camelCase hump, consecutive matches and same case got higher score.
+static int DocWord_FuzzyScore(const char *word, UINT len, const char *root, UINT rootLen) noexcept {
+	int score = 0;
+	UINT index = 0;
+	UINT last = 0;
+	for (UINT i = 0; i < len && index < rootLen; i++) {
+		const uint8_t ch = word[i];
+		const uint8_t expected = root[index];
+		if (DocWord_LowerCase(ch) != DocWord_LowerCase(expected)) {
+			continue;
+		}
+		int bonus = 1 + (ch == expected);
+		if (i == 0) {
+			bonus += 8;
+		} else {
+			const uint8_t chPrev = word[i - 1];
+			if (!IsDocWordChar(chPrev) || chPrev == '_' || chPrev == '-'
+				|| (DocWord_IsUpper(ch) && DocWord_IsLowerOrDigit(chPrev))) {
+				bonus += 6;
+			}
+			if (index != 0) {
+				if (last + 1 == i) {
+					bonus += 4;
+				} else {
+					bonus -= min<UINT>(i - last - 1, 3);
+				}
+			}
+		}
+		score += bonus;
+		last = i;
+		++index;
+	}
+	if (index != rootLen) {
+		return 0;
+	}
+	return max(score, 1);
+}
+
+static int __cdecl CmpFuzzyMatchItem(const void *p1, const void *p2) noexcept {
+	const FuzzyMatchItem *item1 = static_cast<const FuzzyMatchItem *>(p1);
+	const FuzzyMatchItem *item2 = static_cast<const FuzzyMatchItem *>(p2);
+	if (item1->score != item2->score) {
+		return item2->score - item1->score;
+	}
+	// more frequently used word first
+	const DocWord *node1 = item1->node;
+	const DocWord *node2 = item2->node;
+	if (node1->count != node2->count) {
+		return (node1->count > node2->count) ? -1 : 1;
+	}
+	if (node1->len != node2->len) {
+		return node1->len - node2->len;
+	}
+	return strcmp(DocWord_GetWord(node1), DocWord_GetWord(node2));
+}
+
+static void FuzzyMatchCache_Add(FuzzyMatchCache &cache, DocWord *node) noexcept {
+	if (cache.count == cache.capacity) {
+		const UINT capacity = max<UINT>(cache.capacity*2, 1024);
+		DocWord **items = static_cast<DocWord **>(NP2HeapAllocTag(capacity*sizeof(DocWord *), HeapTag_AutoCompletion));
+		if (cache.items) {
+			memcpy(items, cache.items, cache.count*sizeof(DocWord *));
+			NP2HeapFree(cache.items);
+		}
+		cache.items = items;
+		cache.capacity = capacity;
+	}
+	cache.items[cache.count++] = node;
+}
+
+static inline void FuzzyMatchCache_Filter(FuzzyMatchCache &cache, DocWord *node, uint32_t rootMask) noexcept {
+	// reject most words by character set before comparing characters
+	if ((node->charMask & rootMask) == rootMask
+		&& DocWord_FuzzyScore(DocWord_GetWord(node), node->len, cache.root, cache.rootLen)) {
+		FuzzyMatchCache_Add(cache, node);
+	}
+}
+
+void EditWordIndexReset() noexcept {
+	docWordIndex.Reset();
+	if (fuzzyMatchCache.items) {
+		NP2HeapFree(fuzzyMatchCache.items);
+	}
+	memset(&fuzzyMatchCache, 0, sizeof(fuzzyMatchCache));
+}
+
+void EditWordIndexContinue(HANDLE timer) noexcept {
+	docWordIndex.Continue(timer);
+}
+
+void EditWordIndexNotify(int modificationType, Sci_Position position, Sci_Position length, Sci_Line linesAdded) noexcept {
+	docWordIndex.Notify(modificationType, position, length, linesAdded);
+}
+
+// returns list sorted by score, empty list is returned as nullptr.
+static char *AutoC_GetFuzzyList(LPCSTR pRoot, UINT iRootLen, uint8_t wordClass, Sci_Position iCurrentPos, UINT *pCount) noexcept {
+	FuzzyMatchCache &cache = fuzzyMatchCache;
+	const uint32_t rootMask = DocWord_CharMask(pRoot, iRootLen);
+	const DocWord *stop = nullptr;
+	if (cache.generation == docWordIndexGeneration && cache.rootLen != 0
+		&& cache.rootLen <= iRootLen && _strnicmp(cache.root, pRoot, cache.rootLen) == 0) {
+		// root is extended, narrow previous matched words
+		memcpy(cache.root, pRoot, iRootLen + 1);
+		cache.rootLen = iRootLen;
+		const UINT count = cache.count;
+		cache.count = 0;
+		for (UINT i = 0; i < count; i++) {
+			FuzzyMatchCache_Filter(cache, cache.items[i], rootMask);
+		}
+		stop = cache.newest;
+	} else {
+		memcpy(cache.root, pRoot, iRootLen + 1);
+		cache.rootLen = iRootLen;
+		cache.count = 0;
+		cache.generation = docWordIndexGeneration;
+	}
+	// words added after previous match
+	for (DocWord *node = docWordIndex.newest; node != stop; node = node->older) {
+		FuzzyMatchCache_Filter(cache, node, rootMask);
+	}
+	cache.newest = docWordIndex.newest;
+	if (cache.count == 0) {
+		return nullptr;
+	}
+
+	// the word being typed is indexed, skip it unless it occurs elsewhere
+	DocWordToken current;
+	current.len = 0;
+	{
+		const Sci_Position lineEnd = SciCall_GetLineEndPosition(SciCall_LineFromPosition(iCurrentPos));
+		const size_t length = lineEnd - iCurrentPos;
+		if (length != 0) {
+			const char *text = SciCall_GetRangePointer(iCurrentPos, length);
+			DocWord_Scan(text, length, 0, iCurrentPos, current);
+		}
+	}
+
+	FuzzyMatchItem *items = static_cast<FuzzyMatchItem *>(NP2HeapAllocTag(cache.count*sizeof(FuzzyMatchItem), HeapTag_AutoCompletion));
+	UINT count = 0;
+	for (UINT i = 0; i < cache.count; i++) {
+		const DocWord *node = cache.items[i];
+		const char *word = DocWord_GetWord(node);
+		if ((node->wordClass & wordClass)
+			&& !(node->count == 1 && node->len == current.len && memcmp(word, current.word, current.len) == 0)) {
+			items[count].score = DocWord_FuzzyScore(word, node->len, pRoot, iRootLen);
+			items[count].node = node;
+			++count;
+		}
+	}
+
+	char *pList = nullptr;
+	if (count != 0) {
+		qsort(items, count, sizeof(FuzzyMatchItem), CmpFuzzyMatchItem);
+		count = min<UINT>(count, NP2_AUTOC_FUZZY_MAX_ITEM_COUNT);
+		UINT totalLen = 0;
+		for (UINT i = 0; i < count; i++) {
+			totalLen += items[i].node->len + 1;
+		}
+		char *buf = static_cast<char *>(NP2HeapAllocTag(totalLen, HeapTag_AutoCompletion));
+		pList = buf;
+		for (UINT i = 0; i < count; i++) {
+			const DocWord *node = items[i].node;
+			memcpy(buf, DocWord_GetWord(node), node->len);
+			buf += node->len;
+			*buf++ = '\n'; // the separator char
+		}
+		*(--buf) = '\0';
+	}
+	NP2HeapFree(items);
+	*pCount = count;
+	return pList;
+}
+
+static void AutoC_AddDocWord(WordList &pWList, const uint32_t (&ignoredStyleMask)[8], uint8_t wordClass, bool bIgnoreCase, char prefix) noexcept {
 	LPCSTR const pRoot = pWList.pWordStart;
 	const int iRootLen = pWList.iStartLen;
+	if (prefix == '\0' && iRootLen != 0 && IsDocWordChar(static_cast<uint8_t>(pRoot[0]))) {
+		if (docWordIndex.IsReady()) {
+			AutoC_AddIndexedWord(pWList, wordClass, SciCall_GetCurrentPos() - iRootLen);
+			return;
+		}
+		if (docWordIndex.state == DocWordIndexState_None) {
+			// search document until the index is built
+			docWordIndex.Start();
+		}
+	}
 
 	CharBuffer pFind(iRootLen + 2);
 	pFind[0] = prefix;
@@ -969,16 +1599,499 @@ static void AutoC_AddDocWord(WordList &pWList, const uint32_t (&ignoredStyleMask
 	}
 }
 
+// keywords split by same rules as WordList::AddListEx() with empty root and sorted case insensitively,
+// built once for each lexer, then words starting with root are found by binary search.
+#define NP2_AUTOC_KEYWORD_TABLE_COUNT	8
+
+struct KeywordTableItem {
+	const char *word;
+	UINT len;
+};
+
+struct KeywordTable {
+	LPCEDITLEXER pLex;
+	KeywordTableItem *items;
+	UINT count;
+	UINT capacity;
+	char *buffer;
+	UINT offset;
+	UINT size;
+
+	void Free() noexcept;
+	void AddWord(const char *word, UINT len) noexcept;
+	void AddList(LPCSTR pList) noexcept;
+	void Finish() noexcept;
+	void Build(LPCEDITLEXER lex) noexcept;
+	void AddMatched(WordList &pWList) const noexcept;
+};
+
+static KeywordTable keywordTables[NP2_AUTOC_KEYWORD_TABLE_COUNT];
+static UINT keywordTableNext;
+
+void KeywordTable::Free() noexcept {
+	if (items) {
+		NP2HeapFree(items);
+	}
+	if (buffer) {
+		NP2HeapFree(buffer);
+	}
+	memset(this, 0, sizeof(KeywordTable));
+}
+
+void KeywordTable::AddWord(const char *word, UINT len) noexcept {
+	if (count == capacity) {
+		capacity = max<UINT>(capacity*2, 256);
+		KeywordTableItem *newItems = static_cast<KeywordTableItem *>(NP2HeapAllocTag(capacity*sizeof(KeywordTableItem), HeapTag_AutoCompletion));
+		if (items) {
+			memcpy(newItems, items, count*sizeof(KeywordTableItem));
+			NP2HeapFree(items);
+		}
+		items = newItems;
+	}
+	// extra bytes for reading sort key after the last word
+	if (offset + len + 1 + sizeof(uint32_t) > size) {
+		size = max<UINT>(size*2, offset + len + 1 + sizeof(uint32_t));
+		char *newBuffer = static_cast<char *>(NP2HeapAllocTag(size, HeapTag_AutoCompletion));
+		if (buffer) {
+			memcpy(newBuffer, buffer, offset);
+			NP2HeapFree(buffer);
+		}
+		buffer = newBuffer;
+	}
+	// word pointers are fixed after all lists are added
+	items[count].word = reinterpret_cast<const char *>(static_cast<uintptr_t>(offset));
+	items[count].len = len;
+	++count;
+	memcpy(buffer + offset, word, len + 1);
+	offset += len + 1;
+}
+
+void KeywordTable::AddList(LPCSTR pList) noexcept {
+	char word[NP2_AUTOC_WORD_BUFFER_SIZE];
+	UINT len = 0;
+	while (true) {
+		uint8_t ch;
+		LPCSTR sub = pList;
+		do {
+			ch = *sub++;
+		} while (!WordList_IsSeparator(ch));
+
+		UINT lenSub = static_cast<UINT>(sub - pList - 1);
+		lenSub = min<UINT>(NP2_AUTOC_MAX_WORD_LENGTH - len, lenSub);
+		memcpy(word + len, pList, lenSub);
+		len += lenSub;
+		pList = sub;
+		if (len != 0) {
+			if (ch == '(') {
+				word[len++] = '(';
+				word[len++] = ')';
+			}
+			word[len] = '\0';
+			AddWord(word, len);
+		}
+		if (ch == '\0') {
+			break;
+		}
+		if (ch == '^') {
+			word[len++] = ' ';
+		} else if (ch != '.') {
+			len = 0;
+		} else {
+			word[len++] = '.';
+		}
+	}
+}
+
+static int __cdecl CmpKeywordTableItem(const void *p1, const void *p2) noexcept {
+	const KeywordTableItem *item1 = static_cast<const KeywordTableItem *>(p1);
+	const KeywordTableItem *item2 = static_cast<const KeywordTableItem *>(p2);
+	const int cmp = _stricmp(item1->word, item2->word);
+	return cmp ? cmp : strcmp(item1->word, item2->word);
+}
+
+void KeywordTable::Build(LPCEDITLEXER lex) noexcept {
+	Free();
+	pLex = lex;
+	uint64_t attr = lex->keywordAttr;
+	for (UINT i = 0; i < KEYWORDSET_MAX + 1; attr >>= 4, i++) {
+		const char *pKeywords = lex->pKeyWords->pszKeyWords[i];
+		if (!(attr & KeywordAttr_NoAutoComp) && StrNotEmpty(pKeywords)) {
+			AddList(pKeywords);
+		}
+	}
+	Finish();
+}
+
+void KeywordTable::Finish() noexcept {
+	for (UINT i = 0; i < count; i++) {
+		items[i].word = buffer + reinterpret_cast<uintptr_t>(items[i].word);
+	}
+	qsort(items, count, sizeof(KeywordTableItem), CmpKeywordTableItem);
+	// remove duplicate words, which are adjacent after sorting
+	UINT unique = 0;
+	for (UINT i = 0; i < count; i++) {
+		if (unique == 0 || strcmp(items[unique - 1].word, items[i].word) != 0) {
+			items[unique++] = items[i];
+		}
+	}
+	count = unique;
+}
+
+static const KeywordTable &AutoC_GetKeywordTable(LPCEDITLEXER pLex) noexcept {
+	for (const KeywordTable &table : keywordTables) {
+		if (table.pLex == pLex) {
+			return table;
+		}
+	}
+	KeywordTable &table = keywordTables[keywordTableNext];
+	keywordTableNext = (keywordTableNext + 1) % NP2_AUTOC_KEYWORD_TABLE_COUNT;
+	table.Build(pLex);
+	return table;
+}
+
+void KeywordTable::AddMatched(WordList &pWList) const noexcept {
+	LPCSTR const pRoot = pWList.pWordStart;
+	const UINT iRootLen = pWList.iStartLen;
+	// find first word case insensitively starts with root
+	UINT start = 0;
+	UINT end = count;
+	while (start < end) {
+		const UINT pivot = (start + end) / 2;
+		if (_strnicmp(items[pivot].word, pRoot, iRootLen) < 0) {
+			start = pivot + 1;
+		} else {
+			end = pivot;
+		}
+	}
+	for (; start < count; start++) {
+		const KeywordTableItem &item = items[start];
+		if (_strnicmp(item.word, pRoot, iRootLen) != 0) {
+			break;
+		}
+		if (item.len >= iRootLen && pWList.StartsWith(item.word)) {
+			pWList.AddWord(item.word, item.len);
+		}
+	}
+}
+
+static inline void AutoC_AddLexerKeyword(WordList &pWList, LPCEDITLEXER pLex) noexcept {
+	AutoC_GetKeywordTable(pLex).AddMatched(pWList);
+}
+
+
+// Project words: identifiers in files of current scheme under directory of current file, scanned on
+// thread pool. Unchanged files (same size and last write time) are not read again on rescan.
+#define PROJECT_WORDS_MAX_FILE_COUNT	256
+#define PROJECT_WORDS_MAX_FILE_SIZE		(1024*1024)
+#define PROJECT_WORDS_MAX_DEPTH			3
+#define PROJECT_WORDS_MIN_WORD_LENGTH	3
+
+extern WCHAR szCurFile[MAX_PATH + 40];
+
+struct ProjectFile {
+	FILETIME lastWrite;
+	DWORD size;
+	bool seen;
+	UINT wordsLen;
+	char *words;	// unique words separated by '\0'
+	WCHAR path[MAX_PATH];
+};
+
+static struct ProjectWords {
+	PTP_WORK work;
+	volatile LONG running;
+	volatile LONG outdated;
+	volatile LONG stopping;
+	KeywordTable * volatile ready;	// published by worker
+	KeywordTable *table;			// used by main thread
+	LPCEDITLEXER pLex;
+	// input for worker, only changed when worker is not running
+	WCHAR directory[MAX_PATH];
+	WCHAR current[MAX_PATH];
+	WCHAR extensions[MAX_EDITLEXER_EXT_SIZE];
+	// owned by worker
+	UINT fileCount;
+	ProjectFile *files;
+} projectWords;
+
+static constexpr bool ProjectWords_IsWordChar(uint8_t ch) noexcept {
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9')
+		|| ch == '_' || ch == '$' || ch >= 0x80;
+}
+
+static bool ProjectWords_MatchExtension(LPCWSTR extensions, LPCWSTR name) noexcept {
+	LPCWSTR ext = PathFindExtension(name);
+	if (*ext == L'\0') {
+		return false;
+	}
+	++ext;
+	const int cch = lstrlen(ext);
+	LPCWSTR p = extensions;
+	while (*p) {
+		while (*p == L' ' || *p == L';') {
+			++p;
+		}
+		LPCWSTR end = p;
+		while (*end && *end != L';' && *end != L' ') {
+			++end;
+		}
+		if (end - p == cch && _wcsnicmp(p, ext, cch) == 0) {
+			return true;
+		}
+		p = end;
+	}
+	return false;
+}
+
+static void ProjectWords_ReadFile(ProjectFile &file) noexcept {
+	if (file.words) {
+		NP2HeapFree(file.words);
+		file.words = nullptr;
+	}
+	file.wordsLen = 0;
+	HANDLE hFile = CreateFile(file.path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	char *text = static_cast<char *>(NP2HeapAllocTag(file.size + 1, HeapTag_AutoCompletion));
+	DWORD cbRead = 0;
+	const bool success = ReadFile(hFile, text, file.size, &cbRead, nullptr);
+	CloseHandle(hFile);
+	// skip binary file
+	if (!success || memchr(text, '\0', min<DWORD>(cbRead, 4096)) != nullptr) {
+		NP2HeapFree(text);
+		return;
+	}
+
+	KeywordTable table;
+	memset(&table, 0, sizeof(table));
+	const char *ptr = text;
+	const char * const end = text + cbRead;
+	while (ptr < end) {
+		const uint8_t ch = *ptr;
+		if (!ProjectWords_IsWordChar(ch)) {
+			++ptr;
+			continue;
+		}
+		const char *start = ptr;
+		while (ptr < end && ProjectWords_IsWordChar(*ptr)) {
+			++ptr;
+		}
+		const UINT len = static_cast<UINT>(ptr - start);
+		if (!(ch >= '0' && ch <= '9') && len >= PROJECT_WORDS_MIN_WORD_LENGTH && len <= NP2_AUTOC_MAX_WORD_LENGTH) {
+			char word[NP2_AUTOC_WORD_BUFFER_SIZE];
+			memcpy(word, start, len);
+			word[len] = '\0';
+			table.AddWord(word, len);
+		}
+	}
+	NP2HeapFree(text);
+
+	if (table.count != 0) {
+		table.Finish();
+		UINT total = 0;
+		for (UINT i = 0; i < table.count; i++) {
+			total += table.items[i].len + 1;
+		}
+		char *words = static_cast<char *>(NP2HeapAllocTag(total, HeapTag_AutoCompletion));
+		file.words = words;
+		file.wordsLen = total;
+		for (UINT i = 0; i < table.count; i++) {
+			memcpy(words, table.items[i].word, table.items[i].len + 1);
+			words += table.items[i].len + 1;
+		}
+	}
+	table.Free();
+}
+
+static void ProjectWords_AddFile(ProjectWords &context, LPCWSTR path, const WIN32_FIND_DATA &fd) noexcept {
+	if (fd.nFileSizeHigh != 0 || fd.nFileSizeLow > PROJECT_WORDS_MAX_FILE_SIZE || PathEqual(path, context.current)) {
+		return;
+	}
+	ProjectFile *file = nullptr;
+	for (UINT i = 0; i < context.fileCount; i++) {
+		if (PathEqual(context.files[i].path, path)) {
+			file = &context.files[i];
+			break;
+		}
+	}
+	if (file == nullptr) {
+		if (context.fileCount == PROJECT_WORDS_MAX_FILE_COUNT) {
+			return;
+		}
+		file = &context.files[context.fileCount++];
+		memset(file, 0, sizeof(ProjectFile));
+		lstrcpyn(file->path, path, MAX_PATH);
+	} else if (file->size == fd.nFileSizeLow && CompareFileTime(&file->lastWrite, &fd.ftLastWriteTime) == 0) {
+		file->seen = true;
+		return;
+	}
+	file->seen = true;
+	file->size = fd.nFileSizeLow;
+	file->lastWrite = fd.ftLastWriteTime;
+	ProjectWords_ReadFile(*file);
+}
+
+static void ProjectWords_Walk(ProjectWords &context, LPWSTR path, UINT length, UINT depth) noexcept {
+	if (length + 2 >= MAX_PATH) {
+		return;
+	}
+	path[length] = L'\\';
+	path[length + 1] = L'*';
+	path[length + 2] = L'\0';
+	WIN32_FIND_DATA fd;
+	HANDLE hFind = FindFirstFileEx(path, FindExInfoBasic, &fd, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+	if (hFind == INVALID_HANDLE_VALUE) {
+		return;
+	}
+
+	do {
+		LPCWSTR name = fd.cFileName;
+		// also skip ".git", ".vs", etc.
+		if (name[0] == L'.' || (fd.dwFileAttributes & (FILE_ATTRIBUTE_HIDDEN | FILE_ATTRIBUTE_SYSTEM))) {
+			continue;
+		}
+		const UINT cchName = lstrlen(name);
+		if (length + 1 + cchName >= MAX_PATH) {
+			continue;
+		}
+		memcpy(path + length + 1, name, (cchName + 1)*sizeof(WCHAR));
+		if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			if (depth < PROJECT_WORDS_MAX_DEPTH && !(fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+				ProjectWords_Walk(context, path, length + 1 + cchName, depth + 1);
+			}
+		} else if (ProjectWords_MatchExtension(context.extensions, name)) {
+			ProjectWords_AddFile(context, path, fd);
+		}
+	} while (!context.stopping && FindNextFile(hFind, &fd));
+	FindClose(hFind);
+}
+
+static VOID CALLBACK ProjectWords_WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+	ProjectWords &project = *static_cast<ProjectWords *>(context);
+	const bool throttled = BackgroundWork_Begin();
+	if (project.files == nullptr) {
+		project.files = static_cast<ProjectFile *>(NP2HeapAllocTag(PROJECT_WORDS_MAX_FILE_COUNT*sizeof(ProjectFile), HeapTag_AutoCompletion));
+	}
+	for (UINT i = 0; i < project.fileCount; i++) {
+		project.files[i].seen = false;
+	}
+
+	WCHAR path[MAX_PATH];
+	lstrcpy(path, project.directory);
+	ProjectWords_Walk(project, path, lstrlen(path), 0);
+
+	// remove deleted files
+	UINT count = 0;
+	for (UINT i = 0; i < project.fileCount; i++) {
+		ProjectFile &file = project.files[i];
+		if (file.seen) {
+			if (count != i) {
+				project.files[count] = file;
+			}
+			++count;
+		} else if (file.words) {
+			NP2HeapFree(file.words);
+		}
+	}
+	project.fileCount = count;
+
+	if (!project.stopping) {
+		KeywordTable *table = static_cast<KeywordTable *>(NP2HeapAllocTag(sizeof(KeywordTable), HeapTag_AutoCompletion));
+		for (UINT i = 0; i < count; i++) {
+			const ProjectFile &file = project.files[i];
+			const char *word = file.words;
+			const char * const end = word + file.wordsLen;
+			while (word < end) {
+				const UINT len = static_cast<UINT>(strlen(word));
+				table->AddWord(word, len);
+				word += len + 1;
+			}
+		}
+		table->Finish();
+		table = static_cast<KeywordTable *>(InterlockedExchangePointer(reinterpret_cast<PVOID volatile *>(&project.ready), table));
+		if (table) {
+			// previous result is not used
+			table->Free();
+			NP2HeapFree(table);
+		}
+	}
+	BackgroundWork_End(throttled);
+	InterlockedExchange(&project.running, FALSE);
+}
+
+void EditProjectWordsInvalidate() noexcept {
+	InterlockedExchange(&projectWords.outdated, TRUE);
+}
+
+void EditProjectWordsRelease() noexcept {
+	ProjectWords &project = projectWords;
+	if (project.work) {
+		InterlockedExchange(&project.stopping, TRUE);
+		WaitForThreadpoolWorkCallbacks(project.work, TRUE);
+		CloseThreadpoolWork(project.work);
+	}
+	KeywordTable *tables[2] = { project.table, project.ready };
+	for (KeywordTable *table : tables) {
+		if (table) {
+			table->Free();
+			NP2HeapFree(table);
+		}
+	}
+	for (UINT i = 0; i < project.fileCount; i++) {
+		if (project.files[i].words) {
+			NP2HeapFree(project.files[i].words);
+		}
+	}
+	if (project.files) {
+		NP2HeapFree(project.files);
+	}
+	memset(&project, 0, sizeof(ProjectWords));
+}
+
+static void AutoC_AddProjectWord(WordList &pWList) noexcept {
+	ProjectWords &project = projectWords;
+	KeywordTable *table = static_cast<KeywordTable *>(InterlockedExchangePointer(reinterpret_cast<PVOID volatile *>(&project.ready), nullptr));
+	if (table) {
+		if (project.table) {
+			project.table->Free();
+			NP2HeapFree(project.table);
+		}
+		project.table = table;
+	}
+
+	// start rescan when scheme, directory or files in the directory changed, result is used by next completion
+	if (StrNotEmpty(szCurFile) && !project.running) {
+		WCHAR directory[MAX_PATH];
+		lstrcpyn(directory, szCurFile, MAX_PATH);
+		PathRemoveFileSpec(directory);
+		if (project.pLex != pLexCurrent || project.outdated || !PathEqual(directory, project.directory)) {
+			if (project.work == nullptr) {
+				project.work = CreateThreadpoolWork(ProjectWords_WorkCallback, &project, nullptr);
+			}
+			if (project.work) {
+				lstrcpy(project.directory, directory);
+				lstrcpyn(project.current, szCurFile, MAX_PATH);
+				const LPCWSTR extensions = StrNotEmpty(pLexCurrent->szExtensions) ? pLexCurrent->szExtensions : pLexCurrent->pszDefExt;
+				lstrcpyn(project.extensions, extensions, MAX_EDITLEXER_EXT_SIZE);
+				project.pLex = pLexCurrent;
+				project.outdated = FALSE;
+				project.running = TRUE;
+				SubmitThreadpoolWork(project.work);
+			}
+		}
+	}
+
+	if (project.table && project.table->count != 0) {
+		project.table->AddMatched(pWList);
+	}
+}
+
 static void AutoC_AddKeyword(WordList &pWList, int iCurrentStyle) noexcept {
 	const int iLexer = pLexCurrent->iLexer;
 	if (iLexer != SCLEX_PHPSCRIPT) {
-		uint64_t attr = pLexCurrent->keywordAttr;
-		for (UINT i = 0; i < KEYWORDSET_MAX + 1; attr >>= 4, i++) {
-			const char *pKeywords = pLexCurrent->pKeyWords->pszKeyWords[i];
-			if (!(attr & KeywordAttr_NoAutoComp) && StrNotEmpty(pKeywords)) {
-				pWList.AddListEx(pKeywords);
-			}
-		}
+		AutoC_AddLexerKeyword(pWList, pLexCurrent);
 	}
 
 	// additional keywords
@@ -1013,13 +2126,7 @@ static void AutoC_AddKeyword(WordList &pWList, int iCurrentStyle) noexcept {
 		pLex = &lexJavaScript;
 	}
 	if (pLex != nullptr) {
-		uint64_t attr = pLex->keywordAttr;
-		for (UINT i = 0; i < KEYWORDSET_MAX + 1; attr >>= 4, i++) {
-			const char *pKeywords = pLex->pKeyWords->pszKeyWords[i];
-			if (!(attr & KeywordAttr_NoAutoComp) && StrNotEmpty(pKeywords)) {
-				pWList.AddListEx(pKeywords);
-			}
-		}
+		AutoC_AddLexerKeyword(pWList, pLex);
 	}
 	if (iLexer == SCLEX_PHPSCRIPT || iLexer == SCLEX_JAVASCRIPT || iLexer == SCLEX_MARKDOWN) {
 		pWList.AddListEx(lexHTML.pKeyWords->pszKeyWords[HTMLKeywordIndex_Tag]);
@@ -1495,6 +2602,19 @@ void EditCompleteUpdateConfig() noexcept {
 	autoCompletionConfig.wszAutoCompleteFillUp[k] = L'\0';
 }
 
+static void AutoC_ShowList(UINT iStartLen, const char *pList, UINT count, bool bIgnoreCase, bool autoInsert) noexcept {
+	SciCall_AutoCSetIgnoreCase(bIgnoreCase); // case sensitivity
+	SciCall_AutoCSetCaseInsensitiveBehaviour(bIgnoreCase);
+	//SciCall_AutoCSetSeparator('\n');
+	//SciCall_AutoCSetTypeSeparator('\t');
+	SciCall_AutoCSetFillUps(autoCompletionConfig.szAutoCompleteFillUp);
+	//SciCall_AutoCSetDropRestOfWord(true); // delete orginal text: pRoot
+	SciCall_AutoCSetMaxHeight(min(count, autoCompletionConfig.iVisibleItemCount)); // visible rows
+	SciCall_AutoCSetCancelAtStart(false); // don't cancel the list when deleting character
+	SciCall_AutoCSetChooseSingle(autoInsert);
+	SciCall_AutoCShow(iStartLen, pList);
+}
+
 static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 	const Sci_Position iCurrentPos = SciCall_GetCurrentPos();
 	const Sci_Line iLine = SciCall_LineFromPosition(iCurrentPos);
@@ -1653,6 +2773,7 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 
 	bool retry = true;
 	uint32_t ignoredStyleMask[8]{};
+	uint8_t wordClass = DocWordClass_All;
 	const bool bScanWordsInDocument = (autoCompletionConfig.iCompleteOption & AutoCompletionOption_ScanWordsInDocument) != 0;
 	if (pLexCurrent->lexerAttr & LexerAttr_PlainTextFile) {
 		if (!bScanWordsInDocument
@@ -1668,17 +2789,21 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 		}
 		if (retry && bScanWordsInDocument) {
 			memcpy(ignoredStyleMask, IgnoreWordStyleMask, sizeof(IgnoreWordStyleMask));
+			wordClass = DocWordClass_All & ~DocWordClass_Ignored;
 			if (!(autoCompletionConfig.fScanWordScope & AutoCompleteScope_Commont) && !IsCommentStyle(iCurrentStyle)) {
+				wordClass &= ~DocWordClass_Comment;
 				for (UINT i = 0; i < 8; i++) {
 					ignoredStyleMask[i] |= CommentStyleMask[i];
 				}
 			}
 			if (!(autoCompletionConfig.fScanWordScope & AutoCompleteScope_String) && !BitTestEx(AllStringStyleMask, iCurrentStyle)) {
+				wordClass &= ~DocWordClass_String;
 				for (UINT i = 0; i < 8; i++) {
 					ignoredStyleMask[i] |= AllStringStyleMask[i];
 				}
 			}
 			if (!(autoCompletionConfig.fScanWordScope & AutoCompleteScope_PlainText) && !BitTestEx(PlainTextStyleMask, iCurrentStyle)) {
+				wordClass &= ~DocWordClass_PlainText;
 				for (UINT i = 0; i < 8; i++) {
 					ignoredStyleMask[i] |= PlainTextStyleMask[i];
 				}
@@ -1686,6 +2811,26 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 		}
 	}
 
+	if (retry && bScanWordsInDocument && prefix == '\0' && iRootLen >= NP2_AUTOC_FUZZY_MIN_ROOT_LENGTH
+		&& (autoCompletionConfig.iCompleteOption & AutoCompletionOption_FuzzyMatch) != 0
+		&& IsDocWordChar(static_cast<uint8_t>(pRoot[0]))) {
+		if (docWordIndex.IsReady()) {
+			UINT count = 0;
+			char *pList = AutoC_GetFuzzyList(pRoot.data(), iRootLen, wordClass, iStartWordPos, &count);
+			if (pList) {
+				// list is rebuilt on each character, Scintilla only filter it by prefix
+				autoCompleteFuzzyList = true;
+				autoCompletionConfig.iPreviousItemCount = count;
+				SciCall_AutoCSetOptions(SC_AUTOCOMPLETE_FIXED_SIZE | SC_AUTOCOMPLETE_SELECT_FIRST_ITEM);
+				SciCall_AutoCSetOrder(SC_ORDER_CUSTOM);
+				AutoC_ShowList(iRootLen, pList, count, bIgnoreCase, autoInsert);
+				NP2HeapFree(pList);
+				pWList.Free();
+				return true;
+			}
+		}
+	}
+
 	while (retry) {
 		if (!bIgnoreLexer) {
 			// keywords
@@ -1693,11 +2838,14 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 		}
 		if (bScanWordsInDocument) {
 			if (!bIgnoreDoc || pWList.nWordCount == 0) {
-				AutoC_AddDocWord(pWList, ignoredStyleMask, bIgnoreCase, prefix);
+				AutoC_AddDocWord(pWList, ignoredStyleMask, wordClass, bIgnoreCase, prefix);
 			}
 			if (prefix && pWList.nWordCount == 0) {
 				prefix = '\0';
-				AutoC_AddDocWord(pWList, ignoredStyleMask, bIgnoreCase, prefix);
+				AutoC_AddDocWord(pWList, ignoredStyleMask, wordClass, bIgnoreCase, prefix);
+			}
+			if (prefix == '\0' && iRootLen != 0 && (autoCompletionConfig.iCompleteOption & AutoCompletionOption_ScanProjectFiles) != 0) {
+				AutoC_AddProjectWord(pWList);
 			}
 		}
 
@@ -1727,27 +2875,17 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 #endif
 
 	const bool bShow = pWList.nWordCount > 0 && !(pWList.nWordCount == 1 && pWList.nTotalLen == static_cast<UINT>(iRootLen + 1));
-	const bool bUpdated = (autoCompletionConfig.iPreviousItemCount == 0)
-		// deleted some words. leave some words that no longer matches current input at the top.
-		|| (iCondition == AutoCompleteCondition_OnCharAdded && autoCompletionConfig.iPreviousItemCount - pWList.nWordCount > autoCompletionConfig.iVisibleItemCount)
+	const bool bUpdated = (autoCompletionConfig.iPreviousItemCount == 0) || autoCompleteFuzzyList
 		// added some words. TODO: check top matched items before updating, if top items not changed, delay the update.
 		|| (iCondition == AutoCompleteCondition_OnCharDeleted && autoCompletionConfig.iPreviousItemCount < pWList.nWordCount);
 
 	if (bShow && bUpdated) {
+		autoCompleteFuzzyList = false;
 		autoCompletionConfig.iPreviousItemCount = pWList.nWordCount;
 		char *pList = pWList.GetList();
-		SciCall_AutoCSetOptions(SC_AUTOCOMPLETE_FIXED_SIZE);
-		//SciCall_AutoCSetOrder(SC_ORDER_PRESORTED); // pre-sorted is default
-		SciCall_AutoCSetIgnoreCase(bIgnoreCase); // case sensitivity
-		SciCall_AutoCSetCaseInsensitiveBehaviour(bIgnoreCase);
-		//SciCall_AutoCSetSeparator('\n');
-		//SciCall_AutoCSetTypeSeparator('\t');
-		SciCall_AutoCSetFillUps(autoCompletionConfig.szAutoCompleteFillUp);
-		//SciCall_AutoCSetDropRestOfWord(true); // delete orginal text: pRoot
-		SciCall_AutoCSetMaxHeight(min(pWList.nWordCount, autoCompletionConfig.iVisibleItemCount)); // visible rows
-		SciCall_AutoCSetCancelAtStart(false); // don't cancel the list when deleting character
-		SciCall_AutoCSetChooseSingle(autoInsert);
-		SciCall_AutoCShow(pWList.iStartLen, pList);
+		SciCall_AutoCSetOptions(SC_AUTOCOMPLETE_FIXED_SIZE | SC_AUTOCOMPLETE_FILTER_LIST);
+		SciCall_AutoCSetOrder(SC_ORDER_PRESORTED);
+		AutoC_ShowList(pWList.iStartLen, pList, pWList.nWordCount, bIgnoreCase, autoInsert);
 		NP2HeapFree(pList);
 	}
 
@@ -1756,11 +2894,9 @@ static bool EditCompleteWordCore(int iCondition, bool autoInsert) noexcept {
 }
 
 void EditCompleteWord(int iCondition, bool autoInsert) noexcept {
-	if (iCondition == AutoCompleteCondition_OnCharAdded) {
-		if (autoCompletionConfig.iPreviousItemCount <= 2*autoCompletionConfig.iVisibleItemCount) {
-			return;
-		}
-		// too many words in auto-completion list, recreate it.
+	if (iCondition == AutoCompleteCondition_OnCharAdded && !autoCompleteFuzzyList) {
+		// list is narrowed by Scintilla with SC_AUTOCOMPLETE_FILTER_LIST
+		return;
 	}
 
 	if (iCondition == AutoCompleteCondition_Normal) {
@@ -1769,6 +2905,7 @@ void EditCompleteWord(int iCondition, bool autoInsert) noexcept {
 
 	const bool bShow = EditCompleteWordCore(iCondition, autoInsert);
 	if (!bShow) {
+		autoCompleteFuzzyList = false;
 		autoCompletionConfig.iPreviousItemCount = 0;
 		if (iCondition != AutoCompleteCondition_Normal) {
 			SciCall_AutoCCancel();
@@ -1776,6 +2913,33 @@ void EditCompleteWord(int iCondition, bool autoInsert) noexcept {
 	}
 }
 
+// completion on typing is deferred until message queue is empty,
+// newer keystroke replaces previous request, stale request is dropped.
+static struct AutoCompleteRequest {
+	Sci_Position position;
+	Sci_Position length;
+} autoCompleteRequest;
+bool autoCompletePending;
+
+void EditCompleteWordOnTyping() noexcept {
+	autoCompleteRequest.position = SciCall_GetCurrentPos();
+	autoCompleteRequest.length = SciCall_GetLength();
+	autoCompletePending = true;
+}
+
+void EditCompleteWordContinue(HANDLE timer) noexcept {
+	UNREFERENCED_PARAMETER(timer);
+	autoCompletePending = false;
+	// caret moved or text changed by other command
+	if (SciCall_GetCurrentPos() != autoCompleteRequest.position
+		|| SciCall_GetLength() != autoCompleteRequest.length
+		|| !SciCall_IsSelectionEmpty()) {
+		return;
+	}
+	const int iCondition = SciCall_AutoCActive() ? AutoCompleteCondition_OnCharAdded : AutoCompleteCondition_Normal;
+	EditCompleteWord(iCondition, false);
+}
+
 static bool CanAutoCloseSingleQuote(int chPrev, int iCurrentStyle) noexcept {
 	const int iLexer = pLexCurrent->iLexer;
 	if (iCurrentStyle == 0) {
@@ -1925,9 +3089,9 @@ void EditAutoCloseBraceQuote(int ch, AutoInsertCharacter what) noexcept {
 }
 
 void EditAutoCloseXMLTag() noexcept {
-	char tchBuf[512];
+	constexpr Sci_Position maxTagLength = 511;
 	const Sci_Position iCurPos = SciCall_GetCurrentPos();
-	const Sci_Position iStartPos = max<Sci_Position>(0, iCurPos - (COUNTOF(tchBuf) - 1));
+	const Sci_Position iStartPos = max<Sci_Position>(0, iCurPos - maxTagLength);
 	const Sci_Position iSize = iCurPos - iStartPos;
 	bool shouldAutoClose = false;
 	bool autoClosed = false;
@@ -1962,21 +3126,22 @@ void EditAutoCloseXMLTag() noexcept {
 	}
 
 	if (shouldAutoClose) {
-		const Sci_TextRangeFull tr = { { iStartPos, iCurPos }, tchBuf };
-		SciCall_GetTextRangeFull(&tr);
+		// text before caret is contiguous after typing, read it in place without copying
+		const char * const text = SciCall_GetRangePointer(iStartPos, iSize);
+		const char * const textEnd = text + iSize;
 
-		if (tchBuf[iSize - 2] != '/') {
-			char tchIns[COUNTOF(tchBuf) + 4]{};
+		if (text[iSize - 2] != '/') {
+			char tchIns[maxTagLength + 5]{};
 			tchIns[0] = '<';
 			tchIns[1] = ' ';
 			int cchIns = 2;
-			const char *pCur = tchBuf + iSize - 2;
-			while (pCur > tchBuf && *pCur != '<' && *pCur != '>') {
+			const char *pCur = text + iSize - 2;
+			while (pCur > text && *pCur != '<' && *pCur != '>') {
 				--pCur;
 			}
 
 			if (*pCur == '<') {
-				const Sci_Position iPos = iStartPos + (pCur - tchBuf);
+				const Sci_Position iPos = iStartPos + (pCur - text);
 				const int style = SciCall_GetStyleIndexAt(iPos);
 				if (style) {
 					if (style == pLexCurrent->operatorStyle || style == pLexCurrent->operatorStyle2) {
@@ -1989,7 +3154,7 @@ void EditAutoCloseXMLTag() noexcept {
 				}
 
 				pCur++;
-				while (IsHtmlTagChar(*pCur)) {
+				while (pCur < textEnd && IsHtmlTagChar(*pCur)) {
 					tchIns[cchIns++] = *pCur;
 					pCur++;
 				}
@@ -2947,6 +4112,11 @@ void EditInsertScriptShebangLine() noexcept {
 }
 
 void InitAutoCompletionCache(LPCEDITLEXER pLex) noexcept {
+	// word characters and style classes changed
+	EditWordIndexReset();
+	EditOutlineReset();
+	EditHyperlinkReset();
+	EditPrintReset();
 	np2_LexKeyword = nullptr;
 	memset(CharacterPrefixMask, 0, sizeof(CharacterPrefixMask));
 	memset(RawStringStyleMask, 0, sizeof(RawStringStyleMask));
@@ -0,0 +1,1358 @@
+// Edit Compare
+
+#include <windows.h>
+#include <shlwapi.h>
+#include <shellapi.h>
+#include <commdlg.h>
+#include <cstdio>
+#include <cinttypes>
+#include "SciCall.h"
+#include "VectorISA.h"
+#include "Helpers.h"
+#include "Notepad4.h"
+#include "Edit.h"
+#include "Styles.h"
+#include "Dialogs.h"
+#include "resource.h"
+
+extern DWORD dwLastIOError;
+extern bool bUseXPFileDialog;
+
+// Texts are compared line by line, line ending is not compared and the empty
+// line after last line ending is ignored:
+// 1. lines are split and hashed on thread pool.
+// 2. common head and tail lines are skipped, identical lines in the remaining
+//    lines are mapped to same id.
+// 3. ids are compared with linear space Myers diff, sub-ranges split by middle
+//    snake are independent and solved on thread pool.
+// 4. differences are shown with markers, changed part of paired lines is marked
+//    with indicator.
+
+// text is split into chunks at line starts, each chunk is scanned twice:
+// first to count lines, then to fill line start and hash.
+#define MIN_PARALLEL_COMPARE_SPLIT_SIZE		(4U << 20)
+#define PARALLEL_COMPARE_SPLIT_CHUNK_SIZE	(1U << 20)
+// sub-range with fewer lines is solved by current thread
+#define MIN_PARALLEL_COMPARE_LINE_COUNT		(1U << 12)
+// edit cost after which middle snake is approximated with the furthest reaching path
+#define MIN_COMPARE_COST_LIMIT				256
+// upper bound of the cost limit, keeps very different texts compared in seconds
+#define MAX_COMPARE_COST_LIMIT				512
+#define MAX_COMPARE_FILE_SIZE				(1U << 31)
+#define COMPARE_CONTEXT_LINE_COUNT			3
+#define COMPARE_RANGE_CACHE_COUNT			256
+
+#define CompareMarkerAddedColor		RGB(0x40, 0xC0, 0x40)
+#define CompareMarkerDeletedColor	RGB(0xFF, 0x40, 0x40)
+#define CompareMarkerChangedColor	RGB(0xFF, 0xC0, 0x00)
+#define CompareMarkerAlpha			0x40
+#define CompareIndicatorColor		RGB(0xFF, 0x80, 0x00)
+#define CompareIndicatorAlpha		0x60
+
+namespace {
+
+enum CompareMode {
+	CompareMode_None,
+	CompareMode_File,
+	CompareMode_Selections,
+};
+
+CompareMode compareMode;
+WCHAR szCompareFile[MAX_PATH];
+
+struct CompareText {
+	const char *text;
+	size_t length;
+	Sci_Position position;	// document position of text
+	Sci_Line line;			// document line of first line
+	size_t lineCount;
+	size_t *lineStart;		// lineCount + 1 entries
+	UINT *lineHash;			// hash of line content, then replaced by line id
+	uint8_t *changed;		// line is inserted or deleted
+
+	size_t LineEnd(size_t index) const noexcept {
+		const size_t start = lineStart[index];
+		size_t end = lineStart[index + 1];
+		if (end > start && text[end - 1] == '\n') {
+			--end;
+		}
+		if (end > start && text[end - 1] == '\r') {
+			--end;
+		}
+		return end;
+	}
+	bool Split() noexcept;
+	void Free() noexcept {
+		if (lineStart != nullptr) {
+			NP2HeapFree(lineStart);
+		}
+		if (lineHash != nullptr) {
+			NP2HeapFree(lineHash);
+		}
+		if (changed != nullptr) {
+			NP2HeapFree(changed);
+		}
+	}
+};
+
+// returns position of next CR or LF, or end when not found.
+size_t Compare_FindLineEnd(const char *text, size_t pos, size_t end) noexcept {
+#if NP2_USE_AVX2
+	const __m256i vectCR = _mm256_set1_epi8('\r');
+	const __m256i vectLF = _mm256_set1_epi8('\n');
+	while (pos + sizeof(__m256i) <= end) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + pos));
+		const uint32_t mask = mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, vectCR), _mm256_cmpeq_epi8(chunk, vectLF)));
+		if (mask != 0) {
+			return pos + np2::ctz(mask);
+		}
+		pos += sizeof(__m256i);
+	}
+#elif NP2_USE_SSE2
+	const __m128i vectCR = _mm_set1_epi8('\r');
+	const __m128i vectLF = _mm_set1_epi8('\n');
+	while (pos + sizeof(__m128i) <= end) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + pos));
+		const uint32_t mask = mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, vectCR), _mm_cmpeq_epi8(chunk, vectLF)));
+		if (mask != 0) {
+			return pos + np2::ctz(mask);
+		}
+		pos += sizeof(__m128i);
+	}
+#endif
+	while (pos < end && text[pos] != '\r' && text[pos] != '\n') {
+		++pos;
+	}
+	return pos;
+}
+
+UINT Compare_HashLine(const char *text, size_t length) noexcept {
+	uint64_t hash = UINT64_C(0x9E3779B97F4A7C15) ^ length;
+	while (length >= sizeof(uint64_t)) {
+		uint64_t value;
+		memcpy(&value, text, sizeof(uint64_t));
+		hash = ((hash << 5) | (hash >> 59)) ^ value;
+		hash *= UINT64_C(0x100000001B3);
+		text += sizeof(uint64_t);
+		length -= sizeof(uint64_t);
+	}
+	if (length != 0) {
+		uint64_t value = 0;
+		memcpy(&value, text, length);
+		hash = ((hash << 5) | (hash >> 59)) ^ value;
+		hash *= UINT64_C(0x100000001B3);
+	}
+	hash ^= hash >> 29;
+	return static_cast<UINT>(hash ^ (hash >> 32));
+}
+
+// returns count of line endings in [pos, end), fills line start and hash when lineStart is not null.
+size_t Compare_ScanLines(const char *text, size_t pos, size_t end, size_t *lineStart, UINT *lineHash) noexcept {
+	size_t count = 0;
+	while (true) {
+		const size_t lineEnd = Compare_FindLineEnd(text, pos, end);
+		if (lineEnd == end) {
+			break;
+		}
+		if (lineStart != nullptr) {
+			lineStart[count] = pos;
+			lineHash[count] = Compare_HashLine(text + pos, lineEnd - pos);
+		}
+		++count;
+		pos = lineEnd + 1;
+		if (text[lineEnd] == '\r' && pos < end && text[pos] == '\n') {
+			++pos;
+		}
+	}
+	return count;
+}
+
+struct LineSplitWorker {
+	CompareText &text;
+	UINT chunkCount;
+	LONG nextChunk;
+	size_t *chunkStart;	// chunkCount + 1 entries
+	size_t *chunkLine;	// line count of each chunk, then first line of each chunk
+
+	void DoWork() noexcept {
+		while (true) {
+			const UINT index = static_cast<UINT>(InterlockedIncrement(&nextChunk) - 1);
+			if (index >= chunkCount) {
+				break;
+			}
+			const size_t start = chunkStart[index];
+			const size_t end = chunkStart[index + 1];
+			if (text.lineStart == nullptr) {
+				chunkLine[index + 1] = Compare_ScanLines(text.text, start, end, nullptr, nullptr);
+			} else {
+				const size_t line = chunkLine[index];
+				Compare_ScanLines(text.text, start, end, text.lineStart + line, text.lineHash + line);
+			}
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		LineSplitWorker *worker = static_cast<LineSplitWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+bool CompareText::Split() noexcept {
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), static_cast<UINT>(length/PARALLEL_COMPARE_SPLIT_CHUNK_SIZE));
+	PTP_WORK work = nullptr;
+	UINT chunkCount = 1;
+	if (length >= MIN_PARALLEL_COMPARE_SPLIT_SIZE && threadCount > 1) {
+		chunkCount = static_cast<UINT>((length + PARALLEL_COMPARE_SPLIT_CHUNK_SIZE - 1)/PARALLEL_COMPARE_SPLIT_CHUNK_SIZE);
+	}
+
+	size_t * const chunkStart = static_cast<size_t *>(NP2HeapAlloc((chunkCount + 1)*2*sizeof(size_t)));
+	LineSplitWorker worker { *this, chunkCount, 0, chunkStart, chunkStart + chunkCount + 1 };
+	// move chunk boundary after line ending
+	for (UINT index = 1; index < chunkCount; index++) {
+		size_t pos = Compare_FindLineEnd(text, static_cast<size_t>(index)*PARALLEL_COMPARE_SPLIT_CHUNK_SIZE, length);
+		if (pos < length) {
+			pos += 1 + (text[pos] == '\r' && pos + 1 < length && text[pos + 1] == '\n');
+		}
+		chunkStart[index] = pos;
+	}
+	chunkStart[chunkCount] = length;
+	if (chunkCount > 1) {
+		work = CreateThreadpoolWork(LineSplitWorker::WorkCallback, &worker, nullptr);
+	}
+
+	// count lines, then fill line start and hash
+	for (int pass = 0; pass < 2; pass++) {
+		worker.nextChunk = 0;
+		if (work == nullptr) {
+			worker.DoWork();
+		} else {
+			for (UINT i = 1; i < threadCount; i++) {
+				SubmitThreadpoolWork(work);
+			}
+			worker.DoWork();
+			WaitForThreadpoolWorkCallbacks(work, FALSE);
+		}
+		if (pass == 0) {
+			size_t *chunkLine = worker.chunkLine;
+			for (UINT index = 0; index < chunkCount; index++) {
+				chunkLine[index + 1] += chunkLine[index];
+			}
+			lineCount = chunkLine[chunkCount];
+			lineStart = static_cast<size_t *>(NP2HeapAlloc((lineCount + 2)*sizeof(size_t)));
+			lineHash = static_cast<UINT *>(NP2HeapAlloc((lineCount + 1)*sizeof(UINT)));
+			changed = static_cast<uint8_t *>(NP2HeapAlloc(lineCount + 1));
+			if (lineStart == nullptr || lineHash == nullptr || changed == nullptr) {
+				break;
+			}
+		}
+	}
+	if (work != nullptr) {
+		CloseThreadpoolWork(work);
+	}
+	NP2HeapFree(chunkStart);
+	if (lineStart == nullptr || lineHash == nullptr || changed == nullptr) {
+		Free();
+		lineStart = nullptr;
+		lineHash = nullptr;
+		changed = nullptr;
+		return false;
+	}
+
+	// last line without line ending
+	size_t start = length;
+	while (start != 0 && text[start - 1] != '\r' && text[start - 1] != '\n') {
+		--start;
+	}
+	if (start < length) {
+		lineStart[lineCount] = start;
+		lineHash[lineCount] = Compare_HashLine(text + start, length - start);
+		++lineCount;
+	}
+	lineStart[lineCount] = length;
+	return true;
+}
+
+bool Compare_LineContentEqual(const CompareText &text1, size_t line1, const CompareText &text2, size_t line2) noexcept {
+	const size_t start1 = text1.lineStart[line1];
+	const size_t start2 = text2.lineStart[line2];
+	const size_t length = text1.LineEnd(line1) - start1;
+	return length == text2.LineEnd(line2) - start2 && memcmp(text1.text + start1, text2.text + start2, length) == 0;
+}
+
+inline bool Compare_LineEqual(const CompareText &text1, size_t line1, const CompareText &text2, size_t line2) noexcept {
+	return text1.lineHash[line1] == text2.lineHash[line2] && Compare_LineContentEqual(text1, line1, text2, line2);
+}
+
+struct LineClass {
+	UINT hash;
+	UINT side;
+	size_t line;
+};
+
+// map lines in [head, lineCount - tail) to id starts from 1, identical lines share same id.
+// returns number of distinct lines, or zero on failure.
+UINT Compare_MapLineId(CompareText (&texts)[2], size_t head, size_t tail) noexcept {
+	const size_t total = texts[0].lineCount + texts[1].lineCount - 2*(head + tail);
+	if (total >= (1U << 30)) {
+		return 0;
+	}
+	UINT capacity = 64;
+	while (capacity < total*2) {
+		capacity <<= 1;
+	}
+	UINT * const table = static_cast<UINT *>(NP2HeapAlloc(capacity*sizeof(UINT)));
+	LineClass * const classes = static_cast<LineClass *>(NP2HeapAlloc(total*sizeof(LineClass) + sizeof(LineClass)));
+	if (table == nullptr || classes == nullptr) {
+		if (table != nullptr) {
+			NP2HeapFree(table);
+		}
+		if (classes != nullptr) {
+			NP2HeapFree(classes);
+		}
+		return 0;
+	}
+
+	UINT classCount = 0;
+	for (UINT side = 0; side < 2; side++) {
+		CompareText &text = texts[side];
+		const size_t last = text.lineCount - tail;
+		for (size_t line = head; line < last; line++) {
+			const UINT hash = text.lineHash[line];
+			UINT index = hash & (capacity - 1);
+			UINT id;
+			// open addressing with linear probing, slot stores id + 1
+			while ((id = table[index]) != 0) {
+				const LineClass &lc = classes[id - 1];
+				if (lc.hash == hash && Compare_LineContentEqual(texts[lc.side], lc.line, text, line)) {
+					break;
+				}
+				index = (index + 1) & (capacity - 1);
+			}
+			if (id == 0) {
+				classes[classCount] = { hash, side, line };
+				++classCount;
+				id = classCount;
+				table[index] = id;
+			}
+			text.lineHash[line] = id;
+		}
+	}
+
+	NP2HeapFree(table);
+	NP2HeapFree(classes);
+	return classCount;
+}
+
+struct DiffRange {
+	ptrdiff_t off1;
+	ptrdiff_t lim1;
+	ptrdiff_t off2;
+	ptrdiff_t lim2;
+	bool needMin;	// find minimal edit script without approximation
+};
+
+struct DiffBuffer {
+	ptrdiff_t *data;
+	size_t size;
+};
+
+struct DiffWorker {
+	const UINT *ids1;
+	const UINT *ids2;
+	uint8_t *changed1;
+	uint8_t *changed2;
+	ptrdiff_t costLimit;
+	bool parallel;
+	UINT activeCount;
+	UINT rangeCount;
+	DiffRange *ranges;
+	SRWLOCK lock;
+	CONDITION_VARIABLE rangeReady;
+
+	void Split(const DiffRange &range, DiffRange &low, DiffRange &high, ptrdiff_t *buffer) const noexcept;
+	void Solve(DiffRange range, DiffBuffer &buffer) noexcept;
+	void Push(const DiffRange &range) noexcept {
+		AcquireSRWLockExclusive(&lock);
+		ranges[rangeCount] = range;
+		++rangeCount;
+		ReleaseSRWLockExclusive(&lock);
+		WakeConditionVariable(&rangeReady);
+	}
+	void DoWork() noexcept;
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		DiffWorker *worker = static_cast<DiffWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+// find middle snake, see xdl_split() in xdiff.
+void DiffWorker::Split(const DiffRange &range, DiffRange &low, DiffRange &high, ptrdiff_t *buffer) const noexcept {
+	const ptrdiff_t off1 = range.off1;
+	const ptrdiff_t lim1 = range.lim1;
+	const ptrdiff_t off2 = range.off2;
+	const ptrdiff_t lim2 = range.lim2;
+	const ptrdiff_t dmin = off1 - lim2;
+	const ptrdiff_t dmax = lim1 - off2;
+	const ptrdiff_t fmid = off1 - off2;
+	const ptrdiff_t bmid = lim1 - lim2;
+	const bool odd = ((fmid - bmid) & 1) != 0;
+	// furthest reaching x on diagonal [dmin - 1, dmax + 1] for forward and backward path
+	ptrdiff_t * const kvdf = buffer + (1 - dmin);
+	ptrdiff_t * const kvdb = kvdf + (dmax - dmin + 3);
+	ptrdiff_t fmin = fmid;
+	ptrdiff_t fmax = fmid;
+	ptrdiff_t bmin = bmid;
+	ptrdiff_t bmax = bmid;
+	kvdf[fmid] = off1;
+	kvdb[bmid] = lim1;
+
+	ptrdiff_t x;
+	ptrdiff_t y;
+	bool minLow = true;
+	bool minHigh = true;
+	for (ptrdiff_t cost = 1; ; cost++) {
+		if (fmin > dmin) {
+			kvdf[--fmin - 1] = -1;
+		} else {
+			++fmin;
+		}
+		if (fmax < dmax) {
+			kvdf[++fmax + 1] = -1;
+		} else {
+			--fmax;
+		}
+		for (ptrdiff_t d = fmax; d >= fmin; d -= 2) {
+			x = (kvdf[d - 1] >= kvdf[d + 1]) ? kvdf[d - 1] + 1 : kvdf[d + 1];
+			y = x - d;
+			while (x < lim1 && y < lim2 && ids1[x] == ids2[y]) {
+				++x;
+				++y;
+			}
+			kvdf[d] = x;
+			if (odd && bmin <= d && d <= bmax && kvdb[d] <= x) {
+				goto labelFound;
+			}
+		}
+
+		if (bmin > dmin) {
+			kvdb[--bmin - 1] = PTRDIFF_MAX;
+		} else {
+			++bmin;
+		}
+		if (bmax < dmax) {
+			kvdb[++bmax + 1] = PTRDIFF_MAX;
+		} else {
+			--bmax;
+		}
+		for (ptrdiff_t d = bmax; d >= bmin; d -= 2) {
+			x = (kvdb[d - 1] < kvdb[d + 1]) ? kvdb[d - 1] : kvdb[d + 1] - 1;
+			y = x - d;
+			while (x > off1 && y > off2 && ids1[x - 1] == ids2[y - 1]) {
+				--x;
+				--y;
+			}
+			kvdb[d] = x;
+			if (!odd && fmin <= d && d <= fmax && x <= kvdf[d]) {
+				goto labelFound;
+			}
+		}
+
+		if (!range.needMin && cost >= costLimit) {
+			// split at the furthest reaching point, the part before forward point
+			// (or after backward point) is solved with minimal cost.
+			ptrdiff_t fbest = -1;
+			ptrdiff_t fbestX = -1;
+			for (ptrdiff_t d = fmax; d >= fmin; d -= 2) {
+				x = min(kvdf[d], lim1);
+				y = x - d;
+				if (lim2 < y) {
+					x = lim2 + d;
+					y = lim2;
+				}
+				if (fbest < x + y) {
+					fbest = x + y;
+					fbestX = x;
+				}
+			}
+			ptrdiff_t bbest = PTRDIFF_MAX;
+			ptrdiff_t bbestX = PTRDIFF_MAX;
+			for (ptrdiff_t d = bmax; d >= bmin; d -= 2) {
+				x = max(off1, kvdb[d]);
+				y = x - d;
+				if (y < off2) {
+					x = off2 + d;
+					y = off2;
+				}
+				if (x + y < bbest) {
+					bbest = x + y;
+					bbestX = x;
+				}
+			}
+			if ((lim1 + lim2) - bbest < fbest - (off1 + off2)) {
+				x = fbestX;
+				y = fbest - fbestX;
+				minHigh = false;
+			} else {
+				x = bbestX;
+				y = bbest - bbestX;
+				minLow = false;
+			}
+			break;
+		}
+	}
+
+labelFound:
+	low = { off1, x, off2, y, minLow };
+	high = { x, lim1, y, lim2, minHigh };
+}
+
+void DiffWorker::Solve(DiffRange range, DiffBuffer &buffer) noexcept {
+	while (true) {
+		// skip common head and tail
+		while (range.off1 < range.lim1 && range.off2 < range.lim2 && ids1[range.off1] == ids2[range.off2]) {
+			++range.off1;
+			++range.off2;
+		}
+		while (range.off1 < range.lim1 && range.off2 < range.lim2 && ids1[range.lim1 - 1] == ids2[range.lim2 - 1]) {
+			--range.lim1;
+			--range.lim2;
+		}
+		if (range.off1 == range.lim1) {
+			memset(changed2 + range.off2, 1, range.lim2 - range.off2);
+			return;
+		}
+		if (range.off2 == range.lim2) {
+			memset(changed1 + range.off1, 1, range.lim1 - range.off1);
+			return;
+		}
+
+		const size_t size = 2*((range.lim1 - range.off1) + (range.lim2 - range.off2) + 3);
+		if (size > buffer.size) {
+			if (buffer.data != nullptr) {
+				NP2HeapFree(buffer.data);
+			}
+			buffer.data = static_cast<ptrdiff_t *>(NP2HeapAlloc(size*sizeof(ptrdiff_t)));
+			buffer.size = (buffer.data == nullptr) ? 0 : size;
+			if (buffer.data == nullptr) {
+				// treat all lines as changed
+				memset(changed1 + range.off1, 1, range.lim1 - range.off1);
+				memset(changed2 + range.off2, 1, range.lim2 - range.off2);
+				return;
+			}
+		}
+
+		DiffRange low;
+		DiffRange high;
+		Split(range, low, high, buffer.data);
+		// recursion on smaller part to bound stack depth
+		const bool lowSmaller = (low.lim1 - low.off1) + (low.lim2 - low.off2) < (high.lim1 - high.off1) + (high.lim2 - high.off2);
+		const DiffRange &small = lowSmaller ? low : high;
+		const DiffRange &large = lowSmaller ? high : low;
+		if (parallel && (large.lim1 - large.off1) + (large.lim2 - large.off2) >= MIN_PARALLEL_COMPARE_LINE_COUNT) {
+			Push(large);
+			range = small;
+		} else {
+			Solve(small, buffer);
+			range = large;
+		}
+	}
+}
+
+void DiffWorker::DoWork() noexcept {
+	DiffBuffer buffer { nullptr, 0 };
+	AcquireSRWLockExclusive(&lock);
+	while (true) {
+		if (rangeCount != 0) {
+			--rangeCount;
+			const DiffRange range = ranges[rangeCount];
+			++activeCount;
+			ReleaseSRWLockExclusive(&lock);
+			Solve(range, buffer);
+			AcquireSRWLockExclusive(&lock);
+			--activeCount;
+			if (activeCount == 0 && rangeCount == 0) {
+				WakeAllConditionVariable(&rangeReady);
+			}
+		} else if (activeCount == 0) {
+			break;
+		} else {
+			SleepConditionVariableSRW(&rangeReady, &lock, INFINITE, 0);
+		}
+	}
+	ReleaseSRWLockExclusive(&lock);
+	if (buffer.data != nullptr) {
+		NP2HeapFree(buffer.data);
+	}
+}
+
+// compare lines in [head, lineCount - tail), set changed flag for inserted and deleted lines.
+void Compare_Diff(CompareText (&texts)[2], size_t head, size_t tail, UINT classCount) noexcept {
+	// lines not found in other text are always changed, see xdl_cleanup_records() in xdiff.
+	// remaining lines are compacted and compared, which reduces cost for very different texts.
+	const size_t middle = texts[0].lineCount + texts[1].lineCount - 2*(head + tail);
+	UINT * const occurrence = static_cast<UINT *>(NP2HeapAlloc(2*(classCount + 1)*sizeof(UINT)));
+	UINT * const ids = static_cast<UINT *>(NP2HeapAlloc(middle*sizeof(UINT) + sizeof(UINT)));
+	size_t * const lineIndex = static_cast<size_t *>(NP2HeapAlloc(middle*sizeof(size_t) + sizeof(size_t)));
+	uint8_t * const changed = static_cast<uint8_t *>(NP2HeapAlloc(middle + 1));
+	if (occurrence == nullptr || ids == nullptr || lineIndex == nullptr || changed == nullptr) {
+		if (occurrence != nullptr) {
+			NP2HeapFree(occurrence);
+		}
+		if (ids != nullptr) {
+			NP2HeapFree(ids);
+		}
+		if (lineIndex != nullptr) {
+			NP2HeapFree(lineIndex);
+		}
+		if (changed != nullptr) {
+			NP2HeapFree(changed);
+		}
+		// treat all lines as changed
+		for (CompareText &text : texts) {
+			memset(text.changed + head, 1, text.lineCount - head - tail);
+		}
+		return;
+	}
+
+	for (UINT side = 0; side < 2; side++) {
+		const CompareText &text = texts[side];
+		const size_t last = text.lineCount - tail;
+		for (size_t line = head; line < last; line++) {
+			++occurrence[2*text.lineHash[line] + side];
+		}
+	}
+	ptrdiff_t count[2];
+	size_t offset = 0;
+	for (UINT side = 0; side < 2; side++) {
+		CompareText &text = texts[side];
+		const size_t last = text.lineCount - tail;
+		const size_t start = offset;
+		for (size_t line = head; line < last; line++) {
+			const UINT id = text.lineHash[line];
+			if (occurrence[2*id + (side ^ 1)] == 0) {
+				text.changed[line] = 1;
+			} else {
+				ids[offset] = id;
+				lineIndex[offset] = line;
+				++offset;
+			}
+		}
+		count[side] = offset - start;
+	}
+	NP2HeapFree(occurrence);
+
+	const ptrdiff_t count1 = count[0];
+	const ptrdiff_t count2 = count[1];
+	const size_t total = offset;
+	// approximate square root of total, see xdl_bogosqrt() in xdiff
+	ptrdiff_t costLimit = 1;
+	for (size_t n = total; n != 0; n >>= 2) {
+		costLimit <<= 1;
+	}
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), static_cast<UINT>(total/MIN_PARALLEL_COMPARE_LINE_COUNT));
+	DiffWorker worker {
+		ids, ids + count1,
+		changed, changed + count1,
+		clamp<ptrdiff_t>(costLimit, MIN_COMPARE_COST_LIMIT, MAX_COMPARE_COST_LIMIT), false, 0, 0, nullptr,
+		SRWLOCK_INIT, CONDITION_VARIABLE_INIT
+	};
+	PTP_WORK work = nullptr;
+	const DiffRange range { 0, count1, 0, count2, false };
+	if (threadCount > 1) {
+		// ranges in the stack are disjoint, each has at least MIN_PARALLEL_COMPARE_LINE_COUNT lines
+		worker.ranges = static_cast<DiffRange *>(NP2HeapAlloc((total/MIN_PARALLEL_COMPARE_LINE_COUNT + 1)*sizeof(DiffRange)));
+		if (worker.ranges != nullptr) {
+			work = CreateThreadpoolWork(DiffWorker::WorkCallback, &worker, nullptr);
+		}
+	}
+	if (work == nullptr) {
+		DiffBuffer buffer { nullptr, 0 };
+		worker.Solve(range, buffer);
+		if (buffer.data != nullptr) {
+			NP2HeapFree(buffer.data);
+		}
+	} else {
+		worker.parallel = true;
+		worker.ranges[0] = range;
+		worker.rangeCount = 1;
+		for (UINT i = 1; i < threadCount; i++) {
+			SubmitThreadpoolWork(work);
+		}
+		worker.DoWork();
+		WaitForThreadpoolWorkCallbacks(work, FALSE);
+		CloseThreadpoolWork(work);
+	}
+	if (worker.ranges != nullptr) {
+		NP2HeapFree(worker.ranges);
+	}
+
+	for (size_t index = 0; index < total; index++) {
+		CompareText &text = texts[index >= static_cast<size_t>(count1)];
+		text.changed[lineIndex[index]] = changed[index];
+	}
+	NP2HeapFree(ids);
+	NP2HeapFree(lineIndex);
+	NP2HeapFree(changed);
+}
+
+struct DiffHunk {
+	size_t start[2];
+	size_t count[2];
+};
+
+// find hunks of changed lines, hunks is null when texts are identical.
+bool Compare_Run(CompareText (&texts)[2], DiffHunk **hunkList, size_t *hunkCount) noexcept {
+	*hunkList = nullptr;
+	*hunkCount = 0;
+	if (!texts[0].Split() || !texts[1].Split()) {
+		return false;
+	}
+
+	const size_t lineCount1 = texts[0].lineCount;
+	const size_t lineCount2 = texts[1].lineCount;
+	const size_t minCount = min(lineCount1, lineCount2);
+	size_t head = 0;
+	while (head < minCount && Compare_LineEqual(texts[0], head, texts[1], head)) {
+		++head;
+	}
+	size_t tail = 0;
+	while (tail < minCount - head && Compare_LineEqual(texts[0], lineCount1 - tail - 1, texts[1], lineCount2 - tail - 1)) {
+		++tail;
+	}
+	if (head + tail == lineCount1 && head + tail == lineCount2) {
+		return true;
+	}
+	const UINT classCount = Compare_MapLineId(texts, head, tail);
+	if (classCount != 0) {
+		Compare_Diff(texts, head, tail, classCount);
+	} else {
+		// treat all lines as changed
+		memset(texts[0].changed + head, 1, lineCount1 - head - tail);
+		memset(texts[1].changed + head, 1, lineCount2 - head - tail);
+	}
+
+	const uint8_t * const changed1 = texts[0].changed;
+	const uint8_t * const changed2 = texts[1].changed;
+	size_t capacity = 0;
+	DiffHunk *hunks = nullptr;
+	size_t count = 0;
+	size_t line1 = head;
+	size_t line2 = head;
+	const size_t last1 = lineCount1 - tail;
+	const size_t last2 = lineCount2 - tail;
+	while (line1 < last1 || line2 < last2) {
+		if (line1 < last1 && line2 < last2 && !changed1[line1] && !changed2[line2]) {
+			++line1;
+			++line2;
+			continue;
+		}
+		if (count == capacity) {
+			capacity = max<size_t>(capacity*2, 256);
+			DiffHunk *result = static_cast<DiffHunk *>((hunks == nullptr) ? NP2HeapAlloc(capacity*sizeof(DiffHunk)) : NP2HeapReAlloc(hunks, capacity*sizeof(DiffHunk)));
+			if (result == nullptr) {
+				break;
+			}
+			hunks = result;
+		}
+		DiffHunk &hunk = hunks[count++];
+		hunk.start[0] = line1;
+		hunk.start[1] = line2;
+		while (line1 < last1 && changed1[line1]) {
+			++line1;
+		}
+		while (line2 < last2 && changed2[line2]) {
+			++line2;
+		}
+		hunk.count[0] = line1 - hunk.start[0];
+		hunk.count[1] = line2 - hunk.start[1];
+	}
+	*hunkList = hunks;
+	*hunkCount = count;
+	return true;
+}
+
+struct MarkerLineCache {
+	int markerNumber;
+	UINT count;
+	Sci_Line lines[COMPARE_RANGE_CACHE_COUNT + 1];
+
+	void Add(Sci_Line line) noexcept {
+		if (count != 0 && lines[count - 1] == line) {
+			return;
+		}
+		if (count == COMPARE_RANGE_CACHE_COUNT) {
+			Flush();
+		}
+		lines[count++] = line;
+	}
+	void Flush() noexcept {
+		if (count != 0) {
+			lines[count] = -1;
+			SciCall_MarkerAddLines(markerNumber, lines);
+			count = 0;
+		}
+	}
+};
+
+struct IndicatorRangeCache {
+	UINT count;
+	Sci_Position ranges[COMPARE_RANGE_CACHE_COUNT*2];
+
+	void Add(Sci_Position start, Sci_Position length) noexcept {
+		if (count == COMPARE_RANGE_CACHE_COUNT) {
+			Flush();
+		}
+		ranges[2*count] = start;
+		ranges[2*count + 1] = length;
+		++count;
+	}
+	void Flush() noexcept {
+		if (count != 0) {
+			SciCall_IndicatorFillRanges(count, ranges);
+			count = 0;
+		}
+	}
+};
+
+constexpr bool IsUTF8Trail(uint8_t ch) noexcept {
+	return (ch & 0xC0) == 0x80;
+}
+
+// mark the part between common prefix and suffix of paired lines.
+void Compare_MarkChange(const CompareText &text, size_t line, const CompareText &other, size_t otherLine, bool utf8, IndicatorRangeCache &cache) noexcept {
+	const size_t start1 = text.lineStart[line];
+	const size_t start2 = other.lineStart[otherLine];
+	const uint8_t *s1 = reinterpret_cast<const uint8_t *>(text.text + start1);
+	const uint8_t *s2 = reinterpret_cast<const uint8_t *>(other.text + start2);
+	const size_t length1 = text.LineEnd(line) - start1;
+	const size_t length2 = other.LineEnd(otherLine) - start2;
+	const size_t minLength = min(length1, length2);
+	size_t prefix = 0;
+	while (prefix < minLength && s1[prefix] == s2[prefix]) {
+		++prefix;
+	}
+	size_t suffix = 0;
+	while (suffix < minLength - prefix && s1[length1 - suffix - 1] == s2[length2 - suffix - 1]) {
+		++suffix;
+	}
+	if (utf8) {
+		// not split multi-byte character
+		while (prefix != 0 && ((prefix < length1 && IsUTF8Trail(s1[prefix])) || (prefix < length2 && IsUTF8Trail(s2[prefix])))) {
+			--prefix;
+		}
+		while (suffix != 0 && (IsUTF8Trail(s1[length1 - suffix]) || IsUTF8Trail(s2[length2 - suffix]))) {
+			--suffix;
+		}
+	}
+	if (prefix + suffix < length1) {
+		cache.Add(text.position + start1 + prefix, length1 - prefix - suffix);
+	}
+}
+
+void Compare_MarkSide(const CompareText (&texts)[2], UINT side, const DiffHunk *hunks, size_t hunkCount) noexcept {
+	const CompareText &text = texts[side];
+	const CompareText &other = texts[side ^ 1];
+	const bool utf8 = SciCall_GetCodePage() == CP_UTF8;
+	// lines only in old text are deleted, lines only in new text are added
+	MarkerLineCache extra { side ? MarkerNumber_DiffAdded : MarkerNumber_DiffDeleted, 0, {} };
+	MarkerLineCache changed { MarkerNumber_DiffChanged, 0, {} };
+	MarkerLineCache gap { MarkerNumber_DiffGap, 0, {} };
+	IndicatorRangeCache ranges { 0, {} };
+
+	for (size_t i = 0; i < hunkCount; i++) {
+		const DiffHunk &hunk = hunks[i];
+		const size_t start = hunk.start[side];
+		const size_t count = hunk.count[side];
+		const size_t otherStart = hunk.start[side ^ 1];
+		const size_t otherCount = hunk.count[side ^ 1];
+		const size_t paired = min(count, otherCount);
+		for (size_t index = 0; index < paired; index++) {
+			changed.Add(text.line + start + index);
+			Compare_MarkChange(text, start + index, other, otherStart + index, utf8, ranges);
+		}
+		for (size_t index = paired; index < count; index++) {
+			extra.Add(text.line + start + index);
+		}
+		if (otherCount > count) {
+			// underline previous line for lines only in other text
+			gap.Add(text.line + ((start + count == 0) ? 0 : start + count - 1));
+		}
+	}
+
+	extra.Flush();
+	changed.Flush();
+	gap.Flush();
+	SciCall_SetIndicatorCurrent(IndicatorNumber_DiffChange);
+	ranges.Flush();
+}
+
+void Compare_DefineMarkers() noexcept {
+	SciCall_MarkerDefine(MarkerNumber_DiffAdded, SC_MARK_BACKGROUND);
+	SciCall_MarkerSetBackTranslucent(MarkerNumber_DiffAdded, ColorAlpha(CompareMarkerAddedColor, CompareMarkerAlpha));
+	SciCall_MarkerSetLayer(MarkerNumber_DiffAdded, SC_LAYER_OVER_TEXT);
+	SciCall_MarkerDefine(MarkerNumber_DiffDeleted, SC_MARK_BACKGROUND);
+	SciCall_MarkerSetBackTranslucent(MarkerNumber_DiffDeleted, ColorAlpha(CompareMarkerDeletedColor, CompareMarkerAlpha));
+	SciCall_MarkerSetLayer(MarkerNumber_DiffDeleted, SC_LAYER_OVER_TEXT);
+	SciCall_MarkerDefine(MarkerNumber_DiffChanged, SC_MARK_BACKGROUND);
+	SciCall_MarkerSetBackTranslucent(MarkerNumber_DiffChanged, ColorAlpha(CompareMarkerChangedColor, CompareMarkerAlpha));
+	SciCall_MarkerSetLayer(MarkerNumber_DiffChanged, SC_LAYER_OVER_TEXT);
+	SciCall_MarkerDefine(MarkerNumber_DiffGap, SC_MARK_UNDERLINE);
+	SciCall_MarkerSetBackTranslucent(MarkerNumber_DiffGap, ColorAlpha(CompareMarkerDeletedColor, SC_ALPHA_OPAQUE));
+	SciCall_MarkerSetLayer(MarkerNumber_DiffGap, SC_LAYER_OVER_TEXT);
+
+	SciCall_IndicSetStyle(IndicatorNumber_DiffChange, INDIC_FULLBOX);
+	SciCall_IndicSetFore(IndicatorNumber_DiffChange, CompareIndicatorColor);
+	SciCall_IndicSetAlpha(IndicatorNumber_DiffChange, CompareIndicatorAlpha);
+	SciCall_IndicSetOutlineAlpha(IndicatorNumber_DiffChange, CompareIndicatorAlpha);
+}
+
+// read file as text, converted to UTF-8 for UTF-8 document.
+char *Compare_ReadFile(LPCWSTR pszFile, size_t *length) noexcept {
+	HANDLE hFile = CreateFile(pszFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	dwLastIOError = GetLastError();
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return nullptr;
+	}
+
+	LARGE_INTEGER fileSize;
+	fileSize.QuadPart = 0;
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart >= MAX_COMPARE_FILE_SIZE) {
+		dwLastIOError = (fileSize.QuadPart >= MAX_COMPARE_FILE_SIZE) ? ERROR_FILE_TOO_LARGE : GetLastError();
+		CloseHandle(hFile);
+		return nullptr;
+	}
+
+	DWORD cbData = fileSize.LowPart;
+	// NULL padding for IsUTF8Signature() and UTF-16 check
+	char *lpData = static_cast<char *>(NP2HeapAlloc(cbData + 16));
+	DWORD cbRead = 0;
+	const BOOL bReadSuccess = lpData != nullptr && ReadFile(hFile, lpData, cbData, &cbRead, nullptr);
+	dwLastIOError = GetLastError();
+	CloseHandle(hFile);
+	if (!bReadSuccess) {
+		if (lpData != nullptr) {
+			NP2HeapFree(lpData);
+		}
+		return nullptr;
+	}
+
+	cbData = cbRead;
+	const UINT bom = *reinterpret_cast<const uint16_t *>(lpData);
+	if (cbData >= 2 && (bom == BOM_UTF16LE || bom == BOM_UTF16BE)) {
+		LPCWSTR pszTextW = reinterpret_cast<LPCWSTR>(lpData) + 1;
+		const size_t cchTextW = cbData/sizeof(WCHAR) - 1;
+		const bool reverse = bom == BOM_UTF16BE;
+		const size_t cbUTF8 = UTF8LengthFromUTF16(pszTextW, cchTextW, reverse);
+		if (cbUTF8 < MAX_COMPARE_FILE_SIZE) {
+			char *lpDataUTF8 = static_cast<char *>(NP2HeapAlloc(cbUTF8 + 16));
+			if (lpDataUTF8 != nullptr) {
+				cbData = static_cast<DWORD>(UTF16ToUTF8(pszTextW, cchTextW, reverse, lpDataUTF8));
+				NP2HeapFree(lpData);
+				lpData = lpDataUTF8;
+			}
+		}
+	} else if (cbData >= 3 && IsUTF8Signature(lpData)) {
+		cbData -= 3;
+		memmove(lpData, lpData + 3, cbData);
+		lpData[cbData] = '\0';
+	} else if (SciCall_GetCodePage() == CP_UTF8 && !IsUTF8(lpData, cbData)) {
+		DWORD cbDataUTF8 = cbData;
+		char *lpDataUTF8 = RecodeAsUTF8(lpData, &cbDataUTF8, mEncoding[CPI_DEFAULT].uCodePage, 0);
+		if (lpDataUTF8 != nullptr) {
+			NP2HeapFree(lpData);
+			lpData = lpDataUTF8;
+			cbData = cbDataUTF8;
+		}
+	}
+	*length = cbData;
+	return lpData;
+}
+
+struct DiffOutput {
+	char *data;
+	size_t length;
+	size_t capacity;
+
+	bool Append(const char *text, size_t size) noexcept {
+		if (length + size > capacity) {
+			const size_t newCapacity = max(capacity*2, length + size + (64 << 10));
+			char *result = static_cast<char *>((data == nullptr) ? NP2HeapAlloc(newCapacity) : NP2HeapReAlloc(data, newCapacity));
+			if (result == nullptr) {
+				return false;
+			}
+			data = result;
+			capacity = newCapacity;
+		}
+		memcpy(data + length, text, size);
+		length += size;
+		return true;
+	}
+	void AppendLine(char prefix, const CompareText &text, size_t line, const char *eol, size_t eolLength) noexcept {
+		const size_t start = text.lineStart[line];
+		Append(&prefix, 1);
+		Append(text.text + start, text.LineEnd(line) - start);
+		Append(eol, eolLength);
+	}
+};
+
+// unified range: "start,count", count of 1 is omitted, start is the line before for empty range.
+int Compare_FormatRange(char *buffer, size_t start, size_t count) noexcept {
+	if (count == 1) {
+		return sprintf(buffer, "%" PRIu64, static_cast<uint64_t>(start + 1));
+	}
+	return sprintf(buffer, "%" PRIu64 ",%" PRIu64, static_cast<uint64_t>(count ? start + 1 : start), static_cast<uint64_t>(count));
+}
+
+void Compare_FormatUnifiedDiff(const CompareText (&texts)[2], const DiffHunk *hunks, size_t hunkCount, LPCWSTR pszName1, LPCWSTR pszName2, DiffOutput &output) noexcept {
+	const int iEOLMode = SciCall_GetEOLMode();
+	const char *eol = (iEOLMode == SC_EOL_CRLF) ? "\r\n" : ((iEOLMode == SC_EOL_CR) ? "\r" : "\n");
+	const size_t eolLength = (iEOLMode == SC_EOL_CRLF) ? 2 : 1;
+	char buffer[MAX_PATH*kMaxMultiByteCount + 16];
+
+	LPCWSTR names[2] = { pszName1, pszName2 };
+	for (int side = 0; side < 2; side++) {
+		memcpy(buffer, side ? "+++ " : "--- ", 4);
+		const int length = WideCharToMultiByte(CP_UTF8, 0, names[side], -1, buffer + 4, MAX_PATH*kMaxMultiByteCount, nullptr, nullptr);
+		// exclude NULL terminator
+		output.Append(buffer, 4 + ((length == 0) ? 0 : length - 1));
+		output.Append(eol, eolLength);
+	}
+
+	const CompareText &text1 = texts[0];
+	const CompareText &text2 = texts[1];
+	size_t index = 0;
+	while (index < hunkCount) {
+		// merge hunks when context lines between them overlap
+		size_t last = index;
+		while (last + 1 < hunkCount && hunks[last + 1].start[0] - (hunks[last].start[0] + hunks[last].count[0]) <= 2*COMPARE_CONTEXT_LINE_COUNT) {
+			++last;
+		}
+		const DiffHunk &firstHunk = hunks[index];
+		const DiffHunk &lastHunk = hunks[last];
+		const size_t before = min<size_t>(firstHunk.start[0], COMPARE_CONTEXT_LINE_COUNT);
+		const size_t end1 = lastHunk.start[0] + lastHunk.count[0];
+		const size_t after = min<size_t>(text1.lineCount - end1, COMPARE_CONTEXT_LINE_COUNT);
+		const size_t start1 = firstHunk.start[0] - before;
+		const size_t start2 = firstHunk.start[1] - before;
+		const size_t end2 = lastHunk.start[1] + lastHunk.count[1];
+
+		int length = sprintf(buffer, "@@ -");
+		length += Compare_FormatRange(buffer + length, start1, end1 + after - start1);
+		length += sprintf(buffer + length, " +");
+		length += Compare_FormatRange(buffer + length, start2, end2 + after - start2);
+		length += sprintf(buffer + length, " @@");
+		output.Append(buffer, length);
+		output.Append(eol, eolLength);
+
+		size_t line = start1;
+		for (; index <= last; index++) {
+			const DiffHunk &hunk = hunks[index];
+			for (; line < hunk.start[0]; line++) {
+				output.AppendLine(' ', text1, line, eol, eolLength);
+			}
+			for (size_t i = 0; i < hunk.count[0]; i++) {
+				output.AppendLine('-', text1, hunk.start[0] + i, eol, eolLength);
+			}
+			for (size_t i = 0; i < hunk.count[1]; i++) {
+				output.AppendLine('+', text2, hunk.start[1] + i, eol, eolLength);
+			}
+			line += hunk.count[0];
+		}
+		for (; line < end1 + after; line++) {
+			output.AppendLine(' ', text1, line, eol, eolLength);
+		}
+	}
+}
+
+// setup texts to be compared, text for file is allocated and must be freed.
+bool Compare_GetTexts(CompareText (&texts)[2], char **fileData) noexcept {
+	memset(texts, 0, sizeof(texts));
+	*fileData = nullptr;
+	if (compareMode == CompareMode_File) {
+		size_t length = 0;
+		char *lpData = Compare_ReadFile(szCompareFile, &length);
+		if (lpData == nullptr) {
+			MsgBoxLastError(MB_OK, IDS_ERR_LOADFILE, szCompareFile);
+			return false;
+		}
+		*fileData = lpData;
+		// old text is the file, new text is the document
+		texts[0].text = lpData;
+		texts[0].length = length;
+		texts[0].line = -1;
+		length = SciCall_GetLength();
+		texts[1].text = SciCall_GetRangePointer(0, length);
+		texts[1].length = length;
+		return true;
+	}
+
+	if (SciCall_GetSelectionCount() != 2 || SciCall_IsRectangularSelection()) {
+		return false;
+	}
+	Sci_Position start1 = SciCall_GetSelectionNStart(0);
+	Sci_Position end1 = SciCall_GetSelectionNEnd(0);
+	Sci_Position start2 = SciCall_GetSelectionNStart(1);
+	Sci_Position end2 = SciCall_GetSelectionNEnd(1);
+	if (start2 < start1) {
+		Sci_Position temp = start1;
+		start1 = start2;
+		start2 = temp;
+		temp = end1;
+		end1 = end2;
+		end2 = temp;
+	}
+	const char *text = SciCall_GetRangePointer(start1, end2 - start1);
+	texts[0].text = text;
+	texts[0].length = end1 - start1;
+	texts[0].position = start1;
+	texts[0].line = SciCall_LineFromPosition(start1);
+	texts[1].text = text + (start2 - start1);
+	texts[1].length = end2 - start2;
+	texts[1].position = start2;
+	texts[1].line = SciCall_LineFromPosition(start2);
+	return true;
+}
+
+void Compare_ShowDifference() noexcept {
+	CompareText texts[2];
+	char *fileData;
+	if (!Compare_GetTexts(texts, &fileData)) {
+		compareMode = CompareMode_None;
+		return;
+	}
+
+	BeginWaitCursor();
+	EditCompareClear();
+	DiffHunk *hunks;
+	size_t hunkCount;
+	const bool success = Compare_Run(texts, &hunks, &hunkCount);
+	const WPARAM notifyPos = SC_NOTIFICATIONPOSITION_CENTER;
+	if (hunks == nullptr) {
+		EndWaitCursor();
+		if (success) {
+			ShowNotificationMessage(notifyPos, IDS_COMPARE_IDENTICAL);
+		}
+	} else {
+		Compare_DefineMarkers();
+		if (texts[0].line >= 0) {
+			Compare_MarkSide(texts, 0, hunks, hunkCount);
+		}
+		Compare_MarkSide(texts, 1, hunks, hunkCount);
+
+		size_t added = 0;
+		size_t deleted = 0;
+		size_t changed = 0;
+		for (size_t i = 0; i < hunkCount; i++) {
+			const size_t paired = min(hunks[i].count[0], hunks[i].count[1]);
+			changed += paired;
+			deleted += hunks[i].count[0] - paired;
+			added += hunks[i].count[1] - paired;
+		}
+		NP2HeapFree(hunks);
+		EndWaitCursor();
+
+		WCHAR tchHunk[32];
+		WCHAR tchAdded[32];
+		WCHAR tchDeleted[32];
+		WCHAR tchChanged[32];
+		FormatNumber(tchHunk, hunkCount);
+		FormatNumber(tchAdded, added);
+		FormatNumber(tchDeleted, deleted);
+		FormatNumber(tchChanged, changed);
+		ShowNotificationMessage(notifyPos, IDS_COMPARE_STATUS, tchHunk, tchAdded, tchDeleted, tchChanged);
+	}
+	texts[0].Free();
+	texts[1].Free();
+	if (fileData != nullptr) {
+		NP2HeapFree(fileData);
+	}
+}
+
+}
+
+//=============================================================================
+//
+// EditCompareWithFile()
+//
+// Compare current document (new text) with a file (old text).
+//
+void EditCompareWithFile(HWND hwnd) noexcept {
+	WCHAR szFile[MAX_PATH];
+	WCHAR szFilter[256];
+	WCHAR tchInitialDir[MAX_PATH];
+	lstrcpy(szFile, szCompareFile);
+	GetString(IDS_FILTER_ALL, szFilter, COUNTOF(szFilter));
+	PrepareFilterStr(szFilter);
+	lstrcpy(tchInitialDir, szCurFile);
+	PathRemoveFileSpec(tchInitialDir);
+
+	OPENFILENAME ofn;
+	memset(&ofn, 0, sizeof(OPENFILENAME));
+	ofn.lStructSize = sizeof(OPENFILENAME);
+	ofn.hwndOwner = hwnd;
+	ofn.lpstrFilter = szFilter;
+	ofn.lpstrFile = szFile;
+	ofn.lpstrInitialDir = StrNotEmpty(tchInitialDir) ? tchInitialDir : nullptr;
+	ofn.nMaxFile = COUNTOF(szFile);
+	ofn.Flags = OFN_FILEMUSTEXIST | OFN_HIDEREADONLY | OFN_NOCHANGEDIR | OFN_DONTADDTORECENT | OFN_PATHMUSTEXIST | OFN_SHAREAWARE;
+	if (bUseXPFileDialog) {
+		ofn.Flags |= OFN_EXPLORER | OFN_ENABLESIZING | OFN_ENABLEHOOK;
+		ofn.lpfnHook = OpenSaveFileDlgHookProc;
+	}
+
+	if (GetOpenFileName(&ofn)) {
+		lstrcpy(szCompareFile, szFile);
+		compareMode = CompareMode_File;
+		Compare_ShowDifference();
+	}
+}
+
+//=============================================================================
+//
+// EditCompareSelections()
+//
+// Compare the two selections, the first one is the old text.
+//
+void EditCompareSelections() noexcept {
+	if (SciCall_IsRectangularSelection()) {
+		MsgBoxWarn(MB_OK, IDS_SELRECT);
+		return;
+	}
+	if (SciCall_GetSelectionCount() == 2) {
+		compareMode = CompareMode_Selections;
+		Compare_ShowDifference();
+	}
+}
+
+bool EditCompareCanExport() noexcept {
+	return compareMode == CompareMode_File
+		|| (compareMode == CompareMode_Selections && SciCall_GetSelectionCount() == 2 && !SciCall_IsRectangularSelection());
+}
+
+//=============================================================================
+//
+// EditCompareExportDiff()
+//
+// Compare again and save the differences as unified diff, which is opened
+// in a new window.
+//
+void EditCompareExportDiff(HWND hwnd) noexcept {
+	WCHAR szFile[MAX_PATH];
+	WCHAR szFilter[256];
+	LPCWSTR pszName = StrNotEmpty(szCurFile) ? szCurFile : L"Untitled";
+	lstrcpyn(szFile, PathFindFileName(pszName), COUNTOF(szFile) - 8);
+	lstrcat(szFile, L".diff");
+	GetString(IDS_FILTER_DIFF, szFilter, COUNTOF(szFilter));
+	PrepareFilterStr(szFilter);
+
+	OPENFILENAME ofn;
+	memset(&ofn, 0, sizeof(OPENFILENAME));
+	ofn.lStructSize = sizeof(OPENFILENAME);
+	ofn.hwndOwner = hwnd;
+	ofn.lpstrFilter = szFilter;
+	ofn.lpstrFile = szFile;
+	ofn.lpstrDefExt = L"diff";
+	ofn.nMaxFile = COUNTOF(szFile);
+	ofn.Flags = OFN_HIDEREADONLY | OFN_NOCHANGEDIR | OFN_DONTADDTORECENT | OFN_NOTESTFILECREATE
+				| OFN_PATHMUSTEXIST | OFN_SHAREAWARE | OFN_OVERWRITEPROMPT;
+	if (bUseXPFileDialog) {
+		ofn.Flags |= OFN_EXPLORER | OFN_ENABLESIZING | OFN_ENABLEHOOK;
+		ofn.lpfnHook = OpenSaveFileDlgHookProc;
+	}
+
+	if (!GetSaveFileName(&ofn)) {
+		return;
+	}
+
+	CompareText texts[2];
+	char *fileData;
+	if (Compare_GetTexts(texts, &fileData)) {
+		BeginWaitCursor();
+		DiffHunk *hunks;
+		size_t hunkCount;
+		Compare_Run(texts, &hunks, &hunkCount);
+		DiffOutput output { nullptr, 0, 0 };
+		Compare_FormatUnifiedDiff(texts, hunks, hunkCount, (compareMode == CompareMode_File) ? szCompareFile : pszName, pszName, output);
+		if (hunks != nullptr) {
+			NP2HeapFree(hunks);
+		}
+
+		bool success = false;
+		HANDLE hFile = CreateFile(szFile, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		dwLastIOError = GetLastError();
+		if (hFile != INVALID_HANDLE_VALUE) {
+			DWORD dwWritten = 0;
+			success = output.data != nullptr && WriteFile(hFile, output.data, static_cast<DWORD>(output.length), &dwWritten, nullptr);
+			dwLastIOError = GetLastError();
+			CloseHandle(hFile);
+		}
+		if (output.data != nullptr) {
+			NP2HeapFree(output.data);
+		}
+		EndWaitCursor();
+
+		if (!success) {
+			MsgBoxLastError(MB_OK, IDS_ERR_SAVEFILE, szFile);
+		} else {
+			// open in new window, the file is highlighted with Diff lexer
+			WCHAR szModuleName[MAX_PATH];
+			WCHAR szDirectory[MAX_PATH];
+			WCHAR szParameters[MAX_PATH + 8];
+			GetModuleFileName(nullptr, szModuleName, COUNTOF(szModuleName));
+			lstrcpy(szDirectory, szFile);
+			PathRemoveFileSpec(szDirectory);
+			PathQuoteSpaces(szFile);
+			wsprintf(szParameters, L"-n %s", szFile);
+
+			SHELLEXECUTEINFO sei;
+			memset(&sei, 0, sizeof(SHELLEXECUTEINFO));
+			sei.cbSize = sizeof(SHELLEXECUTEINFO);
+			sei.fMask = SEE_MASK_NOZONECHECKS;
+			sei.hwnd = hwnd;
+			sei.lpVerb = nullptr;
+			sei.lpFile = szModuleName;
+			sei.lpParameters = szParameters;
+			sei.lpDirectory = szDirectory;
+			sei.nShow = SW_SHOWNORMAL;
+			ShellExecuteEx(&sei);
+		}
+
+		texts[0].Free();
+		texts[1].Free();
+		if (fileData != nullptr) {
+			NP2HeapFree(fileData);
+		}
+	}
+}
+
+// returns first line of next or previous block of differences, or -1 when not found.
+Sci_Line EditCompareFindDifference(bool next) noexcept {
+	Sci_Line line = SciCall_LineFromPosition(SciCall_GetCurrentPos());
+	const Sci_Line lineCount = SciCall_GetLineCount();
+	if (next) {
+		while (line < lineCount && (SciCall_MarkerGet(line) & MarkerBitmask_Diff) != 0) {
+			++line;
+		}
+		return (line < lineCount) ? SciCall_MarkerNext(line, MarkerBitmask_Diff) : -1;
+	}
+
+	while (line > 0 && (SciCall_MarkerGet(line) & MarkerBitmask_Diff) != 0) {
+		--line;
+	}
+	line = SciCall_MarkerPrevious(line, MarkerBitmask_Diff);
+	while (line > 0 && (SciCall_MarkerGet(line - 1) & MarkerBitmask_Diff) != 0) {
+		--line;
+	}
+	return line;
+}
+
+void EditCompareClear() noexcept {
+	SciCall_MarkerDeleteAll(MarkerNumber_DiffAdded);
+	SciCall_MarkerDeleteAll(MarkerNumber_DiffDeleted);
+	SciCall_MarkerDeleteAll(MarkerNumber_DiffChanged);
+	SciCall_MarkerDeleteAll(MarkerNumber_DiffGap);
+	SciCall_SetIndicatorCurrent(IndicatorNumber_DiffChange);
+	SciCall_IndicatorClearRange(0, SciCall_GetLength());
+}
@@ -1046,7 +1046,34 @@ bool MaybeBinaryFile(const uint8_t *ptr, DWORD length, int *encodingFlag) noexce
 	UINT count = 0;
 	UINT mask = 0; // find two different C0 control characters
 	int result = 0;
+#if NP2_USE_SSE2
+	const __m128i vectC0 = _mm_set1_epi8(0x1f);
+	const __m128i vectTab = _mm_set1_epi8('\t');
+	const __m128i vectSpace = _mm_set1_epi8('\r' - '\t');
+#elif NP2_USE_NEON
+	const uint8x16_t vectC0 = vdupq_n_u8(0x1f);
+	const uint8x16_t vectTab = vdupq_n_u8('\t');
+	const uint8x16_t vectSpace = vdupq_n_u8('\r' - '\t');
+#endif
 	while (ptr < end) {
+#if NP2_USE_SSE2 || NP2_USE_NEON
+		// skip 16 bytes without C0 control character
+		if (ptr + 16 <= end) {
+#if NP2_USE_SSE2
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+			const __m128i c0 = _mm_andnot_si128(mm_cmple_epu8(_mm_sub_epi8(chunk, vectTab), vectSpace), mm_cmple_epu8(chunk, vectC0));
+			const bool skip = _mm_movemask_epi8(c0) == 0;
+#else
+			const uint8x16_t chunk = vld1q_u8(ptr);
+			const uint8x16_t c0 = vbicq_u8(vcleq_u8(chunk, vectC0), vcleq_u8(vsubq_u8(chunk, vectTab), vectSpace));
+			const bool skip = vmaxvq_u8(c0) == 0;
+#endif
+			if (skip) {
+				ptr += 16;
+				continue;
+			}
+		}
+#endif
 		const uint8_t ch = *ptr++;
 		if (IsC0ControlChar(ch)) {
 			++count;
@@ -1749,6 +1776,15 @@ bool IsUTF8(const char *data, DWORD length) noexcept {
 		// Loop over input in sizeof(__m256i)-byte chunks, as long as we can safely read
 		// that far into memory
 		for (; offset + sizeof(__m256i) < length; offset += sizeof(__m256i)) {
+#if NP2_USE_AVX512
+			// skip 64 ASCII bytes when no continuation byte is expected
+			if (last_cont == 0 && offset + sizeof(__m512i) < length
+				&& _mm512_movepi8_mask(_mm512_loadu_si512(data + offset)) == 0) {
+				offset += sizeof(__m512i) - sizeof(__m256i);
+				shifted_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset + sizeof(__m256i) - 1));
+				continue;
+			}
+#endif
 			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + offset));
 			if (!z_validate_vec_avx2(bytes, shifted_bytes, &last_cont)) {
 				return false;
@@ -2034,6 +2070,25 @@ bool IsUTF8(const char *data, DWORD length) noexcept {
 		pt += 2*sizeof(__m128i);
 	}
 	// end NP2_USE_SSE2
+#elif NP2_USE_NEON
+	while (pt + 2*sizeof(uint8x16_t) <= end) {
+		const uint8x16_t chunk1 = vld1q_u8(pt);
+		const uint8x16_t chunk2 = vld1q_u8(pt + sizeof(uint8x16_t));
+		if (vmaxvq_u8(vorrq_u8(chunk1, chunk2)) & 0x80) {
+			const uint8_t * const endPtr = pt + 2*sizeof(uint8x16_t);
+			do {
+				state = utf8_dfa[256 + state + utf8_dfa[*pt++]];
+			} while (pt < endPtr);
+			if (state == UTF8_REJECT) {
+				return false;
+			}
+		} else if (state != UTF8_ACCEPT) {
+			return false;
+		} else {
+			pt += 2*sizeof(uint8x16_t);
+		}
+	}
+	// end NP2_USE_NEON
 #elif defined(_WIN64)
 	while (pt + sizeof(uint64_t) <= end) {
 		const uint64_t val = *(reinterpret_cast<const uint64_t *>(pt));
@@ -2102,6 +2157,94 @@ bool IsUTF8(const char *data, DWORD length) noexcept {
 }
 #endif // !NP2_USE_AVX2
 
+// validate large buffer in chunks on thread pool, after sampling head, middle and tail.
+#define MIN_PARALLEL_UTF8_VALIDATION_SIZE	(16U << 20)
+#define PARALLEL_UTF8_VALIDATION_CHUNK_SIZE	(2U << 20)
+#define UTF8_VALIDATION_SAMPLE_SIZE		(64U << 10)
+
+namespace {
+
+// move position forward to a lead byte or ASCII, valid UTF-8 has at most 3 continuation bytes,
+// two valid byte sequences split at such position are still valid after concatenated.
+inline DWORD UTF8ChunkBoundary(const char *data, DWORD position, DWORD length) noexcept {
+	const DWORD end = min(position + 4, length);
+	while (position < end && (static_cast<uint8_t>(data[position]) & 0xC0) == 0x80) {
+		++position;
+	}
+	return position;
+}
+
+struct UTF8ValidationWorker {
+	const char *data;
+	DWORD length;
+	DWORD chunkCount;
+	LONG nextChunk;
+	volatile LONG invalid;
+
+	DWORD ChunkStart(DWORD index) const noexcept {
+		if (index == 0) {
+			return 0;
+		}
+		if (index >= chunkCount) {
+			return length;
+		}
+		return UTF8ChunkBoundary(data, index*PARALLEL_UTF8_VALIDATION_CHUNK_SIZE, length);
+	}
+
+	void DoWork() noexcept {
+		while (invalid == 0) {
+			const DWORD index = static_cast<DWORD>(InterlockedIncrement(&nextChunk) - 1);
+			if (index >= chunkCount) {
+				break;
+			}
+			const DWORD start = ChunkStart(index);
+			const DWORD end = ChunkStart(index + 1);
+			if (!IsUTF8(data + start, end - start)) {
+				InterlockedExchange(&invalid, TRUE);
+			}
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		UTF8ValidationWorker *worker = static_cast<UTF8ValidationWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+bool IsUTF8Parallel(const char *data, DWORD length) noexcept {
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), length/PARALLEL_UTF8_VALIDATION_CHUNK_SIZE);
+	if (length < MIN_PARALLEL_UTF8_VALIDATION_SIZE || threadCount < 2) {
+		return IsUTF8(data, length);
+	}
+
+	// early rejection: test samples at head, middle and tail
+	const DWORD samples[3] = { 0, length/2, length - UTF8_VALIDATION_SAMPLE_SIZE };
+	for (const DWORD sample : samples) {
+		const DWORD start = UTF8ChunkBoundary(data, sample, length);
+		const DWORD end = UTF8ChunkBoundary(data, sample + UTF8_VALIDATION_SAMPLE_SIZE, length);
+		if (!IsUTF8(data + start, end - start)) {
+			return false;
+		}
+	}
+
+	UTF8ValidationWorker worker {
+		data, length, (length + PARALLEL_UTF8_VALIDATION_CHUNK_SIZE - 1)/PARALLEL_UTF8_VALIDATION_CHUNK_SIZE, 0, 0
+	};
+	PTP_WORK work = CreateThreadpoolWork(UTF8ValidationWorker::WorkCallback, &worker, nullptr);
+	if (work == nullptr) {
+		return IsUTF8(data, length);
+	}
+	for (UINT i = 1; i < threadCount; i++) {
+		SubmitThreadpoolWork(work);
+	}
+	worker.DoWork();
+	WaitForThreadpoolWorkCallbacks(work, FALSE);
+	CloseThreadpoolWork(work);
+	return worker.invalid == 0;
+}
+
+}
+
 static const char *CheckUTF7(const char *pTest, DWORD nLength) noexcept {
 	const char *pt = pTest;
 #if NP2_USE_AVX512
@@ -2331,7 +2474,420 @@ INT UTF8_mbslen(LPCSTR source, INT byte_length) noexcept {
 #endif
 
 
+// UTF-16 <=> UTF-8 conversion for UTF-16LE/BE file, byte swapping is done inline.
+// UTF-16 input must have paired surrogates, and UTF-8 input must be valid,
+// otherwise MultiByteToWideChar() and WideCharToMultiByte() are used to replace invalid characters.
+
+static inline UINT BSwapUTF16(UINT ch, bool reverse) noexcept {
+	return reverse ? (((ch & 0xff) << 8) | (ch >> 8)) : ch;
+}
+
+size_t UTF8LengthFromUTF16(LPCWSTR pszTextW, size_t cchTextW, bool reverse) noexcept {
+	const uint16_t *ptr = reinterpret_cast<const uint16_t *>(pszTextW);
+	const uint16_t * const end = ptr + cchTextW;
+	size_t length = cchTextW;
+	bool lead = false;
+#if NP2_USE_SSE2
+	const __m128i vectMask7F = _mm_set1_epi16(0x7f);
+	const __m128i vectMask7FF = _mm_set1_epi16(0x7ff);
+	const __m128i vectMaskSurrogate = _mm_set1_epi16(static_cast<short>(0xf800));
+	const __m128i vectSurrogate = _mm_set1_epi16(static_cast<short>(SURROGATE_LEAD_FIRST));
+	const __m128i vectMaskLead = _mm_set1_epi16(static_cast<short>(0xfc00));
+	const __m128i vectLead = _mm_set1_epi16(static_cast<short>(SURROGATE_LEAD_FIRST));
+	const __m128i vectTrail = _mm_set1_epi16(static_cast<short>(SURROGATE_TRAIL_FIRST));
+	const __m128i zero = _mm_setzero_si128();
+	while (ptr + sizeof(__m128i)/sizeof(uint16_t) <= end) {
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		ptr += sizeof(__m128i)/sizeof(uint16_t);
+		if (reverse) {
+			chunk = _mm_or_si128(_mm_slli_epi16(chunk, 8), _mm_srli_epi16(chunk, 8));
+		}
+		// one more byte for code unit >= 0x80, two more bytes for code unit >= 0x800,
+		// surrogate pair is four bytes, one less per surrogate.
+		const __m128i lt80 = _mm_cmpeq_epi16(_mm_andnot_si128(vectMask7F, chunk), zero);
+		const __m128i lt800 = _mm_cmpeq_epi16(_mm_andnot_si128(vectMask7FF, chunk), zero);
+		const __m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(chunk, vectMaskSurrogate), vectSurrogate);
+		const uint32_t mask = mm_movemask_epi8(_mm_packs_epi16(lt80, surrogate));
+		if (mask == 0xff) {
+			// all ASCII
+			if (lead) {
+				return SIZE_MAX;
+			}
+			continue;
+		}
+		length += 2*sizeof(__m128i)/sizeof(uint16_t) - np2_popcount(mm_movemask_epi8(_mm_packs_epi16(lt80, lt800)));
+		if ((mask >> 8) != 0) {
+			// lead surrogate must followed by trail surrogate
+			const uint32_t leadMask = mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(_mm_and_si128(chunk, vectMaskLead), vectLead), zero));
+			const uint32_t trailMask = mm_movemask_epi8(_mm_packs_epi16(_mm_cmpeq_epi16(_mm_and_si128(chunk, vectMaskLead), vectTrail), zero));
+			if (trailMask != (((leadMask << 1) | lead) & 0xff)) {
+				return SIZE_MAX;
+			}
+			lead = (leadMask >> 7) & true;
+			length -= np2_popcount(mask >> 8);
+		} else if (lead) {
+			return SIZE_MAX;
+		}
+	}
+#endif
+	while (ptr < end) {
+		const UINT ch = BSwapUTF16(*ptr++, reverse);
+		if (ch >= 0x80) {
+			length += 1 + (ch >= 0x800);
+			if ((ch & 0xf800) == SURROGATE_LEAD_FIRST) {
+				length -= 1;
+				const bool trail = ch >= SURROGATE_TRAIL_FIRST;
+				if (trail != lead) {
+					return SIZE_MAX;
+				}
+				lead = !trail;
+				continue;
+			}
+		}
+		if (lead) {
+			return SIZE_MAX;
+		}
+	}
+	return lead ? SIZE_MAX : length;
+}
+
+size_t UTF16ToUTF8(LPCWSTR pszTextW, size_t cchTextW, bool reverse, char *lpData) noexcept {
+	const uint16_t *ptr = reinterpret_cast<const uint16_t *>(pszTextW);
+	const uint16_t * const end = ptr + cchTextW;
+	uint8_t *output = reinterpret_cast<uint8_t *>(lpData);
+#if NP2_USE_SSE2
+	const __m128i vectMask7F = _mm_set1_epi16(0x7f);
+	const __m128i zero = _mm_setzero_si128();
+#endif
+	while (ptr < end) {
+#if NP2_USE_SSE2
+		if (ptr + sizeof(__m128i)/sizeof(uint16_t) <= end) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+			if (reverse) {
+				chunk = _mm_or_si128(_mm_slli_epi16(chunk, 8), _mm_srli_epi16(chunk, 8));
+			}
+			if (mm_movemask_epi8(_mm_cmpeq_epi16(_mm_andnot_si128(vectMask7F, chunk), zero)) == 0xffff) {
+				_mm_storel_epi64(reinterpret_cast<__m128i *>(output), _mm_packus_epi16(chunk, chunk));
+				output += sizeof(__m128i)/sizeof(uint16_t);
+				ptr += sizeof(__m128i)/sizeof(uint16_t);
+				continue;
+			}
+		}
+#endif
+		UINT ch = BSwapUTF16(*ptr++, reverse);
+		if (ch < 0x80) {
+			*output++ = static_cast<uint8_t>(ch);
+		} else if (ch < 0x800) {
+			output[0] = static_cast<uint8_t>(0xC0 | (ch >> 6));
+			output[1] = static_cast<uint8_t>(0x80 | (ch & 0x3f));
+			output += 2;
+		} else if ((ch & 0xf800) != SURROGATE_LEAD_FIRST) {
+			output[0] = static_cast<uint8_t>(0xE0 | (ch >> 12));
+			output[1] = static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3f));
+			output[2] = static_cast<uint8_t>(0x80 | (ch & 0x3f));
+			output += 3;
+		} else {
+			ch = UTF16_TO_UTF32(ch, BSwapUTF16(*ptr++, reverse));
+			output[0] = static_cast<uint8_t>(0xF0 | (ch >> 18));
+			output[1] = static_cast<uint8_t>(0x80 | ((ch >> 12) & 0x3f));
+			output[2] = static_cast<uint8_t>(0x80 | ((ch >> 6) & 0x3f));
+			output[3] = static_cast<uint8_t>(0x80 | (ch & 0x3f));
+			output += 4;
+		}
+	}
+	return output - reinterpret_cast<uint8_t *>(lpData);
+}
+
+size_t UTF16LengthFromUTF8(const char *lpData, size_t cbData) noexcept {
+	// code unit count = non continuation bytes + 4-byte lead bytes
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(lpData);
+	const uint8_t * const end = ptr + cbData;
+	size_t length = 0;
+#if NP2_USE_SSE2
+	const __m128i vectContinuation = _mm_set1_epi8(static_cast<char>(0xbf));
+	const __m128i vectLead4 = _mm_set1_epi8(static_cast<char>(0xef));
+	while (ptr + sizeof(__m128i) <= end) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+		ptr += sizeof(__m128i);
+		// signed compare: continuation byte is 0x80 to 0xBF, 4-byte lead byte is 0xF0 to 0xF4
+		const uint32_t mask = mm_movemask_epi8(_mm_cmpgt_epi8(chunk, vectContinuation));
+		const uint32_t lead4 = mm_movemask_epi8(_mm_cmpgt_epi8(chunk, vectLead4)) & mm_movemask_epi8(chunk);
+		length += np2_popcount(mask) + np2_popcount(lead4);
+	}
+#endif
+	while (ptr < end) {
+		const uint8_t ch = *ptr++;
+		length += (ch & 0xc0) != 0x80;
+		length += ch >= 0xf0;
+	}
+	return length;
+}
+
+size_t UTF8ToUTF16(const char *lpData, size_t cbData, bool reverse, LPWSTR pszTextW) noexcept {
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(lpData);
+	const uint8_t * const end = ptr + cbData;
+	uint16_t *output = reinterpret_cast<uint16_t *>(pszTextW);
+#if NP2_USE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+#endif
+	while (ptr < end) {
+#if NP2_USE_SSE2
+		if (ptr + sizeof(__m128i) <= end) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+			if (mm_movemask_epi8(chunk) == 0) {
+				// zero extend ASCII, big endian when zero byte is the low byte
+				const __m128i low = reverse ? _mm_unpacklo_epi8(zero, chunk) : _mm_unpacklo_epi8(chunk, zero);
+				const __m128i high = reverse ? _mm_unpackhi_epi8(zero, chunk) : _mm_unpackhi_epi8(chunk, zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(output), low);
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(output + sizeof(__m128i)/sizeof(uint16_t)), high);
+				output += sizeof(__m128i);
+				ptr += sizeof(__m128i);
+				continue;
+			}
+		}
+#endif
+		UINT ch = *ptr++;
+		if (ch >= 0x80) {
+			if (ch < 0xe0) {
+				ch = ((ch & 0x1f) << 6) | (ptr[0] & 0x3f);
+				ptr += 1;
+			} else if (ch < 0xf0) {
+				ch = ((ch & 0x0f) << 12) | ((ptr[0] & 0x3f) << 6) | (ptr[1] & 0x3f);
+				ptr += 2;
+			} else {
+				ch = ((ch & 0x07) << 18) | ((ptr[0] & 0x3f) << 12) | ((ptr[1] & 0x3f) << 6) | (ptr[2] & 0x3f);
+				ptr += 3;
+				*output++ = static_cast<uint16_t>(BSwapUTF16((ch >> 10) + (SURROGATE_LEAD_FIRST - (SUPPLEMENTAL_PLANE_FIRST >> 10)), reverse));
+				ch = (ch & 0x3ff) + SURROGATE_TRAIL_FIRST;
+			}
+		}
+		*output++ = static_cast<uint16_t>(BSwapUTF16(ch, reverse));
+	}
+	return output - reinterpret_cast<uint16_t *>(pszTextW);
+}
+
+namespace {
+
+// chunked DBCS recoding, chunks are split after line feed, which is never a DBCS trail byte.
+#define MIN_PARALLEL_RECODE_SIZE	(16U << 20)
+#define PARALLEL_RECODE_CHUNK_SIZE	(4U << 20)
+
+struct RecodeChunk {
+	DWORD start;
+	DWORD end;
+	LPWSTR lpDataWide;
+	DWORD cchDataWide;
+	DWORD offset;
+	DWORD size;
+};
+
+struct DBCSRecodeWorker {
+	LPCSTR lpData;
+	char *lpDataUTF8;
+	RecodeChunk *chunks;
+	DWORD chunkCount;
+	UINT codePage;
+	DWORD flags;
+	LONG nextChunk;
+	volatile LONG invalid;
+
+	// convert to UTF-16 and get UTF-8 length
+	void Measure(RecodeChunk &chunk) noexcept {
+		const DWORD length = chunk.end - chunk.start;
+		if (length == 0) {
+			return;
+		}
+		chunk.lpDataWide = static_cast<LPWSTR>(NP2HeapAlloc((length + 16) * sizeof(WCHAR)));
+		chunk.cchDataWide = MultiByteToWideChar(codePage, flags, lpData + chunk.start, length, chunk.lpDataWide, length + 16);
+		if (chunk.cchDataWide == 0) {
+			InterlockedExchange(&invalid, TRUE);
+			return;
+		}
+		chunk.size = WideCharToMultiByte(CP_UTF8, 0, chunk.lpDataWide, chunk.cchDataWide, nullptr, 0, nullptr, nullptr);
+	}
+
+	void Convert(RecodeChunk &chunk) const noexcept {
+		if (chunk.lpDataWide != nullptr) {
+			WideCharToMultiByte(CP_UTF8, 0, chunk.lpDataWide, chunk.cchDataWide, lpDataUTF8 + chunk.offset, chunk.size, nullptr, nullptr);
+			NP2HeapFree(chunk.lpDataWide);
+			chunk.lpDataWide = nullptr;
+		}
+	}
+
+	void DoWork() noexcept {
+		while (invalid == 0) {
+			const DWORD index = static_cast<DWORD>(InterlockedIncrement(&nextChunk) - 1);
+			if (index >= chunkCount) {
+				break;
+			}
+			if (lpDataUTF8 == nullptr) {
+				Measure(chunks[index]);
+			} else {
+				Convert(chunks[index]);
+			}
+		}
+	}
+
+	void Run(PTP_WORK work, UINT threadCount) noexcept {
+		nextChunk = 0;
+		if (work != nullptr) {
+			for (UINT i = 1; i < threadCount; i++) {
+				SubmitThreadpoolWork(work);
+			}
+		}
+		DoWork();
+		if (work != nullptr) {
+			WaitForThreadpoolWorkCallbacks(work, FALSE);
+		}
+	}
+
+	static VOID CALLBACK WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PTP_WORK work) noexcept {
+		DBCSRecodeWorker *worker = static_cast<DBCSRecodeWorker *>(context);
+		worker->DoWork();
+	}
+};
+
+LPSTR RecodeDBCSAsUTF8(LPCSTR lpData, DWORD *cbData, UINT codePage, DWORD flags) noexcept {
+	const DWORD length = *cbData;
+	const DWORD chunkCount = (length + PARALLEL_RECODE_CHUNK_SIZE - 1)/PARALLEL_RECODE_CHUNK_SIZE;
+	RecodeChunk *chunks = static_cast<RecodeChunk *>(NP2HeapAlloc(chunkCount * sizeof(RecodeChunk)));
+	DWORD start = 0;
+	for (DWORD index = 0; index < chunkCount; index++) {
+		DWORD end = length;
+		const DWORD position = (index + 1)*PARALLEL_RECODE_CHUNK_SIZE;
+		if (position > start && position < length) {
+			const char *lf = static_cast<const char *>(memchr(lpData + position, '\n', length - position));
+			if (lf != nullptr) {
+				end = static_cast<DWORD>(lf - lpData) + 1;
+			}
+		}
+		end = max(start, end);
+		chunks[index].start = start;
+		chunks[index].end = end;
+		start = end;
+	}
+
+	const UINT threadCount = min<UINT>(GetHardwareConcurrency(), chunkCount);
+	DBCSRecodeWorker worker {
+		lpData, nullptr, chunks, chunkCount, codePage, flags, 0, 0
+	};
+	PTP_WORK work = (threadCount > 1) ? CreateThreadpoolWork(DBCSRecodeWorker::WorkCallback, &worker, nullptr) : nullptr;
+	worker.Run(work, threadCount);
+
+	uint64_t size = 0;
+	for (DWORD index = 0; index < chunkCount; index++) {
+		chunks[index].offset = static_cast<DWORD>(size);
+		size += chunks[index].size;
+	}
+	char *lpDataUTF8 = nullptr;
+	if (worker.invalid == 0 && size < UINT_MAX - 16) {
+		lpDataUTF8 = static_cast<char *>(NP2HeapAlloc(static_cast<size_t>(size) + 16));
+		worker.lpDataUTF8 = lpDataUTF8;
+		worker.Run(work, threadCount);
+		*cbData = static_cast<DWORD>(size);
+	} else {
+		*cbData = 0;
+	}
+	if (work != nullptr) {
+		CloseThreadpoolWork(work);
+	}
+	for (DWORD index = 0; index < chunkCount; index++) {
+		if (chunks[index].lpDataWide != nullptr) {
+			NP2HeapFree(chunks[index].lpDataWide);
+		}
+	}
+	NP2HeapFree(chunks);
+	return lpDataUTF8;
+}
+
+// table driven single byte code page to UTF-8 conversion, without UTF-16 intermediate.
+LPSTR RecodeSBCSAsUTF8(LPCSTR lpData, DWORD *cbData, UINT codePage, DWORD flags) noexcept {
+	// UTF-8 bytes in low 3 bytes, byte count in high byte, zero for invalid character
+	uint32_t table[256];
+	bool asciiCompatible = true; // false for EBCDIC
+	for (UINT ch = 0; ch < 256; ch++) {
+		const char mbc = static_cast<char>(ch);
+		WCHAR wch = 0;
+		uint32_t value = 0;
+		if (MultiByteToWideChar(codePage, flags, &mbc, 1, &wch, 1) == 1) {
+			if (wch < 0x80) {
+				value = wch | (1U << 24);
+			} else if (wch < 0x800) {
+				value = (0xC0 | (wch >> 6)) | ((0x80 | (wch & 0x3f)) << 8) | (2U << 24);
+			} else {
+				value = (0xE0 | (wch >> 12)) | ((0x80 | ((wch >> 6) & 0x3f)) << 8) | ((0x80 | (wch & 0x3f)) << 16) | (3U << 24);
+			}
+		}
+		table[ch] = value;
+		if (ch < 0x80 && value != (ch | (1U << 24))) {
+			asciiCompatible = false;
+		}
+	}
+
+	const uint8_t *ptr = reinterpret_cast<const uint8_t *>(lpData);
+	const uint8_t * const end = ptr + *cbData;
+	uint64_t size = 0;
+	while (ptr < end) {
+		const uint32_t value = table[*ptr++];
+		if (value == 0) {
+			*cbData = 0;
+			return nullptr;
+		}
+		size += value >> 24;
+	}
+	if (size >= UINT_MAX - 16) {
+		*cbData = 0;
+		return nullptr;
+	}
+
+	char *lpDataUTF8 = static_cast<char *>(NP2HeapAlloc(static_cast<size_t>(size) + 16));
+	uint8_t *output = reinterpret_cast<uint8_t *>(lpDataUTF8);
+	ptr = reinterpret_cast<const uint8_t *>(lpData);
+	while (ptr < end) {
+#if NP2_USE_SSE2
+		if (asciiCompatible && ptr + sizeof(__m128i) <= end) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+			if (mm_movemask_epi8(chunk) == 0) {
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(output), chunk);
+				ptr += sizeof(__m128i);
+				output += sizeof(__m128i);
+				continue;
+			}
+		}
+#elif NP2_USE_NEON
+		if (asciiCompatible && ptr + sizeof(uint8x16_t) <= end) {
+			const uint8x16_t chunk = vld1q_u8(ptr);
+			if ((vmaxvq_u8(chunk) & 0x80) == 0) {
+				vst1q_u8(output, chunk);
+				ptr += sizeof(uint8x16_t);
+				output += sizeof(uint8x16_t);
+				continue;
+			}
+		}
+#endif
+		// output has at least 16 bytes padding
+		const uint32_t value = table[*ptr++];
+		memcpy(output, &value, sizeof(uint32_t));
+		output += value >> 24;
+	}
+	*cbData = static_cast<DWORD>(size);
+	return lpDataUTF8;
+}
+
+}
+
 LPSTR RecodeAsUTF8(LPSTR lpData, DWORD *cbData, UINT codePage, DWORD flags) noexcept {
+	if (IsDBCSCodePage(codePage)) {
+		if (*cbData >= MIN_PARALLEL_RECODE_SIZE) {
+			return RecodeDBCSAsUTF8(lpData, cbData, codePage, flags);
+		}
+	} else if (!IsZeroFlagsCodePage(codePage)) {
+		CPINFO info;
+		if (GetCPInfo(codePage, &info) && info.MaxCharSize == 1) {
+			return RecodeSBCSAsUTF8(lpData, cbData, codePage, flags);
+		}
+	}
+
 	DWORD size = *cbData;
 	DWORD cbDataWide = (size + 16) * sizeof(WCHAR);
 	LPWSTR lpDataWide = static_cast<LPWSTR>(NP2HeapAlloc(cbDataWide));
@@ -2417,7 +2973,7 @@ int EditDetermineEncoding(LPCWSTR pszFile, char *lpData, DWORD cbData, int *enco
 
 	// load large file without encoding conversion, i.e. loaded as UTF-8 or ANSI only.
 	if (cbData >= MAX_NON_UTF8_SIZE) {
-		if (iSrcEncoding != CPI_DEFAULT && (utf8Sig || IsUTF8(lpData, cbData))) {
+		if (iSrcEncoding != CPI_DEFAULT && (utf8Sig || IsUTF8Parallel(lpData, cbData))) {
 			iEncoding = CPI_UTF8 + utf8Sig;
 		}
 		return iEncoding;
@@ -2481,7 +3037,7 @@ int EditDetermineEncoding(LPCWSTR pszFile, char *lpData, DWORD cbData, int *enco
 	// prefer UTF-8 when no encoding specified
 	// StopWatch watch;
 	// watch.Start();
-	if (IsUTF8(multiData, multiLen)) {
+	if (IsUTF8Parallel(multiData, multiLen)) {
 		// watch.Stop();
 		// watch.ShowLog("UTF8 time");
 		return CPI_UTF8;
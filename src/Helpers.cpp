@@ -35,6 +35,8 @@
 #include "Helpers.h"
 #include "VectorISA.h"
 #include "GraphicUtils.h"
+#include "EventTrace.h"
+#include "VersionRev.h"
 #include "resource.h"
 
 LPCSTR GetCurrentLogTime() noexcept {
@@ -72,12 +74,621 @@ void DebugPrintf(const char *fmt, ...) noexcept {
 	DebugPrint(buf);
 }
 
+#if NP2_ENABLE_HEAP_STATISTICS
+namespace {
+
+// keep returned pointer aligned as HeapAlloc()
+struct alignas(MEMORY_ALLOCATION_ALIGNMENT) HeapBlockHeader {
+	size_t size;
+	HeapTag tag;
+};
+
+SRWLOCK heapStatisticsLock = SRWLOCK_INIT;
+HeapStatistics heapStatistics[HeapTag_Count];
+
+constexpr LPCSTR heapTagNames[HeapTag_Count] = {
+	"Default",
+	"LoadBuffer",
+	"ConversionBuffer",
+	"SortLines",
+	"AutoCompletion",
+};
+
+void HeapStatistics_Update(HeapTag tag, size_t added, size_t removed) noexcept {
+	AcquireSRWLockExclusive(&heapStatisticsLock);
+	HeapStatistics &stat = heapStatistics[tag];
+	if (added) {
+		stat.calls++;
+		stat.bytes += added;
+	}
+	stat.current = stat.current + added - removed;
+	stat.peak = max(stat.peak, stat.current);
+	ReleaseSRWLockExclusive(&heapStatisticsLock);
+}
+
+}
+
+void *HeapAllocTag(size_t size, HeapTag tag) noexcept {
+	HeapBlockHeader *header = static_cast<HeapBlockHeader *>(HeapAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, size + sizeof(HeapBlockHeader)));
+	if (header == nullptr) {
+		return nullptr;
+	}
+	header->size = size;
+	header->tag = tag;
+	HeapStatistics_Update(tag, size, 0);
+	return header + 1;
+}
+
+void *HeapReAllocTag(void *hMem, size_t size) noexcept {
+	HeapBlockHeader *header = static_cast<HeapBlockHeader *>(hMem) - 1;
+	const size_t oldSize = header->size;
+	const HeapTag tag = header->tag;
+	header = static_cast<HeapBlockHeader *>(HeapReAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, header, size + sizeof(HeapBlockHeader)));
+	if (header == nullptr) {
+		return nullptr;
+	}
+	header->size = size;
+	HeapStatistics_Update(tag, size, oldSize);
+	return header + 1;
+}
+
+BOOL HeapFreeTag(void *hMem) noexcept {
+	if (hMem == nullptr) {
+		return TRUE;
+	}
+	HeapBlockHeader *header = static_cast<HeapBlockHeader *>(hMem) - 1;
+	HeapStatistics_Update(header->tag, 0, header->size);
+	return HeapFree(g_hDefaultHeap, 0, header);
+}
+
+void HeapStatistics_Get(HeapStatistics (&statistics)[HeapTag_Count]) noexcept {
+	AcquireSRWLockShared(&heapStatisticsLock);
+	memcpy(statistics, heapStatistics, sizeof(heapStatistics));
+	ReleaseSRWLockShared(&heapStatisticsLock);
+}
+
+void HeapStatistics_Format(LPWSTR lpszText) noexcept {
+	HeapStatistics statistics[HeapTag_Count];
+	HeapStatistics_Get(statistics);
+	for (int tag = HeapTag_Default; tag < HeapTag_Count; tag++) {
+		const HeapStatistics &stat = statistics[tag];
+		WCHAR tchBytes[32];
+		WCHAR tchCurrent[32];
+		WCHAR tchPeak[32];
+		StrFormatByteSize(stat.bytes, tchBytes, COUNTOF(tchBytes));
+		StrFormatByteSize(stat.current, tchCurrent, COUNTOF(tchCurrent));
+		StrFormatByteSize(stat.peak, tchPeak, COUNTOF(tchPeak));
+		lpszText += wsprintf(lpszText, L"Heap %hs: %u calls, %s total, %s current, %s peak\n", heapTagNames[tag],
+			static_cast<UINT>(stat.calls), tchBytes, tchCurrent, tchPeak);
+	}
+}
+
+void HeapStatistics_Trace([[maybe_unused]] LPCSTR operation) noexcept {
+#if NP2_ENABLE_EVENT_TRACE
+	HeapStatistics statistics[HeapTag_Count];
+	HeapStatistics_Get(statistics);
+	for (int tag = HeapTag_Default; tag < HeapTag_Count; tag++) {
+		const HeapStatistics &stat = statistics[tag];
+		EventTraceWrite("HeapStatistics", TraceLoggingString(operation, "Operation"), TraceLoggingString(heapTagNames[tag], "Tag"),
+			TraceLoggingUInt64(stat.calls, "Calls"), TraceLoggingUInt64(stat.bytes, "Bytes"),
+			TraceLoggingUInt64(stat.current, "Current"), TraceLoggingUInt64(stat.peak, "Peak"));
+	}
+#endif
+}
+#endif
+
+//=============================================================================
+//
+// In-memory copy of ini file
+//
+#define INI_CACHE_BUCKET_COUNT		256
+#define INI_CACHE_MAX_FILE_SIZE		(16*1024*1024)
+
+enum {
+	IniCacheSection_OwnName = 1,	// name is allocated, otherwise it's inside file buffer
+	IniCacheSection_OwnText = 2,	// text is allocated, otherwise it's inside file buffer
+	IniCacheSection_Modified = 4,
+	IniCacheSection_Duplicate = 8,	// ignored by Win32 profile API, only kept for writing back
+};
+
+struct IniCacheSection {
+	LPWSTR name;
+	LPWSTR text;		// lines as "key=value\0...\0", nullptr for deleted section
+	DWORD cchText;		// including final terminator
+	UINT blankLines;	// blank lines after this section
+	UINT flags;
+	UINT hash;
+	int next;
+};
+
+static struct IniCache {
+	bool loaded;
+	bool writeBack;
+	bool modified;
+	UINT count;
+	UINT capacity;
+	LPWSTR buffer;
+	IniCacheSection *sections;
+	int buckets[INI_CACHE_BUCKET_COUNT];
+	WCHAR path[MAX_PATH];
+} iniCache;
+
+static inline bool IniCache_IsCached(LPCWSTR lpszIniFile) noexcept {
+	return iniCache.loaded && StrCaseEqual(lpszIniFile, iniCache.path);
+}
+
+// section name is ASCII, case insensitive just like Win32 profile API.
+static UINT IniCache_Hash(LPCWSTR lpSection) noexcept {
+	UINT hash = 2166136261U;
+	while (*lpSection) {
+		UINT ch = *lpSection++;
+		if (ch >= L'a' && ch <= L'z') {
+			ch -= L'a' - L'A';
+		}
+		hash = (hash ^ ch) * 16777619U;
+	}
+	return hash;
+}
+
+static IniCacheSection *IniCache_Find(LPCWSTR lpSection) noexcept {
+	const UINT hash = IniCache_Hash(lpSection);
+	int index = iniCache.buckets[hash % INI_CACHE_BUCKET_COUNT];
+	while (index >= 0) {
+		IniCacheSection &section = iniCache.sections[index];
+		if (section.hash == hash && StrCaseEqual(section.name, lpSection)) {
+			return &section;
+		}
+		index = section.next;
+	}
+	return nullptr;
+}
+
+static IniCacheSection *IniCache_Add(LPWSTR name, UINT flags) noexcept {
+	if (iniCache.count == iniCache.capacity) {
+		const UINT capacity = max(iniCache.capacity*2, 64U);
+		const size_t size = capacity*sizeof(IniCacheSection);
+		void *ptr = (iniCache.sections == nullptr) ? NP2HeapAlloc(size) : NP2HeapReAlloc(iniCache.sections, size);
+		if (ptr == nullptr) {
+			return nullptr;
+		}
+		iniCache.sections = static_cast<IniCacheSection *>(ptr);
+		iniCache.capacity = capacity;
+	}
+
+	IniCacheSection &section = iniCache.sections[iniCache.count];
+	memset(&section, 0, sizeof(IniCacheSection));
+	section.name = name;
+	section.flags = flags;
+	section.hash = IniCache_Hash(name);
+	section.next = -1;
+	if (*name && IniCache_Find(name) == nullptr) {
+		int &head = iniCache.buckets[section.hash % INI_CACHE_BUCKET_COUNT];
+		section.next = head;
+		head = iniCache.count;
+	} else {
+		section.flags |= IniCacheSection_Duplicate;
+	}
+	++iniCache.count;
+	return &section;
+}
+
+static inline LPWSTR IniCache_TrimLine(LPWSTR line, LPWSTR end) noexcept {
+	while (line < end && (*line == L' ' || *line == L'\t')) {
+		++line;
+	}
+	while (end > line && (end[-1] == L' ' || end[-1] == L'\t')) {
+		--end;
+	}
+	*end = L'\0';
+	return line;
+}
+
+// lines of a section are moved forward in place, removed section header and line endings
+// leave enough space for null terminators.
+static void IniCache_Parse(LPWSTR text, LPWSTR end) noexcept {
+	// lines before first section
+	IniCacheSection *section = IniCache_Add(const_cast<LPWSTR>(L""), 0);
+	LPWSTR sectionStart = text;
+	LPWSTR output = text;
+	while (section != nullptr && text <= end) {
+		LPWSTR lineEnd = text;
+		while (lineEnd < end && *lineEnd != L'\r' && *lineEnd != L'\n') {
+			++lineEnd;
+		}
+		LPWSTR next = lineEnd + 1;
+		if (*lineEnd == L'\r' && lineEnd + 1 < end && lineEnd[1] == L'\n') {
+			++next;
+		}
+		LPWSTR line = IniCache_TrimLine(text, lineEnd);
+		if (*line == L'[') {
+			LPWSTR nameEnd = StrChr(line, L']');
+			if (nameEnd == nullptr) {
+				nameEnd = StrEnd(line);
+			}
+			*output++ = L'\0';
+			section->text = sectionStart;
+			section->cchText = static_cast<DWORD>(output - sectionStart);
+			LPWSTR name = IniCache_TrimLine(line + 1, nameEnd);
+			section = IniCache_Add(name, 0);
+			// name is kept inside header line, which is before new output position
+			sectionStart = output = next;
+		} else if (*line == L'\0') {
+			if (lineEnd < end || next <= end) {
+				section->blankLines++;
+			}
+		} else {
+			const size_t len = StrEnd(line) - line;
+			memmove(output, line, len*sizeof(WCHAR));
+			output += len;
+			*output++ = L'\0';
+		}
+		text = next;
+	}
+	if (section != nullptr) {
+		*output++ = L'\0';
+		section->text = sectionStart;
+		section->cchText = static_cast<DWORD>(output - sectionStart);
+	}
+}
+
+bool IniCache_Load(LPCWSTR lpszIniFile, bool writeBack) noexcept {
+	IniCache_Free();
+	if (StrIsEmpty(lpszIniFile)) {
+		return false;
+	}
+
+	HANDLE hFile = CreateFile(lpszIniFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	DWORD cbData = 0;
+	LPWSTR buffer = nullptr;
+	if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart >= 2 && fileSize.QuadPart < INI_CACHE_MAX_FILE_SIZE) {
+		const DWORD size = static_cast<DWORD>(fileSize.QuadPart);
+		// extra space for terminators of last section
+		buffer = static_cast<LPWSTR>(NP2HeapAlloc(size + 4*sizeof(WCHAR)));
+		if (buffer != nullptr && !(ReadFile(hFile, buffer, size, &cbData, nullptr) && cbData == size)) {
+			cbData = 0;
+		}
+	}
+	CloseHandle(hFile);
+
+	// only UTF-16LE file created by CreateIniFile() is cached, ANSI file is left to Win32 profile API.
+	if (cbData < 2 || *buffer != 0xFEFF) {
+		NP2HeapFree(buffer);
+		return false;
+	}
+
+	memset(iniCache.buckets, -1, sizeof(iniCache.buckets));
+	lstrcpyn(iniCache.path, lpszIniFile, COUNTOF(iniCache.path));
+	iniCache.buffer = buffer;
+	iniCache.writeBack = writeBack;
+	IniCache_Parse(buffer + 1, buffer + cbData/sizeof(WCHAR));
+	iniCache.loaded = true;
+	return true;
+}
+
+void IniCache_Free() noexcept {
+	for (UINT i = 0; i < iniCache.count; i++) {
+		const IniCacheSection &section = iniCache.sections[i];
+		if (section.flags & IniCacheSection_OwnName) {
+			NP2HeapFree(section.name);
+		}
+		if (section.flags & IniCacheSection_OwnText) {
+			NP2HeapFree(section.text);
+		}
+	}
+	if (iniCache.sections) {
+		NP2HeapFree(iniCache.sections);
+	}
+	if (iniCache.buffer) {
+		NP2HeapFree(iniCache.buffer);
+	}
+	memset(&iniCache, 0, sizeof(iniCache));
+}
+
+static bool IniCache_WriteFile() noexcept {
+	size_t cchTotal = 1;
+	for (UINT i = 0; i < iniCache.count; i++) {
+		const IniCacheSection &section = iniCache.sections[i];
+		if (section.text != nullptr) {
+			// "[name]\r\n", "line\0" => "line\r\n"
+			cchTotal += lstrlen(section.name) + 4 + section.cchText*2 + section.blankLines*2;
+		}
+	}
+
+	LPWSTR buffer = static_cast<LPWSTR>(NP2HeapAlloc(cchTotal*sizeof(WCHAR)));
+	if (buffer == nullptr) {
+		return false;
+	}
+	LPWSTR output = buffer;
+	*output++ = 0xFEFF;
+	for (UINT i = 0; i < iniCache.count; i++) {
+		const IniCacheSection &section = iniCache.sections[i];
+		if (section.text == nullptr) {
+			continue;
+		}
+		if (*section.name) {
+			output += wsprintf(output, L"[%s]\r\n", section.name);
+		}
+		LPCWSTR line = section.text;
+		while (*line) {
+			const int len = lstrlen(line);
+			memcpy(output, line, len*sizeof(WCHAR));
+			output += len;
+			*output++ = L'\r';
+			*output++ = L'\n';
+			line += len + 1;
+		}
+		for (UINT n = 0; n < section.blankLines; n++) {
+			*output++ = L'\r';
+			*output++ = L'\n';
+		}
+	}
+
+	// write to a temporary file, then replace the ini file in one step
+	WCHAR tchTemp[MAX_PATH + 8];
+	wsprintf(tchTemp, L"%s.tmp", iniCache.path);
+	HANDLE hFile = CreateFile(tchTemp, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	bool success = false;
+	if (hFile != INVALID_HANDLE_VALUE) {
+		const DWORD cbData = static_cast<DWORD>((output - buffer)*sizeof(WCHAR));
+		DWORD dwWritten = 0;
+		success = WriteFile(hFile, buffer, cbData, &dwWritten, nullptr) && dwWritten == cbData;
+		CloseHandle(hFile);
+		if (success) {
+			success = ReplaceFile(iniCache.path, tchTemp, nullptr, REPLACEFILE_IGNORE_MERGE_ERRORS, nullptr, nullptr)
+				|| MoveFileEx(tchTemp, iniCache.path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+		}
+		if (!success) {
+			DeleteFile(tchTemp);
+		}
+	}
+	NP2HeapFree(buffer);
+	return success;
+}
+
+bool IniCache_Flush() noexcept {
+	if (!iniCache.loaded || !iniCache.modified) {
+		return true;
+	}
+
+	iniCache.modified = false;
+	if (IniCache_WriteFile()) {
+		return true;
+	}
+	// fallback to write each modified section
+	bool success = true;
+	for (UINT i = 0; i < iniCache.count; i++) {
+		IniCacheSection &section = iniCache.sections[i];
+		if (section.flags & IniCacheSection_Modified) {
+			section.flags &= ~IniCacheSection_Modified;
+			success &= WritePrivateProfileSection(section.name, section.text, iniCache.path) != FALSE;
+		}
+	}
+	return success;
+}
+
+DWORD IniCache_GetSection(LPCWSTR lpSection, LPWSTR lpBuf, DWORD cchBuf, LPCWSTR lpszIniFile) noexcept {
+	if (!IniCache_IsCached(lpszIniFile)) {
+		return GetPrivateProfileSection(lpSection, lpBuf, cchBuf, lpszIniFile);
+	}
+
+	const IniCacheSection *section = IniCache_Find(lpSection);
+	if (section == nullptr || section->text == nullptr) {
+		lpBuf[0] = L'\0';
+		lpBuf[1] = L'\0';
+		return 0;
+	}
+	// same as GetPrivateProfileSection(), returns cchBuf - 2 when truncated.
+	if (section->cchText <= cchBuf) {
+		memcpy(lpBuf, section->text, section->cchText*sizeof(WCHAR));
+		if (section->cchText < cchBuf) {
+			lpBuf[section->cchText] = L'\0';
+		}
+		return section->cchText - 1;
+	}
+	memcpy(lpBuf, section->text, (cchBuf - 2)*sizeof(WCHAR));
+	lpBuf[cchBuf - 2] = L'\0';
+	lpBuf[cchBuf - 1] = L'\0';
+	return cchBuf - 2;
+}
+
+static bool IniCache_Replace(LPCWSTR lpSection, LPWSTR text, DWORD cchText) noexcept {
+	IniCacheSection *section = IniCache_Find(lpSection);
+	if (section == nullptr) {
+		if (text == nullptr) {
+			return true;
+		}
+		const size_t cbName = (lstrlen(lpSection) + 1)*sizeof(WCHAR);
+		LPWSTR name = static_cast<LPWSTR>(NP2HeapAlloc(cbName));
+		if (name == nullptr) {
+			return false;
+		}
+		memcpy(name, lpSection, cbName);
+		section = IniCache_Add(name, IniCacheSection_OwnName);
+		if (section == nullptr) {
+			NP2HeapFree(name);
+			return false;
+		}
+	}
+	if (section->flags & IniCacheSection_OwnText) {
+		NP2HeapFree(section->text);
+	}
+	section->text = text;
+	section->cchText = cchText;
+	section->flags |= IniCacheSection_OwnText | IniCacheSection_Modified;
+	iniCache.modified = true;
+	return true;
+}
+
+static inline LPWSTR IniCache_CopyText(LPCWSTR lpBuf, DWORD &cchText) noexcept {
+	LPCWSTR end = lpBuf;
+	while (*end) {
+		end = StrEnd(end) + 1;
+	}
+	cchText = static_cast<DWORD>(end - lpBuf + 1);
+	LPWSTR text = static_cast<LPWSTR>(NP2HeapAlloc(cchText*sizeof(WCHAR)));
+	if (text != nullptr) {
+		memcpy(text, lpBuf, cchText*sizeof(WCHAR));
+	}
+	return text;
+}
+
+BOOL IniCache_SetSection(LPCWSTR lpSection, LPCWSTR lpBuf, LPCWSTR lpszIniFile) noexcept {
+	if (!IniCache_IsCached(lpszIniFile)) {
+		return WritePrivateProfileSection(lpSection, lpBuf, lpszIniFile);
+	}
+
+	DWORD cchText = 0;
+	LPWSTR text = nullptr;
+	if (lpBuf != nullptr) {
+		text = IniCache_CopyText(lpBuf, cchText);
+		if (text == nullptr) {
+			return FALSE;
+		}
+	}
+	if (!IniCache_Replace(lpSection, text, cchText)) {
+		NP2HeapFree(text);
+		return FALSE;
+	}
+	if (!iniCache.writeBack) {
+		return WritePrivateProfileSection(lpSection, lpBuf, lpszIniFile);
+	}
+	return TRUE;
+}
+
+// find line for the key, returns start of value.
+static LPCWSTR IniCache_FindKey(LPCWSTR text, LPCWSTR lpName, LPCWSTR &line) noexcept {
+	const int len = lstrlen(lpName);
+	while (*text) {
+		line = text;
+		LPCWSTR value = StrChr(text, L'=');
+		if (value != nullptr) {
+			LPCWSTR key = value;
+			while (key > text && (key[-1] == L' ' || key[-1] == L'\t')) {
+				--key;
+			}
+			if (key - text == len && _wcsnicmp(text, lpName, len) == 0) {
+				++value;
+				while (*value == L' ' || *value == L'\t') {
+					++value;
+				}
+				return value;
+			}
+		}
+		text = StrEnd(text) + 1;
+	}
+	return nullptr;
+}
+
+DWORD IniCache_GetString(LPCWSTR lpSection, LPCWSTR lpName, LPCWSTR lpDefault, LPWSTR lpReturnedStr, DWORD nSize, LPCWSTR lpszIniFile) noexcept {
+	if (!IniCache_IsCached(lpszIniFile)) {
+		return GetPrivateProfileString(lpSection, lpName, lpDefault, lpReturnedStr, nSize, lpszIniFile);
+	}
+
+	const IniCacheSection *section = IniCache_Find(lpSection);
+	LPCWSTR value = nullptr;
+	int len = 0;
+	if (section != nullptr && section->text != nullptr) {
+		LPCWSTR line;
+		value = IniCache_FindKey(section->text, lpName, line);
+		if (value != nullptr) {
+			len = lstrlen(value);
+			// surrounding quotes are removed
+			if (len > 1 && *value == L'\"' && value[len - 1] == L'\"') {
+				++value;
+				len -= 2;
+			}
+		}
+	}
+	if (value == nullptr) {
+		value = (lpDefault == nullptr) ? L"" : lpDefault;
+		len = lstrlen(value);
+	}
+	len = min<int>(len, nSize - 1);
+	memcpy(lpReturnedStr, value, len*sizeof(WCHAR));
+	lpReturnedStr[len] = L'\0';
+	return len;
+}
+
+UINT IniCache_GetInt(LPCWSTR lpSection, LPCWSTR lpName, int nDefault, LPCWSTR lpszIniFile) noexcept {
+	if (!IniCache_IsCached(lpszIniFile)) {
+		return GetPrivateProfileInt(lpSection, lpName, nDefault, lpszIniFile);
+	}
+
+	WCHAR tch[32];
+	if (IniCache_GetString(lpSection, lpName, nullptr, tch, COUNTOF(tch), lpszIniFile) == 0) {
+		return nDefault;
+	}
+	return static_cast<UINT>(wcstol(tch, nullptr, 10));
+}
+
+BOOL IniCache_SetString(LPCWSTR lpSection, LPCWSTR lpName, LPCWSTR lpString, LPCWSTR lpszIniFile) noexcept {
+	if (!IniCache_IsCached(lpszIniFile)) {
+		return WritePrivateProfileString(lpSection, lpName, lpString, lpszIniFile);
+	}
+	if (lpName == nullptr) {
+		return IniCache_SetSection(lpSection, nullptr, lpszIniFile);
+	}
+
+	const IniCacheSection *section = IniCache_Find(lpSection);
+	LPCWSTR text = L"";
+	DWORD cchText = 1;
+	LPCWSTR line = nullptr;
+	LPCWSTR lineEnd = nullptr;
+	if (section != nullptr && section->text != nullptr) {
+		text = section->text;
+		cchText = section->cchText;
+		if (IniCache_FindKey(text, lpName, line) != nullptr) {
+			lineEnd = StrEnd(line) + 1;
+		} else {
+			line = nullptr;
+		}
+	}
+	if (line == nullptr && lpString == nullptr) {
+		return TRUE;
+	}
+
+	// replace or remove existing line, or append new line
+	const DWORD cchLine = (lpString == nullptr) ? 0 : (lstrlen(lpName) + lstrlen(lpString) + 2);
+	const DWORD cchNew = cchText + cchLine - static_cast<DWORD>(lineEnd - line);
+	LPWSTR buffer = static_cast<LPWSTR>(NP2HeapAlloc(cchNew*sizeof(WCHAR)));
+	if (buffer == nullptr) {
+		return FALSE;
+	}
+	if (line == nullptr) {
+		line = lineEnd = text + cchText - 1;
+	}
+	const DWORD cchHead = static_cast<DWORD>(line - text);
+	memcpy(buffer, text, cchHead*sizeof(WCHAR));
+	if (lpString != nullptr) {
+		LPWSTR p = buffer + cchHead;
+		const int len = lstrlen(lpName);
+		memcpy(p, lpName, len*sizeof(WCHAR));
+		p[len] = L'=';
+		lstrcpy(p + len + 1, lpString);
+	}
+	memcpy(buffer + cchHead + cchLine, lineEnd, (text + cchText - lineEnd)*sizeof(WCHAR));
+	if (!IniCache_Replace(lpSection, buffer, cchNew)) {
+		NP2HeapFree(buffer);
+		return FALSE;
+	}
+	if (!iniCache.writeBack) {
+		return WritePrivateProfileString(lpSection, lpName, lpString, lpszIniFile);
+	}
+	return TRUE;
+}
+
 void IniClearSectionEx(LPCWSTR lpSection, LPCWSTR lpszIniFile, bool bDelete) noexcept {
 	if (StrIsEmpty(lpszIniFile)) {
 		return; // win.ini
 	}
 
-	WritePrivateProfileSection(lpSection, (bDelete ? nullptr : L""), lpszIniFile);
+	IniCache_SetSection(lpSection, (bDelete ? nullptr : L""), lpszIniFile);
 }
 
 void IniClearAllSectionEx(LPCWSTR lpszPrefix, LPCWSTR lpszIniFile, bool bDelete) noexcept {
@@ -86,7 +697,20 @@ void IniClearAllSectionEx(LPCWSTR lpszPrefix, LPCWSTR lpszIniFile, bool bDelete)
 	}
 
 	WCHAR sections[1024] = L"";
-	GetPrivateProfileSectionNames(sections, COUNTOF(sections), lpszIniFile);
+	if (IniCache_IsCached(lpszIniFile)) {
+		LPWSTR p = sections;
+		LPCWSTR const end = sections + COUNTOF(sections) - 2;
+		for (UINT i = 0; i < iniCache.count; i++) {
+			const IniCacheSection &section = iniCache.sections[i];
+			const int len = lstrlen(section.name);
+			if (section.text != nullptr && len != 0 && !(section.flags & IniCacheSection_Duplicate) && p + len < end) {
+				memcpy(p, section.name, len*sizeof(WCHAR));
+				p += len + 1;
+			}
+		}
+	} else {
+		GetPrivateProfileSectionNames(sections, COUNTOF(sections), lpszIniFile);
+	}
 
 	LPCWSTR p = sections;
 	LPCWSTR value = bDelete ? nullptr : L"";
@@ -94,7 +718,7 @@ void IniClearAllSectionEx(LPCWSTR lpszPrefix, LPCWSTR lpszIniFile, bool bDelete)
 
 	while (*p) {
 		if (_wcsnicmp(p, lpszPrefix, len) == 0) {
-			WritePrivateProfileSection(p, value, lpszIniFile);
+			IniCache_SetSection(p, value, lpszIniFile);
 		}
 		p = StrEnd(p) + 1;
 	}
@@ -108,18 +732,49 @@ LPWSTR IniSectionParser::Init(UINT capacity_, DWORD cchIniSection) noexcept {
 	count = 0;
 	capacity = capacity_;
 	head = nullptr;
+#if IniSectionParserUseHashTable
+	hashMask = 0;
+	hashCapacity = 0;
+	hashTable = nullptr;
+	size_t hashSize = 0;
+	if (capacity_ >= IniSectionParserMinHashCount) {
+		hashCapacity = IniSectionParserMinHashCount;
+		while (hashCapacity < capacity_*2) {
+			hashCapacity <<= 1;
+		}
+		hashSize = hashCapacity*sizeof(UINT);
+	}
+#else
+	constexpr size_t hashSize = 0;
+#endif
 #if IniSectionParserUseSentinelNode
-	const size_t allocSize = (capacity_ + 1)*sizeof(IniKeyValueNode) + cchIniSection*sizeof(WCHAR);
+	const size_t allocSize = (capacity_ + 1)*sizeof(IniKeyValueNode) + hashSize + cchIniSection*sizeof(WCHAR);
 	nodeList = static_cast<IniKeyValueNode *>(NP2HeapAlloc(allocSize));
 	sentinel = &nodeList[capacity_];
-	return reinterpret_cast<LPWSTR>(sentinel + 1);
+	char *ptr = reinterpret_cast<char *>(sentinel + 1);
 #else
-	const size_t allocSize = capacity_*sizeof(IniKeyValueNode) + cchIniSection*sizeof(WCHAR);
+	const size_t allocSize = capacity_*sizeof(IniKeyValueNode) + hashSize + cchIniSection*sizeof(WCHAR);
 	nodeList = static_cast<IniKeyValueNode *>(NP2HeapAlloc(allocSize));
-	return reinterpret_cast<LPWSTR>(nodeList + capacity_);
+	char *ptr = reinterpret_cast<char *>(nodeList + capacity_);
+#endif
+#if IniSectionParserUseHashTable
+	if (hashSize) {
+		hashTable = reinterpret_cast<UINT *>(ptr);
+	}
 #endif
+	return reinterpret_cast<LPWSTR>(ptr + hashSize);
 }
 
+#if IniSectionParserUseHashTable
+static inline UINT IniSectionParser_HashKey(LPCWSTR key, int keyLen) noexcept {
+	UINT hash = 2166136261U;
+	for (int i = 0; i < keyLen; i++) {
+		hash = (hash ^ key[i]) * 16777619U;
+	}
+	return hash;
+}
+#endif
+
 bool IniSectionParser::ParseArray(LPWSTR lpCachedIniSection, BOOL quoted) noexcept {
 	Clear();
 	if (StrIsEmpty(lpCachedIniSection)) {
@@ -181,6 +836,24 @@ bool IniSectionParser::Parse(LPWSTR lpCachedIniSection) noexcept {
 	}
 
 	count = index;
+#if IniSectionParserUseHashTable
+	if (index >= IniSectionParserMinHashCount && hashTable != nullptr) {
+		// node hash is replaced with full hash, linked list is not used.
+		hashMask = hashCapacity - 1;
+		memset(hashTable, 0xff, hashCapacity*sizeof(UINT));
+		for (UINT i = 0; i < index; i++) {
+			IniKeyValueNode &node = nodeList[i];
+			const UINT hash = IniSectionParser_HashKey(node.key, static_cast<int>(node.value - node.key - 1));
+			node.hash = hash;
+			UINT slot = hash & hashMask;
+			while (hashTable[slot] != UINT_MAX) {
+				slot = (slot + 1) & hashMask;
+			}
+			hashTable[slot] = i;
+		}
+		return true;
+	}
+#endif
 	head = &nodeList[0];
 	--index;
 #if IniSectionParserUseSentinelNode
@@ -200,6 +873,25 @@ LPCWSTR IniSectionParser::UnsafeGetValue(LPCWSTR key, int keyLen) noexcept {
 		keyLen = lstrlen(key);
 	}
 
+#if IniSectionParserUseHashTable
+	if (hashMask) {
+		const UINT hash = IniSectionParser_HashKey(key, keyLen);
+		UINT slot = hash & hashMask;
+		UINT index;
+		while ((index = hashTable[slot]) != UINT_MAX) {
+			IniKeyValueNode &node = nodeList[index];
+			if (node.hash == hash && node.key != nullptr && StrEqual(node.key, key)) {
+				// remove the node
+				--count;
+				node.key = nullptr;
+				return node.value;
+			}
+			slot = (slot + 1) & hashMask;
+		}
+		return nullptr;
+	}
+#endif
+
 	const UINT hash = keyLen | ((*reinterpret_cast<const UINT *>(key)) << 8);
 	IniKeyValueNode *node = head;
 	IniKeyValueNode *prev = nullptr;
@@ -458,6 +1150,35 @@ HBITMAP ResizeImageForDPI(HBITMAP hbmp, UINT dpi) noexcept {
 }
 
 
+static struct IdleTask {
+	const bool *pending;
+	IdleTaskProc proc;
+	DWORD timeSlot;
+} idleTasks[IdleTaskPriority_Count];
+
+void IdleTask_Register(IdleTaskPriority priority, const bool *pending, IdleTaskProc proc, DWORD timeSlot) noexcept {
+	idleTasks[priority] = { pending, proc, timeSlot };
+}
+
+bool IdleTask_Pending() noexcept {
+	for (const IdleTask &task : idleTasks) {
+		if (task.pending && *task.pending) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void IdleTask_Run(HANDLE timer) noexcept {
+	for (const IdleTask &task : idleTasks) {
+		if (task.pending && *task.pending) {
+			WaitableTimer_Set(timer, task.timeSlot);
+			task.proc(timer);
+			break;
+		}
+	}
+}
+
 void BackgroundWorker::Init(HWND owner) noexcept {
 	hwnd = owner;
 	eventCancel = CreateEvent(nullptr, TRUE, FALSE, nullptr);
@@ -489,6 +1210,47 @@ void BackgroundWorker::Destroy() noexcept {
 	CloseHandle(eventCancel);
 }
 
+UINT GetHardwareConcurrency() noexcept {
+	static UINT hardwareConcurrency = 0;
+	if (hardwareConcurrency == 0) {
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN7
+		// see EditModel::EditModel()
+		hardwareConcurrency = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+		SYSTEM_INFO info;
+		GetNativeSystemInfo(&info);
+		hardwareConcurrency = info.dwNumberOfProcessors;
+#endif
+		hardwareConcurrency = max(hardwareConcurrency, 1U);
+	}
+	return hardwareConcurrency;
+}
+
+bool bBackgroundWorkThrottled;
+
+// same as Scintilla's SetCurrentThreadThrottled() in ParallelSupport.h
+void SetCurrentThreadThrottled(bool throttled) noexcept {
+	// THREAD_POWER_THROTTLING_STATE, SetThreadInformation() requires Windows 8 and EcoQoS Windows 10 1709
+	struct PowerThrottlingState {
+		ULONG Version;
+		ULONG ControlMask;
+		ULONG StateMask;
+	};
+	using SetThreadInformationSig = BOOL (WINAPI *)(HANDLE hThread, int threadInformationClass, LPVOID threadInformation, DWORD threadInformationSize);
+	static const SetThreadInformationSig fnSetThreadInformation = DLLFunctionEx<SetThreadInformationSig>(L"kernel32.dll", "SetThreadInformation");
+
+	HANDLE hThread = GetCurrentThread();
+	if (fnSetThreadInformation) {
+		constexpr int ThreadPowerThrottling = 3;
+		constexpr ULONG ExecutionSpeed = 1; // THREAD_POWER_THROTTLING_EXECUTION_SPEED
+		// empty control mask lets system manage the thread again
+		const ULONG mask = throttled ? ExecutionSpeed : 0;
+		PowerThrottlingState state = { 1, mask, mask };
+		fnSetThreadInformation(hThread, ThreadPowerThrottling, &state, sizeof(state));
+	}
+	SetThreadPriority(hThread, throttled ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_NORMAL);
+}
+
 //=============================================================================
 //
 // PrivateSetCurrentProcessExplicitAppUserModelID()
@@ -798,7 +1560,7 @@ static int CALLBACK EnumFontFamExProc(CONST LOGFONT *plf, CONST TEXTMETRIC *ptm,
 	return FALSE;
 }
 
-BOOL IsFontAvailable(LPCWSTR lpszFontName) noexcept {
+static BOOL EnumFontAvailable(LPCWSTR lpszFontName) noexcept {
 	BOOL fFound = FALSE;
 
 	LOGFONT lf;
@@ -813,6 +1575,91 @@ BOOL IsFontAvailable(LPCWSTR lpszFontName) noexcept {
 	return fFound;
 }
 
+// result of IsFontAvailable() is shared by running instances through a named file mapping,
+// the name contains build revision and last write time of font registry keys,
+// so installing or removing fonts starts a new table.
+#define FontCacheEntryCount		128
+enum FontCacheState {
+	FontCacheState_Empty = 0,
+	FontCacheState_Busy,
+	FontCacheState_Missing,
+	FontCacheState_Found,
+};
+
+struct FontCacheEntry {
+	LONG state;
+	WCHAR faceName[LF_FACESIZE];
+};
+
+static FontCacheEntry *fontCacheTable;
+static bool fontCacheInitialized;
+
+static FontCacheEntry *GetFontCacheTable() noexcept {
+	if (fontCacheInitialized) {
+		return fontCacheTable;
+	}
+	fontCacheInitialized = true;
+
+	FILETIME stamp{};
+	HKEY const roots[] = { HKEY_LOCAL_MACHINE, HKEY_CURRENT_USER };
+	for (HKEY root : roots) {
+		HKEY hKey;
+		if (RegOpenKeyEx(root, L"SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion\\Fonts", 0, KEY_QUERY_VALUE, &hKey) == ERROR_SUCCESS) {
+			FILETIME ft;
+			if (RegQueryInfoKey(hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &ft) == ERROR_SUCCESS
+				&& CompareFileTime(&ft, &stamp) > 0) {
+				stamp = ft;
+			}
+			RegCloseKey(hKey);
+		}
+	}
+
+	WCHAR name[64];
+	wsprintf(name, L"Local\\Notepad4.FontCache.%u.%08X%08X", VERSION_REV, stamp.dwHighDateTime, stamp.dwLowDateTime);
+	constexpr DWORD size = FontCacheEntryCount * sizeof(FontCacheEntry);
+	// mapping is released when process exits, the last instance removes the table.
+	HANDLE hMap = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, size, name);
+	if (hMap != nullptr) {
+		fontCacheTable = static_cast<FontCacheEntry *>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size));
+		if (fontCacheTable == nullptr) {
+			CloseHandle(hMap);
+		}
+	}
+	return fontCacheTable;
+}
+
+BOOL IsFontAvailable(LPCWSTR lpszFontName) noexcept {
+	FontCacheEntry *table = GetFontCacheTable();
+	if (table == nullptr || lstrlen(lpszFontName) >= LF_FACESIZE) {
+		return EnumFontAvailable(lpszFontName);
+	}
+
+	// font family name is case insensitive
+	UINT hash = 2166136261U;
+	for (LPCWSTR p = lpszFontName; *p; p++) {
+		const UINT ch = *p;
+		hash = (hash ^ ((ch - L'A' < 26) ? (ch | 0x20) : ch)) * 16777619U;
+	}
+	for (UINT probe = 0; probe < FontCacheEntryCount; probe++) {
+		FontCacheEntry &entry = table[(hash + probe) & (FontCacheEntryCount - 1)];
+		const LONG state = InterlockedCompareExchange(&entry.state, FontCacheState_Busy, FontCacheState_Empty);
+		if (state == FontCacheState_Empty) {
+			lstrcpyn(entry.faceName, lpszFontName, LF_FACESIZE);
+			const BOOL fFound = EnumFontAvailable(lpszFontName);
+			InterlockedExchange(&entry.state, fFound ? FontCacheState_Found : FontCacheState_Missing);
+			return fFound;
+		}
+		if (state == FontCacheState_Busy) {
+			// being filled by another instance
+			break;
+		}
+		if (StrCmpNI(entry.faceName, lpszFontName, LF_FACESIZE) == 0) {
+			return state == FontCacheState_Found;
+		}
+	}
+	return EnumFontAvailable(lpszFontName);
+}
+
 //=============================================================================
 //
 // SetClipData()
@@ -1722,15 +2569,7 @@ bool PathGetRealPath(HANDLE hFile, LPCWSTR lpszSrc, LPWSTR lpszDest) noexcept {
 	return false;
 }
 
-#if _WIN32_WINNT < _WIN32_WINNT_WIN8
-enum { FileIdInfo = 0x12 };
-struct FILE_ID_INFO {
-	ULONGLONG VolumeSerialNumber;
-	FILE_ID_128 FileId;
-};
-#endif
-
-static inline BOOL PathGetFileId(HANDLE hFile, FILE_ID_INFO *fileId) noexcept {
+BOOL PathGetFileId(HANDLE hFile, FILE_ID_INFO *fileId) noexcept {
 	BOOL success = FALSE;
 	if (IsWin8AndAbove()) {
 		success = GetFileInformationByHandleEx(hFile, static_cast<FILE_INFO_BY_HANDLE_CLASS>(FileIdInfo), fileId, sizeof(FILE_ID_INFO));
@@ -3054,6 +3893,33 @@ size_t Base64Encode(char *output, const uint8_t *src, size_t length, bool urlSaf
 
 	char *p = output;
 	size_t i = 0;
+#if NP2_USE_AVX2
+	// https://arxiv.org/abs/1704.00605 Faster Base64 Encoding and Decoding Using AVX2 Instructions
+	// 24 bytes into 32 characters, two 12 bytes groups are loaded as 16 bytes.
+	const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m256i shiftLUT = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, table[62] - 62, table[63] - 63, 'A', 0, 0,
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, table[62] - 62, table[63] - 63, 'A', 0, 0);
+	while (i + 28 <= length) {
+		__m256i chunk = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))),
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12)), 1);
+		chunk = _mm256_shuffle_epi8(chunk, shuffle);
+		// split each 3 bytes into four 6 bits indices
+		const __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(chunk, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+		const __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(chunk, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+		const __m256i indices = _mm256_or_si256(t0, t1);
+		// map index ranges [0, 25], [26, 51], [52, 61], 62 and 63 to offset in shiftLUT
+		__m256i offset = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		offset = _mm256_or_si256(offset, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+		chunk = _mm256_add_epi8(indices, _mm256_shuffle_epi8(shiftLUT, offset));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(p), chunk);
+		src += 24;
+		p += 32;
+		i += 24;
+	}
+#endif
 	while (i + 3 <= length) {
 		i += 3;
 		const uint8_t C0 = *src++;
@@ -3092,6 +3958,38 @@ size_t Base64Decode(uint8_t *output, const uint8_t *src, size_t length) noexcept
 	uint32_t value = 0;
 	uint8_t *p = output;
 	size_t i = 0;
+#if NP2_USE_AVX2
+	// 32 characters of standard alphabet into 24 bytes, other characters are left to following loop.
+	const __m256i lutLow = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m256i lutHigh = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m256i mask2F = _mm256_set1_epi8(0x2f);
+	const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	while (i + 32 <= length) {
+		__m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+		const __m256i highNibble = _mm256_and_si256(_mm256_srli_epi32(chunk, 4), mask2F);
+		const __m256i lowNibble = _mm256_and_si256(chunk, mask2F);
+		if (!_mm256_testz_si256(_mm256_shuffle_epi8(lutLow, lowNibble), _mm256_shuffle_epi8(lutHigh, highNibble))) {
+			break;
+		}
+		const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(chunk, mask2F), highNibble));
+		chunk = _mm256_add_epi8(chunk, roll);
+		// merge four 6 bits values into 3 bytes
+		chunk = _mm256_maddubs_epi16(chunk, _mm256_set1_epi32(0x01400140));
+		chunk = _mm256_madd_epi16(chunk, _mm256_set1_epi32(0x00011000));
+		chunk = _mm256_shuffle_epi8(chunk, shuffle);
+		chunk = _mm256_permutevar8x32_epi32(chunk, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(chunk));
+		_mm_storel_epi64(reinterpret_cast<__m128i *>(p + 16), _mm256_extracti128_si256(chunk, 1));
+		src += 32;
+		p += 24;
+		i += 32;
+	}
+#endif
 	while(i < length) {
 		uint8_t ch = *src;
 		if (static_cast<signed char>(ch) < 0) {
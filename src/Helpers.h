@@ -496,17 +496,70 @@ inline int GetBitmapResourceIdForCurrentDPI(int resourceId) noexcept {
 
 // https://docs.microsoft.com/en-us/windows/desktop/Memory/comparing-memory-allocation-methods
 // https://blogs.msdn.microsoft.com/oldnewthing/20120316-00/?p=8083/
+
+//! Enable allocation statistics for NP2HeapAlloc(): calls, bytes, current and peak bytes by tag,
+// shown in memory report of "Copy Build Info" and written as "HeapStatistics" trace events.
+// Each block is prefixed with a header, so it must be same for all files.
+#ifndef NP2_ENABLE_HEAP_STATISTICS
+#define NP2_ENABLE_HEAP_STATISTICS	0
+#endif
+
+enum HeapTag {
+	HeapTag_Default,
+	HeapTag_LoadBuffer,
+	HeapTag_ConversionBuffer,
+	HeapTag_SortLines,
+	HeapTag_AutoCompletion,
+	HeapTag_Count,
+};
+
+#if NP2_ENABLE_HEAP_STATISTICS
+struct HeapStatistics {
+	size_t calls;
+	size_t bytes;
+	size_t current;
+	size_t peak;
+};
+
+void *HeapAllocTag(size_t size, HeapTag tag) noexcept;
+void *HeapReAllocTag(void *hMem, size_t size) noexcept;
+BOOL HeapFreeTag(void *hMem) noexcept;
+void HeapStatistics_Get(HeapStatistics (&statistics)[HeapTag_Count]) noexcept;
+void HeapStatistics_Format(LPWSTR lpszText) noexcept;
+void HeapStatistics_Trace(LPCSTR operation) noexcept;
+
+#define NP2HeapAlloc(size)			HeapAllocTag((size), HeapTag_Default)
+#define NP2HeapAllocTag(size, tag)	HeapAllocTag((size), (tag))
+#define NP2HeapReAlloc(hMem, size)	HeapReAllocTag((hMem), (size))
+#define NP2HeapFree(hMem)			HeapFreeTag(hMem)
+#else
 #define NP2HeapAlloc(size)			HeapAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, (size))
+#define NP2HeapAllocTag(size, tag)	HeapAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, (size))
 #define NP2HeapReAlloc(hMem, size)	HeapReAlloc(g_hDefaultHeap, HEAP_ZERO_MEMORY, (hMem), (size))
 #define NP2HeapFree(hMem)			HeapFree(g_hDefaultHeap, 0, (hMem))
+#define HeapStatistics_Trace(operation)
+#endif
 // #define NP2HeapSize(hMem)			HeapSize(g_hDefaultHeap, 0, (hMem))
 
+// In-memory copy of ini file, the file is read once by IniCache_Load(), sections are indexed with
+// a hash table. Without write back, changes are also written to the file (used on startup);
+// with write back, changes are kept in memory until IniCache_Flush() replaces the file.
+// Following functions behave same as Win32 profile API when lpszIniFile is not cached.
+bool IniCache_Load(LPCWSTR lpszIniFile, bool writeBack) noexcept;
+bool IniCache_Flush() noexcept;
+void IniCache_Free() noexcept;
+DWORD IniCache_GetSection(LPCWSTR lpSection, LPWSTR lpBuf, DWORD cchBuf, LPCWSTR lpszIniFile) noexcept;
+BOOL IniCache_SetSection(LPCWSTR lpSection, LPCWSTR lpBuf, LPCWSTR lpszIniFile) noexcept;
+DWORD IniCache_GetString(LPCWSTR lpSection, LPCWSTR lpName, LPCWSTR lpDefault, LPWSTR lpReturnedStr, DWORD nSize, LPCWSTR lpszIniFile) noexcept;
+UINT IniCache_GetInt(LPCWSTR lpSection, LPCWSTR lpName, int nDefault, LPCWSTR lpszIniFile) noexcept;
+BOOL IniCache_SetString(LPCWSTR lpSection, LPCWSTR lpName, LPCWSTR lpString, LPCWSTR lpszIniFile) noexcept;
+
 #define IniGetString(lpSection, lpName, lpDefault, lpReturnedStr, nSize) \
-	GetPrivateProfileString(lpSection, lpName, lpDefault, lpReturnedStr, nSize, szIniFile)
+	IniCache_GetString(lpSection, lpName, lpDefault, lpReturnedStr, nSize, szIniFile)
 #define IniGetInt(lpSection, lpName, nDefault) \
-	GetPrivateProfileInt(lpSection, lpName, nDefault, szIniFile)
+	IniCache_GetInt(lpSection, lpName, nDefault, szIniFile)
 #define IniSetString(lpSection, lpName, lpString) \
-	WritePrivateProfileString(lpSection, lpName, lpString, szIniFile)
+	IniCache_SetString(lpSection, lpName, lpString, szIniFile)
 
 void IniClearSectionEx(LPCWSTR lpSection, LPCWSTR lpszIniFile, bool bDelete) noexcept;
 #define IniClearSection(lpSection)			IniClearSectionEx((lpSection), szIniFile, false)
@@ -539,9 +592,9 @@ inline void IniSetBoolEx(LPCWSTR lpSection, LPCWSTR lpName, bool b, bool bDefaul
 }
 
 #define LoadIniSection(lpSection, lpBuf, cchBuf) \
-	GetPrivateProfileSection(lpSection, lpBuf, cchBuf, szIniFile);
+	IniCache_GetSection(lpSection, lpBuf, cchBuf, szIniFile);
 #define SaveIniSection(lpSection, lpBuf) \
-	WritePrivateProfileSection(lpSection, lpBuf, szIniFile)
+	IniCache_SetSection(lpSection, lpBuf, szIniFile)
 
 struct IniKeyValueNode {
 	IniKeyValueNode *next;
@@ -553,6 +606,10 @@ struct IniKeyValueNode {
 // https://en.wikipedia.org/wiki/Sentinel_node
 // https://en.wikipedia.org/wiki/Sentinel_value
 #define IniSectionParserUseSentinelNode	1
+// open addressing hash table for section with many keys, e.g. styles of a scheme,
+// keys are looked up in O(1) regardless of loading order.
+#define IniSectionParserUseHashTable	1
+#define IniSectionParserMinHashCount	16
 
 struct IniSectionParser {
 	UINT count;
@@ -562,6 +619,11 @@ struct IniSectionParser {
 	IniKeyValueNode *sentinel;
 #endif
 	IniKeyValueNode *nodeList;
+#if IniSectionParserUseHashTable
+	UINT hashMask;		// zero when hash table is not used
+	UINT hashCapacity;	// power of two, at least twice of capacity
+	UINT *hashTable;	// index into nodeList, UINT_MAX for empty slot
+#endif
 
 	LPWSTR Init(UINT capacity_, DWORD cchIniSection) noexcept;
 	void Free() const noexcept {
@@ -570,6 +632,9 @@ struct IniSectionParser {
 	void Clear() noexcept {
 		count = 0;
 		head = nullptr;
+#if IniSectionParserUseHashTable
+		hashMask = 0;
+#endif
 	}
 	bool ParseArray(LPWSTR lpCachedIniSection, BOOL quoted) noexcept;
 	bool Parse(LPWSTR lpCachedIniSection) noexcept;
@@ -658,6 +723,28 @@ inline HANDLE WaitableTimer_New(DWORD milliseconds) noexcept {
 #define WaitableTimer_Continue(timer)	\
 	(WaitForSingleObject((timer), 0) != WAIT_OBJECT_0)
 
+// Background tasks run by main message loop when message queue is empty, the pending task
+// with highest priority (lowest value) gets one time slot at each turn. A task owns its pending
+// flag: set it to schedule more work, clear it to cancel (e.g. on edit or selection change).
+enum IdleTaskPriority {
+	IdleTaskPriority_AutoComplete,		// word completion when typing paused
+	IdleTaskPriority_DeferredInit,		// startup work not needed for first paint
+	IdleTaskPriority_MarkOccurrences,	// remaining text after visible range is marked
+	IdleTaskPriority_WordIndex,			// document words for auto completion
+	IdleTaskPriority_Count,
+};
+
+// run task until timer expired, timer is set to task's time slot.
+typedef void (*IdleTaskProc)(HANDLE timer) noexcept;
+
+void IdleTask_Register(IdleTaskPriority priority, const bool *pending, IdleTaskProc proc, DWORD timeSlot) noexcept;
+bool IdleTask_Pending() noexcept;
+void IdleTask_Run(HANDLE timer) noexcept;
+// stop current time slot on timer expired or user input, typing always pre-empts idle tasks.
+inline bool IdleTask_Continue(HANDLE timer) noexcept {
+	return WaitableTimer_Continue(timer) && HIWORD(GetQueueStatus(QS_KEY | QS_MOUSEBUTTON)) == 0;
+}
+
 struct BackgroundWorker {
 	HWND hwnd;
 	HANDLE eventCancel;
@@ -672,6 +759,26 @@ struct BackgroundWorker {
 	}
 };
 
+// number of logical processors, used to limit thread pool work items.
+UINT GetHardwareConcurrency() noexcept;
+
+// background work nobody waits for (AutoSave, project words) runs with EcoQoS and below normal
+// priority while application is inactive or on battery, see SCI_SETBACKGROUNDWORKTHROTTLED.
+extern bool bBackgroundWorkThrottled;
+void SetCurrentThreadThrottled(bool throttled) noexcept;
+inline bool BackgroundWork_Begin() noexcept {
+	const bool throttled = bBackgroundWorkThrottled;
+	if (throttled) {
+		SetCurrentThreadThrottled(true);
+	}
+	return throttled;
+}
+inline void BackgroundWork_End(bool throttled) noexcept {
+	if (throttled) {
+		SetCurrentThreadThrottled(false);
+	}
+}
+
 HRESULT PrivateSetCurrentProcessExplicitAppUserModelID(LPCWSTR AppID) noexcept;
 bool IsElevated() noexcept;
 
@@ -863,6 +970,16 @@ inline void GetProgramRealPath(LPWSTR tchModule, DWORD nSize) noexcept {
 	}
 }
 
+#if _WIN32_WINNT < _WIN32_WINNT_WIN8
+enum { FileIdInfo = 0x12 };
+struct FILE_ID_INFO {
+	ULONGLONG VolumeSerialNumber;
+	FILE_ID_128 FileId;
+};
+#endif
+
+// volume serial number and file identifier, used to detect replaced (e.g. rotated) file
+BOOL PathGetFileId(HANDLE hFile, FILE_ID_INFO *fileId) noexcept;
 // similar to std::filesystem::equivalent()
 bool PathEquivalent(LPCWSTR pszPath1, LPCWSTR pszPath2) noexcept;
 void PathRelativeToApp(LPCWSTR lpszSrc, LPWSTR lpszDest, DWORD dwAttrTo, BOOL bUnexpandMyDocs) noexcept;
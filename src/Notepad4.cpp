@@ -31,6 +31,7 @@
 #include <cinttypes>
 #include "SciCall.h"
 #include "VectorISA.h"
+#include "EventTrace.h"
 #include "config.h"
 #include "Helpers.h"
 #include "Notepad4.h"
@@ -45,6 +46,8 @@
 #define NP2_LEXER_IDLE_STYLING		SC_IDLESTYLING_ALL
 // profile lexer performance inside Style_SetLexer()
 // #define NP2_LEXER_IDLE_STYLING		SC_IDLESTYLING_NONE
+// lex text after the visible area on worker thread
+#define NP2_LEXER_BACKGROUND_STYLING	true
 
 /******************************************************************************
 *
@@ -53,9 +56,12 @@
 */
 HWND	hwndStatus;
 static HWND hwndToolbar;
+static HBITMAP hbmpToolbarDisabled; // disabled toolbar image is created after startup
 static HWND hwndReBar;
 static HMONITOR hCurrentMonitor = nullptr;
 HWND	hwndEdit;
+// second view on the same document, nullptr when split view is closed
+HWND	hwndEditSplit;
 HWND	hwndMain;
 static HMENU hmenuMain;
 HWND	hDlgFindReplace = nullptr;
@@ -121,6 +127,7 @@ static bool bShowUnicodeControlCharacter;
 static bool bMatchBraces;
 static bool bShowIndentGuides;
 static bool bHighlightCurrentBlock;
+bool	bHighlightHyperlink;
 bool	bHighlightCurrentSubLine;
 LineHighlightMode iHighlightCurrentLine;
 EditTabSettings tabSettings;
@@ -131,6 +138,7 @@ int		iWrapColumn = 0;
 int		iZoomLevel = 100;
 bool	bShowBookmarkMargin;
 static bool bShowLineNumbers;
+static bool bShowOverviewRuler;
 static int bMarkOccurrences;
 int	iChangeHistoryMarker;
 EditAutoCompletionConfig autoCompletionConfig;
@@ -154,6 +162,7 @@ bool	bLoadANSIasUTF8;
 bool	bLoadASCIIasUTF8;
 bool	bLoadNFOasOEM;
 bool	bNoEncodingTags;
+bool	bHexDumpBinaryFile;
 extern int g_DOSEncoding;
 
 #if defined(_WIN64)
@@ -164,6 +173,7 @@ int		iCurrentEOLMode;
 bool	bWarnLineEndings;
 bool	bFixLineEndings;
 bool	bAutoStripBlanks;
+bool	bFixOnlyModifiedLines;
 PrintHeaderOption iPrintHeader;
 PrintFooterOption iPrintFooter;
 int		iPrintColor;
@@ -177,6 +187,9 @@ bool	bResetFileWatching;
 static DWORD dwFileCheckInterval;
 static DWORD dwAutoReloadTimeout;
 unsigned int dwUrlThreshold;
+unsigned int dwUndoMemoryLimit;
+unsigned int dwSearchIndexThreshold;
+static unsigned int dwLayoutThreads;
 bool bUseXPFileDialog;
 static EscFunction iEscFunction;
 static bool bAlwaysOnTop;
@@ -184,6 +197,7 @@ static bool bMinimizeToTray;
 static TransparentMode bTransparentMode;
 static int	iEndAtLastLine;
 int iFindReplaceOption;
+static int iFilterContextLines;
 static bool bEditLayoutRTL;
 bool	bWindowLayoutRTL;
 static int iRenderingTechnology;
@@ -193,6 +207,7 @@ static bool bShowMenu;
 static bool bShowToolbar;
 static int iAutoScaleToolbar;
 static bool bShowStatusbar;
+static bool bShowPaintStatistics;
 static bool bInFullScreenMode;
 static int iFullScreenMode;
 
@@ -217,6 +232,8 @@ static LPWSTR lpFileArg = nullptr;
 static LPWSTR lpSchemeArg = nullptr;
 static LPWSTR lpMatchArg = nullptr;
 static LPWSTR lpEncodingArg = nullptr;
+static LPWSTR lpBenchmarkArg = nullptr;
+static LPWSTR lpHandoffArg = nullptr;
 MRUList mruFile;
 MRUList mruFind;
 MRUList mruReplace;
@@ -253,7 +270,6 @@ bool bFreezeAppTitle = false;
 static WCHAR szTitleExcerpt[128] = L"";
 static bool fKeepTitleExcerpt = false;
 
-static HANDLE hChangeHandle = nullptr;
 static bool bRunningWatch = false;
 static DWORD dwChangeNotifyTime = 0;
 
@@ -265,6 +281,17 @@ static struct WatchFileInformation {
 	DWORD		nFileSizeLow;
 } fdCurFile;
 
+// loaded size of current file, used to append new content of growing log file
+static struct TailFileInformation {
+	bool		valid;
+	ULONGLONG	fileSize;
+	FILE_ID_INFO fileId;
+} tailCurFile;
+
+// detection result of current large file, written with view state on switching file or exit
+static bool bValidSnapshot = false;
+static EditFileSnapshot fileSnapshot;
+
 static EDITFINDREPLACE efrData;
 bool	bReplaceInitialized = false;
 EditMarkAll editMarkAll;
@@ -289,6 +316,14 @@ struct CachedStatusItem {
 	Sci_Line iLine;
 	Sci_Position iLineChar;
 	Sci_Position iLineColumn;
+	// counts from line start to caret
+	Sci_Position iCaretPos;
+	Sci_Position iCaretChar;
+	Sci_Position iCaretColumn;
+	// characters in selection, -1 when text changed
+	Sci_Position iSelStart;
+	Sci_Position iSelEnd;
+	Sci_Position iSelChar;
 
 	LPCWSTR pszLexerName;
 	LPCWSTR pszEncoding;
@@ -367,6 +402,8 @@ static int flagReadOnlyMode			= ReadOnlyMode_None;
 static TripleBoolean flagMultiFileArg = TripleBoolean_NotSet;
 static bool	flagSingleFileInstance	= true;
 static bool	flagStartAsTrayIcon		= false;
+static bool	flagStandbyInstance		= false;
+static bool bStandbyInstance		= false;
 static TripleBoolean flagAlwaysOnTop= TripleBoolean_NotSet;
 static bool	flagRelativeFileMRU		= false;
 static bool	flagPortableMyDocs		= false;
@@ -397,6 +434,11 @@ static inline bool IsDocumentModified() noexcept {
 	return bDocumentModified || iCurrentEncoding != iOriginalEncoding;
 }
 
+static bool FileTailAppend(bool bIsTail) noexcept;
+static HANDLE FileHandoff_Create(LPWSTR pszName, LPCSTR lpszText, Sci_Position cchText, Sci_Line lineCount) noexcept;
+static bool FileHandoff_Load(LPCWSTR pszName) noexcept;
+static void FileWatcher_Notified() noexcept;
+
 static inline bool IsTopMost() noexcept {
 	return (bAlwaysOnTop || flagAlwaysOnTop == TripleBoolean_True) && flagAlwaysOnTop != TripleBoolean_False;
 }
@@ -419,6 +461,7 @@ static void CleanUpResources(bool initialized) noexcept {
 		LocalFree(lpSchemeArg);
 	}
 
+	IniCache_Free();
 	Encoding_ReleaseResources();
 	Style_ReleaseResources();
 	Edit_ReleaseResources();
@@ -438,6 +481,159 @@ static void CleanUpResources(bool initialized) noexcept {
 	OleUninitialize();
 }
 
+static void EditMarkAll_Continue(HANDLE timer) noexcept {
+	editMarkAll.Continue(timer);
+}
+
+// elapsed time from wWinMain() to end of each startup phase, written as StartupPhase trace event.
+enum StartupPhase {
+	StartupPhase_Settings,	// command line, ini file and settings loaded
+	StartupPhase_Window,	// main window created and painted
+	StartupPhase_Document,	// file loaded
+	StartupPhase_Ready,		// command line actions done, caret ready
+	StartupPhase_Deferred,	// deferred initialization done
+	StartupPhase_Count,
+};
+
+static StopWatch startupWatch;
+static UINT startupPhaseTime[StartupPhase_Count];
+static bool deferredInitPending;
+
+static void StartupPhase_End(StartupPhase phase) noexcept {
+	static const char * const phaseNames[StartupPhase_Count] = {
+		"Settings",
+		"Window",
+		"Document",
+		"Ready",
+		"Deferred",
+	};
+	startupWatch.Stop();
+	const double elapsed = startupWatch.Get();
+	startupPhaseTime[phase] = static_cast<UINT>(elapsed);
+	EventTraceWrite("StartupPhase", TraceLoggingString(phaseNames[phase], "Phase"), TraceLoggingFloat64(elapsed, "Elapsed"));
+}
+
+void GetStartupTiming(LPWSTR lpszText) noexcept {
+	wsprintf(lpszText, L"Startup: settings %u ms, window %u ms, document %u ms, ready %u ms, deferred %u ms\n",
+		startupPhaseTime[StartupPhase_Settings], startupPhaseTime[StartupPhase_Window],
+		startupPhaseTime[StartupPhase_Document], startupPhaseTime[StartupPhase_Ready],
+		startupPhaseTime[StartupPhase_Deferred]);
+}
+
+static void SetToolbarDisabledImage() noexcept {
+	HBITMAP hbmp = hbmpToolbarDisabled;
+	hbmpToolbarDisabled = nullptr;
+	// StopWatch watch;
+	// watch.Start();
+	const bool fProcessed = BitmapAlphaBlend(hbmp, GetSysColor(COLOR_3DFACE), 0x60);
+	// watch.Stop();
+	// watch.ShowLog("BitmapAlphaBlend");
+	if (fProcessed) {
+		BITMAP bmp;
+		GetObject(hbmp, sizeof(BITMAP), &bmp);
+		HIMAGELIST himl = ImageList_Create(bmp.bmHeight, bmp.bmHeight, ILC_COLOR32 | ILC_MASK, 0, 0);
+		ImageList_AddMasked(himl, hbmp, CLR_DEFAULT);
+		SendMessage(hwndToolbar, TB_SETDISABLEDIMAGELIST, 0, AsInteger<LPARAM>(himl));
+	}
+	DeleteObject(hbmp);
+}
+
+// work not needed for first paint: disabled toolbar image and remaining schemes.
+//=============================================================================
+//
+// Standby instance
+//
+// a hidden instance started with /standby waits for next launch,
+// the named mutex ensures only one standby for each window class.
+#define STANDBY_WINDOW_PROP		L"Notepad4.Standby"
+static HANDLE hStandbyMutex;
+
+static inline void GetStandbyMutexName(LPWSTR name) noexcept {
+	StrCpyEx(name, L"Local\\Notepad4.Standby.");
+	lstrcat(name, wchWndClass);
+}
+
+static bool Standby_Acquire() noexcept {
+	WCHAR name[64];
+	GetStandbyMutexName(name);
+	hStandbyMutex = CreateMutex(nullptr, FALSE, name);
+	if (hStandbyMutex != nullptr && GetLastError() == ERROR_ALREADY_EXISTS) {
+		CloseHandle(hStandbyMutex);
+		hStandbyMutex = nullptr;
+	}
+	return hStandbyMutex != nullptr;
+}
+
+static void Standby_Launch() noexcept {
+	WCHAR name[64];
+	GetStandbyMutexName(name);
+	HANDLE hMutex = OpenMutex(SYNCHRONIZE, FALSE, name);
+	if (hMutex != nullptr) {
+		// already have one
+		CloseHandle(hMutex);
+		return;
+	}
+
+	WCHAR szModule[MAX_PATH];
+	GetModuleFileName(nullptr, szModule, COUNTOF(szModule));
+	WCHAR szCmdLine[MAX_PATH + 16];
+	wsprintf(szCmdLine, L"\"%s\" /standby", szModule);
+
+	STARTUPINFO si;
+	memset(&si, 0, sizeof(STARTUPINFO));
+	si.cb = sizeof(STARTUPINFO);
+	PROCESS_INFORMATION pi;
+	memset(&pi, 0, sizeof(PROCESS_INFORMATION));
+	// initialize in background without competing with current window
+	if (CreateProcess(szModule, szCmdLine, nullptr, nullptr, FALSE, BELOW_NORMAL_PRIORITY_CLASS, nullptr, g_wchWorkingDirectory, &si, &pi)) {
+		CloseHandle(pi.hThread);
+		CloseHandle(pi.hProcess);
+	}
+}
+
+static BOOL CALLBACK EnumWindProcStandbyInstance(HWND hwnd, LPARAM lParam) noexcept {
+	WCHAR szClassName[64];
+	if (GetClassName(hwnd, szClassName, COUNTOF(szClassName)) && StrCaseEqual(szClassName, wchWndClass)
+		&& GetProp(hwnd, STANDBY_WINDOW_PROP) != nullptr && IsWindowEnabled(hwnd)) {
+		*AsPointer<HWND *>(lParam) = hwnd;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void Standby_Activate(HWND hwnd, int nCmdShow) noexcept {
+	flagStandbyInstance = false;
+	RemoveProp(hwnd, STANDBY_WINDOW_PROP);
+	if (hStandbyMutex != nullptr) {
+		CloseHandle(hStandbyMutex);
+		hStandbyMutex = nullptr;
+	}
+	SetPriorityClass(GetCurrentProcess(), NORMAL_PRIORITY_CLASS);
+	ShowWindow(hwnd, wi.max ? SW_SHOWMAXIMIZED : nCmdShow);
+	UpdateWindow(hwnd);
+	SetForegroundWindow(hwnd);
+	// prepare next one
+	Standby_Launch();
+}
+
+static void DeferredInit_Continue(HANDLE timer) noexcept {
+	if (hbmpToolbarDisabled != nullptr) {
+		SetToolbarDisabledImage();
+		InvalidateRect(hwndToolbar, nullptr, TRUE);
+		if (!IdleTask_Continue(timer)) {
+			return;
+		}
+	}
+	if (Style_LoadDeferred(timer)) {
+		IniCache_Free();
+		deferredInitPending = false;
+		StartupPhase_End(StartupPhase_Deferred);
+		if (bStandbyInstance && !flagStandbyInstance) {
+			Standby_Launch();
+		}
+	}
+}
+
 static void DispatchMessageMain(MSG *msg) noexcept {
 	if (hDlgFindReplace != nullptr && (msg->hwnd == hDlgFindReplace || IsChild(hDlgFindReplace, msg->hwnd))) {
 		if (TranslateAccelerator(hDlgFindReplace, hAccFindReplace, msg) || IsDialogMessage(hDlgFindReplace, msg)) {
@@ -494,6 +690,7 @@ static LONG WINAPI TopLevelHandler(EXCEPTION_POINTERS *ep) {
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nShowCmd) {
 	UNREFERENCED_PARAMETER(hPrevInstance);
 	UNREFERENCED_PARAMETER(lpCmdLine);
+	startupWatch.Start();
 #if 0 // used for Clang UBSan or printing debug message on console.
 	if (AttachConsole(ATTACH_PARENT_PROCESS)) {
 		SetConsoleCtrlHandler(ConsoleHandlerRoutine, TRUE);
@@ -545,6 +742,8 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 	// Command Line, Ini File and Flags
 	ParseCommandLine();
 	FindIniFile();
+	// read ini file once for startup, released after deferred initialization
+	IniCache_Load(szIniFile, false);
 	LoadFlags();
 
 	// set AppUserModelID
@@ -567,6 +766,22 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 		return 0;
 	}
 
+	// Editing scenarios benchmark, results are written to the file and no window is shown.
+	if (lpBenchmarkArg) {
+		OleInitialize(nullptr);
+#if _WIN32_WINNT >= _WIN32_WINNT_WIN10
+		g_uSystemDPI = GetDpiForSystem();
+#else
+		Scintilla_LoadDpiForWindow();
+#endif
+		Scintilla_RegisterClasses(hInstance);
+		const int result = RunScenarioBenchmark(hInstance, lpBenchmarkArg);
+		LocalFree(lpBenchmarkArg);
+		Scintilla_ReleaseResources();
+		OleUninitialize();
+		return result;
+	}
+
 	// Adapt window class name
 	if (fIsElevated) {
 		lstrcat(wchWndClass, L"U");
@@ -575,20 +790,26 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 		lstrcat(wchWndClass, L"B");
 	}
 
-	// Relaunch with elevated privileges
-	if (RelaunchElevated()) {
-		return 0;
-	}
+	if (flagStandbyInstance) {
+		if (!bStandbyInstance || !Standby_Acquire()) {
+			return 0;
+		}
+	} else {
+		// Relaunch with elevated privileges
+		if (RelaunchElevated()) {
+			return 0;
+		}
 
-	// Try to run multiple instances
-	if (RelaunchMultiInst()) {
-		return 0;
-	}
+		// Try to run multiple instances
+		if (RelaunchMultiInst()) {
+			return 0;
+		}
 
-	// Try to activate another window
-	if (ActivatePrevInst()) {
-		NP2HeapFree(lpFileArg);
-		return 0;
+		// Try to activate another window
+		if (ActivatePrevInst() || (bStandbyInstance && ActivateStandbyInst(nShowCmd))) {
+			NP2HeapFree(lpFileArg);
+			return 0;
+		}
 	}
 
 	// Init OLE and Common Controls
@@ -623,6 +844,11 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
 	// Load Settings
 	LoadSettings();
+	StartupPhase_End(StartupPhase_Settings);
+	if (iRenderingTechnology != SC_TECHNOLOGY_DEFAULT) {
+		// overlap DirectWrite loading with window creation
+		Scintilla_PreloadDirectWrite();
+	}
 
 	if (!InitApplication(hInstance)) {
 		CleanUpResources(false);
@@ -632,22 +858,26 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 	// create the timer first, to make flagMatchText working.
 	HANDLE timer = idleTaskTimer = WaitableTimer_Create();
 	QueryPerformanceFrequency(&editMarkAll.watch.freq);
+	IdleTask_Register(IdleTaskPriority_AutoComplete, &autoCompletePending, EditCompleteWordContinue, WaitableTimer_IdleTaskTimeSlot);
+	IdleTask_Register(IdleTaskPriority_DeferredInit, &deferredInitPending, DeferredInit_Continue, WaitableTimer_IdleTaskTimeSlot);
+	IdleTask_Register(IdleTaskPriority_MarkOccurrences, &editMarkAll.pending, EditMarkAll_Continue, WaitableTimer_IdleTaskTimeSlot);
+	IdleTask_Register(IdleTaskPriority_WordIndex, &docWordIndexPending, EditWordIndexContinue, WaitableTimer_IdleTaskTimeSlot);
+	deferredInitPending = true;
 	InitInstance(hInstance, nShowCmd);
+	StartupPhase_End(StartupPhase_Ready);
 	hAccMain = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDR_MAINWND));
 	hAccFindReplace = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDR_ACCFINDREPLACE));
 	MSG msg;
 
 	while (true) {
-		if (editMarkAll.pending) {
+		if (IdleTask_Pending()) {
 			WaitableTimer_Set(timer, WaitableTimer_IdleTaskDelayTime);
-			while (editMarkAll.pending && WaitableTimer_Continue(timer)) {
+			while (IdleTask_Pending() && WaitableTimer_Continue(timer)) {
 				if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
 					DispatchMessageMain(&msg);
 				}
 			}
-			if (editMarkAll.pending) {
-				editMarkAll.Continue(timer);
-			}
+			IdleTask_Run(timer);
 		}
 		if (GetMessage(&msg, nullptr, 0, 0)) {
 			DispatchMessageMain(&msg);
@@ -836,13 +1066,17 @@ void InitInstance(HINSTANCE hInstance, int nCmdShow) {
 	if (!bShowMenu) {
 		SetMenu(hwnd, nullptr);
 	}
-	if (!flagStartAsTrayIcon) {
+	if (flagStandbyInstance) {
+		// stay hidden until APPM_STANDBY_ACTIVATE
+		SetProp(hwnd, STANDBY_WINDOW_PROP, hwnd);
+	} else if (!flagStartAsTrayIcon) {
 		ShowWindow(hwnd, wi.max ? SW_SHOWMAXIMIZED : nCmdShow);
 		UpdateWindow(hwnd);
 	} else {
 		ShowWindow(hwnd, SW_HIDE); // trick ShowWindow()
 		ShowNotifyIcon(hwnd, true);
 	}
+	StartupPhase_End(StartupPhase_Window);
 
 	// Source Encoding
 	if (lpEncodingArg) {
@@ -853,8 +1087,17 @@ void InitInstance(HINSTANCE hInstance, int nCmdShow) {
 	UpdateStatusBarCache(StatusItem_Zoom);
 	bool bOpened = false;
 	bool bFileLoadCalled = false;
+	// Document handed over from non-elevated instance
+	if (lpHandoffArg) {
+		bOpened = FileHandoff_Load(lpHandoffArg);
+		bFileLoadCalled = bOpened;
+		LocalFree(lpHandoffArg);
+		lpHandoffArg = nullptr;
+	}
 	// Pathname parameter
-	if (lpFileArg /*&& !flagNewFromClipboard*/) {
+	if (lpFileArg && bOpened) {
+		NP2HeapFree(lpFileArg);
+	} else if (lpFileArg /*&& !flagNewFromClipboard*/) {
 
 		// Open from Directory
 		if (PathIsDirectory(lpFileArg)) {
@@ -890,6 +1133,7 @@ void InitInstance(HINSTANCE hInstance, int nCmdShow) {
 	if (!bFileLoadCalled) {
 		bOpened = FileLoad(static_cast<FileLoadFlag>(FileLoadFlag_DontSave | FileLoadFlag_New), L"");
 	}
+	StartupPhase_End(StartupPhase_Document);
 	if (!bOpened) {
 		UpdateStatusBarCache(StatusItem_Encoding);
 		UpdateStatusBarCache(StatusItem_EolMode);
@@ -986,10 +1230,30 @@ void InitInstance(HINSTANCE hInstance, int nCmdShow) {
 #endif
 }
 
+#define RELEASE_MEMORY_INACTIVE_TIMEOUT	(5*60*1000)	// 5 minutes in background
+
+// release layout caches and drawing resources of hidden or inactive window, then trim working set.
+// everything is recreated on demand when the window is painted again.
+static void ReleaseInactiveMemory(HWND hwnd) noexcept {
+	KillTimer(hwnd, ID_RELEASEMEMORYTIMER);
+	SciCall_ReleaseResources();
+	HeapCompact(g_hDefaultHeap, 0);
+	SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1), static_cast<SIZE_T>(-1));
+}
+
+// throttle background work while application is inactive or system runs on battery.
+static void UpdateBackgroundWorkThrottled(bool bInactive) noexcept {
+	SYSTEM_POWER_STATUS status;
+	const bool bOnBattery = GetSystemPowerStatus(&status) && status.ACLineStatus == 0;
+	bBackgroundWorkThrottled = bInactive || bOnBattery;
+	SciCall_SetBackgroundWorkThrottled(bBackgroundWorkThrottled);
+}
+
 static inline void NP2MinimizeWind(HWND hwnd) noexcept {
 	MinimizeWndToTray(hwnd);
 	ShowNotifyIcon(hwnd, true);
 	SetNotifyIconTitle(hwnd);
+	ReleaseInactiveMemory(hwnd);
 }
 
 static inline void NP2RestoreWind(HWND hwnd) noexcept {
@@ -1065,10 +1329,16 @@ static inline bool IsFileStartsWithDotLog() noexcept {
 #endif
 
 static void SaveAllSettings(bool destroy) noexcept {
+	// read ini file once, changed sections are written back in one file replace
+	const bool cached = CreateIniFile(szIniFile) && IniCache_Load(szIniFile, true);
 	SaveSettings(false);
 	mruFile.MergeSave(bSaveRecentFiles, destroy);
 	mruFind.MergeSave(bSaveFindReplace, destroy);
 	mruReplace.MergeSave(bSaveFindReplace, destroy);
+	if (cached) {
+		IniCache_Flush();
+		IniCache_Free();
+	}
 }
 
 //=============================================================================
@@ -1115,6 +1385,7 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 		if (!bShutdownOK) {
 			editMarkAll.Stop();
 			AutoSave_Stop(TRUE);
+			FileSnapshot_Save();
 			// Terminate file watching
 			InstallFileWatching(true);
 			DragAcceptFiles(hwnd, FALSE);
@@ -1130,8 +1401,11 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 				DestroyWindow(hDlgFindReplace);
 			}
 
-			// call SaveSettings() when hwndToolbar is still valid
-			SaveAllSettings(true);
+			// call SaveSettings() when hwndToolbar is still valid,
+			// unused standby instance has nothing newer than the ini file.
+			if (!flagStandbyInstance) {
+				SaveAllSettings(true);
+			}
 			bitmapCache.Empty();
 
 			// Remove tray icon if necessary
@@ -1168,6 +1442,8 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 			if (iAutoSaveOption & AutoSaveOption_Suspend) {
 				AutoSave_DoWork(FileSaveFlag_SaveCopy);
 			}
+		} else if (wParam == PBT_APMPOWERSTATUSCHANGE) {
+			UpdateBackgroundWorkThrottled(GetActiveWindow() == nullptr);
 		}
 		break;
 
@@ -1197,10 +1473,17 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 	case WM_TIMER:
 		if (wParam == ID_AUTOSAVETIMER) {
 			AutoSave_DoWork(FileSaveFlag_Default);
+		} else if (wParam == ID_PAINTSTATISTICSTIMER) {
+			UpdatePaintStatistics();
+		} else if (wParam == ID_RELEASEMEMORYTIMER) {
+			ReleaseInactiveMemory(hwnd);
 		}
 		break;
 
 	case WM_SIZE:
+		if (wParam == SIZE_MINIMIZED) {
+			ReleaseInactiveMemory(hwnd);
+		}
 		MsgSize(hwnd, wParam, lParam);
 		break;
 
@@ -1235,11 +1518,26 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 		}
 		break;
 
+	case WM_ACTIVATEAPP:
+		UpdateBackgroundWorkThrottled(!wParam);
+		if (wParam) {
+			KillTimer(hwnd, ID_RELEASEMEMORYTIMER);
+		} else {
+			SetTimer(hwnd, ID_RELEASEMEMORYTIMER, RELEASE_MEMORY_INACTIVE_TIMEOUT, nullptr);
+		}
+		break;
+
 	case WM_DROPFILES:
 	case APPM_DROPFILES:
 		MsgDropFiles(hwnd, umsg, wParam);
 		break;
 
+	case APPM_STANDBY_ACTIVATE:
+		if (flagStandbyInstance) {
+			Standby_Activate(hwnd, static_cast<int>(wParam));
+		}
+		return 0;
+
 	case WM_COPYDATA: {
 		PCOPYDATASTRUCT pcds = AsPointer<PCOPYDATASTRUCT>(lParam);
 
@@ -1434,7 +1732,8 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 					&& ((iFileWatchingOption & FileWatchingOption_KeepAtEnd) || (SciCall_LineFromPosition(SciCall_GetCurrentPos()) + 1 == SciCall_GetLineCount()));
 
 				iWeakSrcEncoding = iCurrentEncoding;
-				if (FileLoad(static_cast<FileLoadFlag>(FileLoadFlag_DontSave | FileLoadFlag_Reload), szCurFile)) {
+				if ((iFileWatchingMode == FileWatchingMode_AutoReload && (iFileWatchingOption & FileWatchingOption_LogFile) && FileTailAppend(bIsTail))
+					|| FileLoad(static_cast<FileLoadFlag>(FileLoadFlag_DontSave | FileLoadFlag_Reload), szCurFile)) {
 					if (bIsTail) {
 						EditJumpTo(INVALID_POSITION, 0);
 					}
@@ -1453,6 +1752,14 @@ LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam)
 		}
 	} break;
 
+	case APPM_WATCHNOTIFY:
+		FileWatcher_Notified();
+		break;
+
+	case APPM_AUTOSAVE_DONE:
+		AutoSave_FinishWork(false);
+		break;
+
 	//// This message is posted before Notepad4 reactivates itself
 	//case APPM_CHANGENOTIFYCLEAR:
 	//	bPendingChangeNotify = false;
@@ -1652,6 +1959,14 @@ void UpdateBookmarkMarginWidth() noexcept {
 	SciCall_SetMarginWidth(MarginNumber_Bookmark, width);
 }
 
+// marks of bookmarks, change history and occurrences beside vertical scroll bar.
+void UpdateOverviewRuler() noexcept {
+	const int width = bShowOverviewRuler ? SystemMetricsForDpi(SM_CXVSCROLL, g_uCurrentDPI)/2 : 0;
+	SciCall_SetOverviewRulerWidth(width);
+	SciCall_SetOverviewRulerMarkers(bShowOverviewRuler ? (MarkerBitmask_Bookmark | SC_MASK_HISTORY) : 0);
+	SciCall_IndicSetOverviewRuler(IndicatorNumber_MarkOccurrence, bShowOverviewRuler);
+}
+
 void SetWrapVisualFlags() noexcept {
 	if (bShowWordWrapSymbols) {
 		int wrapVisualFlags = 0;
@@ -1691,6 +2006,8 @@ void SetWrapVisualFlags() noexcept {
 	}
 }
 
+static void EditInitView(HWND hwnd) noexcept;
+
 //=============================================================================
 //
 // EditCreate()
@@ -1710,11 +2027,16 @@ void EditCreate(HWND hwndParent) noexcept {
 	efrData.hwnd = hwnd;
 	InitScintillaHandle(hwnd);
 	//SciInitThemes(hwnd);
+	Style_InitDefaultColor();
+	EditInitView(hwnd);
+}
+
+// apply view settings to edit control attached to g_hScintilla
+static void EditInitView(HWND hwnd) noexcept {
 	if (bEditLayoutRTL) {
 		SetWindowLayoutRTL(hwnd, true);
 	}
 
-	Style_InitDefaultColor();
 	SciCall_SetTechnology(iRenderingTechnology);
 	SciCall_SetBidirectional(iBidirectional);
 	SciCall_SetIMEInteraction(bUseInlineIME);
@@ -1734,6 +2056,8 @@ void EditCreate(HWND hwndParent) noexcept {
 	SciCall_SetAdditionalCaretsBlink(true);
 	SciCall_SetAdditionalCaretsVisible(true);
 	SciCall_SetIdleStyling(NP2_LEXER_IDLE_STYLING);
+	SciCall_SetBackgroundStyling(NP2_LEXER_BACKGROUND_STYLING);
+	SciCall_SetLayoutThreads(dwLayoutThreads);
 
 	SciCall_AssignCmdKey((SCK_NEXT + (SCMOD_CTRL << 16)), SCI_PARADOWN);
 	SciCall_AssignCmdKey((SCK_PRIOR + (SCMOD_CTRL << 16)), SCI_PARAUP);
@@ -1818,12 +2142,70 @@ void EditCreate(HWND hwndParent) noexcept {
 }
 
 void EditReplaceDocument(HANDLE pdoc) noexcept {
+	EditWordIndexReset();
+	EditOutlineReset();
+	EditHyperlinkReset();
+	EditPrintReset();
 	const UINT cpEdit = SciCall_GetCodePage();
 	SciCall_SetDocPointer(pdoc);
 	// reduce reference count to 1
 	SciCall_ReleaseDocument(pdoc);
 	SciCall_SetCodePage(cpEdit);
 	SciCall_SetEOLMode(iCurrentEOLMode);
+	if (hwndEditSplit != nullptr) {
+		SendMessage(hwndEditSplit, SCI_SETDOCPOINTER, 0, AsInteger<LPARAM>(pdoc));
+	}
+}
+
+//=============================================================================
+//
+// ToggleSplitView()
+//
+// Split view is a second edit control on the document of main edit control,
+// text, styles, folding levels and undo history exist only once, each view
+// only owns its layout (wrapping, folding state, hidden lines, selection).
+// Commands still target the main view.
+//
+void ToggleSplitView() noexcept {
+	if (hwndEditSplit != nullptr) {
+		DestroyWindow(hwndEditSplit);
+		hwndEditSplit = nullptr;
+		SendWMSize(hwndMain);
+		SetFocus(hwndEdit);
+		return;
+	}
+
+	const DWORD dwExStyle = IsAppThemed() ? 0 : WS_EX_CLIENTEDGE;
+	HWND hwnd = CreateWindowEx(dwExStyle,
+						  L"Scintilla",
+						  nullptr,
+						  WS_CHILD | WS_VISIBLE | WS_CLIPSIBLINGS,
+						  0, 0, 0, 0,
+						  hwndMain,
+						  AsPointer<HMENU, ULONG_PTR>(IDC_EDIT_SPLIT),
+						  g_hInstance,
+						  nullptr);
+	if (hwnd == nullptr) {
+		return;
+	}
+
+	HANDLE pdoc = SciCall_GetDocPointer();
+	const Sci_Line iFirstLine = SciCall_DocLineFromVisible(SciCall_GetFirstVisibleLine());
+	const Sci_Position iAnchorPos = SciCall_GetAnchor();
+	const Sci_Position iCurrentPos = SciCall_GetCurrentPos();
+	HANDLE handle = g_hScintilla;
+	InitScintillaHandle(hwnd);
+	EditInitView(hwnd);
+	SciCall_SetDocPointer(pdoc);
+	// only view styles, lexer is owned by the shared document
+	Style_SetLexer(pLexCurrent, false);
+	SciCall_SetSel(iAnchorPos, iCurrentPos);
+	// folding state is not shared, all lines are visible in new view
+	SciCall_SetFirstVisibleLine(iFirstLine);
+	g_hScintilla = handle;
+
+	hwndEditSplit = hwnd;
+	SendWMSize(hwndMain);
 }
 
 //=============================================================================
@@ -1917,19 +2299,16 @@ void CreateBars(HWND hwnd, HINSTANCE hInstance) noexcept {
 	ImageList_AddMasked(himl, hbmp, CLR_DEFAULT);
 	SendMessage(hwndToolbar, TB_SETIMAGELIST, 0, AsInteger<LPARAM>(himl));
 
+	if (hbmpToolbarDisabled != nullptr) {
+		// toolbar recreated before deferred initialization
+		DeleteObject(hbmpToolbarDisabled);
+		hbmpToolbarDisabled = nullptr;
+	}
 	if (internalBitmap) {
-		HBITMAP hbmpCopy = static_cast<HBITMAP>(CopyImage(hbmp, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION));
-		// StopWatch watch;
-		// watch.Start();
-		const bool fProcessed = BitmapAlphaBlend(hbmpCopy, GetSysColor(COLOR_3DFACE), 0x60);
-		// watch.Stop();
-		// watch.ShowLog("BitmapAlphaBlend");
-		if (fProcessed) {
-			himl = ImageList_Create(bmp.bmHeight, bmp.bmHeight, ILC_COLOR32 | ILC_MASK, 0, 0);
-			ImageList_AddMasked(himl, hbmpCopy, CLR_DEFAULT);
-			SendMessage(hwndToolbar, TB_SETDISABLEDIMAGELIST, 0, AsInteger<LPARAM>(himl));
-		}
-		DeleteObject(hbmpCopy);
+		hbmpToolbarDisabled = static_cast<HBITMAP>(CopyImage(hbmp, IMAGE_BITMAP, 0, 0, LR_CREATEDIBSECTION));
+		if (bInitDone) {
+			SetToolbarDisabledImage();
+		}
 	}
 	DeleteObject(hbmp);
 
@@ -2049,6 +2428,7 @@ void MsgDPIChanged(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	UpdateLineNumberWidth();
 	UpdateBookmarkMarginWidth();
 	UpdateFoldMarginWidth();
+	UpdateOverviewRuler();
 	SciCall_SetFirstVisibleLine(iVisTopLine);
 	SciCall_EnsureVisible(iDocTopLine);
 	UpdateToolbar();
@@ -2130,6 +2510,13 @@ void MsgSize(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 		cy -= (rc.bottom - rc.top);
 	}
 
+	if (hwndEditSplit != nullptr) {
+		// split view above the main view
+		const int cySplit = cy / 2;
+		SetWindowPos(hwndEditSplit, nullptr, x, y, cx, cySplit, SWP_NOZORDER | SWP_NOACTIVATE);
+		y += cySplit;
+		cy -= cySplit;
+	}
 	SetWindowPos(hwndEdit, nullptr, x, y, cx, cy, SWP_NOZORDER | SWP_NOACTIVATE);
 
 	// resize Statusbar items
@@ -2376,6 +2763,7 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	const bool nonEmpty = SciCall_GetLength() != 0;
 	static const uint16_t menuRequiresDoc[] = {
 		BME_EDIT_BOOKMARKCLEAR,
+		BME_EDIT_BOOKMARKEXTRACT,
 		BME_EDIT_BOOKMARKNEXT,
 		BME_EDIT_BOOKMARKPREV,
 		BME_EDIT_BOOKMARKSELECT,
@@ -2398,6 +2786,7 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 		IDM_EDIT_FINDNEXT,
 		IDM_EDIT_FINDPREV,
 		IDM_EDIT_GOTOLINE,
+		IDM_EDIT_GOTOSYMBOL,
 		IDM_EDIT_GOTO_BLOCK_END,
 		IDM_EDIT_GOTO_BLOCK_START,
 		IDM_EDIT_GOTO_NEXT_BLOCK,
@@ -2492,6 +2881,10 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	//EnableCmd(hmenu, IDM_EDIT_PASTE_BINARY, canPaste);
 	EnableCmd(hmenu, IDM_EDIT_SWAP, hasSel || canPaste);
 
+	EnableCmd(hmenu, IDM_EDIT_COMPARE_SELECTIONS, SciCall_GetSelectionCount() == 2 && !SciCall_IsRectangularSelection());
+	EnableCmd(hmenu, IDM_EDIT_COMPARE_EXPORT, EditCompareCanExport());
+	EnableCmd(hmenu, IDM_EDIT_FILTER_CLEAR, EditIsFilterActive());
+
 	i = EditGetSelectedLineCount() > 1;
 	EnableCmd(hmenu, IDM_EDIT_SORTLINES, i);
 	EnableCmd(hmenu, IDM_EDIT_REMOVEDUPLICATELINE, i);
@@ -2522,6 +2915,7 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	CheckCmd(hmenu, IDM_VIEW_LINENUMBERS, bShowLineNumbers);
 	CheckCmd(hmenu, IDM_VIEW_MARGIN, bShowBookmarkMargin);
 	CheckCmd(hmenu, IDM_VIEW_CHANGE_HISTORY_MARKER, iChangeHistoryMarker);
+	CheckCmd(hmenu, IDM_VIEW_OVERVIEW_RULER, bShowOverviewRuler);
 	CheckCmd(hmenu, IDM_VIEW_AUTOCOMPLETION_IGNORECASE, autoCompletionConfig.bIgnoreCase);
 	CheckCmd(hmenu, IDM_SET_LATEX_INPUT_METHOD, autoCompletionConfig.bLaTeXInputMethod);
 	CheckCmd(hmenu, IDM_SET_MULTIPLE_SELECTION, iSelectOption & SelectOption_EnableMultipleSelection);
@@ -2554,6 +2948,8 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	CheckCmd(hmenu, IDM_VIEW_USE_LARGE_TOOLBAR, iAutoScaleToolbar > USER_DEFAULT_SCREEN_DPI);
 #endif
 	CheckCmd(hmenu, IDM_VIEW_STATUSBAR, bShowStatusbar);
+	CheckCmd(hmenu, IDM_VIEW_PAINT_STATISTICS, bShowPaintStatistics);
+	EnableCmd(hmenu, IDM_VIEW_PAINT_STATISTICS, bShowStatusbar);
 #if NP2_ENABLE_APP_LOCALIZATION_DLL
 	CheckMenuRadioItem(hmenu, IDM_LANG_USER_DEFAULT, IDM_LANG_LAST_LANGUAGE, languageMenu, MF_BYCOMMAND);
 #endif
@@ -2571,6 +2967,7 @@ void MsgInitMenu(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept {
 	DisableCmd(hmenu, IDM_VIEW_CLEARWINPOS, bStickyWindowPosition);
 	CheckCmd(hmenu, IDM_VIEW_SINGLEFILEINSTANCE, bSingleFileInstance);
 	CheckCmd(hmenu, IDM_VIEW_ALWAYSONTOP, IsTopMost());
+	CheckCmd(hmenu, IDM_VIEW_SPLIT_VIEW, hwndEditSplit != nullptr);
 	CheckCmd(hmenu, IDM_VIEW_MINTOTRAY, bMinimizeToTray);
 	CheckCmd(hmenu, IDM_VIEW_TRANSPARENT, bTransparentMode == TransparentMode_Always);
 	CheckCmd(hmenu, IDM_VIEW_TRANSPARENT_INACTIVE, bTransparentMode == TransparentMode_Inactive);
@@ -3182,7 +3579,7 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 	case IDM_EDIT_REMOVEDUPLICATELINE:
 	case IDM_EDIT_MERGEDUPLICATELINE:
 		BeginWaitCursor();
-		EditSortLines(static_cast<EditSortFlag>(EditSortFlag_DontSort | ((LOWORD(wParam) == IDM_EDIT_REMOVEDUPLICATELINE) ? EditSortFlag_RemoveDuplicate : EditSortFlag_MergeDuplicate)));
+		EditRemoveDuplicateLines(LOWORD(wParam) == IDM_EDIT_MERGEDUPLICATELINE);
 		EndWaitCursor();
 		break;
 
@@ -3227,7 +3624,7 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 
 	case IDM_EDIT_PADWITHSPACES:
 		BeginWaitCursor();
-		EditPadWithSpaces(false, false);
+		EditPadWithSpaces(false);
 		EndWaitCursor();
 		break;
 
@@ -3610,6 +4007,28 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		EditShowCharacterInfo();
 		break;
 
+	case IDM_EDIT_SHOW_TEXT_STATISTICS:
+		EditShowTextStatistics();
+		break;
+
+	case IDM_EDIT_COMPARE_FILE:
+		EditCompareWithFile(hwnd);
+		break;
+
+	case IDM_EDIT_COMPARE_SELECTIONS:
+		BeginWaitCursor();
+		EditCompareSelections();
+		EndWaitCursor();
+		break;
+
+	case IDM_EDIT_COMPARE_EXPORT:
+		EditCompareExportDiff(hwnd);
+		break;
+
+	case IDM_EDIT_COMPARE_CLEAR:
+		EditCompareClear();
+		break;
+
 	case IDM_EDIT_COPYRTF:
 	case IDM_EDIT_CODE_COMPRESS:
 	case IDM_EDIT_CODE_PRETTY:
@@ -3676,13 +4095,17 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 	break;
 
 	// Main Bookmark Functions
+	case IDM_EDIT_COMPARE_NEXT:
+	case IDM_EDIT_COMPARE_PREV:
 	case BME_EDIT_BOOKMARKNEXT:
 	case BME_EDIT_BOOKMARKPREV: {
 		const Sci_Position iPos = SciCall_GetCurrentPos();
 		const Sci_Line iLine = SciCall_LineFromPosition(iPos);
 
 		Sci_Line iNextLine;
-		if (LOWORD(wParam) == BME_EDIT_BOOKMARKNEXT) {
+		if (LOWORD(wParam) == IDM_EDIT_COMPARE_NEXT || LOWORD(wParam) == IDM_EDIT_COMPARE_PREV) {
+			iNextLine = EditCompareFindDifference(LOWORD(wParam) == IDM_EDIT_COMPARE_NEXT);
+		} else if (LOWORD(wParam) == BME_EDIT_BOOKMARKNEXT) {
 			iNextLine = SciCall_MarkerNext(iLine + 1, MarkerBitmask_Bookmark);
 			if (iNextLine < 0) {
 				iNextLine = SciCall_MarkerNext(0, MarkerBitmask_Bookmark);
@@ -3714,6 +4137,12 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		EditBookmarkSelectAll();
 		break;
 
+	case BME_EDIT_BOOKMARKEXTRACT:
+		BeginWaitCursor();
+		ExtractBookmarkedLines(hwnd);
+		EndWaitCursor();
+		break;
+
 	case BME_EDIT_BOOKMARKCLEAR:
 		SciCall_MarkerDeleteAll(MarkerNumber_Bookmark);
 		break;
@@ -3738,6 +4167,39 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 	}
 	break;
 
+	case IDM_EDIT_FINDINFILES: {
+		FindInFilesMatch match;
+		if (FindInFilesDlg(hwnd, &match)) {
+			if (PathEqual(match.path, szCurFile) || (FileSave(FileSaveFlag_Ask) && FileLoad(FileLoadFlag_DontSave, match.path))) {
+				const Sci_Line iLine = match.line - 1;
+				if (iLine < SciCall_GetLineCount()) {
+					const Sci_Position iStartPos = SciCall_PositionRelative(SciCall_PositionFromLine(iLine), match.column);
+					const Sci_Position iEndPos = SciCall_PositionRelative(iStartPos, match.length);
+					EditSelectEx(iStartPos, max(iStartPos, iEndPos));
+				}
+			}
+		}
+	}
+	break;
+
+	case IDM_EDIT_FILTER_LINES:
+		if (SciCall_GetLength() == 0) {
+			break;
+		}
+		if (StrIsEmpty(efrData.szFind)) {
+			EditSaveSelectionAsFindText(&efrData, IDM_EDIT_SAVEFIND, false);
+			if (StrIsEmpty(efrData.szFind)) {
+				SendWMCommand(hwnd, IDM_EDIT_FIND);
+				break;
+			}
+		}
+		EditFilterLines(&efrData, iFilterContextLines);
+		break;
+
+	case IDM_EDIT_FILTER_CLEAR:
+		EditFilterLinesClear();
+		break;
+
 	case IDM_EDIT_FINDNEXT:
 	case IDM_EDIT_FINDPREV:
 	case IDM_EDIT_REPLACENEXT:
@@ -3797,6 +4259,14 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		EditLineNumDlg(hwndEdit);
 		break;
 
+	case IDM_EDIT_GOTOSYMBOL: {
+		Sci_Line iLine;
+		if (GotoSymbolDlg(hwnd, &iLine)) {
+			EditJumpTo(iLine + 1, 0);
+		}
+	}
+	break;
+
 	//case IDM_EDIT_NAVIGATE_BACKWARD:
 	//case IDM_EDIT_NAVIGATE_FORWARD:
 	//	break;
@@ -3899,11 +4369,16 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		Style_SetBookmark();
 		break;
 
+	case IDM_VIEW_OVERVIEW_RULER:
+		bShowOverviewRuler = !bShowOverviewRuler;
+		UpdateOverviewRuler();
+		break;
+
 	case IDM_VIEW_CHANGE_HISTORY_MARKER:
 		if (iChangeHistoryMarker != SC_CHANGE_HISTORY_DISABLED || !SciCall_CanUndo()) {
 			iChangeHistoryMarker = (iChangeHistoryMarker == SC_CHANGE_HISTORY_DISABLED)? (SC_CHANGE_HISTORY_ENABLED | SC_CHANGE_HISTORY_MARKERS) : SC_CHANGE_HISTORY_DISABLED;
 			UpdateBookmarkMarginWidth();
-			SciCall_SetChangeHistory(iChangeHistoryMarker);
+			SciCall_SetChangeHistory(EditGetChangeHistoryOption());
 		}
 		break;
 
@@ -4143,6 +4618,18 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		SendWMSize(hwnd);
 		break;
 
+	case IDM_VIEW_PAINT_STATISTICS:
+		bShowPaintStatistics = !bShowPaintStatistics;
+		if (bShowPaintStatistics) {
+			Sci_PaintStatistics stats;
+			SciCall_GetPaintStatistics(true, &stats);
+			SetTimer(hwnd, ID_PAINTSTATISTICSTIMER, 1000, nullptr);
+		} else {
+			KillTimer(hwnd, ID_PAINTSTATISTICSTIMER);
+			StatusSetText(hwndStatus, StatusItem_Empty, L"");
+		}
+		break;
+
 	case IDM_VIEW_CLEARWINPOS:
 		ClearWindowPositionHistory();
 		break;
@@ -4361,6 +4848,10 @@ LRESULT MsgCommand(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 		ToggleFullScreenMode();
 		break;
 
+	case IDM_VIEW_SPLIT_VIEW:
+		ToggleSplitView();
+		break;
+
 	case IDM_VIEW_FULLSCREEN_ON_START:
 	case IDM_VIEW_FULLSCREEN_HIDE_TITLE: {
 		const int config = 1 << (LOWORD(wParam) - IDM_VIEW_FULLSCREEN_ON_START);
@@ -4675,6 +5166,7 @@ LRESULT MsgNotify(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 	case IDC_EDIT:
 		switch (pnmh->code) {
 		case SCN_UPDATEUI:
+			EditHyperlinkUpdate();
 			if (scn->updated & ~(SC_UPDATE_V_SCROLL | SC_UPDATE_H_SCROLL)) {
 				UpdateToolbar();
 
@@ -4794,8 +5286,7 @@ LRESULT MsgNotify(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 				return 0;
 			}
 
-			const int iCondition = SciCall_AutoCActive() ? AutoCompleteCondition_OnCharAdded : AutoCompleteCondition_Normal;
-			EditCompleteWord(iCondition, false);
+			EditCompleteWordOnTyping();
 		}
 		break;
 
@@ -4882,8 +5373,17 @@ LRESULT MsgNotify(HWND hwnd, WPARAM wParam, LPARAM lParam) {
 			break;
 
 		case SCN_MODIFIED:
+			EditWordIndexNotify(scn->modificationType, scn->position, scn->length, scn->linesAdded);
+			if (scn->modificationType & (SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE)) {
+				// only watched while document word index is active
+				break;
+			}
 			// we only watch SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT
 			++dwCurrentDocReversion;
+			EditSavedFileNotify(scn->position);
+			EditOutlineNotify(scn->position, scn->linesAdded);
+			EditHyperlinkNotify(scn->position, scn->linesAdded);
+			EditPrintReset();
 			UpdateStatusBarCacheLineColumn();
 			if (scn->linesAdded) {
 				UpdateLineNumberWidth();
@@ -5167,6 +5667,8 @@ void LoadSettings() noexcept {
 		efrData.fuFlags = iValue & 1023;
 		efrData.option |= iValue >> 10;
 	}
+	iValue = section.GetInt(L"FilterContextLines", 0);
+	iFilterContextLines = clamp(iValue, 0, 1000);
 
 	fWordWrapG = section.GetBool(L"WordWrap", true);
 	iValue = section.GetInt(L"WordWrapMode", SC_WRAP_AUTO);
@@ -5185,6 +5687,7 @@ void LoadSettings() noexcept {
 
 	bMatchBraces = section.GetBool(L"MatchBraces", true);
 	bHighlightCurrentBlock = section.GetBool(L"HighlightCurrentBlock", true);
+	bHighlightHyperlink = section.GetBool(L"HighlightHyperlink", false);
 	iValue = section.GetInt(L"HighlightCurrentLine", 10 + LineHighlightMode_OutlineFrame);
 	bHighlightCurrentSubLine = (iValue >= 10);
 	iHighlightCurrentLine = clamp(static_cast<LineHighlightMode>(iValue % 10), LineHighlightMode_None, LineHighlightMode_OutlineFrame);
@@ -5243,6 +5746,7 @@ void LoadSettings() noexcept {
 
 	bShowBookmarkMargin = section.GetBool(L"ShowBookmarkMargin", false);
 	bShowLineNumbers = section.GetBool(L"ShowLineNumbers", true);
+	bShowOverviewRuler = section.GetBool(L"ShowOverviewRuler", false);
 	bShowCodeFolding = section.GetBool(L"ShowCodeFolding", true);
 	iChangeHistoryMarker = section.GetInt(L"ChangeHistoryMarker", SC_CHANGE_HISTORY_DISABLED);
 	bMarkOccurrences = section.GetInt(L"MarkOccurrences", MarkOccurrences_Enable);
@@ -5258,6 +5762,7 @@ void LoadSettings() noexcept {
 	bLoadASCIIasUTF8 = section.GetBool(L"LoadASCIIasUTF8", true);
 	bLoadNFOasOEM = section.GetBool(L"LoadNFOasOEM", true);
 	bNoEncodingTags = section.GetBool(L"NoEncodingTags", false);
+	bHexDumpBinaryFile = section.GetBool(L"HexDumpBinaryFile", false);
 
 	iValue = section.GetInt(L"DefaultEOLMode", 0);
 	iDefaultEOLMode = clamp(iValue, SC_EOL_CRLF, SC_EOL_LF);
@@ -5265,6 +5770,7 @@ void LoadSettings() noexcept {
 	bWarnLineEndings = section.GetBool(L"WarnLineEndings", true);
 	bFixLineEndings = section.GetBool(L"FixLineEndings", false);
 	bAutoStripBlanks = section.GetBool(L"FixTrailingBlanks", false);
+	bFixOnlyModifiedLines = section.GetBool(L"FixOnlyModifiedLines", false);
 
 	iValue = section.GetInt(L"PrintHeader", PrintHeaderOption_FilenameAndDate);
 	iPrintHeader = clamp(static_cast<PrintHeaderOption>(iValue), PrintHeaderOption_FilenameAndDateTime, PrintHeaderOption_LeaveBlank);
@@ -5370,6 +5876,10 @@ void LoadSettings() noexcept {
 
 		record.cxFileMRUDlg = section.GetInt(L"FileMRUDlgSizeX", 0);
 		record.cyFileMRUDlg = section.GetInt(L"FileMRUDlgSizeY", 0);
+		record.cxFindInFilesDlg = section.GetInt(L"FindInFilesDlgSizeX", 0);
+		record.cyFindInFilesDlg = section.GetInt(L"FindInFilesDlgSizeY", 0);
+		record.cxGotoSymbolDlg = section.GetInt(L"GotoSymbolDlgSizeX", 0);
+		record.cyGotoSymbolDlg = section.GetInt(L"GotoSymbolDlgSizeY", 0);
 		record.cxOpenWithDlg = section.GetInt(L"OpenWithDlgSizeX", 0);
 		record.cyOpenWithDlg = section.GetInt(L"OpenWithDlgSizeY", 0);
 		record.cxFavoritesDlg = section.GetInt(L"FavoritesDlgSizeX", 0);
@@ -5410,11 +5920,16 @@ void SaveSettingsNow(bool bOnlySaveStyle, bool bQuiet) noexcept {
 			InvalidateRect(hwndStatus, nullptr, TRUE);
 			UpdateWindow(hwndStatus);
 			if (CreateIniFile(szIniFile)) {
+				const bool cached = IniCache_Load(szIniFile, true);
 				if (bOnlySaveStyle) {
 					Style_Save();
 				} else {
 					SaveSettings(true);
 				}
+				if (cached && !IniCache_Flush()) {
+					bCreateFailure = true;
+				}
+				IniCache_Free();
 			} else {
 				bCreateFailure = true;
 			}
@@ -5477,6 +5992,7 @@ void SaveSettings(bool bSaveSettingsNow) noexcept {
 		iValue = efrData.fuFlags | ((efrData.option & FindReplaceOption_SearchMask) << 10);
 		section.SetIntEx(L"FindReplaceFlag", iValue, SCFIND_NONE);
 	}
+	section.SetIntEx(L"FilterContextLines", iFilterContextLines, 0);
 
 	section.SetBoolEx(L"WordWrap", fWordWrapG, true);
 	section.SetIntEx(L"WordWrapMode", iWordWrapMode, SC_WRAP_AUTO);
@@ -5487,6 +6003,7 @@ void SaveSettings(bool bSaveSettingsNow) noexcept {
 	section.SetBoolEx(L"ShowUnicodeControlCharacter", bShowUnicodeControlCharacter, false);
 	section.SetBoolEx(L"MatchBraces", bMatchBraces, true);
 	section.SetBoolEx(L"HighlightCurrentBlock", bHighlightCurrentBlock, true);
+	section.SetBoolEx(L"HighlightHyperlink", bHighlightHyperlink, false);
 	iValue = static_cast<int>(iHighlightCurrentLine) + (static_cast<int>(bHighlightCurrentSubLine)*10);
 	section.SetIntEx(L"HighlightCurrentLine", iValue, 10 + LineHighlightMode_OutlineFrame);
 	section.SetBoolEx(L"ShowIndentGuides", bShowIndentGuides, false);
@@ -5519,6 +6036,7 @@ void SaveSettings(bool bSaveSettingsNow) noexcept {
 	section.SetIntEx(L"ZoomLevel", iZoomLevel, 100);
 	section.SetBoolEx(L"ShowBookmarkMargin", bShowBookmarkMargin, false);
 	section.SetBoolEx(L"ShowLineNumbers", bShowLineNumbers, true);
+	section.SetBoolEx(L"ShowOverviewRuler", bShowOverviewRuler, false);
 	section.SetBoolEx(L"ShowCodeFolding", bShowCodeFolding, true);
 	section.SetIntEx(L"ChangeHistoryMarker", iChangeHistoryMarker, SC_CHANGE_HISTORY_DISABLED);
 	section.SetIntEx(L"MarkOccurrences", bMarkOccurrences, MarkOccurrences_Enable);
@@ -5535,11 +6053,13 @@ void SaveSettings(bool bSaveSettingsNow) noexcept {
 	section.SetBoolEx(L"LoadASCIIasUTF8", bLoadASCIIasUTF8, true);
 	section.SetBoolEx(L"LoadNFOasOEM", bLoadNFOasOEM, true);
 	section.SetBoolEx(L"NoEncodingTags", bNoEncodingTags, false);
+	section.SetBoolEx(L"HexDumpBinaryFile", bHexDumpBinaryFile, false);
 
 	section.SetIntEx(L"DefaultEOLMode", iDefaultEOLMode, 0);
 	section.SetBoolEx(L"WarnLineEndings", bWarnLineEndings, true);
 	section.SetBoolEx(L"FixLineEndings", bFixLineEndings, false);
 	section.SetBoolEx(L"FixTrailingBlanks", bAutoStripBlanks, false);
+	section.SetBoolEx(L"FixOnlyModifiedLines", bFixOnlyModifiedLines, false);
 
 	section.SetIntEx(L"PrintHeader", static_cast<int>(iPrintHeader), PrintHeaderOption_FilenameAndDate);
 	section.SetIntEx(L"PrintFooter", static_cast<int>(iPrintFooter), PrintFooterOption_PageNumber);
@@ -5619,6 +6139,10 @@ void SaveWindowPosition(WCHAR *pIniSectionBuf) noexcept{
 
 	section.SetIntEx(L"FileMRUDlgSizeX", record.cxFileMRUDlg, 0);
 	section.SetIntEx(L"FileMRUDlgSizeY", record.cyFileMRUDlg, 0);
+	section.SetIntEx(L"FindInFilesDlgSizeX", record.cxFindInFilesDlg, 0);
+	section.SetIntEx(L"FindInFilesDlgSizeY", record.cyFindInFilesDlg, 0);
+	section.SetIntEx(L"GotoSymbolDlgSizeX", record.cxGotoSymbolDlg, 0);
+	section.SetIntEx(L"GotoSymbolDlgSizeY", record.cyGotoSymbolDlg, 0);
 	section.SetIntEx(L"OpenWithDlgSizeX", record.cxOpenWithDlg, 0);
 	section.SetIntEx(L"OpenWithDlgSizeY", record.cyOpenWithDlg, 0);
 	section.SetIntEx(L"FavoritesDlgSizeX", record.cxFavoritesDlg, 0);
@@ -5940,6 +6464,19 @@ CommandParseState ParseCommandLineOption(LPWSTR lp1, LPWSTR lp2) noexcept {
 		}
 		break;
 
+	case L'B':
+		if (StrCaseEqual(opt, L"benchmark")) {
+			state = CommandParseState_Argument;
+			if (ExtractFirstArgument(lp2, lp1, lp2)) {
+				if (lpBenchmarkArg) {
+					LocalFree(lpBenchmarkArg);
+				}
+				lpBenchmarkArg = StrDup(lp1);
+				state = CommandParseState_Consumed;
+			}
+		}
+		break;
+
 	case L'C':
 		if (UnsafeUpper(opt[1]) == L'R') {
 			opt += 2;
@@ -5953,6 +6490,19 @@ CommandParseState ParseCommandLineOption(LPWSTR lp1, LPWSTR lp2) noexcept {
 		}
 		break;
 
+	case L'H':
+		if (StrCaseEqual(opt, L"handoff")) {
+			state = CommandParseState_Argument;
+			if (ExtractFirstArgument(lp2, lp1, lp2)) {
+				if (lpHandoffArg) {
+					LocalFree(lpHandoffArg);
+				}
+				lpHandoffArg = StrDup(lp1);
+				state = CommandParseState_Consumed;
+			}
+		}
+		break;
+
 	case L'M':
 		if (StrCaseEqual(opt, L"MBCS")) {
 			flagSetEncoding = IDM_ENCODING_ANSI - IDM_ENCODING_ANSI + 1;
@@ -6117,6 +6667,11 @@ CommandParseState ParseCommandLineOption(LPWSTR lp1, LPWSTR lp2) noexcept {
 	break;
 
 	case L'S':
+		if (StrCaseEqual(opt, L"standby")) {
+			flagStandbyInstance = true;
+			state = CommandParseState_Consumed;
+			break;
+		}
 		// Shell integration
 		if (StrStartsWithCase(opt, L"sysmru=")) {
 			opt += CSTRLEN(L"sysmru=");
@@ -6285,6 +6840,8 @@ void LoadFlags() noexcept {
 	bSingleFileInstance = section.GetBool(L"SingleFileInstance", true);
 	bReuseWindow = section.GetBool(L"ReuseWindow", false);
 	bStickyWindowPosition = section.GetBool(L"StickyWindowPosition", false);
+	// keep a hidden instance ready for next launch
+	bStandbyInstance = section.GetBool(L"StandbyInstance", false);
 
 	if (!flagReuseWindow && !flagNoReuseWindow) {
 		flagNoReuseWindow = !bReuseWindow;
@@ -6307,6 +6864,12 @@ void LoadFlags() noexcept {
 	dwFileCheckInterval = section.GetInt(L"FileCheckInterval", 1000);
 	dwAutoReloadTimeout = section.GetInt(L"AutoReloadTimeout", 1000);
 	dwUrlThreshold = section.GetInt(L"UrlThreshold", 256);
+	// in MiB, old undo text beyond it is compressed and written to temporary file
+	dwUndoMemoryLimit = section.GetInt(L"UndoMemoryLimit", 0);
+	// in MiB, files not smaller than it get a trigram index for faster find
+	dwSearchIndexThreshold = section.GetInt(L"SearchIndexThreshold", 0);
+	// threads used to layout and wrap lines, 0 for all processors, 1 disables parallel layout
+	dwLayoutThreads = section.GetInt(L"LayoutThreads", 0);
 
 	if (IsVistaAndAbove()) {
 		bUseXPFileDialog = section.GetBool(L"UseXPFileDialog", false);
@@ -6491,20 +7054,48 @@ void UpdateStatusbar() noexcept {
 	const Sci_Line iLine = SciCall_LineFromPosition(iPos);
 	const Sci_Line iLines = SciCall_GetLineCount();
 
+	UINT updateMask = cachedStatusItem.updateMask;
+	cachedStatusItem.updateMask = 0;
+	// text or tab width changed
+	const bool textChanged = (updateMask & (1 << StatusItem_Line)) != 0;
+	if (textChanged) {
+		cachedStatusItem.iSelStart = -1;
+		cachedStatusItem.iSelEnd = -1;
+	}
+
 #if 0
 	StopWatch watch;
 	watch.Start();
 #endif
 	Sci_TextToFindFull ft = { { SciCall_PositionFromLine(iLine), iPos }, nullptr, { 0, 0 } };
+	if (!textChanged && iLine == cachedStatusItem.iLine) {
+		// count from previous caret position to avoid recounting long line on every caret move
+		const Sci_Position iPrevPos = cachedStatusItem.iCaretPos;
+		if (iPos >= iPrevPos) {
+			ft.chrg.cpMin = iPrevPos;
+			ft.chrgText.cpMin = cachedStatusItem.iCaretChar;
+			ft.chrgText.cpMax = cachedStatusItem.iCaretColumn;
+		} else {
+			Sci_TextToFindFull back = { { iPos, iPrevPos }, nullptr, { 0, 0 } };
+			SciCall_CountCharactersAndColumns(&back);
+			// column can be subtracted when there is no tab between
+			if (back.chrgText.cpMin == back.chrgText.cpMax) {
+				ft.chrg.cpMin = iPos;
+				ft.chrgText.cpMin = cachedStatusItem.iCaretChar - back.chrgText.cpMin;
+				ft.chrgText.cpMax = cachedStatusItem.iCaretColumn - back.chrgText.cpMax;
+			}
+		}
+	}
 	SciCall_CountCharactersAndColumns(&ft);
+	cachedStatusItem.iCaretPos = iPos;
+	cachedStatusItem.iCaretChar = ft.chrgText.cpMin;
+	cachedStatusItem.iCaretColumn = ft.chrgText.cpMax;
 	const Sci_Position iChar = ft.chrgText.cpMin + 1;
 	const Sci_Position iCol = ft.chrgText.cpMax + 1;
 	Sci_Position iLineChar;
 	Sci_Position iLineColumn;
 
-	UINT updateMask = cachedStatusItem.updateMask;
-	cachedStatusItem.updateMask = 0;
-	if ((updateMask & (1 << StatusItem_Line)) || (iLine != cachedStatusItem.iLine)) {
+	if (textChanged || (iLine != cachedStatusItem.iLine)) {
 		updateMask |= (1 << StatusItem_Line);
 		ft.chrg.cpMin = ft.chrg.cpMax;
 		ft.chrg.cpMax = SciCall_GetLineEndPosition(iLine);
@@ -6553,7 +7144,22 @@ void UpdateStatusbar() noexcept {
 	} else {
 		if (!SciCall_IsRectangularSelection()) {
 			const Sci_Position iSelByte = SciCall_GetSelTextLength();
-			const Sci_Position iSelChar = SciCall_CountCharacters(iSelStart, iSelEnd);
+			// only count changed part when selection is extended or shrunk from one side
+			Sci_Position iSelChar;
+			if (iSelStart == cachedStatusItem.iSelStart) {
+				const Sci_Position iPrevEnd = cachedStatusItem.iSelEnd;
+				iSelChar = cachedStatusItem.iSelChar + ((iSelEnd >= iPrevEnd)
+					? SciCall_CountCharacters(iPrevEnd, iSelEnd) : -SciCall_CountCharacters(iSelEnd, iPrevEnd));
+			} else if (iSelEnd == cachedStatusItem.iSelEnd) {
+				const Sci_Position iPrevStart = cachedStatusItem.iSelStart;
+				iSelChar = cachedStatusItem.iSelChar + ((iSelStart <= iPrevStart)
+					? SciCall_CountCharacters(iSelStart, iPrevStart) : -SciCall_CountCharacters(iPrevStart, iSelStart));
+			} else {
+				iSelChar = SciCall_CountCharacters(iSelStart, iSelEnd);
+			}
+			cachedStatusItem.iSelStart = iSelStart;
+			cachedStatusItem.iSelEnd = iSelEnd;
+			cachedStatusItem.iSelChar = iSelChar;
 			FormatNumber(tchSelByte, iSelByte);
 			FormatNumber(tchSelChar, iSelChar);
 		} else {
@@ -6670,6 +7276,38 @@ void UpdateStatusbar() noexcept {
 	}
 }
 
+//=============================================================================
+//
+// UpdatePaintStatistics()
+//
+// called every second, counters are reset on each call so values are per second or per frame.
+void UpdatePaintStatistics() noexcept {
+	Sci_PaintStatistics stats;
+	SciCall_GetPaintStatistics(true, &stats);
+	if (!bShowStatusbar) {
+		return;
+	}
+
+	const int frames = max(stats.frames, 1);
+	const int paintTime = stats.paintTime / frames;
+	const int layoutTime = stats.layoutTime / frames;
+	const int lookups = stats.positionCacheHits + stats.positionCacheMisses;
+	const int hitRatio = lookups ? MulDiv(stats.positionCacheHits, 100, lookups) : 100;
+	const bool idlePending = stats.idlePending || IdleTask_Pending();
+
+	WCHAR tchUndo[32];
+	WCHAR tchStyles[32];
+	StrFormatByteSize(SciCall_GetMemoryUsage(SC_MEMORY_UNDO_HISTORY), tchUndo, COUNTOF(tchUndo));
+	StrFormatByteSize(SciCall_GetMemoryUsage(SC_MEMORY_STYLES), tchStyles, COUNTOF(tchStyles));
+
+	WCHAR tch[256];
+	wsprintf(tch, L"%d fps, paint %d.%02d ms, layout %d.%02d ms, %d lines, cache %d%%, lex %d B/ms, wrap %d B/ms, undo %s, styles %s%s%s",
+		stats.frames, paintTime / 1000, (paintTime / 10) % 100, layoutTime / 1000, (layoutTime / 10) % 100,
+		stats.linesLaidOut / frames, hitRatio, stats.styleBytesPerMillisecond, stats.wrapBytesPerMillisecond,
+		tchUndo, tchStyles, (idlePending ? L", idle" : L""), (bBackgroundWorkThrottled ? L", eco" : L""));
+	StatusSetText(hwndStatus, StatusItem_Empty, tch);
+}
+
 //=============================================================================
 //
 // UpdateLineNumberWidth()
@@ -6828,6 +7466,9 @@ bool FileLoad(FileLoadFlag loadFlag, LPCWSTR lpszFile) {
 			return false;
 		}
 	}
+	if (!(loadFlag & FileLoadFlag_Reload)) {
+		FileSnapshot_Save();
+	}
 
 	if (loadFlag & FileLoadFlag_New) {
 		SetStrEmpty(szCurFile);
@@ -6925,7 +7566,22 @@ bool FileLoad(FileLoadFlag loadFlag, LPCWSTR lpszFile) {
 			return false;
 		}
 	} else {
+		// reuse detection result and view state of an unchanged large file
+		EditFileSnapshot snapshot;
+		if (!bRestoreView && iSrcEncoding < CPI_FIRST && iWeakSrcEncoding < CPI_FIRST && EditReadFileSnapshot(pszFile, snapshot)) {
+			status.snapshot = &snapshot;
+		}
 		fSuccess = FileIO(true, pszFile, FileSaveFlag_Default, status);
+		if (fSuccess && status.snapshot != nullptr) {
+			iCurPos = min(snapshot.iCurPos, SciCall_GetLength());
+			iAnchorPos = min(snapshot.iAnchorPos, SciCall_GetLength());
+			iLine = SciCall_LineFromPosition(iCurPos) + 1;
+			iCol = SciCall_GetColumn(iCurPos) + 1;
+			iDocTopLine = snapshot.iDocTopLine;
+			iVisTopLine = snapshot.iDocTopLine;
+			iXOffset = snapshot.iXOffset;
+			bRestoreView = true;
+		}
 		if (fSuccess) {
 			iCurrentEncoding = status.iEncoding;
 			iCurrentEOLMode = status.iEOLMode;
@@ -6935,6 +7591,10 @@ bool FileLoad(FileLoadFlag loadFlag, LPCWSTR lpszFile) {
 	if (fSuccess) {
 		lstrcpy(szCurFile, pszFile);
 		SetDlgItemText(hwndMain, IDC_FILENAME, szCurFile);
+		tailCurFile.valid = !status.bLoadCanceled;
+		tailCurFile.fileSize = status.fileSize;
+		memcpy(&tailCurFile.fileId, &status.fileId, sizeof(FILE_ID_INFO));
+		FileSnapshot_Init(pszFile, status);
 		if (!keepTitleExcerpt) {
 			SetStrEmpty(szTitleExcerpt);
 		}
@@ -6987,7 +7647,8 @@ bool FileLoad(FileLoadFlag loadFlag, LPCWSTR lpszFile) {
 			}
 		}
 		// open file in read only mode
-		if (status.bBinaryFile || flagReadOnlyMode != ReadOnlyMode_None || bReadOnlyFile) {
+		// partially loaded file is opened in read only mode to prevent truncating it on save
+		if (status.bBinaryFile || status.bLoadCanceled || flagReadOnlyMode != ReadOnlyMode_None || bReadOnlyFile) {
 			bReadOnlyMode = true;
 			flagReadOnlyMode &= ReadOnlyMode_AllFile;
 			SciCall_SetReadOnly(true);
@@ -7044,7 +7705,7 @@ bool FileLoad(FileLoadFlag loadFlag, LPCWSTR lpszFile) {
 				ConvertLineEndings(status.iEOLMode);
 			}
 		}
-	} else if (!status.bFileTooBig) {
+	} else if (!status.bFileTooBig && dwLastIOError != ERROR_CANCELLED) {
 		MsgBoxLastError(MB_OK, IDS_ERR_LOADFILE, pszFile);
 	}
 
@@ -7179,6 +7840,9 @@ bool FileSave(FileSaveFlag saveFlag) noexcept {
 				iPathNameFormat = TitlePathNameFormat_NameFirst;
 			}
 
+			// saved content differs from loaded bytes
+			tailCurFile.valid = false;
+			bValidSnapshot = false;
 			// Install watching of the current file
 			if ((saveFlag & FileSaveFlag_SaveAs) && bResetFileWatching) {
 				iFileWatchingMode = FileWatchingMode_None;
@@ -7395,7 +8059,7 @@ static BOOL CALLBACK EnumWindProcSingleFileInstance(HWND hwnd, LPARAM lParam) no
 	WCHAR szClassName[64];
 
 	if (GetClassName(hwnd, szClassName, COUNTOF(szClassName))) {
-		if (StrCaseEqual(szClassName, wchWndClass)) {
+		if (StrCaseEqual(szClassName, wchWndClass) && GetProp(hwnd, STANDBY_WINDOW_PROP) == nullptr) {
 			WCHAR tchFileName[MAX_PATH];
 			if (lpFileArg == nullptr || (GetDlgItemText(hwnd, IDC_FILENAME, tchFileName, COUNTOF(tchFileName)) && PathEquivalent(tchFileName, lpFileArg))) {
 				*AsPointer<HWND *>(lParam) = hwnd;
@@ -7542,6 +8206,44 @@ bool ActivatePrevInst() noexcept {
 	return false;
 }
 
+//=============================================================================
+//
+// ActivateStandbyInst()
+//
+// hand current launch over to the hidden standby instance
+//
+bool ActivateStandbyInst(int nCmdShow) noexcept {
+	if (flagStartAsTrayIcon || flagNewFromClipboard || flagPasteBoard || flagDefaultPos != DefaultPositionFlag_None) {
+		return false;
+	}
+
+	HWND hwnd = nullptr;
+	EnumWindows(EnumWindProcStandbyInstance, AsInteger<LPARAM>(&hwnd));
+	if (hwnd == nullptr) {
+		return false;
+	}
+
+	LPWSTR lpszFile = lpFileArg;
+	if (lpszFile) {
+		WCHAR tchTmp[MAX_PATH];
+		if (ExpandEnvironmentStringsEx(lpszFile, tchTmp)) {
+			lstrcpy(lpszFile, tchTmp);
+		}
+		if (PathIsRelative(lpszFile)) {
+			PathCombine(tchTmp, g_wchWorkingDirectory, lpszFile);
+			lstrcpy(lpszFile, tchTmp);
+		}
+	}
+
+	DWORD dwProcessId = 0;
+	GetWindowThreadProcessId(hwnd, &dwProcessId);
+	AllowSetForegroundWindow(dwProcessId);
+	// show window first, then load the file like InitInstance()
+	SendMessage(hwnd, APPM_STANDBY_ACTIVATE, nCmdShow, 0);
+	ActivatePrevWindow(hwnd, lpszFile);
+	return true;
+}
+
 //=============================================================================
 //
 // RelaunchMultiInst()
@@ -7731,21 +8433,45 @@ bool RelaunchElevated() noexcept {
 		LPWSTR lpArg1;
 		LPWSTR lpArg2;
 		bool exit = true;
+		HANDLE hHandoff = nullptr;
+		HANDLE hHandoffDone = nullptr;
 
 		if (flagRelaunchElevated == RelaunchElevatedFlag_Manual) {
+			// hand over current document through shared memory, unsaved changes are kept without saving.
+			WCHAR szHandoff[64];
+			hHandoff = FileHandoff_Create(szHandoff, nullptr, 0, 0);
+			if (hHandoff) {
+				WCHAR szEvent[80];
+				wsprintf(szEvent, L"%s.Done", szHandoff);
+				hHandoffDone = CreateEvent(nullptr, TRUE, FALSE, szEvent);
+			}
+
 			WCHAR tchFile[MAX_PATH];
 			lstrcpy(tchFile, szCurFile);
-			if (!FileSave(FileSaveFlag_Ask)) {
-				return false;
+			if (hHandoffDone == nullptr) {
+				if (hHandoff) {
+					CloseHandle(hHandoff);
+					hHandoff = nullptr;
+				}
+				if (!FileSave(FileSaveFlag_Ask)) {
+					return false;
+				}
+				exit = PathEqual(tchFile, szCurFile);
 			}
 
-			exit = PathEqual(tchFile, szCurFile);
 			constexpr size_t cmdSize = NP2_align_up(MAX_PATH, MEMORY_ALLOCATION_ALIGNMENT);
 			lpArg1 = static_cast<LPWSTR>(NP2HeapAlloc(sizeof(WCHAR) * (cmdSize + 1024)));
 			lpArg2 = lpArg1 + cmdSize;
 			GetModuleFileName(nullptr, lpArg1, MAX_PATH);
-			GetRelaunchParameters(lpArg2, tchFile, !exit, false);
-			exit = !IsDocumentModified();
+			if (hHandoffDone) {
+				// new window avoids the document being sent back to this instance
+				GetRelaunchParameters(lpArg2, tchFile, true, true);
+				lstrcat(lpArg2, L" -handoff ");
+				lstrcat(lpArg2, szHandoff);
+			} else {
+				GetRelaunchParameters(lpArg2, tchFile, !exit, false);
+				exit = !IsDocumentModified();
+			}
 		} else {
 			const LPCWSTR lpCmdLine = GetCommandLine();
 			size_t cmdSize = lstrlen(lpCmdLine);
@@ -7760,6 +8486,9 @@ bool RelaunchElevated() noexcept {
 			memset(&sei, 0, sizeof(SHELLEXECUTEINFO));
 			sei.cbSize = sizeof(SHELLEXECUTEINFO);
 			sei.fMask = SEE_MASK_FLAG_NO_UI | SEE_MASK_NOASYNC | SEE_MASK_NOZONECHECKS;
+			if (hHandoffDone) {
+				sei.fMask |= SEE_MASK_NOCLOSEPROCESS;
+			}
 			sei.hwnd = GetForegroundWindow();
 			sei.lpVerb = L"runas";
 			sei.lpFile = lpArg1;
@@ -7769,11 +8498,23 @@ bool RelaunchElevated() noexcept {
 
 			if (!ShellExecuteEx(&sei)) {
 				exit = false;
+			} else if (hHandoffDone) {
+				// keep shared memory alive until elevated instance took over the document
+				exit = false;
+				if (sei.hProcess) {
+					const HANDLE handles[2] = { hHandoffDone, sei.hProcess };
+					exit = WaitForMultipleObjects(COUNTOF(handles), handles, FALSE, 30*1000) == WAIT_OBJECT_0;
+					CloseHandle(sei.hProcess);
+				}
 			}
 		} else {
 			exit = false;
 		}
 
+		if (hHandoffDone) {
+			CloseHandle(hHandoffDone);
+			CloseHandle(hHandoff);
+		}
 		NP2HeapFree(lpArg1);
 		return exit;
 	}
@@ -7927,6 +8668,127 @@ void ShowNotificationMessage(WPARAM notifyPos, UINT uidMessage, ...) noexcept {
 	ShowNotificationA(notifyPos, lpszText);
 }
 
+//=============================================================================
+//
+// DirectoryWatcher
+//
+// watch parent directory of current file with overlapped ReadDirectoryChangesW() on thread pool,
+// changes to other files are filtered out, only one message is posted until it's handled.
+#define FILE_WATCHER_NOTIFY_FILTER	(FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE)
+
+static struct DirectoryWatcher {
+	HANDLE hDirectory;
+	PTP_IO io;
+	OVERLAPPED overlapped;
+	volatile LONG stopping;
+	volatile LONG pending;
+	volatile LONG failed;
+	WCHAR fileName[MAX_PATH];
+	DWORD buffer[1024];
+
+	bool Arm() noexcept {
+		// I/O completion port is used, pending read is not canceled when the issuing thread exits.
+		StartThreadpoolIo(io);
+		if (ReadDirectoryChangesW(hDirectory, buffer, sizeof(buffer), FALSE, FILE_WATCHER_NOTIFY_FILTER, nullptr, &overlapped, nullptr)) {
+			return true;
+		}
+		CancelThreadpoolIo(io);
+		return false;
+	}
+
+	bool IsCurrentFileChanged(ULONG_PTR cbReturned) const noexcept {
+		if (cbReturned == 0) {
+			// buffer overflow, changes are lost
+			return true;
+		}
+		const BYTE *ptr = reinterpret_cast<const BYTE *>(buffer);
+		while (true) {
+			const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(ptr);
+			const DWORD length = info->FileNameLength / sizeof(WCHAR);
+			if (length < MAX_PATH) {
+				WCHAR name[MAX_PATH];
+				memcpy(name, info->FileName, length * sizeof(WCHAR));
+				name[length] = L'\0';
+				if (PathEqual(name, fileName)) {
+					return true;
+				}
+			}
+			if (info->NextEntryOffset == 0) {
+				return false;
+			}
+			ptr += info->NextEntryOffset;
+		}
+	}
+
+	void OnCompleted(ULONG ioResult, ULONG_PTR cbReturned) noexcept {
+		if (stopping) {
+			return;
+		}
+		// ERROR_NOTIFY_ENUM_DIR: buffer overflow
+		const bool success = ioResult == NO_ERROR || ioResult == ERROR_NOTIFY_ENUM_DIR;
+		const bool changed = !success || ioResult == ERROR_NOTIFY_ENUM_DIR || IsCurrentFileChanged(cbReturned);
+		if (!success || !Arm()) {
+			// let main window check the file and restart watching
+			InterlockedExchange(&failed, TRUE);
+		}
+		// sibling files used by auto completion
+		EditProjectWordsInvalidate();
+		if (changed && InterlockedExchange(&pending, TRUE) == FALSE) {
+			PostMessage(hwndMain, APPM_WATCHNOTIFY, 0, 0);
+		}
+	}
+
+	static VOID CALLBACK IoCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context, [[maybe_unused]] PVOID overlapped,
+		ULONG ioResult, ULONG_PTR numberOfBytesTransferred, [[maybe_unused]] PTP_IO io) noexcept {
+		DirectoryWatcher *watcher = static_cast<DirectoryWatcher *>(context);
+		watcher->OnCompleted(ioResult, numberOfBytesTransferred);
+	}
+} directoryWatcher;
+
+static void FileWatcher_Stop() noexcept {
+	HANDLE hDirectory = directoryWatcher.hDirectory;
+	if (hDirectory == nullptr) {
+		return;
+	}
+
+	InterlockedExchange(&directoryWatcher.stopping, TRUE);
+	if (directoryWatcher.io != nullptr) {
+		// wait pending read to be canceled before reusing the buffer
+		CancelIoEx(hDirectory, &directoryWatcher.overlapped);
+		WaitForThreadpoolIoCallbacks(directoryWatcher.io, FALSE);
+		CloseThreadpoolIo(directoryWatcher.io);
+		directoryWatcher.io = nullptr;
+	}
+	CloseHandle(hDirectory);
+	directoryWatcher.hDirectory = nullptr;
+}
+
+static bool FileWatcher_Start(LPCWSTR pszFile) noexcept {
+	WCHAR tchDirectory[MAX_PATH];
+	lstrcpy(tchDirectory, pszFile);
+	PathRemoveFileSpec(tchDirectory);
+	lstrcpyn(directoryWatcher.fileName, PathFindFileName(pszFile), COUNTOF(directoryWatcher.fileName));
+
+	HANDLE hDirectory = CreateFile(tchDirectory, FILE_LIST_DIRECTORY,
+						FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (hDirectory == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	memset(&directoryWatcher.overlapped, 0, sizeof(OVERLAPPED));
+	directoryWatcher.hDirectory = hDirectory;
+	directoryWatcher.stopping = FALSE;
+	directoryWatcher.pending = FALSE;
+	directoryWatcher.failed = FALSE;
+	directoryWatcher.io = CreateThreadpoolIo(hDirectory, DirectoryWatcher::IoCallback, &directoryWatcher, nullptr);
+	if (directoryWatcher.io != nullptr && directoryWatcher.Arm()) {
+		return true;
+	}
+	FileWatcher_Stop();
+	return false;
+}
+
 //=============================================================================
 //
 // InstallFileWatching()
@@ -7936,10 +8798,7 @@ void InstallFileWatching(bool terminate) noexcept {
 	terminate = terminate || iFileWatchingMode == FileWatchingMode_None || StrIsEmpty(szCurFile);
 	// Terminate
 	if (bRunningWatch) {
-		if (hChangeHandle) {
-			FindCloseChangeNotification(hChangeHandle);
-			hChangeHandle = nullptr;
-		}
+		FileWatcher_Stop();
 		if (terminate) {
 			KillTimer(nullptr, ID_WATCHTIMER);
 		}
@@ -7948,13 +8807,6 @@ void InstallFileWatching(bool terminate) noexcept {
 	dwChangeNotifyTime = 0;
 	bRunningWatch = !terminate;
 	if (bRunningWatch) {
-		// Install
-		SetTimer(nullptr, ID_WATCHTIMER, dwFileCheckInterval, WatchTimerProc);
-
-		WCHAR tchDirectory[MAX_PATH];
-		lstrcpy(tchDirectory, szCurFile);
-		PathRemoveFileSpec(tchDirectory);
-
 		// Save data of current file
 		WIN32_FIND_DATA data;
 		if (GetFileAttributesEx(szCurFile, GetFileExInfoStandard, &data)) {
@@ -7963,16 +8815,11 @@ void InstallFileWatching(bool terminate) noexcept {
 			memset(&fdCurFile, 0, sizeof(fdCurFile));
 		}
 
-		if ((iFileWatchingOption & FileWatchingOption_LogFile) == FileWatchingOption_None) {
-			hChangeHandle = FindFirstChangeNotification(tchDirectory, FALSE,
-						FILE_NOTIFY_CHANGE_FILE_NAME	| \
-						FILE_NOTIFY_CHANGE_DIR_NAME		| \
-						FILE_NOTIFY_CHANGE_ATTRIBUTES	| \
-						FILE_NOTIFY_CHANGE_SIZE			| \
-						FILE_NOTIFY_CHANGE_LAST_WRITE);
-			if (hChangeHandle == INVALID_HANDLE_VALUE) {
-				hChangeHandle = nullptr;
-			}
+		// Install, polling timer is only used for log file or when directory watcher failed
+		if ((iFileWatchingOption & FileWatchingOption_LogFile) == FileWatchingOption_None && FileWatcher_Start(szCurFile)) {
+			KillTimer(nullptr, ID_WATCHTIMER);
+		} else {
+			SetTimer(nullptr, ID_WATCHTIMER, dwFileCheckInterval, WatchTimerProc);
 		}
 	}
 }
@@ -7993,24 +8840,123 @@ static void CheckCurrentFileChangedOutsideApp() noexcept {
 	// Check if the changes affect the current file
 	if (IsCurrentFileChangedOutsideApp()) {
 		// Shutdown current watching and give control to main window
-		if (hChangeHandle) {
-			FindCloseChangeNotification(hChangeHandle);
-			hChangeHandle = nullptr;
-		}
+		FileWatcher_Stop();
 		if (iFileWatchingMode == FileWatchingMode_AutoReload) {
 			bRunningWatch = true;
 			dwChangeNotifyTime = GetTickCount();
+			// wait AutoReloadTimeout to coalesce burst of changes
+			SetTimer(nullptr, ID_WATCHTIMER, dwFileCheckInterval, WatchTimerProc);
 		} else {
 			KillTimer(nullptr, ID_WATCHTIMER);
 			bRunningWatch = false;
 			dwChangeNotifyTime = 0;
 			SendMessage(hwndMain, APPM_CHANGENOTIFY, 0, 0);
 		}
-	} else if (hChangeHandle) {
-		FindNextChangeNotification(hChangeHandle);
+	}
+}
+
+static void FileWatcher_Notified() noexcept {
+	InterlockedExchange(&directoryWatcher.pending, FALSE);
+	if (bRunningWatch && dwChangeNotifyTime == 0 && directoryWatcher.hDirectory != nullptr) {
+		CheckCurrentFileChangedOutsideApp();
+		if (bRunningWatch && dwChangeNotifyTime == 0 && directoryWatcher.failed) {
+			InstallFileWatching(false);
+		}
 	}
 }
 
+//=============================================================================
+//
+// FileTailAppend()
+//
+// append new content of growing log file instead of reloading whole file,
+// return false to fallback to full reload, e.g. the file is truncated or rotated.
+static bool FileTailAppend(bool bIsTail) noexcept {
+	const UINT uFlags = mEncoding[iCurrentEncoding].uFlags;
+	if (!tailCurFile.valid || (uFlags & NCP_UNICODE) || mEncoding[iCurrentEncoding].uCodePage == CP_UTF7) {
+		return false;
+	}
+
+	HANDLE hFile = CreateFile(szCurFile, GENERIC_READ,
+						FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+						nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	FILE_ID_INFO fileId;
+	bool success = GetFileSizeEx(hFile, &fileSize) && PathGetFileId(hFile, &fileId)
+		&& memcmp(&fileId, &tailCurFile.fileId, sizeof(FILE_ID_INFO)) == 0
+		&& static_cast<ULONGLONG>(fileSize.QuadPart) >= tailCurFile.fileSize
+		&& static_cast<ULONGLONG>(fileSize.QuadPart) - tailCurFile.fileSize < MAX_NON_UTF8_SIZE;
+	DWORD cbData = 0;
+	char *lpData = nullptr;
+	if (success && static_cast<ULONGLONG>(fileSize.QuadPart) > tailCurFile.fileSize) {
+		const DWORD size = static_cast<DWORD>(fileSize.QuadPart - tailCurFile.fileSize);
+		lpData = static_cast<char *>(NP2HeapAlloc(size + NP2_ENCODING_DETECTION_PADDING));
+		LARGE_INTEGER offset;
+		offset.QuadPart = tailCurFile.fileSize;
+		success = SetFilePointerEx(hFile, offset, nullptr, FILE_BEGIN)
+			&& ReadFile(hFile, lpData, size, &cbData, nullptr);
+	}
+	CloseHandle(hFile);
+	if (!success) {
+		NP2HeapFree(lpData);
+		return false;
+	}
+
+	// only append complete characters, remaining bytes are appended next time.
+	DWORD length = cbData;
+	if (uFlags & NCP_UTF8) {
+		DWORD back = 0;
+		while (back < kMaxMultiByteCount + 1 && back < length && (static_cast<uint8_t>(lpData[length - back - 1]) & 0xC0) == 0x80) {
+			++back;
+		}
+		if (back < length) {
+			const uint8_t lead = static_cast<uint8_t>(lpData[length - back - 1]);
+			if (lead >= 0xC0 && back + 1 < static_cast<DWORD>(2 + (lead >= 0xE0) + (lead >= 0xF0))) {
+				length -= back + 1;
+			}
+		}
+	} else if (const UINT codePage = (uFlags & NCP_DEFAULT) ? SciCall_GetCodePage() : mEncoding[iCurrentEncoding].uCodePage;
+		IsDBCSCodePage(codePage) || IsZeroFlagsCodePage(codePage)) {
+		// multi-byte or stateful code page, split after line feed
+		while (length != 0 && lpData[length - 1] != '\n') {
+			--length;
+		}
+	}
+
+	if (length != 0) {
+		char *lpDataUTF8 = lpData;
+		DWORD cbText = length;
+		if (uFlags & (NCP_8BIT | NCP_7BIT)) {
+			lpDataUTF8 = RecodeAsUTF8(lpData, &cbText, mEncoding[iCurrentEncoding].uCodePage, 0);
+		}
+		if (lpDataUTF8 != nullptr) {
+			const bool readOnly = SciCall_GetReadOnly();
+			const Sci_Line lineCount = SciCall_GetLineCount();
+			SciCall_SetReadOnly(false);
+			SciCall_SetUndoCollection(false);
+			SciCall_AppendText(cbText, lpDataUTF8);
+			SciCall_SetUndoCollection(true);
+			SciCall_SetSavePoint();
+			SciCall_SetReadOnly(readOnly);
+			if (lpDataUTF8 != lpData) {
+				NP2HeapFree(lpDataUTF8);
+			}
+			EditFilterLinesAppended(lineCount);
+			if (bIsTail) {
+				SciCall_DocumentEnd();
+				SciCall_ScrollCaret();
+			}
+		}
+		tailCurFile.fileSize += length;
+	}
+	NP2HeapFree(lpData);
+	return true;
+}
+
 //=============================================================================
 //
 // WatchTimerProc()
@@ -8024,27 +8970,16 @@ void CALLBACK WatchTimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTim
 
 	if (bRunningWatch) {
 		if (dwChangeNotifyTime > 0 && GetTickCount() - dwChangeNotifyTime > dwAutoReloadTimeout) {
-			if (hChangeHandle) {
-				FindCloseChangeNotification(hChangeHandle);
-				hChangeHandle = nullptr;
-			}
+			FileWatcher_Stop();
 			KillTimer(nullptr, ID_WATCHTIMER);
 			bRunningWatch = false;
 			dwChangeNotifyTime = 0;
 			SendMessage(hwndMain, APPM_CHANGENOTIFY, 0, 0);
 		}
-		// Check Change Notification Handle
-		// TODO: notification not fired for continuously updated file
-		else if (hChangeHandle) {
-			if (WAIT_OBJECT_0 == WaitForSingleObject(hChangeHandle, 0)) {
-				CheckCurrentFileChangedOutsideApp();
-			}
-		}
-		// polling, not very efficient but useful for watching continuously updated file
-		else if (iFileWatchingOption & FileWatchingOption_LogFile) {
-			if (dwChangeNotifyTime == 0) {
-				CheckCurrentFileChangedOutsideApp();
-			}
+		// polling, not very efficient but useful for watching continuously updated file,
+		// or when the directory watcher is not available.
+		else if (dwChangeNotifyTime == 0) {
+			CheckCurrentFileChangedOutsideApp();
 		}
 	}
 }
@@ -8105,6 +9040,8 @@ void AutoSave_Start(bool reset) noexcept {
 }
 
 void AutoSave_Stop(BOOL keepBackup) noexcept {
+	// pending backup belongs to current document
+	AutoSave_FinishWork(true);
 	dwCurrentDocReversion = 0;
 	dwLastSavedDocReversion = 0;
 	if (bAutoSaveTimerSet) {
@@ -8150,10 +9087,90 @@ LPCWSTR AutoSave_GetDefaultFolder() noexcept {
 	return szFolder;
 }
 
+#define AUTOSAVE_WRITE_CHUNK_SIZE	(4U << 20)
+
+// periodic backup is written on a thread pool thread from a copy of the document,
+// at most one backup is pending.
+struct AutoSaveWork {
+	HANDLE hFile;
+	HANDLE hEvent;
+	char *lpData;
+	DWORD cbData;
+	DWORD dwReversion;
+	BOOL bWriteSuccess;
+	WCHAR szPath[MAX_PATH + 40];
+};
+
+static AutoSaveWork *pendingAutoSave = nullptr;
+
+static BOOL AutoSave_WriteData(HANDLE hFile, const char *lpData, DWORD cbData) noexcept {
+	BOOL bWriteSuccess = TRUE;
+	DWORD offset = 0;
+	while (bWriteSuccess && offset < cbData) {
+		DWORD dwBytesWritten = 0;
+		bWriteSuccess = WriteFile(hFile, lpData + offset, min<DWORD>(cbData - offset, AUTOSAVE_WRITE_CHUNK_SIZE), &dwBytesWritten, nullptr);
+		offset += dwBytesWritten;
+	}
+	return bWriteSuccess;
+}
+
+static void CALLBACK AutoSave_WorkCallback([[maybe_unused]] PTP_CALLBACK_INSTANCE instance, PVOID context) noexcept {
+	AutoSaveWork *work = static_cast<AutoSaveWork *>(context);
+	const bool throttled = BackgroundWork_Begin();
+	work->bWriteSuccess = AutoSave_WriteData(work->hFile, work->lpData, work->cbData);
+	BackgroundWork_End(throttled);
+	CloseHandle(work->hFile);
+	// work is freed on UI thread once the event is set
+	HANDLE hEvent = work->hEvent;
+	SetEvent(hEvent);
+	PostMessage(hwndMain, APPM_AUTOSAVE_DONE, 0, 0);
+}
+
+static void AutoSave_AddBackup(LPCWSTR path, FileSaveFlag saveFlag) noexcept {
+	if (!(saveFlag & FileSaveFlag_SaveCopy) && autoSaveCount == MaxAutoSaveCount) {
+		// delete oldest backup
+		LPWSTR old = autoSavePathList[0];
+		if (old) {
+			if (!(iAutoSaveOption & AutoSaveOption_ManuallyDelete)) {
+				DeleteFile(old);
+			}
+			LocalFree(old);
+		}
+		memmove(AsVoidPointer(autoSavePathList), AsVoidPointer(autoSavePathList + 1), (AllAutoSaveCount - 1) * sizeof(LPWSTR));
+		autoSavePathList[AllAutoSaveCount - 1] = nullptr;
+		--autoSaveCount;
+	}
+
+	autoSavePathList[autoSaveCount++] = StrDup(path);
+}
+
+void AutoSave_FinishWork(bool wait) noexcept {
+	AutoSaveWork *work = pendingAutoSave;
+	if (work == nullptr || WaitForSingleObject(work->hEvent, wait ? INFINITE : 0) != WAIT_OBJECT_0) {
+		return;
+	}
+
+	pendingAutoSave = nullptr;
+	if (work->bWriteSuccess) {
+		AutoSave_AddBackup(work->szPath, FileSaveFlag_Default);
+		// document may be changed after the copy
+		dwLastSavedDocReversion = work->dwReversion;
+	} else {
+		DeleteFile(work->szPath);
+	}
+	CloseHandle(work->hEvent);
+	NP2HeapFree(work->lpData);
+	NP2HeapFree(work);
+}
+
 void AutoSave_DoWork(FileSaveFlag saveFlag) noexcept {
 	if (!(saveFlag & FileSaveFlag_SaveAlways) && (!IsDocumentModified() || dwCurrentDocReversion == dwLastSavedDocReversion)) {
 		return;
 	}
+	// previous backup is still being written
+	if (saveFlag == FileSaveFlag_Default && pendingAutoSave != nullptr) {
+		return;
+	}
 
 	const DWORD cbData = static_cast<DWORD>(SciCall_GetLength());
 	if (cbData == 0) {
@@ -8259,7 +9276,28 @@ void AutoSave_DoWork(FileSaveFlag saveFlag) noexcept {
 	SciCall_GetText(cbData, lpData + metaLen);
 	SetEndOfFile(hFile);
 	// no encoding conversion, always saved in UTF-8 or ANSI encoding
-	const BOOL bWriteSuccess = WriteFile(hFile, lpData, cbData + metaLen, &length, nullptr);
+	if (saveFlag == FileSaveFlag_Default) {
+		AutoSaveWork *work = static_cast<AutoSaveWork *>(NP2HeapAlloc(sizeof(AutoSaveWork)));
+		HANDLE hEvent = (work != nullptr) ? CreateEvent(nullptr, TRUE, FALSE, nullptr) : nullptr;
+		if (hEvent != nullptr) {
+			work->hFile = hFile;
+			work->hEvent = hEvent;
+			work->lpData = lpData;
+			work->cbData = cbData + metaLen;
+			work->dwReversion = dwCurrentDocReversion;
+			lstrcpy(work->szPath, tchPath);
+			if (TrySubmitThreadpoolCallback(AutoSave_WorkCallback, work, nullptr)) {
+				pendingAutoSave = work;
+				return;
+			}
+			CloseHandle(hEvent);
+		}
+		if (work != nullptr) {
+			NP2HeapFree(work);
+		}
+	}
+
+	const BOOL bWriteSuccess = AutoSave_WriteData(hFile, lpData, cbData + metaLen);
 	dwLastIOError = GetLastError();
 	CloseHandle(hFile);
 	NP2HeapFree(lpData);
@@ -8269,23 +9307,300 @@ void AutoSave_DoWork(FileSaveFlag saveFlag) noexcept {
 			dwLastSavedDocReversion = dwCurrentDocReversion;
 			return; // treat "Save Backup" as "Save As" with generated file name
 		}
-		if (!(saveFlag & FileSaveFlag_SaveCopy) && autoSaveCount == MaxAutoSaveCount) {
-			// delete oldest backup
-			LPWSTR old = autoSavePathList[0];
-			if (old) {
-				if (!(iAutoSaveOption & AutoSaveOption_ManuallyDelete)) {
-					DeleteFile(old);
-				}
-				LocalFree(old);
-			}
-			memmove(AsVoidPointer(autoSavePathList), AsVoidPointer(autoSavePathList + 1), (AllAutoSaveCount - 1) * sizeof(LPWSTR));
-			autoSavePathList[AllAutoSaveCount - 1] = nullptr;
-			--autoSaveCount;
-		}
-
-		autoSavePathList[autoSaveCount++] = StrDup(tchPath);
+		AutoSave_AddBackup(tchPath, saveFlag);
 		dwLastSavedDocReversion = dwCurrentDocReversion;
 	} else {
 		DeleteFile(tchPath);
 	}
 }
+
+void FileSnapshot_Init(LPCWSTR pszFile, const EditFileIOStatus &status) noexcept {
+	bValidSnapshot = !status.bLoadCanceled && status.fileSize >= MIN_SNAPSHOT_FILE_SIZE;
+	if (!bValidSnapshot) {
+		return;
+	}
+
+	memset(&fileSnapshot, 0, sizeof(EditFileSnapshot));
+	fileSnapshot.magic = EDIT_SNAPSHOT_MAGIC;
+	fileSnapshot.version = EDIT_SNAPSHOT_VERSION;
+	lstrcpyn(fileSnapshot.szFile, pszFile, COUNTOF(fileSnapshot.szFile));
+	memcpy(&fileSnapshot.fileId, &status.fileId, sizeof(FILE_ID_INFO));
+	fileSnapshot.fileSize = status.fileSize;
+	fileSnapshot.ftLastWriteTime = status.ftLastWriteTime;
+	fileSnapshot.uCodePage = mEncoding[status.iEncoding].uCodePage;
+	fileSnapshot.iEncoding = status.iEncoding;
+	fileSnapshot.encodingFlag = status.encodingFlag;
+	fileSnapshot.iEOLMode = status.iEOLMode;
+	fileSnapshot.bInconsistent = status.bInconsistent;
+	fileSnapshot.totalLineCount = status.totalLineCount;
+	memcpy(fileSnapshot.linesCount, status.linesCount, sizeof(fileSnapshot.linesCount));
+	fileSnapshot.iDetectedTabWidth = status.iDetectedTabWidth;
+}
+
+void FileSnapshot_Save() noexcept {
+	// file on disk is still same as the loaded one, document may be modified
+	if (!bValidSnapshot || !PathEqual(fileSnapshot.szFile, szCurFile)) {
+		return;
+	}
+
+	fileSnapshot.iAnchorPos = SciCall_GetAnchor();
+	fileSnapshot.iCurPos = SciCall_GetCurrentPos();
+	fileSnapshot.iDocTopLine = SciCall_DocLineFromVisible(SciCall_GetFirstVisibleLine());
+	fileSnapshot.iXOffset = SciCall_GetXOffset();
+	EditWriteFileSnapshot(fileSnapshot);
+}
+
+// document handed over to elevated instance through a shared memory section, the
+// section is followed by document text and line numbers of folded lines.
+#define EDIT_HANDOFF_MAGIC		0x46464F48U	// HOFF
+
+struct EditHandoffHeader {
+	UINT magic;
+	UINT cbHeader;		// rejects layout from different build
+	EditFileSnapshot snapshot;
+	EditFileVars fileVars;
+	int iOriginalEncoding;
+	int rid;
+	bool bValidSnapshot;
+	bool bModified;
+	bool bReadOnlyMode;
+	Sci_Position textLength;
+	Sci_Line lineCount;
+	Sci_Line foldCount;
+};
+
+//=============================================================================
+//
+// FileHandoff_Create()
+//
+// Writes current document into an unnamed file backed section, text is copied
+// once from Scintilla. Returns the section handle, name is for the command line.
+// When lpszText is not null, the section holds an untitled modified document
+// with the text instead, using current encoding and scheme.
+//
+static HANDLE FileHandoff_Create(LPWSTR pszName, LPCSTR lpszText, Sci_Position cchText, Sci_Line lineCount) noexcept {
+	const bool untitled = lpszText != nullptr;
+	const Sci_Position textLength = untitled ? cchText : SciCall_GetLength();
+	Sci_Line foldCount = 0;
+	if (!untitled) {
+		for (Sci_Line line = SciCall_ContractedFoldNext(0); line >= 0; line = SciCall_ContractedFoldNext(line + 1)) {
+			++foldCount;
+		}
+	}
+
+	const size_t cbText = NP2_align_up(static_cast<size_t>(textLength) + 1, sizeof(Sci_Line));
+	const ULONGLONG cbSection = sizeof(EditHandoffHeader) + cbText + foldCount*sizeof(Sci_Line);
+	wsprintf(pszName, L"Local\\Notepad4.Handoff.%u.%u", GetCurrentProcessId(), GetTickCount());
+	HANDLE hMap = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		static_cast<DWORD>(cbSection >> 32), static_cast<DWORD>(cbSection), pszName);
+	if (hMap == nullptr) {
+		return nullptr;
+	}
+	EditHandoffHeader *header = static_cast<EditHandoffHeader *>(MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, 0));
+	if (header == nullptr) {
+		CloseHandle(hMap);
+		return nullptr;
+	}
+
+	// view is zero initialized
+	EditFileSnapshot &snapshot = header->snapshot;
+	header->bValidSnapshot = !untitled && bValidSnapshot && PathEqual(fileSnapshot.szFile, szCurFile);
+	if (header->bValidSnapshot) {
+		memcpy(&snapshot, &fileSnapshot, sizeof(EditFileSnapshot));
+	} else {
+		snapshot.magic = EDIT_SNAPSHOT_MAGIC;
+		snapshot.version = EDIT_SNAPSHOT_VERSION;
+		if (!untitled) {
+			lstrcpyn(snapshot.szFile, szCurFile, COUNTOF(snapshot.szFile));
+		}
+		snapshot.iDetectedTabWidth = -1;
+	}
+	snapshot.uCodePage = mEncoding[iCurrentEncoding].uCodePage;
+	snapshot.iEncoding = iCurrentEncoding;
+	snapshot.iEOLMode = iCurrentEOLMode;
+	if (!untitled) {
+		snapshot.iAnchorPos = SciCall_GetAnchor();
+		snapshot.iCurPos = SciCall_GetCurrentPos();
+		snapshot.iDocTopLine = SciCall_DocLineFromVisible(SciCall_GetFirstVisibleLine());
+		snapshot.iXOffset = SciCall_GetXOffset();
+	}
+
+	header->magic = EDIT_HANDOFF_MAGIC;
+	header->cbHeader = sizeof(EditHandoffHeader);
+	memcpy(&header->fileVars, &fvCurFile, sizeof(EditFileVars));
+	header->iOriginalEncoding = iOriginalEncoding;
+	header->rid = pLexCurrent->rid;
+	header->bModified = untitled || bDocumentModified;
+	header->bReadOnlyMode = !untitled && bReadOnlyMode;
+	header->textLength = textLength;
+	header->lineCount = untitled ? lineCount : SciCall_GetLineCount();
+	header->foldCount = foldCount;
+
+	char *text = reinterpret_cast<char *>(header + 1);
+	if (untitled) {
+		memcpy(text, lpszText, textLength);
+	} else {
+		SciCall_GetText(textLength, text);
+	}
+	Sci_Line *folds = reinterpret_cast<Sci_Line *>(text + cbText);
+	for (Sci_Line line = SciCall_ContractedFoldNext(0); line >= 0 && foldCount != 0; line = SciCall_ContractedFoldNext(line + 1)) {
+		*folds++ = line;
+		--foldCount;
+	}
+	UnmapViewOfFile(header);
+	return hMap;
+}
+
+//=============================================================================
+//
+// FileHandoff_Load()
+//
+// Takes over document from the section written by FileHandoff_Create(),
+// encoding, line endings and lexer are not detected again.
+//
+static bool FileHandoff_Load(LPCWSTR pszName) noexcept {
+	HANDLE hMap = OpenFileMapping(FILE_MAP_READ, FALSE, pszName);
+	if (hMap == nullptr) {
+		return false;
+	}
+
+	bool fSuccess = false;
+	const EditHandoffHeader *header = static_cast<const EditHandoffHeader *>(MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0));
+	if (header != nullptr) {
+		MEMORY_BASIC_INFORMATION mbi;
+		const size_t cbView = VirtualQuery(header, &mbi, sizeof(mbi)) ? mbi.RegionSize : 0;
+		const EditFileSnapshot &snapshot = header->snapshot;
+		const size_t cbText = NP2_align_up(static_cast<size_t>(header->textLength) + 1, sizeof(Sci_Line));
+		fSuccess = cbView >= sizeof(EditHandoffHeader)
+			&& header->magic == EDIT_HANDOFF_MAGIC
+			&& header->cbHeader == sizeof(EditHandoffHeader)
+			&& snapshot.magic == EDIT_SNAPSHOT_MAGIC
+			&& snapshot.version == EDIT_SNAPSHOT_VERSION
+			&& Encoding_IsValid(snapshot.iEncoding)
+			&& mEncoding[snapshot.iEncoding].uCodePage == snapshot.uCodePage
+			&& header->textLength >= 0 && header->foldCount >= 0
+			&& cbView - sizeof(EditHandoffHeader) >= cbText + header->foldCount*sizeof(Sci_Line);
+	}
+
+	if (fSuccess) {
+		const char *text = reinterpret_cast<const char *>(header + 1);
+		const EditFileSnapshot &snapshot = header->snapshot;
+		iCurrentEncoding = snapshot.iEncoding;
+		iOriginalEncoding = header->iOriginalEncoding;
+		iCurrentEOLMode = snapshot.iEOLMode;
+		memcpy(&fvCurFile, &header->fileVars, sizeof(EditFileVars));
+		SciCall_SetCodePage((iCurrentEncoding == CPI_DEFAULT) ? iDefaultCodePage : SC_CP_UTF8);
+		EditSetNewText(text, static_cast<DWORD>(header->textLength), header->lineCount);
+
+		lstrcpy(szCurFile, snapshot.szFile);
+		SetDlgItemText(hwndMain, IDC_FILENAME, szCurFile);
+		tailCurFile.valid = false;
+		bValidSnapshot = header->bValidSnapshot;
+		if (bValidSnapshot) {
+			memcpy(&fileSnapshot, &snapshot, sizeof(EditFileSnapshot));
+		}
+		bDocumentModified = header->bModified;
+		SciCall_SetEOLMode(iCurrentEOLMode);
+		UpdateStatusBarCache(StatusItem_Encoding);
+		UpdateStatusBarCache(StatusItem_EolMode);
+		UpdateStatusBarCacheLineColumn();
+		Style_SetLexerFromID(header->rid);
+
+		AutoSave_Stop(TRUE);
+		InstallFileWatching(false);
+		if (header->bReadOnlyMode) {
+			bReadOnlyMode = true;
+			SciCall_SetReadOnly(true);
+		}
+
+		// folding needs fold levels, lines are styled up to each folded line.
+		const Sci_Line *folds = reinterpret_cast<const Sci_Line *>(text + cbText);
+		for (Sci_Line i = 0; i < header->foldCount; i++) {
+			const Sci_Line line = folds[i];
+			SciCall_EnsureStyledTo(SciCall_PositionFromLine(line + 1));
+			SciCall_FoldLine(line, SC_FOLDACTION_CONTRACT);
+		}
+		const Sci_Position length = SciCall_GetLength();
+		SciCall_SetSel(min(snapshot.iAnchorPos, length), min(snapshot.iCurPos, length));
+		SciCall_EnsureVisible(snapshot.iDocTopLine);
+		SciCall_SetFirstVisibleLine(SciCall_VisibleFromDocLine(snapshot.iDocTopLine));
+		SciCall_SetXOffset(snapshot.iXOffset);
+
+		UpdateDocumentModificationStatus();
+		UpdateStatusbar();
+		UpdateWindowTitle();
+	}
+
+	if (header != nullptr) {
+		UnmapViewOfFile(header);
+	}
+	CloseHandle(hMap);
+
+	// tell previous instance the document is taken over
+	WCHAR szEvent[80];
+	wsprintf(szEvent, L"%s.Done", pszName);
+	HANDLE hEvent = OpenEvent(EVENT_MODIFY_STATE, FALSE, szEvent);
+	if (hEvent != nullptr) {
+		if (fSuccess) {
+			SetEvent(hEvent);
+		}
+		CloseHandle(hEvent);
+	}
+	return fSuccess;
+}
+
+//=============================================================================
+//
+// ExtractBookmarkedLines()
+//
+// Opens bookmarked lines as untitled document in new window, text is passed
+// through shared memory instead of clipboard, current document is not changed.
+//
+static void ExtractBookmarkedLines(HWND hwnd) noexcept {
+	Sci_Position cchText;
+	Sci_Line lineCount;
+	char *lpszText = EditGetBookmarkedLines(&cchText, &lineCount);
+	if (lpszText == nullptr) {
+		return;
+	}
+
+	WCHAR szHandoff[64];
+	HANDLE hHandoff = FileHandoff_Create(szHandoff, lpszText, cchText, lineCount + 1);
+	NP2HeapFree(lpszText);
+	if (hHandoff == nullptr) {
+		return;
+	}
+
+	WCHAR szEvent[80];
+	wsprintf(szEvent, L"%s.Done", szHandoff);
+	HANDLE hHandoffDone = CreateEvent(nullptr, TRUE, FALSE, szEvent);
+	if (hHandoffDone) {
+		WCHAR szModuleName[MAX_PATH];
+		GetModuleFileName(nullptr, szModuleName, COUNTOF(szModuleName));
+		LPWSTR szParameters = static_cast<LPWSTR>(NP2HeapAlloc(sizeof(WCHAR) * 1024));
+		GetRelaunchParameters(szParameters, nullptr, true, true);
+		lstrcat(szParameters, L" -handoff ");
+		lstrcat(szParameters, szHandoff);
+
+		SHELLEXECUTEINFO sei;
+		memset(&sei, 0, sizeof(SHELLEXECUTEINFO));
+		sei.cbSize = sizeof(SHELLEXECUTEINFO);
+		sei.fMask = SEE_MASK_NOZONECHECKS | SEE_MASK_NOCLOSEPROCESS;
+		sei.hwnd = hwnd;
+		sei.lpVerb = nullptr;
+		sei.lpFile = szModuleName;
+		sei.lpParameters = szParameters;
+		sei.lpDirectory = g_wchWorkingDirectory;
+		sei.nShow = SW_SHOWNORMAL;
+
+		// keep shared memory alive until new window took over the text
+		if (ShellExecuteEx(&sei) && sei.hProcess) {
+			const HANDLE handles[2] = { hHandoffDone, sei.hProcess };
+			WaitForMultipleObjects(COUNTOF(handles), handles, FALSE, 30*1000);
+			CloseHandle(sei.hProcess);
+		}
+		NP2HeapFree(szParameters);
+		CloseHandle(hHandoffDone);
+	}
+	CloseHandle(hHandoff);
+}
@@ -90,6 +90,7 @@ struct NP2PARAMS {
 #define IDC_TOOLBAR			0xFB01
 #define IDC_REBAR			0xFB02
 #define IDC_EDIT			0xFB03
+#define IDC_EDIT_SPLIT		0xFB04
 #define IDC_FILENAME		0xFB05
 
 // submenu in popup menu, IDR_POPUPMENU
@@ -129,10 +130,16 @@ enum {
 // https://www.codeproject.com/tips/1017834/how-to-send-data-from-one-process-to-another-in-cs
 #define APPM_COPYDATA				(WM_APP + 6)
 #define APPM_DROPFILES				(WM_APP + 7)	// ScintillaWin::Drop()
+#define APPM_WATCHNOTIFY			(WM_APP + 8)	// directory watcher detected change of current file
+#define APPM_FINDINFILES			(WM_APP + 9)	// Find in Files result of a file
+#define APPM_STANDBY_ACTIVATE		(WM_APP + 10)	// hidden standby instance takes over a launch, wParam is nShowCmd
+#define APPM_AUTOSAVE_DONE			(WM_APP + 11)	// background AutoSave finished writing backup
 
 #define ID_WATCHTIMER				0xA000	// file watch timer
 #define ID_PASTEBOARDTIMER			0xA001	// paste board timer
 #define ID_AUTOSAVETIMER			0xA002	// AutoSave timer
+#define ID_PAINTSTATISTICSTIMER		0xA003	// performance statistics in statusbar
+#define ID_RELEASEMEMORYTIMER		0xA004	// release caches after window stays in background
 
 enum EscFunction {
 	EscFunction_None = 0,
@@ -191,6 +198,10 @@ struct WindowPositionRecord {
 
 	int cxFileMRUDlg;
 	int cyFileMRUDlg;
+	int cxFindInFilesDlg;
+	int cyFindInFilesDlg;
+	int cxGotoSymbolDlg;
+	int cyGotoSymbolDlg;
 	int cxOpenWithDlg;
 	int cyOpenWithDlg;
 	int cxFavoritesDlg;
@@ -220,6 +231,7 @@ extern WindowPositionRecord positionRecord;
 BOOL InitApplication(HINSTANCE hInstance) noexcept;
 void InitInstance(HINSTANCE hInstance, int nCmdShow);
 bool ActivatePrevInst() noexcept;
+bool ActivateStandbyInst(int nCmdShow) noexcept;
 void GetRelaunchParameters(LPWSTR szParameters, LPCWSTR lpszFile, bool newWind, bool emptyWind) noexcept;
 bool RelaunchMultiInst() noexcept;
 bool RelaunchElevated() noexcept;
@@ -248,11 +260,16 @@ bool CreateIniFile(LPCWSTR lpszIniFile) noexcept;
 
 void UpdateWindowTitle() noexcept;
 void UpdateStatusbar() noexcept;
+void UpdatePaintStatistics() noexcept;
 void UpdateStatusBarCache(int item) noexcept;
 void UpdateToolbar() noexcept;
+int RunScenarioBenchmark(HINSTANCE hInstance, LPCWSTR path) noexcept;
+void GetStartupTiming(LPWSTR lpszText) noexcept;
 void UpdateFoldMarginWidth() noexcept;
 void UpdateLineNumberWidth() noexcept;
 void UpdateBookmarkMarginWidth() noexcept;
+void UpdateOverviewRuler() noexcept;
+void ToggleSplitView() noexcept;
 
 enum {
 	FullScreenMode_OnStartup = 1,
@@ -263,6 +280,34 @@ enum {
 
 void ToggleFullScreenMode() noexcept;
 
+// encoding, line endings and indentation detected for an unchanged large file, saved in
+// AutoSave folder to skip detection when the file is opened again.
+#define EDIT_SNAPSHOT_MAGIC		0x50414E53U	// SNAP
+#define EDIT_SNAPSHOT_VERSION	2
+#define MIN_SNAPSHOT_FILE_SIZE	(64U << 20)
+
+struct EditFileSnapshot {
+	UINT magic;
+	UINT version;
+	WCHAR szFile[MAX_PATH];
+	FILE_ID_INFO fileId;
+	ULONGLONG fileSize;
+	FILETIME ftLastWriteTime;
+	UINT uCodePage;		// validates iEncoding
+	int iEncoding;
+	int encodingFlag;
+	int iEOLMode;
+	bool bInconsistent;
+	size_t totalLineCount;
+	size_t linesCount[3];
+	int iDetectedTabWidth;
+	// view state
+	Sci_Position iAnchorPos;
+	Sci_Position iCurPos;
+	Sci_Line iDocTopLine;
+	int iXOffset;
+};
+
 struct EditFileIOStatus {
 	int iEncoding;		// load output, save input
 	int iEOLMode;		// load output
@@ -271,12 +316,23 @@ struct EditFileIOStatus {
 	bool bUnicodeErr;	// load output
 	bool bBinaryFile;	// load output
 	bool bCancelDataLoss;// save output
+	bool bLoadCanceled;	// load output
 
 	// inconsistent line endings
 	bool bLineEndingsDefaultNo; // set default button to "No"
 	bool bInconsistent;	// load output
 	size_t totalLineCount; // load output, sum(linesCount) + 1
 	size_t linesCount[3];	// load output: CR+LF, CR, LF
+	int iDetectedTabWidth;	// load output, -1 when indentation is not detected
+
+	// raw bytes read and identity of loaded file, used to follow growing log file
+	ULONGLONG fileSize;	// load output
+	FILE_ID_INFO fileId;// load output
+	FILETIME ftLastWriteTime; // load output
+	int encodingFlag;	// load output
+
+	// load input, reset to nullptr when it doesn't match the file
+	const EditFileSnapshot *snapshot;
 };
 
 enum FileLoadFlag {
@@ -317,7 +373,10 @@ enum {
 void	AutoSave_Start(bool reset) noexcept;
 void	AutoSave_Stop(BOOL keepBackup) noexcept;
 void	AutoSave_DoWork(FileSaveFlag saveFlag) noexcept;
+void	AutoSave_FinishWork(bool wait) noexcept;
 LPCWSTR AutoSave_GetDefaultFolder() noexcept;
+void	FileSnapshot_Init(LPCWSTR pszFile, const EditFileIOStatus &status) noexcept;
+void	FileSnapshot_Save() noexcept;
 
 LRESULT CALLBACK MainWndProc(HWND hwnd, UINT umsg, WPARAM wParam, LPARAM lParam);
 LRESULT MsgCreate(HWND hwnd, WPARAM wParam, LPARAM lParam) noexcept;
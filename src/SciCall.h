@@ -178,10 +178,26 @@ inline Sci_Position SciCall_ReplaceTargetRE(Sci_Position length, const char *tex
 	return SciCall(SCI_REPLACETARGETRE, length, AsInteger<LPARAM>(text));
 }
 
+inline Sci_Position SciCall_ReplaceAllInTarget(const char *find, const char *replace) noexcept {
+	return SciCall(SCI_REPLACEALLINTARGET, AsInteger<WPARAM>(find), AsInteger<LPARAM>(replace));
+}
+
 inline Sci_Position SciCall_FindTextFull(int searchFlags, Sci_TextToFindFull *ft) noexcept {
 	return SciCall(SCI_FINDTEXTFULL, searchFlags, AsInteger<LPARAM>(ft));
 }
 
+inline Sci_Position SciCall_FindAll(int searchFlags, Sci_TextToFindFull *ft) noexcept {
+	return SciCall(SCI_FINDALL, searchFlags, AsInteger<LPARAM>(ft));
+}
+
+inline const Sci_Position* SciCall_GetFindAllRanges() noexcept {
+	return AsPointer<const Sci_Position *>(SciCall(SCI_GETFINDALLRANGES, 0, 0));
+}
+
+inline void SciCall_SetSearchIndexThreshold(Sci_Position threshold) noexcept {
+	SciCall(SCI_SETSEARCHINDEXTHRESHOLD, threshold, 0);
+}
+
 inline Sci_Position SciCall_ReplaceTargetEx(BOOL regex, Sci_Position length, const char *text) noexcept {
 	return SciCall(regex ? SCI_REPLACETARGETRE : SCI_REPLACETARGET, length, AsInteger<LPARAM>(text));
 }
@@ -268,18 +284,46 @@ inline void SciCall_EndBatchUpdate(bool bNoUndoGroup = false) noexcept {
 	SciCall(SCI_ENDUNDOACTION, bNoUndoGroup, true);
 }
 
+inline LRESULT SciCall_SendCommands(size_t count, const Sci_CommandRecord *commands) noexcept {
+	return SciCall(SCI_SENDCOMMANDS, count, AsInteger<LPARAM>(commands));
+}
+
 inline size_t SciCall_GetUndoActions() noexcept {
 	return SciCall(SCI_GETUNDOACTIONS, 0, 0);
 }
 
+inline size_t SciCall_GetUndoActionText(int action, char *text) noexcept {
+	return SciCall(SCI_GETUNDOACTIONTEXT, action, AsInteger<LPARAM>(text));
+}
+
 inline void SciCall_SetChangeHistory(int changeHistory) noexcept {
 	SciCall(SCI_SETCHANGEHISTORY, changeHistory, 0);
 }
 
+inline int SciCall_GetChangeHistory() noexcept {
+	return static_cast<int>(SciCall(SCI_GETCHANGEHISTORY, 0, 0));
+}
+
+inline Sci_Line SciCall_ChangeHistoryLineNext(Sci_Line lineStart, int markerMask) noexcept {
+	return SciCall(SCI_CHANGEHISTORYLINENEXT, lineStart, markerMask);
+}
+
 inline void SciCall_SetUndoSelectionHistory(int undoSelectionHistory) noexcept {
 	SciCall(SCI_SETUNDOSELECTIONHISTORY, undoSelectionHistory, 0);
 }
 
+inline void SciCall_SetUndoMemoryLimit(size_t limit) noexcept {
+	SciCall(SCI_SETUNDOMEMORYLIMIT, limit, 0);
+}
+
+inline size_t SciCall_GetUndoMemory() noexcept {
+	return SciCall(SCI_GETUNDOMEMORY, 0, 0);
+}
+
+inline size_t SciCall_GetMemoryUsage(int category) noexcept {
+	return SciCall(SCI_GETMEMORYUSAGE, category, 0);
+}
+
 // Selection and information
 
 inline Sci_Position SciCall_GetLength() noexcept {
@@ -450,10 +494,18 @@ inline Sci_Position SciCall_CountCharacters(Sci_Position start, Sci_Position end
 	return SciCall(SCI_COUNTCHARACTERS, start, end);
 }
 
+inline Sci_Position SciCall_PositionRelative(Sci_Position pos, Sci_Position relative) noexcept {
+	return SciCall(SCI_POSITIONRELATIVE, pos, relative);
+}
+
 inline void SciCall_CountCharactersAndColumns(Sci_TextToFindFull *ft) noexcept {
 	SciCall(SCI_COUNTCHARACTERSANDCOLUMNS, 0, AsInteger<LPARAM>(ft));
 }
 
+inline void SciCall_CountTextStatistics(Sci_TextStatistics *statistics) noexcept {
+	SciCall(SCI_COUNTTEXTSTATISTICS, 0, AsInteger<LPARAM>(statistics));
+}
+
 // Multiple Selection and Virtual Space
 
 inline void SciCall_SetMultipleSelection(bool multipleSelection) noexcept {
@@ -476,6 +528,14 @@ inline size_t SciCall_GetSelectionCount() noexcept {
 	return SciCall(SCI_GETSELECTIONS, 0, 0);
 }
 
+inline Sci_Position SciCall_GetSelectionNStart(size_t selection) noexcept {
+	return SciCall(SCI_GETSELECTIONNSTART, selection, 0);
+}
+
+inline Sci_Position SciCall_GetSelectionNEnd(size_t selection) noexcept {
+	return SciCall(SCI_GETSELECTIONNEND, selection, 0);
+}
+
 inline bool SciCall_IsMultipleSelection() noexcept {
 	return SciCall(SCI_GETSELECTIONS, 0, 0) > 1;
 }
@@ -522,6 +582,10 @@ inline Sci_Line SciCall_GetFirstVisibleLine() noexcept {
 	return SciCall(SCI_GETFIRSTVISIBLELINE, 0, 0);
 }
 
+inline Sci_Line SciCall_LinesOnScreen() noexcept {
+	return SciCall(SCI_LINESONSCREEN, 0, 0);
+}
+
 inline Sci_Line SciCall_SetFirstVisibleLine(Sci_Line displayLine) noexcept {
 	return SciCall(SCI_SETFIRSTVISIBLELINE, displayLine, 0);
 }
@@ -635,6 +699,10 @@ inline void SciCall_SetIdleStyling(int idleStyling) noexcept {
 	SciCall(SCI_SETIDLESTYLING, idleStyling, 0);
 }
 
+inline void SciCall_SetBackgroundStyling(bool backgroundStyling) noexcept {
+	SciCall(SCI_SETBACKGROUNDSTYLING, backgroundStyling, 0);
+}
+
 inline void SciCall_StartStyling(Sci_Position start) noexcept {
 	SciCall(SCI_STARTSTYLING, start, 0);
 }
@@ -745,6 +813,18 @@ inline void SciCall_StyleSetHotSpot(int style, bool hotspot) noexcept {
 	SciCall(SCI_STYLESETHOTSPOT, style, hotspot);
 }
 
+inline void SciCall_StyleSetBulk(int count, const Sci_StyleRecord *records) noexcept {
+	SciCall(SCI_STYLESETBULK, count, AsInteger<LPARAM>(records));
+}
+
+inline void SciCall_BeginStyleUpdate() noexcept {
+	SciCall(SCI_BEGINSTYLEUPDATE, 0, 0);
+}
+
+inline void SciCall_EndStyleUpdate() noexcept {
+	SciCall(SCI_ENDSTYLEUPDATE, 0, 0);
+}
+
 inline bool SciCall_StyleGetHotSpot(int style) noexcept {
 	return static_cast<bool>(SciCall(SCI_STYLEGETHOTSPOT, style, 0));
 }
@@ -851,6 +931,14 @@ inline void SciCall_SetFoldMarginHiColor(bool useSetting, COLORREF fore) noexcep
 	SciCall(SCI_SETFOLDMARGINHICOLOUR, useSetting, fore);
 }
 
+inline void SciCall_SetOverviewRulerWidth(int pixelWidth) noexcept {
+	SciCall(SCI_SETOVERVIEWRULERWIDTH, pixelWidth, 0);
+}
+
+inline void SciCall_SetOverviewRulerMarkers(int markerMask) noexcept {
+	SciCall(SCI_SETOVERVIEWRULERMARKERS, markerMask, 0);
+}
+
 inline void SciCall_SetMarginOptions(int marginOptions) noexcept {
 	SciCall(SCI_SETMARGINOPTIONS, marginOptions, 0);
 }
@@ -1020,6 +1108,11 @@ inline int SciCall_MarkerAdd(Sci_Line line, int markerNumber) noexcept {
 	return static_cast<int>(SciCall(SCI_MARKERADD, line, markerNumber));
 }
 
+// lines is sorted and terminated by -1
+inline Sci_Line SciCall_MarkerAddLines(int markerNumber, const Sci_Line *lines) noexcept {
+	return SciCall(SCI_MARKERADDLINES, markerNumber, AsInteger<LPARAM>(lines));
+}
+
 inline void SciCall_MarkerDelete(Sci_Line line, int markerNumber) noexcept {
 	SciCall(SCI_MARKERDELETE, line, markerNumber);
 }
@@ -1066,6 +1159,18 @@ inline void SciCall_IndicSetStrokeWidth(int indicator, int hundredths) noexcept
 	SciCall(SCI_INDICSETSTROKEWIDTH, indicator, hundredths);
 }
 
+inline void SciCall_IndicSetHoverStyle(int indicator, int indicatorStyle) noexcept {
+	SciCall(SCI_INDICSETHOVERSTYLE, indicator, indicatorStyle);
+}
+
+inline void SciCall_IndicSetHoverFore(int indicator, COLORREF fore) noexcept {
+	SciCall(SCI_INDICSETHOVERFORE, indicator, fore);
+}
+
+inline void SciCall_IndicSetOverviewRuler(int indicator, bool show) noexcept {
+	SciCall(SCI_INDICSETOVERVIEWRULER, indicator, show);
+}
+
 inline void SciCall_SetIndicatorCurrent(int indicator) noexcept {
 	SciCall(SCI_SETINDICATORCURRENT, indicator, 0);
 }
@@ -1078,6 +1183,23 @@ inline void SciCall_IndicatorFillRange(Sci_Position start, Sci_Position length)
 	SciCall(SCI_INDICATORFILLRANGE, start, length);
 }
 
+// ranges is count (start, length) pairs sorted by start
+inline void SciCall_IndicatorFillRanges(size_t count, const Sci_Position *ranges) noexcept {
+	SciCall(SCI_INDICATORFILLRANGES, count, AsInteger<LPARAM>(ranges));
+}
+
+inline int SciCall_IndicatorValueAt(int indicator, Sci_Position position) noexcept {
+	return static_cast<int>(SciCall(SCI_INDICATORVALUEAT, indicator, position));
+}
+
+inline Sci_Position SciCall_IndicatorStart(int indicator, Sci_Position position) noexcept {
+	return SciCall(SCI_INDICATORSTART, indicator, position);
+}
+
+inline Sci_Position SciCall_IndicatorEnd(int indicator, Sci_Position position) noexcept {
+	return SciCall(SCI_INDICATOREND, indicator, position);
+}
+
 // Autocompletion
 
 inline void SciCall_AutoCShow(Sci_Position lengthEntered, const char *itemList) noexcept {
@@ -1300,8 +1422,20 @@ inline const char* SciCall_GetRangePointer(Sci_Position start, Sci_Position leng
 	return AsPointer<const char *>(SciCall(SCI_GETRANGEPOINTER, start, lengthRange));
 }
 
+inline Sci_Position SciCall_GetGapPosition() noexcept {
+	return SciCall(SCI_GETGAPPOSITION, 0, 0);
+}
+
+inline Sci_Position SciCall_GetRangeSegments(Sci_TextSegments *segments) noexcept {
+	return SciCall(SCI_GETRANGESEGMENTS, 0, AsInteger<LPARAM>(segments));
+}
+
 // Multiple views
 
+inline HANDLE SciCall_GetDocPointer() noexcept {
+	return AsPointer<HANDLE>(SciCall(SCI_GETDOCPOINTER, 0, 0));
+}
+
 inline void SciCall_SetDocPointer(HANDLE doc) noexcept {
 	SciCall(SCI_SETDOCPOINTER, 0, AsInteger<LPARAM>(doc));
 }
@@ -1310,6 +1444,10 @@ inline HANDLE SciCall_CreateDocument(Sci_Position bytes, int documentOptions) no
 	return AsPointer<HANDLE>(SciCall(SCI_CREATEDOCUMENT, bytes, documentOptions));
 }
 
+inline void SciCall_AddRefDocument(HANDLE doc) noexcept {
+	SciCall(SCI_ADDREFDOCUMENT, 0, AsInteger<LPARAM>(doc));
+}
+
 inline void SciCall_ReleaseDocument(HANDLE doc) noexcept {
 	SciCall(SCI_RELEASEDOCUMENT, 0, AsInteger<LPARAM>(doc));
 }
@@ -1318,16 +1456,32 @@ inline int SciCall_GetDocumentOptions() noexcept {
 	return static_cast<int>(SciCall(SCI_GETDOCUMENTOPTIONS, 0, 0));
 }
 
+inline void SciCall_ConvertToLargeDocument() noexcept {
+	SciCall(SCI_CONVERTTOLARGEDOCUMENT, 0, 0);
+}
+
 // Folding
 
 inline Sci_Line SciCall_DocLineFromVisible(Sci_Line displayLine) noexcept {
 	return SciCall(SCI_DOCLINEFROMVISIBLE, displayLine, 0);
 }
 
+inline Sci_Line SciCall_VisibleFromDocLine(Sci_Line line) noexcept {
+	return SciCall(SCI_VISIBLEFROMDOCLINE, line, 0);
+}
+
 inline bool SciCall_GetLineVisible(Sci_Line line) noexcept {
 	return static_cast<bool>(SciCall(SCI_GETLINEVISIBLE, line, 0));
 }
 
+inline void SciCall_ShowLines(Sci_Line lineStart, Sci_Line lineEnd) noexcept {
+	SciCall(SCI_SHOWLINES, lineStart, lineEnd);
+}
+
+inline Sci_Line SciCall_HideLinesExceptFindAll(Sci_Line lineStart, Sci_Line contextLines) noexcept {
+	return SciCall(SCI_HIDELINESEXCEPTFINDALL, lineStart, contextLines);
+}
+
 inline int SciCall_GetFoldLevel(Sci_Line line) noexcept {
 	return static_cast<int>(SciCall(SCI_GETFOLDLEVEL, line, 0));
 }
@@ -1352,6 +1506,10 @@ inline BOOL SciCall_GetFoldExpanded(Sci_Line line) noexcept {
 	return static_cast<BOOL>(SciCall(SCI_GETFOLDEXPANDED, line, 0));
 }
 
+inline Sci_Line SciCall_ContractedFoldNext(Sci_Line lineStart) noexcept {
+	return SciCall(SCI_CONTRACTEDFOLDNEXT, lineStart, 0);
+}
+
 inline void SciCall_FoldLine(Sci_Line line, int action) noexcept {
 	SciCall(SCI_FOLDLINE, line, action);
 }
@@ -1360,6 +1518,10 @@ inline void SciCall_FoldAll(int action) noexcept {
 	SciCall(SCI_FOLDALL, action, 0);
 }
 
+inline void SciCall_FoldAllLevel(int level, int action) noexcept {
+	SciCall(SCI_FOLDALLLEVEL, level, action);
+}
+
 inline void SciCall_ToggleFoldShowText(Sci_Line line, const char *text) noexcept {
 	SciCall(SCI_TOGGLEFOLDSHOWTEXT, line, AsInteger<LPARAM>(text));
 }
@@ -1418,6 +1580,26 @@ inline void SciCall_SetLayoutCache(int cacheMode) noexcept {
 	SciCall(SCI_SETLAYOUTCACHE, cacheMode, 0);
 }
 
+inline void SciCall_SetLayoutCacheLimit(size_t bytes) noexcept {
+	SciCall(SCI_SETLAYOUTCACHELIMIT, bytes, 0);
+}
+
+inline void SciCall_ReleaseResources() noexcept {
+	SciCall(SCI_RELEASERESOURCES, 0, 0);
+}
+
+inline void SciCall_SetLayoutThreads(int threads) noexcept {
+	SciCall(SCI_SETLAYOUTTHREADS, threads, 0);
+}
+
+inline void SciCall_SetBackgroundWorkThrottled(bool throttled) noexcept {
+	SciCall(SCI_SETBACKGROUNDWORKTHROTTLED, throttled, 0);
+}
+
+inline void SciCall_GetPaintStatistics(bool reset, Sci_PaintStatistics *statistics) noexcept {
+	SciCall(SCI_GETPAINTSTATISTICS, reset, AsInteger<LPARAM>(statistics));
+}
+
 inline void SciCall_LinesSplit(int pixelWidth) noexcept {
 	SciCall(SCI_LINESSPLIT, pixelWidth, 0);
 }
@@ -1426,6 +1608,10 @@ inline void SciCall_LinesJoin() noexcept {
 	SciCall(SCI_LINESJOIN, 0, 0);
 }
 
+inline Sci_Position SciCall_LinesPad(int flags) noexcept {
+	return SciCall(SCI_LINESPAD, flags, 0);
+}
+
 // Zooming
 
 inline void SciCall_SetZoom(int percent) noexcept {
@@ -356,12 +356,14 @@ int		iCaretBlinkPeriod = -1; // system default, 0 for noblink
 static bool bBookmarkColorUpdated;
 static int	iDefaultLexerIndex;
 static bool bAutoSelect;
+static HANDLE hSplitScintilla;
 
 #define ALL_FILE_EXTENSIONS_BYTE_SIZE	((MATCH_LEXER_COUNT * MAX_EDITLEXER_EXT_SIZE) * sizeof(WCHAR))
 static LPWSTR g_AllFileExtensions = nullptr;
 
 // Notepad4.cpp
 extern HWND hwndMain;
+extern HWND hwndEditSplit;
 extern DWORD dwLastIOError;
 extern int	iCurrentEncoding;
 extern int	g_DOSEncoding;
@@ -664,12 +666,12 @@ static inline void SaveLexTabSettings(IniSectionBuilder &section, LPCEDITLEXER p
 static void Style_LoadOneEx(PEDITLEXER pLex, IniSectionParser &section, WCHAR *pIniSectionBuf, int cchIniSection) noexcept {
 	pLex->iStyleTheme = static_cast<uint8_t>(np2StyleTheme);
 	LPCWSTR themePath = GetStyleThemeFilePath();
-	GetPrivateProfileSection(pLex->pszName, pIniSectionBuf, cchIniSection, themePath);
+	IniCache_GetSection(pLex->pszName, pIniSectionBuf, cchIniSection, themePath);
 
 	const UINT iStyleCount = pLex->iStyleCount;
 	LPWSTR szValue = pLex->szStyleBuf;
 	if (szValue == nullptr) {
-		szValue = static_cast<LPWSTR>(NP2HeapAlloc(EDITSTYLE_BufferSize(iStyleCount)));
+		szValue = static_cast<LPWSTR>(NP2HeapAlloc(EDITSTYLE_BufferSize(iStyleCount) + EDITSTYLE_CacheSize(iStyleCount)));
 		pLex->szStyleBuf = szValue;
 	}
 	if (!section.Parse(pIniSectionBuf)) {
@@ -841,7 +843,7 @@ void Style_LoadAll(StyleLoadFlag loadFlag) noexcept {
 		LPCWSTR themePath = GetStyleThemeFilePath();
 		memcpy(customColor, defaultCustomColor, MAX_CUSTOM_COLOR_COUNT * sizeof(COLORREF));
 
-		GetPrivateProfileSection(INI_SECTION_NAME_CUSTOM_COLORS, pIniSectionBuf, cchIniSection, themePath);
+		IniCache_GetSection(INI_SECTION_NAME_CUSTOM_COLORS, pIniSectionBuf, cchIniSection, themePath);
 		section.ParseArray(pIniSectionBuf, FALSE);
 
 		const UINT count = min<UINT>(section.count, MAX_CUSTOM_COLOR_COUNT);
@@ -874,6 +876,27 @@ void Style_LoadAll(StyleLoadFlag loadFlag) noexcept {
 	}
 }
 
+// load remaining schemes at idle time after startup, one scheme at a time until timer expired.
+// returns true when all schemes are loaded.
+bool Style_LoadDeferred(HANDLE timer) noexcept {
+	static UINT iLexer = 0;
+	IniSectionParser section;
+	constexpr DWORD cchIniSection = MAX_INI_SECTION_SIZE_STYLES;
+	WCHAR * const pIniSectionBuf = section.Init(128, cchIniSection);
+	while (iLexer < ALL_LEXER_COUNT) {
+		PEDITLEXER pLex = pLexArray[iLexer];
+		++iLexer;
+		if (!IsStyleLoaded(pLex)) {
+			Style_LoadOneEx(pLex, section, pIniSectionBuf, cchIniSection);
+			if (!IdleTask_Continue(timer)) {
+				break;
+			}
+		}
+	}
+	section.Free();
+	return iLexer == ALL_LEXER_COUNT;
+}
+
 //=============================================================================
 //
 //	Style_Save()
@@ -935,7 +958,7 @@ void Style_Save() noexcept {
 				section.SetString(tch, wch);
 			}
 		}
-		WritePrivateProfileSection(INI_SECTION_NAME_CUSTOM_COLORS, pIniSectionBuf, themePath);
+		IniCache_SetSection(INI_SECTION_NAME_CUSTOM_COLORS, pIniSectionBuf, themePath);
 	}
 
 	if (fStylesModified & STYLESMODIFIED_STYLE_MASK) {
@@ -956,7 +979,7 @@ void Style_Save() noexcept {
 				SaveLexTabSettings(section, pLex);
 			}
 			// delete this section if nothing changed
-			WritePrivateProfileSection(pLex->pszName, StrIsEmpty(pIniSectionBuf) ? nullptr : pIniSectionBuf, themePath);
+			IniCache_SetSection(pLex->pszName, StrIsEmpty(pIniSectionBuf) ? nullptr : pIniSectionBuf, themePath);
 			pLex->bStyleChanged = false;
 		}
 	}
@@ -1280,8 +1303,43 @@ static void Style_SetFontLocaleName(LPCWSTR lpszStyle) noexcept {
 	SciCall_SetFontLocale(localeName);
 }
 
+// parsed style definitions are cached after style text buffer, entry is reused
+// when style text, base font size and default font names are unchanged.
+struct StyleCacheEntry {
+	UINT generation;
+	int baseFontSize;
+	WCHAR szValue[MAX_EDITSTYLE_VALUE_SIZE];
+	StyleDefinition style;
+};
+
+#define EDITSTYLE_CacheSize(iStyleCount)	((iStyleCount) * sizeof(StyleCacheEntry))
+// bumped when default code or text font changed, zero means not parsed.
+static UINT styleCacheGeneration = 1;
+
+static void Style_Parse(StyleDefinition *style, LPCWSTR lpszStyle) noexcept;
+static void Style_SetParsed(const StyleDefinition *style, int iStyle) noexcept;
+static void Style_GetRecord(const StyleDefinition *style, int iStyle, Sci_StyleRecord *record) noexcept;
+
+static const StyleDefinition *Style_GetParsed(LPCEDITLEXER pLex, UINT index) noexcept {
+	StyleCacheEntry *cache = reinterpret_cast<StyleCacheEntry *>(pLex->szStyleBuf + pLex->iStyleCount * MAX_EDITSTYLE_VALUE_SIZE);
+	StyleCacheEntry &entry = cache[index];
+	LPCWSTR szValue = pLex->Styles[index].szValue;
+	if (entry.generation != styleCacheGeneration || entry.baseFontSize != iBaseFontSize || !StrEqual(entry.szValue, szValue)) {
+		entry.generation = styleCacheGeneration;
+		entry.baseFontSize = iBaseFontSize;
+		lstrcpyn(entry.szValue, szValue, MAX_EDITSTYLE_VALUE_SIZE);
+		memset(&entry.style, 0, sizeof(StyleDefinition));
+		Style_Parse(&entry.style, szValue);
+	}
+	return &entry.style;
+}
+
+static inline void Style_SetStylesCached(LPCEDITLEXER pLex, UINT index, int iStyle) noexcept {
+	Style_SetParsed(Style_GetParsed(pLex, index), iStyle);
+}
+
 static inline void Style_SetDefaultStyle(int index) noexcept {
-	Style_SetStyles(lexGlobal.Styles[index].iStyle, lexGlobal.Styles[index].szValue);
+	Style_SetStylesCached(&lexGlobal, index, lexGlobal.Styles[index].iStyle);
 }
 
 static void Style_SetAllStyle(PEDITLEXER pLex, UINT offset) noexcept {
@@ -1289,17 +1347,30 @@ static void Style_SetAllStyle(PEDITLEXER pLex, UINT offset) noexcept {
 		Style_LoadOne(pLex);
 	}
 
-	const UINT high = offset << 8;
+	// all styles are applied with one SCI_STYLESETBULK, styles sharing same definition
+	// get a copy of the record, which equals SCI_COPYSTYLES after SCI_STYLECLEARALL.
+	Sci_StyleRecord records[STYLE_MAX + 1];
+	UINT count = 0;
 	const UINT iStyleCount = pLex->iStyleCount;
 	// first style is the default style.
 	for (UINT i = 1; i < iStyleCount; i++) {
-		const UINT iStyle = pLex->Styles[i].iStyle;
-		LPCWSTR szValue = pLex->Styles[i].szValue;
-		const int first = (iStyle & 0xff) + offset;
-		Style_SetStyles(first, szValue);
-		if (iStyle > 0xff) {
-			SciCall_CopyStyles(first | high, iStyle >> 8);
+		UINT iStyle = pLex->Styles[i].iStyle;
+		Sci_StyleRecord &record = records[count++];
+		Style_GetRecord(Style_GetParsed(pLex, i), (iStyle & 0xff) + offset, &record);
+		iStyle >>= 8;
+		while (iStyle != 0 && count < COUNTOF(records)) {
+			Sci_StyleRecord &copy = records[count++];
+			copy = record;
+			copy.style = (iStyle & 0xff) + offset;
+			iStyle >>= 8;
 		}
+		if (count + 4 > COUNTOF(records)) {
+			SciCall_StyleSetBulk(count, records);
+			count = 0;
+		}
+	}
+	if (count != 0) {
+		SciCall_StyleSetBulk(count, records);
 	}
 }
 
@@ -1540,6 +1611,9 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 		}
 	}
 
+	// when only colors are changed (e.g. switch theme or edit colors with customize schemes dialog),
+	// Scintilla keeps line layout, position cache and wrapping.
+	SciCall_BeginStyleUpdate();
 	// Font quality setup
 	SciCall_SetFontQuality(iFontQuality);
 
@@ -1548,10 +1622,18 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 	SciCall_StyleSetCharacterSet(STYLE_DEFAULT, DEFAULT_CHARSET);
 
 	//! begin STYLE_DEFAULT
+	WCHAR codeFontName[LF_FACESIZE];
+	WCHAR textFontName[LF_FACESIZE];
+	lstrcpy(codeFontName, defaultCodeFontName);
+	lstrcpy(textFontName, defaultTextFontName);
 	LPCWSTR szValue = lexGlobal.Styles[GlobalStyleIndex_DefaultCode].szValue;
 	Style_StrGetFontEx(szValue, defaultCodeFontName, COUNTOF(defaultCodeFontName), true);
 	szValue = lexGlobal.Styles[GlobalStyleIndex_DefaultText].szValue;
 	Style_StrGetFontEx(szValue, defaultTextFontName, COUNTOF(defaultTextFontName), true);
+	if (!StrEqual(codeFontName, defaultCodeFontName) || !StrEqual(textFontName, defaultTextFontName)) {
+		// cached fonts with $(Code) or $(Text) are outdated
+		++styleCacheGeneration;
+	}
 
 	int iValue = pLexNew->bUseDefaultCodeStyle ? GlobalStyleIndex_DefaultCode : GlobalStyleIndex_DefaultText;
 	szValue = lexGlobal.Styles[iValue].szValue;
@@ -1560,7 +1642,8 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 		iBaseFontSize = defaultBaseFontSize;
 		SciCall_StyleSetSizeFractional(STYLE_DEFAULT, iBaseFontSize);
 	}
-	Style_SetStyles(STYLE_DEFAULT, szValue);
+	const StyleDefinition *style = Style_GetParsed(&lexGlobal, iValue);
+	Style_SetParsed(style, STYLE_DEFAULT);
 
 	// used in Direct2D for language dependent glyphs
 	if (IsVistaAndAbove()) {
@@ -1568,16 +1651,16 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 	}
 
 	COLORREF rgb;
-	if (!Style_StrGetForeColor(szValue, &rgb)) {
+	if (!(style->mask & StyleDefinitionMask_ForeColor)) {
 		rgb = GetSysColor(COLOR_WINDOWTEXT);
 		SciCall_StyleSetFore(STYLE_DEFAULT, rgb);
 	}
-	if (!Style_StrGetBackColor(szValue, &rgb)) {
+	if (!(style->mask & StyleDefinitionMask_BackColor)) {
 		rgb = GetSysColor(COLOR_WINDOW);
 		SciCall_StyleSetBack(STYLE_DEFAULT, rgb);
 	}
 	// lexer default (base style), i.e.: EDITSTYLE_DEFAULT
-	Style_SetStyles(STYLE_DEFAULT, pLexNew->Styles[0].szValue);
+	Style_SetStylesCached(pLexNew, 0, STYLE_DEFAULT);
 	// set all styles to have the same attributes as STYLE_DEFAULT.
 	SciCall_StyleClearAll();
 	//! end STYLE_DEFAULT
@@ -1740,6 +1823,12 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 	// HotSpot
 	Style_SetDefaultStyle(GlobalStyleIndex_Link);
 	SciCall_StyleSetHotSpot(STYLE_LINK, true);
+	// links detected in visible lines, see EditHyperlinkUpdate()
+	rgb = SciCall_StyleGetFore(STYLE_LINK);
+	SciCall_IndicSetStyle(IndicatorNumber_Hyperlink, INDIC_PLAIN);
+	SciCall_IndicSetFore(IndicatorNumber_Hyperlink, rgb);
+	SciCall_IndicSetHoverStyle(IndicatorNumber_Hyperlink, INDIC_TEXTFORE);
+	SciCall_IndicSetHoverFore(IndicatorNumber_Hyperlink, rgb);
 
 	if (SciCall_GetIndentationGuides() != SC_IV_NONE) {
 		Style_SetIndentGuides(true);
@@ -1810,9 +1899,8 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 			}
 			for (UINT i = 1; i < lexHTML.iStyleCount; i++) {
 				const UINT iStyle = lexHTML.Styles[i].iStyle;
-				szValue = lexHTML.Styles[i].szValue;
 				const int first = iStyle & 0xff;
-				Style_SetStyles(first, szValue);
+				Style_SetStylesCached(&lexHTML, i, first);
 				if (iStyle > 0xFF) {
 					SciCall_CopyStyles(first, iStyle >> 8);
 				}
@@ -1823,11 +1911,10 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 			break;
 		}
 	} else {
-		szValue = pLexNew->Styles[ANSIArtStyleIndex_LineNumber].szValue;
-		Style_SetStyles(STYLE_LINENUMBER, szValue);
-		szValue = pLexNew->Styles[ANSIArtStyleIndex_FoldDispalyText].szValue;
-		Style_SetStyles(STYLE_FOLDDISPLAYTEXT, szValue);
+		Style_SetStylesCached(pLexNew, ANSIArtStyleIndex_LineNumber, STYLE_LINENUMBER);
+		Style_SetStylesCached(pLexNew, ANSIArtStyleIndex_FoldDispalyText, STYLE_FOLDDISPLAYTEXT);
 	}
+	SciCall_EndStyleUpdate();
 
 	// update style font, color, etc. don't need colorizing (analyzing whole document) again,
 	// thus we not call SciCall_ClearDocumentStyle() in previous block.
@@ -1860,50 +1947,75 @@ void Style_SetLexer(PEDITLEXER pLexNew, BOOL bLexerChanged) noexcept {
 	UpdateLineNumberWidth();
 	UpdateBookmarkMarginWidth();
 	UpdateFoldMarginWidth();
+	UpdateOverviewRuler();
+
+	// split view shares document and lexer with main view, only apply view styles
+	if (hwndEditSplit != nullptr && g_hScintilla != hSplitScintilla) {
+		HANDLE handle = g_hScintilla;
+		hSplitScintilla = AsPointer<HANDLE>(SendMessage(hwndEditSplit, SCI_GETDIRECTPOINTER, 0, 0));
+		g_hScintilla = hSplitScintilla;
+		Style_SetLexer(pLexNew, false);
+		g_hScintilla = handle;
+	}
+}
+
+//=============================================================================
+// document head shared by content sniffers, filled once for each Style_SetLexerFromFile().
+//
+static char sniffText[4096]; // maybe contains header comments
+static bool sniffSession;
+static bool sniffTextCached;
+
+static const char *Style_GetSniffText() noexcept {
+	if (!sniffTextCached) {
+		sniffText[0] = '\0';
+		SciCall_GetText(COUNTOF(sniffText) - 1, sniffText);
+		sniffTextCached = sniffSession;
+	}
+	return sniffText;
 }
 
 //=============================================================================
 // find lexer from script interpreter, which must be first line of the file.
 // Style_SniffShebang()
 //
-PEDITLEXER Style_SniffShebang(char *pchText) noexcept {
+PEDITLEXER Style_SniffShebang(const char *pchText) noexcept {
 	if (pchText[0] == '#' && pchText[1] == '!') {
-		size_t len = 0;
-		char *pch = pchText + CSTRLEN("#!");
-		char *name;
+		const char *pch = pchText + CSTRLEN("#!");
+		const char *start;
 		while (*pch == ' ' || *pch == '\t') {
 			pch++;
 		}
-		name = pch;
+		start = pch;
 		while (*pch && !IsASpace(*pch)) {
-			len = *pch == '\\' || *pch == '/';
+			const bool separator = *pch == '\\' || *pch == '/';
 			pch++;
-			name = len ? pch : name;
+			start = separator ? pch : start;
 		}
-		if (pch >= name + CSTRLEN("env") && (StrStartsWith(name, "env") || StrStartsWith(name, "winpty"))) {
+		if (pch >= start + CSTRLEN("env") && (StrStartsWith(start, "env") || StrStartsWith(start, "winpty"))) {
 			while (*pch == ' ' || *pch == '\t') {
 				pch++;
 			}
-			name = pch;
+			start = pch;
 			while (*pch && !IsASpace(*pch)) {
-				len = *pch == '\\' || *pch == '/';
+				const bool separator = *pch == '\\' || *pch == '/';
 				pch++;
-				name = len ? pch : name;
+				start = separator ? pch : start;
 			}
 		}
 
-		*pch = '\0';
-		len = pch - name;
-		pch = name;
-		while (*pch) {
-			*pch = UnsafeLower(*pch);
-			if (*pch < 'a' || *pch > 'z') {
-				*pch = '\0';
-				len = pch - name;
+		// lower case copy of leading letters in interpreter name
+		char name[16];
+		size_t len = 0;
+		while (start < pch && len < COUNTOF(name) - 1) {
+			const char ch = UnsafeLower(*start);
+			if (ch < 'a' || ch > 'z') {
 				break;
 			}
-			pch++;
+			name[len++] = ch;
+			++start;
 		}
+		name[len] = '\0';
 
 		if (len >= 4) {
 			if (len >= 5) {
@@ -1990,8 +2102,10 @@ PEDITLEXER Style_SniffShebang(char *pchText) noexcept {
 }
 
 void Style_SniffCSV() noexcept {
+	// first two rows, bounded for huge single line file.
+	constexpr Sci_Position MaxSniffLength = 64*1024;
 	const Sci_Line lines = SciCall_GetLineCount();
-	const Sci_Position endPos = SciCall_PositionFromLine(min<Sci_Line>(lines, 2));
+	const Sci_Position endPos = min(SciCall_PositionFromLine(min<Sci_Line>(lines, 2)), MaxSniffLength);
 	const char *ptr = SciCall_GetRangePointer(0, endPos);
 	if (ptr == nullptr) { // empty document
 		return;
@@ -2011,7 +2125,7 @@ void Style_SniffCSV() noexcept {
 		if (ch == '|' || (ch <= ';' && (mask & (UINT64_C(1) << ch)) != 0)) {
 			if (ch == '\r' || ch == '\n') {
 				offset = 32;
-				if (ch == '\r' && *ptr == '\n') {
+				if (ch == '\r' && ptr < end && *ptr == '\n') {
 					++ptr;
 				}
 			} else {
@@ -2030,7 +2144,7 @@ void Style_SniffCSV() noexcept {
 			table[index] += 1;
 		} else if (ch == '\r' || ch == '\n') {
 			offset = 32;
-			if (ch == '\r' && *ptr == '\n') {
+			if (ch == '\r' && ptr < end && *ptr == '\n') {
 				++ptr;
 			}
 		}
@@ -2094,8 +2208,7 @@ void Style_SniffCSV() noexcept {
 // Style_GetDocTypeLanguage()
 //
 int Style_GetDocTypeLanguage() noexcept {
-	char tchText[4096] = ""; // maybe contains header comments
-	SciCall_GetText(COUNTOF(tchText) - 1, tchText);
+	const char * const tchText = Style_GetSniffText();
 
 	// check DOCTYPE
 	const char *p = StrStrIA(tchText, "<!DOCTYPE");
@@ -2221,8 +2334,7 @@ bool MatchCPPKeyword(const char *p, int index) noexcept {
 }
 
 PEDITLEXER Style_DetectObjCAndMatlab() noexcept {
-	char tchText[4096] = ""; // maybe contains header comments
-	SciCall_GetText(COUNTOF(tchText) - 1, tchText);
+	const char * const tchText = Style_GetSniffText();
 
 	const char *p = tchText;
 	np2LexLangIndex = 0;
@@ -2286,8 +2398,7 @@ PEDITLEXER Style_DetectObjCAndMatlab() noexcept {
 
 // auto detect file type from content.
 PEDITLEXER Style_AutoDetect(BOOL bDotFile) noexcept {
-	char tchText[4096] = ""; // maybe contains header comments
-	SciCall_GetText(COUNTOF(tchText) - 1, tchText);
+	const char * const tchText = Style_GetSniffText();
 
 	const char *p = tchText;
 	const bool shebang = *p == '#' && p[1] == '!';
@@ -2533,8 +2644,7 @@ PEDITLEXER Style_MatchLexer(LPCWSTR lpszMatch, bool bCheckNames) noexcept {
 				}
 			} else if (suffix == L'r') {
 				// check preface `REBOL []` at file beginning
-				char tchText[9] = "";
-				SciCall_GetText(COUNTOF(tchText) - 1, tchText);
+				const char * const tchText = Style_GetSniffText();
 				const char after = tchText[CSTRLEN("rebol")];
 				if ((after == ' ' || after == '\t' || after == '[') && StrStartsWithCase(tchText, "rebol")) {
 					return &lexRebol;
@@ -2602,9 +2712,7 @@ static PEDITLEXER Style_GetLexerFromFile(LPCWSTR lpszFile, bool bCGIGuess, LPCWS
 		}
 
 		else if (bCGIGuess && (StrCaseEqual(lpszExt, L"cgi") || StrCaseEqual(lpszExt, L"fcgi"))) {
-			char tchText[256] = "";
-			SciCall_GetText(COUNTOF(tchText) - 1, tchText);
-			pLexNew = Style_SniffShebang(tchText);
+			pLexNew = Style_SniffShebang(Style_GetSniffText());
 		}
 
 		// autoconf / automake
@@ -2678,6 +2786,8 @@ bool Style_SetLexerFromFile(LPCWSTR lpszFile) noexcept {
 	PEDITLEXER pLexNew = nullptr;
 	PEDITLEXER pLexSniffed;
 	tabSeparatedValue = false;
+	sniffSession = true;
+	sniffTextCached = false;
 
 	if (bAutoSelect) {
 		pLexNew = Style_GetLexerFromFile(lpszFile, !fNoCGIGuess, &lpszExt, &bDotFile);
@@ -2685,8 +2795,7 @@ bool Style_SetLexerFromFile(LPCWSTR lpszFile) noexcept {
 
 	// xml/html
 	if ((!pLexNew && bAutoSelect) || (pLexNew && (pLexNew->iLexer == SCLEX_CONFIG))) {
-		char tchText[256] = "";
-		SciCall_GetText(COUNTOF(tchText) - 1, tchText);
+		const char * const tchText = Style_GetSniffText();
 		const char *p = tchText;
 		while (IsASpace(*p)) {
 			++p;
@@ -2736,9 +2845,7 @@ bool Style_SetLexerFromFile(LPCWSTR lpszFile) noexcept {
 		MultiByteToWideChar(cpEdit, 0, fvCurFile.tchMode, -1, wchMode, COUNTOF(wchMode));
 
 		if (!fNoCGIGuess && (StrCaseEqual(wchMode, L"cgi") || StrCaseEqual(wchMode, L"fcgi"))) {
-			char tchText[256] = "";
-			SciCall_GetText(COUNTOF(tchText) - 1, tchText);
-			pLexSniffed = Style_SniffShebang(tchText);
+			pLexSniffed = Style_SniffShebang(Style_GetSniffText());
 			if (pLexSniffed != nullptr) {
 				if (iCurrentEncoding != g_DOSEncoding || pLexSniffed != &lexTextFile
 					|| !(StrCaseEqual(lpszExt, L"nfo") || StrCaseEqual(lpszExt, L"diz"))) {
@@ -2780,6 +2887,8 @@ bool Style_SetLexerFromFile(LPCWSTR lpszFile) noexcept {
 		bFound = false;
 		pLexNew = pLexArray[iDefaultLexerIndex];
 	}
+	sniffSession = false;
+	sniffTextCached = false;
 	// Apply the new lexer
 	if (pLexNew->iLexer == SCLEX_CSV && !tabSeparatedValue) {
 		Style_SniffCSV();
@@ -3739,8 +3848,11 @@ void Style_SetStyles(int iStyle, LPCWSTR lpszStyle) noexcept {
 	}
 }
 
-#if 0
-void Style_Parse(StyleDefinition *style, LPCWSTR lpszStyle) noexcept {
+//=============================================================================
+//
+// Style_Parse()
+//
+static void Style_Parse(StyleDefinition *style, LPCWSTR lpszStyle) noexcept {
 	UINT mask = 0;
 	int iValue;
 	COLORREF rgb;
@@ -3795,7 +3907,7 @@ void Style_Parse(StyleDefinition *style, LPCWSTR lpszStyle) noexcept {
 	style->mask = mask;
 }
 
-void Style_SetParsed(const StyleDefinition *style, int iStyle) noexcept {
+static void Style_SetParsed(const StyleDefinition *style, int iStyle) noexcept {
 	const UINT mask = style->mask;
 
 	// Font
@@ -3844,17 +3956,62 @@ void Style_SetParsed(const StyleDefinition *style, int iStyle) noexcept {
 		SciCall_StyleSetEOLFilled(iStyle, true);
 	}
 
-	// Case
-	if (mask & STYLE_MASK_FORCE_CASE) {
-		SciCall_StyleSetCase(iStyle, style->forceCase);
-	}
-
 	// Character Set
 	if (mask & StyleDefinitionMask_Charset) {
 		SciCall_StyleSetCharacterSet(iStyle, style->charset);
 	}
 }
-#endif
+
+static void Style_GetRecord(const StyleDefinition *style, int iStyle, Sci_StyleRecord *record) noexcept {
+	const UINT mask = style->mask;
+	int recordMask = 0;
+	if (mask & StyleDefinitionMask_FontFace) {
+		recordMask |= SC_STYLERECORD_FONT;
+	}
+	if (mask & StyleDefinitionMask_FontSize) {
+		recordMask |= SC_STYLERECORD_SIZE;
+	}
+	if (mask & StyleDefinitionMask_ForeColor) {
+		recordMask |= SC_STYLERECORD_FORE;
+	}
+	if (mask & StyleDefinitionMask_BackColor) {
+		recordMask |= SC_STYLERECORD_BACK;
+	}
+	if (mask & StyleDefinitionMask_FontWeight) {
+		recordMask |= SC_STYLERECORD_WEIGHT;
+	}
+	if (mask & StyleDefinitionMask_Charset) {
+		recordMask |= SC_STYLERECORD_CHARACTERSET;
+	}
+
+	// same as Style_SetParsed(), only turn on attributes
+	int attributes = 0;
+	if (style->italic) {
+		attributes |= SC_STYLERECORD_ITALIC;
+	}
+	if (style->underline) {
+		attributes |= SC_STYLERECORD_UNDERLINE;
+	}
+	if (style->strike) {
+		attributes |= SC_STYLERECORD_STRIKE;
+	}
+	if (style->overline) {
+		attributes |= SC_STYLERECORD_OVERLINE;
+	}
+	if (style->eolFilled) {
+		attributes |= SC_STYLERECORD_EOLFILLED;
+	}
+
+	record->style = iStyle;
+	record->mask = recordMask | attributes;
+	record->fore = static_cast<int>(style->foreColor);
+	record->back = static_cast<int>(style->backColor);
+	record->sizeFractional = style->fontSize;
+	record->weight = style->weight;
+	record->characterSet = style->charset;
+	record->attributes = attributes;
+	record->fontName = style->fontFace;
+}
 
 //=============================================================================
 //
@@ -4164,7 +4321,7 @@ static void Style_ResetStyle(LPCEDITLEXER pLex, EDITSTYLE *pStyle) noexcept {
 		LPCWSTR themePath = GetStyleThemeFilePath();
 		WCHAR wch[MAX_EDITSTYLE_VALUE_SIZE] = L"";
 		// use "NULL" to distinguish between empty style value like: Keyword=
-		GetPrivateProfileString(pLex->pszName, pStyle->pszName, L"NULL", wch, COUNTOF(wch), themePath);
+		IniCache_GetString(pLex->pszName, pStyle->pszName, L"NULL", wch, COUNTOF(wch), themePath);
 		if (!StrEqualEx(wch, L"NULL")) {
 			lstrcpy(pStyle->szValue, wch);
 			return;
@@ -90,6 +90,7 @@ void	Style_ReleaseResources() noexcept;
 void	Style_Load() noexcept;
 void	Style_Save() noexcept;
 void	Style_LoadAll(StyleLoadFlag loadFlag) noexcept;
+bool	Style_LoadDeferred(HANDLE timer) noexcept;
 bool	Style_Import(HWND hwnd) noexcept;
 bool	Style_Export(HWND hwnd) noexcept;
 void	Style_LoadTabSettings(LPCEDITLEXER pLex) noexcept;
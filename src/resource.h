@@ -371,6 +371,18 @@
 #define IDC_CSV_QUALIFIER_DOUBLE		110
 #define IDC_CSV_QUALIFIER_SINGLE		111
 #define IDC_CSV_QUALIFIER_NONE			112
+// Find in Files
+#define IDD_FINDINFILES					134
+#define IDC_FINDINFILES_TEXT			110
+#define IDC_FINDINFILES_DIR				111
+#define IDC_FINDINFILES_BROWSE			112
+#define IDC_FINDINFILES_FILTER			113
+#define IDC_FINDINFILES_RESULT			114
+#define IDC_FINDINFILES_STATUS			115
+// Goto Symbol
+#define IDD_GOTOSYMBOL					135
+#define IDC_GOTOSYMBOL_FILTER			110
+#define IDC_GOTOSYMBOL_LIST				111
 
 #define IDS_APPTITLE					10000
 #define IDS_APPTITLE_PASTEBOARD			10001
@@ -380,6 +392,7 @@
 #define IDS_READONLY_FILE				10005
 #define IDS_STATUSITEM_FORMAT			10006
 #define IDS_ZERO_LENGTH_MATCH			10007
+#define IDS_LOADFILE_PROGRESS			10008
 #define IDS_LOADFILE					10009
 #define IDS_SAVEFILE					10010
 #define IDS_PRINTFILE					10011
@@ -394,6 +407,12 @@
 #define IDS_REGEXPHELP					10020
 #define IDS_WILDCARDHELP				10021
 #define IDS_CMDLINEHELP					10022
+#define IDS_FINDINFILES_BROWSE			10023
+#define IDS_FINDINFILES_STATUS			10024
+#define IDS_FILTER_DIFF					10025
+#define IDS_COMPARE_STATUS				10026
+#define IDS_COMPARE_IDENTICAL			10027
+#define IDS_FILTER_LINES_STATUS			10028
 
 #define IDM_FILE_NEW					40000	// Ctrl+N Ctrl+F4
 #define IDM_FILE_OPEN					40001	// Ctrl+O
@@ -507,6 +526,7 @@
 #define BME_EDIT_BOOKMARKCLEAR			40256	// Alt+F2
 #define BME_EDIT_BOOKMARKPREV			40257	// Shift+F2
 #define BME_EDIT_BOOKMARKSELECT			40258
+#define BME_EDIT_BOOKMARKEXTRACT		40259
 // Insert Unicode Control Character, see kUnicodeControlCharacterTable
 #define IDM_INSERT_UNICODE_LRM			40260
 #define IDM_INSERT_UNICODE_RLM			40261
@@ -714,6 +734,7 @@
 #define IDM_VIEW_HIGHLIGHTCURRENTLINE_NONE		40474
 #define IDM_VIEW_HIGHLIGHTCURRENTLINE_BACK		40475	// Ctrl+Shift+I
 #define IDM_VIEW_HIGHLIGHTCURRENTLINE_FRAME		40476	// Ctrl+Shift+F
+#define IDM_VIEW_PAINT_STATISTICS		40477
 
 #define IDM_VIEW_STYLE_THEME_DEFAULT	40478
 #define IDM_VIEW_STYLE_THEME_DARK		40479
@@ -736,6 +757,17 @@
 #define IDM_EDIT_BASE64_HTML_EMBEDDED_IMAGE		40496
 #define IDM_EDIT_BASE64_DECODE					40497
 #define IDM_EDIT_BASE64_DECODE_AS_HEX			40498
+#define IDM_EDIT_FINDINFILES			40499
+#define IDM_EDIT_GOTOSYMBOL				40590	// Ctrl+Alt+G
+#define IDM_EDIT_SHOW_TEXT_STATISTICS	40591
+#define IDM_EDIT_COMPARE_FILE			40592
+#define IDM_EDIT_COMPARE_SELECTIONS		40593
+#define IDM_EDIT_COMPARE_NEXT			40594
+#define IDM_EDIT_COMPARE_PREV			40595
+#define IDM_EDIT_COMPARE_EXPORT			40596
+#define IDM_EDIT_COMPARE_CLEAR			40597
+#define IDM_EDIT_FILTER_LINES			40598
+#define IDM_EDIT_FILTER_CLEAR			40599
 
 #define IDM_HELP_ABOUT					40500	// F1
 #define IDM_CMDLINE_HELP				40501
@@ -749,6 +781,8 @@
 #define IDM_RECENT_HISTORY_END			(IDM_RECENT_HISTORY_START + 32)
 #define IDM_TRAY_RESTORE				40540
 #define IDM_TRAY_EXIT					40541
+#define IDM_VIEW_SPLIT_VIEW				40542
+#define IDM_VIEW_OVERVIEW_RULER			40543
 
 #define CMD_ESCAPE						40550	// Esc					None/Min To Tray/Exit
 #define CMD_SHIFTESC					40551	// Shift+Esc			Exit
@@ -900,7 +934,7 @@
 #define IDS_ERR_ENCODINGNA				50014
 #define IDS_ERR_UNICODE					50015
 #define IDS_ERR_UNICODE2				50016
-#define IDS_WARNLOADBIGFILE				50017
+#define IDS_ASK_LOADBIGFILE				50017
 //#define IDS_ERR_DROP					50018
 #define IDS_ASK_SAVE					50019
 #define IDS_ASK_REVERT					50020